@@ -46,6 +46,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <cutils/properties.h>
 #include <gpt-utils.h>
 #include <bootloader_message/bootloader_message.h>
@@ -88,9 +89,36 @@ using ::android::bootable::InitMiscVirtualAbMessageIfNeeded;
 using ::android::bootable::SetMiscVirtualAbMergeStatus;
 using ::android::hardware::boot::V1_1::MergeStatus;
 
-//Get the value of one of the attribute fields for a partition.
-static int get_partition_attribute(char *partname,
+//Attribute byte of the boot partition of each slot, as last read from
+//or written to the GPT, or -1 if it has to be read again. The slot
+//queries the HAL gets polled with are answered from here. Every change
+//to the slot attributes holds slot_attr_lock while it writes to disk
+//and updates this on the way out.
+static pthread_mutex_t slot_attr_lock = PTHREAD_MUTEX_INITIALIZER;
+static int slot_attr_cache[ARRAY_SIZE(slot_suffix_arr) - 1] = { -1, -1 };
+
+static int decode_partition_attribute(uint8_t attr,
 		enum part_attr_type part_attr)
+{
+	if (part_attr == ATTR_SLOT_ACTIVE)
+		return !!(attr & AB_PARTITION_ATTR_SLOT_ACTIVE);
+	else if (part_attr == ATTR_BOOT_SUCCESSFUL)
+		return !!(attr & AB_PARTITION_ATTR_BOOT_SUCCESSFUL);
+	else if (part_attr == ATTR_UNBOOTABLE)
+		return !!(attr & AB_PARTITION_ATTR_UNBOOTABLE);
+	return -1;
+}
+
+//Drop the cached attributes. Must be called with slot_attr_lock held.
+static void invalidate_slot_attr_cache_locked()
+{
+	unsigned i;
+	for (i = 0; i < ARRAY_SIZE(slot_attr_cache); i++)
+		slot_attr_cache[i] = -1;
+}
+
+//Get the raw attribute byte of a partition from the primary GPT.
+static int get_partition_attribute_byte(char *partname)
 {
 	struct gpt_disk *disk = NULL;
 	uint8_t *pentry = NULL;
@@ -114,14 +142,7 @@ static int get_partition_attribute(char *partname,
 		goto error;
 	}
 	attr = pentry + AB_FLAG_OFFSET;
-	if (part_attr == ATTR_SLOT_ACTIVE)
-		retval = !!(*attr & AB_PARTITION_ATTR_SLOT_ACTIVE);
-	else if (part_attr == ATTR_BOOT_SUCCESSFUL)
-		retval = !!(*attr & AB_PARTITION_ATTR_BOOT_SUCCESSFUL);
-	else if (part_attr == ATTR_UNBOOTABLE)
-		retval = !!(*attr & AB_PARTITION_ATTR_UNBOOTABLE);
-	else
-		retval = -1;
+	retval = *attr;
 	gpt_disk_free(disk);
 	return retval;
 error:
@@ -130,6 +151,41 @@ error:
 	return retval;
 }
 
+//Get the value of one of the attribute fields for a partition.
+static int get_partition_attribute(char *partname,
+		enum part_attr_type part_attr)
+{
+	int attr = get_partition_attribute_byte(partname);
+	if (attr < 0)
+		return -1;
+	return decode_partition_attribute(attr, part_attr);
+}
+
+//Get the value of one of the attribute fields for the boot partition of
+//a slot, reading the GPT only if it is not cached.
+static int get_slot_attribute(unsigned slot, enum part_attr_type part_attr)
+{
+	char bootPartition[MAX_GPT_NAME_SIZE + 1] = {0};
+	int attr = -1;
+
+	if (slot >= ARRAY_SIZE(slot_attr_cache))
+		return -1;
+	pthread_mutex_lock(&slot_attr_lock);
+	attr = slot_attr_cache[slot];
+	if (attr < 0) {
+		snprintf(bootPartition,
+				sizeof(bootPartition) - 1, "boot%s",
+				slot_suffix_arr[slot]);
+		attr = get_partition_attribute_byte(bootPartition);
+		if (attr >= 0)
+			slot_attr_cache[slot] = attr;
+	}
+	pthread_mutex_unlock(&slot_attr_lock);
+	if (attr < 0)
+		return -1;
+	return decode_partition_attribute(attr, part_attr);
+}
+
 //Set a particular attribute for all the partitions in a
 //slot
 static int update_slot_attribute(const char *slot,
@@ -147,6 +203,8 @@ static int update_slot_attribute(const char *slot,
 	char partName[MAX_GPT_NAME_SIZE + 1] = {0};
 	const char ptn_list[][MAX_GPT_NAME_SIZE] = { AB_PTN_LIST };
 	int slot_name_valid = 0;
+	unsigned slot_idx = 0;
+	pthread_mutex_lock(&slot_attr_lock);
 	if (!slot) {
 		ALOGE("%s: Invalid argument", __func__);
 		goto error;
@@ -154,8 +212,10 @@ static int update_slot_attribute(const char *slot,
 	for (i = 0; slot_suffix_arr[i] != NULL; i++)
 	{
 		if (!strncmp(slot, slot_suffix_arr[i],
-					strlen(slot_suffix_arr[i])))
+					strlen(slot_suffix_arr[i]))) {
 				slot_name_valid = 1;
+				slot_idx = i;
+		}
 	}
 	if (!slot_name_valid) {
 		ALOGE("%s: Invalid slot name", __func__);
@@ -240,13 +300,19 @@ static int update_slot_attribute(const char *slot,
 					partName);
 			goto error;
 		}
+		if (!strcmp(ptn_list[i], BOOT_IMG_PTN_NAME))
+			slot_attr_cache[slot_idx] = *attr;
 		gpt_disk_free(disk);
 		disk = NULL;
 	}
+	pthread_mutex_unlock(&slot_attr_lock);
 	return 0;
 error:
 	if (disk)
 		gpt_disk_free(disk);
+	//Part of the slot may have been written already
+	invalidate_slot_attr_cache_locked();
+	pthread_mutex_unlock(&slot_attr_lock);
 	return -1;
 }
 
@@ -639,15 +705,20 @@ int set_active_boot_slot(unsigned slot)
 				__func__);
 		goto error;
 	}
+	//Switching slots rewrites the whole attribute byte of both slots
+	pthread_mutex_lock(&slot_attr_lock);
+	invalidate_slot_attr_cache_locked();
 	for (map_iter = ptn_map.begin(); map_iter != ptn_map.end(); map_iter++){
 		if (map_iter->second.size() < 1)
 			continue;
 		if (boot_ctl_set_active_slot_for_partitions(map_iter->second,
 					slot)) {
 			ALOGE("%s: Failed to set active slot", __func__);
+			pthread_mutex_unlock(&slot_attr_lock);
 			goto error;
 		}
 	}
+	pthread_mutex_unlock(&slot_attr_lock);
 	if (is_ufs) {
 		if (!strncmp(slot_suffix_arr[slot], AB_SLOT_A_SUFFIX,
 					strlen(AB_SLOT_A_SUFFIX))){
@@ -691,16 +762,12 @@ error:
 int is_slot_bootable(unsigned slot)
 {
 	int attr = 0;
-	char bootPartition[MAX_GPT_NAME_SIZE + 1] = {0};
 
 	if (boot_control_check_slot_sanity(slot) != 0) {
 		ALOGE("%s: Argument check failed", __func__);
 		goto error;
 	}
-	snprintf(bootPartition,
-			sizeof(bootPartition) - 1, "boot%s",
-			slot_suffix_arr[slot]);
-	attr = get_partition_attribute(bootPartition, ATTR_UNBOOTABLE);
+	attr = get_slot_attribute(slot, ATTR_UNBOOTABLE);
 	if (attr >= 0)
 		return !attr;
 error:
@@ -710,16 +777,12 @@ error:
 int is_slot_marked_successful(unsigned slot)
 {
 	int attr = 0;
-	char bootPartition[MAX_GPT_NAME_SIZE + 1] = {0};
 
 	if (boot_control_check_slot_sanity(slot) != 0) {
 		ALOGE("%s: Argument check failed", __func__);
 		goto error;
 	}
-	snprintf(bootPartition,
-			sizeof(bootPartition) - 1,
-			"boot%s", slot_suffix_arr[slot]);
-	attr = get_partition_attribute(bootPartition, ATTR_BOOT_SUCCESSFUL);
+	attr = get_slot_attribute(slot, ATTR_BOOT_SUCCESSFUL);
 	if (attr >= 0)
 		return attr;
 error:
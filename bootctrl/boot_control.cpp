@@ -28,6 +28,7 @@
  */
 #include <map>
 #include <list>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #ifdef __cplusplus
@@ -247,15 +248,25 @@ error:
 	return -1;
 }
 
+//The partition layout does not change while we run, so the slot count
+//and the boot slot are worked out once and then served from these.
+//-1 means not known yet.
+static int cached_slot_count = -1;
+static int cached_current_slot = -1;
+
 unsigned get_number_slots(struct boot_control_module *module)
 {
 	struct dirent *de = NULL;
 	DIR *dir_bootdev = NULL;
 	unsigned slot_count = 0;
+	int cached = -1;
 	if (!module) {
 		ALOGE("%s: Invalid argument", __func__);
 		goto error;
 	}
+	cached = __atomic_load_n(&cached_slot_count, __ATOMIC_RELAXED);
+	if (cached >= 0)
+		return cached;
 	dir_bootdev = opendir(BOOTDEV_DIR);
 	if (!dir_bootdev) {
 		ALOGE("%s: Failed to open bootdev dir (%s)",
@@ -271,6 +282,7 @@ unsigned get_number_slots(struct boot_control_module *module)
 			slot_count++;
 	}
 	closedir(dir_bootdev);
+	__atomic_store_n(&cached_slot_count, slot_count, __ATOMIC_RELAXED);
 	return slot_count;
 error:
 	if (dir_bootdev)
@@ -283,13 +295,19 @@ unsigned get_current_slot(struct boot_control_module *module)
 	uint32_t num_slots = 0;
 	char bootSlotProp[PROPERTY_VALUE_MAX] = {'\0'};
 	unsigned i = 0;
+	int cached = -1;
 	if (!module) {
 		ALOGE("%s: Invalid argument", __func__);
 		goto error;
 	}
+	//ro.boot.slot_suffix is fixed for the whole boot
+	cached = __atomic_load_n(&cached_current_slot, __ATOMIC_RELAXED);
+	if (cached >= 0)
+		return cached;
 	num_slots = get_number_slots(module);
 	if (num_slots <= 1) {
 		//Slot 0 is the only slot around.
+		__atomic_store_n(&cached_current_slot, 0, __ATOMIC_RELAXED);
 		return 0;
 	}
 	property_get(BOOT_SLOT_PROP, bootSlotProp, "N/A");
@@ -303,8 +321,11 @@ unsigned get_current_slot(struct boot_control_module *module)
 	for (i = 0; slot_suffix_arr[i] != NULL ; i++) {
 		if (!strncmp(bootSlotProp,
 					slot_suffix_arr[i],
-					strlen(slot_suffix_arr[i])))
-				return i;
+					strlen(slot_suffix_arr[i]))) {
+			__atomic_store_n(&cached_current_slot, (int)i,
+					__ATOMIC_RELAXED);
+			return i;
+		}
 	}
 error:
 	//The HAL spec requires that we return a number between
@@ -379,25 +400,159 @@ error:
 	return NULL;
 }
 
+//In memory copy of the GPT of every disk touched while switching
+//slots. Each disk is read once, its partitions are indexed by name
+//and all the slot flips are applied to the cached tables, which are
+//then written back with a single commit per disk.
+struct boot_ctl_pentry {
+	struct gpt_disk *disk;
+	uint8_t *pentry;
+	uint8_t *pentry_bak;
+};
+
+struct boot_ctl_disk_cache {
+	vector<struct gpt_disk*> disks;
+	unordered_map<string, struct boot_ctl_pentry> ptn_index;
+};
+
+//Add the entries of a partition array to the name index. Names are
+//kept the first time they are seen, as gpt_disk_get_pentry does.
+static void boot_ctl_index_pentries(struct boot_ctl_disk_cache *cache,
+		struct gpt_disk *disk,
+		enum gpt_instance instance)
+{
+	uint8_t *ptn_arr = (instance == PRIMARY_GPT) ?
+		disk->pentry_arr : disk->pentry_arr_bak;
+	uint8_t *pentry = NULL;
+	char name8[MAX_GPT_NAME_SIZE / 2 + 1];
+	uint32_t i;
+
+	for (pentry = ptn_arr;
+			pentry + disk->pentry_size <= ptn_arr + disk->pentry_arr_size;
+			pentry += disk->pentry_size) {
+		//Partition names in GPT are UTF-16 - ignoring UTF-16 2nd byte
+		for (i = 0; i < sizeof(name8) - 1; i++)
+			name8[i] = pentry[PARTITION_NAME_OFFSET + i * 2];
+		name8[i] = '\0';
+		if (name8[0] == '\0')
+			continue;
+		struct boot_ctl_pentry &entry = cache->ptn_index[name8];
+		if (!entry.disk) {
+			entry.disk = disk;
+			entry.pentry = NULL;
+			entry.pentry_bak = NULL;
+		} else if (entry.disk != disk) {
+			continue;
+		}
+		if (instance == PRIMARY_GPT && !entry.pentry)
+			entry.pentry = pentry;
+		else if (instance == SECONDARY_GPT && !entry.pentry_bak)
+			entry.pentry_bak = pentry;
+	}
+}
+
+//Look up the primary and backup entries of a partition, reading the
+//disk holding it if this is the first partition seen on that disk.
+//Returns NULL if the partition does not exist.
+static struct boot_ctl_pentry* boot_ctl_cache_get_pentry(
+		struct boot_ctl_disk_cache *cache,
+		char *partname)
+{
+	char buf[PATH_MAX] = {0};
+	struct gpt_disk *disk = NULL;
+	struct stat st;
+	unordered_map<string, struct boot_ctl_pentry>::iterator it;
+	vector<struct gpt_disk*>::iterator disk_iter;
+
+	it = cache->ptn_index.find(partname);
+	if (it != cache->ptn_index.end())
+		return &it->second;
+	//Not on any of the disks read so far
+	snprintf(buf, sizeof(buf) - 1, "%s/%s", BOOT_DEV_DIR, partname);
+	if (stat(buf, &st))
+		return NULL;
+	disk = boot_ctl_get_disk_info(partname);
+	if (!disk)
+		return NULL;
+	for (disk_iter = cache->disks.begin();
+			disk_iter != cache->disks.end();
+			disk_iter++) {
+		if (!strncmp((*disk_iter)->devpath, disk->devpath,
+					sizeof(disk->devpath))) {
+			//Never keep two copies of the same disk around, one
+			//commit would overwrite the other.
+			ALOGE("%s: %s not indexed on %s", __func__,
+					partname, disk->devpath);
+			gpt_disk_free(disk);
+			return NULL;
+		}
+	}
+	cache->disks.push_back(disk);
+	boot_ctl_index_pentries(cache, disk, PRIMARY_GPT);
+	boot_ctl_index_pentries(cache, disk, SECONDARY_GPT);
+	it = cache->ptn_index.find(partname);
+	if (it == cache->ptn_index.end() ||
+			!it->second.pentry || !it->second.pentry_bak) {
+		ALOGE("%s: pentry for %s not found on %s", __func__,
+				partname, disk->devpath);
+		return NULL;
+	}
+	return &it->second;
+}
+
+//Update the CRCs of the cached disks and write them back
+static int boot_ctl_cache_commit(struct boot_ctl_disk_cache *cache)
+{
+	vector<struct gpt_disk*>::iterator disk_iter;
+
+	for (disk_iter = cache->disks.begin();
+			disk_iter != cache->disks.end();
+			disk_iter++) {
+		if (gpt_disk_update_crc(*disk_iter) != 0) {
+			ALOGE("%s: Failed to update gpt_disk crc",
+					__func__);
+			return -1;
+		}
+		if (gpt_disk_commit(*disk_iter)) {
+			ALOGE("Failed to commit disk entry");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void boot_ctl_cache_free(struct boot_ctl_disk_cache *cache)
+{
+	vector<struct gpt_disk*>::iterator disk_iter;
+
+	for (disk_iter = cache->disks.begin();
+			disk_iter != cache->disks.end();
+			disk_iter++)
+		gpt_disk_free(*disk_iter);
+	cache->disks.clear();
+	cache->ptn_index.clear();
+}
+
 //The argument here is a vector of partition names(including the slot suffix)
-//that lie on a single disk
-static int boot_ctl_set_active_slot_for_partitions(vector<string> part_list,
+//that lie on a single disk. The changes are made to the cached tables
+//only, boot_ctl_cache_commit writes them out.
+static int boot_ctl_set_active_slot_for_partitions(
+		struct boot_ctl_disk_cache *cache,
+		vector<string> &part_list,
 		unsigned slot)
 {
-	char buf[PATH_MAX] = {0};
-	struct gpt_disk *diskA = NULL;
-	struct gpt_disk *diskB = NULL;
 	char slotA[MAX_GPT_NAME_SIZE + 1] = {0};
 	char slotB[MAX_GPT_NAME_SIZE + 1] = {0};
 	char active_guid[TYPE_GUID_SIZE + 1] = {0};
 	char inactive_guid[TYPE_GUID_SIZE + 1] = {0};
+	struct boot_ctl_pentry *entryA = NULL;
+	struct boot_ctl_pentry *entryB = NULL;
 	//Pointer to the partition entry of current 'A' partition
 	uint8_t *pentryA = NULL;
 	uint8_t *pentryA_bak = NULL;
 	//Pointer to partition entry of current 'B' partition
 	uint8_t *pentryB = NULL;
 	uint8_t *pentryB_bak = NULL;
-	struct stat st;
 	vector<string>::iterator partition_iterator;
 
 	for (partition_iterator = part_list.begin();
@@ -411,41 +566,24 @@ static int boot_ctl_set_active_slot_for_partitions(vector<string> part_list,
 			goto error;
 		}
 		prefix.resize(prefix.size() - strlen(AB_SLOT_A_SUFFIX));
-		//Check if A/B versions of this ptn exist
-		snprintf(buf, sizeof(buf) - 1, "%s/%s%s", BOOT_DEV_DIR,
-				prefix.c_str(),
-				AB_SLOT_A_SUFFIX);
-		if (stat(buf, &st))
-			continue;
-		memset(buf, '\0', sizeof(buf));
-		snprintf(buf, sizeof(buf) - 1, "%s/%s%s", BOOT_DEV_DIR,
-				prefix.c_str(),
-				AB_SLOT_B_SUFFIX);
-		if (stat(buf, &st))
-			continue;
 		memset(slotA, 0, sizeof(slotA));
 		memset(slotB, 0, sizeof(slotB));
 		snprintf(slotA, sizeof(slotA) - 1, "%s%s", prefix.c_str(),
 				AB_SLOT_A_SUFFIX);
 		snprintf(slotB, sizeof(slotB) - 1,"%s%s", prefix.c_str(),
 				AB_SLOT_B_SUFFIX);
-		//Get the disks containing the partitions that were passed in.
-		if (!diskA) {
-			diskA = boot_ctl_get_disk_info(slotA);
-			if (!diskA)
-				goto error;
-		}
-		if (!diskB) {
-			diskB = boot_ctl_get_disk_info(slotB);
-			if (!diskB)
-				goto error;
-		}
-		//Get partition entry for slot A & B from the primary
-		//and backup tables.
-		pentryA = gpt_disk_get_pentry(diskA, slotA, PRIMARY_GPT);
-		pentryA_bak = gpt_disk_get_pentry(diskA, slotA, SECONDARY_GPT);
-		pentryB = gpt_disk_get_pentry(diskB, slotB, PRIMARY_GPT);
-		pentryB_bak = gpt_disk_get_pentry(diskB, slotB, SECONDARY_GPT);
+		//Check if A/B versions of this ptn exist and get their
+		//partition entries from the primary and backup tables.
+		entryA = boot_ctl_cache_get_pentry(cache, slotA);
+		if (!entryA)
+			continue;
+		entryB = boot_ctl_cache_get_pentry(cache, slotB);
+		if (!entryB)
+			continue;
+		pentryA = entryA->pentry;
+		pentryA_bak = entryA->pentry_bak;
+		pentryB = entryB->pentry;
+		pentryB_bak = entryB->pentry_bak;
 		if ( !pentryA || !pentryA_bak || !pentryB || !pentryB_bak) {
 			//None of these should be NULL since we have already
 			//checked for A & B versions earlier.
@@ -455,14 +593,14 @@ static int boot_ctl_set_active_slot_for_partitions(vector<string> part_list,
 		}
 		memset(active_guid, '\0', sizeof(active_guid));
 		memset(inactive_guid, '\0', sizeof(inactive_guid));
-		if (get_partition_attribute(slotA, ATTR_SLOT_ACTIVE) == 1) {
+		if (*(pentryA + AB_FLAG_OFFSET) & AB_PARTITION_ATTR_SLOT_ACTIVE) {
 			//A is the current active slot
 			memcpy((void*)active_guid, (const void*)pentryA,
 					TYPE_GUID_SIZE);
 			memcpy((void*)inactive_guid,(const void*)pentryB,
 					TYPE_GUID_SIZE);
-		} else if (get_partition_attribute(slotB,
-					ATTR_SLOT_ACTIVE) == 1) {
+		} else if (*(pentryB + AB_FLAG_OFFSET) &
+				AB_PARTITION_ATTR_SLOT_ACTIVE) {
 			//B is the current active slot
 			memcpy((void*)active_guid, (const void*)pentryB,
 					TYPE_GUID_SIZE);
@@ -498,44 +636,10 @@ static int boot_ctl_set_active_slot_for_partitions(vector<string> part_list,
 			ALOGE("%s: Unknown slot suffix!", __func__);
 			goto error;
 		}
-
-		if (diskA) {
-			if (gpt_disk_update_crc(diskA) != 0) {
-				ALOGE("%s: Failed to update gpt_disk crc",
-						__func__);
-				goto error;
-			}
-		}
-		if (diskB) {
-			if (gpt_disk_update_crc(diskB) != 0) {
-				ALOGE("%s: Failed to update gpt_disk crc",
-						__func__);
-				goto error;
-			}
-		}
-	}
-	//write updated content to disk
-	if (diskA) {
-		if (gpt_disk_commit(diskA)) {
-			ALOGE("Failed to commit disk entry");
-			goto error;
-		}
-		gpt_disk_free(diskA);
-	}
-	if (diskB) {
-		if (gpt_disk_commit(diskB)) {
-			ALOGE("Failed to commit disk entry");
-			goto error;
-		}
-		gpt_disk_free(diskB);
 	}
 	return 0;
 
 error:
-	if (diskA)
-		gpt_disk_free(diskA);
-	if (diskB)
-		gpt_disk_free(diskB);
 	return -1;
 }
 
@@ -548,6 +652,7 @@ int set_active_boot_slot(struct boot_control_module *module, unsigned slot)
 	int rc = -1;
 	int is_ufs = gpt_utils_is_ufs_device();
 	map<string, vector<string>>::iterator map_iter;
+	struct boot_ctl_disk_cache disk_cache;
 
 	if (boot_control_check_slot_sanity(module, slot)) {
 		ALOGE("%s: Bad arguments", __func__);
@@ -589,12 +694,19 @@ int set_active_boot_slot(struct boot_control_module *module, unsigned slot)
 	for (map_iter = ptn_map.begin(); map_iter != ptn_map.end(); map_iter++){
 		if (map_iter->second.size() < 1)
 			continue;
-		if (boot_ctl_set_active_slot_for_partitions(map_iter->second,
+		if (boot_ctl_set_active_slot_for_partitions(&disk_cache,
+					map_iter->second,
 					slot)) {
 			ALOGE("%s: Failed to set active slot", __func__);
 			goto error;
 		}
 	}
+	//write updated content to disk
+	if (boot_ctl_cache_commit(&disk_cache)) {
+		ALOGE("%s: Failed to set active slot", __func__);
+		goto error;
+	}
+	boot_ctl_cache_free(&disk_cache);
 	if (is_ufs) {
 		if (!strncmp(slot_suffix_arr[slot], AB_SLOT_A_SUFFIX,
 					strlen(AB_SLOT_A_SUFFIX))){
@@ -617,6 +729,7 @@ int set_active_boot_slot(struct boot_control_module *module, unsigned slot)
 	}
 	return 0;
 error:
+	boot_ctl_cache_free(&disk_cache);
 	return -1;
 }
 
@@ -18,6 +18,11 @@ GNSS_CFLAGS := \
     -Wno-error=switch \
     -Wno-error=date-time
 
+# debug and verbose logs are compiled out of user builds, see utils/log_util.h
+ifeq ($(TARGET_BUILD_VARIANT),user)
+GNSS_CFLAGS += -DLOC_LOG_MAX_LEVEL=3
+endif
+
 GNSS_HIDL_VERSION = 2.1
 
 GNSS_HIDL_LEGACY_MEASURMENTS_TARGET_LIST += msm8937
@@ -26,6 +26,7 @@ LOCAL_SRC_FILES += \
     location_api/GeofenceAPIClient.cpp \
     location_api/BatchingAPIClient.cpp \
     location_api/LocationUtil.cpp \
+    location_api/CallbackDispatcher.cpp \
 
 ifeq ($(GNSS_HIDL_LEGACY_MEASURMENTS),true)
 LOCAL_CFLAGS += \
@@ -45,12 +46,14 @@ LOCAL_HEADER_LIBRARIES := \
 LOCAL_SHARED_LIBRARIES := \
     liblog \
     libhidlbase \
+    libfmq \
     libcutils \
     libutils \
     android.hardware.gnss@1.0 \
     android.hardware.gnss@1.1 \
     android.hardware.gnss@2.0 \
     android.hardware.gnss@2.1 \
+    vendor.motorola.hardware.gnss@1.0 \
     android.hardware.gnss.measurement_corrections@1.0 \
     android.hardware.gnss.measurement_corrections@1.1 \
     android.hardware.gnss.visibility_control@1.0 \
@@ -119,6 +119,7 @@ Gnss::~Gnss() {
 }
 
 GnssAPIClient* Gnss::getApi() {
+    std::lock_guard<std::mutex> lock(mApiMutex);
     if (mApi != nullptr) {
         return mApi;
     }
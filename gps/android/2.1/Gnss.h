@@ -37,6 +37,7 @@
 #include <GnssVisibilityControl.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
+#include <mutex>
 
 #include "GnssAPIClient.h"
 
@@ -177,6 +178,9 @@ struct Gnss : public IGnss {
     sp<IMeasurementCorrectionsV1_1> mGnssMeasCorr = nullptr;
     sp<IGnssVisibilityControl> mVisibCtrl = nullptr;
 
+    // with more than one binder thread, two framework calls may race to
+    // create mApi
+    std::mutex mApiMutex;
     GnssAPIClient* mApi = nullptr;
     GnssConfig mPendingConfig;
     const GnssInterface* mGnssInterface = nullptr;
@@ -41,7 +41,7 @@ namespace implementation {
 
 static GnssAntennaInfo* spGnssAntennaInfo = nullptr;
 
-static void convertGnssAntennaInfo(std::vector<GnssAntennaInformation>& in,
+static void convertGnssAntennaInfo(const std::vector<GnssAntennaInformation>& in,
         hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo>& antennaInfos);
 
 void GnssAntennaInfo::GnssAntennaInfoDeathRecipient::serviceDied(uint64_t cookie,
@@ -63,7 +63,7 @@ void GnssAntennaInfo::GnssAntennaInfoDeathRecipient::serviceDied(uint64_t cookie
     spGnssAntennaInfo->mGnss->getGnssInterface()->antennaInfoClose();
 }
 
-static void convertGnssAntennaInfo(std::vector<GnssAntennaInformation>& in,
+static void convertGnssAntennaInfo(const std::vector<GnssAntennaInformation>& in,
         hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo>& out) {
 
     uint32_t vecSize, numberOfRows, numberOfColumns;
@@ -171,14 +171,14 @@ Return<void> GnssAntennaInfo::close(void)  {
 }
 
 void GnssAntennaInfo::aiGnssAntennaInfoCb
-        (std::vector<GnssAntennaInformation> gnssAntennaInformations) {
+        (const std::vector<GnssAntennaInformation>& gnssAntennaInformations) {
     if (nullptr != spGnssAntennaInfo) {
         spGnssAntennaInfo->gnssAntennaInfoCb(gnssAntennaInformations);
     }
 }
 
 void GnssAntennaInfo::gnssAntennaInfoCb
-        (std::vector<GnssAntennaInformation> gnssAntennaInformations) {
+        (const std::vector<GnssAntennaInformation>& gnssAntennaInformations) {
 
     if (mGnssAntennaInfoCbIface != nullptr) {
         hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo> antennaInfos;
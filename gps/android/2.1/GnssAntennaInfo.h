@@ -61,9 +61,10 @@ struct GnssAntennaInfo : public IGnssAntennaInfo {
             setCallback(const sp<IGnssAntennaInfoCallback>& callback) override;
     Return<void> close(void) override;
 
-    void gnssAntennaInfoCb(std::vector<GnssAntennaInformation> gnssAntennaInformations);
+    void gnssAntennaInfoCb(const std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
-    static void aiGnssAntennaInfoCb(std::vector<GnssAntennaInformation> gnssAntennaInformations);
+    static void aiGnssAntennaInfoCb(
+            const std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
  private:
     struct GnssAntennaInfoDeathRecipient : hidl_death_recipient {
@@ -25,6 +25,7 @@
 #include "Gnss.h"
 #include "GnssDebug.h"
 #include "LocationUtil.h"
+#include <loc_misc_utils.h>
 
 namespace android {
 namespace hardware {
@@ -49,6 +50,28 @@ GnssDebug::GnssDebug(Gnss* gnss) : mGnss(gnss)
 {
 }
 
+static inline uint64_t latencyTraceUs(uint64_t fromQtimer, uint64_t toQtimer)
+{
+    return (0 != fromQtimer && toQtimer >= fromQtimer) ?
+            qTimerTicksToNanos(toQtimer - fromQtimer) / 1000 : 0;
+}
+
+/*
+ * The HIDL debug data has no room for it, so the per stage latency of the
+ * last fixes goes to the log whenever the debug data is collected, e.g. by
+ * dumpsys location.
+ */
+static void logLatencyTrace(const GnssDebugReport& reports)
+{
+    for (auto& trace : reports.mLatencyTrace) {
+        LOC_LOGi("GnssDebug - fix latency(us): qmi->fanout %" PRIu64
+                 " fanout->dequeue %" PRIu64 " dequeue->clients done %" PRIu64,
+                 latencyTraceUs(trace.qmiIndQtimer, trace.fanOutQtimer),
+                 latencyTraceUs(trace.fanOutQtimer, trace.dequeueQtimer),
+                 latencyTraceUs(trace.dequeueQtimer, trace.clientsDoneQtimer));
+    }
+}
+
 /*
  * This methods requests position, time and satellite ephemeris debug information
  * from the HAL.
@@ -70,6 +93,7 @@ Return<void> GnssDebug::getDebugData(getDebugData_cb _hidl_cb)
     // get debug report snapshot via hal interface
     GnssDebugReport reports = { };
     mGnss->getGnssInterface()->getDebugReport(reports);
+    logLatencyTrace(reports);
 
     // location block
     if (reports.mLocation.mValid) {
@@ -188,6 +212,7 @@ Return<void> GnssDebug::getDebugData_2_0(getDebugData_2_0_cb _hidl_cb)
     // get debug report snapshot via hal interface
     GnssDebugReport reports = { };
     mGnss->getGnssInterface()->getDebugReport(reports);
+    logLatencyTrace(reports);
 
     // location block
     if (reports.mLocation.mValid) {
@@ -96,6 +96,10 @@ void GnssMeasurement::clearInterfaces() {
         mGnssMeasurementCbIface_2_1->unlinkToDeath(mGnssMeasurementDeathRecipient);
         mGnssMeasurementCbIface_2_1 = nullptr;
     }
+    if (mFmqOwner != nullptr) {
+        mFmqOwner->unlinkToDeath(mGnssMeasurementDeathRecipient);
+        mFmqOwner = nullptr;
+    }
 }
 
 Return<void> GnssMeasurement::close()  {
@@ -204,6 +208,47 @@ Return<V1_0::IGnssMeasurement::GnssMeasurementStatus> GnssMeasurement::setCallba
 
 }
 
+// Methods from ::vendor::motorola::hardware::gnss::V1_0::IGnssMeasurementFmq follow.
+Return<void> GnssMeasurement::setFmq(const sp<::android::hidl::base::V1_0::IBase>& owner,
+        bool enableFullTracking, setFmq_cb _hidl_cb) {
+    if (mFmqOwner != nullptr) {
+        LOC_LOGE("%s]: measurement queue is already set", __FUNCTION__);
+        _hidl_cb(IGnssMeasurement::GnssMeasurementStatus::ERROR_ALREADY_INIT,
+                MeasurementAPIClient::GnssFmqDescriptor());
+        return Void();
+    }
+
+    if (owner == nullptr) {
+        LOC_LOGE("%s]: owner is nullptr", __FUNCTION__);
+        _hidl_cb(IGnssMeasurement::GnssMeasurementStatus::ERROR_GENERIC,
+                MeasurementAPIClient::GnssFmqDescriptor());
+        return Void();
+    }
+    if (nullptr == mApi) {
+        LOC_LOGE("%s]: mApi is nullptr", __FUNCTION__);
+        _hidl_cb(IGnssMeasurement::GnssMeasurementStatus::ERROR_GENERIC,
+                MeasurementAPIClient::GnssFmqDescriptor());
+        return Void();
+    }
+
+    clearInterfaces();
+
+    mFmqOwner = owner;
+    mFmqOwner->linkToDeath(mGnssMeasurementDeathRecipient, 0);
+
+    GnssPowerMode powerMode = enableFullTracking ?
+            GNSS_POWER_MODE_M1 : GNSS_POWER_MODE_M2;
+
+    MeasurementAPIClient::GnssFmqDescriptor queue;
+    IGnssMeasurement::GnssMeasurementStatus status =
+            mApi->measurementSetFmq(queue, powerMode);
+    if (IGnssMeasurement::GnssMeasurementStatus::SUCCESS != status) {
+        clearInterfaces();
+    }
+    _hidl_cb(status, queue);
+    return Void();
+}
+
 }  // namespace implementation
 }  // namespace V2_1
 }  // namespace gnss
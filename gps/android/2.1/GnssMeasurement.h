@@ -22,6 +22,7 @@
 #define ANDROID_HARDWARE_GNSS_V2_1_GNSSMEASUREMENT_H
 
 #include <android/hardware/gnss/2.1/IGnssMeasurement.h>
+#include <vendor/motorola/hardware/gnss/1.0/IGnssMeasurementFmq.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 
@@ -36,9 +37,10 @@ using ::android::hardware::Void;
 using ::android::hardware::hidl_vec;
 using ::android::hardware::hidl_string;
 using ::android::sp;
+using ::vendor::motorola::hardware::gnss::V1_0::IGnssMeasurementFmq;
 
 class MeasurementAPIClient;
-struct GnssMeasurement : public V2_1::IGnssMeasurement {
+struct GnssMeasurement : public IGnssMeasurementFmq {
     GnssMeasurement();
     ~GnssMeasurement();
 
@@ -64,6 +66,10 @@ struct GnssMeasurement : public V2_1::IGnssMeasurement {
             const sp<::android::hardware::gnss::V2_1::IGnssMeasurementCallback>& callback,
             bool enableFullTracking) override;
 
+    // Methods from ::vendor::motorola::hardware::gnss::V1_0::IGnssMeasurementFmq follow.
+    Return<void> setFmq(const sp<::android::hidl::base::V1_0::IBase>& owner,
+            bool enableFullTracking, setFmq_cb _hidl_cb) override;
+
  private:
     struct GnssMeasurementDeathRecipient : hidl_death_recipient {
         GnssMeasurementDeathRecipient(sp<GnssMeasurement> gnssMeasurement) :
@@ -80,6 +86,7 @@ struct GnssMeasurement : public V2_1::IGnssMeasurement {
     sp<V1_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_1_1 = nullptr;
     sp<V2_0::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_0 = nullptr;
     sp<V2_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_1 = nullptr;
+    sp<::android::hidl::base::V1_0::IBase> mFmqOwner = nullptr;
     MeasurementAPIClient* mApi;
     void clearInterfaces();
 };
@@ -141,6 +141,7 @@ Return<bool> MeasurementCorrections::setCorrections_1_1(
     gnssMeasurementCorrections.environmentBearingUncertaintyDegrees =
             corrections.environmentBearingUncertaintyDegrees;
 
+    gnssMeasurementCorrections.satCorrections.reserve(corrections.satCorrections.size());
     for (int i = 0; i < corrections.satCorrections.size(); i++) {
         GnssSingleSatCorrection gnssSingleSatCorrection = {};
 
@@ -34,11 +34,15 @@
 #include <log_util.h>
 #include <loc_cfg.h>
 #include <thread>
+#include <algorithm>
 #include "LocationUtil.h"
 #include "BatchingAPIClient.h"
 
 #include "limits.h"
 
+// largest payload of a single gnssLocationBatchCb, well under the 1MB
+// binder transaction buffer the whole process shares
+#define BATCH_CALLBACK_MAX_BYTES_DEFAULT (128 * 1024)
 
 namespace android {
 namespace hardware {
@@ -52,16 +56,22 @@ using ::android::hardware::gnss::V2_0::GnssLocation;
 
 static void convertBatchOption(const IGnssBatching::Options& in, LocationOptions& out,
         LocationCapabilitiesMask mask);
+template <typename GnssLocationType, typename BatchingCallback>
+static void reportLocationBatch(const sp<BatchingCallback>& cbIface,
+        std::vector<Location>& cache, Location* location, size_t count, uint32_t maxBytes);
 
 BatchingAPIClient::BatchingAPIClient(const sp<V1_0::IGnssBatchingCallback>& callback) :
     LocationAPIClientBase(),
     mGnssBatchingCbIface(nullptr),
     mDefaultId(UINT_MAX),
     mLocationCapabilitiesMask(0),
-    mGnssBatchingCbIface_2_0(nullptr)
+    mGnssBatchingCbIface_2_0(nullptr),
+    mCallbackMaxBytes(BATCH_CALLBACK_MAX_BYTES_DEFAULT)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &callback);
 
+    readConfig();
+
     gnssUpdateCallbacks(callback);
 }
 
@@ -70,10 +80,13 @@ BatchingAPIClient::BatchingAPIClient(const sp<V2_0::IGnssBatchingCallback>& call
     mGnssBatchingCbIface(nullptr),
     mDefaultId(UINT_MAX),
     mLocationCapabilitiesMask(0),
-    mGnssBatchingCbIface_2_0(nullptr)
+    mGnssBatchingCbIface_2_0(nullptr),
+    mCallbackMaxBytes(BATCH_CALLBACK_MAX_BYTES_DEFAULT)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &callback);
 
+    readConfig();
+
     gnssUpdateCallbacks_2_0(callback);
 }
 
@@ -82,6 +95,15 @@ BatchingAPIClient::~BatchingAPIClient()
     LOC_LOGD("%s]: ()", __FUNCTION__);
 }
 
+void BatchingAPIClient::readConfig()
+{
+    const loc_param_s_type batchingConfTable[] =
+    {
+        { "BATCH_CALLBACK_MAX_BYTES", &mCallbackMaxBytes, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, batchingConfTable);
+}
+
 int BatchingAPIClient::getBatchSize() {
     int batchSize = locAPIGetBatchSize();
     LOC_LOGd("batchSize: %d", batchSize);
@@ -234,43 +256,53 @@ void BatchingAPIClient::onBatchingCb(size_t count, Location* location,
         size_t batchCacheCnt = mBatchedLocationInCache.size();
         LOC_LOGd("(batchCacheCnt: %zu)", batchCacheCnt);
         if (gnssBatchingCbIface_2_0 != nullptr) {
-            hidl_vec<V2_0::GnssLocation> locationVec;
-            if (count+batchCacheCnt > 0) {
-                locationVec.resize(count+batchCacheCnt);
-                for (size_t i = 0; i < batchCacheCnt; ++i) {
-                    convertGnssLocation(mBatchedLocationInCache[i], locationVec[i]);
-                }
-                for (size_t i = 0; i < count; i++) {
-                    convertGnssLocation(location[i], locationVec[i+batchCacheCnt]);
-                }
-            }
-            auto r = gnssBatchingCbIface_2_0->gnssLocationBatchCb(locationVec);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssLocationBatchCb 2_0 description=%s",
-                        __func__, r.description().c_str());
-            }
+            reportLocationBatch<V2_0::GnssLocation>(gnssBatchingCbIface_2_0,
+                    mBatchedLocationInCache, location, count, mCallbackMaxBytes);
         } else if (gnssBatchingCbIface != nullptr) {
-            hidl_vec<V1_0::GnssLocation> locationVec;
-            if (count+batchCacheCnt > 0) {
-                locationVec.resize(count+batchCacheCnt);
-                for (size_t i = 0; i < batchCacheCnt; ++i) {
-                    convertGnssLocation(mBatchedLocationInCache[i], locationVec[i]);
-                }
-                for (size_t i = 0; i < count; i++) {
-                    convertGnssLocation(location[i], locationVec[i+batchCacheCnt]);
-                }
-            }
-            auto r = gnssBatchingCbIface->gnssLocationBatchCb(locationVec);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssLocationBatchCb 1.0 description=%s",
-                        __func__, r.description().c_str());
-            }
+            reportLocationBatch<V1_0::GnssLocation>(gnssBatchingCbIface,
+                    mBatchedLocationInCache, location, count, mCallbackMaxBytes);
         }
         mBatchedLocationInCache.clear();
     }
     mMutex.unlock();
 }
 
+// Reports the cached locations, then the new ones, in callbacks of at most
+// maxBytes of locations each (0 for no limit), so a large flush neither
+// fails on the binder transaction limit nor needs one huge copy. An empty
+// batch is still reported, with one empty callback.
+template <typename GnssLocationType, typename BatchingCallback>
+static void reportLocationBatch(const sp<BatchingCallback>& cbIface,
+        std::vector<Location>& cache, Location* location, size_t count, uint32_t maxBytes)
+{
+    size_t cacheCount = cache.size();
+    size_t total = cacheCount + count;
+    size_t maxPerCallback = total;
+    if (maxBytes > 0) {
+        maxPerCallback = std::max(maxBytes / sizeof(GnssLocationType), (size_t)1);
+    }
+    size_t reported = 0;
+    do {
+        hidl_vec<GnssLocationType> locationVec;
+        locationVec.resize(std::min(maxPerCallback, total - reported));
+        for (size_t i = 0; i < locationVec.size(); i++) {
+            size_t index = reported + i;
+            if (index < cacheCount) {
+                convertGnssLocation(cache[index], locationVec[i]);
+            } else {
+                convertGnssLocation(location[index - cacheCount], locationVec[i]);
+            }
+        }
+        auto r = cbIface->gnssLocationBatchCb(locationVec);
+        if (!r.isOk()) {
+            LOC_LOGE("%s] Error from gnssLocationBatchCb description=%s, %zu of %zu reported",
+                    __func__, r.description().c_str(), reported, total);
+            break;
+        }
+        reported += locationVec.size();
+    } while (reported < total);
+}
+
 static void convertBatchOption(const IGnssBatching::Options& in, LocationOptions& out,
         LocationCapabilitiesMask mask)
 {
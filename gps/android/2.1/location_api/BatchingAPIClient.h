@@ -70,6 +70,7 @@ private:
     ~BatchingAPIClient();
 
     void setCallbacks();
+    void readConfig();
     std::mutex mMutex;
     sp<V1_0::IGnssBatchingCallback> mGnssBatchingCbIface;
     uint32_t mDefaultId;
@@ -78,6 +79,8 @@ private:
     volatile BATCHING_STATE mState = STOPPED;
 
     std::vector<Location> mBatchedLocationInCache;
+    // see BATCH_CALLBACK_MAX_BYTES in gps.conf
+    uint32_t mCallbackMaxBytes;
 };
 
 }  // namespace implementation
@@ -0,0 +1,103 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_CallbackDispatcher"
+
+#include <inttypes.h>
+#include <log_util.h>
+#include <loc_cfg.h>
+
+#include "CallbackDispatcher.h"
+
+#define HIDL_CALLBACK_QUEUE_SIZE_DEFAULT (32)
+#define HIDL_CALLBACK_QUEUE_SIZE_MAX     (1024)
+
+namespace android {
+namespace hardware {
+namespace gnss {
+namespace V2_1 {
+namespace implementation {
+
+using loc_util::MsgTask;
+
+CallbackDispatcher& CallbackDispatcher::getInstance()
+{
+    static CallbackDispatcher instance;
+    return instance;
+}
+
+CallbackDispatcher::CallbackDispatcher() :
+    mQueueSize(HIDL_CALLBACK_QUEUE_SIZE_DEFAULT),
+    mMsgTask(nullptr),
+    mPending(0),
+    mDropped(0)
+{
+    const loc_param_s_type callbackConfTable[] =
+    {
+        { "HIDL_CALLBACK_QUEUE_SIZE", &mQueueSize, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, callbackConfTable);
+    if (mQueueSize > HIDL_CALLBACK_QUEUE_SIZE_MAX) {
+        mQueueSize = HIDL_CALLBACK_QUEUE_SIZE_MAX;
+    }
+    if (mQueueSize > 0) {
+        mMsgTask = new MsgTask("HidlCbDispatch");
+    }
+    LOC_LOGd("queue size %u", mQueueSize);
+}
+
+void CallbackDispatcher::dispatch(std::function<void()> callback, bool droppable)
+{
+    if (nullptr == mMsgTask) {
+        callback();
+        return;
+    }
+    // the bound is only as exact as two reporting threads racing for the
+    // last slot allow, which is exact enough to keep the backlog in check
+    if (droppable && mPending.load(std::memory_order_relaxed) >= mQueueSize) {
+        uint64_t dropped = mDropped.fetch_add(1, std::memory_order_relaxed) + 1;
+        // log on the 1st, 2nd, 4th, 8th... drop, not on every one
+        if (0 == (dropped & (dropped - 1))) {
+            LOC_LOGw("framework is behind, %" PRIu64 " callbacks dropped so far", dropped);
+        }
+        return;
+    }
+    mPending.fetch_add(1, std::memory_order_relaxed);
+    mMsgTask->sendMsg([this, callback] {
+        callback();
+        mPending.fetch_sub(1, std::memory_order_relaxed);
+    });
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace gnss
+}  // namespace hardware
+}  // namespace android
@@ -30,13 +30,17 @@
 #define LOG_NDEBUG 0
 #define LOG_TAG "LocSvc_GnssAPIClient"
 #define SINGLE_SHOT_MIN_TRACKING_INTERVAL_MSEC (590 * 60 * 60 * 1000) // 590 hours
+#define SV_STATUS_MAX_STALENESS_MSEC_DEFAULT (1000)
 
 #include <inttypes.h>
+#include <math.h>
 #include <log_util.h>
 #include <loc_cfg.h>
+#include <LocAtrace.h>
 
 #include "LocationUtil.h"
 #include "GnssAPIClient.h"
+#include "CallbackDispatcher.h"
 #include <LocContext.h>
 
 namespace android {
@@ -50,22 +54,19 @@ using ::android::hardware::gnss::V2_1::IGnssCallback;
 using ::android::hardware::gnss::V1_0::IGnssNiCallback;
 using ::android::hardware::gnss::V2_0::GnssLocation;
 
-static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out);
-static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out);
-static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out);
+static void convertGnssSvStatus(const GnssSvNotification& in,
+        V1_0::IGnssCallback::GnssSvStatus& out);
+template <typename GnssSvInfo>
+static void convertGnssSvStatus(const GnssSvNotification& in, hidl_vec<GnssSvInfo>& out);
 
 GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
         const sp<V1_0::IGnssNiCallback>& niCb) :
     LocationAPIClientBase(),
-    mGnssCbIface(nullptr),
-    mGnssNiCbIface(nullptr),
+    mCallbacks(std::make_shared<CallbackSet>()),
     mControlClient(new LocationAPIControlClient()),
     mLocationCapabilitiesMask(0),
     mLocationCapabilitiesCached(false),
-    mTracking(false),
-    mGnssCbIface_2_0(nullptr)
+    mTracking(false)
 {
     LOC_LOGD("%s]: (%p %p)", __FUNCTION__, &gpsCb, &niCb);
 
@@ -75,13 +76,11 @@ GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
 
 GnssAPIClient::GnssAPIClient(const sp<V2_0::IGnssCallback>& gpsCb) :
     LocationAPIClientBase(),
-    mGnssCbIface(nullptr),
-    mGnssNiCbIface(nullptr),
+    mCallbacks(std::make_shared<CallbackSet>()),
     mControlClient(new LocationAPIControlClient()),
     mLocationCapabilitiesMask(0),
     mLocationCapabilitiesCached(false),
-    mTracking(false),
-    mGnssCbIface_2_0(nullptr)
+    mTracking(false)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
@@ -91,13 +90,11 @@ GnssAPIClient::GnssAPIClient(const sp<V2_0::IGnssCallback>& gpsCb) :
 
 GnssAPIClient::GnssAPIClient(const sp<V2_1::IGnssCallback>& gpsCb) :
     LocationAPIClientBase(),
-    mGnssCbIface(nullptr),
-    mGnssNiCbIface(nullptr),
+    mCallbacks(std::make_shared<CallbackSet>()),
     mControlClient(new LocationAPIControlClient()),
     mLocationCapabilitiesMask(0),
     mLocationCapabilitiesCached(false),
-    mTracking(false),
-    mGnssCbIface_2_1(nullptr)
+    mTracking(false)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
@@ -114,6 +111,17 @@ GnssAPIClient::~GnssAPIClient()
     }
 }
 
+void GnssAPIClient::onLocationApiDestroyCompleteCb()
+{
+    // a flush already queued by the timer still runs before the delete,
+    // and stopping the timer keeps another from being queued after it
+    mNmeaFlushTimer.stop();
+    // callbacks queued for this client still run before it is deleted
+    CallbackDispatcher::getInstance().dispatch([this] {
+        LocationAPIClientBase::onLocationApiDestroyCompleteCb();
+    }, false);
+}
+
 void GnssAPIClient::initLocationOptions()
 {
     // set default LocationOptions.
@@ -122,6 +130,39 @@ void GnssAPIClient::initLocationOptions()
     mTrackingOptions.minInterval = 1000;
     mTrackingOptions.minDistance = 0;
     mTrackingOptions.mode = GNSS_SUPL_MODE_STANDALONE;
+
+    mSvStatusCn0ThresholdDbHz = 0.0;
+    mSvStatusMaxStalenessMs = SV_STATUS_MAX_STALENESS_MSEC_DEFAULT;
+    const loc_param_s_type svStatusConfTable[] =
+    {
+        { "SV_STATUS_CN0_THRESHOLD", &mSvStatusCn0ThresholdDbHz, NULL, 'f' },
+        { "SV_STATUS_MAX_STALENESS_MSEC", &mSvStatusMaxStalenessMs, NULL, 'n' },
+        { "NMEA_BATCH_FLUSH_MSEC", &mNmeaBatchFlushMs, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, svStatusConfTable);
+}
+
+// An SV report is worth a callback if it is the first of the session, if
+// the SVs tracked, their order or their ephemeris/almanac/used in fix
+// flags changed, if any C/N0 moved by the threshold or more, or if the
+// last callback is older than the staleness bound.
+bool GnssAPIClient::svStatusChanged(const GnssSvNotification& gnssSvNotification) const
+{
+    if (mSvStatusCn0ThresholdDbHz <= 0.0 || !mSvStatusReported ||
+            gnssSvNotification.count != mLastSvStatus.count ||
+            uptimeMillis() - mLastSvStatusTimeMs >= mSvStatusMaxStalenessMs) {
+        return true;
+    }
+    for (uint32_t i = 0; i < gnssSvNotification.count && i < GNSS_SV_MAX; i++) {
+        const GnssSv& sv = gnssSvNotification.gnssSvs[i];
+        const GnssSv& lastSv = mLastSvStatus.gnssSvs[i];
+        if (sv.svId != lastSv.svId || sv.type != lastSv.type ||
+                sv.gnssSvOptionsMask != lastSv.gnssSvOptionsMask ||
+                fabs(sv.cN0Dbhz - lastSv.cN0Dbhz) >= mSvStatusCn0ThresholdDbHz) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void GnssAPIClient::setCallbacks()
@@ -132,7 +173,9 @@ void GnssAPIClient::setCallbacks()
 
     locationCallbacks.trackingCb = nullptr;
     locationCallbacks.trackingCb = [this](Location location) {
-        onTrackingCb(location);
+        CallbackDispatcher::getInstance().dispatch([this, location] {
+            onTrackingCb(location);
+        }, true);
     };
 
     locationCallbacks.batchingCb = nullptr;
@@ -140,7 +183,7 @@ void GnssAPIClient::setCallbacks()
     locationCallbacks.geofenceStatusCb = nullptr;
     locationCallbacks.gnssLocationInfoCb = nullptr;
     locationCallbacks.gnssNiCb = nullptr;
-    if (mGnssNiCbIface != nullptr) {
+    if (getCallbacks()->gnssNiCbIface != nullptr) {
         loc_core::ContextBase* context =
                 loc_core::LocContext::getLocContext(loc_core::LocContext::mLocationHalName);
         if (!context->hasAgpsExtendedCapabilities()) {
@@ -153,12 +196,20 @@ void GnssAPIClient::setCallbacks()
 
     locationCallbacks.gnssSvCb = nullptr;
     locationCallbacks.gnssSvCb = [this](GnssSvNotification gnssSvNotification) {
-        onGnssSvCb(gnssSvNotification);
+        CallbackDispatcher::getInstance().dispatch([this, gnssSvNotification] {
+            onGnssSvCb(gnssSvNotification);
+        }, true);
     };
 
     locationCallbacks.gnssNmeaCb = nullptr;
     locationCallbacks.gnssNmeaCb = [this](GnssNmeaNotification gnssNmeaNotification) {
-        onGnssNmeaCb(gnssNmeaNotification);
+        // the sentences are only valid for the duration of this call
+        std::string nmea(gnssNmeaNotification.nmea);
+        CallbackDispatcher::getInstance().dispatch([this, gnssNmeaNotification, nmea] {
+            GnssNmeaNotification notification = gnssNmeaNotification;
+            notification.nmea = nmea.c_str();
+            onGnssNmeaCb(notification);
+        }, true);
     };
 
     locationCallbacks.gnssMeasurementsCb = nullptr;
@@ -173,11 +224,13 @@ void GnssAPIClient::gnssUpdateCallbacks(const sp<V1_0::IGnssCallback>& gpsCb,
     LOC_LOGD("%s]: (%p %p)", __FUNCTION__, &gpsCb, &niCb);
 
     mMutex.lock();
-    mGnssCbIface = gpsCb;
-    mGnssNiCbIface = niCb;
+    CallbackSet callbacks(*getCallbacks());
+    callbacks.gnssCbIface = gpsCb;
+    callbacks.gnssNiCbIface = niCb;
+    publishCallbacks(callbacks);
     mMutex.unlock();
 
-    if (mGnssCbIface != nullptr || mGnssNiCbIface != nullptr) {
+    if (gpsCb != nullptr || niCb != nullptr) {
         setCallbacks();
     }
 }
@@ -187,10 +240,12 @@ void GnssAPIClient::gnssUpdateCallbacks_2_0(const sp<V2_0::IGnssCallback>& gpsCb
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
     mMutex.lock();
-    mGnssCbIface_2_0 = gpsCb;
+    CallbackSet callbacks(*getCallbacks());
+    callbacks.gnssCbIface_2_0 = gpsCb;
+    publishCallbacks(callbacks);
     mMutex.unlock();
 
-    if (mGnssCbIface_2_0 != nullptr) {
+    if (gpsCb != nullptr) {
         setCallbacks();
     }
 }
@@ -200,21 +255,38 @@ void GnssAPIClient::gnssUpdateCallbacks_2_1(const sp<V2_1::IGnssCallback>& gpsCb
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
 
     mMutex.lock();
-    mGnssCbIface_2_1 = gpsCb;
+    CallbackSet callbacks(*getCallbacks());
+    callbacks.gnssCbIface_2_1 = gpsCb;
+    publishCallbacks(callbacks);
     mMutex.unlock();
 
-    if (mGnssCbIface_2_1 != nullptr) {
+    if (gpsCb != nullptr) {
         setCallbacks();
     }
 }
 
+void GnssAPIClient::publishCallbacks(CallbackSet& callbacks)
+{
+    if (callbacks.gnssCbIface_2_1 != nullptr) {
+        callbacks.newestCbIface = callbacks.gnssCbIface_2_1;
+        callbacks.locationCbIface_2_0 = callbacks.gnssCbIface_2_1;
+    } else if (callbacks.gnssCbIface_2_0 != nullptr) {
+        callbacks.newestCbIface = callbacks.gnssCbIface_2_0;
+        callbacks.locationCbIface_2_0 = callbacks.gnssCbIface_2_0;
+    } else {
+        callbacks.newestCbIface = callbacks.gnssCbIface;
+        callbacks.locationCbIface_2_0 = nullptr;
+    }
+    std::atomic_store(&mCallbacks,
+            std::shared_ptr<const CallbackSet>(std::make_shared<CallbackSet>(callbacks)));
+}
+
 bool GnssAPIClient::gnssStart()
 {
     LOC_LOGD("%s]: ()", __FUNCTION__);
 
-    mMutex.lock();
+    mSvStatusReported = false;
     mTracking = true;
-    mMutex.unlock();
 
     bool retVal = true;
     locAPIStartTracking(mTrackingOptions);
@@ -225,9 +297,7 @@ bool GnssAPIClient::gnssStop()
 {
     LOC_LOGD("%s]: ()", __FUNCTION__);
 
-    mMutex.lock();
     mTracking = false;
-    mMutex.unlock();
 
     bool retVal = true;
     locAPIStopTracking();
@@ -385,11 +455,10 @@ void GnssAPIClient::onCapabilitiesCb(LocationCapabilitiesMask capabilitiesMask)
     mLocationCapabilitiesMask = capabilitiesMask;
     mLocationCapabilitiesCached = true;
 
-    mMutex.lock();
-    auto gnssCbIface(mGnssCbIface);
-    auto gnssCbIface_2_0(mGnssCbIface_2_0);
-    auto gnssCbIface_2_1(mGnssCbIface_2_1);
-    mMutex.unlock();
+    auto callbacks(getCallbacks());
+    auto& gnssCbIface(callbacks->gnssCbIface);
+    auto& gnssCbIface_2_0(callbacks->gnssCbIface_2_0);
+    auto& gnssCbIface_2_1(callbacks->gnssCbIface_2_1);
 
     if (gnssCbIface_2_1 != nullptr ||gnssCbIface_2_0 != nullptr || gnssCbIface != nullptr) {
 
@@ -486,39 +555,27 @@ void GnssAPIClient::onCapabilitiesCb(LocationCapabilitiesMask capabilitiesMask)
 
 void GnssAPIClient::onTrackingCb(Location location)
 {
-    mMutex.lock();
-    auto gnssCbIface(mGnssCbIface);
-    auto gnssCbIface_2_0(mGnssCbIface_2_0);
-    auto gnssCbIface_2_1(mGnssCbIface_2_1);
+    LOC_ATRACE_SCOPE("GnssAPIClient::onTrackingCb");
     bool isTracking = mTracking;
-    mMutex.unlock();
-
     LOC_LOGD("%s]: (flags: %02x isTracking: %d)", __FUNCTION__, location.flags, isTracking);
 
     if (!isTracking) {
         return;
     }
 
-    if (gnssCbIface_2_1 != nullptr) {
-        V2_0::GnssLocation gnssLocation;
-        convertGnssLocation(location, gnssLocation);
-        auto r = gnssCbIface_2_1->gnssLocationCb_2_0(gnssLocation);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssLocationCb_2_0 description=%s",
-                __func__, r.description().c_str());
-        }
-    } else if (gnssCbIface_2_0 != nullptr) {
+    auto callbacks(getCallbacks());
+    if (callbacks->locationCbIface_2_0 != nullptr) {
         V2_0::GnssLocation gnssLocation;
         convertGnssLocation(location, gnssLocation);
-        auto r = gnssCbIface_2_0->gnssLocationCb_2_0(gnssLocation);
+        auto r = callbacks->locationCbIface_2_0->gnssLocationCb_2_0(gnssLocation);
         if (!r.isOk()) {
             LOC_LOGE("%s] Error from gnssLocationCb_2_0 description=%s",
                 __func__, r.description().c_str());
         }
-    } else if (gnssCbIface != nullptr) {
+    } else if (callbacks->newestCbIface != nullptr) {
         V1_0::GnssLocation gnssLocation;
         convertGnssLocation(location, gnssLocation);
-        auto r = gnssCbIface->gnssLocationCb(gnssLocation);
+        auto r = callbacks->newestCbIface->gnssLocationCb(gnssLocation);
         if (!r.isOk()) {
             LOC_LOGE("%s] Error from gnssLocationCb description=%s",
                 __func__, r.description().c_str());
@@ -532,12 +589,10 @@ void GnssAPIClient::onTrackingCb(Location location)
 void GnssAPIClient::onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotification)
 {
     LOC_LOGD("%s]: (id: %d)", __FUNCTION__, id);
-    mMutex.lock();
-    auto gnssNiCbIface(mGnssNiCbIface);
-    mMutex.unlock();
+    auto gnssNiCbIface(getCallbacks()->gnssNiCbIface);
 
     if (gnssNiCbIface == nullptr) {
-        LOC_LOGE("%s]: mGnssNiCbIface is nullptr", __FUNCTION__);
+        LOC_LOGE("%s]: gnssNiCbIface is nullptr", __FUNCTION__);
         return;
     }
 
@@ -606,12 +661,18 @@ void GnssAPIClient::onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotificatio
 
 void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
 {
+    LOC_ATRACE_SCOPE("GnssAPIClient::onGnssSvCb");
     LOC_LOGD("%s]: (count: %u)", __FUNCTION__, gnssSvNotification.count);
-    mMutex.lock();
-    auto gnssCbIface(mGnssCbIface);
-    auto gnssCbIface_2_0(mGnssCbIface_2_0);
-    auto gnssCbIface_2_1(mGnssCbIface_2_1);
-    mMutex.unlock();
+    if (!svStatusChanged(gnssSvNotification)) {
+        return;
+    }
+    mSvStatusReported = true;
+    auto callbacks(getCallbacks());
+    auto& gnssCbIface(callbacks->gnssCbIface);
+    auto& gnssCbIface_2_0(callbacks->gnssCbIface_2_0);
+    auto& gnssCbIface_2_1(callbacks->gnssCbIface_2_1);
+    mLastSvStatusTimeMs = uptimeMillis();
+    mLastSvStatus = gnssSvNotification;
 
     if (gnssCbIface_2_1 != nullptr) {
         hidl_vec<V2_1::IGnssCallback::GnssSvInfo> svInfoList;
@@ -642,13 +703,12 @@ void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
 
 void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
 {
-    mMutex.lock();
-    auto gnssCbIface(mGnssCbIface);
-    auto gnssCbIface_2_0(mGnssCbIface_2_0);
-    auto gnssCbIface_2_1(mGnssCbIface_2_1);
-    mMutex.unlock();
+    LOC_ATRACE_SCOPE("GnssAPIClient::onGnssNmeaCb");
+    auto gnssCbIface(getCallbacks()->newestCbIface);
 
-    if (gnssCbIface != nullptr || gnssCbIface_2_0 != nullptr || gnssCbIface_2_1 != nullptr) {
+    if (gnssCbIface != nullptr && mNmeaBatchFlushMs > 0) {
+        batchNmea(gnssNmeaNotification);
+    } else if (gnssCbIface != nullptr) {
         const std::string s(gnssNmeaNotification.nmea);
         std::stringstream ss(s);
         std::string each;
@@ -656,78 +716,88 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
             each += '\n';
             android::hardware::hidl_string nmeaString;
             nmeaString.setToExternal(each.c_str(), each.length());
-            if (gnssCbIface_2_1 != nullptr) {
-                auto r = gnssCbIface_2_1->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
-                if (!r.isOk()) {
-                    LOC_LOGE("%s] Error from gnssCbIface_2_1 nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
-                             r.description().c_str());
-                }
-            } else if (gnssCbIface_2_0 != nullptr) {
-                auto r = gnssCbIface_2_0->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
-                if (!r.isOk()) {
-                    LOC_LOGE("%s] Error from gnssCbIface_2_0 nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
-                             r.description().c_str());
-                }
-            } else if (gnssCbIface != nullptr) {
-                auto r = gnssCbIface->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
-                if (!r.isOk()) {
-                    LOC_LOGE("%s] Error from gnssNmeaCb nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
-                             r.description().c_str());
-                }
+            auto r = gnssCbIface->gnssNmeaCb(
+                    static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssNmeaCb nmea=%s length=%u description=%s",
+                         __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
+                         r.description().c_str());
             }
         }
     }
 }
 
+// Sentences are held until the epoch ends, i.e. until the GGA sentence
+// loc_nmea_generate_pos() puts out last, or until the flush timeout for an
+// epoch with no GGA, and then go out in one gnssNmeaCb.
+void GnssAPIClient::batchNmea(const GnssNmeaNotification& gnssNmeaNotification)
+{
+    bool epochStart = false;
+    bool epochEnd = false;
+    mNmeaBatchMutex.lock();
+    if (mNmeaBatch.empty()) {
+        epochStart = true;
+        mNmeaBatchTimestamp = gnssNmeaNotification.timestamp;
+    }
+    mNmeaBatch += gnssNmeaNotification.nmea;
+    if (!mNmeaBatch.empty() && mNmeaBatch.back() != '\n') {
+        mNmeaBatch += '\n';
+    }
+    epochEnd = (nullptr != strstr(gnssNmeaNotification.nmea, "GGA,"));
+    mNmeaBatchMutex.unlock();
+
+    if (epochEnd) {
+        mNmeaFlushTimer.stop();
+        flushNmeaBatch();
+    } else if (epochStart) {
+        mNmeaFlushTimer.start(mNmeaBatchFlushMs, false);
+    }
+}
+
+void GnssAPIClient::flushNmeaBatch()
+{
+    std::string nmea;
+    mNmeaBatchMutex.lock();
+    nmea.swap(mNmeaBatch);
+    uint64_t timestamp = mNmeaBatchTimestamp;
+    mNmeaBatchMutex.unlock();
+
+    auto gnssCbIface(getCallbacks()->newestCbIface);
+    if (gnssCbIface != nullptr && !nmea.empty()) {
+        android::hardware::hidl_string nmeaString;
+        nmeaString.setToExternal(nmea.c_str(), nmea.length());
+        auto r = gnssCbIface->gnssNmeaCb(static_cast<V1_0::GnssUtcTime>(timestamp), nmeaString);
+        if (!r.isOk()) {
+            LOC_LOGE("%s] Error from gnssNmeaCb length=%zu description=%s",
+                     __func__, nmea.length(), r.description().c_str());
+        }
+    }
+}
+
+void GnssAPIClient::NmeaFlushTimer::timeOutCallback()
+{
+    // the batch goes out on the callback thread, in order with the rest
+    GnssAPIClient* client = &mClient;
+    CallbackDispatcher::getInstance().dispatch([client] {
+        client->flushNmeaBatch();
+    }, false);
+}
+
 void GnssAPIClient::onStartTrackingCb(LocationError error)
 {
     LOC_LOGD("%s]: (%d)", __FUNCTION__, error);
-    mMutex.lock();
-    auto gnssCbIface(mGnssCbIface);
-    auto gnssCbIface_2_0(mGnssCbIface_2_0);
-    auto gnssCbIface_2_1(mGnssCbIface_2_1);
-    mMutex.unlock();
+    auto gnssCbIface(getCallbacks()->newestCbIface);
 
-    if (error == LOCATION_ERROR_SUCCESS) {
-        if (gnssCbIface_2_1 != nullptr) {
-            auto r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_ON description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_BEGIN description=%s",
-                    __func__, r.description().c_str());
-            }
-        } else if (gnssCbIface_2_0 != nullptr) {
-            auto r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_ON description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_BEGIN description=%s",
-                    __func__, r.description().c_str());
-            }
-        } else if (gnssCbIface != nullptr) {
-            auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb ENGINE_ON description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb SESSION_BEGIN description=%s",
-                    __func__, r.description().c_str());
-            }
+    if (error == LOCATION_ERROR_SUCCESS && gnssCbIface != nullptr) {
+        auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
+        if (!r.isOk()) {
+            LOC_LOGE("%s] Error from gnssStatusCb ENGINE_ON description=%s",
+                __func__, r.description().c_str());
+        }
+        r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
+        if (!r.isOk()) {
+            LOC_LOGE("%s] Error from gnssStatusCb SESSION_BEGIN description=%s",
+                __func__, r.description().c_str());
         }
     }
 }
@@ -735,52 +805,57 @@ void GnssAPIClient::onStartTrackingCb(LocationError error)
 void GnssAPIClient::onStopTrackingCb(LocationError error)
 {
     LOC_LOGD("%s]: (%d)", __FUNCTION__, error);
-    mMutex.lock();
-    auto gnssCbIface(mGnssCbIface);
-    auto gnssCbIface_2_0(mGnssCbIface_2_0);
-    auto gnssCbIface_2_1(mGnssCbIface_2_1);
-    mMutex.unlock();
-
-    if (error == LOCATION_ERROR_SUCCESS) {
-        if (gnssCbIface_2_1 != nullptr) {
-            auto r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_END description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_OFF description=%s",
-                    __func__, r.description().c_str());
-            }
-        } else if (gnssCbIface_2_0 != nullptr) {
-            auto r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_END description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_OFF description=%s",
-                    __func__, r.description().c_str());
-            }
+    auto gnssCbIface(getCallbacks()->newestCbIface);
 
-        } else if (gnssCbIface != nullptr) {
-            auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb SESSION_END description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb ENGINE_OFF description=%s",
-                    __func__, r.description().c_str());
-            }
+    if (error == LOCATION_ERROR_SUCCESS && gnssCbIface != nullptr) {
+        auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
+        if (!r.isOk()) {
+            LOC_LOGE("%s] Error from gnssStatusCb SESSION_END description=%s",
+                __func__, r.description().c_str());
+        }
+        r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
+        if (!r.isOk()) {
+            LOC_LOGE("%s] Error from gnssStatusCb ENGINE_OFF description=%s",
+                __func__, r.description().c_str());
         }
     }
 }
 
-static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out)
+static void convertGnssSvInfo(const GnssSv& in, V1_0::IGnssCallback::GnssSvInfo& out)
+{
+    convertGnssSvid(in, out.svid);
+    convertGnssConstellationType(in.type, out.constellation);
+    out.cN0Dbhz = in.cN0Dbhz;
+    out.elevationDegrees = in.elevation;
+    out.azimuthDegrees = in.azimuth;
+    out.carrierFrequencyHz = in.carrierFrequencyHz;
+    out.svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
+    if (in.gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
+        out.svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
+    if (in.gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
+        out.svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
+    if (in.gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
+        out.svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
+    if (in.gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
+        out.svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
+}
+
+// Each version extends the sv info of the version before it, so each
+// converter fills in the older sv info first and then its own fields.
+static void convertGnssSvInfo(const GnssSv& in, V2_0::IGnssCallback::GnssSvInfo& out)
+{
+    convertGnssSvInfo(in, out.v1_0);
+    convertGnssConstellationType(in.type, out.constellation);
+}
+
+static void convertGnssSvInfo(const GnssSv& in, V2_1::IGnssCallback::GnssSvInfo& out)
+{
+    convertGnssSvInfo(in, out.v2_0);
+    out.basebandCN0DbHz = in.basebandCarrierToNoiseDbHz;
+}
+
+static void convertGnssSvStatus(const GnssSvNotification& in,
+        V1_0::IGnssCallback::GnssSvStatus& out)
 {
     memset(&out, 0, sizeof(IGnssCallback::GnssSvStatus));
     out.numSvs = in.count;
@@ -790,70 +865,16 @@ static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::Gns
         out.numSvs = static_cast<uint32_t>(V1_0::GnssMax::SVS_COUNT);
     }
     for (size_t i = 0; i < out.numSvs; i++) {
-        convertGnssSvid(in.gnssSvs[i], out.gnssSvList[i].svid);
-        convertGnssConstellationType(in.gnssSvs[i].type, out.gnssSvList[i].constellation);
-        out.gnssSvList[i].cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
-        out.gnssSvList[i].elevationDegrees = in.gnssSvs[i].elevation;
-        out.gnssSvList[i].azimuthDegrees = in.gnssSvs[i].azimuth;
-        out.gnssSvList[i].carrierFrequencyHz = in.gnssSvs[i].carrierFrequencyHz;
-        out.gnssSvList[i].svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
-            out.gnssSvList[i].svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
-    }
-}
-
-static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out)
-{
-    out.resize(in.count);
-    for (size_t i = 0; i < in.count; i++) {
-        convertGnssSvid(in.gnssSvs[i], out[i].v1_0.svid);
-        out[i].v1_0.cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
-        out[i].v1_0.elevationDegrees = in.gnssSvs[i].elevation;
-        out[i].v1_0.azimuthDegrees = in.gnssSvs[i].azimuth;
-        out[i].v1_0.carrierFrequencyHz = in.gnssSvs[i].carrierFrequencyHz;
-        out[i].v1_0.svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
-            out[i].v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
-
-        convertGnssConstellationType(in.gnssSvs[i].type, out[i].constellation);
+        convertGnssSvInfo(in.gnssSvs[i], out.gnssSvList[i]);
     }
 }
 
-static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out)
+template <typename GnssSvInfo>
+static void convertGnssSvStatus(const GnssSvNotification& in, hidl_vec<GnssSvInfo>& out)
 {
     out.resize(in.count);
     for (size_t i = 0; i < in.count; i++) {
-        convertGnssSvid(in.gnssSvs[i], out[i].v2_0.v1_0.svid);
-        out[i].v2_0.v1_0.cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
-        out[i].v2_0.v1_0.elevationDegrees = in.gnssSvs[i].elevation;
-        out[i].v2_0.v1_0.azimuthDegrees = in.gnssSvs[i].azimuth;
-        out[i].v2_0.v1_0.carrierFrequencyHz = in.gnssSvs[i].carrierFrequencyHz;
-        out[i].v2_0.v1_0.svFlag = static_cast<uint8_t>(IGnssCallback::GnssSvFlags::NONE);
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_EPHEMERIS_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_ALMANAC_DATA;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::USED_IN_FIX;
-        if (in.gnssSvs[i].gnssSvOptionsMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT)
-            out[i].v2_0.v1_0.svFlag |= IGnssCallback::GnssSvFlags::HAS_CARRIER_FREQUENCY;
-
-        convertGnssConstellationType(in.gnssSvs[i].type, out[i].v2_0.constellation);
-        out[i].basebandCN0DbHz = in.gnssSvs[i].basebandCarrierToNoiseDbHz;
+        convertGnssSvInfo(in.gnssSvs[i], out[i]);
     }
 }
 
@@ -31,10 +31,14 @@
 #define GNSS_API_CLINET_H
 
 
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <android/hardware/gnss/2.1/IGnss.h>
 #include <android/hardware/gnss/2.1/IGnssCallback.h>
 #include <LocationAPIClientBase.h>
+#include <LocTimer.h>
 
 namespace android {
 namespace hardware {
@@ -43,6 +47,7 @@ namespace V2_1 {
 namespace implementation {
 
 using ::android::sp;
+using loc_util::LocTimer;
 
 class GnssAPIClient : public LocationAPIClientBase
 {
@@ -92,22 +97,65 @@ public:
 
     void onStartTrackingCb(LocationError error) final;
     void onStopTrackingCb(LocationError error) final;
+    void onLocationApiDestroyCompleteCb() final;
 
 private:
     virtual ~GnssAPIClient();
     void setCallbacks();
     void initLocationOptions();
+    bool svStatusChanged(const GnssSvNotification& gnssSvNotification) const;
+    void batchNmea(const GnssNmeaNotification& gnssNmeaNotification);
+    void flushNmeaBatch();
 
-    sp<V1_0::IGnssCallback> mGnssCbIface;
-    sp<V1_0::IGnssNiCallback> mGnssNiCbIface;
+    class NmeaFlushTimer : public LocTimer {
+        GnssAPIClient& mClient;
+    public:
+        inline NmeaFlushTimer(GnssAPIClient& client) : LocTimer(), mClient(client) {}
+        void timeOutCallback() override;
+    };
+
+    // The framework callbacks in use. A set is never modified once
+    // published: gnssUpdateCallbacks*() build a new one under mMutex and
+    // swap it in, and the callbacks above read it without a lock.
+    struct CallbackSet {
+        sp<V1_0::IGnssCallback> gnssCbIface;
+        sp<V1_0::IGnssNiCallback> gnssNiCbIface;
+        sp<V2_0::IGnssCallback> gnssCbIface_2_0;
+        sp<V2_1::IGnssCallback> gnssCbIface_2_1;
+        // Resolved once per registration. Every version inherits the 1.0
+        // methods, and 2.1 the 2.0 ones, so the status, NMEA and location
+        // callbacks go to the newest interface without a version check.
+        sp<V1_0::IGnssCallback> newestCbIface;
+        sp<V2_0::IGnssCallback> locationCbIface_2_0;
+    };
+    inline std::shared_ptr<const CallbackSet> getCallbacks() const {
+        return std::atomic_load(&mCallbacks);
+    }
+    void publishCallbacks(CallbackSet& callbacks);
+
+    std::shared_ptr<const CallbackSet> mCallbacks;
     std::mutex mMutex;
     LocationAPIControlClient* mControlClient;
     LocationCapabilitiesMask mLocationCapabilitiesMask;
     bool mLocationCapabilitiesCached;
     TrackingOptions mTrackingOptions;
-    bool mTracking;
-    sp<V2_0::IGnssCallback> mGnssCbIface_2_0;
-    sp<V2_1::IGnssCallback> mGnssCbIface_2_1;
+    std::atomic<bool> mTracking;
+
+    // SV status filter, see SV_STATUS_CN0_THRESHOLD in gps.conf. The last
+    // report is only touched from the callback thread; gnssStart() clears
+    // mSvStatusReported to have the next report go out.
+    double mSvStatusCn0ThresholdDbHz = 0.0;
+    uint32_t mSvStatusMaxStalenessMs = 0;
+    std::atomic<bool> mSvStatusReported{false};
+    uint64_t mLastSvStatusTimeMs = 0;
+    GnssSvNotification mLastSvStatus = {};
+
+    // NMEA batching, see NMEA_BATCH_FLUSH_MSEC in gps.conf, 0 when off
+    uint32_t mNmeaBatchFlushMs = 0;
+    std::mutex mNmeaBatchMutex;
+    std::string mNmeaBatch;
+    uint64_t mNmeaBatchTimestamp = 0;
+    NmeaFlushTimer mNmeaFlushTimer{*this};
 };
 
 }  // namespace implementation
@@ -149,7 +149,7 @@ void convertGnssLocation(const V2_0::GnssLocation& in, Location& out)
     convertGnssLocation(in.v1_0, out);
 }
 
-void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& out)
+void convertGnssConstellationType(const GnssSvType& in, V1_0::GnssConstellationType& out)
 {
     switch(in) {
         case GNSS_SV_TYPE_GPS:
@@ -177,7 +177,7 @@ void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& o
     }
 }
 
-void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& out)
+void convertGnssConstellationType(const GnssSvType& in, V2_0::GnssConstellationType& out)
 {
     switch(in) {
         case GNSS_SV_TYPE_GPS:
@@ -208,7 +208,7 @@ void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& o
     }
 }
 
-void convertGnssSvid(GnssSv& in, int16_t& out)
+void convertGnssSvid(const GnssSv& in, int16_t& out)
 {
     switch (in.type) {
         case GNSS_SV_TYPE_GPS:
@@ -242,7 +242,7 @@ void convertGnssSvid(GnssSv& in, int16_t& out)
     }
 }
 
-void convertGnssSvid(GnssMeasurementsData& in, int16_t& out)
+void convertGnssSvid(const GnssMeasurementsData& in, int16_t& out)
 {
     switch (in.svType) {
         case GNSS_SV_TYPE_GPS:
@@ -390,6 +390,7 @@ void convertMeasurementCorrections(const MeasurementCorrectionsV1_0& in,
     out.verticalPositionUncertaintyMeters = in.verticalPositionUncertaintyMeters;
     out.toaGpsNanosecondsOfWeek = in.toaGpsNanosecondsOfWeek;
 
+    out.satCorrections.reserve(in.satCorrections.size());
     for (int i = 0; i < in.satCorrections.size(); i++) {
         GnssSingleSatCorrection gnssSingleSatCorrection = {};
 
@@ -32,10 +32,12 @@
 
 #include <log_util.h>
 #include <loc_cfg.h>
+#include <LocAtrace.h>
 #include <inttypes.h>
 
 #include "LocationUtil.h"
 #include "MeasurementAPIClient.h"
+#include "CallbackDispatcher.h"
 #include <loc_misc_utils.h>
 
 namespace android {
@@ -46,30 +48,47 @@ namespace implementation {
 
 using ::android::hardware::gnss::V1_0::IGnssMeasurement;
 using ::android::hardware::gnss::V2_0::IGnssMeasurementCallback;
+using ::android::hardware::EventFlag;
+using ::vendor::motorola::hardware::gnss::V1_0::GnssFmqData;
+using ::vendor::motorola::hardware::gnss::V1_0::GnssFmqEventBits;
+using ::vendor::motorola::hardware::gnss::V1_0::GnssFmqMeasurement;
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+// epochs the measurement queue holds, a reader may fall this far behind
+static const size_t GNSS_FMQ_DEPTH = 8;
+
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssData_1_1(GnssMeasurementsNotification& in,
-        V1_1::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssData_2_0(GnssMeasurementsNotification& in,
-        V2_0::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssData_2_1(GnssMeasurementsNotification& in,
-        V2_1::IGnssMeasurementCallback::GnssData& out);
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+template <typename GnssMeasurement, typename GnssData>
+static void convertGnssData(const GnssMeasurementsNotification& in,
+        std::vector<GnssMeasurement>& measurements, GnssData& out);
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out);
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out);
-static void convertGnssClock_2_1(GnssMeasurementsClock& in,
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
+        V1_1::IGnssMeasurementCallback::GnssMeasurement& out);
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
+        V2_0::IGnssMeasurementCallback::GnssMeasurement& out);
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
+        V2_1::IGnssMeasurementCallback::GnssMeasurement& out);
+static void convertGnssData(const GnssMeasurementsNotification& in, GnssFmqData& out);
+static void convertGnssMeasurement(const GnssMeasurementsData& in, GnssFmqMeasurement& out);
+static uint32_t convertGnssMeasurementFlags(const GnssMeasurementsDataFlagsMask& in);
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out);
+static void convertGnssClock(const GnssMeasurementsClock& in,
         V2_1::IGnssMeasurementCallback::GnssClock& out);
-static void convertGnssMeasurementsCodeType(GnssMeasurementsCodeType& inCodeType,
-        char* inOtherCodeTypeName,
+static const char* convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType& inCodeType,
+        const char* inOtherCodeTypeName);
+static void convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType& inCodeType,
+        const char* inOtherCodeTypeName,
         ::android::hardware::hidl_string& out);
-static void convertGnssMeasurementsAccumulatedDeltaRangeState(GnssMeasurementsAdrStateMask& in,
+static void convertGnssMeasurementsAccumulatedDeltaRangeState(
+        const GnssMeasurementsAdrStateMask& in,
         ::android::hardware::hidl_bitfield
                 <V1_1::IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState>& out);
-static void convertGnssMeasurementsState(GnssMeasurementsStateMask& in,
+static void convertGnssMeasurementsState(const GnssMeasurementsStateMask& in,
         ::android::hardware::hidl_bitfield
                 <V2_0::IGnssMeasurementCallback::GnssMeasurementState>& out);
-static void convertElapsedRealtimeNanos(GnssMeasurementsNotification& in,
+static void convertElapsedRealtimeNanos(const GnssMeasurementsNotification& in,
         ::android::hardware::gnss::V2_0::ElapsedRealtime& elapsedRealtimeNanos);
 
 MeasurementAPIClient::MeasurementAPIClient() :
@@ -87,12 +106,30 @@ MeasurementAPIClient::~MeasurementAPIClient()
     LOC_LOGD("%s]: ()", __FUNCTION__);
 }
 
+MeasurementAPIClient::GnssFmq::GnssFmq() :
+    queue(GNSS_FMQ_DEPTH, true),
+    eventFlag(nullptr)
+{
+    if (queue.isValid() &&
+        EventFlag::createEventFlag(queue.getEventFlagWord(), &eventFlag) != ::android::OK) {
+        eventFlag = nullptr;
+    }
+}
+
+MeasurementAPIClient::GnssFmq::~GnssFmq()
+{
+    if (eventFlag != nullptr) {
+        EventFlag::deleteEventFlag(&eventFlag);
+    }
+}
+
 void MeasurementAPIClient::clearInterfaces()
 {
     mGnssMeasurementCbIface = nullptr;
     mGnssMeasurementCbIface_1_1 = nullptr;
     mGnssMeasurementCbIface_2_0 = nullptr;
     mGnssMeasurementCbIface_2_1 = nullptr;
+    mFmq = nullptr;
 }
 
 // for GpsInterface
@@ -154,6 +191,28 @@ Return<IGnssMeasurement::GnssMeasurementStatus> MeasurementAPIClient::measuremen
 
     return startTracking(powerMode, timeBetweenMeasurement);
 }
+
+Return<IGnssMeasurement::GnssMeasurementStatus> MeasurementAPIClient::measurementSetFmq(
+        GnssFmqDescriptor& queue,
+        GnssPowerMode powerMode, uint32_t timeBetweenMeasurement) {
+    LOC_LOGD("%s]: (powermode: %d) (tbm: %d)",
+        __FUNCTION__, (int)powerMode, timeBetweenMeasurement);
+
+    std::shared_ptr<GnssFmq> fmq = std::make_shared<GnssFmq>();
+    if (!fmq->queue.isValid() || nullptr == fmq->eventFlag) {
+        LOC_LOGE("%s]: failed to create the measurement queue", __FUNCTION__);
+        return IGnssMeasurement::GnssMeasurementStatus::ERROR_GENERIC;
+    }
+    queue = *fmq->queue.getDesc();
+
+    mMutex.lock();
+    clearInterfaces();
+    mFmq = fmq;
+    mMutex.unlock();
+
+    return startTracking(powerMode, timeBetweenMeasurement);
+}
+
 Return<IGnssMeasurement::GnssMeasurementStatus>
 MeasurementAPIClient::startTracking(
         GnssPowerMode powerMode, uint32_t timeBetweenMeasurement)
@@ -172,13 +231,17 @@ MeasurementAPIClient::startTracking(
     locationCallbacks.gnssNmeaCb = nullptr;
 
     locationCallbacks.gnssMeasurementsCb = nullptr;
-    if (mGnssMeasurementCbIface_2_1 != nullptr ||
+    if (mFmq != nullptr ||
+        mGnssMeasurementCbIface_2_1 != nullptr ||
         mGnssMeasurementCbIface_2_0 != nullptr ||
         mGnssMeasurementCbIface_1_1 != nullptr ||
         mGnssMeasurementCbIface != nullptr) {
         locationCallbacks.gnssMeasurementsCb =
             [this](GnssMeasurementsNotification gnssMeasurementsNotification) {
-                onGnssMeasurementsCb(gnssMeasurementsNotification);
+                CallbackDispatcher::getInstance().dispatch(
+                        [this, gnssMeasurementsNotification] {
+                    reportGnssMeasurements(gnssMeasurementsNotification);
+                }, true);
             };
     }
 
@@ -200,6 +263,14 @@ MeasurementAPIClient::startTracking(
     return IGnssMeasurement::GnssMeasurementStatus::SUCCESS;
 }
 
+void MeasurementAPIClient::onLocationApiDestroyCompleteCb()
+{
+    // callbacks queued for this client still run before it is deleted
+    CallbackDispatcher::getInstance().dispatch([this] {
+        LocationAPIClientBase::onLocationApiDestroyCompleteCb();
+    }, false);
+}
+
 // for GpsMeasurementInterface
 void MeasurementAPIClient::measurementClose() {
     LOC_LOGD("%s]: ()", __FUNCTION__);
@@ -210,6 +281,13 @@ void MeasurementAPIClient::measurementClose() {
 // callbacks
 void MeasurementAPIClient::onGnssMeasurementsCb(
         GnssMeasurementsNotification gnssMeasurementsNotification)
+{
+    LOC_ATRACE_SCOPE("MeasurementAPIClient::onGnssMeasurementsCb");
+    reportGnssMeasurements(gnssMeasurementsNotification);
+}
+
+void MeasurementAPIClient::reportGnssMeasurements(
+        const GnssMeasurementsNotification& gnssMeasurementsNotification)
 {
     LOC_LOGD("%s]: (count: %u active: %d)",
             __FUNCTION__, gnssMeasurementsNotification.count, mTracking);
@@ -219,6 +297,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
         sp<V1_1::IGnssMeasurementCallback> gnssMeasurementCbIface_1_1 = nullptr;
         sp<V2_0::IGnssMeasurementCallback> gnssMeasurementCbIface_2_0 = nullptr;
         sp<V2_1::IGnssMeasurementCallback> gnssMeasurementCbIface_2_1 = nullptr;
+        std::shared_ptr<GnssFmq> fmq = mFmq;
         if (mGnssMeasurementCbIface_2_1 != nullptr) {
             gnssMeasurementCbIface_2_1 = mGnssMeasurementCbIface_2_1;
         } else if (mGnssMeasurementCbIface_2_0 != nullptr) {
@@ -230,9 +309,19 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
         }
         mMutex.unlock();
 
-        if (gnssMeasurementCbIface_2_1 != nullptr) {
+        if (fmq != nullptr) {
+            // the epoch is converted in place in the shared memory of the queue
+            GnssFmqQueue::MemTransaction tx;
+            if (fmq->queue.beginWrite(1, &tx)) {
+                convertGnssData(gnssMeasurementsNotification, *tx.getSlot(0));
+                fmq->queue.commitWrite(1);
+                fmq->eventFlag->wake(static_cast<uint32_t>(GnssFmqEventBits::EPOCH_WRITTEN));
+            } else {
+                LOC_LOGE("%s] Failed to write to the measurement queue", __func__);
+            }
+        } else if (gnssMeasurementCbIface_2_1 != nullptr) {
             V2_1::IGnssMeasurementCallback::GnssData gnssData;
-            convertGnssData_2_1(gnssMeasurementsNotification, gnssData);
+            convertGnssData(gnssMeasurementsNotification, mMeasurements_2_1, gnssData);
             auto r = gnssMeasurementCbIface_2_1->gnssMeasurementCb_2_1(gnssData);
             if (!r.isOk()) {
                 LOC_LOGE("%s] Error from gnssMeasurementCb description=%s",
@@ -240,7 +329,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
             }
         } else if (gnssMeasurementCbIface_2_0 != nullptr) {
             V2_0::IGnssMeasurementCallback::GnssData gnssData;
-            convertGnssData_2_0(gnssMeasurementsNotification, gnssData);
+            convertGnssData(gnssMeasurementsNotification, mMeasurements_2_0, gnssData);
             auto r = gnssMeasurementCbIface_2_0->gnssMeasurementCb_2_0(gnssData);
             if (!r.isOk()) {
                 LOC_LOGE("%s] Error from gnssMeasurementCb description=%s",
@@ -248,7 +337,7 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
             }
         } else if (gnssMeasurementCbIface_1_1 != nullptr) {
             V1_1::IGnssMeasurementCallback::GnssData gnssData;
-            convertGnssData_1_1(gnssMeasurementsNotification, gnssData);
+            convertGnssData(gnssMeasurementsNotification, mMeasurements_1_1, gnssData);
             auto r = gnssMeasurementCbIface_1_1->gnssMeasurementCb(gnssData);
             if (!r.isOk()) {
                 LOC_LOGE("%s] Error from gnssMeasurementCb description=%s",
@@ -266,7 +355,18 @@ void MeasurementAPIClient::onGnssMeasurementsCb(
     }
 }
 
-static void convertGnssMeasurement(GnssMeasurementsData& in,
+// Points out at storage, sized to count. storage keeps its capacity, and the
+// strings of its elements their buffers, from one epoch to the next, so a
+// steady number of measurements converts without allocating.
+template <typename T>
+static inline void useMeasurementStorage(std::vector<T>& storage, size_t count,
+        ::android::hardware::hidl_vec<T>& out)
+{
+    storage.resize(count);
+    out.setToExternal(storage.data(), storage.size());
+}
+
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
         V1_0::IGnssMeasurementCallback::GnssMeasurement& out)
 {
     memset(&out, 0, sizeof(out));
@@ -345,7 +445,8 @@ static void convertGnssMeasurement(GnssMeasurementsData& in,
     out.agcLevelDb = in.agcLevelDb;
 }
 
-static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback::GnssClock& out)
+static void convertGnssClock(const GnssMeasurementsClock& in,
+        IGnssMeasurementCallback::GnssClock& out)
 {
     memset(&out, 0, sizeof(out));
     if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT)
@@ -373,10 +474,10 @@ static void convertGnssClock(GnssMeasurementsClock& in, IGnssMeasurementCallback
     out.hwClockDiscontinuityCount = in.hwClockDiscontinuityCount;
 }
 
-static void convertGnssClock_2_1(GnssMeasurementsClock& in,
+static void convertGnssClock(const GnssMeasurementsClock& in,
         V2_1::IGnssMeasurementCallback::GnssClock& out)
 {
-    memset(&out, 0, sizeof(out));
+    // every field is set below; a memset would leak the codeType string
     convertGnssClock(in, out.v1_0);
     convertGnssConstellationType(in.referenceSignalTypeForIsb.svType,
             out.referenceSignalTypeForIsb.constellation);
@@ -387,7 +488,7 @@ static void convertGnssClock_2_1(GnssMeasurementsClock& in,
             out.referenceSignalTypeForIsb.codeType);
 }
 
-static void convertGnssData(GnssMeasurementsNotification& in,
+static void convertGnssData(const GnssMeasurementsNotification& in,
         V1_0::IGnssMeasurementCallback::GnssData& out)
 {
     memset(&out, 0, sizeof(out));
@@ -403,93 +504,73 @@ static void convertGnssData(GnssMeasurementsNotification& in,
     convertGnssClock(in.clock, out.clock);
 }
 
-static void convertGnssData_1_1(GnssMeasurementsNotification& in,
-        V1_1::IGnssMeasurementCallback::GnssData& out)
+static const char* convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType& inCodeType,
+        const char* inOtherCodeTypeName)
 {
-    memset(&out, 0, sizeof(out));
-    out.measurements.resize(in.count);
-    for (size_t i = 0; i < in.count; i++) {
-        convertGnssMeasurement(in.measurements[i], out.measurements[i].v1_0);
-        convertGnssMeasurementsAccumulatedDeltaRangeState(in.measurements[i].adrStateMask,
-                out.measurements[i].accumulatedDeltaRangeState);
-    }
-    convertGnssClock(in.clock, out.clock);
-}
-
-static void convertGnssData_2_0(GnssMeasurementsNotification& in,
-        V2_0::IGnssMeasurementCallback::GnssData& out)
-{
-    memset(&out, 0, sizeof(out));
-    out.measurements.resize(in.count);
-    for (size_t i = 0; i < in.count; i++) {
-        convertGnssMeasurement(in.measurements[i], out.measurements[i].v1_1.v1_0);
-        convertGnssConstellationType(in.measurements[i].svType, out.measurements[i].constellation);
-        convertGnssMeasurementsCodeType(in.measurements[i].codeType,
-            in.measurements[i].otherCodeTypeName,
-            out.measurements[i].codeType);
-        convertGnssMeasurementsAccumulatedDeltaRangeState(in.measurements[i].adrStateMask,
-                out.measurements[i].v1_1.accumulatedDeltaRangeState);
-        convertGnssMeasurementsState(in.measurements[i].stateMask, out.measurements[i].state);
-    }
-    convertGnssClock(in.clock, out.clock);
-    convertElapsedRealtimeNanos(in, out.elapsedRealtime);
-}
-
-static void convertGnssMeasurementsCodeType(GnssMeasurementsCodeType& inCodeType,
-        char* inOtherCodeTypeName, ::android::hardware::hidl_string& out)
-{
-    memset(&out, 0, sizeof(out));
+    const char* codeType = nullptr;
     switch(inCodeType) {
         case GNSS_MEASUREMENTS_CODE_TYPE_A:
-            out = "A";
+            codeType = "A";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_B:
-            out = "B";
+            codeType = "B";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_C:
-            out = "C";
+            codeType = "C";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_I:
-            out = "I";
+            codeType = "I";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_L:
-            out = "L";
+            codeType = "L";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_M:
-            out = "M";
+            codeType = "M";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_P:
-            out = "P";
+            codeType = "P";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_Q:
-            out = "Q";
+            codeType = "Q";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_S:
-            out = "S";
+            codeType = "S";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_W:
-            out = "W";
+            codeType = "W";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_X:
-            out = "X";
+            codeType = "X";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_Y:
-            out = "Y";
+            codeType = "Y";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_Z:
-            out = "Z";
+            codeType = "Z";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_N:
-            out = "N";
+            codeType = "N";
             break;
         case GNSS_MEASUREMENTS_CODE_TYPE_OTHER:
         default:
-            out = inOtherCodeTypeName;
+            codeType = inOtherCodeTypeName;
             break;
     }
+    return codeType;
+}
+
+static void convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType& inCodeType,
+        const char* inOtherCodeTypeName, ::android::hardware::hidl_string& out)
+{
+    const char* codeType = convertGnssMeasurementsCodeType(inCodeType, inOtherCodeTypeName);
+    // the string of a reused element is only reallocated when it changes
+    if (nullptr != codeType && 0 != strcmp(out.c_str(), codeType)) {
+        out = codeType;
+    }
 }
 
-static void convertGnssMeasurementsAccumulatedDeltaRangeState(GnssMeasurementsAdrStateMask& in,
+static void convertGnssMeasurementsAccumulatedDeltaRangeState(
+        const GnssMeasurementsAdrStateMask& in,
         ::android::hardware::hidl_bitfield
                 <V1_1::IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState>& out)
 {
@@ -505,7 +586,7 @@ static void convertGnssMeasurementsAccumulatedDeltaRangeState(GnssMeasurementsAd
                 GnssAccumulatedDeltaRangeState::ADR_STATE_HALF_CYCLE_RESOLVED;
 }
 
-static void convertGnssMeasurementsState(GnssMeasurementsStateMask& in,
+static void convertGnssMeasurementsState(const GnssMeasurementsStateMask& in,
         ::android::hardware::hidl_bitfield
                 <V2_0::IGnssMeasurementCallback::GnssMeasurementState>& out)
 {
@@ -546,81 +627,176 @@ static void convertGnssMeasurementsState(GnssMeasurementsStateMask& in,
         out |= IGnssMeasurementCallback::GnssMeasurementState::STATE_2ND_CODE_LOCK;
 }
 
-static void convertGnssData_2_1(GnssMeasurementsNotification& in,
-        V2_1::IGnssMeasurementCallback::GnssData& out)
+// Each version extends the measurement of the version before it, so each
+// converter fills in the older measurement first and then its own fields.
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
+        V1_1::IGnssMeasurementCallback::GnssMeasurement& out)
 {
-    memset(&out, 0, sizeof(out));
-    out.measurements.resize(in.count);
-    for (size_t i = 0; i < in.count; i++) {
-        out.measurements[i].flags = 0;
-        convertGnssMeasurement(in.measurements[i], out.measurements[i].v2_0.v1_1.v1_0);
-        convertGnssConstellationType(in.measurements[i].svType,
-                out.measurements[i].v2_0.constellation);
-        convertGnssMeasurementsCodeType(in.measurements[i].codeType,
-                in.measurements[i].otherCodeTypeName,
-                out.measurements[i].v2_0.codeType);
-        convertGnssMeasurementsAccumulatedDeltaRangeState(in.measurements[i].adrStateMask,
-                out.measurements[i].v2_0.v1_1.accumulatedDeltaRangeState);
-        convertGnssMeasurementsState(in.measurements[i].stateMask,
-                out.measurements[i].v2_0.state);
-        out.measurements[i].basebandCN0DbHz = in.measurements[i].basebandCarrierToNoiseDbHz;
-
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SNR;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_FREQUENCY;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_CYCLES;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_PHASE;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::
-                        GnssMeasurementFlags::HAS_CARRIER_PHASE_UNCERTAINTY;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
-            out.measurements[i].flags |=
-                V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_AUTOMATIC_GAIN_CONTROL;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) {
-            out.measurements[i].fullInterSignalBiasNs = in.measurements[i].fullInterSignalBiasNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_FULL_ISB;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) {
-            out.measurements[i].fullInterSignalBiasUncertaintyNs =
-                    in.measurements[i].fullInterSignalBiasUncertaintyNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::
-                            GnssMeasurementFlags::HAS_FULL_ISB_UNCERTAINTY;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT) {
-            out.measurements[i].satelliteInterSignalBiasNs =
-                    in.measurements[i].satelliteInterSignalBiasNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SATELLITE_ISB;
-        }
-        if (in.measurements[i].flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT) {
-            out.measurements[i].satelliteInterSignalBiasUncertaintyNs =
-                    in.measurements[i].satelliteInterSignalBiasUncertaintyNs;
-            out.measurements[i].flags |=
-                    V2_1::IGnssMeasurementCallback::
-                            GnssMeasurementFlags::HAS_SATELLITE_ISB_UNCERTAINTY;
-        }
+    convertGnssMeasurement(in, out.v1_0);
+    convertGnssMeasurementsAccumulatedDeltaRangeState(in.adrStateMask,
+            out.accumulatedDeltaRangeState);
+}
+
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
+        V2_0::IGnssMeasurementCallback::GnssMeasurement& out)
+{
+    convertGnssMeasurement(in, out.v1_1);
+    convertGnssConstellationType(in.svType, out.constellation);
+    convertGnssMeasurementsCodeType(in.codeType, in.otherCodeTypeName, out.codeType);
+    convertGnssMeasurementsState(in.stateMask, out.state);
+}
+
+static void convertGnssMeasurement(const GnssMeasurementsData& in,
+        V2_1::IGnssMeasurementCallback::GnssMeasurement& out)
+{
+    convertGnssMeasurement(in, out.v2_0);
+    out.basebandCN0DbHz = in.basebandCarrierToNoiseDbHz;
+
+    // elements are reused, so what is only set on a flag is reset here
+    out.flags = convertGnssMeasurementFlags(in.flags);
+    out.fullInterSignalBiasNs = (in.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) ?
+            in.fullInterSignalBiasNs : 0;
+    out.fullInterSignalBiasUncertaintyNs =
+            (in.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) ?
+            in.fullInterSignalBiasUncertaintyNs : 0;
+    out.satelliteInterSignalBiasNs = (in.flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT) ?
+            in.satelliteInterSignalBiasNs : 0;
+    out.satelliteInterSignalBiasUncertaintyNs =
+            (in.flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT) ?
+            in.satelliteInterSignalBiasUncertaintyNs : 0;
+}
+
+static uint32_t convertGnssMeasurementFlags(const GnssMeasurementsDataFlagsMask& in)
+{
+    uint32_t out = 0;
+    if (in & GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT)
+        out |= V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SNR;
+    if (in & GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT)
+        out |= V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_FREQUENCY;
+    if (in & GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT)
+        out |= V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_CYCLES;
+    if (in & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT)
+        out |= V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_CARRIER_PHASE;
+    if (in & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT)
+        out |= V2_1::IGnssMeasurementCallback::
+                GnssMeasurementFlags::HAS_CARRIER_PHASE_UNCERTAINTY;
+    if (in & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT)
+        out |= V2_1::IGnssMeasurementCallback::
+                GnssMeasurementFlags::HAS_AUTOMATIC_GAIN_CONTROL;
+    if (in & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT)
+        out |= V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_FULL_ISB;
+    if (in & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT)
+        out |= V2_1::IGnssMeasurementCallback::
+                GnssMeasurementFlags::HAS_FULL_ISB_UNCERTAINTY;
+    if (in & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT)
+        out |= V2_1::IGnssMeasurementCallback::GnssMeasurementFlags::HAS_SATELLITE_ISB;
+    if (in & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT)
+        out |= V2_1::IGnssMeasurementCallback::
+                GnssMeasurementFlags::HAS_SATELLITE_ISB_UNCERTAINTY;
+    return out;
+}
+
+// The queue element has every field inline, so it is converted straight into
+// the shared memory of the queue. Only the measurements in use are written.
+static void convertGnssMeasurement(const GnssMeasurementsData& in, GnssFmqMeasurement& out)
+{
+    out.flags = convertGnssMeasurementFlags(in.flags);
+    convertGnssSvid(in, out.svid);
+    convertGnssConstellationType(in.svType, out.constellation);
+    out.timeOffsetNs = in.timeOffsetNs;
+    convertGnssMeasurementsState(in.stateMask, out.state);
+    out.receivedSvTimeInNs = in.receivedSvTimeNs;
+    out.receivedSvTimeUncertaintyInNs = in.receivedSvTimeUncertaintyNs;
+    out.cN0DbHz = in.carrierToNoiseDbHz;
+    out.basebandCN0DbHz = in.basebandCarrierToNoiseDbHz;
+    out.pseudorangeRateMps = in.pseudorangeRateMps;
+    out.pseudorangeRateUncertaintyMps = in.pseudorangeRateUncertaintyMps;
+    convertGnssMeasurementsAccumulatedDeltaRangeState(in.adrStateMask,
+            out.accumulatedDeltaRangeState);
+    out.accumulatedDeltaRangeM = in.adrMeters;
+    out.accumulatedDeltaRangeUncertaintyM = in.adrUncertaintyMeters;
+    out.carrierFrequencyHz = in.carrierFrequencyHz;
+    out.carrierCycles = in.carrierCycles;
+    out.carrierPhase = in.carrierPhase;
+    out.carrierPhaseUncertainty = in.carrierPhaseUncertainty;
+    if (GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_PRESENT == in.multipathIndicator) {
+        out.multipathIndicator =
+                V1_0::IGnssMeasurementCallback::GnssMultipathIndicator::INDICATOR_PRESENT;
+    } else if (GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_NOT_PRESENT == in.multipathIndicator) {
+        out.multipathIndicator =
+                V1_0::IGnssMeasurementCallback::GnssMultipathIndicator::INDICATIOR_NOT_PRESENT;
+    } else {
+        out.multipathIndicator =
+                V1_0::IGnssMeasurementCallback::GnssMultipathIndicator::INDICATOR_UNKNOWN;
     }
-    convertGnssClock_2_1(in.clock, out.clock);
+    out.snrDb = in.signalToNoiseRatioDb;
+    out.agcLevelDb = in.agcLevelDb;
+    const char* codeType = convertGnssMeasurementsCodeType(in.codeType, in.otherCodeTypeName);
+    strlcpy(reinterpret_cast<char*>(&out.codeType[0]),
+            nullptr != codeType ? codeType : "", sizeof(out.codeType));
+    out.fullInterSignalBiasNs = (in.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) ?
+            in.fullInterSignalBiasNs : 0;
+    out.fullInterSignalBiasUncertaintyNs =
+            (in.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) ?
+            in.fullInterSignalBiasUncertaintyNs : 0;
+    out.satelliteInterSignalBiasNs = (in.flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT) ?
+            in.satelliteInterSignalBiasNs : 0;
+    out.satelliteInterSignalBiasUncertaintyNs =
+            (in.flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT) ?
+            in.satelliteInterSignalBiasUncertaintyNs : 0;
+}
+
+static void convertGnssData(const GnssMeasurementsNotification& in, GnssFmqData& out)
+{
+    out.measurementCount = in.count;
+    if (out.measurementCount > GNSS_MEASUREMENTS_MAX) {
+        out.measurementCount = GNSS_MEASUREMENTS_MAX;
+    }
+    for (size_t i = 0; i < out.measurementCount; i++) {
+        convertGnssMeasurement(in.measurements[i], out.measurements[i]);
+    }
+    convertGnssClock(in.clock, out.clock);
+    convertGnssConstellationType(in.clock.referenceSignalTypeForIsb.svType,
+            out.referenceConstellation);
+    out.referenceCarrierFrequencyHz = in.clock.referenceSignalTypeForIsb.carrierFrequencyHz;
+    const char* codeType = convertGnssMeasurementsCodeType(
+            in.clock.referenceSignalTypeForIsb.codeType,
+            in.clock.referenceSignalTypeForIsb.otherCodeTypeName);
+    strlcpy(reinterpret_cast<char*>(&out.referenceCodeType[0]),
+            nullptr != codeType ? codeType : "", sizeof(out.referenceCodeType));
+    out.elapsedRealtime = {};
     convertElapsedRealtimeNanos(in, out.elapsedRealtime);
 }
 
-static void convertElapsedRealtimeNanos(GnssMeasurementsNotification& in,
+// 1.1 data carries no elapsed realtime
+static inline void convertGnssDataElapsedRealtime(const GnssMeasurementsNotification&,
+        V1_1::IGnssMeasurementCallback::GnssData&)
+{
+}
+
+template <typename GnssData>
+static inline void convertGnssDataElapsedRealtime(const GnssMeasurementsNotification& in,
+        GnssData& out)
+{
+    out.elapsedRealtime = {};
+    convertElapsedRealtimeNanos(in, out.elapsedRealtime);
+}
+
+// 1.1 and later hand measurements over in a hidl_vec; the per version overloads
+// of convertGnssMeasurement and convertGnssClock pick what each one adds.
+template <typename GnssMeasurement, typename GnssData>
+static void convertGnssData(const GnssMeasurementsNotification& in,
+        std::vector<GnssMeasurement>& measurements, GnssData& out)
+{
+    useMeasurementStorage(measurements, in.count, out.measurements);
+    for (size_t i = 0; i < in.count; i++) {
+        convertGnssMeasurement(in.measurements[i], out.measurements[i]);
+    }
+    convertGnssClock(in.clock, out.clock);
+    convertGnssDataElapsedRealtime(in, out);
+}
+
+static void convertElapsedRealtimeNanos(const GnssMeasurementsNotification& in,
         ::android::hardware::gnss::V2_0::ElapsedRealtime& elapsedRealtime)
 {
     if (in.clock.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_ELAPSED_REAL_TIME_BIT) {
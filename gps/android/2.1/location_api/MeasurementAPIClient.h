@@ -30,8 +30,13 @@
 #ifndef MEASUREMENT_API_CLINET_H
 #define MEASUREMENT_API_CLINET_H
 
+#include <memory>
 #include <mutex>
+#include <vector>
 #include <android/hardware/gnss/2.1/IGnssMeasurement.h>
+#include <vendor/motorola/hardware/gnss/1.0/types.h>
+#include <fmq/EventFlag.h>
+#include <fmq/MessageQueue.h>
 //#include <android/hardware/gnss/1.1/IGnssMeasurementCallback.h>
 #include <android/hardware/gnss/2.1/IGnssMeasurementCallback.h>
 #include <LocationAPIClientBase.h>
@@ -53,6 +58,11 @@ public:
     MeasurementAPIClient(const MeasurementAPIClient&) = delete;
     MeasurementAPIClient& operator=(const MeasurementAPIClient&) = delete;
 
+    typedef ::android::hardware::MessageQueue<
+            ::vendor::motorola::hardware::gnss::V1_0::GnssFmqData,
+            ::android::hardware::kUnsynchronizedWrite> GnssFmqQueue;
+    typedef GnssFmqQueue::Descriptor GnssFmqDescriptor;
+
     // for GpsMeasurementInterface
     Return<V1_0::IGnssMeasurement::GnssMeasurementStatus> measurementSetCallback(
             const sp<V1_0::IGnssMeasurementCallback>& callback);
@@ -68,6 +78,12 @@ public:
             const sp<V2_1::IGnssMeasurementCallback>& callback,
             GnssPowerMode powerMode = GNSS_POWER_MODE_INVALID,
             uint32_t timeBetweenMeasurement = GPS_DEFAULT_FIX_INTERVAL_MS);
+    // measurements go to a queue instead of a callback, queue is set to its
+    // descriptor on success
+    Return<V1_0::IGnssMeasurement::GnssMeasurementStatus> measurementSetFmq(
+            GnssFmqDescriptor& queue,
+            GnssPowerMode powerMode = GNSS_POWER_MODE_INVALID,
+            uint32_t timeBetweenMeasurement = GPS_DEFAULT_FIX_INTERVAL_MS);
     void measurementClose();
     Return<IGnssMeasurement::GnssMeasurementStatus> startTracking(
             GnssPowerMode powerMode = GNSS_POWER_MODE_INVALID,
@@ -75,16 +91,33 @@ public:
 
     // callbacks we are interested in
     void onGnssMeasurementsCb(GnssMeasurementsNotification gnssMeasurementsNotification) final;
+    void onLocationApiDestroyCompleteCb() final;
 
 private:
     virtual ~MeasurementAPIClient();
+    void reportGnssMeasurements(const GnssMeasurementsNotification& gnssMeasurementsNotification);
+
+    struct GnssFmq {
+        GnssFmq();
+        ~GnssFmq();
+        GnssFmqQueue queue;
+        ::android::hardware::EventFlag* eventFlag;
+    };
 
     std::mutex mMutex;
     sp<V1_0::IGnssMeasurementCallback> mGnssMeasurementCbIface;
     sp<V1_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_1_1;
     sp<V2_0::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_0;
     sp<V2_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_1;
+    // held by the callback thread while it writes an epoch, so a queue
+    // replaced or closed meanwhile outlives the write
+    std::shared_ptr<GnssFmq> mFmq;
     bool mTracking;
+    // measurements handed to the callback, reused from one epoch to the
+    // next; only touched on the callback thread
+    std::vector<V1_1::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_1_1;
+    std::vector<V2_0::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_2_0;
+    std::vector<V2_1::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_2_1;
     void clearInterfaces();
 };
 
@@ -33,6 +33,9 @@ extern "C" {
 #define DEFAULT_HW_BINDER_MEM_SIZE 65536
 #endif
 
+#define DEFAULT_HW_BINDER_THREAD_POOL_SIZE 1
+#define MAX_HW_BINDER_THREAD_POOL_SIZE 8
+
 using android::hardware::gnss::V2_1::IGnss;
 
 using android::hardware::configureRpcThreadpool;
@@ -55,7 +58,19 @@ int main() {
 #ifdef ARCH_ARM_32
     android::hardware::ProcessState::initWithMmapSize((size_t)(DEFAULT_HW_BINDER_MEM_SIZE));
 #endif
-    configureRpcThreadpool(1, true);
+    uint32_t binderThreadPoolSize = DEFAULT_HW_BINDER_THREAD_POOL_SIZE;
+    const loc_param_s_type serviceConfTable[] =
+    {
+        { "HIDL_BINDER_THREAD_POOL_SIZE", &binderThreadPoolSize, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, serviceConfTable);
+    if (binderThreadPoolSize < 1) {
+        binderThreadPoolSize = 1;
+    } else if (binderThreadPoolSize > MAX_HW_BINDER_THREAD_POOL_SIZE) {
+        binderThreadPoolSize = MAX_HW_BINDER_THREAD_POOL_SIZE;
+    }
+    ALOGI("binder thread pool size %u", binderThreadPoolSize);
+    configureRpcThreadpool(binderThreadPoolSize, true);
     status_t status;
 
     status = registerPassthroughServiceImplementation<IGnss>();
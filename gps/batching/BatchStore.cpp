@@ -0,0 +1,331 @@
+/* Copyright (c) 2017-2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_BatchStore"
+
+#include <loc_pla.h>
+#include <log_util.h>
+#include <BatchStore.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+// the largest record: 2 masks, the time and 9 fields
+#define BATCH_STORE_RECORD_MAX (2 * 5 + 10 * 10)
+
+// the fields coded when valid, in order of the record
+static const struct {
+    LocationFlagsMask bit;
+    double scale;
+} sStoredFields[] = {
+    {LOCATION_HAS_LAT_LONG_BIT,          1e7},  // latitude
+    {LOCATION_HAS_LAT_LONG_BIT,          1e7},  // longitude
+    {LOCATION_HAS_ALTITUDE_BIT,          10},
+    {LOCATION_HAS_SPEED_BIT,             100},
+    {LOCATION_HAS_BEARING_BIT,           10},
+    {LOCATION_HAS_ACCURACY_BIT,          10},
+    {LOCATION_HAS_VERTICAL_ACCURACY_BIT, 10},
+    {LOCATION_HAS_SPEED_ACCURACY_BIT,    100},
+    {LOCATION_HAS_BEARING_ACCURACY_BIT,  10},
+};
+#define STORED_FIELDS_COUNT (sizeof(sStoredFields) / sizeof(sStoredFields[0]))
+
+static inline size_t putVarint(uint64_t value, uint8_t* out)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static inline size_t getVarint(const uint8_t* in, size_t len, uint64_t& value)
+{
+    value = 0;
+    for (size_t n = 0; n < len && n < 10; ++n) {
+        value |= (uint64_t)(in[n] & 0x7f) << (7 * n);
+        if (0 == (in[n] & 0x80)) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+static inline uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+BatchStore::BatchStore() :
+    mFd(-1),
+    mMap(nullptr),
+    mMapSize(0),
+    mLast{}
+{
+}
+
+BatchStore::~BatchStore()
+{
+    close();
+}
+
+bool
+BatchStore::open(const char* path, size_t maxSize)
+{
+    close();
+    if (maxSize <= sizeof(Header) + BATCH_STORE_RECORD_MAX) {
+        LOC_LOGE("%s]: size %zu too small", __func__, maxSize);
+        return false;
+    }
+
+    mFd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (mFd < 0) {
+        LOC_LOGE("%s]: failed to open %s, errno %d", __func__, path, errno);
+        return false;
+    }
+    if (0 != ftruncate(mFd, maxSize)) {
+        LOC_LOGE("%s]: failed to size %s, errno %d", __func__, path, errno);
+        close();
+        return false;
+    }
+    void* map = mmap(nullptr, maxSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (MAP_FAILED == map) {
+        LOC_LOGE("%s]: failed to map %s, errno %d", __func__, path, errno);
+        close();
+        return false;
+    }
+    mMap = (uint8_t*)map;
+    mMapSize = maxSize;
+    header()->version = BATCH_STORE_VERSION;
+    header()->used = 0;
+    header()->count = 0;
+    memset(&mLast, 0, sizeof(mLast));
+    LOC_LOGD("%s]: %s, %zu bytes", __func__, path, maxSize);
+    return true;
+}
+
+void
+BatchStore::close()
+{
+    if (nullptr != mMap) {
+        munmap(mMap, mMapSize);
+        mMap = nullptr;
+        mMapSize = 0;
+    }
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+void
+BatchStore::toStored(const Location& location, StoredFix& fix)
+{
+    memset(&fix, 0, sizeof(fix));
+    fix.flags = location.flags;
+    fix.techMask = location.techMask;
+    fix.timestamp = (int64_t)location.timestamp;
+    const double values[STORED_FIELDS_COUNT] = {
+        location.latitude, location.longitude, location.altitude,
+        location.speed, location.bearing, location.accuracy,
+        location.verticalAccuracy, location.speedAccuracy, location.bearingAccuracy
+    };
+    for (size_t i = 0; i < STORED_FIELDS_COUNT; ++i) {
+        // a field not valid is stored as 0, so that the next difference does not need it
+        if (location.flags & sStoredFields[i].bit) {
+            fix.fields[i] = llround(values[i] * sStoredFields[i].scale);
+        }
+    }
+}
+
+void
+BatchStore::toLocation(const StoredFix& fix, Location& location)
+{
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(Location);
+    location.flags = (LocationFlagsMask)fix.flags;
+    location.techMask = (LocationTechnologyMask)fix.techMask;
+    location.timestamp = (uint64_t)fix.timestamp;
+    double values[STORED_FIELDS_COUNT];
+    for (size_t i = 0; i < STORED_FIELDS_COUNT; ++i) {
+        values[i] = fix.fields[i] / sStoredFields[i].scale;
+    }
+    location.latitude = values[0];
+    location.longitude = values[1];
+    location.altitude = values[2];
+    location.speed = (float)values[3];
+    location.bearing = (float)values[4];
+    location.accuracy = (float)values[5];
+    location.verticalAccuracy = (float)values[6];
+    location.speedAccuracy = (float)values[7];
+    location.bearingAccuracy = (float)values[8];
+}
+
+size_t
+BatchStore::encode(const StoredFix& fix, const StoredFix& last, uint8_t* out)
+{
+    size_t n = 0;
+    n += putVarint(fix.flags ^ last.flags, out + n);
+    n += putVarint(fix.techMask ^ last.techMask, out + n);
+    n += putVarint(zigzag(fix.timestamp - last.timestamp), out + n);
+    // the fields valid in either, the decoder knowing both masks
+    uint32_t flags = fix.flags | last.flags;
+    for (size_t i = 0; i < STORED_FIELDS_COUNT; ++i) {
+        if (flags & sStoredFields[i].bit) {
+            n += putVarint(zigzag(fix.fields[i] - last.fields[i]), out + n);
+        }
+    }
+    return n;
+}
+
+// decodes the record after fix into fix, returns 0 if it is not complete
+size_t
+BatchStore::decode(const uint8_t* in, size_t len, StoredFix& fix)
+{
+    uint64_t value = 0;
+    size_t n = 0;
+    size_t m = 0;
+    uint32_t lastFlags = fix.flags;
+
+#define GET_VARINT() \
+    if (0 == (m = getVarint(in + n, len - n, value))) { return 0; } else { n += m; }
+
+    GET_VARINT();
+    fix.flags ^= (uint32_t)value;
+    GET_VARINT();
+    fix.techMask ^= (uint32_t)value;
+    GET_VARINT();
+    fix.timestamp += unzigzag(value);
+    uint32_t flags = fix.flags | lastFlags;
+    for (size_t i = 0; i < STORED_FIELDS_COUNT; ++i) {
+        if (flags & sStoredFields[i].bit) {
+            GET_VARINT();
+            fix.fields[i] += unzigzag(value);
+        }
+    }
+#undef GET_VARINT
+    return n;
+}
+
+void
+BatchStore::dropOldestHalf()
+{
+    Header* hdr = header();
+    StoredFix fix = {};
+    size_t offset = 0;
+    uint32_t dropped = 0;
+    while (offset < hdr->used / 2) {
+        size_t n = decode(records() + offset, hdr->used - offset, fix);
+        if (0 == n) {
+            break;
+        }
+        offset += n;
+        dropped++;
+    }
+
+    // the last one dropped is kept instead, coded on its own, as the base of the next
+    uint8_t first[BATCH_STORE_RECORD_MAX];
+    StoredFix none = {};
+    size_t firstSize = encode(fix, none, first);
+    if (0 == dropped || firstSize > offset) {
+        hdr->used = 0;
+        hdr->count = 0;
+        memset(&mLast, 0, sizeof(mLast));
+        LOC_LOGW("%s]: store emptied", __func__);
+        return;
+    }
+    memmove(records() + firstSize, records() + offset, hdr->used - offset);
+    memcpy(records(), first, firstSize);
+    hdr->used = hdr->used - offset + firstSize;
+    hdr->count -= dropped - 1;
+    LOC_LOGW("%s]: dropped the %u oldest locations", __func__, dropped - 1);
+}
+
+void
+BatchStore::append(const Location* locations, size_t count)
+{
+    if (!isOpen() || nullptr == locations) {
+        return;
+    }
+    Header* hdr = header();
+    for (size_t i = 0; i < count; ++i) {
+        if (hdr->used + BATCH_STORE_RECORD_MAX > capacity()) {
+            dropOldestHalf();
+        }
+        StoredFix fix;
+        toStored(locations[i], fix);
+        hdr->used += encode(fix, mLast, records() + hdr->used);
+        hdr->count++;
+        mLast = fix;
+    }
+    LOC_LOGD("%s]: %u locations in %u bytes", __func__, hdr->count, hdr->used);
+}
+
+void
+BatchStore::drain(size_t chunkSize, const std::function<void(Location*, size_t)>& cb)
+{
+    if (!isOpen() || 0 == header()->count) {
+        return;
+    }
+    Header* hdr = header();
+    std::vector<Location> chunk(std::max(chunkSize, (size_t)1));
+    size_t inChunk = 0;
+    StoredFix fix = {};
+    size_t offset = 0;
+    while (offset < hdr->used) {
+        size_t n = decode(records() + offset, hdr->used - offset, fix);
+        if (0 == n) {
+            LOC_LOGE("%s]: bad record at %zu", __func__, offset);
+            break;
+        }
+        offset += n;
+        toLocation(fix, chunk[inChunk++]);
+        if (inChunk == chunk.size()) {
+            cb(chunk.data(), inChunk);
+            inChunk = 0;
+        }
+    }
+    if (inChunk > 0) {
+        cb(chunk.data(), inChunk);
+    }
+    hdr->used = 0;
+    hdr->count = 0;
+    memset(&mLast, 0, sizeof(mLast));
+}
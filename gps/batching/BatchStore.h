@@ -0,0 +1,94 @@
+/* Copyright (c) 2017-2019, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef BATCH_STORE_H
+#define BATCH_STORE_H
+
+#include <LocationDataTypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#define BATCH_STORE_FILE "/data/vendor/location/batch_store.bin"
+#define BATCH_STORE_VERSION 1
+
+/* Batched locations kept on the AP, once the modem batch is full, until a client reads
+   them. They are kept in a file mapped in memory, each location as the varint coded
+   difference to the one before, of its fields rounded to:
+   latitude and longitude 1e-7 degree, altitude, accuracies 0.1 meter, speed 0.01 m/s,
+   bearing 0.1 degree, time 1 millisecond. A fix takes 10 to 20 bytes.
+   Once full, the oldest half is dropped. Not thread safe. */
+class BatchStore {
+    // the fields as stored, the differences being taken on these
+    typedef struct {
+        uint32_t flags;
+        uint32_t techMask;
+        int64_t timestamp;
+        // latitude, longitude, altitude, speed, bearing, accuracy, vertical
+        // accuracy, speed accuracy and bearing accuracy, rounded as above
+        int64_t fields[9];
+    } StoredFix;
+
+    typedef struct {
+        uint32_t version;
+        uint32_t used;   // bytes of records after the header
+        uint32_t count;  // records
+    } Header;
+
+    int mFd;
+    uint8_t* mMap;
+    size_t mMapSize;
+    StoredFix mLast;
+
+    inline uint8_t* records() const { return mMap + sizeof(Header); }
+    inline Header* header() const { return (Header*)mMap; }
+    inline size_t capacity() const { return mMapSize - sizeof(Header); }
+
+    static void toStored(const Location& location, StoredFix& fix);
+    static void toLocation(const StoredFix& fix, Location& location);
+    static size_t encode(const StoredFix& fix, const StoredFix& last, uint8_t* out);
+    static size_t decode(const uint8_t* in, size_t len, StoredFix& fix);
+    void dropOldestHalf();
+
+public:
+    BatchStore();
+    ~BatchStore();
+
+    // maps a new, empty store of up to maxSize bytes in path
+    bool open(const char* path, size_t maxSize);
+    void close();
+    inline bool isOpen() const { return nullptr != mMap; }
+    inline size_t count() const { return isOpen() ? header()->count : 0; }
+    inline size_t bytesUsed() const { return isOpen() ? header()->used : 0; }
+
+    void append(const Location* locations, size_t count);
+    // calls cb with up to chunkSize locations at a time, oldest first, and empties the store
+    void drain(size_t chunkSize, const std::function<void(Location*, size_t)>& cb);
+};
+
+#endif /* BATCH_STORE_H */
@@ -33,25 +33,43 @@
 #include <log_util.h>
 #include <LocContext.h>
 #include <BatchingAdapter.h>
+#include <LocConfWatcher.h>
+#include <math.h>
+#include <algorithm>
+
+#define TRIP_EARTH_RADIUS_M 6371009.0
 
 using namespace loc_core;
 
 BatchingAdapter::BatchingAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   false, nullptr, true),
+                   false, nullptr, true, "Loc_batching"),
     mOngoingTripDistance(0),
     mOngoingTripTBFInterval(0),
     mTripWithOngoingTBFDropped(false),
     mTripWithOngoingTripDistanceDropped(false),
+    mTripPathDistance(0),
+    mRoutineEngineSessionId(0),
+    mRoutineEngineOptions(),
     mBatchingTimeout(0),
     mBatchingAccuracy(1),
     mBatchSize(0),
-    mTripBatchSize(0)
+    mTripBatchSize(0),
+    mBatchStoreSize(0),
+    mBatchedLocationsRequests(0)
 {
     LOC_LOGD("%s]: Constructor", __func__);
+    resetTripPath();
     readConfigCommand();
     setConfigCommand();
+    LocConfWatcher::getInstance().watch(LOC_PATH_FLP_CONF,
+            [this](const char*, const std::unordered_set<std::string>& changedKeys) {
+                confChangedCommand(changedKeys);
+            });
+
+    // no position, SV, NMEA or measurement reports are consumed here
+    setReportMask(0);
 
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
@@ -73,12 +91,14 @@ BatchingAdapter::readConfigCommand()
             uint32_t batchingAccuracy = 0;
             uint32_t batchSize = 0;
             uint32_t tripBatchSize = 0;
+            uint32_t batchStoreSizeKb = 0;
             static const loc_param_s_type flp_conf_param_table[] =
             {
                 {"BATCH_SIZE", &batchSize, NULL, 'n'},
                 {"OUTDOOR_TRIP_BATCH_SIZE", &tripBatchSize, NULL, 'n'},
                 {"BATCH_SESSION_TIMEOUT", &batchingTimeout, NULL, 'n'},
                 {"ACCURACY", &batchingAccuracy, NULL, 'n'},
+                {"AP_BATCH_STORE_SIZE_KB", &batchStoreSizeKb, NULL, 'n'},
             };
             UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
 
@@ -89,6 +109,7 @@ BatchingAdapter::readConfigCommand()
              mAdapter.setTripBatchSize(tripBatchSize);
              mAdapter.setBatchingTimeout(batchingTimeout);
              mAdapter.setBatchingAccuracy(batchingAccuracy);
+             mAdapter.setBatchStoreSize(batchStoreSizeKb * 1024);
         }
     };
 
@@ -118,6 +139,70 @@ BatchingAdapter::setConfigCommand()
     sendMsg(new MsgSetConfig(*this, *mLocApi));
 }
 
+void
+BatchingAdapter::confChangedCommand(const std::unordered_set<std::string>& changedKeys)
+{
+    LOC_LOGD("%s]: ", __func__);
+
+    struct MsgConfChanged : public LocMsg {
+        BatchingAdapter& mAdapter;
+        LocApiBase& mApi;
+        const std::unordered_set<std::string> mChangedKeys;
+        inline MsgConfChanged(BatchingAdapter& adapter,
+                              LocApiBase& api,
+                              const std::unordered_set<std::string>& changedKeys) :
+            LocMsg(),
+            mAdapter(adapter),
+            mApi(api),
+            mChangedKeys(changedKeys) {}
+        inline virtual void proc() const {
+            uint32_t batchingTimeout = 0;
+            uint32_t batchingAccuracy = 0;
+            uint32_t batchSize = 0;
+            uint32_t tripBatchSize = 0;
+            uint8_t batchingTimeoutSet = 0;
+            uint8_t batchingAccuracySet = 0;
+            uint8_t batchSizeSet = 0;
+            uint8_t tripBatchSizeSet = 0;
+            const loc_param_s_type flp_conf_param_table[] =
+            {
+                {"BATCH_SIZE", &batchSize, &batchSizeSet, 'n'},
+                {"OUTDOOR_TRIP_BATCH_SIZE", &tripBatchSize, &tripBatchSizeSet, 'n'},
+                {"BATCH_SESSION_TIMEOUT", &batchingTimeout, &batchingTimeoutSet, 'n'},
+                {"ACCURACY", &batchingAccuracy, &batchingAccuracySet, 'n'},
+            };
+            UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
+
+            // only the changed keys that are still in flp.conf are applied;
+            // the batch sizes are the only ones the modem has to be told of,
+            // the others are used as the next sessions start
+            auto changed = [this](const char* key, uint8_t isSet) {
+                return isSet && mChangedKeys.find(key) != mChangedKeys.end();
+            };
+            if (changed("BATCH_SIZE", batchSizeSet)) {
+                LOC_LOGD("%s]: batchSize %u", __func__, batchSize);
+                mAdapter.setBatchSize(batchSize);
+                mApi.setBatchSize(mAdapter.getBatchSize());
+            }
+            if (changed("OUTDOOR_TRIP_BATCH_SIZE", tripBatchSizeSet)) {
+                LOC_LOGD("%s]: tripBatchSize %u", __func__, tripBatchSize);
+                mAdapter.setTripBatchSize(tripBatchSize);
+                mApi.setTripBatchSize(mAdapter.getTripBatchSize());
+            }
+            if (changed("BATCH_SESSION_TIMEOUT", batchingTimeoutSet)) {
+                LOC_LOGD("%s]: batchingTimeout %u", __func__, batchingTimeout);
+                mAdapter.setBatchingTimeout(batchingTimeout);
+            }
+            if (changed("ACCURACY", batchingAccuracySet)) {
+                LOC_LOGD("%s]: batchingAccuracy %u", __func__, batchingAccuracy);
+                mAdapter.setBatchingAccuracy(batchingAccuracy);
+            }
+        }
+    };
+
+    sendMsg(new MsgConfChanged(*this, *mLocApi, changedKeys));
+}
+
 void
 BatchingAdapter::stopClientSessions(LocationAPI* client)
 {
@@ -143,6 +228,7 @@ BatchingAdapter::stopClientSessions(LocationAPI* client)
             stopTripBatchingMultiplex(keyBatchingMode.client, keyBatchingMode.id);
         }
     }
+    mRoutineClientLastFix.erase(client);
 }
 
 void
@@ -178,7 +264,9 @@ BatchingAdapter::handleEngineUpEvent()
             mAdapter.broadcastCapabilities(mAdapter.getCapabilities());
             mApi.setBatchSize(mAdapter.getBatchSize());
             mApi.setTripBatchSize(mAdapter.getTripBatchSize());
+            mAdapter.beginReplay();
             mAdapter.restartSessions();
+            mAdapter.endReplay();
             for (auto msg: mAdapter.mPendingMsgs) {
                 mAdapter.sendMsg(msg);
             }
@@ -198,14 +286,12 @@ BatchingAdapter::restartSessions()
         updateEvtMask(LOC_API_ADAPTER_BIT_BATCH_FULL,
                       LOC_REGISTRATION_MASK_ENABLED);
     }
-    for (auto it = mBatchingSessions.begin();
-              it != mBatchingSessions.end(); ++it) {
-        if (it->second.batchingMode != BATCHING_MODE_TRIP) {
-            mLocApi->startBatching(it->first.id, it->second,
-                                    getBatchingAccuracy(), getBatchingTimeout(),
-                                    new LocApiResponse(*getContext(),
-                                    [] (LocationError /*err*/) {}));
-        }
+    // the modem lost the shared routine batch, it is started again as is
+    mRoutineEngineOptions = getMultiplexedRoutineOptions();
+    if (0 != mRoutineEngineOptions.size) {
+        mLocApi->startBatching(mRoutineEngineSessionId, mRoutineEngineOptions,
+                                getBatchingAccuracy(), getBatchingTimeout(),
+                                newReplayResponse());
     }
 
     if (mTripSessions.size() > 0) {
@@ -235,8 +321,9 @@ BatchingAdapter::restartSessions()
 
         }
 
+        resetTripPath();
         mLocApi->startOutdoorTripBatching(mOngoingTripDistance, mOngoingTripTBFInterval,
-                getBatchingTimeout(), new LocApiResponse(*getContext(), [this] (LocationError err) {
+                getBatchingTimeout(), newReplayResponse([this] (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
                 mOngoingTripDistance = 0;
                 mOngoingTripTBFInterval = 0;
@@ -302,7 +389,9 @@ BatchingAdapter::autoReportBatchingSessionsCount()
 {
     uint32_t count = 0;
     for (auto batchingSession: mBatchingSessions) {
-        if (batchingSession.second.batchingMode != BATCHING_MODE_NO_AUTO_REPORT) {
+        // with the AP store, a full batch is kept there for the sessions without auto report
+        if (batchingSession.second.batchingMode != BATCHING_MODE_NO_AUTO_REPORT ||
+                mBatchStore.isOpen()) {
             count++;
         }
     }
@@ -373,34 +462,108 @@ void
 BatchingAdapter::startBatching(LocationAPI* client, uint32_t sessionId,
         const BatchingOptions& batchingOptions)
 {
-    if (batchingOptions.batchingMode != BATCHING_MODE_NO_AUTO_REPORT &&
-        0 == autoReportBatchingSessionsCount()) {
+    uint32_t autoReportCount = autoReportBatchingSessionsCount();
+
+    // Assume start will be OK, remove session if not
+    saveBatchingSession(client, sessionId, batchingOptions);
+    if (0 == autoReportCount && 0 != autoReportBatchingSessionsCount()) {
         // if there is currenty no batching sessions interested in batch full event, then this
         // new session will need to register for batch full event
         updateEvtMask(LOC_API_ADAPTER_BIT_BATCH_FULL,
                       LOC_REGISTRATION_MASK_ENABLED);
     }
 
-    // Assume start will be OK, remove session if not
-    saveBatchingSession(client, sessionId, batchingOptions);
-    mLocApi->startBatching(sessionId, batchingOptions, getBatchingAccuracy(), getBatchingTimeout(),
-            new LocApiResponse(*getContext(),
-            [this, client, sessionId, batchingOptions] (LocationError err) {
+    updateRoutineEngineSession([this, client, sessionId] (LocationError err) {
         if (LOCATION_ERROR_SUCCESS != err) {
             eraseBatchingSession(client, sessionId);
+            // back to the options of the sessions left
+            updateRoutineEngineSession();
+            if (0 == autoReportBatchingSessionsCount()) {
+                // if we fail to start batching and we have already registered batch full
+                // event we need to undo that since no sessions are now interested in it
+                updateEvtMask(LOC_API_ADAPTER_BIT_BATCH_FULL,
+                              LOC_REGISTRATION_MASK_DISABLED);
+            }
         }
+        reportResponse(client, err, sessionId);
+    });
+}
 
-        if (LOCATION_ERROR_SUCCESS != err &&
-            batchingOptions.batchingMode != BATCHING_MODE_NO_AUTO_REPORT &&
-            0 == autoReportBatchingSessionsCount()) {
-            // if we fail to start batching and we have already registered batch full event
-            // we need to undo that since no sessions are now interested in batch full event
-            updateEvtMask(LOC_API_ADAPTER_BIT_BATCH_FULL,
-                          LOC_REGISTRATION_MASK_DISABLED);
+LocationOptions
+BatchingAdapter::getMultiplexedRoutineOptions() const
+{
+    LocationOptions multiplexed;
+    for (auto it = mBatchingSessions.begin(); it != mBatchingSessions.end(); ++it) {
+        const BatchingOptions& options = it->second;
+        if (BATCHING_MODE_TRIP == options.batchingMode) {
+            continue;
         }
+        if (0 == multiplexed.size) {
+            multiplexed.size = sizeof(LocationOptions);
+            multiplexed.minInterval = options.minInterval;
+            multiplexed.minDistance = options.minDistance;
+            multiplexed.mode = options.mode;
+            multiplexed.locReqEngTypeMask = options.locReqEngTypeMask;
+            continue;
+        }
+        multiplexed.minInterval = std::min(multiplexed.minInterval, options.minInterval);
+        multiplexed.minDistance = std::min(multiplexed.minDistance, options.minDistance);
+    }
+    return multiplexed;
+}
 
-        reportResponse(client, err, sessionId);
-    }));
+void
+BatchingAdapter::updateRoutineEngineSession(std::function<void(LocationError)> onDone)
+{
+    LocationOptions options = getMultiplexedRoutineOptions();
+    if (options.size == mRoutineEngineOptions.size &&
+            options.minInterval == mRoutineEngineOptions.minInterval &&
+            options.minDistance == mRoutineEngineOptions.minDistance) {
+        // the fixes of each client are decimated on the AP, the batch runs on as is
+        if (onDone) {
+            onDone(LOCATION_ERROR_SUCCESS);
+        }
+        return;
+    }
+    LOC_LOGD("%s]: minInterval %u -> %u minDistance %u -> %u", __func__,
+             mRoutineEngineOptions.minInterval, options.minInterval,
+             mRoutineEngineOptions.minDistance, options.minDistance);
+    if (0 == mRoutineEngineSessionId) {
+        mRoutineEngineSessionId = generateSessionId();
+    }
+    bool running = (0 != mRoutineEngineOptions.size);
+    mRoutineEngineOptions = options;
+
+    // drops the options if the modem did not take them, so the next
+    // update starts the batch again
+    auto onStarted = [this, options, onDone] (LocationError err) {
+        if (LOCATION_ERROR_SUCCESS != err &&
+                options.size == mRoutineEngineOptions.size &&
+                options.minInterval == mRoutineEngineOptions.minInterval &&
+                options.minDistance == mRoutineEngineOptions.minDistance) {
+            mRoutineEngineOptions = LocationOptions();
+        }
+        if (onDone) {
+            onDone(err);
+        }
+    };
+    if (!running) {
+        mLocApi->startBatching(mRoutineEngineSessionId, options,
+                getBatchingAccuracy(), getBatchingTimeout(),
+                new LocApiResponse(getMsgTask(), onStarted));
+    } else {
+        mLocApi->stopBatching(mRoutineEngineSessionId,
+                new LocApiResponse(getMsgTask(), [this, options, onStarted]
+                (LocationError err) {
+            if (0 == options.size || LOCATION_ERROR_SUCCESS != err) {
+                onStarted(err);
+            } else {
+                mLocApi->startBatching(mRoutineEngineSessionId, options,
+                        getBatchingAccuracy(), getBatchingTimeout(),
+                        new LocApiResponse(getMsgTask(), onStarted));
+            }
+        }));
+    }
 }
 
 void
@@ -503,14 +666,26 @@ BatchingAdapter::stopBatching(LocationAPI* client, uint32_t sessionId, bool rest
     auto it = mBatchingSessions.find(key);
     if (it != mBatchingSessions.end()) {
         auto flpOptions = it->second;
+        uint32_t autoReportCount = autoReportBatchingSessionsCount();
         // Assume stop will be OK, restore session if not
         eraseBatchingSession(client, sessionId);
-        mLocApi->stopBatching(sessionId,
-                new LocApiResponse(*getContext(),
+        if (restartNeeded && (batchOptions.batchingMode == BATCHING_MODE_ROUTINE ||
+                batchOptions.batchingMode == BATCHING_MODE_NO_AUTO_REPORT)) {
+            // an update of the options, the shared batch is only restarted if
+            // the smallest options change
+            startBatching(client, sessionId, batchOptions);
+            if (0 != autoReportCount && 0 == autoReportBatchingSessionsCount()) {
+                updateEvtMask(LOC_API_ADAPTER_BIT_BATCH_FULL,
+                              LOC_REGISTRATION_MASK_DISABLED);
+            }
+            return;
+        }
+        updateRoutineEngineSession(
                 [this, client, sessionId, flpOptions, restartNeeded, batchOptions]
                 (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
-                saveBatchingSession(client, sessionId, batchOptions);
+                saveBatchingSession(client, sessionId, flpOptions);
+                updateRoutineEngineSession();
             } else {
                 // if stopBatching is success, unregister for batch full event if this was the last
                 // batching session that is interested in batch full event
@@ -520,17 +695,12 @@ BatchingAdapter::stopBatching(LocationAPI* client, uint32_t sessionId, bool rest
                                   LOC_REGISTRATION_MASK_DISABLED);
                 }
 
-                if (restartNeeded) {
-                    if (batchOptions.batchingMode == BATCHING_MODE_ROUTINE ||
-                            batchOptions.batchingMode == BATCHING_MODE_NO_AUTO_REPORT) {
-                        startBatching(client, sessionId, batchOptions);
-                    } else if (batchOptions.batchingMode == BATCHING_MODE_TRIP) {
-                        startTripBatchingMultiplex(client, sessionId, batchOptions);
-                    }
+                if (restartNeeded && batchOptions.batchingMode == BATCHING_MODE_TRIP) {
+                    startTripBatchingMultiplex(client, sessionId, batchOptions);
                 }
             }
             reportResponse(client, err, sessionId);
-        }));
+        });
     }
 }
 
@@ -570,17 +740,28 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (mAdapter.isTripSession(mSessionId)) {
                     mApi.getBatchedTripLocations(mCount, 0,
-                            new LocApiResponse(*mAdapter.getContext(),
+                            new LocApiResponse(mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
                         mAdapter.reportResponse(mClient, err, mSessionId);
                     }));
                 } else {
-                    mApi.getBatchedLocations(mCount, new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mSessionId = mSessionId,
-                            mClient = mClient] (LocationError err) {
-                        mAdapter.reportResponse(mClient, err, mSessionId);
-                    }));
+                    // the modem batch is shared, a read already in flight is
+                    // reported to every client and answers this request too
+                    mAdapter.mBatchedLocationsWaiters.emplace_back(mClient, mSessionId);
+                    if (0 == mAdapter.mBatchedLocationsRequests) {
+                        mAdapter.mBatchedLocationsRequests++;
+                        mApi.getBatchedLocations(mCount,
+                                new LocApiResponse(mAdapter.getMsgTask(),
+                                [&mAdapter = mAdapter] (LocationError err) {
+                            mAdapter.mBatchedLocationsRequests--;
+                            std::vector<LocationSessionKey> waiters;
+                            waiters.swap(mAdapter.mBatchedLocationsWaiters);
+                            for (auto& waiter : waiters) {
+                                mAdapter.reportResponse(waiter.client, err, waiter.id);
+                            }
+                        }));
+                    }
                 }
             } else {
                 mAdapter.reportResponse(mClient, err, mSessionId);
@@ -592,44 +773,35 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
 }
 
 void
-BatchingAdapter::reportLocationsEvent(const Location* locations, size_t count,
+BatchingAdapter::reportLocationsEvent(const BatchedLocationsPtr& locations,
         BatchingMode batchingMode)
 {
+    size_t count = (nullptr != locations) ? locations->size() : 0;
     LOC_LOGD("%s]: count %zu batchMode %d", __func__, count, batchingMode);
 
+    // the buffer of LocApi is kept by reference until the clients are called
     struct MsgReportLocations : public LocMsg {
         BatchingAdapter& mAdapter;
-        Location* mLocations;
-        size_t mCount;
+        BatchedLocationsPtr mLocations;
         BatchingMode mBatchingMode;
         inline MsgReportLocations(BatchingAdapter& adapter,
-                                  const Location* locations,
-                                  size_t count,
+                                  const BatchedLocationsPtr& locations,
                                   BatchingMode batchingMode) :
             LocMsg(),
             mAdapter(adapter),
-            mLocations(new Location[count]),
-            mCount(count),
-            mBatchingMode(batchingMode)
-        {
+            mLocations(locations),
+            mBatchingMode(batchingMode) {}
+        inline virtual void proc() const {
             if (nullptr == mLocations) {
-                LOC_LOGE("%s]: new failed to allocate mLocations", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
-                mLocations[i] = locations[i];
+                mAdapter.reportLocations(nullptr, 0, mBatchingMode);
+            } else {
+                mAdapter.reportLocations(mLocations->data(), mLocations->size(),
+                                         mBatchingMode);
             }
         }
-        inline virtual ~MsgReportLocations() {
-            if (nullptr != mLocations)
-                delete[] mLocations;
-        }
-        inline virtual void proc() const {
-            mAdapter.reportLocations(mLocations, mCount, mBatchingMode);
-        }
     };
 
-    sendMsg(new MsgReportLocations(*this, locations, count, batchingMode));
+    sendMsg(new MsgReportLocations(*this, locations, batchingMode));
 }
 
 void
@@ -637,6 +809,34 @@ BatchingAdapter::reportLocations(Location* locations, size_t count, BatchingMode
 {
     BatchingOptions batchOptions = {sizeof(BatchingOptions), batchingMode};
 
+    if (BATCHING_MODE_TRIP == batchingMode) {
+        updateTripPath(locations, count);
+    } else if (BATCHING_MODE_ROUTINE == batchingMode && mBatchStore.isOpen()) {
+        if (0 == mBatchedLocationsRequests) {
+            // a full batch; kept, unless a session reports its batches anyway
+            bool autoReport = false;
+            for (auto it = mBatchingSessions.begin(); it != mBatchingSessions.end(); ++it) {
+                if (BATCHING_MODE_ROUTINE == it->second.batchingMode) {
+                    autoReport = true;
+                    break;
+                }
+            }
+            if (!autoReport) {
+                mBatchStore.append(locations, count);
+                return;
+            }
+        }
+        // the kept locations are older, so they go first
+        mBatchStore.drain(std::max(getBatchSize(), (size_t)1),
+                [this, &batchOptions] (Location* storedLocations, size_t storedCount) {
+            reportRoutineLocations(storedLocations, storedCount, batchOptions);
+        });
+    }
+
+    if (BATCHING_MODE_TRIP != batchingMode) {
+        reportRoutineLocations(locations, count, batchOptions);
+        return;
+    }
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.batchingCb) {
             it->second.batchingCb(count, locations, batchOptions);
@@ -644,6 +844,79 @@ BatchingAdapter::reportLocations(Location* locations, size_t count, BatchingMode
     }
 }
 
+void
+BatchingAdapter::reportRoutineLocations(Location* locations, size_t count,
+        const BatchingOptions& batchOptions)
+{
+    // the largest criteria each client with routine sessions asks for
+    std::map<LocationAPI*, LocationOptions> clientOptions;
+    for (auto it = mBatchingSessions.begin(); it != mBatchingSessions.end(); ++it) {
+        if (BATCHING_MODE_TRIP == it->second.batchingMode) {
+            continue;
+        }
+        auto it2 = clientOptions.find(it->first.client);
+        if (it2 == clientOptions.end()) {
+            clientOptions[it->first.client] = it->second;
+        } else {
+            it2->second.minInterval = std::min(it2->second.minInterval, it->second.minInterval);
+            it2->second.minDistance = std::min(it2->second.minDistance, it->second.minDistance);
+        }
+    }
+
+    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+        if (nullptr == it->second.batchingCb) {
+            continue;
+        }
+        auto it2 = clientOptions.find(it->first);
+        if (it2 == clientOptions.end() || nullptr == locations ||
+                (it2->second.minInterval <= mRoutineEngineOptions.minInterval &&
+                 it2->second.minDistance <= mRoutineEngineOptions.minDistance)) {
+            // gets the whole batch, as the modem runs for it
+            it->second.batchingCb(count, locations, batchOptions);
+            continue;
+        }
+
+        // a fix is kept once the client's interval, less half the one of the
+        // modem for jitter, and its distance are past the last fix it got
+        uint64_t minIntervalMs = it2->second.minInterval;
+        uint64_t jitterMs = mRoutineEngineOptions.minInterval / 2;
+        minIntervalMs = (minIntervalMs > jitterMs) ? minIntervalMs - jitterMs : 0;
+        uint32_t minDistance = it2->second.minDistance;
+        auto it3 = mRoutineClientLastFix.find(it->first);
+        bool hasLastFix = (it3 != mRoutineClientLastFix.end());
+        Location lastFix = hasLastFix ? it3->second : Location();
+        mRoutineClientLocations.clear();
+        for (size_t i=0; i < count; ++i) {
+            const Location& fix = locations[i];
+            if (hasLastFix) {
+                if (fix.timestamp < lastFix.timestamp + minIntervalMs) {
+                    continue;
+                }
+                if (0 != minDistance && (LOCATION_HAS_LAT_LONG_BIT & fix.flags) &&
+                        (LOCATION_HAS_LAT_LONG_BIT & lastFix.flags)) {
+                    double lat1 = lastFix.latitude * M_PI / 180.0;
+                    double lat2 = fix.latitude * M_PI / 180.0;
+                    double sinDLat = sin((lat2 - lat1) / 2.0);
+                    double sinDLon = sin((fix.longitude - lastFix.longitude) * M_PI / 360.0);
+                    double a = sinDLat * sinDLat + cos(lat1) * cos(lat2) * sinDLon * sinDLon;
+                    if (2.0 * TRIP_EARTH_RADIUS_M * asin(sqrt(std::min(a, 1.0))) <
+                            minDistance) {
+                        continue;
+                    }
+                }
+            }
+            mRoutineClientLocations.push_back(fix);
+            lastFix = fix;
+            hasLastFix = true;
+        }
+        if (!mRoutineClientLocations.empty()) {
+            mRoutineClientLastFix[it->first] = lastFix;
+            it->second.batchingCb(mRoutineClientLocations.size(),
+                                  mRoutineClientLocations.data(), batchOptions);
+        }
+    }
+}
+
 void
 BatchingAdapter::reportCompletedTripsEvent(uint32_t accumulated_distance)
 {
@@ -764,11 +1037,12 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
         mTripSessions[sessionId] = { 0, 0, 0, batchingOptions.minDistance,
                 batchingOptions.minInterval};
         mLocApi->startOutdoorTripBatching(batchingOptions.minDistance,
-                batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(*getContext(),
+                batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(getMsgTask(),
                 [this, client, sessionId, batchingOptions] (LocationError err) {
             if (err == LOCATION_ERROR_SUCCESS) {
                 mOngoingTripDistance = batchingOptions.minDistance;
                 mOngoingTripTBFInterval = batchingOptions.minInterval;
+                resetTripPath();
                 LOC_LOGD("%s] New Trip started ...", __func__);
                 printTripReport();
             } else {
@@ -786,7 +1060,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
     } else {
         // query accumulated distance
         mLocApi->queryAccumulatedTripDistance(
-                new LocApiResponseData<LocApiBatchData>(*getContext(),
+                new LocApiResponseData<LocApiBatchData>(getMsgTask(),
                 [this, batchingOptions, sessionId, client]
                 (LocationError err, LocApiBatchData data) {
             uint32_t accumulatedDistanceOngoingBatch = 0;
@@ -800,35 +1074,34 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                 ongoingTripInterval = batchingOptions.minInterval;
                 needsRestart = true;
             }
-            accumulatedDistanceOngoingBatch = data.accumulatedDistance;
-            numOfBatchedPositions = data.numOfBatchedPositions;
+            if (err != LOCATION_ERROR_SUCCESS) {
+                // unable to query accumulated distance, use the estimate of the AP
+                accumulatedDistanceOngoingBatch = std::min((uint32_t)mTripPathDistance,
+                                                           ongoingTripDistance);
+                LOC_LOGW("%s] Accumulated distance query failed, estimated %u",
+                         __func__, accumulatedDistanceOngoingBatch);
+            } else {
+                accumulatedDistanceOngoingBatch = data.accumulatedDistance;
+                numOfBatchedPositions = data.numOfBatchedPositions;
+            }
             TripSessionStatus newTripSession = { accumulatedDistanceOngoingBatch, 0, 0,
                                                  batchingOptions.minDistance,
                                                  batchingOptions.minInterval};
-            if (err != LOCATION_ERROR_SUCCESS) {
-                // unable to query accumulated distance, assume remaining distance in
-                // ongoing batch is mongoingTripDistance.
-                if (batchingOptions.minDistance < ongoingTripDistance) {
-                    ongoingTripDistance = batchingOptions.minDistance;
-                    needsRestart = true;
-                }
-            } else {
-                // compute the remaining distance
-                uint32_t ongoing_trip_remaining_distance = ongoingTripDistance -
-                        accumulatedDistanceOngoingBatch;
-
-                // check if new trip distance is lesser than the ongoing batch remaining distance
-                if (batchingOptions.minDistance < ongoing_trip_remaining_distance) {
-                    ongoingTripDistance = batchingOptions.minDistance;
-                    needsRestart = true;
-                } else if (needsRestart == true) {
-                    // needsRestart is anyways true , may be because of lesser TBF of new session.
-                    ongoingTripDistance = ongoing_trip_remaining_distance;
-                }
-                mTripSessions[sessionId] = newTripSession;
-                LOC_LOGD("%s] New Trip started ...", __func__);
-                printTripReport();
+            // compute the remaining distance
+            uint32_t ongoing_trip_remaining_distance = ongoingTripDistance -
+                    accumulatedDistanceOngoingBatch;
+
+            // check if new trip distance is lesser than the ongoing batch remaining distance
+            if (batchingOptions.minDistance < ongoing_trip_remaining_distance) {
+                ongoingTripDistance = batchingOptions.minDistance;
+                needsRestart = true;
+            } else if (needsRestart == true) {
+                // needsRestart is anyways true , may be because of lesser TBF of new session.
+                ongoingTripDistance = ongoing_trip_remaining_distance;
             }
+            mTripSessions[sessionId] = newTripSession;
+            LOC_LOGD("%s] New Trip started ...", __func__);
+            printTripReport();
 
             if (needsRestart) {
                 mOngoingTripDistance = ongoingTripDistance;
@@ -843,10 +1116,12 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                             tripSessStatus.accumulatedDistanceThisTrip;
                 }
                 mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
-                        getBatchingTimeout(), new LocApiResponse(*getContext(),
+                        getBatchingTimeout(), new LocApiResponse(getMsgTask(),
                         [this, client, sessionId] (LocationError err) {
                     if (err != LOCATION_ERROR_SUCCESS) {
                         LOC_LOGE("%s] New Trip restart failed!", __func__);
+                    } else {
+                        resetTripPath();
                     }
                     reportResponse(client, err, sessionId);
                 }));
@@ -864,7 +1139,7 @@ BatchingAdapter::stopTripBatchingMultiplex(LocationAPI* client, uint32_t session
     LocationError err = LOCATION_ERROR_SUCCESS;
 
     if (mTripSessions.size() == 1) {
-        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
+        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(getMsgTask(),
                 [this, restartNeeded, client, sessionId, batchOptions]
                 (LocationError err) {
             if (LOCATION_ERROR_SUCCESS == err) {
@@ -923,7 +1198,7 @@ BatchingAdapter::stopTripBatchingMultiplexCommon(LocationError err, LocationAPI*
 
 void
 BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t accDist,
-        uint32_t numbatchedPos)
+        uint32_t /*numbatchedPos*/)
 {
     // does batch need restart with new trip distance / TBF interval
     uint32_t minRemainingDistance = 0;
@@ -931,7 +1206,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
 
     // if no more trips left, stop the ongoing trip
     if (mTripSessions.size() == 0) {
-        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
+        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(getMsgTask(),
                                                [] (LocationError /*err*/) {}));
         mOngoingTripDistance = 0;
         mOngoingTripTBFInterval = 0;
@@ -962,70 +1237,136 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
         }
     }
 
+    if (!queryAccumulatedDistance) {
+        // the distance is known already, from the report of the trip batch
+        restartTripBatchingWithDistance(minRemainingDistance, minTBFInterval, accDist);
+        return;
+    }
+
+    if (!mTripWithOngoingTripDistanceDropped && !mTripWithOngoingTBFDropped) {
+        // the ongoing distance and TBF interval still come from the sessions left,
+        // which got as much closer to their end as the ongoing batch, so none of
+        // them can end before it does, and no restart is needed
+        printTripReport();
+        return;
+    }
+
     mLocApi->queryAccumulatedTripDistance(
-            new LocApiResponseData<LocApiBatchData>(*getContext(),
-            [this, queryAccumulatedDistance, minRemainingDistance, minTBFInterval, accDist,
-            numbatchedPos] (LocationError /*err*/, LocApiBatchData data) {
-        bool needsRestart = false;
-
-        uint32_t ongoingTripDistance = mOngoingTripDistance;
-        uint32_t ongoingTripInterval = mOngoingTripTBFInterval;
-        uint32_t accumulatedDistance = accDist;
-        uint32_t numOfBatchedPositions = numbatchedPos;
-
-        if (queryAccumulatedDistance) {
-            accumulatedDistance = data.accumulatedDistance;
-            numOfBatchedPositions = data.numOfBatchedPositions;
+            new LocApiResponseData<LocApiBatchData>(getMsgTask(),
+            [this, minRemainingDistance, minTBFInterval]
+            (LocationError err, LocApiBatchData data) {
+        uint32_t accumulatedDistance = data.accumulatedDistance;
+        if (LOCATION_ERROR_SUCCESS != err) {
+            // unable to query accumulated distance, use the estimate of the AP
+            accumulatedDistance = (uint32_t)mTripPathDistance;
+            LOC_LOGW("%s] Accumulated distance query failed, estimated %u",
+                     __func__, accumulatedDistance);
         }
+        restartTripBatchingWithDistance(minRemainingDistance, minTBFInterval,
+                                        accumulatedDistance);
+    }));
+}
 
-        if ((!mTripWithOngoingTripDistanceDropped) &&
-                (ongoingTripDistance - accumulatedDistance != 0)) {
-            // if ongoing trip is already not completed still,
-            // check the min distance against the remaining distance
-            if (minRemainingDistance <
-                    (ongoingTripDistance - accumulatedDistance)) {
-                ongoingTripDistance = minRemainingDistance;
-                needsRestart = true;
-            }
-        } else if (minRemainingDistance != 0) {
-            // else if ongoing trip is already completed / dropped,
-            // use the minRemainingDistance of ongoing sessions
+void
+BatchingAdapter::restartTripBatchingWithDistance(uint32_t minRemainingDistance,
+        uint32_t minTBFInterval, uint32_t accumulatedDistance)
+{
+    bool needsRestart = false;
+
+    uint32_t ongoingTripDistance = mOngoingTripDistance;
+    uint32_t ongoingTripInterval = mOngoingTripTBFInterval;
+
+    if ((!mTripWithOngoingTripDistanceDropped) &&
+            (ongoingTripDistance - accumulatedDistance != 0)) {
+        // if ongoing trip is already not completed still,
+        // check the min distance against the remaining distance
+        if (minRemainingDistance <
+                (ongoingTripDistance - accumulatedDistance)) {
             ongoingTripDistance = minRemainingDistance;
             needsRestart = true;
         }
+    } else if (minRemainingDistance != 0) {
+        // else if ongoing trip is already completed / dropped,
+        // use the minRemainingDistance of ongoing sessions
+        ongoingTripDistance = minRemainingDistance;
+        needsRestart = true;
+    }
 
-         if ((minTBFInterval < ongoingTripInterval) ||
-                    ((minTBFInterval != ongoingTripInterval) &&
-                    (mTripWithOngoingTBFDropped))) {
-            ongoingTripInterval = minTBFInterval;
-            needsRestart = true;
-        }
+    if ((minTBFInterval < ongoingTripInterval) ||
+            ((minTBFInterval != ongoingTripInterval) &&
+            (mTripWithOngoingTBFDropped))) {
+        ongoingTripInterval = minTBFInterval;
+        needsRestart = true;
+    }
 
-        if (needsRestart) {
-            mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
-                    getBatchingTimeout(), new LocApiResponse(*getContext(),
-                    [this, accumulatedDistance, ongoingTripDistance, ongoingTripInterval]
-                    (LocationError err) {
-
-                if (err == LOCATION_ERROR_SUCCESS) {
-                    for(auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
-                        TripSessionStatus &tripSessStatus = itt->second;
-                        tripSessStatus.accumulatedDistanceThisTrip =
-                                tripSessStatus.accumulatedDistanceOnTripRestart +
-                                (accumulatedDistance -
-                                 tripSessStatus.accumulatedDistanceOngoingBatch);
-
-                        tripSessStatus.accumulatedDistanceOngoingBatch = 0;
-                        tripSessStatus.accumulatedDistanceOnTripRestart =
-                                tripSessStatus.accumulatedDistanceThisTrip;
-                    }
+    if (needsRestart) {
+        mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
+                getBatchingTimeout(), new LocApiResponse(getMsgTask(),
+                [this, accumulatedDistance, ongoingTripDistance, ongoingTripInterval]
+                (LocationError err) {
+
+            if (err == LOCATION_ERROR_SUCCESS) {
+                for(auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
+                    TripSessionStatus &tripSessStatus = itt->second;
+                    tripSessStatus.accumulatedDistanceThisTrip =
+                            tripSessStatus.accumulatedDistanceOnTripRestart +
+                            (accumulatedDistance -
+                             tripSessStatus.accumulatedDistanceOngoingBatch);
 
-                    mOngoingTripDistance = ongoingTripDistance;
-                    mOngoingTripTBFInterval = ongoingTripInterval;
+                    tripSessStatus.accumulatedDistanceOngoingBatch = 0;
+                    tripSessStatus.accumulatedDistanceOnTripRestart =
+                            tripSessStatus.accumulatedDistanceThisTrip;
                 }
-            }));
+
+                mOngoingTripDistance = ongoingTripDistance;
+                mOngoingTripTBFInterval = ongoingTripInterval;
+                resetTripPath();
+            }
+        }));
+    }
+}
+
+void
+BatchingAdapter::setBatchStoreSize(size_t batchStoreSize)
+{
+    if (batchStoreSize == mBatchStoreSize) {
+        return;
+    }
+    mBatchStoreSize = batchStoreSize;
+    if (0 == batchStoreSize) {
+        mBatchStore.close();
+    } else if (!mBatchStore.open(BATCH_STORE_FILE, batchStoreSize)) {
+        mBatchStoreSize = 0;
+    }
+}
+
+void
+BatchingAdapter::resetTripPath()
+{
+    mTripPathDistance = 0;
+    memset(&mTripLastFix, 0, sizeof(mTripLastFix));
+}
+
+void
+BatchingAdapter::updateTripPath(const Location* locations, size_t count)
+{
+    // great circle length of each leg, from the last fix of the previous report on
+    for (size_t i=0; nullptr != locations && i < count; ++i) {
+        const Location& fix = locations[i];
+        if (!(LOCATION_HAS_LAT_LONG_BIT & fix.flags)) {
+            continue;
         }
-    }));
+        if (LOCATION_HAS_LAT_LONG_BIT & mTripLastFix.flags) {
+            double lat1 = mTripLastFix.latitude * M_PI / 180.0;
+            double lat2 = fix.latitude * M_PI / 180.0;
+            double sinDLat = sin((lat2 - lat1) / 2.0);
+            double sinDLon = sin((fix.longitude - mTripLastFix.longitude) * M_PI / 360.0);
+            double a = sinDLat * sinDLat + cos(lat1) * cos(lat2) * sinDLon * sinDLon;
+            mTripPathDistance += 2.0 * TRIP_EARTH_RADIUS_M * asin(sqrt(std::min(a, 1.0)));
+        }
+        mTripLastFix = fix;
+    }
+    LOC_LOGD("%s]: estimated trip path %.1f m", __func__, mTripPathDistance);
 }
 
 void
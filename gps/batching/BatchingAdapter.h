@@ -32,7 +32,10 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <BatchStore.h>
 #include <map>
+#include <vector>
+#include <unordered_set>
 
 using namespace loc_core;
 
@@ -55,6 +58,10 @@ class BatchingAdapter : public LocAdapterBase {
     uint32_t mOngoingTripTBFInterval;
     bool mTripWithOngoingTBFDropped;
     bool mTripWithOngoingTripDistanceDropped;
+    // AP side estimate of the distance accumulated by the ongoing trip batch:
+    // the path through the trip fixes reported since the batch (re)started
+    double mTripPathDistance;
+    Location mTripLastFix;
 
     void startTripBatchingMultiplex(LocationAPI* client, uint32_t sessionId,
                                     const BatchingOptions& batchingOptions);
@@ -72,13 +79,42 @@ class BatchingAdapter : public LocAdapterBase {
                                          const BatchingOptions& batchOptions);
     void restartTripBatching(bool queryAccumulatedDistance, uint32_t accDist = 0,
                              uint32_t numbatchedPos = 0);
+    void restartTripBatchingWithDistance(uint32_t minRemainingDistance, uint32_t minTBFInterval,
+                                         uint32_t accumulatedDistance);
+    void resetTripPath();
+    void updateTripPath(const Location* locations, size_t count);
     void printTripReport();
 
+    /* ==== SHARED ROUTINE BATCH =========================================================== */
+    // the routine and no auto report sessions all run as this one modem batching
+    // session, at the smallest minInterval and minDistance of them; the options
+    // last sent to the modem are kept, size 0 while it does not run
+    uint32_t mRoutineEngineSessionId;
+    LocationOptions mRoutineEngineOptions;
+    // the last batched fix each client with routine sessions got, its fixes being
+    // decimated on the AP to the largest criteria its sessions allow
+    std::map<LocationAPI*, Location> mRoutineClientLastFix;
+    std::vector<Location> mRoutineClientLocations;
+    // the sessions waiting for the modem read in flight, all answered by it
+    std::vector<LocationSessionKey> mBatchedLocationsWaiters;
+
+    LocationOptions getMultiplexedRoutineOptions() const;
+    void updateRoutineEngineSession(std::function<void(LocationError)> onDone = nullptr);
+    void reportRoutineLocations(Location* locations, size_t count,
+                                const BatchingOptions& batchOptions);
+
     /* ==== CONFIGURATION ================================================================== */
     uint32_t mBatchingTimeout;
     uint32_t mBatchingAccuracy;
     size_t mBatchSize;
     size_t mTripBatchSize;
+    size_t mBatchStoreSize;
+
+    /* ==== AP BATCH STORE ================================================================= */
+    // routine batches, once full in the modem, kept for the sessions without auto report
+    BatchStore mBatchStore;
+    // getBatchedLocations reads of routine sessions waiting for the modem
+    uint32_t mBatchedLocationsRequests;
 
 protected:
 
@@ -124,7 +160,7 @@ public:
 
     /* ==== REPORTS ======================================================================== */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
-    void reportLocationsEvent(const Location* locations, size_t count,
+    void reportLocationsEvent(const BatchedLocationsPtr& locations,
             BatchingMode batchingMode);
     void reportCompletedTripsEvent(uint32_t accumulatedDistance);
     void reportBatchStatusChangeEvent(BatchingStatus batchStatus);
@@ -137,6 +173,7 @@ public:
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
     void readConfigCommand();
     void setConfigCommand();
+    void confChangedCommand(const std::unordered_set<std::string>& changedKeys);
     /* ======== UTILITIES ================================================================== */
     void setBatchSize(size_t batchSize) { mBatchSize = batchSize; }
     size_t getBatchSize() { return mBatchSize; }
@@ -146,6 +183,7 @@ public:
     uint32_t getBatchingTimeout() { return mBatchingTimeout; }
     void setBatchingAccuracy(uint32_t accuracy) { mBatchingAccuracy = accuracy; }
     uint32_t getBatchingAccuracy() { return mBatchingAccuracy; }
+    void setBatchStoreSize(size_t batchStoreSize);
 
 };
 
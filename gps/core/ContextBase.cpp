@@ -31,7 +31,9 @@
 
 #include <dlfcn.h>
 #include <unistd.h>
+#include <mutex>
 #include <ContextBase.h>
+#include <ReplayLocApi.h>
 #include <msg_q.h>
 #include <loc_target.h>
 #include <loc_pla.h>
@@ -95,7 +97,34 @@ const loc_param_s_type ContextBase::mGps_conf_table[] =
            &mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED, NULL, 'n'},
   {"NMEA_TAG_BLOCK_GROUPING_ENABLED", &mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED, NULL, 'n'},
   {"NI_SUPL_DENY_ON_NFW_LOCKED",  &mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED, NULL, 'n'},
-  {"ENABLE_NMEA_PRINT",  &mGps_conf.ENABLE_NMEA_PRINT, NULL, 'n'}
+  {"ENABLE_NMEA_PRINT",  &mGps_conf.ENABLE_NMEA_PRINT, NULL, 'n'},
+  {"NMEA_GSV_DECIMATION",  &mGps_conf.NMEA_GSV_DECIMATION, NULL, 'n'},
+  {"DATA_ITEM_NOTIFY_COALESCE_MS",  &mGps_conf.DATA_ITEM_NOTIFY_COALESCE_MS, NULL, 'n'},
+  {"TRACKING_REPORT_BATCH_SIZE",  &mGps_conf.TRACKING_REPORT_BATCH_SIZE, NULL, 'n'},
+  {"TRACKING_REPORT_BATCH_MS",  &mGps_conf.TRACKING_REPORT_BATCH_MS, NULL, 'n'},
+  {"WARM_START_CACHE_ENABLED",  &mGps_conf.WARM_START_CACHE_ENABLED, NULL, 'n'},
+  {"ODCPI_CACHE_MAX_AGE_MS",  &mGps_conf.ODCPI_CACHE_MAX_AGE_MS, NULL, 'n'},
+  {"ODCPI_CACHE_MAX_ACCURACY_M",  &mGps_conf.ODCPI_CACHE_MAX_ACCURACY_M, NULL, 'n'},
+  {"GEOFENCE_SW_OVERFLOW_ENABLED",  &mGps_conf.GEOFENCE_SW_OVERFLOW_ENABLED, NULL, 'n'},
+  {"GEOFENCE_BREACH_COALESCE_MS",  &mGps_conf.GEOFENCE_BREACH_COALESCE_MS, NULL, 'n'},
+  {"GEOFENCE_ADAPTIVE_MAX_SCALE",  &mGps_conf.GEOFENCE_ADAPTIVE_MAX_SCALE, NULL, 'n'},
+  {"POWER_POLICY_ENABLED",  &mGps_conf.POWER_POLICY_ENABLED, NULL, 'n'},
+  {"POWER_POLICY_REDUCED_NMEA_ENABLED",
+           &mGps_conf.POWER_POLICY_REDUCED_NMEA_ENABLED, NULL, 'n'},
+  {"POWER_POLICY_REDUCED_SV_DECIMATION",
+           &mGps_conf.POWER_POLICY_REDUCED_SV_DECIMATION, NULL, 'n'},
+  {"POWER_POLICY_REDUCED_MEAS_DECIMATION",
+           &mGps_conf.POWER_POLICY_REDUCED_MEAS_DECIMATION, NULL, 'n'},
+  {"POWER_POLICY_REDUCED_GEOFENCE_SCALE",
+           &mGps_conf.POWER_POLICY_REDUCED_GEOFENCE_SCALE, NULL, 'n'},
+  {"AGPS_E911_PRECONNECT_SEC",  &mGps_conf.AGPS_E911_PRECONNECT_SEC, NULL, 'n'},
+  {"XTRA_PREFETCH_AGE_HOURS",  &mGps_conf.XTRA_PREFETCH_AGE_HOURS, NULL, 'n'},
+  {"ENGINE_POSITION_SELECTION",  &mGps_conf.ENGINE_POSITION_SELECTION, NULL, 'n'},
+  {"GNSS_ENERGY_CACHE_MAX_AGE_MS",  &mGps_conf.GNSS_ENERGY_CACHE_MAX_AGE_MS, NULL, 'n'},
+  {"GNSS_RECORDER_ENABLED",  &mGps_conf.GNSS_RECORDER_ENABLED, NULL, 'n'},
+  {"GNSS_RECORDER_DIR",  &mGps_conf.GNSS_RECORDER_DIR, NULL, 's'},
+  {"GNSS_RECORDER_FILE_SIZE_KB",  &mGps_conf.GNSS_RECORDER_FILE_SIZE_KB, NULL, 'n'},
+  {"GNSS_RECORDER_FILE_COUNT",  &mGps_conf.GNSS_RECORDER_FILE_COUNT, NULL, 'n'}
 };
 
 const loc_param_s_type ContextBase::mSap_conf_table[] =
@@ -199,6 +228,45 @@ void ContextBase::readConfig()
         mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED = 1;
         /* By default NMEA Printing is disabled */
         mGps_conf.ENABLE_NMEA_PRINT = 0;
+        /* By default GSV is generated for every SV report */
+        mGps_conf.NMEA_GSV_DECIMATION = 1;
+        /* By default data item updates are forwarded to clients immediately */
+        mGps_conf.DATA_ITEM_NOTIFY_COALESCE_MS = 0;
+        /* By default tracking fixes are reported one by one */
+        mGps_conf.TRACKING_REPORT_BATCH_SIZE = 0;
+        mGps_conf.TRACKING_REPORT_BATCH_MS = 0;
+        /* By default no position and time are kept for the next engine start */
+        mGps_conf.WARM_START_CACHE_ENABLED = 0;
+        /* By default every ODCPI request goes to the framework */
+        mGps_conf.ODCPI_CACHE_MAX_AGE_MS = 0;
+        mGps_conf.ODCPI_CACHE_MAX_ACCURACY_M = 0;
+        /* By default geofences the engine has no room for are rejected */
+        mGps_conf.GEOFENCE_SW_OVERFLOW_ENABLED = 0;
+        /* By default geofence breaches are reported as they come */
+        mGps_conf.GEOFENCE_BREACH_COALESCE_MS = 0;
+        /* By default the geofence responsiveness does not depend on the distance */
+        mGps_conf.GEOFENCE_ADAPTIVE_MAX_SCALE = 0;
+        /* By default the reports do not depend on the charging and screen state */
+        mGps_conf.POWER_POLICY_ENABLED = 0;
+        mGps_conf.POWER_POLICY_REDUCED_NMEA_ENABLED = 0;
+        mGps_conf.POWER_POLICY_REDUCED_SV_DECIMATION = 4;
+        mGps_conf.POWER_POLICY_REDUCED_MEAS_DECIMATION = 4;
+        mGps_conf.POWER_POLICY_REDUCED_GEOFENCE_SCALE = 4;
+        /* By default the SUPL data call is brought up when the engine asks */
+        mGps_conf.AGPS_E911_PRECONNECT_SEC = 0;
+        /* By default XTRA is downloaded only when the engine asks */
+        mGps_conf.XTRA_PREFETCH_AGE_HOURS = 0;
+        /* By default only the fused position of the engine hub is reported */
+        mGps_conf.ENGINE_POSITION_SELECTION = 0;
+        /* By default every energy consumed query goes to the modem */
+        mGps_conf.GNSS_ENERGY_CACHE_MAX_AGE_MS = 0;
+        /* By default no reports are recorded, and when they are it is to
+           8 files of 1 MB in the location data dir */
+        mGps_conf.GNSS_RECORDER_ENABLED = 0;
+        strlcpy(mGps_conf.GNSS_RECORDER_DIR, "/data/vendor/location/gnss_rec",
+                sizeof(mGps_conf.GNSS_RECORDER_DIR));
+        mGps_conf.GNSS_RECORDER_FILE_SIZE_KB = 1024;
+        mGps_conf.GNSS_RECORDER_FILE_COUNT = 8;
 
         UTIL_READ_CONF(LOC_PATH_GPS_CONF, mGps_conf_table);
         UTIL_READ_CONF(LOC_PATH_SAP_CONF, mSap_conf_table);
@@ -225,11 +293,42 @@ void ContextBase::readConfig()
     }
 }
 
+void ContextBase::readGpsConfItems(const std::unordered_set<std::string>& keys)
+{
+    std::vector<loc_param_s_type> table;
+    for (auto& entry : mGps_conf_table) {
+        if (keys.find(entry.param_name) != keys.end()) {
+            table.push_back(entry);
+        }
+    }
+    if (table.empty()) {
+        return;
+    }
+    loc_read_conf(LOC_PATH_GPS_CONF, table.data(), table.size());
+
+    if (keys.find("NMEA_REPORT_RATE") != keys.end()) {
+        sNmeaReportRate = (strncmp(mGps_conf.NMEA_REPORT_RATE, "1HZ",
+                sizeof(mGps_conf.NMEA_REPORT_RATE)) == 0) ?
+                GNSS_NMEA_REPORT_RATE_1HZ : GNSS_NMEA_REPORT_RATE_NHZ;
+    }
+}
+
 uint32_t ContextBase::getCarrierCapabilities() {
     #define carrierMSA (uint32_t)0x2
     #define carrierMSB (uint32_t)0x1
     #define gpsConfMSA (uint32_t)0x4
     #define gpsConfMSB (uint32_t)0x2
+    // CAPABILITIES and SUPL_MODE change only with the config or a SUPL mode
+    // update, so the result is kept until one of them does
+    static std::mutex cacheMutex;
+    static uint64_t cachedInputs = UINT64_MAX;
+    static uint32_t cachedCapabilities = 0;
+    uint64_t inputs = ((uint64_t)mGps_conf.CAPABILITIES << 32) | mGps_conf.SUPL_MODE;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cachedInputs == inputs) {
+        return cachedCapabilities;
+    }
+
     uint32_t capabilities = mGps_conf.CAPABILITIES;
     if ((mGps_conf.SUPL_MODE & carrierMSA) != carrierMSA) {
         capabilities &= ~gpsConfMSA;
@@ -240,6 +339,8 @@ uint32_t ContextBase::getCarrierCapabilities() {
 
     LOC_LOGV("getCarrierCapabilities: CAPABILITIES %x, SUPL_MODE %x, carrier capabilities %x",
              mGps_conf.CAPABILITIES, mGps_conf.SUPL_MODE, capabilities);
+    cachedCapabilities = capabilities;
+    cachedInputs = inputs;
     return capabilities;
 }
 
@@ -271,6 +372,28 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
     LocApiBase* locApi = NULL;
     const char* libname = LOC_APIV2_0_LIB_NAME;
 
+    // gps.conf is not read yet at this point, so the capture and replay
+    // settings are read on their own; both are off by default
+    char captureFile[LOC_MAX_PARAM_STRING] = {};
+    char replayFile[LOC_MAX_PARAM_STRING] = {};
+    uint32_t replaySpeed = 1;
+    uint32_t replayLoop = 0;
+    loc_param_s_type replay_conf_table[] =
+    {
+        { "LOC_API_CAPTURE_FILE", &captureFile, NULL, 's' },
+        { "LOC_API_REPLAY_FILE",  &replayFile,  NULL, 's' },
+        { "LOC_API_REPLAY_SPEED", &replaySpeed, NULL, 'n' },
+        { "LOC_API_REPLAY_LOOP",  &replayLoop,  NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, replay_conf_table);
+
+    // A replay stands in for the engine, whether there is one or not
+    if ('\0' != replayFile[0]) {
+        LOC_LOGi("replaying engine reports from %s at speed %u",
+                 replayFile, replaySpeed);
+        return new ReplayLocApi(exMask, this, replayFile, replaySpeed, 0 != replayLoop);
+    }
+
     // Check the target
     if (TARGET_NO_GNSS != loc_get_target()){
 
@@ -313,6 +436,10 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
         locApi = new LocApiBase(exMask, this);
     }
 
+    if ('\0' != captureFile[0]) {
+        locApi->startCapture(captureFile);
+    }
+
     return locApi;
 }
 
@@ -368,17 +495,4 @@ void ContextBase::setEngineCapabilities(uint64_t supportedMsgMask,
 }
 
 
-bool ContextBase::isFeatureSupported(uint8_t featureVal)
-{
-    uint8_t arrayIndex = featureVal >> 3;
-    uint8_t bitPos = featureVal & 7;
-
-    if (arrayIndex >= MAX_FEATURE_LENGTH) return false;
-    return ((ContextBase::sFeaturesSupported[arrayIndex] >> bitPos ) & 0x1);
-}
-
-bool ContextBase::gnssConstellationConfig() {
-    return sGnssMeasurementSupported;
-}
-
 }
@@ -40,6 +40,8 @@
 #else
     #include <unordered_map>
 #endif
+#include <unordered_set>
+#include <string>
 
 /* GPS.conf support */
 /* NOTE: the implementaiton of the parser casts number
@@ -83,6 +85,29 @@ typedef struct loc_gps_cfg_s
     uint32_t       NI_SUPL_DENY_ON_NFW_LOCKED;
     uint32_t       ENABLE_NMEA_PRINT;
     uint32_t       NMEA_TAG_BLOCK_GROUPING_ENABLED;
+    uint32_t       NMEA_GSV_DECIMATION;
+    uint32_t       DATA_ITEM_NOTIFY_COALESCE_MS;
+    uint32_t       TRACKING_REPORT_BATCH_SIZE;
+    uint32_t       TRACKING_REPORT_BATCH_MS;
+    uint32_t       WARM_START_CACHE_ENABLED;
+    uint32_t       ODCPI_CACHE_MAX_AGE_MS;
+    uint32_t       ODCPI_CACHE_MAX_ACCURACY_M;
+    uint32_t       GEOFENCE_SW_OVERFLOW_ENABLED;
+    uint32_t       GEOFENCE_BREACH_COALESCE_MS;
+    uint32_t       GEOFENCE_ADAPTIVE_MAX_SCALE;
+    uint32_t       POWER_POLICY_ENABLED;
+    uint32_t       POWER_POLICY_REDUCED_NMEA_ENABLED;
+    uint32_t       POWER_POLICY_REDUCED_SV_DECIMATION;
+    uint32_t       POWER_POLICY_REDUCED_MEAS_DECIMATION;
+    uint32_t       POWER_POLICY_REDUCED_GEOFENCE_SCALE;
+    uint32_t       AGPS_E911_PRECONNECT_SEC;
+    uint32_t       XTRA_PREFETCH_AGE_HOURS;
+    uint32_t       ENGINE_POSITION_SELECTION;
+    uint32_t       GNSS_ENERGY_CACHE_MAX_AGE_MS;
+    uint32_t       GNSS_RECORDER_ENABLED;
+    char           GNSS_RECORDER_DIR[LOC_MAX_PARAM_STRING];
+    uint32_t       GNSS_RECORDER_FILE_SIZE_KB;
+    uint32_t       GNSS_RECORDER_FILE_COUNT;
 } loc_gps_cfg_s_type;
 
 /* NOTE: the implementation of the parser casts number
@@ -169,6 +194,9 @@ public:
     static LocationCapabilitiesMask sQwesFeatureMask;
 
     void readConfig();
+    // re-reads only the given keys of gps.conf into mGps_conf, e.g. after
+    // the file changed; keys no longer in the file keep their value
+    static void readGpsConfItems(const std::unordered_set<std::string>& keys);
     static uint32_t getCarrierCapabilities();
     void setEngineCapabilities(uint64_t supportedMsgMask,
             uint8_t *featureList, bool gnssMeasurementSupported);
@@ -181,10 +209,10 @@ public:
 
         // confirm if msgID is not larger than the number of bits in
         // mSupportedMsg
-        if ((uint64_t)msgID > (sizeof(sSupportedMsgMask) << 3)) {
+        if ((uint64_t)msgID >= (sizeof(sSupportedMsgMask) << 3)) {
             return false;
         } else {
-            uint32_t messageChecker = 1 << msgID;
+            uint64_t messageChecker = (uint64_t)1 << msgID;
             return (messageChecker & sSupportedMsgMask) == messageChecker;
         }
     }
@@ -192,12 +220,20 @@ public:
     /*
         Check if a feature is supported
     */
-    static bool isFeatureSupported(uint8_t featureVal);
+    static inline bool isFeatureSupported(uint8_t featureVal) {
+        uint8_t arrayIndex = featureVal >> 3;
+        uint8_t bitPos = featureVal & 7;
+
+        if (arrayIndex >= MAX_FEATURE_LENGTH) return false;
+        return ((sFeaturesSupported[arrayIndex] >> bitPos ) & 0x1);
+    }
 
     /*
         Check if gnss measurement is supported
     */
-    static bool gnssConstellationConfig();
+    static inline bool gnssConstellationConfig() {
+        return sGnssMeasurementSupported;
+    }
 
     /*
         set QWES feature status info
@@ -315,7 +351,7 @@ public:
 
 struct LocApiResponse: LocMsg {
     private:
-        ContextBase& mContext;
+        const MsgTask* mMsgTask;
         std::function<void (LocationError err)> mProcImpl;
         inline virtual void proc() const {
             mProcImpl(mLocationError);
@@ -325,17 +361,21 @@ struct LocApiResponse: LocMsg {
     public:
         inline LocApiResponse(ContextBase& context,
                               std::function<void (LocationError err)> procImpl ) :
-                              mContext(context), mProcImpl(procImpl) {}
+                              mMsgTask(context.getMsgTask()), mProcImpl(procImpl) {}
+        // to be returned to the given MsgTask, e.g. the one of an adapter
+        inline LocApiResponse(const MsgTask* msgTask,
+                              std::function<void (LocationError err)> procImpl ) :
+                              mMsgTask(msgTask), mProcImpl(procImpl) {}
 
         void returnToSender(const LocationError err) {
             mLocationError = err;
-            mContext.sendMsg(this);
+            mMsgTask->sendMsg(this);
         }
 };
 
 struct LocApiCollectiveResponse: LocMsg {
     private:
-        ContextBase& mContext;
+        const MsgTask* mMsgTask;
         std::function<void (std::vector<LocationError> errs)> mProcImpl;
         inline virtual void proc() const {
             mProcImpl(mLocationErrors);
@@ -345,13 +385,17 @@ struct LocApiCollectiveResponse: LocMsg {
     public:
         inline LocApiCollectiveResponse(ContextBase& context,
                               std::function<void (std::vector<LocationError> errs)> procImpl ) :
-                              mContext(context), mProcImpl(procImpl) {}
+                              mMsgTask(context.getMsgTask()), mProcImpl(procImpl) {}
+        // to be returned to the given MsgTask, e.g. the one of an adapter
+        inline LocApiCollectiveResponse(const MsgTask* msgTask,
+                              std::function<void (std::vector<LocationError> errs)> procImpl ) :
+                              mMsgTask(msgTask), mProcImpl(procImpl) {}
         inline virtual ~LocApiCollectiveResponse() {
         }
 
         void returnToSender(std::vector<LocationError>& errs) {
             mLocationErrors = errs;
-            mContext.sendMsg(this);
+            mMsgTask->sendMsg(this);
         }
 };
 
@@ -359,7 +403,7 @@ struct LocApiCollectiveResponse: LocMsg {
 template <typename DATA>
 struct LocApiResponseData: LocMsg {
     private:
-        ContextBase& mContext;
+        const MsgTask* mMsgTask;
         std::function<void (LocationError err, DATA data)> mProcImpl;
         inline virtual void proc() const {
             mProcImpl(mLocationError, mData);
@@ -370,12 +414,16 @@ struct LocApiResponseData: LocMsg {
     public:
         inline LocApiResponseData(ContextBase& context,
                               std::function<void (LocationError err, DATA data)> procImpl ) :
-                              mContext(context), mProcImpl(procImpl) {}
+                              mMsgTask(context.getMsgTask()), mProcImpl(procImpl) {}
+        // to be returned to the given MsgTask, e.g. the one of an adapter
+        inline LocApiResponseData(const MsgTask* msgTask,
+                              std::function<void (LocationError err, DATA data)> procImpl ) :
+                              mMsgTask(msgTask), mProcImpl(procImpl) {}
 
         void returnToSender(const LocationError err, const DATA data) {
             mLocationError = err;
             mData = data;
-            mContext.sendMsg(this);
+            mMsgTask->sendMsg(this);
         }
 };
 
@@ -38,6 +38,20 @@ namespace loc_core {
 
 using namespace loc_util;
 
+/* Reports of one epoch, handed to the engine hub in a single call: the SV,
+   measurement and polynomial reports received since the previous position,
+   and that position. Members not reported in the epoch are null/0; all
+   pointers are only valid for the duration of the call. */
+struct GnssEpochBundle {
+    const UlpLocation*          location;
+    const GpsLocationExtended*  locationExtended;
+    enum loc_sess_status        status;
+    const GnssSvNotification*   svNotify;
+    const GnssSvMeasurementSet* svMeasurementSet;
+    const GnssSvPolynomial*     svPolynomials;
+    uint32_t                    svPolynomialCount;
+};
+
 class EngineHubProxyBase {
 public:
     inline EngineHubProxyBase() {
@@ -88,6 +102,18 @@ public:
         return false;
     }
 
+    // true if the engine hub takes gnssReportEpochBundle in place of the
+    // gnssReportPosition, gnssReportSv, gnssReportSvMeasurement and
+    // gnssReportSvPolynomial calls
+    inline virtual bool isEpochBundleSupported() {
+        return false;
+    }
+
+    inline virtual bool gnssReportEpochBundle(const GnssEpochBundle& bundle) {
+        (void) bundle;
+        return false;
+    }
+
     inline virtual bool gnssReportSvEphemeris(const GnssSvEphemerisReport& svEphemeris) {
         (void) svEphemeris;
         return false;
@@ -34,6 +34,8 @@
 #include <loc_target.h>
 #include <log_util.h>
 #include <LocAdapterProxyBase.h>
+#include <loc_cfg.h>
+#include <loc_misc_utils.h>
 
 namespace loc_core {
 
@@ -41,13 +43,37 @@ namespace loc_core {
 // always gets called. Here we prepare for the default.
 // But if getLocApi(targetEnumType target) is overriden,
 // the right locApi should get created.
+// slots in the lock-free ring of an adapter's own MsgTask
+#define LOC_ADAPTER_MSG_TASK_RING_SIZE 64
+
+static const MsgTask* getAdapterMsgTask(ContextBase* context, const char* ownMsgTaskName)
+{
+    const MsgTask* msgTask = context->getMsgTask();
+
+    if (NULL != ownMsgTaskName) {
+        uint32_t separateMsgTask = 0;
+        const loc_param_s_type gps_conf_param_table[] =
+        {
+            {"SEPARATE_ADAPTER_MSG_TASK", &separateMsgTask, NULL, 'n'},
+        };
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+
+        if (separateMsgTask) {
+            // like the context MsgTask, it lives as long as the process
+            LOC_LOGd("adapter msg task: %s", ownMsgTaskName);
+            msgTask = new MsgTask(ownMsgTaskName, LOC_ADAPTER_MSG_TASK_RING_SIZE);
+        }
+    }
+    return msgTask;
+}
+
 LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                                ContextBase* context, bool isMaster,
                                LocAdapterProxyBase *adapterProxyBase,
-                               bool waitForDoneInit) :
+                               bool waitForDoneInit, const char* ownMsgTaskName) :
     mIsMaster(isMaster), mEvtMask(mask), mContext(context),
     mLocApi(context->getLocApi()), mLocAdapterProxyBase(adapterProxyBase),
-    mMsgTask(context->getMsgTask()),
+    mMsgTask(getAdapterMsgTask(context, ownMsgTaskName)),
     mIsEngineCapabilitiesKnown(ContextBase::sIsEngineCapabilitiesKnown)
 {
     LOC_LOGd("waitForDoneInit: %d", waitForDoneInit);
@@ -59,14 +85,22 @@ LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
     }
 }
 
-uint32_t LocAdapterBase::mSessionIdCounter(1);
+std::atomic<uint32_t> LocAdapterBase::mSessionIdCounter(1);
+thread_local LocMsgBatch* LocAdapterBase::sMsgBatch = nullptr;
+thread_local LocMsgBatchSet* LocAdapterBase::sMsgBatchSet = nullptr;
 
+// called from the client threads of all adapters, which LocationAPI no
+// longer serializes
 uint32_t LocAdapterBase::generateSessionId()
 {
-    if (++mSessionIdCounter == 0xFFFFFFFF)
-        mSessionIdCounter = 1;
-
-     return mSessionIdCounter;
+    uint32_t sessionId = mSessionIdCounter.load(std::memory_order_relaxed);
+    uint32_t nextId;
+    do {
+        nextId = (sessionId + 1 == 0xFFFFFFFF) ? 1 : sessionId + 1;
+    } while (!mSessionIdCounter.compare_exchange_weak(sessionId, nextId,
+                                                      std::memory_order_relaxed));
+
+    return nextId;
 }
 
 void LocAdapterBase::handleEngineUpEvent()
@@ -78,11 +112,79 @@ void LocAdapterBase::handleEngineUpEvent()
 
 void LocAdapterBase::handleEngineDownEvent()
 {
+    // read in the adapter msgs of the following engine up event
+    mEngineDownTimeMs = getBootTimeMilliSec();
     if (mLocAdapterProxyBase) {
         mLocAdapterProxyBase->handleEngineDownEvent();
     }
 }
 
+void LocAdapterBase::beginReplay()
+{
+    mReplayStartTimeMs = getBootTimeMilliSec();
+    mReplayGeneration++;
+    mReplayPending = 0;
+    mReplaySent = 0;
+    mReplayFailed = 0;
+    mReplayInProgress = true;
+    mReplayAllSent = false;
+}
+
+void LocAdapterBase::endReplay()
+{
+    if (mReplayInProgress) {
+        mReplayAllSent = true;
+        checkReplayComplete();
+    }
+}
+
+void LocAdapterBase::replayRequestSent()
+{
+    if (mReplayInProgress) {
+        mReplayPending++;
+        mReplaySent++;
+    }
+}
+
+void LocAdapterBase::replayResponseReceived(uint32_t generation, LocationError err)
+{
+    // responses of a replay superseded by another engine restart are not counted
+    if (mReplayInProgress && generation == mReplayGeneration && mReplayPending > 0) {
+        mReplayPending--;
+        if (LOCATION_ERROR_SUCCESS != err) {
+            mReplayFailed++;
+        }
+        checkReplayComplete();
+    }
+}
+
+LocApiResponse* LocAdapterBase::newReplayResponse(
+        std::function<void(LocationError err)> callback)
+{
+    replayRequestSent();
+    uint32_t generation = mReplayGeneration;
+    return new LocApiResponse(getMsgTask(),
+            [this, generation, callback] (LocationError err) {
+        if (nullptr != callback) {
+            callback(err);
+        }
+        replayResponseReceived(generation, err);
+    });
+}
+
+void LocAdapterBase::checkReplayComplete()
+{
+    if (mReplayAllSent && 0 == mReplayPending) {
+        uint64_t nowMs = getBootTimeMilliSec();
+        LOC_LOGi("replayed %u requests, %u failed, in %" PRIu64 " ms, "
+                 "%" PRIu64 " ms since engine down",
+                 mReplaySent, mReplayFailed, nowMs - mReplayStartTimeMs,
+                 (0 != mEngineDownTimeMs) ? nowMs - mEngineDownTimeMs : 0);
+        mReplayInProgress = false;
+        mEngineDownTimeMs = 0;
+    }
+}
+
 void LocAdapterBase::
     reportPositionEvent(const UlpLocation& location,
                         const GpsLocationExtended& locationExtended,
@@ -166,7 +268,7 @@ bool LocAdapterBase::
 DEFAULT_IMPL(false)
 
 void LocAdapterBase::
-reportGnssMeasurementsEvent(const GnssMeasurements& /*gnssMeasurements*/,
+reportGnssMeasurementsEvent(const GnssMeasurementsPtr& /*gnssMeasurements*/,
                                    int /*msInWeek*/)
 DEFAULT_IMPL()
 
@@ -223,7 +325,7 @@ LocAdapterBase::geofenceStatusEvent(GeofenceStatusAvailable /*available*/)
 DEFAULT_IMPL()
 
 void
-LocAdapterBase::reportLocationsEvent(const Location* /*locations*/, size_t /*count*/,
+LocAdapterBase::reportLocationsEvent(const BatchedLocationsPtr& /*locations*/,
                                      BatchingMode /*batchingMode*/)
 DEFAULT_IMPL()
 
@@ -33,6 +33,8 @@
 #include <ContextBase.h>
 #include <LocationAPI.h>
 #include <map>
+#include <atomic>
+#include <LocFlatMap.h>
 
 #define MIN_TRACKING_INTERVAL (100) // 100 msec
 
@@ -60,11 +62,27 @@ class LocAdapterProxyBase;
 
 class LocAdapterBase {
 private:
-    static uint32_t mSessionIdCounter;
+    static std::atomic<uint32_t> mSessionIdCounter;
     const bool mIsMaster;
     bool mIsEngineCapabilitiesKnown = false;
+    LocAdapterReportMask mReportMask = LOC_ADAPTER_REPORT_MASK_ALL;
+    /* ==== SSR RECOVERY =================================================================== */
+    uint64_t mEngineDownTimeMs = 0;
+    uint64_t mReplayStartTimeMs = 0;
+    uint32_t mReplayGeneration = 0;
+    uint32_t mReplayPending = 0;
+    uint32_t mReplaySent = 0;
+    uint32_t mReplayFailed = 0;
+    bool mReplayInProgress = false;
+    bool mReplayAllSent = false;
+    void checkReplayComplete();
 
 protected:
+    // the msgs being collected on this thread into a batch, if any; all
+    // adapters post to the same MsgTask, so one batch holds them all
+    static thread_local LocMsgBatch* sMsgBatch;
+    // the same, for msgs of adapters that may run on different MsgTasks
+    static thread_local LocMsgBatchSet* sMsgBatchSet;
     LOC_API_ADAPTER_EVENT_MASK_T mEvtMask;
     ContextBase* mContext;
     LocApiBase* mLocApi;
@@ -76,8 +94,13 @@ protected:
         mIsMaster(false), mEvtMask(0), mContext(NULL), mLocApi(NULL),
         mLocAdapterProxyBase(NULL), mMsgTask(msgTask), mAdapterAdded(false) {}
 
+    // Declares the high rate reports this adapter consumes, all by default.
+    // LocApiBase samples it when the adapter is added, so an adapter has to
+    // set it in its constructor before doneInit().
+    inline void setReportMask(LocAdapterReportMask mask) { mReportMask = mask; }
+
     /* ==== CLIENT ========================================================================= */
-    typedef std::map<LocationAPI*, LocationCallbacks> ClientDataMap;
+    typedef LocFlatMap<LocationAPI*, LocationCallbacks> ClientDataMap;
     ClientDataMap mClientData;
     std::vector<LocMsg*> mPendingMsgs; // For temporal storage of msgs before Open is completed
     /* ======== UTILITIES ================================================================== */
@@ -88,6 +111,20 @@ protected:
     void broadcastCapabilities(LocationCapabilitiesMask mask);
     virtual void updateClientsEventMask();
     virtual void stopClientSessions(LocationAPI* client);
+    /* ======== SSR RECOVERY ====(Called from Adapter MsgTask)============================== */
+    // The adapter state is replayed to the engine when it comes up. Every
+    // replayed request that gets a response between beginReplay() and
+    // endReplay() is counted, and the recovery latency is logged once the
+    // last of their responses is in.
+    void beginReplay();
+    void endReplay();
+    inline bool isReplayInProgress() const { return mReplayInProgress; }
+    void replayRequestSent();
+    void replayResponseReceived(uint32_t generation, LocationError err);
+    inline uint32_t getReplayGeneration() const { return mReplayGeneration; }
+    // a counted response for a replayed request, calling callback if any
+    LocApiResponse* newReplayResponse(
+            std::function<void(LocationError err)> callback = nullptr);
 
 public:
     inline virtual ~LocAdapterBase() { mLocApi->removeAdapter(this); }
@@ -101,10 +138,15 @@ public:
     // waitForDoneInit to *TRUE* to delay handleEngineUpEvent to get called
     // until when the child adapter finishes its initialization and notify
     // LocAdapterBase via doneInit method.
+    //
+    // An adapter passing ownMsgTaskName runs its msgs on a MsgTask of its own
+    // instead of the context MsgTask, when SEPARATE_ADAPTER_MSG_TASK is set in
+    // gps.conf. It then has to direct its LocApiResponses to getMsgTask().
     LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                    ContextBase* context, bool isMaster = false,
                    LocAdapterProxyBase *adapterProxyBase = NULL,
-                   bool waitForDoneInit = false);
+                   bool waitForDoneInit = false,
+                   const char* ownMsgTaskName = NULL);
 
     inline void doneInit() {
         if (!mAdapterAdded) {
@@ -122,12 +164,43 @@ public:
         return mEvtMask;
     }
 
+    inline bool isReportInterested(LocAdapterReportType report) const {
+        return (mReportMask & LOC_ADAPTER_REPORT_BIT(report)) != 0;
+    }
+
+    inline const MsgTask* getMsgTask() const {
+        return mMsgTask;
+    }
+
     inline void sendMsg(const LocMsg* msg) const {
-        mMsgTask->sendMsg(msg);
+        if (nullptr != sMsgBatch) {
+            sMsgBatch->mMsgs.push_back(msg);
+        } else if (nullptr != sMsgBatchSet) {
+            sMsgBatchSet->add(mMsgTask, msg, MSG_TASK_PRIORITY_NORMAL);
+        } else {
+            mMsgTask->sendMsg(msg);
+        }
     }
 
     inline void sendMsg(const LocMsg* msg) {
-        mMsgTask->sendMsg(msg);
+        static_cast<const LocAdapterBase*>(this)->sendMsg(msg);
+    }
+
+    // for time critical msgs that must not queue behind config or logging work
+    inline void sendMsg(const LocMsg* msg, MsgTaskPriority priority) const {
+        if (nullptr != sMsgBatch) {
+            sMsgBatch->mMsgs.push_back(msg);
+        } else if (nullptr != sMsgBatchSet) {
+            sMsgBatchSet->add(mMsgTask, msg, priority);
+        } else {
+            mMsgTask->sendMsg(msg, priority);
+        }
+    }
+
+    // From here to setMsgBatchSet(nullptr), the msgs the adapters send from
+    // the calling thread are collected into batchSet, one batch per MsgTask
+    static inline void setMsgBatchSet(LocMsgBatchSet* batchSet) {
+        sMsgBatchSet = batchSet;
     }
 
     inline void updateEvtMask(LOC_API_ADAPTER_EVENT_MASK_T event,
@@ -199,8 +272,10 @@ public:
                                       const LocInEmergency emergencyState);
     inline virtual bool isInSession() { return false; }
     ContextBase* getContext() const { return mContext; }
-    virtual void reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurements,
-                                                int msInWeek);
+    // The buffer is shared with the other adapters. It may only be annotated
+    // within this call, and may be kept by reference for later processing.
+    virtual void reportGnssMeasurementsEvent(const GnssMeasurementsPtr& gnssMeasurements,
+                                             int msInWeek);
     virtual bool reportWwanZppFix(LocGpsLocation &zppLoc);
     virtual bool reportZppBestAvailableFix(LocGpsLocation &zppLoc,
             GpsLocationExtended &location_extended, LocPosTechMask tech_mask);
@@ -224,7 +299,9 @@ public:
                                      enum loc_sess_status status,
                                      LocPosTechMask loc_technology_mask);
 
-    virtual void reportLocationsEvent(const Location* locations, size_t count,
+    // The buffer is shared with the other adapters, and may be kept by
+    // reference for later processing; it must not be modified.
+    virtual void reportLocationsEvent(const BatchedLocationsPtr& locations,
             BatchingMode batchingMode);
     virtual void reportCompletedTripsEvent(uint32_t accumulated_distance);
     virtual void reportBatchStatusChangeEvent(BatchingStatus batchStatus);
@@ -33,6 +33,7 @@
 #include <inttypes.h>
 #include <gps_extended_c.h>
 #include <LocApiBase.h>
+#include <ReplayLocApi.h>
 #include <LocAdapterBase.h>
 #include <log_util.h>
 #include <LocContext.h>
@@ -42,6 +43,15 @@ namespace loc_core {
 
 #define TO_ALL_LOCADAPTERS(call) TO_ALL_ADAPTERS(mLocAdapters, (call))
 #define TO_1ST_HANDLING_LOCADAPTERS(call) TO_1ST_HANDLING_ADAPTER(mLocAdapters, (call))
+#define TO_REPORT_LOCADAPTERS(report, call)                             \
+    for (LocAdapterBase* const* adapter = mReportAdapters[report];      \
+         NULL != *adapter; adapter++) {                                 \
+        (*adapter)->call;                                               \
+    }
+
+// slots in the lock-free ring of LocApiMsgTask, which carries the QMI
+// indications posted by the modem transport
+#define LOC_API_MSG_TASK_RING_SIZE 256
 
 int hexcode(char *hexstring, int string_size,
             const char *data, int data_size)
@@ -151,6 +161,7 @@ struct LocCloseMsg : public LocMsg {
 
 MsgTask* LocApiBase::mMsgTask = nullptr;
 volatile int32_t LocApiBase::mMsgTaskRefCount = 0;
+thread_local LocMsgBatch* LocApiBase::sMsgBatch = nullptr;
 
 LocApiBase::LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
                        ContextBase* context) :
@@ -158,13 +169,39 @@ LocApiBase::LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
     mMask(0), mExcludedMask(excludedMask)
 {
     memset(mLocAdapters, 0, sizeof(mLocAdapters));
+    memset(mReportAdapters, 0, sizeof(mReportAdapters));
 
     android_atomic_inc(&mMsgTaskRefCount);
     if (nullptr == mMsgTask) {
-        mMsgTask = new MsgTask("LocApiMsgTask");
+        mMsgTask = new MsgTask("LocApiMsgTask", LOC_API_MSG_TASK_RING_SIZE);
     }
 }
 
+void LocApiBase::startMsgBatch()
+{
+    if (nullptr == sMsgBatch) {
+        sMsgBatch = new LocMsgBatch();
+    }
+}
+
+void LocApiBase::sendMsgBatch()
+{
+    LocMsgBatch* batch = sMsgBatch;
+    sMsgBatch = nullptr;
+    if (nullptr != batch) {
+        if (batch->mMsgs.empty()) {
+            delete batch;
+        } else {
+            sendMsg(batch);
+        }
+    }
+}
+
+void LocApiBase::startCapture(const char* path)
+{
+    mCapture.reset(LocApiCapture::create(path));
+}
+
 LOC_API_ADAPTER_EVENT_MASK_T LocApiBase::getEvtMask()
 {
     LOC_API_ADAPTER_EVENT_MASK_T mask = 0;
@@ -233,6 +270,7 @@ void LocApiBase::addAdapter(LocAdapterBase* adapter)
     for (int i = 0; i < MAX_ADAPTERS && mLocAdapters[i] != adapter; i++) {
         if (mLocAdapters[i] == NULL) {
             mLocAdapters[i] = adapter;
+            updateReportAdapters();
             sendMsg(new LocOpenMsg(this,  adapter));
             break;
         }
@@ -263,6 +301,7 @@ void LocApiBase::removeAdapter(LocAdapterBase* adapter)
             mLocAdapters[j] = mLocAdapters[i];
             // this makes sure that we exit the for loop
             mLocAdapters[i] = NULL;
+            updateReportAdapters();
 
             // if we have an empty list of adapters
             if (0 == i) {
@@ -275,6 +314,19 @@ void LocApiBase::removeAdapter(LocAdapterBase* adapter)
     }
 }
 
+void LocApiBase::updateReportAdapters()
+{
+    for (int report = 0; report < LOC_ADAPTER_REPORT_MAX; report++) {
+        int count = 0;
+        for (int i = 0; i < MAX_ADAPTERS && NULL != mLocAdapters[i]; i++) {
+            if (mLocAdapters[i]->isReportInterested((LocAdapterReportType)report)) {
+                mReportAdapters[report][count++] = mLocAdapters[i];
+            }
+        }
+        mReportAdapters[report][count] = NULL;
+    }
+}
+
 void LocApiBase::updateEvtMask()
 {
     sendMsg(new LocOpenMsg(this));
@@ -343,11 +395,20 @@ void LocApiBase::reportPosition(UlpLocation& location,
              locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.navic_sv_used_ids_mask);
+    if (nullptr != mCapture) {
+        std::unique_ptr<LocApiCapturePosition> position(new LocApiCapturePosition());
+        position->location = location;
+        position->locationExtended = locationExtended;
+        position->status = status;
+        position->techMask = loc_technology_mask;
+        position->msInWeek = msInWeek;
+        mCapture->write(LOC_API_CAPTURE_POSITION, position.get(), sizeof(*position));
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportPositionEvent(location, locationExtended,
-                                             status, loc_technology_mask,
-                                             pDataNotify, msInWeek)
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_POSITION,
+        reportPositionEvent(location, locationExtended,
+                            status, loc_technology_mask,
+                            pDataNotify, msInWeek)
     );
 }
 
@@ -430,30 +491,37 @@ void LocApiBase::reportSv(GnssSvNotification& svNotify)
             svNotify.gnssSvs[i].gnssSvOptionsMask,
             svNotify.gnssSvs[i].gnssSignalTypeMask);
     }
+    if (nullptr != mCapture) {
+        mCapture->write(LOC_API_CAPTURE_SV, &svNotify, sizeof(svNotify));
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportSvEvent(svNotify)
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_SV,
+        reportSvEvent(svNotify)
         );
 }
 
 void LocApiBase::reportSvPolynomial(GnssSvPolynomial &svPolynomial)
 {
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportSvPolynomialEvent(svPolynomial)
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_SV_POLYNOMIAL,
+        reportSvPolynomialEvent(svPolynomial)
     );
 }
 
 void LocApiBase::reportSvEphemeris(GnssSvEphemerisReport & svEphemeris)
 {
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportSvEphemerisEvent(svEphemeris)
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_SV_EPHEMERIS,
+        reportSvEphemerisEvent(svEphemeris)
     );
 }
 
 void LocApiBase::reportStatus(LocGpsStatusValue status)
 {
+    if (nullptr != mCapture) {
+        uint32_t value = status;
+        mCapture->write(LOC_API_CAPTURE_STATUS, &value, sizeof(value));
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportStatus(status));
 }
@@ -461,13 +529,16 @@ void LocApiBase::reportStatus(LocGpsStatusValue status)
 void LocApiBase::reportData(GnssDataNotification& dataNotify, int msInWeek)
 {
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportDataEvent(dataNotify, msInWeek));
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_DATA, reportDataEvent(dataNotify, msInWeek));
 }
 
 void LocApiBase::reportNmea(const char* nmea, int length)
 {
+    if (nullptr != mCapture && length > 0) {
+        mCapture->write(LOC_API_CAPTURE_NMEA, nmea, length);
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportNmeaEvent(nmea, length));
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_NMEA, reportNmeaEvent(nmea, length));
 }
 
 void LocApiBase::reportXtraServer(const char* url1, const char* url2,
@@ -542,8 +613,29 @@ LocApiProxyBase* LocApiBase :: getLocApiProxy()
 
 void LocApiBase::reportGnssMeasurements(GnssMeasurements& gnssMeasurements, int msInWeek)
 {
+    GnssMeasurementsPtr measurements(mGnssMeasurementsPool.acquire());
+    if (nullptr == measurements) {
+        LOC_LOGe("Failed to allocate GnssMeasurements");
+    } else {
+        *measurements = gnssMeasurements;
+        reportGnssMeasurements(measurements, msInWeek);
+    }
+}
+
+void LocApiBase::reportGnssMeasurements(const GnssMeasurementsPtr& gnssMeasurements,
+                                        int msInWeek)
+{
+    if (nullptr != mCapture) {
+        std::unique_ptr<LocApiCaptureMeasurements> measurements(
+                new LocApiCaptureMeasurements());
+        measurements->measurements = *gnssMeasurements;
+        measurements->msInWeek = msInWeek;
+        mCapture->write(LOC_API_CAPTURE_MEASUREMENTS, measurements.get(),
+                        sizeof(*measurements));
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportGnssMeasurementsEvent(gnssMeasurements, msInWeek));
+    TO_REPORT_LOCADAPTERS(LOC_ADAPTER_REPORT_MEASUREMENTS,
+                          reportGnssMeasurementsEvent(gnssMeasurements, msInWeek));
 }
 
 void LocApiBase::reportGnssSvIdConfig(const GnssSvIdConfig& config)
@@ -590,7 +682,21 @@ void LocApiBase::reportDBTPosition(UlpLocation &location, GpsLocationExtended &l
 
 void LocApiBase::reportLocations(Location* locations, size_t count, BatchingMode batchingMode)
 {
-    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportLocationsEvent(locations, count, batchingMode));
+    BatchedLocationsPtr batchedLocations(mBatchedLocationsPool.acquire());
+    if (nullptr == batchedLocations) {
+        LOC_LOGe("Failed to allocate batched locations");
+    } else {
+        if (nullptr == locations) {
+            count = 0;
+        }
+        batchedLocations->assign(locations, locations + count);
+        reportLocations(batchedLocations, batchingMode);
+    }
+}
+
+void LocApiBase::reportLocations(const BatchedLocationsPtr& locations, BatchingMode batchingMode)
+{
+    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportLocationsEvent(locations, batchingMode));
 }
 
 void LocApiBase::reportCompletedTrips(uint32_t accumulated_distance)
@@ -615,6 +721,40 @@ void LocApiBase::reportLatencyInfo(GnssLatencyInfo& gnssLatencyInfo)
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportLatencyInfoEvent(gnssLatencyInfo));
 }
 
+void LocApiBase::reportEpochBundle(LocApiEpochBundle& bundle)
+{
+    LOC_LOGv("gpsTowMs: %d positions: %zu sv: %d meas: %d data: %zu nmea: %zu latency: %d",
+             bundle.gpsTowMs, bundle.positions.size(), bundle.hasSv,
+             nullptr != bundle.measurements, bundle.data.size(), bundle.nmea.size(),
+             bundle.hasLatencyInfo);
+
+    LocMsgBatchSet batchSet;
+    LocAdapterBase::setMsgBatchSet(&batchSet);
+    if (nullptr != bundle.measurements) {
+        reportGnssMeasurements(bundle.measurements, bundle.measurementsMsInWeek);
+    }
+    if (bundle.hasLatencyInfo) {
+        reportLatencyInfo(bundle.latencyInfo);
+    }
+    if (bundle.hasSv) {
+        reportSv(bundle.svNotify);
+    }
+    for (auto& nmea : bundle.nmea) {
+        reportNmea(nmea.c_str(), nmea.length());
+    }
+    for (auto& data : bundle.data) {
+        reportData(data.dataNotify, data.msInWeek);
+    }
+    for (auto& position : bundle.positions) {
+        reportPosition(position.location, position.locationExtended,
+                       position.status, position.techMask,
+                       position.hasDataNotify ? &position.dataNotify : nullptr,
+                       position.msInWeek);
+    }
+    LocAdapterBase::setMsgBatchSet(nullptr);
+    batchSet.send();
+}
+
 enum loc_api_adapter_err LocApiBase::
    open(LOC_API_ADAPTER_EVENT_MASK_T /*mask*/)
 DEFAULT_IMPL(LOC_API_ADAPTER_ERR_SUCCESS)
@@ -723,6 +863,40 @@ LocationError LocApiBase::
     setLPPeProtocolUpSync(GnssConfigLppeUserPlaneMask /*lppeUP*/)
 DEFAULT_IMPL(LOCATION_ERROR_SUCCESS)
 
+LocationError LocApiBase::
+    setProtocolConfigSync(const GnssConfig& gnssConfig, GnssConfigFlagsMask& failedFlags)
+{
+    // without a single request for them, set the parameters one by one
+    failedFlags = 0;
+    if ((gnssConfig.flags & GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) &&
+            LOCATION_ERROR_SUCCESS != setSUPLVersionSync(gnssConfig.suplVersion)) {
+        failedFlags |= GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT;
+    }
+    if ((gnssConfig.flags & GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) &&
+            LOCATION_ERROR_SUCCESS != setLPPConfigSync(gnssConfig.lppProfileMask)) {
+        failedFlags |= GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT;
+    }
+    if ((gnssConfig.flags & GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) &&
+            LOCATION_ERROR_SUCCESS != setLPPeProtocolCpSync(gnssConfig.lppeControlPlaneMask)) {
+        failedFlags |= GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT;
+    }
+    if ((gnssConfig.flags & GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) &&
+            LOCATION_ERROR_SUCCESS != setLPPeProtocolUpSync(gnssConfig.lppeUserPlaneMask)) {
+        failedFlags |= GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT;
+    }
+    if ((gnssConfig.flags & GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) &&
+            LOCATION_ERROR_SUCCESS !=
+            setAGLONASSProtocolSync(gnssConfig.aGlonassPositionProtocolMask)) {
+        failedFlags |= GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT;
+    }
+    if ((gnssConfig.flags & GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) &&
+            LOCATION_ERROR_SUCCESS !=
+            setEmergencyExtensionWindowSync(gnssConfig.emergencyExtensionSeconds)) {
+        failedFlags |= GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT;
+    }
+    return (0 == failedFlags) ? LOCATION_ERROR_SUCCESS : LOCATION_ERROR_GENERAL_FAILURE;
+}
+
 GnssConfigSuplVersion LocApiBase::convertSuplVersion(const uint32_t /*suplVersion*/)
 DEFAULT_IMPL(GNSS_CONFIG_SUPL_VERSION_1_0_0)
 
@@ -929,6 +1103,11 @@ void LocApiBase::
     getConstellationMultiBandConfig(uint32_t sessionId, LocApiResponse* /*adapterResponse*/)
 DEFAULT_IMPL()
 
+bool LocApiBase::
+    getSvEphemeris(Gnss_LocSvSystemEnumType /*constellation*/,
+                   GnssSvEphemerisReport& /*svEphemeris*/)
+DEFAULT_IMPL(false)
+
 int64_t ElapsedRealtimeEstimator::getElapsedRealtimeEstimateNanos(int64_t curDataTimeNanos,
             bool isCurDataTimeTrustable, int64_t tbf) {
     //The algorithm works follow below steps:
@@ -990,39 +1169,30 @@ void ElapsedRealtimeEstimator::reset() {
 }
 
 int64_t ElapsedRealtimeEstimator::getElapsedRealtimeQtimer(int64_t qtimerTicksAtOrigin) {
-    struct timespec currentTime;
-    int64_t sinceBootTimeNanos;
-    int64_t elapsedRealTimeNanos;
+    int64_t elapsedRealTimeNanos = getBootTimeNanosFromQTimer(qtimerTicksAtOrigin);
 
-    if (getCurrentTime(currentTime, sinceBootTimeNanos)) {
-       uint64_t qtimerDiff = 0;
-       uint64_t qTimerTickCount = getQTimerTickCount();
-       if (qTimerTickCount >= qtimerTicksAtOrigin) {
-           qtimerDiff = qTimerTickCount - qtimerTicksAtOrigin;
-       }
-       LOC_LOGd("sinceBootTimeNanos:%" PRIi64 " qtimerTicksAtOrigin=%" PRIi64 ""
-                " qTimerTickCount=%" PRIi64 " qtimerDiff=%" PRIi64 "",
-                sinceBootTimeNanos, qtimerTicksAtOrigin, qTimerTickCount, qtimerDiff);
-       uint64_t qTimerDiffNanos = qTimerTicksToNanos(double(qtimerDiff));
-
-       /* If the time difference between Qtimer on modem side and Qtimer on AP side
-          is greater than one second we assume this is a dual-SoC device such as
-          Kona and will try to get Qtimer on modem side and on AP side and
-          will adjust our difference accordingly */
-       if (qTimerDiffNanos > 1000000000) {
-           uint64_t qtimerDelta = getQTimerDeltaNanos();
-           if (qTimerDiffNanos >= qtimerDelta) {
-               qTimerDiffNanos -= qtimerDelta;
-           }
-       }
-
-       LOC_LOGd("Qtimer travel time: %" PRIi64 "", qTimerDiffNanos);
-       if (sinceBootTimeNanos >= qTimerDiffNanos) {
-           elapsedRealTimeNanos = sinceBootTimeNanos - qTimerDiffNanos;
-       } else {
-           elapsedRealTimeNanos = -1;
-       }
-    } else {
+    uint64_t qtimerDiff = 0;
+    uint64_t qTimerTickCount = getQTimerTickCount();
+    if (qTimerTickCount >= qtimerTicksAtOrigin) {
+        qtimerDiff = qTimerTickCount - qtimerTicksAtOrigin;
+    }
+    uint64_t qTimerDiffNanos = qTimerTicksToNanos(double(qtimerDiff));
+    LOC_LOGd("qtimerTicksAtOrigin=%" PRIi64 " qTimerTickCount=%" PRIi64 ""
+             " qtimerDiff=%" PRIi64 " bootTimeAtOrigin=%" PRIi64 "",
+             qtimerTicksAtOrigin, qTimerTickCount, qtimerDiff, elapsedRealTimeNanos);
+
+    /* If the time difference between Qtimer on modem side and Qtimer on AP side
+       is greater than one second we assume this is a dual-SoC device such as
+       Kona and will try to get Qtimer on modem side and on AP side and
+       will adjust our difference accordingly */
+    if (qTimerDiffNanos > 1000000000) {
+        uint64_t qtimerDelta = getQTimerDeltaNanos();
+        if (qTimerDiffNanos >= qtimerDelta) {
+            elapsedRealTimeNanos += qtimerDelta;
+        }
+    }
+
+    if (elapsedRealTimeNanos < 0) {
         elapsedRealTimeNanos = -1;
     }
     return elapsedRealTimeNanos;
@@ -35,6 +35,7 @@
 #include <LocationAPI.h>
 #include <MsgTask.h>
 #include <LocSharedLock.h>
+#include <LocBufferPool.h>
 #include <log_util.h>
 #ifdef NO_UNORDERED_SET_OR_MAP
     #include <map>
@@ -43,6 +44,9 @@
 #endif
 #include <inttypes.h>
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 using namespace loc_util;
 
@@ -50,6 +54,7 @@ namespace loc_core {
 
 class ContextBase;
 struct LocApiResponse;
+class LocApiCapture;
 template <typename> struct LocApiResponseData;
 
 int hexcode(char *hexstring, int string_size,
@@ -68,6 +73,65 @@ int decodeAddress(char *addr_string, int string_size,
 #define TO_1ST_HANDLING_ADAPTER(adapters, call)                              \
     for (int i = 0; i <MAX_ADAPTERS && NULL != (adapters)[i] && !(call); i++);
 
+// High rate reports, which LocApiBase only fans out to the adapters
+// that declared interest in them, see LocAdapterBase::setReportMask()
+typedef enum {
+    LOC_ADAPTER_REPORT_POSITION = 0,
+    LOC_ADAPTER_REPORT_SV,
+    LOC_ADAPTER_REPORT_SV_POLYNOMIAL,
+    LOC_ADAPTER_REPORT_SV_EPHEMERIS,
+    LOC_ADAPTER_REPORT_DATA,
+    LOC_ADAPTER_REPORT_NMEA,
+    LOC_ADAPTER_REPORT_MEASUREMENTS,
+    LOC_ADAPTER_REPORT_MAX
+} LocAdapterReportType;
+
+// Measurement report shared by LocApi and the adapters without copying,
+// see LocApiBase::reportGnssMeasurements()
+typedef std::shared_ptr<GnssMeasurements> GnssMeasurementsPtr;
+// Batched locations, oldest first, shared the same way,
+// see LocApiBase::reportLocations()
+typedef std::shared_ptr<std::vector<Location>> BatchedLocationsPtr;
+
+typedef uint32_t LocAdapterReportMask;
+#define LOC_ADAPTER_REPORT_BIT(type)    ((LocAdapterReportMask)1 << (type))
+#define LOC_ADAPTER_REPORT_MASK_ALL     (LOC_ADAPTER_REPORT_BIT(LOC_ADAPTER_REPORT_MAX) - 1)
+
+// The reports of one GNSS epoch, gathered by the LocApi as they come in
+// and then delivered together, see LocApiBase::reportEpochBundle()
+struct LocApiEpochBundle {
+    struct Position {
+        UlpLocation location;
+        GpsLocationExtended locationExtended;
+        enum loc_sess_status status;
+        LocPosTechMask techMask;
+        bool hasDataNotify;
+        GnssDataNotification dataNotify;
+        int msInWeek;
+    };
+    struct Data {
+        GnssDataNotification dataNotify;
+        int msInWeek;
+    };
+    // GPS time of week of the epoch, -1 until a report that has one joins
+    int gpsTowMs = -1;
+    // propagated and unpropagated fixes, in the order they came in
+    std::vector<Position> positions;
+    bool hasSv = false;
+    GnssSvNotification svNotify;
+    GnssMeasurementsPtr measurements;
+    int measurementsMsInWeek = -1;
+    std::vector<Data> data;
+    std::vector<std::string> nmea;
+    bool hasLatencyInfo = false;
+    GnssLatencyInfo latencyInfo;
+
+    inline bool empty() const {
+        return positions.empty() && !hasSv && nullptr == measurements &&
+                data.empty() && nmea.empty() && !hasLatencyInfo;
+    }
+};
+
 class LocAdapterBase;
 struct LocSsrMsg;
 struct LocOpenMsg;
@@ -115,6 +179,13 @@ class LocApiBase {
     static MsgTask* mMsgTask;
     static volatile int32_t mMsgTaskRefCount;
     LocAdapterBase* mLocAdapters[MAX_ADAPTERS];
+    // per LocAdapterReportType, the NULL terminated list of interested adapters
+    LocAdapterBase* mReportAdapters[LOC_ADAPTER_REPORT_MAX][MAX_ADAPTERS + 1];
+    void updateReportAdapters();
+    // with gps.conf LOC_API_CAPTURE_FILE, where the reports are captured
+    // for a ReplayLocApi to replay
+    std::shared_ptr<LocApiCapture> mCapture;
+    void startCapture(const char* path);
 
 protected:
     ContextBase *mContext;
@@ -136,14 +207,28 @@ protected:
     }
     bool isInSession();
     const LOC_API_ADAPTER_EVENT_MASK_T mExcludedMask;
+    // GnssMeasurements buffers, filled in place and then shared with the adapters
+    LocBufferPool<GnssMeasurements> mGnssMeasurementsPool;
+    // batched location buffers, read from the engine in place and then shared
+    LocBufferPool<std::vector<Location>> mBatchedLocationsPool;
     bool isMaster();
 
+    // the msgs being collected by startMsgBatch() on this thread, if any
+    static thread_local LocMsgBatch* sMsgBatch;
+
 public:
     inline void sendMsg(const LocMsg* msg) const {
-        if (nullptr != mMsgTask) {
+        if (nullptr != sMsgBatch) {
+            sMsgBatch->mMsgs.push_back(msg);
+        } else if (nullptr != mMsgTask) {
             mMsgTask->sendMsg(msg);
         }
     }
+    // From here to sendMsgBatch(), the msgs sent to the LocApi thread from
+    // the calling thread are held back, and then sent on as one msg, for
+    // their modem requests to go out back to back
+    void startMsgBatch();
+    void sendMsgBatch();
     inline void destroy() {
         close();
         struct LocKillMsg : public LocMsg {
@@ -190,6 +275,9 @@ public:
     void requestNiNotify(GnssNiNotification &notify, const void* data,
                          const LocInEmergency emergencyState);
     void reportGnssMeasurements(GnssMeasurements& gnssMeasurements, int msInWeek);
+    // Adapters may keep a reference of the buffer, so it must not be
+    // modified after this call; acquire a new one from mGnssMeasurementsPool.
+    void reportGnssMeasurements(const GnssMeasurementsPtr& gnssMeasurements, int msInWeek);
     void reportWwanZppFix(LocGpsLocation &zppLoc);
     void reportZppBestAvailableFix(LocGpsLocation &zppLoc, GpsLocationExtended &location_extended,
             LocPosTechMask tech_mask);
@@ -203,6 +291,10 @@ public:
     void sendNfwNotification(GnssNfwNotification& notification);
     void reportGnssConfig(uint32_t sessionId, const GnssConfig& gnssConfig);
     void reportLatencyInfo(GnssLatencyInfo& gnssLatencyInfo);
+    // Delivers the reports of the bundle as the report calls above would, in
+    // the order measurements, latency, SV, NMEA, data, positions, except
+    // that each MsgTask gets the msgs of all its adapters for them as one.
+    void reportEpochBundle(LocApiEpochBundle& bundle);
     void reportQwesCapabilities
     (
         const std::unordered_map<LocationQwesFeatureType, bool> &featureMap
@@ -216,6 +308,9 @@ public:
                            enum loc_sess_status status,
                            LocPosTechMask loc_technology_mask);
     void reportLocations(Location* locations, size_t count, BatchingMode batchingMode);
+    // Adapters may keep a reference of the buffer, so it must not be
+    // modified after this call; acquire a new one from mBatchedLocationsPool.
+    void reportLocations(const BatchedLocationsPtr& locations, BatchingMode batchingMode);
     void reportCompletedTrips(uint32_t accumulated_distance);
     void handleBatchStatusEvent(BatchingStatus batchStatus);
 
@@ -254,6 +349,10 @@ public:
             setAGLONASSProtocolSync(GnssConfigAGlonassPositionProtocolMask aGlonassProtocol);
     virtual LocationError setLPPeProtocolCpSync(GnssConfigLppeControlPlaneMask lppeCP);
     virtual LocationError setLPPeProtocolUpSync(GnssConfigLppeUserPlaneMask lppeUP);
+    /* sets the SUPL version, LPP, LPPe, A-GLONASS and emergency extension
+       window parameters valid in gnssConfig, failedFlags returns those failed */
+    virtual LocationError setProtocolConfigSync(const GnssConfig& gnssConfig,
+                                                GnssConfigFlagsMask& failedFlags);
     virtual GnssConfigSuplVersion convertSuplVersion(const uint32_t suplVersion);
     virtual GnssConfigLppeControlPlaneMask convertLppeCp(const uint32_t lppeControlPlaneMask);
     virtual GnssConfigLppeUserPlaneMask convertLppeUp(const uint32_t lppeUserPlaneMask);
@@ -345,6 +444,12 @@ public:
                                               LocApiResponse* adapterResponse=nullptr);
     virtual void getConstellationMultiBandConfig(uint32_t sessionId,
                                         LocApiResponse* adapterResponse=nullptr);
+
+    // Fills svEphemeris with the latest ephemeris reported for each SV of
+    // the constellation, without a request to the engine. Can be called
+    // from any thread; returns false if no ephemeris is kept.
+    virtual bool getSvEphemeris(Gnss_LocSvSystemEnumType constellation,
+                                GnssSvEphemerisReport& svEphemeris);
 };
 
 class ElapsedRealtimeEstimator {
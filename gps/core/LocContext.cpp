@@ -50,10 +50,18 @@ const char* LocContext::mLBSLibName = "liblbs_core.so.1";
 
 pthread_mutex_t LocContext::mGetLocContextMutex = PTHREAD_MUTEX_INITIALIZER;
 
+// slots in the lock-free ring of the hal worker MsgTask, enough to absorb
+// a batch of location reports plus the sv / measurement reports of an epoch
+#define LOC_HAL_WORKER_RING_SIZE 256
+// most msgs the hal worker takes off its queue per round, e.g. a batch
+// full indication followed by its reportLocationsEvent posts
+#define LOC_HAL_WORKER_MAX_DRAIN_BATCH 32
+
 const MsgTask* LocContext::getMsgTask(const char* name)
 {
     if (NULL == mMsgTask) {
-        mMsgTask = new MsgTask(name);
+        mMsgTask = new MsgTask(name, LOC_HAL_WORKER_RING_SIZE);
+        mMsgTask->setBatchDrain(LOC_HAL_WORKER_MAX_DRAIN_BATCH);
     }
     return mMsgTask;
 }
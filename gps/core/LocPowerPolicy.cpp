@@ -0,0 +1,136 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_PowerPolicy"
+
+#include <algorithm>
+#include <LocPowerPolicy.h>
+#include <ContextBase.h>
+#include <DataItemId.h>
+#include <DataItemConcreteTypesBase.h>
+#include <loc_pla.h>
+#include <log_util.h>
+
+namespace loc_core {
+
+LocPowerPolicy::LocPowerPolicy(IOsObserver* sysStatObs, const char* name,
+                               ProfileCb profileCb) :
+    mSystemStatusObsrvr(nullptr),
+    mName(name),
+    mProfileCb(profileCb),
+    mCharging(true),
+    mScreenOn(true),
+    mSuspended(false),
+    mReduced(false)
+{
+    if (0 != ContextBase::mGps_conf.POWER_POLICY_ENABLED && nullptr != sysStatObs) {
+        mSystemStatusObsrvr = sysStatObs;
+        list<DataItemId> subItemIdList = {POWER_CONNECTED_STATE_DATA_ITEM_ID,
+                                          SCREEN_STATE_DATA_ITEM_ID};
+        mSystemStatusObsrvr->subscribe(subItemIdList, this);
+    }
+}
+
+LocPowerPolicy::~LocPowerPolicy()
+{
+    if (nullptr != mSystemStatusObsrvr) {
+        list<DataItemId> subItemIdList = {POWER_CONNECTED_STATE_DATA_ITEM_ID,
+                                          SCREEN_STATE_DATA_ITEM_ID};
+        mSystemStatusObsrvr->unsubscribe(subItemIdList, this);
+        mSystemStatusObsrvr = nullptr;
+    }
+}
+
+LocPowerProfile LocPowerPolicy::fullProfile()
+{
+    LocPowerProfile profile = {false, true, 1, 1, 1};
+    return profile;
+}
+
+void LocPowerPolicy::getName(string& name)
+{
+    name = mName;
+}
+
+void LocPowerPolicy::notify(const list<IDataItemCore*>& dlist)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto each : dlist) {
+        switch (each->getId()) {
+            case POWER_CONNECTED_STATE_DATA_ITEM_ID:
+                mCharging = static_cast<PowerConnectStateDataItemBase*>(each)->mState;
+                break;
+            case SCREEN_STATE_DATA_ITEM_ID:
+                mScreenOn = static_cast<ScreenStateDataItemBase*>(each)->mState;
+                break;
+            default:
+                break;
+        }
+    }
+    evaluate();
+}
+
+void LocPowerPolicy::updateSystemPowerState(PowerStateType systemPowerState)
+{
+    if (nullptr == mSystemStatusObsrvr || POWER_STATE_UNKNOWN == systemPowerState) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSuspended = (POWER_STATE_SUSPEND == systemPowerState);
+    evaluate();
+}
+
+// called with mMutex held, so the profiles are posted in the order decided
+void LocPowerPolicy::evaluate()
+{
+    bool reduced = !mCharging && (!mScreenOn || mSuspended);
+    if (reduced == mReduced) {
+        return;
+    }
+    mReduced = reduced;
+
+    LocPowerProfile profile = fullProfile();
+    if (reduced) {
+        const loc_gps_cfg_s_type& conf = ContextBase::mGps_conf;
+        profile.reduced = true;
+        profile.nmeaEnabled = (0 != conf.POWER_POLICY_REDUCED_NMEA_ENABLED);
+        profile.svDecimation = std::max(1u, conf.POWER_POLICY_REDUCED_SV_DECIMATION);
+        profile.measurementsDecimation =
+                std::max(1u, conf.POWER_POLICY_REDUCED_MEAS_DECIMATION);
+        profile.geofenceResponsivenessScale =
+                std::max(1u, conf.POWER_POLICY_REDUCED_GEOFENCE_SCALE);
+    }
+    LOC_LOGi("%s: %s profile, charging %d screen on %d suspended %d", mName.c_str(),
+             reduced ? "reduced" : "full", mCharging, mScreenOn, mSuspended);
+    if (nullptr != mProfileCb) {
+        mProfileCb(profile);
+    }
+}
+
+} // namespace loc_core
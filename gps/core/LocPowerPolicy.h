@@ -0,0 +1,88 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_POWER_POLICY_H__
+#define __LOC_POWER_POLICY_H__
+
+#include <stdint.h>
+#include <mutex>
+#include <functional>
+#include <gps_extended_c.h>
+#include <IDataItemObserver.h>
+#include <IOsObserver.h>
+
+namespace loc_core {
+
+/* How much of its reporting work an adapter keeps. Decimations of 1 and
+   a scale of 1 leave the reports as the clients asked for them. */
+typedef struct {
+    bool reduced;
+    bool nmeaEnabled;                      // NMEA generated on the AP
+    uint32_t svDecimation;                 // one SV report out of this many
+    uint32_t measurementsDecimation;       // one measurements report out of this many
+    uint32_t geofenceResponsivenessScale;  // engine responsiveness multiplied by this
+} LocPowerProfile;
+
+/* Maps the charging, screen and system power state to the profile the
+   adapters apply, in the REDUCED form of gps.conf POWER_POLICY_* while
+   the device is on battery with the screen off or suspended, and in full
+   otherwise. The callback is invoked on each change, from the OS observer
+   thread or from the caller of updateSystemPowerState(), so it is only to
+   post the profile to the adapter's own thread. Without
+   POWER_POLICY_ENABLED it never fires. */
+class LocPowerPolicy : public IDataItemObserver {
+public:
+    typedef std::function<void(const LocPowerProfile& profile)> ProfileCb;
+
+    LocPowerPolicy(IOsObserver* sysStatObs, const char* name, ProfileCb profileCb);
+    virtual ~LocPowerPolicy();
+
+    void updateSystemPowerState(PowerStateType systemPowerState);
+    static LocPowerProfile fullProfile();
+
+    // IDataItemObserver overrides
+    virtual void notify(const list<IDataItemCore*>& dlist);
+    virtual void getName(string& name);
+
+private:
+    void evaluate();
+
+    IOsObserver* mSystemStatusObsrvr;
+    string mName;
+    ProfileCb mProfileCb;
+    std::mutex mMutex;
+    // until told otherwise, as if on the charger with the screen on
+    bool mCharging;
+    bool mScreenOn;
+    bool mSuspended;
+    bool mReduced;
+};
+
+} // namespace loc_core
+
+#endif // __LOC_POWER_POLICY_H__
@@ -0,0 +1,317 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_ReplayLocApi"
+
+#include <errno.h>
+#include <string.h>
+#include <inttypes.h>
+#include <vector>
+#include <ReplayLocApi.h>
+#include <ContextBase.h>
+#include <loc_pla.h>
+#include <log_util.h>
+
+/* no single report comes anywhere near this, so a bigger record
+   means the capture is corrupt */
+#define LOC_API_CAPTURE_MAX_RECORD_LENGTH (1024 * 1024)
+
+using namespace std::chrono;
+
+namespace loc_core {
+
+static inline uint64_t steadyNowNs()
+{
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void fillCaptureHeader(LocApiCaptureHeader& header)
+{
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOC_API_CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = LOC_API_CAPTURE_VERSION;
+    header.ulpLocationSize = sizeof(UlpLocation);
+    header.locationExtendedSize = sizeof(GpsLocationExtended);
+    header.svNotificationSize = sizeof(GnssSvNotification);
+    header.measurementsSize = sizeof(GnssMeasurements);
+}
+
+LocApiCapture* LocApiCapture::create(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if (nullptr == file) {
+        LOC_LOGe("cannot create capture file %s, errno %d", path, errno);
+        return nullptr;
+    }
+
+    LocApiCaptureHeader header;
+    fillCaptureHeader(header);
+    if (1 != fwrite(&header, sizeof(header), 1, file)) {
+        LOC_LOGe("cannot write capture file %s, errno %d", path, errno);
+        fclose(file);
+        return nullptr;
+    }
+    LOC_LOGi("capturing engine reports to %s", path);
+    return new LocApiCapture(file);
+}
+
+LocApiCapture::~LocApiCapture()
+{
+    fclose(mFile);
+}
+
+void LocApiCapture::write(LocApiCaptureRecordType type, const void* payload, uint32_t length)
+{
+    uint64_t nowNs = steadyNowNs();
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (0 == mStartNs) {
+        mStartNs = nowNs;
+    }
+    LocApiCaptureRecord record = {(uint32_t)type, length, nowNs - mStartNs};
+    // the file is flushed per record, so the capture survives the process
+    // being killed while it is still being written
+    if (1 != fwrite(&record, sizeof(record), 1, mFile) ||
+        (length > 0 && 1 != fwrite(payload, length, 1, mFile)) ||
+        0 != fflush(mFile)) {
+        LOC_LOGw("failed to capture a report of type %u, errno %d", type, errno);
+    }
+}
+
+ReplayLocApi::ReplayLocApi(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
+                           ContextBase* context, const char* replayFile,
+                           uint32_t speed, bool loop) :
+    LocApiBase(excludedMask, context),
+    mReplayFile(replayFile),
+    mSpeed(speed),
+    mLoop(loop),
+    mStopping(false),
+    mDone(true)
+{
+}
+
+ReplayLocApi::~ReplayLocApi()
+{
+    stopReplay();
+}
+
+enum loc_api_adapter_err ReplayLocApi::open(LOC_API_ADAPTER_EVENT_MASK_T mask)
+{
+    mMask = mask;
+    // as if the engine had measurements and nothing else to report
+    if (nullptr != mContext) {
+        mContext->setEngineCapabilities(0, nullptr, true);
+    }
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err ReplayLocApi::close()
+{
+    stopReplay();
+    mMask = 0;
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+void ReplayLocApi::startFix(const LocPosMode& /*fixCriteria*/, LocApiResponse* adapterResponse)
+{
+    startReplay();
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    }
+}
+
+void ReplayLocApi::stopFix(LocApiResponse* adapterResponse)
+{
+    stopReplay();
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    }
+}
+
+void ReplayLocApi::startTimeBasedTracking(const TrackingOptions& /*options*/,
+                                          LocApiResponse* adapterResponse)
+{
+    startReplay();
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    }
+}
+
+void ReplayLocApi::stopTimeBasedTracking(LocApiResponse* adapterResponse)
+{
+    stopReplay();
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    }
+}
+
+void ReplayLocApi::startReplay()
+{
+    {
+        // a session being updated keeps the replay it already has going
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mDone) {
+            return;
+        }
+    }
+    stopReplay();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = false;
+    mDone = false;
+    mThread = std::thread(&ReplayLocApi::replay, this);
+}
+
+void ReplayLocApi::stopReplay()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCond.notify_all();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+bool ReplayLocApi::waitUntil(const steady_clock::time_point& deadline)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (0 != mSpeed) {
+        mCond.wait_until(lock, deadline, [this] { return mStopping; });
+    }
+    return !mStopping;
+}
+
+void ReplayLocApi::replay()
+{
+    uint64_t reports = 0;
+    uint64_t startNs = steadyNowNs();
+    bool replaying = true;
+
+    while (replaying) {
+        FILE* file = fopen(mReplayFile.c_str(), "rb");
+        if (nullptr == file) {
+            LOC_LOGe("cannot open replay file %s, errno %d", mReplayFile.c_str(), errno);
+            break;
+        }
+        replaying = replayOnce(file, reports) && mLoop;
+        fclose(file);
+    }
+
+    uint64_t elapsedMs = (steadyNowNs() - startNs) / 1000000;
+    LOC_LOGi("replayed %" PRIu64 " reports in %" PRIu64 " ms", reports, elapsedMs);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDone = true;
+}
+
+bool ReplayLocApi::replayOnce(FILE* file, uint64_t& reports)
+{
+    LocApiCaptureHeader header;
+    LocApiCaptureHeader expected;
+    fillCaptureHeader(expected);
+    if (1 != fread(&header, sizeof(header), 1, file) ||
+        0 != memcmp(&header, &expected, sizeof(header))) {
+        LOC_LOGe("%s is not a capture of this build", mReplayFile.c_str());
+        return false;
+    }
+
+    // std::vector storage comes from operator new, so it is aligned for
+    // any of the report structures read into it
+    std::vector<uint8_t> payload;
+    steady_clock::time_point passStart = steady_clock::now();
+    LocApiCaptureRecord record;
+    while (1 == fread(&record, sizeof(record), 1, file)) {
+        if (record.length > LOC_API_CAPTURE_MAX_RECORD_LENGTH) {
+            LOC_LOGe("corrupt record of %u bytes in %s", record.length, mReplayFile.c_str());
+            return false;
+        }
+        // one more byte keeps NMEA NUL terminated
+        payload.resize(record.length + 1);
+        if (record.length > 0 && 1 != fread(payload.data(), record.length, 1, file)) {
+            LOC_LOGe("truncated record in %s", mReplayFile.c_str());
+            return false;
+        }
+        payload[record.length] = '\0';
+
+        steady_clock::time_point deadline = passStart;
+        if (0 != mSpeed) {
+            deadline += nanoseconds(record.offsetNs / mSpeed);
+        }
+        if (!waitUntil(deadline)) {
+            return false;
+        }
+        deliver(record, payload.data());
+        reports++;
+    }
+    return true;
+}
+
+void ReplayLocApi::deliver(const LocApiCaptureRecord& record, uint8_t* payload)
+{
+    switch (record.type) {
+    case LOC_API_CAPTURE_POSITION:
+        if (sizeof(LocApiCapturePosition) == record.length) {
+            LocApiCapturePosition* position = (LocApiCapturePosition*)payload;
+            reportPosition(position->location, position->locationExtended,
+                           (enum loc_sess_status)position->status,
+                           (LocPosTechMask)position->techMask, nullptr,
+                           position->msInWeek);
+            return;
+        }
+        break;
+    case LOC_API_CAPTURE_SV:
+        if (sizeof(GnssSvNotification) == record.length) {
+            reportSv(*(GnssSvNotification*)payload);
+            return;
+        }
+        break;
+    case LOC_API_CAPTURE_NMEA:
+        reportNmea((const char*)payload, record.length);
+        return;
+    case LOC_API_CAPTURE_STATUS:
+        if (sizeof(uint32_t) == record.length) {
+            reportStatus((LocGpsStatusValue)*(uint32_t*)payload);
+            return;
+        }
+        break;
+    case LOC_API_CAPTURE_MEASUREMENTS:
+        if (sizeof(LocApiCaptureMeasurements) == record.length) {
+            LocApiCaptureMeasurements* measurements = (LocApiCaptureMeasurements*)payload;
+            reportGnssMeasurements(measurements->measurements, measurements->msInWeek);
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    LOC_LOGw("skipping record of type %u and %u bytes", record.type, record.length);
+}
+
+} // namespace loc_core
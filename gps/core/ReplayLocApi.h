@@ -0,0 +1,149 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __REPLAY_LOC_API_H__
+#define __REPLAY_LOC_API_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <LocApiBase.h>
+
+namespace loc_core {
+
+/* A capture is a header followed by records, each of which is a record
+   header and the payload of one engine report as LocApiBase passes it to
+   the adapters. The payloads are the report structures byte for byte, so
+   a capture only replays on a build with the same structure sizes, which
+   the header records. */
+#define LOC_API_CAPTURE_MAGIC   "LOCCAPT1"
+#define LOC_API_CAPTURE_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t ulpLocationSize;
+    uint32_t locationExtendedSize;
+    uint32_t svNotificationSize;
+    uint32_t measurementsSize;
+} LocApiCaptureHeader;
+
+typedef enum {
+    LOC_API_CAPTURE_POSITION = 1,     // LocApiCapturePosition
+    LOC_API_CAPTURE_SV,               // GnssSvNotification
+    LOC_API_CAPTURE_NMEA,             // the sentences, without terminating NUL
+    LOC_API_CAPTURE_STATUS,           // uint32_t LocGpsStatusValue
+    LOC_API_CAPTURE_MEASUREMENTS,     // LocApiCaptureMeasurements
+} LocApiCaptureRecordType;
+
+typedef struct {
+    uint32_t type;                    // LocApiCaptureRecordType
+    uint32_t length;                  // of the payload that follows
+    uint64_t offsetNs;                // since the first report captured
+} LocApiCaptureRecord;
+
+typedef struct {
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    uint32_t status;                  // loc_sess_status
+    uint32_t techMask;                // LocPosTechMask
+    int32_t msInWeek;
+} LocApiCapturePosition;
+
+typedef struct {
+    GnssMeasurements measurements;
+    int32_t msInWeek;
+} LocApiCaptureMeasurements;
+
+/* Appends the reports of a LocApiBase to a capture file, from whichever
+   thread they come in on. */
+class LocApiCapture {
+public:
+    static LocApiCapture* create(const char* path);
+    ~LocApiCapture();
+
+    void write(LocApiCaptureRecordType type, const void* payload, uint32_t length);
+
+private:
+    inline LocApiCapture(FILE* file) : mFile(file), mStartNs(0) {}
+
+    std::mutex mMutex;
+    FILE* mFile;
+    uint64_t mStartNs;
+};
+
+/* Stands in for the engine by replaying a capture made with gps.conf
+   LOC_API_CAPTURE_FILE, so the adapters, the HAL and the daemon and their
+   clients see the same reports, with the same spacing, run after run.
+   The replay starts with a tracking session and stops with it, at speed
+   times real time, or as fast as the adapters take the reports with a
+   speed of 0. Any other engine request is accepted and ignored. */
+class ReplayLocApi : public LocApiBase {
+public:
+    ReplayLocApi(LOC_API_ADAPTER_EVENT_MASK_T excludedMask, ContextBase* context,
+                 const char* replayFile, uint32_t speed, bool loop);
+    virtual ~ReplayLocApi();
+
+    virtual void startFix(const LocPosMode& fixCriteria,
+                          LocApiResponse* adapterResponse) override;
+    virtual void stopFix(LocApiResponse* adapterResponse) override;
+    virtual void startTimeBasedTracking(const TrackingOptions& options,
+                                        LocApiResponse* adapterResponse) override;
+    virtual void stopTimeBasedTracking(LocApiResponse* adapterResponse) override;
+
+protected:
+    virtual enum loc_api_adapter_err open(LOC_API_ADAPTER_EVENT_MASK_T mask) override;
+    virtual enum loc_api_adapter_err close() override;
+
+private:
+    void startReplay();
+    void stopReplay();
+    void replay();
+    // returns false once the capture is done with, or the replay stopped
+    bool replayOnce(FILE* file, uint64_t& reports);
+    bool waitUntil(const std::chrono::steady_clock::time_point& deadline);
+    void deliver(const LocApiCaptureRecord& record, uint8_t* payload);
+
+    std::string mReplayFile;
+    uint32_t mSpeed;
+    bool mLoop;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    bool mStopping;
+    // no replay thread running, or only one that has finished
+    bool mDone;
+};
+
+} // namespace loc_core
+
+#endif // __REPLAY_LOC_API_H__
@@ -30,6 +30,7 @@
 
 #include <inttypes.h>
 #include <string>
+#include <type_traits>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
@@ -45,49 +46,157 @@
 namespace loc_core
 {
 
+/******************************************************************************
+ SystemStatusNmeaFieldSchema - how a field converts into its report member
+******************************************************************************/
+enum SystemStatusNmeaFieldFormat
+{
+    NMEA_FIELD_INT,     // atoi
+    NMEA_FIELD_HEX,     // strtol, base 16
+    NMEA_FIELD_UINT64,  // strtoull, base 10
+    NMEA_FIELD_FLOAT    // atof
+};
+
+enum SystemStatusNmeaMemberType
+{
+    NMEA_MEMBER_UINT8,
+    NMEA_MEMBER_UINT16,
+    NMEA_MEMBER_UINT32,
+    NMEA_MEMBER_INT32,
+    NMEA_MEMBER_UINT64,
+    NMEA_MEMBER_FLOAT,
+    NMEA_MEMBER_DOUBLE
+};
+
+template <typename T> struct SystemStatusNmeaMember;
+#define NMEA_MEMBER_TYPE(T, memberType) \
+    template <> struct SystemStatusNmeaMember<T> { \
+        static const uint8_t eType = memberType; \
+    }
+NMEA_MEMBER_TYPE(uint8_t,  NMEA_MEMBER_UINT8);
+NMEA_MEMBER_TYPE(uint16_t, NMEA_MEMBER_UINT16);
+NMEA_MEMBER_TYPE(uint32_t, NMEA_MEMBER_UINT32);
+NMEA_MEMBER_TYPE(int32_t,  NMEA_MEMBER_INT32);
+NMEA_MEMBER_TYPE(uint64_t, NMEA_MEMBER_UINT64);
+NMEA_MEMBER_TYPE(float,    NMEA_MEMBER_FLOAT);
+NMEA_MEMBER_TYPE(double,   NMEA_MEMBER_DOUBLE);
+
+struct SystemStatusNmeaFieldSchema
+{
+    uint16_t mIndex;      // field in the sentence
+    uint16_t mRequired;   // field that must be in the sentence for this one to be read
+    uint8_t  mFormat;     // SystemStatusNmeaFieldFormat
+    uint8_t  mMemberType; // SystemStatusNmeaMemberType
+    uint16_t mOffset;     // of the member in the report
+};
+
+// field index of the sentence into member of report, the member type is
+// taken from its declaration
+#define NMEA_FIELD(report, member, index, format) \
+    NMEA_OPTIONAL_FIELD(report, member, index, format, index)
+#define NMEA_OPTIONAL_FIELD(report, member, index, format, required) \
+    { (uint16_t)(index), (uint16_t)(required), format, \
+      SystemStatusNmeaMember<decltype(report::member)>::eType, \
+      (uint16_t)offsetof(report, member) }
+
 /******************************************************************************
  SystemStatusNmeaBase - base class for all NMEA parsers
 ******************************************************************************/
 class SystemStatusNmeaBase
 {
+public:
+    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
+    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // PQWP7 has the most fields of all debug NMEA
+    static const uint32_t NMEA_MAXFIELDS = 2 + SV_ALL_NUM*3;
+
 protected:
-    std::vector<std::string> mField;
+    // fields of the sentence, each NUL terminated in the sentence buffer
+    class SystemStatusNmeaFields
+    {
+        const char* mFields[NMEA_MAXFIELDS];
+        size_t mCount;
+    public:
+        inline SystemStatusNmeaFields() : mCount(0) {}
+        inline size_t size() const { return mCount; }
+        inline const char* operator[](size_t index) const { return mFields[index]; }
+        // fields past NMEA_MAXFIELDS are read by no parser
+        inline void push_back(const char* field) {
+            if (mCount < NMEA_MAXFIELDS) {
+                mFields[mCount++] = field;
+            }
+        }
+    };
+    SystemStatusNmeaFields mField;
 
-    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    // splits str_in in place, without copying or allocating
+    SystemStatusNmeaBase(char *str_in, uint32_t len_in)
     {
         // check size and talker
         if (!loc_nmea_is_debug(str_in, len_in)) {
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
         // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        char* checksum = strchr(str_in, '*');
+        if (nullptr == checksum) {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
+        *checksum = ',';
+
+        // tokenize, what follows the last ',' is not a field
+        char* field = str_in;
+        for (char* p = str_in; *p != '\0'; p++) {
+            if (',' == *p) {
+                *p = '\0';
+                mField.push_back(field);
+                field = p + 1;
             }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
         }
     }
 
-    virtual ~SystemStatusNmeaBase() { }
+    // converts the fields of schema straight into their members of report,
+    // fields not in schema are never converted
+    template <size_t N>
+    void parseFields(const SystemStatusNmeaFieldSchema (&schema)[N], void* report) const
+    {
+        for (size_t i = 0; i < N; i++) {
+            const SystemStatusNmeaFieldSchema& entry = schema[i];
+            if (entry.mRequired >= mField.size()) {
+                continue;
+            }
+            const char* field = mField[entry.mIndex];
+            int64_t integer = 0;
+            double real = 0.0;
+            switch (entry.mFormat) {
+                case NMEA_FIELD_INT:
+                    real = integer = atoi(field);
+                    break;
+                case NMEA_FIELD_HEX:
+                    real = integer = strtol(field, NULL, 16);
+                    break;
+                case NMEA_FIELD_UINT64:
+                    integer = (int64_t)strtoull(field, nullptr, 10);
+                    real = (uint64_t)integer;
+                    break;
+                case NMEA_FIELD_FLOAT:
+                    real = atof(field);
+                    break;
+            }
+            char* member = (char*)report + entry.mOffset;
+            switch (entry.mMemberType) {
+                case NMEA_MEMBER_UINT8:  *(uint8_t*)member = (uint8_t)integer;   break;
+                case NMEA_MEMBER_UINT16: *(uint16_t*)member = (uint16_t)integer; break;
+                case NMEA_MEMBER_UINT32: *(uint32_t*)member = (uint32_t)integer; break;
+                case NMEA_MEMBER_INT32:  *(int32_t*)member = (int32_t)integer;   break;
+                case NMEA_MEMBER_UINT64: *(uint64_t*)member = (uint64_t)integer; break;
+                case NMEA_MEMBER_FLOAT:  *(float*)member = (float)real;          break;
+                case NMEA_MEMBER_DOUBLE: *(double*)member = real;                break;
+            }
+        }
+    }
 
-public:
-    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
-    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    virtual ~SystemStatusNmeaBase() { }
 };
 
 /******************************************************************************
@@ -205,52 +314,58 @@ public:
     inline uint32_t   getGalBpAmpQ()  { return mM1.mGalBpAmpQ; }
     inline uint64_t   getTimeUncNs()  { return mM1.mTimeUncNs; }
 
-    SystemStatusPQWM1parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWM1parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWM1, mGpsWeek, eGpsWeek, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mGpsTowMs, eGpsTowMs, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mTimeValid, eTimeValid, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mTimeSource, eTimeSource, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mTimeUnc, eTimeUnc, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mClockFreqBias, eClockFreqBias, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mClockFreqBiasUnc, eClockFreqBiasUnc, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mXoState, eXoState, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mPgaGain, ePgaGain, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mGpsBpAmpI, eGpsBpAmpI, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mGpsBpAmpQ, eGpsBpAmpQ, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mAdcI, eAdcI, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mAdcQ, eAdcQ, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mJammerGps, eJammerGps, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mJammerGlo, eJammerGlo, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mJammerBds, eJammerBds, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mJammerGal, eJammerGal, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mRecErrorRecovery, eRecErrorRecovery, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWM1, mAgcGps, eAgcGps, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWM1, mAgcGlo, eAgcGlo, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWM1, mAgcBds, eAgcBds, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWM1, mAgcGal, eAgcGal, NMEA_FIELD_FLOAT),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mLeapSeconds, eLeapSeconds,
+                    NMEA_FIELD_INT, eLeapSecUnc),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mLeapSecUnc, eLeapSecUnc,
+                    NMEA_FIELD_INT, eLeapSecUnc),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mGloBpAmpI, eGloBpAmpI,
+                    NMEA_FIELD_INT, eGalBpAmpQ),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mGloBpAmpQ, eGloBpAmpQ,
+                    NMEA_FIELD_INT, eGalBpAmpQ),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mBdsBpAmpI, eBdsBpAmpI,
+                    NMEA_FIELD_INT, eGalBpAmpQ),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mBdsBpAmpQ, eBdsBpAmpQ,
+                    NMEA_FIELD_INT, eGalBpAmpQ),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mGalBpAmpI, eGalBpAmpI,
+                    NMEA_FIELD_INT, eGalBpAmpQ),
+            NMEA_OPTIONAL_FIELD(SystemStatusPQWM1, mGalBpAmpQ, eGalBpAmpQ,
+                    NMEA_FIELD_INT, eGalBpAmpQ),
+            NMEA_FIELD(SystemStatusPQWM1, mTimeUncNs, eTimeUncNs, NMEA_FIELD_UINT64),
+        };
+
         memset(&mM1, 0, sizeof(mM1));
         if (mField.size() <= eMax0) {
             LOC_LOGE("PQWM1parser - invalid size=%zu", mField.size());
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
-        if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
-        }
-        if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
-        }
-        if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
-        }
+        parseFields(schema, &mM1);
     }
 
     inline SystemStatusPQWM1& get() { return mM1;} //getparser
@@ -298,20 +413,24 @@ public:
     inline float      getEpiAltUnc() { return mP1.mEpiAltUnc;        }
     inline uint8_t    getEpiSrc() { return mP1.mEpiSrc;           }
 
-    SystemStatusPQWP1parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP1parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWP1, mEpiValidity, eEpiValidity, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP1, mEpiLat, eEpiLat, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP1, mEpiLon, eEpiLon, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP1, mEpiAlt, eEpiAlt, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP1, mEpiHepe, eEpiHepe, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWP1, mEpiAltUnc, eEpiAltUnc, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP1, mEpiSrc, eEpiSrc, NMEA_FIELD_INT),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        parseFields(schema, &mP1);
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -353,18 +472,22 @@ public:
     inline float      getBestHepe() { return mP2.mBestHepe;         }
     inline float      getBestAltUnc() { return mP2.mBestAltUnc;       }
 
-    SystemStatusPQWP2parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP2parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWP2, mBestLat, eBestLat, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP2, mBestLon, eBestLon, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP2, mBestAlt, eBestAlt, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP2, mBestHepe, eBestHepe, NMEA_FIELD_FLOAT),
+            NMEA_FIELD(SystemStatusPQWP2, mBestAltUnc, eBestAltUnc, NMEA_FIELD_FLOAT),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        parseFields(schema, &mP2);
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -429,25 +552,28 @@ public:
     inline uint8_t    getQzssXtraValid() { return mP3.mQzssXtraValid;    }
     inline uint32_t   getNavicXtraValid() { return mP3.mNavicXtraValid;     }
 
-    SystemStatusPQWP3parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP3parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWP3, mXtraValidMask, eXtraValidMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP3, mGpsXtraAge, eGpsXtraAge, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWP3, mGloXtraAge, eGloXtraAge, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWP3, mBdsXtraAge, eBdsXtraAge, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWP3, mGalXtraAge, eGalXtraAge, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWP3, mQzssXtraAge, eQzssXtraAge, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWP3, mGpsXtraValid, eGpsXtraValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP3, mGloXtraValid, eGloXtraValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP3, mBdsXtraValid, eBdsXtraValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP3, mGalXtraValid, eGalXtraValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP3, mQzssXtraValid, eQzssXtraValid, NMEA_FIELD_HEX),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
-        // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        parseFields(schema, &mP3);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -489,18 +615,22 @@ public:
     inline uint64_t   getGalEpheValid() { return mP4.mGalEpheValid;     }
     inline uint8_t    getQzssEpheValid() { return mP4.mQzssEpheValid;    }
 
-    SystemStatusPQWP4parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP4parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWP4, mGpsEpheValid, eGpsEpheValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP4, mGloEpheValid, eGloEpheValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP4, mBdsEpheValid, eBdsEpheValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP4, mGalEpheValid, eGalEpheValid, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP4, mQzssEpheValid, eQzssEpheValid, NMEA_FIELD_HEX),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        parseFields(schema, &mP4);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -579,29 +709,32 @@ public:
     inline uint8_t    getQzssBadMask() { return mP5.mQzssBadMask;      }
     inline uint32_t   getNavicBadMask() { return mP5.mNavicBadMask;       }
 
-    SystemStatusPQWP5parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP5parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWP5, mGpsUnknownMask, eGpsUnknownMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGloUnknownMask, eGloUnknownMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mBdsUnknownMask, eBdsUnknownMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGalUnknownMask, eGalUnknownMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mQzssUnknownMask, eQzssUnknownMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGpsGoodMask, eGpsGoodMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGloGoodMask, eGloGoodMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mBdsGoodMask, eBdsGoodMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGalGoodMask, eGalGoodMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mQzssGoodMask, eQzssGoodMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGpsBadMask, eGpsBadMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGloBadMask, eGloBadMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mBdsBadMask, eBdsBadMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mGalBadMask, eGalBadMask, NMEA_FIELD_HEX),
+            NMEA_FIELD(SystemStatusPQWP5, mQzssBadMask, eQzssBadMask, NMEA_FIELD_HEX),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
-        // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        parseFields(schema, &mP5);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -631,14 +764,18 @@ private:
 public:
     inline uint32_t   getFixInfoMask() { return mP6.mFixInfoMask;      }
 
-    SystemStatusPQWP6parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP6parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWP6, mFixInfoMask, eFixInfoMask, NMEA_FIELD_HEX),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        parseFields(schema, &mP6);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -666,7 +803,7 @@ private:
     SystemStatusPQWP7 mP7;
 
 public:
-    SystemStatusPQWP7parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP7parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
         uint32_t svLimit = SV_ALL_NUM;
@@ -681,9 +818,9 @@ public:
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2]));
+            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3]));
+            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4]);
         }
     }
 
@@ -717,15 +854,19 @@ public:
     inline uint16_t   getFixInfoMask() { return mS1.mFixInfoMask;      }
     inline uint32_t   getHepeLimit()   { return mS1.mHepeLimit;      }
 
-    SystemStatusPQWS1parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWS1parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
+        static const SystemStatusNmeaFieldSchema schema[] = {
+            NMEA_FIELD(SystemStatusPQWS1, mFixInfoMask, eFixInfoMask, NMEA_FIELD_INT),
+            NMEA_FIELD(SystemStatusPQWS1, mHepeLimit, eHepeLimit, NMEA_FIELD_INT),
+        };
+
         if (mField.size() < eMax) {
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        parseFields(schema, &mS1);
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1288,10 +1429,12 @@ void SystemStatus::destroyInstance()
 }
 
 void SystemStatus::resetNetworkInfo() {
-    for (int i=0; i<mCache.mNetworkInfo.size(); ++i) {
+    std::vector<SystemStatusNetworkInfo> networkInfo;
+    mCache.mNetworkInfo.copyTo(networkInfo);
+    for (int i=0; i<networkInfo.size(); ++i) {
         // Reset all the cached NetworkInfo Items as disconnected
-        eventConnectionStatus(false, mCache.mNetworkInfo[i].mType, mCache.mNetworkInfo[i].mRoaming,
-                mCache.mNetworkInfo[i].mNetworkHandle, mCache.mNetworkInfo[i].mApn);
+        eventConnectionStatus(false, networkInfo[i].mType, networkInfo[i].mRoaming,
+                networkInfo[i].mNetworkHandle, networkInfo[i].mApn);
     }
 }
 
@@ -1301,7 +1444,9 @@ IOsObserver* SystemStatus::getOsObserver()
 }
 
 SystemStatus::SystemStatus(const MsgTask* msgTask) :
-    mSysStatusObsvr(this, msgTask)
+    mSysStatusObsvr(this, msgTask),
+    mNmeaSubscribers(),
+    mPendingNmea(0)
 {
     int result = 0;
     ENTRY_LOG ();
@@ -1357,17 +1502,20 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
     if (s.ignore()) {
         return false;
     }
-    if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
-        // there is no change - just update reported timestamp
-        report.back().mUtcReported = s.mUtcReported;
-        return false;
+    std::shared_ptr<const typename std::decay<TYPE_ITEM>::type> back = report.back();
+    if (nullptr != back) {
+        // published items are immutable, compare and update a copy
+        typename std::decay<TYPE_ITEM>::type last(*back);
+        if (last.equals(static_cast<TYPE_ITEM&>(s.collate(last)))) {
+            // there is no change - just update reported timestamp
+            last.mUtcReported = s.mUtcReported;
+            report.replace_back(last);
+            return false;
+        }
     }
 
-    // first event or updated
+    // first event or updated, the oldest is dropped once maxItem are kept
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
     return true;
 }
 
@@ -1375,17 +1523,15 @@ template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const
 {
     reportout.clear();
-    if (c.size() >= 1) {
-        reportout.push_back(c.back());
+    auto last = c.back();
+    if (nullptr != last) {
+        reportout.push_back(*last);
         reportout.back().dump();
     }
 }
@@ -1400,61 +1546,161 @@ void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) c
 ******************************************************************************/
 bool SystemStatus::setNmeaString(const char *data, uint32_t len)
 {
+    // in the order of SystemStatusNmeaType
+    static const char* const nmeaTypes[SYSTEM_STATUS_NMEA_COUNT] = {
+        "$PQWM1", "$PQWP1", "$PQWP2", "$PQWP3", "$PQWP4",
+        "$PQWP5", "$PQWP6", "$PQWP7", "$PQWS1"
+    };
+
     if (!loc_nmea_is_debug(data, len)) {
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
+    int type = 0;
+    while (type < SYSTEM_STATUS_NMEA_COUNT &&
+           0 != strncmp(data, nmeaTypes[type], SystemStatusNmeaBase::NMEA_MINSIZE)) {
+        type++;
+    }
+    if (SYSTEM_STATUS_NMEA_COUNT == type) {
+        return true;
+    }
+
+    // the time it arrived, not the time it is parsed, is what it reports
+    timeval tv;
+    gettimeofday(&tv, NULL);
 
     pthread_mutex_lock(&mMutexSystemStatus);
 
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
-        setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
-        setIteminReport(mCache.mXoState, SystemStatusXoState(s));
-        setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
-        setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
-    }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mInjectedPosition,
-                SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mBestPosition,
-                SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mXtra,
-                SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mEphemeris,
-                SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mSvHealth,
-                SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
+    SystemStatusRawNmea& raw = mRawNmea[type];
+    strlcpy(raw.mData, data, sizeof(raw.mData));
+    raw.mLength = (len < SystemStatusNmeaBase::NMEA_MAXSIZE) ?
+            len : SystemStatusNmeaBase::NMEA_MAXSIZE;
+    raw.mUtcTime.tv_sec = tv.tv_sec;
+    raw.mUtcTime.tv_nsec = tv.tv_usec*1000ULL;
+    if (mNmeaSubscribers[type] > 0) {
+        parseNmea((SystemStatusNmeaType)type);
+    } else {
+        mPendingNmea |= SYSTEM_STATUS_NMEA_BIT(type);
     }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPdr,
-                SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mNavData,
-                SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
+
+    pthread_mutex_unlock(&mMutexSystemStatus);
+    return true;
+}
+
+// a report parsed from a kept sentence is as of when the sentence arrived
+template <typename TYPE_ITEM>
+static inline TYPE_ITEM&& receivedAt(TYPE_ITEM&& s, const timespec& utcTime)
+{
+    s.mUtcTime = utcTime;
+    s.mUtcReported = utcTime;
+    return std::forward<TYPE_ITEM>(s);
+}
+
+/******************************************************************************
+@brief      parses the kept sentence of a debug NMEA type into its reports,
+            with mMutexSystemStatus held
+
+@param[In]  type debug NMEA type
+******************************************************************************/
+void SystemStatus::parseNmea(SystemStatusNmeaType type)
+{
+    // the parsers split the sentence in place, it is parsed only once
+    char* buf = mRawNmea[type].mData;
+    uint32_t len = mRawNmea[type].mLength;
+    const timespec& t = mRawNmea[type].mUtcTime;
+
+    switch (type) {
+        case SYSTEM_STATUS_NMEA_PQWM1: {
+            SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
+            setIteminReport(mCache.mTimeAndClock, receivedAt(SystemStatusTimeAndClock(s), t));
+            setIteminReport(mCache.mXoState, receivedAt(SystemStatusXoState(s), t));
+            setIteminReport(mCache.mRfAndParams, receivedAt(SystemStatusRfAndParams(s), t));
+            setIteminReport(mCache.mErrRecovery, receivedAt(SystemStatusErrRecovery(s), t));
+            break;
+        }
+        case SYSTEM_STATUS_NMEA_PQWP1:
+            setIteminReport(mCache.mInjectedPosition, receivedAt(
+                    SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWP2:
+            setIteminReport(mCache.mBestPosition, receivedAt(
+                    SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWP3:
+            setIteminReport(mCache.mXtra, receivedAt(
+                    SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWP4:
+            setIteminReport(mCache.mEphemeris, receivedAt(
+                    SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWP5:
+            setIteminReport(mCache.mSvHealth, receivedAt(
+                    SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWP6:
+            setIteminReport(mCache.mPdr, receivedAt(
+                    SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWP7:
+            setIteminReport(mCache.mNavData, receivedAt(
+                    SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()), t));
+            break;
+        case SYSTEM_STATUS_NMEA_PQWS1:
+            setIteminReport(mCache.mPositionFailure, receivedAt(
+                    SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()), t));
+            break;
+        default:
+            break;
     }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPositionFailure,
-                SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
+}
+
+/******************************************************************************
+@brief      parses the kept sentences of the types in mask not parsed yet
+
+@param[In]  mask debug NMEA types about to be read
+******************************************************************************/
+void SystemStatus::parsePendingNmea(SystemStatusNmeaMask mask)
+{
+    // nothing to parse is the common case, and takes no lock
+    if (0 == (mPendingNmea.load() & mask)) {
+        return;
     }
-    else {
-        // do nothing
+
+    pthread_mutex_lock(&mMutexSystemStatus);
+    SystemStatusNmeaMask pending = mPendingNmea.load() & mask;
+    for (int type = 0; type < SYSTEM_STATUS_NMEA_COUNT; type++) {
+        if (pending & SYSTEM_STATUS_NMEA_BIT(type)) {
+            parseNmea((SystemStatusNmeaType)type);
+        }
     }
+    mPendingNmea &= ~pending;
+    pthread_mutex_unlock(&mMutexSystemStatus);
+}
+
+/******************************************************************************
+@brief      API to (un)subscribe to debug NMEA types
+
+@param[In]  mask      debug NMEA types
+@param[In]  subscribe true to subscribe, false to undo a subscribe
+******************************************************************************/
+void SystemStatus::subscribeNmea(SystemStatusNmeaMask mask, bool subscribe)
+{
+    // what arrived before the subscription starts its history
+    parsePendingNmea(mask);
 
+    pthread_mutex_lock(&mMutexSystemStatus);
+    for (int type = 0; type < SYSTEM_STATUS_NMEA_COUNT; type++) {
+        if (0 == (mask & SYSTEM_STATUS_NMEA_BIT(type))) {
+            continue;
+        }
+        if (subscribe) {
+            mNmeaSubscribers[type]++;
+        } else if (mNmeaSubscribers[type] > 0) {
+            mNmeaSubscribers[type]--;
+        }
+    }
     pthread_mutex_unlock(&mMutexSystemStatus);
-    return true;
 }
 
 /******************************************************************************
@@ -1598,10 +1844,12 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 
 @return     true when successfully done
 ******************************************************************************/
-bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
+bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly)
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
+    parsePendingNmea(SYSTEM_STATUS_NMEA_ALL);
 
+    // past the pending debug NMEA each history is a snapshot, the
+    // reporting threads are never blocked
     if (isLatestOnly) {
         // push back only the latest report and return it
         getIteminReport(report.mLocation, mCache.mLocation);
@@ -1646,50 +1894,107 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
     }
     else {
         // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-
-        report.mAirplaneMode.clear();
-        report.mENH.clear();
-        report.mGPSState.clear();
-        report.mNLPStatus.clear();
-        report.mWifiHardwareState.clear();
-        report.mNetworkInfo.clear();
-        report.mRilServiceInfo.clear();
-        report.mRilCellInfo.clear();
-        report.mServiceStatus.clear();
-        report.mModel.clear();
-        report.mManufacturer.clear();
-        report.mAssistedGps.clear();
-        report.mScreenState.clear();
-        report.mPowerConnectState.clear();
-        report.mTimeZoneChange.clear();
-        report.mTimeChange.clear();
-        report.mWifiSupplicantStatus.clear();
-        report.mShutdownState.clear();
-        report.mTac.clear();
-        report.mMccMnc.clear();
-        report.mBtDeviceScanDetail.clear();
-        report.mBtLeDeviceScanDetail.clear();
-
-        report = mCache;
+        mCache.mLocation.copyTo(report.mLocation);
+
+        mCache.mTimeAndClock.copyTo(report.mTimeAndClock);
+        mCache.mXoState.copyTo(report.mXoState);
+        mCache.mRfAndParams.copyTo(report.mRfAndParams);
+        mCache.mErrRecovery.copyTo(report.mErrRecovery);
+
+        mCache.mInjectedPosition.copyTo(report.mInjectedPosition);
+        mCache.mBestPosition.copyTo(report.mBestPosition);
+        mCache.mXtra.copyTo(report.mXtra);
+        mCache.mEphemeris.copyTo(report.mEphemeris);
+        mCache.mSvHealth.copyTo(report.mSvHealth);
+        mCache.mPdr.copyTo(report.mPdr);
+        mCache.mNavData.copyTo(report.mNavData);
+
+        mCache.mPositionFailure.copyTo(report.mPositionFailure);
+
+        mCache.mAirplaneMode.copyTo(report.mAirplaneMode);
+        mCache.mENH.copyTo(report.mENH);
+        mCache.mGPSState.copyTo(report.mGPSState);
+        mCache.mNLPStatus.copyTo(report.mNLPStatus);
+        mCache.mWifiHardwareState.copyTo(report.mWifiHardwareState);
+        mCache.mNetworkInfo.copyTo(report.mNetworkInfo);
+        mCache.mRilServiceInfo.copyTo(report.mRilServiceInfo);
+        mCache.mRilCellInfo.copyTo(report.mRilCellInfo);
+        mCache.mServiceStatus.copyTo(report.mServiceStatus);
+        mCache.mModel.copyTo(report.mModel);
+        mCache.mManufacturer.copyTo(report.mManufacturer);
+        mCache.mAssistedGps.copyTo(report.mAssistedGps);
+        mCache.mScreenState.copyTo(report.mScreenState);
+        mCache.mPowerConnectState.copyTo(report.mPowerConnectState);
+        mCache.mTimeZoneChange.copyTo(report.mTimeZoneChange);
+        mCache.mTimeChange.copyTo(report.mTimeChange);
+        mCache.mWifiSupplicantStatus.copyTo(report.mWifiSupplicantStatus);
+        mCache.mShutdownState.copyTo(report.mShutdownState);
+        mCache.mTac.copyTo(report.mTac);
+        mCache.mMccMnc.copyTo(report.mMccMnc);
+        mCache.mBtDeviceScanDetail.copyTo(report.mBtDeviceScanDetail);
+        mCache.mBtLeDeviceScanDetail.copyTo(report.mBtLeDeviceScanDetail);
     }
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    return true;
+}
+
+/******************************************************************************
+@brief      API to get the latest of the items the GNSS debug report needs
+
+@param[In]  Reports buffer, only the location, best position, time and clock,
+            XTRA, SV health and nav data reports are filled in
+
+@return     true when successfully done
+******************************************************************************/
+bool SystemStatus::getDebugReportItems(SystemStatusReports& report)
+{
+    parsePendingNmea(SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWM1) |
+            SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP2) |
+            SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP3) |
+            SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP5) |
+            SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP7));
+    getIteminReport(report.mLocation, mCache.mLocation);
+    getIteminReport(report.mBestPosition, mCache.mBestPosition);
+    getIteminReport(report.mTimeAndClock, mCache.mTimeAndClock);
+    getIteminReport(report.mXtra, mCache.mXtra);
+    getIteminReport(report.mSvHealth, mCache.mSvHealth);
+    getIteminReport(report.mNavData, mCache.mNavData);
+    return true;
+}
+
+/******************************************************************************
+@brief      API to tell whether the sources of the debug satellite info changed
+
+@param[In]  none
+
+@return     a value that changes whenever the SV health, XTRA or nav data
+            history does
+******************************************************************************/
+uint64_t SystemStatus::getSatelliteInfoGeneration()
+{
+    parsePendingNmea(SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP3) |
+            SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP5) |
+            SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP7));
+    // each generation only ever grows, so the sum changes with any of them
+    return mCache.mSvHealth.generation() + mCache.mXtra.generation() +
+            mCache.mNavData.generation();
+}
+
+/******************************************************************************
+@brief      API to get the latest XTRA status of the engine
+
+@param[In]  xtra the latest XTRA status
+
+@return     true when the engine reported one
+******************************************************************************/
+bool SystemStatus::getLatestXtra(SystemStatusXtra& xtra)
+{
+    parsePendingNmea(SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_PQWP3));
+    auto last = mCache.mXtra.back();
+    if (nullptr == last) {
+        return false;
+    }
+    xtra = *last;
     return true;
 }
 
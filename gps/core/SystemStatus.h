@@ -32,6 +32,8 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <algorithm>
 #include <iterator>
 #include <loc_pla.h>
@@ -43,6 +45,7 @@
 #include <SystemStatusOsObserver.h>
 
 #include <gps_extended_c.h>
+#include <loc_nmea.h>
 
 #define GPS_MIN    (1)   //1-32
 #define SBAS_MIN   (33)
@@ -101,8 +104,22 @@ public:
     inline SystemStatusLocation(const UlpLocation& location,
                          const GpsLocationExtended& locationEx) :
         mValid(true),
-        mLocation(location),
-        mLocationEx(locationEx) {}
+        mLocation(location) {
+        loc_copy_location_extended(&mLocationEx, &locationEx);
+    }
+    inline SystemStatusLocation(const SystemStatusLocation& peer) :
+        SystemStatusItemBase(peer),
+        mValid(peer.mValid),
+        mLocation(peer.mLocation) {
+        loc_copy_location_extended(&mLocationEx, &peer.mLocationEx);
+    }
+    inline SystemStatusLocation& operator=(const SystemStatusLocation& peer) {
+        SystemStatusItemBase::operator=(peer);
+        mValid = peer.mValid;
+        mLocation = peer.mLocation;
+        loc_copy_location_extended(&mLocationEx, &peer.mLocationEx);
+        return *this;
+    }
     bool equals(const SystemStatusLocation& peer);
     void dump(void) override;
 };
@@ -823,6 +840,82 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusHistory
+******************************************************************************/
+// The newest TYPE_ITEM::maxItem items of one report type, in a fixed ring.
+// Writers are serialized by SystemStatus::mMutexSystemStatus and publish
+// every change as a new immutable ring, so readers take a consistent
+// snapshot of the history by loading one pointer, without waiting for the
+// writer.
+template <typename TYPE_ITEM>
+class SystemStatusHistory
+{
+    struct Ring {
+        std::shared_ptr<const TYPE_ITEM> mItems[TYPE_ITEM::maxItem];
+        uint32_t mHead;  // oldest item
+        uint32_t mCount;
+        inline Ring() : mHead(0), mCount(0) {}
+        inline const std::shared_ptr<const TYPE_ITEM>& at(uint32_t index) const {
+            return mItems[(mHead + index) % TYPE_ITEM::maxItem];
+        }
+    };
+    std::shared_ptr<const Ring> mRing;
+    // bumped by every publish, so a reader can tell the history changed
+    std::atomic<uint64_t> mGeneration;
+
+    inline std::shared_ptr<const Ring> snapshot() const { return std::atomic_load(&mRing); }
+    inline void publish(const Ring* ring) {
+        std::atomic_store(&mRing, std::shared_ptr<const Ring>(ring));
+        mGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+public:
+    inline SystemStatusHistory() : mRing(std::make_shared<Ring>()), mGeneration(0) {}
+
+    // writer side
+    inline void clear() { publish(new Ring()); }
+    inline void push_back(const TYPE_ITEM& item) {
+        Ring* ring = new Ring(*snapshot());
+        std::shared_ptr<const TYPE_ITEM> newItem = std::make_shared<TYPE_ITEM>(item);
+        if (ring->mCount < TYPE_ITEM::maxItem) {
+            ring->mItems[(ring->mHead + ring->mCount) % TYPE_ITEM::maxItem] = newItem;
+            ring->mCount++;
+        } else {
+            // drop the oldest
+            ring->mItems[ring->mHead] = newItem;
+            ring->mHead = (ring->mHead + 1) % TYPE_ITEM::maxItem;
+        }
+        publish(ring);
+    }
+    inline void replace_back(const TYPE_ITEM& item) {
+        std::shared_ptr<const Ring> last = snapshot();
+        if (0 == last->mCount) {
+            push_back(item);
+            return;
+        }
+        Ring* ring = new Ring(*last);
+        ring->mItems[(ring->mHead + ring->mCount - 1) % TYPE_ITEM::maxItem] =
+                std::make_shared<TYPE_ITEM>(item);
+        publish(ring);
+    }
+
+    // reader side, any thread
+    inline uint64_t generation() const { return mGeneration.load(std::memory_order_acquire); }
+    inline std::shared_ptr<const TYPE_ITEM> back() const {
+        std::shared_ptr<const Ring> ring = snapshot();
+        return (0 == ring->mCount) ? nullptr : ring->at(ring->mCount - 1);
+    }
+    inline void copyTo(std::vector<TYPE_ITEM>& out) const {
+        std::shared_ptr<const Ring> ring = snapshot();
+        out.clear();
+        out.reserve(ring->mCount);
+        for (uint32_t i = 0; i < ring->mCount; i++) {
+            out.push_back(*ring->at(i));
+        }
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
@@ -875,9 +968,80 @@ public:
     std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
 };
 
+/******************************************************************************
+ SystemStatusReportHistory
+******************************************************************************/
+// what SystemStatus keeps of each report type, copied out into
+// SystemStatusReports by SystemStatus::getReport
+class SystemStatusReportHistory
+{
+public:
+    // from QMI_LOC indication
+    SystemStatusHistory<SystemStatusLocation>             mLocation;
+
+    // from ME debug NMEA
+    SystemStatusHistory<SystemStatusTimeAndClock>         mTimeAndClock;
+    SystemStatusHistory<SystemStatusXoState>              mXoState;
+    SystemStatusHistory<SystemStatusRfAndParams>          mRfAndParams;
+    SystemStatusHistory<SystemStatusErrRecovery>          mErrRecovery;
+
+    // from PE debug NMEA
+    SystemStatusHistory<SystemStatusInjectedPosition>     mInjectedPosition;
+    SystemStatusHistory<SystemStatusBestPosition>         mBestPosition;
+    SystemStatusHistory<SystemStatusXtra>                 mXtra;
+    SystemStatusHistory<SystemStatusEphemeris>            mEphemeris;
+    SystemStatusHistory<SystemStatusSvHealth>             mSvHealth;
+    SystemStatusHistory<SystemStatusPdr>                  mPdr;
+    SystemStatusHistory<SystemStatusNavData>              mNavData;
+
+    // from SM debug NMEA
+    SystemStatusHistory<SystemStatusPositionFailure>      mPositionFailure;
+
+    // from dataitems observer
+    SystemStatusHistory<SystemStatusAirplaneMode>         mAirplaneMode;
+    SystemStatusHistory<SystemStatusENH>                  mENH;
+    SystemStatusHistory<SystemStatusGpsState>             mGPSState;
+    SystemStatusHistory<SystemStatusNLPStatus>            mNLPStatus;
+    SystemStatusHistory<SystemStatusWifiHardwareState>    mWifiHardwareState;
+    SystemStatusHistory<SystemStatusNetworkInfo>          mNetworkInfo;
+    SystemStatusHistory<SystemStatusServiceInfo>          mRilServiceInfo;
+    SystemStatusHistory<SystemStatusRilCellInfo>          mRilCellInfo;
+    SystemStatusHistory<SystemStatusServiceStatus>        mServiceStatus;
+    SystemStatusHistory<SystemStatusModel>                mModel;
+    SystemStatusHistory<SystemStatusManufacturer>         mManufacturer;
+    SystemStatusHistory<SystemStatusAssistedGps>          mAssistedGps;
+    SystemStatusHistory<SystemStatusScreenState>          mScreenState;
+    SystemStatusHistory<SystemStatusPowerConnectState>    mPowerConnectState;
+    SystemStatusHistory<SystemStatusTimeZoneChange>       mTimeZoneChange;
+    SystemStatusHistory<SystemStatusTimeChange>           mTimeChange;
+    SystemStatusHistory<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    SystemStatusHistory<SystemStatusShutdownState>        mShutdownState;
+    SystemStatusHistory<SystemStatusTac>                  mTac;
+    SystemStatusHistory<SystemStatusMccMnc>               mMccMnc;
+    SystemStatusHistory<SystemStatusBtDeviceScanDetail>   mBtDeviceScanDetail;
+    SystemStatusHistory<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+};
+
 /******************************************************************************
  SystemStatus
 ******************************************************************************/
+// debug NMEA sentence types, as bits of a SystemStatusNmeaMask
+typedef enum {
+    SYSTEM_STATUS_NMEA_PQWM1 = 0,
+    SYSTEM_STATUS_NMEA_PQWP1,
+    SYSTEM_STATUS_NMEA_PQWP2,
+    SYSTEM_STATUS_NMEA_PQWP3,
+    SYSTEM_STATUS_NMEA_PQWP4,
+    SYSTEM_STATUS_NMEA_PQWP5,
+    SYSTEM_STATUS_NMEA_PQWP6,
+    SYSTEM_STATUS_NMEA_PQWP7,
+    SYSTEM_STATUS_NMEA_PQWS1,
+    SYSTEM_STATUS_NMEA_COUNT
+} SystemStatusNmeaType;
+typedef uint32_t SystemStatusNmeaMask;
+#define SYSTEM_STATUS_NMEA_BIT(type)  ((SystemStatusNmeaMask)1 << (type))
+#define SYSTEM_STATUS_NMEA_ALL        (SYSTEM_STATUS_NMEA_BIT(SYSTEM_STATUS_NMEA_COUNT) - 1)
+
 class SystemStatus
 {
 private:
@@ -890,7 +1054,24 @@ private:
 
     // Data members
     static pthread_mutex_t                    mMutexSystemStatus;
-    SystemStatusReports mCache;
+    SystemStatusReportHistory mCache;
+
+    // Debug NMEA is only parsed as it arrives for the types someone is
+    // subscribed to. Of the others the latest sentence is kept raw and
+    // parsed when a report is asked for, so history is only kept of the
+    // subscribed types. Guarded by mMutexSystemStatus, but the mask of the
+    // pending sentences, which readers check first.
+    struct SystemStatusRawNmea {
+        char mData[DEBUG_NMEA_MAXSIZE + 1];
+        uint32_t mLength;
+        timespec mUtcTime;
+    };
+    SystemStatusRawNmea                       mRawNmea[SYSTEM_STATUS_NMEA_COUNT];
+    uint32_t                                  mNmeaSubscribers[SYSTEM_STATUS_NMEA_COUNT];
+    std::atomic<SystemStatusNmeaMask>         mPendingNmea;
+
+    void parseNmea(SystemStatusNmeaType type);
+    void parsePendingNmea(SystemStatusNmeaMask mask);
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
@@ -912,7 +1093,16 @@ public:
     bool eventPosition(const UlpLocation& location,const GpsLocationExtended& locationEx);
     bool eventDataItemNotify(IDataItemCore* dataitem);
     bool setNmeaString(const char *data, uint32_t len);
-    bool getReport(SystemStatusReports& reports, bool isLatestonly = false) const;
+    // while subscribed, the debug NMEA of the types in mask is parsed as it
+    // arrives and keeps its history; each subscribe is undone by one
+    // unsubscribe
+    void subscribeNmea(SystemStatusNmeaMask mask, bool subscribe);
+    bool getReport(SystemStatusReports& reports, bool isLatestonly = false);
+    // the latest of only the items the GNSS debug report is built from
+    bool getDebugReportItems(SystemStatusReports& reports);
+    // changes whenever the SV health, XTRA or nav data history does
+    uint64_t getSatelliteInfoGeneration();
+    bool getLatestXtra(SystemStatusXtra& xtra);
     bool setDefaultGnssEngineStates(void);
     bool eventConnectionStatus(bool connected, int8_t type,
                                bool roaming, NetworkHandle networkHandle, string& apn);
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <SystemStatus.h>
 #include <SystemStatusOsObserver.h>
+#include <ContextBase.h>
 #include <IDataItemCore.h>
 #include <DataItemsFactoryProxy.h>
 
@@ -46,17 +47,11 @@ COUT SystemStatusOsObserver::containerTransfer(CINT& inContainer) {
 }
 
 SystemStatusOsObserver::~SystemStatusOsObserver() {
+    // Destroy cache, while the data-item library is still there to do it
+    mDataItemCache.clear();
+
     // Close data-item library handle
     DataItemsFactoryProxy::closeDataItemLibraryHandle();
-
-    // Destroy cache
-    for (auto each : mDataItemCache) {
-        if (nullptr != each.second) {
-            delete each.second;
-        }
-    }
-
-    mDataItemCache.clear();
 }
 
 void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscriptionObj)
@@ -70,10 +65,9 @@ void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscript
             LOC_LOGi("SetSubsObj::enter");
             mContext.mSubscriptionObj = mSubsObj;
 
-            if (!mContext.mSSObserver->mDataItemToClients.empty()) {
-                list<DataItemId> dis(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                mContext.mSSObserver->mDataItemToClients.getKeys()));
+            if (!mContext.mSSObserver->mSubscriptions.empty()) {
+                list<DataItemId> dis(toDataItemIdList(
+                        mContext.mSSObserver->mSubscriptions.getDataItems()));
                 mContext.mSubscriptionObj->subscribe(dis, mContext.mSSObserver);
                 mContext.mSubscriptionObj->requestData(dis, mContext.mSSObserver);
             }
@@ -98,14 +92,13 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
         inline HandleSubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client, bool requestData) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)),
+                mDataItemSet(toDataItemIdSet(l)),
                 diItemlist(l),
                 mToRequestData(requestData) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            mParent->mDataItemToClients.add(mDataItemSet, {mClient}, &dataItemsToSubscribe);
-            mParent->mClientToDataItems.add(mClient, mDataItemSet);
+            DataItemIdSet dataItemsToSubscribe;
+            mParent->mSubscriptions.add(mClient, mDataItemSet, dataItemsToSubscribe);
 
             mParent->sendCachedDataItems(mDataItemSet, mClient);
 
@@ -114,19 +107,17 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
                 if (mToRequestData) {
                     LOC_LOGD("Request Data sent to framework for the following");
                     mParent->mContext.mSubscriptionObj->requestData(diItemlist, mParent);
-                } else if (!dataItemsToSubscribe.empty()) {
+                } else if (dataItemsToSubscribe.any()) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToSubscribe), mParent);
                 }
             }
         }
         mutable SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        const unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
         const list<DataItemId> diItemlist;
         bool mToRequestData;
     };
@@ -146,61 +137,41 @@ void SystemStatusOsObserver::updateSubscription(
         HandleUpdateSubscriptionReq(SystemStatusOsObserver* parent,
                                     list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(toDataItemIdSet(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            unordered_set<IDataItemObserver*> clients({mClient});
-            // below removes clients from all entries keyed with the return of the
-            // mClientToDataItems.update() call. If leaving an empty set of clients as the
-            // result, the entire entry will be removed. dataItemsToUnsubscribe will be
-            // populated to keep the keys of the removed entries.
-            mParent->mDataItemToClients.trimOrRemove(
-                    // this call updates <IDataItemObserver*, DataItemId> map; removes
-                    // the DataItemId's that are not new to the clietn from mDataItemSet;
-                    // and returns a set of mDataItemSet's that are no longer used by client.
-                    // This unused set of mDataItemSet's is passed to trimOrRemove method of
-                    // <DataItemId, IDataItemObserver*> map to remove the client from the
-                    // corresponding entries, and gets a set of the entries that are
-                    // removed from the <DataItemId, IDataItemObserver*> map as a result.
-                    mParent->mClientToDataItems.update(mClient,
-                                                       (unordered_set<DataItemId>&)mDataItemSet),
-                    clients, &dataItemsToUnsubscribe, nullptr);
-            // below adds mClient to <DataItemId, IDataItemObserver*> map, and populates
-            // new keys added to that map, which are DataItemIds to be subscribed.
-            mParent->mDataItemToClients.add(mDataItemSet, clients, &dataItemsToSubscribe);
+            DataItemIdSet dataItemsAdded;
+            DataItemIdSet dataItemsToSubscribe;
+            DataItemIdSet dataItemsToUnsubscribe;
+            mParent->mSubscriptions.update(mClient, mDataItemSet, dataItemsAdded,
+                                           dataItemsToSubscribe, dataItemsToUnsubscribe);
 
             // Send First Response
-            mParent->sendCachedDataItems(mDataItemSet, mClient);
+            mParent->sendCachedDataItems(dataItemsAdded, mClient);
 
             if (nullptr != mParent->mContext.mSubscriptionObj) {
                 // Send subscription set to framework
-                if (!dataItemsToSubscribe.empty()) {
+                if (dataItemsToSubscribe.any()) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
 
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToSubscribe), mParent);
                 }
 
                 // Send unsubscribe to framework
-                if (!dataItemsToUnsubscribe.empty()) {
+                if (dataItemsToUnsubscribe.any()) {
                     LOC_LOGD("Unsubscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToUnsubscribe);
 
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToUnsubscribe), mParent);
                 }
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -218,31 +189,24 @@ void SystemStatusOsObserver::unsubscribe(
         HandleUnsubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(toDataItemIdSet(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsUnusedByClient = {};
-            unordered_set<IDataItemObserver*> clientToRemove = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            mParent->mClientToDataItems.trimOrRemove({mClient}, mDataItemSet,  &clientToRemove,
-                                                     &dataItemsUnusedByClient);
-            mParent->mDataItemToClients.trimOrRemove(dataItemsUnusedByClient, {mClient},
-                                                     &dataItemsToUnsubscribe, nullptr);
-
-            if (nullptr != mParent->mContext.mSubscriptionObj && !dataItemsToUnsubscribe.empty()) {
+            DataItemIdSet dataItemsToUnsubscribe;
+            mParent->mSubscriptions.remove(mClient, mDataItemSet, dataItemsToUnsubscribe);
+
+            if (nullptr != mParent->mContext.mSubscriptionObj && dataItemsToUnsubscribe.any()) {
                 LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
                 mParent->logMe(dataItemsToUnsubscribe);
 
                 // Send unsubscribe to framework
                 mParent->mContext.mSubscriptionObj->unsubscribe(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                  std::move(dataItemsToUnsubscribe)),
-                        mParent);
+                        toDataItemIdList(dataItemsToUnsubscribe), mParent);
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -260,26 +224,18 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
                 mParent(parent), mClient(client) {}
 
         void proc() const {
-            unordered_set<DataItemId> diByClient = mParent->mClientToDataItems.getValSet(mClient);
+            DataItemIdSet dataItemsToUnsubscribe;
+            mParent->mSubscriptions.removeAll(mClient, dataItemsToUnsubscribe);
 
-            if (!diByClient.empty()) {
-                unordered_set<DataItemId> dataItemsToUnsubscribe;
-                mParent->mClientToDataItems.remove(mClient);
-                mParent->mDataItemToClients.trimOrRemove(diByClient, {mClient},
-                                                         &dataItemsToUnsubscribe, nullptr);
+            if (dataItemsToUnsubscribe.any() &&
+                nullptr != mParent->mContext.mSubscriptionObj) {
 
-                if (!dataItemsToUnsubscribe.empty() &&
-                    nullptr != mParent->mContext.mSubscriptionObj) {
-
-                    LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
-                    mParent->logMe(dataItemsToUnsubscribe);
+                LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
+                mParent->logMe(dataItemsToUnsubscribe);
 
-                    // Send unsubscribe to framework
-                    mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
-                }
+                // Send unsubscribe to framework
+                mParent->mContext.mSubscriptionObj->unsubscribe(
+                        toDataItemIdList(dataItemsToUnsubscribe), mParent);
             }
         }
         SystemStatusOsObserver* mParent;
@@ -299,59 +255,33 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
 void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
 {
     struct HandleNotify : public LocMsg {
-        HandleNotify(SystemStatusOsObserver* parent, vector<IDataItemCore*>& v) :
+        HandleNotify(SystemStatusOsObserver* parent, vector<shared_ptr<IDataItemCore>>& v) :
                 mParent(parent), mDiVec(std::move(v)) {}
 
-        inline virtual ~HandleNotify() {
-            for (auto item : mDiVec) {
-                delete item;
-            }
-        }
-
         void proc() const {
             // Update Cache with received data items and prepare
             // list of data items to be sent.
-            unordered_set<DataItemId> dataItemIdsToBeSent = {};
-            for (auto item : mDiVec) {
+            DataItemIdSet dataItemIdsToBeSent;
+            for (auto& item : mDiVec) {
                 if (mParent->updateCache(item)) {
-                    dataItemIdsToBeSent.insert(item->getId());
-                }
-            }
-
-            // Send data item to all subscribed clients
-            unordered_set<IDataItemObserver*> clientSet = {};
-            for (auto each : dataItemIdsToBeSent) {
-                auto clients = mParent->mDataItemToClients.getValSetPtr(each);
-                if (nullptr != clients) {
-                    clientSet.insert(clients->begin(), clients->end());
+                    dataItemIdsToBeSent.set(item->getId());
                 }
             }
 
-            for (auto client : clientSet) {
-                unordered_set<DataItemId> dataItemIdsForThisClient(
-                        mParent->mClientToDataItems.getValSet(client));
-                for (auto itr = dataItemIdsForThisClient.begin();
-                        itr != dataItemIdsForThisClient.end(); ) {
-                    if (dataItemIdsToBeSent.find(*itr) == dataItemIdsToBeSent.end()) {
-                        itr = dataItemIdsForThisClient.erase(itr);
-                    } else {
-                        itr++;
-                    }
-                }
-
-                mParent->sendCachedDataItems(dataItemIdsForThisClient, client);
-            }
+            mParent->coalesceNotify(dataItemIdsToBeSent);
         }
         SystemStatusOsObserver* mParent;
-        const vector<IDataItemCore*> mDiVec;
+        const vector<shared_ptr<IDataItemCore>> mDiVec;
     };
 
     if (!dlist.empty()) {
-        vector<IDataItemCore*> dataItemVec(dlist.size());
+        // the one copy made of a notified item, cached and sent as is
+        vector<shared_ptr<IDataItemCore>> dataItemVec;
+        dataItemVec.reserve(dlist.size());
 
         for (auto each : dlist) {
 
-            IDataItemCore* di = DataItemsFactoryProxy::createNewDataItem(each->getId());
+            shared_ptr<IDataItemCore> di(DataItemsFactoryProxy::createNewDataItem(each->getId()));
             if (nullptr == di) {
                 LOC_LOGw("Unable to create dataitem:%d", each->getId());
                 continue;
@@ -527,35 +457,108 @@ bool SystemStatusOsObserver::disconnectBackhaul(const string& clientName)
 /******************************************************************************
  Helpers
 ******************************************************************************/
+DataItemIdSet SystemStatusOsObserver::toDataItemIdSet(const list<DataItemId>& l)
+{
+    DataItemIdSet s;
+    for (auto id : l) {
+        if (id >= 0 && id < MAX_DATA_ITEM_ID_1_1) {
+            s.set(id);
+        } else {
+            LOC_LOGw("Invalid dataitem:%d", id);
+        }
+    }
+    return s;
+}
+
+list<DataItemId> SystemStatusOsObserver::toDataItemIdList(const DataItemIdSet& s)
+{
+    list<DataItemId> l = {};
+    for (int id = 0; id < MAX_DATA_ITEM_ID_1_1; id++) {
+        if (s.test(id)) {
+            l.push_back((DataItemId)id);
+        }
+    }
+    return l;
+}
+
 void SystemStatusOsObserver::sendCachedDataItems(
-        const unordered_set<DataItemId>& s, IDataItemObserver* to)
+        const DataItemIdSet& s, IDataItemObserver* to)
 {
     if (nullptr == to) {
         LOC_LOGv("client pointer is NULL.");
     } else {
         string clientName;
-        to->getName(clientName);
-        list<IDataItemCore*> dataItems = {};
-
-        for (auto each : s) {
-            auto citer = mDataItemCache.find(each);
-            if (citer != mDataItemCache.end()) {
-                string dv;
-                citer->second->stringify(dv);
-                LOC_LOGI("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
-                dataItems.push_front(citer->second);
+        IF_LOC_LOGI {
+            to->getName(clientName);
+        }
+        list<shared_ptr<IDataItemCore>> dataItems = {};
+
+        for (auto& each : mDataItemCache) {
+            if (s.test(each.first)) {
+                IF_LOC_LOGI {
+                    string dv;
+                    each.second.mSnapshot->stringify(dv);
+                    LOC_LOGI("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
+                }
+                dataItems.push_front(each.second.mSnapshot);
             }
         }
 
         if (dataItems.empty()) {
             LOC_LOGv("No items to notify.");
         } else {
-            to->notify(dataItems);
+            to->notifyShared(dataItems);
         }
     }
 }
 
-bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
+void SystemStatusOsObserver::coalesceNotify(const DataItemIdSet& s)
+{
+    uint32_t windowMs = ContextBase::mGps_conf.DATA_ITEM_NOTIFY_COALESCE_MS;
+
+    if (0 == windowMs && mPendingNotifyIds.none()) {
+        notifyClients(s);
+    } else if (s.any()) {
+        // Only the latest cached value is sent once the window expires, so
+        // an item updated several times within it reaches clients once.
+        bool timerIdle = mPendingNotifyIds.none();
+        mPendingNotifyIds |= s;
+        if (timerIdle) {
+            mNotifyCoalesceTimer.start(windowMs, false);
+        }
+    }
+}
+
+void SystemStatusOsObserver::NotifyCoalesceTimer::timeOutCallback()
+{
+    struct HandleNotifyFlush : public LocMsg {
+        HandleNotifyFlush(SystemStatusOsObserver* parent) : mParent(parent) {}
+
+        void proc() const {
+            DataItemIdSet dataItemIdsToBeSent = mParent->mPendingNotifyIds;
+            mParent->mPendingNotifyIds.reset();
+            mParent->notifyClients(dataItemIdsToBeSent);
+        }
+        SystemStatusOsObserver* mParent;
+    };
+
+    mObserver.mContext.mMsgTask->sendMsg(new HandleNotifyFlush(&mObserver));
+}
+
+void SystemStatusOsObserver::notifyClients(const DataItemIdSet& s)
+{
+    // Send data item to all subscribed clients
+    if ((s & mSubscriptions.getDataItems()).any()) {
+        for (auto each : mSubscriptions.getClients()) {
+            DataItemIdSet dataItemIdsForThisClient = each.second & s;
+            if (dataItemIdsForThisClient.any()) {
+                sendCachedDataItems(dataItemIdsForThisClient, each.first);
+            }
+        }
+    }
+}
+
+bool SystemStatusOsObserver::updateCache(const shared_ptr<IDataItemCore>& d)
 {
     bool dataItemUpdated = false;
 
@@ -563,21 +566,28 @@ bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
     // if the return is false, it means that SystemStatus is not
     // handling it, so SystemStatusOsObserver also doesn't.
     // So it has to be true to proceed.
-    if (nullptr != d && mSystemStatus->eventDataItemNotify(d)) {
+    if (nullptr != d && mSystemStatus->eventDataItemNotify(d.get())) {
         auto citer = mDataItemCache.find(d->getId());
         if (citer == mDataItemCache.end()) {
             // New data item; not found in cache
-            IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(d->getId());
+            unique_ptr<IDataItemCore> dataitem(
+                    DataItemsFactoryProxy::createNewDataItem(d->getId()));
             if (nullptr != dataitem) {
                 // Copy the contents of the data item
-                dataitem->copy(d);
+                dataitem->copy(d.get());
                 // Insert in mDataItemCache
-                mDataItemCache.insert(std::make_pair(d->getId(), dataitem));
+                CachedDataItem& cached = mDataItemCache[d->getId()];
+                cached.mLatest = std::move(dataitem);
+                cached.mSnapshot = d;
                 dataItemUpdated = true;
             }
         } else {
-            // Found in cache; Update cache if necessary
-            citer->second->copy(d, &dataItemUpdated);
+            // Found in cache; the snapshot sent so far may still be held by
+            // observers, so it is replaced rather than updated
+            citer->second.mLatest->copy(d.get(), &dataItemUpdated);
+            if (dataItemUpdated) {
+                citer->second.mSnapshot = d;
+            }
         }
 
         if (dataItemUpdated) {
@@ -588,5 +598,72 @@ bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
     return dataItemUpdated;
 }
 
-} // namespace loc_core
+/******************************************************************************
+ DataItemSubscriptions
+******************************************************************************/
+DataItemIdSet DataItemSubscriptions::addClient(
+        const DataItemIdSet& s, IDataItemObserver* client)
+{
+    for (int id = 0; id < MAX_DATA_ITEM_ID_1_1; id++) {
+        if (s.test(id)) {
+            mDataItemToClients[id].insert(client);
+        }
+    }
+    DataItemIdSet firstClient = s & ~mSubscribed;
+    mSubscribed |= s;
+    return firstClient;
+}
+
+DataItemIdSet DataItemSubscriptions::removeClient(
+        const DataItemIdSet& s, IDataItemObserver* client)
+{
+    DataItemIdSet lastClient;
+    for (int id = 0; id < MAX_DATA_ITEM_ID_1_1; id++) {
+        if (s.test(id) && mDataItemToClients[id].erase(client) > 0 &&
+                mDataItemToClients[id].empty()) {
+            lastClient.set(id);
+        }
+    }
+    mSubscribed &= ~lastClient;
+    return lastClient;
+}
+
+void DataItemSubscriptions::add(IDataItemObserver* client, const DataItemIdSet& s,
+                                DataItemIdSet& toSubscribe)
+{
+    if (s.any()) {
+        DataItemIdSet& cur = mClientToDataItems[client];
+        toSubscribe = addClient(s & ~cur, client);
+        cur |= s;
+    }
+}
 
+void DataItemSubscriptions::update(IDataItemObserver* client, const DataItemIdSet& s,
+                                   DataItemIdSet& added, DataItemIdSet& toSubscribe,
+                                   DataItemIdSet& toUnsubscribe)
+{
+    DataItemIdSet cur = getDataItems(client);
+    added = s & ~cur;
+    toUnsubscribe = removeClient(cur & ~s, client);
+    toSubscribe = addClient(added, client);
+    if (s.any()) {
+        mClientToDataItems[client] = s;
+    } else {
+        mClientToDataItems.erase(client);
+    }
+}
+
+void DataItemSubscriptions::remove(IDataItemObserver* client, const DataItemIdSet& s,
+                                   DataItemIdSet& toUnsubscribe)
+{
+    auto entry = mClientToDataItems.find(client);
+    if (entry != mClientToDataItems.end()) {
+        toUnsubscribe = removeClient(entry->second & s, client);
+        entry->second &= ~s;
+        if (entry->second.none()) {
+            mClientToDataItems.erase(entry);
+        }
+    }
+}
+
+} // namespace loc_core
@@ -30,13 +30,16 @@
 #define __SYSTEM_STATUS_OSOBSERVER__
 
 #include <cinttypes>
+#include <bitset>
 #include <string>
 #include <list>
 #include <map>
+#include <memory>
 #include <new>
 #include <vector>
 
 #include <MsgTask.h>
+#include <LocTimer.h>
 #include <DataItemId.h>
 #include <IOsObserver.h>
 #include <loc_pla.h>
@@ -56,15 +59,62 @@ class IDataItemCore;
 class SystemStatus;
 class SystemStatusOsObserver;
 typedef map<IDataItemObserver*, list<DataItemId>> ObserverReqCache;
-typedef LocUnorderedSetMap<IDataItemObserver*, DataItemId> ClientToDataItems;
-typedef LocUnorderedSetMap<DataItemId, IDataItemObserver*> DataItemToClients;
-typedef unordered_map<DataItemId, IDataItemCore*> DataItemIdToCore;
+// DataItemId is a small dense enum, so sets of data items are bitsets indexed by id
+typedef bitset<MAX_DATA_ITEM_ID_1_1> DataItemIdSet;
+typedef unordered_map<IDataItemObserver*, DataItemIdSet> ClientToDataItems;
+// What is cached of a data item. Observers are sent the snapshot itself,
+// which is never changed once cached, so no observer needs a copy of its own.
+struct CachedDataItem {
+    // private copy, updated in place to tell whether a notification changes it
+    unique_ptr<IDataItemCore> mLatest;
+    // the notified item the last change came in, shared with the observers
+    shared_ptr<IDataItemCore> mSnapshot;
+};
+typedef unordered_map<DataItemId, CachedDataItem> DataItemIdToCore;
 typedef unordered_map<DataItemId, int> DataItemIdToInt;
 #ifdef USE_GLIB
 // Cache details of backhaul client requests
 typedef unordered_set<string> ClientBackhaulReqCache;
 #endif
 
+// Subscriptions between clients and data items, kept in both directions
+class DataItemSubscriptions {
+    ClientToDataItems                                mClientToDataItems;
+    unordered_set<IDataItemObserver*>                mDataItemToClients[MAX_DATA_ITEM_ID_1_1];
+    // data items that have at least one client
+    DataItemIdSet                                    mSubscribed;
+
+    DataItemIdSet addClient(const DataItemIdSet& s, IDataItemObserver* client);
+    DataItemIdSet removeClient(const DataItemIdSet& s, IDataItemObserver* client);
+
+public:
+    inline bool empty() const { return mSubscribed.none(); }
+    inline const DataItemIdSet& getDataItems() const { return mSubscribed; }
+    inline DataItemIdSet getDataItems(IDataItemObserver* client) const {
+        auto entry = mClientToDataItems.find(client);
+        return (entry != mClientToDataItems.end()) ? entry->second : DataItemIdSet();
+    }
+    inline const ClientToDataItems& getClients() const { return mClientToDataItems; }
+
+    // Each of below returns in *toSubscribe* the data items that got their first
+    // client, and in *toUnsubscribe* those that lost their last client, i.e. the
+    // changes to be sent to the framework.
+
+    // Adds *s* to the subscription of *client*
+    void add(IDataItemObserver* client, const DataItemIdSet& s, DataItemIdSet& toSubscribe);
+    // Replaces the subscription of *client* with *s*; *added* returns the data
+    // items *client* was not subscribed to before.
+    void update(IDataItemObserver* client, const DataItemIdSet& s, DataItemIdSet& added,
+                DataItemIdSet& toSubscribe, DataItemIdSet& toUnsubscribe);
+    // Removes *s* from the subscription of *client*
+    void remove(IDataItemObserver* client, const DataItemIdSet& s,
+                DataItemIdSet& toUnsubscribe);
+    // Removes all the subscription of *client*
+    inline void removeAll(IDataItemObserver* client, DataItemIdSet& toUnsubscribe) {
+        remove(client, getDataItems(client), toUnsubscribe);
+    }
+};
+
 struct ObserverContext {
     IDataItemSubscription* mSubscriptionObj;
     IFrameworkActionReq* mFrameworkActionReqObj;
@@ -87,7 +137,7 @@ public:
     inline SystemStatusOsObserver(SystemStatus* systemstatus, const MsgTask* msgTask) :
             mSystemStatus(systemstatus), mContext(msgTask, this),
             mAddress("SystemStatusOsObserver"),
-            mClientToDataItems(MAX_DATA_ITEM_ID), mDataItemToClients(MAX_DATA_ITEM_ID) {}
+            mNotifyCoalesceTimer(*this) {}
 
     // dtor
     ~SystemStatusOsObserver();
@@ -148,10 +198,19 @@ private:
     SystemStatus*                                    mSystemStatus;
     ObserverContext                                  mContext;
     const string                                     mAddress;
-    ClientToDataItems                                mClientToDataItems;
-    DataItemToClients                                mDataItemToClients;
+    DataItemSubscriptions                            mSubscriptions;
     DataItemIdToCore                                 mDataItemCache;
     DataItemIdToInt                                  mActiveRequestCount;
+    // Data items updated in the cache but not yet sent to clients
+    DataItemIdSet                                    mPendingNotifyIds;
+
+    // Flushes mPendingNotifyIds once the coalescing window expires
+    class NotifyCoalesceTimer : public LocTimer {
+        SystemStatusOsObserver& mObserver;
+    public:
+        NotifyCoalesceTimer(SystemStatusOsObserver& observer) : mObserver(observer) {}
+        void timeOutCallback() override;
+    } mNotifyCoalesceTimer;
 
     // Cache the subscribe and requestData till subscription obj is obtained
     void cacheObserverRequest(ObserverReqCache& reqCache,
@@ -164,12 +223,18 @@ private:
     void subscribe(const list<DataItemId>& l, IDataItemObserver* client, bool toRequestData);
 
     // Helpers
-    void sendCachedDataItems(const unordered_set<DataItemId>& s, IDataItemObserver* to);
-    bool updateCache(IDataItemCore* d);
-    inline void logMe(const unordered_set<DataItemId>& l) {
+    void sendCachedDataItems(const DataItemIdSet& s, IDataItemObserver* to);
+    bool updateCache(const shared_ptr<IDataItemCore>& d);
+    void coalesceNotify(const DataItemIdSet& s);
+    void notifyClients(const DataItemIdSet& s);
+    static DataItemIdSet toDataItemIdSet(const list<DataItemId>& l);
+    static list<DataItemId> toDataItemIdList(const DataItemIdSet& s);
+    inline void logMe(const DataItemIdSet& s) {
         IF_LOC_LOGD {
-            for (auto id : l) {
-                LOC_LOGD("DataItem %d", id);
+            for (size_t id = 0; id < s.size(); id++) {
+                if (s.test(id)) {
+                    LOC_LOGD("DataItem %zu", id);
+                }
             }
         }
     }
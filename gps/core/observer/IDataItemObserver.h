@@ -31,6 +31,7 @@
 #define __IDATAITEMOBSERVER_H__
 
 #include  <list>
+#include <memory>
 #include <string>
 
 using namespace std;
@@ -64,6 +65,23 @@ public:
      */
     virtual void notify (const std :: list <IDataItemCore *> & dlist)  = 0;
 
+    /**
+     * @brief Notify updated values of Data Items, shared
+     * @details Notifys updated values of Data items. The items are immutable
+     *          snapshots shared with the sender and its other observers, so an
+     *          observer that keeps them past the call can hold on to them
+     *          instead of copying them. By default they go to notify.
+     *
+     * @param dlist List of updated data items
+     */
+    virtual void notifyShared (const std :: list <std :: shared_ptr <IDataItemCore>> & dlist) {
+        std :: list <IDataItemCore *> l;
+        for (auto & each : dlist) {
+            l.push_back (each.get ());
+        }
+        notify (l);
+    }
+
     /**
      * @brief Destructor
      * @details Destructor
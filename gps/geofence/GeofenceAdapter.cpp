@@ -29,19 +29,57 @@
 #define LOG_TAG "LocSvc_GeofenceAdapter"
 
 #include <GeofenceAdapter.h>
+#include <SystemStatus.h>
 #include "loc_log.h"
 #include <log_util.h>
 #include <string>
+#include <math.h>
+#include <algorithm>
+#include <loc_misc_utils.h>
 
 using namespace loc_core;
 
+/* haversine distance in meters from the location to the center of the geofence */
+static double
+geofenceCenterDistance(const Location& location, double cosLat, const GeofenceObject& object)
+{
+    double latRad = location.latitude * M_PI / 180.0;
+    double fenceLatRad = object.latitude * M_PI / 180.0;
+    double sinDLat = sin((fenceLatRad - latRad) / 2.0);
+    double sinDLon = sin((object.longitude - location.longitude) * M_PI / 360.0);
+    double a = sinDLat * sinDLat + cosLat * cos(fenceLatRad) * sinDLon * sinDLon;
+    return 2.0 * GEOFENCE_SW_EARTH_RADIUS_M * asin(sqrt(std::min(a, 1.0)));
+}
+
 GeofenceAdapter::GeofenceAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   true /*isMaster*/, nullptr, true)
+                   true /*isMaster*/, nullptr, true, "Loc_geofence"),
+    mSwGeofenceEnabled(false),
+    mNextSwHwId(GEOFENCE_SW_HWID_BASE),
+    mBreachesPending(false),
+    mBreachCoalesceTimer(*this),
+    mResponsivenessScale(1),
+    mAdaptiveMaxScale(1),
+    mPowerPolicy(SystemStatus::getInstance(mMsgTask)->getOsObserver(),
+                 "GeofenceAdapterPowerPolicy",
+                 [this] (const LocPowerProfile& profile) {
+                     mMsgTask->sendMsg([this, profile] { applyPowerProfile(profile); });
+                 })
 {
     LOC_LOGD("%s]: Constructor", __func__);
 
+    mSwGeofenceEnabled = (0 != ContextBase::mGps_conf.GEOFENCE_SW_OVERFLOW_ENABLED);
+    // powers of two only, so the scale moves a step at a time
+    while (mAdaptiveMaxScale * 2 <= ContextBase::mGps_conf.GEOFENCE_ADAPTIVE_MAX_SCALE) {
+        mAdaptiveMaxScale *= 2;
+    }
+    // no SV, NMEA or measurement reports are consumed here, and positions
+    // only to evaluate the fences the engine had no room for and to adapt
+    // the responsiveness of the others
+    setReportMask((mSwGeofenceEnabled || mAdaptiveMaxScale > 1) ?
+                  LOC_ADAPTER_REPORT_BIT(LOC_ADAPTER_REPORT_POSITION) : 0);
+
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
     doneInit();
@@ -53,26 +91,25 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
     LOC_LOGD("%s]: client %p", __func__, client);
 
 
-    for (auto it = mGeofenceIds.begin(); it != mGeofenceIds.end();) {
+    for (auto it = mGeofenceIds.lower_bound(GeofenceKey(client, 0));
+            it != mGeofenceIds.end() && client == it->first.client;) {
         uint32_t hwId = it->second;
         GeofenceKey key(it->first);
-        if (client == key.client) {
-            it = mGeofenceIds.erase(it);
-            mLocApi->removeGeofence(hwId, key.id,
-                    new LocApiResponse(*getContext(),
-                    [this, hwId] (LocationError err) {
-                if (LOCATION_ERROR_SUCCESS == err) {
-                    auto it2 = mGeofences.find(hwId);
-                    if (it2 != mGeofences.end()) {
-                        mGeofences.erase(it2);
-                    } else {
-                        LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
-                    }
+        it = mGeofenceIds.erase(it);
+        removeGeofence(hwId, key.id,
+                new LocApiResponse(getMsgTask(),
+                [this, hwId] (LocationError err) {
+            if (LOCATION_ERROR_SUCCESS == err) {
+                mSwGeofences.erase(hwId);
+                dropPendingBreaches(hwId);
+                auto it2 = mGeofences.find(hwId);
+                if (it2 != mGeofences.end()) {
+                    mGeofences.erase(it2);
+                } else {
+                    LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
                 }
-            }));
-            continue;
-        }
-        ++it; // increment only when not erasing an iterator
+            }
+        }));
     }
 
 }
@@ -127,7 +164,9 @@ GeofenceAdapter::handleEngineUpEvent()
         virtual void proc() const {
             mAdapter.setEngineCapabilitiesKnown(true);
             mAdapter.broadcastCapabilities(mAdapter.getCapabilities());
+            mAdapter.beginReplay();
             mAdapter.restartGeofences();
+            mAdapter.endReplay();
             for (auto msg: mAdapter.mPendingMsgs) {
                 mAdapter.sendMsg(msg);
             }
@@ -149,6 +188,7 @@ GeofenceAdapter::restartGeofences()
     mGeofences.clear();
     mGeofenceIds.clear();
 
+    uint32_t generation = getReplayGeneration();
     for (auto it = oldGeofences.begin(); it != oldGeofences.end(); it++) {
         GeofenceObject object = it->second;
         GeofenceOption options = {sizeof(GeofenceOption),
@@ -159,18 +199,30 @@ GeofenceAdapter::restartGeofences()
                              object.latitude,
                              object.longitude,
                              object.radius};
+        if (isSwGeofence(it->first)) {
+            // not in the engine, nothing to replay
+            saveGeofenceItem(object.key.client, object.key.id, it->first, options, info);
+            if (true == object.paused) {
+                pauseGeofenceItem(it->first);
+            }
+            continue;
+        }
+        replayRequestSent();
         mLocApi->addGeofence(object.key.id,
-                              options,
+                              engineGeofenceOption(options),
                               info,
-                              new LocApiResponseData<LocApiGeofenceData>(*getContext(),
-                [this, object, options, info] (LocationError err, LocApiGeofenceData data) {
+                              new LocApiResponseData<LocApiGeofenceData>(getMsgTask(),
+                [this, object, options, info, generation] (LocationError err,
+                                                           LocApiGeofenceData data) {
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (true == object.paused) {
+                    // counted before the add response, to keep the replay open for it
                     mLocApi->pauseGeofence(data.hwId, object.key.id,
-                            new LocApiResponse(*getContext(), [] (LocationError err ) {}));
+                            newReplayResponse());
                 }
                 saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
             }
+            replayResponseReceived(generation, err);
         }));
     }
 }
@@ -238,19 +290,25 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            // the items complete in any order, the last one sends the response
+            size_t* remaining = new size_t(mCount);
             for (size_t i=0; i < mCount; ++i) {
                 if (NULL == mIds || NULL == mOptions || NULL == mInfos) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
                 } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    mApi.addToCallQueue(new LocApiResponse(mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
                             mOptions = mOptions, mInfos = mInfos, mIds = mIds, &mApi = mApi,
-                            errs, i] (LocationError err ) {
-                        mApi.addGeofence(mIds[i], mOptions[i], mInfos[i],
-                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
+                            errs, remaining, i] (LocationError err ) {
+                        mApi.addGeofence(mIds[i], mAdapter.engineGeofenceOption(mOptions[i]),
+                        mInfos[i],
+                        new LocApiResponseData<LocApiGeofenceData>(mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mOptions = mOptions, mClient = mClient,
-                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, i]
+                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, remaining, i]
                         (LocationError err, LocApiGeofenceData data) {
+                            if (LOCATION_ERROR_GEOFENCES_AT_MAX == err) {
+                                err = mAdapter.allocSwGeofenceHwId(data.hwId);
+                            }
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.saveGeofenceItem(mClient,
                                 mIds[i],
@@ -261,9 +319,10 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
                             errs[i] = err;
 
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --*remaining) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
+                                delete remaining;
                                 delete[] mIds;
                                 delete[] mOptions;
                                 delete[] mInfos;
@@ -343,34 +402,37 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            size_t* remaining = new size_t(mCount);
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiResponse(mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
+                        errs, remaining, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                     if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.removeGeofence(hwId, mIds[i],
-                        new LocApiResponse(*mAdapter.getContext(),
+                        mAdapter.removeGeofence(hwId, mIds[i],
+                        new LocApiResponse(mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
+                        hwId, errs, remaining, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.removeGeofenceItem(hwId);
                             }
                             errs[i] = err;
 
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --*remaining) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
+                                delete remaining;
                                 delete[] mIds;
                             }
                         }));
                     } else {
                         // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
+                        if (0 == --*remaining) {
                             mAdapter.reportResponse(mClient, mCount, errs, mIds);
                             delete[] errs;
+                            delete remaining;
                             delete[] mIds;
                         }
                     }
@@ -419,33 +481,36 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            size_t* remaining = new size_t(mCount);
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiResponse(mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
+                        errs, remaining, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                     if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getContext(),
+                        mAdapter.pauseGeofence(hwId, mIds[i], new LocApiResponse(mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
+                        hwId, errs, remaining, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.pauseGeofenceItem(hwId);
                             }
                             errs[i] = err;
 
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --*remaining) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
+                                delete remaining;
                                 delete[] mIds;
                             }
                         }));
                     } else {
                         // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
+                        if (0 == --*remaining) {
                             mAdapter.reportResponse(mClient, mCount, errs, mIds);
                             delete[] errs;
+                            delete remaining;
                             delete[] mIds;
                         }
                     }
@@ -494,34 +559,37 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            size_t* remaining = new size_t(mCount);
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiResponse(mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err ) {
+                        errs, remaining, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                     if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.resumeGeofence(hwId, mIds[i],
-                                new LocApiResponse(*mAdapter.getContext(),
+                        mAdapter.resumeGeofence(hwId, mIds[i],
+                                new LocApiResponse(mAdapter.getMsgTask(),
                                 [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, hwId,
-                                errs, mIds = mIds, i] (LocationError err ) {
+                                errs, remaining, mIds = mIds, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
-                                errs[i] = err;
-
                                 mAdapter.resumeGeofenceItem(hwId);
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                }
+                            }
+                            errs[i] = err;
+
+                            // Send aggregated response on last item and cleanup
+                            if (0 == --*remaining) {
+                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                                delete[] errs;
+                                delete remaining;
+                                delete[] mIds;
                             }
                         }));
                     } else {
                         // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
+                        if (0 == --*remaining) {
                             mAdapter.reportResponse(mClient, mCount, errs, mIds);
                             delete[] errs;
+                            delete remaining;
                             delete[] mIds;
                         }
                     }
@@ -574,39 +642,42 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
+            size_t* remaining = new size_t(mCount);
             for (size_t i=0; i < mCount; ++i) {
                 if (NULL == mIds || NULL == mOptions) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
                 } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    mApi.addToCallQueue(new LocApiResponse(mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                            &mApi = mApi, mOptions = mOptions, errs, i] (LocationError err ) {
+                            mOptions = mOptions, errs, remaining, i] (LocationError err ) {
                         uint32_t hwId = 0;
                         errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                         if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                            mApi.modifyGeofence(hwId, mIds[i], mOptions[i],
-                                    new LocApiResponse(*mAdapter.getContext(),
+                            mAdapter.modifyGeofence(hwId, mIds[i], mOptions[i],
+                                    new LocApiResponse(mAdapter.getMsgTask(),
                                     [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                                    mIds = mIds, mOptions = mOptions, hwId, errs, i]
+                                    mIds = mIds, mOptions = mOptions, hwId, errs, remaining, i]
                                     (LocationError err ) {
                                 if (LOCATION_ERROR_SUCCESS == err) {
-                                    errs[i] = err;
-
                                     mAdapter.modifyGeofenceItem(hwId, mOptions[i]);
                                 }
+                                errs[i] = err;
+
                                 // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
+                                if (0 == --*remaining) {
                                     mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                     delete[] errs;
+                                    delete remaining;
                                     delete[] mIds;
                                     delete[] mOptions;
                                 }
                             }));
                         } else {
                             // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
+                            if (0 == --*remaining) {
                                 mAdapter.reportResponse(mClient, mCount, errs, mIds);
                                 delete[] errs;
+                                delete remaining;
                                 delete[] mIds;
                                 delete[] mOptions;
                             }
@@ -654,9 +725,13 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
                              info.latitude,
                              info.longitude,
                              info.radius,
-                             false};
+                             false,
+                             1};
     mGeofences[hwId] = object;
     mGeofenceIds[key] = hwId;
+    if (isSwGeofence(hwId)) {
+        mSwGeofences[hwId] = {false, false, 0};
+    }
     dump();
 }
 
@@ -672,6 +747,8 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
         if (it1 != mGeofenceIds.end()) {
             mGeofenceIds.erase(it1);
 
+            mSwGeofences.erase(hwId);
+            dropPendingBreaches(hwId);
             auto it2 = mGeofences.find(hwId);
             if (it2 != mGeofences.end()) {
                 mGeofences.erase(it2);
@@ -703,6 +780,11 @@ GeofenceAdapter::resumeGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = false;
+        // the side of the boundary is found again, as if just added
+        auto it2 = mSwGeofences.find(hwId);
+        if (it2 != mSwGeofences.end()) {
+            it2->second.known = false;
+        }
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to resume not found. hwId %u", __func__, hwId);
@@ -723,6 +805,284 @@ GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options
     }
 }
 
+LocationError
+GeofenceAdapter::allocSwGeofenceHwId(uint32_t& hwId)
+{
+    if (!mSwGeofenceEnabled) {
+        return LOCATION_ERROR_GEOFENCES_AT_MAX;
+    }
+    while (mGeofences.find(mNextSwHwId) != mGeofences.end()) {
+        mNextSwHwId = (mNextSwHwId + 1) | GEOFENCE_SW_HWID_BASE;
+    }
+    hwId = mNextSwHwId;
+    mNextSwHwId = (mNextSwHwId + 1) | GEOFENCE_SW_HWID_BASE;
+    LOC_LOGD("%s]: engine full, hwId %u evaluated on the AP", __func__, hwId);
+    return LOCATION_ERROR_SUCCESS;
+}
+
+void
+GeofenceAdapter::removeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse)
+{
+    if (isSwGeofence(hwId)) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    } else {
+        mLocApi->removeGeofence(hwId, clientId, adapterResponse);
+    }
+}
+
+void
+GeofenceAdapter::pauseGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse)
+{
+    if (isSwGeofence(hwId)) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    } else {
+        mLocApi->pauseGeofence(hwId, clientId, adapterResponse);
+    }
+}
+
+void
+GeofenceAdapter::resumeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse)
+{
+    if (isSwGeofence(hwId)) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    } else {
+        mLocApi->resumeGeofence(hwId, clientId, adapterResponse);
+    }
+}
+
+void
+GeofenceAdapter::modifyGeofence(uint32_t hwId, uint32_t clientId, const GeofenceOption& options,
+        LocApiResponse* adapterResponse)
+{
+    if (isSwGeofence(hwId)) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    } else {
+        auto it = mGeofences.find(hwId);
+        uint32_t adaptiveScale = (it != mGeofences.end()) ? it->second.adaptiveScale : 1;
+        mLocApi->modifyGeofence(hwId, clientId, engineGeofenceOption(options, adaptiveScale),
+                                adapterResponse);
+    }
+}
+
+GeofenceOption
+GeofenceAdapter::engineGeofenceOption(const GeofenceOption& options,
+                                      uint32_t adaptiveScale) const
+{
+    GeofenceOption engineOptions = options;
+    uint64_t scale = (uint64_t)mResponsivenessScale * adaptiveScale;
+    if (scale > 1) {
+        uint64_t responsiveness = (uint64_t)options.responsiveness * scale;
+        engineOptions.responsiveness =
+                (uint32_t)std::min(responsiveness, (uint64_t)UINT32_MAX);
+    }
+    return engineOptions;
+}
+
+void
+GeofenceAdapter::applyPowerProfile(const LocPowerProfile& profile)
+{
+    if (profile.geofenceResponsivenessScale == mResponsivenessScale) {
+        return;
+    }
+    LOC_LOGD("%s]: responsiveness scale %u -> %u", __func__,
+             mResponsivenessScale, profile.geofenceResponsivenessScale);
+    mResponsivenessScale = profile.geofenceResponsivenessScale;
+
+    // the geofences already in the engine follow, the stored options stay as requested
+    for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
+        if (isSwGeofence(it->first)) {
+            continue;
+        }
+        GeofenceOption options = {sizeof(GeofenceOption),
+                                  it->second.breachMask,
+                                  it->second.responsiveness,
+                                  it->second.dwellTime};
+        uint32_t hwId = it->first;
+        mLocApi->modifyGeofence(hwId, it->second.key.id,
+                engineGeofenceOption(options, it->second.adaptiveScale),
+                new LocApiResponse(getMsgTask(), [hwId] (LocationError err) {
+            if (LOCATION_ERROR_SUCCESS != err) {
+                LOC_LOGE("%s]: responsiveness of hwId %u not updated, err %u",
+                         __func__, hwId, err);
+            }
+        }));
+    }
+}
+
+void
+GeofenceAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
+                                     const GpsLocationExtended& /*locationExtended*/,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask techMask,
+                                     GnssDataNotification* /*pDataNotify*/,
+                                     int /*msInWeek*/)
+{
+    if (LOC_SESS_SUCCESS != status ||
+            !(LOC_GPS_LOCATION_HAS_LAT_LONG & ulpLocation.gpsLocation.flags)) {
+        return;
+    }
+
+    struct MsgGeofencePosition : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        Location mLocation;
+        inline MsgGeofencePosition(GeofenceAdapter& adapter,
+                                   const Location& location) :
+            LocMsg(),
+            mAdapter(adapter),
+            mLocation(location) {}
+        inline virtual void proc() const {
+            mAdapter.evaluateSwGeofences(mLocation);
+            mAdapter.adaptGeofences(mLocation);
+        }
+    };
+
+    Location location;
+    memset(&location, 0, sizeof(Location));
+    location.size = sizeof(Location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT;
+    location.latitude = ulpLocation.gpsLocation.latitude;
+    location.longitude = ulpLocation.gpsLocation.longitude;
+    if (LOC_GPS_LOCATION_HAS_ALTITUDE & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_ALTITUDE_BIT;
+        location.altitude = ulpLocation.gpsLocation.altitude;
+    }
+    if (LOC_GPS_LOCATION_HAS_SPEED & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_SPEED_BIT;
+        location.speed = ulpLocation.gpsLocation.speed;
+    }
+    if (LOC_GPS_LOCATION_HAS_BEARING & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_BEARING_BIT;
+        location.bearing = ulpLocation.gpsLocation.bearing;
+    }
+    if (LOC_GPS_LOCATION_HAS_ACCURACY & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_ACCURACY_BIT;
+        location.accuracy = ulpLocation.gpsLocation.accuracy;
+    }
+    location.timestamp = ulpLocation.gpsLocation.timestamp;
+    if (LOC_POS_TECH_MASK_SATELLITE & techMask) {
+        location.techMask |= LOCATION_TECHNOLOGY_GNSS_BIT;
+    }
+
+    sendMsg(new MsgGeofencePosition(*this, location));
+}
+
+void
+GeofenceAdapter::evaluateSwGeofences(const Location& location)
+{
+    if (mSwGeofences.empty()) {
+        return;
+    }
+
+    uint64_t nowMs = getBootTimeMilliSec();
+    double cosLat = cos(location.latitude * M_PI / 180.0);
+    std::vector<uint32_t> entered;
+    std::vector<uint32_t> exited;
+
+    for (auto it = mSwGeofences.begin(); it != mSwGeofences.end(); ++it) {
+        SwGeofenceState& state = it->second;
+        // still too far from its boundary to have crossed it since
+        if (state.known && nowMs < state.nextEvalMs) {
+            continue;
+        }
+        auto it2 = mGeofences.find(it->first);
+        if (it2 == mGeofences.end() || it2->second.paused) {
+            continue;
+        }
+        const GeofenceObject& object = it2->second;
+
+        double distance = geofenceCenterDistance(location, cosLat, object);
+        double margin = fabs(distance - object.radius) - location.accuracy;
+
+        // the side is not changed while the fix is not clear of the boundary
+        if (margin <= 0.0) {
+            continue;
+        }
+        bool inside = (distance < object.radius);
+        if (inside && (!state.known || !state.inside) &&
+                (object.breachMask & GEOFENCE_BREACH_ENTER_BIT)) {
+            entered.push_back(it->first);
+        } else if (!inside && state.known && state.inside &&
+                (object.breachMask & GEOFENCE_BREACH_EXIT_BIT)) {
+            exited.push_back(it->first);
+        }
+        state.known = true;
+        state.inside = inside;
+        state.nextEvalMs = nowMs + (uint64_t)(margin * 1000.0 / GEOFENCE_SW_MAX_SPEED_MPS);
+    }
+
+    if (!entered.empty()) {
+        geofenceBreach(entered.size(), entered.data(), location,
+                       GEOFENCE_BREACH_ENTER, location.timestamp);
+    }
+    if (!exited.empty()) {
+        geofenceBreach(exited.size(), exited.data(), location,
+                       GEOFENCE_BREACH_EXIT, location.timestamp);
+    }
+}
+
+void
+GeofenceAdapter::adaptGeofences(const Location& location)
+{
+    if (mAdaptiveMaxScale <= 1) {
+        return;
+    }
+
+    double speed = GEOFENCE_ADAPTIVE_MIN_SPEED_MPS;
+    if ((LOCATION_HAS_SPEED_BIT & location.flags) && location.speed > speed) {
+        speed = location.speed;
+    }
+    double cosLat = cos(location.latitude * M_PI / 180.0);
+    std::vector<uint32_t> changed;
+
+    for (auto it = mGeofences.begin(); it != mGeofences.end(); ++it) {
+        GeofenceObject& object = it->second;
+        if (isSwGeofence(it->first) || object.paused || 0 == object.responsiveness) {
+            continue;
+        }
+        double distance = geofenceCenterDistance(location, cosLat, object);
+        double margin = fabs(distance - object.radius) - location.accuracy;
+        double reachMs = (margin > 0.0) ? margin * 1000.0 / speed : 0.0;
+
+        // the engine is to look at the fence at least twice before the
+        // boundary can be reached
+        uint32_t scale = 1;
+        while (scale * 2 <= mAdaptiveMaxScale &&
+                (double)object.responsiveness * scale * 4 <= reachMs) {
+            scale *= 2;
+        }
+        // tightened at once, relaxed only a step short of the new scale, so
+        // that a fix going back and forth across a step does not flip it
+        if (scale < object.adaptiveScale) {
+            object.adaptiveScale = scale;
+        } else if (scale >= object.adaptiveScale * 4) {
+            object.adaptiveScale = scale / 2;
+        } else {
+            continue;
+        }
+        changed.push_back(it->first);
+    }
+
+    if (changed.empty()) {
+        return;
+    }
+    LOC_LOGD("%s]: responsiveness of %zu geofences adapted", __func__, changed.size());
+    for (uint32_t hwId : changed) {
+        const GeofenceObject& object = mGeofences[hwId];
+        GeofenceOption options = {sizeof(GeofenceOption),
+                                  object.breachMask,
+                                  object.responsiveness,
+                                  object.dwellTime};
+        uint32_t adaptiveScale = object.adaptiveScale;
+        mLocApi->modifyGeofence(hwId, object.key.id,
+                engineGeofenceOption(options, adaptiveScale),
+                new LocApiResponse(getMsgTask(), [hwId, adaptiveScale] (LocationError err) {
+            if (LOCATION_ERROR_SUCCESS != err) {
+                LOC_LOGE("%s]: responsiveness of hwId %u not scaled by %u, err %u",
+                         __func__, hwId, adaptiveScale, err);
+            }
+        }));
+    }
+}
 
 void
 GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
@@ -787,23 +1147,111 @@ void
 GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
         GeofenceBreachType breachType, uint64_t timestamp)
 {
+    uint32_t windowMs = ContextBase::mGps_conf.GEOFENCE_BREACH_COALESCE_MS;
 
-    for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        uint32_t* clientIds = new uint32_t[count];
-        if (nullptr == clientIds) {
-            return;
+    if (0 == windowMs && !mBreachesPending) {
+        notifyGeofenceBreach(count, hwIds, location, breachType, timestamp);
+        return;
+    }
+    if (breachType > GEOFENCE_BREACH_UNKNOWN) {
+        breachType = GEOFENCE_BREACH_UNKNOWN;
+    }
+
+    // Breaches of the same type within the window reach the clients in one
+    // callback, with the location of the latest one. An enter or exit replaces
+    // the opposite one of the same fence still pending, only the last is kept.
+    PendingGeofenceBreach& pending = mPendingBreaches[breachType];
+    for (size_t i=0; i < count; ++i) {
+        if (GEOFENCE_BREACH_ENTER == breachType) {
+            mPendingBreaches[GEOFENCE_BREACH_EXIT].hwIds.erase(hwIds[i]);
+        } else if (GEOFENCE_BREACH_EXIT == breachType) {
+            mPendingBreaches[GEOFENCE_BREACH_ENTER].hwIds.erase(hwIds[i]);
+        }
+        pending.hwIds.insert(hwIds[i]);
+    }
+    pending.location = location;
+    pending.timestamp = timestamp;
+
+    if (!mBreachesPending) {
+        mBreachesPending = true;
+        mBreachCoalesceTimer.start(windowMs, false);
+    }
+}
+
+// Called in the context of LocTimer thread
+void
+GeofenceAdapter::BreachCoalesceTimer::timeOutCallback()
+{
+    struct MsgFlushGeofenceBreaches : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        inline MsgFlushGeofenceBreaches(GeofenceAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.flushGeofenceBreaches();
+        }
+    };
+
+    mAdapter.sendMsg(new MsgFlushGeofenceBreaches(mAdapter));
+}
+
+void
+GeofenceAdapter::flushGeofenceBreaches()
+{
+    mBreachesPending = false;
+    for (int type = GEOFENCE_BREACH_ENTER; type <= GEOFENCE_BREACH_UNKNOWN; ++type) {
+        PendingGeofenceBreach& pending = mPendingBreaches[type];
+        if (pending.hwIds.empty()) {
+            continue;
+        }
+        std::vector<uint32_t> hwIds(pending.hwIds.begin(), pending.hwIds.end());
+        pending.hwIds.clear();
+        notifyGeofenceBreach(hwIds.size(), hwIds.data(), pending.location,
+                             (GeofenceBreachType)type, pending.timestamp);
+    }
+}
+
+void
+GeofenceAdapter::dropPendingBreaches(uint32_t hwId)
+{
+    if (mBreachesPending) {
+        for (int type = GEOFENCE_BREACH_ENTER; type <= GEOFENCE_BREACH_UNKNOWN; ++type) {
+            mPendingBreaches[type].hwIds.erase(hwId);
+        }
+    }
+}
+
+void
+GeofenceAdapter::notifyGeofenceBreach(size_t count, const uint32_t* hwIds,
+        const Location& location, GeofenceBreachType breachType, uint64_t timestamp)
+{
+
+    // the keys are looked up once for all the clients
+    GeofenceKey* keys = new GeofenceKey[count];
+    uint32_t* clientIds = new uint32_t[count];
+    if (nullptr == keys || nullptr == clientIds) {
+        delete[] keys;
+        delete[] clientIds;
+        return;
+    }
+    size_t keyCount = 0;
+    for (size_t i=0; i < count; ++i) {
+        if (LOCATION_ERROR_SUCCESS == getGeofenceKeyFromHwId(hwIds[i], keys[keyCount])) {
+            ++keyCount;
+        }
+    }
+
+    for (auto it = mClientData.begin(); keyCount > 0 && it != mClientData.end(); ++it) {
+        if (it->second.geofenceBreachCb == nullptr) {
+            continue;
         }
         uint32_t index = 0;
-        for (size_t i=0; i < count; ++i) {
-            GeofenceKey key;
-            LocationError err = getGeofenceKeyFromHwId(hwIds[i], key);
-            if (LOCATION_ERROR_SUCCESS == err) {
-                if (key.client == it->first) {
-                    clientIds[index++] = key.id;
-                }
+        for (size_t i=0; i < keyCount; ++i) {
+            if (keys[i].client == it->first) {
+                clientIds[index++] = keys[i].id;
             }
         }
-        if (index > 0 && it->second.geofenceBreachCb != nullptr) {
+        if (index > 0) {
             GeofenceBreachNotification notify = {sizeof(GeofenceBreachNotification),
                                                  index,
                                                  clientIds,
@@ -813,8 +1261,9 @@ GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& l
 
             it->second.geofenceBreachCb(notify);
         }
-        delete[] clientIds;
     }
+    delete[] keys;
+    delete[] clientIds;
 }
 
 void
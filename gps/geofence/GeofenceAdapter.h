@@ -32,7 +32,11 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <LocTimer.h>
+#include <LocPowerPolicy.h>
 #include <map>
+#include <set>
+#include <vector>
 
 using namespace loc_core;
 
@@ -52,8 +56,9 @@ typedef struct GeofenceKey {
     inline GeofenceKey(LocationAPI* _client, uint32_t _id) :
         client(_client), id(_id) {}
 } GeofenceKey;
+// ordered by client first, so the fences of a client are next to each other
 inline bool operator <(GeofenceKey const& left, GeofenceKey const& right) {
-    return left.id < right.id || (left.id == right.id && left.client < right.client);
+    return left.client < right.client || (left.client == right.client && left.id < right.id);
 }
 inline bool operator ==(GeofenceKey const& left, GeofenceKey const& right) {
     return left.id == right.id && left.client == right.client;
@@ -70,15 +75,58 @@ typedef struct {
     double longitude;
     double radius;
     bool paused;
+    uint32_t adaptiveScale; // engine responsiveness relaxed by this while far from the boundary
 } GeofenceObject;
 typedef std::map<uint32_t, GeofenceObject> GeofencesMap; //map of hwId to GeofenceObject
 typedef std::map<GeofenceKey, uint32_t> GeofenceIdMap; //map of GeofenceKey to hwId
 
+/* hwIds of the geofences evaluated on the AP, out of the range of the engine hwIds */
+#define GEOFENCE_SW_HWID_BASE 0x80000000
+#define GEOFENCE_SW_EARTH_RADIUS_M 6371009.0
+/* the fastest the device is assumed to move toward a boundary */
+#define GEOFENCE_SW_MAX_SPEED_MPS 50.0
+/* the slowest the device is assumed to move toward a boundary, even if at rest */
+#define GEOFENCE_ADAPTIVE_MIN_SPEED_MPS 5.0
+typedef struct {
+    bool known; // side of the boundary found yet
+    bool inside;
+    uint64_t nextEvalMs; // boot time before which the boundary can not be reached
+} SwGeofenceState;
+typedef std::map<uint32_t, SwGeofenceState> SwGeofencesMap; //map of hwId to SwGeofenceState
+/* breaches of one type waiting for the end of the coalescing window */
+typedef struct {
+    std::set<uint32_t> hwIds;
+    Location location; // of the latest breach
+    uint64_t timestamp; // of the latest breach
+} PendingGeofenceBreach;
+
 class GeofenceAdapter : public LocAdapterBase {
 
     /* ==== GEOFENCES ====================================================================== */
     GeofencesMap mGeofences; //map hwId to GeofenceObject
     GeofenceIdMap mGeofenceIds; //map of GeofenceKey to hwId
+    bool mSwGeofenceEnabled;
+    uint32_t mNextSwHwId;
+    SwGeofencesMap mSwGeofences; //map hwId to state of the geofences evaluated on the AP
+    PendingGeofenceBreach mPendingBreaches[GEOFENCE_BREACH_UNKNOWN + 1]; //indexed by breach type
+    bool mBreachesPending;
+
+    // Flushes mPendingBreaches once the coalescing window expires
+    class BreachCoalesceTimer : public LocTimer {
+        GeofenceAdapter& mAdapter;
+    public:
+        BreachCoalesceTimer(GeofenceAdapter& adapter) : mAdapter(adapter) {}
+        void timeOutCallback() override;
+    } mBreachCoalesceTimer;
+
+    // engine responsiveness is the requested one times this, per the power profile
+    uint32_t mResponsivenessScale;
+    // largest adaptiveScale of an engine geofence, 1 if not adaptive
+    uint32_t mAdaptiveMaxScale;
+    LocPowerPolicy mPowerPolicy;
+    void applyPowerProfile(const LocPowerProfile& profile);
+    GeofenceOption engineGeofenceOption(const GeofenceOption& options,
+                                        uint32_t adaptiveScale = 1) const;
 
 protected:
 
@@ -121,15 +169,38 @@ public:
     LocationError getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint32_t& hwId);
     LocationError getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key);
     void dump();
+    /* ======== SW GEOFENCES ====(overflow of the engine table, evaluated on the AP)===== */
+    inline bool isSwGeofence(uint32_t hwId) const {
+        return (hwId & GEOFENCE_SW_HWID_BASE) != 0;
+    }
+    LocationError allocSwGeofenceHwId(uint32_t& hwId);
+    void removeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    void pauseGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    void resumeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    void modifyGeofence(uint32_t hwId, uint32_t clientId, const GeofenceOption& options,
+                        LocApiResponse* adapterResponse);
+    void evaluateSwGeofences(const Location& location);
+    /* ======== ADAPTIVE RESPONSIVENESS ====(engine geofences, from the distance)======== */
+    void adaptGeofences(const Location& location);
 
     /* ==== REPORTS ======================================================================== */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
+    virtual void reportPositionEvent(const UlpLocation& ulpLocation,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask techMask,
+                                     GnssDataNotification* pDataNotify = nullptr,
+                                     int msInWeek = -1);
     void geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
                              GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatusEvent(GeofenceStatusAvailable available);
     /* ======== UTILITIES ================================================================== */
     void geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
                         GeofenceBreachType breachType, uint64_t timestamp);
+    void flushGeofenceBreaches();
+    void dropPendingBreaches(uint32_t hwId);
+    void notifyGeofenceBreach(size_t count, const uint32_t* hwIds, const Location& location,
+                              GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatus(GeofenceStatusAvailable available);
 };
 
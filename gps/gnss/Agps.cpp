@@ -350,6 +350,15 @@ void AgpsStateMachine::notifyEventToSubscriber(
             "SM %p, Event %d Subscriber %p Delete %d",
             this, event, subscriberToNotify, deleteSubscriberPostNotify);
 
+    if (AGPS_PRECONNECT_CONN_HANDLE == subscriberToNotify->mConnHandle) {
+        /* the engine never asked for this one */
+        LOC_LOGD("preconnect subscriber, event %d", event);
+        if (deleteSubscriberPostNotify) {
+            deleteSubscriber(subscriberToNotify);
+        }
+        return;
+    }
+
     switch (event) {
 
         case AGPS_EVENT_GRANTED:
@@ -661,10 +670,49 @@ void AgpsManager::reportAtlClosed(AGpsExtType agpsType){
     sm->processAgpsEvent(AGPS_EVENT_RELEASED);
 }
 
+void AgpsManager::preconnect(bool enable){
+
+    LOC_LOGD("AgpsManager::preconnect(): enable %d preconnected %d", enable, mPreconnected);
+
+    if (enable == mPreconnected) {
+        return;
+    }
+    if (NULL == mAgnssNif) {
+        LOC_LOGW("No AGNSS NIF to preconnect");
+        return;
+    }
+    mPreconnected = enable;
+
+    if (enable) {
+        bool emergencyPdn =
+                (1 == loc_core::ContextBase::mGps_conf.USE_EMERGENCY_PDN_FOR_EMERGENCY_SUPL);
+        LocApnTypeMask apnTypeMask =
+                emergencyPdn ? LOC_APN_TYPE_MASK_EMERGENCY : LOC_APN_TYPE_MASK_SUPL;
+        /* a request of the engine in progress keeps its type */
+        if (NULL == mAgnssNif->getFirstSubscriber(false) &&
+                NULL == mAgnssNif->getFirstSubscriber(true)) {
+            mAgnssNif->setType(emergencyPdn ? LOC_AGPS_TYPE_SUPL_ES : LOC_AGPS_TYPE_SUPL);
+            mAgnssNif->setApnTypeMask(apnTypeMask);
+        }
+        AgpsSubscriber subscriber(AGPS_PRECONNECT_CONN_HANDLE, false, false, apnTypeMask);
+        mAgnssNif->setCurrentSubscriber(&subscriber);
+        mAgnssNif->processAgpsEvent(AGPS_EVENT_SUBSCRIBE);
+    } else {
+        /* gone already if the bring-up was denied */
+        AgpsSubscriber* subscriber = mAgnssNif->getSubscriber(AGPS_PRECONNECT_CONN_HANDLE);
+        if (NULL != subscriber) {
+            mAgnssNif->setCurrentSubscriber(subscriber);
+            mAgnssNif->processAgpsEvent(AGPS_EVENT_UNSUBSCRIBE);
+        }
+    }
+}
+
 void AgpsManager::handleModemSSR(){
 
     LOC_LOGD("AgpsManager::handleModemSSR");
 
+    mPreconnected = false;
+
     /* Drop subscribers from all state machines */
     if (mAgnssNif) {
         mAgnssNif->dropAllSubscribers();
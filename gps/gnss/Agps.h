@@ -48,6 +48,10 @@ typedef std::function<void(
 
 typedef std::function<void(int handle, int isSuccess)> AgpsAtlCloseStatusCb;
 
+/* Connection handle of the SUPL data call brought up ahead of the
+ * engine's request; never reported to the engine */
+#define AGPS_PRECONNECT_CONN_HANDLE (-1)
+
 /* Post message to adapter's message queue */
 typedef std::function<void(LocMsg* msg)>     SendMsgToAdapterMsgQueueFn;
 
@@ -243,7 +247,7 @@ public:
     /* CONSTRUCTOR */
     AgpsManager():
         mAtlOpenStatusCb(), mAtlCloseStatusCb(),
-        mAgnssNif(NULL), mInternetNif(NULL)/*, mDsNif(NULL)*/ {}
+        mAgnssNif(NULL), mInternetNif(NULL), mPreconnected(false)/*, mDsNif(NULL)*/ {}
 
     /* Register callbacks */
     inline void registerATLCallbacks(AgpsAtlOpenStatusCb  atlOpenStatusCb,
@@ -268,6 +272,12 @@ public:
     void reportAtlOpenFailed(AGpsExtType agpsType);
     void reportAtlClosed(AGpsExtType agpsType);
 
+    /* Bring the SUPL data call up before the engine asks for it, e.g. as
+     * an emergency session starts, so its assistance download does not
+     * wait for the bring-up. The call is shared with the engine's own
+     * requests and held until preconnect(false). */
+    void preconnect(bool enable);
+
     /* Handle Modem SSR */
     void handleModemSSR();
 
@@ -277,6 +287,7 @@ protected:
     AgpsAtlCloseStatusCb  mAtlCloseStatusCb;
     AgpsStateMachine*   mAgnssNif;
     AgpsStateMachine*   mInternetNif;
+    bool                mPreconnected;
 private:
     /* Fetch state machine for handling request ATL call */
     AgpsStateMachine* getAgpsStateMachine(AGpsExtType agpsType);
@@ -46,25 +46,108 @@
 #include <Agps.h>
 #include <SystemStatus.h>
 #include <vector>
+#include <algorithm>
 #include <loc_misc_utils.h>
+#include <LocConfWatcher.h>
+#include <LocHostResolver.h>
+#include <LocConvUtils.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <gps_extended_c.h>
+#include <LocAtrace.h>
 
 #define RAD2DEG    (180.0 / M_PI)
 #define DEG2RAD    (M_PI / 180.0)
 #define PROCESS_NAME_ENGINE_SERVICE "engine-service"
 #define MIN_TRACKING_INTERVAL (100) // 100 msec
+#define TRACKING_EARTH_RADIUS_M 6371009.0
 
 #define BILLION_NSEC (1000000000ULL)
 #define NMEA_MIN_THRESHOLD_MSEC (99)
 #define NMEA_MAX_THRESHOLD_MSEC (975)
 
 #define DGNSS_RANGE_UPDATE_TIME_10MIN_IN_MILLI  600000
+#define DGNSS_CORRECTION_AGE_LOG_FIXES          600
+#define ENGINE_POSITION_SELECTION_BEST_ACCURACY 1
 
 using namespace loc_core;
 
-static int loadEngHubForExternalEngine = 0;
-static loc_param_s_type izatConfParamTable[] = {
-    {"LOAD_ENGHUB_FOR_EXTERNAL_ENGINE", &loadEngHubForExternalEngine, nullptr,'n'}
+/* logs how long a stage of the HAL start took, as one of them can hold
+   up the adapter thread for the ones queued behind it */
+class InitStageTimer {
+    const char* mStage;
+    uint64_t mStartMs;
+public:
+    inline InitStageTimer(const char* stage) :
+            mStage(stage), mStartMs(getBootTimeMilliSec()) {}
+    inline ~InitStageTimer() {
+        LOC_LOGi("init stage %s took %" PRIu64 " ms", mStage,
+                 getBootTimeMilliSec() - mStartMs);
+    }
+};
+
+/* whether izat.conf asks for libloc_eng_hub.so, from any thread */
+static bool isEngHubRequired(bool& dreIntEnabled) {
+    unsigned int processListLength = 0;
+    loc_process_info_s_type* processInfoList = nullptr;
+    dreIntEnabled = false;
+
+    int rc = loc_read_process_conf(LOC_PATH_IZAT_CONF, &processListLength,
+                                   &processInfoList);
+    if (rc != 0) {
+        LOC_LOGE("%s]: failed to parse conf file", __func__);
+        return false;
+    }
+
+    bool pluginDaemonEnabled = false;
+    // go over the conf table to see whether any plugin daemon is enabled
+    for (unsigned int i = 0; i < processListLength; i++) {
+        if ((strncmp(processInfoList[i].name[0], PROCESS_NAME_ENGINE_SERVICE,
+                     strlen(PROCESS_NAME_ENGINE_SERVICE)) == 0) &&
+            (processInfoList[i].proc_status == ENABLED)) {
+            pluginDaemonEnabled = true;
+            // check if this is DRE-INT engine
+            if ((processInfoList[i].args[1]!= nullptr) &&
+                (strncmp(processInfoList[i].args[1], "DRE-INT", sizeof("DRE-INT")) == 0)) {
+                dreIntEnabled = true;
+                break;
+            }
+        }
+    }
+    if (processInfoList != nullptr) {
+        free (processInfoList);
+    }
+
+    // no plugin daemon is enabled for this platform,
+    // check if external engine is present for which we need
+    // libloc_eng_hub.so to be loaded
+    if (pluginDaemonEnabled == false) {
+        int loadEngHubForExternalEngine = 0;
+        loc_param_s_type izatConfParamTable[] = {
+            {"LOAD_ENGHUB_FOR_EXTERNAL_ENGINE", &loadEngHubForExternalEngine, nullptr,'n'}
+        };
+        UTIL_READ_CONF(LOC_PATH_IZAT_CONF, izatConfParamTable);
+        return (0 != loadEngHubForExternalEngine);
+    }
+    return true;
+}
+
+/* Loads libloc_eng_hub.so and the engine libraries it links on a thread of
+   its own at HAL start, while the adapter thread reads the config and the
+   LocApi thread opens the QMI service. The handle stays open, so that the
+   dlopen of initEngHubProxy then only takes a reference. */
+class EngHubPrefetchRunnable : public LocRunnable {
+public:
+    inline virtual bool run() override {
+        InitStageTimer stageTimer("engine hub prefetch");
+        bool dreIntEnabled = false;
+        if (isEngHubRequired(dreIntEnabled) &&
+                nullptr == dlopen("libloc_eng_hub.so", RTLD_NOW)) {
+            LOC_LOGd("libloc_eng_hub.so not prefetched");
+        }
+        return false;
+    }
+    inline virtual void interrupt() override {}
 };
 
 /* Method to fetch status cb from loc_net_iface library */
@@ -98,6 +181,10 @@ GnssAdapter::GnssAdapter() :
     mCdfwInterface(nullptr),
     mDGnssNeedReport(false),
     mDGnssDataUsage(false),
+    mDbtEngineSessionId(0),
+    mDbtEngineOptions(),
+    mInCommandBatch(false),
+    mClientsEventMaskPending(false),
     mLocPositionMode(),
     mNHzNeeded(false),
     mSPEAlreadyRunningAtHighestInterval(false),
@@ -106,6 +193,7 @@ GnssAdapter::GnssAdapter() :
     mControlCallbacks(),
     mAfwControlId(0),
     mNmeaMask(0),
+    mModemNmeaMask(0),
     mGnssSvIdConfig(),
     mGnssSeconaryBandConfig(),
     mGnssSvTypeConfig(),
@@ -113,10 +201,14 @@ GnssAdapter::GnssAdapter() :
     mLocConfigInfo{},
     mNiData(),
     mAgpsManager(),
+    mAgpsPreconnectTimer(*this),
     mOdcpiRequestCb(nullptr),
     mOdcpiRequestActive(false),
     mOdcpiTimer(this),
     mOdcpiRequest(),
+    mOdcpiFrameworkRequested(false),
+    mOdcpiCachedLocation(),
+    mOdcpiCachedTimeMs(0),
     mCallbackPriority(OdcpiPrioritytype::ODCPI_HANDLER_PRIORITY_LOW),
     mSystemStatus(SystemStatus::getInstance(mMsgTask)),
     mServerUrl(":"),
@@ -127,20 +219,41 @@ GnssAdapter::GnssAdapter() :
     mNfwCb(NULL),
     mPowerOn(false),
     mAllowFlpNetworkFixes(0),
-    mGnssEnergyConsumedCb(nullptr),
+    mLatencyTrace{},
+    mGnssEnergyConsumedCbs(),
+    mGnssEnergyConsumedQueryTimeMs(0),
+    mGnssEnergyConsumed(0),
+    mGnssEnergyConsumedTimeMs(0),
     mPowerStateCb(nullptr),
     mIsE911Session(NULL),
     mGnssMbSvIdUsedInPosition{},
     mGnssMbSvIdUsedInPosAvail(false),
+    mGsvReportCount(0),
+    mDataWanted(false),
+    mMeasurementsAgcWanted(false),
     mSupportNfwControl(true),
     mSystemPowerState(POWER_STATE_UNKNOWN),
+    mTrackingSuspended(false),
     mIsMeasCorrInterfaceOpen(false),
+    mMeasCorrPending{},
+    mMeasCorrDrainQueued(false),
+    mMeasCorrResync(true),
+    mMeasCorrLastSent{},
     mIsAntennaInfoInterfaceOpened(false),
+    mGnssAntennaInformationsLoaded(false),
     mLastDeleteAidingDataTime(0),
+    mWarmStartCacheSavedMs(0),
     mDgnssState(0),
     mSendNmeaConsent(false),
     mDgnssLastNmeaBootTimeMilli(0),
-    mNativeAgpsHandler(mSystemStatus->getOsObserver(), *this)
+    mNativeAgpsHandler(mSystemStatus->getOsObserver(), *this),
+    mPowerPolicy(mSystemStatus->getOsObserver(), "GnssAdapterPowerPolicy",
+                 [this] (const LocPowerProfile& profile) {
+                     mMsgTask->sendMsg([this, profile] { applyPowerProfile(profile); });
+                 }),
+    mPowerProfile(LocPowerPolicy::fullProfile()),
+    mSvReportCount(0),
+    mMeasurementsReportCount(0)
 {
     LOC_LOGD("%s]: Constructor %p", __func__, this);
     mLocPositionMode.mode = LOC_POSITION_MODE_INVALID;
@@ -167,10 +280,18 @@ GnssAdapter::GnssAdapter() :
             };
     mAgpsManager.registerATLCallbacks(atlOpenStatusCb, atlCloseStatusCb);
 
+    mEngHubPrefetchThread.start("EngHubPrefetch", std::make_shared<EngHubPrefetchRunnable>());
     readConfigCommand();
     initDefaultAgpsCommand();
     initEngHubProxyCommand();
 
+    LocConfWatcher::LocConfChangedCb confChangedCb =
+            [this](const char* confFileName, const std::unordered_set<std::string>& changedKeys) {
+                confChangedCommand(confFileName, changedKeys);
+            };
+    LocConfWatcher::getInstance().watch(LOC_PATH_GPS_CONF, confChangedCb);
+    LocConfWatcher::getInstance().watch(LOC_PATH_IZAT_CONF, confChangedCb);
+
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
     doneInit();
@@ -239,6 +360,53 @@ GnssAdapter::checkAndSetSPEToRunforNHz(TrackingOptions & out) {
     return isSPERunningAtHighestInterval;
 }
 
+TrackingOptions
+GnssAdapter::getMultiplexedTrackingOptions(const LocationSessionKey* excludedKey)
+{
+    // options of the session with the smallest interval, with the highest power mode
+    // of the sessions, excluding excludedKey; size is 0 if there is no such session
+    TrackingOptions multiplexedOptions = {};
+    memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
+
+    const LocationSessionKey* key =
+            mTrackingMultiplexer.getSmallestIntervalSession(excludedKey);
+    if (nullptr != key) {
+        auto it = mTimeBasedTrackingSessions.find(*key);
+        if (it != mTimeBasedTrackingSessions.end()) {
+            GnssPowerMode excludedPowerMode = GNSS_POWER_MODE_INVALID;
+            if (nullptr != excludedKey) {
+                auto it2 = mTimeBasedTrackingSessions.find(*excludedKey);
+                if (it2 != mTimeBasedTrackingSessions.end()) {
+                    excludedPowerMode = it2->second.powerMode;
+                }
+            }
+            multiplexedOptions = it->second;
+            multiplexedOptions.powerMode =
+                    mTrackingMultiplexer.getHighestPowerMode(excludedPowerMode);
+        }
+    }
+    return multiplexedOptions;
+}
+
+void
+GnssAdapter::multiplexTrackingOptions(TrackingOptions& multiplexedOptions,
+                                      const TrackingOptions& options)
+{
+    // size of zero means there is no other session to multiplex with
+    if (0 == multiplexedOptions.size) {
+        multiplexedOptions = options;
+    } else {
+        if (options.minInterval < multiplexedOptions.minInterval) {
+            multiplexedOptions.minInterval = options.minInterval;
+        }
+        if (GNSS_POWER_MODE_INVALID != options.powerMode &&
+            (GNSS_POWER_MODE_INVALID == multiplexedOptions.powerMode ||
+             options.powerMode < multiplexedOptions.powerMode)) {
+            multiplexedOptions.powerMode = options.powerMode;
+        }
+    }
+}
+
 
 void
 GnssAdapter::convertLocation(Location& out, const UlpLocation& ulpLocation,
@@ -345,16 +513,7 @@ uint16_t GnssAdapter::getNumSvUsed(uint64_t svUsedIdsMask,
         return 0;
     }
 
-    uint16_t numSvUsed = 0;
-    uint64_t mask = 0x1;
-    for (int i = 0; i < totalSvCntInThisConstellation; i++) {
-        if (svUsedIdsMask & mask) {
-            numSvUsed++;
-        }
-        mask <<= 1;
-    }
-
-    return numSvUsed;
+    return loc_util::countSvUsedInMask(svUsedIdsMask, totalSvCntInThisConstellation);
 }
 
 void
@@ -784,6 +943,22 @@ GnssAdapter::convertSuplMode(const GnssConfigSuplModeMask suplModeMask)
     return mask;
 }
 
+static uint32_t
+getNmeaMaskFromConf(const loc_gps_cfg_s& gpsConf)
+{
+    uint32_t mask = 0;
+    if (NMEA_PROVIDER_MP == gpsConf.NMEA_PROVIDER) {
+        mask |= LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
+        if (gpsConf.NMEA_TAG_BLOCK_GROUPING_ENABLED) {
+            mask |= LOC_NMEA_MASK_TAGBLOCK_V02;
+        }
+    }
+    if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_DEBUG_NMEA_V02)) {
+        mask |= LOC_NMEA_MASK_DEBUG_V02;
+    }
+    return mask;
+}
+
 void
 GnssAdapter::readConfigCommand()
 {
@@ -801,6 +976,7 @@ GnssAdapter::readConfigCommand()
             static bool confReadDone = false;
             if (!confReadDone) {
                 confReadDone = true;
+                InitStageTimer stageTimer("read config");
                 // reads config into mContext->mGps_conf
                 mContext.readConfig();
 
@@ -812,6 +988,7 @@ GnssAdapter::readConfigCommand()
                 UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
                 LOC_LOGd("allowFlpNetworkFixes %u", allowFlpNetworkFixes);
                 mAdapter->setAllowFlpNetworkFixes(allowFlpNetworkFixes);
+                mAdapter->initGnssRecorder();
             }
         }
     };
@@ -821,6 +998,49 @@ GnssAdapter::readConfigCommand()
     }
 }
 
+void
+GnssAdapter::initGnssRecorder()
+{
+    if (ContextBase::mGps_conf.GNSS_RECORDER_ENABLED) {
+        mRecorder.reset(new GnssRecorder(ContextBase::mGps_conf.GNSS_RECORDER_DIR,
+                                         ContextBase::mGps_conf.GNSS_RECORDER_FILE_SIZE_KB,
+                                         ContextBase::mGps_conf.GNSS_RECORDER_FILE_COUNT));
+    }
+}
+
+void
+GnssAdapter::confChangedCommand(const char* confFileName,
+        const std::unordered_set<std::string>& changedKeys)
+{
+    LOC_LOGD("%s]: %s", __func__, confFileName);
+
+    struct MsgConfChanged : public LocMsg {
+        GnssAdapter& mAdapter;
+        const bool mIsGpsConf;
+        const std::unordered_set<std::string> mChangedKeys;
+        inline MsgConfChanged(GnssAdapter& adapter, bool isGpsConf,
+                              const std::unordered_set<std::string>& changedKeys) :
+            LocMsg(),
+            mAdapter(adapter),
+            mIsGpsConf(isGpsConf),
+            mChangedKeys(changedKeys) {}
+        inline virtual void proc() const {
+            if (mIsGpsConf) {
+                mAdapter.applyGpsConfChanges(mChangedKeys);
+            } else {
+                // izat.conf is only looked at when the processes and
+                // engine hub are brought up
+                for (auto& key : mChangedKeys) {
+                    LOC_LOGi("izat.conf %s changed, takes effect on restart", key.c_str());
+                }
+            }
+        }
+    };
+
+    sendMsg(new MsgConfChanged(*this, 0 == strcmp(confFileName, LOC_PATH_GPS_CONF),
+                               changedKeys));
+}
+
 void
 GnssAdapter::setSuplHostServer(const char* server, int port, LocServerType type)
 {
@@ -860,27 +1080,12 @@ GnssAdapter::setConfig()
     LOC_LOGD("%s]: ", __func__);
 
     // set nmea mask type
-    uint32_t mask = 0;
-    if (NMEA_PROVIDER_MP == ContextBase::mGps_conf.NMEA_PROVIDER) {
-        mask |= LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
-        if (ContextBase::mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED) {
-            mask |= LOC_NMEA_MASK_TAGBLOCK_V02;
-        }
-    }
-    if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_DEBUG_NMEA_V02)) {
-        mask |= LOC_NMEA_MASK_DEBUG_V02;
-    }
+    uint32_t mask = getNmeaMaskFromConf(ContextBase::mGps_conf);
     if (mNmeaMask != mask) {
         mNmeaMask = mask;
-        if (mNmeaMask) {
-            for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-                if ((it->second.gnssNmeaCb != nullptr)) {
-                    updateEvtMask(LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT,
-                                  LOC_REGISTRATION_MASK_ENABLED);
-                    break;
-                }
-            }
-        }
+        // NMEA from the modem is registered for only while there is
+        // both a mask and a client for it
+        updateClientsEventMask();
     }
 
     std::string oldMoServerUrl = getMoServerUrl();
@@ -939,26 +1144,17 @@ GnssAdapter::setConfig()
     }
     gnssConfigRequested.blacklistedSvIds.assign(mBlacklistedSvIds.begin(),
                                                 mBlacklistedSvIds.end());
+    mModemNmeaMask = getModemNmeaMask();
+    uint32_t nmeaMask = mModemNmeaMask;
     mLocApi->sendMsg(new LocApiMsg(
             [this, gpsConf, sapConf, oldMoServerUrl, moServerUrl,
-            serverUrl, gnssConfigRequested] () mutable {
+            serverUrl, gnssConfigRequested, nmeaMask] () mutable {
         gnssUpdateConfig(oldMoServerUrl, moServerUrl, serverUrl,
                 gnssConfigRequested, gnssConfigRequested);
 
         // set nmea mask type
-        uint32_t mask = 0;
-        if (NMEA_PROVIDER_MP == gpsConf.NMEA_PROVIDER) {
-            mask |= LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
-            if (gpsConf.NMEA_TAG_BLOCK_GROUPING_ENABLED) {
-                mask |= LOC_NMEA_MASK_TAGBLOCK_V02;
-            }
-        }
-        if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_DEBUG_NMEA_V02)) {
-            mask |= LOC_NMEA_MASK_DEBUG_V02;
-        }
-
-        if (mask != 0) {
-            mLocApi->setNMEATypesSync(mask);
+        if (nmeaMask != 0) {
+            mLocApi->setNMEATypesSync(nmeaMask);
         }
 
         // load tunc configuration from config file on first boot-up,
@@ -1025,11 +1221,137 @@ GnssAdapter::setConfig()
                 sapConf.SENSOR_ALGORITHM_CONFIG_MASK);
     } ));
     // deal with Measurement Corrections
+    mMeasCorrResync = true;
     if (true == mIsMeasCorrInterfaceOpen) {
         initMeasCorr(true);
     }
 }
 
+void
+GnssAdapter::applyGpsConfChanges(const std::unordered_set<std::string>& changedKeys)
+{
+    auto changed = [&changedKeys](const char* key) {
+        return changedKeys.find(key) != changedKeys.end();
+    };
+
+    // only the changed keys are re-read, and only their setters are sent to
+    // the modem, instead of the full re-injection setConfig() does at SSR
+    ContextBase::readGpsConfItems(changedKeys);
+    loc_gps_cfg_s gpsConf = ContextBase::mGps_conf;
+
+    bool updateNmea = false;
+    if (changed("NMEA_PROVIDER") || changed("NMEA_TAG_BLOCK_GROUPING_ENABLED")) {
+        uint32_t mask = getNmeaMaskFromConf(gpsConf);
+        if (mNmeaMask != mask) {
+            mNmeaMask = mask;
+            updateNmea = true;
+            // sends the new mask to the modem along with the debug NMEA bit
+            updateClientsEventMask();
+        }
+    }
+
+    GnssConfig gnssConfigRequested = {};
+    std::string oldMoServerUrl = getMoServerUrl();
+    if (changed("SUPL_HOST") || changed("SUPL_PORT")) {
+        std::string oldServerUrl = getServerUrl();
+        setSuplHostServer(gpsConf.SUPL_HOST, gpsConf.SUPL_PORT, LOC_AGPS_SUPL_SERVER);
+        if (oldServerUrl != getServerUrl()) {
+            gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_SET_ASSISTANCE_DATA_VALID_BIT;
+            gnssConfigRequested.assistanceServer.type = GNSS_ASSISTANCE_TYPE_SUPL;
+        }
+    }
+    if (changed("MO_SUPL_HOST") || changed("MO_SUPL_PORT")) {
+        setSuplHostServer(gpsConf.MO_SUPL_HOST, gpsConf.MO_SUPL_PORT,
+                          LOC_AGPS_MO_SUPL_SERVER);
+        if (oldMoServerUrl != getMoServerUrl()) {
+            gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_SET_ASSISTANCE_DATA_VALID_BIT;
+            gnssConfigRequested.assistanceServer.type = GNSS_ASSISTANCE_TYPE_SUPL;
+        }
+    }
+    if (changed("GPS_LOCK")) {
+        gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_GPS_LOCK_VALID_BIT;
+        // see setConfig() on what GPS_LOCK means with and without NFW control
+        if (mSupportNfwControl || (0 == getAfwControlId())) {
+            gnssConfigRequested.gpsLock = gpsConf.GPS_LOCK;
+        } else {
+            gnssConfigRequested.gpsLock = GNSS_CONFIG_GPS_LOCK_NONE;
+        }
+    }
+    if (changed("SUPL_VER")) {
+        gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT;
+        gnssConfigRequested.suplVersion = mLocApi->convertSuplVersion(gpsConf.SUPL_VER);
+    }
+    if (changed("LPP_PROFILE")) {
+        gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT;
+        gnssConfigRequested.lppProfileMask = gpsConf.LPP_PROFILE;
+    }
+    if (changed("A_GLONASS_POS_PROTOCOL_SELECT")) {
+        gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT;
+        gnssConfigRequested.aGlonassPositionProtocolMask =
+                gpsConf.A_GLONASS_POS_PROTOCOL_SELECT;
+    }
+    if (changed("LPPE_CP_TECHNOLOGY")) {
+        gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT;
+        gnssConfigRequested.lppeControlPlaneMask =
+                mLocApi->convertLppeCp(gpsConf.LPPE_CP_TECHNOLOGY);
+    }
+    if (changed("LPPE_UP_TECHNOLOGY")) {
+        gnssConfigRequested.flags |= GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT;
+        gnssConfigRequested.lppeUserPlaneMask =
+                mLocApi->convertLppeUp(gpsConf.LPPE_UP_TECHNOLOGY);
+    }
+
+    bool updateTunc = false;
+    if (changed("CONSTRAINED_TIME_UNCERTAINTY_ENABLED") ||
+            changed("CONSTRAINED_TIME_UNCERTAINTY_THRESHOLD") ||
+            changed("CONSTRAINED_TIME_UNCERTAINTY_ENERGY_BUDGET")) {
+        updateTunc = true;
+        mLocConfigInfo.tuncConfigInfo.isValid = true;
+        mLocConfigInfo.tuncConfigInfo.enable =
+                (gpsConf.CONSTRAINED_TIME_UNCERTAINTY_ENABLED == 1);
+        mLocConfigInfo.tuncConfigInfo.tuncThresholdMs =
+                (float)gpsConf.CONSTRAINED_TIME_UNCERTAINTY_THRESHOLD;
+        mLocConfigInfo.tuncConfigInfo.energyBudget =
+                gpsConf.CONSTRAINED_TIME_UNCERTAINTY_ENERGY_BUDGET;
+    }
+    bool updatePace = false;
+    if (changed("POSITION_ASSISTED_CLOCK_ESTIMATOR_ENABLED")) {
+        updatePace = true;
+        mLocConfigInfo.paceConfigInfo.isValid = true;
+        mLocConfigInfo.paceConfigInfo.enable =
+                (gpsConf.POSITION_ASSISTED_CLOCK_ESTIMATOR_ENABLED == 1);
+    }
+
+    if (!updateNmea && !updateTunc && !updatePace && 0 == gnssConfigRequested.flags) {
+        LOC_LOGd("no gps.conf change to apply at runtime, the rest takes effect on restart");
+        return;
+    }
+    LOC_LOGd("applying gps.conf changes, config flags 0x%x%s%s%s", gnssConfigRequested.flags,
+             updateNmea ? ", nmea" : "", updateTunc ? ", tunc" : "", updatePace ? ", pace" : "");
+
+    std::string moServerUrl = getMoServerUrl();
+    std::string serverUrl = getServerUrl();
+    LocIntegrationConfigInfo locConfigInfo = mLocConfigInfo;
+    mLocApi->sendMsg(new LocApiMsg(
+            [this, oldMoServerUrl, moServerUrl, serverUrl, gnssConfigRequested,
+            updateTunc, updatePace, locConfigInfo] () mutable {
+        if (0 != gnssConfigRequested.flags) {
+            gnssUpdateConfig(oldMoServerUrl, moServerUrl, serverUrl,
+                    gnssConfigRequested, gnssConfigRequested);
+        }
+        if (updateTunc) {
+            mLocApi->setConstrainedTuncMode(
+                    locConfigInfo.tuncConfigInfo.enable,
+                    locConfigInfo.tuncConfigInfo.tuncThresholdMs,
+                    locConfigInfo.tuncConfigInfo.energyBudget);
+        }
+        if (updatePace) {
+            mLocApi->setPositionAssistedClockEstimatorMode(
+                    locConfigInfo.paceConfigInfo.enable);
+        }
+    }));
+}
+
 std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldMoServerUrl,
         const std::string& moServerUrl, const std::string& serverUrl,
         GnssConfig& gnssConfigRequested, GnssConfig& gnssConfigNeedEngineUpdate, size_t count) {
@@ -1052,6 +1374,26 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
                 GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT);
     }
 
+    // the protocol config parameters all go to the engine in one request,
+    // instead of one request and one round trip each
+    const GnssConfigFlagsMask protocolConfigFlags = GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT |
+            GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT |
+            GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT |
+            GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT |
+            GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT |
+            GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT;
+    GnssConfig protocolConfig = gnssConfigRequested;
+    protocolConfig.flags = gnssConfigRequested.flags & gnssConfigNeedEngineUpdate.flags &
+            protocolConfigFlags;
+    GnssConfigFlagsMask protocolConfigFailedFlags = 0;
+    if (0 != protocolConfig.flags) {
+        mLocApi->setProtocolConfigSync(protocolConfig, protocolConfigFailedFlags);
+    }
+    auto protocolConfigErr = [protocolConfigFailedFlags] (GnssConfigFlagsMask flag) {
+        return (protocolConfigFailedFlags & flag) ?
+                LOCATION_ERROR_GENERAL_FAILURE : LOCATION_ERROR_SUCCESS;
+    };
+
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_GPS_LOCK_VALID_BIT) {
         if (gnssConfigNeedEngineUpdate.flags & GNSS_CONFIG_FLAGS_GPS_LOCK_VALID_BIT) {
             err = mLocApi->setGpsLockSync(gnssConfigRequested.gpsLock);
@@ -1085,39 +1427,30 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
                 }
             } else if (gnssConfigNeedEngineUpdate.assistanceServer.type ==
                     GNSS_ASSISTANCE_TYPE_C2K) {
-                struct in_addr addr;
-                struct hostent* hp;
-                bool resolveAddrSuccess = true;
-
-                hp = gethostbyname(
-                        gnssConfigNeedEngineUpdate.assistanceServer.hostName);
-                if (hp != NULL) { /* DNS OK */
-                    memcpy(&addr, hp->h_addr_list[0], hp->h_length);
-                } else {
-                    /* Try IP representation */
-                    if (inet_aton(
-                                gnssConfigNeedEngineUpdate.assistanceServer.hostName,
-                                &addr) == 0) {
-                        /* IP not valid */
-                        LOC_LOGE("%s]: hostname '%s' cannot be resolved ",
-                                __func__,
-                                gnssConfigNeedEngineUpdate.assistanceServer.hostName);
-                        if (index < count) {
-                            errsList[index] = LOCATION_ERROR_INVALID_PARAMETER;
-                        }
-                    } else {
-                        resolveAddrSuccess = false;
-                    }
-                }
-
-                if (resolveAddrSuccess) {
-                    unsigned int ip = htonl(addr.s_addr);
-                    err = mLocApi->setServerSync(ip,
-                            gnssConfigNeedEngineUpdate.assistanceServer.port,
-                            LOC_AGPS_CDMA_PDE_SERVER);
+                // this is the LocApi thread, a host not cached yet is looked up
+                // on the resolver thread and set once it is resolved
+                const char* hostName = gnssConfigNeedEngineUpdate.assistanceServer.hostName;
+                uint32_t port = gnssConfigNeedEngineUpdate.assistanceServer.port;
+                in_addr_t addr;
+                if (LocHostResolver::getInstance().getCached(hostName, addr)) {
+                    err = mLocApi->setServerSync(ntohl(addr), port, LOC_AGPS_CDMA_PDE_SERVER);
                     if (index < count) {
                         errsList[index] = err;
                     }
+                } else {
+                    std::string host((nullptr == hostName) ? "" : hostName);
+                    LocHostResolver::getInstance().resolve(hostName,
+                            [this, host, port] (bool resolved, in_addr_t addr) {
+                        if (!resolved) {
+                            LOC_LOGE("%s]: hostname '%s' cannot be resolved ",
+                                    __func__, host.c_str());
+                            return;
+                        }
+                        mLocApi->sendMsg(new LocApiMsg([this, addr, port] () {
+                            mLocApi->setServerSync(ntohl(addr), port,
+                                    LOC_AGPS_CDMA_PDE_SERVER);
+                        }));
+                    });
                 }
             }
         }
@@ -1127,7 +1460,7 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) {
         if (gnssConfigNeedEngineUpdate.flags &
                 GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) {
-            err = mLocApi->setSUPLVersionSync(gnssConfigRequested.suplVersion);
+            err = protocolConfigErr(GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1138,7 +1471,7 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) {
         if (gnssConfigNeedEngineUpdate.flags &
                 GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) {
-            err = mLocApi->setLPPConfigSync(gnssConfigRequested.lppProfileMask);
+            err = protocolConfigErr(GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1149,8 +1482,7 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) {
         if (gnssConfigNeedEngineUpdate.flags &
                 GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) {
-            err = mLocApi->setLPPeProtocolCpSync(
-                    gnssConfigRequested.lppeControlPlaneMask);
+            err = protocolConfigErr(GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1161,8 +1493,7 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) {
         if (gnssConfigNeedEngineUpdate.flags &
                 GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) {
-            err = mLocApi->setLPPeProtocolUpSync(
-                    gnssConfigRequested.lppeUserPlaneMask);
+            err = protocolConfigErr(GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1174,8 +1505,8 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
             GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) {
         if (gnssConfigNeedEngineUpdate.flags &
                 GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) {
-            err = mLocApi->setAGLONASSProtocolSync(
-                    gnssConfigRequested.aGlonassPositionProtocolMask);
+            err = protocolConfigErr(
+                    GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1206,8 +1537,8 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
             GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) {
         if (gnssConfigNeedEngineUpdate.flags &
                 GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) {
-            err = mLocApi->setEmergencyExtensionWindowSync(
-                    gnssConfigRequested.emergencyExtensionSeconds);
+            err = protocolConfigErr(
+                    GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -2192,6 +2523,135 @@ void GnssAdapter::deleteAidingData(const GnssAidingData &data, uint32_t sessionI
             mLastDeleteAidingDataTime = bootDeleteTimeMs;
        }
    }
+   // what was deleted is not to come back with the next engine up
+   if (data.deleteAll || (data.common.mask &
+           (GNSS_AIDING_DATA_COMMON_POSITION_BIT | GNSS_AIDING_DATA_COMMON_TIME_BIT))) {
+       deleteWarmStartCache();
+   }
+}
+
+void
+GnssAdapter::getBootId(char* bootId, size_t size)
+{
+    memset(bootId, 0, size);
+    int fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t len = read(fd, bootId, size - 1);
+        close(fd);
+        if (len > 0 && '\n' == bootId[len - 1]) {
+            bootId[len - 1] = '\0';
+        }
+    }
+}
+
+void
+GnssAdapter::saveWarmStartCache(const UlpLocation& ulpLocation,
+                                const GpsLocationExtended& locationExtended)
+{
+    uint64_t nowMs = getBootTimeMilliSec();
+    if (0 != mWarmStartCacheSavedMs &&
+            nowMs - mWarmStartCacheSavedMs < WARM_START_CACHE_SAVE_INTERVAL_MS) {
+        return;
+    }
+    if (!(ulpLocation.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG) ||
+            !(ulpLocation.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ACCURACY)) {
+        return;
+    }
+    mWarmStartCacheSavedMs = nowMs;
+
+    GnssWarmStartCache cache = {};
+    cache.version = WARM_START_CACHE_VERSION;
+    cache.size = sizeof(cache);
+    getBootId(cache.bootId, sizeof(cache.bootId));
+    cache.bootTimeMs = nowMs;
+    cache.positionValid = true;
+    cache.latitude = ulpLocation.gpsLocation.latitude;
+    cache.longitude = ulpLocation.gpsLocation.longitude;
+    cache.accuracy = ulpLocation.gpsLocation.accuracy;
+    if (0 != ulpLocation.gpsLocation.timestamp &&
+            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_TIME_UNC)) {
+        cache.timeValid = true;
+        cache.utcTimeMs = ulpLocation.gpsLocation.timestamp;
+        // the fix reached us a little after its time
+        cache.timeUncMs = (int32_t)locationExtended.timeUncMs + 100;
+    }
+    cache.leapSecondSysInfo = mLocSystemInfo.leapSecondSysInfo;
+
+    // rename, so that a reader never gets a partial cache
+    std::string tmpPath = std::string(WARM_START_CACHE_FILE) + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOC_LOGe("failed to open %s, errno %d", tmpPath.c_str(), errno);
+        return;
+    }
+    bool written = (write(fd, &cache, sizeof(cache)) == (ssize_t)sizeof(cache));
+    close(fd);
+    if (!written || 0 != rename(tmpPath.c_str(), WARM_START_CACHE_FILE)) {
+        LOC_LOGe("failed to write %s, errno %d", WARM_START_CACHE_FILE, errno);
+        unlink(tmpPath.c_str());
+    }
+}
+
+void
+GnssAdapter::injectWarmStartCache()
+{
+    GnssWarmStartCache cache = {};
+    int fd = open(WARM_START_CACHE_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    bool readOk = (read(fd, &cache, sizeof(cache)) == (ssize_t)sizeof(cache));
+    close(fd);
+    if (!readOk || WARM_START_CACHE_VERSION != cache.version ||
+            sizeof(cache) != cache.size) {
+        LOC_LOGw("discarding invalid %s", WARM_START_CACHE_FILE);
+        deleteWarmStartCache();
+        return;
+    }
+
+    // the leap seconds do not depend on when they were saved
+    if (!(mLocSystemInfo.systemInfoMask & LOCATION_SYS_INFO_LEAP_SECOND) &&
+            (cache.leapSecondSysInfo.leapSecondInfoMask &
+             LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT)) {
+        LocationSystemInfo locationSystemInfo = {};
+        locationSystemInfo.systemInfoMask = LOCATION_SYS_INFO_LEAP_SECOND;
+        locationSystemInfo.leapSecondSysInfo.leapSecondInfoMask =
+                LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT;
+        locationSystemInfo.leapSecondSysInfo.leapSecondCurrent =
+                cache.leapSecondSysInfo.leapSecondCurrent;
+        reportLocationSystemInfo(locationSystemInfo);
+    }
+
+    // the position and time are only known to be good for the same boot,
+    // as the boot time of the fix is all there is to age them
+    char bootId[sizeof(cache.bootId)];
+    getBootId(bootId, sizeof(bootId));
+    uint64_t nowMs = getBootTimeMilliSec();
+    if ('\0' == bootId[0] || 0 != strncmp(bootId, cache.bootId, sizeof(bootId)) ||
+            nowMs < cache.bootTimeMs) {
+        LOC_LOGd("cache is of another boot");
+        return;
+    }
+    uint64_t ageMs = nowMs - cache.bootTimeMs;
+    LOC_LOGd("cache age %" PRIu64 " ms", ageMs);
+
+    if (cache.timeValid && ageMs <= WARM_START_TIME_MAX_AGE_MS) {
+        // the boot clock drifts by no more than 50 ppm meanwhile
+        int32_t uncertainty = cache.timeUncMs + (int32_t)(ageMs / 20000);
+        injectTimeCommand(cache.utcTimeMs, cache.bootTimeMs, uncertainty);
+    }
+    if (cache.positionValid && ageMs <= WARM_START_POSITION_MAX_AGE_MS) {
+        // the device may have moved at up to 30 m/s meanwhile
+        float accuracy = cache.accuracy + (float)(ageMs / 1000) * 30.0f;
+        injectLocationCommand(cache.latitude, cache.longitude, accuracy);
+    }
+}
+
+void
+GnssAdapter::deleteWarmStartCache()
+{
+    mWarmStartCacheSavedMs = 0;
+    unlink(WARM_START_CACHE_FILE);
 }
 
 uint32_t
@@ -2405,9 +2865,19 @@ GnssAdapter::updateSystemPowerState(PowerStateType systemPowerState) {
     if (POWER_STATE_UNKNOWN != systemPowerState) {
         mSystemPowerState = systemPowerState;
         mLocApi->updateSystemPowerState(mSystemPowerState);
+        mPowerPolicy.updateSystemPowerState(mSystemPowerState);
     }
 }
 
+void
+GnssAdapter::applyPowerProfile(const LocPowerProfile& profile) {
+    LOC_LOGd("nmea %d sv decimation %u measurements decimation %u",
+             profile.nmeaEnabled, profile.svDecimation, profile.measurementsDecimation);
+    mPowerProfile = profile;
+    mSvReportCount = 0;
+    mMeasurementsReportCount = 0;
+}
+
 void
 GnssAdapter::updateSystemPowerStateCommand(PowerStateType systemPowerState) {
     LOC_LOGd("power event %d", systemPowerState);
@@ -2429,6 +2899,77 @@ GnssAdapter::updateSystemPowerStateCommand(PowerStateType systemPowerState) {
     sendMsg(new MsgUpdatePowerState(*this, systemPowerState));
 }
 
+void
+GnssAdapter::suspendTracking(bool suspend) {
+    if (suspend == mTrackingSuspended) {
+        return;
+    }
+    LOC_LOGi("%s tracking, %zu sessions", suspend ? "suspend" : "resume",
+             mTimeBasedTrackingSessions.size());
+    if (suspend) {
+        suspendSessions();
+        mTrackingSuspended = true;
+    } else {
+        mTrackingSuspended = false;
+        restartSessions(false);
+    }
+}
+
+void
+GnssAdapter::suspendTrackingCommand(bool suspend) {
+    struct MsgSuspendTracking : public LocMsg {
+        GnssAdapter& mAdapter;
+        bool mSuspend;
+        inline MsgSuspendTracking(GnssAdapter& adapter, bool suspend) :
+            LocMsg(),
+            mAdapter(adapter),
+            mSuspend(suspend) {}
+        inline virtual void proc() const {
+            mAdapter.suspendTracking(mSuspend);
+        }
+    };
+
+    sendMsg(new MsgSuspendTracking(*this, suspend));
+}
+
+void
+GnssAdapter::submitBatchCommand(const std::vector<std::function<void()>>& commands)
+{
+    struct MsgCommandBatch : public LocMsgBatch {
+        GnssAdapter& mAdapter;
+        inline MsgCommandBatch(GnssAdapter& adapter) :
+            LocMsgBatch(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            LOC_LOGd("%zu msgs", mMsgs.size());
+            mAdapter.mLocApi->startMsgBatch();
+            mAdapter.mInCommandBatch = true;
+            LocMsgBatch::proc();
+            mAdapter.mInCommandBatch = false;
+            if (mAdapter.mClientsEventMaskPending) {
+                mAdapter.mClientsEventMaskPending = false;
+                mAdapter.updateClientsEventMask();
+            }
+            mAdapter.mLocApi->sendMsgBatch();
+        }
+    };
+
+    if (nullptr != sMsgBatch) {
+        // already in a batch, the commands join it
+        for (auto& command : commands) {
+            command();
+        }
+        return;
+    }
+    MsgCommandBatch* batch = new MsgCommandBatch(*this);
+    sMsgBatch = batch;
+    for (auto& command : commands) {
+        command();
+    }
+    sMsgBatch = nullptr;
+    sendMsg(batch);
+}
+
 void
 GnssAdapter::addClientCommand(LocationAPI* client, const LocationCallbacks& callbacks)
 {
@@ -2473,25 +3014,184 @@ GnssAdapter::stopClientSessions(LocationAPI* client)
     }
 
     /* Distance-based Tracking */
+    std::vector<uint32_t> vDistanceBasedTrackingIds;
+    for (auto it : mDistanceBasedTrackingSessions) {
+        if (client == it.first.client) {
+            vDistanceBasedTrackingIds.push_back(it.first.id);
+        }
+    }
+    if (!vDistanceBasedTrackingIds.empty()) {
+        for (auto id : vDistanceBasedTrackingIds) {
+            eraseTrackingSession(client, id);
+        }
+        updateDbtEngineSession();
+    }
+
+    mSvFilters.erase(client);
+}
+
+void
+GnssAdapter::updatePositionSubscribers()
+{
+    // smallest minInterval of the time based sessions of each client,
+    // 0 for the clients which get every fix
+    LocFlatMap<LocationAPI*, uint32_t> clientIntervals;
+    for (auto it = mTimeBasedTrackingSessions.begin();
+            it != mTimeBasedTrackingSessions.end(); ++it) {
+        auto it2 = clientIntervals.find(it->first.client);
+        if (it2 == clientIntervals.end()) {
+            clientIntervals[it->first.client] = it->second.minInterval;
+        } else if (it->second.minInterval < it2->second) {
+            it2->second = it->second.minInterval;
+        }
+    }
+    // smallest minDistance of the distance based sessions of each client that
+    // has no time based one, those with both get every fix
+    LocFlatMap<LocationAPI*, uint32_t> clientDistances;
     for (auto it = mDistanceBasedTrackingSessions.begin();
-              it != mDistanceBasedTrackingSessions.end(); /* no increment here*/) {
-        if (client == it->first.client) {
-            mLocApi->stopDistanceBasedTracking(it->first.id, new LocApiResponse(*getContext(),
-                          [this, client, id=it->first.id] (LocationError err) {
-                    if (LOCATION_ERROR_SUCCESS == err) {
-                        eraseTrackingSession(client, id);
+            it != mDistanceBasedTrackingSessions.end(); ++it) {
+        auto it2 = clientIntervals.find(it->first.client);
+        if (it2 != clientIntervals.end()) {
+            it2->second = 0;
+            continue;
+        }
+        auto it3 = clientDistances.find(it->first.client);
+        if (it3 == clientDistances.end()) {
+            clientDistances[it->first.client] = it->second.minDistance;
+        } else if (it->second.minDistance < it3->second) {
+            it3->second = it->second.minDistance;
+        }
+    }
+
+    // keep when the decimated clients are due next, and the fixes collected
+    // for the batched clients, across the rebuild
+    LocFlatMap<LocationAPI*, uint64_t> clientNextDues;
+    for (auto& decimated : mDecimatedPositionClients) {
+        clientNextDues[decimated.client] = decimated.nextDueMs;
+    }
+    std::vector<BatchedPositionClient> batchedPositionClients;
+    batchedPositionClients.swap(mBatchedPositionClients);
+    // and the last fix the distance filtered clients got
+    std::vector<DistanceFilteredPositionClient> distanceFilteredPositionClients;
+    distanceFilteredPositionClients.swap(mDistanceFilteredPositionClients);
+
+    mGnssPositionClients.clear();
+    mFlpPositionClients.clear();
+    mDecimatedPositionClients.clear();
+    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+        LocationCallbacks* callbacks = &it->second;
+        if (nullptr != callbacks->gnssLocationInfoCb ||
+            nullptr != callbacks->engineLocationsInfoCb ||
+            nullptr != callbacks->trackingCb) {
+            bool isFlp = isFlpClient(*callbacks);
+            auto it2 = clientIntervals.find(it->first);
+            auto it4 = clientDistances.find(it->first);
+            if (isTrackingReportBatched(*callbacks)) {
+                BatchedPositionClient batched = {it->first, callbacks, isFlp, 0, {}};
+                for (auto& old : batchedPositionClients) {
+                    if (old.client == it->first) {
+                        batched.firstFixMs = old.firstFixMs;
+                        batched.locations.swap(old.locations);
+                        break;
                     }
                 }
-            ));
+                // the client has no more session, report what is left
+                if (it2 == clientIntervals.end() && it4 == clientDistances.end() &&
+                        !batched.locations.empty()) {
+                    reportTrackingBatch(batched);
+                }
+                mBatchedPositionClients.push_back(std::move(batched));
+            } else if (it4 != clientDistances.end()) {
+                DistanceFilteredPositionClient filtered =
+                        {it->first, callbacks, isFlp, it4->second, false, 0.0, 0.0};
+                for (auto& old : distanceFilteredPositionClients) {
+                    if (old.client == it->first) {
+                        filtered.hasLastFix = old.hasLastFix;
+                        filtered.lastLatitude = old.lastLatitude;
+                        filtered.lastLongitude = old.lastLongitude;
+                        break;
+                    }
+                }
+                mDistanceFilteredPositionClients.push_back(filtered);
+            } else if (it2 != clientIntervals.end() && 0 != it2->second) {
+                auto it3 = clientNextDues.find(it->first);
+                uint64_t nextDueMs = (it3 != clientNextDues.end()) ? it3->second : 0;
+                mDecimatedPositionClients.push_back(
+                        {nextDueMs, it2->second, it->first, callbacks, isFlp});
+            } else if (isFlp) {
+                mFlpPositionClients.push_back(callbacks);
+            } else {
+                mGnssPositionClients.push_back(callbacks);
+            }
         }
-        ++it; // increment only when not erasing an iterator
     }
+    std::make_heap(mDecimatedPositionClients.begin(), mDecimatedPositionClients.end(),
+                   std::greater<DecimatedPositionClient>());
+}
+
+bool
+GnssAdapter::isTrackingReportBatched(const LocationCallbacks& callbacks)
+{
+    return (0 != ContextBase::mGps_conf.TRACKING_REPORT_BATCH_SIZE ||
+            0 != ContextBase::mGps_conf.TRACKING_REPORT_BATCH_MS) &&
+            nullptr != callbacks.trackingCb && nullptr != callbacks.batchingCb &&
+            nullptr == callbacks.gnssLocationInfoCb &&
+            nullptr == callbacks.engineLocationsInfoCb;
+}
 
+void
+GnssAdapter::reportTrackingBatch(BatchedPositionClient& batched)
+{
+    LOC_LOGd("client %p, %zu fixes", batched.client, batched.locations.size());
+    BatchingOptions batchingOptions(sizeof(BatchingOptions), BATCHING_MODE_NO_AUTO_REPORT);
+    batched.callbacks->batchingCb(batched.locations.size(), batched.locations.data(),
+                                  batchingOptions);
+    batched.locations.clear();
+}
+
+void
+GnssAdapter::updateClientSubscribers()
+{
+    updatePositionSubscribers();
+    mEnginePositionClients.clear();
+    mSvClients.clear();
+    mNmeaClients.clear();
+    mDataClients.clear();
+    mMeasurementsClients.clear();
+    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+        LocationCallbacks* callbacks = &it->second;
+        if (nullptr != callbacks->engineLocationsInfoCb) {
+            mEnginePositionClients.push_back(callbacks);
+        }
+        if (nullptr != callbacks->gnssSvCb) {
+            auto filter = mSvFilters.find(it->first);
+            mSvClients.push_back({callbacks,
+                    (filter != mSvFilters.end()) ? &filter->second : nullptr});
+        }
+        if (nullptr != callbacks->gnssNmeaCb) {
+            mNmeaClients.push_back(callbacks);
+        }
+        if (nullptr != callbacks->gnssDataCb) {
+            mDataClients.push_back(callbacks);
+        }
+        if (nullptr != callbacks->gnssMeasurementsCb) {
+            mMeasurementsClients.push_back(callbacks);
+        }
+    }
+    mDataWanted = !mDataClients.empty();
+    mMeasurementsAgcWanted = !mMeasurementsClients.empty();
 }
 
 void
 GnssAdapter::updateClientsEventMask()
 {
+    if (mInCommandBatch) {
+        // once for the whole batch, at its end
+        mClientsEventMaskPending = true;
+        return;
+    }
+    updateClientSubscribers();
+
     // need to register for leap second info
     // for proper nmea generation
     LOC_API_ADAPTER_EVENT_MASK_T mask = LOC_API_ADAPTER_BIT_LOC_SYSTEM_INFO |
@@ -2514,9 +3214,15 @@ GnssAdapter::updateClientsEventMask()
         if (it->second.gnssDataCb != nullptr) {
             mask |= LOC_API_ADAPTER_BIT_PARSED_POSITION_REPORT;
             mask |= LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT;
-            updateNmeaMask(mNmeaMask | LOC_NMEA_MASK_DEBUG_V02);
         }
     }
+    // the debug NMEA is asked of the modem only while a gnssDataCb client is
+    // registered, and only sent again when that changes
+    uint32_t nmeaMask = getModemNmeaMask();
+    if (mModemNmeaMask != nmeaMask) {
+        mModemNmeaMask = nmeaMask;
+        updateNmeaMask(nmeaMask);
+    }
 
     /*
     ** For Automotive use cases we need to enable MEASUREMENT, POLY and EPHEMERIS
@@ -2583,10 +3289,15 @@ GnssAdapter::handleEngineUpEvent()
             mAdapter.gnssSvTypeConfigUpdate();
             mAdapter.updateSystemPowerState(mAdapter.getSystemPowerState());
             mAdapter.gnssSecondaryBandConfigUpdate();
+            if (1 == ContextBase::mGps_conf.WARM_START_CACHE_ENABLED) {
+                mAdapter.injectWarmStartCache();
+            }
             // start CDFW service
             mAdapter.initCDFWService();
             // restart sessions
+            mAdapter.beginReplay();
             mAdapter.restartSessions(true);
+            mAdapter.endReplay();
             for (auto msg: mAdapter.mPendingMsgs) {
                 mAdapter.sendMsg(msg);
             }
@@ -2611,7 +3322,7 @@ GnssAdapter::restartSessions(bool modemSSR)
     // SPE will be restarted now, so set this variable to false.
     mSPEAlreadyRunningAtHighestInterval = false;
 
-    if (false == mTimeBasedTrackingSessions.empty()) {
+    if (false == mTimeBasedTrackingSessions.empty() && !mTrackingSuspended) {
         // inform engine hub that GNSS session is about to start
         mEngHubProxy->gnssSetFixMode(mLocPositionMode);
         mEngHubProxy->gnssStartFix();
@@ -2630,11 +3341,11 @@ void GnssAdapter::checkAndRestartSPESession()
 
     checkAndRestartTimeBasedSession();
 
-    for (auto it = mDistanceBasedTrackingSessions.begin();
-        it != mDistanceBasedTrackingSessions.end(); ++it) {
-        mLocApi->startDistanceBasedTracking(it->first.id, it->second,
-                                            new LocApiResponse(*getContext(),
-                                            [] (LocationError /*err*/) {}));
+    // the engine lost the distance based session, it is started again as is
+    mDbtEngineOptions = getMultiplexedDbtOptions();
+    if (0 != mDbtEngineOptions.size) {
+        mLocApi->startDistanceBasedTracking(mDbtEngineSessionId, mDbtEngineOptions,
+                                            newReplayResponse());
     }
 }
 
@@ -2644,7 +3355,8 @@ GnssAdapter::suspendSessions()
 {
     LOC_LOGi(":enter");
 
-    if (!mTimeBasedTrackingSessions.empty()) {
+    // while suspended the engine is stopped already
+    if (!mTimeBasedTrackingSessions.empty() && !mTrackingSuspended) {
         // inform engine hub that GNSS session has stopped
         mEngHubProxy->gnssStopFix();
         mLocApi->stopFix(nullptr);
@@ -2660,32 +3372,14 @@ void GnssAdapter::checkAndRestartTimeBasedSession()
 {
     LOC_LOGD("%s]: ", __func__);
 
-    if (!mTimeBasedTrackingSessions.empty()) {
-        // get the LocationOptions that has the smallest interval, which should be the active one
-        TrackingOptions smallestIntervalOptions; // size is zero until set for the first time
-        TrackingOptions highestPowerTrackingOptions;
-        memset(&smallestIntervalOptions, 0, sizeof(smallestIntervalOptions));
-        memset(&highestPowerTrackingOptions, 0, sizeof(highestPowerTrackingOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin();
-                it != mTimeBasedTrackingSessions.end(); ++it) {
-            // size of zero means we havent set it yet
-            if (0 == smallestIntervalOptions.size ||
-                it->second.minInterval < smallestIntervalOptions.minInterval) {
-                 smallestIntervalOptions = it->second;
-            }
-            GnssPowerMode powerMode = it->second.powerMode;
-            // Size of zero means we havent set it yet
-            if (0 == highestPowerTrackingOptions.size ||
-                (GNSS_POWER_MODE_INVALID != powerMode &&
-                        powerMode < highestPowerTrackingOptions.powerMode)) {
-                 highestPowerTrackingOptions = it->second;
-            }
-        }
-
-        highestPowerTrackingOptions.setLocationOptions(smallestIntervalOptions);
+    if (!mTimeBasedTrackingSessions.empty() && !mTrackingSuspended) {
+        // the multiplexed options of all sessions should be the active ones
+        TrackingOptions multiplexedOptions = getMultiplexedTrackingOptions(nullptr);
         // want to run SPE session at a fixed min interval in some automotive scenarios
-        if(!checkAndSetSPEToRunforNHz(highestPowerTrackingOptions)) {
-            mLocApi->startTimeBasedTracking(highestPowerTrackingOptions, nullptr);
+        if(!checkAndSetSPEToRunforNHz(multiplexedOptions)) {
+            // only the replay after an engine restart waits on the response
+            mLocApi->startTimeBasedTracking(multiplexedOptions,
+                    isReplayInProgress() ? newReplayResponse() : nullptr);
         }
     }
 }
@@ -2845,8 +3539,16 @@ GnssAdapter::saveTrackingSession(LocationAPI* client, uint32_t sessionId,
             ContextBase::isMessageSupported(LOC_API_ADAPTER_MESSAGE_DISTANCE_BASE_TRACKING)) {
         mDistanceBasedTrackingSessions[key] = options;
     } else {
-        mTimeBasedTrackingSessions[key] = options;
+        auto it = mTimeBasedTrackingSessions.find(key);
+        if (it != mTimeBasedTrackingSessions.end()) {
+            mTrackingMultiplexer.remove(key, it->second);
+            it->second = options;
+        } else {
+            mTimeBasedTrackingSessions[key] = options;
+        }
+        mTrackingMultiplexer.add(key, options);
     }
+    updatePositionSubscribers();
     reportPowerStateIfChanged();
 }
 
@@ -2856,6 +3558,7 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
     LocationSessionKey key(client, sessionId);
     auto it = mTimeBasedTrackingSessions.find(key);
     if (it != mTimeBasedTrackingSessions.end()) {
+        mTrackingMultiplexer.remove(key, it->second);
         mTimeBasedTrackingSessions.erase(it);
     } else {
         auto itr = mDistanceBasedTrackingSessions.find(key);
@@ -2863,9 +3566,87 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
             mDistanceBasedTrackingSessions.erase(itr);
         }
     }
+    updatePositionSubscribers();
     reportPowerStateIfChanged();
 }
 
+LocationOptions
+GnssAdapter::getMultiplexedDbtOptions() const
+{
+    LocationOptions multiplexed;
+    for (auto it = mDistanceBasedTrackingSessions.begin();
+            it != mDistanceBasedTrackingSessions.end(); ++it) {
+        const LocationOptions& options = it->second;
+        if (0 == multiplexed.size) {
+            multiplexed = options;
+            continue;
+        }
+        if (options.minDistance < multiplexed.minDistance) {
+            multiplexed.minDistance = options.minDistance;
+            multiplexed.mode = options.mode;
+        }
+        multiplexed.minInterval = std::min(multiplexed.minInterval, options.minInterval);
+        multiplexed.locReqEngTypeMask = (LocReqEngineTypeMask)
+                (multiplexed.locReqEngTypeMask | options.locReqEngTypeMask);
+    }
+    return multiplexed;
+}
+
+void
+GnssAdapter::updateDbtEngineSession(std::function<void(LocationError)> onDone)
+{
+    LocationOptions options = getMultiplexedDbtOptions();
+    if (options.size == mDbtEngineOptions.size &&
+            options.minDistance == mDbtEngineOptions.minDistance &&
+            options.minInterval == mDbtEngineOptions.minInterval &&
+            options.mode == mDbtEngineOptions.mode &&
+            options.locReqEngTypeMask == mDbtEngineOptions.locReqEngTypeMask) {
+        // each session is filtered on its own minDistance, the engine runs on as is
+        if (onDone) {
+            onDone(LOCATION_ERROR_SUCCESS);
+        }
+        return;
+    }
+    LOC_LOGd("distance based engine session %u -> %u m, %u -> %u ms, %zu sessions",
+             mDbtEngineOptions.minDistance, options.minDistance,
+             mDbtEngineOptions.minInterval, options.minInterval,
+             mDistanceBasedTrackingSessions.size());
+    if (0 == mDbtEngineSessionId) {
+        mDbtEngineSessionId = generateSessionId();
+    }
+    bool running = (0 != mDbtEngineOptions.size);
+    mDbtEngineOptions = options;
+
+    // drops the criteria if the engine did not take them, so the next
+    // update starts the session again
+    auto onStarted = [this, options, onDone] (LocationError err) {
+        if (LOCATION_ERROR_SUCCESS != err && options.size == mDbtEngineOptions.size &&
+                options.minDistance == mDbtEngineOptions.minDistance &&
+                options.minInterval == mDbtEngineOptions.minInterval) {
+            mDbtEngineOptions = LocationOptions();
+        }
+        if (onDone) {
+            onDone(err);
+        }
+    };
+    if (!running) {
+        mLocApi->startDistanceBasedTracking(mDbtEngineSessionId, options,
+                new LocApiResponse(*getContext(), onStarted));
+    } else {
+        // the engine has no update of a distance based session
+        mLocApi->stopDistanceBasedTracking(mDbtEngineSessionId,
+                new LocApiResponse(*getContext(), [this, options, onStarted]
+                (LocationError err) {
+            if (0 == options.size || LOCATION_ERROR_SUCCESS != err) {
+                onStarted(err);
+            } else {
+                mLocApi->startDistanceBasedTracking(mDbtEngineSessionId, options,
+                        new LocApiResponse(*getContext(), onStarted));
+            }
+        }));
+    }
+}
+
 bool GnssAdapter::setLocPositionMode(const LocPosMode& mode) {
     if (!mLocPositionMode.equals(mode)) {
         mLocPositionMode = mode;
@@ -2970,15 +3751,16 @@ GnssAdapter::startTrackingCommand(LocationAPI* client, TrackingOptions& options)
                         ContextBase::isMessageSupported(
                         LOC_API_ADAPTER_MESSAGE_DISTANCE_BASE_TRACKING)) {
                     mAdapter.saveTrackingSession(mClient, mSessionId, mOptions);
-                    mApi.startDistanceBasedTracking(mSessionId, mOptions,
-                            new LocApiResponse(*mAdapter.getContext(),
+                    mAdapter.updateDbtEngineSession(
                             [&mAdapter = mAdapter, mSessionId = mSessionId, mClient = mClient]
                             (LocationError err) {
                         if (LOCATION_ERROR_SUCCESS != err) {
                             mAdapter.eraseTrackingSession(mClient, mSessionId);
+                            // back to the criteria of the sessions left
+                            mAdapter.updateDbtEngineSession();
                         }
                         mAdapter.reportResponse(mClient, err, mSessionId);
-                    }));
+                    });
                 } else {
                     if (GNSS_POWER_MODE_M4 == mOptions.powerMode &&
                             mOptions.tbm > TRACKING_TBM_THRESHOLD_MILLIS) {
@@ -3017,36 +3799,13 @@ GnssAdapter::startTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t sessi
         // need to wait for QMI callback
         reportToClientWithNoWait = false;
     } else {
-        // find the smallest interval and powerMode
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin(); it != mTimeBasedTrackingSessions.end(); ++it) {
-            // if not set or there is a new smallest interval, then set the new interval
-            if (0 == multiplexedOptions.size ||
-                it->second.minInterval < multiplexedOptions.minInterval) {
-                multiplexedOptions = it->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedPowerMode = it->second.powerMode;
-            }
-        }
-        bool updateOptions = false;
-        // if session we are starting has smaller interval then next smallest
-        if (options.minInterval < multiplexedOptions.minInterval) {
-            multiplexedOptions.minInterval = options.minInterval;
-            updateOptions = true;
-        }
-
-        // if session we are starting has smaller powerMode then next smallest
-        if (options.powerMode < multiplexedPowerMode) {
-            multiplexedOptions.powerMode = options.powerMode;
-            updateOptions = true;
-        }
-        if (updateOptions) {
+        // the criteria of the running sessions, and those with the new session added
+        TrackingOptions currentOptions = getMultiplexedTrackingOptions(nullptr);
+        TrackingOptions multiplexedOptions(currentOptions);
+        multiplexTrackingOptions(multiplexedOptions, options);
+        // only restart if the session we are starting changes the criteria
+        if (multiplexedOptions.minInterval != currentOptions.minInterval ||
+            multiplexedOptions.powerMode != currentOptions.powerMode) {
             // restart time based tracking with the newly updated options
 
             startTimeBasedTracking(client, sessionId, multiplexedOptions);
@@ -3070,6 +3829,11 @@ GnssAdapter::startTimeBasedTracking(LocationAPI* client, uint32_t sessionId,
     convertOptions(locPosMode, trackingOptions);
     // save position mode parameters
     setLocPositionMode(locPosMode);
+    if (mTrackingSuspended) {
+        // the session is kept, and the engine started for it on resume
+        reportResponse(client, LOCATION_ERROR_SUCCESS, sessionId);
+        return;
+    }
     // inform engine hub that GNSS session is about to start
     mEngHubProxy->gnssSetFixMode(mLocPositionMode);
     mEngHubProxy->gnssStartFix();
@@ -3104,6 +3868,10 @@ GnssAdapter::updateTracking(LocationAPI* client, uint32_t sessionId,
     convertOptions(locPosMode, updatedOptions);
     // save position mode parameters
     setLocPositionMode(locPosMode);
+    if (mTrackingSuspended) {
+        reportResponse(client, LOCATION_ERROR_SUCCESS, sessionId);
+        return;
+    }
 
     // inform engine hub that GNSS session is about to start
     mEngHubProxy->gnssSetFixMode(mLocPositionMode);
@@ -3191,14 +3959,11 @@ GnssAdapter::updateTrackingOptionsCommand(LocationAPI* client, uint32_t id,
                     }
                     // saves as distance based Session
                     mAdapter.saveTrackingSession(mClient, mSessionId, mOptions);
-                    mApi.startDistanceBasedTracking(mSessionId, mOptions,
-                            new LocApiResponse(*mAdapter.getContext(),
-                                        [] (LocationError /*err*/) {}));
+                    mAdapter.updateDbtEngineSession();
                 } else if (isDistanceBased && mOptions.minDistance == 0) {
                     // switch from distance based to time based
                     mAdapter.eraseTrackingSession(mClient, mSessionId);
-                    mApi.stopDistanceBasedTracking(mSessionId, new LocApiResponse(
-                            *mAdapter.getContext(),
+                    mAdapter.updateDbtEngineSession(
                             [&mAdapter = mAdapter, mSessionId = mSessionId, mOptions = mOptions,
                             mClient = mClient] (LocationError /*err*/) {
                         // Api doesn't support multiple clients for time based tracking,
@@ -3211,7 +3976,7 @@ GnssAdapter::updateTrackingOptionsCommand(LocationAPI* client, uint32_t id,
                         if (reportToClientWithNoWait) {
                             mAdapter.reportResponse(mClient, LOCATION_ERROR_SUCCESS, mSessionId);
                         }
-                    }));
+                    });
                 } else if (isTimeBased) {
                     // update time based tracking
                     // Api doesn't support multiple clients for time based tracking, so mutiplex
@@ -3223,23 +3988,14 @@ GnssAdapter::updateTrackingOptionsCommand(LocationAPI* client, uint32_t id,
                         mAdapter.reportResponse(mClient, err, mSessionId);
                     }
                 } else if (isDistanceBased) {
-                    // restart distance based tracking
-                    mApi.stopDistanceBasedTracking(mSessionId, new LocApiResponse(
-                            *mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mSessionId = mSessionId, mOptions = mOptions,
-                            mClient = mClient, &mApi = mApi] (LocationError err) {
-                        if (LOCATION_ERROR_SUCCESS == err) {
-                            mApi.startDistanceBasedTracking(mSessionId, mOptions,
-                                    new LocApiResponse(*mAdapter.getContext(),
-                                    [&mAdapter, mClient, mSessionId, mOptions]
-                                    (LocationError err) {
-                                if (LOCATION_ERROR_SUCCESS == err) {
-                                    mAdapter.saveTrackingSession(mClient, mSessionId, mOptions);
-                                }
-                                mAdapter.reportResponse(mClient, err, mSessionId);
-                            }));
-                        }
-                    }));
+                    // the engine session is only restarted if the smallest
+                    // criteria of the distance based sessions change
+                    mAdapter.saveTrackingSession(mClient, mSessionId, mOptions);
+                    mAdapter.updateDbtEngineSession(
+                            [&mAdapter = mAdapter, mSessionId = mSessionId, mClient = mClient]
+                            (LocationError err) {
+                        mAdapter.reportResponse(mClient, err, mSessionId);
+                    });
                 }
             }
         }
@@ -3258,50 +4014,21 @@ GnssAdapter::updateTrackingMultiplex(LocationAPI* client, uint32_t id,
     // get the session we are updating
     auto it = mTimeBasedTrackingSessions.find(key);
 
-    // cache the clients existing LocationOptions
-    TrackingOptions oldOptions = it->second;
-
     // if session we are updating exists and the minInterval or powerMode has changed
     if (it != mTimeBasedTrackingSessions.end() &&
        (it->second.minInterval != trackingOptions.minInterval ||
         it->second.powerMode != trackingOptions.powerMode)) {
-        // find the smallest interval and powerMode, other than the session we are updating
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it2 = mTimeBasedTrackingSessions.begin();
-             it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-            // if session is not the one we are updating and either interval
-            // is not set or there is a new smallest interval, then set the new interval
-            if (it2->first != key && (0 == multiplexedOptions.size ||
-                it2->second.minInterval < multiplexedOptions.minInterval)) {
-                 multiplexedOptions = it2->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it2->second.powerMode < multiplexedPowerMode)) {
-                multiplexedPowerMode = it2->second.powerMode;
-            }
-            // else part: no QMI call is made, need to report back to client right away
-        }
-        bool updateOptions = false;
-        // if session we are updating has smaller interval then next smallest
-        if (trackingOptions.minInterval < multiplexedOptions.minInterval) {
-            multiplexedOptions.minInterval = trackingOptions.minInterval;
-            updateOptions = true;
-        }
-        // if session we are updating has smaller powerMode then next smallest
-        if (trackingOptions.powerMode < multiplexedPowerMode) {
-            multiplexedOptions.powerMode = trackingOptions.powerMode;
-            updateOptions = true;
-        }
-        // if only one session exists, then tracking should be updated with it
-        if (1 == mTimeBasedTrackingSessions.size()) {
-            multiplexedOptions = trackingOptions;
-            updateOptions = true;
-        }
-        if (updateOptions) {
+        // cache the clients existing LocationOptions
+        TrackingOptions oldOptions = it->second;
+        // the criteria of the running sessions, and those with the session updated
+        TrackingOptions currentOptions = getMultiplexedTrackingOptions(nullptr);
+        TrackingOptions multiplexedOptions = getMultiplexedTrackingOptions(&key);
+        multiplexTrackingOptions(multiplexedOptions, trackingOptions);
+        // if only one session exists, then tracking should be updated with it,
+        // otherwise only if the session we are updating changes the criteria
+        if (1 == mTimeBasedTrackingSessions.size() ||
+            multiplexedOptions.minInterval != currentOptions.minInterval ||
+            multiplexedOptions.powerMode != currentOptions.powerMode) {
             // restart time based tracking with the newly updated options
             updateTracking(client, id, multiplexedOptions, oldOptions);
             // need to wait for QMI callback
@@ -3345,15 +4072,12 @@ GnssAdapter::stopTrackingCommand(LocationAPI* client, uint32_t id)
                         mAdapter.reportResponse(mClient, LOCATION_ERROR_SUCCESS, mSessionId);
                     }
                 } else if (isDistanceBased) {
-                    mApi.stopDistanceBasedTracking(mSessionId, new LocApiResponse(
-                            *mAdapter.getContext(),
+                    mAdapter.eraseTrackingSession(mClient, mSessionId);
+                    mAdapter.updateDbtEngineSession(
                             [&mAdapter = mAdapter, mSessionId = mSessionId, mClient = mClient]
                             (LocationError err) {
-                        if (LOCATION_ERROR_SUCCESS == err) {
-                            mAdapter.eraseTrackingSession(mClient, mSessionId);
-                        }
                         mAdapter.reportResponse(mClient, err, mSessionId);
-                    }));
+                    });
                 }
             } else {
                 mAdapter.reportResponse(mClient, LOCATION_ERROR_ID_UNKNOWN, mSessionId);
@@ -3380,30 +4104,12 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
         // get the session we are stopping
         auto it = mTimeBasedTrackingSessions.find(key);
         if (it != mTimeBasedTrackingSessions.end()) {
-            // find the smallest interval and powerMode, other than the session we are stopping
-            TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-            GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-            memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-            for (auto it2 = mTimeBasedTrackingSessions.begin();
-                 it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-                // if session is not the one we are stopping and either interval
-                // is not set or there is a new smallest interval, then set the new interval
-                if (it2->first != key && (0 == multiplexedOptions.size ||
-                    it2->second.minInterval < multiplexedOptions.minInterval)) {
-                     multiplexedOptions = it2->second;
-                }
-                // if session is not the one we are stopping and either powerMode
-                // is not set or there is a new smallest powerMode, then set the new powerMode
-                if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                    it2->second.powerMode < multiplexedPowerMode)) {
-                    multiplexedPowerMode = it2->second.powerMode;
-                }
-            }
-            // if session we are stopping has smaller interval then next smallest or
-            // if session we are stopping has smaller powerMode then next smallest
-            if (it->second.minInterval < multiplexedOptions.minInterval ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedOptions.powerMode = multiplexedPowerMode;
+            // the criteria of the running sessions, and those without the session stopped
+            TrackingOptions currentOptions = getMultiplexedTrackingOptions(nullptr);
+            TrackingOptions multiplexedOptions = getMultiplexedTrackingOptions(&key);
+            // only restart if the session we are stopping was setting the criteria
+            if (multiplexedOptions.minInterval != currentOptions.minInterval ||
+                multiplexedOptions.powerMode != currentOptions.powerMode) {
                 // restart time based tracking with the newly updated options
                 startTimeBasedTracking(client, id, multiplexedOptions);
                 // need to wait for QMI callback
@@ -3418,6 +4124,11 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
 void
 GnssAdapter::stopTracking(LocationAPI* client, uint32_t id)
 {
+    if (mTrackingSuspended) {
+        // the engine is stopped already
+        reportResponse(client, LOCATION_ERROR_SUCCESS, id);
+        return;
+    }
     // inform engine hub that GNSS session has stopped
     mEngHubProxy->gnssStopFix();
 
@@ -3647,9 +4358,8 @@ GnssAdapter::disableCommand(uint32_t id)
 // north, east and up velocity and save the result into EHubTechReport.
 void
 GnssAdapter::computeVRPBasedLla(const UlpLocation& loc, GpsLocationExtended& locExt,
-                                const LeverArmConfigInfo& leverArmConfigInfo) {
+                                const LocIntegrationConfigInfo& locConfigInfo) {
 
-    float leverArm[3];
     float rollPitchYaw[3];
     double lla[3];
 
@@ -3664,16 +4374,12 @@ GnssAdapter::computeVRPBasedLla(const UlpLocation& loc, GpsLocationExtended& loc
     }
 
     // we can only do translation if we have VRP based lever ARM info
-    LeverArmTypeMask leverArmFlags = leverArmConfigInfo.leverArmValidMask;
+    LeverArmTypeMask leverArmFlags = locConfigInfo.leverArmConfigInfo.leverArmValidMask;
     if (!(leverArmFlags & LEVER_ARM_TYPE_GNSS_TO_VRP_BIT)) {
         LOC_LOGd("no VRP based lever ARM info");
         return;
     }
 
-    leverArm[0] = leverArmConfigInfo.gnssToVRP.forwardOffsetMeters;
-    leverArm[1] = leverArmConfigInfo.gnssToVRP.sidewaysOffsetMeters;
-    leverArm[2] = leverArmConfigInfo.gnssToVRP.upOffsetMeters;
-
     if ((locFlags & LOC_GPS_LOCATION_HAS_LAT_LONG) &&
         (locFlags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
         (locFlags & LOCATION_HAS_BEARING_BIT)) {
@@ -3686,7 +4392,7 @@ GnssAdapter::computeVRPBasedLla(const UlpLocation& loc, GpsLocationExtended& loc
         rollPitchYaw[1] = 0.0f;
         rollPitchYaw[2] = loc.gpsLocation.bearing * DEG2RAD;
 
-        loc_convert_lla_gnss_to_vrp(lla, rollPitchYaw, leverArm);
+        loc_vrp_transform_lla(&locConfigInfo.vrpTransform, &lla, &rollPitchYaw, 1);
 
         // assign the converted value into position report and
         // set up valid mask
@@ -3723,6 +4429,8 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
         LocPosTechMask mTechMask;
         mutable GnssDataNotification mDataNotify;
         int mMsInWeek;
+        uint64_t mFanOutQtimer;
+        std::unique_ptr<EngineHubEpoch> mEngHubEpoch;
 
         inline MsgReportSPEPosition(GnssAdapter& adapter,
                                     const UlpLocation& ulpLocation,
@@ -3730,23 +4438,33 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                                     enum loc_sess_status status,
                                     LocPosTechMask techMask,
                                     GnssDataNotification dataNotify,
-                                    int msInWeek) :
+                                    int msInWeek,
+                                    std::unique_ptr<EngineHubEpoch> engHubEpoch) :
             LocMsg(),
             mAdapter(adapter),
             mUlpLocation(ulpLocation),
-            mLocationExtended(locationExtended),
             mStatus(status),
             mTechMask(techMask),
             mDataNotify(dataNotify),
-            mMsInWeek(msInWeek) {}
+            mMsInWeek(msInWeek),
+            mFanOutQtimer(getQTimerTickCount()),
+            mEngHubEpoch(std::move(engHubEpoch)) {
+            loc_copy_location_extended(&mLocationExtended, &locationExtended);
+        }
         inline virtual void proc() const {
+            uint64_t dequeueQtimer = getQTimerTickCount();
             if (mAdapter.mTimeBasedTrackingSessions.empty() &&
                 mAdapter.mDistanceBasedTrackingSessions.empty()) {
                 LOC_LOGd("reportPositionEvent, no session on-going, throw away the SPE reports");
+                if (mEngHubEpoch) {
+                    // the epoch reports other than the position still go to the hub
+                    mAdapter.reportEngHubEpoch(mEngHubEpoch.get(), nullptr, nullptr, mStatus);
+                }
                 return;
             }
 
-            if (false == mUlpLocation.unpropagatedPosition && mDataNotify.size != 0) {
+            if (false == mUlpLocation.unpropagatedPosition && mDataNotify.size != 0 &&
+                !mAdapter.mDataClients.empty()) {
                 if (mMsInWeek >= 0) {
                     mAdapter.getDataInformation((GnssDataNotification&)mDataNotify,
                                                 mMsInWeek);
@@ -3756,18 +4474,28 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
 
             if (true == mAdapter.initEngHubProxy()){
                 // send the SPE fix to engine hub
-                mAdapter.mEngHubProxy->gnssReportPosition(mUlpLocation, mLocationExtended, mStatus);
+                if (mEngHubEpoch) {
+                    mAdapter.reportEngHubEpoch(mEngHubEpoch.get(), &mUlpLocation,
+                                               &mLocationExtended, mStatus);
+                } else {
+                    mAdapter.mEngHubProxy->gnssReportPosition(
+                            mUlpLocation, mLocationExtended, mStatus);
+                }
                 // report out all SPE fix if it is not propagated, even for failed fix
                 if (false == mUlpLocation.unpropagatedPosition) {
-                    EngineLocationInfo engLocationInfo = {};
+                    EngineLocationInfo engLocationInfo;
                     engLocationInfo.location = mUlpLocation;
-                    engLocationInfo.locationExtended = mLocationExtended;
+                    loc_copy_location_extended(&engLocationInfo.locationExtended,
+                                               &mLocationExtended);
                     engLocationInfo.sessionStatus = mStatus;
 
-                    // obtain the VRP based latitude/longitude/altitude for SPE fix
-                    computeVRPBasedLla(engLocationInfo.location,
-                                       engLocationInfo.locationExtended,
-                                       mAdapter.mLocConfigInfo.leverArmConfigInfo);
+                    // obtain the VRP based latitude/longitude/altitude for SPE fix,
+                    // only the engine position clients get it
+                    if (!mAdapter.mEnginePositionClients.empty()) {
+                        computeVRPBasedLla(engLocationInfo.location,
+                                           engLocationInfo.locationExtended,
+                                           mAdapter.mLocConfigInfo);
+                    }
                     mAdapter.reportEnginePositions(1, &engLocationInfo);
                 }
                 return;
@@ -3786,18 +4514,30 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                 s->eventPosition(mUlpLocation, mLocationExtended);
             }
 
+            mAdapter.mLatencyTrace = {0, mFanOutQtimer, dequeueQtimer, 0};
             mAdapter.reportPosition(mUlpLocation, mLocationExtended, mStatus, mTechMask);
+            mAdapter.mLatencyTrace = {};
         }
     };
 
     if (mContext != NULL) {
         GnssDataNotification dataNotifyCopy = {};
-        if (pDataNotify) {
+        if (pDataNotify && mDataWanted) {
             dataNotifyCopy = *pDataNotify;
             dataNotifyCopy.size = sizeof(dataNotifyCopy);
         }
+        // the position closes the epoch the engine hub bundle was gathering
+        std::unique_ptr<EngineHubEpoch> engHubEpoch;
+        if (isEngHubEpochBundled()) {
+            engHubEpoch = std::move(mEngHubEpoch);
+            if (!engHubEpoch) {
+                engHubEpoch.reset(new EngineHubEpoch());
+            }
+        }
         sendMsg(new MsgReportSPEPosition(*this, ulpLocation, locationExtended,
-                                          status, techMask, dataNotifyCopy, msInWeek));
+                                          status, techMask, dataNotifyCopy, msInWeek,
+                                          std::move(engHubEpoch)),
+                MSG_TASK_PRIORITY_HIGH);
     }
 }
 
@@ -3809,21 +4549,25 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
         GnssAdapter& mAdapter;
         unsigned int mCount;
         EngineLocationInfo mEngLocInfo[LOC_OUTPUT_ENGINE_COUNT];
+        uint64_t mFanOutQtimer;
         inline MsgReportEnginePositions(GnssAdapter& adapter,
                                         unsigned int count,
                                         EngineLocationInfo* locationArr) :
             LocMsg(),
             mAdapter(adapter),
-            mCount(count) {
+            mCount(count),
+            mFanOutQtimer(getQTimerTickCount()) {
             if (mCount > LOC_OUTPUT_ENGINE_COUNT) {
                 mCount = LOC_OUTPUT_ENGINE_COUNT;
             }
-            if (mCount > 0) {
-                memcpy(mEngLocInfo, locationArr, sizeof(EngineLocationInfo)*mCount);
+            for (unsigned int i = 0; i < mCount; i++) {
+                loc_copy_engine_location_info(&mEngLocInfo[i], &locationArr[i]);
             }
         }
         inline virtual void proc() const {
+            mAdapter.mLatencyTrace = {0, mFanOutQtimer, getQTimerTickCount(), 0};
             mAdapter.reportEnginePositions(mCount, mEngLocInfo);
+            mAdapter.mLatencyTrace = {};
         }
     };
 
@@ -3901,6 +4645,33 @@ bool GnssAdapter::needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
     return retVal;
 }
 
+/* The sentence types someone is to get: all of them once there is an NMEA
+   client, or NMEA is printed; else only GGA, if the DGNSS NTRIP source
+   wants it */
+NmeaSentenceTypesMask
+GnssAdapter::getNmeaSentenceTypesInDemand()
+{
+    NmeaSentenceTypesMask sentenceTypes = 0;
+    if (mPowerProfile.nmeaEnabled && (isNMEAPrintEnabled() || !mNmeaClients.empty())) {
+        sentenceTypes = LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK;
+    }
+    if (isDgnssNmeaRequired()) {
+        sentenceTypes |= LOC_NMEA_GGA_MASK;
+    }
+    return sentenceTypes;
+}
+
+bool
+GnssAdapter::isGsvDecimated()
+{
+    // NMEA clients get GSV on every SV report, only the NMEA print is decimated
+    if (!mNmeaClients.empty()) {
+        return false;
+    }
+    uint32_t decimation = ContextBase::mGps_conf.NMEA_GSV_DECIMATION;
+    return (decimation > 1 && 0 != (mGsvReportCount++ % decimation));
+}
+
 void
 GnssAdapter::logLatencyInfo()
 {
@@ -3965,38 +4736,156 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                             enum loc_sess_status status,
                             LocPosTechMask techMask)
 {
+    LOC_ATRACE_SCOPE("GnssAdapter::reportPosition");
     bool reportToGnssClient = needReportForGnssClient(ulpLocation, status, techMask);
     bool reportToFlpClient = needReportForFlpClient(status, techMask);
 
+    if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE) {
+        updateDgnssCorrectionAge(locationExtended);
+    }
+
+    // engine fixes standing in for the fused one were recorded by
+    // reportEnginePositions already
+    if (nullptr != mRecorder && LOC_SESS_FAILURE != status &&
+            (0 == (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE) ||
+             LOC_OUTPUT_ENGINE_FUSED == locationExtended.locOutputEngType)) {
+        mRecorder->recordPosition(ulpLocation, locationExtended, techMask);
+    }
+
     if (reportToGnssClient || reportToFlpClient) {
         GnssLocationInfoNotification locationInfo = {};
-        convertLocationInfo(locationInfo, locationExtended, status);
         convertLocation(locationInfo.location, ulpLocation, locationExtended);
+        // the rest of the location info is only converted once a client or
+        // the PACE injection needs it, and is then shared for this fix
+        bool locationInfoConverted = false;
+        auto getLocationInfo = [&] () -> const GnssLocationInfoNotification& {
+            if (!locationInfoConverted) {
+                convertLocationInfo(locationInfo, locationExtended, status);
+                locationInfoConverted = true;
+            }
+            return locationInfo;
+        };
+        if (!mGnssLatencyInfoQueue.empty()) {
+            mLatencyTrace.qmiIndQtimer = mGnssLatencyInfoQueue.front().hlosQtimer2;
+        }
         logLatencyInfo();
-        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-            if ((reportToFlpClient && isFlpClient(it->second)) ||
-                    (reportToGnssClient && !isFlpClient(it->second))) {
-                if (nullptr != it->second.gnssLocationInfoCb) {
-                    it->second.gnssLocationInfoCb(locationInfo);
-                } else if ((nullptr != it->second.engineLocationsInfoCb) &&
-                           (false == initEngHubProxy())) {
-                    // if engine hub is disabled, this is SPE fix from modem
-                    // we need to mark one copy marked as fused and one copy marked as PPE
-                    // and dispatch it to the engineLocationsInfoCb
-                    GnssLocationInfoNotification engLocationsInfo[2];
-                    engLocationsInfo[0] = locationInfo;
-                    engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
-                    engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
-                    engLocationsInfo[1] = locationInfo;
-                    it->second.engineLocationsInfoCb(2, engLocationsInfo);
-                } else if (nullptr != it->second.trackingCb) {
-                    it->second.trackingCb(locationInfo.location);
+        auto reportToClient = [this, &locationInfo, &getLocationInfo]
+                (const LocationCallbacks& callbacks) {
+            if (nullptr != callbacks.gnssLocationInfoCb) {
+                callbacks.gnssLocationInfoCb(getLocationInfo());
+            } else if ((nullptr != callbacks.engineLocationsInfoCb) &&
+                       (false == initEngHubProxy())) {
+                // if engine hub is disabled, this is SPE fix from modem
+                // we need to mark one copy marked as fused and one copy marked as PPE
+                // and dispatch it to the engineLocationsInfoCb
+                GnssLocationInfoNotification engLocationsInfo[2];
+                engLocationsInfo[0] = getLocationInfo();
+                engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
+                engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
+                engLocationsInfo[1] = locationInfo;
+                callbacks.engineLocationsInfoCb(2, engLocationsInfo);
+            } else if (nullptr != callbacks.trackingCb) {
+                callbacks.trackingCb(locationInfo.location);
+            }
+        };
+        if (reportToGnssClient) {
+            for (auto callbacks : mGnssPositionClients) {
+                reportToClient(*callbacks);
+            }
+        }
+        if (reportToFlpClient) {
+            for (auto callbacks : mFlpPositionClients) {
+                reportToClient(*callbacks);
+            }
+        }
+        // the batched clients report their fixes once enough of them are collected
+        if (!mBatchedPositionClients.empty()) {
+            uint64_t nowMs = getBootTimeMilliSec();
+            uint32_t batchSize = ContextBase::mGps_conf.TRACKING_REPORT_BATCH_SIZE;
+            uint32_t batchMs = ContextBase::mGps_conf.TRACKING_REPORT_BATCH_MS;
+            for (auto& batched : mBatchedPositionClients) {
+                if (batched.isFlp ? reportToFlpClient : reportToGnssClient) {
+                    if (batched.locations.empty()) {
+                        batched.firstFixMs = nowMs;
+                    }
+                    batched.locations.push_back(locationInfo.location);
+                    if ((0 != batchSize && batched.locations.size() >= batchSize) ||
+                        (0 != batchMs && nowMs - batched.firstFixMs >= batchMs)) {
+                        reportTrackingBatch(batched);
+                    }
+                }
+            }
+        }
+        // the decimated clients due by this fix, allowing for half an engine interval
+        // of jitter, get it and are next due one their interval later
+        if (!mDecimatedPositionClients.empty()) {
+            uint64_t nowMs = getBootTimeMilliSec();
+            uint64_t dueMs = nowMs + mLocPositionMode.min_interval / 2;
+            auto greater = std::greater<DecimatedPositionClient>();
+            while (!mDecimatedPositionClients.empty() &&
+                   mDecimatedPositionClients.front().nextDueMs <= dueMs) {
+                std::pop_heap(mDecimatedPositionClients.begin(),
+                              mDecimatedPositionClients.end(), greater);
+                mDuePositionClients.push_back(mDecimatedPositionClients.back());
+                mDecimatedPositionClients.pop_back();
+            }
+            for (auto& due : mDuePositionClients) {
+                if (due.isFlp ? reportToFlpClient : reportToGnssClient) {
+                    reportToClient(*due.callbacks);
+                    due.nextDueMs += due.intervalMs;
+                    if (due.nextDueMs <= dueMs) {
+                        due.nextDueMs = nowMs + due.intervalMs;
+                    }
                 }
+                mDecimatedPositionClients.push_back(due);
+                std::push_heap(mDecimatedPositionClients.begin(),
+                               mDecimatedPositionClients.end(), greater);
+            }
+            mDuePositionClients.clear();
+        }
+        // the distance filtered clients get the fix once it is far enough from
+        // the last one they got, the engine running at the smallest distance
+        const Location& location = locationInfo.location;
+        if (!mDistanceFilteredPositionClients.empty() &&
+                (LOCATION_HAS_LAT_LONG_BIT & location.flags)) {
+            double latRad = location.latitude * DEG2RAD;
+            double cosLat = cos(latRad);
+            for (auto& filtered : mDistanceFilteredPositionClients) {
+                if (!(filtered.isFlp ? reportToFlpClient : reportToGnssClient)) {
+                    continue;
+                }
+                if (filtered.hasLastFix) {
+                    double lastLatRad = filtered.lastLatitude * DEG2RAD;
+                    double sinDLat = sin((latRad - lastLatRad) / 2.0);
+                    double sinDLon = sin((location.longitude - filtered.lastLongitude) *
+                                         DEG2RAD / 2.0);
+                    double a = sinDLat * sinDLat +
+                            cosLat * cos(lastLatRad) * sinDLon * sinDLon;
+                    double distance =
+                            2.0 * TRACKING_EARTH_RADIUS_M * asin(sqrt(std::min(a, 1.0)));
+                    if (distance < filtered.minDistance) {
+                        continue;
+                    }
+                }
+                reportToClient(*filtered.callbacks);
+                filtered.hasLastFix = true;
+                filtered.lastLatitude = location.latitude;
+                filtered.lastLongitude = location.longitude;
             }
         }
+        // only the fixes of a traced report msg, once their clients are done
+        if (0 != mLatencyTrace.dequeueQtimer) {
+            mLatencyTrace.clientsDoneQtimer = getQTimerTickCount();
+            mLatencyTraces.push(mLatencyTrace);
+            mLatencyTrace = {};
+        }
 
         mGnssSvIdUsedInPosAvail = false;
         mGnssMbSvIdUsedInPosAvail = false;
+        if (reportToGnssClient && LOC_SESS_SUCCESS == status &&
+                1 == ContextBase::mGps_conf.WARM_START_CACHE_ENABLED) {
+            saveWarmStartCache(ulpLocation, locationExtended);
+        }
         if (reportToGnssClient) {
             if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA) {
                 mGnssSvIdUsedInPosAvail = true;
@@ -4010,6 +4899,7 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
             // if PACE is enabled
             if ((true == mLocConfigInfo.paceConfigInfo.isValid) &&
                 (true == mLocConfigInfo.paceConfigInfo.enable)) {
+                getLocationInfo();
                 // If fix has sensor contribution, and it is fused fix with DRE engine
                 // contributing to the fix, inject to modem
                 if ((LOC_POS_TECH_MASK_SENSORS & techMask) &&
@@ -4023,8 +4913,10 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         }
     }
 
+    NmeaSentenceTypesMask nmeaSentenceTypes = 0;
     if (needToGenerateNmeaReport(locationExtended.gpsTime.gpsTimeOfWeekMs,
-            locationExtended.timeStamp.apTimeStamp)) {
+            locationExtended.timeStamp.apTimeStamp) &&
+            0 != (nmeaSentenceTypes = getNmeaSentenceTypesInDemand())) {
         /*Only BlankNMEA sentence needs to be processed and sent, if both lat, long is 0 &
           horReliability is not set. */
         bool blank_fix = ((0 == ulpLocation.gpsLocation.latitude) &&
@@ -4037,13 +4929,16 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         std::vector<std::string> nmeaArraystr;
         int indexOfGGA = -1;
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo, generate_nmea,
-                custom_nmea_gga, nmeaArraystr, indexOfGGA, isTagBlockGroupingEnabled);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
+                custom_nmea_gga, nmeaArraystr, indexOfGGA, isTagBlockGroupingEnabled,
+                nmeaSentenceTypes);
+        if (nmeaSentenceTypes != LOC_NMEA_GGA_MASK) {
+            stringstream ss;
+            for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
+                ss << *itor;
+            }
+            string s = ss.str();
+            reportNmea(s.c_str(), s.length());
         }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
 
         /* DgnssNtrip */
         if (-1 != indexOfGGA && isDgnssNmeaRequired()) {
@@ -4079,13 +4974,10 @@ void
 GnssAdapter::reportEnginePositions(unsigned int count,
                                    const EngineLocationInfo* locationArr)
 {
-    bool needReportEnginePositions = false;
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.engineLocationsInfoCb) {
-            needReportEnginePositions = true;
-            break;
-        }
-    }
+    bool needReportEnginePositions = !mEnginePositionClients.empty();
+    bool fusedReported = false;
+    // the engine fix the clients get when the hub has no fused one this epoch
+    const EngineLocationInfo* selected = nullptr;
 
     GnssLocationInfoNotification locationInfo[LOC_OUTPUT_ENGINE_COUNT] = {};
     for (unsigned int i = 0; i < count; i++) {
@@ -4097,6 +4989,19 @@ GnssAdapter::reportEnginePositions(unsigned int count,
                            engLocation->locationExtended,
                            engLocation->sessionStatus,
                            engLocation->location.tech_mask);
+            fusedReported = true;
+        } else {
+            if (nullptr != mRecorder && LOC_SESS_FAILURE != engLocation->sessionStatus) {
+                mRecorder->recordPosition(engLocation->location,
+                                          engLocation->locationExtended,
+                                          engLocation->location.tech_mask);
+            }
+            if (LOC_SESS_FAILURE != engLocation->sessionStatus &&
+                    (LOC_GPS_LOCATION_HAS_ACCURACY & engLocation->location.gpsLocation.flags) &&
+                    (nullptr == selected || engLocation->location.gpsLocation.accuracy <
+                     selected->location.gpsLocation.accuracy)) {
+                selected = engLocation;
+            }
         }
 
         if (needReportEnginePositions) {
@@ -4108,6 +5013,15 @@ GnssAdapter::reportEnginePositions(unsigned int count,
         }
     }
 
+    if (!fusedReported && nullptr != selected &&
+            ENGINE_POSITION_SELECTION_BEST_ACCURACY ==
+            ContextBase::mGps_conf.ENGINE_POSITION_SELECTION) {
+        reportPosition(selected->location,
+                       selected->locationExtended,
+                       selected->sessionStatus,
+                       selected->location.tech_mask);
+    }
+
     const EngineLocationInfo* engLocation = locationArr;
     LOC_LOGv("engLocation->locationExtended.locOutputEngType=%d",
              engLocation->locationExtended.locOutputEngType);
@@ -4124,12 +5038,8 @@ GnssAdapter::reportEnginePositions(unsigned int count,
             LOC_LOGv("PPE hlosQtimer4=%" PRIi64 " ", mGnssLatencyInfoQueue.front().hlosQtimer4);
         }
     }
-    if (needReportEnginePositions) {
-        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-            if (nullptr != it->second.engineLocationsInfoCb) {
-                it->second.engineLocationsInfoCb(count, locationInfo);
-            }
-        }
+    for (auto callbacks : mEnginePositionClients) {
+        callbacks->engineLocationsInfoCb(count, locationInfo);
     }
 }
 
@@ -4138,7 +5048,20 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
                            bool fromEngineHub)
 {
     if (!fromEngineHub) {
-        mEngHubProxy->gnssReportSv(svNotify);
+        if (isEngHubEpochBundled()) {
+            if (mEngHubEpoch && mEngHubEpoch->hasSv) {
+                // no position came for the previous epoch
+                reportEngHubEpoch(mEngHubEpoch.get(), nullptr, nullptr, LOC_SESS_FAILURE);
+                mEngHubEpoch.reset();
+            }
+            if (!mEngHubEpoch) {
+                mEngHubEpoch.reset(new EngineHubEpoch());
+            }
+            mEngHubEpoch->hasSv = true;
+            mEngHubEpoch->svNotify = svNotify;
+        } else {
+            mEngHubProxy->gnssReportSv(svNotify);
+        }
         if (true == initEngHubProxy()){
             return;
         }
@@ -4160,9 +5083,108 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
     sendMsg(new MsgReportSv(*this, svNotify));
 }
 
+static bool
+svPassesFilter(const GnssSv& sv, const GnssSvFilter& filter)
+{
+    if (0 != filter.svTypesMask) {
+        GnssSvTypesMask svTypeBit = 0;
+        switch (sv.type) {
+            case GNSS_SV_TYPE_GPS:     svTypeBit = GNSS_SV_TYPES_MASK_GPS_BIT;   break;
+            case GNSS_SV_TYPE_GLONASS: svTypeBit = GNSS_SV_TYPES_MASK_GLO_BIT;   break;
+            case GNSS_SV_TYPE_QZSS:    svTypeBit = GNSS_SV_TYPES_MASK_QZSS_BIT;  break;
+            case GNSS_SV_TYPE_BEIDOU:  svTypeBit = GNSS_SV_TYPES_MASK_BDS_BIT;   break;
+            case GNSS_SV_TYPE_GALILEO: svTypeBit = GNSS_SV_TYPES_MASK_GAL_BIT;   break;
+            case GNSS_SV_TYPE_NAVIC:   svTypeBit = GNSS_SV_TYPES_MASK_NAVIC_BIT; break;
+            default:                   break;
+        }
+        if (0 == (filter.svTypesMask & svTypeBit)) {
+            return false;
+        }
+    }
+    if (sv.cN0Dbhz < filter.minCN0Dbhz) {
+        return false;
+    }
+    if (filter.usedInFixOnly &&
+            0 == (sv.gnssSvOptionsMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT)) {
+        return false;
+    }
+    return true;
+}
+
+static inline bool
+isSameSvFilter(const GnssSvFilter& a, const GnssSvFilter& b)
+{
+    return a.svTypesMask == b.svTypesMask && a.minCN0Dbhz == b.minCN0Dbhz &&
+            a.usedInFixOnly == b.usedInFixOnly;
+}
+
+void
+GnssAdapter::setSvFilterCommand(LocationAPI* client, const GnssSvFilter& filter)
+{
+    struct MsgSetSvFilter : public LocMsg {
+        GnssAdapter& mAdapter;
+        LocationAPI* mClient;
+        const GnssSvFilter mFilter;
+        inline MsgSetSvFilter(GnssAdapter& adapter, LocationAPI* client,
+                              const GnssSvFilter& filter) :
+            LocMsg(),
+            mAdapter(adapter),
+            mClient(client),
+            mFilter(filter) {}
+        inline virtual void proc() const {
+            if (mAdapter.mClientData.find(mClient) == mAdapter.mClientData.end()) {
+                LOC_LOGe("client %p not registered", mClient);
+                return;
+            }
+            if (0 == mFilter.svTypesMask && mFilter.minCN0Dbhz <= 0 &&
+                    !mFilter.usedInFixOnly) {
+                mAdapter.mSvFilters.erase(mClient);
+            } else {
+                mAdapter.mSvFilters[mClient] = mFilter;
+            }
+            LOC_LOGd("client %p, sv types 0x%" PRIx64 ", min cn0 %.1f, used in fix only %d",
+                     mClient, mFilter.svTypesMask, mFilter.minCN0Dbhz, mFilter.usedInFixOnly);
+            // the subscribers point into mSvFilters
+            mAdapter.updateClientSubscribers();
+        }
+    };
+
+    sendMsg(new MsgSetSvFilter(*this, client, filter));
+}
+
+/* Clients without a filter share the full report, the others get it cut down
+   to their SVs; the cut is made once for clients in a row with equal filters */
+void
+GnssAdapter::reportSvToClients(const GnssSvNotification& svNotify)
+{
+    const GnssSvFilter* lastFilter = nullptr;
+    for (auto& client : mSvClients) {
+        if (nullptr == client.filter) {
+            client.callbacks->gnssSvCb(svNotify);
+            continue;
+        }
+        if (nullptr == lastFilter || !isSameSvFilter(*lastFilter, *client.filter)) {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < svNotify.count && i < GNSS_SV_MAX; i++) {
+                if (svPassesFilter(svNotify.gnssSvs[i], *client.filter)) {
+                    mSvFilteredNotify.gnssSvs[count++] = svNotify.gnssSvs[i];
+                }
+            }
+            mSvFilteredNotify.size = svNotify.size;
+            mSvFilteredNotify.count = count;
+            mSvFilteredNotify.gnssSignalTypeMaskValid = svNotify.gnssSignalTypeMaskValid;
+            lastFilter = client.filter;
+        }
+        client.callbacks->gnssSvCb(mSvFilteredNotify);
+    }
+}
+
 void
 GnssAdapter::reportSv(GnssSvNotification& svNotify)
 {
+    if (nullptr != mRecorder) {
+        mRecorder->recordSv(svNotify);
+    }
     int numSv = svNotify.count;
     uint16_t gnssSvId = 0;
     uint64_t svUsedIdMask = 0;
@@ -4299,16 +5321,25 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
         }
     }
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssSvCb) {
-            it->second.gnssSvCb(svNotify);
-        }
+    // merged per satellite once, with the marking above, for all that walk
+    // this report by satellite
+    mSvEpoch.build(svNotify);
+
+    // the used in fix marking above keeps up with every report, only the
+    // delivery is cut down by the power profile
+    bool decimated = (mPowerProfile.svDecimation > 1 &&
+                      0 != (mSvReportCount++ % mPowerProfile.svDecimation));
+    if (!decimated) {
+        reportSvToClients(svNotify);
     }
 
-    if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
-        !mTimeBasedTrackingSessions.empty()) {
+    NmeaSentenceTypesMask nmeaSentenceTypes = 0;
+    if (!decimated && NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
+        !mTimeBasedTrackingSessions.empty() &&
+        0 != ((nmeaSentenceTypes = getNmeaSentenceTypesInDemand()) & LOC_NMEA_GSV_MASK) &&
+        !isGsvDecimated()) {
         std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
+        loc_nmea_generate_sv(mSvEpoch, nmeaArraystr, nmeaSentenceTypes);
         stringstream ss;
         for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
             ss << *itor;
@@ -4372,6 +5403,10 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
 void
 GnssAdapter::reportNmea(const char* nmea, size_t length)
 {
+    if (!mPowerProfile.nmeaEnabled) {
+        return;
+    }
+
     GnssNmeaNotification nmeaNotification = {};
     nmeaNotification.size = sizeof(GnssNmeaNotification);
 
@@ -4382,10 +5417,8 @@ GnssAdapter::reportNmea(const char* nmea, size_t length)
     nmeaNotification.nmea = nmea;
     nmeaNotification.length = length;
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssNmeaCb) {
-            it->second.gnssNmeaCb(nmeaNotification);
-        }
+    for (auto callbacks : mNmeaClients) {
+        callbacks->gnssNmeaCb(nmeaNotification);
     }
 
     if (isNMEAPrintEnabled()) {
@@ -4410,6 +5443,10 @@ GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
             mMsInWeek(msInWeek) {
         }
         inline virtual void proc() const {
+            // the last client may have gone since this was queued
+            if (mAdapter.mDataClients.empty()) {
+                return;
+            }
             if (mMsInWeek >= 0) {
                 mAdapter.getDataInformation((GnssDataNotification&)mDataNotify,
                                             mMsInWeek);
@@ -4418,7 +5455,9 @@ GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
         }
     };
 
-    sendMsg(new MsgReportData(*this, dataNotify, msInWeek));
+    if (mDataWanted) {
+        sendMsg(new MsgReportData(*this, dataNotify, msInWeek));
+    }
 }
 
 void
@@ -4434,10 +5473,8 @@ GnssAdapter::reportData(GnssDataNotification& dataNotify)
             LOC_LOGv("agc[%d]=%f", sig, dataNotify.agc[sig]);
         }
     }
-    for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssDataCb) {
-            it->second.gnssDataCb(dataNotify);
-        }
+    for (auto callbacks : mDataClients) {
+        callbacks->gnssDataCb(dataNotify);
     }
 }
 
@@ -4475,6 +5512,9 @@ GnssAdapter::requestNiNotifyEvent(const GnssNiNotification &notify, const void*
             bIsInEmergency = ((LOC_IN_EMERGENCY_UNKNOWN == mEmergencyState) &&
                     mAdapter.getE911State()) ||                // older modems
                     (LOC_IN_EMERGENCY_SET == mEmergencyState); // newer modems
+            if (bIsInEmergency) {
+                mAdapter.agpsPreconnectForEmergency();
+            }
 
             if ((mAdapter.mSupportNfwControl || 0 == mAdapter.getAfwControlId()) &&
                 (GNSS_NI_TYPE_SUPL == mNotify.type || GNSS_NI_TYPE_EMERGENCY_SUPL == mNotify.type)
@@ -4511,7 +5551,8 @@ GnssAdapter::requestNiNotifyEvent(const GnssNiNotification &notify, const void*
         }
     };
 
-    sendMsg(new MsgReportNiNotify(*this, *mLocApi, notify, data, emergencyState));
+    sendMsg(new MsgReportNiNotify(*this, *mLocApi, notify, data, emergencyState),
+            MSG_TASK_PRIORITY_HIGH);
 
     return true;
 }
@@ -4721,46 +5762,63 @@ GnssAdapter::requestNiNotify(const GnssNiNotification& notify, const void* data,
 }
 
 void
-GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurements,
-                                            int msInWeek)
+GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurementsPtr& gnssMeasurements,
+                                         int msInWeek)
 {
     LOC_LOGD("%s]: msInWeek=%d", __func__, msInWeek);
 
-    if (0 != gnssMeasurements.gnssMeasNotification.count) {
+    if (0 != gnssMeasurements->gnssMeasNotification.count) {
         struct MsgReportGnssMeasurementData : public LocMsg {
             GnssAdapter& mAdapter;
-            GnssMeasurements mGnssMeasurements;
-            GnssMeasurementsNotification mMeasurementsNotify;
+            // shared with LocApi, only read from here on
+            const GnssMeasurementsPtr mGnssMeasurements;
             inline MsgReportGnssMeasurementData(GnssAdapter& adapter,
-                                                const GnssMeasurements& gnssMeasurements,
-                                                int msInWeek) :
+                                                const GnssMeasurementsPtr& gnssMeasurements) :
                     LocMsg(),
                     mAdapter(adapter),
-                    mMeasurementsNotify(gnssMeasurements.gnssMeasNotification) {
-                if (-1 != msInWeek) {
-                    mAdapter.getAgcInformation(mMeasurementsNotify, msInWeek);
-                }
-            }
+                    mGnssMeasurements(gnssMeasurements) {}
             inline virtual void proc() const {
-                mAdapter.reportGnssMeasurementData(mMeasurementsNotify);
+                mAdapter.reportGnssMeasurementData(mGnssMeasurements->gnssMeasNotification);
             }
         };
 
-        sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements, msInWeek));
+        if (-1 != msInWeek && mMeasurementsAgcWanted) {
+            getAgcInformation(gnssMeasurements->gnssMeasNotification, msInWeek);
+        }
+        sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements));
+    }
+    if (isEngHubEpochBundled()) {
+        if (mEngHubEpoch && mEngHubEpoch->measurements) {
+            // no position came for the previous epoch
+            reportEngHubEpoch(mEngHubEpoch.get(), nullptr, nullptr, LOC_SESS_FAILURE);
+            mEngHubEpoch.reset();
+        }
+        if (!mEngHubEpoch) {
+            mEngHubEpoch.reset(new EngineHubEpoch());
+        }
+        // shared with the client report, no copy
+        mEngHubEpoch->measurements = gnssMeasurements;
+    } else {
+        mEngHubProxy->gnssReportSvMeasurement(gnssMeasurements->gnssSvMeasurementSet);
     }
-    mEngHubProxy->gnssReportSvMeasurement(gnssMeasurements.gnssSvMeasurementSet);
     if (mDGnssNeedReport) {
-        reportDGnssDataUsable(gnssMeasurements.gnssSvMeasurementSet);
+        reportDGnssDataUsable(gnssMeasurements->gnssSvMeasurementSet);
     }
 }
 
 void
 GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measurements)
 {
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssMeasurementsCb) {
-            it->second.gnssMeasurementsCb(measurements);
-        }
+    // every epoch is recorded, decimated or not
+    if (nullptr != mRecorder) {
+        mRecorder->recordMeasurements(measurements);
+    }
+    if (mPowerProfile.measurementsDecimation > 1 &&
+            0 != (mMeasurementsReportCount++ % mPowerProfile.measurementsDecimation)) {
+        return;
+    }
+    for (auto callbacks : mMeasurementsClients) {
+        callbacks->gnssMeasurementsCb(measurements);
     }
 }
 
@@ -4789,7 +5847,42 @@ void
 GnssAdapter::reportSvPolynomialEvent(GnssSvPolynomial &svPolynomial)
 {
     LOC_LOGD("%s]: ", __func__);
-    mEngHubProxy->gnssReportSvPolynomial(svPolynomial);
+    if (isEngHubEpochBundled()) {
+        if (!mEngHubEpoch) {
+            mEngHubEpoch.reset(new EngineHubEpoch());
+        }
+        mEngHubEpoch->svPolynomials.push_back(svPolynomial);
+    } else {
+        mEngHubProxy->gnssReportSvPolynomial(svPolynomial);
+    }
+}
+
+bool
+GnssAdapter::isEngHubEpochBundled()
+{
+    return initEngHubProxy() && mEngHubProxy->isEpochBundleSupported();
+}
+
+void
+GnssAdapter::reportEngHubEpoch(const EngineHubEpoch* epoch, const UlpLocation* location,
+                               const GpsLocationExtended* locationExtended,
+                               enum loc_sess_status status)
+{
+    GnssEpochBundle bundle = {};
+    bundle.location = location;
+    bundle.locationExtended = locationExtended;
+    bundle.status = status;
+    if (epoch->hasSv) {
+        bundle.svNotify = &epoch->svNotify;
+    }
+    if (epoch->measurements) {
+        bundle.svMeasurementSet = &epoch->measurements->gnssSvMeasurementSet;
+    }
+    if (!epoch->svPolynomials.empty()) {
+        bundle.svPolynomials = epoch->svPolynomials.data();
+        bundle.svPolynomialCount = epoch->svPolynomials.size();
+    }
+    mEngHubProxy->gnssReportEpochBundle(bundle);
 }
 
 void
@@ -4815,12 +5908,15 @@ GnssAdapter::requestOdcpiEvent(OdcpiRequestInfo& request)
         }
     };
 
-    sendMsg(new MsgRequestOdcpi(*this, request));
+    sendMsg(new MsgRequestOdcpi(*this, request), MSG_TASK_PRIORITY_HIGH);
     return true;
 }
 
 void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
 {
+    if (ODCPI_REQUEST_TYPE_START == request.type && request.isEmergencyMode) {
+        agpsPreconnectForEmergency();
+    }
     if (nullptr != mOdcpiRequestCb) {
         LOC_LOGd("request: type %d, tbf %d, isEmergency %d"
                  " requestActive: %d timerActive: %d",
@@ -4831,7 +5927,9 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
         // extending the odcpi session past 30 seconds if needed
         if (ODCPI_REQUEST_TYPE_START == request.type) {
             if (false == mOdcpiRequestActive && false == mOdcpiTimer.isActive()) {
-                mOdcpiRequestCb(request);
+                if (!injectOdcpiFromCache(request)) {
+                    requestOdcpiFromFramework(request);
+                }
                 mOdcpiRequestActive = true;
                 mOdcpiTimer.start();
             // if the current active odcpi session is non-emergency, and the new
@@ -4839,7 +5937,7 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
             // and restart the timer
             } else if (false == mOdcpiRequest.isEmergencyMode &&
                        true == request.isEmergencyMode) {
-                mOdcpiRequestCb(request);
+                requestOdcpiFromFramework(request);
                 mOdcpiRequestActive = true;
                 if (true == mOdcpiTimer.isActive()) {
                     mOdcpiTimer.restart();
@@ -4858,7 +5956,11 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
         // to avoid spamming more odcpi requests to the framework
         } else if (ODCPI_REQUEST_TYPE_STOP == request.type) {
             LOC_LOGd("request: type %d, isEmergency %d", request.type, request.isEmergencyMode);
-            mOdcpiRequestCb(request);
+            // nothing to stop if the requests were all served from cache
+            if (mOdcpiFrameworkRequested) {
+                mOdcpiRequestCb(request);
+                mOdcpiFrameworkRequested = false;
+            }
             mOdcpiRequestActive = false;
         } else {
             LOC_LOGE("Invalid ODCPI request type..");
@@ -4868,6 +5970,37 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
     }
 }
 
+void GnssAdapter::requestOdcpiFromFramework(const OdcpiRequestInfo& request)
+{
+    mOdcpiRequestCb(request);
+    mOdcpiFrameworkRequested = true;
+}
+
+bool GnssAdapter::injectOdcpiFromCache(const OdcpiRequestInfo& request)
+{
+    const loc_gps_cfg_s_type& gpsConf = ContextBase::mGps_conf;
+    // an emergency request always gets a fresh position
+    if (0 == gpsConf.ODCPI_CACHE_MAX_AGE_MS || 0 == mOdcpiCachedTimeMs ||
+        request.isEmergencyMode) {
+        return false;
+    }
+
+    uint64_t ageMs = getBootTimeMilliSec() - mOdcpiCachedTimeMs;
+    if (ageMs > gpsConf.ODCPI_CACHE_MAX_AGE_MS) {
+        return false;
+    }
+    if (0 != gpsConf.ODCPI_CACHE_MAX_ACCURACY_M &&
+        (!(mOdcpiCachedLocation.flags & LOCATION_HAS_ACCURACY_BIT) ||
+         mOdcpiCachedLocation.accuracy > gpsConf.ODCPI_CACHE_MAX_ACCURACY_M)) {
+        return false;
+    }
+
+    LOC_LOGd("ODCPI served from cache, age %" PRIu64 " ms, accuracy %.1f",
+             ageMs, mOdcpiCachedLocation.accuracy);
+    mLocApi->injectPosition(mOdcpiCachedLocation, true);
+    return true;
+}
+
 bool GnssAdapter::reportDeleteAidingDataEvent(GnssAidingData& aidingData)
 {
     LOC_LOGD("%s]:", __func__);
@@ -4973,6 +6106,8 @@ void GnssAdapter::injectOdcpi(const Location& location)
             mOdcpiRequestActive, mOdcpiTimer.isActive(),
             location.latitude, location.longitude);
 
+    mOdcpiCachedLocation = location;
+    mOdcpiCachedTimeMs = getBootTimeMilliSec();
     mLocApi->injectPosition(location, true);
 }
 
@@ -5006,7 +6141,9 @@ void GnssAdapter::odcpiTimerExpire()
     // if ODCPI request is still active after timer
     // expires, request again and restart timer
     if (mOdcpiRequestActive) {
-        mOdcpiRequestCb(mOdcpiRequest);
+        if (!injectOdcpiFromCache(mOdcpiRequest)) {
+            requestOdcpiFromFramework(mOdcpiRequest);
+        }
         mOdcpiTimer.restart();
     } else {
         mOdcpiTimer.stop();
@@ -5015,9 +6152,15 @@ void GnssAdapter::odcpiTimerExpire()
 
 void
 GnssAdapter::invokeGnssEnergyConsumedCallback(uint64_t energyConsumedSinceFirstBoot) {
-    if (mGnssEnergyConsumedCb) {
-        mGnssEnergyConsumedCb(energyConsumedSinceFirstBoot);
-        mGnssEnergyConsumedCb = nullptr;
+    mGnssEnergyConsumed = energyConsumedSinceFirstBoot;
+    mGnssEnergyConsumedTimeMs = getBootTimeMilliSec();
+    // everyone who asked while the query was in flight gets this answer
+    std::vector<GnssEnergyConsumedCallback> callbacks;
+    callbacks.swap(mGnssEnergyConsumedCbs);
+    for (auto& callback : callbacks) {
+        if (callback) {
+            callback(energyConsumedSinceFirstBoot);
+        }
     }
 }
 
@@ -5077,6 +6220,7 @@ void GnssAdapter::initDefaultAgpsCommand() {
             mAdapter(adapter) {
             }
         inline virtual void proc() const {
+            InitStageTimer stageTimer("default agps");
             mAdapter.initDefaultAgps();
         }
     };
@@ -5100,6 +6244,27 @@ void GnssAdapter::initAgps(const AgpsCbInfo& cbInfo) {
             LOC_REGISTRATION_MASK_ENABLED);
 }
 
+/* on each sign of an emergency session, (re)starts the window during which
+   the SUPL data call is kept up ahead of the engine's requests */
+void GnssAdapter::agpsPreconnectForEmergency() {
+    uint32_t windowSec = ContextBase::mGps_conf.AGPS_E911_PRECONNECT_SEC;
+    if (0 == windowSec || !mAgpsManager.isRegistered()) {
+        return;
+    }
+    LOC_LOGD("%s]: SUPL preconnect for %u sec", __func__, windowSec);
+    mAgpsManager.preconnect(true);
+    mAgpsPreconnectTimer.stop();
+    mAgpsPreconnectTimer.start(windowSec * 1000, false);
+}
+
+// Called in the context of LocTimer thread
+void GnssAdapter::AgpsPreconnectTimer::timeOutCallback() {
+    GnssAdapter& adapter = mAdapter;
+    adapter.mMsgTask->sendMsg([&adapter] {
+        adapter.mAgpsManager.preconnect(false);
+    });
+}
+
 void GnssAdapter::initAgpsCommand(const AgpsCbInfo& cbInfo){
     LOC_LOGI("GnssAdapter::initAgpsCommand");
 
@@ -5529,11 +6694,16 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
         return false;
     }
 
+    // taken before the items, so a change in between only costs a rebuild
+    uint64_t satelliteInfoGeneration = systemstatus->getSatelliteInfoGeneration();
     SystemStatusReports reports = {};
-    systemstatus->getReport(reports, true);
+    systemstatus->getDebugReportItems(reports);
 
     r.size = sizeof(r);
 
+    // lock free, this runs on the HIDL thread while fixes are traced
+    mLatencyTraces.snapshot(r.mLatencyTrace);
+
     // location block
     r.mLocation.size = sizeof(r.mLocation);
     if(!reports.mLocation.empty() && reports.mLocation.back().mValid) {
@@ -5617,13 +6787,22 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
         r.mTime.mValid = false;
     }
 
-    // satellite info block
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GPS, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GLONASS, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_QZSS, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_BEIDOU, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GALILEO, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_NAVIC, reports);
+    // satellite info block, only rebuilt when its sources changed
+    std::shared_ptr<const DebugSatelliteInfo> satellites = std::atomic_load(&mDebugSatelliteInfo);
+    if (nullptr == satellites || satellites->mGeneration != satelliteInfoGeneration) {
+        std::shared_ptr<DebugSatelliteInfo> rebuilt = std::make_shared<DebugSatelliteInfo>();
+        rebuilt->mGeneration = satelliteInfoGeneration;
+        rebuilt->mInfo.reserve(SV_ALL_NUM);
+        convertSatelliteInfo(rebuilt->mInfo, GNSS_SV_TYPE_GPS, reports);
+        convertSatelliteInfo(rebuilt->mInfo, GNSS_SV_TYPE_GLONASS, reports);
+        convertSatelliteInfo(rebuilt->mInfo, GNSS_SV_TYPE_QZSS, reports);
+        convertSatelliteInfo(rebuilt->mInfo, GNSS_SV_TYPE_BEIDOU, reports);
+        convertSatelliteInfo(rebuilt->mInfo, GNSS_SV_TYPE_GALILEO, reports);
+        convertSatelliteInfo(rebuilt->mInfo, GNSS_SV_TYPE_NAVIC, reports);
+        satellites = rebuilt;
+        std::atomic_store(&mDebugSatelliteInfo, satellites);
+    }
+    r.mSatelliteInfo = satellites->mInfo;
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
 
     return true;
@@ -5805,30 +6984,51 @@ static void agpsCloseResultCb (bool isSuccess, AGpsExtType agpsType, void* userD
     }
 }
 
+// a query the modem has not answered in this long is sent again
+#define GNSS_ENERGY_CONSUMED_QUERY_TIMEOUT_MS 5000
+
 void
-GnssAdapter::saveGnssEnergyConsumedCallback(GnssEnergyConsumedCallback energyConsumedCb) {
-    mGnssEnergyConsumedCb = energyConsumedCb;
+GnssAdapter::requestGnssEnergyConsumed(const GnssEnergyConsumedCallback& energyConsumedCb) {
+    uint64_t nowMs = getBootTimeMilliSec();
+    uint32_t maxAgeMs = ContextBase::mGps_conf.GNSS_ENERGY_CACHE_MAX_AGE_MS;
+    if (0 != maxAgeMs && 0 != mGnssEnergyConsumedTimeMs &&
+        nowMs - mGnssEnergyConsumedTimeMs <= maxAgeMs) {
+        LOC_LOGd("energy consumed served from cache, age %" PRIu64 " ms",
+                 nowMs - mGnssEnergyConsumedTimeMs);
+        if (energyConsumedCb) {
+            energyConsumedCb(mGnssEnergyConsumed);
+        }
+        return;
+    }
+
+    bool inFlight = !mGnssEnergyConsumedCbs.empty() &&
+            nowMs - mGnssEnergyConsumedQueryTimeMs < GNSS_ENERGY_CONSUMED_QUERY_TIMEOUT_MS;
+    mGnssEnergyConsumedCbs.push_back(energyConsumedCb);
+    if (inFlight) {
+        LOC_LOGd("energy consumed query in flight, %zu waiting",
+                 mGnssEnergyConsumedCbs.size());
+    } else {
+        mGnssEnergyConsumedQueryTimeMs = nowMs;
+        mLocApi->getGnssEnergyConsumed();
+    }
 }
 
 void
 GnssAdapter::getGnssEnergyConsumedCommand(GnssEnergyConsumedCallback energyConsumedCb) {
     struct MsgGetGnssEnergyConsumed : public LocMsg {
         GnssAdapter& mAdapter;
-        LocApiBase& mApi;
         GnssEnergyConsumedCallback mEnergyConsumedCb;
-        inline MsgGetGnssEnergyConsumed(GnssAdapter& adapter, LocApiBase& api,
+        inline MsgGetGnssEnergyConsumed(GnssAdapter& adapter,
                                         GnssEnergyConsumedCallback energyConsumedCb) :
             LocMsg(),
             mAdapter(adapter),
-            mApi(api),
             mEnergyConsumedCb(energyConsumedCb){}
         inline virtual void proc() const {
-            mAdapter.saveGnssEnergyConsumedCallback(mEnergyConsumedCb);
-            mApi.getGnssEnergyConsumed();
+            mAdapter.requestGnssEnergyConsumed(mEnergyConsumedCb);
         }
     };
 
-    sendMsg(new MsgGetGnssEnergyConsumed(*this, *mLocApi, energyConsumedCb));
+    sendMsg(new MsgGetGnssEnergyConsumed(*this, energyConsumedCb));
 }
 
 void
@@ -6183,6 +7383,10 @@ GnssAdapter::configLeverArmCommand(const LeverArmConfigInfo& configInfo) {
                 mAdapter.mLocConfigInfo.leverArmConfigInfo.leverArmValidMask |=
                         LEVER_ARM_TYPE_GNSS_TO_VRP_BIT;
                 mAdapter.mLocConfigInfo.leverArmConfigInfo.gnssToVRP = mConfigInfo.gnssToVRP;
+                float leverArm[3] = {mConfigInfo.gnssToVRP.forwardOffsetMeters,
+                                     mConfigInfo.gnssToVRP.sidewaysOffsetMeters,
+                                     mConfigInfo.gnssToVRP.upOffsetMeters};
+                loc_vrp_transform_init(&mAdapter.mLocConfigInfo.vrpTransform, leverArm);
             }
             mAdapter.configLeverArm(mSessionId, mConfigInfo);
         }
@@ -6239,39 +7443,144 @@ bool GnssAdapter::openMeasCorrCommand(const measCorrSetCapabilitiesCb setCapabil
         }
 }
 
+static inline uint64_t
+measCorrKey(const GnssSingleSatCorrection& corr)
+{
+    uint32_t freqBits = 0;
+    memcpy(&freqBits, &corr.carrierFrequencyHz, sizeof(freqBits));
+    return ((uint64_t)corr.svType << 48) | ((uint64_t)corr.svId << 32) | freqBits;
+}
+
+static inline bool
+measCorrValid(const GnssSingleSatCorrection& corr)
+{
+    if (GNSS_SV_TYPE_UNKNOWN == corr.svType || 0 == corr.svId) {
+        return false;
+    }
+    if ((corr.flags & GNSS_MEAS_CORR_HAS_SAT_IS_LOS_PROBABILITY_BIT) &&
+        !(corr.probSatIsLos >= 0.0f && corr.probSatIsLos <= 1.0f)) {
+        return false;
+    }
+    if ((corr.flags & GNSS_MEAS_CORR_HAS_EXCESS_PATH_LENGTH_BIT) &&
+        !(corr.excessPathLengthMeters >= 0.0f)) {
+        return false;
+    }
+    return true;
+}
+
+static inline bool
+measCorrEqual(const GnssSingleSatCorrection& a, const GnssSingleSatCorrection& b)
+{
+    return a.flags == b.flags &&
+           a.probSatIsLos == b.probSatIsLos &&
+           a.excessPathLengthMeters == b.excessPathLengthMeters &&
+           a.excessPathLengthUncertaintyMeters == b.excessPathLengthUncertaintyMeters &&
+           a.reflectingPlane.latitudeDegrees == b.reflectingPlane.latitudeDegrees &&
+           a.reflectingPlane.longitudeDegrees == b.reflectingPlane.longitudeDegrees &&
+           a.reflectingPlane.altitudeMeters == b.reflectingPlane.altitudeMeters &&
+           a.reflectingPlane.azimuthDegrees == b.reflectingPlane.azimuthDegrees;
+}
+
 bool GnssAdapter::measCorrSetCorrectionsCommand(const GnssMeasurementCorrections gnssMeasCorr) {
     LOC_LOGi("GnssAdapter::measCorrSetCorrectionsCommand");
 
-    /* Message to set Measurement Corrections */
-    struct MsgSetCorrectionsMeasCorr : public LocMsg {
-        const GnssMeasurementCorrections mGnssMeasCorr;
+    if (!ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_MEASUREMENTS_CORRECTION)) {
+        LOC_LOGw("Measurement Corrections are not supported!");
+        return false;
+    }
+
+    // validate on the caller's thread so bad entries never reach the drain
+    GnssMeasurementCorrections measCorr = gnssMeasCorr;
+    size_t total = measCorr.satCorrections.size();
+    measCorr.satCorrections.erase(
+            std::remove_if(measCorr.satCorrections.begin(), measCorr.satCorrections.end(),
+                           [](const GnssSingleSatCorrection& corr) {
+                               return !measCorrValid(corr);
+                           }),
+            measCorr.satCorrections.end());
+    if (measCorr.satCorrections.size() != total) {
+        LOC_LOGw("dropped %zu invalid single satellite corrections",
+                 total - measCorr.satCorrections.size());
+    }
+
+    bool queueDrain = false;
+    {
+        std::lock_guard<std::mutex> lock(mMeasCorrMutex);
+        mMeasCorrPending = std::move(measCorr);
+        queueDrain = !mMeasCorrDrainQueued;
+        mMeasCorrDrainQueued = true;
+    }
+
+    /* Message to hand the latest Measurement Corrections to the engine */
+    struct MsgDrainMeasCorr : public LocMsg {
         GnssAdapter& mAdapter;
-        LocApiBase& mApi;
 
-        inline MsgSetCorrectionsMeasCorr(
-            const GnssMeasurementCorrections gnssMeasCorr,
-            GnssAdapter& adapter,
-            LocApiBase& api) :
+        inline MsgDrainMeasCorr(GnssAdapter& adapter) :
             LocMsg(),
-            mGnssMeasCorr(gnssMeasCorr),
-            mAdapter(adapter),
-            mApi(api) {
-            LOC_LOGv("MsgSetCorrectionsMeasCorr");
+            mAdapter(adapter) {
+            LOC_LOGv("MsgDrainMeasCorr");
         }
 
         inline virtual void proc() const {
-            LOC_LOGv("MsgSetCorrectionsMeasCorr::proc()");
-            mApi.setMeasurementCorrections(mGnssMeasCorr);
+            LOC_LOGv("MsgDrainMeasCorr::proc()");
+            mAdapter.drainMeasCorr();
         }
     };
 
-    if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_MEASUREMENTS_CORRECTION)) {
-        sendMsg(new MsgSetCorrectionsMeasCorr(gnssMeasCorr, *this, *mLocApi));
-        return true;
-    } else {
-        LOC_LOGw("Measurement Corrections are not supported!");
-        return false;
+    // runs on the LocApi thread, next to the engine call it feeds, so that
+    // a burst of updates does not hold up the adapter's own queue
+    if (queueDrain) {
+        mLocApi->sendMsg(new MsgDrainMeasCorr(*this));
+    }
+    return true;
+}
+
+void GnssAdapter::drainMeasCorr() {
+    GnssMeasurementCorrections latest;
+    {
+        std::lock_guard<std::mutex> lock(mMeasCorrMutex);
+        latest = std::move(mMeasCorrPending);
+        mMeasCorrPending.satCorrections.clear();
+        mMeasCorrDrainQueued = false;
+    }
+
+    bool resync = mMeasCorrResync.exchange(false);
+    std::map<uint64_t, GnssSingleSatCorrection> cache;
+    std::vector<GnssSingleSatCorrection> changed;
+    changed.reserve(latest.satCorrections.size());
+    for (const GnssSingleSatCorrection& corr : latest.satCorrections) {
+        uint64_t key = measCorrKey(corr);
+        cache.emplace(key, corr);
+        auto it = mMeasCorrCache.find(key);
+        if (mMeasCorrCache.end() == it || !measCorrEqual(it->second, corr)) {
+            changed.push_back(corr);
+        }
+    }
+    // a satellite that left the set can only be withdrawn by a full update
+    for (const auto& entry : mMeasCorrCache) {
+        if (cache.end() == cache.find(entry.first)) {
+            resync = true;
+            break;
+        }
     }
+    mMeasCorrCache.swap(cache);
+
+    if (!resync) {
+        if (changed.empty() &&
+            latest.latitudeDegrees == mMeasCorrLastSent.latitudeDegrees &&
+            latest.longitudeDegrees == mMeasCorrLastSent.longitudeDegrees &&
+            latest.altitudeMeters == mMeasCorrLastSent.altitudeMeters) {
+            LOC_LOGv("measurement corrections unchanged, not sent");
+            return;
+        }
+        LOC_LOGv("sending %zu of %zu single satellite corrections",
+                 changed.size(), latest.satCorrections.size());
+        latest.satCorrections.swap(changed);
+    }
+    mLocApi->setMeasurementCorrections(latest);
+    mMeasCorrLastSent.latitudeDegrees = latest.latitudeDegrees;
+    mMeasCorrLastSent.longitudeDegrees = latest.longitudeDegrees;
+    mMeasCorrLastSent.altitudeMeters = latest.altitudeMeters;
 }
 uint32_t GnssAdapter::antennaInfoInitCommand(const antennaInfoCb antennaInfoCallback) {
     LOC_LOGi("GnssAdapter::antennaInfoInitCommand");
@@ -6511,6 +7820,7 @@ GnssAdapter::initEngHubProxyCommand() {
             LocMsg(),
             mAdapter(adapter) {}
         inline virtual void proc() const {
+            InitStageTimer stageTimer("engine hub");
             mAdapter->initEngHubProxy();
         }
     };
@@ -6524,8 +7834,6 @@ GnssAdapter::initEngHubProxy() {
     static bool engHubLoadSuccessful = false;
 
     const char *error = nullptr;
-    unsigned int processListLength = 0;
-    loc_process_info_s_type* processInfoList = nullptr;
 
     do {
         // load eng hub only once
@@ -6533,37 +7841,13 @@ GnssAdapter::initEngHubProxy() {
             break;
         }
 
-        int rc = loc_read_process_conf(LOC_PATH_IZAT_CONF, &processListLength,
-                                       &processInfoList);
-        if (rc != 0) {
-            LOC_LOGE("%s]: failed to parse conf file", __func__);
-            break;
-        }
-
-        bool pluginDaemonEnabled = false;
-        // go over the conf table to see whether any plugin daemon is enabled
-        for (unsigned int i = 0; i < processListLength; i++) {
-            if ((strncmp(processInfoList[i].name[0], PROCESS_NAME_ENGINE_SERVICE,
-                         strlen(PROCESS_NAME_ENGINE_SERVICE)) == 0) &&
-                (processInfoList[i].proc_status == ENABLED)) {
-                pluginDaemonEnabled = true;
-                // check if this is DRE-INT engine
-                if ((processInfoList[i].args[1]!= nullptr) &&
-                    (strncmp(processInfoList[i].args[1], "DRE-INT", sizeof("DRE-INT")) == 0)) {
-                    mDreIntEnabled = true;
-                    break;
-                }
-            }
+        bool dreIntEnabled = false;
+        bool engHubRequired = isEngHubRequired(dreIntEnabled);
+        if (dreIntEnabled) {
+            mDreIntEnabled = true;
         }
-
-        // no plugin daemon is enabled for this platform,
-        // check if external engine is present for which we need
-        // libloc_eng_hub.so to be loaded
-        if (pluginDaemonEnabled == false) {
-            UTIL_READ_CONF(LOC_PATH_IZAT_CONF, izatConfParamTable);
-            if (!loadEngHubForExternalEngine) {
-                break;
-            }
+        if (!engHubRequired) {
+            break;
         }
 
         // load the engine hub .so, if the .so is not present
@@ -6640,11 +7924,6 @@ GnssAdapter::initEngHubProxy() {
 
     } while (0);
 
-    if (processInfoList != nullptr) {
-        free (processInfoList);
-        processInfoList = nullptr;
-    }
-
     firstTime = false;
     return engHubLoadSuccessful;
 }
@@ -6665,7 +7944,7 @@ GnssAdapter::parseDoublesString(char* dString) {
 }
 
 void
-GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallback)
+GnssAdapter::loadGnssAntennaInformation()
 {
 #define MAX_TEXT_WIDTH      50
 #define MAX_COLUMN_WIDTH    20
@@ -6673,19 +7952,21 @@ GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallbac
     /* parse antenna_corrections file and fill in
     a vector of GnssAntennaInformation data structure */
 
-    std::vector<GnssAntennaInformation> gnssAntennaInformations;
+    std::vector<GnssAntennaInformation>& gnssAntennaInformations = mGnssAntennaInformations;
     GnssAntennaInformation gnssAntennaInfo;
 
-    uint32_t antennaInfoVectorSize;
+    mGnssAntennaInformationsLoaded = true;
+    uint32_t antennaInfoVectorSize = 0;
     loc_param_s_type ant_info_vector_table[] =
     {
         { "ANTENNA_INFO_VECTOR_SIZE", &antennaInfoVectorSize, NULL, 'n' }
     };
     UTIL_READ_CONF(LOC_PATH_ANT_CORR, ant_info_vector_table);
 
+    gnssAntennaInformations.reserve(antennaInfoVectorSize);
     for (uint32_t i = 0; i < antennaInfoVectorSize; i++) {
         double carrierFrequencyMHz;
-        char pcOffsetStr[LOC_MAX_PARAM_STRING];
+        char pcOffsetStr[LOC_MAX_PARAM_STRING] = "";
         uint32_t numberOfRows = 0;
         uint32_t numberOfColumns = 0;
         uint32_t numberOfRowsSGC = 0;
@@ -6732,6 +8013,10 @@ GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallbac
         // now parse pcOffsetStr to get each entry
         std::vector<double> pcOffset;
         pcOffset = parseDoublesString(pcOffsetStr);
+        if (pcOffset.size() < 6) {
+            LOC_LOGe("%s has %zu entries, expected 6", s2.c_str(), pcOffset.size());
+            pcOffset.resize(6, 0.0);
+        }
         gnssAntennaInfo.phaseCenterOffsetCoordinateMillimeters.size =
                 sizeof(gnssAntennaInfo.phaseCenterOffsetCoordinateMillimeters);
         gnssAntennaInfo.phaseCenterOffsetCoordinateMillimeters.x = pcOffset[0];
@@ -6787,8 +8072,16 @@ GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallbac
         }
         gnssAntennaInformations.push_back(std::move(gnssAntennaInfo));
     }
-    if (antennaInfoVectorSize > 0) {
-        antennaInfoCallback(gnssAntennaInformations);
+}
+
+void
+GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallback)
+{
+    if (!mGnssAntennaInformationsLoaded) {
+        loadGnssAntennaInformation();
+    }
+    if (!mGnssAntennaInformations.empty()) {
+        antennaInfoCallback(mGnssAntennaInformations);
     }
 }
 
@@ -6925,6 +8218,7 @@ void GnssAdapter::checkUpdateDgnssNtrip(bool isLocationValid) {
 
 void GnssAdapter::stopDgnssNtrip() {
     LOC_LOGd("isInSession %d mDgnssState 0x%x", isInSession(), mDgnssState);
+    logDgnssCorrectionAge();
     mStartDgnssNtripParams.nmea.clear();
     if (mDgnssState & DGNSS_STATE_NTRIP_SESSION_STARTED) {
         mDgnssState &= ~DGNSS_STATE_NTRIP_SESSION_STARTED;
@@ -6932,6 +8226,37 @@ void GnssAdapter::stopDgnssNtrip() {
     }
 }
 
+void GnssAdapter::updateDgnssCorrectionAge(const GpsLocationExtended& locationExtended) {
+    uint32_t sourceId = (locationExtended.flags &
+            GPS_LOCATION_EXTENDED_HAS_DGNSS_CORRECTION_SOURCE_ID) ?
+            locationExtended.dgnssCorrectionSourceID : 0;
+    DgnssCorrectionAgeStats& stats = mDgnssCorrectionAgeStats[sourceId];
+    uint32_t ageMsec = locationExtended.dgnssDataAgeMsec;
+
+    stats.mFixCount++;
+    stats.mLastAgeMsec = ageMsec;
+    stats.mSumAgeMsec += ageMsec;
+    if (ageMsec > stats.mMaxAgeMsec) {
+        stats.mMaxAgeMsec = ageMsec;
+    }
+    // roughly every 10 minutes at 1Hz, so long sessions show how the age moves
+    if (stats.mFixCount >= DGNSS_CORRECTION_AGE_LOG_FIXES) {
+        logDgnssCorrectionAge();
+    }
+}
+
+void GnssAdapter::logDgnssCorrectionAge() {
+    for (auto& it : mDgnssCorrectionAgeStats) {
+        const DgnssCorrectionAgeStats& stats = it.second;
+        if (stats.mFixCount > 0) {
+            LOC_LOGi("DGNSS source %u: %u fixes, correction age last %u avg %" PRIu64
+                     " max %u msec", it.first, stats.mFixCount, stats.mLastAgeMsec,
+                     stats.mSumAgeMsec / stats.mFixCount, stats.mMaxAgeMsec);
+        }
+    }
+    mDgnssCorrectionAgeStats.clear();
+}
+
 void GnssAdapter::reportGGAToNtrip(const char* nmea) {
 
 #define POS_OF_GGA (3)  //start position of "GGA"
@@ -6945,6 +8270,14 @@ void GnssAdapter::reportGGAToNtrip(const char* nmea) {
         return;
     }
 
+    /* once the session runs, the server only takes a GGA every 10 minutes,
+       so leave the sentences of the epochs in between unparsed */
+    if ((mDgnssState & DGNSS_STATE_NTRIP_SESSION_STARTED) &&
+            getBootTimeMilliSec() - mDgnssLastNmeaBootTimeMilli <=
+            DGNSS_RANGE_UPDATE_TIME_10MIN_IN_MILLI) {
+        return;
+    }
+
     string nmeaString(nmea);
     size_t foundPos = nmeaString.find("GGA");
     size_t foundNth = 0;
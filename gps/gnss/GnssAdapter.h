@@ -38,10 +38,20 @@
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
 #include <map>
+#include <set>
 #include <functional>
 #include <loc_misc_utils.h>
 #include <queue>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <LocTraceRing.h>
+#include <LocSvEpoch.h>
 #include <NativeAgpsHandler.h>
+#include <LocPowerPolicy.h>
+#include <LocThread.h>
+#include <GnssRecorder.h>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -51,11 +61,62 @@
 #define LOC_GPS_NI_RESPONSE_IGNORE 4
 #define ODCPI_EXPECTED_INJECTION_TIME_MS 10000
 #define DELETE_AIDING_DATA_EXPECTED_TIME_MS 5000
+#define GNSS_LATENCY_TRACE_SIZE 64
+#define WARM_START_CACHE_FILE "/data/vendor/location/gnss_warm_start.bin"
+#define WARM_START_CACHE_VERSION 1
+#define WARM_START_CACHE_SAVE_INTERVAL_MS 60000
+#define WARM_START_POSITION_MAX_AGE_MS 600000
+#define WARM_START_TIME_MAX_AGE_MS 86400000
 
 class GnssAdapter;
 
-typedef std::map<LocationSessionKey, LocationOptions> LocationSessionMap;
-typedef std::map<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
+typedef LocFlatMap<LocationSessionKey, LocationOptions> LocationSessionMap;
+typedef LocFlatMap<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
+
+/* Orders the time based tracking sessions by minInterval and by powerMode, so that
+   the multiplexed criteria of all sessions are found in O(log n) on every change */
+class TrackingMultiplexer {
+public:
+    inline void add(const LocationSessionKey& key, const TrackingOptions& options) {
+        mIntervals.emplace(options.minInterval, key);
+        if (GNSS_POWER_MODE_INVALID != options.powerMode) {
+            mPowerModes.insert(options.powerMode);
+        }
+    }
+    inline void remove(const LocationSessionKey& key, const TrackingOptions& options) {
+        mIntervals.erase(std::make_pair(options.minInterval, key));
+        auto it = mPowerModes.find(options.powerMode);
+        if (it != mPowerModes.end()) {
+            mPowerModes.erase(it);
+        }
+    }
+    // session with the smallest minInterval other than excludedKey, nullptr if none
+    inline const LocationSessionKey* getSmallestIntervalSession(
+            const LocationSessionKey* excludedKey) const {
+        for (auto it = mIntervals.begin(); it != mIntervals.end(); ++it) {
+            if (nullptr == excludedKey || it->second != *excludedKey) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+    // smallest valid powerMode with one occurrence of excludedPowerMode taken out,
+    // GNSS_POWER_MODE_INVALID if none
+    inline GnssPowerMode getHighestPowerMode(GnssPowerMode excludedPowerMode) const {
+        bool excluded = (GNSS_POWER_MODE_INVALID == excludedPowerMode);
+        for (auto it = mPowerModes.begin(); it != mPowerModes.end(); ++it) {
+            if (!excluded && *it == excludedPowerMode) {
+                excluded = true;
+            } else {
+                return *it;
+            }
+        }
+        return GNSS_POWER_MODE_INVALID;
+    }
+private:
+    std::set<std::pair<uint32_t, LocationSessionKey>> mIntervals;
+    std::multiset<GnssPowerMode> mPowerModes;
+};
 
 class OdcpiTimer : public LocTimer {
 public:
@@ -150,6 +211,8 @@ typedef struct {
     PaceConfigInfo paceConfigInfo;
     RobustLocationConfigInfo robustLocationConfigInfo;
     LeverArmConfigInfo  leverArmConfigInfo;
+    // derived from leverArmConfigInfo.gnssToVRP
+    LocVrpTransform vrpTransform;
 } LocIntegrationConfigInfo;
 
 using namespace loc_core;
@@ -175,6 +238,25 @@ struct CdfwInterface {
     void (*reportUsable)(QDgnssListenerHDL handle, bool usable);
 };
 
+/* What is saved of the engine state, for GnssAdapter to inject it on the next
+   engine up in the same boot, as binary in WARM_START_CACHE_FILE */
+typedef struct {
+    uint32_t version;
+    uint32_t size;
+    // kernel boot_id of the boot this was saved in
+    char bootId[40];
+    // boot time of the fix below
+    uint64_t bootTimeMs;
+    bool positionValid;
+    double latitude;
+    double longitude;
+    float accuracy;
+    bool timeValid;
+    int64_t utcTimeMs;
+    int32_t timeUncMs;
+    LeapSecondSystemInfo leapSecondSysInfo;
+} GnssWarmStartCache;
+
 typedef uint16_t  DGnssStateBitMask;
 #define DGNSS_STATE_ENABLE_NTRIP_COMMAND      0X01
 #define DGNSS_STATE_NO_NMEA_PENDING           0X02
@@ -201,22 +283,128 @@ class GnssAdapter : public LocAdapterBase {
 
     /* ==== Engine Hub ===================================================================== */
     EngineHubProxyBase* mEngHubProxy;
+    LocThread mEngHubPrefetchThread;
     bool mNHzNeeded;
     bool mSPEAlreadyRunningAtHighestInterval;
+    /* reports of the current epoch, gathered on the LocApi thread for an
+       engine hub that takes them as one bundle */
+    struct EngineHubEpoch {
+        bool hasSv;
+        GnssSvNotification svNotify;
+        GnssMeasurementsPtr measurements;
+        std::vector<GnssSvPolynomial> svPolynomials;
+    };
+    std::unique_ptr<EngineHubEpoch> mEngHubEpoch;
+    bool isEngHubEpochBundled();
+    void reportEngHubEpoch(const EngineHubEpoch* epoch, const UlpLocation* location,
+                           const GpsLocationExtended* locationExtended,
+                           enum loc_sess_status status);
 
     /* ==== TRACKING ======================================================================= */
     TrackingOptionsMap mTimeBasedTrackingSessions;
+    TrackingMultiplexer mTrackingMultiplexer;
     LocationSessionMap mDistanceBasedTrackingSessions;
+    // the distance based sessions all run as this one engine session, at the
+    // smallest minDistance and minInterval of them; the criteria last sent to
+    // the engine are kept, size 0 while it does not run
+    uint32_t mDbtEngineSessionId;
+    LocationOptions mDbtEngineOptions;
+    /* ==== COMMAND BATCH ================================================================== */
+    // set while the msgs of a batch are processed, client event mask
+    // updates then wait for the end of the batch
+    bool mInCommandBatch;
+    bool mClientsEventMaskPending;
     LocPosMode mLocPositionMode;
     GnssSvUsedInPosition mGnssSvIdUsedInPosition;
     bool mGnssSvIdUsedInPosAvail;
     GnssSvMbUsedInPosition mGnssMbSvIdUsedInPosition;
     bool mGnssMbSvIdUsedInPosAvail;
+    uint32_t mGsvReportCount;
+
+    /* ==== CLIENT SUBSCRIBERS ============================================================= */
+    // callbacks in mClientData of the clients registered for each per report
+    // callback; rebuilt by updateClientsEventMask() on every mClientData change
+    std::vector<LocationCallbacks*> mGnssPositionClients;
+    std::vector<LocationCallbacks*> mFlpPositionClients;
+    std::vector<LocationCallbacks*> mEnginePositionClients;
+    // with the SV filter of the client, nullptr if it takes all SVs
+    struct SvClient {
+        LocationCallbacks* callbacks;
+        const GnssSvFilter* filter;
+    };
+    std::vector<SvClient> mSvClients;
+    // SV filters set by clients, only the ones that leave something out
+    LocFlatMap<LocationAPI*, GnssSvFilter> mSvFilters;
+    // the SV report as cut down for a filter, reused by the clients that follow
+    // with an equal filter in the same report
+    GnssSvNotification mSvFilteredNotify;
+    // the SV report in reportSv() merged per satellite, only valid in there
+    LocSvEpoch mSvEpoch;
+    std::vector<LocationCallbacks*> mNmeaClients;
+    std::vector<LocationCallbacks*> mDataClients;
+    std::vector<LocationCallbacks*> mMeasurementsClients;
+    // copies of !mDataClients.empty() and !mMeasurementsClients.empty() for the
+    // LocApi thread, so the per epoch AGC and jammer lookups in SystemStatus are
+    // skipped while nobody would get them
+    std::atomic<bool> mDataWanted;
+    std::atomic<bool> mMeasurementsAgcWanted;
+    void updateClientSubscribers();
+
+    /* ==== POSITION DECIMATION ============================================================ */
+    // position clients whose time based sessions all ask for a longer interval than
+    // the engine may run at get a fix only once per their smallest minInterval; they
+    // are kept in a min-heap on the boot time their next fix is due, out of the
+    // mGnssPositionClients and mFlpPositionClients lists
+    struct DecimatedPositionClient {
+        uint64_t nextDueMs;
+        uint32_t intervalMs;
+        LocationAPI* client;
+        LocationCallbacks* callbacks;
+        bool isFlp;
+        inline bool operator>(const DecimatedPositionClient& other) const {
+            return nextDueMs > other.nextDueMs;
+        }
+    };
+    std::vector<DecimatedPositionClient> mDecimatedPositionClients;
+    std::vector<DecimatedPositionClient> mDuePositionClients;
+    // with TRACKING_REPORT_BATCH_SIZE or TRACKING_REPORT_BATCH_MS set, the fixes of
+    // the tracking clients also having a batchingCb are collected and reported
+    // through it, out of the other position client lists
+    struct BatchedPositionClient {
+        LocationAPI* client;
+        LocationCallbacks* callbacks;
+        bool isFlp;
+        uint64_t firstFixMs;
+        std::vector<Location> locations;
+    };
+    std::vector<BatchedPositionClient> mBatchedPositionClients;
+    static bool isTrackingReportBatched(const LocationCallbacks& callbacks);
+    static void reportTrackingBatch(BatchedPositionClient& batched);
+    // position clients whose sessions are all distance based get a fix once it is
+    // the smallest minDistance of their sessions away from the last one they got,
+    // out of the other position client lists
+    struct DistanceFilteredPositionClient {
+        LocationAPI* client;
+        LocationCallbacks* callbacks;
+        bool isFlp;
+        uint32_t minDistance;
+        bool hasLastFix;
+        double lastLatitude;
+        double lastLongitude;
+    };
+    std::vector<DistanceFilteredPositionClient> mDistanceFilteredPositionClients;
+    void updatePositionSubscribers();
 
     /* ==== CONTROL ======================================================================== */
     LocationControlCallbacks mControlCallbacks;
     uint32_t mAfwControlId;
     uint32_t mNmeaMask;
+    // mNmeaMask plus the debug NMEA while a gnssDataCb client is registered,
+    // as last sent to the modem
+    uint32_t mModemNmeaMask;
+    inline uint32_t getModemNmeaMask() const {
+        return mNmeaMask | (mDataClients.empty() ? 0 : LOC_NMEA_MASK_DEBUG_V02);
+    }
     uint64_t mPrevNmeaRptTimeNsec;
     GnssSvIdConfig mGnssSvIdConfig;
     GnssSvTypeConfig mGnssSeconaryBandConfig;
@@ -232,6 +420,15 @@ class GnssAdapter : public LocAdapterBase {
     // This must be initialized via initAgps()
     AgpsManager mAgpsManager;
     void initAgps(const AgpsCbInfo& cbInfo);
+    // ends the SUPL preconnect AGPS_E911_PRECONNECT_SEC after the last
+    // sign of an emergency session
+    class AgpsPreconnectTimer : public LocTimer {
+        GnssAdapter& mAdapter;
+    public:
+        AgpsPreconnectTimer(GnssAdapter& adapter) : mAdapter(adapter) {}
+        void timeOutCallback() override;
+    } mAgpsPreconnectTimer;
+    void agpsPreconnectForEmergency();
 
     /* ==== NFW =========================================================================== */
     NfwStatusCb mNfwCb;
@@ -245,7 +442,22 @@ class GnssAdapter : public LocAdapterBase {
     bool mIsMeasCorrInterfaceOpen;
     measCorrSetCapabilitiesCb mMeasCorrSetCapabilitiesCb;
     bool initMeasCorr(bool bSendCbWhenNotSupported);
+    // latest corrections from the HAL, drained on the LocApi thread; a burst
+    // of updates arriving before the drain runs collapses into the last one
+    std::mutex mMeasCorrMutex;
+    GnssMeasurementCorrections mMeasCorrPending;
+    bool mMeasCorrDrainQueued;
+    // set when the engine must get the full set again (interface reopened,
+    // engine restart); per-SV cache below is only touched by the drain
+    std::atomic<bool> mMeasCorrResync;
+    std::map<uint64_t, GnssSingleSatCorrection> mMeasCorrCache;
+    GnssMeasurementCorrections mMeasCorrLastSent;
+    void drainMeasCorr();
     bool mIsAntennaInfoInterfaceOpened;
+    // antenna_corrections is read on the first request and kept, it does not
+    // change at run time
+    bool mGnssAntennaInformationsLoaded;
+    std::vector<GnssAntennaInformation> mGnssAntennaInformations;
 
     /* ==== DGNSS Data Usable Report======================================================== */
     QDgnssListenerHDL mQDgnssListenerHDL;
@@ -260,11 +472,24 @@ class GnssAdapter : public LocAdapterBase {
     OdcpiPrioritytype mCallbackPriority;
     OdcpiTimer mOdcpiTimer;
     OdcpiRequestInfo mOdcpiRequest;
+    bool mOdcpiFrameworkRequested; // a START was sent to the framework since the last STOP
+    Location mOdcpiCachedLocation;
+    uint64_t mOdcpiCachedTimeMs;   // boot time of mOdcpiCachedLocation injection
     void odcpiTimerExpire();
+    void requestOdcpiFromFramework(const OdcpiRequestInfo& request);
+    bool injectOdcpiFromCache(const OdcpiRequestInfo& request);
 
     /* ==== DELETEAIDINGDATA =============================================================== */
     int64_t mLastDeleteAidingDataTime;
 
+    /* ==== WARM START ===================================================================== */
+    uint64_t mWarmStartCacheSavedMs;
+    static void getBootId(char* bootId, size_t size);
+    void saveWarmStartCache(const UlpLocation& ulpLocation,
+                            const GpsLocationExtended& locationExtended);
+    void injectWarmStartCache();
+    void deleteWarmStartCache();
+
     /* === SystemStatus ===================================================================== */
     SystemStatus* mSystemStatus;
     std::string mServerUrl;
@@ -273,20 +498,49 @@ class GnssAdapter : public LocAdapterBase {
     LocationSystemInfo mLocSystemInfo;
     std::vector<GnssSvIdSource> mBlacklistedSvIds;
     PowerStateType mSystemPowerState;
+    // the engine is stopped for all tracking sessions, see suspendTracking()
+    bool mTrackingSuspended;
 
     /* === Misc ===================================================================== */
     BlockCPIInfo mBlockCPIInfo;
     bool mPowerOn;
     uint32_t mAllowFlpNetworkFixes;
     std::queue<GnssLatencyInfo> mGnssLatencyInfoQueue;
+    // the fix being reported, and the last ones read by getDebugReport()
+    // from the HIDL binder thread
+    GnssLatencyTrace mLatencyTrace;
+    loc_util::LocTraceRing<GnssLatencyTrace, GNSS_LATENCY_TRACE_SIZE> mLatencyTraces;
+    // satellite block of the debug report, kept until the SystemStatus
+    // items it is built from change; read and swapped lock free by
+    // getDebugReport() on the HIDL binder threads
+    struct DebugSatelliteInfo {
+        uint64_t mGeneration;
+        std::vector<GnssDebugSatelliteInfo> mInfo;
+    };
+    std::shared_ptr<const DebugSatelliteInfo> mDebugSatelliteInfo;
     GnssReportLoggerUtil mLogger;
     bool mDreIntEnabled;
 
     /* === NativeAgpsHandler ======================================================== */
     NativeAgpsHandler mNativeAgpsHandler;
 
+    /* === Power policy ================================================================ */
+    LocPowerPolicy mPowerPolicy;
+    LocPowerProfile mPowerProfile;
+    uint32_t mSvReportCount;
+    uint32_t mMeasurementsReportCount;
+    void applyPowerProfile(const LocPowerProfile& profile);
+
+    /* === Report recorder ============================================================= */
+    // set once gps.conf GNSS_RECORDER_ENABLED is read
+    std::unique_ptr<GnssRecorder> mRecorder;
+
     /* === Misc callback from QMI LOC API ============================================== */
-    GnssEnergyConsumedCallback mGnssEnergyConsumedCb;
+    // callers waiting for the energy consumed query in flight, if any
+    std::vector<GnssEnergyConsumedCallback> mGnssEnergyConsumedCbs;
+    uint64_t mGnssEnergyConsumedQueryTimeMs;  // boot time the query in flight was sent
+    uint64_t mGnssEnergyConsumed;             // last answer of the modem
+    uint64_t mGnssEnergyConsumedTimeMs;       // boot time of mGnssEnergyConsumed, 0 if none
     std::function<void(bool)> mPowerStateCb;
 
     /*==== CONVERSION ===================================================================*/
@@ -311,6 +565,16 @@ class GnssAdapter : public LocAdapterBase {
     void checkUpdateDgnssNtrip(bool isLocationValid);
     void stopDgnssNtrip();
     uint64_t   mDgnssLastNmeaBootTimeMilli;
+    /* age of the corrections the engine used, per correction stream */
+    struct DgnssCorrectionAgeStats {
+        uint32_t mFixCount;
+        uint32_t mLastAgeMsec;
+        uint32_t mMaxAgeMsec;
+        uint64_t mSumAgeMsec;
+    };
+    std::map<uint32_t, DgnssCorrectionAgeStats> mDgnssCorrectionAgeStats;
+    void updateDgnssCorrectionAge(const GpsLocationExtended& locationExtended);
+    void logDgnssCorrectionAge();
 
 protected:
 
@@ -354,6 +618,8 @@ public:
     void saveTrackingSession(LocationAPI* client, uint32_t sessionId,
                              const TrackingOptions& trackingOptions);
     void eraseTrackingSession(LocationAPI* client, uint32_t sessionId);
+    LocationOptions getMultiplexedDbtOptions() const;
+    void updateDbtEngineSession(std::function<void(LocationError)> onDone = nullptr);
 
     bool setLocPositionMode(const LocPosMode& mode);
     LocPosMode& getLocPositionMode() { return mLocPositionMode; }
@@ -369,6 +635,9 @@ public:
     void updateTracking(LocationAPI* client, uint32_t sessionId,
             const TrackingOptions& updatedOptions, const TrackingOptions& oldOptions);
     bool checkAndSetSPEToRunforNHz(TrackingOptions & out);
+    TrackingOptions getMultiplexedTrackingOptions(const LocationSessionKey* excludedKey);
+    static void multiplexTrackingOptions(TrackingOptions& multiplexedOptions,
+                                         const TrackingOptions& options);
 
     void setConstrainedTunc(bool enable, float tuncConstraint,
                             uint32_t energyBudget, uint32_t sessionId);
@@ -400,6 +669,8 @@ public:
     void disableCommand(uint32_t id);
     void setControlCallbacksCommand(LocationControlCallbacks& controlCallbacks);
     void readConfigCommand();
+    void confChangedCommand(const char* confFileName,
+            const std::unordered_set<std::string>& changedKeys);
     void requestUlpCommand();
     void initEngHubProxyCommand();
     uint32_t* gnssUpdateConfigCommand(const GnssConfig& config);
@@ -434,6 +705,7 @@ public:
     inline GnssSvTypeConfigCallback gnssGetSvTypeConfigCallback()
     { return mGnssSvTypeConfigCb; }
     void setConfig();
+    void applyGpsConfChanges(const std::unordered_set<std::string>& changedKeys);
     void gnssSecondaryBandConfigUpdate(LocApiResponse* locApiResponse= nullptr);
 
     /* ========= AGPS ====================================================================== */
@@ -459,7 +731,10 @@ public:
     uint32_t configRobustLocationCommand(bool enable, bool enableForE911);
     bool openMeasCorrCommand(const measCorrSetCapabilitiesCb setCapabilitiesCb);
     bool measCorrSetCorrectionsCommand(const GnssMeasurementCorrections gnssMeasCorr);
-    inline void closeMeasCorrCommand() { mIsMeasCorrInterfaceOpen = false; }
+    inline void closeMeasCorrCommand() {
+        mIsMeasCorrInterfaceOpen = false;
+        mMeasCorrResync = true;
+    }
     uint32_t antennaInfoInitCommand(const antennaInfoCb antennaInfoCallback);
     inline void antennaInfoCloseCommand() { mIsAntennaInfoInterfaceOpened = false; }
     uint32_t configMinGpsWeekCommand(uint16_t minGpsWeek);
@@ -503,8 +778,8 @@ public:
     virtual void reportDataEvent(const GnssDataNotification& dataNotify, int msInWeek);
     virtual bool requestNiNotifyEvent(const GnssNiNotification& notify, const void* data,
                                       const LocInEmergency emergencyState);
-    virtual void reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurements,
-                                                int msInWeek);
+    virtual void reportGnssMeasurementsEvent(const GnssMeasurementsPtr& gnssMeasurements,
+                                             int msInWeek);
     virtual void reportSvPolynomialEvent(GnssSvPolynomial &svPolynomial);
     virtual void reportSvEphemerisEvent(GnssSvEphemerisReport & svEphemeris);
     virtual void reportGnssSvIdConfigEvent(const GnssSvIdConfig& config);
@@ -535,6 +810,8 @@ public:
     bool needReportForFlpClient(enum loc_sess_status status, LocPosTechMask techMask);
     bool needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
         const struct timespec32_t &apTimeStamp);
+    NmeaSentenceTypesMask getNmeaSentenceTypesInDemand();
+    bool isGsvDecimated();
     void reportPosition(const UlpLocation &ulpLocation,
                         const GpsLocationExtended &locationExtended,
                         enum loc_sess_status status,
@@ -542,6 +819,7 @@ public:
     void reportEnginePositions(unsigned int count,
                                const EngineLocationInfo* locationArr);
     void reportSv(GnssSvNotification& svNotify);
+    void reportSvToClients(const GnssSvNotification& svNotify);
     void reportNmea(const char* nmea, size_t length);
     void reportData(GnssDataNotification& dataNotify);
     bool requestNiNotify(const GnssNiNotification& notify, const void* data,
@@ -552,7 +830,7 @@ public:
     void reportGnssConfig(uint32_t sessionId, const GnssConfig& gnssConfig);
     void requestOdcpi(const OdcpiRequestInfo& request);
     void invokeGnssEnergyConsumedCallback(uint64_t energyConsumedSinceFirstBoot);
-    void saveGnssEnergyConsumedCallback(GnssEnergyConsumedCallback energyConsumedCb);
+    void requestGnssEnergyConsumed(const GnssEnergyConsumedCallback& energyConsumedCb);
     void reportLocationSystemInfo(const LocationSystemInfo & locationSystemInfo);
     inline void reportNfwNotification(const GnssNfwNotification& notification) {
         if (NULL != mNfwCb) {
@@ -568,9 +846,16 @@ public:
 
     void updateSystemPowerState(PowerStateType systemPowerState);
     void reportSvPolynomial(const GnssSvPolynomial &svPolynomial);
+    /* latest ephemeris of each SV of the constellation, for in process
+       clients such as DGNSS; can be called from any thread */
+    inline bool getSvEphemeris(Gnss_LocSvSystemEnumType constellation,
+                               GnssSvEphemerisReport& svEphemeris) {
+        return mLocApi->getSvEphemeris(constellation, svEphemeris);
+    }
 
 
     std::vector<double> parseDoublesString(char* dString);
+    void loadGnssAntennaInformation();
     void reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallback);
 
     /*======== GNSSDEBUG ================================================================*/
@@ -604,7 +889,7 @@ public:
             uint64_t svIdMask, std::vector<GnssSvIdSource>& svIds,
             GnssSvId initialSvId, GnssSvType svType);
     static void computeVRPBasedLla(const UlpLocation& loc, GpsLocationExtended& locExt,
-                                   const LeverArmConfigInfo& leverArmConfigInfo);
+                                   const LocIntegrationConfigInfo& locConfigInfo);
 
     void injectLocationCommand(double latitude, double longitude, float accuracy);
     void injectLocationExtCommand(const GnssLocationInfoNotification &locationInfo);
@@ -624,12 +909,26 @@ public:
     inline PowerStateType getSystemPowerState() { return mSystemPowerState; }
 
     void setAllowFlpNetworkFixes(uint32_t allow) { mAllowFlpNetworkFixes = allow; }
+    void initGnssRecorder();
     uint32_t getAllowFlpNetworkFixes() { return mAllowFlpNetworkFixes; }
     void setSuplHostServer(const char* server, int port, LocServerType type);
     void notifyClientOfCachedLocationSystemInfo(LocationAPI* client,
                                                 const LocationCallbacks& callbacks);
     LocationCapabilitiesMask getCapabilities();
     void updateSystemPowerStateCommand(PowerStateType systemPowerState);
+    // Stops the engine for all tracking sessions at once, or starts it again
+    // for the sessions there are by then. The sessions stay on the AP
+    // meanwhile; the ones started, updated or stopped while suspended only
+    // take effect at the engine on resume.
+    void suspendTrackingCommand(bool suspend);
+    void suspendTracking(bool suspend);
+    // Runs the commands, each a call of a GnssInterface function, and has
+    // all they post to the adapter thread processed as one msg; the modem
+    // requests they lead to then go to the LocApi thread as one msg too,
+    // with the client event mask updated once at the end.
+    void submitBatchCommand(const std::vector<std::function<void()>>& commands);
+    // SVs the client gets in its gnssSvCb, a filter of all 0 passes all of them
+    void setSvFilterCommand(LocationAPI* client, const GnssSvFilter& filter);
 
     /*==== DGnss Usable Report Flag ====================================================*/
     inline void setDGnssUsableFLag(bool dGnssNeedReport) { mDGnssNeedReport = dGnssNeedReport;}
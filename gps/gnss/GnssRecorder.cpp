@@ -0,0 +1,281 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_GnssRecorder"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <GnssRecorder.h>
+#include <loc_pla.h>
+#include <log_util.h>
+
+#define GNSS_REC_MIN_FILE_SIZE      (64 * 1024)
+// varints are at most 10 bytes; the record header is a type and a length
+#define GNSS_REC_MAX_FIELD_SIZE     (10)
+#define GNSS_REC_MAX_RECORD_HEADER  (1 + GNSS_REC_MAX_FIELD_SIZE)
+#define GNSS_REC_POSITION_FIELDS    (11)
+#define GNSS_REC_SV_FIELDS          (2)
+#define GNSS_REC_SV_ENTRY_FIELDS    (7)
+#define GNSS_REC_CLOCK_FIELDS       (11)
+#define GNSS_REC_MEAS_ENTRY_FIELDS  (17)
+
+static int64_t clockMs(clockid_t clock) {
+    struct timespec ts = {};
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+GnssRecorder::GnssRecorder(const char* dir, uint32_t fileSizeKb, uint32_t fileCount) :
+    mDir(dir),
+    mFileSize(std::max((size_t)fileSizeKb * 1024, (size_t)GNSS_REC_MIN_FILE_SIZE)),
+    mFileCount(std::max(fileCount, 1u)),
+    mDisabled(false),
+    mFd(-1),
+    mMap(nullptr),
+    mUsed(0),
+    mDelta()
+{
+    mPayload.reserve(GNSS_REC_MAX_FIELD_SIZE * (GNSS_REC_CLOCK_FIELDS +
+            GNSS_MEASUREMENTS_MAX * GNSS_REC_MEAS_ENTRY_FIELDS));
+    LOC_LOGi("recording to %s, %u files of %zu bytes", dir, mFileCount, mFileSize);
+}
+
+GnssRecorder::~GnssRecorder()
+{
+    closeFile();
+}
+
+std::string GnssRecorder::filePath(uint32_t index) const
+{
+    return mDir + "/gnss_rec." + std::to_string(index) + ".bin";
+}
+
+bool GnssRecorder::openFile()
+{
+    // the newest file is always .0, so a recording left by an earlier run
+    // moves along with the rest, and the oldest falls off the end
+    unlink(filePath(mFileCount - 1).c_str());
+    for (uint32_t i = mFileCount - 1; i > 0; i--) {
+        rename(filePath(i - 1).c_str(), filePath(i).c_str());
+    }
+
+    std::string path = filePath(0);
+    mFd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (mFd < 0) {
+        LOC_LOGe("cannot create %s, errno %d", path.c_str(), errno);
+        return false;
+    }
+    if (0 != ftruncate(mFd, mFileSize)) {
+        LOC_LOGe("cannot size %s, errno %d", path.c_str(), errno);
+        closeFile();
+        return false;
+    }
+    void* map = mmap(nullptr, mFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (MAP_FAILED == map) {
+        LOC_LOGe("cannot map %s, errno %d", path.c_str(), errno);
+        closeFile();
+        return false;
+    }
+    mMap = (uint8_t*)map;
+
+    GnssRecFileHeader* header = (GnssRecFileHeader*)mMap;
+    memcpy(header->magic, GNSS_REC_MAGIC, sizeof(header->magic));
+    header->version = GNSS_REC_VERSION;
+    header->headerSize = sizeof(GnssRecFileHeader);
+    header->fileSize = mFileSize;
+    header->dataSize = 0;
+    header->createdUtcMs = clockMs(CLOCK_REALTIME);
+    mUsed = 0;
+    memset(&mDelta, 0, sizeof(mDelta));
+    return true;
+}
+
+void GnssRecorder::closeFile()
+{
+    if (nullptr != mMap) {
+        munmap(mMap, mFileSize);
+        mMap = nullptr;
+    }
+    if (mFd >= 0) {
+        // give back what the file did not get to use
+        if (0 != ftruncate(mFd, sizeof(GnssRecFileHeader) + mUsed)) {
+            LOC_LOGw("cannot trim recording, errno %d", errno);
+        }
+        close(mFd);
+        mFd = -1;
+    }
+}
+
+bool GnssRecorder::reserve(size_t maxPayload)
+{
+    if (mDisabled) {
+        return false;
+    }
+    size_t maxRecord = GNSS_REC_MAX_RECORD_HEADER + maxPayload;
+    if (sizeof(GnssRecFileHeader) + maxRecord > mFileSize) {
+        LOC_LOGw("%zu byte record does not fit a file, dropped", maxRecord);
+        return false;
+    }
+    if (nullptr == mMap || sizeof(GnssRecFileHeader) + mUsed + maxRecord > mFileSize) {
+        closeFile();
+        if (!openFile()) {
+            LOC_LOGe("recording stopped");
+            mDisabled = true;
+            return false;
+        }
+    }
+    mPayload.clear();
+    return true;
+}
+
+void GnssRecorder::commit(GnssRecRecordType type)
+{
+    uint8_t* out = mMap + sizeof(GnssRecFileHeader) + mUsed;
+    size_t length = 0;
+    out[length++] = (uint8_t)type;
+    length += gnssRecPutVarint(out + length, mPayload.size());
+    memcpy(out + length, mPayload.data(), mPayload.size());
+    mUsed += length + mPayload.size();
+    // a reader takes the records up to dataSize, so it only ever grows
+    // over complete ones
+    ((GnssRecFileHeader*)mMap)->dataSize = mUsed;
+}
+
+void GnssRecorder::recordPosition(const UlpLocation& ulpLocation,
+                                  const GpsLocationExtended& locationExtended,
+                                  LocPosTechMask techMask)
+{
+    if (!reserve(GNSS_REC_MAX_FIELD_SIZE * GNSS_REC_POSITION_FIELDS)) {
+        return;
+    }
+    const LocGpsLocation& location = ulpLocation.gpsLocation;
+    int64_t utcMs = location.timestamp;
+    int64_t latitude = gnssRecFixed(location.latitude, GNSS_REC_DEG_SCALE);
+    int64_t longitude = gnssRecFixed(location.longitude, GNSS_REC_DEG_SCALE);
+    uint32_t engine = (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE) ?
+            locationExtended.locOutputEngType : LOC_OUTPUT_ENGINE_FUSED;
+
+    putSigned(utcMs - mDelta.utcMs);
+    putUnsigned(engine);
+    putUnsigned(location.flags);
+    putUnsigned(techMask);
+    putSigned(latitude - mDelta.latitude);
+    putSigned(longitude - mDelta.longitude);
+    putSigned(gnssRecFixed(location.altitude, GNSS_REC_MM_SCALE));
+    putUnsigned(gnssRecFixed(location.speed, GNSS_REC_MM_SCALE));
+    putUnsigned(gnssRecFixed(location.bearing, GNSS_REC_ANGLE_SCALE));
+    putUnsigned(gnssRecFixed(location.accuracy, GNSS_REC_MM_SCALE));
+    putUnsigned(gnssRecFixed(location.vertUncertainity, GNSS_REC_MM_SCALE));
+    commit(GNSS_REC_POSITION);
+
+    mDelta.utcMs = utcMs;
+    mDelta.latitude = latitude;
+    mDelta.longitude = longitude;
+}
+
+void GnssRecorder::recordSv(const GnssSvNotification& svNotify)
+{
+    uint32_t count = std::min(svNotify.count, (uint32_t)GNSS_SV_MAX);
+    if (!reserve(GNSS_REC_MAX_FIELD_SIZE *
+                 (GNSS_REC_SV_FIELDS + count * GNSS_REC_SV_ENTRY_FIELDS))) {
+        return;
+    }
+    int64_t bootMs = clockMs(CLOCK_BOOTTIME);
+
+    putSigned(bootMs - mDelta.svBootMs);
+    putUnsigned(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const GnssSv& sv = svNotify.gnssSvs[i];
+        putUnsigned(sv.svId);
+        putUnsigned(sv.type);
+        putUnsigned(sv.gnssSvOptionsMask);
+        putUnsigned(gnssRecFixed(sv.cN0Dbhz, GNSS_REC_CN0_SCALE));
+        putSigned(gnssRecFixed(sv.elevation, GNSS_REC_ANGLE_SCALE));
+        putUnsigned(gnssRecFixed(sv.azimuth, GNSS_REC_ANGLE_SCALE));
+        putUnsigned(gnssRecFixed(sv.carrierFrequencyHz, 1e-3));
+    }
+    commit(GNSS_REC_SV);
+
+    mDelta.svBootMs = bootMs;
+}
+
+void GnssRecorder::recordMeasurements(const GnssMeasurementsNotification& measurements)
+{
+    uint32_t count = std::min(measurements.count, (uint32_t)GNSS_MEASUREMENTS_MAX);
+    if (!reserve(GNSS_REC_MAX_FIELD_SIZE *
+                 (GNSS_REC_CLOCK_FIELDS + count * GNSS_REC_MEAS_ENTRY_FIELDS))) {
+        return;
+    }
+    const GnssMeasurementsClock& clock = measurements.clock;
+    int64_t biasPs = gnssRecFixed(clock.biasNs, GNSS_REC_PS_SCALE);
+    // the receive times of the SVs are all near the receiver's own time,
+    // so only their offset from it is stored
+    int64_t rxTimeRefNs = gnssRecRxTimeRefNs(clock.timeNs, clock.fullBiasNs, biasPs);
+
+    putUnsigned(clock.flags);
+    putSigned(clock.leapSecond);
+    putSigned(clock.timeNs - mDelta.timeNs);
+    putUnsigned(gnssRecFixed(clock.timeUncertaintyNs, GNSS_REC_PS_SCALE));
+    putSigned(clock.fullBiasNs - mDelta.fullBiasNs);
+    putSigned(biasPs);
+    putUnsigned(gnssRecFixed(clock.biasUncertaintyNs, GNSS_REC_PS_SCALE));
+    putSigned(gnssRecFixed(clock.driftNsps, GNSS_REC_PS_SCALE));
+    putUnsigned(gnssRecFixed(clock.driftUncertaintyNsps, GNSS_REC_PS_SCALE));
+    putUnsigned(clock.hwClockDiscontinuityCount);
+    putUnsigned(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const GnssMeasurementsData& meas = measurements.measurements[i];
+        putUnsigned(meas.flags);
+        putUnsigned(meas.svId);
+        putUnsigned(meas.svType);
+        putSigned(gnssRecFixed(meas.timeOffsetNs, GNSS_REC_PS_SCALE));
+        putUnsigned(meas.stateMask);
+        putSigned(meas.receivedSvTimeNs - rxTimeRefNs);
+        putUnsigned(meas.receivedSvTimeUncertaintyNs);
+        putUnsigned(gnssRecFixed(meas.carrierToNoiseDbHz, GNSS_REC_CN0_SCALE));
+        putSigned(gnssRecFixed(meas.pseudorangeRateMps, GNSS_REC_MM_SCALE));
+        putUnsigned(gnssRecFixed(meas.pseudorangeRateUncertaintyMps, GNSS_REC_MM_SCALE));
+        putUnsigned(meas.adrStateMask);
+        putSigned(gnssRecFixed(meas.adrMeters, GNSS_REC_ADR_SCALE));
+        putUnsigned(gnssRecFixed(meas.adrUncertaintyMeters, GNSS_REC_ADR_SCALE));
+        putUnsigned(gnssRecFixed(meas.carrierFrequencyHz, 1.0));
+        putUnsigned(meas.multipathIndicator);
+        putUnsigned(meas.cycleSlipCount);
+        putSigned(meas.gloFrequency);
+    }
+    commit(GNSS_REC_MEASUREMENTS);
+
+    mDelta.timeNs = clock.timeNs;
+    mDelta.fullBiasNs = clock.fullBiasNs;
+}
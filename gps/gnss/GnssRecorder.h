@@ -0,0 +1,83 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GNSS_RECORDER_H
+#define GNSS_RECORDER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <gps_extended_c.h>
+#include <GnssRecorderFormat.h>
+
+/* Records the positions, SV reports and raw measurements the GnssAdapter
+   gets into a rolling set of files, in the compact form GnssRecorderFormat.h
+   describes, for gnss_recorder_convert to turn into CSV or RINEX offline.
+   The files are mapped in, so a record costs an encode and a copy and no
+   system call, and a crash loses nothing but the record being written.
+   Only ever used from the adapter thread. */
+class GnssRecorder {
+public:
+    GnssRecorder(const char* dir, uint32_t fileSizeKb, uint32_t fileCount);
+    ~GnssRecorder();
+
+    void recordPosition(const UlpLocation& ulpLocation,
+                        const GpsLocationExtended& locationExtended,
+                        LocPosTechMask techMask);
+    void recordSv(const GnssSvNotification& svNotify);
+    void recordMeasurements(const GnssMeasurementsNotification& measurements);
+
+private:
+    inline void putUnsigned(uint64_t value) {
+        size_t size = mPayload.size();
+        mPayload.resize(size + 10);
+        mPayload.resize(size + gnssRecPutVarint(&mPayload[size], value));
+    }
+    inline void putSigned(int64_t value) { putUnsigned(gnssRecZigzag(value)); }
+
+    std::string filePath(uint32_t index) const;
+    bool openFile();
+    void closeFile();
+    // makes room for a record of up to maxPayload bytes and starts it, false
+    // if there is nothing to record to
+    bool reserve(size_t maxPayload);
+    // appends the record in mPayload, moving on to a new file if it is full
+    void commit(GnssRecRecordType type);
+
+    std::string mDir;
+    size_t mFileSize;
+    uint32_t mFileCount;
+    bool mDisabled;
+    int mFd;
+    uint8_t* mMap;
+    size_t mUsed;
+    GnssRecDeltaState mDelta;
+    std::vector<uint8_t> mPayload;
+};
+
+#endif // GNSS_RECORDER_H
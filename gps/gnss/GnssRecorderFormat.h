@@ -0,0 +1,154 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GNSS_RECORDER_FORMAT_H
+#define GNSS_RECORDER_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+/* Format of the files GnssRecorder writes, shared with the host side
+ * gnss_recorder_convert. A file is a GnssRecFileHeader followed by records of
+ *     uint8_t type;       GnssRecRecordType
+ *     varint  length;     of the payload
+ *     uint8_t payload[length];
+ * Only the first dataSize bytes after the header hold complete records.
+ *
+ * All payload fields are varints, LEB128 as in protobuf, signed ones zigzag
+ * encoded, and fixed point in the units below. Fields marked delta are the
+ * difference to the same field of the previous record of that type in the
+ * same file, so each file decodes on its own. Payloads, field by field:
+ *
+ * GNSS_REC_POSITION
+ *     s delta utcMs, u engine (LocOutputEngineType), u flags (LocGpsLocation),
+ *     u techMask, s delta latitude, s delta longitude (GNSS_REC_DEG_SCALE),
+ *     s altitude (mm), u speed (mm/s), u bearing (GNSS_REC_ANGLE_SCALE),
+ *     u accuracy (mm), u verticalAccuracy (mm)
+ * GNSS_REC_SV
+ *     s delta bootMs, u count, then per SV:
+ *     u svId, u type, u gnssSvOptionsMask, u cN0 (GNSS_REC_CN0_SCALE),
+ *     s elevation, u azimuth (GNSS_REC_ANGLE_SCALE), u carrierFrequency (kHz)
+ * GNSS_REC_MEASUREMENTS
+ *     u clock flags, s leapSecond, s delta timeNs, u timeUncertainty (ps),
+ *     s delta fullBiasNs, s bias (ps), u biasUncertainty (ps),
+ *     s drift (ps/s), u driftUncertainty (ps/s), u hwClockDiscontinuityCount,
+ *     u count, then per measurement:
+ *     u flags, u svId, u svType, s timeOffset (ps), u stateMask,
+ *     s receivedSvTimeNs - gnssRecRxTimeRefNs(), u receivedSvTimeUncertaintyNs,
+ *     u carrierToNoise (GNSS_REC_CN0_SCALE), s pseudorangeRate (mm/s),
+ *     u pseudorangeRateUncertainty (mm/s), u adrStateMask,
+ *     s adr (GNSS_REC_ADR_SCALE), u adrUncertainty (GNSS_REC_ADR_SCALE),
+ *     u carrierFrequency (Hz), u multipathIndicator, u cycleSlipCount,
+ *     s gloFrequency
+ */
+
+#define GNSS_REC_MAGIC              "GNSSREC1"
+#define GNSS_REC_VERSION            (1)
+
+#define GNSS_REC_DEG_SCALE          (1e7)     // 1e-7 degrees, about 1 cm
+#define GNSS_REC_ANGLE_SCALE        (100.0)   // 0.01 degrees
+#define GNSS_REC_CN0_SCALE          (100.0)   // 0.01 dB-Hz
+#define GNSS_REC_ADR_SCALE          (10000.0) // 0.1 mm
+#define GNSS_REC_PS_SCALE           (1000.0)  // ps per ns
+#define GNSS_REC_MM_SCALE           (1000.0)  // mm per m
+
+#define GNSS_REC_WEEK_NS            (604800LL * 1000000000LL)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    // bytes of complete records after the header, updated after each record
+    uint64_t dataSize;
+    uint64_t createdUtcMs;
+    uint8_t reserved[24];
+} GnssRecFileHeader;
+
+typedef enum {
+    GNSS_REC_POSITION = 1,
+    GNSS_REC_SV,
+    GNSS_REC_MEASUREMENTS,
+} GnssRecRecordType;
+
+// the previous values the delta fields are relative to, reset per file
+typedef struct {
+    int64_t utcMs;
+    int64_t latitude;
+    int64_t longitude;
+    int64_t svBootMs;
+    int64_t timeNs;
+    int64_t fullBiasNs;
+} GnssRecDeltaState;
+
+static inline int64_t gnssRecFixed(double value, double scale) {
+    return (int64_t)llround(value * scale);
+}
+
+static inline uint64_t gnssRecZigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t gnssRecUnzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// writes value at out, which must have room for 10 bytes; returns the bytes written
+static inline size_t gnssRecPutVarint(uint8_t* out, uint64_t value) {
+    size_t len = 0;
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+// reads a varint at *in, not past end; false if it is cut off
+static inline bool gnssRecGetVarint(const uint8_t** in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; *in < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*in)++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (0 == (byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* GPS time of week of the receiver clock, from the fixed point fields of a
+ * measurements record, to which a receivedSvTimeNs is close for most
+ * constellations; encoder and decoder must compute it alike. */
+static inline int64_t gnssRecRxTimeRefNs(int64_t timeNs, int64_t fullBiasNs, int64_t biasPs) {
+    int64_t gpsNs = timeNs - fullBiasNs - biasPs / 1000;
+    return ((gpsNs % GNSS_REC_WEEK_NS) + GNSS_REC_WEEK_NS) % GNSS_REC_WEEK_NS;
+}
+
+#endif // GNSS_RECORDER_FORMAT_H
@@ -48,6 +48,7 @@
 #include <DataItemId.h>
 #include <DataItemsFactoryProxy.h>
 #include <DataItemConcreteTypesBase.h>
+#include <loc_misc_utils.h>
 
 using namespace loc_util;
 using namespace loc_core;
@@ -110,6 +111,9 @@ XtraSystemStatusObserver::XtraSystemStatusObserver(IOsObserver* sysStatObs,
         mReqStatusReceived(false),
         mIsConnectivityStatusKnown(false),
         mSender(LocIpc::getLocIpcLocalSender(LOC_IPC_XTRA)),
+        mCharging(false),
+        mLastPrefetchMs(0),
+        mPrefetchTimer(*this),
         mDelayLocTimer(*mSender) {
     subscribe(true);
     auto recver = LocIpc::getLocIpcLocalRecver(
@@ -122,9 +126,12 @@ XtraSystemStatusObserver::XtraSystemStatusObserver(IOsObserver* sysStatObs,
 bool XtraSystemStatusObserver::updateLockStatus(GnssConfigGpsLock lock) {
     // mask NI(NFW bit) since from XTRA's standpoint GPS is enabled if
     // MO(AFW bit) is enabled and disabled when MO is disabled
-    mGpsLock = lock & ~GNSS_CONFIG_GPS_LOCK_NI;
+    GnssConfigGpsLock gpsLock = lock & ~GNSS_CONFIG_GPS_LOCK_NI;
+    // XTRA already holds this value, from the last update or respondStatus
+    bool unchanged = (gpsLock == mGpsLock);
+    mGpsLock = gpsLock;
 
-    if (!mReqStatusReceived) {
+    if (!mReqStatusReceived || unchanged) {
         return true;
     }
 
@@ -137,17 +144,22 @@ bool XtraSystemStatusObserver::updateLockStatus(GnssConfigGpsLock lock) {
 
 bool XtraSystemStatusObserver::updateConnections(uint64_t allConnections,
         NetworkInfoType* networkHandleInfo) {
+    bool unchanged = mIsConnectivityStatusKnown && (allConnections == mConnections);
     mIsConnectivityStatusKnown = true;
     mConnections = allConnections;
 
     LOC_LOGd("updateConnections mConnections:%" PRIx64, mConnections);
     for (uint8_t i = 0; i < MAX_NETWORK_HANDLES; ++i) {
+        unchanged = unchanged && (mNetworkHandle[i] == networkHandleInfo[i]);
         mNetworkHandle[i] = networkHandleInfo[i];
         LOC_LOGd("updateConnections [%d] networkHandle:%" PRIx64 " networkType:%u",
             i, mNetworkHandle[i].networkHandle, mNetworkHandle[i].networkType);
     }
 
-    if (!mReqStatusReceived) {
+    evaluateXtraPrefetch();
+    // the network info item is re-notified on every data call change, most
+    // of which leave the connection set as it was
+    if (!mReqStatusReceived || unchanged) {
         return true;
     }
 
@@ -168,30 +180,26 @@ bool XtraSystemStatusObserver::updateConnections(uint64_t allConnections,
 }
 
 bool XtraSystemStatusObserver::updateTac(const string& tac) {
-    mTac = tac;
-
-    if (!mReqStatusReceived) {
+    if (!mReqStatusReceived || tac == mTac) {
+        mTac = tac;
         return true;
     }
+    mTac = tac;
 
-    stringstream ss;
-    ss <<  "tac";
-    ss << " " << tac.c_str();
-    string s = ss.str();
+    string s("tac ");
+    s.append(tac.c_str());
     return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
 }
 
 bool XtraSystemStatusObserver::updateMccMnc(const string& mccmnc) {
-    mMccmnc = mccmnc;
-
-    if (!mReqStatusReceived) {
+    if (!mReqStatusReceived || mccmnc == mMccmnc) {
+        mMccmnc = mccmnc;
         return true;
     }
+    mMccmnc = mccmnc;
 
-    stringstream ss;
-    ss <<  "mncmcc";
-    ss << " " << mccmnc.c_str();
-    string s = ss.str();
+    string s("mncmcc ");
+    s.append(mccmnc.c_str());
     return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
 }
 
@@ -209,8 +217,61 @@ bool XtraSystemStatusObserver::updateXtraThrottle(const bool enabled) {
     return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
 }
 
+void XtraSystemStatusObserver::updatePowerConnectState(bool charging) {
+    mCharging = charging;
+    evaluateXtraPrefetch();
+}
+
+/* unmetered network and charger, a download costs the user nothing now */
+bool XtraSystemStatusObserver::isPrefetchOpportune() const {
+    uint64_t unmetered = ((uint64_t)1 << TYPE_WIFI) | ((uint64_t)1 << TYPE_ETHERNET);
+    return mIsConnectivityStatusKnown && mCharging && (0 != (mConnections & unmetered));
+}
+
+/* Asks the XTRA daemon for a download ahead of the engine's own request,
+   once the data the engine holds is XTRA_PREFETCH_AGE_HOURS old, so that
+   a later cold start on cellular finds it fresh. */
+void XtraSystemStatusObserver::evaluateXtraPrefetch() {
+    uint32_t prefetchAgeHours = ContextBase::mGps_conf.XTRA_PREFETCH_AGE_HOURS;
+    if (0 == prefetchAgeHours) {
+        return;
+    }
+    mPrefetchTimer.stop();
+    if (!mReqStatusReceived || !isPrefetchOpportune()) {
+        return;
+    }
+    // the data ages without any event, so look again while this lasts
+    mPrefetchTimer.start(XTRA_PREFETCH_RECHECK_MS, false);
+
+    uint64_t nowMs = getBootTimeMilliSec();
+    if (0 != mLastPrefetchMs && nowMs - mLastPrefetchMs < XTRA_PREFETCH_RECHECK_MS) {
+        return;
+    }
+    SystemStatusXtra xtra;
+    if (!SystemStatus::getInstance(mMsgTask)->getLatestXtra(xtra)) {
+        LOC_LOGd("no XTRA status from the engine yet");
+        return;
+    }
+    // the age is as of the engine report, in hours
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    uint64_t sinceReportHours = (tv.tv_sec > xtra.mUtcTime.tv_sec) ?
+            (tv.tv_sec - xtra.mUtcTime.tv_sec) / 3600 : 0;
+    uint64_t ageHours = xtra.mGpsXtraAge + sinceReportHours;
+    if (0 != xtra.mXtraValidMask && ageHours < prefetchAgeHours) {
+        return;
+    }
+
+    LOC_LOGi("XTRA prefetch, age %" PRIu64 " hours valid mask 0x%x",
+             ageHours, xtra.mXtraValidMask);
+    mLastPrefetchMs = nowMs;
+    const char s[] = "xtraprefetch";
+    LocIpc::send(*mSender, (const uint8_t*)s, strlen(s));
+}
+
 inline bool XtraSystemStatusObserver::onStatusRequested(int32_t xtraStatusUpdated) {
     mReqStatusReceived = true;
+    evaluateXtraPrefetch();
 
     if (xtraStatusUpdated) {
         return true;
@@ -277,11 +338,10 @@ void XtraSystemStatusObserver::stopDgnssSource() {
 
 void XtraSystemStatusObserver::updateNmeaToDgnssServer(const string& nmea)
 {
-    stringstream ss;
-    ss <<  "updateDgnssServerNmea" << endl;
-    ss << nmea.data() << endl;
-
-    string s = ss.str();
+    static const char header[] = "updateDgnssServerNmea\n";
+    string s;
+    s.reserve(sizeof(header) + nmea.size() + 1);
+    s.append(header).append(nmea.data()).push_back('\n');
     LOC_LOGd("%s", s.data());
     LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size());
 }
@@ -292,6 +352,7 @@ void XtraSystemStatusObserver::subscribe(bool yes)
     list<DataItemId> subItemIdList;
     subItemIdList.push_back(NETWORKINFO_DATA_ITEM_ID);
     subItemIdList.push_back(MCCMNC_DATA_ITEM_ID);
+    subItemIdList.push_back(POWER_CONNECTED_STATE_DATA_ITEM_ID);
 
     if (yes) {
         mSystemStatusObsrvr->subscribe(subItemIdList, this);
@@ -313,38 +374,37 @@ void XtraSystemStatusObserver::getName(string& name)
 }
 
 void XtraSystemStatusObserver::notify(const list<IDataItemCore*>& dlist)
+{
+    // the items are only lent for the call, so they are copied
+    list<shared_ptr<IDataItemCore>> dataItemList;
+    for (auto eachItem : dlist) {
+        shared_ptr<IDataItemCore> dataitem(
+                DataItemsFactoryProxy::createNewDataItem(eachItem->getId()));
+        if (nullptr == dataitem) {
+            break;
+        }
+        // Copy the contents of the data item
+        dataitem->copy(eachItem);
+
+        dataItemList.push_back(dataitem);
+    }
+    notifyShared(dataItemList);
+}
+
+void XtraSystemStatusObserver::notifyShared(const list<shared_ptr<IDataItemCore>>& dlist)
 {
     struct HandleOsObserverUpdateMsg : public LocMsg {
         XtraSystemStatusObserver* mXtraSysStatObj;
-        list <IDataItemCore*> mDataItemList;
+        // snapshots shared with the sender, never changed
+        list<shared_ptr<IDataItemCore>> mDataItemList;
 
         inline HandleOsObserverUpdateMsg(XtraSystemStatusObserver* xtraSysStatObs,
-                const list<IDataItemCore*>& dataItemList) :
-                mXtraSysStatObj(xtraSysStatObs) {
-            for (auto eachItem : dataItemList) {
-                IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(
-                        eachItem->getId());
-                if (NULL == dataitem) {
-                    break;
-                }
-                // Copy the contents of the data item
-                dataitem->copy(eachItem);
-
-                mDataItemList.push_back(dataitem);
-            }
-        }
-
-        inline ~HandleOsObserverUpdateMsg() {
-            for (auto itor = mDataItemList.begin(); itor != mDataItemList.end(); ++itor) {
-                if (*itor != nullptr) {
-                    delete *itor;
-                    *itor = nullptr;
-                }
-            }
-        }
+                const list<shared_ptr<IDataItemCore>>& dataItemList) :
+                mXtraSysStatObj(xtraSysStatObs), mDataItemList(dataItemList) {}
 
         inline void proc() const {
-            for (auto each : mDataItemList) {
+            for (auto& eachItem : mDataItemList) {
+                IDataItemCore* each = eachItem.get();
                 switch (each->getId())
                 {
                     case NETWORKINFO_DATA_ITEM_ID:
@@ -374,6 +434,14 @@ void XtraSystemStatusObserver::notify(const list<IDataItemCore*>& dlist)
                     }
                     break;
 
+                    case POWER_CONNECTED_STATE_DATA_ITEM_ID:
+                    {
+                        PowerConnectStateDataItemBase* powerConnect =
+                                static_cast<PowerConnectStateDataItemBase*>(each);
+                        mXtraSysStatObj->updatePowerConnectState(powerConnect->mState);
+                    }
+                    break;
+
                     default:
                     break;
                 }
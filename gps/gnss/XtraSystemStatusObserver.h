@@ -41,6 +41,10 @@ using loc_core::IOsObserver;
 using loc_core::IDataItemObserver;
 using loc_core::IDataItemCore;
 
+/* how often the XTRA age is checked again while the device stays on an
+   unmetered network and the charger, and the least time between prefetches */
+#define XTRA_PREFETCH_RECHECK_MS (60 * 60 * 1000)
+
 struct StartDgnssNtripParams {
     GnssNtripConnectionParams ntripParams;
     string                    nmea;
@@ -62,6 +66,7 @@ public :
     // constructor & destructor
     XtraSystemStatusObserver(IOsObserver* sysStatObs, const MsgTask* msgTask);
     inline virtual ~XtraSystemStatusObserver() {
+        mPrefetchTimer.stop();
         subscribe(false);
         mIpc.stopNonBlockingListening();
     }
@@ -69,6 +74,7 @@ public :
     // IDataItemObserver overrides
     inline virtual void getName(string& name);
     virtual void notify(const list<IDataItemCore*>& dlist);
+    virtual void notifyShared(const list<shared_ptr<IDataItemCore>>& dlist);
 
     bool updateLockStatus(GnssConfigGpsLock lock);
     bool updateConnections(uint64_t allConnections,
@@ -76,6 +82,7 @@ public :
     bool updateTac(const string& tac);
     bool updateMccMnc(const string& mccmnc);
     bool updateXtraThrottle(const bool enabled);
+    void updatePowerConnectState(bool charging);
     inline const MsgTask* getMsgTask() { return mMsgTask; }
     void subscribe(bool yes);
     bool onStatusRequested(int32_t xtraStatusUpdated);
@@ -98,6 +105,20 @@ private:
     bool mIsConnectivityStatusKnown;
     shared_ptr<LocIpcSender> mSender;
     string mNtripParamsString;
+    bool mCharging;
+    uint64_t mLastPrefetchMs;
+
+    bool isPrefetchOpportune() const;
+    void evaluateXtraPrefetch();
+    class PrefetchTimer : public LocTimer {
+        XtraSystemStatusObserver& mXSSO;
+    public:
+        PrefetchTimer(XtraSystemStatusObserver& xsso) : mXSSO(xsso) {}
+        void timeOutCallback() override {
+            XtraSystemStatusObserver& xsso = mXSSO;
+            xsso.mMsgTask->sendMsg([&xsso] { xsso.evaluateXtraPrefetch(); });
+        }
+    } mPrefetchTimer;
 
     class DelayLocTimer : public LocTimer {
         LocIpcSender& mSender;
@@ -0,0 +1,562 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/* gnss_recorder_convert: turns the files GnssRecorder writes into CSV, or
+   the raw measurements in them into a RINEX 3.03 observation file.
+       gnss_recorder_convert csv|rinex <file>...
+   The files are given oldest first, i.e. gnss_rec.7.bin down to
+   gnss_rec.0.bin, and the output goes to stdout. */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <LocationDataTypes.h>
+#include <GnssRecorderFormat.h>
+
+#define SPEED_OF_LIGHT_MPS  (299792458.0)
+#define DAY_NS              (86400LL * 1000000000LL)
+// seconds from the Unix epoch to the GPS one, 1980-01-06
+#define GPS_EPOCH_UNIX_SEC  (315964800LL)
+#define BDS_GPS_OFFSET_NS   (14LL * 1000000000LL)
+#define GLO_UTC_OFFSET_NS   (3LL * 3600 * 1000000000LL)
+#define DEFAULT_LEAP_SECOND (18)
+
+typedef struct {
+    uint32_t flags;
+    uint32_t svId;
+    uint32_t svType;
+    double timeOffsetNs;
+    uint32_t stateMask;
+    int64_t receivedSvTimeNs;
+    uint64_t receivedSvTimeUncertaintyNs;
+    double carrierToNoiseDbHz;
+    double pseudorangeRateMps;
+    double pseudorangeRateUncertaintyMps;
+    uint32_t adrStateMask;
+    double adrMeters;
+    double adrUncertaintyMeters;
+    double carrierFrequencyHz;
+    uint32_t multipathIndicator;
+    uint32_t cycleSlipCount;
+    int32_t gloFrequency;
+} Measurement;
+
+typedef struct {
+    uint32_t flags;
+    int32_t leapSecond;
+    int64_t timeNs;
+    double timeUncertaintyNs;
+    int64_t fullBiasNs;
+    int64_t biasPs;
+    double biasUncertaintyNs;
+    double driftNsps;
+    double driftUncertaintyNsps;
+    uint32_t hwClockDiscontinuityCount;
+    std::vector<Measurement> measurements;
+} Epoch;
+
+/* Reads the fields of one record payload in order. A payload cut short
+   reads as zeroes from there on and marks the reader bad. */
+class PayloadReader {
+public:
+    PayloadReader(const uint8_t* data, size_t length) :
+        mIn(data), mEnd(data + length), mBad(false) {}
+    uint64_t u() {
+        uint64_t value = 0;
+        if (!mBad && !gnssRecGetVarint(&mIn, mEnd, value)) {
+            mBad = true;
+            value = 0;
+        }
+        return value;
+    }
+    int64_t s() { return gnssRecUnzigzag(u()); }
+    bool bad() const { return mBad; }
+private:
+    const uint8_t* mIn;
+    const uint8_t* mEnd;
+    bool mBad;
+};
+
+static bool sCsv = true;
+static std::vector<Epoch> sEpochs;
+
+static void decodePosition(PayloadReader& in, GnssRecDeltaState& delta)
+{
+    delta.utcMs += in.s();
+    uint64_t engine = in.u();
+    uint64_t flags = in.u();
+    uint64_t techMask = in.u();
+    delta.latitude += in.s();
+    delta.longitude += in.s();
+    double altitude = in.s() / GNSS_REC_MM_SCALE;
+    double speed = in.u() / GNSS_REC_MM_SCALE;
+    double bearing = in.u() / GNSS_REC_ANGLE_SCALE;
+    double accuracy = in.u() / GNSS_REC_MM_SCALE;
+    double verticalAccuracy = in.u() / GNSS_REC_MM_SCALE;
+    if (sCsv && !in.bad()) {
+        printf("Fix,%lld,%llu,0x%llx,0x%llx,%.7f,%.7f,%.3f,%.3f,%.2f,%.3f,%.3f\n",
+               (long long)delta.utcMs, (unsigned long long)engine,
+               (unsigned long long)flags, (unsigned long long)techMask,
+               delta.latitude / GNSS_REC_DEG_SCALE, delta.longitude / GNSS_REC_DEG_SCALE,
+               altitude, speed, bearing, accuracy, verticalAccuracy);
+    }
+}
+
+static void decodeSv(PayloadReader& in, GnssRecDeltaState& delta)
+{
+    delta.svBootMs += in.s();
+    uint64_t count = in.u();
+    for (uint64_t i = 0; i < count && !in.bad(); i++) {
+        uint64_t svId = in.u();
+        uint64_t type = in.u();
+        uint64_t options = in.u();
+        double cN0 = in.u() / GNSS_REC_CN0_SCALE;
+        double elevation = in.s() / GNSS_REC_ANGLE_SCALE;
+        double azimuth = in.u() / GNSS_REC_ANGLE_SCALE;
+        uint64_t frequencyKhz = in.u();
+        if (sCsv && !in.bad()) {
+            printf("Status,%lld,%llu,%llu,0x%llx,%.2f,%.2f,%.2f,%llu\n",
+                   (long long)delta.svBootMs, (unsigned long long)svId,
+                   (unsigned long long)type, (unsigned long long)options,
+                   cN0, elevation, azimuth, (unsigned long long)frequencyKhz * 1000);
+        }
+    }
+}
+
+static void decodeMeasurements(PayloadReader& in, GnssRecDeltaState& delta)
+{
+    Epoch epoch;
+    epoch.flags = in.u();
+    epoch.leapSecond = in.s();
+    delta.timeNs += in.s();
+    epoch.timeNs = delta.timeNs;
+    epoch.timeUncertaintyNs = in.u() / GNSS_REC_PS_SCALE;
+    delta.fullBiasNs += in.s();
+    epoch.fullBiasNs = delta.fullBiasNs;
+    epoch.biasPs = in.s();
+    epoch.biasUncertaintyNs = in.u() / GNSS_REC_PS_SCALE;
+    epoch.driftNsps = in.s() / GNSS_REC_PS_SCALE;
+    epoch.driftUncertaintyNsps = in.u() / GNSS_REC_PS_SCALE;
+    epoch.hwClockDiscontinuityCount = in.u();
+    uint64_t count = in.u();
+    int64_t rxTimeRefNs = gnssRecRxTimeRefNs(epoch.timeNs, epoch.fullBiasNs, epoch.biasPs);
+    for (uint64_t i = 0; i < count && !in.bad(); i++) {
+        Measurement meas;
+        meas.flags = in.u();
+        meas.svId = in.u();
+        meas.svType = in.u();
+        meas.timeOffsetNs = in.s() / GNSS_REC_PS_SCALE;
+        meas.stateMask = in.u();
+        meas.receivedSvTimeNs = in.s() + rxTimeRefNs;
+        meas.receivedSvTimeUncertaintyNs = in.u();
+        meas.carrierToNoiseDbHz = in.u() / GNSS_REC_CN0_SCALE;
+        meas.pseudorangeRateMps = in.s() / GNSS_REC_MM_SCALE;
+        meas.pseudorangeRateUncertaintyMps = in.u() / GNSS_REC_MM_SCALE;
+        meas.adrStateMask = in.u();
+        meas.adrMeters = in.s() / GNSS_REC_ADR_SCALE;
+        meas.adrUncertaintyMeters = in.u() / GNSS_REC_ADR_SCALE;
+        meas.carrierFrequencyHz = in.u();
+        meas.multipathIndicator = in.u();
+        meas.cycleSlipCount = in.u();
+        meas.gloFrequency = in.s();
+        epoch.measurements.push_back(meas);
+    }
+    if (in.bad()) {
+        return;
+    }
+    if (!sCsv) {
+        sEpochs.push_back(epoch);
+        return;
+    }
+    for (const Measurement& meas : epoch.measurements) {
+        printf("Raw,%lld,0x%x,%d,%.3f,%lld,%.3f,%.3f,%.3f,%.3f,%u,"
+               "%u,%u,0x%x,%.3f,0x%x,%lld,%llu,%.2f,%.3f,%.3f,0x%x,%.4f,%.4f,%.0f,%u,%u,%d\n",
+               (long long)epoch.timeNs, epoch.flags, epoch.leapSecond,
+               epoch.timeUncertaintyNs, (long long)epoch.fullBiasNs,
+               epoch.biasPs / GNSS_REC_PS_SCALE, epoch.biasUncertaintyNs,
+               epoch.driftNsps, epoch.driftUncertaintyNsps, epoch.hwClockDiscontinuityCount,
+               meas.svId, meas.svType, meas.flags, meas.timeOffsetNs, meas.stateMask,
+               (long long)meas.receivedSvTimeNs,
+               (unsigned long long)meas.receivedSvTimeUncertaintyNs,
+               meas.carrierToNoiseDbHz, meas.pseudorangeRateMps,
+               meas.pseudorangeRateUncertaintyMps, meas.adrStateMask, meas.adrMeters,
+               meas.adrUncertaintyMeters, meas.carrierFrequencyHz, meas.multipathIndicator,
+               meas.cycleSlipCount, meas.gloFrequency);
+    }
+}
+
+static bool decodeFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (nullptr == file) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[64 * 1024];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + length);
+    }
+    fclose(file);
+
+    GnssRecFileHeader header;
+    if (data.size() < sizeof(header)) {
+        fprintf(stderr, "%s is not a recording\n", path);
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (0 != memcmp(header.magic, GNSS_REC_MAGIC, sizeof(header.magic)) ||
+            GNSS_REC_VERSION != header.version || header.headerSize > data.size()) {
+        fprintf(stderr, "%s is not a recording of version %d\n", path, GNSS_REC_VERSION);
+        return false;
+    }
+    const uint8_t* in = data.data() + header.headerSize;
+    const uint8_t* end = in + std::min((uint64_t)(data.size() - header.headerSize),
+                                       header.dataSize);
+
+    GnssRecDeltaState delta = {};
+    while (in < end) {
+        uint8_t type = *in++;
+        uint64_t payloadLength = 0;
+        if (!gnssRecGetVarint(&in, end, payloadLength) ||
+                payloadLength > (uint64_t)(end - in)) {
+            fprintf(stderr, "%s: truncated record\n", path);
+            break;
+        }
+        PayloadReader payload(in, payloadLength);
+        switch (type) {
+            case GNSS_REC_POSITION:
+                decodePosition(payload, delta);
+                break;
+            case GNSS_REC_SV:
+                decodeSv(payload, delta);
+                break;
+            case GNSS_REC_MEASUREMENTS:
+                decodeMeasurements(payload, delta);
+                break;
+            default:
+                // a record of a later version of the format
+                break;
+        }
+        if (payload.bad()) {
+            fprintf(stderr, "%s: corrupt record of type %u\n", path, type);
+        }
+        in += payloadLength;
+    }
+    return true;
+}
+
+/* === RINEX ================================================================== */
+
+typedef struct {
+    char system;              // RINEX satellite system letter
+    const char* band;         // band and attribute of the observation codes
+} RinexSignal;
+
+// the signals of each system written, in the order of SYS / # / OBS TYPES
+static const struct {
+    char system;
+    const char* bands[2];
+} sRinexSystems[] = {
+    { 'G', { "1C", "5Q" } },
+    { 'R', { "1C", nullptr } },
+    { 'E', { "1C", "5Q" } },
+    { 'C', { "2I", "5P" } },
+    { 'J', { "1C", "5Q" } },
+};
+
+static bool rinexSignal(const Measurement& meas, RinexSignal& signal, int& prn)
+{
+    // the lower bands are all about 1.2 GHz, the upper ones 1.6 GHz; no
+    // frequency at all means the usual L1 signal
+    bool upper = meas.carrierFrequencyHz < 1 || meas.carrierFrequencyHz > 1.4e9;
+    prn = meas.svId;
+    switch (meas.svType) {
+        case GNSS_SV_TYPE_GPS:
+            signal.system = 'G';
+            break;
+        case GNSS_SV_TYPE_GLONASS:
+            signal.system = 'R';
+            prn -= (prn > 64) ? 64 : 0;
+            if (!upper) {
+                return false;
+            }
+            break;
+        case GNSS_SV_TYPE_GALILEO:
+            signal.system = 'E';
+            prn -= (prn > 300) ? 300 : 0;
+            break;
+        case GNSS_SV_TYPE_BEIDOU:
+            signal.system = 'C';
+            prn -= (prn > 200) ? 200 : 0;
+            break;
+        case GNSS_SV_TYPE_QZSS:
+            signal.system = 'J';
+            prn -= (prn > 192) ? 192 : 0;
+            break;
+        default:
+            return false;
+    }
+    for (const auto& system : sRinexSystems) {
+        if (system.system == signal.system) {
+            signal.band = system.bands[upper ? 0 : 1];
+        }
+    }
+    return nullptr != signal.band && prn > 0 && prn < 100;
+}
+
+static double carrierFrequency(const Measurement& meas, const RinexSignal& signal)
+{
+    if (meas.carrierFrequencyHz > 0) {
+        return meas.carrierFrequencyHz;
+    }
+    switch (signal.system) {
+        case 'R':
+            return 1602e6 + meas.gloFrequency * 562.5e3;
+        case 'C':
+            return 1561.098e6;
+        default:
+            return 1575.42e6;
+    }
+}
+
+/* The pseudorange from the receiver clock and the SV time, which counts
+   from the start of the GPS week for most systems, or 0 if the SV time is
+   not known well enough for one. */
+static double pseudorange(const Epoch& epoch, const Measurement& meas, char system)
+{
+    int64_t rxNs = epoch.timeNs + (int64_t)llround(meas.timeOffsetNs) -
+            epoch.fullBiasNs - epoch.biasPs / 1000;
+    int64_t periodNs = GNSS_REC_WEEK_NS;
+    if ('R' == system) {
+        if (0 == (meas.stateMask & (GNSS_MEASUREMENTS_STATE_GLO_TOD_DECODED_BIT |
+                                    GNSS_MEASUREMENTS_STATE_GLO_TOD_KNOWN_BIT))) {
+            return 0;
+        }
+        int32_t leapSecond = (epoch.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT) ?
+                epoch.leapSecond : DEFAULT_LEAP_SECOND;
+        rxNs += GLO_UTC_OFFSET_NS - leapSecond * 1000000000LL;
+        periodNs = DAY_NS;
+    } else {
+        if (0 == (meas.stateMask & (GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT |
+                                    GNSS_MEASUREMENTS_STATE_TOW_KNOWN_BIT))) {
+            return 0;
+        }
+        if ('C' == system) {
+            rxNs -= BDS_GPS_OFFSET_NS;
+        }
+    }
+    int64_t rangeNs = ((rxNs % periodNs) + periodNs) % periodNs - meas.receivedSvTimeNs;
+    // across the end of a week or day
+    if (rangeNs > periodNs / 2) {
+        rangeNs -= periodNs;
+    } else if (rangeNs < -periodNs / 2) {
+        rangeNs += periodNs;
+    }
+    // the sub-ns part of the bias, lost in the integer time above
+    double rangeSec = (rangeNs - fmod(epoch.biasPs / GNSS_REC_PS_SCALE, 1.0)) * 1e-9;
+    return (rangeSec > 0 && rangeSec < 0.5) ? rangeSec * SPEED_OF_LIGHT_MPS : 0;
+}
+
+static void rinexTime(const Epoch& epoch, struct tm& date, double& seconds)
+{
+    int64_t gpsNs = epoch.timeNs - epoch.fullBiasNs - epoch.biasPs / 1000;
+    time_t sec = (time_t)(gpsNs / 1000000000LL + GPS_EPOCH_UNIX_SEC);
+    gmtime_r(&sec, &date);
+    seconds = date.tm_sec + (gpsNs % 1000000000LL) * 1e-9 +
+            fmod(-epoch.biasPs / GNSS_REC_PS_SCALE, 1.0) * 1e-9;
+}
+
+static void writeRinexHeader()
+{
+    time_t now = time(nullptr);
+    struct tm date;
+    gmtime_r(&now, &date);
+    char runDate[32];
+    strftime(runDate, sizeof(runDate), "%Y%m%d %H%M%S UTC", &date);
+
+    printf("%9.2f%-11s%-20s%-20s%-20s\n", 3.03, "", "OBSERVATION DATA", "M",
+           "RINEX VERSION / TYPE");
+    printf("%-20s%-20s%-20s%-20s\n", "gnss_recorder_conv", "", runDate,
+           "PGM / RUN BY / DATE");
+    printf("%-60s%-20s\n", "GNSS_REC", "MARKER NAME");
+    printf("%-60s%-20s\n", "", "OBSERVER / AGENCY");
+    printf("%-60s%-20s\n", "", "REC # / TYPE / VERS");
+    printf("%-60s%-20s\n", "", "ANT # / TYPE");
+    printf("%14.4f%14.4f%14.4f%-18s%-20s\n", 0.0, 0.0, 0.0, "",
+           "APPROX POSITION XYZ");
+    printf("%14.4f%14.4f%14.4f%-18s%-20s\n", 0.0, 0.0, 0.0, "",
+           "ANTENNA: DELTA H/E/N");
+    for (const auto& system : sRinexSystems) {
+        std::string types;
+        int count = 0;
+        for (const char* band : system.bands) {
+            if (nullptr != band) {
+                for (char observable : { 'C', 'L', 'D', 'S' }) {
+                    types += std::string(" ") + observable + band;
+                    count++;
+                }
+            }
+        }
+        printf("%c  %3d%-54s%-20s\n", system.system, count, types.c_str(),
+               "SYS / # / OBS TYPES");
+    }
+    struct tm first;
+    double seconds;
+    rinexTime(sEpochs.front(), first, seconds);
+    printf("  %4d    %2d    %2d    %2d    %2d   %10.7f     GPS         %-20s\n",
+           first.tm_year + 1900, first.tm_mon + 1, first.tm_mday,
+           first.tm_hour, first.tm_min, seconds, "TIME OF FIRST OBS");
+    printf("%-60s%-20s\n", "", "END OF HEADER");
+}
+
+static void writeRinexEpoch(const Epoch& epoch)
+{
+    // one line per satellite, with the observables of its signals side by side
+    typedef struct {
+        char system;
+        int prn;
+        std::string observations[2];
+    } RinexSatellite;
+    std::vector<RinexSatellite> satellites;
+
+    for (const Measurement& meas : epoch.measurements) {
+        RinexSignal signal = {};
+        int prn = 0;
+        if (!rinexSignal(meas, signal, prn)) {
+            continue;
+        }
+        int slot = 0;
+        for (const auto& system : sRinexSystems) {
+            if (system.system == signal.system) {
+                slot = (signal.band == system.bands[0]) ? 0 : 1;
+            }
+        }
+        double wavelength = SPEED_OF_LIGHT_MPS / carrierFrequency(meas, signal);
+        double range = pseudorange(epoch, meas, signal.system);
+        bool adrValid = 0 != (meas.adrStateMask &
+                GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT);
+        bool lossOfLock = 0 != (meas.adrStateMask &
+                (GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT |
+                 GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_CYCLE_SLIP_BIT));
+
+        char text[4 * 16 + 1];
+        int length = 0;
+        if (range > 0) {
+            length += snprintf(text + length, sizeof(text) - length, "%14.3f  ", range);
+        } else {
+            length += snprintf(text + length, sizeof(text) - length, "%16s", "");
+        }
+        if (adrValid) {
+            length += snprintf(text + length, sizeof(text) - length, "%14.3f%c ",
+                               meas.adrMeters / wavelength, lossOfLock ? '1' : ' ');
+        } else {
+            length += snprintf(text + length, sizeof(text) - length, "%16s", "");
+        }
+        length += snprintf(text + length, sizeof(text) - length, "%14.3f  ",
+                           -meas.pseudorangeRateMps / wavelength);
+        snprintf(text + length, sizeof(text) - length, "%14.3f  ",
+                 meas.carrierToNoiseDbHz);
+
+        RinexSatellite* satellite = nullptr;
+        for (RinexSatellite& each : satellites) {
+            if (each.system == signal.system && each.prn == prn) {
+                satellite = &each;
+            }
+        }
+        if (nullptr == satellite) {
+            satellites.push_back(RinexSatellite());
+            satellite = &satellites.back();
+            satellite->system = signal.system;
+            satellite->prn = prn;
+        }
+        satellite->observations[slot] = text;
+    }
+    if (satellites.empty()) {
+        return;
+    }
+
+    struct tm date;
+    double seconds;
+    rinexTime(epoch, date, seconds);
+    printf("> %4d %02d %02d %02d %02d%11.7f  0%3zu\n", date.tm_year + 1900,
+           date.tm_mon + 1, date.tm_mday, date.tm_hour, date.tm_min, seconds,
+           satellites.size());
+    for (const RinexSatellite& satellite : satellites) {
+        std::string line = satellite.observations[0];
+        if (!satellite.observations[1].empty()) {
+            line.resize(4 * 16, ' ');
+            line += satellite.observations[1];
+        }
+        // trailing blanks are left out
+        line.erase(line.find_last_not_of(' ') + 1);
+        printf("%c%02d%s\n", satellite.system, satellite.prn, line.c_str());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || (0 != strcmp(argv[1], "csv") && 0 != strcmp(argv[1], "rinex"))) {
+        fprintf(stderr, "usage: %s csv|rinex <file>...\n"
+                "    files oldest first, e.g. gnss_rec.7.bin ... gnss_rec.0.bin\n", argv[0]);
+        return 1;
+    }
+    sCsv = (0 == strcmp(argv[1], "csv"));
+    if (sCsv) {
+        printf("# Fix,UtcTimeMs,Engine,Flags,TechMask,LatitudeDeg,LongitudeDeg,AltitudeM,"
+               "SpeedMps,BearingDeg,AccuracyM,VerticalAccuracyM\n");
+        printf("# Status,BootTimeMs,Svid,ConstellationType,Options,Cn0DbHz,ElevationDeg,"
+               "AzimuthDeg,CarrierFrequencyHz\n");
+        printf("# Raw,TimeNanos,ClockFlags,LeapSecond,TimeUncertaintyNanos,FullBiasNanos,"
+               "BiasNanos,BiasUncertaintyNanos,DriftNanosPerSecond,"
+               "DriftUncertaintyNanosPerSecond,HardwareClockDiscontinuityCount,Svid,"
+               "ConstellationType,Flags,TimeOffsetNanos,State,ReceivedSvTimeNanos,"
+               "ReceivedSvTimeUncertaintyNanos,Cn0DbHz,PseudorangeRateMetersPerSecond,"
+               "PseudorangeRateUncertaintyMetersPerSecond,AccumulatedDeltaRangeState,"
+               "AccumulatedDeltaRangeMeters,AccumulatedDeltaRangeUncertaintyMeters,"
+               "CarrierFrequencyHz,MultipathIndicator,CycleSlipCount,GloFrequency\n");
+    }
+    for (int i = 2; i < argc; i++) {
+        decodeFile(argv[i]);
+    }
+    if (!sCsv) {
+        if (sEpochs.empty()) {
+            fprintf(stderr, "no measurements recorded\n");
+            return 1;
+        }
+        writeRinexHeader();
+        for (const Epoch& epoch : sEpochs) {
+            writeRinexEpoch(epoch);
+        }
+    }
+    return 0;
+}
@@ -104,6 +104,9 @@ static void measCorrClose();
 static uint32_t antennaInfoInit(const antennaInfoCb antennaInfoCallback);
 static void antennaInfoClose();
 static uint32_t configEngineRunState(PositioningEngineMask engType, LocEngineRunState engState);
+static void suspendTracking(bool suspend);
+static void submitBatch(const std::vector<std::function<void()>>& commands);
+static void setSvFilter(LocationAPI* client, const GnssSvFilter& filter);
 
 static const GnssInterface gGnssInterface = {
     sizeof(GnssInterface),
@@ -162,7 +165,10 @@ static const GnssInterface gGnssInterface = {
     gnssUpdateSecondaryBandConfig,
     gnssGetSecondaryBandConfig,
     resetNetworkInfo,
-    configEngineRunState
+    configEngineRunState,
+    suspendTracking,
+    submitBatch,
+    setSvFilter
 };
 
 #ifndef DEBUG_X86
@@ -445,6 +451,24 @@ static void resetNetworkInfo() {
     }
 }
 
+static void suspendTracking(bool suspend) {
+    if (NULL != gGnssAdapter) {
+        gGnssAdapter->suspendTrackingCommand(suspend);
+    }
+}
+
+static void submitBatch(const std::vector<std::function<void()>>& commands) {
+    if (NULL != gGnssAdapter) {
+        gGnssAdapter->submitBatchCommand(commands);
+    }
+}
+
+static void setSvFilter(LocationAPI* client, const GnssSvFilter& filter) {
+    if (NULL != gGnssAdapter) {
+        gGnssAdapter->setSvFilterCommand(client, filter);
+    }
+}
+
 static void updateSystemPowerState(PowerStateType systemPowerState) {
    if (NULL != gGnssAdapter) {
        gGnssAdapter->updateSystemPowerStateCommand(systemPowerState);
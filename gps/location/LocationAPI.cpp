@@ -34,7 +34,9 @@
 #include <log_util.h>
 #include <pthread.h>
 #include <map>
+#include <atomic>
 #include <loc_misc_utils.h>
+#include <loc_cfg.h>
 
 typedef const GnssInterface* (getGnssInterface)();
 typedef const GeofenceInterface* (getGeofenceInterface)();
@@ -67,9 +69,11 @@ typedef struct {
     LocationClientDestroyCbMap destroyClientData;
     LocationControlAPI* controlAPI;
     LocationControlCallbacks controlCallbacks;
-    GnssInterface* gnssInterface;
-    GeofenceInterface* geofenceInterface;
-    BatchingInterface* batchingInterface;
+    // written under gDataMutex, but read without it by the per-call paths;
+    // an interface is published once initialized and never unloaded
+    std::atomic<GnssInterface*> gnssInterface;
+    std::atomic<GeofenceInterface*> geofenceInterface;
+    std::atomic<BatchingInterface*> batchingInterface;
 } LocationAPIData;
 
 static LocationAPIData gData = {};
@@ -79,6 +83,11 @@ static bool gBatchingLoadFailed = false;
 static bool gGeofenceLoadFailed = false;
 static uint32_t gOSFrameworkRefCount = 0;
 
+/* LAZY_ADAPTER_LOAD bits of gps.conf: the library is loaded on the
+   first request of its kind instead of when a client registers */
+#define LAZY_ADAPTER_LOAD_BATCHING (1<<0)
+#define LAZY_ADAPTER_LOAD_GEOFENCE (1<<1)
+
 template <typename T1, typename T2>
 static const T1* loadLocationInterface(const char* library, const char* name) {
     void* libhandle = nullptr;
@@ -90,6 +99,120 @@ static const T1* loadLocationInterface(const char* library, const char* name) {
     }
 }
 
+static uint32_t getLazyAdapterLoad() {
+    static const uint32_t lazyAdapterLoad = []() {
+        uint32_t lazyAdapterLoad = 0;
+        const loc_param_s_type gpsConfTable[] =
+        {
+            {"LAZY_ADAPTER_LOAD", &lazyAdapterLoad, nullptr, 'n'},
+        };
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, gpsConfTable);
+        return lazyAdapterLoad;
+    }();
+    return lazyAdapterLoad;
+}
+
+static bool isBatchingClient(LocationCallbacks& locationCallbacks);
+static bool isGeofenceClient(LocationCallbacks& locationCallbacks);
+
+/* called with gDataMutex held; an interface is only published once it
+   is initialized, since the per-call paths read it without the lock */
+static GnssInterface* loadGnssInterface() {
+    GnssInterface* gnssInterface = gData.gnssInterface.load(std::memory_order_relaxed);
+    if (NULL == gnssInterface && !gGnssLoadFailed) {
+        gnssInterface =
+            (GnssInterface*)loadLocationInterface<GnssInterface,
+                getGnssInterface>("libgnss.so", "getGnssInterface");
+        if (NULL == gnssInterface) {
+            gGnssLoadFailed = true;
+            LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
+        } else {
+            gnssInterface->initialize();
+            gData.gnssInterface.store(gnssInterface, std::memory_order_release);
+        }
+    }
+    return gnssInterface;
+}
+
+/* called with gDataMutex held; the clients that registered while the
+   library was left unloaded are added to the new adapter */
+static BatchingInterface* loadBatchingInterface() {
+    BatchingInterface* batchingInterface =
+            gData.batchingInterface.load(std::memory_order_relaxed);
+    if (NULL == batchingInterface && !gBatchingLoadFailed) {
+        batchingInterface =
+            (BatchingInterface*)loadLocationInterface<BatchingInterface,
+             getBatchingInterface>("libbatching.so", "getBatchingInterface");
+        if (NULL == batchingInterface) {
+            gBatchingLoadFailed = true;
+            LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
+        } else {
+            batchingInterface->initialize();
+            for (auto& client : gData.clientData) {
+                if (isBatchingClient(client.second)) {
+                    batchingInterface->addClient(client.first, client.second);
+                    batchingInterface->requestCapabilities(client.first);
+                }
+            }
+            gData.batchingInterface.store(batchingInterface, std::memory_order_release);
+        }
+    }
+    return batchingInterface;
+}
+
+static GeofenceInterface* loadGeofenceInterface() {
+    GeofenceInterface* geofenceInterface =
+            gData.geofenceInterface.load(std::memory_order_relaxed);
+    if (NULL == geofenceInterface && !gGeofenceLoadFailed) {
+        geofenceInterface =
+            (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
+             getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
+        if (NULL == geofenceInterface) {
+            gGeofenceLoadFailed = true;
+            LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
+        } else {
+            geofenceInterface->initialize();
+            for (auto& client : gData.clientData) {
+                if (isGeofenceClient(client.second)) {
+                    geofenceInterface->addClient(client.first, client.second);
+                    geofenceInterface->requestCapabilities(client.first);
+                }
+            }
+            gData.geofenceInterface.store(geofenceInterface, std::memory_order_release);
+        }
+    }
+    return geofenceInterface;
+}
+
+/* lock free, for the per-call paths */
+static inline GnssInterface* publishedGnssInterface() {
+    return gData.gnssInterface.load(std::memory_order_acquire);
+}
+
+/* the interface for a batching or geofence request; gDataMutex is only
+   taken when it was left for the first request and is not loaded yet */
+static BatchingInterface* getBatchingInterfaceForRequest() {
+    BatchingInterface* batchingInterface =
+            gData.batchingInterface.load(std::memory_order_acquire);
+    if (NULL == batchingInterface && (getLazyAdapterLoad() & LAZY_ADAPTER_LOAD_BATCHING)) {
+        pthread_mutex_lock(&gDataMutex);
+        batchingInterface = loadBatchingInterface();
+        pthread_mutex_unlock(&gDataMutex);
+    }
+    return batchingInterface;
+}
+
+static GeofenceInterface* getGeofenceInterfaceForRequest() {
+    GeofenceInterface* geofenceInterface =
+            gData.geofenceInterface.load(std::memory_order_acquire);
+    if (NULL == geofenceInterface && (getLazyAdapterLoad() & LAZY_ADAPTER_LOAD_GEOFENCE)) {
+        pthread_mutex_lock(&gDataMutex);
+        geofenceInterface = loadGeofenceInterface();
+        pthread_mutex_unlock(&gDataMutex);
+    }
+    return geofenceInterface;
+}
+
 static void createOSFrameworkInstance() {
     void* libHandle = nullptr;
     createOSFramework* getter = (createOSFramework*)dlGetSymFromLib(libHandle,
@@ -210,69 +333,42 @@ LocationAPI::createInstance (LocationCallbacks& locationCallbacks)
     }
 
     if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            gData.gnssInterface->addClient(newLocationAPI, locationCallbacks);
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
+            gnssInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.gnssInterface->requestCapabilities(newLocationAPI);
+                gnssInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
-            gData.batchingInterface->addClient(newLocationAPI, locationCallbacks);
+        BatchingInterface* batchingInterface = (getLazyAdapterLoad() & LAZY_ADAPTER_LOAD_BATCHING) ?
+                gData.batchingInterface.load(std::memory_order_relaxed) : loadBatchingInterface();
+        if (NULL != batchingInterface) {
+            batchingInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.batchingInterface->requestCapabilities(newLocationAPI);
+                batchingInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-               (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-               getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
-            gData.geofenceInterface->addClient(newLocationAPI, locationCallbacks);
+        GeofenceInterface* geofenceInterface = (getLazyAdapterLoad() & LAZY_ADAPTER_LOAD_GEOFENCE) ?
+                gData.geofenceInterface.load(std::memory_order_relaxed) : loadGeofenceInterface();
+        if (NULL != geofenceInterface) {
+            geofenceInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.geofenceInterface->requestCapabilities(newLocationAPI);
+                geofenceInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     gData.clientData[newLocationAPI] = locationCallbacks;
+    newLocationAPI->mRegistered.store(true, std::memory_order_release);
 
     pthread_mutex_unlock(&gDataMutex);
 
@@ -287,9 +383,14 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
     pthread_mutex_lock(&gDataMutex);
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
-        bool removeFromGnssInf = (NULL != gData.gnssInterface);
-        bool removeFromBatchingInf = (NULL != gData.batchingInterface);
-        bool removeFromGeofenceInf = (NULL != gData.geofenceInterface);
+        GnssInterface* gnssInterface = gData.gnssInterface.load(std::memory_order_relaxed);
+        BatchingInterface* batchingInterface =
+                gData.batchingInterface.load(std::memory_order_relaxed);
+        GeofenceInterface* geofenceInterface =
+                gData.geofenceInterface.load(std::memory_order_relaxed);
+        bool removeFromGnssInf = (NULL != gnssInterface);
+        bool removeFromBatchingInf = (NULL != batchingInterface);
+        bool removeFromGeofenceInf = (NULL != geofenceInterface);
         bool needToWait = (removeFromGnssInf || removeFromBatchingInf || removeFromGeofenceInf);
         LOC_LOGe("removeFromGnssInf: %d, removeFromBatchingInf: %d, removeFromGeofenceInf: %d,"
                  "needToWait: %d", removeFromGnssInf, removeFromBatchingInf, removeFromGeofenceInf,
@@ -312,18 +413,19 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
         }
 
         if (removeFromGnssInf) {
-            gData.gnssInterface->removeClient(it->first,
-                                              onGnssRemoveClientCompleteCb);
+            gnssInterface->removeClient(it->first,
+                                       onGnssRemoveClientCompleteCb);
         }
         if (removeFromBatchingInf) {
-            gData.batchingInterface->removeClient(it->first,
-                                             onBatchingRemoveClientCompleteCb);
+            batchingInterface->removeClient(it->first,
+                                            onBatchingRemoveClientCompleteCb);
         }
         if (removeFromGeofenceInf) {
-            gData.geofenceInterface->removeClient(it->first,
-                                                  onGeofenceRemoveClientCompleteCb);
+            geofenceInterface->removeClient(it->first,
+                                            onGeofenceRemoveClientCompleteCb);
         }
 
+        mRegistered.store(false, std::memory_order_release);
         gData.clientData.erase(it);
 
         if (!needToWait) {
@@ -348,7 +450,7 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
     }
 }
 
-LocationAPI::LocationAPI()
+LocationAPI::LocationAPI() : mRegistered(false)
 {
     LOC_LOGD("LOCATION API CONSTRUCTOR");
 }
@@ -371,56 +473,28 @@ LocationAPI::updateCallbacks(LocationCallbacks& locationCallbacks)
     pthread_mutex_lock(&gDataMutex);
 
     if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
             // either adds new Client or updates existing Client
-            gData.gnssInterface->addClient(this, locationCallbacks);
+            gnssInterface->addClient(this, locationCallbacks);
         }
     }
 
     if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
+        BatchingInterface* batchingInterface = (getLazyAdapterLoad() & LAZY_ADAPTER_LOAD_BATCHING) ?
+                gData.batchingInterface.load(std::memory_order_relaxed) : loadBatchingInterface();
+        if (NULL != batchingInterface) {
             // either adds new Client or updates existing Client
-            gData.batchingInterface->addClient(this, locationCallbacks);
+            batchingInterface->addClient(this, locationCallbacks);
         }
     }
 
     if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-                (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-                 getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
+        GeofenceInterface* geofenceInterface = (getLazyAdapterLoad() & LAZY_ADAPTER_LOAD_GEOFENCE) ?
+                gData.geofenceInterface.load(std::memory_order_relaxed) : loadGeofenceInterface();
+        if (NULL != geofenceInterface) {
             // either adds new Client or updates existing Client
-            gData.geofenceInterface->addClient(this, locationCallbacks);
+            geofenceInterface->addClient(this, locationCallbacks);
         }
     }
 
@@ -433,12 +507,11 @@ uint32_t
 LocationAPI::startTracking(TrackingOptions& trackingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
-        if (NULL != gData.gnssInterface) {
-            id = gData.gnssInterface->startTracking(this, trackingOptions);
+    if (mRegistered.load(std::memory_order_acquire)) {
+        if (NULL != gnssInterface) {
+            id = gnssInterface->startTracking(this, trackingOptions);
         } else {
             LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -448,19 +521,17 @@ LocationAPI::startTracking(TrackingOptions& trackingOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationAPI::stopTracking(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
-        if (gData.gnssInterface != NULL) {
-            gData.gnssInterface->stopTracking(this, id);
+    if (mRegistered.load(std::memory_order_acquire)) {
+        if (gnssInterface != NULL) {
+            gnssInterface->stopTracking(this, id);
         } else {
             LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -469,20 +540,17 @@ LocationAPI::stopTracking(uint32_t id)
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::updateTrackingOptions(
         uint32_t id, TrackingOptions& trackingOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
-        if (gData.gnssInterface != NULL) {
-            gData.gnssInterface->updateTrackingOptions(this, id, trackingOptions);
+    if (mRegistered.load(std::memory_order_acquire)) {
+        if (gnssInterface != NULL) {
+            gnssInterface->updateTrackingOptions(this, id, trackingOptions);
         } else {
             LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -491,162 +559,151 @@ LocationAPI::updateTrackingOptions(
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
     }
+}
 
-    pthread_mutex_unlock(&gDataMutex);
+void
+LocationAPI::setSvFilter(const GnssSvFilter& filter)
+{
+    GnssInterface* gnssInterface = publishedGnssInterface();
+
+    if (mRegistered.load(std::memory_order_acquire)) {
+        if (gnssInterface != NULL) {
+            gnssInterface->setSvFilter(this, filter);
+        } else {
+            LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
+                     __func__, __LINE__, this);
+        }
+    } else {
+        LOC_LOGE("%s:%d]: Location API client %p not found in client data",
+                 __func__, __LINE__, this);
+    }
 }
 
 uint32_t
 LocationAPI::startBatching(BatchingOptions &batchingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
-    if (NULL != gData.batchingInterface) {
-        id = gData.batchingInterface->startBatching(this, batchingOptions);
+    BatchingInterface* batchingInterface = getBatchingInterfaceForRequest();
+    if (NULL != batchingInterface) {
+        id = batchingInterface->startBatching(this, batchingOptions);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationAPI::stopBatching(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (NULL != gData.batchingInterface) {
-        gData.batchingInterface->stopBatching(this, id);
+    BatchingInterface* batchingInterface = getBatchingInterfaceForRequest();
+    if (NULL != batchingInterface) {
+        batchingInterface->stopBatching(this, id);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::updateBatchingOptions(uint32_t id, BatchingOptions& batchOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (NULL != gData.batchingInterface) {
-        gData.batchingInterface->updateBatchingOptions(this, id, batchOptions);
+    BatchingInterface* batchingInterface = getBatchingInterfaceForRequest();
+    if (NULL != batchingInterface) {
+        batchingInterface->updateBatchingOptions(this, id, batchOptions);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::getBatchedLocations(uint32_t id, size_t count)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (gData.batchingInterface != NULL) {
-        gData.batchingInterface->getBatchedLocations(this, id, count);
+    BatchingInterface* batchingInterface = getBatchingInterfaceForRequest();
+    if (NULL != batchingInterface) {
+        batchingInterface->getBatchedLocations(this, id, count);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 uint32_t*
 LocationAPI::addGeofences(size_t count, GeofenceOption* options, GeofenceInfo* info)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
-
-    if (gData.geofenceInterface != NULL) {
-        ids = gData.geofenceInterface->addGeofences(this, count, options, info);
+    GeofenceInterface* geofenceInterface = getGeofenceInterfaceForRequest();
+    if (NULL != geofenceInterface) {
+        ids = geofenceInterface->addGeofences(this, count, options, info);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
 void
 LocationAPI::removeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->removeGeofences(this, count, ids);
+    GeofenceInterface* geofenceInterface = getGeofenceInterfaceForRequest();
+    if (NULL != geofenceInterface) {
+        geofenceInterface->removeGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* options)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->modifyGeofences(this, count, ids, options);
+    GeofenceInterface* geofenceInterface = getGeofenceInterfaceForRequest();
+    if (NULL != geofenceInterface) {
+        geofenceInterface->modifyGeofences(this, count, ids, options);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->pauseGeofences(this, count, ids);
+    GeofenceInterface* geofenceInterface = getGeofenceInterfaceForRequest();
+    if (NULL != geofenceInterface) {
+        geofenceInterface->pauseGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
-
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->resumeGeofences(this, count, ids);
+    GeofenceInterface* geofenceInterface = getGeofenceInterfaceForRequest();
+    if (NULL != geofenceInterface) {
+        geofenceInterface->resumeGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        gData.gnssInterface->gnssNiResponse(this, id, response);
+    if (gnssInterface != NULL) {
+        gnssInterface->gnssNiResponse(this, id, response);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void LocationAPI::enableNetworkProvider() {
@@ -702,21 +759,11 @@ LocationControlAPI::createInstance(LocationControlCallbacks& locationControlCall
     pthread_mutex_lock(&gDataMutex);
 
     if (nullptr != locationControlCallbacks.responseCb && NULL == gData.controlAPI) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
             gData.controlAPI = new LocationControlAPI();
             gData.controlCallbacks = locationControlCallbacks;
-            gData.gnssInterface->setControlCallbacks(locationControlCallbacks);
+            gnssInterface->setControlCallbacks(locationControlCallbacks);
             controlAPI = gData.controlAPI;
         }
     }
@@ -750,63 +797,58 @@ uint32_t
 LocationControlAPI::enable(LocationTechnologyType techType)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->enable(techType);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->enable(techType);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationControlAPI::disable(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        gData.gnssInterface->disable(id);
+    if (gnssInterface != NULL) {
+        gnssInterface->disable(id);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 uint32_t*
 LocationControlAPI::gnssUpdateConfig(const GnssConfig& config)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        ids = gData.gnssInterface->gnssUpdateConfig(config);
+    if (gnssInterface != NULL) {
+        ids = gnssInterface->gnssUpdateConfig(config);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
 uint32_t* LocationControlAPI::gnssGetConfig(GnssConfigFlagsMask mask) {
 
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (NULL != gData.gnssInterface) {
-        ids = gData.gnssInterface->gnssGetConfig(mask);
+    if (NULL != gnssInterface) {
+        ids = gnssInterface->gnssGetConfig(mask);
     } else {
         LOC_LOGe("No gnss interface available for Control API client %p", this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
@@ -814,16 +856,15 @@ uint32_t
 LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssDeleteAidingData(data);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->gnssDeleteAidingData(data);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
@@ -831,134 +872,125 @@ uint32_t LocationControlAPI::configConstellations(
         const GnssSvTypeConfig& constellationEnablementConfig,
         const GnssSvIdConfig&   blacklistSvConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssUpdateSvConfig(
+    if (gnssInterface != NULL) {
+        id = gnssInterface->gnssUpdateSvConfig(
                 constellationEnablementConfig, blacklistSvConfig);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configConstellationSecondaryBand(
         const GnssSvTypeConfig& secondaryBandConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssUpdateSecondaryBandConfig(secondaryBandConfig);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->gnssUpdateSecondaryBandConfig(secondaryBandConfig);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configConstrainedTimeUncertainty(
             bool enable, float tuncThreshold, uint32_t energyBudget) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->setConstrainedTunc(enable,
-                                                     tuncThreshold,
-                                                     energyBudget);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->setConstrainedTunc(enable,
+                                               tuncThreshold,
+                                               energyBudget);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configPositionAssistedClockEstimator(bool enable) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->setPositionAssistedClockEstimator(enable);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->setPositionAssistedClockEstimator(enable);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configLeverArm(const LeverArmConfigInfo& configInfo) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configLeverArm(configInfo);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->configLeverArm(configInfo);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configRobustLocation(bool enable, bool enableForE911) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configRobustLocation(enable, enableForE911);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->configRobustLocation(enable, enableForE911);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configMinGpsWeek(uint16_t minGpsWeek) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configMinGpsWeek(minGpsWeek);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->configMinGpsWeek(minGpsWeek);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configDeadReckoningEngineParams(
         const DeadReckoningEngineConfig& dreConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configDeadReckoningEngineParams(dreConfig);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->configDeadReckoningEngineParams(dreConfig);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 uint32_t LocationControlAPI::configEngineRunState(
         PositioningEngineMask engType, LocEngineRunState engState) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = publishedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->configEngineRunState(engType, engState);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->configEngineRunState(engType, engState);
     } else {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
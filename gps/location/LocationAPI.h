@@ -30,6 +30,7 @@
 #define LOCATIONAPI_H
 
 #include "ILocationAPI.h"
+#include <atomic>
 
 class LocationAPI : public ILocationAPI
 {
@@ -37,6 +38,10 @@ private:
     LocationAPI();
     ~LocationAPI();
 
+    // between createInstance and destroy; lets the per-call methods check
+    // the client without taking the lock on the client table
+    std::atomic<bool> mRegistered;
+
 public:
     /* creates an instance to LocationAPI object.
        Will return NULL if mandatory parameters are invalid or if the maximum number
@@ -85,6 +90,10 @@ public:
                 LOCATION_ERROR_ID_UNKNOWN if id is not associated with a tracking session */
     virtual void updateTrackingOptions(uint32_t id, TrackingOptions&) override;
 
+    /* setSvFilter limits the SVs of gnssSvCallback to the ones passing filter, which
+       shortens the notifications of clients that only show a few of them */
+    void setSvFilter(const GnssSvFilter& filter);
+
     /* ================================== BATCHING ================================== */
 
     /* startBatching starts a batching session, which returns a session id that will be
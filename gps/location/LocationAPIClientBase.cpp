@@ -656,6 +656,7 @@ uint32_t LocationAPIClientBase::locAPIAddGeofences(
             LOC_LOGI("%s:%d] start new sessions: %p", __FUNCTION__, __LINE__, sessions);
             mRequestQueues[REQUEST_GEOFENCE].push(new AddGeofencesRequest(*this));
 
+            mGeofenceBiDict.reserve(mGeofenceBiDict.size() + count);
             for (size_t i = 0; i < count; i++) {
                 mGeofenceBiDict.set(ids[i], sessions[i], options[i].breachTypeMask);
             }
@@ -671,23 +672,19 @@ void LocationAPIClientBase::locAPIRemoveGeofences(size_t count, uint32_t* ids)
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
-        }
+        // mGeofenceSessions is only touched under mMutex and keeps its capacity
+        mGeofenceSessions.resize(count);
+        uint32_t* sessions = mGeofenceSessions.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             BiDict<GeofenceBreachTypeMask>* removedGeofenceBiDict =
                     new BiDict<GeofenceBreachTypeMask>();
+            removedGeofenceBiDict->reserve(count);
             size_t j = 0;
             for (size_t i = 0; i < count; i++) {
-                sessions[j] = mGeofenceBiDict.getSession(ids[i]);
+                GeofenceBreachTypeMask type;
+                sessions[j] = mGeofenceBiDict.takeById(ids[i], type);
                 if (sessions[j] > 0) {
-                    GeofenceBreachTypeMask type = mGeofenceBiDict.getExtBySession(sessions[j]);
-                    mGeofenceBiDict.rmBySession(sessions[j]);
                     removedGeofenceBiDict->set(ids[i], sessions[j], type);
                     j++;
                 }
@@ -703,8 +700,6 @@ void LocationAPIClientBase::locAPIRemoveGeofences(size_t count, uint32_t* ids)
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -714,13 +709,9 @@ void LocationAPIClientBase::locAPIModifyGeofences(
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
-        }
+        // mGeofenceSessions is only touched under mMutex and keeps its capacity
+        mGeofenceSessions.resize(count);
+        uint32_t* sessions = mGeofenceSessions.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
@@ -739,8 +730,6 @@ void LocationAPIClientBase::locAPIModifyGeofences(
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -749,13 +738,9 @@ void LocationAPIClientBase::locAPIPauseGeofences(size_t count, uint32_t* ids)
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
-        }
+        // mGeofenceSessions is only touched under mMutex and keeps its capacity
+        mGeofenceSessions.resize(count);
+        uint32_t* sessions = mGeofenceSessions.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
@@ -773,8 +758,6 @@ void LocationAPIClientBase::locAPIPauseGeofences(size_t count, uint32_t* ids)
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -784,13 +767,9 @@ void LocationAPIClientBase::locAPIResumeGeofences(
 {
     pthread_mutex_lock(&mMutex);
     if (mLocationAPI) {
-        uint32_t* sessions = (uint32_t*)malloc(sizeof(uint32_t) * count);
-        if (sessions == NULL) {
-            LOC_LOGE("%s:%d] Failed to allocate %zu bytes !",
-                    __FUNCTION__, __LINE__, sizeof(uint32_t) * count);
-            pthread_mutex_unlock(&mMutex);
-            return;
-        }
+        // mGeofenceSessions is only touched under mMutex and keeps its capacity
+        mGeofenceSessions.resize(count);
+        uint32_t* sessions = mGeofenceSessions.data();
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
@@ -811,8 +790,6 @@ void LocationAPIClientBase::locAPIResumeGeofences(
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__,
                     mRequestQueues[REQUEST_GEOFENCE].getSession());
         }
-
-        free(sessions);
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -857,9 +834,8 @@ void LocationAPIClientBase::beforeGeofenceBreachCb(
     if (mGeofenceBreachCallback != nullptr) {
         size_t count = 0;
         for (size_t i = 0; i < n; i++) {
-            uint32_t id = mGeofenceBiDict.getId(geofenceBreachNotification.ids[i]);
-            GeofenceBreachTypeMask type =
-                mGeofenceBiDict.getExtBySession(geofenceBreachNotification.ids[i]);
+            GeofenceBreachTypeMask type;
+            uint32_t id = mGeofenceBiDict.getIdAndExt(geofenceBreachNotification.ids[i], type);
             // if type == 0, we will not head into the fllowing block anyway.
             // so we don't need to check id and type
             if ((geofenceBreachNotification.type == GEOFENCE_BREACH_ENTER &&
@@ -33,7 +33,8 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <queue>
-#include <map>
+#include <vector>
+#include <algorithm>
 
 #include "LocationAPI.h"
 #include <loc_pla.h>
@@ -204,7 +205,7 @@ public:
     LocationAPIClientBase& operator=(const LocationAPIClientBase&) = delete;
 
     void destroy();
-    void onLocationApiDestroyCompleteCb();
+    virtual void onLocationApiDestroyCompleteCb();
 
     void locAPISetCallbacks(LocationCallbacks& locationCallbacks);
     void removeSession(uint32_t session);
@@ -297,10 +298,14 @@ private:
         uint32_t sessionMode;
     } SessionEntity;
 
+    // Two-way id<->session dictionary with an ext value per session. Entries
+    // live in one dense array, and id and session each index it through an
+    // open-addressing table (linear probing, backward-shift deletion), so
+    // lookups are O(1) and nothing is allocated per entry once reserve()d.
     template<typename T>
     class BiDict {
     public:
-        BiDict() {
+        BiDict() : mMask(0) {
             pthread_mutex_init(&mBiDictMutex, nullptr);
         }
         virtual ~BiDict() {
@@ -308,50 +313,106 @@ private:
         }
         bool hasId(uint32_t id) {
             pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mForwardMap.find(id) != mForwardMap.end());
+            bool ret = (find(mByIdIndex, id, false) != NOT_FOUND);
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
         bool hasSession(uint32_t session) {
             pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mBackwardMap.find(session) != mBackwardMap.end());
+            bool ret = (find(mBySessionIndex, session, true) != NOT_FOUND);
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
+        size_t size() {
+            pthread_mutex_lock(&mBiDictMutex);
+            size_t ret = mEntries.size();
+            pthread_mutex_unlock(&mBiDictMutex);
+            return ret;
+        }
+        // make room for count entries in total, so that many set() calls
+        // in a row do not rehash on the way
+        void reserve(size_t count) {
+            pthread_mutex_lock(&mBiDictMutex);
+            grow(count);
+            pthread_mutex_unlock(&mBiDictMutex);
+        }
         void set(uint32_t id, uint32_t session, T& ext) {
             pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap[id] = session;
-            mBackwardMap[session] = id;
-            mExtMap[session] = ext;
+            uint32_t entry = find(mByIdIndex, id, false);
+            if (entry != NOT_FOUND && mEntries[entry].session == session) {
+                mEntries[entry].ext = ext;
+            } else {
+                // neither the id nor the session may keep a stale mapping
+                if (entry != NOT_FOUND) {
+                    erase(entry);
+                }
+                entry = find(mBySessionIndex, session, true);
+                if (entry != NOT_FOUND) {
+                    erase(entry);
+                }
+                grow(mEntries.size() + 1);
+                Entry newEntry = {id, session, ext};
+                mEntries.push_back(newEntry);
+                link(mByIdIndex, id, mEntries.size());
+                link(mBySessionIndex, session, mEntries.size());
+            }
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void clear() {
             pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap.clear();
-            mBackwardMap.clear();
-            mExtMap.clear();
+            mEntries.clear();
+            std::fill(mByIdIndex.begin(), mByIdIndex.end(), 0);
+            std::fill(mBySessionIndex.begin(), mBySessionIndex.end(), 0);
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void rmById(uint32_t id) {
             pthread_mutex_lock(&mBiDictMutex);
-            mBackwardMap.erase(mForwardMap[id]);
-            mExtMap.erase(mForwardMap[id]);
-            mForwardMap.erase(id);
+            uint32_t entry = find(mByIdIndex, id, false);
+            if (entry != NOT_FOUND) {
+                erase(entry);
+            }
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void rmBySession(uint32_t session) {
             pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap.erase(mBackwardMap[session]);
-            mBackwardMap.erase(session);
-            mExtMap.erase(session);
+            uint32_t entry = find(mBySessionIndex, session, true);
+            if (entry != NOT_FOUND) {
+                erase(entry);
+            }
             pthread_mutex_unlock(&mBiDictMutex);
         }
+        // remove id and return its session and ext, 0 if id is not there
+        uint32_t takeById(uint32_t id, T& ext) {
+            pthread_mutex_lock(&mBiDictMutex);
+            uint32_t ret = 0;
+            uint32_t entry = find(mByIdIndex, id, false);
+            if (entry != NOT_FOUND) {
+                ret = mEntries[entry].session;
+                ext = mEntries[entry].ext;
+                erase(entry);
+            }
+            pthread_mutex_unlock(&mBiDictMutex);
+            return ret;
+        }
         uint32_t getId(uint32_t session) {
             pthread_mutex_lock(&mBiDictMutex);
             uint32_t ret = 0;
-            auto it = mBackwardMap.find(session);
-            if (it != mBackwardMap.end()) {
-                ret = it->second;
+            uint32_t entry = find(mBySessionIndex, session, true);
+            if (entry != NOT_FOUND) {
+                ret = mEntries[entry].id;
+            }
+            pthread_mutex_unlock(&mBiDictMutex);
+            return ret;
+        }
+        // id and ext of session in one lookup, ext is zeroed if not there
+        uint32_t getIdAndExt(uint32_t session, T& ext) {
+            pthread_mutex_lock(&mBiDictMutex);
+            uint32_t ret = 0;
+            memset(&ext, 0, sizeof(T));
+            uint32_t entry = find(mBySessionIndex, session, true);
+            if (entry != NOT_FOUND) {
+                ret = mEntries[entry].id;
+                ext = mEntries[entry].ext;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -359,9 +420,9 @@ private:
         uint32_t getSession(uint32_t id) {
             pthread_mutex_lock(&mBiDictMutex);
             uint32_t ret = 0;
-            auto it = mForwardMap.find(id);
-            if (it != mForwardMap.end()) {
-                ret = it->second;
+            uint32_t entry = find(mByIdIndex, id, false);
+            if (entry != NOT_FOUND) {
+                ret = mEntries[entry].session;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -370,12 +431,9 @@ private:
             pthread_mutex_lock(&mBiDictMutex);
             T ret;
             memset(&ret, 0, sizeof(T));
-            uint32_t session = mForwardMap[id];
-            if (session > 0) {
-                auto it = mExtMap.find(session);
-                if (it != mExtMap.end()) {
-                    ret = it->second;
-                }
+            uint32_t entry = find(mByIdIndex, id, false);
+            if (entry != NOT_FOUND) {
+                ret = mEntries[entry].ext;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -384,9 +442,9 @@ private:
             pthread_mutex_lock(&mBiDictMutex);
             T ret;
             memset(&ret, 0, sizeof(T));
-            auto it = mExtMap.find(session);
-            if (it != mExtMap.end()) {
-                ret = it->second;
+            uint32_t entry = find(mBySessionIndex, session, true);
+            if (entry != NOT_FOUND) {
+                ret = mEntries[entry].ext;
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
@@ -394,20 +452,109 @@ private:
         std::vector<uint32_t> getAllSessions() {
             std::vector<uint32_t> ret;
             pthread_mutex_lock(&mBiDictMutex);
-            for (auto it = mBackwardMap.begin(); it != mBackwardMap.end(); it++) {
-                ret.push_back(it->first);
+            ret.reserve(mEntries.size());
+            for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+                ret.push_back(it->session);
             }
             pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
     private:
+        static const uint32_t NOT_FOUND = UINT32_MAX;
+        static const size_t MIN_INDEX_SIZE = 16;
+        typedef struct {
+            uint32_t id;
+            uint32_t session;
+            T ext;
+        } Entry;
+
+        inline uint32_t keyOf(uint32_t entry, bool bySession) const {
+            return bySession ? mEntries[entry].session : mEntries[entry].id;
+        }
+        inline uint32_t home(uint32_t key) const {
+            uint32_t hash = key * 2654435769u;
+            return (hash ^ (hash >> 16)) & mMask;
+        }
+        // index slots hold entry + 1, so that 0 marks an empty slot
+        uint32_t find(const std::vector<uint32_t>& index, uint32_t key, bool bySession) const {
+            if (index.empty()) {
+                return NOT_FOUND;
+            }
+            for (uint32_t slot = home(key); index[slot] != 0; slot = (slot + 1) & mMask) {
+                if (keyOf(index[slot] - 1, bySession) == key) {
+                    return index[slot] - 1;
+                }
+            }
+            return NOT_FOUND;
+        }
+        void link(std::vector<uint32_t>& index, uint32_t key, uint32_t value) {
+            uint32_t slot = home(key);
+            while (index[slot] != 0) {
+                slot = (slot + 1) & mMask;
+            }
+            index[slot] = value;
+        }
+        uint32_t slotOf(const std::vector<uint32_t>& index, uint32_t key, uint32_t value) const {
+            uint32_t slot = home(key);
+            while (index[slot] != value) {
+                slot = (slot + 1) & mMask;
+            }
+            return slot;
+        }
+        void unlink(std::vector<uint32_t>& index, uint32_t key, uint32_t value, bool bySession) {
+            uint32_t hole = slotOf(index, key, value);
+            for (uint32_t slot = (hole + 1) & mMask; index[slot] != 0; slot = (slot + 1) & mMask) {
+                // pull back any entry whose probe run passes through the hole
+                uint32_t from = home(keyOf(index[slot] - 1, bySession));
+                if (((slot - from) & mMask) >= ((slot - hole) & mMask)) {
+                    index[hole] = index[slot];
+                    hole = slot;
+                }
+            }
+            index[hole] = 0;
+        }
+        // remove an entry and move the last one into its place
+        void erase(uint32_t entry) {
+            uint32_t last = mEntries.size() - 1;
+            unlink(mByIdIndex, mEntries[entry].id, entry + 1, false);
+            unlink(mBySessionIndex, mEntries[entry].session, entry + 1, true);
+            if (entry != last) {
+                mByIdIndex[slotOf(mByIdIndex, mEntries[last].id, last + 1)] = entry + 1;
+                mBySessionIndex[slotOf(mBySessionIndex, mEntries[last].session, last + 1)] =
+                        entry + 1;
+                mEntries[entry] = mEntries[last];
+            }
+            mEntries.pop_back();
+        }
+        // keep the tables at most half full
+        void grow(size_t count) {
+            size_t size = mByIdIndex.size();
+            if (count * 2 <= size) {
+                return;
+            }
+            if (size < MIN_INDEX_SIZE) {
+                size = MIN_INDEX_SIZE;
+            }
+            while (size < count * 2) {
+                size *= 2;
+            }
+            mEntries.reserve(count);
+            mByIdIndex.assign(size, 0);
+            mBySessionIndex.assign(size, 0);
+            mMask = size - 1;
+            for (uint32_t i = 0; i < mEntries.size(); i++) {
+                link(mByIdIndex, mEntries[i].id, i + 1);
+                link(mBySessionIndex, mEntries[i].session, i + 1);
+            }
+        }
+
         pthread_mutex_t mBiDictMutex;
-        // mForwarMap mapping id->session
-        std::map<uint32_t, uint32_t> mForwardMap;
-        // mBackwardMap mapping session->id
-        std::map<uint32_t, uint32_t> mBackwardMap;
-        // mExtMap mapping session->ext
-        std::map<uint32_t, T> mExtMap;
+        std::vector<Entry> mEntries;
+        // mByIdIndex mapping id->entry
+        std::vector<uint32_t> mByIdIndex;
+        // mBySessionIndex mapping session->entry
+        std::vector<uint32_t> mBySessionIndex;
+        uint32_t mMask;
     };
 
     class StartTrackingRequest : public LocationAPIRequest {
@@ -585,6 +732,8 @@ private:
     RequestQueue mRequestQueues[REQUEST_MAX];
     BiDict<GeofenceBreachTypeMask> mGeofenceBiDict;
     BiDict<SessionEntity> mSessionBiDict;
+    // session ids handed to LocationAPI by the geofence calls, reused across calls
+    std::vector<uint32_t> mGeofenceSessions;
     int32_t mBatchSize;
     bool mTracking;
 };
@@ -1569,6 +1569,16 @@ typedef enum {
     (GNSS_SV_TYPES_MASK_GPS_BIT|GNSS_SV_TYPES_MASK_GLO_BIT|GNSS_SV_TYPES_MASK_BDS_BIT|\
      GNSS_SV_TYPES_MASK_QZSS_BIT|GNSS_SV_TYPES_MASK_GAL_BIT|GNSS_SV_TYPES_MASK_NAVIC_BIT)
 
+/* SVs a client is to get in its gnssSvCallback, which then carries only
+   those. A filter of all 0 passes every SV. */
+typedef struct {
+    uint32_t size;               // set to sizeof(GnssSvFilter)
+    GnssSvTypesMask svTypesMask; // bitwise OR of GnssSvTypesMaskBits, 0 for all
+                                 // constellations; SBAS SVs only pass with 0
+    float minCN0Dbhz;            // SVs of a weaker signal are left out
+    bool usedInFixOnly;          // only SVs used in the last fix
+} GnssSvFilter;
+
 /* This SV Type config is injected directly to GNSS Adapter
  * bypassing Location API */
 struct GnssSvTypeConfig{
@@ -1663,11 +1673,20 @@ typedef struct {
     float                               serverPredictionAgeSeconds;
 } GnssDebugSatelliteInfo;
 
+// QTimer ticks of a fix at each HLOS stage of its report, 0 if not known
+typedef struct {
+    uint64_t qmiIndQtimer;      // position indication received from QMI LOC
+    uint64_t fanOutQtimer;      // handed by LocApiBase to the adapter
+    uint64_t dequeueQtimer;     // dequeued by the adapter MsgTask
+    uint64_t clientsDoneQtimer; // last client callback returned, e.g. HIDL or daemon IPC
+} GnssLatencyTrace;
+
 typedef struct {
     uint32_t size;                        // set to sizeof
     GnssDebugLocation                   mLocation;
     GnssDebugTime                       mTime;
     std::vector<GnssDebugSatelliteInfo> mSatelliteInfo;
+    std::vector<GnssLatencyTrace>       mLatencyTrace;  // oldest first
 } GnssDebugReport;
 
 typedef uint32_t LeapSecondSysInfoMask;
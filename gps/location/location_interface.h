@@ -32,6 +32,7 @@
 #include <LocationAPI.h>
 #include <gps_extended_c.h>
 #include <functional>
+#include <vector>
 
 /* Used for callback to deliver GNSS energy consumed */
 /** @fn
@@ -111,6 +112,12 @@ struct GnssInterface {
     void (*resetNetworkInfo)();
     uint32_t (*configEngineRunState)(PositioningEngineMask engType,
                                      LocEngineRunState engState);
+    void (*suspendTracking)(bool suspend);
+    // runs the commands, each calling functions of this interface, as one
+    // msg on the adapter thread, with their engine requests merged
+    void (*submitBatch)(const std::vector<std::function<void()>>& commands);
+    // SVs the client gets in its gnssSvCb from now on
+    void (*setSvFilter)(LocationAPI* client, const GnssSvFilter& filter);
 };
 
 struct BatchingInterface {
@@ -114,6 +114,7 @@ extern "C" {
 #define LOC_PATH_ANT_CORR_STR      "/etc/gnss_antenna_info.conf"
 #define LOC_PATH_SLIM_CONF_STR     "/etc/slim.conf"
 #define LOC_PATH_VPE_CONF_STR      "/etc/vpeglue.conf"
+#define LOC_PATH_CONF_CACHE_DIR    "/data/location/"
 
 #ifdef FEATURE_EXTERNAL_AP
 #define PROPERTY_VALUE_MAX 92
@@ -0,0 +1,80 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_ATRACE_H__
+#define __LOC_ATRACE_H__
+
+#include <stdint.h>
+
+// Begin/end and counter markers for systrace and perfetto, under the HAL
+// tag. They compile to nothing unless LOC_ATRACE_ENABLED is defined, and
+// while compiled in they cost a check of the enabled tags until tracing of
+// the HAL category is started.
+//
+// LOC_ATRACE_SCOPE(name) marks the rest of the enclosing block;
+// LOC_ATRACE_BEGIN/LOC_ATRACE_END pair up on the same thread;
+// LOC_ATRACE_INT(name, value) records a counter, e.g. a queue depth.
+// The names must be string literals or live until the trace is taken.
+#if defined(LOC_ATRACE_ENABLED) && !defined(USE_GLIB)
+
+#include <cutils/trace.h>
+
+namespace loc_util {
+
+class LocAtraceScope {
+public:
+    inline explicit LocAtraceScope(const char* name) {
+        atrace_begin(ATRACE_TAG_HAL, name);
+    }
+    inline ~LocAtraceScope() {
+        atrace_end(ATRACE_TAG_HAL);
+    }
+    LocAtraceScope(const LocAtraceScope&) = delete;
+    LocAtraceScope& operator=(const LocAtraceScope&) = delete;
+};
+
+} // namespace loc_util
+
+#define LOC_ATRACE_CONCAT_(a, b) a##b
+#define LOC_ATRACE_CONCAT(a, b) LOC_ATRACE_CONCAT_(a, b)
+#define LOC_ATRACE_SCOPE(name) \
+    loc_util::LocAtraceScope LOC_ATRACE_CONCAT(locAtraceScope, __LINE__)(name)
+#define LOC_ATRACE_BEGIN(name) atrace_begin(ATRACE_TAG_HAL, name)
+#define LOC_ATRACE_END() atrace_end(ATRACE_TAG_HAL)
+#define LOC_ATRACE_INT(name, value) atrace_int64(ATRACE_TAG_HAL, name, (int64_t)(value))
+
+#else
+
+#define LOC_ATRACE_SCOPE(name)
+#define LOC_ATRACE_BEGIN(name)
+#define LOC_ATRACE_END()
+#define LOC_ATRACE_INT(name, value)
+
+#endif // LOC_ATRACE_ENABLED
+
+#endif // __LOC_ATRACE_H__
@@ -0,0 +1,95 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_BUFFER_POOL_H__
+#define __LOC_BUFFER_POOL_H__
+
+#include <stddef.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace loc_util {
+
+// Pool of large report buffers handed out as std::shared_ptr. A producer
+// fills the buffer it acquired in place and shares it with the consumers;
+// when the last reference is dropped, on whichever thread, the buffer goes
+// back to the pool instead of the heap. At most maxFree idle buffers are
+// kept. Buffers are not cleared on either acquire or release.
+// The pool may be destroyed while buffers are still out.
+template <typename T>
+class LocBufferPool {
+    struct Store {
+        std::mutex mLock;
+        std::vector<T*> mFree;
+        const size_t mMaxFree;
+        inline Store(size_t maxFree) : mMaxFree(maxFree) { mFree.reserve(maxFree); }
+        inline ~Store() {
+            for (auto buf : mFree) {
+                delete buf;
+            }
+        }
+    };
+    std::shared_ptr<Store> mStore;
+
+public:
+    inline LocBufferPool(size_t maxFree = 2) : mStore(std::make_shared<Store>(maxFree)) {}
+
+    // returns nullptr if a new buffer is needed and can not be allocated
+    std::shared_ptr<T> acquire() {
+        T* buf = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(mStore->mLock);
+            if (!mStore->mFree.empty()) {
+                buf = mStore->mFree.back();
+                mStore->mFree.pop_back();
+            }
+        }
+        if (nullptr == buf) {
+            buf = new (std::nothrow) T;
+            if (nullptr == buf) {
+                return nullptr;
+            }
+        }
+
+        std::shared_ptr<Store> store(mStore);
+        return std::shared_ptr<T>(buf, [store](T* b) {
+            std::lock_guard<std::mutex> guard(store->mLock);
+            if (store->mFree.size() < store->mMaxFree) {
+                store->mFree.push_back(b);
+            } else {
+                delete b;
+            }
+        });
+    }
+};
+
+} // namespace loc_util
+
+#endif // __LOC_BUFFER_POOL_H__
@@ -0,0 +1,211 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_ConfWatcher"
+
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <loc_cfg.h>
+#include <log_util.h>
+#include <LocConfWatcher.h>
+
+namespace loc_util {
+
+class LocConfWatcherRunnable : public LocRunnable {
+    typedef std::unordered_map<std::string, std::string> Items;
+    struct WatchedFile {
+        Items mItems;
+        std::vector<LocConfWatcher::LocConfChangedCb> mCbs;
+    };
+
+    std::mutex mLock;
+    int mInotifyFd;
+    int mWakeFd;
+    // watch descriptor to the directory it watches; files are watched
+    // through their directory, so that a file replaced by a rename, as
+    // most editors and adb push do, is followed
+    std::unordered_map<int, std::string> mDirs;
+    std::unordered_map<std::string, WatchedFile> mFiles;
+
+    void onFileChanged(const std::string& path) {
+        Items items;
+        if (!loc_read_conf_items(path.c_str(), items)) {
+            // mid replace, the final rename is reported on its own
+            LOC_LOGd("%s can not be read", path.c_str());
+            return;
+        }
+
+        std::unordered_set<std::string> changedKeys;
+        std::vector<LocConfWatcher::LocConfChangedCb> cbs;
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            auto file = mFiles.find(path);
+            if (file == mFiles.end()) {
+                return;
+            }
+            Items& oldItems = file->second.mItems;
+            for (auto& item : items) {
+                auto old = oldItems.find(item.first);
+                if (old == oldItems.end() || old->second != item.second) {
+                    changedKeys.insert(item.first);
+                }
+            }
+            for (auto& old : oldItems) {
+                if (items.find(old.first) == items.end()) {
+                    changedKeys.insert(old.first);
+                }
+            }
+            oldItems.swap(items);
+            cbs = file->second.mCbs;
+        }
+
+        if (!changedKeys.empty()) {
+            LOC_LOGi("%s: %zu keys changed", path.c_str(), changedKeys.size());
+            for (auto& cb : cbs) {
+                cb(path.c_str(), changedKeys);
+            }
+        }
+    }
+
+public:
+    inline LocConfWatcherRunnable() :
+            mInotifyFd(inotify_init1(IN_CLOEXEC | IN_NONBLOCK)),
+            mWakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+        if (mInotifyFd < 0 || mWakeFd < 0) {
+            LOC_LOGe("inotify_init1 / eventfd failed, errno: %d", errno);
+        }
+    }
+    inline virtual ~LocConfWatcherRunnable() {
+        if (mInotifyFd >= 0) {
+            close(mInotifyFd);
+        }
+        if (mWakeFd >= 0) {
+            close(mWakeFd);
+        }
+    }
+    inline bool isValid() const { return mInotifyFd >= 0 && mWakeFd >= 0; }
+
+    void watch(const char* confFileName, const LocConfWatcher::LocConfChangedCb& changedCb) {
+        std::string path(confFileName);
+        Items items;
+        loc_read_conf_items(confFileName, items);
+
+        std::lock_guard<std::mutex> guard(mLock);
+        auto file = mFiles.find(path);
+        if (file == mFiles.end()) {
+            size_t slash = path.rfind('/');
+            std::string dir = (std::string::npos == slash) ? "." : path.substr(0, slash);
+            int wd = inotify_add_watch(mInotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0) {
+                LOC_LOGe("can not watch %s, errno: %d", dir.c_str(), errno);
+                return;
+            }
+            mDirs[wd] = dir;
+            file = mFiles.emplace(path, WatchedFile()).first;
+            file->second.mItems.swap(items);
+            LOC_LOGd("watching %s", confFileName);
+        }
+        file->second.mCbs.push_back(changedCb);
+    }
+
+    virtual bool run() override {
+        struct pollfd fds[2] = {{mInotifyFd, POLLIN, 0}, {mWakeFd, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            return (EINTR == errno);
+        }
+        if (fds[1].revents) {
+            return false;
+        }
+
+        char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        std::unordered_set<std::string> paths;
+        ssize_t len;
+        while ((len = read(mInotifyFd, buf, sizeof(buf))) > 0) {
+            std::lock_guard<std::mutex> guard(mLock);
+            for (char* p = buf; p < buf + len;
+                    p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+                const struct inotify_event* event = (const struct inotify_event*)p;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // events lost, look at every file
+                    for (auto& file : mFiles) {
+                        paths.insert(file.first);
+                    }
+                    continue;
+                }
+                auto dir = mDirs.find(event->wd);
+                if (dir == mDirs.end() || 0 == event->len) {
+                    continue;
+                }
+                std::string path = dir->second + "/" + event->name;
+                if (mFiles.find(path) != mFiles.end()) {
+                    paths.insert(path);
+                }
+            }
+        }
+        for (auto& path : paths) {
+            onFileChanged(path);
+        }
+        return true;
+    }
+
+    virtual void interrupt() override {
+        uint64_t one = 1;
+        if (write(mWakeFd, &one, sizeof(one)) < 0) {
+            LOC_LOGe("failed to wake up, errno: %d", errno);
+        }
+    }
+};
+
+LocConfWatcher& LocConfWatcher::getInstance() {
+    static LocConfWatcher sInstance;
+    return sInstance;
+}
+
+LocConfWatcher::LocConfWatcher() :
+        mRunnable(std::make_shared<LocConfWatcherRunnable>()) {
+    if (mRunnable->isValid()) {
+        mThread.start("LocConfWatcher", mRunnable);
+    }
+}
+
+void LocConfWatcher::watch(const char* confFileName, LocConfChangedCb changedCb) {
+    if (nullptr == confFileName || nullptr == changedCb || !mRunnable->isValid()) {
+        return;
+    }
+    mRunnable->watch(confFileName, changedCb);
+}
+
+} // namespace loc_util
@@ -0,0 +1,71 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_CONF_WATCHER_H__
+#define __LOC_CONF_WATCHER_H__
+
+#include <string>
+#include <functional>
+#include <unordered_set>
+#include <LocThread.h>
+
+namespace loc_util {
+
+class LocConfWatcherRunnable;
+
+// Watches config files for changes, e.g. an edited gps.conf being pushed,
+// and tells its clients which keys of a file changed. A key counts as
+// changed if its value changed, or if it was added or removed.
+// There is one watcher, and one watching thread, per process; the callbacks
+// are called in the context of that thread, and are to post the work to
+// their own thread before looking at the new values.
+class LocConfWatcher {
+public:
+    typedef std::function<void(const char* confFileName,
+                               const std::unordered_set<std::string>& changedKeys)>
+            LocConfChangedCb;
+
+    static LocConfWatcher& getInstance();
+
+    // starts watching confFileName, if not already, and calls changedCb when
+    // any of its keys changes. The items of the file at this point are the
+    // ones changes are reported against.
+    void watch(const char* confFileName, LocConfChangedCb changedCb);
+
+private:
+    LocConfWatcher();
+    LocConfWatcher(const LocConfWatcher&) = delete;
+    LocConfWatcher& operator=(const LocConfWatcher&) = delete;
+
+    LocThread mThread;
+    std::shared_ptr<LocConfWatcherRunnable> mRunnable;
+};
+
+} // namespace loc_util
+
+#endif // __LOC_CONF_WATCHER_H__
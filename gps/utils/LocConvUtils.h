@@ -0,0 +1,75 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_CONV_UTILS_H__
+#define __LOC_CONV_UTILS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace loc_util {
+
+// Conversion kernels shared by the LocApi backends and the adapters, so
+// that the reports from every engine are converted by the same code.
+
+// Number of SVs set in an SV used mask, counting only the first
+// totalSvCnt SVs of the constellation.
+inline uint16_t countSvUsedInMask(uint64_t svUsedIdsMask, int totalSvCnt) {
+    if (totalSvCnt <= 0) {
+        return 0;
+    }
+    if (totalSvCnt < 64) {
+        svUsedIdsMask &= (1ULL << totalSvCnt) - 1;
+    }
+    return (uint16_t)__builtin_popcountll(svUsedIdsMask);
+}
+
+// One bit of a mask conversion table: "from" set in the source mask
+// sets "to" in the converted mask.
+template <typename FROM, typename TO>
+struct LocMaskBitMap {
+    FROM from;
+    TO to;
+};
+
+// Converts a mask with a table of LocMaskBitMap. There is no branch per
+// bit, each entry turns into an all ones or all zeros term, so the loop
+// over a constant table is unrolled by the compiler.
+template <typename TO, typename FROM, size_t N>
+inline TO convertMaskBits(FROM mask, const LocMaskBitMap<FROM, TO> (&table)[N],
+                          TO initial = 0) {
+    TO converted = initial;
+    for (size_t i = 0; i < N; i++) {
+        converted |= table[i].to & (TO)(0 - (TO)(0 != (mask & table[i].from)));
+    }
+    return converted;
+}
+
+} // namespace loc_util
+
+#endif // __LOC_CONV_UTILS_H__
@@ -0,0 +1,121 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_FLAT_MAP_H__
+#define __LOC_FLAT_MAP_H__
+
+#include <stddef.h>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace loc_util {
+
+// An ordered map kept as a sorted vector, for the small tables (clients,
+// sessions) walked on every report. Lookups are binary searches and
+// iteration is a linear scan of contiguous memory. Insert and erase move
+// the tail, and, unlike std::map, invalidate iterators and references to
+// the elements at and after the insert or erase position.
+// Keys are not const here, they must not be modified through an iterator.
+template <typename KEY, typename VAL, typename COMPARE = std::less<KEY>>
+class LocFlatMap {
+public:
+    typedef std::pair<KEY, VAL> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+private:
+    std::vector<value_type> mElements;
+
+    struct KeyLess {
+        inline bool operator()(const value_type& element, const KEY& key) const {
+            return COMPARE()(element.first, key);
+        }
+    };
+    inline iterator lowerBound(const KEY& key) {
+        return std::lower_bound(mElements.begin(), mElements.end(), key, KeyLess());
+    }
+    inline const_iterator lowerBound(const KEY& key) const {
+        return std::lower_bound(mElements.begin(), mElements.end(), key, KeyLess());
+    }
+    inline bool isKey(const_iterator it, const KEY& key) const {
+        return it != mElements.end() && !COMPARE()(key, it->first);
+    }
+
+public:
+    inline iterator begin() { return mElements.begin(); }
+    inline iterator end() { return mElements.end(); }
+    inline const_iterator begin() const { return mElements.begin(); }
+    inline const_iterator end() const { return mElements.end(); }
+    inline bool empty() const { return mElements.empty(); }
+    inline size_t size() const { return mElements.size(); }
+    inline void clear() { mElements.clear(); }
+    inline void reserve(size_t n) { mElements.reserve(n); }
+
+    inline iterator find(const KEY& key) {
+        iterator it = lowerBound(key);
+        return isKey(it, key) ? it : mElements.end();
+    }
+    inline const_iterator find(const KEY& key) const {
+        const_iterator it = lowerBound(key);
+        return isKey(it, key) ? it : mElements.end();
+    }
+    inline size_t count(const KEY& key) const {
+        return isKey(lowerBound(key), key) ? 1 : 0;
+    }
+
+    inline std::pair<iterator, bool> insert(const value_type& element) {
+        iterator it = lowerBound(element.first);
+        if (isKey(it, element.first)) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(mElements.insert(it, element), true);
+    }
+    inline VAL& operator[](const KEY& key) {
+        iterator it = lowerBound(key);
+        if (!isKey(it, key)) {
+            it = mElements.insert(it, value_type(key, VAL()));
+        }
+        return it->second;
+    }
+
+    inline iterator erase(iterator it) { return mElements.erase(it); }
+    inline size_t erase(const KEY& key) {
+        iterator it = find(key);
+        if (it == mElements.end()) {
+            return 0;
+        }
+        mElements.erase(it);
+        return 1;
+    }
+};
+
+} // namespace loc_util
+
+#endif // __LOC_FLAT_MAP_H__
@@ -268,6 +268,106 @@ LocRankable* LocHeap::remove(LocRankable& rankable) {
     return locNode;
 }
 
+LocDaryHeap::~LocDaryHeap() {
+    for (LocRankable* node : mNodes) {
+        node->mHeapIndex = LocRankable::NOT_IN_HEAP;
+    }
+}
+
+// moves the node at index up, while it outranks its parent
+void LocDaryHeap::siftUp(size_t index) {
+    LocRankable* node = mNodes[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / ARITY;
+        if (!node->outRanks(*mNodes[parent])) {
+            break;
+        }
+        place(mNodes[parent], index);
+        index = parent;
+    }
+    place(node, index);
+}
+
+// moves the node at index down, while any of its children outranks it
+void LocDaryHeap::siftDown(size_t index) {
+    LocRankable* node = mNodes[index];
+    size_t count = mNodes.size();
+    while (true) {
+        size_t first = index * ARITY + 1;
+        if (first >= count) {
+            break;
+        }
+        size_t last = (first + ARITY < count) ? (first + ARITY) : count;
+        size_t top = first;
+        for (size_t child = first + 1; child < last; child++) {
+            if (mNodes[child]->outRanks(*mNodes[top])) {
+                top = child;
+            }
+        }
+        if (!mNodes[top]->outRanks(*node)) {
+            break;
+        }
+        place(mNodes[top], index);
+        index = top;
+    }
+    place(node, index);
+}
+
+void LocDaryHeap::push(LocRankable& node) {
+    mNodes.push_back(&node);
+    node.mHeapIndex = mNodes.size() - 1;
+    siftUp(node.mHeapIndex);
+}
+
+LocRankable* LocDaryHeap::pop() {
+    return mNodes.empty() ? NULL : remove(*mNodes[0]);
+}
+
+LocRankable* LocDaryHeap::remove(LocRankable& rankable) {
+    size_t index = rankable.mHeapIndex;
+    if (index >= mNodes.size() || mNodes[index] != &rankable) {
+        return NULL;
+    }
+    LocRankable* last = mNodes.back();
+    mNodes.pop_back();
+    if (last != &rankable) {
+        // the last node fills the hole, and may belong above or below it
+        place(last, index);
+        if (index > 0 && last->outRanks(*mNodes[(index - 1) / ARITY])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    }
+    rankable.mHeapIndex = LocRankable::NOT_IN_HEAP;
+    return &rankable;
+}
+
+bool LocDaryHeap::update(LocRankable& rankable) {
+    size_t index = rankable.mHeapIndex;
+    if (index >= mNodes.size() || mNodes[index] != &rankable) {
+        return false;
+    }
+    if (index > 0 && rankable.outRanks(*mNodes[(index - 1) / ARITY])) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+    return true;
+}
+
+#ifdef __LOC_UNIT_TEST__
+bool LocDaryHeap::checkTree() {
+    for (size_t i = 0; i < mNodes.size(); i++) {
+        if (mNodes[i]->mHeapIndex != i ||
+            (i > 0 && mNodes[i]->outRanks(*mNodes[(i - 1) / ARITY]))) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
 } // namespace loc_util
 
 #ifdef __LOC_UNIT_TEST__
@@ -31,12 +31,20 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <vector>
 
 namespace loc_util {
 
+class LocDaryHeap;
+
 // abstract class to be implemented by client to provide a rankable class
 class LocRankable {
+    friend class LocDaryHeap;
+    // position in the LocDaryHeap this obj is in, if any
+    size_t mHeapIndex;
 public:
+    static const size_t NOT_IN_HEAP = (size_t)-1;
+    inline LocRankable() : mHeapIndex(NOT_IN_HEAP) {}
     virtual inline ~LocRankable() {}
 
     // method to rank objects of such type for sorting purposes.
@@ -95,6 +103,53 @@ public:
 #endif
 };
 
+// an array backed d-ary heap, which keeps the position of each node in the
+// node (LocRankable) itself. Unlike LocHeap, push() does not allocate once
+// the array has grown to the working set, and remove() of an arbitrary node
+// is O(log n) rather than a walk of the tree. A LocRankable obj can only be
+// in one LocDaryHeap at a time.
+class LocDaryHeap {
+    // 4 children per node keeps the tree shallow, with siblings on one cache line
+    static const size_t ARITY = 4;
+    std::vector<LocRankable*> mNodes;
+    inline void place(LocRankable* node, size_t index) {
+        mNodes[index] = node;
+        node->mHeapIndex = index;
+    }
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+public:
+    // capacity: number of nodes to preallocate room for
+    inline LocDaryHeap(size_t capacity = 0) { mNodes.reserve(capacity); }
+    ~LocDaryHeap();
+
+    // node is reference to an obj that is managed by client, that client
+    //      creates and destroyes. The destroy should happen after the
+    //      node is popped out from the heap.
+    void push(LocRankable& node);
+
+    // Returns NULL if the heap is empty, otherwise pointer to the node that
+    //         currently has the highest ranking.
+    inline LocRankable* peek() { return mNodes.empty() ? NULL : mNodes[0]; }
+
+    // Return - pointer to the node popped out, or NULL if heap is already empty
+    LocRankable* pop();
+
+    // removes the input node, if it is in this heap.
+    // returns the pointer to the node removed; or NULL (if failed).
+    LocRankable* remove(LocRankable& rankable);
+
+    // re-sorts a node in this heap after the client changed its ranking, e.g.
+    // a decrease-key. Returns false if the node is not in this heap.
+    bool update(LocRankable& rankable);
+
+    inline size_t size() const { return mNodes.size(); }
+
+#ifdef __LOC_UNIT_TEST__
+    bool checkTree();
+#endif
+};
+
 } // namespace loc_util
 
 #endif //__LOC_HEAP__
@@ -0,0 +1,152 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_HostResolver"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <string.h>
+#include <loc_misc_utils.h>
+#include <log_util.h>
+#include <LocHostResolver.h>
+
+#define LOC_HOST_RESOLVER_TTL_MS            (5 * 60 * 1000)
+#define LOC_HOST_RESOLVER_NEGATIVE_TTL_MS   (30 * 1000)
+
+namespace loc_util {
+
+LocHostResolver& LocHostResolver::getInstance() {
+    static LocHostResolver instance;
+    return instance;
+}
+
+LocHostResolver::LocHostResolver() : mMsgTask("LocHostResolver") {}
+
+bool LocHostResolver::getCached(const char* host, in_addr_t& addr) {
+    if (nullptr == host) {
+        return false;
+    }
+    struct in_addr inAddr;
+    if (0 != inet_aton(host, &inAddr)) {
+        addr = inAddr.s_addr;
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(mLock);
+    auto it = mCache.find(host);
+    if (it == mCache.end() || !it->second.mResolved ||
+            it->second.mExpiryMs <= getBootTimeMilliSec()) {
+        return false;
+    }
+    addr = it->second.mAddr;
+    return true;
+}
+
+bool LocHostResolver::lookUp(const std::string& host, in_addr_t& addr) {
+    struct addrinfo hints = {};
+    struct addrinfo* result = nullptr;
+    hints.ai_family = AF_INET;
+    int ret = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+    if (0 != ret || nullptr == result) {
+        LOC_LOGe("%s can not be resolved: %s", host.c_str(), gai_strerror(ret));
+        return false;
+    }
+    addr = ((struct sockaddr_in*)result->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+void LocHostResolver::onLookedUp(const std::string& host, bool resolved, in_addr_t addr) {
+    std::vector<LocHostResolvedCb> cbs;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        mCache[host] = {resolved, addr, getBootTimeMilliSec() +
+                (resolved ? LOC_HOST_RESOLVER_TTL_MS : LOC_HOST_RESOLVER_NEGATIVE_TTL_MS)};
+        auto it = mPending.find(host);
+        if (it != mPending.end()) {
+            cbs.swap(it->second);
+            mPending.erase(it);
+        }
+    }
+    for (auto& cb : cbs) {
+        cb(resolved, addr);
+    }
+}
+
+void LocHostResolver::resolve(const char* host, LocHostResolvedCb resolvedCb) {
+    if (nullptr == host) {
+        resolvedCb(false, INADDR_NONE);
+        return;
+    }
+    in_addr_t addr = INADDR_NONE;
+    if (getCached(host, addr)) {
+        resolvedCb(true, addr);
+        return;
+    }
+
+    std::string hostName(host);
+    bool failedRecently = false;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        auto it = mCache.find(hostName);
+        if (it != mCache.end() && !it->second.mResolved &&
+                it->second.mExpiryMs > getBootTimeMilliSec()) {
+            // failed a short while ago, not worth asking again yet
+            failedRecently = true;
+        } else {
+            std::vector<LocHostResolvedCb>& cbs = mPending[hostName];
+            cbs.push_back(resolvedCb);
+            if (cbs.size() > 1) {
+                return;
+            }
+        }
+    }
+    if (failedRecently) {
+        resolvedCb(false, INADDR_NONE);
+        return;
+    }
+    mMsgTask.sendMsg([this, hostName] () {
+        in_addr_t addr = INADDR_NONE;
+        bool resolved = lookUp(hostName, addr);
+        onLookedUp(hostName, resolved, addr);
+    });
+}
+
+bool LocHostResolver::resolveSync(const char* host, in_addr_t& addr) {
+    if (getCached(host, addr)) {
+        return true;
+    } else if (nullptr == host) {
+        return false;
+    }
+    std::string hostName(host);
+    bool resolved = lookUp(hostName, addr);
+    onLookedUp(hostName, resolved, addr);
+    return resolved;
+}
+
+} // namespace loc_util
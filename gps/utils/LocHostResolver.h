@@ -0,0 +1,88 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_HOST_RESOLVER_H__
+#define __LOC_HOST_RESOLVER_H__
+
+#include <netinet/in.h>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <MsgTask.h>
+
+namespace loc_util {
+
+// Resolves host names to IPv4 addresses on a thread of its own, so that a
+// slow or unreachable DNS server never holds up the thread asking. Answers
+// are cached per host name; getaddrinfo() does not hand out the TTL of the
+// records, so an address is kept for LOC_HOST_RESOLVER_TTL_MS and a failed
+// lookup for LOC_HOST_RESOLVER_NEGATIVE_TTL_MS.
+// There is one resolver per process.
+class LocHostResolver {
+public:
+    // resolved is false if the host could not be resolved; called in the
+    // context of the resolver thread, or of the caller if the answer was
+    // already at hand
+    typedef std::function<void(bool resolved, in_addr_t addr)> LocHostResolvedCb;
+
+    static LocHostResolver& getInstance();
+
+    // the cached address of host, or host itself if it is an IP address;
+    // false if neither, in which case nothing is looked up
+    bool getCached(const char* host, in_addr_t& addr);
+    // calls resolvedCb with the address of host, looking it up if it is not
+    // cached. Lookups of a host already in flight are answered together.
+    void resolve(const char* host, LocHostResolvedCb resolvedCb);
+    // same as resolve(), but blocks the caller until the answer is there
+    bool resolveSync(const char* host, in_addr_t& addr);
+
+private:
+    struct CachedHost {
+        bool mResolved;
+        in_addr_t mAddr;
+        uint64_t mExpiryMs;
+    };
+
+    LocHostResolver();
+    LocHostResolver(const LocHostResolver&) = delete;
+    LocHostResolver& operator=(const LocHostResolver&) = delete;
+
+    bool lookUp(const std::string& host, in_addr_t& addr);
+    void onLookedUp(const std::string& host, bool resolved, in_addr_t addr);
+
+    std::mutex mLock;
+    std::unordered_map<std::string, CachedHost> mCache;
+    std::unordered_map<std::string, std::vector<LocHostResolvedCb>> mPending;
+    MsgTask mMsgTask;
+};
+
+} // namespace loc_util
+
+#endif // __LOC_HOST_RESOLVER_H__
@@ -29,12 +29,26 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <atomic>
 #include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <loc_misc_utils.h>
 #include <log_util.h>
 #include <LocIpc.h>
+#include <LocHostResolver.h>
+#include <LocAtrace.h>
 #include <algorithm>
 
 using namespace std;
@@ -60,12 +74,67 @@ namespace loc_util {
 
 const char Sock::MSG_ABORT[] = "LocIpc::Sock::ABORT";
 const char Sock::LOC_IPC_HEAD[] = "$MSGLEN$";
+const char Sock::MSG_FDS[] = "LocIpc::Sock::FDS";
 ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                           socklen_t addrlen) const {
     ssize_t rtv = -1;
-    SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendto(buf, len, flags, destAddr, addrlen));
+    struct iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+    SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendmsgs(&iov, 1, len, flags, destAddr, addrlen));
     return rtv;
 }
+ssize_t Sock::sendv(const struct iovec iov[], int iovcnt, int flags,
+                    const struct sockaddr *destAddr, socklen_t addrlen) const {
+    ssize_t rtv = -1;
+    size_t len = 0;
+    for (int i = 0; nullptr != iov && i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    SOCK_OP_AND_LOG(iov, (uint32_t)len, isValid(), rtv,
+                    sendmsgs(iov, iovcnt, len, flags, destAddr, addrlen));
+    return rtv;
+}
+int Sock::sendBatch(const struct iovec msgs[], int count, int flags,
+                    const struct sockaddr *destAddr, socklen_t addrlen) const {
+    if (nullptr == msgs || count <= 0 || !isValid()) {
+        LOC_LOGe("Invalid inputs: msgs - %p, count - %d, valid - %d", msgs, count, isValid());
+        return 0;
+    }
+    vector<struct mmsghdr> hdrs;
+    hdrs.reserve(count);
+    int sent = 0;
+    for (int i = 0; i <= count; i++) {
+        if (i < count && SOCK_STREAM != mSockType &&
+                msgs[i].iov_len > 0 && msgs[i].iov_len <= mMaxTxSize) {
+            struct mmsghdr hdr = {};
+            hdr.msg_hdr.msg_name = (void*)destAddr;
+            hdr.msg_hdr.msg_namelen = addrlen;
+            hdr.msg_hdr.msg_iov = (struct iovec*)&msgs[i];
+            hdr.msg_hdr.msg_iovlen = 1;
+            hdrs.push_back(hdr);
+            continue;
+        }
+        // flush the run of single datagram messages before msgs[i]
+        for (size_t j = 0; j < hdrs.size(); ) {
+            int n = ::sendmmsg(mSid, hdrs.data() + j, min(hdrs.size() - j, (size_t)IOV_MAX),
+                               flags);
+            if (n <= 0) {
+                LOC_LOGw("failed reason: %s", strerror(errno));
+                return sent;
+            }
+            j += n;
+            sent += n;
+        }
+        hdrs.clear();
+        // a long message, or any message on a stream socket
+        if (i < count) {
+            if (send(msgs[i].iov_base, msgs[i].iov_len, flags, destAddr, addrlen) <= 0) {
+                return sent;
+            }
+            sent++;
+        }
+    }
+    return sent;
+}
 ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                    struct sockaddr *srcAddr, socklen_t *addrlen, int sid) const {
     ssize_t rtv = -1;
@@ -76,58 +145,358 @@ ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>
                     recvfrom(recver, dataCb, sid, flags, srcAddr, addrlen));
     return rtv;
 }
-ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
-                     socklen_t addrlen) const {
-    ssize_t rtv = -1;
+ssize_t Sock::sendmsgs(const struct iovec iov[], int iovcnt, size_t len, int flags,
+                       const struct sockaddr *destAddr, socklen_t addrlen) const {
+    struct msghdr hdr = {};
+    hdr.msg_name = (void*)destAddr;
+    hdr.msg_namelen = addrlen;
     if (len <= mMaxTxSize) {
-        rtv = ::sendto(mSid, buf, len, flags, destAddr, addrlen);
-    } else {
-        std::string head(LOC_IPC_HEAD + to_string(len));
-        rtv = ::sendto(mSid, head.c_str(), head.length(), flags, destAddr, addrlen);
-        if (rtv > 0) {
-            for (size_t offset = 0; offset < len && rtv > 0; offset += rtv) {
-                rtv = ::sendto(mSid, (char*)buf + offset, min(len - offset, (size_t)mMaxTxSize),
-                               flags, destAddr, addrlen);
+        hdr.msg_iov = (struct iovec*)iov;
+        hdr.msg_iovlen = iovcnt;
+        return ::sendmsg(mSid, &hdr, flags);
+    }
+
+    FrameHead head = { FRAME_MAGIC, (uint32_t)len };
+    vector<struct iovec> frags;
+    frags.reserve(iovcnt + 1 + len / mMaxTxSize);
+    frags.push_back({ .iov_base = &head, .iov_len = sizeof(head) });
+
+    if (SOCK_STREAM == mSockType) {
+        // no datagram boundaries to keep, so head and payload go out in one
+        // sendmsg(); only a short write takes another round
+        frags.insert(frags.end(), iov, iov + iovcnt);
+        size_t first = 0;
+        for (size_t sent = 0; sent < sizeof(head) + len; ) {
+            hdr.msg_iov = frags.data() + first;
+            hdr.msg_iovlen = frags.size() - first;
+            ssize_t rtv = ::sendmsg(mSid, &hdr, flags);
+            if (rtv <= 0) {
+                return -1;
+            }
+            sent += rtv;
+            for (; first < frags.size() && (size_t)rtv >= frags[first].iov_len; first++) {
+                rtv -= frags[first].iov_len;
+            }
+            if (rtv > 0) {
+                frags[first].iov_base = (char*)frags[first].iov_base + rtv;
+                frags[first].iov_len -= rtv;
             }
-            rtv = (rtv > 0) ? (head.length() + len) : -1;
         }
+        return sizeof(head) + len;
     }
-    return rtv;
+
+    // cut head + payload into fragments of up to mMaxTxSize, each one
+    // datagram referring to a range of frags, and hand them all to the
+    // kernel in as few sendmmsg() as it allows
+    vector<pair<size_t, size_t>> ranges;
+    size_t fragStart = 0;
+    size_t room = mMaxTxSize - sizeof(head);
+    for (int i = 0; i < iovcnt; i++) {
+        char* base = (char*)iov[i].iov_base;
+        for (size_t left = iov[i].iov_len; left > 0; ) {
+            size_t n = min(left, room);
+            frags.push_back({ .iov_base = base, .iov_len = n });
+            base += n;
+            left -= n;
+            room -= n;
+            if (0 == room) {
+                ranges.push_back(make_pair(fragStart, frags.size() - fragStart));
+                fragStart = frags.size();
+                room = mMaxTxSize;
+            }
+        }
+    }
+    if (frags.size() > fragStart) {
+        ranges.push_back(make_pair(fragStart, frags.size() - fragStart));
+    }
+
+    vector<struct mmsghdr> msgs(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        msgs[i].msg_hdr = hdr;
+        msgs[i].msg_hdr.msg_iov = frags.data() + ranges[i].first;
+        msgs[i].msg_hdr.msg_iovlen = ranges[i].second;
+    }
+    for (size_t i = 0; i < msgs.size(); ) {
+        int n = ::sendmmsg(mSid, msgs.data() + i, min(msgs.size() - i, (size_t)IOV_MAX), flags);
+        if (n <= 0) {
+            return -1;
+        }
+        i += n;
+    }
+    return sizeof(head) + len;
+}
+ssize_t Sock::recvInto(int sid, size_t offset, size_t len, int flags,
+                       struct sockaddr *srcAddr, socklen_t *addrlen) const {
+    // grow only; resize() is a no-op once the buffer has reached the
+    // largest message size seen on this socket
+    if (mRxBuf.size() < offset + len) {
+        mRxBuf.resize(offset + len);
+    }
+    struct iovec iov = { .iov_base = mRxBuf.data() + offset, .iov_len = len };
+    struct msghdr hdr = {};
+    // fds may only come along with the first fragment
+    char ctrl[CMSG_SPACE(sizeof(mRxFds))];
+    hdr.msg_name = srcAddr;
+    hdr.msg_namelen = (nullptr != addrlen) ? *addrlen : 0;
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    if (0 == offset) {
+        hdr.msg_control = ctrl;
+        hdr.msg_controllen = sizeof(ctrl);
+    }
+    mRxFdCount = 0;
+    ssize_t nBytes = ::recvmsg(sid, &hdr, flags | MSG_CMSG_CLOEXEC);
+    if (nBytes >= 0) {
+        if (nullptr != addrlen) {
+            *addrlen = hdr.msg_namelen;
+        }
+        if (hdr.msg_flags & MSG_TRUNC) {
+            LOC_LOGw("datagram truncated to %zu bytes", len);
+        }
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); nullptr != cmsg;
+             cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+                int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (int i = 0; i < count; i++) {
+                    int fd;
+                    memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+                    if (mRxFdCount < MAX_FDS) {
+                        mRxFds[mRxFdCount++] = fd;
+                    } else {
+                        ::close(fd);
+                    }
+                }
+            }
+        }
+    }
+    return nBytes;
+}
+ssize_t Sock::recvFragment(int sid, size_t offset, size_t len, int flags,
+                           struct sockaddr *srcAddr, socklen_t *addrlen) const {
+    if (mRxBatchNext >= mRxBatchCount) {
+        return recvInto(sid, offset, len, flags, srcAddr, addrlen);
+    }
+    const struct mmsghdr& msg = mRxMsgs[mRxBatchNext++];
+    size_t nBytes = min((size_t)msg.msg_len, len);
+    if (mRxBuf.size() < offset + len) {
+        mRxBuf.resize(offset + len);
+    }
+    memcpy(mRxBuf.data() + offset, msg.msg_hdr.msg_iov->iov_base, nBytes);
+    return nBytes;
 }
 ssize_t Sock::recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
-    std::string msg(mMaxTxSize, 0);
-    ssize_t nBytes = ::recvfrom(sid, (void*)msg.data(), msg.size(), flags, srcAddr, addrlen);
+    ssize_t nBytes = recvInto(sid, 0, mMaxTxSize, flags, srcAddr, addrlen);
     if (nBytes > 0) {
-        if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
-            nBytes = 0;
-        } else if (strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
-            // short message
-            msg.resize(nBytes);
-            dataCb->onReceive(msg.data(), nBytes, &recver);
+        nBytes = deliver(recver, dataCb, sid, flags, mRxBuf.data(), nBytes, srcAddr, addrlen);
+    }
+    return nBytes;
+}
+ssize_t Sock::deliver(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                      int sid, int flags, const char* data, ssize_t nBytes,
+                      struct sockaddr *srcAddr, socklen_t *addrlen) const {
+    LOC_ATRACE_SCOPE("LocIpc::recv");
+    FrameHead head = {};
+    if ((size_t)nBytes >= sizeof(head)) {
+        memcpy(&head, data, sizeof(head));
+    }
+    if (mRxFdCount > 0) {
+        int fds[MAX_FDS];
+        int count = mRxFdCount;
+        memcpy(fds, mRxFds, count * sizeof(int));
+        if ((size_t)nBytes == sizeof(MSG_FDS) && strncmp(data, MSG_FDS, sizeof(MSG_FDS)) == 0) {
+            dataCb->onReceiveFds(fds, count, &recver);
         } else {
-            // long message
-            size_t msgLen = 0;
-            sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
-            msg.resize(msgLen);
-            for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
-                 msgLenReceived += nBytes) {
-                nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
-                                    flags, srcAddr, addrlen);
+            LOC_LOGw("dropping %d fds that came with a regular message", count);
+            for (int i = 0; i < count; i++) {
+                ::close(fds[i]);
             }
-            if (nBytes > 0) {
-                nBytes = msgLen;
-                dataCb->onReceive(msg.data(), nBytes, &recver);
+        }
+    } else if ((size_t)nBytes >= sizeof(MSG_ABORT) &&
+        strncmp(data, MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+        LOC_LOGi("recvd abort msg.data %s", data);
+        nBytes = 0;
+    } else if (FRAME_MAGIC == head.mMagic) {
+        // framed long message; the rest of the payload is received in
+        // place right behind what came with the head
+        size_t msgLen = head.mLen;
+        size_t msgLenReceived = min((size_t)nBytes - sizeof(head), msgLen);
+        if (data != mRxBuf.data()) {
+            // first fragment came with a batch
+            if (mRxBuf.size() < sizeof(head) + msgLenReceived) {
+                mRxBuf.resize(sizeof(head) + msgLenReceived);
             }
+            memcpy(mRxBuf.data() + sizeof(head), data + sizeof(head), msgLenReceived);
+        }
+        for (; (msgLenReceived < msgLen) && (nBytes > 0); msgLenReceived += nBytes) {
+            nBytes = recvFragment(sid, sizeof(head) + msgLenReceived, msgLen - msgLenReceived,
+                                  flags, srcAddr, addrlen);
+        }
+        if (nBytes > 0) {
+            nBytes = msgLen;
+            dataCb->onReceive(mRxBuf.data() + sizeof(head), nBytes, &recver);
+        }
+    } else if ((size_t)nBytes < sizeof(LOC_IPC_HEAD) - 1 ||
+               strncmp(data, LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+        // short message
+        dataCb->onReceive(data, nBytes, &recver);
+    } else {
+        // legacy long message; the head is parsed out before the fragments
+        // are received, so they can be laid down from offset 0 in place
+        char lenStr[32] = {};
+        memcpy(lenStr, data + sizeof(LOC_IPC_HEAD) - 1,
+               min((size_t)nBytes - (sizeof(LOC_IPC_HEAD) - 1), sizeof(lenStr) - 1));
+        size_t msgLen = 0;
+        sscanf(lenStr, "%zu", &msgLen);
+        for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
+             msgLenReceived += nBytes) {
+            nBytes = recvFragment(sid, msgLenReceived, msgLen - msgLenReceived,
+                                  flags, srcAddr, addrlen);
+        }
+        if (nBytes > 0) {
+            nBytes = msgLen;
+            dataCb->onReceive(mRxBuf.data(), nBytes, &recver);
         }
     }
 
     return nBytes;
 }
+ssize_t Sock::recvmmsgs(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                        int batchSize, int flags,
+                        struct sockaddr *srcAddr, socklen_t *addrlen) const {
+    size_t count = max(batchSize, 1);
+    if (mRxMsgs.size() < count) {
+        mRxBatch.resize(count * mMaxTxSize);
+        mRxMsgs.resize(count);
+        mRxIovs.resize(count);
+        mRxAddrs.resize(count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        mRxIovs[i] = { .iov_base = mRxBatch.data() + i * mMaxTxSize, .iov_len = mMaxTxSize };
+        mRxMsgs[i] = {};
+        mRxMsgs[i].msg_hdr.msg_name = &mRxAddrs[i];
+        mRxMsgs[i].msg_hdr.msg_namelen = sizeof(mRxAddrs[i]);
+        mRxMsgs[i].msg_hdr.msg_iov = &mRxIovs[i];
+        mRxMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int received = ::recvmmsg(mSid, mRxMsgs.data(), count, flags, nullptr);
+    if (received <= 0) {
+        return -1;
+    }
+
+    const socklen_t addrSize = (nullptr != addrlen) ? *addrlen : 0;
+    ssize_t nBytes = 0;
+    // no fds come along with a recvmmsg()
+    mRxFdCount = 0;
+    mRxBatchCount = received;
+    for (mRxBatchNext = 0; mRxBatchNext < mRxBatchCount; ) {
+        const struct mmsghdr& msg = mRxMsgs[mRxBatchNext++];
+        if (nullptr != srcAddr && nullptr != addrlen) {
+            socklen_t len = min(addrSize, msg.msg_hdr.msg_namelen);
+            memcpy(srcAddr, msg.msg_hdr.msg_name, len);
+            *addrlen = len;
+        }
+        if (msg.msg_hdr.msg_flags & MSG_TRUNC) {
+            LOC_LOGw("datagram truncated to %u bytes", mMaxTxSize);
+        }
+        nBytes = msg.msg_len;
+        if (nBytes <= 0) {
+            break;
+        }
+        // fragments missing from the batch are waited for
+        nBytes = deliver(recver, dataCb, mSid, 0, (const char*)msg.msg_hdr.msg_iov->iov_base,
+                         nBytes, srcAddr, addrlen);
+        if (nBytes <= 0) {
+            break;
+        }
+    }
+    mRxBatchNext = mRxBatchCount = 0;
+    return nBytes;
+}
+ssize_t Sock::recvBatch(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                        int batchSize, uint32_t busyPollUs,
+                        struct sockaddr *srcAddr, socklen_t *addrlen) const {
+    ssize_t rtv = -1;
+    const socklen_t addrSize = (nullptr != addrlen) ? *addrlen : 0;
+    SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
+                    recvmmsgs(recver, dataCb, batchSize, MSG_WAITFORONE, srcAddr, addrlen));
+    if (rtv > 0 && busyPollUs > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t deadlineUs = now.tv_sec * 1000000ULL + now.tv_nsec / 1000 + busyPollUs;
+        uint64_t nowUs = 0;
+        do {
+            if (nullptr != addrlen) {
+                *addrlen = addrSize;
+            }
+            ssize_t nBytes = recvmmsgs(recver, dataCb, batchSize, MSG_DONTWAIT,
+                                       srcAddr, addrlen);
+            if (0 == nBytes) {
+                // abort
+                return 0;
+            } else if (nBytes < 0 && EAGAIN != errno && EWOULDBLOCK != errno) {
+                // what was received so far has been delivered, the error
+                // is left to the next recv
+                break;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            nowUs = now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+        } while (nowUs < deadlineUs);
+    }
+    return rtv;
+}
 ssize_t Sock::sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen) {
     return send(MSG_ABORT, sizeof(MSG_ABORT), flags, destAddr, addrlen);
 }
+ssize_t Sock::sendFds(const int fds[], int count, int flags,
+                      const struct sockaddr *destAddr, socklen_t addrlen) const {
+    if (!isValid() || nullptr == fds || count <= 0 || count > MAX_FDS) {
+        LOC_LOGe("Invalid inputs: fds - %p, count - %d", fds, count);
+        return -1;
+    }
+    struct iovec iov = { .iov_base = (void*)MSG_FDS, .iov_len = sizeof(MSG_FDS) };
+    char ctrl[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    struct msghdr hdr = {};
+    hdr.msg_name = (void*)destAddr;
+    hdr.msg_namelen = addrlen;
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = ctrl;
+    hdr.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+    ssize_t rtv = ::sendmsg(mSid, &hdr, flags);
+    if (-1 == rtv) {
+        LOC_LOGw("failed reason: %s", strerror(errno));
+    }
+    return rtv;
+}
+
+// Local datagrams are not bound by any MTU, only by the socket's send
+// buffer, so they are made big enough for nearly every message to go out
+// whole; the framing of long messages is only left for the rare ones above.
+// Every local socket of the device ends up with the same size, as it only
+// depends on the system wide buffer limits.
+#define LOC_IPC_LOCAL_MAX_TX_SIZE   (64 * 1024)
+#define LOC_IPC_LOCAL_SOCK_BUF_SIZE (256 * 1024)
+#define LOC_IPC_DEFAULT_MAX_TX_SIZE 8192
+static uint32_t setUpLocalSockBufs(int fd) {
+    int size = LOC_IPC_LOCAL_SOCK_BUF_SIZE;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    socklen_t len = sizeof(size);
+    if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, &len) < 0) {
+        return LOC_IPC_DEFAULT_MAX_TX_SIZE;
+    }
+    // what is read back is doubled for the kernel's bookkeeping, and a
+    // datagram has to fit into the rest
+    uint32_t usable = (uint32_t)size / 2;
+    return max((uint32_t)LOC_IPC_DEFAULT_MAX_TX_SIZE,
+               min((uint32_t)LOC_IPC_LOCAL_MAX_TX_SIZE, usable));
+}
 
 class LocIpcLocalSender : public LocIpcSender {
 protected:
@@ -137,12 +506,23 @@ protected:
     inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
+    inline virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                                 int32_t /* msgId */) const override {
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
+    inline virtual int sendBatch(const struct iovec msgs[], int count) const override {
+        return mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
 public:
+    inline virtual ssize_t sendFds(const int fds[], int count) const override {
+        return mSock->sendFds(fds, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
     inline LocIpcLocalSender(const char* name) : LocIpcSender(),
             mSock(nullptr),
             mAddr({.sun_family = AF_UNIX, {}}) {
 
         int fd = -1;
+        uint32_t maxTxSize = LOC_IPC_DEFAULT_MAX_TX_SIZE;
         if (nullptr != name) {
             fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
             if (fd >= 0) {
@@ -150,9 +530,10 @@ public:
                 timeout.tv_sec = 2;
                 timeout.tv_usec = 0;
                 setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                maxTxSize = setUpLocalSockBufs(fd);
             }
         }
-        mSock.reset(new Sock(fd));
+        mSock.reset(new Sock(fd, maxTxSize));
         if (mSock != nullptr && mSock->isValid()) {
             snprintf(mAddr.sun_path, sizeof(mAddr.sun_path), "%s", name);
         }
@@ -182,6 +563,7 @@ public:
     }
     inline virtual ~LocIpcLocalRecver() { unlink(mAddr.sun_path); }
     inline virtual const char* getName() const override { return mAddr.sun_path; };
+    inline virtual int getRecvFd() const override { return mSock->mSid; }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));
@@ -191,29 +573,67 @@ public:
 
 class LocIpcInetSender : public LocIpcSender {
 protected:
+    // the address of a host that was not in the resolver cache, set from
+    // the resolver thread; the sender can not send until it is there
+    struct HostAddr {
+        atomic<bool> mResolved;
+        atomic<in_addr_t> mAddr;
+        inline HostAddr() : mResolved(false), mAddr(htonl(INADDR_ANY)) {}
+    };
+
     int mSockType;
     shared_ptr<Sock> mSock;
     const string mName;
     sockaddr_in mAddr;
-    inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
+    shared_ptr<HostAddr> mHostAddr;
+    inline virtual bool isOperable() const override {
+        return mSock != nullptr && mSock->isValid() &&
+                (nullptr == mHostAddr || mHostAddr->mResolved);
+    }
+    inline sockaddr_in getDestAddr() const {
+        sockaddr_in addr = mAddr;
+        if (nullptr != mHostAddr) {
+            addr.sin_addr.s_addr = mHostAddr->mAddr;
+        }
+        return addr;
+    }
     virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        sockaddr_in addr = getDestAddr();
+        return mSock->send(data, length, 0, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                          int32_t /* msgId */) const override {
+        sockaddr_in addr = getDestAddr();
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&addr, sizeof(addr));
     }
 public:
     inline LocIpcInetSender(const LocIpcInetSender& sender) :
             mSockType(sender.mSockType), mSock(sender.mSock),
-            mName(sender.mName), mAddr(sender.mAddr) {
+            mName(sender.mName), mAddr(sender.mAddr), mHostAddr(sender.mHostAddr) {
     }
-    inline LocIpcInetSender(const char* name, int32_t port, int sockType) : LocIpcSender(),
+    // A sender looks its host up on the resolver thread, unless it is
+    // cached; a receiver binds to it right away, so it waits for it.
+    inline LocIpcInetSender(const char* name, int32_t port, int sockType,
+                            bool resolveAsync = true) : LocIpcSender(),
             mSockType(sockType),
             mSock(make_shared<Sock>((nullptr == name) ? -1 : (::socket(AF_INET, mSockType, 0)))),
             mName((nullptr == name) ? "" : name),
             mAddr({.sin_family = AF_INET, .sin_port = htons(port),
                     .sin_addr = {htonl(INADDR_ANY)}}) {
-        if (mSock != nullptr && mSock->isValid() && nullptr != name) {
-            struct hostent* hp = gethostbyname(name);
-            if (nullptr != hp) {
-                memcpy((char*)&(mAddr.sin_addr.s_addr), hp->h_addr_list[0], hp->h_length);
+        if (mSock != nullptr && mSock->isValid() && !mName.empty()) {
+            LocHostResolver& resolver = LocHostResolver::getInstance();
+            in_addr_t addr;
+            if (resolver.getCached(name, addr) ||
+                    (!resolveAsync && resolver.resolveSync(name, addr))) {
+                mAddr.sin_addr.s_addr = addr;
+            } else if (resolveAsync) {
+                mHostAddr = make_shared<HostAddr>();
+                resolver.resolve(name, [hostAddr = mHostAddr] (bool resolved, in_addr_t addr) {
+                    if (resolved) {
+                        hostAddr->mAddr = addr;
+                        hostAddr->mResolved = true;
+                    }
+                });
             }
         }
     }
@@ -227,12 +647,23 @@ class LocIpcInetTcpSender : public LocIpcInetSender {
 protected:
     mutable bool mFirstTime;
 
-    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+    inline void connectOnce() const {
         if (mFirstTime) {
             mFirstTime = false;
-            ::connect(mSock->mSid, (const struct sockaddr*)&mAddr, sizeof(mAddr));
+            sockaddr_in addr = getDestAddr();
+            ::connect(mSock->mSid, (const struct sockaddr*)&addr, sizeof(addr));
         }
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+        connectOnce();
+        sockaddr_in addr = getDestAddr();
+        return mSock->send(data, length, 0, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                          int32_t /* msgId */) const override {
+        connectOnce();
+        sockaddr_in addr = getDestAddr();
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&addr, sizeof(addr));
     }
 
 public:
@@ -248,7 +679,7 @@ protected:
 public:
     inline LocIpcInetRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
                                int32_t port, int sockType) :
-            LocIpcInetSender(name, port, sockType), LocIpcRecver(listener, *this),
+            LocIpcInetSender(name, port, sockType, false), LocIpcRecver(listener, *this),
             mPort(port) {
         if (mSock->isValid() && ::bind(mSock->mSid, (struct sockaddr*)&mAddr, sizeof(mAddr)) < 0) {
             LOC_LOGe("bind socket error. sock fd: %d, reason: %s", mSock->mSid, strerror(errno));
@@ -257,6 +688,7 @@ public:
     }
     inline virtual ~LocIpcInetRecver() {}
     inline virtual const char* getName() const override { return mName.data(); };
+    inline virtual int getRecvFd() const override { return mSock->mSid; }
     inline virtual void abort() const override {
         if (isSendable()) {
             sockaddr_in loopBackAddr = {.sin_family = AF_INET, .sin_port = htons(mPort),
@@ -288,6 +720,8 @@ public:
                                int32_t port) :
             LocIpcInetRecver(listener, name, port, SOCK_STREAM), mConnFd(-1) {}
     inline virtual ~LocIpcInetTcpRecver() { if (-1 != mConnFd) ::close(mConnFd);}
+    // the connection is only accepted inside recv()
+    inline virtual int getRecvFd() const override { return -1; }
 };
 
 class LocIpcInetUdpRecver : public LocIpcInetRecver {
@@ -364,13 +798,703 @@ void LocIpc::stopBlockingListening(LocIpcRecver& ipcRecver) {
     }
 }
 
+#define LOC_IPC_REACTOR_MAX_EVENTS 16
+
+class LocIpcReactorRunnable : public LocRunnable {
+    LocIpcReactor& mReactor;
+public:
+    inline LocIpcReactorRunnable(LocIpcReactor& reactor) : mReactor(reactor) {}
+    inline virtual bool run() override { return mReactor.runOnce(); }
+    inline virtual void interrupt() override { mReactor.wakeUp(); }
+};
+
+LocIpcReactor::LocIpcReactor() :
+        mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+        mEventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+        mStopped(false),
+        mServing(false),
+        mServingTid(0),
+        mRemovalsPosted(0),
+        mRemovalsDone(0) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = mEventFd;
+    if (mEpollFd < 0 || mEventFd < 0 ||
+        epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &ev) < 0) {
+        LOC_LOGe("failed to set up epoll %d / eventfd %d, reason: %s",
+                 mEpollFd, mEventFd, strerror(errno));
+    }
+}
+
+LocIpcReactor::~LocIpcReactor() {
+    stop();
+    mRecvers.clear();
+    mFds.clear();
+    if (mEventFd >= 0) {
+        ::close(mEventFd);
+    }
+    if (mEpollFd >= 0) {
+        ::close(mEpollFd);
+    }
+}
+
+LocIpcReactor& LocIpcReactor::getProcessReactor() {
+    // never destroyed, clients may still be torn down from exit handlers
+    static LocIpcReactor* sReactor = [] {
+        LocIpcReactor* reactor = new LocIpcReactor();
+        reactor->startNonBlocking("LocIpc-Process");
+        return reactor;
+    }();
+    return *sReactor;
+}
+
+bool LocIpcReactor::add(unique_ptr<LocIpcRecver>& ipcRecver, const void* owner) {
+    if (mEpollFd < 0 || mEventFd < 0 || ipcRecver == nullptr ||
+        !ipcRecver->isRecvable() || -1 == ipcRecver->getRecvFd()) {
+        LOC_LOGe("ipcRecver is null OR not recvable OR has no fd to watch");
+        return false;
+    }
+    {
+        lock_guard<mutex> lock(mLock);
+        mPendingRecvers.emplace_back(move(ipcRecver), owner);
+    }
+    wakeUp();
+    return true;
+}
+
+bool LocIpcReactor::addFd(int fd, const function<void()>& onReadable, const void* owner) {
+    if (mEpollFd < 0 || mEventFd < 0 || fd < 0 || nullptr == onReadable) {
+        LOC_LOGe("fd %d is invalid OR has no handler", fd);
+        return false;
+    }
+    {
+        lock_guard<mutex> lock(mLock);
+        mPendingFds.emplace_back(fd, make_pair(onReadable, owner));
+    }
+    wakeUp();
+    return true;
+}
+
+// removes the entries of the given owners from a map keyed by watched fd
+template <typename Map, typename Match>
+static void unwatchOwners(int epollFd, Map& map, Match match) {
+    for (auto it = map.begin(); it != map.end();) {
+        if (match(it->second.second)) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LocIpcReactor::removeOwner(const void* owner) {
+    unique_lock<mutex> lock(mLock);
+    for (auto it = mPendingRecvers.begin(); it != mPendingRecvers.end();) {
+        if (owner == it->second) {
+            it = mPendingRecvers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = mPendingFds.begin(); it != mPendingFds.end();) {
+        if (owner == it->second.second) {
+            it = mPendingFds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!mServing) {
+        // nobody serves mRecvers, so they can be taken out right here
+        auto match = [owner] (const void* o) { return owner == o; };
+        unwatchOwners(mEpollFd, mRecvers, match);
+        unwatchOwners(mEpollFd, mFds, match);
+        return;
+    }
+    mPendingRemovals.push_back(owner);
+    uint64_t ticket = ++mRemovalsPosted;
+    bool onServingThread = (gettid() == mServingTid.load(std::memory_order_relaxed));
+    lock.unlock();
+    wakeUp();
+    if (!onServingThread) {
+        lock.lock();
+        mRemovedCond.wait(lock, [this, ticket] { return mRemovalsDone >= ticket || !mServing; });
+    }
+}
+
+bool LocIpcReactor::startNonBlocking(const char* threadName) {
+    {
+        lock_guard<mutex> lock(mLock);
+        mServing = true;
+    }
+    if (!mThread.start(threadName, make_shared<LocIpcReactorRunnable>(*this))) {
+        lock_guard<mutex> lock(mLock);
+        mServing = false;
+        return false;
+    }
+    return true;
+}
+
+bool LocIpcReactor::startBlocking() {
+    {
+        lock_guard<mutex> lock(mLock);
+        mServing = true;
+    }
+    while (runOnce());
+    return true;
+}
+
+void LocIpcReactor::stop() {
+    {
+        lock_guard<mutex> lock(mLock);
+        mStopped = true;
+    }
+    wakeUp();
+    mThread.stop();
+}
+
+void LocIpcReactor::wakeUp() const {
+    uint64_t one = 1;
+    if (mEventFd >= 0 && ::write(mEventFd, &one, sizeof(one)) < 0 && EAGAIN != errno) {
+        LOC_LOGw("failed to signal eventfd, reason: %s", strerror(errno));
+    }
+}
+
+void LocIpcReactor::addPending() {
+    vector<pair<unique_ptr<LocIpcRecver>, const void*>> recvers;
+    vector<pair<int, pair<function<void()>, const void*>>> fds;
+    {
+        lock_guard<mutex> lock(mLock);
+        recvers.swap(mPendingRecvers);
+        fds.swap(mPendingFds);
+    }
+    for (auto& fd : fds) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd.first;
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd.first, &ev) < 0) {
+            LOC_LOGe("failed to watch fd %d, reason: %s", fd.first, strerror(errno));
+            continue;
+        }
+        mFds[fd.first] = move(fd.second);
+    }
+    for (auto& recver : recvers) {
+        int fd = recver.first->getRecvFd();
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = fd;
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            LOC_LOGe("failed to watch %s fd %d, reason: %s",
+                     recver.first->getName(), fd, strerror(errno));
+            continue;
+        }
+        LocIpcRecver* pRecver = recver.first.get();
+        mRecvers[fd] = move(recver);
+        // inform that the socket is ready to receive message
+        pRecver->onListenerReady();
+        // whatever arrived before the fd was watched raises no edge
+        drain(fd);
+    }
+}
+
+void LocIpcReactor::removePendingOwners() {
+    vector<const void*> owners;
+    uint64_t posted;
+    {
+        lock_guard<mutex> lock(mLock);
+        owners.swap(mPendingRemovals);
+        posted = mRemovalsPosted;
+    }
+    if (owners.empty()) {
+        return;
+    }
+    for (auto it = mRecvers.begin(); it != mRecvers.end();) {
+        if (find(owners.begin(), owners.end(), it->second.second) != owners.end()) {
+            LOC_LOGi("stop serving %s", it->second.first->getName());
+            epoll_ctl(mEpollFd, EPOLL_CTL_DEL, it->first, nullptr);
+            it = mRecvers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    unwatchOwners(mEpollFd, mFds, [&owners] (const void* owner) {
+        return find(owners.begin(), owners.end(), owner) != owners.end();
+    });
+    {
+        lock_guard<mutex> lock(mLock);
+        mRemovalsDone = posted;
+    }
+    mRemovedCond.notify_all();
+}
+
+void LocIpcReactor::drain(int fd) {
+    auto it = mRecvers.find(fd);
+    if (mRecvers.end() == it) {
+        return;
+    }
+    // edge triggered, so everything queued must be consumed now. The peek
+    // only tells whether a message is pending; recvData() keeps the socket
+    // blocking so that the fragments of a long message are waited for.
+    LocIpcRecver& recver = *it->second.first;
+    ssize_t rtv;
+    while ((rtv = recver.peekRecv()) >= 0 || EINTR == errno) {
+        if (rtv >= 0 && !recver.recvData()) {
+            remove(fd);
+            return;
+        }
+    }
+    if (EAGAIN != errno && EWOULDBLOCK != errno) {
+        LOC_LOGe("%s fd %d failed, reason: %s", recver.getName(), fd, strerror(errno));
+        remove(fd);
+    }
+}
+
+void LocIpcReactor::remove(int fd) {
+    auto it = mRecvers.find(fd);
+    if (mRecvers.end() != it) {
+        LOC_LOGi("stop serving %s", it->second.first->getName());
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+        mRecvers.erase(it);
+    } else if (mFds.erase(fd) > 0) {
+        LOC_LOGi("stop watching fd %d", fd);
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+bool LocIpcReactor::runOnce() {
+    if (mEpollFd < 0) {
+        return false;
+    }
+    mServingTid.store(gettid(), std::memory_order_relaxed);
+    struct epoll_event events[LOC_IPC_REACTOR_MAX_EVENTS];
+    int n = epoll_wait(mEpollFd, events, LOC_IPC_REACTOR_MAX_EVENTS, -1);
+    if (n < 0 && EINTR != errno) {
+        LOC_LOGe("epoll_wait failed, reason: %s", strerror(errno));
+        n = -1;
+    }
+    for (int i = 0; i < n; i++) {
+        int fd = events[i].data.fd;
+        if (fd == mEventFd) {
+            uint64_t count;
+            while (::read(mEventFd, &count, sizeof(count)) > 0);
+            removePendingOwners();
+            addPending();
+        } else {
+            auto watched = mFds.find(fd);
+            if (mFds.end() != watched) {
+                // copied, the handler may have its own fd removed
+                function<void()> onReadable = watched->second.first;
+                onReadable();
+            }
+            // what is pending on a hung up fd is still delivered, e.g. the
+            // exit of the process a pidfd refers to
+            drain(fd);
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                remove(fd);
+            }
+        }
+    }
+    lock_guard<mutex> lock(mLock);
+    if (mStopped || n < 0) {
+        // no one would serve removals any more, let the waiters go
+        mServing = false;
+        mRemovedCond.notify_all();
+        return false;
+    }
+    return true;
+}
+
+ssize_t LocIpcRecver::peekRecv() const {
+    char peek;
+    int fd = getRecvFd();
+    if (-1 == fd) {
+        errno = EBADF;
+        return -1;
+    }
+    return ::recv(fd, &peek, sizeof(peek), MSG_PEEK | MSG_DONTWAIT);
+}
+
+#define LOC_IPC_SHM_MAGIC 0x4d485350 // "PSHM"
+#define LOC_IPC_SHM_WRAP  0xffffffff
+#define LOC_IPC_SHM_ALIGN(len) (((len) + 7) & ~((size_t)7))
+
+// Control block at the start of the shared mapping, followed by the ring.
+// Producer and consumer live in different processes, so each index sits in
+// its own cache line and everything shared is a lock-free atomic.
+struct LocIpcShmHead {
+    uint32_t mMagic;
+    uint32_t mSize;
+    // set by the consumer once it has mapped the ring
+    atomic<uint32_t> mAttached;
+    // set by the producer when it goes away
+    atomic<uint32_t> mClosed;
+    char mPad0[48];
+    atomic<uint64_t> mHead;
+    char mPad1[56];
+    atomic<uint64_t> mTail;
+    // consumer is (about to be) asleep on the eventfd
+    atomic<uint32_t> mWaiting;
+    char mPad2[52];
+};
+
+// Single producer / single consumer ring of length prefixed records in a
+// memfd. A record that does not fit into what is left before the end of the
+// ring is preceded by a LOC_IPC_SHM_WRAP marker and starts over at offset 0,
+// so the consumer can always hand out a record in place.
+class LocIpcShmRing {
+    int mMemFd;
+    int mEventFd;
+    size_t mMapSize;
+    LocIpcShmHead* mHead;
+    char* mData;
+    bool mIsProducer;
+    inline LocIpcShmRing(int memFd, int eventFd, bool isProducer) :
+            mMemFd(memFd), mEventFd(eventFd), mMapSize(0), mHead(nullptr), mData(nullptr),
+            mIsProducer(isProducer) {}
+    bool map(size_t mapSize) {
+        void* addr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mMemFd, 0);
+        if (MAP_FAILED == addr) {
+            LOC_LOGe("mmap failed, reason: %s", strerror(errno));
+            return false;
+        }
+        mMapSize = mapSize;
+        mHead = (LocIpcShmHead*)addr;
+        mData = (char*)addr + sizeof(LocIpcShmHead);
+        return true;
+    }
+    inline void notify() const {
+        uint64_t one = 1;
+        if (::write(mEventFd, &one, sizeof(one)) < 0 && EAGAIN != errno) {
+            LOC_LOGw("failed to signal eventfd, reason: %s", strerror(errno));
+        }
+    }
+public:
+    // producer side
+    static shared_ptr<LocIpcShmRing> create(uint32_t size) {
+        if (!ATOMIC_LLONG_LOCK_FREE || size < 4096 || (size & (size - 1)) != 0) {
+            LOC_LOGe("ring size %u is not a power of 2 >= 4096 or atomics are not lock free",
+                     size);
+            return nullptr;
+        }
+        int memFd = syscall(__NR_memfd_create, "LocIpcShm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        int eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        shared_ptr<LocIpcShmRing> ring(new LocIpcShmRing(memFd, eventFd, true));
+        size_t mapSize = sizeof(LocIpcShmHead) + size;
+        // the peer must not be able to shrink the file from under our mapping
+        if (memFd < 0 || eventFd < 0 || ftruncate(memFd, mapSize) < 0 ||
+            fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0 ||
+            !ring->map(mapSize)) {
+            LOC_LOGe("failed to set up shm ring, reason: %s", strerror(errno));
+            return nullptr;
+        }
+        ring->mHead->mMagic = LOC_IPC_SHM_MAGIC;
+        ring->mHead->mSize = size;
+        return ring;
+    }
+    // consumer side; takes over both fds
+    static shared_ptr<LocIpcShmRing> attach(int memFd, int eventFd) {
+        shared_ptr<LocIpcShmRing> ring(new LocIpcShmRing(memFd, eventFd, false));
+        struct stat st = {};
+        if (fstat(memFd, &st) < 0 || (size_t)st.st_size <= sizeof(LocIpcShmHead) ||
+            !ring->map(st.st_size)) {
+            LOC_LOGe("failed to map shm ring, reason: %s", strerror(errno));
+            return nullptr;
+        }
+        uint32_t size = ring->mHead->mSize;
+        if (LOC_IPC_SHM_MAGIC != ring->mHead->mMagic || (size & (size - 1)) != 0 ||
+            sizeof(LocIpcShmHead) + size > ring->mMapSize) {
+            LOC_LOGe("invalid shm ring, size %u", size);
+            return nullptr;
+        }
+        ring->mHead->mAttached.store(1);
+        return ring;
+    }
+    ~LocIpcShmRing() {
+        if (nullptr != mHead) {
+            if (mIsProducer) {
+                mHead->mClosed.store(1);
+                notify();
+            }
+            munmap(mHead, mMapSize);
+        }
+        if (mMemFd >= 0) {
+            ::close(mMemFd);
+        }
+        if (mEventFd >= 0) {
+            ::close(mEventFd);
+        }
+    }
+    inline int getMemFd() const { return mMemFd; }
+    inline int getEventFd() const { return mEventFd; }
+    inline uint32_t capacity() const { return mHead->mSize; }
+    inline bool isAttached() const { return 0 != mHead->mAttached.load(memory_order_acquire); }
+    inline bool isClosed() const { return 0 != mHead->mClosed.load(memory_order_acquire); }
+
+    // producer: false if the record does not fit now, or if the consumer
+    // left the indices in a state no sane consumer would
+    bool push(const struct iovec iov[], int iovcnt, size_t len) {
+        const uint32_t size = mHead->mSize;
+        const uint64_t head = mHead->mHead.load(memory_order_relaxed);
+        const uint64_t tail = mHead->mTail.load(memory_order_acquire);
+        if (tail > head || head - tail > size) {
+            LOC_LOGe("corrupted shm ring, head %" PRIu64 " tail %" PRIu64, head, tail);
+            return false;
+        }
+        size_t offset = head & (size - 1);
+        size_t need = LOC_IPC_SHM_ALIGN(sizeof(uint32_t) + len);
+        size_t skip = (need > size - offset) ? (size - offset) : 0;
+        if (skip + need > size - (head - tail)) {
+            return false;
+        }
+        if (skip > 0) {
+            uint32_t wrap = LOC_IPC_SHM_WRAP;
+            memcpy(mData + offset, &wrap, sizeof(wrap));
+            offset = 0;
+        }
+        uint32_t recLen = len;
+        memcpy(mData + offset, &recLen, sizeof(recLen));
+        char* dst = mData + offset + sizeof(recLen);
+        for (int i = 0; i < iovcnt; i++) {
+            memcpy(dst, iov[i].iov_base, iov[i].iov_len);
+            dst += iov[i].iov_len;
+        }
+        mHead->mHead.store(head + skip + need, memory_order_release);
+        // pairs with the fence in prepareWait(): either the consumer sees the
+        // new head, or we see it waiting and wake it up
+        atomic_thread_fence(memory_order_seq_cst);
+        if (mHead->mWaiting.load(memory_order_relaxed)) {
+            notify();
+        }
+        return true;
+    }
+
+    // consumer: the oldest record in place, or nullptr if there is none
+    const char* front(uint32_t& len) {
+        const uint32_t size = mHead->mSize;
+        uint64_t tail = mHead->mTail.load(memory_order_relaxed);
+        while (true) {
+            const uint64_t head = mHead->mHead.load(memory_order_acquire);
+            if (tail == head) {
+                return nullptr;
+            }
+            size_t offset = tail & (size - 1);
+            memcpy(&len, mData + offset, sizeof(len));
+            if (LOC_IPC_SHM_WRAP == len) {
+                tail += size - offset;
+                mHead->mTail.store(tail, memory_order_release);
+            } else if (len > size - offset - sizeof(len) || head - tail > size) {
+                LOC_LOGe("corrupted shm ring record, len %u", len);
+                return nullptr;
+            } else {
+                return mData + offset + sizeof(len);
+            }
+        }
+    }
+    inline void pop(uint32_t len) {
+        uint64_t tail = mHead->mTail.load(memory_order_relaxed);
+        mHead->mTail.store(tail + LOC_IPC_SHM_ALIGN(sizeof(len) + len), memory_order_release);
+    }
+    // consumer: announce going to sleep; false if there is something to
+    // consume after all
+    inline bool prepareWait() {
+        mHead->mWaiting.store(1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (mHead->mHead.load(memory_order_acquire) !=
+            mHead->mTail.load(memory_order_relaxed) || isClosed()) {
+            mHead->mWaiting.store(0, memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    inline void doneWaiting() {
+        uint64_t count;
+        while (::read(mEventFd, &count, sizeof(count)) > 0);
+        mHead->mWaiting.store(0, memory_order_relaxed);
+    }
+    inline void wakeUp() const { notify(); }
+};
+
+class LocIpcShmSender : public LocIpcSender {
+    const shared_ptr<LocIpcShmRing> mRing;
+    const shared_ptr<LocIpcSender> mSockSender;
+    // daemon side callers may send from more than one thread
+    mutable mutex mLock;
+    mutable bool mOverflowed;
+protected:
+    inline virtual bool isOperable() const override {
+        return mRing->isAttached() || mSockSender->isSendable();
+    }
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
+                                int32_t msgId) const override {
+        struct iovec iov = { .iov_base = (void*)data, .iov_len = length };
+        return sendv(&iov, 1, msgId);
+    }
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt, int32_t msgId) const override {
+        size_t len = 0;
+        for (int i = 0; nullptr != iov && i < iovcnt; i++) {
+            len += iov[i].iov_len;
+        }
+        if (0 == len) {
+            return -1;
+        }
+        if (mRing->isAttached() && len <= mRing->capacity() / 2) {
+            lock_guard<mutex> lock(mLock);
+            if (mRing->push(iov, iovcnt, len)) {
+                mOverflowed = false;
+                return len;
+            }
+            if (!mOverflowed) {
+                mOverflowed = true;
+                LOC_LOGw("shm ring full, falling back to socket");
+            }
+        }
+        return mSockSender->sendDataV(iov, iovcnt, msgId) ? len : -1;
+    }
+public:
+    inline LocIpcShmSender(const shared_ptr<LocIpcShmRing>& ring,
+                           const shared_ptr<LocIpcSender>& sockSender) :
+            LocIpcSender(), mRing(ring), mSockSender(sockSender), mOverflowed(false) {}
+    inline virtual ssize_t sendFds(const int fds[], int count) const override {
+        return mSockSender->sendFds(fds, count);
+    }
+    inline virtual void copyDestAddrFrom(const LocIpcSender& otherSender) override {
+        mSockSender->copyDestAddrFrom(otherSender);
+    }
+};
+
+class LocIpcShmRecver : public LocIpcSender, public LocIpcRecver {
+    const shared_ptr<LocIpcShmRing> mRing;
+    mutable atomic<bool> mAborted;
+protected:
+    inline virtual bool isOperable() const override { return !mAborted; }
+    // the ring only carries messages towards this recver
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
+                                int32_t msgId) const override {
+        return -1;
+    }
+    virtual ssize_t recv() const override {
+        while (!mAborted) {
+            uint32_t len = 0;
+            const char* data = mRing->front(len);
+            if (nullptr != data) {
+                LOC_ATRACE_SCOPE("LocIpc::recv");
+                mDataCb->onReceive(data, len, this);
+                mRing->pop(len);
+                return (0 == len) ? 1 : len;
+            }
+            if (mRing->isClosed()) {
+                LOC_LOGi("shm ring closed by peer");
+                return 0;
+            }
+            if (mRing->prepareWait()) {
+                struct pollfd pfd = { .fd = mRing->getEventFd(), .events = POLLIN, .revents = 0 };
+                poll(&pfd, 1, -1);
+                mRing->doneWaiting();
+            }
+        }
+        return 0;
+    }
+public:
+    inline LocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                           const shared_ptr<LocIpcShmRing>& ring) :
+            LocIpcSender(), LocIpcRecver(listener, *this), mRing(ring), mAborted(false) {}
+    inline virtual const char* getName() const override { return "LocIpcShmRecver"; }
+    // the ring is a side channel of a connection already set up over a socket
+    inline virtual void onListenerReady() override {}
+    inline virtual void abort() const override {
+        mAborted = true;
+        mRing->wakeUp();
+    }
+    inline virtual int getRecvFd() const override { return mRing->getEventFd(); }
+    virtual ssize_t peekRecv() const override {
+        uint64_t count;
+        while (::read(mRing->getEventFd(), &count, sizeof(count)) > 0);
+        uint32_t len = 0;
+        if (mAborted || (mRing->isClosed() && nullptr == mRing->front(len))) {
+            return 0;
+        }
+        if (nullptr != mRing->front(len) || !mRing->prepareWait()) {
+            return 1;
+        }
+        // the producer now wakes up the reactor through the eventfd
+        errno = EAGAIN;
+        return -1;
+    }
+};
+
+shared_ptr<LocIpcSender> LocIpc::getLocIpcShmSender(const shared_ptr<LocIpcSender>& sockSender,
+                                                    uint32_t ringSize) {
+    if (nullptr == sockSender) {
+        return nullptr;
+    }
+    shared_ptr<LocIpcShmRing> ring = LocIpcShmRing::create(ringSize);
+    if (nullptr != ring) {
+        int fds[] = { ring->getMemFd(), ring->getEventFd() };
+        if (sockSender->sendFds(fds, sizeof(fds) / sizeof(fds[0])) > 0) {
+            return make_shared<LocIpcShmSender>(ring, sockSender);
+        }
+    }
+    LOC_LOGw("no shm ring, staying with socket");
+    return sockSender;
+}
+unique_ptr<LocIpcRecver> LocIpc::getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                                                   const int fds[], int count) {
+    shared_ptr<LocIpcShmRing> ring = nullptr;
+    if (nullptr != fds && 2 == count) {
+        ring = LocIpcShmRing::attach(fds[0], fds[1]);
+    } else {
+        for (int i = 0; nullptr != fds && i < count; i++) {
+            ::close(fds[i]);
+        }
+    }
+    return (nullptr == ring) ? nullptr : make_unique<LocIpcShmRecver>(listener, ring);
+}
+
 bool LocIpc::send(LocIpcSender& sender, const uint8_t data[], uint32_t length, int32_t msgId) {
+    LOC_ATRACE_SCOPE("LocIpc::send");
     return sender.sendData(data, length, msgId);
 }
+bool LocIpc::sendv(LocIpcSender& sender, const struct iovec iov[], int iovcnt, int32_t msgId) {
+    LOC_ATRACE_SCOPE("LocIpc::send");
+    return sender.sendDataV(iov, iovcnt, msgId);
+}
+int LocIpc::sendBatch(LocIpcSender& sender, const struct iovec msgs[], int count) {
+    LOC_ATRACE_SCOPE("LocIpc::sendBatch");
+    return sender.sendDataBatch(msgs, count);
+}
+
+ssize_t LocIpcSender::sendv(const struct iovec iov[], int iovcnt, int32_t msgId) const {
+    string data;
+    for (int i = 0; nullptr != iov && i < iovcnt; i++) {
+        data.append((const char*)iov[i].iov_base, iov[i].iov_len);
+    }
+    return data.empty() ? -1 : send((const uint8_t*)data.data(), data.size(), msgId);
+}
+int LocIpcSender::sendBatch(const struct iovec msgs[], int count) const {
+    int sent = 0;
+    for (; nullptr != msgs && sent < count; sent++) {
+        if (send((const uint8_t*)msgs[sent].iov_base, msgs[sent].iov_len, -1) <= 0) {
+            break;
+        }
+    }
+    return sent;
+}
 
 shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName) {
     return make_shared<LocIpcLocalSender>(localSockName);
 }
+shared_ptr<LocIpcSender> LocIpc::getSharedLocIpcLocalSender(const char* localSockName) {
+    static mutex sLock;
+    static unordered_map<string, weak_ptr<LocIpcSender>> sSenders;
+    lock_guard<mutex> lock(sLock);
+    weak_ptr<LocIpcSender>& shared = sSenders[localSockName];
+    shared_ptr<LocIpcSender> sender = shared.lock();
+    if (nullptr == sender) {
+        sender = make_shared<LocIpcLocalSender>(localSockName);
+        shared = sender;
+    }
+    return sender;
+}
 unique_ptr<LocIpcRecver> LocIpc::getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
                                                       const char* localSockName) {
     return make_unique<LocIpcLocalRecver>(listener, localSockName);
@@ -32,11 +32,17 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unordered_set>
+#include <unordered_map>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <LocThread.h>
 
 using namespace std;
@@ -54,6 +60,14 @@ public:
     // when the socket for LocIpc is ready to receive messages.
     inline virtual void onListenerReady() {}
     virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver* recver) = 0;
+    // LocIpc client can overwrite this function to take over the file
+    // descriptors the peer passed with LocIpcSender::sendFds(), e.g. those
+    // of a LocIpcShmRecver. Whatever is not taken over is closed.
+    inline virtual void onReceiveFds(const int fds[], int count, const LocIpcRecver* recver) {
+        for (int i = 0; i < count; i++) {
+            ::close(fds[i]);
+        }
+    }
 };
 
 class LocIpcQrtrWatcher {
@@ -95,6 +109,11 @@ public:
 
     static shared_ptr<LocIpcSender>
             getLocIpcLocalSender(const char* localSockName);
+    // Same as getLocIpcLocalSender(), but all callers in the process that
+    // ask for the same socket while one is alive share a single sender.
+    // The sender must not be re-targeted with copyDestAddrFrom().
+    static shared_ptr<LocIpcSender>
+            getSharedLocIpcLocalSender(const char* localSockName);
     static shared_ptr<LocIpcSender>
             getLocIpcInetUdpSender(const char* serverName, int32_t port);
     static shared_ptr<LocIpcSender>
@@ -147,11 +166,101 @@ public:
     // The function will return true on success, and false on failure.
     static bool send(LocIpcSender& sender, const uint8_t data[],
                      uint32_t length, int32_t msgId = -1);
+    // Send out a message that is scattered over iovcnt buffers in iov, e.g. a
+    // header and a serialized payload, without concatenating them first.
+    // The receiver gets them as one message in a single onReceive().
+    static bool sendv(LocIpcSender& sender, const struct iovec iov[],
+                      int iovcnt, int32_t msgId = -1);
+    // Send out count messages in order, msgs[i] being the whole of message i,
+    // with as few syscalls as the sender allows. Each message is received
+    // in a onReceive() of its own.
+    // Returns the number of leading messages sent; less than count on failure.
+    static int sendBatch(LocIpcSender& sender, const struct iovec msgs[], int count);
+
+    // Shared memory transport for a local peer that sockSender already
+    // reaches. A ring of ringSize bytes is set up in a memfd and offered to
+    // the peer over sockSender, together with an eventfd for notification.
+    // Until the peer has taken the ring over through getLocIpcShmRecver(), and
+    // whenever a message does not fit into the ring, the returned sender
+    // falls back to sockSender. Returns sockSender if no ring can be set up.
+    static shared_ptr<LocIpcSender>
+            getLocIpcShmSender(const shared_ptr<LocIpcSender>& sockSender,
+                               uint32_t ringSize = 256 * 1024);
+    // Peer side of getLocIpcShmSender(), to be called from
+    // ILocIpcListener::onReceiveFds() with the fds received there.
+    static unique_ptr<LocIpcRecver>
+            getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                               const int fds[], int count);
 
 private:
     LocThread mThread;
 };
 
+// Serves any number of LocIpcRecvers from a single thread, in place of one
+// LocIpc (and so one thread) per recver. The recvers' sockets are watched
+// edge triggered in one epoll set; an eventfd wakes the serving thread up
+// for newly added recvers and for stop(), so no abort message has to be
+// looped back through the sockets.
+// Only recvers that report their socket through getRecvFd() can be added.
+class LocIpcReactor {
+public:
+    LocIpcReactor();
+    virtual ~LocIpcReactor();
+
+    // The reactor shared by all clients of the hal daemon in this process,
+    // already serving on its own thread; it lives until the process exits.
+    static LocIpcReactor& getProcessReactor();
+
+    // Takes over ipcRecver. Its onListenerReady() is called from the serving
+    // thread, before its first message is received. A recver whose recvData()
+    // fails, e.g. on peer abort, is dropped from the reactor.
+    // owner tags the recver for removeOwner().
+    bool add(unique_ptr<LocIpcRecver>& ipcRecver, const void* owner = nullptr);
+    // Watches any other readable fd, e.g. the eventfd of a MsgTask, a
+    // timerfd or a QMI fd, so that one thread serves them all. The fd is
+    // watched level triggered and onReadable is called from the serving
+    // thread until it has consumed what is pending. The caller keeps
+    // owning fd, and must have it removed with removeOwner() before it is
+    // closed.
+    bool addFd(int fd, const function<void()>& onReadable, const void* owner = nullptr);
+    // Stops serving and destroys all recvers added with owner. Returns only
+    // once the serving thread is done with them, so their listeners are not
+    // called any more; called from the serving thread itself, they go right
+    // after the current event.
+    void removeOwner(const void* owner);
+    // Serve the recvers in a new LocThread; returns immediately.
+    bool startNonBlocking(const char* threadName = "LocIpcReactor");
+    // Serve the recvers in the calling thread; returns after stop().
+    bool startBlocking();
+    void stop();
+
+private:
+    friend class LocIpcReactorRunnable;
+    bool runOnce();
+    void wakeUp() const;
+    void addPending();
+    void removePendingOwners();
+    void drain(int fd);
+    void remove(int fd);
+
+    int mEpollFd;
+    int mEventFd;
+    bool mStopped;
+    bool mServing;
+    atomic<pid_t> mServingTid;
+    mutex mLock;
+    condition_variable mRemovedCond;
+    vector<pair<unique_ptr<LocIpcRecver>, const void*>> mPendingRecvers;
+    vector<pair<int, pair<function<void()>, const void*>>> mPendingFds;
+    vector<const void*> mPendingRemovals;
+    uint64_t mRemovalsPosted;
+    uint64_t mRemovalsDone;
+    // accessed only by the serving thread
+    unordered_map<int, pair<unique_ptr<LocIpcRecver>, const void*>> mRecvers;
+    unordered_map<int, pair<function<void()>, const void*>> mFds;
+    LocThread mThread;
+};
+
 /* this is only when client needs to implement Sender / Recver that are not already provided by
    the factor methods prvoided by LocIpc. */
 
@@ -160,16 +269,30 @@ protected:
     LocIpcSender() = default;
     virtual bool isOperable() const = 0;
     virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const = 0;
+    // default falls back to gathering iov into one buffer for send(); socket
+    // based senders override this to hand iov to the kernel as is.
+    virtual ssize_t sendv(const struct iovec iov[], int iovcnt, int32_t msgId) const;
+    // default falls back to one send() per message; socket based senders
+    // override this to hand the whole batch to the kernel at once.
+    virtual int sendBatch(const struct iovec msgs[], int count) const;
 public:
     virtual ~LocIpcSender() = default;
     inline bool isSendable() const { return isOperable(); }
     inline bool sendData(const uint8_t data[], uint32_t length, int32_t msgId) const {
         return isSendable() && (send(data, length, msgId) > 0);
     }
+    inline bool sendDataV(const struct iovec iov[], int iovcnt, int32_t msgId) const {
+        return isSendable() && (sendv(iov, iovcnt, msgId) > 0);
+    }
+    inline int sendDataBatch(const struct iovec msgs[], int count) const {
+        return isSendable() ? sendBatch(msgs, count) : 0;
+    }
     virtual unique_ptr<LocIpcRecver> getRecver(const shared_ptr<ILocIpcListener>& listener) {
         return nullptr;
     }
     inline virtual void copyDestAddrFrom(const LocIpcSender& otherSender) {}
+    // pass file descriptors on to the peer, see ILocIpcListener::onReceiveFds()
+    inline virtual ssize_t sendFds(const int fds[], int count) const { return -1; }
 };
 
 class LocIpcRecver {
@@ -191,26 +314,97 @@ public:
     }
     virtual void abort() const = 0;
     virtual const char* getName() const = 0;
+    // socket to be watched when served by a LocIpcReactor; -1 if the recver
+    // can only be served by a blocking loop of its own
+    inline virtual int getRecvFd() const { return -1; }
+    // >= 0 if recv() would not block, else -1 with errno set, EAGAIN if
+    // nothing is pending. Peeks at getRecvFd() by default.
+    virtual ssize_t peekRecv() const;
 };
 
 class Sock {
     static const char MSG_ABORT[];
+    static const char MSG_FDS[];
+    static const int MAX_FDS = 4;
+    // legacy text head of fragmented messages, only parsed on receive
     static const char LOC_IPC_HEAD[];
+    // binary head of messages longer than mMaxTxSize. It leads the first
+    // fragment, which also carries the first bytes of the payload.
+    struct FrameHead {
+        uint32_t mMagic;
+        uint32_t mLen;
+    };
+    static const uint32_t FRAME_MAGIC = 0x4650494c; // "LIPF"
     const uint32_t mMaxTxSize;
-    ssize_t sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
-                   socklen_t addrlen) const;
+    const int mSockType;
+    // receive buffer, reused across recvfrom() calls so that steady state
+    // receives do not allocate. Only ever touched by the receiving thread.
+    mutable vector<char> mRxBuf;
+    mutable int mRxFds[MAX_FDS];
+    mutable int mRxFdCount;
+    // datagrams of the last recvmmsg(), mMaxTxSize bytes each, and the ones
+    // of them still to be delivered. Only ever touched by the receiving thread.
+    mutable vector<char> mRxBatch;
+    mutable vector<struct mmsghdr> mRxMsgs;
+    mutable vector<struct iovec> mRxIovs;
+    mutable vector<struct sockaddr_storage> mRxAddrs;
+    mutable int mRxBatchNext;
+    mutable int mRxBatchCount;
+    ssize_t recvInto(int sid, size_t offset, size_t len, int flags,
+                     struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    // the next fragment of a long message, taken from the current batch
+    // first, if any, and only then from the socket
+    ssize_t recvFragment(int sid, size_t offset, size_t len, int flags,
+                         struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvmmsgs(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                      int batchSize, int flags,
+                      struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t sendmsgs(const struct iovec iov[], int iovcnt, size_t len, int flags,
+                     const struct sockaddr *destAddr, socklen_t addrlen) const;
+    static inline int sockType(int sid) {
+        int type = SOCK_DGRAM;
+        socklen_t size = sizeof(type);
+        if (-1 != sid) {
+            getsockopt(sid, SOL_SOCKET, SO_TYPE, &type, &size);
+        }
+        return type;
+    }
     ssize_t recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    // hands the nBytes of a first datagram in data to dataCb, after having
+    // received the rest of it if it leads a long message
+    ssize_t deliver(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                    int sid, int flags, const char* data, ssize_t nBytes,
+                    struct sockaddr *srcAddr, socklen_t *addrlen) const;
 public:
     int mSid;
-    inline Sock(int sid, const uint32_t maxTxSize = 8192) : mMaxTxSize(maxTxSize), mSid(sid) {}
+    inline Sock(int sid, const uint32_t maxTxSize = 8192) :
+            mMaxTxSize(maxTxSize), mSockType(sockType(sid)), mRxFdCount(0),
+            mRxBatchNext(0), mRxBatchCount(0), mSid(sid) {}
     inline ~Sock() { close(); }
     inline bool isValid() const { return -1 != mSid; }
     ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                  socklen_t addrlen) const;
+    ssize_t sendv(const struct iovec iov[], int iovcnt, int flags,
+                  const struct sockaddr *destAddr, socklen_t addrlen) const;
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
+    // Sends each of msgs[] as a message of its own; runs of messages that
+    // fit into one datagram go out in as few sendmmsg() as the kernel
+    // allows. Returns the number of leading messages sent.
+    int sendBatch(const struct iovec msgs[], int count, int flags,
+                  const struct sockaddr *destAddr, socklen_t addrlen) const;
+    // recv() for datagram sockets, taking up to batchSize datagrams off the
+    // socket in one recvmmsg(). srcAddr is set to the sender of each message
+    // before it is handed to dataCb. With busyPollUs > 0 the socket is then
+    // polled without blocking for that long, so that the rest of a burst is
+    // served before the caller goes back to sleep.
+    ssize_t recvBatch(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                      int batchSize, uint32_t busyPollUs,
+                      struct sockaddr *srcAddr, socklen_t *addrlen) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
+    ssize_t sendFds(const int fds[], int count, int flags,
+                    const struct sockaddr *destAddr, socklen_t addrlen) const;
     inline void close() {
         if (isValid()) {
             ::close(mSid);
@@ -234,6 +428,7 @@ public:
         return "SockRecver";
     }
     inline virtual void abort() const override {}
+    inline virtual int getRecvFd() const override { return mSock->mSid; }
 };
 
 }
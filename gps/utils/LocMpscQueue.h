@@ -0,0 +1,145 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_MPSC_QUEUE_H__
+#define __LOC_MPSC_QUEUE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace loc_util {
+
+// Bounded multi-producer / single-consumer ring of pointers, based on
+// the per-cell sequence number scheme (D. Vyukov). Producers never take
+// a lock and the ring never allocates after construction.
+// push() returns false when the ring is full; what to do with the element
+// is left to the caller. pop(), empty() must only be called from the one
+// consumer thread.
+template <typename T>
+class LocMpscQueue {
+    struct Cell {
+        std::atomic<size_t> mSeq;
+        T* mData;
+    };
+    // keep producer and consumer cursors on separate cache lines
+    std::atomic<size_t> mEnqueuePos;
+    char mPad[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mDequeuePos;
+    const size_t mMask;
+    std::unique_ptr<Cell[]> mCells;
+
+    static inline size_t roundUpPow2(size_t n) {
+        size_t size = 2;
+        while (size < n) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+public:
+    // capacity is rounded up to the next power of 2
+    inline LocMpscQueue(size_t capacity) :
+            mEnqueuePos(0), mDequeuePos(0), mMask(roundUpPow2(capacity) - 1),
+            mCells(new Cell[mMask + 1]) {
+        for (size_t i = 0; i <= mMask; i++) {
+            mCells[i].mSeq.store(i, std::memory_order_relaxed);
+            mCells[i].mData = nullptr;
+        }
+    }
+    inline ~LocMpscQueue() = default;
+    LocMpscQueue(const LocMpscQueue&) = delete;
+    LocMpscQueue& operator=(const LocMpscQueue&) = delete;
+
+    inline size_t capacity() const { return mMask + 1; }
+
+    // safe to call from any thread
+    bool push(T* data) {
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &mCells[pos & mMask];
+            size_t seq = cell->mSeq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (0 == diff) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the slot still holds an element one lap behind, ring is full
+                return false;
+            } else {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->mData = data;
+        cell->mSeq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only; returns nullptr if empty
+    T* pop() {
+        size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = &mCells[pos & mMask];
+        while (cell->mSeq.load(std::memory_order_acquire) != pos + 1) {
+            if (mEnqueuePos.load(std::memory_order_acquire) == pos) {
+                return nullptr;
+            }
+            // the slot is claimed by a producer that has not yet published
+            // into it. It is a few instructions away from doing so, and
+            // skipping over it would reorder that producer's messages.
+            std::this_thread::yield();
+        }
+        T* data = cell->mData;
+        cell->mData = nullptr;
+        cell->mSeq.store(pos + mMask + 1, std::memory_order_release);
+        mDequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return data;
+    }
+
+    // consumer thread only. A slot claimed but not yet published counts
+    // as non empty.
+    inline bool empty() const {
+        return mEnqueuePos.load(std::memory_order_acquire) ==
+                mDequeuePos.load(std::memory_order_relaxed);
+    }
+
+    // approximate, for stats only
+    inline size_t size() const {
+        size_t enq = mEnqueuePos.load(std::memory_order_relaxed);
+        size_t deq = mDequeuePos.load(std::memory_order_relaxed);
+        return (enq > deq) ? (enq - deq) : 0;
+    }
+};
+
+} // namespace loc_util
+
+#endif //__LOC_MPSC_QUEUE_H__
@@ -0,0 +1,128 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_SV_EPOCH_H__
+#define __LOC_SV_EPOCH_H__
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <gps_extended_c.h>
+
+namespace loc_util {
+
+// The SVs of one report merged per satellite. In multi-band mode the report
+// has an entry per signal of each satellite; here each satellite is one
+// record, with the entries of its signals as a sub-array, and the records
+// are ordered by constellation and SV id. Built once per report, so that the
+// consumers walk the satellites of a constellation rather than each scanning
+// and regrouping the whole report.
+class LocSvEpoch {
+public:
+    static const uint32_t MAX_BANDS = 4;
+    struct Satellite {
+        GnssSvType type;
+        uint16_t svId;
+        GnssSvOptionsMask optionsMask; // OR of the masks of its signals
+        uint8_t bandCount;
+        uint8_t bands[MAX_BANDS];      // entries of its signals in the report
+    };
+
+    inline LocSvEpoch() : mReport(nullptr), mTypeBegin{} {
+        mSatellites.reserve(GNSS_SV_MAX);
+    }
+
+    // Merges svNotify, which has to outlive the use of the epoch
+    inline void build(const GnssSvNotification& svNotify) {
+        mReport = &svNotify;
+        mSatellites.clear();
+        uint32_t count = std::min<uint32_t>(svNotify.count, GNSS_SV_MAX);
+
+        // entries by constellation and SV id, in report order within a satellite
+        uint8_t order[GNSS_SV_MAX];
+        for (uint32_t i = 0; i < count; i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order, order + count, [&svNotify] (uint8_t a, uint8_t b) {
+            const GnssSv& svA = svNotify.gnssSvs[a];
+            const GnssSv& svB = svNotify.gnssSvs[b];
+            return typeSlot(svA.type) < typeSlot(svB.type) ||
+                    (svA.type == svB.type && svA.svId < svB.svId);
+        });
+
+        uint32_t slot = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            const GnssSv& sv = svNotify.gnssSvs[order[i]];
+            Satellite* sat = mSatellites.empty() ? nullptr : &mSatellites.back();
+            // a GLONASS SV of unknown slot can not be told apart from another
+            if (nullptr == sat || sat->type != sv.type || sat->svId != sv.svId ||
+                    sat->bandCount == MAX_BANDS ||
+                    (GNSS_SV_TYPE_GLONASS == sv.type && GLO_SV_PRN_SLOT_UNKNOWN == sv.svId)) {
+                for (uint32_t s = typeSlot(sv.type); slot < s; ) {
+                    mTypeBegin[++slot] = mSatellites.size();
+                }
+                mSatellites.push_back({sv.type, sv.svId, 0, 0, {}});
+                sat = &mSatellites.back();
+            }
+            sat->optionsMask |= sv.gnssSvOptionsMask;
+            sat->bands[sat->bandCount++] = order[i];
+        }
+        while (slot < TYPE_SLOTS) {
+            mTypeBegin[++slot] = mSatellites.size();
+        }
+    }
+
+    inline const GnssSvNotification& report() const { return *mReport; }
+    inline size_t size() const { return mSatellites.size(); }
+    // the satellites of a constellation
+    inline const Satellite* begin(GnssSvType type) const {
+        return mSatellites.data() + mTypeBegin[typeSlot(type)];
+    }
+    inline const Satellite* end(GnssSvType type) const {
+        return mSatellites.data() + mTypeBegin[typeSlot(type) + 1];
+    }
+    inline const GnssSv& band(const Satellite& sat, uint32_t b) const {
+        return mReport->gnssSvs[sat.bands[b]];
+    }
+
+private:
+    // GnssSvType values, with the unknown ones in slot 0
+    static const uint32_t TYPE_SLOTS = GNSS_SV_TYPE_NAVIC + 1;
+    static inline uint32_t typeSlot(GnssSvType type) {
+        return (type < TYPE_SLOTS) ? type : GNSS_SV_TYPE_UNKNOWN;
+    }
+
+    const GnssSvNotification* mReport;
+    std::vector<Satellite> mSatellites;
+    // first satellite of each type slot, and the end of the last
+    uint32_t mTypeBegin[TYPE_SLOTS + 1];
+};
+
+} // namespace loc_util
+
+#endif // __LOC_SV_EPOCH_H__
@@ -26,20 +26,216 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  */
+#define LOG_TAG "LocSvc_LocThread"
+
 #include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <LocThread.h>
 #include <string.h>
 #include <string>
 #include <thread>
+#include <vector>
 #include <loc_pla.h>
+#include <loc_cfg.h>
+#include <log_util.h>
 
 using std::weak_ptr;
 using std::shared_ptr;
 using std::thread;
 using std::string;
+using std::vector;
 
 namespace loc_util {
 
+/* Per thread scheduling policy from gps.conf, THREAD_QOS_1 .. THREAD_QOS_n:
+     <thread name prefix> <cpu list> <priority> <uclamp min> <uclamp max>
+   The first entry whose prefix matches the thread name is applied when the
+   thread starts, after the runnable's prerun(). "-" leaves a field alone;
+   priority is a nice value, or rtN for SCHED_FIFO priority N. */
+#define LOC_THREAD_QOS_MAX_ENTRIES 8
+
+#ifndef SCHED_FLAG_KEEP_POLICY
+#define SCHED_FLAG_KEEP_POLICY      0x08
+#define SCHED_FLAG_KEEP_PARAMS      0x10
+#define SCHED_FLAG_UTIL_CLAMP_MIN   0x20
+#define SCHED_FLAG_UTIL_CLAMP_MAX   0x40
+#endif
+
+struct LocSchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+
+struct LocThreadQos {
+    string namePrefix;
+    bool hasCpus;
+    cpu_set_t cpus;
+    bool hasNice;
+    int nice;
+    int rtPriority;   // 0 for none
+    int uclampMin;    // -1 to leave alone
+    int uclampMax;    // -1 to leave alone
+};
+
+static bool parseCpuList(const char* str, cpu_set_t& cpus) {
+    CPU_ZERO(&cpus);
+    while ('\0' != *str) {
+        char* end;
+        long first = strtol(str, &end, 10);
+        if (end == str || first < 0 || first >= CPU_SETSIZE) {
+            return false;
+        }
+        long last = first;
+        str = end;
+        if ('-' == *str) {
+            last = strtol(str + 1, &end, 10);
+            if (end == str + 1 || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            str = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, &cpus);
+        }
+        if (',' == *str) {
+            str++;
+        } else if ('\0' != *str) {
+            return false;
+        }
+    }
+    return CPU_COUNT(&cpus) > 0;
+}
+
+static bool parseThreadQos(char* entry, LocThreadQos& qos) {
+    char* fields[5] = {};
+    char* tmp = nullptr;
+    int n = 0;
+    for (char* tok = strtok_r(entry, " \t", &tmp); nullptr != tok && n < 5;
+            tok = strtok_r(nullptr, " \t", &tmp)) {
+        fields[n++] = tok;
+    }
+    if (n < 2) {
+        return false;
+    }
+
+    qos.namePrefix = fields[0];
+    qos.hasCpus = false;
+    qos.hasNice = false;
+    qos.rtPriority = 0;
+    qos.uclampMin = -1;
+    qos.uclampMax = -1;
+
+    if (0 != strcmp(fields[1], "-")) {
+        if (!parseCpuList(fields[1], qos.cpus)) {
+            return false;
+        }
+        qos.hasCpus = true;
+    }
+    if (n > 2 && 0 != strcmp(fields[2], "-")) {
+        if (0 == strncmp(fields[2], "rt", 2)) {
+            qos.rtPriority = atoi(fields[2] + 2);
+            if (qos.rtPriority < 1 || qos.rtPriority > 99) {
+                return false;
+            }
+        } else {
+            qos.nice = atoi(fields[2]);
+            qos.hasNice = true;
+        }
+    }
+    if (n > 3 && 0 != strcmp(fields[3], "-")) {
+        qos.uclampMin = atoi(fields[3]);
+    }
+    if (n > 4 && 0 != strcmp(fields[4], "-")) {
+        qos.uclampMax = atoi(fields[4]);
+    }
+    return true;
+}
+
+static const vector<LocThreadQos>& getThreadQosPolicies() {
+    static const vector<LocThreadQos> sPolicies = [] {
+        vector<LocThreadQos> policies;
+        char entries[LOC_THREAD_QOS_MAX_ENTRIES][LOC_MAX_PARAM_STRING] = {};
+        string names[LOC_THREAD_QOS_MAX_ENTRIES];
+        loc_param_s_type qosTable[LOC_THREAD_QOS_MAX_ENTRIES];
+        for (int i = 0; i < LOC_THREAD_QOS_MAX_ENTRIES; i++) {
+            names[i] = "THREAD_QOS_" + std::to_string(i + 1);
+            qosTable[i] = {names[i].c_str(), &entries[i], nullptr, 's'};
+        }
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF_STR, qosTable);
+
+        for (int i = 0; i < LOC_THREAD_QOS_MAX_ENTRIES; i++) {
+            if ('\0' == entries[i][0]) {
+                continue;
+            }
+            LocThreadQos qos;
+            if (parseThreadQos(entries[i], qos)) {
+                policies.push_back(qos);
+            } else {
+                LOC_LOGe("ignoring malformed %s", names[i].c_str());
+            }
+        }
+        return policies;
+    }();
+    return sPolicies;
+}
+
+static void applyThreadQos(const string& tName) {
+    for (const LocThreadQos& qos : getThreadQosPolicies()) {
+        if (0 != tName.compare(0, qos.namePrefix.size(), qos.namePrefix)) {
+            continue;
+        }
+
+        pid_t tid = gettid();
+        if (qos.hasCpus && 0 != sched_setaffinity(tid, sizeof(qos.cpus), &qos.cpus)) {
+            LOC_LOGw("%s: sched_setaffinity failed: %s", tName.c_str(), strerror(errno));
+        }
+        if (qos.rtPriority > 0) {
+            struct sched_param param = {};
+            param.sched_priority = qos.rtPriority;
+            if (0 != sched_setscheduler(tid, SCHED_FIFO, &param)) {
+                LOC_LOGw("%s: SCHED_FIFO %d failed: %s",
+                         tName.c_str(), qos.rtPriority, strerror(errno));
+            }
+        } else if (qos.hasNice && 0 != setpriority(PRIO_PROCESS, tid, qos.nice)) {
+            LOC_LOGw("%s: nice %d failed: %s", tName.c_str(), qos.nice, strerror(errno));
+        }
+#ifdef __NR_sched_setattr
+        if (qos.uclampMin >= 0 || qos.uclampMax >= 0) {
+            LocSchedAttr attr = {};
+            attr.size = sizeof(attr);
+            attr.sched_flags = SCHED_FLAG_KEEP_POLICY | SCHED_FLAG_KEEP_PARAMS;
+            if (qos.uclampMin >= 0) {
+                attr.sched_flags |= SCHED_FLAG_UTIL_CLAMP_MIN;
+                attr.sched_util_min = qos.uclampMin;
+            }
+            if (qos.uclampMax >= 0) {
+                attr.sched_flags |= SCHED_FLAG_UTIL_CLAMP_MAX;
+                attr.sched_util_max = qos.uclampMax;
+            }
+            if (0 != syscall(__NR_sched_setattr, tid, &attr, 0)) {
+                LOC_LOGw("%s: uclamp %d-%d failed: %s", tName.c_str(),
+                         qos.uclampMin, qos.uclampMax, strerror(errno));
+            }
+        }
+#endif
+        LOC_LOGd("%s: applied %s", tName.c_str(), qos.namePrefix.c_str());
+        return;
+    }
+}
+
 class LocThreadDelegate {
     static const char defaultThreadName[];
     weak_ptr<LocRunnable> mRunnable;
@@ -82,6 +278,7 @@ LocThreadDelegate::LocThreadDelegate(const string tName, shared_ptr<LocRunnable>
         mThread([tName, runnable] {
                 prctl(PR_SET_NAME, tName.c_str(), 0, 0, 0);
                 runnable->prerun();
+                applyThreadQos(tName);
                 while (runnable->run());
                 runnable->postrun();
             }) {
@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
+#include <algorithm>
 #include <log_util.h>
 #include <loc_timer.h>
 #include <LocTimer.h>
@@ -51,8 +52,9 @@
 namespace loc_util {
 
 /*
-There are implementations of 5 classes in this file:
-LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerPollTask, LocTimerWrapper
+There are implementations of 8 classes in this file:
+LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerStore, LocTimerHeapStore,
+LocTimerWheel, LocTimerPollTask, LocTimerWrapper
 
 LocTimer - client front end, interface for client to start / stop timers, also
            to provide a callback.
@@ -66,14 +68,19 @@ LocTimerDelegate - an internal timer entity, which also is a LocRankable obj.
                    is also a LocRankable obj, and LocTimerContainer also is a
                    heap, its ranks() implementation decides where it is placed
                    in the heap.
-LocTimerContainer - core of the timer service. It is a container (derived from
-                    LocHeap) for LocTimerDelegate (implements LocRankable) objs.
-                    There are 2 of such containers, one for sw timers (or Linux
-                    timers) one for hw timers (or Linux alarms). It adds one of
-                    each (those that expire the soonest) to kernel via services
-                    provided by LocTimerPollTask. All the heap management on the
-                    LocTimerDelegate objs are done in the MsgTask context, such
-                    that synchronization is ensured.
+LocTimerContainer - core of the timer service. It is a container for
+                    LocTimerDelegate (implements LocRankable) objs, kept in a
+                    LocTimerStore. There are 2 of such containers, one for sw
+                    timers (or Linux timers) one for hw timers (or Linux alarms).
+                    It adds one of each (those that expire the soonest) to kernel
+                    via services provided by LocTimerPollTask, and only touches
+                    the timerfd when that soonest time actually changes. All the
+                    store management on the LocTimerDelegate objs are done in the
+                    MsgTask context, such that synchronization is ensured.
+LocTimerStore - the ordered storage of a container. LocTimerHeapStore keeps the
+                timers in a LocDaryHeap, O(log n) add and remove. LocTimerWheel
+                is a hierarchical timing wheel with O(1) add and remove, used
+                when enabled by loc_timer_use_wheel().
 LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
                    both implements LocRunnalbe with epoll_wait() in the run()
                    method. It is also a LocThread client, so as to loop the run
@@ -84,16 +91,30 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 */
 
 class LocTimerPollTask;
+class LocTimerDelegate;
+
+// Ordered storage of the ticking timers of a container. All these are called
+// in the MsgTask context only.
+class LocTimerStore {
+public:
+    virtual ~LocTimerStore() = default;
+    virtual void add(LocTimerDelegate& timer) = 0;
+    // returns true if timer was in the store
+    virtual bool remove(LocTimerDelegate& timer) = 0;
+    // time the soonest timer in the store is due; false if the store is empty
+    virtual bool getSoonestTime(struct timespec& soonest) = 0;
+    // takes out a timer that is due at or before now, or returns NULL
+    virtual LocTimerDelegate* popExpired(const struct timespec& now) = 0;
+};
 
 // This is a multi-functaional class that:
-// * extends the LocHeap class for the detection of head update upon add / remove
-//   events. When that happens, soonest time out changes, so timerfd needs update.
-// * contains the timers, and add / remove them into the heap
+// * owns the LocTimerStore of the timers, and add / remove them into it. When
+//   that changes the soonest time out, timerfd gets updated.
 // * provides and maps 2 of such containers, one for timers (or  mSwTimers), one
 //   for alarms (or mHwTimers);
 // * provides a polling thread;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
-class LocTimerContainer : public LocHeap {
+class LocTimerContainer {
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -104,24 +125,30 @@ class LocTimerContainer : public LocHeap {
     static MsgTask* mMsgTask;
     // Poll task to provide epoll call and threading to poll.
     static LocTimerPollTask* mPollTask;
+    // true to have the containers created with a LocTimerWheel store
+    static bool mUseWheel;
     // timer / alarm fd
     int mDevFd;
+    // the timers
+    LocTimerStore* mStore;
+    // what timerfd is currently armed with, so that it is only reprogrammed
+    // when the soonest time out actually changes
+    bool mArmed;
+    struct timespec mArmedTime;
     // ctor
     LocTimerContainer(bool wakeOnExpire);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
-    // extend LocHeap and pop if the top outRanks input
-    LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
     // update the timer POSIX calls with updated soonest timer spec
-    void updateSoonestTime(LocTimerDelegate* priorTop);
+    void updateSoonestTime();
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
+    static inline void setUseWheel(bool useWheel) { mUseWheel = useWheel; }
 
-    LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
     // add a timer / alarm obj into the container
     void add(LocTimerDelegate& timer);
@@ -187,14 +214,22 @@ public:
 // the container (of LocHeap), it gets placed in sorted order.
 class LocTimerDelegate : public LocRankable {
     friend class LocTimerContainer;
+    friend class LocTimerHeapStore;
+    friend class LocTimerWheel;
     friend class LocTimer;
     LocTimer* mClient;
     LocSharedLock* mLock;
     struct timespec mFutureTime;
     LocTimerContainer* mContainer;
+    // LocTimerWheel linkage; mWheelLevel is -1 while not in a wheel
+    LocTimerDelegate* mWheelPrev;
+    LocTimerDelegate* mWheelNext;
+    int mWheelLevel;
+    uint32_t mWheelSlot;
     // not a complete obj, just ctor for LocRankable comparisons
-    inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
+    inline LocTimerDelegate(const struct timespec& delay)
+        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL),
+          mWheelPrev(NULL), mWheelNext(NULL), mWheelLevel(-1), mWheelSlot(0) {}
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
     LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
@@ -217,12 +252,211 @@ LocTimerContainer* LocTimerContainer::mSwTimers = NULL;
 LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
+bool LocTimerContainer::mUseWheel = false;
+
+static inline uint64_t timespecToMs(const struct timespec& time, bool roundUp = false) {
+    return (uint64_t)time.tv_sec * 1000 + (time.tv_nsec + (roundUp ? 999999 : 0)) / 1000000;
+}
+
+static inline struct timespec msToTimespec(uint64_t ms) {
+    struct timespec time;
+    time.tv_sec = ms / 1000;
+    time.tv_nsec = (ms % 1000) * 1000000;
+    return time;
+}
+
+/***************************LocTimerStore methods*******************************/
+
+class LocTimerHeapStore : public LocTimerStore {
+    LocDaryHeap mHeap;
+public:
+    inline virtual void add(LocTimerDelegate& timer) override {
+        mHeap.push((LocRankable&)timer);
+    }
+    inline virtual bool remove(LocTimerDelegate& timer) override {
+        return NULL != mHeap.remove((LocRankable&)timer);
+    }
+    inline virtual bool getSoonestTime(struct timespec& soonest) override {
+        LocTimerDelegate* top = (LocTimerDelegate*)mHeap.peek();
+        if (top) {
+            soonest = top->getFutureTime();
+        }
+        return NULL != top;
+    }
+    inline virtual LocTimerDelegate* popExpired(const struct timespec& now) override {
+        LocTimerDelegate timerOfNow(now);
+        LocTimerDelegate* top = (LocTimerDelegate*)mHeap.peek();
+        return (top && !timerOfNow.outRanks(*top)) ? (LocTimerDelegate*)mHeap.pop() : NULL;
+    }
+};
+
+// A hierarchical timing wheel in ms ticks, with levels of 64 slots each, so
+// that level n spans 64^(n+1) ms. A timer goes into the level of the highest
+// 6 bit group in which its due time differs from mNowMs, at the slot of that
+// group's value. When mNowMs enters a slot of level n > 0, the slot's timers
+// are cascaded down to lower levels, until in level 0 they are due at the
+// exact ms of their slot. Each slot is an intrusive doubly linked list, so add
+// and remove are O(1) and allocation free.
+// Slots above level 0 also keep the soonest due time added to them, so that
+// timerfd is armed for the soonest timer rather than for the next cascade.
+// A removal may leave that a bit too early, which only costs an early wakeup.
+class LocTimerWheel : public LocTimerStore {
+    static const int LEVELS = 7;
+    static const int SLOT_BITS = 6;
+    static const uint32_t SLOTS = 1 << SLOT_BITS;
+    uint64_t mNowMs;
+    uint64_t mBitmap[LEVELS];
+    LocTimerDelegate* mSlots[LEVELS][SLOTS];
+    uint64_t mSlotSoonestMs[LEVELS][SLOTS];
+
+    static inline uint32_t slotOf(uint64_t ms, int level) {
+        return (ms >> (level * SLOT_BITS)) & (SLOTS - 1);
+    }
+    // start of the slot of level, out of those ahead of mNowMs
+    inline uint64_t slotStartMs(int level, uint32_t slot) const {
+        uint64_t upper = mNowMs >> ((level + 1) * SLOT_BITS) << ((level + 1) * SLOT_BITS);
+        return upper | ((uint64_t)slot << (level * SLOT_BITS));
+    }
+    // first occupied slot of level at or after mNowMs's slot, or SLOTS
+    inline uint32_t firstSlot(int level) const {
+        uint32_t cur = slotOf(mNowMs, level);
+        uint64_t ahead = mBitmap[level] & (~0ULL << cur);
+        return (0 == ahead) ? SLOTS : __builtin_ctzll(ahead);
+    }
+    void link(LocTimerDelegate& timer) {
+        uint64_t dueMs = timespecToMs(timer.mFutureTime, true);
+        if (dueMs < mNowMs) {
+            dueMs = mNowMs;
+        }
+        uint64_t diff = dueMs ^ mNowMs;
+        int level = (0 == diff) ? 0 : (63 - __builtin_clzll(diff)) / SLOT_BITS;
+        if (level >= LEVELS) {
+            level = LEVELS - 1;
+        }
+        uint32_t slot = slotOf(dueMs, level);
+        timer.mWheelLevel = level;
+        timer.mWheelSlot = slot;
+        timer.mWheelPrev = NULL;
+        timer.mWheelNext = mSlots[level][slot];
+        if (timer.mWheelNext) {
+            timer.mWheelNext->mWheelPrev = &timer;
+        }
+        mSlots[level][slot] = &timer;
+        mBitmap[level] |= (1ULL << slot);
+        if (dueMs < mSlotSoonestMs[level][slot]) {
+            mSlotSoonestMs[level][slot] = dueMs;
+        }
+    }
+    void unlink(LocTimerDelegate& timer) {
+        int level = timer.mWheelLevel;
+        uint32_t slot = timer.mWheelSlot;
+        if (timer.mWheelPrev) {
+            timer.mWheelPrev->mWheelNext = timer.mWheelNext;
+        } else {
+            mSlots[level][slot] = timer.mWheelNext;
+        }
+        if (timer.mWheelNext) {
+            timer.mWheelNext->mWheelPrev = timer.mWheelPrev;
+        }
+        if (NULL == mSlots[level][slot]) {
+            mBitmap[level] &= ~(1ULL << slot);
+            mSlotSoonestMs[level][slot] = UINT64_MAX;
+        }
+        timer.mWheelPrev = timer.mWheelNext = NULL;
+        timer.mWheelLevel = -1;
+    }
+    // the next time mNowMs needs to stop at: a level 0 slot, or a slot of a
+    // higher level to cascade; UINT64_MAX if the wheel is empty
+    uint64_t nextEventMs() const {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < LEVELS; level++) {
+            uint32_t slot = firstSlot(level);
+            if (slot < SLOTS) {
+                next = std::min(next, slotStartMs(level, slot));
+            }
+        }
+        return next;
+    }
+    void cascade() {
+        for (int level = LEVELS - 1; level > 0; level--) {
+            uint32_t slot = slotOf(mNowMs, level);
+            if ((mBitmap[level] & (1ULL << slot)) && slotStartMs(level, slot) == mNowMs) {
+                LocTimerDelegate* timer = mSlots[level][slot];
+                mSlots[level][slot] = NULL;
+                mBitmap[level] &= ~(1ULL << slot);
+                mSlotSoonestMs[level][slot] = UINT64_MAX;
+                while (timer) {
+                    LocTimerDelegate* next = timer->mWheelNext;
+                    link(*timer);
+                    timer = next;
+                }
+            }
+        }
+    }
+public:
+    inline LocTimerWheel() : mBitmap{} {
+        struct timespec now;
+        clock_gettime(CLOCK_BOOTTIME, &now);
+        mNowMs = timespecToMs(now);
+        memset(mSlots, 0, sizeof(mSlots));
+        memset(mSlotSoonestMs, 0xff, sizeof(mSlotSoonestMs));
+    }
+    inline virtual void add(LocTimerDelegate& timer) override {
+        link(timer);
+    }
+    inline virtual bool remove(LocTimerDelegate& timer) override {
+        bool inWheel = (timer.mWheelLevel >= 0);
+        if (inWheel) {
+            unlink(timer);
+        }
+        return inWheel;
+    }
+    virtual bool getSoonestTime(struct timespec& soonest) override {
+        uint64_t soonestMs = UINT64_MAX;
+        uint32_t slot = firstSlot(0);
+        if (slot < SLOTS) {
+            soonestMs = slotStartMs(0, slot);
+        }
+        for (int level = 1; level < LEVELS; level++) {
+            for (uint64_t bits = mBitmap[level]; bits; bits &= bits - 1) {
+                soonestMs = std::min(soonestMs, mSlotSoonestMs[level][__builtin_ctzll(bits)]);
+            }
+        }
+        if (UINT64_MAX != soonestMs) {
+            soonest = msToTimespec(soonestMs);
+        }
+        return UINT64_MAX != soonestMs;
+    }
+    virtual LocTimerDelegate* popExpired(const struct timespec& now) override {
+        uint64_t nowMs = timespecToMs(now);
+        while (true) {
+            uint32_t slot = slotOf(mNowMs, 0);
+            if (mSlots[0][slot] && mNowMs <= nowMs) {
+                LocTimerDelegate* timer = mSlots[0][slot];
+                unlink(*timer);
+                return timer;
+            }
+            uint64_t next = nextEventMs();
+            if (next > nowMs) {
+                // nothing is due in between, so no slot is skipped
+                if (nowMs > mNowMs) {
+                    mNowMs = nowMs;
+                }
+                return NULL;
+            }
+            mNowMs = next;
+            cascade();
+        }
+    }
+};
 
 // ctor - initialize timer heaps
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
 LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mStore(mUseWheel ? (LocTimerStore*)new LocTimerWheel() : new LocTimerHeapStore()),
+    mArmed(false), mArmedTime{} {
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -244,6 +478,7 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
 inline
 LocTimerContainer::~LocTimerContainer() {
     close(mDevFd);
+    delete mStore;
 }
 
 LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
@@ -282,45 +517,39 @@ LocTimerPollTask* LocTimerContainer::getPollTaskLocked() {
     return mPollTask;
 }
 
-inline
-LocTimerDelegate* LocTimerContainer::getSoonestTimer() {
-    return (LocTimerDelegate*)(peek());
-}
-
 inline
 int LocTimerContainer::getTimerFd() {
     return mDevFd;
 }
 
-void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
-    LocTimerDelegate* curTop = getSoonestTimer();
-
-    // check if top has changed
-    if (curTop != priorTop) {
-        struct itimerspec delay;
-        memset(&delay, 0, sizeof(struct itimerspec));
-        bool toSetTime = false;
-        // if tree is empty now, we remove poll and disarm timer
-        if (!curTop) {
+void LocTimerContainer::updateSoonestTime() {
+    struct timespec soonest;
+    if (!mStore->getSoonestTime(soonest)) {
+        // if store is empty now, we remove poll and disarm timer
+        if (mArmed) {
+            mArmed = false;
             mPollTask->removePoll(*this);
-            // setting the values to disarm timer
-            delay.it_value.tv_sec = 0;
-            delay.it_value.tv_nsec = 0;
-            toSetTime = true;
-        } else if (!priorTop || curTop->outRanks(*priorTop)) {
+            struct itimerspec delay;
+            memset(&delay, 0, sizeof(struct itimerspec));
+            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        }
+    } else if (!mArmed || soonest.tv_sec != mArmedTime.tv_sec ||
+               soonest.tv_nsec != mArmedTime.tv_nsec) {
+        if (!mArmed) {
             // do this first to avoid race condition, in case settime is called
             // with too small an interval
             mPollTask->addPoll(*this);
-            delay.it_value = curTop->getFutureTime();
-            toSetTime = true;
-        }
-        if (toSetTime) {
-            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
         }
+        mArmed = true;
+        mArmedTime = soonest;
+        struct itimerspec delay;
+        memset(&delay, 0, sizeof(struct itimerspec));
+        delay.it_value = soonest;
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
     }
 }
 
-// all the heap management is done in the MsgTask context.
+// all the store management is done in the MsgTask context.
 inline
 void LocTimerContainer::add(LocTimerDelegate& timer) {
     struct MsgTimerPush : public LocMsg {
@@ -329,16 +558,15 @@ void LocTimerContainer::add(LocTimerDelegate& timer) {
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-            mTimerContainer->push((LocRankable&)(*mTimer));
-            mTimerContainer->updateSoonestTime(priorTop);
+            mTimerContainer->mStore->add(*mTimer);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
     mMsgTask->sendMsg(new MsgTimerPush(*this, timer));
 }
 
-// all the heap management is done in the MsgTask context.
+// all the store management is done in the MsgTask context.
 void LocTimerContainer::remove(LocTimerDelegate& timer) {
     struct MsgTimerRemove : public LocMsg {
         LocTimerContainer* mTimerContainer;
@@ -346,14 +574,10 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-
             // update soonest timer only if mTimer is actually removed from
-            // mTimerContainer AND mTimer is not priorTop.
-            if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
-                // if passing in NULL, we tell updateSoonestTime to update
-                // kernel with the current top timer interval.
-                mTimerContainer->updateSoonestTime(NULL);
+            // mTimerContainer; it is a no-op unless the soonest time changed.
+            if (mTimerContainer->mStore->remove(*mTimer)) {
+                mTimerContainer->updateSoonestTime();
             }
             // all timers are deleted here, and only here.
             delete mTimer;
@@ -363,9 +587,9 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
     mMsgTask->sendMsg(new MsgTimerRemove(*this, timer));
 }
 
-// all the heap management is done in the MsgTask context.
-// Upon expire, we check and continuously pop the heap until
-// the top node's timeout is in the future.
+// all the store management is done in the MsgTask context.
+// Upon expire, we check and continuously pop the store until
+// the soonest timer's timeout is in the future.
 void LocTimerContainer::expire() {
     struct MsgTimerExpire : public LocMsg {
         LocTimerContainer* mTimerContainer;
@@ -375,16 +599,17 @@ void LocTimerContainer::expire() {
             struct timespec now;
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
-            LocTimerDelegate timerOfNow(now);
-            // pop everything in the heap that outRanks now, i.e. has time older than now
+            // the poll thread has disarmed timerfd and removed the poll
+            mTimerContainer->mArmed = false;
+            // pop everything in the store that is due by now
             // and then call expire() on that timer.
-            for (LocTimerDelegate* timer = (LocTimerDelegate*)mTimerContainer->pop();
+            for (LocTimerDelegate* timer = mTimerContainer->mStore->popExpired(now);
                  NULL != timer;
-                 timer = mTimerContainer->popIfOutRanks(timerOfNow)) {
+                 timer = mTimerContainer->mStore->popExpired(now)) {
                 // the timer delegate obj will be deleted before the return of this call
                 timer->expire();
             }
-            mTimerContainer->updateSoonestTime(NULL);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
@@ -395,16 +620,6 @@ void LocTimerContainer::expire() {
     mMsgTask->sendMsg(new MsgTimerExpire(*this));
 }
 
-LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
-    LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
-        poppedNode = (LocTimerDelegate*)(pop());
-    }
-
-    return poppedNode;
-}
-
-
 /***************************LocTimerPollTask methods***************************/
 
 inline
@@ -541,7 +756,7 @@ LocTimer::~LocTimer() {
     }
 }
 
-bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
+bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire, uint32_t slackInMs) {
     bool success = false;
     mLock->lock();
     if (!mTimer) {
@@ -553,6 +768,15 @@ bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
             futureTime.tv_sec += futureTime.tv_nsec / 1000000000;
             futureTime.tv_nsec %= 1000000000;
         }
+        if (slackInMs > 0) {
+            // round up to the coarsest power of 2 ms boundary within the
+            // slack, so that timers with overlapping slack share a due time
+            // and therefore a wakeup
+            uint64_t granularity = 1ULL << (63 - __builtin_clzll(slackInMs));
+            uint64_t dueMs = timespecToMs(futureTime, true);
+            dueMs = (dueMs + granularity - 1) / granularity * granularity;
+            futureTime = msToTimespec(dueMs);
+        }
 
         LocTimerContainer* container;
         container = LocTimerContainer::get(wakeOnExpire);
@@ -619,6 +843,12 @@ public:
 //////////////////////////////////////////////////////////////////////////
 
 using loc_util::LocTimerWrapper;
+using loc_util::LocTimerContainer;
+
+void loc_timer_use_wheel(bool enabled)
+{
+    LocTimerContainer::setUseWheel(enabled);
+}
 
 pthread_mutex_t LocTimerWrapper::mMutex = PTHREAD_MUTEX_INITIALIZER;
 
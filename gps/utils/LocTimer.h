@@ -59,9 +59,11 @@ public:
     //                        expiration and notify the client.
     //               false if to wait until next time CPU wakes up (if
     //                        sleeping) and then notify the client.
+    // slackInMs:    how much later than timeOutInMs the timer may expire,
+    //               so that it can share a wakeup with other timers.
     // return:       true on success;
     //               false on failure, e.g. timer is already running.
-    bool start(uint32_t timeOutInMs, bool wakeOnExpire);
+    bool start(uint32_t timeOutInMs, bool wakeOnExpire, uint32_t slackInMs = 0);
 
     // return:       true on success;
     //               false on failure, e.g. timer is not running.
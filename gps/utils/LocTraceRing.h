@@ -0,0 +1,105 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_TRACE_RING_H__
+#define __LOC_TRACE_RING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+namespace loc_util {
+
+// A fixed size ring of the last N trace entries, written by a single thread
+// and read by any thread without a lock. Each slot carries a sequence that
+// is odd while the slot is written, so a reader racing the writer skips
+// the slot instead of copying a torn entry. The writer never blocks.
+template <typename T, size_t N>
+class LocTraceRing {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "trace entries are copied as raw memory");
+    static_assert(N > 0, "the ring needs at least one slot");
+
+public:
+    inline LocTraceRing() : mCount(0) {
+        for (size_t i = 0; i < N; i++) {
+            mSlots[i].seq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // only ever called from the one writer thread
+    inline void push(const T& entry) {
+        uint64_t count = mCount.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[count % N];
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.entry, &entry, sizeof(T));
+        slot.seq.store(seq + 2, std::memory_order_release);
+        mCount.store(count + 1, std::memory_order_release);
+    }
+
+    // appends the entries, oldest first, and returns how many were appended
+    inline size_t snapshot(std::vector<T>& entries) const {
+        uint64_t count = mCount.load(std::memory_order_acquire);
+        uint64_t first = (count > N) ? count - N : 0;
+        size_t appended = 0;
+        for (uint64_t i = first; i < count; i++) {
+            const Slot& slot = mSlots[i % N];
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                continue;
+            }
+            T entry;
+            memcpy(&entry, &slot.entry, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                entries.push_back(entry);
+                appended++;
+            }
+        }
+        return appended;
+    }
+
+    inline uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T entry;
+    };
+    Slot mSlots[N];
+    std::atomic<uint64_t> mCount;
+};
+
+} // namespace loc_util
+
+#endif // __LOC_TRACE_RING_H__
@@ -28,6 +28,18 @@
  */
 
 #include "LogBuffer.h"
+#include "MsgTask.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <new>
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
 #ifdef USE_GLIB
 #include <execinfo.h>
 #endif
@@ -37,12 +49,16 @@
 #endif
 #define LOG_TAG "LocSvc_LogBuffer"
 
+// a text record read from a stage of a log file, which is not '\0' terminated
+#define LOG_RECORD_STAGED 0x80000000
+
 namespace loc_util {
 
 LogBuffer* LogBuffer::mInstance;
 struct sigaction LogBuffer::mOriSigAction[NSIG];
 struct sigaction LogBuffer::mNewSigAction;
 mutex LogBuffer::sLock;
+const char* const LogBuffer::sLevelMap[TOTAL_LOG_LEVELS] = {"E", "W", "I", "D", "V"};
 
 LogBuffer* LogBuffer::getInstance() {
     if (mInstance == nullptr) {
@@ -54,9 +70,480 @@ LogBuffer* LogBuffer::getInstance() {
     return mInstance;
 }
 
-LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
+static inline size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+size_t LogLevelRing::memSize(uint32_t capacity, uint32_t arenaSize) {
+    return align8(sizeof(State)) + capacity * sizeof(Record) + align8(arenaSize);
+}
+
+void LogLevelRing::setUp(char* mem) {
+    mState = (State*)mem;
+    mRecords = (Record*)(mem + align8(sizeof(State)));
+    mArena = (char*)(mRecords + mState->mCapacity);
+}
+
+void LogLevelRing::init(uint32_t capacity, uint32_t arenaSize, char* mem) {
+    if (nullptr == mem) {
+        mOwned.resize(memSize(capacity, arenaSize) / sizeof(uint64_t));
+        mem = (char*)mOwned.data();
+    }
+    State* state = (State*)mem;
+    state->mCapacity = capacity;
+    state->mArenaSize = arenaSize;
+    setUp(mem);
+    flush();
+}
+
+bool LogLevelRing::attach(char* mem, size_t memLen) {
+    State* state = (State*)mem;
+    if (memLen < sizeof(State) || memLen < memSize(state->mCapacity, state->mArenaSize) ||
+            (state->mCapacity > 0 && (state->mHead >= state->mCapacity ||
+            state->mCount > state->mCapacity)) ||
+            (0 == state->mCapacity && state->mCount > 0)) {
+        return false;
+    }
+    setUp(mem);
+    for (uint32_t i = 0; i < size(); i++) {
+        if ((uint64_t)at(i).mOffset + at(i).mLen > state->mArenaSize || 0 == at(i).mLen) {
+            mState = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+// finds room of len bytes in the arena, after the newest text, or at the
+// start of the arena if the room left till its end is too small.
+bool LogLevelRing::reserve(uint32_t len, uint32_t& offset) {
+    uint32_t count = mState->mCount;
+    if (0 == count) {
+        mState->mArenaTail = 0;
+    }
+    uint32_t arenaTail = mState->mArenaTail;
+    uint32_t arenaHead = (0 == count) ? 0 : at(0).mOffset;
+    if (0 == count || arenaTail > arenaHead) {
+        if (len <= mState->mArenaSize - arenaTail) {
+            offset = arenaTail;
+            return true;
+        }
+        if (len <= arenaHead) {
+            offset = 0;
+            return true;
+        }
+    } else if (len <= arenaHead - arenaTail) {
+        offset = arenaTail;
+        return true;
+    }
+    return false;
+}
+
+void LogLevelRing::append(const char* data, uint32_t dataLen, uint32_t flags,
+        uint64_t timestamp, uint64_t seq) {
+    if (nullptr == mState || 0 == mState->mCapacity || 0 == mState->mArenaSize) {
+        return;
+    }
+    uint32_t len = std::min(dataLen + 1, mState->mArenaSize);
+    uint32_t offset = 0;
+    // no room for the text or for the record, evict the oldest
+    while (mState->mCount == mState->mCapacity || !reserve(len, offset)) {
+        pop();
+    }
+    memcpy(&mArena[offset], data, len - 1);
+    mArena[offset + len - 1] = '\0';
+    mState->mArenaTail = offset + len;
+
+    Record& record = mRecords[(mState->mHead + mState->mCount) % mState->mCapacity];
+    record.mTimestamp = timestamp;
+    record.mSeq = seq;
+    record.mOffset = offset;
+    record.mLen = len;
+    record.mFlags = flags;
+    // the record is complete before it is counted, for a reader of the mapped file
+    std::atomic_signal_fence(std::memory_order_release);
+    mState->mCount++;
+}
+
+static inline uint32_t alignedRecordSize(uint32_t len) {
+    return (sizeof(LogStage::Record) + len + 7) & ~7u;
+}
+
+bool LogStage::push(const char* data, uint32_t len, int level, uint32_t flags,
+        uint64_t timestamp, uint64_t seq) {
+    uint32_t need = alignedRecordSize(len);
+    uint32_t tail = mTail.load(std::memory_order_relaxed);
+    uint32_t head = mHead.load(std::memory_order_acquire);
+    uint32_t offset = tail & (LOG_STAGE_SIZE - 1);
+    uint32_t toEnd = LOG_STAGE_SIZE - offset;
+    uint32_t skip = (toEnd < need) ? toEnd : 0;
+    if (LOG_STAGE_SIZE - (tail - head) < need + skip) {
+        return false;
+    }
+    if (skip > 0) {
+        // toEnd is a multiple of 8, so there is always room for the marker
+        *(uint32_t*)&mRing[offset] = WRAP_MARKER;
+        tail += skip;
+        offset = 0;
+    }
+    Record* record = (Record*)&mRing[offset];
+    record->mLen = len;
+    record->mLevel = level;
+    record->mFlags = flags;
+    record->mSeq = seq;
+    record->mTimestamp = timestamp;
+    memcpy(record + 1, data, len);
+    mTail.store(tail + need, std::memory_order_release);
+    return true;
+}
+
+const LogStage::Record* LogStage::front() {
+    uint32_t head = mHead.load(std::memory_order_relaxed);
+    uint32_t tail = mTail.load(std::memory_order_acquire);
+    if (head == tail) {
+        return nullptr;
+    }
+    uint32_t offset = head & (LOG_STAGE_SIZE - 1);
+    if (WRAP_MARKER == *(uint32_t*)&mRing[offset]) {
+        head += LOG_STAGE_SIZE - offset;
+        mHead.store(head, std::memory_order_release);
+        if (head == tail) {
+            return nullptr;
+        }
+        offset = 0;
+    }
+    return (const Record*)&mRing[offset];
+}
+
+void LogStage::pop() {
+    const Record* record = front();
+    if (nullptr != record) {
+        mHead.store(mHead.load(std::memory_order_relaxed) + alignedRecordSize(record->mLen),
+                std::memory_order_release);
+    }
+}
+
+// prefix of deferred records, same as INSERT_BUFFER puts in front of a sentence
+struct LogDeferredHead {
+    const char* mFormat;
+    const char* mTag;
+    struct timeval mTime;
+    int32_t mPid;
+    int32_t mTid;
+    // with LOG_RECORD_INLINE_FORMAT, offsets of the copies in the payload
+    uint16_t mFormatOffset;
+    uint16_t mTagOffset;
+};
+
+// one conversion of a printf format
+struct LogFormatSpec {
+    // one past the conversion char
+    const char* mEnd;
+    // number of '*' width / precision args
+    int mStars;
+    // literal precision, -1 if none or given by '*'
+    int mPrecision;
+    // 0, 'H' for hh, 'h', 'l', 'q' for ll, 'j', 'z', 't' or 'L'
+    char mLength;
+    // 0 if not supported
+    char mConversion;
+};
+
+// p points at the '%'
+static void parseFormatSpec(const char* p, LogFormatSpec& spec) {
+    spec.mStars = 0;
+    spec.mPrecision = -1;
+    spec.mLength = 0;
+    spec.mConversion = 0;
+    for (p++; *p && strchr("-+ #0'", *p); p++) {}
+    if ('*' == *p) {
+        spec.mStars++;
+        p++;
+    }
+    for (; *p >= '0' && *p <= '9'; p++) {}
+    if ('.' == *p) {
+        p++;
+        if ('*' == *p) {
+            spec.mStars++;
+            p++;
+        } else {
+            for (spec.mPrecision = 0; *p >= '0' && *p <= '9'; p++) {
+                spec.mPrecision = spec.mPrecision * 10 + (*p - '0');
+            }
+        }
+    }
+    if ('h' == *p || 'l' == *p) {
+        spec.mLength = *p++;
+        if (spec.mLength == *p) {
+            spec.mLength = ('h' == *p) ? 'H' : 'q';
+            p++;
+        }
+    } else if (*p && strchr("qjztL", *p)) {
+        spec.mLength = *p++;
+    }
+    if (*p && strchr("diouxXcsfFeEgGaApmn%", *p)) {
+        spec.mConversion = *p++;
+    }
+    spec.mEnd = p;
+}
+
+// writes the raw args of format after a LogDeferredHead, each integer or
+// pointer as 8 bytes, each floating point as a double, each string with its
+// '\0'. Stops at the first arg that is not supported or does not fit.
+uint32_t LogBuffer::encodeDeferred(char* buf, uint32_t size, const char* tag,
+        const char* format, va_list args, bool inlineFormat) {
+    int savedErrno = errno;
+    LogDeferredHead* head = (LogDeferredHead*)buf;
+    head->mFormat = format;
+    head->mTag = tag;
+    gettimeofday(&head->mTime, NULL);
+    head->mPid = getpid();
+    head->mTid = (int32_t)syscall(SYS_gettid);
+    head->mFormatOffset = head->mTagOffset = 0;
+    uint32_t len = sizeof(*head);
+    if (inlineFormat) {
+        // the copies go after the args, keep room for them
+        size_t formatLen = strlen(format) + 1;
+        size_t tagLen = strlen(tag) + 1;
+        if (len + formatLen + tagLen > size) {
+            return 0;
+        }
+        size -= formatLen + tagLen;
+        len = encodeDeferredArgs(buf, len, size, format, args, savedErrno);
+        head->mFormatOffset = len;
+        memcpy(buf + len, format, formatLen);
+        head->mTagOffset = len + formatLen;
+        memcpy(buf + len + formatLen, tag, tagLen);
+        return len + formatLen + tagLen;
+    }
+    return encodeDeferredArgs(buf, len, size, format, args, savedErrno);
+}
+
+uint32_t LogBuffer::encodeDeferredArgs(char* buf, uint32_t len, uint32_t size,
+        const char* format, va_list args, int savedErrno) {
+
+    for (const char* p = strchr(format, '%'); p; p = strchr(p, '%')) {
+        LogFormatSpec spec;
+        parseFormatSpec(p, spec);
+        p = spec.mEnd;
+        int64_t values[3];
+        int count = 0;
+        const char* str = NULL;
+        for (int i = 0; i < spec.mStars; i++) {
+            values[count++] = va_arg(args, int);
+        }
+        switch (spec.mConversion) {
+        case 'd': case 'i':
+            switch (spec.mLength) {
+            case 'l': values[count++] = va_arg(args, long); break;
+            case 'q': values[count++] = va_arg(args, long long); break;
+            case 'j': values[count++] = va_arg(args, intmax_t); break;
+            case 'z': values[count++] = va_arg(args, ssize_t); break;
+            case 't': values[count++] = va_arg(args, ptrdiff_t); break;
+            default: values[count++] = va_arg(args, int); break;
+            }
+            break;
+        case 'o': case 'u': case 'x': case 'X': case 'c':
+            switch (spec.mLength) {
+            case 'l': values[count++] = va_arg(args, unsigned long); break;
+            case 'q': values[count++] = va_arg(args, unsigned long long); break;
+            case 'j': values[count++] = va_arg(args, uintmax_t); break;
+            case 'z': values[count++] = va_arg(args, size_t); break;
+            case 't': values[count++] = va_arg(args, ptrdiff_t); break;
+            default: values[count++] = va_arg(args, unsigned int); break;
+            }
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            double d = ('L' == spec.mLength) ? (double)va_arg(args, long double) :
+                    va_arg(args, double);
+            memcpy(&values[count++], &d, sizeof(d));
+            break;
+        }
+        case 'p':
+            values[count++] = (int64_t)(uintptr_t)va_arg(args, void*);
+            break;
+        case 's':
+            if ('l' == spec.mLength) {
+                return len;
+            }
+            str = va_arg(args, const char*);
+            if (NULL == str) {
+                str = "(null)";
+            }
+            break;
+        case 'm':
+            str = strerror(savedErrno);
+            break;
+        case 'n':
+            (void)va_arg(args, void*);
+            break;
+        case '%':
+            break;
+        default:
+            return len;
+        }
+        uint32_t need = count * sizeof(int64_t) + ((NULL != str) ? 1 : 0);
+        if (len + need > size) {
+            return len;
+        }
+        size_t strLen = 0;
+        if (NULL != str) {
+            int precision = (spec.mPrecision >= 0) ? spec.mPrecision :
+                    ((spec.mStars > 0 && 's' == spec.mConversion) ? (int)values[count - 1] : -1);
+            // a long string is cut to the room left
+            strLen = strnlen(str, std::min((precision >= 0) ? (size_t)precision : size,
+                    (size_t)(size - len - need)));
+        }
+        memcpy(buf + len, values, count * sizeof(int64_t));
+        len += count * sizeof(int64_t);
+        if (NULL != str) {
+            memcpy(buf + len, str, strLen);
+            buf[len + strLen] = '\0';
+            len += strLen + 1;
+        }
+    }
+    return len;
+}
+
+template <typename T>
+static void appendFormatted(string& out, const char* spec, int stars, const int64_t* starArgs,
+        T value) {
+    char buf[LOGGING_BUFFER_MAX_LEN];
+    int n = (0 == stars) ? snprintf(buf, sizeof(buf), spec, value) :
+            (1 == stars) ? snprintf(buf, sizeof(buf), spec, (int)starArgs[0], value) :
+            snprintf(buf, sizeof(buf), spec, (int)starArgs[0], (int)starArgs[1], value);
+    if (n > 0) {
+        out.append(buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+}
+
+// formats a deferred record the way INSERT_BUFFER would have
+string LogBuffer::decodeDeferred(const char* buf, uint32_t len, uint32_t flags) {
+    string out;
+    if (len < sizeof(LogDeferredHead)) {
+        return out;
+    }
+    LogDeferredHead head;
+    memcpy(&head, buf, sizeof(head));
+    if (flags & LOG_RECORD_INLINE_FORMAT) {
+        if (head.mFormatOffset >= len || head.mTagOffset >= len ||
+                nullptr == memchr(buf + head.mFormatOffset, '\0', len - head.mFormatOffset) ||
+                nullptr == memchr(buf + head.mTagOffset, '\0', len - head.mTagOffset)) {
+            return out;
+        }
+        head.mFormat = buf + head.mFormatOffset;
+        head.mTag = buf + head.mTagOffset;
+        len = head.mFormatOffset;
+    }
+    char prefix[LOGGING_BUFFER_MAX_LEN];
+    long sec = head.mTime.tv_sec;
+    snprintf(prefix, sizeof(prefix), "%02ld:%02ld:%02ld.%06ld %d %d %s :",
+            sec / 3600 % 24, (sec % 3600) / 60, sec % 60, (long)head.mTime.tv_usec,
+            head.mPid, head.mTid, head.mTag);
+    out = prefix;
+
+    uint32_t pos = sizeof(head);
+    const char* format = head.mFormat;
+    for (const char* p = strchr(format, '%'); p; p = strchr(p, '%')) {
+        out.append(format, p - format);
+        LogFormatSpec spec;
+        parseFormatSpec(p, spec);
+        format = spec.mEnd;
+        char specStr[32];
+        size_t specLen = spec.mEnd - p;
+        if (0 == spec.mConversion || specLen >= sizeof(specStr)) {
+            return out;
+        }
+        memcpy(specStr, p, specLen);
+        specStr[specLen] = '\0';
+        p = spec.mEnd;
+
+        bool isStr = ('s' == spec.mConversion || 'm' == spec.mConversion);
+        int count = spec.mStars + ((isStr || 'n' == spec.mConversion ||
+                '%' == spec.mConversion) ? 0 : 1);
+        if (pos + count * sizeof(int64_t) > len) {
+            return out;
+        }
+        int64_t values[3];
+        memcpy(values, buf + pos, count * sizeof(int64_t));
+        pos += count * sizeof(int64_t);
+        int64_t value = (count > 0) ? values[count - 1] : 0;
+        switch (spec.mConversion) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c': {
+            bool isSigned = ('d' == spec.mConversion || 'i' == spec.mConversion);
+            switch (spec.mLength) {
+            case 'l':
+                isSigned ? appendFormatted(out, specStr, spec.mStars, values, (long)value) :
+                        appendFormatted(out, specStr, spec.mStars, values, (unsigned long)value);
+                break;
+            case 'q': case 'j':
+                isSigned ? appendFormatted(out, specStr, spec.mStars, values, (long long)value) :
+                        appendFormatted(out, specStr, spec.mStars, values,
+                                (unsigned long long)value);
+                break;
+            case 'z': case 't':
+                isSigned ? appendFormatted(out, specStr, spec.mStars, values, (ssize_t)value) :
+                        appendFormatted(out, specStr, spec.mStars, values, (size_t)value);
+                break;
+            default:
+                isSigned ? appendFormatted(out, specStr, spec.mStars, values, (int)value) :
+                        appendFormatted(out, specStr, spec.mStars, values, (unsigned int)value);
+                break;
+            }
+            break;
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            double d;
+            memcpy(&d, &value, sizeof(d));
+            ('L' == spec.mLength) ?
+                    appendFormatted(out, specStr, spec.mStars, values, (long double)d) :
+                    appendFormatted(out, specStr, spec.mStars, values, d);
+            break;
+        }
+        case 'p':
+            appendFormatted(out, specStr, spec.mStars, values, (void*)(uintptr_t)value);
+            break;
+        case 's': case 'm': {
+            const char* str = buf + pos;
+            size_t strLen = strnlen(str, len - pos);
+            if (pos + strLen >= len) {
+                return out;
+            }
+            pos += strLen + 1;
+            if ('m' == spec.mConversion) {
+                out.append(str, strLen);
+            } else {
+                appendFormatted(out, specStr, spec.mStars, values, str);
+            }
+            break;
+        }
+        case '%':
+            out.push_back('%');
+            break;
+        default:
+            break;
+        }
+    }
+    out.append(format);
+    return out;
+}
+
+// hands the staging ring back to LogBuffer when its thread exits
+struct LogStageHolder {
+    LogStage* mStage;
+    inline LogStageHolder() : mStage(nullptr) {}
+    inline ~LogStageHolder() {
+        if (nullptr != mStage) {
+            LogBuffer::getInstance()->releaseStage(mStage);
+        }
+    }
+};
+static thread_local LogStageHolder sStageHolder;
+
+LogBuffer::LogBuffer(): mLogRings(TOTAL_LOG_LEVELS),
         mConfigVec(TOTAL_LOG_LEVELS, ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC,
-                    MAXIMUM_NUM_IN_LIST, 0)) {
+                    MAXIMUM_NUM_IN_LIST, 0)), mSeq(0), mPersistent(0), mMap(nullptr),
+        mMapSize(0) {
     loc_param_s_type log_buff_config_table[] =
     {
         {"E_LEVEL_TIME_DEPTH",      &mConfigVec[0].mTimeDepthThres,  NULL, 'n'},
@@ -69,50 +556,317 @@ LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
         {"D_LEVEL_MAX_CAPACITY",    &mConfigVec[3].mMaxNumThres,     NULL, 'n'},
         {"V_LEVEL_TIME_DEPTH",      &mConfigVec[4].mTimeDepthThres,  NULL, 'n'},
         {"V_LEVEL_MAX_CAPACITY",    &mConfigVec[4].mMaxNumThres,     NULL, 'n'},
+        {"LOG_BUFFER_PERSISTENT",   &mPersistent,                    NULL, 'n'},
     };
     loc_read_conf(LOC_PATH_GPS_CONF_STR, log_buff_config_table,
             sizeof(log_buff_config_table)/sizeof(log_buff_config_table[0]));
+    if (0 == mPersistent || !mapFile()) {
+        for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+            mLogRings[i].init(mConfigVec[i].mMaxNumThres,
+                    mConfigVec[i].mMaxNumThres * AVERAGE_RECORD_SIZE_IN_ARENA);
+        }
+    }
     registerSignalHandler();
 }
 
-void LogBuffer::append(string& data, int level, uint64_t timestamp) {
+LogStage* LogBuffer::getStage() {
+    if (nullptr == sStageHolder.mStage) {
+        lock_guard<mutex> guard(mLock);
+        LogStage* stage = nullptr;
+        if (!mFreeStages.empty()) {
+            stage = mFreeStages.back();
+            mFreeStages.pop_back();
+        } else {
+            stage = new LogStage();
+        }
+        mStages.push_back(stage);
+        sStageHolder.mStage = stage;
+    }
+    return sStageHolder.mStage;
+}
+
+void LogBuffer::releaseStage(LogStage* stage) {
+    lock_guard<mutex> guard(mLock);
+    drainStagesLocked();
+    mStages.erase(std::remove(mStages.begin(), mStages.end(), stage), mStages.end());
+    if ((char*)stage >= mMap && (char*)stage < mMap + mMapSize) {
+        // a drained slot of the mapped file, for the next thread
+        mFreeStages.push_back(new (stage) LogStage());
+    } else {
+        delete stage;
+    }
+}
+
+// moves the staged records of all threads into the level rings, merged by
+// their sequence numbers, so they keep the order they were appended in.
+void LogBuffer::drainStagesLocked() {
+    while (true) {
+        LogStage* next = nullptr;
+        const LogStage::Record* nextRecord = nullptr;
+        for (LogStage* stage : mStages) {
+            const LogStage::Record* record = stage->front();
+            if (nullptr != record && (nullptr == nextRecord || record->mSeq < nextRecord->mSeq)) {
+                next = stage;
+                nextRecord = record;
+            }
+        }
+        if (nullptr == next) {
+            break;
+        }
+        appendLocked((const char*)(nextRecord + 1), nextRecord->mLen, nextRecord->mLevel,
+                nextRecord->mFlags, nextRecord->mTimestamp, nextRecord->mSeq);
+        next->pop();
+    }
+}
+
+void LogBuffer::appendLocked(const char* data, uint32_t len, int level, uint32_t flags,
+        uint64_t timestamp, uint64_t seq) {
+    LogLevelRing& ring = mLogRings[level];
+    // the ring evicts by count and arena space itself
+    ring.append(data, len, flags, timestamp, seq);
+    while (ring.size() > 0 &&
+            (timestamp - ring.at(0).mTimestamp) > mConfigVec[level].mTimeDepthThres) {
+        ring.pop();
+    }
+    mConfigVec[level].mCurrentSize = ring.size();
+}
+
+void LogBuffer::append(const char* data, uint32_t len, int level, uint32_t flags,
+        uint64_t timestamp) {
+    if (level < 0 || level >= TOTAL_LOG_LEVELS) {
+        return;
+    }
+    uint64_t seq = mSeq.fetch_add(1, std::memory_order_relaxed);
+    if (len <= LOG_STAGE_SIZE / 4 &&
+            getStage()->push(data, len, level, flags, timestamp, seq)) {
+        return;
+    }
+    // staging ring is full, or the record too large for it
     lock_guard<mutex> guard(mLock);
-    pair<uint64_t, string> item(timestamp, data);
-    mLogList.append(item, level);
-    mConfigVec[level].mCurrentSize++;
+    drainStagesLocked();
+    appendLocked(data, len, level, flags, timestamp, seq);
+}
+
+void LogBuffer::append(string& data, int level, uint64_t timestamp) {
+    append(data.c_str(), data.size(), level, 0, timestamp);
+}
 
-    while ((timestamp - mLogList.front(level).first) > mConfigVec[level].mTimeDepthThres ||
-            mConfigVec[level].mCurrentSize > mConfigVec[level].mMaxNumThres) {
-        mLogList.pop(level);
-        mConfigVec[level].mCurrentSize--;
+void LogBuffer::appendDeferred(int level, uint64_t timestamp, const char* tag,
+        const char* format, va_list args) {
+    char payload[LOGGING_BUFFER_MAX_LEN];
+    // a mapped file is read by another process, which can not follow the pointers
+    bool inlineFormat = (nullptr != mMap);
+    uint32_t len = encodeDeferred(payload, sizeof(payload), tag, format, args, inlineFormat);
+    if (len > 0) {
+        append(payload, len, level,
+                LOG_RECORD_DEFERRED | (inlineFormat ? LOG_RECORD_INLINE_FORMAT : 0), timestamp);
     }
 }
 
 //Dump the log buffer of specific level, level = -1 to dump all the levels in log buffer.
 void LogBuffer::dump(std::function<void(stringstream&)> log, int level) {
     lock_guard<mutex> guard(mLock);
-    list<pair<pair<uint64_t, string>, int>> li;
-    if (-1 == level) {
-        li = mLogList.dump();
-    } else {
-        li = mLogList.dump(level);
+    drainStagesLocked();
+    int first = (-1 == level) ? 0 : level;
+    int last = (-1 == level) ? TOTAL_LOG_LEVELS - 1 : level;
+    if (first < 0 || last >= TOTAL_LOG_LEVELS) {
+        return;
+    }
+    uint32_t total = 0;
+    for (int i = first; i <= last; i++) {
+        total += mLogRings[i].size();
     }
-    ALOGE("Begining of dump, buffer size: %d", (int)li.size());
+    ALOGE("Begining of dump, buffer size: %d", (int)total);
     stringstream ln;
-    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << li.size() << endl;
+    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << total << endl;
     log(ln);
-    for_each (li.begin(), li.end(), [&, this](const pair<pair<uint64_t, string>, int> &item){
+    // merge the levels in the order the records were appended
+    uint32_t cursor[TOTAL_LOG_LEVELS] = {};
+    for (uint32_t n = 0; n < total; n++) {
+        int next = -1;
+        for (int i = first; i <= last; i++) {
+            if (cursor[i] < mLogRings[i].size() && (-1 == next ||
+                    mLogRings[i].at(cursor[i]).mSeq < mLogRings[next].at(cursor[next]).mSeq)) {
+                next = i;
+            }
+        }
+        const LogLevelRing::Record& record = mLogRings[next].at(cursor[next]++);
         stringstream line;
-        line << "["<<item.first.first << "] ";
-        line << "Level " << mLevelMap[item.second] << ": ";
-        line << item.first.second << endl;
+        formatLine(line, record.mTimestamp, next, record.mFlags, mLogRings[next].text(record),
+                record.mLen - 1);
         if (log != nullptr) {
             log(line);
         }
-    });
+    }
+    if (-1 == level) {
+        MsgTask::dumpStats(log);
+    }
     ALOGE("End of dump");
 }
 
+void LogBuffer::formatLine(stringstream& line, uint64_t timestamp, int level, uint32_t flags,
+        const char* text, uint32_t len) {
+    line << "["<< timestamp << "] ";
+    line << "Level " << sLevelMap[level] << ": ";
+    if (flags & LOG_RECORD_DEFERRED) {
+        line << decodeDeferred(text, len, flags) << endl;
+    } else {
+        line << text << endl;
+    }
+}
+
+// maps the rings and the staging slots in a file, so that the records are
+// there after a crash, with nothing to flush. The file of the previous run
+// is kept as .prev
+bool LogBuffer::mapFile() {
+    char name[32] = "gps";
+    int commFd = open("/proc/self/comm", O_RDONLY | O_CLOEXEC);
+    if (commFd >= 0) {
+        ssize_t n = read(commFd, name, sizeof(name) - 1);
+        if (n > 0) {
+            name[n] = '\0';
+            for (char* c = name; *c; c++) {
+                if ('\n' == *c || '/' == *c || ' ' == *c) {
+                    *c = ('\n' == *c) ? '\0' : '_';
+                }
+            }
+        }
+        close(commFd);
+    }
+    string path = string(LOG_BUFFER_FILE_PATH "gpslog_ring_") + name + ".bin";
+    rename(path.c_str(), (path + ".prev").c_str());
+
+    LogMapHead head = {};
+    head.mMagic = LOG_MAP_MAGIC;
+    head.mVersion = LOG_MAP_VERSION;
+    head.mPid = getpid();
+    head.mStageCount = LOG_MAPPED_STAGES;
+    size_t size = align8(sizeof(head));
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        head.mLevelOffset[i] = size;
+        head.mLevelSize[i] = LogLevelRing::memSize(mConfigVec[i].mMaxNumThres,
+                mConfigVec[i].mMaxNumThres * AVERAGE_RECORD_SIZE_IN_ARENA);
+        size += head.mLevelSize[i];
+    }
+    head.mStageOffset = size;
+    size += LOG_MAPPED_STAGES * sizeof(LogStage);
+    head.mSize = size;
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        ALOGE("Failed to open %s, errno: %d", path.c_str(), errno);
+        return false;
+    }
+    void* map = MAP_FAILED;
+    if (0 == ftruncate(fd, size)) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (MAP_FAILED == map) {
+        ALOGE("Failed to map %s, errno: %d", path.c_str(), errno);
+        unlink(path.c_str());
+        return false;
+    }
+    mMap = (char*)map;
+    mMapSize = size;
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        mLogRings[i].init(mConfigVec[i].mMaxNumThres,
+                mConfigVec[i].mMaxNumThres * AVERAGE_RECORD_SIZE_IN_ARENA,
+                mMap + head.mLevelOffset[i]);
+    }
+    for (int i = LOG_MAPPED_STAGES - 1; i >= 0; i--) {
+        mFreeStages.push_back(new (mMap + head.mStageOffset + i * sizeof(LogStage)) LogStage());
+    }
+    // the head is written last, a reader ignores a file without it
+    std::atomic_signal_fence(std::memory_order_release);
+    memcpy(mMap, &head, sizeof(head));
+    return true;
+}
+
+bool LogBuffer::dumpMappedFile(const string& filePath,
+        std::function<void(stringstream&)> log) {
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // read into a private copy, as the records are consumed below
+    vector<uint64_t> buf;
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+    if (fileSize >= (off_t)sizeof(LogMapHead)) {
+        buf.resize((fileSize + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        if (pread(fd, buf.data(), fileSize, 0) != fileSize) {
+            buf.clear();
+        }
+    }
+    close(fd);
+    char* mem = (char*)buf.data();
+    LogMapHead head;
+    if (buf.empty() || (memcpy(&head, mem, sizeof(head)), LOG_MAP_MAGIC != head.mMagic) ||
+            LOG_MAP_VERSION != head.mVersion || head.mSize > (uint64_t)fileSize ||
+            head.mStageOffset + head.mStageCount * sizeof(LogStage) > head.mSize) {
+        return false;
+    }
+
+    struct Line {
+        uint64_t mSeq;
+        uint64_t mTimestamp;
+        int mLevel;
+        uint32_t mFlags;
+        const char* mText;
+        uint32_t mLen;
+    };
+    vector<Line> lines;
+    LogLevelRing rings[TOTAL_LOG_LEVELS];
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        if (head.mLevelOffset[i] + head.mLevelSize[i] > head.mSize ||
+                !rings[i].attach(mem + head.mLevelOffset[i], head.mLevelSize[i])) {
+            continue;
+        }
+        for (uint32_t n = 0; n < rings[i].size(); n++) {
+            const LogLevelRing::Record& record = rings[i].at(n);
+            lines.push_back({record.mSeq, record.mTimestamp, i, record.mFlags,
+                    rings[i].text(record), record.mLen - 1});
+        }
+    }
+    // records not drained yet when the process died
+    for (uint32_t i = 0; i < head.mStageCount; i++) {
+        LogStage* stage = (LogStage*)(mem + head.mStageOffset + i * sizeof(LogStage));
+        for (uint32_t n = 0; stage->isConsistent() && n < LOG_STAGE_SIZE / sizeof(LogStage::Record); n++) {
+            const LogStage::Record* record = stage->front();
+            if (nullptr == record || record->mLen > LOG_STAGE_SIZE / 4 ||
+                    record->mLevel < 0 || record->mLevel >= TOTAL_LOG_LEVELS ||
+                    (const char*)(record + 1) + record->mLen > (const char*)(stage + 1)) {
+                break;
+            }
+            // a text record from a stage is not terminated, copy it
+            const char* text = (const char*)(record + 1);
+            if (0 == (record->mFlags & LOG_RECORD_DEFERRED)) {
+                text = strndup(text, record->mLen);
+            }
+            lines.push_back({record->mSeq, record->mTimestamp, record->mLevel,
+                    record->mFlags | LOG_RECORD_STAGED, text, record->mLen});
+            stage->pop();
+        }
+    }
+    std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+        return a.mSeq < b.mSeq;
+    });
+
+    stringstream ln;
+    ln << "dump log file " << filePath << ", pid: " << head.mPid << ", buffer size: "
+            << lines.size() << endl;
+    log(ln);
+    for (const Line& item : lines) {
+        stringstream line;
+        formatLine(line, item.mTimestamp, item.mLevel, item.mFlags, item.mText, item.mLen);
+        log(line);
+        if ((item.mFlags & LOG_RECORD_STAGED) && 0 == (item.mFlags & LOG_RECORD_DEFERRED)) {
+            free((void*)item.mText);
+        }
+    }
+    return true;
+}
+
 void LogBuffer::dumpToAdbLogcat() {
     dump([](stringstream& line){
         ALOGE("%s", line.str().c_str());
@@ -130,7 +884,12 @@ void LogBuffer::dumpToLogFile(string filePath) {
 }
 
 void LogBuffer::flush() {
-    mLogList.flush();
+    lock_guard<mutex> guard(mLock);
+    drainStagesLocked();
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        mLogRings[i].flush();
+        mConfigVec[i].mCurrentSize = 0;
+    }
 }
 
 void LogBuffer::registerSignalHandler() {
@@ -167,6 +926,14 @@ void LogBuffer::signalHandler(const int code, siginfo_t *const si, void *const s
         }
     }
 #endif
+    //The mapped log file already has the records, no dump needed
+    if (nullptr != mInstance->mMap) {
+        if (code != SIGUSR1) {
+            mOriSigAction[code].sa_sigaction(code, si, sc);
+        }
+        return;
+    }
+
     //Dump the log buffer to adb logcat
     mInstance->dumpToAdbLogcat();
 
@@ -30,7 +30,6 @@
 #ifndef LOG_BUFFER_H
 #define LOG_BUFFER_H
 
-#include "SkipList.h"
 #include "log_util.h"
 #include <loc_cfg.h>
 #include <loc_pla.h>
@@ -43,11 +42,29 @@
 #include <signal.h>
 #include <thread>
 #include <functional>
+#include <vector>
+#include <atomic>
+#include <stdarg.h>
+
+using namespace std;
 
 //default error level time depth threshold,
 #define TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC 60
 //default maximum log buffer size
 #define MAXIMUM_NUM_IN_LIST 50
+//average bytes of text reserved per log record in a level's arena
+#define AVERAGE_RECORD_SIZE_IN_ARENA 256
+//bytes of the staging ring of each logging thread, must be power of 2
+#define LOG_STAGE_SIZE (16 * 1024)
+//LogStage / LogLevelRing record flags, the payload is a LogDeferredHead followed
+//by the raw arguments of its format
+#define LOG_RECORD_DEFERRED 0x1
+//the format and tag of a deferred record are copied in its payload
+#define LOG_RECORD_INLINE_FORMAT 0x2
+//number of LogStage slots in the mapped log file
+#define LOG_MAPPED_STAGES 16
+#define LOG_MAP_MAGIC 0x4642474c
+#define LOG_MAP_VERSION 1
 //file path of dumped log buffer
 #define LOG_BUFFER_FILE_PATH "/data/vendor/location/"
 
@@ -63,28 +80,167 @@ public:
         mTimeDepthThres(time), mMaxNumThres(num), mCurrentSize(size) {}
 };
 
+// Fixed capacity ring of the log records of one level. The record headers are
+// kept in a ring of mMaxNumThres entries, and the texts in a byte arena that is
+// used as a ring too, both allocated once. So append() does not allocate, and
+// evicting the oldest record is only moving the head. The ring state, records
+// and arena are one block of memory, which can be part of a mapped file.
+class LogLevelRing {
+public:
+    struct Record {
+        uint64_t mTimestamp;
+        // order of the record among all levels, for dumping levels merged
+        uint64_t mSeq;
+        uint32_t mOffset;
+        // length of text, including the terminating '\0'
+        uint32_t mLen;
+        uint32_t mFlags;
+    };
+    struct State {
+        uint32_t mCapacity;
+        uint32_t mArenaSize;
+        uint32_t mHead;
+        uint32_t mCount;
+        uint32_t mArenaTail;
+    };
+private:
+    // backing memory, unless the ring is in a mapped file
+    vector<uint64_t> mOwned;
+    State* mState;
+    Record* mRecords;
+    char* mArena;
+    bool reserve(uint32_t len, uint32_t& offset);
+    void setUp(char* mem);
+public:
+    LogLevelRing() : mState(nullptr), mRecords(nullptr), mArena(nullptr) {}
+    static size_t memSize(uint32_t capacity, uint32_t arenaSize);
+    // sets up an empty ring, in mem of memSize() bytes if not nullptr
+    void init(uint32_t capacity, uint32_t arenaSize, char* mem = nullptr);
+    // uses a ring left in mem by init(), false if it is not consistent
+    bool attach(char* mem, size_t memLen);
+    void append(const char* data, uint32_t dataLen, uint32_t flags, uint64_t timestamp,
+            uint64_t seq);
+    inline uint32_t size() const { return (nullptr == mState) ? 0 : mState->mCount; }
+    // i-th oldest record, i < size()
+    inline const Record& at(uint32_t i) const {
+        return mRecords[(mState->mHead + i) % mState->mCapacity];
+    }
+    inline const char* text(const Record& record) const { return &mArena[record.mOffset]; }
+    inline void pop() {
+        if (size() > 0) {
+            mState->mHead = (mState->mHead + 1) % mState->mCapacity;
+            mState->mCount--;
+        }
+    }
+    inline void flush() {
+        if (nullptr != mState) {
+            mState->mHead = mState->mCount = mState->mArenaTail = 0;
+        }
+    }
+};
+
+// Single producer / single consumer ring, in which a logging thread stages its
+// records, so that append() does not need to take the LogBuffer lock. The
+// owning thread is the only producer; consumers drain it while holding the
+// LogBuffer lock, which makes them one consumer.
+class LogStage {
+public:
+    struct Record {
+        // length of payload; WRAP_MARKER if the rest of the ring is skipped
+        uint32_t mLen;
+        int16_t mLevel;
+        uint16_t mFlags;
+        uint64_t mSeq;
+        uint64_t mTimestamp;
+    };
+    static const uint32_t WRAP_MARKER = 0xffffffff;
+private:
+    std::atomic<uint32_t> mHead;
+    std::atomic<uint32_t> mTail;
+    char mRing[LOG_STAGE_SIZE] __attribute__((aligned(8)));
+public:
+    inline LogStage() : mHead(0), mTail(0) {}
+    // producer side, false if not enough room
+    bool push(const char* data, uint32_t len, int level, uint32_t flags, uint64_t timestamp,
+            uint64_t seq);
+    // consumer side, the oldest record or nullptr if empty
+    const Record* front();
+    // false if head and tail, as read from a log file, are not possible
+    inline bool isConsistent() const {
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_relaxed)
+                <= LOG_STAGE_SIZE;
+    }
+    void pop();
+};
+
+// head of the log file the rings and stages are mapped in, when
+// LOG_BUFFER_PERSISTENT is on
+struct LogMapHead {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    int32_t mPid;
+    uint32_t mStageCount;
+    uint64_t mSize;
+    uint64_t mLevelOffset[TOTAL_LOG_LEVELS];
+    uint64_t mLevelSize[TOTAL_LOG_LEVELS];
+    uint64_t mStageOffset;
+};
+
+struct LogStageHolder;
+
 class LogBuffer {
+    friend struct LogStageHolder;
 private:
     static LogBuffer* mInstance;
     static struct sigaction mOriSigAction[NSIG];
     static struct sigaction mNewSigAction;
     static mutex sLock;
 
-    SkipList<pair<uint64_t, string>> mLogList;
+    vector<LogLevelRing> mLogRings;
     vector<ConfigsInLevel> mConfigVec;
+    std::atomic<uint64_t> mSeq;
+    // staging rings of all logging threads, guarded by mLock
+    vector<LogStage*> mStages;
+    // unused LogStage slots in the mapped file, guarded by mLock
+    vector<LogStage*> mFreeStages;
     mutex mLock;
+    uint32_t mPersistent;
+    char* mMap;
+    size_t mMapSize;
 
-    const vector<string> mLevelMap {"E", "W", "I", "D", "V"};
+    static const char* const sLevelMap[TOTAL_LOG_LEVELS];
 
 public:
     static LogBuffer* getInstance();
     void append(string& data, int level, uint64_t timestamp);
+    // keeps format and the raw args, to be formatted by dump(). format and
+    // tag must be string literals, as only their pointers are kept.
+    void appendDeferred(int level, uint64_t timestamp, const char* tag, const char* format,
+            va_list args);
     void dump(std::function<void(stringstream&)> log, int level = -1);
     void dumpToAdbLogcat();
     void dumpToLogFile(string filePath);
     void flush();
+    // dumps a log file left by a LOG_BUFFER_PERSISTENT process, false if the
+    // file can not be read or is not a log file
+    static bool dumpMappedFile(const string& filePath,
+            std::function<void(stringstream&)> log);
 private:
     LogBuffer();
+    bool mapFile();
+    static void formatLine(stringstream& line, uint64_t timestamp, int level, uint32_t flags,
+            const char* text, uint32_t len);
+    LogStage* getStage();
+    void releaseStage(LogStage* stage);
+    void drainStagesLocked();
+    static uint32_t encodeDeferred(char* buf, uint32_t size, const char* tag,
+            const char* format, va_list args, bool inlineFormat);
+    static uint32_t encodeDeferredArgs(char* buf, uint32_t len, uint32_t size,
+            const char* format, va_list args, int savedErrno);
+    static string decodeDeferred(const char* buf, uint32_t len, uint32_t flags);
+    void append(const char* data, uint32_t len, int level, uint32_t flags, uint64_t timestamp);
+    void appendLocked(const char* data, uint32_t len, int level, uint32_t flags,
+            uint64_t timestamp, uint64_t seq);
     void registerSignalHandler();
     static void signalHandler(const int code, siginfo_t *const si, void *const sc);
 
@@ -30,7 +30,27 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <string>
+#include <sstream>
+#include <new>
 #include <MsgTask.h>
+#include <LocMpscQueue.h>
+#include <LocAtrace.h>
 #include <msg_q.h>
 #include <log_util.h>
 #include <loc_log.h>
@@ -38,11 +58,689 @@
 
 namespace loc_util {
 
+// Queue backend of a MsgTask. send() may be called from any thread,
+// rcv() and flush() only from the MsgTask thread (or after it is gone).
+class MsgQueue {
+public:
+    inline MsgQueue() = default;
+    inline virtual ~MsgQueue() = default;
+    // returns false if the msg could not be taken, in which case the
+    // caller still owns it
+    virtual bool send(const LocMsg* msg, MsgTaskPriority priority) = 0;
+    // blocks until a msg is available; nullptr once unblocked
+    virtual const LocMsg* rcv() = 0;
+    // blocks until a msg is available, then takes up to maxCount msgs in
+    // order, all from the same lane; returns how many, 0 once unblocked
+    virtual uint32_t rcvBatch(const LocMsg** msgs, uint32_t maxCount,
+                              MsgTaskPriority& priority) = 0;
+    // non blocking, the next high priority msg if any. Lets a batch being
+    // processed yield to time critical msgs that arrived in the meantime.
+    inline virtual const LocMsg* tryRcvHigh() { return nullptr; }
+    // non blocking, the next msg if any, high priority ones first
+    inline virtual const LocMsg* tryRcv() { return nullptr; }
+    // eventfd signalled in place of waking a thread up, -1 if none
+    inline virtual int getEventFd() const { return -1; }
+    // eventfd queue only: the consumer found the queue empty and goes back
+    // to polling the eventfd. Returns true if a msg came in meanwhile and
+    // the queue has to be looked at again.
+    inline virtual bool arm() { return false; }
+    // approximate number of msgs queued, for stats
+    virtual size_t depth() const = 0;
+    virtual void unblock() = 0;
+    // deletes all the msgs still queued
+    virtual void flush() = 0;
+};
+
+static void LocMsgDestroy(void* msg) {
+    delete (LocMsg*)msg;
+}
+
+class LegacyMsgQueue : public MsgQueue {
+    void* mQ;
+    std::atomic<int32_t> mDepth;
+public:
+    inline LegacyMsgQueue() : mQ((void*)msg_q_init2()), mDepth(0) {}
+    inline virtual ~LegacyMsgQueue() { msg_q_destroy(&mQ); }
+    // single FIFO, priority is not supported
+    inline virtual bool send(const LocMsg* msg, MsgTaskPriority /*priority*/) override {
+        bool sent = (eMSG_Q_SUCCESS == msg_q_snd(mQ, (void*)msg, LocMsgDestroy));
+        if (sent) {
+            mDepth.fetch_add(1, std::memory_order_relaxed);
+        }
+        return sent;
+    }
+    virtual const LocMsg* rcv() override {
+        LocMsg* msg = nullptr;
+        msq_q_err_type result = msg_q_rcv(mQ, (void **)&msg);
+        if (eMSG_Q_SUCCESS != result) {
+            LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
+                     loc_get_msg_q_status(result));
+            msg = nullptr;
+        } else {
+            mDepth.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return msg;
+    }
+    virtual uint32_t rcvBatch(const LocMsg** msgs, uint32_t maxCount,
+                              MsgTaskPriority& priority) override {
+        unsigned int count = 0;
+        priority = MSG_TASK_PRIORITY_NORMAL;
+        msq_q_err_type result = msg_q_rcv_batch(mQ, (void**)msgs, maxCount, &count);
+        if (eMSG_Q_SUCCESS != result) {
+            LOC_LOGE("%s:%d] fail receiving msgs: %s\n", __func__, __LINE__,
+                     loc_get_msg_q_status(result));
+            count = 0;
+        } else {
+            mDepth.fetch_sub(count, std::memory_order_relaxed);
+        }
+        return count;
+    }
+    inline virtual size_t depth() const override {
+        int32_t depth = mDepth.load(std::memory_order_relaxed);
+        return (depth > 0) ? depth : 0;
+    }
+    inline virtual void unblock() override { msg_q_unblock(mQ); }
+    inline virtual void flush() override { msg_q_flush(mQ); }
+};
+
+class RingMsgQueue : public MsgQueue {
+    // one lock-free ring plus its overflow list per priority
+    struct Lane {
+        LocMpscQueue<const LocMsg> mRing;
+        // guarded by RingMsgQueue::mLock
+        std::deque<const LocMsg*> mSpill;
+        // set while mSpill is not empty; producers then bypass the ring so
+        // that each producer's msgs stay in order
+        std::atomic<bool> mSpilling;
+        std::atomic<uint32_t> mSpillSize;
+        inline Lane(uint32_t ringSize) :
+                mRing(ringSize), mSpill(), mSpilling(false), mSpillSize(0) {}
+        // mLock must be held
+        inline bool emptyLocked() const { return mRing.empty() && mSpill.empty(); }
+    };
+
+    Lane mNormal;
+    Lane mHigh;
+    const MsgTaskOverflowPolicy mOverflowPolicy;
+    // -1 unless the consumer polls an eventfd instead of waiting on mCond
+    const int mEventFd;
+    // mLock guards the spill lists and the consumer going to sleep.
+    // Producers only take it if a ring is full or the consumer is asleep.
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::atomic<bool> mWaiting;
+    std::atomic<bool> mUnblocked;
+    std::atomic<uint32_t> mDropped;
+
+    inline Lane& lane(MsgTaskPriority priority) {
+        return (MSG_TASK_PRIORITY_HIGH == priority) ? mHigh : mNormal;
+    }
+
+public:
+    // the high lane only carries the odd time critical msg
+    // with an eventfd the consumer starts out waiting on it
+    inline RingMsgQueue(uint32_t ringSize, MsgTaskOverflowPolicy overflowPolicy,
+                        bool useEventFd = false) :
+            mNormal(ringSize), mHigh(std::max(ringSize / 4, (uint32_t)16)),
+            mOverflowPolicy(overflowPolicy),
+            mEventFd(useEventFd ? eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) : -1),
+            mWaiting(useEventFd), mUnblocked(false), mDropped(0) {
+        if (useEventFd && mEventFd < 0) {
+            LOC_LOGE("%s: failed to create eventfd, reason: %s", __func__, strerror(errno));
+        }
+    }
+    inline virtual ~RingMsgQueue() {
+        if (mEventFd >= 0) {
+            ::close(mEventFd);
+        }
+    }
+
+    virtual bool send(const LocMsg* msg, MsgTaskPriority priority) override {
+        if (mUnblocked.load(std::memory_order_acquire)) {
+            return false;
+        }
+        Lane& l = lane(priority);
+        if (l.mSpilling.load(std::memory_order_acquire) || !l.mRing.push(msg)) {
+            // time critical msgs are never dropped
+            if (MSG_TASK_OVERFLOW_DROP == mOverflowPolicy && &mNormal == &l) {
+                uint32_t dropped = ++mDropped;
+                if (1 == dropped || 0 == (dropped % 100)) {
+                    LOC_LOGW("%s: ring of %zu full, %u msgs dropped so far",
+                             __func__, l.mRing.capacity(), dropped);
+                }
+                delete msg;
+            } else {
+                std::lock_guard<std::mutex> guard(mLock);
+                if (l.mSpill.empty()) {
+                    LOC_LOGW("%s: ring of %zu full, spilling, priority %d",
+                             __func__, l.mRing.capacity(), priority);
+                }
+                l.mSpilling.store(true, std::memory_order_release);
+                l.mSpill.push_back(msg);
+                l.mSpillSize.fetch_add(1, std::memory_order_relaxed);
+                mCond.notify_one();
+            }
+            signalEventFd();
+            return true;
+        }
+        // pairs with the fence in rcv(), so that either we see the consumer
+        // waiting, or the consumer sees the msg we just pushed.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mEventFd >= 0) {
+            signalEventFd();
+        } else if (mWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> guard(mLock);
+            mCond.notify_one();
+        }
+        return true;
+    }
+
+    inline virtual const LocMsg* tryRcv() override {
+        return mUnblocked.load(std::memory_order_acquire) ? nullptr : popAny();
+    }
+
+    inline virtual int getEventFd() const override { return mEventFd; }
+
+    virtual bool arm() override {
+        mWaiting.store(true, std::memory_order_relaxed);
+        // pairs with the fence in send()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return !mUnblocked.load(std::memory_order_acquire) &&
+                !(mHigh.mRing.empty() && !mHigh.mSpilling.load(std::memory_order_acquire) &&
+                  mNormal.mRing.empty() && !mNormal.mSpilling.load(std::memory_order_acquire));
+    }
+
+    virtual const LocMsg* rcv() override {
+        const LocMsg* msg = nullptr;
+        while (!mUnblocked.load(std::memory_order_acquire) &&
+               nullptr == (msg = popAny()) && waitForMsg());
+        return msg;
+    }
+
+    // a batch never mixes lanes, so that the high lane msgs that come in
+    // while it is processed cannot overtake older ones in the batch
+    virtual uint32_t rcvBatch(const LocMsg** msgs, uint32_t maxCount,
+                              MsgTaskPriority& priority) override {
+        uint32_t count = 0;
+        if (mUnblocked.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        do {
+            priority = MSG_TASK_PRIORITY_HIGH;
+            count = popLane(mHigh, msgs, maxCount);
+            if (0 == count) {
+                priority = MSG_TASK_PRIORITY_NORMAL;
+                count = popLane(mNormal, msgs, maxCount);
+            }
+        } while (0 == count && waitForMsg());
+        return count;
+    }
+
+    inline virtual const LocMsg* tryRcvHigh() override {
+        return popLane(mHigh);
+    }
+
+    inline virtual size_t depth() const override {
+        return mNormal.mRing.size() + mNormal.mSpillSize.load(std::memory_order_relaxed) +
+                mHigh.mRing.size() + mHigh.mSpillSize.load(std::memory_order_relaxed);
+    }
+
+    virtual void unblock() override {
+        std::lock_guard<std::mutex> guard(mLock);
+        mUnblocked.store(true, std::memory_order_release);
+        mCond.notify_all();
+    }
+
+    virtual void flush() override {
+        flushLane(mHigh);
+        flushLane(mNormal);
+    }
+
+private:
+    // only the first msg after the consumer armed the eventfd writes it
+    inline void signalEventFd() {
+        uint64_t one = 1;
+        if (mEventFd >= 0 && mWaiting.exchange(false, std::memory_order_relaxed) &&
+            ::write(mEventFd, &one, sizeof(one)) < 0 && EAGAIN != errno) {
+            LOC_LOGW("%s: failed to signal eventfd, reason: %s", __func__, strerror(errno));
+        }
+    }
+
+    // blocks until any lane has a msg; false once unblocked
+    bool waitForMsg() {
+        std::unique_lock<std::mutex> lock(mLock);
+        mWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (mHigh.emptyLocked() && mNormal.emptyLocked() &&
+               !mUnblocked.load(std::memory_order_acquire)) {
+            mCond.wait(lock);
+        }
+        mWaiting.store(false, std::memory_order_relaxed);
+        return !mUnblocked.load(std::memory_order_acquire);
+    }
+
+    inline uint32_t popLane(Lane& l, const LocMsg** msgs, uint32_t maxCount) {
+        uint32_t count = 0;
+        while (count < maxCount && nullptr != (msgs[count] = popLane(l))) {
+            count++;
+        }
+        return count;
+    }
+
+    inline const LocMsg* popAny() {
+        const LocMsg* msg = popLane(mHigh);
+        return (nullptr != msg) ? msg : popLane(mNormal);
+    }
+
+    // non blocking, nullptr if the lane is empty
+    const LocMsg* popLane(Lane& l) {
+        const LocMsg* msg = l.mRing.pop();
+        if (nullptr == msg && l.mSpilling.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> guard(mLock);
+            // the ring must be drained ahead of the spill list, and a msg
+            // may have landed in the ring before it filled up.
+            if (l.mRing.empty() && !l.mSpill.empty()) {
+                msg = l.mSpill.front();
+                l.mSpill.pop_front();
+                l.mSpillSize.fetch_sub(1, std::memory_order_relaxed);
+                if (l.mSpill.empty()) {
+                    l.mSpilling.store(false, std::memory_order_release);
+                }
+            }
+        }
+        return msg;
+    }
+
+    void flushLane(Lane& l) {
+        const LocMsg* msg = nullptr;
+        while (nullptr != (msg = l.mRing.pop())) {
+            delete msg;
+        }
+        std::lock_guard<std::mutex> guard(mLock);
+        for (auto spilled : l.mSpill) {
+            delete spilled;
+        }
+        l.mSpill.clear();
+        l.mSpillSize.store(0, std::memory_order_relaxed);
+        l.mSpilling.store(false, std::memory_order_release);
+    }
+};
+
+// blocks of RunMsg pool per MsgTask
+#define MSG_TASK_RUN_MSG_POOL_BLOCKS 64
+#define LOC_MSG_POOL_NO_BLOCK 0xFFFFFFFF
+
+struct LocMsgPool::BlockHeader {
+    // nullptr for a block from the heap
+    LocMsgPool* mPool;
+    uint32_t mIndex;
+    std::atomic<uint32_t> mNext;
+};
+
+#define LOC_MSG_POOL_BLOCK_SIZE \
+    (sizeof(LocMsgPool::BlockHeader) + LocMsgPool::BLOCK_PAYLOAD_SIZE)
+
+LocMsgPool::LocMsgPool(uint32_t blocks) :
+        mBlocks(blocks),
+        mStorage(new char[(size_t)blocks * LOC_MSG_POOL_BLOCK_SIZE + alignof(max_align_t)]),
+        mFreeHead(0 == blocks ? LOC_MSG_POOL_NO_BLOCK : 0) {
+    static_assert(sizeof(BlockHeader) % alignof(max_align_t) == 0,
+                  "block payload would be misaligned");
+    for (uint32_t i = 0; i < mBlocks; i++) {
+        BlockHeader* header = block(i);
+        header->mPool = this;
+        header->mIndex = i;
+        header->mNext.store((i + 1 < mBlocks) ? i + 1 : LOC_MSG_POOL_NO_BLOCK,
+                            std::memory_order_relaxed);
+    }
+}
+
+LocMsgPool::~LocMsgPool() {
+    delete[] mStorage;
+}
+
+inline LocMsgPool::BlockHeader* LocMsgPool::block(uint32_t index) const {
+    uintptr_t base = ((uintptr_t)mStorage + alignof(max_align_t) - 1) &
+            ~(uintptr_t)(alignof(max_align_t) - 1);
+    return (BlockHeader*)(base + (size_t)index * LOC_MSG_POOL_BLOCK_SIZE);
+}
+
+void* LocMsgPool::alloc() {
+    BlockHeader* header = nullptr;
+    uint64_t head = mFreeHead.load(std::memory_order_acquire);
+    while (LOC_MSG_POOL_NO_BLOCK != (uint32_t)head) {
+        BlockHeader* candidate = block((uint32_t)head);
+        uint64_t next = (((head >> 32) + 1) << 32) |
+                candidate->mNext.load(std::memory_order_relaxed);
+        if (mFreeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel)) {
+            header = candidate;
+            break;
+        }
+    }
+    if (nullptr == header) {
+        header = (BlockHeader*)::operator new(LOC_MSG_POOL_BLOCK_SIZE, std::nothrow);
+        if (nullptr == header) {
+            return nullptr;
+        }
+        header->mPool = nullptr;
+    }
+    return header + 1;
+}
+
+void LocMsgPool::free(void* payload) {
+    if (nullptr == payload) {
+        return;
+    }
+    BlockHeader* header = (BlockHeader*)payload - 1;
+    LocMsgPool* pool = header->mPool;
+    if (nullptr == pool) {
+        ::operator delete(header);
+        return;
+    }
+    uint64_t head = pool->mFreeHead.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        header->mNext.store((uint32_t)head, std::memory_order_relaxed);
+        next = (((head >> 32) + 1) << 32) | header->mIndex;
+    } while (!pool->mFreeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed));
+}
+
+// LocMsg size classes; a msg bigger than the last class comes from the heap
+static const size_t sLocMsgBlockSizes[] = {64, 128, 256, 512, 1024};
+#define LOC_MSG_SIZE_CLASSES (sizeof(sLocMsgBlockSizes) / sizeof(sLocMsgBlockSizes[0]))
+// each slab is carved into blocks of one size class
+#define LOC_MSG_SLAB_SIZE (16 * 1024)
+// blocks a thread keeps per size class, and moves to or from the shared
+// slabs in one go
+#define LOC_MSG_CACHE_BLOCKS 32
+#define LOC_MSG_CACHE_BATCH 16
+
+struct LocMsgFreeBlock {
+    LocMsgFreeBlock* mNext;
+};
+
+static inline uint32_t locMsgSizeClass(size_t size) {
+    uint32_t sizeClass = 0;
+    while (sizeClass < LOC_MSG_SIZE_CLASSES && size > sLocMsgBlockSizes[sizeClass]) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+// The free lists shared by all threads, one lock per size class
+class LocMsgSlabs {
+    struct SizeClass {
+        std::mutex mLock;
+        LocMsgFreeBlock* mFree;
+        std::atomic<uint64_t> mAllocCount;
+        std::atomic<uint64_t> mFreeCount;
+        std::atomic<uint64_t> mSlabBytes;
+        inline SizeClass() : mFree(nullptr), mAllocCount(0), mFreeCount(0), mSlabBytes(0) {}
+    };
+    // the last one counts the msgs from the heap
+    SizeClass mClasses[LOC_MSG_SIZE_CLASSES + 1];
+
+public:
+    // never destroyed, msgs can still be freed by static destructors
+    static LocMsgSlabs& get() {
+        static LocMsgSlabs* slabs = new LocMsgSlabs();
+        return *slabs;
+    }
+    // pops up to count blocks onto list, carving a new slab if none is
+    // free; returns how many. Out of memory fails like a plain new would.
+    uint32_t take(uint32_t sizeClass, LocMsgFreeBlock*& list, uint32_t count) {
+        SizeClass& c = mClasses[sizeClass];
+        std::lock_guard<std::mutex> guard(c.mLock);
+        if (nullptr == c.mFree) {
+            char* slab = (char*)::operator new(LOC_MSG_SLAB_SIZE);
+            size_t blockSize = sLocMsgBlockSizes[sizeClass];
+            for (size_t offset = 0; offset + blockSize <= LOC_MSG_SLAB_SIZE;
+                 offset += blockSize) {
+                LocMsgFreeBlock* block = (LocMsgFreeBlock*)(slab + offset);
+                block->mNext = c.mFree;
+                c.mFree = block;
+            }
+            c.mSlabBytes.fetch_add(LOC_MSG_SLAB_SIZE, std::memory_order_relaxed);
+        }
+        uint32_t taken = 0;
+        while (taken < count && nullptr != c.mFree) {
+            LocMsgFreeBlock* block = c.mFree;
+            c.mFree = block->mNext;
+            block->mNext = list;
+            list = block;
+            taken++;
+        }
+        return taken;
+    }
+    // pushes count blocks from the head of list back, leaving list at the rest
+    void give(uint32_t sizeClass, LocMsgFreeBlock*& list, uint32_t count) {
+        SizeClass& c = mClasses[sizeClass];
+        std::lock_guard<std::mutex> guard(c.mLock);
+        for (uint32_t i = 0; i < count && nullptr != list; i++) {
+            LocMsgFreeBlock* block = list;
+            list = block->mNext;
+            block->mNext = c.mFree;
+            c.mFree = block;
+        }
+    }
+    inline void count(uint32_t sizeClass, uint64_t allocCount, uint64_t freeCount) {
+        mClasses[sizeClass].mAllocCount.fetch_add(allocCount, std::memory_order_relaxed);
+        mClasses[sizeClass].mFreeCount.fetch_add(freeCount, std::memory_order_relaxed);
+    }
+    void getStats(std::vector<LocMsgAllocStats>& stats) const {
+        stats.clear();
+        for (uint32_t i = 0; i <= LOC_MSG_SIZE_CLASSES; i++) {
+            LocMsgAllocStats entry = {};
+            entry.mBlockSize = (i < LOC_MSG_SIZE_CLASSES) ? sLocMsgBlockSizes[i] : 0;
+            entry.mAllocCount = mClasses[i].mAllocCount.load(std::memory_order_relaxed);
+            entry.mFreeCount = mClasses[i].mFreeCount.load(std::memory_order_relaxed);
+            entry.mSlabBytes = mClasses[i].mSlabBytes.load(std::memory_order_relaxed);
+            stats.push_back(entry);
+        }
+    }
+};
+
+// Blocks a thread allocates from and frees to without a lock. Msgs are
+// mostly created on one thread and deleted on the MsgTask thread, so a
+// cache fills on one side and drains on the other, a batch at a time.
+struct LocMsgThreadCache {
+    LocMsgFreeBlock* mFree[LOC_MSG_SIZE_CLASSES];
+    uint32_t mCount[LOC_MSG_SIZE_CLASSES];
+    uint32_t mAllocCount[LOC_MSG_SIZE_CLASSES];
+    uint32_t mFreeCount[LOC_MSG_SIZE_CLASSES];
+    // set once the thread is exiting, msgs deleted after that by other
+    // thread_local destructors go straight to the shared slabs
+    bool mExited;
+
+    inline LocMsgThreadCache() :
+            mFree{}, mCount{}, mAllocCount{}, mFreeCount{}, mExited(false) {}
+    ~LocMsgThreadCache() {
+        LocMsgSlabs& slabs = LocMsgSlabs::get();
+        for (uint32_t i = 0; i < LOC_MSG_SIZE_CLASSES; i++) {
+            slabs.give(i, mFree[i], mCount[i]);
+            mCount[i] = 0;
+            flushCounts(i);
+        }
+        mExited = true;
+    }
+    inline void flushCounts(uint32_t sizeClass) {
+        LocMsgSlabs::get().count(sizeClass, mAllocCount[sizeClass], mFreeCount[sizeClass]);
+        mAllocCount[sizeClass] = 0;
+        mFreeCount[sizeClass] = 0;
+    }
+};
+
+static thread_local LocMsgThreadCache sLocMsgCache;
+
+void* LocMsg::operator new(size_t size) {
+    uint32_t sizeClass = locMsgSizeClass(size);
+    if (sizeClass >= LOC_MSG_SIZE_CLASSES) {
+        void* msg = ::operator new(size);
+        LocMsgSlabs::get().count(LOC_MSG_SIZE_CLASSES, 1, 0);
+        return msg;
+    }
+    LocMsgThreadCache& cache = sLocMsgCache;
+    if (cache.mExited) {
+        LocMsgFreeBlock* block = nullptr;
+        LocMsgSlabs::get().take(sizeClass, block, 1);
+        LocMsgSlabs::get().count(sizeClass, 1, 0);
+        return block;
+    }
+    if (0 == cache.mCount[sizeClass]) {
+        cache.mCount[sizeClass] = LocMsgSlabs::get().take(
+                sizeClass, cache.mFree[sizeClass], LOC_MSG_CACHE_BATCH);
+        cache.flushCounts(sizeClass);
+    }
+    LocMsgFreeBlock* block = cache.mFree[sizeClass];
+    cache.mFree[sizeClass] = block->mNext;
+    cache.mCount[sizeClass]--;
+    cache.mAllocCount[sizeClass]++;
+    return block;
+}
+
+void* LocMsg::operator new(size_t size, const std::nothrow_t&) noexcept {
+    return LocMsg::operator new(size);
+}
+
+void LocMsg::operator delete(void* msg, size_t size) {
+    if (nullptr == msg) {
+        return;
+    }
+    uint32_t sizeClass = locMsgSizeClass(size);
+    if (sizeClass >= LOC_MSG_SIZE_CLASSES) {
+        ::operator delete(msg);
+        LocMsgSlabs::get().count(LOC_MSG_SIZE_CLASSES, 0, 1);
+        return;
+    }
+    LocMsgThreadCache& cache = sLocMsgCache;
+    LocMsgFreeBlock* block = (LocMsgFreeBlock*)msg;
+    if (cache.mExited) {
+        block->mNext = nullptr;
+        LocMsgSlabs::get().give(sizeClass, block, 1);
+        LocMsgSlabs::get().count(sizeClass, 0, 1);
+        return;
+    }
+    block->mNext = cache.mFree[sizeClass];
+    cache.mFree[sizeClass] = block;
+    cache.mCount[sizeClass]++;
+    cache.mFreeCount[sizeClass]++;
+    if (cache.mCount[sizeClass] > LOC_MSG_CACHE_BLOCKS) {
+        LocMsgSlabs::get().give(sizeClass, cache.mFree[sizeClass], LOC_MSG_CACHE_BATCH);
+        cache.mCount[sizeClass] -= LOC_MSG_CACHE_BATCH;
+        cache.flushCounts(sizeClass);
+    }
+}
+
+// log2 buckets of microseconds, bucket i counts [2^(i-1), 2^i) us;
+// bucket 0 is under 1us and the last one everything from ~32ms up
+#define MSG_LATENCY_BUCKETS 17
+
+struct MsgLatencyHistogram {
+    uint32_t mBuckets[MSG_LATENCY_BUCKETS];
+    uint64_t mTotalNs;
+    uint64_t mMaxNs;
+
+    inline MsgLatencyHistogram() : mBuckets{}, mTotalNs(0), mMaxNs(0) {}
+    inline void add(uint64_t ns) {
+        uint64_t us = ns / 1000;
+        uint32_t bucket = 0;
+        while (us > 0 && bucket < MSG_LATENCY_BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        mBuckets[bucket]++;
+        mTotalNs += ns;
+        if (ns > mMaxNs) {
+            mMaxNs = ns;
+        }
+    }
+    // upper bound in us of the bucket holding the given percentile
+    inline uint64_t percentileUs(uint32_t count, uint32_t percent) const {
+        uint64_t target = ((uint64_t)count * percent + 99) / 100;
+        uint64_t seen = 0;
+        uint32_t bucket = 0;
+        for (; bucket < MSG_LATENCY_BUCKETS - 1; bucket++) {
+            seen += mBuckets[bucket];
+            if (seen >= target) {
+                break;
+            }
+        }
+        // the last bucket is open ended, its bound is the max seen
+        return (MSG_LATENCY_BUCKETS - 1 == bucket) ? mMaxNs / 1000 : (uint64_t)1 << bucket;
+    }
+};
+
+// latency of one msg type, keyed by its vtable
+struct MsgLatencyEntry {
+    uint32_t mCount;
+    // sendMsg() to the start of log() + proc()
+    MsgLatencyHistogram mWait;
+    // log() + proc() + delete
+    MsgLatencyHistogram mProc;
+    inline MsgLatencyEntry() : mCount(0), mWait(), mProc() {}
+};
+
+// Readable name for a msg type from its vtable. RTTI is off in the
+// Android build, so this goes by the dynamic symbol of the vtable, if
+// the type has one, else library + offset for addr2line.
+static std::string msgTypeName(const void* vptr) {
+    Dl_info info = {};
+    std::string name;
+    if (0 == dladdr(vptr, &info)) {
+        std::stringstream ss;
+        ss << vptr;
+        name = ss.str();
+    } else if (nullptr != info.dli_sname &&
+               (const char*)info.dli_saddr + 2 * sizeof(void*) == (const char*)vptr) {
+        int status = -1;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name = (0 == status && nullptr != demangled) ? demangled : info.dli_sname;
+        free(demangled);
+    } else {
+        const char* lib = (nullptr != info.dli_fname) ? strrchr(info.dli_fname, '/') : nullptr;
+        std::stringstream ss;
+        ss << ((nullptr != lib) ? lib + 1 : info.dli_fname) << "+0x" << std::hex <<
+                ((uintptr_t)vptr - (uintptr_t)info.dli_fbase);
+        name = ss.str();
+    }
+    return name;
+}
+
 class MTRunnable : public LocRunnable {
-    const void* mQ;
+    static std::mutex sRegistryLock;
+    static std::list<MTRunnable*> sRegistry;
+
+    const std::string mName;
+    MsgQueue* mQ;
+    LocMsgPool* mPool;
+    std::atomic<uint32_t> mMaxBatchSize;
+    // only touched by the MsgTask thread
+    std::vector<const LocMsg*> mBatch;
+    // written by the MsgTask thread only, read by getStats() from anywhere
+    std::atomic<uint64_t> mMsgCount;
+    std::atomic<uint64_t> mBatchCount;
+    std::atomic<uint32_t> mMaxBatchSeen;
+    std::atomic<uint32_t> mQueueDepthHighWater;
+    std::atomic<uint64_t> mProcTimeNs;
+    std::atomic<uint64_t> mMaxProcTimeNs;
+    // per msg type latency, guarded by mLatencyLock
+    mutable std::mutex mLatencyLock;
+    std::unordered_map<const void*, MsgLatencyEntry> mLatency;
+
+    inline void process(const LocMsg* msg);
+    inline void countBatch(uint32_t batchSize, size_t depth);
+    void dumpStats(std::function<void(std::stringstream&)> log) const;
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
+    MTRunnable(const char* name, MsgQueue* q, LocMsgPool* pool);
     virtual ~MTRunnable();
+    static void dumpAllStats(std::function<void(std::stringstream&)> log);
+    inline void setBatchDrain(uint32_t maxBatchSize) {
+        mMaxBatchSize.store(maxBatchSize > 1 ? maxBatchSize : 1,
+                            std::memory_order_relaxed);
+    }
+    void getStats(MsgTaskStats& stats) const;
+    uint32_t processPending(uint32_t maxCount);
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
     // until thread is stopped.
@@ -56,18 +754,51 @@ public:
     virtual void interrupt() override;
 };
 
-static void LocMsgDestroy(void* msg) {
-    delete (LocMsg*)msg;
+std::mutex MTRunnable::sRegistryLock;
+std::list<MTRunnable*> MTRunnable::sRegistry;
+
+MTRunnable::MTRunnable(const char* name, MsgQueue* q, LocMsgPool* pool) :
+        mName((nullptr != name) ? name : "LocThread"), mQ(q), mPool(pool),
+        mMaxBatchSize(1), mBatch(), mMsgCount(0), mBatchCount(0), mMaxBatchSeen(0),
+        mQueueDepthHighWater(0), mProcTimeNs(0), mMaxProcTimeNs(0), mLatency() {
+    std::lock_guard<std::mutex> guard(sRegistryLock);
+    sRegistry.push_back(this);
 }
 
 MsgTask::MsgTask(const char* threadName) :
-    mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+    mQ(new LegacyMsgQueue()), mPool(new LocMsgPool(MSG_TASK_RUN_MSG_POOL_BLOCKS)),
+    mRunnable(std::make_shared<MTRunnable>(threadName, mQ, mPool)), mThread() {
+    mThread.start(threadName, mRunnable);
+}
+
+MsgTask::MsgTask(const char* threadName, uint32_t ringSize,
+                 MsgTaskOverflowPolicy overflowPolicy, MsgTaskWakeup wakeup) :
+    mQ((ringSize > 0) ?
+       (MsgQueue*)new RingMsgQueue(ringSize, overflowPolicy,
+                                   MSG_TASK_WAKEUP_EVENTFD == wakeup) :
+       (MsgQueue*)new LegacyMsgQueue()),
+    mPool(new LocMsgPool(MSG_TASK_RUN_MSG_POOL_BLOCKS)),
+    mRunnable(std::make_shared<MTRunnable>(threadName, mQ, mPool)), mThread() {
+    if (MSG_TASK_WAKEUP_EVENTFD != wakeup) {
+        mThread.start(threadName, mRunnable);
+    } else if (0 == ringSize) {
+        LOC_LOGE("%s: %s needs a ring to signal an eventfd", __func__, threadName);
+    }
+}
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
-void MsgTask::sendMsg(const LocMsg* msg) const {
+void MsgTask::sendMsg(const LocMsg* msg, MsgTaskPriority priority) const {
     if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        msg->mSendTimeNs = monotonicNs();
+        if (!mQ->send(msg, priority)) {
+            LOC_LOGW("%s: queue no longer accepting, msg %p dropped", __func__, msg);
+            delete msg;
+        }
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
@@ -85,8 +816,33 @@ void MsgTask::sendMsg(const std::function<void()> runnable) const {
     sendMsg(new RunMsg(runnable));
 }
 
+void MsgTask::setBatchDrain(uint32_t maxBatchSize) const {
+    mRunnable->setBatchDrain(maxBatchSize);
+}
+
+void MsgTask::getStats(MsgTaskStats& stats) const {
+    mRunnable->getStats(stats);
+}
+
+int MsgTask::getEventFd() const {
+    return mQ->getEventFd();
+}
+
+uint32_t MsgTask::processPending(uint32_t maxCount) const {
+    return mRunnable->processPending(maxCount);
+}
+
+void MTRunnable::getStats(MsgTaskStats& stats) const {
+    stats.mMsgCount = mMsgCount.load(std::memory_order_relaxed);
+    stats.mBatchCount = mBatchCount.load(std::memory_order_relaxed);
+    stats.mMaxBatchSize = mMaxBatchSeen.load(std::memory_order_relaxed);
+    stats.mQueueDepthHighWater = mQueueDepthHighWater.load(std::memory_order_relaxed);
+    stats.mProcTimeNs = mProcTimeNs.load(std::memory_order_relaxed);
+    stats.mMaxProcTimeNs = mMaxProcTimeNs.load(std::memory_order_relaxed);
+}
+
 void MTRunnable::interrupt() {
-    msg_q_unblock((void*)mQ);
+    mQ->unblock();
 }
 
 void MTRunnable::prerun() {
@@ -94,27 +850,202 @@ void MTRunnable::prerun() {
      set_sched_policy(gettid(), SP_FOREGROUND);
 }
 
-bool MTRunnable::run() {
-    LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
-    if (eMSG_Q_SUCCESS != result) {
-        LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
-                 loc_get_msg_q_status(result));
-        return false;
+// a store instead of a RMW, only the MsgTask thread ever writes these
+template <typename T>
+static inline void storeMax(std::atomic<T>& maxVal, T val) {
+    if (val > maxVal.load(std::memory_order_relaxed)) {
+        maxVal.store(val, std::memory_order_relaxed);
     }
+}
+
+inline void MTRunnable::process(const LocMsg* msg) {
+    uint64_t startNs = monotonicNs();
+    uint64_t waitNs = (0 != msg->mSendTimeNs && startNs > msg->mSendTimeNs) ?
+            startNs - msg->mSendTimeNs : 0;
+    // the vptr identifies the msg type; it has to be read before delete
+    const void* vptr = nullptr;
+    memcpy(&vptr, (const void*)msg, sizeof(vptr));
 
     msg->log();
     // there is where each individual msg handling is invoked
+    LOC_ATRACE_BEGIN(mName.c_str());
     msg->proc();
+    LOC_ATRACE_END();
 
     delete msg;
 
+    uint64_t procNs = monotonicNs() - startNs;
+    mProcTimeNs.store(mProcTimeNs.load(std::memory_order_relaxed) + procNs,
+                      std::memory_order_relaxed);
+    storeMax(mMaxProcTimeNs, procNs);
+
+    std::lock_guard<std::mutex> guard(mLatencyLock);
+    MsgLatencyEntry& entry = mLatency[vptr];
+    entry.mCount++;
+    entry.mWait.add(waitNs);
+    entry.mProc.add(procNs);
+}
+
+void MTRunnable::dumpStats(std::function<void(std::stringstream&)> log) const {
+    MsgTaskStats stats = {};
+    getStats(stats);
+    std::stringstream ss;
+    ss << "MsgTask " << mName << ": msgs " << stats.mMsgCount << ", batches " <<
+            stats.mBatchCount << ", max batch " << stats.mMaxBatchSize <<
+            ", queue depth high water " << stats.mQueueDepthHighWater <<
+            ", proc total us " << stats.mProcTimeNs / 1000 << ", max us " <<
+            stats.mMaxProcTimeNs / 1000 << std::endl;
+    log(ss);
+
+    // try_lock, as this can run from the LogBuffer signal handler, which
+    // may have interrupted this very MsgTask thread in process()
+    std::unordered_map<const void*, MsgLatencyEntry> latency;
+    {
+        std::unique_lock<std::mutex> lock(mLatencyLock, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            std::stringstream busy;
+            busy << "  msg type latency busy, skipped" << std::endl;
+            log(busy);
+            return;
+        }
+        latency = mLatency;
+    }
+    for (auto& item : latency) {
+        const MsgLatencyEntry& entry = item.second;
+        std::stringstream line;
+        line << "  " << msgTypeName(item.first) << ": count " << entry.mCount <<
+                ", wait us p50<=" << entry.mWait.percentileUs(entry.mCount, 50) <<
+                " p99<=" << entry.mWait.percentileUs(entry.mCount, 99) <<
+                " max " << entry.mWait.mMaxNs / 1000 <<
+                ", proc us p50<=" << entry.mProc.percentileUs(entry.mCount, 50) <<
+                " p99<=" << entry.mProc.percentileUs(entry.mCount, 99) <<
+                " max " << entry.mProc.mMaxNs / 1000 <<
+                " total " << entry.mProc.mTotalNs / 1000 << std::endl;
+        line << "    wait hist";
+        for (uint32_t i = 0; i < MSG_LATENCY_BUCKETS; i++) {
+            line << " " << entry.mWait.mBuckets[i];
+        }
+        line << std::endl << "    proc hist";
+        for (uint32_t i = 0; i < MSG_LATENCY_BUCKETS; i++) {
+            line << " " << entry.mProc.mBuckets[i];
+        }
+        line << std::endl;
+        log(line);
+    }
+}
+
+void MTRunnable::dumpAllStats(std::function<void(std::stringstream&)> log) {
+    std::unique_lock<std::mutex> lock(sRegistryLock, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    for (auto runnable : sRegistry) {
+        runnable->dumpStats(log);
+    }
+}
+
+void MsgTask::dumpStats(std::function<void(std::stringstream&)> log) {
+    if (nullptr != log) {
+        MTRunnable::dumpAllStats(log);
+
+        std::vector<LocMsgAllocStats> allocStats;
+        getMsgAllocStats(allocStats);
+        std::stringstream ss;
+        ss << "LocMsg alloc:";
+        for (auto& entry : allocStats) {
+            ss << " [" << (0 == entry.mBlockSize ? "heap" : std::to_string(entry.mBlockSize)) <<
+                    " allocs " << entry.mAllocCount << " frees " << entry.mFreeCount <<
+                    " slab KB " << entry.mSlabBytes / 1024 << "]";
+        }
+        ss << std::endl;
+        log(ss);
+    }
+}
+
+void MsgTask::getMsgAllocStats(std::vector<LocMsgAllocStats>& stats) {
+    LocMsgSlabs::get().getStats(stats);
+}
+
+inline void MTRunnable::countBatch(uint32_t batchSize, size_t depth) {
+    LOC_ATRACE_INT(mName.c_str(), depth);
+    mMsgCount.store(mMsgCount.load(std::memory_order_relaxed) + batchSize,
+                    std::memory_order_relaxed);
+    mBatchCount.store(mBatchCount.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    storeMax(mMaxBatchSeen, batchSize);
+    storeMax(mQueueDepthHighWater, (uint32_t)(batchSize + depth));
+}
+
+bool MTRunnable::run() {
+    uint32_t maxBatchSize = mMaxBatchSize.load(std::memory_order_relaxed);
+    if (maxBatchSize <= 1) {
+        const LocMsg* msg = mQ->rcv();
+        if (nullptr == msg) {
+            return false;
+        }
+        countBatch(1, mQ->depth());
+        process(msg);
+    } else {
+        if (mBatch.size() < maxBatchSize) {
+            mBatch.resize(maxBatchSize);
+        }
+        MsgTaskPriority priority = MSG_TASK_PRIORITY_NORMAL;
+        uint32_t count = mQ->rcvBatch(mBatch.data(), maxBatchSize, priority);
+        if (0 == count) {
+            return false;
+        }
+        countBatch(count, mQ->depth());
+        for (uint32_t i = 0; i < count; i++) {
+            const LocMsg* high = nullptr;
+            while (MSG_TASK_PRIORITY_NORMAL == priority &&
+                   nullptr != (high = mQ->tryRcvHigh())) {
+                countBatch(1, mQ->depth());
+                process(high);
+            }
+            process(mBatch[i]);
+        }
+    }
+
     return true;
 }
 
+uint32_t MTRunnable::processPending(uint32_t maxCount) {
+    int eventFd = mQ->getEventFd();
+    if (eventFd < 0) {
+        return 0;
+    }
+    uint64_t count;
+    while (::read(eventFd, &count, sizeof(count)) > 0);
+
+    uint32_t processed = 0;
+    do {
+        const LocMsg* msg = nullptr;
+        while (processed < maxCount && nullptr != (msg = mQ->tryRcv())) {
+            countBatch(1, mQ->depth());
+            process(msg);
+            processed++;
+        }
+    } while (processed < maxCount && mQ->arm());
+
+    if (processed >= maxCount) {
+        // msgs may be left, and nothing signals while the queue is not armed
+        uint64_t one = 1;
+        if (::write(eventFd, &one, sizeof(one)) < 0 && EAGAIN != errno) {
+            LOC_LOGW("%s: failed to signal eventfd, reason: %s", __func__, strerror(errno));
+        }
+    }
+    return processed;
+}
+
 MTRunnable::~MTRunnable() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
+    {
+        std::lock_guard<std::mutex> guard(sRegistryLock);
+        sRegistry.remove(this);
+    }
+    mQ->flush();
+    delete mQ;
+    // only after flush(), queued PooledRunMsg's live in the pool
+    delete mPool;
 }
 
 } // namespace loc_util
@@ -29,26 +29,240 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
 #include <functional>
+#include <new>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <LocThread.h>
 
 namespace loc_util {
 
 struct LocMsg {
-    inline LocMsg() {}
+    // stamped by MsgTask::sendMsg(), CLOCK_MONOTONIC ns
+    mutable uint64_t mSendTimeNs;
+    inline LocMsg() : mSendTimeNs(0) {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+    // msgs come from size class slabs with a per thread cache, see
+    // MsgTask::getMsgAllocStats(); the virtual destructor makes delete
+    // pass the size of the actual msg type
+    static void* operator new(size_t size);
+    // for msgs made with new (std::nothrow); a failed allocation ends the
+    // process either way, as the slabs come from the throwing heap
+    static void* operator new(size_t size, const std::nothrow_t&) noexcept;
+    static void operator delete(void* msg, size_t size);
+};
+
+// Msgs run back to back as one, in the order they were added, so that a
+// burst of them takes a single trip through the queue
+struct LocMsgBatch : public LocMsg {
+    std::vector<const LocMsg*> mMsgs;
+    inline virtual ~LocMsgBatch() {
+        for (auto msg : mMsgs) {
+            delete msg;
+        }
+    }
+    inline virtual void proc() const override {
+        for (auto msg : mMsgs) {
+            msg->log();
+            msg->proc();
+        }
+    }
+};
+
+// Counters of one size class of the LocMsg allocator. Threads fold their
+// counts in whenever they go to the shared slabs, so the totals can lag
+// by a thread cache worth of msgs.
+struct LocMsgAllocStats {
+    // 0 for the msgs too big for any size class, which go to the heap
+    uint32_t mBlockSize;
+    uint64_t mAllocCount;
+    uint64_t mFreeCount;
+    // carved into blocks so far; slabs are never given back
+    uint64_t mSlabBytes;
+};
+
+// What a MsgTask with a lock-free ring does when the ring is full
+enum MsgTaskOverflowPolicy {
+    // park the msg on a locked overflow list, drained in order once the
+    // ring has room again. Nothing is lost, only the fast path is.
+    MSG_TASK_OVERFLOW_SPILL = 0,
+    // delete the msg and count it
+    MSG_TASK_OVERFLOW_DROP
+};
+
+// How the queue of a MsgTask wakes its consumer up. Only the lock-free
+// ring backend can signal an eventfd.
+enum MsgTaskWakeup {
+    // the MsgTask thread blocks on the queue
+    MSG_TASK_WAKEUP_THREAD = 0,
+    // no thread: the queue signals getEventFd(), which the owner polls
+    // along with its other fds, e.g. in a LocIpcReactor, and runs the msgs
+    // from its own thread with processPending()
+    MSG_TASK_WAKEUP_EVENTFD
+};
+
+// Counters of a MsgTask, all maintained by the MsgTask thread itself.
+// A batch is whatever one dequeue round hands to proc(): one msg unless
+// batch drain is enabled.
+struct MsgTaskStats {
+    uint64_t mMsgCount;
+    uint64_t mBatchCount;
+    uint32_t mMaxBatchSize;
+    // most msgs seen queued at the start of a dequeue round
+    uint32_t mQueueDepthHighWater;
+    // time spent in log() + proc() of all msgs
+    uint64_t mProcTimeNs;
+    uint64_t mMaxProcTimeNs;
+};
+
+// Lanes of a MsgTask. HIGH msgs are taken ahead of any NORMAL msg
+// already queued; order within a lane is FIFO. Only the lock-free ring
+// backend has lanes, a msg_q backed MsgTask is a single FIFO.
+enum MsgTaskPriority {
+    MSG_TASK_PRIORITY_NORMAL = 0,
+    // for time critical msgs, e.g. position reports, NI notifications
+    MSG_TASK_PRIORITY_HIGH
+};
+
+class MsgQueue;
+class MTRunnable;
+
+// Fixed size blocks that any thread can take and give back without a lock
+// or a heap allocation. When the pool runs dry alloc() falls back to the
+// heap, and free() knows where each block came from.
+class LocMsgPool {
+    struct BlockHeader;
+    const uint32_t mBlocks;
+    char* mStorage;
+    // index of the first free block in the low 32 bits, ABA tag in the high
+    std::atomic<uint64_t> mFreeHead;
+    inline BlockHeader* block(uint32_t index) const;
+public:
+    // bytes available to the caller in each block
+    static const size_t BLOCK_PAYLOAD_SIZE = 112;
+    LocMsgPool(uint32_t blocks);
+    ~LocMsgPool();
+    // returns BLOCK_PAYLOAD_SIZE bytes aligned for any type, nullptr if
+    // out of memory
+    void* alloc();
+    static void free(void* payload);
 };
 
 class MsgTask {
-    const void* mQ;
+    // a std::function<void()> kept inline in a pool block
+    template <typename Fn>
+    struct PooledRunMsg : public LocMsg {
+        mutable Fn mRunnable;
+        template <typename F>
+        inline PooledRunMsg(F&& runnable) : mRunnable(std::forward<F>(runnable)) {}
+        inline virtual ~PooledRunMsg() = default;
+        inline virtual void proc() const override { mRunnable(); }
+        inline static void* operator new(size_t, void* block) { return block; }
+        inline static void operator delete(void* block, void*) { LocMsgPool::free(block); }
+        inline static void operator delete(void* block) { LocMsgPool::free(block); }
+    };
+
+    MsgQueue* mQ;
+    LocMsgPool* mPool;
+    std::shared_ptr<MTRunnable> mRunnable;
     LocThread mThread;
 public:
     ~MsgTask() = default;
+    // queue backed by msg_q, unbounded, one lock and one node allocation
+    // per msg
     MsgTask(const char* threadName = NULL);
-    void sendMsg(const LocMsg* msg) const;
+    // queue backed by a bounded lock-free MPSC ring of ringSize slots
+    // (rounded up to a power of 2). ringSize 0 falls back to msg_q.
+    MsgTask(const char* threadName, uint32_t ringSize,
+            MsgTaskOverflowPolicy overflowPolicy = MSG_TASK_OVERFLOW_SPILL,
+            MsgTaskWakeup wakeup = MSG_TASK_WAKEUP_THREAD);
+    // eventfd of a MSG_TASK_WAKEUP_EVENTFD MsgTask, readable while msgs are
+    // queued; -1 for a MsgTask with a thread of its own
+    int getEventFd() const;
+    // MSG_TASK_WAKEUP_EVENTFD only: runs up to maxCount queued msgs without
+    // blocking and returns how many. Must only be called from one thread,
+    // which stands in for the MsgTask thread. If msgs are left the eventfd
+    // stays readable, so a level triggered poll comes back for them.
+    uint32_t processPending(uint32_t maxCount = 64) const;
+    void sendMsg(const LocMsg* msg,
+                 MsgTaskPriority priority = MSG_TASK_PRIORITY_NORMAL) const;
     void sendMsg(const std::function<void()> runnable) const;
+    // With maxBatchSize > 1 the thread takes everything pending, up to
+    // maxBatchSize msgs, off the queue in one go and runs them in order,
+    // instead of one queue round trip per msg. 0 or 1 turns it back off.
+    void setBatchDrain(uint32_t maxBatchSize) const;
+    void getStats(MsgTaskStats& stats) const;
+    // Dumps the counters of every live MsgTask in the process, along with
+    // queue wait and proc() time histograms per msg type.
+    static void dumpStats(std::function<void(std::stringstream&)> log);
+    // One entry per LocMsg size class, then one for the msgs from the heap
+    static void getMsgAllocStats(std::vector<LocMsgAllocStats>& stats);
+    // Same as above, without the std::function. A callable whose captures
+    // fit in a pool block is moved straight into it, so the common case
+    // of sendMsg([this, ...] { ... }) never touches the heap.
+    template <typename F, typename = typename std::enable_if<
+                  !std::is_convertible<F, const LocMsg*>::value>::type>
+    inline void sendMsg(F&& runnable) const {
+        typedef PooledRunMsg<typename std::decay<F>::type> RunMsg;
+        void* block = (sizeof(RunMsg) <= LocMsgPool::BLOCK_PAYLOAD_SIZE &&
+                       alignof(RunMsg) <= alignof(max_align_t)) ?
+                mPool->alloc() : nullptr;
+        if (nullptr != block) {
+            sendMsg(new (block) RunMsg(std::forward<F>(runnable)));
+        } else {
+            sendMsg(std::function<void()>(std::forward<F>(runnable)));
+        }
+    }
+};
+
+// Msgs bound for several MsgTasks, collected into one LocMsgBatch per
+// MsgTask, so that each MsgTask gets a single msg for all of them
+class LocMsgBatchSet {
+    struct Entry {
+        const MsgTask* mMsgTask;
+        LocMsgBatch* mBatch;
+        MsgTaskPriority mPriority;
+    };
+    std::vector<Entry> mEntries;
+public:
+    inline LocMsgBatchSet() {}
+    LocMsgBatchSet(const LocMsgBatchSet&) = delete;
+    LocMsgBatchSet& operator=(const LocMsgBatchSet&) = delete;
+    inline ~LocMsgBatchSet() {
+        for (auto& entry : mEntries) {
+            delete entry.mBatch;
+        }
+    }
+    // a batch goes at the highest priority of the msgs in it
+    inline void add(const MsgTask* msgTask, const LocMsg* msg, MsgTaskPriority priority) {
+        Entry* entry = nullptr;
+        for (auto& e : mEntries) {
+            if (e.mMsgTask == msgTask) {
+                entry = &e;
+                break;
+            }
+        }
+        if (nullptr == entry) {
+            mEntries.push_back({msgTask, new LocMsgBatch(), priority});
+            entry = &mEntries.back();
+        } else if (priority > entry->mPriority) {
+            entry->mPriority = priority;
+        }
+        entry->mBatch->mMsgs.push_back(msg);
+    }
+    inline void send() {
+        for (auto& entry : mEntries) {
+            entry.mMsgTask->sendMsg(entry.mBatch, entry.mPriority);
+        }
+        mEntries.clear();
+    }
 };
 
 } //
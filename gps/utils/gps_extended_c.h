@@ -30,6 +30,7 @@
 #define GPS_EXTENDED_C_H
 
 #include <ctype.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -888,6 +889,34 @@ typedef struct {
     enum loc_sess_status sessionStatus;
 } EngineLocationInfo;
 
+/* Copies a GpsLocationExtended but for the measUsageInfo entries past
+   numOfMeasReceived, which nothing reads. Those are 4 KB of the 4.7 KB of
+   the struct, so a copy on the position report path touches a few cache
+   lines instead of all of it. The struct is filled in as is by the LocApi
+   backends, hence the same layout and a lighter copy rather than a
+   compact form of it. */
+static inline void loc_copy_location_extended(GpsLocationExtended* dst,
+                                              const GpsLocationExtended* src)
+{
+    if (dst != src) {
+        size_t used = (src->numOfMeasReceived < GNSS_SV_MAX) ?
+                src->numOfMeasReceived : GNSS_SV_MAX;
+        size_t head = offsetof(GpsLocationExtended, measUsageInfo) +
+                used * sizeof(GpsMeasUsageInfo);
+        size_t tail = offsetof(GpsLocationExtended, leapSeconds);
+        memcpy(dst, src, head);
+        memcpy((char*)dst + tail, (const char*)src + tail, sizeof(GpsLocationExtended) - tail);
+    }
+}
+
+static inline void loc_copy_engine_location_info(EngineLocationInfo* dst,
+                                                 const EngineLocationInfo* src)
+{
+    dst->location = src->location;
+    loc_copy_location_extended(&dst->locationExtended, &src->locationExtended);
+    dst->sessionStatus = src->sessionStatus;
+}
+
 // Nmea sentence types mask
 typedef uint32_t NmeaSentenceTypesMask;
 #define LOC_NMEA_MASK_GGA_V02   ((NmeaSentenceTypesMask)0x00000001) /**<  Enable GGA type  */
@@ -2386,7 +2415,7 @@ typedef void (*AgnssStatusIpV6Cb)(AGnssExtStatusIpV6 status);
 /*
 * Callback with Antenna information.
 */
-typedef void(*antennaInfoCb)(std::vector<GnssAntennaInformation> gnssAntennaInformations);
+typedef void(*antennaInfoCb)(const std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
 /* Constructs for interaction with loc_net_iface library */
 typedef void (*LocAgpsOpenResultCb)(bool isSuccess, AGpsExtType agpsType, const char* apn,
@@ -0,0 +1,350 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Micro benchmarks of the gps-utils primitives the location stack is built
+ * on, as a baseline for their performance work and a guard against
+ * regressions. The files they need are made under BENCH_DIR. e.g.
+ *     gps_utils_benchmarks --benchmark_filter=MsgTask
+ */
+
+#define LOG_TAG "LocSvc_utils_benchmarks"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <loc_pla.h>
+#include <loc_cfg.h>
+#include <loc_nmea.h>
+#include <msg_q.h>
+#include <MsgTask.h>
+#include <LocIpc.h>
+#include <LocTimer.h>
+#include <LocHeap.h>
+#include <SkipList.h>
+#include <LogBuffer.h>
+#include <log_util.h>
+
+using namespace loc_util;
+
+#define BENCH_DIR "/data/local/tmp/"
+
+// msgs per timed round, so that a round is not just the wait for its end
+static const int kMsgsPerRound = 1000;
+
+struct BenchCountMsg : public LocMsg {
+    std::atomic<uint64_t>& mCount;
+    inline BenchCountMsg(std::atomic<uint64_t>& count) : LocMsg(), mCount(count) {}
+    inline virtual void proc() const { mCount.fetch_add(1, std::memory_order_relaxed); }
+};
+
+// Waits on the caller's side until a signal() from another thread
+class BenchLatch {
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    uint64_t mCount = 0;
+public:
+    inline void signal() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCount++;
+        mCond.notify_one();
+    }
+    inline void waitFor(uint64_t count) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCond.wait(lock, [this, count] { return mCount >= count; });
+    }
+};
+
+// MsgTask post and dispatch throughput; ring size 0 is the msg_q backend
+static void BM_MsgTaskPostDispatch(benchmark::State& state) {
+    MsgTask msgTask("BenchMsgTask", (uint32_t)state.range(0));
+    std::atomic<uint64_t> count(0);
+    BenchLatch latch;
+    uint64_t rounds = 0;
+
+    for (auto _ : state) {
+        for (int i = 0; i < kMsgsPerRound; i++) {
+            msgTask.sendMsg(new BenchCountMsg(count));
+        }
+        msgTask.sendMsg([&latch] { latch.signal(); });
+        latch.waitFor(++rounds);
+    }
+    state.SetItemsProcessed(state.iterations() * kMsgsPerRound);
+}
+BENCHMARK(BM_MsgTaskPostDispatch)->Arg(0)->Arg(1024)->UseRealTime();
+
+// msg_q with producers threads sending to one consumer
+static void BM_MsgQContention(benchmark::State& state) {
+    static int token;
+    const int producers = (int)state.range(0);
+    void* msgQ = nullptr;
+    msg_q_init(&msgQ);
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([msgQ] {
+                for (int i = 0; i < kMsgsPerRound; i++) {
+                    msg_q_snd(msgQ, &token, nullptr);
+                }
+            });
+        }
+        void* msg = nullptr;
+        for (int i = 0; i < producers * kMsgsPerRound; i++) {
+            msg_q_rcv(msgQ, &msg);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    msg_q_destroy(&msgQ);
+    state.SetItemsProcessed(state.iterations() * producers * kMsgsPerRound);
+}
+BENCHMARK(BM_MsgQContention)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+class BenchIpcListener : public ILocIpcListener {
+public:
+    BenchLatch mReady;
+    BenchLatch mReceived;
+    inline virtual void onListenerReady() override { mReady.signal(); }
+    inline virtual void onReceive(const char* /*data*/, uint32_t /*len*/,
+                                  const LocIpcRecver* /*recver*/) override {
+        mReceived.signal();
+    }
+};
+
+// LocIpc local socket, from send() to onReceive() on the listener thread
+static void BM_LocIpcLocalRoundTrip(benchmark::State& state) {
+    // a socket of its own per run, as the recver of the previous run may
+    // still be on its way out, and unlinks its socket when it goes
+    static int run = 0;
+    char sockName[64];
+    snprintf(sockName, sizeof(sockName), BENCH_DIR "gps_utils_benchmarks.%d.sock", run++);
+    std::vector<uint8_t> data(state.range(0), 0x5a);
+    shared_ptr<BenchIpcListener> listener = std::make_shared<BenchIpcListener>();
+    LocIpc ipc;
+    unique_ptr<LocIpcRecver> recver = LocIpc::getLocIpcLocalRecver(listener, sockName);
+    if (!ipc.startNonBlockingListening(recver)) {
+        state.SkipWithError("cannot listen on " BENCH_DIR);
+        return;
+    }
+    listener->mReady.waitFor(1);
+    shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcLocalSender(sockName);
+    uint64_t received = 0;
+
+    for (auto _ : state) {
+        if (!LocIpc::send(*sender, data.data(), data.size())) {
+            state.SkipWithError("send failed");
+            break;
+        }
+        listener->mReceived.waitFor(++received);
+    }
+    ipc.stopNonBlockingListening();
+    unlink(sockName);
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_LocIpcLocalRoundTrip)->RangeMultiplier(8)->Range(64, 64 * 1024)->UseRealTime();
+
+class BenchTimer : public LocTimer {
+public:
+    inline virtual void timeOutCallback() override {}
+};
+
+// LocTimer arm and disarm, with as many other timers armed
+static void BM_LocTimerStartStop(benchmark::State& state) {
+    std::vector<BenchTimer> others(state.range(0));
+    for (auto& timer : others) {
+        timer.start(3600 * 1000, false);
+    }
+    BenchTimer timer;
+
+    for (auto _ : state) {
+        timer.start(60 * 1000, false);
+        timer.stop();
+    }
+    for (auto& timer : others) {
+        timer.stop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LocTimerStartStop)->Arg(0)->Arg(64)->Arg(1024);
+
+class BenchRankable : public LocRankable {
+public:
+    uint32_t mRank = 0;
+    inline virtual int ranks(LocRankable& rankable) override {
+        uint32_t rank = static_cast<BenchRankable&>(rankable).mRank;
+        return (mRank < rank) ? 1 : ((mRank > rank) ? -1 : 0);
+    }
+};
+
+static std::vector<BenchRankable> benchRankables(size_t count) {
+    std::vector<BenchRankable> nodes(count);
+    uint32_t seed = 1;
+    for (auto& node : nodes) {
+        seed = seed * 1103515245 + 12345;
+        node.mRank = seed >> 8;
+    }
+    return nodes;
+}
+
+// push all, then pop all, of nodes in random rank order
+template <typename Heap>
+static void BM_LocHeapPushPop(benchmark::State& state) {
+    std::vector<BenchRankable> nodes = benchRankables(state.range(0));
+    Heap heap;
+
+    for (auto _ : state) {
+        for (auto& node : nodes) {
+            heap.push(node);
+        }
+        while (nullptr != heap.pop()) {}
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK_TEMPLATE(BM_LocHeapPushPop, LocHeap)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_LocHeapPushPop, LocDaryHeap)->Arg(16)->Arg(256)->Arg(4096);
+
+// SkipList as LogBuffer once used it, one level per log level
+static void BM_SkipListAppend(benchmark::State& state) {
+    SkipList<uint64_t> list(5);
+    uint64_t data = 0;
+
+    for (auto _ : state) {
+        list.append(data, (int)(data % 5));
+        if (++data % 1024 == 0) {
+            list.flush();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SkipListAppend);
+
+static void BM_LogBufferAppend(benchmark::State& state) {
+    LogBuffer* logBuffer = LogBuffer::getInstance();
+    std::string line(state.range(0), 'x');
+    uint64_t timestamp = 0;
+
+    for (auto _ : state) {
+        logBuffer->append(line, 3, ++timestamp);
+    }
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+BENCHMARK(BM_LogBufferAppend)->Arg(64)->Arg(256)->Threads(1)->Threads(4);
+
+// what a LOC_LOGD that is off costs on a report path, arguments included;
+// nothing at all where LOC_LOG_MAX_LEVEL compiles it out
+static void BM_LocLogDisabled(benchmark::State& state) {
+    loc_logger_init(2, 0);
+    log_tag_level_map_init();
+    loc_log_level_reset();
+    double values[10] = {};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(values);
+        LOC_LOGD("%f %f %f %f %f %f %f %f %f %f", values[0], values[1], values[2], values[3],
+                 values[4], values[5], values[6], values[7], values[8], values[9]);
+    }
+}
+BENCHMARK(BM_LocLogDisabled);
+
+// a gps.conf sized file, of which the table picks a quarter of the keys
+static void BM_LocReadConf(benchmark::State& state) {
+    const char* confName = BENCH_DIR "gps_utils_benchmarks.conf";
+    const int keyCount = 256;
+    FILE* file = fopen(confName, "w");
+    if (nullptr == file) {
+        state.SkipWithError("cannot write to " BENCH_DIR);
+        return;
+    }
+    for (int i = 0; i < keyCount; i++) {
+        fprintf(file, "##################################################\n"
+                "# KEY_%d is key number %d\n"
+                "##################################################\n"
+                "KEY_%d = %d\n\n", i, i, i, i);
+    }
+    fclose(file);
+
+    std::vector<std::string> names;
+    for (int i = 0; i < keyCount; i += 4) {
+        names.push_back("KEY_" + std::to_string(i));
+    }
+    std::vector<uint32_t> values(names.size());
+    std::vector<loc_param_s_type> table;
+    for (size_t i = 0; i < names.size(); i++) {
+        table.push_back({names[i].c_str(), &values[i], nullptr, 'n'});
+    }
+
+    for (auto _ : state) {
+        loc_read_conf_long(confName, table.data(), table.size(), LOC_MAX_PARAM_STRING);
+    }
+    unlink(confName);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LocReadConf);
+
+// GGA, RMC, GSA, VTG and GNS of one fix
+static void BM_LocNmeaGeneratePos(benchmark::State& state) {
+    UlpLocation location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.gpsLocation.size = sizeof(location.gpsLocation);
+    location.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    location.gpsLocation.latitude = 32.8968;
+    location.gpsLocation.longitude = -117.2027;
+    location.gpsLocation.altitude = 120.5;
+    location.gpsLocation.speed = 12.3f;
+    location.gpsLocation.bearing = 271.4f;
+    location.gpsLocation.accuracy = 3.2f;
+    location.gpsLocation.timestamp = 1600000000000LL;
+    GpsLocationExtended locationExtended;
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    locationExtended.size = sizeof(locationExtended);
+    LocationSystemInfo systemInfo = {};
+    std::vector<std::string> sentences;
+    int indexOfGGA = -1;
+
+    for (auto _ : state) {
+        sentences.clear();
+        loc_nmea_generate_pos(location, locationExtended, systemInfo, 1, false,
+                              sentences, indexOfGGA, false);
+        benchmark::DoNotOptimize(sentences.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LocNmeaGeneratePos);
+
+BENCHMARK_MAIN();
@@ -43,10 +43,19 @@
 #include <loc_pla.h>
 #include <loc_target.h>
 #include <loc_misc_utils.h>
+#include <loc_timer.h>
 #ifdef USE_GLIB
 #include <glib.h>
 #endif
 #include "log_util.h"
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
 
 /*=============================================================================
  *
@@ -60,6 +69,8 @@ static uint32_t TIMESTAMP = 0;
 static uint32_t DATUM_TYPE = 0;
 static bool sVendorEnhanced = true;
 static uint32_t sLogBufferEnabled = 0;
+static uint32_t sLogBufferDeferredFormat = 0;
+static uint32_t sTimerWheelEnabled = 0;
 
 /* Parameter spec table */
 static const loc_param_s_type loc_param_table[] =
@@ -68,6 +79,8 @@ static const loc_param_s_type loc_param_table[] =
     {"TIMESTAMP",               &TIMESTAMP,          NULL, 'n'},
     {"DATUM_TYPE",              &DATUM_TYPE,         NULL, 'n'},
     {"LOG_BUFFER_ENABLED",      &sLogBufferEnabled,  NULL, 'n'},
+    {"LOG_BUFFER_DEFERRED_FORMAT", &sLogBufferDeferredFormat, NULL, 'n'},
+    {"TIMER_WHEEL_ENABLED",     &sTimerWheelEnabled, NULL, 'n'},
 };
 static const int loc_param_num = sizeof(loc_param_table) / sizeof(loc_param_s_type);
 
@@ -218,6 +231,23 @@ int loc_set_config_entry(const loc_param_s_type* config_entry,
     return ret;
 }
 
+/* Parse numerical value of a config item, from its string value */
+static void loc_parse_conf_value(loc_param_v_type* config_value)
+{
+    if ((strlen(config_value->param_str_value) >=3) &&
+        (config_value->param_str_value[0] == '0') &&
+        (tolower(config_value->param_str_value[1]) == 'x'))
+    {
+        /* hex */
+        config_value->param_int_value = (int) strtol(&config_value->param_str_value[2],
+                                                     (char**) NULL, 16);
+    }
+    else {
+        config_value->param_double_value = (double) atof(config_value->param_str_value); /* float */
+        config_value->param_int_value = atoi(config_value->param_str_value); /* dec */
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_fill_conf_item
 
@@ -263,19 +293,7 @@ int loc_fill_conf_item(char* input_buf,
                 loc_util_trim_space(config_value.param_name);
                 loc_util_trim_space(config_value.param_str_value);
 
-                /* Parse numerical value */
-                if ((strlen(config_value.param_str_value) >=3) &&
-                    (config_value.param_str_value[0] == '0') &&
-                    (tolower(config_value.param_str_value[1]) == 'x'))
-                {
-                    /* hex */
-                    config_value.param_int_value = (int) strtol(&config_value.param_str_value[2],
-                                                                (char**) NULL, 16);
-                }
-                else {
-                    config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
-                    config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
-                }
+                loc_parse_conf_value(&config_value);
 
                 for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
                 {
@@ -418,6 +436,430 @@ int loc_update_conf_long(const char* conf_data, int32_t length,
     return ret;
 }
 
+/* Snapshot of the parsed items of a config file. It is built once from the
+   text file, and written under LOC_PATH_CONF_CACHE_DIR, laid out so that the
+   next process to start maps it, instead of parsing the text file again, for
+   as long as the text file is not changed:
+       LocConfSnapshotHead
+       uint32_t buckets[bucketCount], index + 1 of the item, 0 if empty
+       LocConfSnapshotItem items[count]
+       '\0' terminated names and string values */
+#define LOC_CONF_SNAPSHOT_MAGIC   0x5346434c
+#define LOC_CONF_SNAPSHOT_VERSION 1
+
+struct LocConfSnapshotHead {
+    uint32_t magic;
+    uint32_t version;
+    /* identity of the text file the snapshot is of */
+    uint64_t srcIno;
+    int64_t srcSize;
+    int64_t srcMtimeSec;
+    int64_t srcMtimeNsec;
+    uint32_t count;
+    uint32_t bucketCount;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+struct LocConfSnapshotItem {
+    uint32_t nameOffset;
+    uint32_t strOffset;
+    int32_t intValue;
+    uint32_t reserved;
+    double doubleValue;
+};
+
+static inline uint32_t loc_conf_hash(const char* name)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ (uint8_t)*name) * 16777619u;
+    }
+    return hash;
+}
+
+static inline bool loc_conf_snapshot_is_of(const LocConfSnapshotHead& head,
+                                           const struct stat& st)
+{
+    return head.srcIno == (uint64_t)st.st_ino && head.srcSize == (int64_t)st.st_size &&
+            head.srcMtimeSec == (int64_t)st.st_mtim.tv_sec &&
+            head.srcMtimeNsec == (int64_t)st.st_mtim.tv_nsec;
+}
+
+/* Parsed items of a config file, keyed by parameter name, in a snapshot
+   that is either built in memory, or mapped from the cache. Each file is
+   parsed once per process, and again only if it changes on disk. */
+class LocConfIndex {
+    std::vector<uint64_t> mOwned;
+    void* mMap;
+    const char* mMem;
+    const LocConfSnapshotHead* mHead;
+    const uint32_t* mBuckets;
+    const LocConfSnapshotItem* mItems;
+    dev_t mDev;
+    void setUp(const char* mem) {
+        mMem = mem;
+        mHead = (const LocConfSnapshotHead*)mem;
+        mBuckets = (const uint32_t*)(mHead + 1);
+        mItems = (const LocConfSnapshotItem*)(mBuckets + mHead->bucketCount);
+    }
+public:
+    LocConfIndex(std::vector<uint64_t>& snapshot, dev_t dev) : mMap(NULL), mDev(dev) {
+        mOwned.swap(snapshot);
+        setUp((const char*)mOwned.data());
+    }
+    LocConfIndex(void* map, dev_t dev) : mMap(map), mDev(dev) {
+        setUp((const char*)map);
+    }
+    ~LocConfIndex() {
+        if (NULL != mMap) {
+            munmap(mMap, mHead->size);
+        }
+    }
+    inline bool isOf(const struct stat& st) const {
+        return mDev == st.st_dev && loc_conf_snapshot_is_of(*mHead, st);
+    }
+    inline const char* str(uint32_t offset) const { return mMem + offset; }
+    inline uint32_t count() const { return mHead->count; }
+    inline const LocConfSnapshotItem& item(uint32_t i) const { return mItems[i]; }
+    const LocConfSnapshotItem* find(const char* name) const {
+        uint32_t mask = mHead->bucketCount - 1;
+        for (uint32_t b = loc_conf_hash(name) & mask; 0 != mBuckets[b]; b = (b + 1) & mask) {
+            const LocConfSnapshotItem* item = &mItems[mBuckets[b] - 1];
+            if (0 == strcmp(str(item->nameOffset), name)) {
+                return item;
+            }
+        }
+        return NULL;
+    }
+};
+
+static std::mutex sConfIndexLock;
+static std::unordered_map<std::string, std::shared_ptr<const LocConfIndex>> sConfIndexes;
+
+/* Path of the cached snapshot of a config file, e.g. vendor_etc_gps.conf.snapshot */
+static std::string loc_conf_snapshot_path(const char* conf_file_name)
+{
+    std::string name(conf_file_name);
+    for (char& c : name) {
+        if ('/' == c) {
+            c = '_';
+        }
+    }
+    size_t first = name.find_first_not_of('_');
+    return LOC_PATH_CONF_CACHE_DIR + name.substr((std::string::npos == first) ? 0 : first) +
+            ".snapshot";
+}
+
+/*===========================================================================
+FUNCTION loc_map_conf_snapshot
+
+DESCRIPTION
+   Maps the cached snapshot of a config file, if there is one of the same
+   version of the file, and it is consistent.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+   st: stat of the configuration file
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   index over the mapped snapshot, or NULL
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static std::shared_ptr<const LocConfIndex> loc_map_conf_snapshot(const char* conf_file_name,
+                                                                 const struct stat& st)
+{
+    std::string path = loc_conf_snapshot_path(conf_file_name);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat snapshotSt;
+    void* map = MAP_FAILED;
+    if (0 == fstat(fd, &snapshotSt) && snapshotSt.st_size >= (off_t)sizeof(LocConfSnapshotHead)) {
+        map = mmap(NULL, snapshotSt.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (MAP_FAILED == map) {
+        return nullptr;
+    }
+
+    const LocConfSnapshotHead* head = (const LocConfSnapshotHead*)map;
+    const char* mem = (const char*)map;
+    size_t size = snapshotSt.st_size;
+    size_t tableEnd = sizeof(*head) + (uint64_t)head->bucketCount * sizeof(uint32_t) +
+            (uint64_t)head->count * sizeof(LocConfSnapshotItem);
+    bool valid = LOC_CONF_SNAPSHOT_MAGIC == head->magic &&
+            LOC_CONF_SNAPSHOT_VERSION == head->version && head->size == size &&
+            loc_conf_snapshot_is_of(*head, st) &&
+            head->bucketCount > head->count && 0 == (head->bucketCount & (head->bucketCount - 1)) &&
+            tableEnd < size && '\0' == mem[size - 1];
+    if (valid) {
+        // offsets past the tables of a '\0' terminated block are terminated strings
+        const uint32_t* buckets = (const uint32_t*)(head + 1);
+        const LocConfSnapshotItem* items =
+                (const LocConfSnapshotItem*)(buckets + head->bucketCount);
+        for (uint32_t i = 0; valid && i < head->bucketCount; i++) {
+            valid = buckets[i] <= head->count;
+        }
+        for (uint32_t i = 0; valid && i < head->count; i++) {
+            valid = items[i].nameOffset >= tableEnd && items[i].nameOffset < size &&
+                    items[i].strOffset >= tableEnd && items[i].strOffset < size;
+        }
+    }
+    if (!valid) {
+        LOC_LOGW("%s: ignoring stale snapshot %s", __FUNCTION__, path.c_str());
+        munmap(map, size);
+        return nullptr;
+    }
+    return std::make_shared<LocConfIndex>(map, st.st_dev);
+}
+
+/*===========================================================================
+FUNCTION loc_write_conf_snapshot
+
+DESCRIPTION
+   Writes the snapshot of a config file to the cache, for the next process
+   to read the file to map. Best effort, a process that can not write the
+   cache still has the snapshot in memory.
+
+PARAMETERS:
+   conf_file_name: configuration file the snapshot is of
+   snapshot: the snapshot
+   size: bytes of the snapshot
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static void loc_write_conf_snapshot(const char* conf_file_name, const void* snapshot,
+                                    size_t size)
+{
+    std::string path = loc_conf_snapshot_path(conf_file_name);
+    std::string tmpPath = path + "." + std::to_string(getpid());
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    bool written = (write(fd, snapshot, size) == (ssize_t)size);
+    close(fd);
+    // rename, so that a reader never maps a partial snapshot
+    if (!written || 0 != rename(tmpPath.c_str(), path.c_str())) {
+        unlink(tmpPath.c_str());
+    }
+}
+
+/*===========================================================================
+FUNCTION loc_parse_conf_snapshot
+
+DESCRIPTION
+   Parses a config file into a snapshot.
+
+PARAMETERS:
+   conf_fp: the opened configuration file
+   st: stat of the configuration file
+   snapshot: the snapshot built
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   size of the snapshot in bytes
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static size_t loc_parse_conf_snapshot(FILE* conf_fp, const struct stat& st,
+                                      std::vector<uint64_t>& snapshot)
+{
+    struct Parsed {
+        uint32_t hash;
+        LocConfSnapshotItem item;
+    };
+    std::vector<Parsed> parsed;
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> names;
+    char* line = NULL;
+    size_t lineSize = 0;
+    while (getline(&line, &lineSize, conf_fp) >= 0) {
+        char *lasts;
+        loc_param_v_type config_value;
+        memset(&config_value, 0, sizeof(config_value));
+        config_value.param_name = strtok_r(line, "=", &lasts);
+        if (NULL == config_value.param_name) {
+            continue;
+        }
+        config_value.param_str_value = strtok_r(NULL, "\0", &lasts);
+        if (NULL == config_value.param_str_value) {
+            continue;
+        }
+        loc_util_trim_space(config_value.param_name);
+        loc_util_trim_space(config_value.param_str_value);
+        // the first of repeated items is kept, as a scan of the file would fill it first
+        if ('#' == config_value.param_name[0] ||
+                !names.emplace(config_value.param_name, parsed.size()).second) {
+            continue;
+        }
+        loc_parse_conf_value(&config_value);
+        Parsed p = {};
+        p.hash = loc_conf_hash(config_value.param_name);
+        // offsets are made absolute below, once the size of the tables is known
+        p.item.nameOffset = strings.size();
+        strings.append(config_value.param_name).push_back('\0');
+        p.item.strOffset = strings.size();
+        strings.append(config_value.param_str_value).push_back('\0');
+        p.item.intValue = config_value.param_int_value;
+        p.item.doubleValue = config_value.param_double_value;
+        parsed.push_back(p);
+    }
+    free(line);
+    if (strings.empty()) {
+        strings.push_back('\0');
+    }
+
+    uint32_t bucketCount = 1;
+    while (bucketCount < parsed.size() * 2 + 1) {
+        bucketCount <<= 1;
+    }
+    size_t stringsOffset = sizeof(LocConfSnapshotHead) + bucketCount * sizeof(uint32_t) +
+            parsed.size() * sizeof(LocConfSnapshotItem);
+    size_t size = stringsOffset + strings.size();
+    snapshot.assign((size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    char* mem = (char*)snapshot.data();
+    LocConfSnapshotHead* head = (LocConfSnapshotHead*)mem;
+    head->magic = LOC_CONF_SNAPSHOT_MAGIC;
+    head->version = LOC_CONF_SNAPSHOT_VERSION;
+    head->srcIno = st.st_ino;
+    head->srcSize = st.st_size;
+    head->srcMtimeSec = st.st_mtim.tv_sec;
+    head->srcMtimeNsec = st.st_mtim.tv_nsec;
+    head->count = parsed.size();
+    head->bucketCount = bucketCount;
+    head->size = size;
+    uint32_t* buckets = (uint32_t*)(head + 1);
+    LocConfSnapshotItem* items = (LocConfSnapshotItem*)(buckets + bucketCount);
+    for (uint32_t i = 0; i < parsed.size(); i++) {
+        items[i] = parsed[i].item;
+        items[i].nameOffset += stringsOffset;
+        items[i].strOffset += stringsOffset;
+        uint32_t b = parsed[i].hash & (bucketCount - 1);
+        while (0 != buckets[b]) {
+            b = (b + 1) & (bucketCount - 1);
+        }
+        buckets[b] = i + 1;
+    }
+    memcpy(mem + stringsOffset, strings.data(), strings.size());
+    return size;
+}
+
+/*===========================================================================
+FUNCTION loc_get_conf_index
+
+DESCRIPTION
+   Gets the parsed items of a config file. The file is parsed only if it
+   has not been parsed before, in this process or into the cache, or has
+   changed since.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   index of the file, or NULL if the file can not be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static std::shared_ptr<const LocConfIndex> loc_get_conf_index(const char* conf_file_name)
+{
+    struct stat st;
+    if (stat(conf_file_name, &st) != 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(sConfIndexLock);
+    auto it = sConfIndexes.find(conf_file_name);
+    if (it != sConfIndexes.end() && it->second->isOf(st)) {
+        return it->second;
+    }
+
+    std::shared_ptr<const LocConfIndex> index = loc_map_conf_snapshot(conf_file_name, st);
+    if (nullptr == index) {
+        FILE* conf_fp = fopen(conf_file_name, "r");
+        if (NULL == conf_fp) {
+            return nullptr;
+        }
+        std::vector<uint64_t> snapshot;
+        size_t size = loc_parse_conf_snapshot(conf_fp, st, snapshot);
+        fclose(conf_fp);
+        loc_write_conf_snapshot(conf_file_name, snapshot.data(), size);
+        index = std::make_shared<LocConfIndex>(snapshot, st.st_dev);
+        LOC_LOGD("%s: parsed %s, %u items", __FUNCTION__, conf_file_name, index->count());
+    }
+    sConfIndexes[conf_file_name] = index;
+    return index;
+}
+
+/*===========================================================================
+FUNCTION loc_fill_conf_table
+
+DESCRIPTION
+   Sets the entries of the passed in configuration table from the parsed
+   items of a config file, looking each entry up by name.
+
+PARAMETERS:
+   index: parsed items of the config file
+   config_table: table definition of strings to places to store information
+   table_length: length of the configuration table
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Number of records in the config_table filled
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_fill_conf_table(const LocConfIndex& index, const loc_param_s_type* config_table,
+                               uint32_t table_length, uint16_t string_len)
+{
+    int ret = 0;
+    for (uint32_t i = 0; NULL != config_table && i < table_length; i++) {
+        if (NULL != config_table[i].param_set) {
+            *(config_table[i].param_set) = 0;
+        }
+        if (NULL == config_table[i].param_name) {
+            continue;
+        }
+        const LocConfSnapshotItem* item = index.find(config_table[i].param_name);
+        if (NULL == item) {
+            continue;
+        }
+        loc_param_v_type config_value;
+        config_value.param_name = (char*)config_table[i].param_name;
+        config_value.param_str_value = (char*)index.str(item->strOffset);
+        config_value.param_int_value = item->intValue;
+        config_value.param_double_value = item->doubleValue;
+        if (!loc_set_config_entry(&config_table[i], &config_value, string_len)) {
+            ret += 1;
+        }
+    }
+    return ret;
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf_long
 
@@ -443,23 +885,62 @@ SIDE EFFECTS
 void loc_read_conf_long(const char* conf_file_name, const loc_param_s_type* config_table,
                         uint32_t table_length, uint16_t string_len)
 {
-    FILE *conf_fp = NULL;
-
     log_buffer_init(false);
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
+    std::shared_ptr<const LocConfIndex> index = loc_get_conf_index(conf_file_name);
+    if (nullptr != index)
     {
         LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
         if(table_length && config_table) {
-            loc_read_conf_r_long(conf_fp, config_table, table_length, string_len);
-            rewind(conf_fp);
+            loc_fill_conf_table(*index, config_table, table_length, string_len);
         }
-        loc_read_conf_r_long(conf_fp, loc_param_table, loc_param_num, string_len);
-        fclose(conf_fp);
+        loc_fill_conf_table(*index, loc_param_table, loc_param_num, string_len);
     }
     /* Initialize logging mechanism with parsed data */
+    unsigned long lastDebugLevel = loc_logger.DEBUG_LEVEL;
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
+    if (lastDebugLevel != loc_logger.DEBUG_LEVEL) {
+        loc_log_level_reset();
+    }
     log_buffer_init(sLogBufferEnabled);
+    log_buffer_use_deferred_format(0 != sLogBufferDeferredFormat);
     log_tag_level_map_init();
+    loc_timer_use_wheel(0 != sTimerWheelEnabled);
+}
+
+/*===========================================================================
+FUNCTION loc_read_conf_items
+
+DESCRIPTION
+   Reads all the items of the specified configuration file, as the value
+   strings they have in the file, keyed by parameter name.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+   items: set to the items of the file
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if the file could be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+bool loc_read_conf_items(const char* conf_file_name,
+                         std::unordered_map<std::string, std::string>& items)
+{
+    items.clear();
+    std::shared_ptr<const LocConfIndex> index = loc_get_conf_index(conf_file_name);
+    if (nullptr == index) {
+        return false;
+    }
+    items.reserve(index->count());
+    for (uint32_t i = 0; i < index->count(); i++) {
+        const LocConfSnapshotItem& item = index->item(i);
+        items.emplace(index->str(item.nameOffset), index->str(item.strOffset));
+    }
+    return true;
 }
 
 /*=============================================================================
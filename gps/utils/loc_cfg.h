@@ -162,6 +162,12 @@ int loc_read_process_conf(const char* conf_file_name, uint32_t * process_count_p
 int loc_get_datum_type();
 #ifdef __cplusplus
 }
+
+#include <string>
+#include <unordered_map>
+
+bool loc_read_conf_items(const char* conf_file_name,
+                         std::unordered_map<std::string, std::string>& items);
 #endif
 
 #endif /* LOC_CFG_H */
@@ -31,6 +31,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include "log_util.h"
@@ -43,6 +44,7 @@
 #include <algorithm>
 #include <string>
 #include <cctype>
+#include <mutex>
 #define  BUFFER_SIZE  120
 #define  LOG_TAG_LEVEL_CONF_FILE_PATH "/data/vendor/location/gps.prop"
 
@@ -67,6 +69,10 @@ loc_logger_s_type loc_logger;
 /* tag base logging control map*/
 static std::unordered_map<std::string, uint8_t> tag_level_map;
 static bool tag_map_inited = false;
+/* the level caches of the source files that have logged, see
+   loc_log_level_resolve() */
+static std::mutex level_cache_lock;
+static loc_log_level_cache* level_caches = NULL;
 
 /* returns the least signification bit that is set in the mask
    Param
@@ -229,6 +235,30 @@ void log_buffer_insert(char *str, unsigned long buf_size, int level)
     loc_util::LogBuffer::getInstance()->append(ss, level, elapsedTime);
 }
 
+/*===========================================================================
+
+FUNCTION log_buffer_insert_deferred
+
+DESCRIPTION
+   Insert a log sentence with specific level to the log buffer, without
+   formatting it. The format, which must be a string literal, and the raw
+   arguments are kept, and formatted only when the log buffer is dumped.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void log_buffer_insert_deferred(int level, const char* tag, const char* format, ...)
+{
+    timespec tv;
+    clock_gettime(CLOCK_BOOTTIME, &tv);
+    uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
+    va_list args;
+    va_start(args, format);
+    loc_util::LogBuffer::getInstance()->appendDeferred(level, elapsedTime, tag, format, args);
+    va_end(args);
+}
+
 void log_tag_level_map_init()
 {
     if (tag_map_inited) {
@@ -280,3 +310,34 @@ int get_tag_log_level(const char* tag)
     }
     return log_level;
 }
+
+/* Slow path of IF_LOC_LOG, on the first log of a source file or after a
+   reset; returns the level to use and caches it. Logs stay off and are
+   looked up again until the levels have been read. */
+int loc_log_level_resolve(loc_log_level_cache* cache, const char* tag)
+{
+    if (!tag_map_inited) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(level_cache_lock);
+    int level = get_tag_log_level(tag);
+    if (level > 5) {
+        level = 0;
+    }
+    if (!cache->registered) {
+        cache->registered = 1;
+        cache->next = level_caches;
+        level_caches = cache;
+    }
+    __atomic_store_n(&cache->level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+/* Makes every source file look its level up again on its next log */
+void loc_log_level_reset()
+{
+    std::lock_guard<std::mutex> guard(level_cache_lock);
+    for (loc_log_level_cache* cache = level_caches; NULL != cache; cache = cache->next) {
+        __atomic_store_n(&cache->level, -1, __ATOMIC_RELAXED);
+    }
+}
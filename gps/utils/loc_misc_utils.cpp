@@ -38,11 +38,18 @@
 #include <ctype.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
 
 #ifndef MSEC_IN_ONE_SEC
 #define MSEC_IN_ONE_SEC 1000ULL
 #endif
 #define GET_MSEC_FROM_TS(ts) ((ts.tv_sec * MSEC_IN_ONE_SEC) + (ts.tv_nsec + 500000)/1000000)
+#ifndef NSEC_IN_ONE_SEC
+#define NSEC_IN_ONE_SEC 1000000000ULL
+#endif
 
 int loc_util_split_string(char *raw_string, char **split_strings_ptr,
                           int max_num_substrings, char delimiter)
@@ -169,47 +176,209 @@ uint64_t getQTimerTickCount()
     return qTimerCount;
 }
 
-uint64_t getQTimerDeltaNanos()
+static uint64_t getQTimerFreqCached()
+{
+    /* The QTimer frequency is fixed by the hardware; fall back to the nominal
+       19.2 MHz where it cannot be read */
+    static const uint64_t freq = getQTimerFreq() ? getQTimerFreq() : 19200000ULL;
+    return freq;
+}
+
+static uint64_t qTimerTicksToNanosAtFreq(uint64_t ticks)
+{
+    uint64_t freq = getQTimerFreqCached();
+    return (ticks / freq) * NSEC_IN_ONE_SEC + ((ticks % freq) * NSEC_IN_ONE_SEC) / freq;
+}
+
+/* The MHI time_us node is probed once and kept open; the delta it reports
+   only moves with the drift between the two SoCs, so it is re-read at most
+   once per QTIMER_DELTA_REFRESH_NSEC and served from the cache otherwise */
+#define QTIMER_DELTA_REFRESH_NSEC (10 * NSEC_IN_ONE_SEC)
+
+static int openQTimerDeltaNode()
+{
+    char devNode[] = "/sys/bus/mhi/devices/0306_00.01.00/time_us";
+    int mdm_fd = -1;
+    for (; devNode[27] < '3' && mdm_fd < 0; devNode[27]++) {
+        mdm_fd = ::open(devNode, O_RDONLY | O_CLOEXEC);
+        if (mdm_fd < 0) {
+            LOC_LOGd("MDM open file: %s error: %s", devNode, strerror(errno));
+        }
+    }
+    return mdm_fd;
+}
+
+static uint64_t readQTimerDeltaNanos(int mdm_fd)
 {
     char qtimer_val_string[100];
     char *temp;
     uint64_t local_qtimer = 0, remote_qtimer = 0;
-    int mdm_fd = -1, wlan_fd = -1, ret = 0;
     uint64_t delta = 0;
 
-    memset(qtimer_val_string, '\0', sizeof(qtimer_val_string));
+    ssize_t ret = pread(mdm_fd, qtimer_val_string, sizeof(qtimer_val_string)-1, 0);
+    if (ret < 0) {
+        LOC_LOGe("MDM read time_us file error: %s", strerror(errno));
+        return 0;
+    }
+    qtimer_val_string[ret] = '\0';
 
-    char devNode[] = "/sys/bus/mhi/devices/0306_00.01.00/time_us";
-    for (; devNode[27] < 3 && mdm_fd < 0; devNode[27]++) {
-        mdm_fd = ::open(devNode, O_RDONLY);
-        if (mdm_fd < 0) {
-            LOC_LOGe("MDM open file: %s error: %s", devNode, strerror(errno));
+    temp = strchr(qtimer_val_string, ':');
+    if (NULL == temp) {
+        return 0;
+    }
+    local_qtimer = atoll(temp + 2);
+
+    temp = strchr(temp + 1, ':');
+    if (NULL == temp) {
+        return 0;
+    }
+    remote_qtimer = atoll(temp + 2);
+
+    if (local_qtimer >= remote_qtimer) {
+        delta = (local_qtimer - remote_qtimer) * 1000;
+    }
+    LOC_LOGv("qtimer values in microseconds: local:%" PRIi64 " remote:%" PRIi64 ""
+             " delta in nanoseconds:%" PRIi64 "",
+             local_qtimer, remote_qtimer, delta);
+    return delta;
+}
+
+uint64_t getQTimerDeltaNanos()
+{
+    static const int mdm_fd = openQTimerDeltaNode();
+    static std::atomic<uint64_t> cachedDelta(0);
+    static std::atomic<uint64_t> cachedAtNanos(0);
+    static std::atomic_flag refreshing = ATOMIC_FLAG_INIT;
+
+    if (mdm_fd < 0) {
+        return 0;
+    }
+
+    uint64_t now = qTimerTicksToNanosAtFreq(getQTimerTickCount());
+    uint64_t last = cachedAtNanos.load(std::memory_order_acquire);
+    if ((0 == last || now - last >= QTIMER_DELTA_REFRESH_NSEC) &&
+            !refreshing.test_and_set(std::memory_order_acquire)) {
+        cachedDelta.store(readQTimerDeltaNanos(mdm_fd), std::memory_order_relaxed);
+        cachedAtNanos.store(now, std::memory_order_release);
+        refreshing.clear(std::memory_order_release);
+    }
+    return cachedDelta.load(std::memory_order_relaxed);
+}
+
+/* QTimer to CLOCK_BOOTTIME mapping. Both clocks are read back to back a few
+   times and the tightest bracket is kept as the anchor; the offset between
+   anchors gives the rate at which boottime drifts against the QTimer, which
+   is lightly filtered and applied between refreshes. The mapping is
+   published through a sequence counter, so readers never block and only
+   the thread that finds it stale pays for the clock_gettime calls. */
+#define BOOT_TIME_MAP_REFRESH_NSEC NSEC_IN_ONE_SEC
+#define BOOT_TIME_MAP_SAMPLES      3
+/* A change in offset larger than this is a clock step or a suspend, not
+   drift, and restarts the drift estimate */
+#define BOOT_TIME_MAP_MAX_SLEW_NSEC 1000000LL
+#define BOOT_TIME_MAP_MAX_DRIFT_PPB 500000LL
+
+static std::atomic<uint32_t> sBootTimeMapSeq(0);
+static std::atomic<uint64_t> sBootTimeMapAnchor(0);   /* QTimer nanos at the anchor */
+static std::atomic<int64_t>  sBootTimeMapOffset(0);   /* boottime - QTimer at the anchor */
+static std::atomic<int64_t>  sBootTimeMapDriftPpb(0);
+static std::atomic_flag      sBootTimeMapRefreshing = ATOMIC_FLAG_INIT;
+
+static bool sampleBootTimeMap(uint64_t& qtimerNanos, int64_t& offset)
+{
+    int64_t bestBracket = INT64_MAX;
+    for (int i = 0; i < BOOT_TIME_MAP_SAMPLES; i++) {
+        struct timespec before, after;
+        if (clock_gettime(CLOCK_BOOTTIME, &before) != 0) {
+            return false;
+        }
+        uint64_t ticks = getQTimerTickCount();
+        if (clock_gettime(CLOCK_BOOTTIME, &after) != 0) {
+            return false;
         }
+        int64_t beforeNanos = (int64_t)before.tv_sec * (int64_t)NSEC_IN_ONE_SEC + before.tv_nsec;
+        int64_t afterNanos = (int64_t)after.tv_sec * (int64_t)NSEC_IN_ONE_SEC + after.tv_nsec;
+        if (afterNanos - beforeNanos < bestBracket) {
+            bestBracket = afterNanos - beforeNanos;
+            qtimerNanos = qTimerTicksToNanosAtFreq(ticks);
+            offset = beforeNanos + bestBracket / 2 - (int64_t)qtimerNanos;
+        }
+    }
+    return true;
+}
+
+static void refreshBootTimeMap(uint64_t prevAnchor, int64_t prevOffset, int64_t prevDriftPpb)
+{
+    uint64_t anchor;
+    int64_t offset;
+    if (!sampleBootTimeMap(anchor, offset)) {
+        LOC_LOGe("clock_gettime(CLOCK_BOOTTIME) failed: %s", strerror(errno));
+        return;
     }
-    if (mdm_fd > 0) {
-        ret = read(mdm_fd, qtimer_val_string, sizeof(qtimer_val_string)-1);
-        ::close(mdm_fd);
-        if (ret < 0) {
-            LOC_LOGe("MDM read time_us file error: %s", strerror(errno));
-        } else {
-            temp = qtimer_val_string;
-            temp = strchr(temp, ':');
-            temp = temp + 2;
-            local_qtimer = atoll(temp);
-
-            temp = strchr(temp, ':');
-            temp = temp + 2;
-            remote_qtimer = atoll(temp);
-
-            if (local_qtimer >= remote_qtimer) {
-                delta = (local_qtimer - remote_qtimer) * 1000;
+
+    int64_t driftPpb = 0;
+    if (0 != prevAnchor && anchor > prevAnchor) {
+        int64_t slew = offset - prevOffset;
+        if (llabs(slew) < BOOT_TIME_MAP_MAX_SLEW_NSEC) {
+            int64_t span = (int64_t)(anchor - prevAnchor);
+            int64_t measuredPpb = (int64_t)((double)slew * 1e9 / (double)span);
+            if (measuredPpb > BOOT_TIME_MAP_MAX_DRIFT_PPB) {
+                measuredPpb = BOOT_TIME_MAP_MAX_DRIFT_PPB;
+            } else if (measuredPpb < -BOOT_TIME_MAP_MAX_DRIFT_PPB) {
+                measuredPpb = -BOOT_TIME_MAP_MAX_DRIFT_PPB;
             }
-            LOC_LOGv("qtimer values in microseconds: local:%" PRIi64 " remote:%" PRIi64 ""
-                     " delta in nanoseconds:%" PRIi64 "",
-                     local_qtimer, remote_qtimer, delta);
+            driftPpb = (0 == prevDriftPpb) ? measuredPpb : (3 * prevDriftPpb + measuredPpb) / 4;
         }
     }
-    return delta;
+
+    uint32_t seq = sBootTimeMapSeq.load(std::memory_order_relaxed);
+    sBootTimeMapSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sBootTimeMapAnchor.store(anchor, std::memory_order_relaxed);
+    sBootTimeMapOffset.store(offset, std::memory_order_relaxed);
+    sBootTimeMapDriftPpb.store(driftPpb, std::memory_order_relaxed);
+    sBootTimeMapSeq.store(seq + 2, std::memory_order_release);
+}
+
+static uint64_t readBootTimeMap(int64_t& offset, int64_t& driftPpb)
+{
+    uint64_t anchor;
+    uint32_t seq;
+    do {
+        seq = sBootTimeMapSeq.load(std::memory_order_acquire);
+        anchor = sBootTimeMapAnchor.load(std::memory_order_relaxed);
+        offset = sBootTimeMapOffset.load(std::memory_order_relaxed);
+        driftPpb = sBootTimeMapDriftPpb.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != sBootTimeMapSeq.load(std::memory_order_relaxed));
+    return anchor;
+}
+
+int64_t getBootTimeNanosFromQTimer(uint64_t qtimerTicks)
+{
+    int64_t offset, driftPpb;
+    uint64_t anchor = readBootTimeMap(offset, driftPpb);
+
+    uint64_t nowNanos = qTimerTicksToNanosAtFreq(getQTimerTickCount());
+    if ((0 == anchor || nowNanos - anchor >= BOOT_TIME_MAP_REFRESH_NSEC) &&
+            !sBootTimeMapRefreshing.test_and_set(std::memory_order_acquire)) {
+        refreshBootTimeMap(anchor, offset, driftPpb);
+        sBootTimeMapRefreshing.clear(std::memory_order_release);
+        anchor = readBootTimeMap(offset, driftPpb);
+    }
+
+    int64_t qtimerNanos = (int64_t)qTimerTicksToNanosAtFreq(qtimerTicks);
+    if (0 == anchor) {
+        /* No mapping yet, either another thread is taking the very first
+           sample or sampling failed */
+        struct timespec ts;
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+        return (int64_t)ts.tv_sec * (int64_t)NSEC_IN_ONE_SEC + ts.tv_nsec -
+                ((int64_t)nowNanos - qtimerNanos);
+    }
+
+    int64_t sinceAnchor = qtimerNanos - (int64_t)anchor;
+    return qtimerNanos + offset + (int64_t)((double)sinceAnchor * driftPpb / 1e9);
 }
 
 uint64_t getQTimerFreq()
@@ -282,11 +451,84 @@ void Euler2Dcm(float euler[3], float dcm[3][3]) {
     dcm[2][2] = cr * cp;
 }
 
+// Used for convert position/velocity from GNSS antenna based to VRP based.
+// Only the heading is known for most fixes, the yaw-only DCM needs two of
+// the six trig calls of the full one.
+static void loc_vrp_dcm(const float rollPitchYaw[3], float dcm[3][3]) {
+    if (0.0f == rollPitchYaw[0] && 0.0f == rollPitchYaw[1]) {
+        float ch = cosf(rollPitchYaw[2]);
+        float sh = sinf(rollPitchYaw[2]);
+
+        dcm[0][0] = ch;
+        dcm[0][1] = -sh;
+        dcm[0][2] = 0.0f;
+        dcm[1][0] = sh;
+        dcm[1][1] = ch;
+        dcm[1][2] = 0.0f;
+        dcm[2][0] = 0.0f;
+        dcm[2][1] = 0.0f;
+        dcm[2][2] = 1.0f;
+    } else {
+        Euler2Dcm((float*)rollPitchYaw, dcm);
+    }
+}
+
+void loc_vrp_transform_init(LocVrpTransform* transform, const float leverArm[3]) {
+    memcpy(transform->leverArm, leverArm, sizeof(transform->leverArm));
+    Matrix_Skew(transform->leverArm, transform->skewLeverArm);
+}
+
 // Used for convert position from GSNS based to VRP based
-// The converted position will be stored in the llaInfo parameter.
+// The converted position will be stored in the lla parameter.
 #define A6DOF_WGS_A (6378137.0f)
 #define A6DOF_WGS_B (6335439.0f)
 #define A6DOF_WGS_E2 (0.00669437999014f)
+void loc_vrp_transform_lla(const LocVrpTransform* transform, double lla[][3],
+                           const float rollPitchYaw[][3], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float cnb[3][3];
+        loc_vrp_dcm(rollPitchYaw[i], cnb);
+
+        float sl = sin(lla[i][0]);
+        float cl = cos(lla[i][0]);
+        float sf = 1.0f / (1.0f - A6DOF_WGS_E2 * sl* sl);
+        float sfr = sqrtf(sf);
+
+        float rn = A6DOF_WGS_B * sf * sfr + lla[i][2];
+        float re = A6DOF_WGS_A * sfr + lla[i][2];
+
+        float deltaNEU[3];
+
+        // gps_pos_lla = imu_pos_lla + Cbn*la_b .* [1/geo.Rn; 1/(geo.Re*geo.cL); -1];
+        Matrix_MxV(cnb, (float*)transform->leverArm, deltaNEU);
+
+        // NED to lla conversion
+        lla[i][0] = lla[i][0] + deltaNEU[0] / rn;
+        lla[i][1] = lla[i][1] + deltaNEU[1] / (re * cl);
+        lla[i][2] = lla[i][2] + deltaNEU[2];
+    }
+}
+
+// Used for convert velocity from GSNS based to VRP based
+// The converted velocity will be stored in the enuVelocity parameter.
+void loc_vrp_transform_velocity(const LocVrpTransform* transform, float enuVelocity[][3],
+                                const float rollPitchYaw[][3],
+                                const float rollPitchYawRate[][3], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float cnb[3][3];
+        loc_vrp_dcm(rollPitchYaw[i], cnb);
+
+        float tmp[3];
+        float deltaEnuVelocity[3];
+        Matrix_MxV((float (*)[3])transform->skewLeverArm, (float*)rollPitchYawRate[i], tmp);
+        Matrix_MxV(cnb, tmp, deltaEnuVelocity);
+
+        enuVelocity[i][0] = enuVelocity[i][0] - deltaEnuVelocity[0];
+        enuVelocity[i][1] = enuVelocity[i][1] - deltaEnuVelocity[1];
+        enuVelocity[i][2] = enuVelocity[i][2] - deltaEnuVelocity[2];
+    }
+}
+
 void loc_convert_lla_gnss_to_vrp(double lla[3], float rollPitchYaw[3],
                                  float leverArm[3]) {
     LOC_LOGv("lla: %f, %f, %f, lever arm: %f %f %f, "
@@ -295,31 +537,12 @@ void loc_convert_lla_gnss_to_vrp(double lla[3], float rollPitchYaw[3],
              leverArm[0], leverArm[1], leverArm[2],
              rollPitchYaw[0], rollPitchYaw[1], rollPitchYaw[2]);
 
-    float cnb[3][3];
-    memset(cnb, 0, sizeof(cnb));
-    Euler2Dcm(rollPitchYaw, cnb);
-
-    float sl = sin(lla[0]);
-    float cl = cos(lla[0]);
-    float sf = 1.0f / (1.0f - A6DOF_WGS_E2 * sl* sl);
-    float sfr = sqrtf(sf);
-
-    float rn = A6DOF_WGS_B * sf * sfr + lla[2];
-    float re = A6DOF_WGS_A * sfr + lla[2];
-
-    float deltaNEU[3];
-
-    // gps_pos_lla = imu_pos_lla + Cbn*la_b .* [1/geo.Rn; 1/(geo.Re*geo.cL); -1];
-    Matrix_MxV(cnb, leverArm, deltaNEU);
-
-    // NED to lla conversion
-    lla[0] = lla[0] + deltaNEU[0] / rn;
-    lla[1] = lla[1] + deltaNEU[1] / (re * cl);
-    lla[2] = lla[2] + deltaNEU[2];
+    LocVrpTransform transform;
+    loc_vrp_transform_init(&transform, leverArm);
+    loc_vrp_transform_lla(&transform, (double (*)[3])lla,
+                          (const float (*)[3])rollPitchYaw, 1);
 }
 
-// Used for convert velocity from GSNS based to VRP based
-// The converted velocity will be stored in the enuVelocity parameter.
 void loc_convert_velocity_gnss_to_vrp(float enuVelocity[3], float rollPitchYaw[3],
                                       float rollPitchYawRate[3], float leverArm[3]) {
 
@@ -330,22 +553,9 @@ void loc_convert_velocity_gnss_to_vrp(float enuVelocity[3], float rollPitchYaw[3
              rollPitchYaw[0], rollPitchYaw[1], rollPitchYaw[2],
              rollPitchYawRate[0], rollPitchYawRate[1], rollPitchYawRate[2]);
 
-    float cnb[3][3];
-    memset(cnb, 0, sizeof(cnb));
-    Euler2Dcm(rollPitchYaw, cnb);
-
-    float skewLA[3][3];
-    memset(skewLA, 0, sizeof(skewLA));
-    Matrix_Skew(leverArm, skewLA);
-
-    float tmp[3];
-    float deltaEnuVelocity[3];
-    memset(tmp, 0, sizeof(tmp));
-    memset(deltaEnuVelocity, 0, sizeof(deltaEnuVelocity));
-    Matrix_MxV(skewLA, rollPitchYawRate, tmp);
-    Matrix_MxV(cnb, tmp, deltaEnuVelocity);
-
-    enuVelocity[0] = enuVelocity[0] - deltaEnuVelocity[0];
-    enuVelocity[1] = enuVelocity[1] - deltaEnuVelocity[1];
-    enuVelocity[2] = enuVelocity[2] - deltaEnuVelocity[2];
+    LocVrpTransform transform;
+    loc_vrp_transform_init(&transform, leverArm);
+    loc_vrp_transform_velocity(&transform, (float (*)[3])enuVelocity,
+                               (const float (*)[3])rollPitchYaw,
+                               (const float (*)[3])rollPitchYawRate, 1);
 }
@@ -148,7 +148,8 @@ FUNCTION getQTimerDeltaNanos
 
 DESCRIPTION
 This function is used to read the the difference in nanoseconds between
-Qtimer on AP side and Qtimer on MP side for dual-SoC architectures such as Kona
+Qtimer on AP side and Qtimer on MP side for dual-SoC architectures such as Kona.
+The value is cached and re-read from the MHI node at most every 10 seconds.
 
 DEPENDENCIES
 N/A
@@ -161,6 +162,25 @@ N/A
 ===========================================================================*/
 uint64_t getQTimerDeltaNanos();
 
+/*===========================================================================
+FUNCTION getBootTimeNanosFromQTimer
+
+DESCRIPTION
+   This function converts a QTimer tick count into CLOCK_BOOTTIME nanoseconds.
+   The QTimer to boottime mapping is sampled at most once a second and
+   corrected for drift in between, so most calls only read the QTimer.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+    int64_t boot time in nanoseconds at the given QTimer tick count
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+int64_t getBootTimeNanosFromQTimer(uint64_t qtimerTicks);
+
 /*===========================================================================
 FUNCTION getQTimerFreq
 
@@ -279,6 +299,72 @@ inline uint64_t qTimerTicksToNanos(double qTimer) {
     return (uint64_t((qTimer * double(10000ull)) / (double)192ull));
 }
 
+/* Lever arm dependent terms of the GNSS antenna to VRP conversion, computed
+   once when the lever arm is configured rather than for every fix */
+typedef struct {
+    float leverArm[3];
+    float skewLeverArm[3][3];
+} LocVrpTransform;
+
+/*===========================================================================
+FUNCTION loc_vrp_transform_init
+
+DESCRIPTION
+   This function precomputes the VRP transform for a GNSS antenna to vehicle
+   reference point lever arm, given as forward/sideways/up offsets in meters.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+    N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_vrp_transform_init(LocVrpTransform* transform, const float leverArm[3]);
+
+/*===========================================================================
+FUNCTION loc_vrp_transform_lla
+
+DESCRIPTION
+   This function converts count lat/long/altitude entries, lat/long in
+   radians, from GNSS antenna based to vehicle reference point based, each
+   with its own roll/pitch/yaw.
+
+DEPENDENCIES
+   transform must have been set up by loc_vrp_transform_init.
+
+RETURN VALUE
+    The converted lat/long/altitude will be stored in lla.
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_vrp_transform_lla(const LocVrpTransform* transform, double lla[][3],
+                           const float rollPitchYaw[][3], size_t count);
+
+/*===========================================================================
+FUNCTION loc_vrp_transform_velocity
+
+DESCRIPTION
+   This function converts count east/north/up velocities from GNSS antenna
+   based to vehicle reference point based, each with its own roll/pitch/yaw
+   and roll/pitch/yaw rate.
+
+DEPENDENCIES
+   transform must have been set up by loc_vrp_transform_init.
+
+RETURN VALUE
+    The converted east/north/up velocity will be stored in enuVelocity.
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_vrp_transform_velocity(const LocVrpTransform* transform, float enuVelocity[][3],
+                                const float rollPitchYaw[][3],
+                                const float rollPitchYawRate[][3], size_t count);
+
 /*===========================================================================
 FUNCTION loc_convert_lla_gnss_to_vrp
 
@@ -34,6 +34,9 @@
 #include <log_util.h>
 #include <loc_pla.h>
 #include <loc_cfg.h>
+#include <algorithm>
+#include <LocConvUtils.h>
+#include <LocAtrace.h>
 
 #define GLONASS_SV_ID_OFFSET 64
 #define SBAS_SV_ID_OFFSET    (87)
@@ -152,6 +155,107 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
+/* One satellite of a GSV page, as it is printed */
+typedef struct {
+    bool hasSvId;
+    bool hasCN0;
+    int32_t svId;
+    int32_t elevation;
+    int32_t azimuth;
+    int32_t cN0;
+} loc_nmea_gsv_sv;
+
+typedef struct {
+    int count;
+    loc_nmea_gsv_sv svs[4];
+    std::string sentence;
+} loc_nmea_gsv_page;
+
+/* GSV pages of the last SV report for one constellation and signal */
+typedef struct {
+    int svCount;
+    std::vector<loc_nmea_gsv_page> pages;
+} loc_nmea_gsv_cache;
+
+/* constellation and signal of each GSV group, in the order they are reported */
+static const struct {
+    GnssSvType svType;
+    GnssSignalTypeMask signalType;
+} sGsvGroups[] = {
+    {GNSS_SV_TYPE_GPS,     GNSS_SIGNAL_GPS_L1CA},   // $GPGSV:L1CA
+    {GNSS_SV_TYPE_GPS,     GNSS_SIGNAL_GPS_L5},     // $GPGSV:L5
+    {GNSS_SV_TYPE_GPS,     GNSS_SIGNAL_GPS_L2},     // $GPGSV:L2
+    {GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G1}, // $GLGSV:G1
+    {GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G2}, // $GLGSV:G2
+    {GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E1}, // $GAGSV:E1
+    {GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5A},// $GAGSV:E5A
+    {GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5B},// $GAGSV:E5B
+    {GNSS_SV_TYPE_QZSS,    GNSS_SIGNAL_QZSS_L1CA},  // $GQGSV (QZSS):L1CA
+    {GNSS_SV_TYPE_QZSS,    GNSS_SIGNAL_QZSS_L5},    // $GQGSV (QZSS):L5
+    {GNSS_SV_TYPE_QZSS,    GNSS_SIGNAL_QZSS_L2},    // $GQGSV (QZSS):L2
+    {GNSS_SV_TYPE_BEIDOU,  GNSS_SIGNAL_BEIDOU_B1I}, // $GBGSV (BEIDOU:B1I)
+    {GNSS_SV_TYPE_BEIDOU,  GNSS_SIGNAL_BEIDOU_B1C}, // $GBGSV (BEIDOU:B1C)
+    {GNSS_SV_TYPE_BEIDOU,  GNSS_SIGNAL_BEIDOU_B2AI},// $GBGSV (BEIDOU:B2AI)
+    {GNSS_SV_TYPE_NAVIC,   GNSS_SIGNAL_NAVIC_L5},   // $GIGSV (NAVIC:L5)
+};
+#define LOC_NMEA_GSV_GROUP_COUNT (sizeof(sGsvGroups) / sizeof(sGsvGroups[0]))
+
+static inline bool loc_nmea_gsv_page_equals(const loc_nmea_gsv_page& a,
+                                            const loc_nmea_gsv_page& b)
+{
+    if (a.count != b.count) {
+        return false;
+    }
+    for (int i = 0; i < a.count; i++) {
+        if (a.svs[i].hasSvId != b.svs[i].hasSvId || a.svs[i].hasCN0 != b.svs[i].hasCN0 ||
+                a.svs[i].svId != b.svs[i].svId || a.svs[i].elevation != b.svs[i].elevation ||
+                a.svs[i].azimuth != b.svs[i].azimuth || a.svs[i].cN0 != b.svs[i].cN0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Helmert transform from WGS84 to a local datum, together with the constants
+   of the local ellipsoid, all derived once instead of on every fix */
+typedef struct {
+    double deltaX;
+    double deltaY;
+    double deltaZ;
+    double deltaScale;
+    double rotX;
+    double rotY;
+    double rotZ;
+    double ecefA;
+    double ecefASq;
+    double ecef1Mf;
+    double ecefE2;
+    double ecefE2A;
+} LocDatumTransform;
+
+static LocDatumTransform loc_make_datum_transform(const double (&datumConst)[9])
+{
+    LocDatumTransform transform;
+    double ecefA = datumConst[7];
+    double ecefB = datumConst[8];
+
+    transform.deltaX     = datumConst[0];
+    transform.deltaY     = datumConst[1];
+    transform.deltaZ     = datumConst[2];
+    transform.deltaScale = datumConst[3];
+    transform.rotX       = datumConst[4];
+    transform.rotY       = datumConst[5];
+    transform.rotZ       = datumConst[6];
+    transform.ecefA      = ecefA;
+    transform.ecefASq    = ecefA * ecefA;
+    transform.ecef1Mf    = 1.0 - (ecefA - ecefB) / ecefA;
+    transform.ecefE2     = 1.0 - (ecefB * ecefB) / (ecefA * ecefA);
+    transform.ecefE2A    = transform.ecefE2 * ecefA;
+    return transform;
+}
+
+static const LocDatumTransform sWgs84ToPz90 = loc_make_datum_transform(DatumConstFromWGS84);
+
 /*===========================================================================
 FUNCTION    convert_Lla_to_Ecef
 
@@ -168,21 +272,23 @@ SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void convert_Lla_to_Ecef(const LocLla& plla, LocEcef& pecef)
+static inline void convert_Lla_to_Ecef(const LocLla& plla, LocEcef& pecef)
 {
+    double sinLat = sin(plla.lat);
+    double cosLat = cos(plla.lat);
     double r;
 
-    r = MAJA / sqrt(1.0 - ESQR * sin(plla.lat) * sin(plla.lat));
-    pecef.X = (r + plla.alt) * cos(plla.lat) * cos(plla.lon);
-    pecef.Y = (r + plla.alt) * cos(plla.lat) * sin(plla.lon);
-    pecef.Z = (r * OMES + plla.alt) * sin(plla.lat);
+    r = MAJA / sqrt(1.0 - ESQR * sinLat * sinLat);
+    pecef.X = (r + plla.alt) * cosLat * cos(plla.lon);
+    pecef.Y = (r + plla.alt) * cosLat * sin(plla.lon);
+    pecef.Z = (r * OMES + plla.alt) * sinLat;
 }
 
 /*===========================================================================
-FUNCTION    convert_WGS84_to_PZ90
+FUNCTION    convert_WGS84_to_Datum
 
 DESCRIPTION
-   Convert datum from WGS84 to PZ90
+   Convert datum from WGS84 to the datum of transform
 
 DEPENDENCIES
    NONE
@@ -194,26 +300,22 @@ SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void convert_WGS84_to_PZ90(const LocEcef& pWGS84, LocEcef& pPZ90)
+static inline void convert_WGS84_to_Datum(const LocDatumTransform& transform,
+                                          const LocEcef& pWGS84, LocEcef& pLocal)
 {
-    double deltaX     = DatumConstFromWGS84[0];
-    double deltaY     = DatumConstFromWGS84[1];
-    double deltaZ     = DatumConstFromWGS84[2];
-    double deltaScale = DatumConstFromWGS84[3];
-    double rotX       = DatumConstFromWGS84[4];
-    double rotY       = DatumConstFromWGS84[5];
-    double rotZ       = DatumConstFromWGS84[6];
-
-    pPZ90.X = deltaX + deltaScale * (pWGS84.X + rotZ * pWGS84.Y - rotY * pWGS84.Z);
-    pPZ90.Y = deltaY + deltaScale * (pWGS84.Y - rotZ * pWGS84.X + rotX * pWGS84.Z);
-    pPZ90.Z = deltaZ + deltaScale * (pWGS84.Z + rotY * pWGS84.X - rotX * pWGS84.Y);
+    pLocal.X = transform.deltaX + transform.deltaScale *
+            (pWGS84.X + transform.rotZ * pWGS84.Y - transform.rotY * pWGS84.Z);
+    pLocal.Y = transform.deltaY + transform.deltaScale *
+            (pWGS84.Y - transform.rotZ * pWGS84.X + transform.rotX * pWGS84.Z);
+    pLocal.Z = transform.deltaZ + transform.deltaScale *
+            (pWGS84.Z + transform.rotY * pWGS84.X - transform.rotX * pWGS84.Y);
 }
 
 /*===========================================================================
 FUNCTION    convert_Ecef_to_Lla
 
 DESCRIPTION
-   Convert ECEF to LLA
+   Convert ECEF to LLA on the ellipsoid of transform
 
 DEPENDENCIES
    NONE
@@ -225,13 +327,10 @@ SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
+static inline void convert_Ecef_to_Lla(const LocDatumTransform& transform,
+                                       const LocEcef& pecef, LocLla& plla)
 {
     double p, r;
-    double EcefA = C_PZ90A;
-    double EcefB = C_PZ90B;
-    double Ecef1Mf;
-    double EcefE2;
     double Mu;
     double Smu;
     double Cmu;
@@ -246,10 +345,8 @@ static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
         plla.lon = 1.0;
         plla.alt = 1.0;
     }
-    Ecef1Mf = 1.0 - (EcefA - EcefB) / EcefA;
-    EcefE2 = 1.0 - (EcefB * EcefB) / (EcefA * EcefA);
     if (p > 1.0) {
-        Mu = atan2(pecef.Z * (Ecef1Mf + EcefE2 * EcefA / r), p);
+        Mu = atan2(pecef.Z * (transform.ecef1Mf + transform.ecefE2A / r), p);
     } else {
         if (pecef.Z > 0.0) {
             Mu = M_PI / 2.0;
@@ -259,11 +356,11 @@ static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
     }
     Smu = sin(Mu);
     Cmu = cos(Mu);
-    Phi = atan2(pecef.Z * Ecef1Mf + EcefE2 * EcefA * Smu * Smu * Smu,
-                Ecef1Mf * (p - EcefE2 * EcefA * Cmu * Cmu * Cmu));
+    Phi = atan2(pecef.Z * transform.ecef1Mf + transform.ecefE2A * Smu * Smu * Smu,
+                transform.ecef1Mf * (p - transform.ecefE2A * Cmu * Cmu * Cmu));
     Sphi = sin(Phi);
-    N = EcefA / sqrt(1.0 - EcefE2 * Sphi * Sphi);
-    plla.alt = p * cos(Phi) + pecef.Z * Sphi - EcefA * EcefA/N;
+    N = transform.ecefA / sqrt(1.0 - transform.ecefE2 * Sphi * Sphi);
+    plla.alt = p * cos(Phi) + pecef.Z * Sphi - transform.ecefASq / N;
     plla.lat = Phi;
     if ( p > 1.0) {
         plla.lon = atan2(pecef.Y, pecef.X);
@@ -272,6 +369,85 @@ static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
     }
 }
 
+/*===========================================================================
+FUNCTION    loc_convert_wgs84_to_pz90
+
+DESCRIPTION
+   Convert a batch of WGS84 positions to PZ90, lat / lon in degrees and
+   alt in meters. wgs84 and pz90 may be the same array.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_convert_wgs84_to_pz90(const LocLla* wgs84, LocLla* pz90, size_t count)
+{
+    if (nullptr == wgs84 || nullptr == pz90) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        LocLla lla = {wgs84[i].lat / 180.0 * M_PI, wgs84[i].lon / 180.0 * M_PI, wgs84[i].alt};
+        LocEcef ecefW84;
+        LocEcef ecefLocal;
+
+        convert_Lla_to_Ecef(lla, ecefW84);
+        convert_WGS84_to_Datum(sWgs84ToPz90, ecefW84, ecefLocal);
+        convert_Ecef_to_Lla(sWgs84ToPz90, ecefLocal, lla);
+        pz90[i].lat = lla.lat / M_PI * 180.0;
+        pz90[i].lon = lla.lon / M_PI * 180.0;
+        pz90[i].alt = lla.alt;
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_get_dual_datum_lla
+
+DESCRIPTION
+   Get a WGS84 position in both the datum positions are reported in (ref)
+   and the other datum (local), as DTM describes them. The last fix is kept
+   per thread, so every consumer of the same fix shares one transform.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_get_dual_datum_lla(const LocLla& wgs84, int datumType, LocDualDatumLla& dual)
+{
+    static thread_local LocLla sLastWgs84 = {NAN, NAN, NAN};
+    static thread_local LocLla sLastPz90;
+
+    if (wgs84.lat != sLastWgs84.lat || wgs84.lon != sLastWgs84.lon ||
+            wgs84.alt != sLastWgs84.alt) {
+        loc_convert_wgs84_to_pz90(&wgs84, &sLastPz90, 1);
+        sLastWgs84 = wgs84;
+    }
+    switch (datumType) {
+        case LOC_GNSS_DATUM_WGS84:
+            dual.ref = wgs84;
+            dual.local = sLastPz90;
+            break;
+        case LOC_GNSS_DATUM_PZ90:
+            dual.ref = sLastPz90;
+            dual.local = wgs84;
+            break;
+        default:
+            memset(&dual, 0, sizeof(dual));
+            break;
+    }
+}
+
 /*===========================================================================
 FUNCTION    convert_signalType_to_signalId
 
@@ -369,19 +545,11 @@ SIDE EFFECTS
 ===========================================================================*/
 static uint32_t get_sv_count_from_mask(uint64_t svMask, int totalSvCount)
 {
-    int index = 0;
-    uint32_t svCount = 0;
-
     if(totalSvCount > MAX_SV_COUNT_SUPPORTED_IN_ONE_CONSTELLATION) {
         LOC_LOGE("total SV count in this constellation %d exceeded limit %d",
                  totalSvCount, MAX_SV_COUNT_SUPPORTED_IN_ONE_CONSTELLATION);
     }
-    for(index = 0; index < totalSvCount; index++) {
-        if(svMask & 0x1)
-            svCount += 1;
-        svMask >>= 1;
-    }
-    return svCount;
+    return loc_util::countSvUsedInMask(svMask, totalSvCount);
 }
 
 /*===========================================================================
@@ -594,6 +762,215 @@ static int loc_nmea_put_checksum(char *pNmea, int maxSize, bool isTagBlock)
     return (length + checksumLength + 1);
 }
 
+/* Builds an NMEA sentence in place in a caller buffer, without snprintf
+   and without allocating. The checksum is XORed in as the characters are
+   written, so finish() does not scan the sentence again. Numbers are
+   written with the same digits snprintf gives for %0Nd, %X and %0W.Df;
+   once the buffer is full, everything after is dropped and finish()
+   fails. */
+class LocNmeaWriter {
+    char* mBuf;
+    int mSize;
+    int mLen;
+    uint8_t mChecksum;
+    bool mOverflow;
+
+    static constexpr uint64_t sPow10[] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+        100000000ULL, 1000000000ULL };
+
+    // keeps one byte for the '\0'
+    inline bool reserve(int n) {
+        if (mOverflow || mLen + n >= mSize) {
+            mOverflow = true;
+            return false;
+        }
+        return true;
+    }
+    inline void putDigits(uint64_t v, int minDigits) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + (v % 10);
+            v /= 10;
+        } while (v > 0);
+        while (n < minDigits && n < (int)sizeof(digits)) {
+            digits[n++] = '0';
+        }
+        if (reserve(n)) {
+            while (n > 0) {
+                char c = digits[--n];
+                mBuf[mLen++] = c;
+                mChecksum ^= c;
+            }
+        }
+    }
+
+public:
+    // start is the leading '$' of a sentence, or '\' of a tag block,
+    // which is not part of the checksum
+    inline LocNmeaWriter(char* buf, int size, char start = '$') :
+            mBuf(buf), mSize(size), mLen(0), mChecksum(0), mOverflow(false) {
+        if (reserve(1)) {
+            mBuf[mLen++] = start;
+        }
+    }
+
+    inline void put(char c) {
+        if (reserve(1)) {
+            mBuf[mLen++] = c;
+            mChecksum ^= c;
+        }
+    }
+    inline void put(const char* s, size_t len) {
+        if (reserve(len)) {
+            for (size_t i = 0; i < len; i++) {
+                mChecksum ^= s[i];
+            }
+            memcpy(mBuf + mLen, s, len);
+            mLen += len;
+        }
+    }
+    // string literals, with their length known at compile time
+    template <size_t N>
+    inline void put(const char (&s)[N]) { put(s, N - 1); }
+    inline void putStr(const char* s) { put(s, strlen(s)); }
+
+    // %0*d
+    inline void putInt(int64_t v, int minDigits = 1) {
+        if (v < 0) {
+            put('-');
+            putDigits(-(uint64_t)v, minDigits - 1);
+        } else {
+            putDigits(v, minDigits);
+        }
+    }
+    // %X
+    inline void putHex(uint32_t v) {
+        static const char hex[] = "0123456789ABCDEF";
+        char digits[8];
+        int n = 0;
+        do {
+            digits[n++] = hex[v & 0xF];
+            v >>= 4;
+        } while (v > 0);
+        while (n > 0) {
+            put(digits[--n]);
+        }
+    }
+    // %0<width>.<decimals>f
+    void putFixed(double v, int decimals, int width = 0) {
+        double scaled = fabs(v) * sPow10[decimals];
+        double frac = scaled - floor(scaled);
+        // snprintf rounds the exact binary value to nearest, ties to even.
+        // Away from a tie, the rounding error of the scaling can not change
+        // that, near one only snprintf can tell, and does it.
+        if (!(scaled < 1e12) || fabs(frac - 0.5) < 1e-3) {
+            char field[32];
+            int length = snprintf(field, sizeof(field), "%0*.*f", width, decimals, v);
+            if (length > 0 && length < (int)sizeof(field)) {
+                put(field, length);
+            } else {
+                mOverflow = true;
+            }
+            return;
+        }
+        uint64_t n = (uint64_t)(scaled + 0.5);
+        int intWidth = width - (decimals > 0 ? decimals + 1 : 0);
+        if (signbit(v)) {
+            put('-');
+            intWidth--;
+        }
+        putDigits(n / sPow10[decimals], intWidth);
+        if (decimals > 0) {
+            put('.');
+            putDigits(n % sPow10[decimals], decimals);
+        }
+    }
+
+    // appends *hh\r\n, or *hh\ to a tag block, and the '\0'. Returns the
+    // length of the sentence, or -1 if it did not fit
+    int finish(bool isTagBlock = false) {
+        static const char hex[] = "0123456789ABCDEF";
+        uint8_t checksum = mChecksum;
+        if (reserve(isTagBlock ? 4 : 5)) {
+            mBuf[mLen++] = '*';
+            mBuf[mLen++] = hex[checksum >> 4];
+            mBuf[mLen++] = hex[checksum & 0xF];
+            if (isTagBlock) {
+                mBuf[mLen++] = '\\';
+            } else {
+                mBuf[mLen++] = '\r';
+                mBuf[mLen++] = '\n';
+            }
+        }
+        if (mOverflow) {
+            if (mSize > 0) {
+                mBuf[0] = '\0';
+            }
+            return -1;
+        }
+        mBuf[mLen] = '\0';
+        return mLen;
+    }
+};
+
+constexpr uint64_t LocNmeaWriter::sPow10[];
+
+/* hhmmss.ss */
+static inline void loc_nmea_put_utc_time(LocNmeaWriter& writer, int hours, int minutes,
+                                         int seconds, int mSeconds)
+{
+    writer.putInt(hours, 2);
+    writer.putInt(minutes, 2);
+    writer.putInt(seconds, 2);
+    writer.put('.');
+    writer.putInt(mSeconds/10, 2);
+}
+
+/* ddmm.mmmmmm,a,dddmm.mmmmmm,a, of a position in degrees */
+static void loc_nmea_put_lat_long(LocNmeaWriter& writer, double latitude, double longitude)
+{
+    char latHemisphere;
+    char lonHemisphere;
+    double latMinutes;
+    double lonMinutes;
+
+    if (latitude > 0)
+    {
+        latHemisphere = 'N';
+    }
+    else
+    {
+        latHemisphere = 'S';
+        latitude *= -1.0;
+    }
+
+    if (longitude < 0)
+    {
+        lonHemisphere = 'W';
+        longitude *= -1.0;
+    }
+    else
+    {
+        lonHemisphere = 'E';
+    }
+
+    latMinutes = fmod(latitude * 60.0 , 60.0);
+    lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+    writer.putInt((uint8_t)floor(latitude), 2);
+    writer.putFixed(latMinutes, 6, 9);
+    writer.put(',');
+    writer.put(latHemisphere);
+    writer.put(',');
+    writer.putInt((uint8_t)floor(longitude), 3);
+    writer.putFixed(lonMinutes, 6, 9);
+    writer.put(',');
+    writer.put(lonHemisphere);
+    writer.put(',');
+}
+
 /*===========================================================================
 FUNCTION    loc_nmea_generate_GSA
 
@@ -620,7 +997,8 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
                               std::vector<std::string> &nmeaArraystr,
-                              bool isTagBlockGroupingEnabled)
+                              bool isTagBlockGroupingEnabled,
+                              bool isRequested)
 {
     if (!sentence || bufSize <= 0 || !sv_meta_p)
     {
@@ -657,8 +1035,9 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         mask = mask >> 1;
     }
 
-    if (svUsedCount == 0) {
-        return 0;
+    if (svUsedCount == 0 || !isRequested) {
+        // the count and talker are still needed for the other sentences
+        return svUsedCount;
     } else {
         sentenceNumber = 1;
         sentenceCount = svUsedCount / 12 + (svUsedCount % 12 != 0);
@@ -667,13 +1046,23 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
     while (sentenceNumber <= sentenceCount) {
         pMarker = sentence;
         lengthRemaining = bufSize;
+        lengthTagBlock = 0;
         if (svUsedCount > 12 && isTagBlockGroupingEnabled) {
-            lengthTagBlock = snprintf(pMarker, lengthRemaining, "\\g:%d-%d-%d", sentenceNumber,
-                     sentenceCount, code);
+            LocNmeaWriter tagBlock(pMarker, lengthRemaining, '\\');
+            tagBlock.put("g:");
+            tagBlock.putInt(sentenceNumber);
+            tagBlock.put('-');
+            tagBlock.putInt(sentenceCount);
+            tagBlock.put('-');
+            tagBlock.putInt(code);
             if (MAX_TAG_BLOCK_GROUP_CODE == code) {
                 code = 1;
             }
-            lengthTagBlock = loc_nmea_put_checksum(sentence, bufSize, true);
+            lengthTagBlock = tagBlock.finish(true);
+            if (lengthTagBlock < 0) {
+                LOC_LOGE("NMEA Error in string formatting");
+                return 0;
+            }
             pMarker += lengthTagBlock;
             lengthRemaining -= lengthTagBlock;
         }
@@ -694,52 +1083,44 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         // v.v : Vertical DOP
         // s : GNSS System Id
         // cc : Checksum value
-        length = snprintf(pMarker, lengthRemaining, "$%sGSA,A,%c,", talker, fixType);
-        if (length < 0 || length >= lengthRemaining) {
-            LOC_LOGE("NMEA Error in string formatting");
-            return 0;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        LocNmeaWriter writer(pMarker, lengthRemaining);
+        writer.putStr(talker);
+        writer.put("GSA,A,");
+        writer.put(fixType);
+        writer.put(',');
 
         // Add 12 satellite IDs
         for (uint8_t i = 0; i < 12; i++, svNumber++)
         {
             if (svNumber <= svUsedCount)
-                length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[svNumber - 1]);
-            else
-                length = snprintf(pMarker, lengthRemaining, ",");
-
-            if (length < 0 || length >= lengthRemaining) {
-                LOC_LOGE("NMEA Error in string formatting");
-                return 0;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+                writer.putInt(svUsedList[svNumber - 1], 2);
+            writer.put(',');
         }
 
         // Add the position/horizontal/vertical DOP values
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                    locationExtended.pdop,
-                    locationExtended.hdop,
-                    locationExtended.vdop);
+            writer.putFixed(locationExtended.pdop, 1);
+            writer.put(',');
+            writer.putFixed(locationExtended.hdop, 1);
+            writer.put(',');
+            writer.putFixed(locationExtended.vdop, 1);
+            writer.put(',');
         }
         else
         {   // no dop
-            length = snprintf(pMarker, lengthRemaining, ",,,");
+            writer.put(",,,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         // system id
-        length = snprintf(pMarker, lengthRemaining, "%d", sv_meta_p->systemId);
-        pMarker += length;
-        lengthRemaining -= length;
+        writer.putInt(sv_meta_p->systemId);
 
         /* Sentence is ready, add checksum and broadcast */
-        length = loc_nmea_put_checksum(sentence + lengthTagBlock, bufSize - lengthTagBlock, false);
+        length = writer.finish();
+        if (length < 0) {
+            LOC_LOGE("NMEA Error in string formatting");
+            return 0;
+        }
         nmeaArraystr.push_back(sentence);
         sentenceNumber++;
         if (!isTagBlockGroupingEnabled) {
@@ -761,6 +1142,8 @@ DESCRIPTION
    - $GPGSV: GPS Satellites in View
    - $GLGSV: GLONASS Satellites in View
    - $GAGSV: GALILEO Satellites in View
+   Pages that read the same as in the last report are taken from cache
+   instead of being formatted again.
 
 DEPENDENCIES
    NONE
@@ -772,24 +1155,40 @@ SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
+static void loc_nmea_generate_GSV(const loc_util::LocSvEpoch &svEpoch,
+                              const uint32_t* svSignalIds,
                               char* sentence,
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              loc_nmea_gsv_cache& cache,
+                              std::vector<std::string> &nmeaArraystr,
+                              NmeaSentenceTypesMask sentenceTypes)
 {
-    if (!sentence || bufSize <= 0)
+    if (!sentence || bufSize <= 0 || !sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid argument.");
         return;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    NmeaSentenceTypesMask gsvType = 0;
+    switch (sv_meta_p->systemId) {
+        case SYSTEM_ID_GPS:     gsvType = LOC_NMEA_MASK_GSV_V02;   break;
+        case SYSTEM_ID_GLONASS: gsvType = LOC_NMEA_MASK_GLGSV_V02; break;
+        case SYSTEM_ID_GALILEO: gsvType = LOC_NMEA_MASK_GAGSV_V02; break;
+        case SYSTEM_ID_BDS:     gsvType = LOC_NMEA_MASK_GBGSV_V02; break;
+        case SYSTEM_ID_QZSS:    gsvType = LOC_NMEA_MASK_GQGSV_V02; break;
+        case SYSTEM_ID_NAVIC:   gsvType = LOC_NMEA_MASK_GIGSV_V02; break;
+        default: break;
+    }
+    if (0 == (sentenceTypes & gsvType)) {
+        return;
+    }
+
     int sentenceCount = 0;
     int sentenceNumber = 1;
     size_t svNumber = 1;
+    size_t svTotal = 0;
+    const GnssSvNotification& svNotify = svEpoch.report();
 
     const char* talker = sv_meta_p->talker;
     uint32_t svIdOffset = sv_meta_p->svIdOffset;
@@ -803,112 +1202,103 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
     if ((1 << GNSS_SV_TYPE_GLONASS) & sv_meta_p->svTypeMask) {
         svIdOffset = 0;
     }
-    svNumber = 1;
-    sentenceNumber = 1;
     sentenceCount = svCount / 4 + (svCount % 4 != 0);
+    // pages of the last report are only valid for the same page count
+    if (cache.svCount != svCount) {
+        cache.pages.clear();
+    }
+    cache.svCount = svCount;
+    cache.pages.resize(sentenceCount);
+
+    // the entries of this signal, taken from the satellites of the constellations
+    // of the group rather than from a scan of the whole report
+    uint8_t svIndices[GNSS_SV_MAX];
+    for (uint32_t svType = 0; svType <= GNSS_SV_TYPE_NAVIC; svType++) {
+        if (0 == (sv_meta_p->svTypeMask & (1 << svType))) {
+            continue;
+        }
+        for (auto sat = svEpoch.begin((GnssSvType)svType);
+                sat != svEpoch.end((GnssSvType)svType); ++sat) {
+            for (uint32_t band = 0; band < sat->bandCount; band++) {
+                if (sv_meta_p->signalId == svSignalIds[sat->bands[band]]) {
+                    svIndices[svTotal++] = sat->bands[band];
+                }
+            }
+        }
+    }
 
     while (sentenceNumber <= sentenceCount)
     {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
+        loc_nmea_gsv_page page = {};
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        for (int i=0; (svNumber <= svNotify.count) && (i < 4);  svNumber++)
+        for (; (svNumber <= svTotal) && (page.count < 4);  svNumber++)
         {
-            GnssSignalTypeMask signalType = svNotify.gnssSvs[svNumber-1].gnssSignalTypeMask;
-            if (0 == signalType) {
-                // If no signal type in report, it means default L1,G1,E1,B1I
-                switch (svNotify.gnssSvs[svNumber - 1].type)
-                {
-                    case GNSS_SV_TYPE_GPS:
-                        signalType = GNSS_SIGNAL_GPS_L1CA;
-                        break;
-                    case GNSS_SV_TYPE_GLONASS:
-                        signalType = GNSS_SIGNAL_GLONASS_G1;
-                        break;
-                    case GNSS_SV_TYPE_GALILEO:
-                        signalType = GNSS_SIGNAL_GALILEO_E1;
-                        break;
-                    case GNSS_SV_TYPE_QZSS:
-                        signalType = GNSS_SIGNAL_QZSS_L1CA;
-                        break;
-                    case GNSS_SV_TYPE_BEIDOU:
-                        signalType = GNSS_SIGNAL_BEIDOU_B1I;
-                        break;
-                    case GNSS_SV_TYPE_SBAS:
-                        signalType = GNSS_SIGNAL_SBAS_L1;
-                        break;
-                    case GNSS_SV_TYPE_NAVIC:
-                        signalType = GNSS_SIGNAL_NAVIC_L5;
-                        break;
-                    default:
-                        LOC_LOGE("NMEA Error unknow constellation type: %d",
-                                svNotify.gnssSvs[svNumber - 1].type);
-                        continue;
-                }
-            }
-
-            if ((sv_meta_p->svTypeMask & (1 << svNotify.gnssSvs[svNumber - 1].type)) &&
-                    sv_meta_p->signalId == convert_signalType_to_signalId(signalType))
+            const GnssSv& gnssSv = svNotify.gnssSvs[svIndices[svNumber - 1]];
             {
-                if (GNSS_SV_TYPE_SBAS == svNotify.gnssSvs[svNumber - 1].type) {
+                loc_nmea_gsv_sv& sv = page.svs[page.count++];
+                if (GNSS_SV_TYPE_SBAS == gnssSv.type) {
                     svIdOffset = SBAS_SV_ID_OFFSET;
                 }
-                if (GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svNumber - 1].type &&
-                    GLO_SV_PRN_SLOT_UNKNOWN == svNotify.gnssSvs[svNumber - 1].svId) {
-                    length = snprintf(pMarker, lengthRemaining, ",,%02d,%03d,",
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
+                if (GNSS_SV_TYPE_GLONASS == gnssSv.type &&
+                    GLO_SV_PRN_SLOT_UNKNOWN == gnssSv.svId) {
+                    sv.hasSvId = false;
+                    sv.svId = 0;
                 } else {
-                    length = snprintf(pMarker, lengthRemaining, ",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-                }
-                if (length < 0 || length >= lengthRemaining)
-                {
-                    LOC_LOGE("NMEA Error in string formatting");
-                    return;
-                }
-                pMarker += length;
-                lengthRemaining -= length;
-
-                if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
-                {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
-
-                    if (length < 0 || length >= lengthRemaining)
-                    {
-                        LOC_LOGE("NMEA Error in string formatting");
-                        return;
-                    }
-                    pMarker += length;
-                    lengthRemaining -= length;
+                    sv.hasSvId = true;
+                    sv.svId = gnssSv.svId - svIdOffset;
                 }
-
-                i++;
+                sv.elevation = (int)(0.5 + gnssSv.elevation); //float to int
+                sv.azimuth = (int)(0.5 + gnssSv.azimuth); //float to int
+                sv.hasCN0 = (gnssSv.cN0Dbhz > 0);
+                sv.cN0 = sv.hasCN0 ? (int)(0.5 + gnssSv.cN0Dbhz) : 0; //float to int
             }
+        }
 
+        // the page reads the same as in the last report
+        loc_nmea_gsv_page& cached = cache.pages[sentenceNumber - 1];
+        if (!cached.sentence.empty() && loc_nmea_gsv_page_equals(cached, page)) {
+            nmeaArraystr.push_back(cached.sentence);
+            sentenceNumber++;
+            continue;
+        }
+
+        LocNmeaWriter writer(sentence, bufSize);
+        writer.putStr(talker);
+        writer.put("GSV,");
+        writer.putInt(sentenceCount);
+        writer.put(',');
+        writer.putInt(sentenceNumber);
+        writer.put(',');
+        writer.putInt(svCount, 2);
+
+        for (int i = 0; i < page.count; i++) {
+            const loc_nmea_gsv_sv& sv = page.svs[i];
+            writer.put(',');
+            if (sv.hasSvId) {
+                writer.putInt(sv.svId, 2);
+            }
+            writer.put(',');
+            writer.putInt(sv.elevation, 2);
+            writer.put(',');
+            writer.putInt(sv.azimuth, 3);
+            writer.put(',');
+            if (sv.hasCN0) {
+                writer.putInt(sv.cN0, 2);
+            }
         }
 
         // append signalId
-        length = snprintf(pMarker, lengthRemaining,",%X",sv_meta_p->signalId);
-        pMarker += length;
-        lengthRemaining -= length;
+        writer.put(',');
+        writer.putHex(sv_meta_p->signalId);
 
-        length = loc_nmea_put_checksum(sentence, bufSize, false);
-        nmeaArraystr.push_back(sentence);
+        if (writer.finish() < 0) {
+            LOC_LOGE("NMEA Error in string formatting");
+            cached.sentence.clear();
+            return;
+        }
+        page.sentence = sentence;
+        cached = std::move(page);
+        nmeaArraystr.push_back(cached.sentence);
         sentenceNumber++;
 
     }  //while
@@ -932,23 +1322,17 @@ SIDE EFFECTS
 ===========================================================================*/
 static void loc_nmea_generate_DTM(const LocLla &ref_lla,
                                   const LocLla &local_lla,
+                                  int datum_type,
                                   char *talker,
                                   char *sentence,
                                   int bufSize)
 {
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
-    int datum_type;
     char ref_datum[4] = {0};
     char local_datum[4] = {0};
     double lla_offset[3] = {0};
     char latHem, longHem;
     double latMins, longMins;
 
-
-
-    datum_type = loc_get_datum_type();
     switch (datum_type) {
         case LOC_GNSS_DATUM_WGS84:
             ref_datum[0] = 'W';
@@ -969,13 +1353,11 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         default:
             break;
     }
-    length = snprintf(pMarker , lengthRemaining , "$%sDTM,%s,," , talker, local_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    LocNmeaWriter writer(sentence, bufSize);
+    writer.putStr(talker);
+    writer.put("DTM,");
+    writer.putStr(local_datum);
+    writer.put(",,");
 
     lla_offset[0] = local_lla.lat - ref_lla.lat;
     lla_offset[1] = fmod(local_lla.lon - ref_lla.lon, 360.0);
@@ -999,24 +1381,23 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         longHem = 'E';
     }
     longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
-    if (length < 0 || length >= lengthRemaining) {
+    writer.putInt((uint8_t)floor(lla_offset[0]), 2);
+    writer.putFixed(latMins, 6, 9);
+    writer.put(',');
+    writer.put(latHem);
+    writer.put(',');
+    writer.putInt((uint8_t)floor(lla_offset[1]), 3);
+    writer.putFixed(longMins, 6, 9);
+    writer.put(',');
+    writer.put(longHem);
+    writer.put(',');
+    writer.putFixed(lla_offset[2], 3);
+    writer.put(',');
+    writer.putStr(ref_datum);
+
+    if (writer.finish() < 0) {
         LOC_LOGE("NMEA Error in string formatting");
-        return;
     }
-    pMarker += length;
-    lengthRemaining -= length;
-    length = snprintf(pMarker , lengthRemaining , "%s" , ref_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-
-    length = loc_nmea_put_checksum(sentence, bufSize, false);
 }
 
 /*===========================================================================
@@ -1333,9 +1714,11 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                bool custom_gga_fix_quality,
                                std::vector<std::string> &nmeaArraystr,
                                int& indexOfGGA,
-                               bool isTagBlockGroupingEnabled)
+                               bool isTagBlockGroupingEnabled,
+                               NmeaSentenceTypesMask sentenceTypes)
 {
     ENTRY_LOG();
+    LOC_ATRACE_SCOPE("loc_nmea_generate_pos");
 
     indexOfGGA = -1;
     LocGpsUtcTime utcPosTimestamp = 0;
@@ -1357,8 +1740,6 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     char sentence_RMC[NMEA_SENTENCE_MAX_LENGTH] = {0};
     char sentence_GNS[NMEA_SENTENCE_MAX_LENGTH] = {0};
     char sentence_GGA[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
     int length = 0;
     int utcYear = pTm->tm_year % 100; // 2 digit year
     int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
@@ -1368,12 +1749,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     int utcSeconds = pTm->tm_sec;
     int utcMSeconds = (location.gpsLocation.timestamp)%1000;
     int datum_type = loc_get_datum_type();
-    LocEcef ecef_w84;
-    LocEcef ecef_p90;
     LocLla  lla_w84;
-    LocLla  lla_p90;
-    LocLla  ref_lla;
-    LocLla  local_lla;
+    LocDualDatumLla dual_lla;
 
     if (inLsTransition) {
         // During leap second transition, we need to display the extra
@@ -1414,7 +1791,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        0 != (sentenceTypes & LOC_NMEA_GSA_MASK));
         if (count > 0)
         {
             svUsedCount += count;
@@ -1428,7 +1806,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        0 != (sentenceTypes & LOC_NMEA_GSA_MASK));
         if (count > 0)
         {
             svUsedCount += count;
@@ -1442,7 +1821,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        0 != (sentenceTypes & LOC_NMEA_GSA_MASK));
         if (count > 0)
         {
             svUsedCount += count;
@@ -1455,7 +1835,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        0 != (sentenceTypes & LOC_NMEA_GSA_MASK));
         if (count > 0)
         {
             svUsedCount += count;
@@ -1469,7 +1850,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        0 != (sentenceTypes & LOC_NMEA_GSA_MASK));
         if (count > 0)
         {
             svUsedCount += count;
@@ -1479,7 +1861,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         // if svUsedCount is 0, it means we do not generate any GSA sentence yet.
         // in this case, generate an empty GSA sentence
-        if (svUsedCount == 0) {
+        if (svUsedCount == 0 && (sentenceTypes & LOC_NMEA_GSA_MASK)) {
             strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
             length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
             nmeaArraystr.push_back(sentence);
@@ -1496,626 +1878,358 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
-        pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        if (sentenceTypes & LOC_NMEA_VTG_MASK) {
+            LocNmeaWriter vtg(sentence, sizeof(sentence));
+            vtg.putStr(talker);
+            vtg.put("VTG,");
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
+            {
+                float magTrack = location.gpsLocation.bearing;
+                if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
+                {
+                    magTrack = location.gpsLocation.bearing - locationExtended.magneticDeviation;
+                    if (magTrack < 0.0)
+                        magTrack += 360.0;
+                    else if (magTrack > 360.0)
+                        magTrack -= 360.0;
+                }
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
-        {
-            float magTrack = location.gpsLocation.bearing;
-            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
+                vtg.putFixed(location.gpsLocation.bearing, 1);
+                vtg.put(",T,");
+                vtg.putFixed(magTrack, 1);
+                vtg.put(",M,");
+            }
+            else
             {
-                magTrack = location.gpsLocation.bearing - locationExtended.magneticDeviation;
-                if (magTrack < 0.0)
-                    magTrack += 360.0;
-                else if (magTrack > 360.0)
-                    magTrack -= 360.0;
+                vtg.put(",T,,M,");
             }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
+            {
+                float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
+                float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
-        {
-            float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            float speedKmPerHour = location.gpsLocation.speed * 3.6;
+                vtg.putFixed(speedKnots, 1);
+                vtg.put(",N,");
+                vtg.putFixed(speedKmPerHour, 1);
+                vtg.put(",K,");
+            }
+            else
+            {
+                vtg.put(",N,,K,");
+            }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
-        }
+            vtg.put(vtgModeIndicator);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            if (vtg.finish() < 0)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            nmeaArraystr.push_back(sentence);
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
-
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        memset(&ecef_w84, 0, sizeof(ecef_w84));
-        memset(&ecef_p90, 0, sizeof(ecef_p90));
-        memset(&lla_w84, 0, sizeof(lla_w84));
-        memset(&lla_p90, 0, sizeof(lla_p90));
-        memset(&ref_lla, 0, sizeof(ref_lla));
-        memset(&local_lla, 0, sizeof(local_lla));
-        lla_w84.lat = location.gpsLocation.latitude / 180.0 * M_PI;
-        lla_w84.lon = location.gpsLocation.longitude / 180.0 * M_PI;
+        lla_w84.lat = location.gpsLocation.latitude;
+        lla_w84.lon = location.gpsLocation.longitude;
         lla_w84.alt = location.gpsLocation.altitude;
 
-        convert_Lla_to_Ecef(lla_w84, ecef_w84);
-        convert_WGS84_to_PZ90(ecef_w84, ecef_p90);
-        convert_Ecef_to_Lla(ecef_p90, lla_p90);
-
-        switch (datum_type) {
-            case LOC_GNSS_DATUM_WGS84:
-                ref_lla.lat = location.gpsLocation.latitude;
-                ref_lla.lon = location.gpsLocation.longitude;
-                ref_lla.alt = location.gpsLocation.altitude;
-                local_lla.lat = lla_p90.lat / M_PI * 180.0;
-                local_lla.lon = lla_p90.lon / M_PI * 180.0;
-                local_lla.alt = lla_p90.alt;
-                break;
-            case LOC_GNSS_DATUM_PZ90:
-                ref_lla.lat = lla_p90.lat / M_PI * 180.0;
-                ref_lla.lon = lla_p90.lon / M_PI * 180.0;
-                ref_lla.alt = lla_p90.alt;
-                local_lla.lat = location.gpsLocation.latitude;
-                local_lla.lon = location.gpsLocation.longitude;
-                local_lla.alt = location.gpsLocation.altitude;
-                break;
-            default:
-                break;
+        // PZ90 is only needed as the datum of the position, or by DTM
+        if (LOC_GNSS_DATUM_WGS84 != datum_type || (sentenceTypes & LOC_NMEA_DTM_MASK)) {
+            loc_get_dual_datum_lla(lla_w84, datum_type, dual_lla);
+        } else {
+            dual_lla.ref = lla_w84;
+            memset(&dual_lla.local, 0, sizeof(dual_lla.local));
         }
+        const LocLla& ref_lla = dual_lla.ref;
+        const LocLla& local_lla = dual_lla.local;
 
         // -------------------
         // ------$--DTM-------
         // -------------------
-        loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
+        if (sentenceTypes & LOC_NMEA_DTM_MASK) {
+            loc_nmea_generate_DTM(ref_lla, local_lla, datum_type, talker,
+                                  sentence_DTM, sizeof(sentence_DTM));
+        }
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
-        pMarker = sentence_RMC;
-        lengthRemaining = sizeof(sentence_RMC);
-
         bool validFix = ((0 != sv_cache_info.gps_used_mask) ||
                 (0 != sv_cache_info.glo_used_mask) ||
                 (0 != sv_cache_info.gal_used_mask) ||
                 (0 != sv_cache_info.qzss_used_mask) ||
                 (0 != sv_cache_info.bds_used_mask));
 
-        if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        if (sentenceTypes & LOC_NMEA_RMC_MASK) {
+            LocNmeaWriter rmc(sentence_RMC, sizeof(sentence_RMC));
+            rmc.putStr(talker);
+            rmc.put("RMC,");
+            loc_nmea_put_utc_time(rmc, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+            rmc.put(validFix ? ",A," : ",V,");
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
             {
-                latHemisphere = 'N';
+                loc_nmea_put_lat_long(rmc, ref_lla.lat, ref_lla.lon);
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                rmc.put(",,,,");
             }
 
-            if (longitude < 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
+                rmc.putFixed(speedKnots, 1);
             }
-            else
+            rmc.put(',');
+
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
             {
-                lonHemisphere = 'E';
+                rmc.putFixed(location.gpsLocation.bearing, 1);
             }
+            rmc.put(',');
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
+            rmc.putInt(utcDay, 2);
+            rmc.putInt(utcMonth, 2);
+            rmc.putInt(utcYear, 2);
+            rmc.put(',');
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
-        {
-            float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
-        {
-            float magneticVariation = locationExtended.magneticDeviation;
-            char direction;
-            if (magneticVariation < 0.0)
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
             {
-                direction = 'W';
-                magneticVariation *= -1.0;
+                float magneticVariation = locationExtended.magneticDeviation;
+                char direction;
+                if (magneticVariation < 0.0)
+                {
+                    direction = 'W';
+                    magneticVariation *= -1.0;
+                }
+                else
+                {
+                    direction = 'E';
+                }
+
+                rmc.putFixed(magneticVariation, 1);
+                rmc.put(',');
+                rmc.put(direction);
+                rmc.put(',');
             }
             else
             {
-                direction = 'E';
+                rmc.put(",,");
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            rmc.put(rmcModeIndicator);
 
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
-        pMarker += length;
-        lengthRemaining -= length;
+            // hardcode Navigation Status field to 'V'
+            rmc.put(",V");
 
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-
-        length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC), false);
+            if (rmc.finish() < 0)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+        }
 
         // -------------------
         // ------$--GNS-------
         // -------------------
 
-        pMarker = sentence_GNS;
-        lengthRemaining = sizeof(sentence_GNS);
+        if (sentenceTypes & LOC_NMEA_GNS_MASK) {
+            LocNmeaWriter gns(sentence_GNS, sizeof(sentence_GNS));
+            gns.putStr(talker);
+            gns.put("GNS,");
+            loc_nmea_put_utc_time(gns, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+            gns.put(',');
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
             {
-                latHemisphere = 'N';
+                loc_nmea_put_lat_long(gns, ref_lla.lat, ref_lla.lon);
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                gns.put(",,,,");
             }
 
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+            gns.putStr(gnsModeIndicator);
+            gns.put(',');
+
+            gns.putInt(svUsedCount, 2);
+            gns.put(',');
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
+                gns.putFixed(locationExtended.hdop, 1);
             }
-            else
+            gns.put(',');
+
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
             {
-                lonHemisphere = 'E';
+                gns.putFixed(locationExtended.altitudeMeanSeaLevel, 1);
             }
+            gns.put(',');
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%s,", gnsModeIndicator);
-
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
-        }
-        else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",");
-        }
+            if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
+                (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
+            {
+                gns.putFixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1);
+            }
+            gns.put(',');
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
+            {
+                gns.putFixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1);
+            }
+            gns.put(',');
 
-        if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
-            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
+            {
+                gns.putInt(locationExtended.dgnssRefStationId, 4);
+            }
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            // hardcode Navigation Status field to 'V'
+            gns.put(",V");
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
+            if (gns.finish() < 0)
             {
                 LOC_LOGE("NMEA Error in string formatting");
                 return;
             }
-            pMarker += length;
-            lengthRemaining -= length;
         }
 
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS), false);
-
         // -------------------
         // ------$--GGA-------
         // -------------------
 
-        pMarker = sentence_GGA;
-        lengthRemaining = sizeof(sentence_GGA);
+        if (sentenceTypes & LOC_NMEA_GGA_MASK) {
+            LocNmeaWriter gga(sentence_GGA, sizeof(sentence_GGA));
+            gga.putStr(talker);
+            gga.put("GGA,");
+            loc_nmea_put_utc_time(gga, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+            gga.put(',');
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
+            {
+                loc_nmea_put_lat_long(gga, ref_lla.lat, ref_lla.lon);
+            }
+            else
+            {
+                gga.put(",,,,");
+            }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            // Number of satellites in use, 00-12
+            if (svUsedCount > MAX_SATELLITES_IN_USE)
+                svUsedCount = MAX_SATELLITES_IN_USE;
+            gga.putStr(ggaGpsQuality);
+            gga.put(',');
+            gga.putInt(svUsedCount, 2);
+            gga.put(',');
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
+            {
+                gga.putFixed(locationExtended.hdop, 1);
+            }
+            gga.put(',');
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
             {
-                latHemisphere = 'N';
+                gga.putFixed(locationExtended.altitudeMeanSeaLevel, 1);
+                gga.put(",M,");
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                gga.put(",,");
             }
 
-            if (longitude < 0)
+            if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
+                (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                gga.putFixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1);
+                gga.put(",M,");
             }
             else
             {
-                lonHemisphere = 'E';
+                gga.put(",,");
             }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        // Number of satellites in use, 00-12
-        if (svUsedCount > MAX_SATELLITES_IN_USE)
-            svUsedCount = MAX_SATELLITES_IN_USE;
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
-        }
-        else
-        {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
-            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",,");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
+            {
+                gga.putFixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1);
+            }
+            gga.put(',');
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
+            {
+                gga.putInt(locationExtended.dgnssRefStationId, 4);
+            }
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
+            if (gga.finish() < 0)
             {
                 LOC_LOGE("NMEA Error in string formatting");
                 return;
             }
-            pMarker += length;
-            lengthRemaining -= length;
         }
 
-        length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA), false);
-
         // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
-        // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
+        if (sentenceTypes & LOC_NMEA_DTM_MASK) {
             nmeaArraystr.push_back(sentence_DTM);
         }
+        // ------$--RMC-------
+        if (sentenceTypes & LOC_NMEA_RMC_MASK) {
+            nmeaArraystr.push_back(sentence_RMC);
+            if(LOC_GNSS_DATUM_PZ90 == datum_type && (sentenceTypes & LOC_NMEA_DTM_MASK)) {
+                // ------$--DTM-------
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+        }
         // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+        if (sentenceTypes & LOC_NMEA_GNS_MASK) {
+            nmeaArraystr.push_back(sentence_GNS);
+            if(LOC_GNSS_DATUM_PZ90 == datum_type && (sentenceTypes & LOC_NMEA_DTM_MASK)) {
+                // ------$--DTM-------
+                nmeaArraystr.push_back(sentence_DTM);
+            }
         }
         // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
-        indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
+        if (sentenceTypes & LOC_NMEA_GGA_MASK) {
+            nmeaArraystr.push_back(sentence_GGA);
+            indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
+        }
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        if (sentenceTypes & LOC_NMEA_GSA_MASK) {
+            strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        if (sentenceTypes & LOC_NMEA_VTG_MASK) {
+            strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        if (sentenceTypes & LOC_NMEA_DTM_MASK) {
+            strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        if (sentenceTypes & LOC_NMEA_RMC_MASK) {
+            strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        if (sentenceTypes & LOC_NMEA_GNS_MASK) {
+            strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        if (sentenceTypes & LOC_NMEA_GGA_MASK) {
+            strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            nmeaArraystr.push_back(sentence);
+        }
     }
 
     EXIT_LOG(%d, 0);
@@ -2127,7 +2241,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 FUNCTION    loc_nmea_generate_sv
 
 DESCRIPTION
-   Generate NMEA sentences generated based on sv report
+   Generate NMEA sentences generated based on sv report, from the report
+   merged per satellite when the caller has it already
 
 DEPENDENCIES
    NONE
@@ -2140,12 +2255,31 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              std::vector<std::string> &nmeaArraystr,
+                              NmeaSentenceTypesMask sentenceTypes)
+{
+    if (0 == (sentenceTypes & LOC_NMEA_GSV_MASK)) {
+        return;
+    }
+    loc_util::LocSvEpoch svEpoch;
+    svEpoch.build(svNotify);
+    loc_nmea_generate_sv(svEpoch, nmeaArraystr, sentenceTypes);
+}
+
+void loc_nmea_generate_sv(const loc_util::LocSvEpoch &svEpoch,
+                              std::vector<std::string> &nmeaArraystr,
+                              NmeaSentenceTypesMask sentenceTypes)
 {
     ENTRY_LOG();
 
+    if (0 == (sentenceTypes & LOC_NMEA_GSV_MASK)) {
+        EXIT_LOG(%d, 0);
+        return;
+    }
+
     char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
     loc_sv_cache_info sv_cache_info = {};
+    const GnssSvNotification& svNotify = svEpoch.report();
 
     //Count GPS SVs for saparating GPS from GLONASS and throw others
     for (uint32_t svOffset = 0; svOffset < svNotify.count; svOffset++) {
@@ -2224,124 +2358,55 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
         }
     }
 
+    // signal ID of each SV, if no signal type in report, it means
+    // default L1,G1,E1,B1I
+    uint32_t svSignalIds[GNSS_SV_MAX];
+    for (uint32_t svOffset = 0; svOffset < svNotify.count && svOffset < GNSS_SV_MAX; svOffset++) {
+        GnssSignalTypeMask signalType = svNotify.gnssSvs[svOffset].gnssSignalTypeMask;
+        if (0 == signalType) {
+            switch (svNotify.gnssSvs[svOffset].type)
+            {
+                case GNSS_SV_TYPE_GPS:
+                    signalType = GNSS_SIGNAL_GPS_L1CA;
+                    break;
+                case GNSS_SV_TYPE_GLONASS:
+                    signalType = GNSS_SIGNAL_GLONASS_G1;
+                    break;
+                case GNSS_SV_TYPE_GALILEO:
+                    signalType = GNSS_SIGNAL_GALILEO_E1;
+                    break;
+                case GNSS_SV_TYPE_QZSS:
+                    signalType = GNSS_SIGNAL_QZSS_L1CA;
+                    break;
+                case GNSS_SV_TYPE_BEIDOU:
+                    signalType = GNSS_SIGNAL_BEIDOU_B1I;
+                    break;
+                case GNSS_SV_TYPE_SBAS:
+                    signalType = GNSS_SIGNAL_SBAS_L1;
+                    break;
+                case GNSS_SV_TYPE_NAVIC:
+                    signalType = GNSS_SIGNAL_NAVIC_L5;
+                    break;
+                default:
+                    LOC_LOGE("NMEA Error unknow constellation type: %d",
+                            svNotify.gnssSvs[svOffset].type);
+                    break;
+            }
+        }
+        // an SV of unknown constellation is in no GSV group
+        svSignalIds[svOffset] = (0 == signalType) ? UINT32_MAX :
+                convert_signalType_to_signalId(signalType);
+    }
+
+    // the last report, per constellation and signal, of this thread
+    static thread_local loc_nmea_gsv_cache sGsvCache[LOC_NMEA_GSV_GROUP_COUNT] = {};
     loc_nmea_sv_meta sv_meta;
-    // ---------------------
-    // ------$GPGSV:L1CA----
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L1CA, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GPGSV:L5------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L5, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GPGSV:L2------
-    // ---------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L2, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GLGSV:G1------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G1, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GLGSV:G2------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G2, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GAGSV:E1------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E1, false), nmeaArraystr);
-
-    // -------------------------
-    // ------$GAGSV:E5A---------
-    // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5A, false), nmeaArraystr);
-
-    // -------------------------
-    // ------$GAGSV:E5B---------
-    // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5B, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GQGSV (QZSS):L1CA-----
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L1CA, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GQGSV (QZSS):L5-------
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L5, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GQGSV (QZSS):L2-------
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L2, false), nmeaArraystr);
-
-
-    // -----------------------------
-    // ------$GBGSV (BEIDOU:B1I)----
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1I, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GBGSV (BEIDOU:B1C)----
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1C, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GBGSV (BEIDOU:B2AI)---
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B2AI, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GIGSV (NAVIC:L5)------
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_NAVIC,
-            GNSS_SIGNAL_NAVIC_L5,false), nmeaArraystr);
+    for (size_t group = 0; group < LOC_NMEA_GSV_GROUP_COUNT; group++) {
+        loc_nmea_generate_GSV(svEpoch, svSignalIds, sentence, sizeof(sentence),
+                loc_nmea_sv_meta_init(sv_meta, sv_cache_info, sGsvGroups[group].svType,
+                sGsvGroups[group].signalType, false), sGsvCache[group],
+                nmeaArraystr, sentenceTypes);
+    }
 
     EXIT_LOG(%d, 0);
 }
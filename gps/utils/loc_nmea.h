@@ -31,6 +31,7 @@
 #define LOC_ENG_NMEA_H
 
 #include <gps_extended.h>
+#include <LocSvEpoch.h>
 #include <vector>
 #include <string>
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -72,8 +73,42 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/** Represents a position in the datum it is reported in (ref) and in the
+    other datum (local), lat / lon in degrees and alt in meters */
+typedef struct {
+    LocLla     ref;
+    LocLla     local;
+} LocDualDatumLla;
+
+void loc_convert_wgs84_to_pz90(const LocLla* wgs84, LocLla* pz90, size_t count);
+
+void loc_get_dual_datum_lla(const LocLla& wgs84, int datumType, LocDualDatumLla& dual);
+
+/* The sentences AP generates, by type, for any talker. Only the types in the
+   sentenceTypes passed to loc_nmea_generate_pos / loc_nmea_generate_sv are
+   formatted, GSV per constellation */
+#define LOC_NMEA_GGA_MASK (LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_GNGGA_V02 | \
+        LOC_NMEA_MASK_GAGGA_V02 | LOC_NMEA_MASK_GBGGA_V02)
+#define LOC_NMEA_RMC_MASK (LOC_NMEA_MASK_RMC_V02 | LOC_NMEA_MASK_GNRMC_V02 | \
+        LOC_NMEA_MASK_GARMC_V02 | LOC_NMEA_MASK_GBRMC_V02)
+#define LOC_NMEA_GSA_MASK (LOC_NMEA_MASK_GSA_V02 | LOC_NMEA_MASK_GNGSA_V02 | \
+        LOC_NMEA_MASK_GAGSA_V02 | LOC_NMEA_MASK_GBGSA_V02 | LOC_NMEA_MASK_PQGSA_V02)
+#define LOC_NMEA_VTG_MASK (LOC_NMEA_MASK_VTG_V02 | LOC_NMEA_MASK_GNVTG_V02 | \
+        LOC_NMEA_MASK_GAVTG_V02 | LOC_NMEA_MASK_GBVTG_V02)
+#define LOC_NMEA_GNS_MASK (LOC_NMEA_MASK_GNGNS_V02 | LOC_NMEA_MASK_GAGNS_V02)
+#define LOC_NMEA_DTM_MASK (LOC_NMEA_MASK_GPDTM_V02 | LOC_NMEA_MASK_GNDTM_V02)
+#define LOC_NMEA_GSV_MASK (LOC_NMEA_MASK_GSV_V02 | LOC_NMEA_MASK_GLGSV_V02 | \
+        LOC_NMEA_MASK_GAGSV_V02 | LOC_NMEA_MASK_GBGSV_V02 | LOC_NMEA_MASK_GQGSV_V02 | \
+        LOC_NMEA_MASK_GIGSV_V02)
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr);
+                              std::vector<std::string> &nmeaArraystr,
+                              NmeaSentenceTypesMask sentenceTypes =
+                                      LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK);
+void loc_nmea_generate_sv(const loc_util::LocSvEpoch &svEpoch,
+                              std::vector<std::string> &nmeaArraystr,
+                              NmeaSentenceTypesMask sentenceTypes =
+                                      LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK);
 
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
@@ -82,7 +117,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                bool custom_gga_fix_quality,
                                std::vector<std::string> &nmeaArraystr,
                                int& indexOfGGA,
-                               bool isTagBlockGroupingEnabled);
+                               bool isTagBlockGroupingEnabled,
+                               NmeaSentenceTypesMask sentenceTypes =
+                                       LOC_NMEA_ALL_GENERAL_SUPPORTED_MASK);
 
 #define DEBUG_NMEA_MINSIZE 6
 #define DEBUG_NMEA_MAXSIZE 4096
@@ -67,6 +67,14 @@ void* loc_timer_start(uint64_t delay_msec,
 */
 void loc_timer_stop(void*& handle);
 
+/*
+    enabled:            true to keep timers in a hierarchical timing wheel,
+                        with O(1) start / stop, instead of a heap.
+                        Only takes effect if called before the first
+                        timer is started in the process.
+*/
+void loc_timer_use_wheel(bool enabled);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -96,6 +96,7 @@ typedef struct loc_logger_s
   unsigned long  DEBUG_LEVEL;
   unsigned long  TIMESTAMP;
   bool           LOG_BUFFER_ENABLE;
+  bool           LOG_BUFFER_DEFERRED_FORMAT;
 } loc_logger_s_type;
 
 
@@ -159,10 +160,26 @@ inline void loc_logger_init(unsigned long debug, unsigned long timestamp)
 inline void log_buffer_init(bool enabled) {
     loc_logger.LOG_BUFFER_ENABLE = enabled;
 }
+inline void log_buffer_use_deferred_format(bool deferred) {
+    loc_logger.LOG_BUFFER_DEFERRED_FORMAT = deferred;
+}
 extern void log_tag_level_map_init();
 extern int get_tag_log_level(const char* tag);
+
+/* Log level of the tag of one source file, cached on its first log and
+   reset by loc_log_level_reset() whenever the levels are read again.
+   level is -1 until resolved, and 0 when logs of the tag are off. */
+typedef struct loc_log_level_cache_s {
+    int level;
+    int registered;
+    struct loc_log_level_cache_s* next;
+} loc_log_level_cache;
+extern int loc_log_level_resolve(loc_log_level_cache* cache, const char* tag);
+extern void loc_log_level_reset();
 extern char* get_timestamp(char* str, unsigned long buf_size);
 extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
+extern void log_buffer_insert_deferred(int level, const char* tag, const char* format, ...)
+        __attribute__((format(printf, 3, 4)));
 /*=============================================================================
  *
  *                          LOGGING BUFFER MACROS
@@ -177,7 +194,9 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define INSERT_BUFFER(flag, level, format, x...)                                              \
 {                                                                                             \
     IF_LOG_BUFFER_ENABLE {                                                                    \
-        if (flag == 0) {                                                                      \
+        if (flag == 0 && loc_logger.LOG_BUFFER_DEFERRED_FORMAT) {                             \
+            log_buffer_insert_deferred(level, LOG_TAG==NULL ? "": LOG_TAG, format "\n", ##x); \
+        } else if (flag == 0) {                                                               \
             char timestr[32];                                                                 \
             get_timestamp(timestr, sizeof(timestr));                                          \
             char log_str[LOGGING_BUFFER_MAX_LEN];                                             \
@@ -202,15 +221,29 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
  * 1, LOCAL_LOG_LEVEL is defined as a static variable in log_util.h,
  *    then all source files which includes log_util.h will have its own LOCAL_LOG_LEVEL variable;
  * 2, For each source file,
- *    2.1, First time when LOC_LOG* is invoked(its LOCAL_LOG_LEVEL == -1),
+ *    2.1, First time when LOC_LOG* is invoked(its level is -1),
  *         Set the tag based log level according to the <tag, level> map;
  *         If this tag isn't found in map, set local debug level as global loc_logger.DEBUG_LEVEL;
- *    2.2, If not the first time, use its LOCAL_LOG_LEVEL as the debug level of this tag.
+ *    2.2, If not the first time, use its cached level, one relaxed atomic load;
+ *    2.3, When DEBUG_LEVEL is read again, all the cached levels go back to -1.
+ * The level is checked before any argument of the log is evaluated.
+ * Logs above LOC_LOG_MAX_LEVEL are compiled out, see Android.bp.
 */
-static int LOCAL_LOG_LEVEL = -1;
+#ifndef LOC_LOG_MAX_LEVEL
+#define LOC_LOG_MAX_LEVEL 5
+#endif
+static loc_log_level_cache LOCAL_LOG_LEVEL = {-1, 0, NULL};
+static inline int loc_log_level_get(loc_log_level_cache* cache, const char* tag)
+{
+    int level = __atomic_load_n(&cache->level, __ATOMIC_RELAXED);
+    if (__builtin_expect(level < 0, 0)) {
+        level = loc_log_level_resolve(cache, tag);
+    }
+    return level;
+}
 #define IF_LOC_LOG(x) \
-    if (((LOCAL_LOG_LEVEL == -1 && (LOCAL_LOG_LEVEL = get_tag_log_level(LOG_TAG)) >= x) ||\
-            LOCAL_LOG_LEVEL >= x) && LOCAL_LOG_LEVEL <= 5)
+    if ((x) <= LOC_LOG_MAX_LEVEL && \
+            __builtin_expect(loc_log_level_get(&LOCAL_LOG_LEVEL, LOG_TAG) >= (x), 0))
 
 #define IF_LOC_LOGE IF_LOC_LOG(1)
 #define IF_LOC_LOGW IF_LOC_LOG(2)
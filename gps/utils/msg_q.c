@@ -267,6 +267,74 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
    return rv;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_batch
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs,
+                               unsigned int max_count, unsigned int* count)
+{
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   if( msg_objs == NULL || count == NULL || max_count == 0 )
+   {
+      LOC_LOGE("%s: Invalid msg_objs parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+   *count = 0;
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+
+   if( p_msg_q->unblocked )
+   {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   /* Wait for data in the message queue */
+   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
+   {
+      pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+   }
+
+   while( *count < max_count && !linked_list_empty(p_msg_q->msg_list) )
+   {
+      rv = convert_linked_list_err_type(
+            linked_list_remove(p_msg_q->msg_list, &msg_objs[*count]));
+      if( rv != eMSG_Q_SUCCESS )
+      {
+         break;
+      }
+      (*count)++;
+   }
+
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   LOC_LOGV("%s: Received %u messages rv = %d\n", __FUNCTION__, *count, rv);
+
+   if( *count > 0 )
+   {
+      /* a partial batch is still a batch */
+      rv = eMSG_Q_SUCCESS;
+   }
+   else if( rv == eMSG_Q_SUCCESS )
+   {
+      /* woken up by msg_q_unblock() with nothing queued */
+      rv = eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   return rv;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_rmv
@@ -157,6 +157,32 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj);
 
+/*===========================================================================
+FUNCTION    msg_q_rcv_batch
+
+DESCRIPTION
+   Retrieves up to max_count messages from the message queue, oldest first,
+   blocking until at least one is available. All of them are taken under a
+   single hold of the queue lock.
+
+   msg_q_data: Message Queue to copy data from into msg_objs.
+   msg_objs:   Array of at least max_count pointers to copy msg_q contents to.
+   max_count:  Capacity of msg_objs.
+   count:      Number of messages copied into msg_objs.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs,
+                               unsigned int max_count, unsigned int* count);
+
 /*===========================================================================
 FUNCTION    msg_q_rmv
 
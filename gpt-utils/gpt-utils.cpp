@@ -37,6 +37,7 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <linux/fs.h>
 #include <limits.h>
@@ -57,6 +58,7 @@
 #include "gpt-utils.h"
 #include <zlib.h>
 #include <endian.h>
+#include <pthread.h>
 
 
 /******************************************************************************
@@ -83,6 +85,8 @@
 #define LUN_NAME_START_LOC (sizeof("/dev/block/") - 1)
 #define BOOT_LUN_A_ID 1
 #define BOOT_LUN_B_ID 2
+//Number of LUNs prepared for update at the same time
+#define MAX_PREPARE_WORKERS 4
 /******************************************************************************
  * MACROS
  ******************************************************************************/
@@ -123,7 +127,26 @@ struct update_data {
      uint32_t num_valid_entries;
 };
 
+//LUNs shared out between the prepare_partitions workers
+struct prepare_lun_job {
+     struct update_data *data;
+     enum boot_update_stage stage;
+     //Index of the next LUN to hand out
+     uint32_t next;
+     int rcode[MAX_LUNS];
+};
+
+//The boot LUN is a device wide setting switched through a single
+//bsg/sg node, so LUNs being prepared in parallel take turns at it.
+static pthread_mutex_t boot_lun_lock = PTHREAD_MUTEX_INITIALIZER;
+
 int32_t set_boot_lun(char *sg_dev,uint8_t boot_lun_id);
+
+static struct gpt_io_stats io_stats;
+#ifdef GPT_UTILS_FAULT_INJECTION
+//Bytes of writes still allowed through, -1 for no limit
+static int64_t write_budget = -1;
+#endif
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -144,28 +167,160 @@ int32_t set_boot_lun(char *sg_dev,uint8_t boot_lun_id);
  */
 static int blk_rw(int fd, int rw, int64_t offset, uint8_t *buf, unsigned len)
 {
-    int r;
+    ssize_t r;
+
+    while (len) {
+        if (rw) {
+#ifdef GPT_UTILS_FAULT_INJECTION
+            if (write_budget == 0) {
+                errno = EIO;
+                r = -1;
+            } else {
+                unsigned chunk = len;
+                if (write_budget > 0 && (int64_t)chunk > write_budget)
+                    chunk = write_budget;
+                r = pwrite64(fd, buf, chunk, offset);
+                if (r > 0 && write_budget > 0)
+                    write_budget -= r;
+            }
+#else
+            r = pwrite64(fd, buf, len, offset);
+#endif
+            __atomic_fetch_add(&io_stats.writes, 1, __ATOMIC_RELAXED);
+            if (r > 0)
+                __atomic_fetch_add(&io_stats.bytes_written, r,
+                        __ATOMIC_RELAXED);
+        } else {
+            r = pread64(fd, buf, len, offset);
+            __atomic_fetch_add(&io_stats.reads, 1, __ATOMIC_RELAXED);
+            if (r > 0)
+                __atomic_fetch_add(&io_stats.bytes_read, r,
+                        __ATOMIC_RELAXED);
+        }
 
-    if (lseek64(fd, offset, SEEK_SET) < 0) {
-        fprintf(stderr, "block dev lseek64 %" PRIi64 " failed: %s\n", offset,
-                strerror(errno));
-        return -1;
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "block dev %s %" PRIi64 " failed: %s\n",
+                    rw ? "write" : "read", offset, strerror(errno));
+            return -1;
+        }
+        if (r == 0) {
+            fprintf(stderr, "block dev %s %" PRIi64 " hit end of device\n",
+                    rw ? "write" : "read", offset);
+            return -1;
+        }
+        buf += r;
+        offset += r;
+        len -= r;
     }
 
-    if (rw)
-        r = write(fd, buf, len);
-    else
-        r = read(fd, buf, len);
+    return 0;
+}
 
-    if (r < 0)
-        fprintf(stderr, "block dev %s failed: %s\n", rw ? "write" : "read",
-                strerror(errno));
-    else
+
+/**
+ *  ==========================================================================
+ *
+ *  \brief  Read/Write a set of buffers from/to consecutive block dev
+ *  locations with a single syscall
+ *
+ *  \param [in] fd      block dev file descriptor (returned from open)
+ *  \param [in] rw      RW flag: 0 - read, != 0 - write
+ *  \param [in] offset  block dev offset [bytes] - RW start position
+ *  \param [in] iov     Buffers, in on-disk order
+ *  \param [in] iovcnt  Number of buffers in iov
+ *
+ *  \return  0 on success
+ *
+ *  ==========================================================================
+ */
+static int blk_rwv(int fd, int rw, int64_t offset, const struct iovec *iov,
+                   int iovcnt)
+{
+    ssize_t r;
+    size_t len = 0;
+    int i;
+
+    for (i = 0; i < iovcnt; i++)
+        len += iov[i].iov_len;
+
+#ifdef GPT_UTILS_FAULT_INJECTION
+    //Go through blk_rw so that the write budget applies
+    if (rw && write_budget >= 0)
         r = 0;
+    else
+#endif
+    do {
+        if (rw) {
+            r = pwritev64(fd, iov, iovcnt, offset);
+            __atomic_fetch_add(&io_stats.writes, 1, __ATOMIC_RELAXED);
+            if (r > 0)
+                __atomic_fetch_add(&io_stats.bytes_written, r,
+                        __ATOMIC_RELAXED);
+        } else {
+            r = preadv64(fd, iov, iovcnt, offset);
+            __atomic_fetch_add(&io_stats.reads, 1, __ATOMIC_RELAXED);
+            if (r > 0)
+                __atomic_fetch_add(&io_stats.bytes_read, r,
+                        __ATOMIC_RELAXED);
+        }
+    } while (r < 0 && errno == EINTR);
 
-    return r;
+    if (r < 0) {
+        fprintf(stderr, "block dev %s %" PRIi64 " failed: %s\n",
+                rw ? "writev" : "readv", offset, strerror(errno));
+        return -1;
+    }
+    if ((size_t)r == len)
+        return 0;
+
+    //Short transfer, redo it one buffer at a time
+    for (i = 0; i < iovcnt; i++) {
+        if (blk_rw(fd, rw, offset, (uint8_t *)iov[i].iov_base,
+                   iov[i].iov_len))
+            return -1;
+        offset += iov[i].iov_len;
+    }
+    return 0;
+}
+
+//Flush the block dev, only its data if datasync is set
+static int blk_flush(int fd, int datasync)
+{
+    __atomic_fetch_add(&io_stats.flushes, 1, __ATOMIC_RELAXED);
+    return datasync ? fdatasync(fd) : fsync(fd);
+}
+
+void gpt_utils_get_io_stats(struct gpt_io_stats *stats)
+{
+    if (!stats)
+        return;
+    stats->reads = __atomic_load_n(&io_stats.reads, __ATOMIC_RELAXED);
+    stats->writes = __atomic_load_n(&io_stats.writes, __ATOMIC_RELAXED);
+    stats->flushes = __atomic_load_n(&io_stats.flushes, __ATOMIC_RELAXED);
+    stats->bytes_read = __atomic_load_n(&io_stats.bytes_read,
+            __ATOMIC_RELAXED);
+    stats->bytes_written = __atomic_load_n(&io_stats.bytes_written,
+            __ATOMIC_RELAXED);
 }
 
+void gpt_utils_reset_io_stats()
+{
+    __atomic_store_n(&io_stats.reads, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&io_stats.writes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&io_stats.flushes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&io_stats.bytes_read, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&io_stats.bytes_written, 0, __ATOMIC_RELAXED);
+}
+
+#ifdef GPT_UTILS_FAULT_INJECTION
+void gpt_utils_set_write_budget(int64_t bytes)
+{
+    write_budget = bytes < 0 ? -1 : bytes;
+}
+#endif
+
 
 
 /**
@@ -213,6 +368,50 @@ static uint8_t *gpt_pentry_seek(const char *ptn_name,
 
 
 
+/**
+ *  ==========================================================================
+ *
+ *  \brief  Updates the CRC of an array for a change of some of its bytes
+ *
+ *  CRC32 is linear: the CRCs of two arrays of the same size differ by the
+ *  CRC of their XOR, less that of as many zeros. That difference only
+ *  depends on the changed bytes, and is carried over the bytes after them
+ *  by crc32_combine(), so the rest of the array is never gone over.
+ *
+ *  \param [in] crc         CRC of the array before the change
+ *  \param [in] array_size  Size of the whole array
+ *  \param [in] offset      Offset of the changed bytes in the array
+ *  \param [in] old_data    Changed bytes before the change
+ *  \param [in] new_data    Changed bytes after the change
+ *  \param [in] len         Number of changed bytes
+ *
+ *  \return  CRC of the array after the change
+ *
+ *  ==========================================================================
+ */
+static uint32_t gpt_crc_update(uint32_t crc, uint32_t array_size,
+                               uint32_t offset, const uint8_t *old_data,
+                               const uint8_t *new_data, uint32_t len)
+{
+    static const uint8_t zeros[PTN_ENTRY_SIZE] = {0};
+    uint8_t  delta[PTN_ENTRY_SIZE];
+    uint32_t crc_delta = 0;
+    uint32_t crc_zeros = 0;
+    uint32_t i, j, n;
+
+    for (i = 0; i < len; i += n) {
+        n = (len - i < sizeof(delta)) ? len - i : sizeof(delta);
+        for (j = 0; j < n; j++)
+            delta[j] = old_data[i + j] ^ new_data[i + j];
+        crc_delta = crc32(crc_delta, delta, n);
+        crc_zeros = crc32(crc_zeros, zeros, n);
+    }
+    return crc ^ crc32_combine(crc_delta ^ crc_zeros, 0,
+                               array_size - offset - len);
+}
+
+
+
 /**
  *  ==========================================================================
  *
@@ -221,6 +420,8 @@ static uint8_t *gpt_pentry_seek(const char *ptn_name,
  *  \param [in] pentries_start  Partition entries array start
  *  \param [in] pentries_end    Partition entries array end
  *  \param [in] pentry_size     Single partition entry size
+ *  \param [in,out] crc         CRC of the array, kept up to date with the
+ *                              entries swapped
  *
  *  \return  0 on success, 1 if no backup partitions found
  *
@@ -228,8 +429,10 @@ static uint8_t *gpt_pentry_seek(const char *ptn_name,
  */
 static int gpt_boot_chain_swap(const uint8_t *pentries_start,
                                 const uint8_t *pentries_end,
-                                uint32_t pentry_size)
+                                uint32_t pentry_size,
+                                uint32_t *crc)
 {
+    uint32_t pentries_array_size = pentries_end - pentries_start;
     const char ptn_swap_list[][MAX_GPT_NAME_SIZE] = { PTN_SWAP_LIST };
 
     int backup_not_found = 1;
@@ -259,6 +462,14 @@ static int gpt_boot_chain_swap(const uint8_t *pentries_start,
             continue;
         }
 
+        /* each entry changes from its own contents to the other's */
+        *crc = gpt_crc_update(*crc, pentries_array_size,
+                        ptn_entry - pentries_start,
+                        ptn_entry, ptn_bak_entry, PTN_ENTRY_SIZE);
+        *crc = gpt_crc_update(*crc, pentries_array_size,
+                        ptn_bak_entry - pentries_start,
+                        ptn_bak_entry, ptn_entry, PTN_ENTRY_SIZE);
+
         /* swap primary <-> backup partition entries */
         memcpy(ptn_swap, ptn_entry, PTN_ENTRY_SIZE);
         memcpy(ptn_entry, ptn_bak_entry, PTN_ENTRY_SIZE);
@@ -362,13 +573,13 @@ static int gpt2_set_boot_chain(int fd, enum boot_chain boot)
         GET_8_BYTES(gpt_header + PENTRIES_OFFSET) * blk_size;
 
     if (boot == BACKUP_BOOT) {
+        /* crc, validated above, follows the few entries swapped */
         r = gpt_boot_chain_swap(pentries, pentries + pentries_array_size,
-                                pentry_size);
+                                pentry_size, &crc);
         if (r)
             goto EXIT;
     }
 
-    crc = crc32(crc_zero, pentries, pentries_array_size);
     PUT_4_BYTES(gpt_header + PARTITION_CRC_OFFSET, crc);
 
     /* header CRC is calculated with this field cleared */
@@ -633,6 +844,7 @@ int gpt_utils_set_xbl_boot_partition(enum boot_chain chain)
         char sg_dev_node[PATH_MAX] = {0};
         uint8_t boot_lun_id = 0;
         const char *boot_dev = NULL;
+        int32_t rc = 0;
 
         if (chain == BACKUP_BOOT) {
                 boot_lun_id = BOOT_LUN_B_ID;
@@ -682,7 +894,10 @@ int gpt_utils_set_xbl_boot_partition(enum boot_chain chain)
                 goto error;
         }
         /* set boot lun using /dev/sg or /dev/ufs-bsg* */
-        if (set_boot_lun(sg_dev_node, boot_lun_id)) {
+        pthread_mutex_lock(&boot_lun_lock);
+        rc = set_boot_lun(sg_dev_node, boot_lun_id);
+        pthread_mutex_unlock(&boot_lun_lock);
+        if (rc) {
                 fprintf(stderr, "%s: Failed to set xblbak as boot partition\n",
                                 __func__);
                 goto error;
@@ -694,13 +909,22 @@ error:
 
 int gpt_utils_is_ufs_device()
 {
+    //ro.boot.bootdevice cannot change once set, so look it up only once
+    static int is_ufs = -1;
     char bootdevice[PROPERTY_VALUE_MAX] = {0};
+    int r = __atomic_load_n(&is_ufs, __ATOMIC_RELAXED);
+
+    if (r >= 0)
+        return r;
     property_get("ro.boot.bootdevice", bootdevice, "N/A");
     if (strlen(bootdevice) < strlen(".ufshc") + 1)
-        return 0;
-    return (!strncmp(&bootdevice[strlen(bootdevice) - strlen(".ufshc")],
-                            ".ufshc",
-                            sizeof(".ufshc")));
+        r = 0;
+    else
+        r = (!strncmp(&bootdevice[strlen(bootdevice) - strlen(".ufshc")],
+                                ".ufshc",
+                                sizeof(".ufshc")));
+    __atomic_store_n(&is_ufs, r, __ATOMIC_RELAXED);
+    return r;
 }
 //dev_path is the path to the block device that contains the GPT image that
 //needs to be updated. This would be the device which holds one or more critical
@@ -885,7 +1109,7 @@ int prepare_partitions(enum boot_update_stage stage, const char *dev_path)
 
 EXIT:
     if (fd >= 0) {
-       fsync(fd);
+       blk_flush(fd, 0);
        close(fd);
     }
     return r;
@@ -937,12 +1161,33 @@ int add_lun_to_update_list(char *lun_path, struct update_data *dat)
         return 0;
 }
 
+//Prepare LUNs from the shared list until none are left
+static void *prepare_partitions_worker(void *arg)
+{
+        struct prepare_lun_job *job = (struct prepare_lun_job *)arg;
+        uint32_t i;
+
+        while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+                        job->data->num_valid_entries) {
+                fprintf(stderr, "%s: Preparing %s for update stage %d\n",
+                                __func__,
+                                job->data->lun_list[i],
+                                job->stage);
+                job->rcode[i] = prepare_partitions(job->stage,
+                                job->data->lun_list[i]);
+        }
+        return NULL;
+}
+
 int prepare_boot_update(enum boot_update_stage stage)
 {
         int is_ufs = gpt_utils_is_ufs_device();
         struct stat ufs_dir_stat;
         struct update_data data;
+        struct prepare_lun_job job;
         int rcode = 0;
+        pthread_t workers[MAX_PREPARE_WORKERS - 1];
+        uint32_t num_workers = 0;
         uint32_t i = 0;
         int is_error = 0;
         const char ptn_swap_list[][MAX_GPT_NAME_SIZE] = { PTN_SWAP_LIST };
@@ -998,13 +1243,33 @@ int prepare_boot_update(enum boot_update_stage stage)
                         memset(buf, '\0', sizeof(buf));
                         memset(real_path, '\0', sizeof(real_path));
                 }
+                //The LUNs have separate GPTs, so they are prepared in
+                //parallel. Each one still goes through its stages in
+                //order inside prepare_partitions.
+                memset(&job, '\0', sizeof(struct prepare_lun_job));
+                job.data = &data;
+                job.stage = stage;
+                for (num_workers = 0;
+                                num_workers + 1 < MAX_PREPARE_WORKERS &&
+                                num_workers + 1 < data.num_valid_entries;
+                                num_workers++) {
+                        rcode = pthread_create(&workers[num_workers], NULL,
+                                        prepare_partitions_worker,
+                                        &job);
+                        if (rcode) {
+                                fprintf(stderr, "%s: Failed to start worker: %s\n",
+                                                __func__,
+                                                strerror(rcode));
+                                break;
+                        }
+                }
+                //This thread takes a share of the LUNs too, so the list
+                //is covered even if no worker could be started
+                prepare_partitions_worker(&job);
+                for (i = 0; i < num_workers; i++)
+                        pthread_join(workers[i], NULL);
                 for (i=0; i < data.num_valid_entries; i++) {
-                        fprintf(stderr, "%s: Preparing %s for update stage %d\n",
-                                        __func__,
-                                        data.lun_list[i],
-                                        stage);
-                        rcode = prepare_partitions(stage, data.lun_list[i]);
-                        if (rcode != 0)
+                        if (job.rcode[i] != 0)
                         {
                                 fprintf(stderr, "%s: Failed to prepare %s.Continuing..\n",
                                                 __func__,
@@ -1018,6 +1283,67 @@ int prepare_boot_update(enum boot_update_stage stage)
         return 0;
 }
 
+//Cache of /dev/block/bootdevice/by-name, mapping each partition name to
+//the LUN holding it. It is filled with one scan of the directory and
+//rebuilt whenever the directory mtime changes, i.e. whenever ueventd
+//has added or removed links since the last scan.
+static pthread_mutex_t ptn_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static map<string, string> ptn_cache;
+static struct timespec ptn_cache_mtime;
+static int ptn_cache_valid = 0;
+
+//Bring the partition cache up to date. Must be called with ptn_cache_lock
+//held. Returns 0 on success and -1 on error.
+static int ptn_cache_refresh_locked()
+{
+        struct stat st;
+        DIR *dir = NULL;
+        struct dirent *de = NULL;
+        char path[PATH_MAX] = {0};
+        char real_path[PATH_MAX] = {0};
+        ssize_t len = 0;
+
+        if (stat(BOOT_DEV_DIR, &st)) {
+                ptn_cache_valid = 0;
+                goto error;
+        }
+        if (ptn_cache_valid &&
+                        st.st_mtim.tv_sec == ptn_cache_mtime.tv_sec &&
+                        st.st_mtim.tv_nsec == ptn_cache_mtime.tv_nsec)
+                return 0;
+        ptn_cache.clear();
+        ptn_cache_valid = 0;
+        dir = opendir(BOOT_DEV_DIR);
+        if (!dir) {
+                ALOGE("%s: Failed to open %s: %s",
+                                __func__,
+                                BOOT_DEV_DIR,
+                                strerror(errno));
+                goto error;
+        }
+        while ((de = readdir(dir))) {
+                if (de->d_name[0] == '.')
+                        continue;
+                snprintf(path, sizeof(path),
+                                "%s/%s",
+                                BOOT_DEV_DIR,
+                                de->d_name);
+                len = readlink(path, real_path, sizeof(real_path) - 1);
+                if (len < (ssize_t)PATH_TRUNCATE_LOC)
+                        continue;
+                real_path[PATH_TRUNCATE_LOC] = '\0';
+                ptn_cache[de->d_name] = real_path;
+        }
+        closedir(dir);
+        //The mtime is the one from before the scan, so links added while
+        //scanning cause another rebuild on the next lookup.
+        ptn_cache_mtime = st.st_mtim;
+        ptn_cache_valid = 1;
+        return 0;
+error:
+        return -1;
+}
+
 //Given a parttion name(eg: rpm) get the path to the block device that
 //represents the GPT disk the partition resides on. In the case of emmc it
 //would be the default emmc dev(/dev/block/mmcblk0). In the case of UFS we look
@@ -1027,27 +1353,25 @@ static int get_dev_path_from_partition_name(const char *partname,
                 char *buf,
                 size_t buflen)
 {
-        struct stat st;
-        char path[PATH_MAX] = {0};
+        map<string, string>::iterator it;
         if (!partname || !buf || buflen < ((PATH_TRUNCATE_LOC) + 1)) {
                 ALOGE("%s: Invalid argument", __func__);
                 goto error;
         }
         if (gpt_utils_is_ufs_device()) {
                 //Need to find the lun that holds partition partname
-                snprintf(path, sizeof(path),
-                                "%s/%s",
-                                BOOT_DEV_DIR,
-                                partname);
-                if (stat(path, &st)) {
+                pthread_mutex_lock(&ptn_cache_lock);
+                if (ptn_cache_refresh_locked()) {
+                        pthread_mutex_unlock(&ptn_cache_lock);
                         goto error;
                 }
-                if (readlink(path, buf, buflen) < 0)
-                {
+                it = ptn_cache.find(partname);
+                if (it == ptn_cache.end()) {
+                        pthread_mutex_unlock(&ptn_cache_lock);
                         goto error;
-                } else {
-                        buf[PATH_TRUNCATE_LOC] = '\0';
                 }
+                strlcpy(buf, it->second.c_str(), buflen);
+                pthread_mutex_unlock(&ptn_cache_lock);
         } else {
                 snprintf(buf, buflen, BLK_DEV_FILE);
         }
@@ -1114,87 +1438,35 @@ error:
         return 0;
 }
 
-//Write the GPT header present in the passed in buffer back to the
-//disk represented by fd
-static int gpt_set_header(uint8_t *gpt_header, int fd,
+//Offset of the primary or backup GPT header on a disk of disk_size
+//bytes
+static int64_t gpt_get_header_offset(int64_t disk_size, uint32_t block_size,
                 enum gpt_instance instance)
 {
-        uint32_t block_size = 0;
-        off64_t gpt_header_offset = 0;
-        if (!gpt_header || fd < 0) {
-                ALOGE("%s: Invalid arguments",
-                                __func__);
-                goto error;
-        }
-        block_size = gpt_get_block_size(fd);
-        if (block_size == 0) {
-                ALOGE("%s: Failed to get block size", __func__);
-                goto error;
-        }
         if (instance == PRIMARY_GPT)
-                gpt_header_offset = block_size;
-        else
-                gpt_header_offset = lseek64(fd, 0, SEEK_END) - block_size;
-        if (gpt_header_offset <= 0) {
-                ALOGE("%s: Failed to get gpt header offset",__func__);
-                goto error;
-        }
-        if (blk_rw(fd, 1, gpt_header_offset, gpt_header, block_size)) {
-                ALOGE("%s: Failed to write back GPT header", __func__);
-                goto error;
-        }
-        return 0;
-error:
-        return -1;
+                return block_size;
+        return disk_size - block_size;
 }
 
-//Read out the GPT header for the disk that contains the partition partname
-static uint8_t* gpt_get_header(const char *partname, enum gpt_instance instance)
+//Read out the primary or backup GPT header of the disk represented by
+//fd
+static uint8_t* gpt_get_header(int fd, uint32_t block_size,
+                int64_t disk_size, enum gpt_instance instance)
 {
         uint8_t* hdr = NULL;
-        char devpath[PATH_MAX] = {0};
         int64_t hdr_offset = 0;
-        uint32_t block_size = 0;
-        int fd = -1;
-        if (!partname) {
-                ALOGE("%s: Invalid partition name", __func__);
-                goto error;
-        }
-        if (get_dev_path_from_partition_name(partname, devpath, sizeof(devpath))
-                        != 0) {
-                ALOGE("%s: Failed to resolve path for %s",
-                                __func__,
-                                partname);
-                goto error;
-        }
-        fd = open(devpath, O_RDWR);
-        if (fd < 0) {
-                ALOGE("%s: Failed to open %s : %s",
-                                __func__,
-                                devpath,
-                                strerror(errno));
-                goto error;
-        }
-        block_size = gpt_get_block_size(fd);
-        if (block_size == 0)
-        {
-                ALOGE("%s: Failed to get gpt block size for %s",
-                                __func__,
-                                partname);
+        if (fd < 0 || block_size == 0) {
+                ALOGE("%s: Invalid arguments", __func__);
                 goto error;
         }
-
         hdr = (uint8_t*)malloc(block_size);
         if (!hdr) {
                 ALOGE("%s: Failed to allocate memory for gpt header",
                                 __func__);
+                goto error;
         }
-        if (instance == PRIMARY_GPT)
-                hdr_offset = block_size;
-        else {
-                hdr_offset = lseek64(fd, 0, SEEK_END) - block_size;
-        }
-        if (hdr_offset < 0) {
+        hdr_offset = gpt_get_header_offset(disk_size, block_size, instance);
+        if (hdr_offset <= 0) {
                 ALOGE("%s: Failed to get gpt header offset",
                                 __func__);
                 goto error;
@@ -1204,11 +1476,8 @@ static uint8_t* gpt_get_header(const char *partname, enum gpt_instance instance)
                                 __func__);
                 goto error;
         }
-        close(fd);
         return hdr;
 error:
-        if (fd >= 0)
-                close(fd);
         if (hdr)
                 free(hdr);
         return NULL;
@@ -1218,11 +1487,10 @@ error:
 //passed in buffer which contains the gpt header.
 //The fd here is the descriptor for the 'disk' which
 //holds the partition
-static uint8_t* gpt_get_pentry_arr(uint8_t *hdr, int fd)
+static uint8_t* gpt_get_pentry_arr(uint8_t *hdr, int fd, uint32_t block_size)
 {
         uint64_t pentries_start = 0;
         uint32_t pentry_size = 0;
-        uint32_t block_size = 0;
         uint32_t pentries_arr_size = 0;
         uint8_t *pentry_arr = NULL;
         int rc = 0;
@@ -1230,16 +1498,10 @@ static uint8_t* gpt_get_pentry_arr(uint8_t *hdr, int fd)
                 ALOGE("%s: Invalid header", __func__);
                 goto error;
         }
-        if (fd < 0) {
+        if (fd < 0 || !block_size) {
                 ALOGE("%s: Invalid fd", __func__);
                 goto error;
         }
-        block_size = gpt_get_block_size(fd);
-        if (!block_size) {
-                ALOGE("%s: Failed to get gpt block size for",
-                                __func__);
-                goto error;
-        }
         pentries_start = GET_8_BYTES(hdr + PENTRIES_OFFSET) * block_size;
         pentry_size = GET_4_BYTES(hdr + PENTRY_SIZE_OFFSET);
         pentries_arr_size =
@@ -1266,33 +1528,48 @@ error:
         return NULL;
 }
 
-static int gpt_set_pentry_arr(uint8_t *hdr, int fd, uint8_t* arr)
+//Write a GPT header and its partition entry array back to the disk
+//represented by fd. The array sits right after the primary header and
+//right before the backup one, so both normally go out in one write.
+static int gpt_set_table(uint8_t *hdr, uint8_t *arr, int fd,
+                uint32_t block_size, int64_t hdr_offset)
 {
-        uint32_t block_size = 0;
         uint64_t pentries_start = 0;
         uint32_t pentry_size = 0;
         uint32_t pentries_arr_size = 0;
+        struct iovec iov[2];
         int rc = 0;
-        if (!hdr || fd < 0 || !arr) {
+        if (!hdr || fd < 0 || !arr || !block_size || hdr_offset <= 0) {
                 ALOGE("%s: Invalid argument", __func__);
                 goto error;
         }
-        block_size = gpt_get_block_size(fd);
-        if (!block_size) {
-                ALOGE("%s: Failed to get gpt block size for",
-                                __func__);
-                goto error;
-        }
         pentries_start = GET_8_BYTES(hdr + PENTRIES_OFFSET) * block_size;
         pentry_size = GET_4_BYTES(hdr + PENTRY_SIZE_OFFSET);
         pentries_arr_size =
                 GET_4_BYTES(hdr + PARTITION_COUNT_OFFSET) * pentry_size;
-        rc = blk_rw(fd, 1,
-                        pentries_start,
-                        arr,
-                        pentries_arr_size);
+        if (pentries_start == (uint64_t)hdr_offset + block_size) {
+                iov[0].iov_base = hdr;
+                iov[0].iov_len = block_size;
+                iov[1].iov_base = arr;
+                iov[1].iov_len = pentries_arr_size;
+                rc = blk_rwv(fd, 1, hdr_offset, iov, 2);
+        } else if (pentries_start + pentries_arr_size ==
+                        (uint64_t)hdr_offset) {
+                iov[0].iov_base = arr;
+                iov[0].iov_len = pentries_arr_size;
+                iov[1].iov_base = hdr;
+                iov[1].iov_len = block_size;
+                rc = blk_rwv(fd, 1, pentries_start, iov, 2);
+        } else {
+                rc = blk_rw(fd, 1, hdr_offset, hdr, block_size);
+                if (!rc)
+                        rc = blk_rw(fd, 1,
+                                        pentries_start,
+                                        arr,
+                                        pentries_arr_size);
+        }
         if (rc) {
-                ALOGE("%s: Failed to read partition entry array",
+                ALOGE("%s: Failed to write back GPT header and partition arr",
                                 __func__);
                 goto error;
         }
@@ -1303,6 +1580,50 @@ error:
 
 
 
+//Returns a copy of a partition entry array to base CRC updates on, if
+//the CRC in hdr is the one of arr. That is taken as given if the
+//header itself checks out, the array is not gone over for it.
+static uint8_t* gpt_get_crc_base(uint8_t *hdr, uint32_t block_size,
+                const uint8_t *arr, uint32_t arr_size)
+{
+        uint32_t gpt_header_size = GET_4_BYTES(hdr + HEADER_SIZE_OFFSET);
+        uint32_t hdr_crc = GET_4_BYTES(hdr + HEADER_CRC_OFFSET);
+        uint32_t crc = 0;
+        uint8_t *base = NULL;
+        if (gpt_header_size > block_size)
+                return NULL;
+        //Header CRC is calculated with its own CRC field set to 0
+        PUT_4_BYTES(hdr + HEADER_CRC_OFFSET, 0);
+        crc = crc32(crc32(0L, Z_NULL, 0), hdr, gpt_header_size);
+        PUT_4_BYTES(hdr + HEADER_CRC_OFFSET, hdr_crc);
+        if (crc != hdr_crc)
+                return NULL;
+        base = (uint8_t*)malloc(arr_size);
+        if (base)
+                memcpy(base, arr, arr_size);
+        return base;
+}
+
+//CRC of a partition entry array. With a base, crc being its CRC, only
+//the entries that differ from it are gone over, and base is brought
+//up to date with arr.
+static uint32_t gpt_pentry_arr_crc(const uint8_t *arr, uint8_t *base,
+                uint32_t arr_size, uint32_t pentry_size, uint32_t crc)
+{
+        uint32_t offset = 0;
+        if (!base)
+                return crc32(crc32(0L, Z_NULL, 0), arr, arr_size);
+        for (offset = 0; offset + pentry_size <= arr_size;
+                        offset += pentry_size) {
+                if (!memcmp(arr + offset, base + offset, pentry_size))
+                        continue;
+                crc = gpt_crc_update(crc, arr_size, offset,
+                                base + offset, arr + offset, pentry_size);
+                memcpy(base + offset, arr + offset, pentry_size);
+        }
+        return crc;
+}
+
 //Allocate a handle used by calls to the "gpt_disk" api's
 struct gpt_disk * gpt_disk_alloc()
 {
@@ -1330,6 +1651,10 @@ void gpt_disk_free(struct gpt_disk *disk)
                 free(disk->pentry_arr);
         if (disk->pentry_arr_bak)
                 free(disk->pentry_arr_bak);
+        if (disk->pentry_arr_crc_base)
+                free(disk->pentry_arr_crc_base);
+        if (disk->pentry_arr_bak_crc_base)
+                free(disk->pentry_arr_bak_crc_base);
         free(disk);
         return;
 }
@@ -1342,6 +1667,7 @@ int gpt_disk_get_disk_info(const char *dev, struct gpt_disk *dsk)
 	struct gpt_disk *disk = NULL;
 	int fd = -1;
 	uint32_t gpt_header_size = 0;
+	int64_t disk_size = 0;
 	uint32_t crc_zero;
 
 	crc_zero = crc32(0L, Z_NULL, 0);
@@ -1350,20 +1676,6 @@ int gpt_disk_get_disk_info(const char *dev, struct gpt_disk *dsk)
                 goto error;
         }
         disk = dsk;
-        disk->hdr = gpt_get_header(dev, PRIMARY_GPT);
-        if (!disk->hdr) {
-                ALOGE("%s: Failed to get primary header", __func__);
-                goto error;
-        }
-        gpt_header_size = GET_4_BYTES(disk->hdr + HEADER_SIZE_OFFSET);
-        disk->hdr_crc = crc32(crc_zero, disk->hdr, gpt_header_size);
-        disk->hdr_bak = gpt_get_header(dev, SECONDARY_GPT);
-        if (!disk->hdr_bak) {
-                ALOGE("%s: Failed to get backup header", __func__);
-                goto error;
-        }
-        disk->hdr_bak_crc = crc32(crc_zero, disk->hdr_bak, gpt_header_size);
-
         //Descriptor for the block device. We will use this for further
         //modifications to the partition table
         if (get_dev_path_from_partition_name(dev,
@@ -1374,6 +1686,7 @@ int gpt_disk_get_disk_info(const char *dev, struct gpt_disk *dsk)
                                 dev);
                 goto error;
         }
+        //Both tables are read through this one descriptor
         fd = open(disk->devpath, O_RDWR);
         if (fd < 0) {
                 ALOGE("%s: Failed to open %s: %s",
@@ -1382,13 +1695,38 @@ int gpt_disk_get_disk_info(const char *dev, struct gpt_disk *dsk)
                                 strerror(errno));
                 goto error;
         }
-        disk->pentry_arr = gpt_get_pentry_arr(disk->hdr, fd);
+        disk->block_size = gpt_get_block_size(fd);
+        if (!disk->block_size) {
+                ALOGE("%s: Failed to get gpt block size for %s",
+                                __func__,
+                                disk->devpath);
+                goto error;
+        }
+        disk_size = lseek64(fd, 0, SEEK_END);
+        disk->hdr = gpt_get_header(fd, disk->block_size, disk_size,
+                        PRIMARY_GPT);
+        if (!disk->hdr) {
+                ALOGE("%s: Failed to get primary header", __func__);
+                goto error;
+        }
+        gpt_header_size = GET_4_BYTES(disk->hdr + HEADER_SIZE_OFFSET);
+        disk->hdr_crc = crc32(crc_zero, disk->hdr, gpt_header_size);
+        disk->hdr_bak = gpt_get_header(fd, disk->block_size, disk_size,
+                        SECONDARY_GPT);
+        if (!disk->hdr_bak) {
+                ALOGE("%s: Failed to get backup header", __func__);
+                goto error;
+        }
+        disk->hdr_bak_crc = crc32(crc_zero, disk->hdr_bak, gpt_header_size);
+        disk->pentry_arr = gpt_get_pentry_arr(disk->hdr, fd,
+                        disk->block_size);
         if (!disk->pentry_arr) {
                 ALOGE("%s: Failed to obtain partition entry array",
                                 __func__);
                 goto error;
         }
-        disk->pentry_arr_bak = gpt_get_pentry_arr(disk->hdr_bak, fd);
+        disk->pentry_arr_bak = gpt_get_pentry_arr(disk->hdr_bak, fd,
+                        disk->block_size);
         if (!disk->pentry_arr_bak) {
                 ALOGE("%s: Failed to obtain backup partition entry array",
                                 __func__);
@@ -1401,7 +1739,10 @@ int gpt_disk_get_disk_info(const char *dev, struct gpt_disk *dsk)
         disk->pentry_arr_crc = GET_4_BYTES(disk->hdr + PARTITION_CRC_OFFSET);
         disk->pentry_arr_bak_crc = GET_4_BYTES(disk->hdr_bak +
                         PARTITION_CRC_OFFSET);
-        disk->block_size = gpt_get_block_size(fd);
+        disk->pentry_arr_crc_base = gpt_get_crc_base(disk->hdr,
+                        disk->block_size, disk->pentry_arr, disk->pentry_arr_size);
+        disk->pentry_arr_bak_crc_base = gpt_get_crc_base(disk->hdr_bak,
+                        disk->block_size, disk->pentry_arr_bak, disk->pentry_arr_size);
         close(fd);
         disk->is_initialized = GPT_DISK_INIT_MAGIC;
         return 0;
@@ -1443,14 +1784,30 @@ int gpt_disk_update_crc(struct gpt_disk *disk)
                 ALOGE("%s: invalid argument", __func__);
                 goto error;
         }
-        //Recalculate the CRC of the primary partiton array
-        disk->pentry_arr_crc = crc32(crc_zero,
-                        disk->pentry_arr,
-                        disk->pentry_arr_size);
-        //Recalculate the CRC of the backup partition array
-        disk->pentry_arr_bak_crc = crc32(crc_zero,
-                        disk->pentry_arr_bak,
-                        disk->pentry_arr_size);
+        //Recalculate the CRC of the primary partiton array, from the
+        //entries changed since the last one where it can
+        disk->pentry_arr_crc = gpt_pentry_arr_crc(disk->pentry_arr,
+                        disk->pentry_arr_crc_base,
+                        disk->pentry_arr_size,
+                        disk->pentry_size,
+                        disk->pentry_arr_crc);
+        //Recalculate the CRC of the backup partition array. Without a
+        //base it is still normally a copy of the primary one, which a
+        //compare tells faster than a second CRC over the whole array would
+        if (disk->pentry_arr_bak_crc_base)
+                disk->pentry_arr_bak_crc = gpt_pentry_arr_crc(
+                                disk->pentry_arr_bak,
+                                disk->pentry_arr_bak_crc_base,
+                                disk->pentry_arr_size,
+                                disk->pentry_size,
+                                disk->pentry_arr_bak_crc);
+        else if (!memcmp(disk->pentry_arr_bak, disk->pentry_arr,
+                                disk->pentry_arr_size))
+                disk->pentry_arr_bak_crc = disk->pentry_arr_crc;
+        else
+                disk->pentry_arr_bak_crc = crc32(crc_zero,
+                                disk->pentry_arr_bak,
+                                disk->pentry_arr_size);
         //Update the partition CRC value in the primary GPT header
         PUT_4_BYTES(disk->hdr + PARTITION_CRC_OFFSET, disk->pentry_arr_crc);
         //Update the partition CRC value in the backup GPT header
@@ -1474,11 +1831,12 @@ error:
 int gpt_disk_commit(struct gpt_disk *disk)
 {
         int fd = -1;
+        int64_t disk_size = 0;
         if (!disk || (disk->is_initialized != GPT_DISK_INIT_MAGIC)){
                 ALOGE("%s: Invalid args", __func__);
                 goto error;
         }
-        fd = open(disk->devpath, O_RDWR | O_DSYNC);
+        fd = open(disk->devpath, O_RDWR);
         if (fd < 0) {
                 ALOGE("%s: Failed to open %s: %s",
                                 __func__,
@@ -1486,31 +1844,35 @@ int gpt_disk_commit(struct gpt_disk *disk)
                                 strerror(errno));
                 goto error;
         }
-        //Write the primary header
-        if(gpt_set_header(disk->hdr, fd, PRIMARY_GPT) != 0) {
-                ALOGE("%s: Failed to update primary GPT header",
+        disk_size = lseek64(fd, 0, SEEK_END);
+        //Write back the primary header and partition array
+        if (gpt_set_table(disk->hdr, disk->pentry_arr, fd, disk->block_size,
+                                gpt_get_header_offset(disk_size,
+                                        disk->block_size,
+                                        PRIMARY_GPT))) {
+                ALOGE("%s: Failed to update primary GPT",
                                 __func__);
                 goto error;
         }
-        //Write back the primary partition array
-        if (gpt_set_pentry_arr(disk->hdr, fd, disk->pentry_arr)) {
-                ALOGE("%s: Failed to write primary GPT partition arr",
-                                __func__);
-                goto error;
-        }
-        //Write back the secondary header
-        if(gpt_set_header(disk->hdr_bak, fd, SECONDARY_GPT) != 0) {
-                ALOGE("%s: Failed to update secondary GPT header",
-                                __func__);
+        //The primary table has to be on disk before the backup one is
+        //touched, so that one of the two is always intact
+        if (blk_flush(fd, 1)) {
+                ALOGE("%s: Failed to sync primary GPT: %s",
+                                __func__,
+                                strerror(errno));
                 goto error;
         }
-        //Write back the secondary partition array
-        if (gpt_set_pentry_arr(disk->hdr_bak, fd, disk->pentry_arr_bak)) {
-                ALOGE("%s: Failed to write secondary GPT partition arr",
+        //Write back the secondary header and partition array
+        if (gpt_set_table(disk->hdr_bak, disk->pentry_arr_bak, fd,
+                                disk->block_size,
+                                gpt_get_header_offset(disk_size,
+                                        disk->block_size,
+                                        SECONDARY_GPT))) {
+                ALOGE("%s: Failed to update secondary GPT",
                                 __func__);
                 goto error;
         }
-        fsync(fd);
+        blk_flush(fd, 0);
         close(fd);
         return 0;
 error:
@@ -128,6 +128,11 @@ struct gpt_disk {
 	uint32_t pentry_arr_crc;
 	//CRC of the backup partition entry array
 	uint32_t pentry_arr_bak_crc;
+	//The entry arrays as they were when the above CRCs were taken, or
+	//NULL if those CRCs are not known to be right. gpt_disk_update_crc
+	//only goes over the entries changed since.
+	uint8_t *pentry_arr_crc_base;
+	uint8_t *pentry_arr_bak_crc_base;
 	//Path to block dev representing the disk
 	char devpath[PATH_MAX];
 	//Block size of disk
@@ -187,6 +192,26 @@ int gpt_utils_set_xbl_boot_partition(enum boot_chain chain);
 //the passed in partiton names sits on that device.
 int gpt_utils_get_partition_map(std::vector<std::string>& partition_list,
                 std::map<std::string,std::vector<std::string>>& partition_map);
+
+//Block I/O done through gpt-utils since the last reset. These let the
+//update paths be measured, e.g. by a harness running them against image
+//files. reads/writes count syscalls, a vectored call counting once.
+struct gpt_io_stats {
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t flushes;
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+};
+void gpt_utils_get_io_stats(struct gpt_io_stats *stats);
+void gpt_utils_reset_io_stats();
+
+#ifdef GPT_UTILS_FAULT_INJECTION
+//Let only the next 'bytes' bytes of writes reach the disk and fail every
+//write after that with EIO, like a power cut in the middle of an update.
+//A negative value turns the limit off.
+void gpt_utils_set_write_budget(int64_t bytes);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -43,18 +43,29 @@
 #define UFS_ATTR_DATA_SIZE          32
 
 #ifdef _BSG_FRAMEWORK_KERNEL_HEADERS
+//The bsg node, its descriptor and the last boot LUN written through it
+//stay around for the life of the process, so switching the boot LUN
+//again (prepare_partitions does it once per LUN) costs at most one
+//ioctl and no directory scan, open or close.
+static int ufs_bsg_dev_found;
+//Last value written to bBootLunEn, -1 if unknown
+static int ufs_boot_lun_cache = -1;
+
 static int get_ufs_bsg_dev(void)
 {
     DIR *dir;
     struct dirent *ent;
     int ret = -ENODEV;
 
+    if (ufs_bsg_dev_found)
+        return 0;
     if ((dir = opendir ("/dev")) != NULL) {
         /* read all the files and directories within directory */
         while ((ent = readdir(dir)) != NULL) {
             if (!strcmp(ent->d_name, "ufs-bsg") ||
                     !strcmp(ent->d_name, "ufs-bsg0")) {
                 snprintf(ufs_bsg_dev, FNAME_SZ, "/dev/%s", ent->d_name);
+                ufs_bsg_dev_found = 1;
                 ret = 0;
                 break;
             }
@@ -75,7 +86,7 @@ int ufs_bsg_dev_open(void)
 {
     int ret;
     if (!fd_ufs_bsg) {
-        fd_ufs_bsg = open(ufs_bsg_dev, O_RDWR);
+        fd_ufs_bsg = open(ufs_bsg_dev, O_RDWR | O_CLOEXEC);
         ret = errno;
         if (fd_ufs_bsg < 0) {
             ALOGE("Unable to open %s (error no: %d)",
@@ -180,6 +191,11 @@ int32_t set_boot_lun(char *sg_dev __unused,uint8_t lun_id)
     int32_t ret;
     __u32 boot_lun_id  = lun_id;
 
+    if (ufs_boot_lun_cache == (int)boot_lun_id) {
+        ALOGV("Boot lun already set to %d\n", boot_lun_id);
+        return 0;
+    }
+
     ret = get_ufs_bsg_dev();
     if (ret)
         return ret;
@@ -197,7 +213,12 @@ int32_t set_boot_lun(char *sg_dev __unused,uint8_t lun_id)
                 QUERY_ATTR_IDN_BOOT_LU_EN, ret, errno);
         goto out;
     }
+    ufs_boot_lun_cache = boot_lun_id;
+    return 0;
 out:
+    //Start from a fresh node lookup and open next time
+    ufs_boot_lun_cache = -1;
+    ufs_bsg_dev_found = 0;
     ufs_bsg_dev_close();
     return ret;
 }
@@ -16,50 +16,76 @@
 
 #include "AntiFlicker.h"
 
-#include <android-base/file.h>
-#include <android-base/strings.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 namespace {
     constexpr const char *kFileDc = "/sys/devices/platform/soc/soc:qcom,dsi-display-primary/dsi_display_dc";
 };  // anonymous namespace
 
-using ::android::base::ReadFileToString;
-using ::android::base::Trim;
-using ::android::base::WriteStringToFile;
-
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
 namespace V2_1 {
 namespace implementation {
 
-AntiFlicker::AntiFlicker() {
-    if (!access(kFileDc, R_OK | W_OK)) {
-        file_ = kFileDc;
-        enabled_mode_ = 1;
-    } else {
-        file_ = nullptr;
-    }
+AntiFlicker::AntiFlicker() : enabled_mode_(1) {
+    // Kept open so that queries and toggles do not reopen the node
+    fd_.reset(TEMP_FAILURE_RETRY(open(kFileDc, O_RDWR | O_CLOEXEC)));
 }
 
 bool AntiFlicker::isSupported() {
-    return file_ != nullptr;
+    return fd_.ok();
 }
 
-// Methods from ::vendor::lineage::livedisplay::V2_1::IAntiFlicker follow.
-Return<bool> AntiFlicker::isEnabled() {
-    std::string tmp;
-    int32_t contents = 0;
+int32_t AntiFlicker::readState() {
+    char buf[16];
+    ssize_t len = TEMP_FAILURE_RETRY(pread(fd_.get(), buf, sizeof(buf) - 1, 0));
+
+    if (len <= 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+    return strtol(buf, nullptr, 10);
+}
+
+void AntiFlicker::refreshState() {
+    struct pollfd pfd = {fd_.get(), POLLPRI, 0};
 
-    if (ReadFileToString(file_, &tmp)) {
-        contents = std::stoi(Trim(tmp));
+    // A sysfs_notify() on the node raises POLLPRI until it is read again,
+    // so the cached state only has to be dropped when the kernel says so.
+    if (state_ < 0 || (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR)))) {
+        state_ = readState();
     }
+}
+
+// Methods from ::vendor::lineage::livedisplay::V2_1::IAntiFlicker follow.
+Return<bool> AntiFlicker::isEnabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    return contents > 0;
+    refreshState();
+    return state_ > 0;
 }
 
 Return<bool> AntiFlicker::setEnabled(bool enabled) {
-    return WriteStringToFile(enabled ? std::to_string(enabled_mode_) : "0", file_, true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    int32_t mode = enabled ? enabled_mode_ : 0;
+
+    refreshState();
+    if (state_ == mode) {
+        return true;
+    }
+
+    std::string value = std::to_string(mode);
+    if (TEMP_FAILURE_RETRY(pwrite(fd_.get(), value.c_str(), value.size(), 0)) !=
+        static_cast<ssize_t>(value.size())) {
+        state_ = -1;
+        return false;
+    }
+    state_ = mode;
+    return true;
 }
 
 }  // namespace implementation
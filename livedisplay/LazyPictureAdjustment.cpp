@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2022 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LazyPictureAdjustment.h"
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_1 {
+namespace implementation {
+
+using ::vendor::lineage::livedisplay::V2_0::sdm::SDMController;
+
+const sp<V2_0::sdm::PictureAdjustment>& LazyPictureAdjustment::get() {
+    std::call_once(once_, [this] {
+        pa_ = new V2_0::sdm::PictureAdjustment(std::make_shared<SDMController>());
+    });
+    return pa_;
+}
+
+Return<void> LazyPictureAdjustment::getHueRange(getHueRange_cb _hidl_cb) {
+    return get()->getHueRange(_hidl_cb);
+}
+
+Return<void> LazyPictureAdjustment::getSaturationRange(getSaturationRange_cb _hidl_cb) {
+    return get()->getSaturationRange(_hidl_cb);
+}
+
+Return<void> LazyPictureAdjustment::getIntensityRange(getIntensityRange_cb _hidl_cb) {
+    return get()->getIntensityRange(_hidl_cb);
+}
+
+Return<void> LazyPictureAdjustment::getContrastRange(getContrastRange_cb _hidl_cb) {
+    return get()->getContrastRange(_hidl_cb);
+}
+
+Return<void> LazyPictureAdjustment::getSaturationThresholdRange(
+        getSaturationThresholdRange_cb _hidl_cb) {
+    return get()->getSaturationThresholdRange(_hidl_cb);
+}
+
+Return<void> LazyPictureAdjustment::getPictureAdjustment(getPictureAdjustment_cb _hidl_cb) {
+    return get()->getPictureAdjustment(_hidl_cb);
+}
+
+Return<void> LazyPictureAdjustment::getDefaultPictureAdjustment(
+        getDefaultPictureAdjustment_cb _hidl_cb) {
+    return get()->getDefaultPictureAdjustment(_hidl_cb);
+}
+
+Return<bool> LazyPictureAdjustment::setPictureAdjustment(const HSIC& hsic) {
+    return get()->setPictureAdjustment(hsic);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2022 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "vendor.lineage.livedisplay@2.1-service.motorola_lahaina"
+
+#include "SunlightAutoMode.h"
+
+#include <android-base/logging.h>
+#include <android/looper.h>
+#include <android/sensor.h>
+#include <utils/SystemClock.h>
+
+namespace {
+    constexpr float kEnterLux = 20000.0f;
+    constexpr float kExitLux = 5000.0f;
+    constexpr int64_t kMinSwitchIntervalNs = 10000000000LL;  // 10 s
+
+    // The sensor is sampled once a second and delivered in batches
+    constexpr int32_t kSamplingPeriodUs = 1000000;
+    constexpr int64_t kMaxReportLatencyUs = 3000000;
+
+    constexpr int kLooperId = 1;
+    constexpr size_t kMaxEvents = 16;
+};  // anonymous namespace
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_1 {
+namespace implementation {
+
+SunlightAutoMode::SunlightAutoMode(const sp<SunlightEnhancement>& se) : se_(se) {}
+
+void SunlightAutoMode::start() {
+    enabled_ = se_->isEnabled();
+    thread_ = std::thread(&SunlightAutoMode::run, this);
+    thread_.detach();
+}
+
+int SunlightAutoMode::update(int64_t now) {
+    if (!has_lux_) {
+        return -1;
+    }
+
+    bool enable = enabled_ ? lux_ > kExitLux : lux_ >= kEnterLux;
+    if (enable == enabled_) {
+        return -1;
+    }
+
+    int64_t wait = last_switch_ns_ + kMinSwitchIntervalNs - now;
+    if (last_switch_ns_ != 0 && wait > 0) {
+        return wait / 1000000 + 1;
+    }
+
+    if (se_->setEnabled(enable)) {
+        enabled_ = enable;
+    } else {
+        LOG(ERROR) << "Failed to " << (enable ? "enable" : "disable") << " sunlight enhancement";
+    }
+    // A failed write is retried no sooner than a successful switch
+    last_switch_ns_ = now;
+    return -1;
+}
+
+void SunlightAutoMode::run() {
+    ASensorManager* manager = ASensorManager_getInstanceForPackage("");
+    if (manager == nullptr) {
+        LOG(ERROR) << "Could not get the sensor manager";
+        return;
+    }
+
+    const ASensor* sensor = ASensorManager_getDefaultSensor(manager, ASENSOR_TYPE_LIGHT);
+    if (sensor == nullptr) {
+        LOG(ERROR) << "No light sensor, automatic sunlight enhancement disabled";
+        return;
+    }
+
+    ALooper* looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+    ASensorEventQueue* queue =
+            ASensorManager_createEventQueue(manager, looper, kLooperId, nullptr, nullptr);
+    if (queue == nullptr) {
+        LOG(ERROR) << "Could not create the light sensor event queue";
+        return;
+    }
+
+    if (ASensorEventQueue_registerSensor(queue, sensor, kSamplingPeriodUs, kMaxReportLatencyUs) <
+        0) {
+        LOG(ERROR) << "Could not register for light sensor events";
+        ASensorManager_destroyEventQueue(manager, queue);
+        return;
+    }
+
+    ASensorEvent events[kMaxEvents];
+    int timeout = -1;
+    for (;;) {
+        int id = ALooper_pollOnce(timeout, nullptr, nullptr, nullptr);
+        if (id == ALOOPER_POLL_ERROR) {
+            LOG(ERROR) << "Light sensor looper failed, automatic sunlight enhancement stopped";
+            break;
+        }
+
+        if (id == kLooperId) {
+            // Only the latest reading of a batch matters
+            ssize_t count;
+            while ((count = ASensorEventQueue_getEvents(queue, events, kMaxEvents)) > 0) {
+                for (ssize_t i = 0; i < count; i++) {
+                    if (events[i].type == ASENSOR_TYPE_LIGHT) {
+                        lux_ = events[i].light;
+                        has_lux_ = true;
+                    }
+                }
+            }
+        }
+
+        // The light sensor only reports changes, so a change held back by
+        // the rate limit is applied on a timeout rather than the next event
+        timeout = update(android::elapsedRealtimeNano());
+    }
+
+    ASensorManager_destroyEventQueue(manager, queue);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
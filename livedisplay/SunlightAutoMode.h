@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <thread>
+
+#include "SunlightEnhancement.h"
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_1 {
+namespace implementation {
+
+using ::android::sp;
+
+// Turns sunlight enhancement on and off from the ambient light sensor.
+// Bright light has to go above kEnterLux to turn it on and below
+// kExitLux to turn it off again, and the state changes at most once per
+// kMinSwitchInterval, so the HBM node is only written on real transitions.
+class SunlightAutoMode {
+  public:
+    explicit SunlightAutoMode(const sp<SunlightEnhancement>& se);
+
+    // Starts following the light sensor on a thread of its own
+    void start();
+
+  private:
+    void run();
+    // Applies the last lux reading, returns how long to wait in ms before
+    // a pending change may be applied, or -1 if none is pending
+    int update(int64_t now);
+
+    sp<SunlightEnhancement> se_;
+    std::thread thread_;
+
+    bool has_lux_ = false;
+    float lux_ = 0.0f;
+    bool enabled_ = false;
+    int64_t last_switch_ns_ = 0;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
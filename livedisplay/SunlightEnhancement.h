@@ -16,8 +16,11 @@
 
 #pragma once
 
+#include <android-base/unique_fd.h>
 #include <vendor/lineage/livedisplay/2.1/ISunlightEnhancement.h>
 
+#include <mutex>
+
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
@@ -36,8 +39,15 @@ class SunlightEnhancement : public ISunlightEnhancement {
     Return<bool> setEnabled(bool enabled) override;
 
   private:
-    const char* file_;
+    int32_t readState();
+    void refreshState();
+
+    android::base::unique_fd fd_;
     int32_t enabled_mode_;
+
+    std::mutex mutex_;
+    // Last value read from or written to the node, -1 if unknown
+    int32_t state_ = -1;
 };
 
 }  // namespace implementation
@@ -17,41 +17,61 @@
 #define LOG_TAG "vendor.lineage.livedisplay@2.1-service.motorola_lahaina"
 
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include <binder/ProcessState.h>
+#include <hidl/HidlLazyUtils.h>
 #include <hidl/HidlTransportSupport.h>
-#include <livedisplay/sdm/PictureAdjustment.h>
-#include <vendor/lineage/livedisplay/2.1/IPictureAdjustment.h>
 #include "AntiFlicker.h"
+#include "LazyPictureAdjustment.h"
+#include "SunlightAutoMode.h"
 #include "SunlightEnhancement.h"
 
 using ::android::OK;
+using ::android::base::GetBoolProperty;
 using ::android::sp;
 using ::android::status_t;
 using ::android::hardware::configureRpcThreadpool;
 using ::android::hardware::joinRpcThreadpool;
+using ::android::hardware::LazyServiceRegistrar;
 
-using ::vendor::lineage::livedisplay::V2_0::sdm::PictureAdjustment;
-using ::vendor::lineage::livedisplay::V2_0::sdm::SDMController;
-using ::vendor::lineage::livedisplay::V2_1::IPictureAdjustment;
 using ::vendor::lineage::livedisplay::V2_1::implementation::AntiFlicker;
+using ::vendor::lineage::livedisplay::V2_1::implementation::LazyPictureAdjustment;
+using ::vendor::lineage::livedisplay::V2_1::implementation::SunlightAutoMode;
 using ::vendor::lineage::livedisplay::V2_1::implementation::SunlightEnhancement;
 
+// The service is started on demand and exits once it has no clients,
+// unless the automatic sunlight mode has to keep running in it
+template <typename T>
+status_t RegisterService(const sp<T>& service, bool persistent) {
+    if (persistent) {
+        return service->registerAsService();
+    }
+    return LazyServiceRegistrar::getInstance().registerService(service);
+}
+
 status_t RegisterAsServices() {
     status_t status = OK;
+    bool autoMode = GetBoolProperty("persist.vendor.livedisplay.sunlight_auto", false);
 
     sp<SunlightEnhancement> se = new SunlightEnhancement();
     if (se->isSupported()) {
-        status = se->registerAsService();
+        status = RegisterService(se, autoMode);
         if (status != OK) {
             LOG(ERROR) << "Could not register service for LiveDisplay HAL SunlightEnhancement Iface"
                        << " (" << status << ")";
             return status;
         }
+
+        if (autoMode) {
+            // Runs for the life of the service
+            SunlightAutoMode* sunlightAutoMode = new SunlightAutoMode(se);
+            sunlightAutoMode->start();
+        }
     }
-	
-	sp<AntiFlicker> af = new AntiFlicker();
+
+    sp<AntiFlicker> af = new AntiFlicker();
     if (af->isSupported()) {
-        status = af->registerAsService();
+        status = RegisterService(af, autoMode);
         if (status != OK) {
             LOG(ERROR) << "Could not register service for LiveDisplay HAL AntiFlicker Iface"
                        << " (" << status << ")";
@@ -59,9 +79,9 @@ status_t RegisterAsServices() {
         }
     }
 
-    std::shared_ptr<SDMController> controller = std::make_shared<SDMController>();
-    sp<PictureAdjustment> pa = new PictureAdjustment(controller);
-	status = pa->registerAsService();
+    // The SDM library is only loaded once picture adjustment is used
+    sp<LazyPictureAdjustment> pa = new LazyPictureAdjustment();
+    status = RegisterService(pa, autoMode);
     if (status != OK) {
         LOG(ERROR) << "Could not register service for LiveDisplay HAL PictureAdjustment Iface ("
                    << status << ")";
@@ -33,6 +33,9 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 // DEPRECATION - BACKWARD COMPATIBILITY SECTION
 #define GnssLocationPosTechMask LocationTechnologyMask
@@ -1216,6 +1219,37 @@ struct GnssSv {
     string toString() const;
 };
 
+/** GNSS SV report that comes when clients registers for
+ *  location_client::GnssSvsCb, laid out as one array per field of
+ *  GnssSv. <br/>
+ *  Element i of each array belongs to the same SV, and the fields
+ *  have the meaning and validity of the GnssSv fields of the same
+ *  name. Code scanning a few fields over all SVs, e.g.: C/N0 and
+ *  the used in fix bit, reads only the arrays of those fields.
+ *  <br/> */
+struct GnssSvs {
+    std::vector<uint16_t> svId;
+    std::vector<GnssSvType> type;
+    std::vector<float> cN0Dbhz;
+    std::vector<float> elevation;
+    std::vector<float> azimuth;
+    std::vector<GnssSvOptionsMask> gnssSvOptionsMask;
+    std::vector<float> carrierFrequencyHz;
+    std::vector<GnssSignalTypeMask> gnssSignalTypeMask;
+    std::vector<double> basebandCarrierToNoiseDbHz;
+    std::vector<uint16_t> gloFrequency;
+
+    /** Number of SVs in the report. <br/> */
+    inline size_t size() const { return svId.size(); }
+    /** Empties all arrays, keeping their capacity. <br/> */
+    void clear();
+    /** Appends the fields of gnssSv to the arrays. <br/> */
+    void push_back(const GnssSv& gnssSv);
+    /** Method to print the struct to human readable form, for logging.
+     *  <br/> */
+    string toString() const;
+};
+
 /** Specify the GNSS signal type and RF band for jammer info and
 - *  automatic gain control metric in GnssData. <br/>
 - *  To find out the jammer info and automatic gain control
@@ -1800,6 +1834,18 @@ typedef std::function<void(
     const std::vector<GnssSv>& gnssSvs
 )> GnssSvCb;
 
+/** @brief
+    GnssSvsCb is for receiving the same GNSS SV report as GnssSvCb,
+    in a GnssSvs. <br/>
+    The report is only valid for the duration of the callback; its
+    arrays are reused for the following reports. <br/>
+
+    @param gnssSvs: GNSS SV report. <br/>
+*/
+typedef std::function<void(
+    const GnssSvs& gnssSvs
+)> GnssSvsCb;
+
 /** @brief
     GnssNmeaCb is for receiving NMEA sentences when
     LocationClientApi is in a positioning session. <br/>
@@ -1907,6 +1953,9 @@ struct GnssReportCbs {
     GnssDataCb gnssDataCallback;
     /** Callback to receive GnssMeasurements modem GNSS engine. <br/>  */
     GnssMeasurementsCb gnssMeasurementsCallback;
+    /** Callback to receive the GnssSv report of gnssSvCallback as
+     *  GnssSvs. Either or both can be set. <br/> */
+    GnssSvsCb gnssSvsCallback;
 };
 
 /** Specify the set of callbacks to receive the reports when
@@ -1935,6 +1984,9 @@ struct EngineReportCbs {
     /** Callback to receive GnssMeasurements from modem GNSS engine.
      *  <br/> */
     GnssMeasurementsCb gnssMeasurementsCallback;
+    /** Callback to receive the GnssSv report of gnssSvCallback as
+     *  GnssSvs. Either or both can be set. <br/> */
+    GnssSvsCb gnssSvsCallback;
 };
 
 /**
@@ -1973,6 +2025,162 @@ typedef std::function<void(
     const GnssEnergyConsumedInfo& gnssEneryConsumed
 )> GnssEnergyConsumedCb;
 
+/** Specify where LocationClientApi invokes the callbacks of the
+ *  app. <br/>   */
+enum CallbackExecutorType {
+    /** Callbacks are invoked on the internal thread that also
+     *  decodes the reports from the location hal daemon. A slow
+     *  callback delays the reports that follow it. <br/> */
+    CALLBACK_EXECUTOR_INLINE = 0,
+    /** Callbacks are invoked on a thread of their own, created
+     *  along with the LocationClientApi object. <br/> */
+    CALLBACK_EXECUTOR_THREAD,
+    /** Callbacks are handed to CallbackExecutor::userQueue, to be
+     *  run on a thread of the app's choosing. <br/> */
+    CALLBACK_EXECUTOR_USER_QUEUE,
+};
+
+/** @brief Queue of the app that callbacks are handed to under
+           CALLBACK_EXECUTOR_USER_QUEUE. <br/>
+
+    @param callback: to be invoked once, on any thread of the app,
+                   but never concurrently with another callback of
+                   the same LocationClientApi object. <br/>
+*/
+typedef std::function<void(
+    std::function<void()> callback
+)> CallbackQueueCb;
+
+/** Specify the executor of the callbacks, when creating
+ *  LocationClientApi with
+ *  LocationClientApi(CapabilitiesCb, const CallbackExecutor&).
+ *  <br/>
+ *  With CALLBACK_EXECUTOR_THREAD and CALLBACK_EXECUTOR_USER_QUEUE,
+ *  at most maxPending callbacks are handed off and not yet run. A
+ *  position callback (LocationCb, GnssLocationCb,
+ *  EngineLocationsCb) replaces the one of its kind still pending,
+ *  so a slow app sees the latest position rather than a backlog.
+ *  Any other callback waits for room once maxPending is reached.
+ *  <br/>   */
+struct CallbackExecutor {
+    /** Where the callbacks are invoked. <br/> */
+    CallbackExecutorType type;
+    /** Most callbacks handed off and not yet run, 0 for the
+     *  default of 32. <br/> */
+    uint32_t maxPending;
+    /** Queue of the app, required with
+     *  CALLBACK_EXECUTOR_USER_QUEUE. <br/> */
+    CallbackQueueCb userQueue;
+
+    inline CallbackExecutor() :
+            type(CALLBACK_EXECUTOR_INLINE), maxPending(0), userQueue(nullptr) {}
+};
+
+/** @brief Result of a LocationClientApi call that is to come,
+           in place of its ResponseCb or CollectiveResponseCb.
+           <br/>
+
+    Copies share the same result. A result is set once, the
+    first response of the call wins. If the call is replaced
+    before it is answered, e.g. by another call of the same
+    kind, it completes with failure rather than never. <br/>
+
+    get() and waitFor() block, so they must not be called from
+    a callback of the LocationClientApi object under
+    CALLBACK_EXECUTOR_INLINE, which would wait on itself. <br/>
+*/
+template <typename T>
+class LocationFuture {
+public:
+    inline LocationFuture() : mState(std::make_shared<State>()) {}
+
+    /** True once the result is set. <br/> */
+    inline bool isReady() const {
+        std::lock_guard<std::mutex> lock(mState->mLock);
+        return mState->mReady;
+    }
+
+    /** Blocks until the result is set and returns it. <br/> */
+    inline const T& get() const {
+        std::unique_lock<std::mutex> lock(mState->mLock);
+        mState->mCond.wait(lock, [this] { return mState->mReady; });
+        return mState->mValue;
+    }
+
+    /** Blocks until the result is set or timeoutMs passes.
+        @return True if the result is set. <br/> */
+    inline bool waitFor(uint32_t timeoutMs) const {
+        std::unique_lock<std::mutex> lock(mState->mLock);
+        return mState->mCond.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                      [this] { return mState->mReady; });
+    }
+
+    /** Invokes continuation with the result, right away if it is
+        set already, else where the ResponseCb of the call would
+        have been invoked. Any number of continuations may be
+        added. <br/> */
+    inline const LocationFuture& then(std::function<void(const T&)> continuation) const {
+        std::unique_lock<std::mutex> lock(mState->mLock);
+        if (!mState->mReady) {
+            mState->mContinuations.push_back(std::move(continuation));
+            return *this;
+        }
+        lock.unlock();
+        continuation(mState->mValue);
+        return *this;
+    }
+
+    /** Sets the result, if not set yet. <br/> */
+    inline void complete(const T& value) const {
+        std::vector<std::function<void(const T&)>> continuations;
+        {
+            std::lock_guard<std::mutex> lock(mState->mLock);
+            if (mState->mReady) {
+                return;
+            }
+            mState->mValue = value;
+            mState->mReady = true;
+            continuations.swap(mState->mContinuations);
+        }
+        mState->mCond.notify_all();
+        for (auto& continuation : continuations) {
+            continuation(mState->mValue);
+        }
+    }
+
+    /** Callback that sets the result to what it is invoked with.
+        Once the callback and all its copies are gone without it
+        being invoked, the result is set to dropped. <br/> */
+    inline std::function<void(const T&)> completer(const T& dropped) const {
+        struct Guard {
+            LocationFuture mFuture;
+            T mDropped;
+            ~Guard() { mFuture.complete(mDropped); }
+        };
+        std::shared_ptr<Guard> guard(new Guard{*this, dropped});
+        return [guard](const T& value) { guard->mFuture.complete(value); };
+    }
+
+private:
+    struct State {
+        std::mutex mLock;
+        std::condition_variable mCond;
+        bool mReady = false;
+        T mValue{};
+        std::vector<std::function<void(const T&)>> mContinuations;
+    };
+    std::shared_ptr<State> mState;
+};
+
+/** Result of a LocationClientApi call that reports a single
+ *  LocationResponse. <br/>   */
+typedef LocationFuture<LocationResponse> LocationResponseFuture;
+
+/** Result of a LocationClientApi call that reports a
+ *  LocationResponse per geofence. <br/>   */
+typedef LocationFuture<std::vector<std::pair<Geofence, LocationResponse>>>
+        CollectiveResponseFuture;
+
 class LocationClientApiImpl;
 class LocationClientApi
 {
@@ -1991,6 +2199,22 @@ public:
     */
     LocationClientApi(CapabilitiesCb capsCallback);
 
+    /** @brief
+        Creates an instance of LocationClientApi object, whose
+        callbacks are invoked by the given executor. <br/>
+
+        @param
+        capsCallback: same as in LocationClientApi(CapabilitiesCb).
+                      <br/>
+
+        @param
+        executor: where and how the callbacks of this object are
+                  invoked. If CALLBACK_EXECUTOR_USER_QUEUE is asked
+                  for without a userQueue, callbacks are invoked
+                  inline. <br/>
+    */
+    LocationClientApi(CapabilitiesCb capsCallback, const CallbackExecutor& executor);
+
     /** @brief Default destructor */
     virtual ~LocationClientApi();
 
@@ -2189,6 +2413,25 @@ public:
                               const EngineReportCbs& engReportCallbacks,
                               ResponseCb responseCallback);
 
+    /** @brief
+        Same as the startPositionSession calls above, with the
+        processing status delivered through the returned future
+        in place of ResponseCb, so several calls can be made back
+        to back and their results waited for together. <br/>
+
+        @return Future of the processing status. If no session is
+                started, it is LOCATION_RESPONSE_PARAM_INVALID
+                right away. <br/>
+    */
+    LocationResponseFuture startPositionSession(uint32_t intervalInMs,
+                                                uint32_t distanceInMeters,
+                                                LocationCb locationCallback);
+    LocationResponseFuture startPositionSession(uint32_t intervalInMs,
+                                                const GnssReportCbs& gnssReportCallbacks);
+    LocationResponseFuture startPositionSession(uint32_t intervalInMs,
+                                                LocReqEngineTypeMask locReqEngMask,
+                                                const EngineReportCbs& engReportCallbacks);
+
     /** @brief Stop the ongoing positioning session and
      *  de-register the callbacks of previous startPositionSession.
      *  No callback will be issued regarding the procesing status.
@@ -2407,6 +2650,19 @@ public:
     */
     bool startRoutineBatchingSession(uint32_t minInterval, uint32_t minDistance,
                                      BatchingCb batchingCallback, ResponseCb responseCallback);
+
+    /** @brief Same as the batching session calls above, with the
+        processing status delivered through the returned future.
+        @return Future of the processing status. If no session is
+                started, it is LOCATION_RESPONSE_PARAM_INVALID
+                right away.
+    */
+    LocationResponseFuture startTripBatchingSession(uint32_t minInterval,
+                                                    uint32_t tripDistance,
+                                                    BatchingCb batchingCallback);
+    LocationResponseFuture startRoutineBatchingSession(uint32_t minInterval,
+                                                       uint32_t minDistance,
+                                                       BatchingCb batchingCallback);
     /** @brief Stops the batching session.
     */
     void stopBatchingSession();
@@ -2448,6 +2704,14 @@ public:
     void addGeofences(std::vector<Geofence>& geofences, GeofenceBreachCb gfBreachCb,
                       CollectiveResponseCb responseCallback);
 
+    /** @brief Same as addGeofences above, with the responses
+        delivered through the returned future.
+        @return Future of the responses, which are empty if no
+        geofence is added.
+    */
+    CollectiveResponseFuture addGeofences(std::vector<Geofence>& geofences,
+                                          GeofenceBreachCb gfBreachCb);
+
     /** @brief Removes any number of geofences.
         @param geofences
         Geofence objects, must be originally added to the system. Otherwise it would be no op.
@@ -2546,6 +2810,12 @@ public:
     void getGnssEnergyConsumed(GnssEnergyConsumedCb gnssEnergyConsumedCallback,
                                ResponseCb responseCallback);
 
+    /** @brief Same as getGnssEnergyConsumed above, with the
+        processing status delivered through the returned future.
+        <br/> */
+    LocationResponseFuture getGnssEnergyConsumed(
+            GnssEnergyConsumedCb gnssEnergyConsumedCallback);
+
     /** @brief
         Register/update listener to receive location system info
         that are not tied with positioning session, e.g.: next leap
@@ -26,6 +26,24 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "LCAReportLoggerUtil.h"
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+
+// reports queued for the diag library when logging is async
+#define LCA_REPORT_LOG_RING_SIZE  (64)
+// most reports handed to the diag library per wake up
+#define LCA_REPORT_LOG_BATCH_SIZE (16)
+// nice value of the async logging thread
+#define LCA_REPORT_LOG_NICE       (10)
+
+static uint32_t gLcaReportLogAsync = 0;
+static const loc_param_s_type gLoggerConfigTable[] =
+{
+    {"LCA_REPORT_LOG_ASYNC", &gLcaReportLogAsync, NULL, 'n'}
+};
 
 namespace location_client {
 
@@ -33,7 +51,8 @@ LCAReportLoggerUtil::LCAReportLoggerUtil():
         mLogLocation(nullptr),
         mLogSv(nullptr),
         mLogNmea(nullptr),
-        mLogMeas(nullptr) {
+        mLogMeas(nullptr),
+        mLogTask(nullptr) {
     const char* libname = "liblocdiagiface.so";
     void* libHandle = nullptr;
     mLogLocation = (LogGnssLocation)dlGetSymFromLib(
@@ -44,31 +63,74 @@ LCAReportLoggerUtil::LCAReportLoggerUtil():
             libHandle, libname, "LogGnssNmea");
     mLogMeas = (LogGnssMeas)dlGetSymFromLib(
             libHandle, libname, "LogGnssMeas");
+
+    if (nullptr == libHandle) {
+        return;
+    }
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, gLoggerConfigTable);
+    if (0 != gLcaReportLogAsync) {
+        mLogTask.reset(new MsgTask("LCAReportLogger", LCA_REPORT_LOG_RING_SIZE,
+                                   MSG_TASK_OVERFLOW_DROP));
+        mLogTask->setBatchDrain(LCA_REPORT_LOG_BATCH_SIZE);
+        // logging must not compete with app callbacks and ipc decoding
+        mLogTask->sendMsg([] {
+            if (0 != setpriority(PRIO_PROCESS, syscall(SYS_gettid), LCA_REPORT_LOG_NICE)) {
+                LOC_LOGw("setpriority failed %s", strerror(errno));
+            }
+        });
+        LOC_LOGd("async report logging");
+    }
 }
 
 void LCAReportLoggerUtil::log(const GnssLocation& gnssLocation,
             const LocationCapabilitiesMask& capMask) {
     if (mLogLocation != nullptr) {
-        mLogLocation(gnssLocation, capMask);
+        if (nullptr != mLogTask) {
+            LogGnssLocation logLocation = mLogLocation;
+            LocationCapabilitiesMask caps = capMask;
+            mLogTask->sendMsg([logLocation, gnssLocation, caps] {
+                logLocation(gnssLocation, caps);
+            });
+        } else {
+            mLogLocation(gnssLocation, capMask);
+        }
     }
 }
 
 void LCAReportLoggerUtil::log(const std::vector<GnssSv>& gnssSvsVector) {
     if (mLogSv != nullptr) {
-        mLogSv(gnssSvsVector);
+        if (nullptr != mLogTask) {
+            LogGnssSv logSv = mLogSv;
+            mLogTask->sendMsg([logSv, gnssSvsVector] { logSv(gnssSvsVector); });
+        } else {
+            mLogSv(gnssSvsVector);
+        }
     }
 }
 
 void LCAReportLoggerUtil::log(
         uint64_t timestamp, uint32_t length, const char* nmea) {
     if (mLogNmea != nullptr) {
-        mLogNmea(timestamp, length, nmea);
+        if (nullptr != mLogTask) {
+            LogGnssNmea logNmea = mLogNmea;
+            std::string nmeaCopy(nmea, length);
+            mLogTask->sendMsg([logNmea, timestamp, nmeaCopy] {
+                logNmea(timestamp, nmeaCopy.size(), nmeaCopy.c_str());
+            });
+        } else {
+            mLogNmea(timestamp, length, nmea);
+        }
     }
 }
 
 void LCAReportLoggerUtil::log(const GnssMeasurements& gnssMeasurements) {
     if (mLogMeas != nullptr) {
-        mLogMeas(gnssMeasurements);
+        if (nullptr != mLogTask) {
+            LogGnssMeas logMeas = mLogMeas;
+            mLogTask->sendMsg([logMeas, gnssMeasurements] { logMeas(gnssMeasurements); });
+        } else {
+            mLogMeas(gnssMeasurements);
+        }
     }
 }
 }
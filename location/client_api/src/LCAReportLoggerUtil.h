@@ -31,6 +31,8 @@
 #include "LocLoggerBase.h"
 #include "LocationClientApi.h"
 #include <loc_misc_utils.h>
+#include <MsgTask.h>
+#include <memory>
 
 using namespace loc_util;
 
@@ -45,15 +47,22 @@ public:
     typedef void (*LogGnssMeas)(const GnssMeasurements& gnssMeasurements);
 
     LCAReportLoggerUtil();
+    // With LCA_REPORT_LOG_ASYNC set in gps.conf, each log() only copies the
+    // report into a bounded ring; a low priority thread hands the reports
+    // to the diag library in batches. Reports are dropped if the ring is full.
     void log(const GnssLocation& gnssLocation, const LocationCapabilitiesMask& capMask);
     void log(const std::vector<GnssSv>& gnssSvsVector);
     void log(uint64_t timestamp, uint32_t length, const char* nmea);
     void log(const GnssMeasurements& gnssMeasurements);
+    // whether SV reports are logged, so they need not be converted otherwise
+    inline bool logsSv() const { return mLogSv != nullptr; }
 private:
     LogGnssLocation mLogLocation;
     LogGnssSv mLogSv;
     LogGnssNmea mLogNmea;
     LogGnssMeas mLogMeas;
+    // nullptr unless logging is async
+    std::unique_ptr<MsgTask> mLogTask;
 };
 
 
@@ -54,6 +54,11 @@ LocationClientApi::LocationClientApi(CapabilitiesCb capabitiescb) :
         mApiImpl(new LocationClientApiImpl(capabitiescb)) {
 }
 
+LocationClientApi::LocationClientApi(CapabilitiesCb capabitiescb,
+                                     const CallbackExecutor& executor) :
+        mApiImpl(new LocationClientApiImpl(capabitiescb, executor)) {
+}
+
 LocationClientApi::~LocationClientApi() {
     if (mApiImpl) {
         // two steps processes due to asynchronous message processing
@@ -135,7 +140,7 @@ bool LocationClientApi::startPositionSession(
     if (gnssReportCallbacks.gnssLocationCallback) {
         callbacksOption.gnssLocationInfoCb = [](::GnssLocationInfoNotification n) {};
     }
-    if (gnssReportCallbacks.gnssSvCallback) {
+    if (gnssReportCallbacks.gnssSvCallback || gnssReportCallbacks.gnssSvsCallback) {
         callbacksOption.gnssSvCb = [](::GnssSvNotification n) {};
     }
     if (gnssReportCallbacks.gnssNmeaCallback) {
@@ -187,7 +192,7 @@ bool LocationClientApi::startPositionSession(
         callbacksOption.engineLocationsInfoCb =
                 [](uint32_t count, ::GnssLocationInfoNotification* locArr) {};
     }
-    if (engReportCallbacks.gnssSvCallback) {
+    if (engReportCallbacks.gnssSvCallback || engReportCallbacks.gnssSvsCallback) {
         callbacksOption.gnssSvCb = [](::GnssSvNotification n) {};
     }
     if (engReportCallbacks.gnssNmeaCallback) {
@@ -214,6 +219,45 @@ bool LocationClientApi::startPositionSession(
     return true;
 }
 
+LocationResponseFuture LocationClientApi::startPositionSession(
+        uint32_t intervalInMs,
+        uint32_t distanceInMeters,
+        LocationCb locationCallback) {
+    LocationResponseFuture future;
+    // the callback has to outlive a failed call, else the future
+    // completes as dropped before it can take PARAM_INVALID
+    ResponseCb responseCallback = future.completer(LOCATION_RESPONSE_UNKOWN_FAILURE);
+    if (!startPositionSession(intervalInMs, distanceInMeters, locationCallback,
+                              responseCallback)) {
+        future.complete(LOCATION_RESPONSE_PARAM_INVALID);
+    }
+    return future;
+}
+
+LocationResponseFuture LocationClientApi::startPositionSession(
+        uint32_t intervalInMs,
+        const GnssReportCbs& gnssReportCallbacks) {
+    LocationResponseFuture future;
+    ResponseCb responseCallback = future.completer(LOCATION_RESPONSE_UNKOWN_FAILURE);
+    if (!startPositionSession(intervalInMs, gnssReportCallbacks, responseCallback)) {
+        future.complete(LOCATION_RESPONSE_PARAM_INVALID);
+    }
+    return future;
+}
+
+LocationResponseFuture LocationClientApi::startPositionSession(
+        uint32_t intervalInMs,
+        LocReqEngineTypeMask locEngReqMask,
+        const EngineReportCbs& engReportCallbacks) {
+    LocationResponseFuture future;
+    ResponseCb responseCallback = future.completer(LOCATION_RESPONSE_UNKOWN_FAILURE);
+    if (!startPositionSession(intervalInMs, locEngReqMask, engReportCallbacks,
+                              responseCallback)) {
+        future.complete(LOCATION_RESPONSE_PARAM_INVALID);
+    }
+    return future;
+}
+
 void LocationClientApi::stopPositionSession() {
     if (mApiImpl) {
         mApiImpl->stopTracking(0);
@@ -300,6 +344,28 @@ bool LocationClientApi::startRoutineBatchingSession(uint32_t minInterval, uint32
     return true;
 }
 
+LocationResponseFuture LocationClientApi::startTripBatchingSession(uint32_t minInterval,
+        uint32_t tripDistance, BatchingCb batchingCallback) {
+    LocationResponseFuture future;
+    ResponseCb responseCallback = future.completer(LOCATION_RESPONSE_UNKOWN_FAILURE);
+    if (!startTripBatchingSession(minInterval, tripDistance, batchingCallback,
+                                  responseCallback)) {
+        future.complete(LOCATION_RESPONSE_PARAM_INVALID);
+    }
+    return future;
+}
+
+LocationResponseFuture LocationClientApi::startRoutineBatchingSession(uint32_t minInterval,
+        uint32_t minDistance, BatchingCb batchingCallback) {
+    LocationResponseFuture future;
+    ResponseCb responseCallback = future.completer(LOCATION_RESPONSE_UNKOWN_FAILURE);
+    if (!startRoutineBatchingSession(minInterval, minDistance, batchingCallback,
+                                     responseCallback)) {
+        future.complete(LOCATION_RESPONSE_PARAM_INVALID);
+    }
+    return future;
+}
+
 void LocationClientApi::stopBatchingSession() {
     if (mApiImpl) {
         mApiImpl->stopBatching(0);
@@ -360,6 +426,17 @@ void LocationClientApi::addGeofences(std::vector<Geofence>& geofences,
                 reinterpret_cast<GeofenceInfo*>(gfInfos));
     }
 }
+CollectiveResponseFuture LocationClientApi::addGeofences(std::vector<Geofence>& geofences,
+        GeofenceBreachCb gfBreachCb) {
+    CollectiveResponseFuture future;
+    // nothing is added without gfBreachCb or geofences, and no response comes
+    if (!gfBreachCb || geofences.empty()) {
+        future.complete({});
+    } else {
+        addGeofences(geofences, gfBreachCb, future.completer({}));
+    }
+    return future;
+}
 void LocationClientApi::removeGeofences(std::vector<Geofence>& geofences) {
     if (!mApiImpl) {
         LOC_LOGe ("NULL mApiImpl");
@@ -493,6 +570,14 @@ void LocationClientApi::getGnssEnergyConsumed(
     }
 }
 
+LocationResponseFuture LocationClientApi::getGnssEnergyConsumed(
+        GnssEnergyConsumedCb gnssEnergyConsumedCallback) {
+    LocationResponseFuture future;
+    getGnssEnergyConsumed(gnssEnergyConsumedCallback,
+                          future.completer(LOCATION_RESPONSE_UNKOWN_FAILURE));
+    return future;
+}
+
 void LocationClientApi::updateLocationSystemInfoListener(
     LocationSystemInfoCb locSystemInfoCallback,
     ResponseCb responseCallback) {
@@ -1106,6 +1191,52 @@ string GnssSv::toString() const {
     return out;
 }
 
+void GnssSvs::clear() {
+    svId.clear();
+    type.clear();
+    cN0Dbhz.clear();
+    elevation.clear();
+    azimuth.clear();
+    gnssSvOptionsMask.clear();
+    carrierFrequencyHz.clear();
+    gnssSignalTypeMask.clear();
+    basebandCarrierToNoiseDbHz.clear();
+    gloFrequency.clear();
+}
+
+void GnssSvs::push_back(const GnssSv& gnssSv) {
+    svId.push_back(gnssSv.svId);
+    type.push_back(gnssSv.type);
+    cN0Dbhz.push_back(gnssSv.cN0Dbhz);
+    elevation.push_back(gnssSv.elevation);
+    azimuth.push_back(gnssSv.azimuth);
+    gnssSvOptionsMask.push_back(gnssSv.gnssSvOptionsMask);
+    carrierFrequencyHz.push_back(gnssSv.carrierFrequencyHz);
+    gnssSignalTypeMask.push_back(gnssSv.gnssSignalTypeMask);
+    basebandCarrierToNoiseDbHz.push_back(gnssSv.basebandCarrierToNoiseDbHz);
+    gloFrequency.push_back(gnssSv.gloFrequency);
+}
+
+string GnssSvs::toString() const {
+    string out;
+    out.reserve(256 * size());
+
+    for (size_t i = 0; i < size(); i++) {
+        out += FIELDVAL_DEC(svId[i]);
+        out += FIELDVAL_ENUM(type[i], GnssSvType_tbl);
+        out += FIELDVAL_DEC(cN0Dbhz[i]);
+        out += FIELDVAL_DEC(elevation[i]);
+        out += FIELDVAL_DEC(azimuth[i]);
+        out += FIELDVAL_MASK(gnssSvOptionsMask[i], GnssSvOptionsMask_tbl);
+        out += FIELDVAL_DEC(carrierFrequencyHz[i]);
+        out += FIELDVAL_MASK(gnssSignalTypeMask[i], GnssSignalTypeMask_tbl);
+        out += FIELDVAL_DEC(basebandCarrierToNoiseDbHz[i]);
+        out += FIELDVAL_DEC(gloFrequency[i]);
+    }
+
+    return out;
+}
+
 string GnssData::toString() const {
     string out;
     out.reserve(4096);
@@ -35,7 +35,6 @@
 #include <log_util.h>
 #include <gps_extended_c.h>
 #include <unistd.h>
-#include <sstream>
 #include <dlfcn.h>
 #include <loc_misc_utils.h>
 
@@ -929,6 +928,7 @@ static GnssMeasurements parseGnssMeasurements(const ::GnssMeasurementsNotificati
             &halGnssMeasurements) {
     GnssMeasurements gnssMeasurements = {};
 
+    gnssMeasurements.measurements.reserve(halGnssMeasurements.count);
     for (int meas = 0; meas < halGnssMeasurements.count; meas++) {
         GnssMeasurementsData measurement;
 
@@ -975,7 +975,7 @@ static GnssMeasurements parseGnssMeasurements(const ::GnssMeasurementsNotificati
                 halGnssMeasurements.measurements[meas].fullInterSignalBiasUncertaintyNs;
         measurement.cycleSlipCount = halGnssMeasurements.measurements[meas].cycleSlipCount;
 
-        gnssMeasurements.measurements.push_back(measurement);
+        gnssMeasurements.measurements.push_back(std::move(measurement));
     }
     gnssMeasurements.clock.flags =
             (GnssMeasurementsClockFlagsMask) halGnssMeasurements.clock.flags;
@@ -1060,6 +1060,8 @@ public:
     virtual void onListenerReady() override;
     virtual void onReceive(const char* data, uint32_t length,
                            const LocIpcRecver* recver) override;
+    virtual void onReceiveFds(const int fds[], int count,
+                              const LocIpcRecver* recver) override;
 };
 
 /******************************************************************************
@@ -1116,7 +1118,89 @@ mutex LocationClientApiImpl::mMutex;
 /******************************************************************************
 LocationClientApiImpl - constructors
 ******************************************************************************/
-LocationClientApiImpl::LocationClientApiImpl(CapabilitiesCb capabitiescb) :
+/******************************************************************************
+CallbackHandoff
+******************************************************************************/
+static const uint32_t CALLBACK_HANDOFF_DEFAULT_MAX_PENDING = 32;
+
+CallbackHandoff::CallbackHandoff(const CallbackExecutor& executor) :
+        mMaxPending((0 == executor.maxPending) ?
+                CALLBACK_HANDOFF_DEFAULT_MAX_PENDING : executor.maxPending),
+        mUserQueue((CALLBACK_EXECUTOR_USER_QUEUE == executor.type) ?
+                executor.userQueue : nullptr),
+        mCbTask((nullptr == mUserQueue) ? new MsgTask("ClientApiCb") : nullptr),
+        mStopped(false),
+        mRunning(false) {
+}
+
+void CallbackHandoff::post(CallbackCoalesceKey coalesceKey, std::function<void()>&& callback) {
+    {
+        unique_lock<mutex> lock(mLock);
+        if (mStopped) {
+            return;
+        }
+        if (CALLBACK_COALESCE_NONE != coalesceKey) {
+            for (auto& pending : mPending) {
+                if (pending.first == coalesceKey) {
+                    pending.second = std::move(callback);
+                    return;
+                }
+            }
+        }
+        // bounded handoff, a decoder running ahead of the app waits here
+        mRoom.wait(lock, [this] { return mStopped || mPending.size() < mMaxPending; });
+        if (mStopped) {
+            return;
+        }
+        mPending.emplace_back(coalesceKey, std::move(callback));
+    }
+
+    shared_ptr<CallbackHandoff> self = shared_from_this();
+    if (nullptr != mCbTask) {
+        mCbTask->sendMsg([self] { self->runOne(); });
+    } else {
+        mUserQueue([self] { self->runOne(); });
+    }
+}
+
+void CallbackHandoff::runOne() {
+    unique_lock<mutex> lock(mLock);
+    // a user queue may run us on several threads at once; whoever runs
+    // first drains in order and the others leave
+    if (mRunning) {
+        return;
+    }
+    mRunning = true;
+    while (!mPending.empty()) {
+        std::function<void()> callback(std::move(mPending.front().second));
+        mPending.pop_front();
+        lock.unlock();
+        mRoom.notify_one();
+        callback();
+        lock.lock();
+    }
+    mRunning = false;
+}
+
+void CallbackHandoff::stop() {
+    std::deque<PendingCallback> dropped;
+    {
+        lock_guard<mutex> lock(mLock);
+        mStopped = true;
+        dropped.swap(mPending);
+    }
+    mRoom.notify_all();
+}
+
+static google::protobuf::ArenaOptions getDecodeArenaOptions(char* block, size_t size) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = size;
+    return options;
+}
+
+LocationClientApiImpl::LocationClientApiImpl(CapabilitiesCb capabitiescb,
+                                             const CallbackExecutor& executor) :
         mSessionId(LOCATION_CLIENT_SESSION_ID_INVALID),
         mBatchingId(LOCATION_CLIENT_SESSION_ID_INVALID),
         mHalRegistered(false),
@@ -1141,7 +1225,12 @@ LocationClientApiImpl::LocationClientApiImpl(CapabilitiesCb capabitiescb) :
         mSingleTerrestrialPosCb(nullptr),
         mSingleTerrestrialPosRespCb(nullptr),
         mPingTestCb(nullptr),
+        mDecodeArena(getDecodeArenaOptions(mDecodeBlock, sizeof(mDecodeBlock))),
         mMsgTask("ClientApiImpl"),
+        mCbHandoff((CALLBACK_EXECUTOR_THREAD == executor.type ||
+                    (CALLBACK_EXECUTOR_USER_QUEUE == executor.type &&
+                     nullptr != executor.userQueue)) ?
+                make_shared<CallbackHandoff>(executor) : nullptr),
         mLogger()
 {
     // read configuration file
@@ -1216,7 +1305,7 @@ LocationClientApiImpl::LocationClientApiImpl(CapabilitiesCb capabitiescb) :
     }
 
     // establish an ipc sender to the hal daemon
-    mIpcSender = LocIpc::getLocIpcLocalSender(SOCKET_TO_LOCATION_HAL_DAEMON);
+    mIpcSender = LocIpc::getSharedLocIpcLocalSender(SOCKET_TO_LOCATION_HAL_DAEMON);
     if (mIpcSender == nullptr) {
         LOC_LOGe("create sender socket failed %s", SOCKET_TO_LOCATION_HAL_DAEMON);
         return;
@@ -1226,13 +1315,19 @@ LocationClientApiImpl::LocationClientApiImpl(CapabilitiesCb capabitiescb) :
 #endif
 
     LOC_LOGd("listen on socket: %s", mSocketName);
-    mIpc.startNonBlockingListening(recver);
+    LocIpcReactor::getProcessReactor().add(recver, this);
 }
 
 LocationClientApiImpl::~LocationClientApiImpl() {
+    // the listeners refer to this client, so they must be gone first
+    LocIpcReactor::getProcessReactor().removeOwner(this);
 }
 
 void LocationClientApiImpl::destroy() {
+    // no callback reaches the app once its LocationClientApi is gone
+    if (nullptr != mCbHandoff) {
+        mCbHandoff->stop();
+    }
 
     struct DestroyReq : public LocMsg {
         DestroyReq(LocationClientApiImpl* apiImpl) :
@@ -1292,12 +1387,14 @@ void LocationClientApiImpl::updateCallbackFunctions(const ClientCallbacks& cbs,
             if (REPORT_CB_GNSS_INFO == mReportCbType) {
                 mApiImpl->mGnssLocationCb     = mCbs.gnssreportcbs.gnssLocationCallback;
                 mApiImpl->mGnssSvCb           = mCbs.gnssreportcbs.gnssSvCallback;
+                mApiImpl->mGnssSvsCb          = mCbs.gnssreportcbs.gnssSvsCallback;
                 mApiImpl->mGnssNmeaCb         = mCbs.gnssreportcbs.gnssNmeaCallback;
                 mApiImpl->mGnssDataCb         = mCbs.gnssreportcbs.gnssDataCallback;
                 mApiImpl->mGnssMeasurementsCb = mCbs.gnssreportcbs.gnssMeasurementsCallback;
             } else if (REPORT_CB_ENGINE_INFO == mReportCbType) {
                 mApiImpl->mEngLocationsCb     = mCbs.engreportcbs.engLocationsCallback;
                 mApiImpl->mGnssSvCb           = mCbs.engreportcbs.gnssSvCallback;
+                mApiImpl->mGnssSvsCb          = mCbs.engreportcbs.gnssSvsCallback;
                 mApiImpl->mGnssNmeaCb         = mCbs.engreportcbs.gnssNmeaCallback;
                 mApiImpl->mGnssDataCb         = mCbs.engreportcbs.gnssDataCallback;
                 mApiImpl->mGnssMeasurementsCb = mCbs.engreportcbs.gnssMeasurementsCallback;
@@ -1339,7 +1436,8 @@ void LocationClientApiImpl::updateCallbacks(LocationCallbacks& callbacks) {
                 callBacksMask |= E_LOC_CB_GNSS_SV_BIT;
             }
             if (mCallBacks.gnssNmeaCb) {
-                callBacksMask |= E_LOC_CB_GNSS_NMEA_BIT;
+                // NMEA indications are split into sentences below anyway
+                callBacksMask |= E_LOC_CB_GNSS_NMEA_BIT | E_LOC_CB_GNSS_NMEA_BUNDLE_BIT;
             }
             if (mCallBacks.gnssDataCb) {
                 callBacksMask |= E_LOC_CB_GNSS_DATA_BIT;
@@ -1938,9 +2036,9 @@ void LocationClientApiImpl::getGnssEnergyConsumed(
                             reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()), pbStr.size());
                     if (mResponseCb) {
                         if (true == rc) {
-                            mResponseCb(LOCATION_RESPONSE_SUCCESS);
+                            mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_SUCCESS);
                         } else {
-                            mResponseCb(LOCATION_RESPONSE_UNKOWN_FAILURE);
+                            mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_UNKOWN_FAILURE);
                         }
                     }
                 } else {
@@ -2008,9 +2106,9 @@ void LocationClientApiImpl::updateLocationSystemInfoListener(
                                  mApiImpl->mCallbacksMask, callbackMaskCopy, rc);
                         if (mResponseCb) {
                             if (true == rc) {
-                                mResponseCb(LOCATION_RESPONSE_SUCCESS);
+                                mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_SUCCESS);
                             } else {
-                                mResponseCb(LOCATION_RESPONSE_UNKOWN_FAILURE);
+                                mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_UNKOWN_FAILURE);
                             }
                         }
                     } else {
@@ -2019,7 +2117,7 @@ void LocationClientApiImpl::updateLocationSystemInfoListener(
                 }
             } else {
                 if (mResponseCb) {
-                    mResponseCb(LOCATION_RESPONSE_SUCCESS);
+                    mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_SUCCESS);
                 }
                 LOC_LOGd("No updateCallbacks because same callback");
             }
@@ -2057,7 +2155,7 @@ void LocationClientApiImpl::getSingleTerrestrialPos(
                         (mSingleTerrestrialPosCb == nullptr)) {
                     // pos cb can not be null if there is no pending request
                     if (mResponseCb) {
-                        mResponseCb(LOCATION_RESPONSE_PARAM_INVALID);
+                        mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_PARAM_INVALID);
                     }
                     break;
                 }
@@ -2066,14 +2164,15 @@ void LocationClientApiImpl::getSingleTerrestrialPos(
                         (mSingleTerrestrialPosCb != nullptr)) {
                     // do not allow concurent single terrestrial position requests
                     if (mResponseCb) {
-                        mResponseCb(LOCATION_RESPONSE_REQUEST_ALREADY_IN_PROGRESS);
+                        mApiImpl->invokeCb(mResponseCb,
+                                           LOCATION_RESPONSE_REQUEST_ALREADY_IN_PROGRESS);
                     }
                     break;
                 }
 
                 if (!mApiImpl->mHalRegistered) {
                     if (mResponseCb) {
-                        mResponseCb(LOCATION_RESPONSE_SYSTEM_NOT_READY);
+                        mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_SYSTEM_NOT_READY);
                     }
                     break;
                 }
@@ -2085,7 +2184,7 @@ void LocationClientApiImpl::getSingleTerrestrialPos(
                 // If client has cancelled the callback, we are done with processing
                 if (mApiImpl->mSingleTerrestrialPosCb == nullptr) {
                     if (mResponseCb) {
-                        mResponseCb(LOCATION_RESPONSE_SUCCESS);
+                        mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_SUCCESS);
                     }
                     break;
                 }
@@ -2100,7 +2199,7 @@ void LocationClientApiImpl::getSingleTerrestrialPos(
                             reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()),
                                         pbStr.size());
                     if (!rc && mResponseCb) {
-                        mResponseCb(LOCATION_RESPONSE_UNKOWN_FAILURE);
+                        mApiImpl->invokeCb(mResponseCb, LOCATION_RESPONSE_UNKOWN_FAILURE);
                     }
                 }
             } while (0);
@@ -2128,9 +2227,11 @@ void LocationClientApiImpl::capabilitesCallback(ELocMsgID msgId, const void* msg
     const LocAPICapabilitiesIndMsg* pCapabilitiesIndMsg =
             (LocAPICapabilitiesIndMsg*)(msgData);
     mCapsMask = parseCapabilitiesMask(pCapabilitiesIndMsg->capabilitiesMask);
+    // msgs from here on carry the token instead of the socket name
+    mPbufMsgConv.setClientToken(pCapabilitiesIndMsg->clientToken);
 
     if (mCapabilitiesCb) {
-        mCapabilitiesCb(mCapsMask);
+        invokeCb(mCapabilitiesCb, mCapsMask);
     }
 
     mYearOfHw = parseYearOfHw(pCapabilitiesIndMsg->capabilitiesMask);
@@ -2185,7 +2286,7 @@ void LocationClientApiImpl::pingTest(PingTestCb pingTestCallback) {
 void LocationClientApiImpl::invokePositionSessionResponseCb(LocationResponse responseCode) {
     if (mPositionSessionResponseCbPending) {
         if (nullptr != mResponseCb) {
-            mResponseCb(responseCode);
+            invokeCb(mResponseCb, responseCode);
         }
         mPositionSessionResponseCbPending = false;
     }
@@ -2196,11 +2297,15 @@ LocationClientApiImpl -ILocIpcListener
 ******************************************************************************/
 void IpcListener::onListenerReady() {
     struct ClientRegisterReq : public LocMsg {
-        ClientRegisterReq(LocationClientApiImpl& apiImpl) : mApiImpl(apiImpl) {}
+        ClientRegisterReq(LocationClientApiImpl& apiImpl, uint32_t wireFormats) :
+                mApiImpl(apiImpl), mWireFormats(wireFormats) {}
         void proc() const {
             string pbStr;
+            // a token of an earlier registration is gone with the hal daemon
+            // that handed it out, msgs go by name until a new one comes
+            mApiImpl.mPbufMsgConv.setClientToken(0);
             LocAPIClientRegisterReqMsg msg(mApiImpl.mSocketName, LOCATION_CLIENT_API,
-                    &mApiImpl.mPbufMsgConv);
+                    &mApiImpl.mPbufMsgConv, mWireFormats);
             if (msg.serializeToProtobuf(pbStr)) {
                 mApiImpl.sendMessage(
                         reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()), pbStr.size());
@@ -2209,13 +2314,36 @@ void IpcListener::onListenerReady() {
             }
         }
         LocationClientApiImpl& mApiImpl;
+        const uint32_t mWireFormats;
     };
+    uint32_t wireFormats = 0;
     if (SockNode::Local == mSockTpye) {
         if (0 != chown(mApiImpl.mSocketName, getuid(), GID_LOCCLIENT)) {
             LOC_LOGe("chown to group locclient failed %s", strerror(errno));
         }
+        // same device as the hal daemon, so its structs can be taken as they are
+        wireFormats |= LOCATION_REMOTE_API_WIRE_FORMAT_FLAT;
+    } else {
+        // on a remote node, large msgs are worth the cpu to save packets
+        wireFormats |= LOCATION_REMOTE_API_WIRE_FORMAT_LZ4;
+    }
+    mMsgTask.sendMsg(new (nothrow) ClientRegisterReq(mApiImpl, wireFormats));
+}
+
+void IpcListener::onReceiveFds(const int fds[], int count, const LocIpcRecver* recver) {
+    // hal daemon offers a shm ring for its indications, served next to the socket
+    unique_ptr<LocIpcRecver> shmRecver = LocIpc::getLocIpcShmRecver(
+            make_shared<IpcListener>(mApiImpl, mMsgTask, mSockTpye), fds, count);
+    if (nullptr != shmRecver) {
+        LOC_LOGd("shm ring from hal daemon mapped");
+        LocIpcReactor::getProcessReactor().add(shmRecver, &mApiImpl);
     }
-    mMsgTask.sendMsg(new (nothrow) ClientRegisterReq(mApiImpl));
+}
+
+// all indications are decoded on mMsgTask, so a single arena serves them
+template <typename PbMsg>
+static inline PbMsg& decodeMsg(google::protobuf::Arena& arena) {
+    return *google::protobuf::Arena::CreateMessage<PbMsg>(&arena);
 }
 
 void IpcListener::onReceive(const char* data, uint32_t length,
@@ -2226,18 +2354,107 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 mApiImpl(apiImpl), mListener(listener), mMsgData(data, length) {}
 
         virtual ~OnReceiveHandler() {}
+        struct DecodeArenaReset {
+            google::protobuf::Arena& mArena;
+            ~DecodeArenaReset() { mArena.Reset(); }
+        };
+        void onLocation(const ::Location& halLocation) const {
+            LocationCallbacksMask tempMask =
+                    (E_LOC_CB_DISTANCE_BASED_TRACKING_BIT | E_LOC_CB_SIMPLE_LOCATION_INFO_BIT);
+            if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
+                    (mApiImpl.mCallbacksMask & tempMask)) {
+                Location location = parseLocation(halLocation);
+                if (mApiImpl.mLocationCb) {
+                    mApiImpl.invokeCoalescedCb(CALLBACK_COALESCE_LOCATION,
+                                               mApiImpl.mLocationCb, location);
+                }
+                // copy location info over to gnsslocaiton so we can use existing routine
+                // to log the packet
+                GnssLocation gnssLocation = {};
+                gnssLocation.flags              = location.flags;
+                gnssLocation.timestamp          = location.timestamp;
+                gnssLocation.latitude           = location.latitude;
+                gnssLocation.longitude          = location.longitude;
+                gnssLocation.altitude           = location.altitude;
+                gnssLocation.speed              = location.speed;
+                gnssLocation.bearing            = location.bearing;
+                gnssLocation.horizontalAccuracy = location.horizontalAccuracy;
+                gnssLocation.verticalAccuracy   = location.verticalAccuracy;
+                gnssLocation.speedAccuracy      = location.speedAccuracy;
+                gnssLocation.bearingAccuracy    = location.bearingAccuracy;
+                gnssLocation.techMask           = location.techMask;
+
+                mApiImpl.mLogger.log(gnssLocation, mApiImpl.mCapsMask);
+            }
+        }
+        void onLocationInfo(const ::GnssLocationInfoNotification& notification) const {
+            GnssLocation gnssLocation = parseLocationInfo(notification);
+
+            // the one decoded instance serves logger and app alike: logged first,
+            // then moved to the callback, which copies nothing unless deferred
+            mApiImpl.mLogger.log(gnssLocation, mApiImpl.mCapsMask);
+            if (mApiImpl.mGnssLocationCb) {
+                mApiImpl.invokeCoalescedCb(CALLBACK_COALESCE_GNSS_LOCATION,
+                                           mApiImpl.mGnssLocationCb, std::move(gnssLocation));
+            }
+        }
+        // location indications in the flat wire format, asked for by local
+        // clients at registration; false if the msg is protobuf
+        bool procFlat() const {
+            ELocMsgID eLocMsgid = E_LOCAPI_UNDEFINED_MSG_ID;
+            uint32_t payloadSize = 0;
+            const char* payload = LocAPIFlatMsgHeader::getPayload(
+                    mMsgData.data(), mMsgData.size(), eLocMsgid, payloadSize);
+            if (nullptr == payload) {
+                return false;
+            }
+            LOC_LOGi(">-- onReceive Rcvd flat msg id: %d, payload size: %u",
+                     eLocMsgid, payloadSize);
+            switch (eLocMsgid) {
+            case E_LOCAPI_LOCATION_MSG_ID:
+                if (sizeof(::Location) == payloadSize) {
+                    ::Location location;
+                    memcpy(&location, payload, sizeof(location));
+                    onLocation(location);
+                    return true;
+                }
+                break;
+            case E_LOCAPI_LOCATION_INFO_MSG_ID:
+                if (sizeof(::GnssLocationInfoNotification) == payloadSize) {
+                    if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
+                            (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT)) {
+                        ::GnssLocationInfoNotification notification;
+                        memcpy(&notification, payload, sizeof(notification));
+                        onLocationInfo(notification);
+                    }
+                    return true;
+                }
+                break;
+            default:
+                break;
+            }
+            LOC_LOGe("<<< flat msg id %d of payload size %u not handled", eLocMsgid, payloadSize);
+            return true;
+        }
         void proc() const {
+            if (procFlat()) {
+                return;
+            }
             // Protobuff Encoding enabled, so we need to convert the message from proto
-            // encoded format to local structure
-            PBLocAPIMsgHeader pbLocApiMsg;
-            if (0 == pbLocApiMsg.ParseFromString(mMsgData)) {
+            // encoded format to local structure. The header is parsed into the one
+            // mPbMsgHeader, whose payload buffer is kept from msg to msg. The payload
+            // is decoded on mDecodeArena, which is handed back in one go once the msg
+            // is done.
+            DecodeArenaReset arenaReset = {mApiImpl.mDecodeArena};
+            PBLocAPIMsgHeader& pbLocApiMsg = mApiImpl.mPbMsgHeader;
+            if (0 == pbLocApiMsg.ParseFromArray(mMsgData.data(), mMsgData.size())) {
                 LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u",
                         mMsgData.length());
                 return;
             }
 
             ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
-            string sockName = pbLocApiMsg.msocketname();
+            const string& sockName = pbLocApiMsg.msocketname();
             uint32_t msgVer = pbLocApiMsg.msgversion();
             uint32_t payloadSize = pbLocApiMsg.payloadsize();
             // pbLocApiMsg.payload() contains the payload data.
@@ -2255,7 +2472,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_CAPABILILTIES_MSG_ID:
             {
                 LOC_LOGd("<<< capabilities indication");
-                PBLocAPICapabilitiesIndMsg pbLocApiCapIndMsg;
+                PBLocAPICapabilitiesIndMsg& pbLocApiCapIndMsg =
+                        decodeMsg<PBLocAPICapabilitiesIndMsg>(mApiImpl.mDecodeArena);
                 if (0 == pbLocApiCapIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                     LOC_LOGe("Failed to parse pbLocApiCapIndMsg from payload!!");
                     return;
@@ -2286,7 +2504,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID:
             {
                 LOC_LOGd("<<< response message %d\n", locApiMsg.msgId);
-                PBLocAPIGenericRespMsg pbLocApiGenericRsp;
+                PBLocAPIGenericRespMsg& pbLocApiGenericRsp =
+                        decodeMsg<PBLocAPIGenericRespMsg>(mApiImpl.mDecodeArena);
                 if (0 == pbLocApiGenericRsp.ParseFromString(pbLocApiMsg.payload())) {
                     LOC_LOGe("Failed to parse pbLocApiGenericRsp from payload!!");
                     return;
@@ -2307,7 +2526,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_RESUME_GEOFENCES_MSG_ID:
             {
                 LOC_LOGd("<<< collective response message, msgId = %d", locApiMsg.msgId);
-                PBLocAPICollectiveRespMsg pbLocApiCollctvRespMsg;
+                PBLocAPICollectiveRespMsg& pbLocApiCollctvRespMsg =
+                        decodeMsg<PBLocAPICollectiveRespMsg>(mApiImpl.mDecodeArena);
                 if (0 == pbLocApiCollctvRespMsg.ParseFromString(pbLocApiMsg.payload())) {
                     LOC_LOGe("Failed to parse pbLocApiCollctvRespMsg from payload!!");
                     return;
@@ -2330,7 +2550,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     }
                 }
                 if (mApiImpl.mCollectiveResCb) {
-                    mApiImpl.mCollectiveResCb(responses);
+                    mApiImpl.invokeCb(mApiImpl.mCollectiveResCb, responses);
                 }
                 break;
             }
@@ -2339,40 +2559,15 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_LOCATION_MSG_ID:
             {
                 LOC_LOGd("<<< message = location");
-                PBLocAPILocationIndMsg pbLocApiLocIndMsg;
+                PBLocAPILocationIndMsg& pbLocApiLocIndMsg =
+                        decodeMsg<PBLocAPILocationIndMsg>(mApiImpl.mDecodeArena);
                 if (0 == pbLocApiLocIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                     LOC_LOGe("Failed to parse pbLocApiLocIndMsg from payload!!");
                     return;
                 }
                 LocAPILocationIndMsg msg(sockName.c_str(), pbLocApiLocIndMsg,
                         &mApiImpl.mPbufMsgConv);
-                LocationCallbacksMask tempMask =
-                        (E_LOC_CB_DISTANCE_BASED_TRACKING_BIT | E_LOC_CB_SIMPLE_LOCATION_INFO_BIT);
-                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
-                        (mApiImpl.mCallbacksMask & tempMask)) {
-                    const LocAPILocationIndMsg* pLocationIndMsg = (LocAPILocationIndMsg*)(&msg);
-                    Location location = parseLocation(pLocationIndMsg->locationNotification);
-                    if (mApiImpl.mLocationCb) {
-                        mApiImpl.mLocationCb(location);
-                    }
-                    // copy location info over to gnsslocaiton so we can use existing routine
-                    // to log the packet
-                    GnssLocation gnssLocation = {};
-                    gnssLocation.flags              = location.flags;
-                    gnssLocation.timestamp          = location.timestamp;
-                    gnssLocation.latitude           = location.latitude;
-                    gnssLocation.longitude          = location.longitude;
-                    gnssLocation.altitude           = location.altitude;
-                    gnssLocation.speed              = location.speed;
-                    gnssLocation.bearing            = location.bearing;
-                    gnssLocation.horizontalAccuracy = location.horizontalAccuracy;
-                    gnssLocation.verticalAccuracy   = location.verticalAccuracy;
-                    gnssLocation.speedAccuracy      = location.speedAccuracy;
-                    gnssLocation.bearingAccuracy    = location.bearingAccuracy;
-                    gnssLocation.techMask           = location.techMask;
-
-                    mApiImpl.mLogger.log(gnssLocation, mApiImpl.mCapsMask);
-                }
+                onLocation(msg.locationNotification);
                 break;
             }
 
@@ -2380,7 +2575,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = batching");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_BATCHING_BIT) {
-                    PBLocAPIBatchingIndMsg pbLocApiBatchIndMsg;
+                    PBLocAPIBatchingIndMsg& pbLocApiBatchIndMsg =
+                            decodeMsg<PBLocAPIBatchingIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiBatchIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiBatchIndMsg from payload!!");
                         return;
@@ -2408,7 +2604,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                         break;
                     }
                     if (mApiImpl.mBatchingCb) {
-                        mApiImpl.mBatchingCb(locationVector, status);
+                        mApiImpl.invokeCb(mApiImpl.mBatchingCb, locationVector, status);
                     }
                 }
                 break;
@@ -2418,7 +2614,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = geofence breach");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_GEOFENCE_BREACH_BIT) {
-                    PBLocAPIGeofenceBreachIndMsg pbLocApiGfBreachIndMsg;
+                    PBLocAPIGeofenceBreachIndMsg& pbLocApiGfBreachIndMsg =
+                            decodeMsg<PBLocAPIGeofenceBreachIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiGfBreachIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiGfBreachIndMsg from payload!!");
                         return;
@@ -2434,12 +2631,12 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                                                 *(pGfBreachIndMsg->gfBreachNotification.id + i)));
                     }
                     if (mApiImpl.mGfBreachCb) {
-                        mApiImpl.mGfBreachCb(geofences,
-                                             parseLocation(
-                                                 pGfBreachIndMsg->gfBreachNotification.location),
-                                             GeofenceBreachTypeMask(
-                                                 pGfBreachIndMsg->gfBreachNotification.type),
-                                             pGfBreachIndMsg->gfBreachNotification.timestamp);
+                        mApiImpl.invokeCb(mApiImpl.mGfBreachCb, geofences,
+                                          parseLocation(
+                                              pGfBreachIndMsg->gfBreachNotification.location),
+                                          GeofenceBreachTypeMask(
+                                              pGfBreachIndMsg->gfBreachNotification.type),
+                                          pGfBreachIndMsg->gfBreachNotification.timestamp);
                     }
                 }
                 break;
@@ -2450,22 +2647,15 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 LOC_LOGd("<<< message = location info");
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT)) {
-                    PBLocAPILocationInfoIndMsg pbLocApiLocInfoIndMsg;
+                    PBLocAPILocationInfoIndMsg& pbLocApiLocInfoIndMsg =
+                            decodeMsg<PBLocAPILocationInfoIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiLocInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiLocInfoIndMsg from payload!!");
                         return;
                     }
                     LocAPILocationInfoIndMsg msg(sockName.c_str(), pbLocApiLocInfoIndMsg,
                             &mApiImpl.mPbufMsgConv);
-                    const LocAPILocationInfoIndMsg* pLocationInfoIndMsg =
-                        (LocAPILocationInfoIndMsg*)(&msg);
-                    GnssLocation gnssLocation =
-                        parseLocationInfo(pLocationInfoIndMsg->gnssLocationInfoNotification);
-
-                    if (mApiImpl.mGnssLocationCb) {
-                        mApiImpl.mGnssLocationCb(gnssLocation);
-                    }
-                    mApiImpl.mLogger.log(gnssLocation, mApiImpl.mCapsMask);
+                    onLocationInfo(msg.gnssLocationInfoNotification);
                 }
                 break;
             }
@@ -2475,7 +2665,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
 
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT)) {
-                    PBLocAPIEngineLocationsInfoIndMsg pbLocApiEngLocInfoIndMsg;
+                    PBLocAPIEngineLocationsInfoIndMsg& pbLocApiEngLocInfoIndMsg =
+                            decodeMsg<PBLocAPIEngineLocationsInfoIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiEngLocInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiEngLocInfoIndMsg from payload!!");
                         return;
@@ -2492,15 +2683,17 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     }
 
                     std::vector<GnssLocation> engLocationsVector;
+                    engLocationsVector.reserve(pEngLocationsInfoIndMsg->count);
                     for (int i=0; i< pEngLocationsInfoIndMsg->count; i++) {
-                        GnssLocation gnssLocation =
-                            parseLocationInfo(pEngLocationsInfoIndMsg->engineLocationsInfo[i]);
-                        engLocationsVector.push_back(gnssLocation);
-                        mApiImpl.mLogger.log(gnssLocation, mApiImpl.mCapsMask);
+                        engLocationsVector.push_back(
+                            parseLocationInfo(pEngLocationsInfoIndMsg->engineLocationsInfo[i]));
+                        mApiImpl.mLogger.log(engLocationsVector.back(), mApiImpl.mCapsMask);
                     }
 
                     if (mApiImpl.mEngLocationsCb) {
-                        mApiImpl.mEngLocationsCb(engLocationsVector);
+                        mApiImpl.invokeCoalescedCb(CALLBACK_COALESCE_ENGINE_LOCATIONS,
+                                                   mApiImpl.mEngLocationsCb,
+                                                   std::move(engLocationsVector));
                     }
                 }
                 break;
@@ -2510,7 +2703,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = sv");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_SV_BIT) {
-                    PBLocAPISatelliteVehicleIndMsg pbLocApiSatVehIndMsg;
+                    PBLocAPISatelliteVehicleIndMsg& pbLocApiSatVehIndMsg =
+                            decodeMsg<PBLocAPISatelliteVehicleIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiSatVehIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiSatVehIndMsg from payload!!");
                         return;
@@ -2519,16 +2713,41 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPISatelliteVehicleIndMsg* pSvIndMsg =
                         (LocAPISatelliteVehicleIndMsg*)(&msg);
-                    std::vector<GnssSv> gnssSvsVector;
-                    for (int i=0; i< pSvIndMsg->gnssSvNotification.count; i++) {
-                        GnssSv gnssSv;
-                        gnssSv = parseGnssSv(pSvIndMsg->gnssSvNotification.gnssSvs[i]);
-                        gnssSvsVector.push_back(gnssSv);
+                    const ::GnssSvNotification& svNotify = pSvIndMsg->gnssSvNotification;
+                    if (mApiImpl.mGnssSvsCb) {
+                        // only this thread and pending callbacks hold the
+                        // arrays, so once no callback holds them they are ours
+                        if (nullptr == mApiImpl.mGnssSvs ||
+                                mApiImpl.mGnssSvs.use_count() > 1) {
+                            mApiImpl.mGnssSvs = make_shared<GnssSvs>();
+                        }
+                        shared_ptr<GnssSvs> gnssSvs = mApiImpl.mGnssSvs;
+                        gnssSvs->clear();
+                        for (uint32_t i = 0; i < svNotify.count; i++) {
+                            gnssSvs->push_back(parseGnssSv(svNotify.gnssSvs[i]));
+                        }
+                        GnssSvsCb gnssSvsCb = mApiImpl.mGnssSvsCb;
+                        mApiImpl.invokeCb([gnssSvsCb, gnssSvs] { gnssSvsCb(*gnssSvs); });
                     }
-                    if (mApiImpl.mGnssSvCb) {
-                        mApiImpl.mGnssSvCb(gnssSvsVector);
+                    if (mApiImpl.mGnssSvCb || mApiImpl.mLogger.logsSv()) {
+                        // reused the same way as mGnssSvs
+                        if (nullptr == mApiImpl.mGnssSvVector ||
+                                mApiImpl.mGnssSvVector.use_count() > 1) {
+                            mApiImpl.mGnssSvVector = make_shared<std::vector<GnssSv>>();
+                        }
+                        shared_ptr<std::vector<GnssSv>> gnssSvsVector = mApiImpl.mGnssSvVector;
+                        gnssSvsVector->clear();
+                        for (uint32_t i = 0; i < svNotify.count; i++) {
+                            gnssSvsVector->push_back(parseGnssSv(svNotify.gnssSvs[i]));
+                        }
+                        mApiImpl.mLogger.log(*gnssSvsVector);
+                        if (mApiImpl.mGnssSvCb) {
+                            GnssSvCb gnssSvCb = mApiImpl.mGnssSvCb;
+                            mApiImpl.invokeCb([gnssSvCb, gnssSvsVector] {
+                                gnssSvCb(*gnssSvsVector);
+                            });
+                        }
                     }
-                    mApiImpl.mLogger.log(gnssSvsVector);
                 }
                 break;
             }
@@ -2539,25 +2758,38 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                         (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_NMEA_BIT) &&
                          mApiImpl.mGnssNmeaCb) {
 
-                    PBLocAPINmeaIndMsg pbLocApiNmeaIndMsg;
+                    PBLocAPINmeaIndMsg& pbLocApiNmeaIndMsg =
+                            decodeMsg<PBLocAPINmeaIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiNmeaIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiNmeaIndMsg from payload!!");
                         return;
                     }
-                    LocAPINmeaIndMsg msg(sockName.c_str(), pbLocApiNmeaIndMsg,
-                            &mApiImpl.mPbufMsgConv);
-                    // nmea is variable length, can not be checked
-                    const LocAPINmeaIndMsg* pNmeaIndMsg = (LocAPINmeaIndMsg*)(&msg);
-                    uint64_t timestamp = pNmeaIndMsg->gnssNmeaNotification.timestamp;
-                    std::string nmea(pNmeaIndMsg->gnssNmeaNotification.nmea);
-                    LOC_LOGd("<<< message = nmea[%s]", nmea.c_str());
-                    std::stringstream ss(nmea);
-                    std::string each;
-                    while(std::getline(ss, each, '\n')) {
-                        each += '\n';
-                        mApiImpl.mGnssNmeaCb(timestamp, each);
+                    // nmea is variable length, can not be checked. It is taken
+                    // from the decoded msg as it is, not copied into a LocAPINmeaIndMsg
+                    const PBLocAPINmeaSerializedPayload& pbNmea =
+                            pbLocApiNmeaIndMsg.gnssnmeanotification();
+                    uint64_t timestamp = pbNmea.timestamp();
+                    const char* nmea = pbNmea.nmea().data();
+                    size_t nmeaLen = pbNmea.nmea().size();
+                    LOC_LOGd("<<< message = nmea[%s]", pbNmea.nmea().c_str());
+                    // each sentence is cut straight out of the decoded msg, with
+                    // its \n, or one added to the last if it has none
+                    const char* end = nmea + nmeaLen;
+                    for (const char* each = nmea; each < end; ) {
+                        const char* eol = (const char*)memchr(each, '\n', end - each);
+                        std::string sentence;
+                        if (nullptr != eol) {
+                            sentence.assign(each, eol + 1 - each);
+                            each = eol + 1;
+                        } else {
+                            sentence.reserve(end - each + 1);
+                            sentence.assign(each, end - each);
+                            sentence += '\n';
+                            each = end;
+                        }
+                        mApiImpl.invokeCb(mApiImpl.mGnssNmeaCb, timestamp, std::move(sentence));
                     }
-                    mApiImpl.mLogger.log(timestamp, nmea.size(), nmea.c_str());
+                    mApiImpl.mLogger.log(timestamp, nmeaLen, nmea);
                 }
                 break;
             }
@@ -2567,7 +2799,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 LOC_LOGd("<<< message = data");
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_DATA_BIT)) {
-                    PBLocAPIDataIndMsg pbLocApiDataIndMsg;
+                    PBLocAPIDataIndMsg& pbLocApiDataIndMsg =
+                            decodeMsg<PBLocAPIDataIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiDataIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiDataIndMsg from payload!!");
                         return;
@@ -2578,7 +2811,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     GnssData gnssData =
                         parseGnssData(pDataIndMsg->gnssDataNotification);
                     if (mApiImpl.mGnssDataCb) {
-                        mApiImpl.mGnssDataCb(gnssData);
+                        mApiImpl.invokeCb(mApiImpl.mGnssDataCb, std::move(gnssData));
                     }
                 }
                 break;
@@ -2590,7 +2823,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                     (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_MEAS_BIT)) {
 
-                    PBLocAPIMeasIndMsg pbLocApiMeasIndMsg;
+                    PBLocAPIMeasIndMsg& pbLocApiMeasIndMsg =
+                            decodeMsg<PBLocAPIMeasIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiMeasIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiMeasIndMsg from payload!!");
                         return;
@@ -2600,10 +2834,11 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     const LocAPIMeasIndMsg* pMeasIndMsg = (LocAPIMeasIndMsg*)(&msg);
                     GnssMeasurements gnssMeasurements =
                         parseGnssMeasurements(pMeasIndMsg->gnssMeasurementsNotification);
+                    mApiImpl.mLogger.log(gnssMeasurements);
                     if (mApiImpl.mGnssMeasurementsCb) {
-                        mApiImpl.mGnssMeasurementsCb(gnssMeasurements);
+                        mApiImpl.invokeCb(mApiImpl.mGnssMeasurementsCb,
+                                          std::move(gnssMeasurements));
                     }
-                    mApiImpl.mLogger.log(gnssMeasurements);
                 }
                 break;
             }
@@ -2611,7 +2846,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID:
             {
                 LOC_LOGd("<<< message = GNSS power consumption\n");
-                PBLocAPIGnssEnergyConsumedIndMsg pbLocApiGnssEnergyConsmdIndMsg;
+                PBLocAPIGnssEnergyConsumedIndMsg& pbLocApiGnssEnergyConsmdIndMsg =
+                        decodeMsg<PBLocAPIGnssEnergyConsumedIndMsg>(mApiImpl.mDecodeArena);
                 if (0 == pbLocApiGnssEnergyConsmdIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                     LOC_LOGe("Failed to parse pbLocApiGnssEnergyConsmdIndMsg from payload!!");
                     return;
@@ -2631,10 +2867,10 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     (location_client::GnssEnergyConsumedInfoMask) flags;
                 energyConsumedInfo.totalEnergyConsumedSinceFirstBoot = energyNumber;
                 if (flags == 0 && mApiImpl.mGnssEnergyConsumedResponseCb) {
-                    mApiImpl.mGnssEnergyConsumedResponseCb(
+                    mApiImpl.invokeCb(mApiImpl.mGnssEnergyConsumedResponseCb,
                         LOCATION_RESPONSE_UNKOWN_FAILURE);
                 } else if (mApiImpl.mGnssEnergyConsumedInfoCb){
-                    mApiImpl.mGnssEnergyConsumedInfoCb(energyConsumedInfo);
+                    mApiImpl.invokeCb(mApiImpl.mGnssEnergyConsumedInfoCb, energyConsumedInfo);
                 }
                 break;
             }
@@ -2643,7 +2879,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = location system info");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_SYSTEM_INFO_BIT) {
-                    PBLocAPILocationSystemInfoIndMsg pbLocApiLocSysInfoIndMsg;
+                    PBLocAPILocationSystemInfoIndMsg& pbLocApiLocSysInfoIndMsg =
+                            decodeMsg<PBLocAPILocationSystemInfoIndMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbLocApiLocSysInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse pbLocApiLocSysInfoIndMsg from payload!!");
                         return;
@@ -2655,7 +2892,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     LocationSystemInfo locationSystemInfo =
                             parseLocationSystemInfo(pDataIndMsg->locationSystemInfo);
                     if (mApiImpl.mLocationSysInfoCb) {
-                        mApiImpl.mLocationSysInfoCb(locationSystemInfo);
+                        mApiImpl.invokeCb(mApiImpl.mLocationSysInfoCb, locationSystemInfo);
                     }
                 }
                 break;
@@ -2665,7 +2902,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = terrestrial pos info");
                 if (mApiImpl.mSingleTerrestrialPosCb) {
-                    PBLocAPIGetSingleTerrestrialPosRespMsg pbMsg;
+                    PBLocAPIGetSingleTerrestrialPosRespMsg& pbMsg =
+                            decodeMsg<PBLocAPIGetSingleTerrestrialPosRespMsg>(mApiImpl.mDecodeArena);
                     if (0 == pbMsg.ParseFromString(pbLocApiMsg.payload())) {
                         LOC_LOGe("Failed to parse PBLocAPIGetSingleTerrestrialPosRespMsg!!");
                         return;
@@ -2674,11 +2912,12 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                     LocAPIGetSingleTerrestrialPosRespMsg msg(sockName.c_str(), pbMsg,
                                                              &mApiImpl.mPbufMsgConv);
                     if (mApiImpl.mSingleTerrestrialPosRespCb) {
-                        mApiImpl.mSingleTerrestrialPosRespCb(parseLocationError(msg.mErrorCode));
+                        mApiImpl.invokeCb(mApiImpl.mSingleTerrestrialPosRespCb,
+                                          parseLocationError(msg.mErrorCode));
                     }
                     if (msg.mErrorCode == ::LOCATION_ERROR_SUCCESS) {
                         Location terrestialPos = parseLocation(msg.mLocation);
-                        mApiImpl.mSingleTerrestrialPosCb(terrestialPos);
+                        mApiImpl.invokeCb(mApiImpl.mSingleTerrestrialPosCb, terrestialPos);
                     }
                     // clean up variable to indicate that no request is pending
                     mApiImpl.mSingleTerrestrialPosRespCb = nullptr;
@@ -2690,7 +2929,8 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_PINGTEST_MSG_ID:
             {
                 LOC_LOGd("<<< ping message %d", locApiMsg.msgId);
-                PBLocAPIPingTestIndMsg pbLocApiPingTestIndMsg;
+                PBLocAPIPingTestIndMsg& pbLocApiPingTestIndMsg =
+                        decodeMsg<PBLocAPIPingTestIndMsg>(mApiImpl.mDecodeArena);
                 if (0 == pbLocApiPingTestIndMsg.ParseFromString(pbLocApiMsg.payload())) {
                     LOC_LOGe("Failed to parse pbLocApiPingTestIndMsg from payload!!");
                     return;
@@ -2700,7 +2940,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 const LocAPIPingTestIndMsg* pIndMsg = (LocAPIPingTestIndMsg*)(&msg);
                 if (mApiImpl.mPingTestCb) {
                     uint32_t response = pIndMsg->data[0];
-                    mApiImpl.mPingTestCb(response);
+                    mApiImpl.invokeCb(mApiImpl.mPingTestCb, response);
                 }
                 break;
             }
@@ -2716,6 +2956,14 @@ void IpcListener::onReceive(const char* data, uint32_t length,
         IpcListener& mListener;
         const string mMsgData;
     };
+    string rawStr;
+    if (LocAPILz4MsgHeader::isCompressed(data, length)) {
+        if (!LocAPILz4MsgHeader::decompress(data, length, rawStr)) {
+            return;
+        }
+        data = rawStr.data();
+        length = rawStr.size();
+    }
     mMsgTask.sendMsg(new (nothrow) OnReceiveHandler(mApiImpl, *this, data, length));
 }
 
@@ -30,6 +30,9 @@
 #define LOCATIONCLIENTAPIIMPL_H
 
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <google/protobuf/arena.h>
 
 #include <loc_pla.h>
 #include <LocIpc.h>
@@ -95,12 +98,46 @@ public:
     inline uint32_t getClientId() { return mId; }
 };
 
+// kinds of callbacks of which only the latest one stays pending in a
+// CallbackHandoff
+enum CallbackCoalesceKey {
+    CALLBACK_COALESCE_NONE = 0,
+    CALLBACK_COALESCE_LOCATION,
+    CALLBACK_COALESCE_GNSS_LOCATION,
+    CALLBACK_COALESCE_ENGINE_LOCATIONS,
+};
+
+// Hands app callbacks off the thread that decodes the hal daemon reports, to
+// a thread of its own or to the app's queue, see CallbackExecutor. Callbacks
+// run one at a time in the order they were posted.
+class CallbackHandoff : public std::enable_shared_from_this<CallbackHandoff> {
+    typedef std::pair<CallbackCoalesceKey, std::function<void()>> PendingCallback;
+    const uint32_t mMaxPending;
+    const CallbackQueueCb mUserQueue;
+    std::unique_ptr<MsgTask> mCbTask;
+    std::mutex mLock;
+    std::condition_variable mRoom;
+    std::deque<PendingCallback> mPending;
+    bool mStopped;
+    bool mRunning;
+    void runOne();
+public:
+    CallbackHandoff(const CallbackExecutor& executor);
+    // waits for room if maxPending callbacks are already pending, unless
+    // a callback of the same coalesceKey is pending, which is replaced
+    void post(CallbackCoalesceKey coalesceKey, std::function<void()>&& callback);
+    // drops the pending callbacks, none is run after this returns, except
+    // the one running right now
+    void stop();
+};
+
 class IpcListener;
 
 class LocationClientApiImpl : public ILocationAPI {
     friend IpcListener;
 public:
-    LocationClientApiImpl(CapabilitiesCb capabitiescb);
+    LocationClientApiImpl(CapabilitiesCb capabitiescb,
+                          const CallbackExecutor& executor = CallbackExecutor());
     void destroy();
 
     // Tracking
@@ -163,6 +200,20 @@ public:
     inline uint16_t getYearOfHw() {return mYearOfHw;}
     void invokePositionSessionResponseCb(LocationResponse responseCode);
 
+    // invokes an app callback on the executor given at creation
+    template <typename Cb, typename... Args>
+    inline void invokeCb(const Cb& cb, Args&&... args) {
+        invokeCoalescedCb(CALLBACK_COALESCE_NONE, cb, std::forward<Args>(args)...);
+    }
+    template <typename Cb, typename... Args>
+    inline void invokeCoalescedCb(CallbackCoalesceKey key, const Cb& cb, Args&&... args) {
+        if (nullptr == mCbHandoff) {
+            cb(std::forward<Args>(args)...);
+        } else {
+            mCbHandoff->post(key, std::bind(cb, std::forward<Args>(args)...));
+        }
+    }
+
     void getSingleTerrestrialPos(uint32_t timeoutMsec, TerrestrialTechMask techMask,
                                  float horQoS, LocationCb terrestrialPositionCallback,
                                  ResponseCb responseCallback);
@@ -212,6 +263,7 @@ private:
 
     // other GNSS related callback
     GnssSvCb                mGnssSvCb;
+    GnssSvsCb               mGnssSvsCb;
     GnssNmeaCb              mGnssNmeaCb;
     GnssDataCb              mGnssDataCb;
     GnssMeasurementsCb      mGnssMeasurementsCb;
@@ -226,12 +278,33 @@ private:
     LocationCb              mSingleTerrestrialPosCb;
     ResponseCb              mSingleTerrestrialPosRespCb;
 
+    // indications from hal daemon are decoded on this arena, reset once a msg
+    // is done; its first block is part of the client, so most indications are
+    // decoded without touching the allocator
+    char                       mDecodeBlock[16 * 1024];
+    google::protobuf::Arena    mDecodeArena;
+    // header of the indication being decoded. It is kept rather than put on
+    // mDecodeArena, so that the payload buffer keeps its capacity and is not
+    // allocated again for every indication. Payload msgs stay on the arena:
+    // clearing a msg that is not on an arena frees its sub msgs.
+    PBLocAPIMsgHeader          mPbMsgHeader;
+
     MsgTask                    mMsgTask;
+    // nullptr if callbacks are invoked inline, on mMsgTask
+    shared_ptr<CallbackHandoff> mCbHandoff;
 
-    LocIpc                     mIpc;
+    // the listening thread, and on the same processor the socket to the
+    // hal daemon, are shared by all clients of the process, see
+    // LocIpcReactor::getProcessReactor()
     shared_ptr<LocIpcSender>   mIpcSender;
 
     LCAReportLoggerUtil        mLogger;
+
+    // the arrays of the last SV report given to mGnssSvsCb, reused for the
+    // next one unless a callback still pending on mCbHandoff holds them
+    shared_ptr<GnssSvs>        mGnssSvs;
+    // same, for the SV vector given to mGnssSvCb
+    shared_ptr<std::vector<GnssSv>> mGnssSvVector;
 };
 
 } // namespace location_client
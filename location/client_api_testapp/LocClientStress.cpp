@@ -0,0 +1,370 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <loc_pla.h>
+#include <LocationClientApi.h>
+
+#include "LocClientStress.h"
+
+using namespace std;
+using namespace location_client;
+
+#define STRESS_DEFAULT_CLIENTS      (8)
+#define STRESS_DEFAULT_SEC          (60)
+#define STRESS_DEFAULT_PERIOD_SEC   (10)
+#define STRESS_DETAILED_INTERVAL_MS (1000)
+#define STRESS_BATCHING_INTERVAL_MS (1000)
+#define STRESS_GEOFENCE_COUNT       (4)
+// as in /proc/<pid>/comm, which keeps the first 15 characters
+#define STRESS_DAEMON_COMM          "location_hal_da"
+
+static const uint32_t sTrackingIntervalsMs[] = { 100, 1000, 5000 };
+
+enum StressRole {
+    STRESS_ROLE_TRACKING = 0,
+    STRESS_ROLE_DETAILED,
+    STRESS_ROLE_BATCHING,
+    STRESS_ROLE_GEOFENCE,
+    STRESS_ROLE_MAX
+};
+static const char* const sRoleNames[STRESS_ROLE_MAX] = {
+    "tracking", "detailed", "batching", "geofence"
+};
+
+static uint64_t nowMs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+/******************************************************************************
+Simulated client
+******************************************************************************/
+class StressClient {
+public:
+    const uint32_t mId;
+    const StressRole mRole;
+    const uint32_t mIntervalMs;
+    LocationClientApi* mApi;
+    vector<Geofence> mGeofences;
+
+    mutable mutex mMutex;
+    uint64_t mCallbacks;
+    uint64_t mFixes;
+    // fixes of a tracking session that did not come within 1.5 intervals
+    uint64_t mMissed;
+    uint64_t mLastFixMs;
+    // UTC time of a fix to the time its callback ran
+    uint64_t mLatencySumMs;
+    uint64_t mLatencyMaxMs;
+    uint64_t mErrors;
+
+    StressClient(uint32_t id, StressRole role, uint32_t intervalMs) :
+            mId(id), mRole(role), mIntervalMs(intervalMs), mApi(nullptr),
+            mCallbacks(0), mFixes(0), mMissed(0), mLastFixMs(0),
+            mLatencySumMs(0), mLatencyMaxMs(0), mErrors(0) {}
+
+    void onCallback() {
+        lock_guard<mutex> lock(mMutex);
+        mCallbacks++;
+    }
+
+    void onFix(const Location& location) {
+        uint64_t bootMs = nowMs(CLOCK_BOOTTIME);
+        uint64_t utcMs = nowMs(CLOCK_REALTIME);
+        lock_guard<mutex> lock(mMutex);
+        mCallbacks++;
+        mFixes++;
+        if (0 != mLastFixMs && bootMs - mLastFixMs > mIntervalMs * 3 / 2) {
+            mMissed += (bootMs - mLastFixMs + mIntervalMs / 2) / mIntervalMs - 1;
+        }
+        mLastFixMs = bootMs;
+        if (0 != location.timestamp && utcMs >= location.timestamp) {
+            uint64_t latencyMs = utcMs - location.timestamp;
+            mLatencySumMs += latencyMs;
+            if (latencyMs > mLatencyMaxMs) {
+                mLatencyMaxMs = latencyMs;
+            }
+        }
+    }
+
+    void onResponse(LocationResponse response) {
+        if (LOCATION_RESPONSE_SUCCESS != response) {
+            lock_guard<mutex> lock(mMutex);
+            mErrors++;
+        }
+    }
+
+    uint64_t getCallbacks() const {
+        lock_guard<mutex> lock(mMutex);
+        return mCallbacks;
+    }
+
+    bool start() {
+        mApi = new LocationClientApi([](LocationCapabilitiesMask) {});
+        ResponseCb responseCb = [this](LocationResponse response) { onResponse(response); };
+
+        switch (mRole) {
+        case STRESS_ROLE_TRACKING:
+            return mApi->startPositionSession(mIntervalMs, 0,
+                    [this](const Location& location) { onFix(location); }, responseCb);
+        case STRESS_ROLE_DETAILED: {
+            GnssReportCbs reportCbs;
+            reportCbs.gnssLocationCallback = [this](const GnssLocation& location) {
+                onFix(location);
+            };
+            reportCbs.gnssSvCallback = [this](const vector<GnssSv>&) { onCallback(); };
+            reportCbs.gnssNmeaCallback = [this](uint64_t, const string&) { onCallback(); };
+            reportCbs.gnssMeasurementsCallback = [this](const GnssMeasurements&) {
+                onCallback();
+            };
+            return mApi->startPositionSession(mIntervalMs, reportCbs, responseCb);
+        }
+        case STRESS_ROLE_BATCHING:
+            return mApi->startRoutineBatchingSession(mIntervalMs, 0,
+                    [this](const vector<Location>&, BatchingStatus) { onCallback(); },
+                    responseCb);
+        case STRESS_ROLE_GEOFENCE:
+            // a few hundred meters apart
+            for (uint32_t i = 0; i < STRESS_GEOFENCE_COUNT; i++) {
+                mGeofences.push_back(Geofence(32.8962 + 0.002 * i, -117.1963, 200.0,
+                        (GeofenceBreachTypeMask)(GEOFENCE_BREACH_ENTER_BIT |
+                                                 GEOFENCE_BREACH_EXIT_BIT),
+                        5000, 0));
+            }
+            mApi->addGeofences(mGeofences,
+                    [this](const vector<Geofence>&, Location, GeofenceBreachTypeMask,
+                           uint64_t) { onCallback(); },
+                    [this](vector<pair<Geofence, LocationResponse>>& responses) {
+                        for (auto& response : responses) {
+                            onResponse(response.second);
+                        }
+                    });
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void stop() {
+        switch (mRole) {
+        case STRESS_ROLE_TRACKING:
+        case STRESS_ROLE_DETAILED:
+            mApi->stopPositionSession();
+            break;
+        case STRESS_ROLE_BATCHING:
+            mApi->stopBatchingSession();
+            break;
+        case STRESS_ROLE_GEOFENCE:
+            mApi->removeGeofences(mGeofences);
+            break;
+        default:
+            break;
+        }
+        delete mApi;
+        mApi = nullptr;
+    }
+
+    void print() const {
+        lock_guard<mutex> lock(mMutex);
+        printf("%6u %-9s %8u %10" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64
+               " %8" PRIu64 " %6" PRIu64 "\n",
+               mId, sRoleNames[mRole], mIntervalMs, mCallbacks, mFixes, mMissed,
+               (0 == mFixes) ? 0 : mLatencySumMs / mFixes, mLatencyMaxMs, mErrors);
+    }
+};
+
+/******************************************************************************
+Hal daemon resource usage
+******************************************************************************/
+struct DaemonUsage {
+    uint64_t mCpuTicks;          // utime + stime
+    uint64_t mWakeups;           // voluntary context switches
+    uint64_t mRssKb;
+};
+
+static pid_t findDaemon() {
+    DIR* dir = opendir("/proc");
+    if (nullptr == dir) {
+        return -1;
+    }
+    pid_t pid = -1;
+    struct dirent* entry;
+    while (-1 == pid && nullptr != (entry = readdir(dir))) {
+        char path[64];
+        char comm[32] = {};
+        snprintf(path, sizeof(path), "/proc/%s/comm", entry->d_name);
+        FILE* file = fopen(path, "r");
+        if (nullptr != file) {
+            if (nullptr != fgets(comm, sizeof(comm), file) &&
+                    0 == strncmp(comm, STRESS_DAEMON_COMM, strlen(STRESS_DAEMON_COMM))) {
+                pid = atoi(entry->d_name);
+            }
+            fclose(file);
+        }
+    }
+    closedir(dir);
+    return pid;
+}
+
+static bool readDaemonUsage(pid_t pid, DaemonUsage& usage) {
+    char path[64];
+    char line[512];
+    memset(&usage, 0, sizeof(usage));
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* file = fopen(path, "r");
+    if (nullptr == file) {
+        return false;
+    }
+    bool ok = false;
+    if (nullptr != fgets(line, sizeof(line), file)) {
+        // the fields after comm, which may have spaces in it, start at state
+        char* fields = strrchr(line, ')');
+        unsigned long utime = 0, stime = 0;
+        ok = (nullptr != fields && 2 == sscanf(fields + 2,
+                "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime));
+        usage.mCpuTicks = utime + stime;
+    }
+    fclose(file);
+
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    file = fopen(path, "r");
+    if (nullptr != file) {
+        while (nullptr != fgets(line, sizeof(line), file)) {
+            unsigned long value = 0;
+            if (1 == sscanf(line, "VmRSS: %lu", &value)) {
+                usage.mRssKb = value;
+            } else if (1 == sscanf(line, "voluntary_ctxt_switches: %lu", &value)) {
+                usage.mWakeups = value;
+            }
+        }
+        fclose(file);
+    }
+    return ok;
+}
+
+/******************************************************************************
+Stress run
+******************************************************************************/
+int runClientStress(int argc, char* argv[]) {
+    uint32_t clientCount = (argc >= 1) ? atoi(argv[0]) : STRESS_DEFAULT_CLIENTS;
+    uint32_t durationSec = (argc >= 2) ? atoi(argv[1]) : STRESS_DEFAULT_SEC;
+    uint32_t periodSec = (argc >= 3) ? atoi(argv[2]) : STRESS_DEFAULT_PERIOD_SEC;
+    if (0 == clientCount) {
+        clientCount = STRESS_DEFAULT_CLIENTS;
+    }
+    if (0 == durationSec) {
+        durationSec = STRESS_DEFAULT_SEC;
+    }
+    if (0 == periodSec || periodSec > durationSec) {
+        periodSec = durationSec;
+    }
+
+    pid_t daemonPid = findDaemon();
+    if (daemonPid < 0) {
+        printf("hal daemon not found, its usage is not reported\n");
+    }
+    long ticksPerSec = sysconf(_SC_CLK_TCK);
+
+    vector<StressClient*> clients;
+    uint32_t trackingCount = 0;
+    for (uint32_t i = 0; i < clientCount; i++) {
+        StressRole role = (StressRole)(i % STRESS_ROLE_MAX);
+        uint32_t intervalMs = 0;
+        switch (role) {
+        case STRESS_ROLE_TRACKING:
+            intervalMs = sTrackingIntervalsMs[trackingCount++ %
+                    (sizeof(sTrackingIntervalsMs) / sizeof(sTrackingIntervalsMs[0]))];
+            break;
+        case STRESS_ROLE_DETAILED:
+            intervalMs = STRESS_DETAILED_INTERVAL_MS;
+            break;
+        case STRESS_ROLE_BATCHING:
+            intervalMs = STRESS_BATCHING_INTERVAL_MS;
+            break;
+        default:
+            break;
+        }
+        StressClient* client = new StressClient(i, role, intervalMs);
+        if (!client->start()) {
+            printf("client %u (%s) did not start\n", i, sRoleNames[role]);
+        }
+        clients.push_back(client);
+    }
+    printf("%u clients started for %u sec\n", clientCount, durationSec);
+
+    DaemonUsage lastUsage = {};
+    bool haveUsage = (daemonPid >= 0) && readDaemonUsage(daemonPid, lastUsage);
+    uint64_t lastCallbacks = 0;
+    uint64_t startMs = nowMs(CLOCK_BOOTTIME);
+    uint64_t lastMs = startMs;
+    for (uint32_t elapsedSec = 0; elapsedSec < durationSec; elapsedSec += periodSec) {
+        sleep(min(periodSec, durationSec - elapsedSec));
+
+        uint64_t callbacks = 0;
+        for (auto client : clients) {
+            callbacks += client->getCallbacks();
+        }
+        uint64_t ms = nowMs(CLOCK_BOOTTIME);
+        uint64_t periodMs = max<uint64_t>(ms - lastMs, 1);
+        printf("[%5" PRIu64 " s] callbacks %8.1f/s", (ms - startMs) / 1000,
+               (callbacks - lastCallbacks) * 1000.0 / periodMs);
+        DaemonUsage usage;
+        if (haveUsage && readDaemonUsage(daemonPid, usage)) {
+            printf("  daemon cpu %5.1f%%  wakeups %7.1f/s  rss %" PRIu64 " kB",
+                   (usage.mCpuTicks - lastUsage.mCpuTicks) * 100000.0 / ticksPerSec / periodMs,
+                   (usage.mWakeups - lastUsage.mWakeups) * 1000.0 / periodMs, usage.mRssKb);
+            lastUsage = usage;
+        }
+        printf("\n");
+        lastCallbacks = callbacks;
+        lastMs = ms;
+    }
+
+    printf("%6s %-9s %8s %10s %8s %8s %8s %8s %6s\n", "client", "role", "interval",
+           "callbacks", "fixes", "missed", "latAvgMs", "latMaxMs", "errors");
+    for (auto client : clients) {
+        client->stop();
+        client->print();
+        delete client;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LOC_CLIENT_STRESS_H
+#define LOC_CLIENT_STRESS_H
+
+/* Runs a number of LocationClientApi clients in this process against the hal
+ * daemon, to see how it scales with the client count. Client i does, by i % 4:
+ *     0: tracking, Location only, at 100 ms, 1 s or 5 s in turn
+ *     1: tracking with GnssLocation, SV, NMEA and measurements, at 1 s
+ *     2: routine batching at 1 s
+ *     3: four geofences
+ * Every period the callback rate of all clients, and the CPU, wakeups and
+ * resident memory of the hal daemon are printed; at the end the callbacks,
+ * fix latency and fixes missed of each client.
+ *
+ * usage: location_client_api_testapp stress [clients] [seconds] [periodSec]
+ */
+int runClientStress(int argc, char* argv[]);
+
+#endif // LOC_CLIENT_STRESS_H
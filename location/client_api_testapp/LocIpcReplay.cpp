@@ -0,0 +1,353 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <semaphore.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <loc_pla.h>
+#include <gps_extended_c.h>
+#include <LocIpc.h>
+#include <MsgTask.h>
+#include <LocationClientApi.h>
+
+#include "LocIpcReplay.h"
+
+using namespace std;
+using namespace loc_util;
+using namespace location_client;
+
+#define REPLAY_DEFAULT_RATE_HZ      (10)
+#define REPLAY_WAIT_SEC             (5)
+// time given to the client to act on the start session request, and to
+// finish the last replayed msgs, before any measuring
+#define REPLAY_SETTLE_MS            (500)
+// most callbacks a single indication may trigger, e.g. NMEA sentences
+#define REPLAY_MAX_CB_PER_MSG       (8)
+
+/******************************************************************************
+Allocation counting
+******************************************************************************/
+// allocations by any thread of the process while counting is on
+static atomic<bool> gCountAllocs(false);
+static atomic<uint64_t> gAllocCount(0);
+
+void* operator new(size_t size) {
+    if (gCountAllocs.load(memory_order_relaxed)) {
+        gAllocCount.fetch_add(1, memory_order_relaxed);
+    }
+    void* p = malloc((0 == size) ? 1 : size);
+    if (nullptr == p) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    if (gCountAllocs.load(memory_order_relaxed)) {
+        gAllocCount.fetch_add(1, memory_order_relaxed);
+    }
+    return malloc((0 == size) ? 1 : size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept {
+    free(p);
+}
+
+/******************************************************************************
+Callback latency
+******************************************************************************/
+enum ReplayCbKind {
+    REPLAY_CB_LOCATION = 0,
+    REPLAY_CB_SV,
+    REPLAY_CB_NMEA,
+    REPLAY_CB_DATA,
+    REPLAY_CB_MEAS,
+    REPLAY_CB_MAX
+};
+
+static const char* const sReplayCbNames[REPLAY_CB_MAX] = {
+    "location", "sv", "nmea", "data", "measurements"
+};
+
+static uint64_t getMonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t getProcessCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// when the msg in flight was sent; callbacks are measured against it
+static atomic<uint64_t> gLastSendNs(0);
+static mutex gStatsLock;
+// reserved up front, so recording does not allocate while counting
+static vector<uint64_t> gLatencyNs;
+static uint32_t gCbCount[REPLAY_CB_MAX];
+// callbacks that came in after the next msg was sent already
+static uint32_t gOverruns = 0;
+
+static void onReplayCb(ReplayCbKind kind) {
+    uint64_t now = getMonotonicNs();
+    uint64_t sent = gLastSendNs.load(memory_order_acquire);
+    lock_guard<mutex> lock(gStatsLock);
+    gCbCount[kind]++;
+    if (0 == sent) {
+        return;
+    }
+    if (now < sent) {
+        gOverruns++;
+    } else if (gLatencyNs.size() < gLatencyNs.capacity()) {
+        gLatencyNs.push_back(now - sent);
+    }
+}
+
+static uint64_t getPercentile(const vector<uint64_t>& sorted, uint32_t percent) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (sorted.size() - 1) * percent / 100;
+    return sorted[index];
+}
+
+/******************************************************************************
+Hal daemon stand in
+******************************************************************************/
+class ReplayDaemonListener : public ILocIpcListener {
+public:
+    sem_t mRegistered;
+    atomic<uint32_t> mRcvdCount;
+    inline ReplayDaemonListener() : mRcvdCount(0) {
+        sem_init(&mRegistered, 0, 0);
+    }
+    inline virtual ~ReplayDaemonListener() {
+        sem_destroy(&mRegistered);
+    }
+    // the first msg of a client is its registration; the rest, e.g. the start
+    // session request, is taken as it comes and left unanswered
+    inline virtual void onReceive(const char* data, uint32_t length,
+                                  const LocIpcRecver* recver) override {
+        if (1 == ++mRcvdCount) {
+            sem_post(&mRegistered);
+        }
+    }
+};
+
+static bool waitSem(sem_t* sem) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += REPLAY_WAIT_SEC;
+    while (0 != sem_timedwait(sem, &ts)) {
+        if (EINTR != errno) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// client sockets are named <prefix>.<pid>.<client id>
+static string findClientSocket() {
+    string pidTag = "." + to_string(getpid()) + ".";
+    string sockName;
+    DIR* dir = opendir(SOCKET_LOC_CLIENT_DIR);
+    if (nullptr != dir) {
+        struct dirent* entry = nullptr;
+        while (nullptr != (entry = readdir(dir))) {
+            if (nullptr != strstr(entry->d_name, pidTag.c_str())) {
+                sockName = string(SOCKET_LOC_CLIENT_DIR) + entry->d_name;
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return sockName;
+}
+
+static bool loadCapture(const char* fileName, vector<string>& records) {
+    ifstream capture(fileName, ios::binary);
+    if (!capture) {
+        printf("can not open capture %s\n", fileName);
+        return false;
+    }
+    uint32_t length = 0;
+    while (capture.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+        string record(length, '\0');
+        if (!capture.read(&record[0], length)) {
+            printf("capture %s truncated after %zu records\n", fileName, records.size());
+            return false;
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+/******************************************************************************
+Replay
+******************************************************************************/
+static sem_t sCapsReceived;
+
+int runIpcReplay(int argc, char* argv[]) {
+    if (argc < 1) {
+        printf("usage: location_client_api_testapp replay <capture> [rateHz] [loops]\n");
+        return -1;
+    }
+    uint32_t rateHz = (argc >= 2) ? atoi(argv[1]) : REPLAY_DEFAULT_RATE_HZ;
+    uint32_t loops = (argc >= 3) ? atoi(argv[2]) : 1;
+    if (0 == rateHz) {
+        rateHz = REPLAY_DEFAULT_RATE_HZ;
+    }
+    if (0 == loops) {
+        loops = 1;
+    }
+
+    vector<string> records;
+    if (!loadCapture(argv[0], records) || records.size() < 2) {
+        printf("capture needs the capabilities indication and at least one more msg\n");
+        return -1;
+    }
+
+    // stand in for the hal daemon
+    shared_ptr<ReplayDaemonListener> daemon = make_shared<ReplayDaemonListener>();
+    LocIpc daemonIpc;
+    unique_ptr<LocIpcRecver> daemonRecver =
+            LocIpc::getLocIpcLocalRecver(daemon, SOCKET_TO_LOCATION_HAL_DAEMON);
+    if (nullptr == daemonRecver || !daemonIpc.startNonBlockingListening(daemonRecver)) {
+        printf("can not listen on %s, is the hal daemon running?\n",
+               SOCKET_TO_LOCATION_HAL_DAEMON);
+        return -1;
+    }
+
+    sem_init(&sCapsReceived, 0, 0);
+    LocationClientApi* pClient = new LocationClientApi(
+            [](LocationCapabilitiesMask) { sem_post(&sCapsReceived); });
+    string clientSock;
+    if (!waitSem(&daemon->mRegistered) || (clientSock = findClientSocket()).empty()) {
+        printf("client did not register\n");
+        delete pClient;
+        return -1;
+    }
+    shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcLocalSender(clientSock.c_str());
+    if (nullptr == sender ||
+            !LocIpc::send(*sender, (const uint8_t*)records[0].data(), records[0].size()) ||
+            !waitSem(&sCapsReceived)) {
+        printf("client %s did not take the capabilities indication\n", clientSock.c_str());
+        delete pClient;
+        return -1;
+    }
+
+    GnssReportCbs reportCbs;
+    reportCbs.gnssLocationCallback = [](const GnssLocation&) {
+        onReplayCb(REPLAY_CB_LOCATION);
+    };
+    reportCbs.gnssSvCallback = [](const vector<location_client::GnssSv>&) {
+        onReplayCb(REPLAY_CB_SV);
+    };
+    reportCbs.gnssNmeaCallback = [](uint64_t, const string&) { onReplayCb(REPLAY_CB_NMEA); };
+    reportCbs.gnssDataCallback = [](const GnssData&) { onReplayCb(REPLAY_CB_DATA); };
+    reportCbs.gnssMeasurementsCallback = [](const location_client::GnssMeasurements&) {
+        onReplayCb(REPLAY_CB_MEAS);
+    };
+    pClient->startPositionSession(1000 / rateHz, reportCbs, [](LocationResponse) {});
+    usleep(REPLAY_SETTLE_MS * 1000);
+
+    const uint64_t msgCount = (uint64_t)(records.size() - 1) * loops;
+    gLatencyNs.reserve(msgCount * REPLAY_MAX_CB_PER_MSG);
+    const uint64_t periodNs = 1000000000ULL / rateHz;
+    printf("replaying %" PRIu64 " msgs to %s at %u Hz\n", msgCount, clientSock.c_str(), rateHz);
+
+    uint64_t cpuStartNs = getProcessCpuNs();
+    gAllocCount.store(0);
+    gCountAllocs.store(true);
+    uint64_t sendFailures = 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        for (size_t i = 1; i < records.size(); i++) {
+            while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr)) {}
+            gLastSendNs.store(getMonotonicNs(), memory_order_release);
+            if (!LocIpc::send(*sender, (const uint8_t*)records[i].data(), records[i].size())) {
+                sendFailures++;
+            }
+            next.tv_nsec += periodNs;
+            next.tv_sec += next.tv_nsec / 1000000000;
+            next.tv_nsec %= 1000000000;
+        }
+    }
+    usleep(REPLAY_SETTLE_MS * 1000);
+    gCountAllocs.store(false);
+    uint64_t cpuNs = getProcessCpuNs() - cpuStartNs;
+    uint64_t allocCount = gAllocCount.load();
+
+    {
+        lock_guard<mutex> lock(gStatsLock);
+        printf("\n************* replay results *************\n");
+        printf("msgs sent %" PRIu64 ", send failures %" PRIu64 "\n", msgCount, sendFailures);
+        for (int kind = 0; kind < REPLAY_CB_MAX; kind++) {
+            printf("%s callbacks %u\n", sReplayCbNames[kind], gCbCount[kind]);
+        }
+        sort(gLatencyNs.begin(), gLatencyNs.end());
+        printf("callback latency us: p50 %" PRIu64 ", p90 %" PRIu64 ", p99 %" PRIu64
+               ", max %" PRIu64 ", overruns %u\n",
+               getPercentile(gLatencyNs, 50) / 1000, getPercentile(gLatencyNs, 90) / 1000,
+               getPercentile(gLatencyNs, 99) / 1000,
+               gLatencyNs.empty() ? 0 : gLatencyNs.back() / 1000, gOverruns);
+        // process wide, so the replay loop's own share is included
+        printf("per msg: allocations %.1f, cpu us %.1f\n",
+               (double)allocCount / msgCount, (double)cpuNs / msgCount / 1000);
+    }
+    // queue wait and proc() time per msg type of the client's MsgTask, i.e.
+    // the decode latency of each kind of indication
+    MsgTask::dumpStats([](stringstream& ss) { printf("%s", ss.str().c_str()); });
+
+    pClient->stopPositionSession();
+    delete pClient;
+    daemonIpc.stopNonBlockingListening();
+    sem_destroy(&sCapsReceived);
+    return 0;
+}
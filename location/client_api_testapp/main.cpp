@@ -49,6 +49,8 @@
 
 #include <LocationClientApi.h>
 #include <LocationIntegrationApi.h>
+#include "LocIpcReplay.h"
+#include "LocClientStress.h"
 
 using namespace location_client;
 using namespace location_integration;
@@ -579,6 +581,12 @@ static void checkForAutoStart(int argc, char *argv[]) {
 int main(int argc, char *argv[]) {
 
     setRequiredPermToRunAsLocClient();
+    if (argc >= 2 && strncmp(argv[1], "replay", strlen("replay")) == 0) {
+        return runIpcReplay(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && strncmp(argv[1], "stress", strlen("stress")) == 0) {
+        return runClientStress(argc - 2, argv + 2);
+    }
     checkForAutoStart(argc, argv);
 
     // create Location client API
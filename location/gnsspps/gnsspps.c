@@ -40,6 +40,9 @@
 #include <inttypes.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <gnsspps.h>
 
 #define BILLION_NSEC  (1E9)
 
@@ -52,6 +55,17 @@ static struct timespec drsyncUserTs = {0,0};
 
 static struct timespec prevDrsyncKernelTs = {0,0};
 
+/* Ring of the last PPS samples and their statistics. Written by the PPS
+** thread only, and published to readers through ppsSeq, which is odd while
+** an update is in progress; readers retry instead of holding the PPS
+** thread up, so getPPS() takes no lock.*/
+static gnss_pps_sample ppsRing[GNSS_PPS_HISTORY_SIZE];
+static uint32_t ppsRingHead = 0;
+static uint32_t ppsRingCount = 0;
+static int64_t ppsDriftNsPerSec = 0;
+static int64_t ppsJitterNs = 0;
+static atomic_uint ppsSeq;
+
 //flag to stop fetching timestamp
 static int isActive = 0;
 static pthread_t threadId;
@@ -248,6 +262,84 @@ exit0:
 }
 
 
+static inline int64_t convertTimeToNanoSec(pps_sync_time timeToConvert)
+{
+    return (int64_t)timeToConvert.tv_sec * 1000000000LL + timeToConvert.tv_nsec;
+}
+
+/* drift and jitter of the intervals between the pulses in the ring; a gap
+** of several seconds counts as that many intervals */
+static void update_pps_stats()
+{
+    int64_t devs[GNSS_PPS_HISTORY_SIZE];
+    int64_t devSum = 0, absDevSum = 0;
+    uint32_t devCount = 0, i;
+    uint32_t oldest = (ppsRingHead + GNSS_PPS_HISTORY_SIZE - ppsRingCount) %
+            GNSS_PPS_HISTORY_SIZE;
+
+    for (i = 1; i < ppsRingCount; i++) {
+        int64_t prevNs = convertTimeToNanoSec(
+                ppsRing[(oldest + i - 1) % GNSS_PPS_HISTORY_SIZE].kernelTs);
+        int64_t interval = convertTimeToNanoSec(
+                ppsRing[(oldest + i) % GNSS_PPS_HISTORY_SIZE].kernelTs) - prevNs;
+        int64_t seconds = (interval + (int64_t)BILLION_NSEC / 2) / (int64_t)BILLION_NSEC;
+        if (seconds > 0) {
+            devs[devCount] = (interval - seconds * (int64_t)BILLION_NSEC) / seconds;
+            devSum += devs[devCount];
+            devCount++;
+        }
+    }
+    ppsDriftNsPerSec = (devCount > 0) ? devSum / devCount : 0;
+    for (i = 0; i < devCount; i++) {
+        absDevSum += llabs(devs[i] - ppsDriftNsPerSec);
+    }
+    ppsJitterNs = (devCount > 0) ? absDevSum / devCount : 0;
+}
+
+/* called from the PPS thread only */
+static void publish_pps_sample(pps_sync_time kernelTs, pps_sync_time userTs)
+{
+    unsigned int seq = atomic_load_explicit(&ppsSeq, memory_order_relaxed);
+    atomic_store_explicit(&ppsSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    ppsRing[ppsRingHead].kernelTs = kernelTs;
+    ppsRing[ppsRingHead].userTs = userTs;
+    ppsRingHead = (ppsRingHead + 1) % GNSS_PPS_HISTORY_SIZE;
+    if (ppsRingCount < GNSS_PPS_HISTORY_SIZE) {
+        ppsRingCount++;
+    }
+    update_pps_stats();
+
+    atomic_store_explicit(&ppsSeq, seq + 2, memory_order_release);
+}
+
+/* copies up to maxSamples of the newest samples, and the statistics, into
+** history; a zero sample stands in for the newest before the first pulse */
+static void read_pps_history(gnss_pps_history *history, uint32_t maxSamples)
+{
+    unsigned int seq;
+    uint32_t i;
+
+    do {
+        while ((seq = atomic_load_explicit(&ppsSeq, memory_order_acquire)) & 1) {
+            /* PPS thread is updating, for a few hundred nsec at most */
+        }
+        history->count = (ppsRingCount < maxSamples) ? ppsRingCount : maxSamples;
+        for (i = 0; i < history->count; i++) {
+            history->samples[i] = ppsRing[(ppsRingHead + GNSS_PPS_HISTORY_SIZE - 1 - i) %
+                    GNSS_PPS_HISTORY_SIZE];
+        }
+        history->driftNsPerSec = ppsDriftNsPerSec;
+        history->jitterNs = ppsJitterNs;
+        atomic_thread_fence(memory_order_acquire);
+    } while (seq != atomic_load_explicit(&ppsSeq, memory_order_relaxed));
+
+    if (0 == history->count) {
+        memset(&history->samples[0], 0, sizeof(history->samples[0]));
+    }
+}
+
 /* fetches the timestamp from the PPS source */
 int read_pps(pps_handle *handle)
 {
@@ -288,12 +380,10 @@ int read_pps(pps_handle *handle)
         return 0;
     }
     /* update dr syncpulse time*/
-
-    pthread_mutex_lock(&ts_lock);
-
     ret = compute_real_to_boot_time(infobuf);
-
-    pthread_mutex_unlock(&ts_lock);
+    if (0 == ret) {
+        publish_pps_sample(drsyncKernelTs, drsyncUserTs);
+    }
 
     return 0;
 }
@@ -374,20 +464,17 @@ int getPPS(struct timespec *fineKernelTs ,struct timespec *currentTs,
            struct timespec *fineUserTs)
 {
     int ret = 0;
+    gnss_pps_history latest;
 
-    pthread_mutex_lock(&ts_lock);
     if (0 != isActive) {
-        fineKernelTs->tv_sec = drsyncKernelTs.tv_sec;
-        fineKernelTs->tv_nsec = drsyncKernelTs.tv_nsec;
-
-        fineUserTs->tv_sec = drsyncUserTs.tv_sec;
-        fineUserTs->tv_nsec = drsyncUserTs.tv_nsec;
+        read_pps_history(&latest, 1);
+        *fineKernelTs = latest.samples[0].kernelTs;
+        *fineUserTs = latest.samples[0].userTs;
 
         ret = clock_gettime(CLOCK_BOOTTIME,currentTs);
     } else {
        LOC_LOGV("%s:%d No active thread to read PPS - call initPPS first", __func__, __LINE__);
     }
-    pthread_mutex_unlock(&ts_lock);
     if(ret != 0)
     {
        LOC_LOGV("%s:%d clock_gettime() error",__func__,__LINE__);
@@ -396,6 +483,16 @@ int getPPS(struct timespec *fineKernelTs ,struct timespec *currentTs,
     return 1;
 }
 
+int getPPSHistory(gnss_pps_history *history)
+{
+    if (NULL == history || 0 == isActive) {
+       LOC_LOGV("%s:%d No active thread to read PPS - call initPPS first", __func__, __LINE__);
+       return 0;
+    }
+    read_pps_history(history, GNSS_PPS_HISTORY_SIZE);
+    return 1;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,16 +28,42 @@
 #ifndef _GNSSPPS_H
 #define _GNSSPPS_H
 
+#include <stdint.h>
+#include <time.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* number of PPS samples kept for getPPSHistory() */
+#define GNSS_PPS_HISTORY_SIZE 16
+
+typedef struct {
+    /* PPS edge, CLOCK_BOOTTIME */
+    struct timespec kernelTs;
+    /* when the edge was read in userspace, CLOCK_BOOTTIME */
+    struct timespec userTs;
+} gnss_pps_sample;
+
+typedef struct {
+    /* valid entries in samples, newest first */
+    uint32_t count;
+    gnss_pps_sample samples[GNSS_PPS_HISTORY_SIZE];
+    /* mean deviation of the pulse interval from 1 sec, in nsec per sec */
+    int64_t driftNsPerSec;
+    /* mean absolute deviation of the pulse interval from that, in nsec */
+    int64_t jitterNs;
+} gnss_pps_history;
+
 /*  opens the device and fetches from PPS source */
 int initPPS(char *devname);
 /* updates the fine time stamp */
 int getPPS(struct timespec *current_ts, struct timespec *current_boottime, struct timespec *last_boottime);
 /* stops fetching and closes the device */
 void deInitPPS();
+/* copies the last PPS samples and their statistics, without blocking the
+   PPS thread; returns 1 on success, 0 if PPS is not running */
+int getPPSHistory(gnss_pps_history *history);
 
 #ifdef __cplusplus
 }
@@ -82,6 +82,10 @@ enum LocConfigTypeEnum{
     /** Config user consent to use GTP terrestrial positioning
      *  service. <br/> */
     CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING = 12,
+    /** Apply the configuration requests made between
+     *  LocationIntegrationApi::beginConfig() and
+     *  LocationIntegrationApi::commit(). <br/> */
+    CONFIG_TRANSACTION = 13,
 
     /** Get configuration regarding robust location setting used by
      *  the GNSS standard position engine (SPE).  <br/> */
@@ -1165,6 +1169,51 @@ public:
     */
     bool setUserConsentForTerrestrialPositioning(bool userConsent);
 
+    /** @brief
+        Begin a configuration transaction. <br/>
+
+        The configuration requests made after this call, e.g.:
+        configConstellations(), configLeverArm() and
+        configMinSvElevation(), are held back, until commit() is
+        called. commit() then sends all of them to the location
+        stack in one message, to be applied in the order they were
+        made. This way, a client that provisions many settings,
+        e.g.: at boot up, needs one round trip instead of one per
+        setting. <br/>
+
+        LocConfigCb() is not invoked for the requests of a
+        transaction; it is invoked once, with configType set to
+        CONFIG_TRANSACTION, when all of them have been processed.
+        <br/>
+
+        Requests to get a configuration, e.g.:
+        getRobustLocationConfig(), are not part of the transaction
+        and are sent right away. <br/>
+
+        @return true, if the API request has been accepted. <br/>
+
+        @return false, if the API request has not been accepted for
+                further processing. <br/>
+    */
+    bool beginConfig();
+
+    /** @brief
+        Commit the configuration transaction started with
+        beginConfig(). <br/>
+
+        @return true, if the API request has been accepted. The
+                status will be returned via LocConfigCb() with
+                configType set to CONFIG_TRANSACTION. The status is
+                LOC_INT_RESPONSE_SUCCESS only if all requests of the
+                transaction have been processed successfully. <br/>
+
+        @return false, if the API request has not been accepted for
+                further processing, e.g.: there is no transaction to
+                commit. When returning false, LocConfigCb() will not
+                be invoked. <br/>
+    */
+    bool commit();
+
 private:
     LocationIntegrationApiImpl* mApiImpl;
 };
@@ -556,5 +556,23 @@ bool LocationIntegrationApi::setUserConsentForTerrestrialPositioning(bool userCo
     }
 }
 
+bool LocationIntegrationApi::beginConfig() {
+    if (mApiImpl) {
+        return (mApiImpl->beginConfig() == 0);
+    } else {
+        LOC_LOGe ("NULL mApiImpl");
+        return false;
+    }
+}
+
+bool LocationIntegrationApi::commit() {
+    if (mApiImpl) {
+        return (mApiImpl->commitConfig() == 0);
+    } else {
+        LOC_LOGe ("NULL mApiImpl");
+        return false;
+    }
+}
+
 } // namespace location_integration
 
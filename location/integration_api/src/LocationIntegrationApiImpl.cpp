@@ -31,12 +31,18 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <loc_cfg.h>
+#include <loc_misc_utils.h>
 #include <LocationIntegrationApiImpl.h>
 #include <log_util.h>
 #include <gps_extended_c.h>
 
 namespace location_integration {
 
+// how long an answer to a get request is returned from the cache; the settings
+// can also be changed by other clients of the location stack and, for the min
+// gps week, by the modem itself, which no indication tells about
+#define CONFIG_GET_CACHE_MAX_AGE_MS (30000)
+
 /******************************************************************************
 Utilities
 ******************************************************************************/
@@ -80,6 +86,9 @@ static LocConfigTypeEnum getLocConfigTypeFromMsgId(ELocMsgID  msgId) {
     case E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID:
         configType = CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING;
         break;
+    case E_INTAPI_CONFIG_BATCH_MSG_ID:
+        configType = CONFIG_TRANSACTION;
+        break;
     case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID:
     case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_RESP_MSG_ID:
         configType = GET_ROBUST_LOCATION_CONFIG;
@@ -200,6 +209,11 @@ LocationIntegrationApiImpl::LocationIntegrationApiImpl(LocIntegrationCbs& integr
         mLeverArmConfigInfo{},
         mRobustLocationConfigInfo{},
         mDreConfigInfo{},
+        mRobustLocationConfigCache{},
+        mMinGpsWeekCache(0),
+        mMinSvElevationCache(0),
+        mSecondaryBandConfigCache{},
+        mInConfigTransaction(false),
         mMsgTask("IntegrationApiImpl"),
         mGtpUserConsentConfigInfo{} {
     if (integrationClientAllowed() == false) {
@@ -242,7 +256,7 @@ LocationIntegrationApiImpl::LocationIntegrationApiImpl(LocIntegrationCbs& integr
 
     LOC_LOGd("create sender socket: %s", mSocketName);
     // establish an ipc sender to the hal daemon
-    mIpcSender = LocIpc::getLocIpcLocalSender(SOCKET_TO_LOCATION_HAL_DAEMON);
+    mIpcSender = LocIpc::getSharedLocIpcLocalSender(SOCKET_TO_LOCATION_HAL_DAEMON);
     if (mIpcSender == nullptr) {
         LOC_LOGe("create sender socket failed %s", SOCKET_TO_LOCATION_HAL_DAEMON);
         return;
@@ -252,10 +266,12 @@ LocationIntegrationApiImpl::LocationIntegrationApiImpl(LocIntegrationCbs& integr
 #endif //  FEATURE_EXTERNAL_AP
 
     LOC_LOGd("listen on socket: %s", mSocketName);
-    mIpc.startNonBlockingListening(recver);
+    LocIpcReactor::getProcessReactor().add(recver, this);
 }
 
 LocationIntegrationApiImpl::~LocationIntegrationApiImpl() {
+    // the listener refers to this client, so it must be gone first
+    LocIpcReactor::getProcessReactor().removeOwner(this);
 }
 
 void LocationIntegrationApiImpl::destroy() {
@@ -378,6 +394,7 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_INTAPI_CONFIG_MIN_SV_ELEVATION_MSG_ID:
             case E_INTAPI_CONFIG_ENGINE_RUN_STATE_MSG_ID:
             case E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID:
+            case E_INTAPI_CONFIG_BATCH_MSG_ID:
             case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID:
             case E_INTAPI_GET_MIN_GPS_WEEK_REQ_MSG_ID:
             case E_INTAPI_GET_MIN_SV_ELEVATION_REQ_MSG_ID:
@@ -549,6 +566,11 @@ uint32_t LocationIntegrationApiImpl::getConstellationSecondaryBandConfig() {
                 mApiImpl(apiImpl) {}
         virtual ~GetConstellationSecondaryBandConfigReq() {}
         void proc() const {
+            if (mApiImpl->isConfigGetCached(GET_CONSTELLATION_SECONDARY_BAND_CONFIG)) {
+                mApiImpl->deliverConstellationSecondaryBandConfig(
+                        mApiImpl->mSecondaryBandConfigCache);
+                return;
+            }
             string pbStr;
             LocConfigGetConstellationSecondaryBandConfigReqMsg msg(mApiImpl->mSocketName,
                     &mApiImpl->mPbufMsgConv);
@@ -753,6 +775,10 @@ uint32_t LocationIntegrationApiImpl::getRobustLocationConfig() {
                 mApiImpl(apiImpl) {}
         virtual ~GetRobustLocationConfigReq() {}
         void proc() const {
+            if (mApiImpl->isConfigGetCached(GET_ROBUST_LOCATION_CONFIG)) {
+                mApiImpl->deliverRobustLocationConfig(mApiImpl->mRobustLocationConfigCache);
+                return;
+            }
             string pbStr;
             LocConfigGetRobustLocationConfigReqMsg msg(mApiImpl->mSocketName,
                     &mApiImpl->mPbufMsgConv);
@@ -811,6 +837,10 @@ uint32_t LocationIntegrationApiImpl::getMinGpsWeek() {
                 mApiImpl(apiImpl) {}
         virtual ~GetMinGpsWeekReq() {}
         void proc() const {
+            if (mApiImpl->isConfigGetCached(GET_MIN_GPS_WEEK)) {
+                mApiImpl->mIntegrationCbs.getMinGpsWeekCb(mApiImpl->mMinGpsWeekCache);
+                return;
+            }
             string pbStr;
             LocConfigGetMinGpsWeekReqMsg msg(mApiImpl->mSocketName, &mApiImpl->mPbufMsgConv);
             if (msg.serializeToProtobuf(pbStr)) {
@@ -900,6 +930,10 @@ uint32_t LocationIntegrationApiImpl::getMinSvElevation() {
                 mApiImpl(apiImpl) {}
         virtual ~GetMinSvElevationReq() {}
         void proc() const {
+            if (mApiImpl->isConfigGetCached(GET_MIN_SV_ELEVATION)) {
+                mApiImpl->mIntegrationCbs.getMinSvElevationCb(mApiImpl->mMinSvElevationCache);
+                return;
+            }
             string pbStr;
             LocConfigGetMinSvElevationReqMsg msg(mApiImpl->mSocketName, &mApiImpl->mPbufMsgConv);
             if (msg.serializeToProtobuf(pbStr)) {
@@ -990,16 +1024,87 @@ uint32_t LocationIntegrationApiImpl::setUserConsentForTerrestrialPositioning(boo
     return 0;
 }
 
+uint32_t LocationIntegrationApiImpl::beginConfig() {
+    struct BeginConfigReq : public LocMsg {
+        BeginConfigReq(LocationIntegrationApiImpl* apiImpl) :
+                mApiImpl(apiImpl) {}
+        virtual ~BeginConfigReq() {}
+        void proc() const {
+            if (mApiImpl->mInConfigTransaction) {
+                LOC_LOGw("config transaction of %zu requests already open",
+                         mApiImpl->mConfigTransactionMsgs.size());
+            }
+            mApiImpl->mInConfigTransaction = true;
+        }
+
+        LocationIntegrationApiImpl* mApiImpl;
+    };
+
+    mMsgTask.sendMsg(new (nothrow) BeginConfigReq(this));
+    return 0;
+}
+
+uint32_t LocationIntegrationApiImpl::commitConfig() {
+    struct CommitConfigReq : public LocMsg {
+        CommitConfigReq(LocationIntegrationApiImpl* apiImpl) :
+                mApiImpl(apiImpl) {}
+        virtual ~CommitConfigReq() {}
+        void proc() const {
+            if (!mApiImpl->mInConfigTransaction) {
+                LOC_LOGe("no config transaction to commit");
+                return;
+            }
+            mApiImpl->mInConfigTransaction = false;
+            if (mApiImpl->mConfigTransactionMsgs.empty()) {
+                if (mApiImpl->mIntegrationCbs.configCb) {
+                    mApiImpl->mIntegrationCbs.configCb(CONFIG_TRANSACTION,
+                                                       LOC_INT_RESPONSE_SUCCESS);
+                }
+                return;
+            }
+
+            string pbStr;
+            LocConfigBatchReqMsg msg(mApiImpl->mSocketName,
+                                     std::move(mApiImpl->mConfigTransactionMsgs),
+                                     &mApiImpl->mPbufMsgConv);
+            mApiImpl->mConfigTransactionMsgs.clear();
+            if (msg.serializeToProtobuf(pbStr)) {
+                mApiImpl->sendConfigMsgToHalDaemon(CONFIG_TRANSACTION,
+                        reinterpret_cast<uint8_t*>((uint8_t *)pbStr.c_str()), pbStr.size());
+            } else {
+                LOC_LOGe("LocConfigBatchReqMsg serializeToProtobuf failed");
+            }
+        }
+
+        LocationIntegrationApiImpl* mApiImpl;
+    };
+
+    mMsgTask.sendMsg(new (nothrow) CommitConfigReq(this));
+    return 0;
+}
+
 void LocationIntegrationApiImpl::sendConfigMsgToHalDaemon(
         LocConfigTypeEnum configType, uint8_t* pMsg,
         size_t msgSize, bool invokeResponseCb) {
 
+    invalidateConfigGetCache(configType);
+
+    // config requests of an open transaction are sent, and answered, as one
+    // batch on commit; requests to get a config are not part of it
+    if (mInConfigTransaction && configType < GET_ROBUST_LOCATION_CONFIG) {
+        mConfigTransactionMsgs.emplace_back(reinterpret_cast<const char*>(pMsg), msgSize);
+        return;
+    }
+
     bool messageSentToHal = false;
     if (mHalRegistered) {
         bool rc = sendMessage(pMsg, msgSize);
         LOC_LOGd(">>> sendConfigMsgToHalDaemon, msg type=%d, rc=%d", configType, rc);
         if (true == rc) {
             messageSentToHal = true;
+            if (configType >= GET_ROBUST_LOCATION_CONFIG) {
+                mConfigGetCache[configType].pendingGets++;
+            }
         } else {
             LOC_LOGe(">>> sendConfigMsgToHalDaemon failed for msg type=%d", configType);
         }
@@ -1029,134 +1134,104 @@ void LocationIntegrationApiImpl::sendClientRegMsgToHalDaemon(){
     }
 }
 
+// serializes a config request into the snapshot that is replayed on hal
+// daemon restart
+static void addToConfigSnapshot(vector<string>& snapshot, LocAPIMsgHeader& msg) {
+    string pbStr;
+    if (msg.serializeToProtobuf(pbStr)) {
+        snapshot.push_back(std::move(pbStr));
+    } else {
+        LOC_LOGe("msg id %d serializeToProtobuf failed", msg.msgId);
+    }
+}
+
 void LocationIntegrationApiImpl::processHalReadyMsg() {
     // when location hal daemon crashes and restarts,
     // we flush out all pending requests and notify each client
     // that the request has failed.
     flushConfigReqs();
+    // the pending get requests are not going to be answered, and the
+    // settings may have been reset
+    mConfigGetCache.clear();
 
     // register with hal daemon
     sendClientRegMsgToHalDaemon();
 
-    // send cached configuration to hal daemon
+    // send cached configuration to hal daemon, one request per config type,
+    // all in one batch with one response
+    vector<string> snapshot;
     if (mSvConfigInfo.isValid) {
-        string pbStrLocConfigSvConst;
         LocConfigSvConstellationReqMsg msg(mSocketName,
                                            mSvConfigInfo.constellationEnablementConfig,
                                            mSvConfigInfo.blacklistSvConfig,
                                            &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocConfigSvConst)) {
-            sendConfigMsgToHalDaemon(CONFIG_CONSTELLATIONS,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocConfigSvConst.c_str()),
-                    pbStrLocConfigSvConst.size());
-        } else {
-            LOC_LOGe("LocConfigSvConstellationReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
-
     if (mSvConfigInfo.secondaryBandConfig.size != 0) {
-        string pbStrLocConfigConstSecndBandReq;
         LocConfigConstellationSecondaryBandReqMsg msg(
                     mSocketName, mSvConfigInfo.secondaryBandConfig, &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocConfigConstSecndBandReq)) {
-            sendConfigMsgToHalDaemon(CONFIG_CONSTELLATION_SECONDARY_BAND,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocConfigConstSecndBandReq.c_str()),
-                    pbStrLocConfigConstSecndBandReq.size());
-        } else {
-            LOC_LOGe("LocConfigConstellationSecondaryBandReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
-
     if (mTuncConfigInfo.isValid) {
-        string pbStrLocConfigConstTunc;
         LocConfigConstrainedTuncReqMsg msg(mSocketName,
                                            mTuncConfigInfo.enable,
                                            mTuncConfigInfo.tuncThresholdMs,
                                            mTuncConfigInfo.energyBudget,
                                            &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocConfigConstTunc)) {
-            sendConfigMsgToHalDaemon(CONFIG_CONSTRAINED_TIME_UNCERTAINTY,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocConfigConstTunc.c_str()),
-                    pbStrLocConfigConstTunc.size());
-        } else {
-            LOC_LOGe("LocConfigConstrainedTuncReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
     if (mPaceConfigInfo.isValid) {
-        string pbStrLocConfigPosAsstdClockEst;
         LocConfigPositionAssistedClockEstimatorReqMsg msg(mSocketName,
                                                           mPaceConfigInfo.enable,
                                                           &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocConfigPosAsstdClockEst)) {
-            sendConfigMsgToHalDaemon(CONFIG_POSITION_ASSISTED_CLOCK_ESTIMATOR,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocConfigPosAsstdClockEst.c_str()),
-                    pbStrLocConfigPosAsstdClockEst.size());
-        } else {
-            LOC_LOGe("LocConfigPositionAssistedClockEstimatorReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
     if (mLeverArmConfigInfo.leverArmValidMask) {
-        string pbStrLocConfigLeverArm;
         LocConfigLeverArmReqMsg msg(mSocketName, mLeverArmConfigInfo, &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocConfigLeverArm)) {
-            sendConfigMsgToHalDaemon(CONFIG_LEVER_ARM,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocConfigLeverArm.c_str()),
-                    pbStrLocConfigLeverArm.size());
-        } else {
-            LOC_LOGe("LocConfigLeverArmReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
     if (mRobustLocationConfigInfo.isValid) {
-        string pbStrLocConfigRobustLoc;
         LocConfigRobustLocationReqMsg msg(mSocketName,
                                           mRobustLocationConfigInfo.enable,
                                           mRobustLocationConfigInfo.enableForE911,
                                           &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocConfigRobustLoc)) {
-            sendConfigMsgToHalDaemon(CONFIG_ROBUST_LOCATION,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocConfigRobustLoc.c_str()),
-                    pbStrLocConfigRobustLoc.size());
-        } else {
-            LOC_LOGe("LocConfigRobustLocationReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
     // Do not reconfigure min gps week, as min gps week setting
     // can be overwritten by modem over  time
 
     if (mDreConfigInfo.isValid) {
-        string pbStrLocCfgDrEngParam;
         LocConfigDrEngineParamsReqMsg msg(mSocketName, mDreConfigInfo.dreConfig, &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocCfgDrEngParam)) {
-            sendConfigMsgToHalDaemon(CONFIG_DEAD_RECKONING_ENGINE,
-                             reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocCfgDrEngParam.c_str()),
-                             pbStrLocCfgDrEngParam.size());
-        } else {
-            LOC_LOGe("LocConfigDrEngineParamsReqMsg serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
-
     if (mGtpUserConsentConfigInfo.isValid) {
-        string pbStr;
         LocConfigUserConsentTerrestrialPositioningReqMsg msg(
                     mSocketName, mGtpUserConsentConfigInfo.userConsent, &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            sendConfigMsgToHalDaemon(CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING,
-                        reinterpret_cast<uint8_t*>((uint8_t *)pbStr.c_str()), pbStr.size());
-        } else {
-            LOC_LOGe("serializeToProtobuf failed");
-        }
+        addToConfigSnapshot(snapshot, msg);
     }
-
-    // send down engine state config request
+    // engine state config, the last state requested per engine
     for (auto it = mEngRunStateConfigMap.begin(); it != mEngRunStateConfigMap.end(); ++it) {
-        string pbStrLocCfgEngineRunState;
         LocConfigEngineRunStateReqMsg msg(mSocketName, it->first, it->second, &mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStrLocCfgEngineRunState)) {
-            sendConfigMsgToHalDaemon(
-                    CONFIG_ENGINE_RUN_STATE,
-                    reinterpret_cast<uint8_t*>((uint8_t *)pbStrLocCfgEngineRunState.c_str()),
-                    pbStrLocCfgEngineRunState.size());
+        addToConfigSnapshot(snapshot, msg);
+    }
+
+    if (snapshot.empty() || !mHalRegistered) {
+        return;
+    }
+    LOC_LOGd(">>> replay %zu cached config requests", snapshot.size());
+    // the replay was not requested by the client, so its response is not
+    // delivered to it; this also keeps it out of any transaction the client
+    // has open
+    string pbStr;
+    LocConfigBatchReqMsg msg(mSocketName, std::move(snapshot), &mPbufMsgConv);
+    if (msg.serializeToProtobuf(pbStr)) {
+        bool rc = sendMessage(reinterpret_cast<uint8_t*>((uint8_t *)pbStr.c_str()),
+                              pbStr.size());
+        if (!rc) {
+            LOC_LOGe(">>> replay of cached config failed");
         }
+    } else {
+        LOC_LOGe("LocConfigBatchReqMsg serializeToProtobuf failed");
     }
 }
 
@@ -1180,6 +1255,10 @@ void LocationIntegrationApiImpl::processConfigRespCb(const LocAPIGenericRespMsg*
              "config type: %d, int response %d",
              pRespMsg->msgId, pRespMsg->err, configType, intResponse);
 
+    if (configType >= GET_ROBUST_LOCATION_CONFIG && LOC_INT_RESPONSE_SUCCESS != intResponse) {
+        updateConfigGetCache(configType, false);
+    }
+
     if (mIntegrationCbs.configCb) {
         auto configReqData = mConfigReqCntMap.find(configType);
         if (configReqData != std::end(mConfigReqCntMap)) {
@@ -1218,25 +1297,33 @@ void LocationIntegrationApiImpl::processGetRobustLocationConfigRespCb(
              pRespMsg->mRobustLoationConfig.enabled,
              pRespMsg->mRobustLoationConfig.enabledForE911);
 
+    mRobustLocationConfigCache = pRespMsg->mRobustLoationConfig;
+    updateConfigGetCache(GET_ROBUST_LOCATION_CONFIG, true);
+    deliverRobustLocationConfig(pRespMsg->mRobustLoationConfig);
+}
+
+void LocationIntegrationApiImpl::deliverRobustLocationConfig(
+        const GnssConfigRobustLocation& robustLocationConfig) {
+
     if (mIntegrationCbs.getRobustLocationConfigCb) {
         // conversion between the enums
         RobustLocationConfig robustConfig = {};
         uint32_t validMask = 0;;
-        if (pRespMsg->mRobustLoationConfig.validMask &
+        if (robustLocationConfig.validMask &
                 GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT) {
             validMask |= ROBUST_LOCATION_CONFIG_VALID_ENABLED;
-            robustConfig.enabled = pRespMsg->mRobustLoationConfig.enabled;
+            robustConfig.enabled = robustLocationConfig.enabled;
         }
-        if (pRespMsg->mRobustLoationConfig.validMask &
+        if (robustLocationConfig.validMask &
                 GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT) {
             validMask |= ROBUST_LOCATION_CONFIG_VALID_ENABLED_FOR_E911;
-            robustConfig.enabledForE911 = pRespMsg->mRobustLoationConfig.enabledForE911;
+            robustConfig.enabledForE911 = robustLocationConfig.enabledForE911;
         }
-        if (pRespMsg->mRobustLoationConfig.validMask &
+        if (robustLocationConfig.validMask &
                 GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT) {
             validMask |= ROBUST_LOCATION_CONFIG_VALID_VERSION;
-            robustConfig.version.major = pRespMsg->mRobustLoationConfig.version.major;
-            robustConfig.version.minor = pRespMsg->mRobustLoationConfig.version.minor;
+            robustConfig.version.major = robustLocationConfig.version.major;
+            robustConfig.version.minor = robustLocationConfig.version.minor;
         }
 
         robustConfig.validMask = (RobustLocationConfigValidMask) validMask;
@@ -1249,6 +1336,8 @@ void LocationIntegrationApiImpl::processGetMinGpsWeekRespCb(
 
     LOC_LOGd("<<< response message id: %d, min gps week: %d",
              pRespMsg->msgId, pRespMsg->mMinGpsWeek);
+    mMinGpsWeekCache = pRespMsg->mMinGpsWeek;
+    updateConfigGetCache(GET_MIN_GPS_WEEK, true);
     if (mIntegrationCbs.getMinGpsWeekCb) {
         mIntegrationCbs.getMinGpsWeekCb(pRespMsg->mMinGpsWeek);
     }
@@ -1259,6 +1348,8 @@ void LocationIntegrationApiImpl::processGetMinSvElevationRespCb(
 
     LOC_LOGd("<<< response message id: %d, min sv elevation: %d",
              pRespMsg->msgId, pRespMsg->mMinSvElevation);
+    mMinSvElevationCache = pRespMsg->mMinSvElevation;
+    updateConfigGetCache(GET_MIN_SV_ELEVATION, true);
     if (mIntegrationCbs.getMinSvElevationCb) {
         mIntegrationCbs.getMinSvElevationCb(pRespMsg->mMinSvElevation);
     }
@@ -1290,13 +1381,21 @@ static bool isBitMaskSetForConstellation(
 void LocationIntegrationApiImpl::processGetConstellationSecondaryBandConfigRespCb(
     const LocConfigGetConstellationSecondaryBandConfigRespMsg* pRespMsg) {
 
+    mSecondaryBandConfigCache = pRespMsg->mSecondaryBandConfig;
+    updateConfigGetCache(GET_CONSTELLATION_SECONDARY_BAND_CONFIG, true);
+    deliverConstellationSecondaryBandConfig(pRespMsg->mSecondaryBandConfig);
+}
+
+void LocationIntegrationApiImpl::deliverConstellationSecondaryBandConfig(
+        const GnssSvTypeConfig& secondaryBandConfig) {
+
     if (mIntegrationCbs.getConstellationSecondaryBandConfigCb) {
         ConstellationSet secondaryBandDisablementSet;
 
-        if (pRespMsg->mSecondaryBandConfig.size != 0) {
+        if (secondaryBandConfig.size != 0) {
             uint32_t constellationType = 0;
             GnssSvTypesMask secondaryBandDisabledMask =
-                    pRespMsg->mSecondaryBandConfig.blacklistedSvTypesMask;
+                    secondaryBandConfig.blacklistedSvTypesMask;
 
             LOC_LOGd("secondary band disabled mask: 0x%" PRIx64 "", secondaryBandDisabledMask);
             for (;constellationType <= GNSS_CONSTELLATION_TYPE_MAX; constellationType++) {
@@ -1311,6 +1410,64 @@ void LocationIntegrationApiImpl::processGetConstellationSecondaryBandConfigRespC
     }
 }
 
+bool LocationIntegrationApiImpl::isConfigGetCached(LocConfigTypeEnum getType) {
+    auto cacheState = mConfigGetCache.find(getType);
+    if (cacheState == std::end(mConfigGetCache) || !cacheState->second.isValid) {
+        return false;
+    }
+    if (getBootTimeMilliSec() - cacheState->second.updateTimeMs > CONFIG_GET_CACHE_MAX_AGE_MS) {
+        cacheState->second.isValid = false;
+        return false;
+    }
+    LOC_LOGd("config type %d answered from cache", getType);
+    return true;
+}
+
+// a get request has been answered, with the value when isAnswered is true,
+// or with an error
+void LocationIntegrationApiImpl::updateConfigGetCache(LocConfigTypeEnum getType,
+                                                      bool isAnswered) {
+    ConfigGetCacheState& cacheState = mConfigGetCache[getType];
+    if (isAnswered && !cacheState.pendingGetsStale) {
+        cacheState.isValid = true;
+        cacheState.updateTimeMs = getBootTimeMilliSec();
+    }
+    if (cacheState.pendingGets > 0) {
+        cacheState.pendingGets--;
+    }
+    if (0 == cacheState.pendingGets) {
+        cacheState.pendingGetsStale = false;
+    }
+}
+
+void LocationIntegrationApiImpl::invalidateConfigGetCache(LocConfigTypeEnum configType) {
+    LocConfigTypeEnum getType;
+    switch (configType) {
+    case CONFIG_ROBUST_LOCATION:
+        getType = GET_ROBUST_LOCATION_CONFIG;
+        break;
+    case CONFIG_MIN_GPS_WEEK:
+        getType = GET_MIN_GPS_WEEK;
+        break;
+    case CONFIG_MIN_SV_ELEVATION:
+        getType = GET_MIN_SV_ELEVATION;
+        break;
+    case CONFIG_CONSTELLATIONS:
+    case CONFIG_CONSTELLATION_SECONDARY_BAND:
+        getType = GET_CONSTELLATION_SECONDARY_BAND_CONFIG;
+        break;
+    default:
+        return;
+    }
+    auto cacheState = mConfigGetCache.find(getType);
+    if (cacheState != std::end(mConfigGetCache)) {
+        cacheState->second.isValid = false;
+        if (cacheState->second.pendingGets > 0) {
+            cacheState->second.pendingGetsStale = true;
+        }
+    }
+}
+
 /******************************************************************************
 LocationIntegrationApiImpl - Not implemented ILocationControlAPI functions
 ******************************************************************************/
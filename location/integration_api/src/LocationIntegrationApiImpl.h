@@ -89,6 +89,19 @@ typedef struct {
     bool userConsent;
 } GtpUserConsentConfigInfo;
 
+// state of the cached answer to one of the get requests
+typedef struct {
+    bool     isValid;
+    uint64_t updateTimeMs;
+    // get requests sent to the hal daemon and not yet answered
+    uint32_t pendingGets;
+    // a config request that may change the value was sent while get requests
+    // were pending, so their answers may predate it and are not cached
+    bool     pendingGetsStale;
+} ConfigGetCacheState;
+
+typedef std::unordered_map<LocConfigTypeEnum, ConfigGetCacheState> LocConfigGetCacheMap;
+
 class IpcListener;
 
 class LocationIntegrationApiImpl : public ILocationControlAPI {
@@ -133,6 +146,9 @@ public:
 
     uint32_t setUserConsentForTerrestrialPositioning(bool userConsent);
 
+    uint32_t beginConfig();
+    uint32_t commitConfig();
+
 private:
     ~LocationIntegrationApiImpl();
     bool integrationClientAllowed();
@@ -153,6 +169,13 @@ private:
     void processGetConstellationSecondaryBandConfigRespCb(
             const LocConfigGetConstellationSecondaryBandConfigRespMsg* pRespMsg);
 
+    // cache of the answers to the get requests
+    bool isConfigGetCached(LocConfigTypeEnum getType);
+    void updateConfigGetCache(LocConfigTypeEnum getType, bool isAnswered);
+    void invalidateConfigGetCache(LocConfigTypeEnum configType);
+    void deliverRobustLocationConfig(const GnssConfigRobustLocation& robustLocationConfig);
+    void deliverConstellationSecondaryBandConfig(const GnssSvTypeConfig& secondaryBandConfig);
+
     // protobuf conversion util class
     LocationApiPbMsgConv mPbufMsgConv;
 
@@ -178,9 +201,20 @@ private:
     GtpUserConsentConfigInfo      mGtpUserConsentConfigInfo;
 
     LocConfigReqCntMap       mConfigReqCntMap;
+    // last answers to the get requests, returned without a round trip to the
+    // hal daemon until a config request may have changed them
+    LocConfigGetCacheMap     mConfigGetCache;
+    GnssConfigRobustLocation mRobustLocationConfigCache;
+    uint16_t                 mMinGpsWeekCache;
+    uint8_t                  mMinSvElevationCache;
+    GnssSvTypeConfig         mSecondaryBandConfigCache;
+    // config requests held back by an open transaction, sent on commit
+    bool                     mInConfigTransaction;
+    vector<string>           mConfigTransactionMsgs;
     LocIntegrationCbs        mIntegrationCbs;
 
-    LocIpc                   mIpc;
+    // served by the process wide LocIpcReactor, shared with the
+    // LocationClientApi instances of the process
     shared_ptr<LocIpcSender> mIpcSender;
 
     MsgTask                  mMsgTask;
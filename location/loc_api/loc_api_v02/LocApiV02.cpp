@@ -36,6 +36,7 @@
 #include <math.h>
 #include <dlfcn.h>
 #include <algorithm>
+#include <unistd.h>
 
 #include <LocApiV02.h>
 #include <loc_api_v02_log.h>
@@ -45,10 +46,13 @@
 #include <gps_extended.h>
 #include "loc_pla.h"
 #include <loc_cfg.h>
+#include <LocConvUtils.h>
 #include <LocContext.h>
 
 using namespace std;
 using namespace loc_core;
+using loc_util::LocMaskBitMap;
+using loc_util::convertMaskBits;
 
 /* Doppler Conversion from M/S to NS/S */
 #define MPS_TO_NSPS         (1.0/0.299792458)
@@ -97,9 +101,19 @@ using namespace loc_core;
 /* the time, in seconds, to wait for user response for NI  */
 #define LOC_NI_NO_RESPONSE_TIME 20
 
+/* event indications queued for conversion, and idle buffers kept for them */
+#define LOC_API_V02_IND_MSG_TASK_RING_SIZE 64
+#define LOC_API_V02_IND_BUFFER_POOL_SIZE   8
+
 #define LAT_LONG_TO_RADIANS .000005364418
 #define GF_RESPONSIVENESS_THRESHOLD_MSEC_HIGH   120000 //2 mins
 #define GF_RESPONSIVENESS_THRESHOLD_MSEC_MEDIUM 900000 //15 mins
+/* geofence requests kept in flight, by default and at most */
+#define GF_DEF_REQ_WINDOW 8
+#define GF_MAX_REQ_WINDOW 32
+/* a streamed batch flush waits at most this long, polling, for a client to release a chunk */
+#define BATCH_FLUSH_RELEASE_POLL_MSEC    5
+#define BATCH_FLUSH_RELEASE_TIMEOUT_MSEC 2000
 
 #define FLP_BATCHING_MINIMUN_INTERVAL           (1000) // in msec
 #define FLP_BATCHING_MIN_TRIP_DISTANCE           1 // 1 meter
@@ -134,6 +148,17 @@ const struct conf_scaler_to_68_pair confScalers[CONF_SCALER_ARRAY_MAX] = {
 /*fixed timestamp uncertainty 10 milli second */
 static int ap_timestamp_uncertainty = 0;
 
+static int geofence_req_window = GF_DEF_REQ_WINDOW;
+
+/* locations per report of a batch flush, 0 to report the whole batch at once */
+static int batch_flush_chunk_size = 0;
+
+/* longest an epoch bundle waits for the rest of its reports, 0 to send each
+   report up on its own */
+static int epoch_bundle_timeout_ms = 0;
+
+#define GPS_WEEK_MS (7 * 24 * 3600 * 1000)
+
 typedef enum {
     RF_LOSS_GPS_CONF        = 0,
     RF_LOSS_GPS_L5_CONF     = 1,
@@ -163,6 +188,9 @@ static loc_param_s_type gps_conf_param_table[] =
     { "RF_LOSS_GAL",                &rfLossNV[RF_LOSS_GAL_CONF],        NULL, 'n' },
     { "RF_LOSS_GAL_E5",             &rfLossNV[RF_LOSS_GAL_E5_CONF],     NULL, 'n' },
     { "RF_LOSS_NAVIC",              &rfLossNV[RF_LOSS_NAVIC_CONF],      NULL, 'n' },
+    { "GEOFENCE_REQ_WINDOW",        &geofence_req_window,               NULL, 'n' },
+    { "BATCH_FLUSH_CHUNK_SIZE",     &batch_flush_chunk_size,            NULL, 'n' },
+    { "EPOCH_BUNDLE_TIMEOUT_MS",    &epoch_bundle_timeout_ms,           NULL, 'n' },
 };
 
 /* static event callbacks that call the LocApiV02 callbacks*/
@@ -206,7 +234,7 @@ static void globalEventCb(locClientHandleType clientHandle,
                   clientHandle, eventId);
         return;
     }
-    locApiV02Instance->eventCb(clientHandle, eventId, eventPayload);
+    locApiV02Instance->queueEventInd(clientHandle, eventId, eventPayload);
 }
 
 /* global response callback, it calls the sync request process
@@ -315,13 +343,33 @@ LocApiV02 :: LocApiV02(LOC_API_ADAPTER_EVENT_MASK_T exMask,
     mHlosQtimer2(0),
     mRefFCount(0),
     mMeasElapsedRealTimeCal(600000000),
-    mPositionElapsedRealTimeCal(30000000)
+    mPositionElapsedRealTimeCal(30000000),
+    mAsyncReqTxnId(0),
+    mAsyncReqTimer(*this),
+    mGeofenceReqTxnId(0),
+    mSendingGeofenceReqs(false),
+    mIndBufferPool(LOC_API_V02_IND_BUFFER_POOL_SIZE),
+    mIndQtimer(0),
+    mIndMsgTask("LocApiV02IndMsgTask", LOC_API_V02_IND_MSG_TASK_RING_SIZE),
+    mEpochBundleDueMs(0),
+    mEpochBundleTimer(*this)
 {
   // initialize loc_sync_req interface
   loc_sync_req_init();
-  mADRdata.clear();
+  mADRdata.reserve(GNSS_MEASUREMENTS_MAX);
 
   UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+  if (geofence_req_window < 1) {
+      geofence_req_window = 1;
+  } else if (geofence_req_window > GF_MAX_REQ_WINDOW) {
+      geofence_req_window = GF_MAX_REQ_WINDOW;
+  }
+  if (batch_flush_chunk_size < 0) {
+      batch_flush_chunk_size = 0;
+  }
+  if (epoch_bundle_timeout_ms < 0) {
+      epoch_bundle_timeout_ms = 0;
+  }
 }
 
 /* Destructor for LocApiV02 */
@@ -659,6 +707,8 @@ enum loc_api_adapter_err LocApiV02 :: close()
   mQmiMask = 0;
   mInSession = false;
   clientHandle = LOC_CLIENT_INVALID_HANDLE_VALUE;
+  // their indications will not come any more
+  cancelAsyncReqs();
 
   return rtv;
 }
@@ -875,12 +925,10 @@ void LocApiV02 :: stopFix(LocApiResponse *adapterResponse)
       registerEventMask(mMask);
   }
 
-  // free the memory used to assemble SV measurement from
+  // release the buffer used to assemble SV measurement from
   // different constellations and bands
-  if (!mGnssMeasurements) {
-      free(mGnssMeasurements);
-      mGnssMeasurements = nullptr;
-  }
+  mGnssMeasurementsBuf = nullptr;
+  mGnssMeasurements = nullptr;
 
   if( eLOC_CLIENT_SUCCESS != status)
   {
@@ -1900,23 +1948,7 @@ LocApiV02::setSUPLVersionSync(GnssConfigSuplVersion version)
   memset(&supl_config_req, 0, sizeof(supl_config_req));
   memset(&supl_config_ind, 0, sizeof(supl_config_ind));
 
-  supl_config_req.suplVersion_valid = 1;
-
-  switch (version) {
-    case GNSS_CONFIG_SUPL_VERSION_2_0_4:
-      supl_config_req.suplVersion = eQMI_LOC_SUPL_VERSION_2_0_4_V02;
-      break;
-    case GNSS_CONFIG_SUPL_VERSION_2_0_2:
-      supl_config_req.suplVersion = eQMI_LOC_SUPL_VERSION_2_0_2_V02;
-      break;
-    case GNSS_CONFIG_SUPL_VERSION_2_0_0:
-      supl_config_req.suplVersion = eQMI_LOC_SUPL_VERSION_2_0_V02;
-      break;
-    case GNSS_CONFIG_SUPL_VERSION_1_0_0:
-    default:
-      supl_config_req.suplVersion =  eQMI_LOC_SUPL_VERSION_1_0_V02;
-      break;
-  }
+  fillSUPLVersion(supl_config_req, version);
 
   req_union.pSetProtocolConfigParametersReq = &supl_config_req;
 
@@ -1938,6 +1970,29 @@ LocApiV02::setSUPLVersionSync(GnssConfigSuplVersion version)
   return err;
 }
 
+void
+LocApiV02::fillSUPLVersion(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+                           GnssConfigSuplVersion version)
+{
+  req.suplVersion_valid = 1;
+
+  switch (version) {
+    case GNSS_CONFIG_SUPL_VERSION_2_0_4:
+      req.suplVersion = eQMI_LOC_SUPL_VERSION_2_0_4_V02;
+      break;
+    case GNSS_CONFIG_SUPL_VERSION_2_0_2:
+      req.suplVersion = eQMI_LOC_SUPL_VERSION_2_0_2_V02;
+      break;
+    case GNSS_CONFIG_SUPL_VERSION_2_0_0:
+      req.suplVersion = eQMI_LOC_SUPL_VERSION_2_0_V02;
+      break;
+    case GNSS_CONFIG_SUPL_VERSION_1_0_0:
+    default:
+      req.suplVersion =  eQMI_LOC_SUPL_VERSION_1_0_V02;
+      break;
+  }
+}
+
 /* set the NMEA types mask */
 enum loc_api_adapter_err LocApiV02 :: setNMEATypesSync(uint32_t typesMask)
 {
@@ -1977,6 +2032,25 @@ enum loc_api_adapter_err LocApiV02 :: setNMEATypesSync(uint32_t typesMask)
   return convertErr(result);
 }
 
+void
+LocApiV02::fillLPPConfig(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+                         GnssConfigLppProfileMask profileMask)
+{
+  req.lppConfig_valid = 1;
+  if (profileMask & GNSS_CONFIG_LPP_PROFILE_USER_PLANE_BIT) {
+      req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_USER_PLANE_V02;
+  }
+  if (profileMask & GNSS_CONFIG_LPP_PROFILE_CONTROL_PLANE_BIT) {
+      req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_CONTROL_PLANE_V02;
+  }
+  if (profileMask & GNSS_CONFIG_LPP_PROFILE_USER_PLANE_OVER_NR5G_SA_BIT) {
+      req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_USER_PLANE_OVER_NR5G_SA_V02;
+  }
+  if (profileMask & GNSS_CONFIG_LPP_PROFILE_CONTROL_PLANE_OVER_NR5G_SA_BIT) {
+      req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_CONTROL_PLANE_OVER_NR5G_SA_V02;
+  }
+}
+
 /* set the configuration for LTE positioning profile (LPP) */
 LocationError
 LocApiV02::setLPPConfigSync(GnssConfigLppProfileMask profileMask)
@@ -1992,19 +2066,7 @@ LocApiV02::setLPPConfigSync(GnssConfigLppProfileMask profileMask)
   memset(&lpp_config_req, 0, sizeof(lpp_config_req));
   memset(&lpp_config_ind, 0, sizeof(lpp_config_ind));
 
-  lpp_config_req.lppConfig_valid = 1;
-  if (profileMask & GNSS_CONFIG_LPP_PROFILE_USER_PLANE_BIT) {
-      lpp_config_req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_USER_PLANE_V02;
-  }
-  if (profileMask & GNSS_CONFIG_LPP_PROFILE_CONTROL_PLANE_BIT) {
-      lpp_config_req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_CONTROL_PLANE_V02;
-  }
-  if (profileMask & GNSS_CONFIG_LPP_PROFILE_USER_PLANE_OVER_NR5G_SA_BIT) {
-      lpp_config_req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_USER_PLANE_OVER_NR5G_SA_V02;
-  }
-  if (profileMask & GNSS_CONFIG_LPP_PROFILE_CONTROL_PLANE_OVER_NR5G_SA_BIT) {
-      lpp_config_req.lppConfig |= QMI_LOC_LPP_CONFIG_ENABLE_CONTROL_PLANE_OVER_NR5G_SA_V02;
-  }
+  fillLPPConfig(lpp_config_req, profileMask);
 
   req_union.pSetProtocolConfigParametersReq = &lpp_config_req;
 
@@ -2155,36 +2217,43 @@ enum loc_api_adapter_err LocApiV02 :: setSensorPerfControlConfigSync(int control
   return convertErr(result);
 }
 
-/* set the Positioning Protocol on A-GLONASS system */
-LocationError
-LocApiV02::setAGLONASSProtocolSync(GnssConfigAGlonassPositionProtocolMask aGlonassProtocol)
+void
+LocApiV02::fillAGLONASSProtocol(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+                                GnssConfigAGlonassPositionProtocolMask aGlonassProtocol)
 {
-  LocationError err = LOCATION_ERROR_SUCCESS;
-  locClientStatusEnumType result = eLOC_CLIENT_SUCCESS;
-  locClientReqUnionType req_union;
-  qmiLocSetProtocolConfigParametersReqMsgT_v02 aGlonassProtocol_req;
-  qmiLocSetProtocolConfigParametersIndMsgT_v02 aGlonassProtocol_ind;
-
-  memset(&aGlonassProtocol_req, 0, sizeof(aGlonassProtocol_req));
-  memset(&aGlonassProtocol_ind, 0, sizeof(aGlonassProtocol_ind));
-
-  aGlonassProtocol_req.assistedGlonassProtocolMask_valid = 1;
+  req.assistedGlonassProtocolMask_valid = 1;
   if (GNSS_CONFIG_RRC_CONTROL_PLANE_BIT & aGlonassProtocol) {
-      aGlonassProtocol_req.assistedGlonassProtocolMask |=
+      req.assistedGlonassProtocolMask |=
           QMI_LOC_ASSISTED_GLONASS_PROTOCOL_MASK_RRC_CP_V02 ;
   }
   if (GNSS_CONFIG_RRLP_USER_PLANE_BIT & aGlonassProtocol) {
-      aGlonassProtocol_req.assistedGlonassProtocolMask |=
+      req.assistedGlonassProtocolMask |=
           QMI_LOC_ASSISTED_GLONASS_PROTOCOL_MASK_RRLP_UP_V02;
   }
   if (GNSS_CONFIG_LLP_USER_PLANE_BIT & aGlonassProtocol) {
-      aGlonassProtocol_req.assistedGlonassProtocolMask |=
+      req.assistedGlonassProtocolMask |=
           QMI_LOC_ASSISTED_GLONASS_PROTOCOL_MASK_LPP_UP_V02;
   }
   if (GNSS_CONFIG_LLP_CONTROL_PLANE_BIT & aGlonassProtocol) {
-      aGlonassProtocol_req.assistedGlonassProtocolMask |=
+      req.assistedGlonassProtocolMask |=
           QMI_LOC_ASSISTED_GLONASS_PROTOCOL_MASK_LPP_CP_V02;
   }
+}
+
+/* set the Positioning Protocol on A-GLONASS system */
+LocationError
+LocApiV02::setAGLONASSProtocolSync(GnssConfigAGlonassPositionProtocolMask aGlonassProtocol)
+{
+  LocationError err = LOCATION_ERROR_SUCCESS;
+  locClientStatusEnumType result = eLOC_CLIENT_SUCCESS;
+  locClientReqUnionType req_union;
+  qmiLocSetProtocolConfigParametersReqMsgT_v02 aGlonassProtocol_req;
+  qmiLocSetProtocolConfigParametersIndMsgT_v02 aGlonassProtocol_ind;
+
+  memset(&aGlonassProtocol_req, 0, sizeof(aGlonassProtocol_req));
+  memset(&aGlonassProtocol_ind, 0, sizeof(aGlonassProtocol_ind));
+
+  fillAGLONASSProtocol(aGlonassProtocol_req, aGlonassProtocol);
 
   req_union.pSetProtocolConfigParametersReq = &aGlonassProtocol_req;
 
@@ -2209,6 +2278,44 @@ LocApiV02::setAGLONASSProtocolSync(GnssConfigAGlonassPositionProtocolMask aGlona
   return err;
 }
 
+void
+LocApiV02::fillLPPeProtocolCp(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+                              GnssConfigLppeControlPlaneMask lppeCP)
+{
+  req.lppeCpConfig_valid = 1;
+  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_DBH_BIT & lppeCP) {
+      req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_DBH_V02;
+  }
+  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_WLAN_AP_MEASUREMENTS_BIT & lppeCP) {
+      req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_AP_WIFI_MEASUREMENT_V02;
+  }
+  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_SRN_AP_MEASUREMENTS_BIT & lppeCP) {
+      req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_AP_SRN_BTLE_MEASUREMENT_V02;
+  }
+  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_SENSOR_BARO_MEASUREMENTS_BIT & lppeCP) {
+      req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_UBP_V02;
+  }
+}
+
+void
+LocApiV02::fillLPPeProtocolUp(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+                              GnssConfigLppeUserPlaneMask lppeUP)
+{
+  req.lppeUpConfig_valid = 1;
+  if (GNSS_CONFIG_LPPE_USER_PLANE_DBH_BIT & lppeUP) {
+      req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_DBH_V02;
+  }
+  if (GNSS_CONFIG_LPPE_USER_PLANE_WLAN_AP_MEASUREMENTS_BIT & lppeUP) {
+      req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_AP_WIFI_MEASUREMENT_V02;
+  }
+  if (GNSS_CONFIG_LPPE_USER_PLANE_SRN_AP_MEASUREMENTS_BIT & lppeUP) {
+      req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_AP_SRN_BTLE_MEASUREMENT_V02;
+  }
+  if (GNSS_CONFIG_LPPE_USER_PLANE_SENSOR_BARO_MEASUREMENTS_BIT & lppeUP) {
+      req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_UBP_V02;
+  }
+}
+
 LocationError
 LocApiV02::setLPPeProtocolCpSync(GnssConfigLppeControlPlaneMask lppeCP)
 {
@@ -2221,19 +2328,7 @@ LocApiV02::setLPPeProtocolCpSync(GnssConfigLppeControlPlaneMask lppeCP)
   memset(&lppe_req, 0, sizeof(lppe_req));
   memset(&lppe_ind, 0, sizeof(lppe_ind));
 
-  lppe_req.lppeCpConfig_valid = 1;
-  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_DBH_BIT & lppeCP) {
-      lppe_req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_DBH_V02;
-  }
-  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_WLAN_AP_MEASUREMENTS_BIT & lppeCP) {
-      lppe_req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_AP_WIFI_MEASUREMENT_V02;
-  }
-  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_SRN_AP_MEASUREMENTS_BIT & lppeCP) {
-      lppe_req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_AP_SRN_BTLE_MEASUREMENT_V02;
-  }
-  if (GNSS_CONFIG_LPPE_CONTROL_PLANE_SENSOR_BARO_MEASUREMENTS_BIT & lppeCP) {
-      lppe_req.lppeCpConfig |= QMI_LOC_LPPE_MASK_CP_UBP_V02;
-  }
+  fillLPPeProtocolCp(lppe_req, lppeCP);
 
   req_union.pSetProtocolConfigParametersReq = &lppe_req;
 
@@ -2271,19 +2366,7 @@ LocApiV02::setLPPeProtocolUpSync(GnssConfigLppeUserPlaneMask lppeUP)
   memset(&lppe_ind, 0, sizeof(lppe_ind));
   memset(&req_union, 0, sizeof(req_union));
 
-  lppe_req.lppeUpConfig_valid = 1;
-  if (GNSS_CONFIG_LPPE_USER_PLANE_DBH_BIT & lppeUP) {
-      lppe_req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_DBH_V02;
-  }
-  if (GNSS_CONFIG_LPPE_USER_PLANE_WLAN_AP_MEASUREMENTS_BIT & lppeUP) {
-      lppe_req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_AP_WIFI_MEASUREMENT_V02;
-  }
-  if (GNSS_CONFIG_LPPE_USER_PLANE_SRN_AP_MEASUREMENTS_BIT & lppeUP) {
-      lppe_req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_AP_SRN_BTLE_MEASUREMENT_V02;
-  }
-  if (GNSS_CONFIG_LPPE_USER_PLANE_SENSOR_BARO_MEASUREMENTS_BIT & lppeUP) {
-      lppe_req.lppeUpConfig |= QMI_LOC_LPPE_MASK_UP_UBP_V02;
-  }
+  fillLPPeProtocolUp(lppe_req, lppeUP);
 
   req_union.pSetProtocolConfigParametersReq = &lppe_req;
 
@@ -2308,6 +2391,100 @@ LocApiV02::setLPPeProtocolUpSync(GnssConfigLppeUserPlaneMask lppeUP)
   return err;
 }
 
+/* set all the protocol config parameters of gnssConfig in one request,
+   failedFlags returns the flags of those which could not be set */
+LocationError
+LocApiV02::setProtocolConfigSync(const GnssConfig& gnssConfig,
+                                 GnssConfigFlagsMask& failedFlags)
+{
+  LocationError err = LOCATION_ERROR_SUCCESS;
+  locClientStatusEnumType result = eLOC_CLIENT_SUCCESS;
+  locClientReqUnionType req_union;
+  qmiLocSetProtocolConfigParametersReqMsgT_v02 protocol_req;
+  qmiLocSetProtocolConfigParametersIndMsgT_v02 protocol_ind;
+  GnssConfigFlagsMask flags = gnssConfig.flags & (GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT |
+          GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT |
+          GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT |
+          GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT |
+          GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT |
+          GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT);
+
+  failedFlags = 0;
+  if (0 == flags) {
+    return err;
+  }
+
+  memset(&protocol_req, 0, sizeof(protocol_req));
+  memset(&protocol_ind, 0, sizeof(protocol_ind));
+  memset(&req_union, 0, sizeof(req_union));
+
+  if (flags & GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) {
+    fillSUPLVersion(protocol_req, gnssConfig.suplVersion);
+  }
+  if (flags & GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) {
+    fillLPPConfig(protocol_req, gnssConfig.lppProfileMask);
+  }
+  if (flags & GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) {
+    fillLPPeProtocolCp(protocol_req, gnssConfig.lppeControlPlaneMask);
+  }
+  if (flags & GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) {
+    fillLPPeProtocolUp(protocol_req, gnssConfig.lppeUserPlaneMask);
+  }
+  if (flags & GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) {
+    fillAGLONASSProtocol(protocol_req, gnssConfig.aGlonassPositionProtocolMask);
+  }
+  if (flags & GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) {
+    protocol_req.emergencyCallbackWindow_valid = 1;
+    protocol_req.emergencyCallbackWindow = gnssConfig.emergencyExtensionSeconds;
+  }
+
+  req_union.pSetProtocolConfigParametersReq = &protocol_req;
+
+  LOC_LOGd("flags = 0x%x", flags);
+
+  result = locSyncSendReq(QMI_LOC_SET_PROTOCOL_CONFIG_PARAMETERS_REQ_V02,
+                          req_union, LOC_ENGINE_SYNC_REQUEST_LONG_TIMEOUT,
+                          QMI_LOC_SET_PROTOCOL_CONFIG_PARAMETERS_IND_V02,
+                          &protocol_ind);
+
+  if (result != eLOC_CLIENT_SUCCESS ||
+      eQMI_LOC_SUCCESS_V02 != protocol_ind.status)
+  {
+    LOC_LOGe("Error status = %s, ind..status = %s, failed mask 0x%" PRIx64,
+             loc_get_v02_client_status_name(result),
+             loc_get_v02_qmi_status_name(protocol_ind.status),
+             protocol_ind.failedProtocolConfigParamMask);
+    err = LOCATION_ERROR_GENERAL_FAILURE;
+    if (result != eLOC_CLIENT_SUCCESS || !protocol_ind.failedProtocolConfigParamMask_valid) {
+      failedFlags = flags;
+    } else {
+      qmiLocProtocolConfigParamMaskT_v02 failedMask =
+              protocol_ind.failedProtocolConfigParamMask;
+      if (failedMask & QMI_LOC_PROTOCOL_CONFIG_PARAM_MASK_SUPL_VERSION_V02) {
+        failedFlags |= GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT;
+      }
+      if (failedMask & QMI_LOC_PROTOCOL_CONFIG_PARAM_MASK_LPP_CONFIG_V02) {
+        failedFlags |= GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT;
+      }
+      if (failedMask & QMI_LOC_PROTOCOL_CONFIG_PARAM_MASK_LPPE_CP_V02) {
+        failedFlags |= GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT;
+      }
+      if (failedMask & QMI_LOC_PROTOCOL_CONFIG_PARAM_MASK_LPPE_UP_V02) {
+        failedFlags |= GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT;
+      }
+      if (failedMask & QMI_LOC_PROTOCOL_CONFIG_PARAM_MASK_ASSISTED_GLONASS_PROTOCOL_V02) {
+        failedFlags |= GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT;
+      }
+      if (failedMask & QMI_LOC_PROTOCOL_CONFIG_PARAM_MASK_EMERGENCY_CB_WINDOW_V02) {
+        failedFlags |= GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT;
+      }
+      failedFlags &= flags;
+    }
+  }
+
+  return err;
+}
+
 /* Convert event mask from loc eng to loc_api_v02 format */
 locClientEventMaskType LocApiV02 :: convertMask(
   LOC_API_ADAPTER_EVENT_MASK_T mask)
@@ -2534,7 +2711,7 @@ void LocApiV02 :: reportPosition (
     LocPosTechMask tech_Mask = LOC_POS_TECH_MASK_DEFAULT;
     LOC_LOGD("Reporting position from V2 Adapter\n");
 
-    mHlosQtimer2 = getQTimerTickCount();
+    mHlosQtimer2 = mIndQtimer;
     LOC_LOGv("mHlosQtimer2=%" PRIi64 " ", mHlosQtimer2);
 
     memset(&location, 0, sizeof (UlpLocation));
@@ -2542,6 +2719,8 @@ void LocApiV02 :: reportPosition (
     location.unpropagatedPosition = unpropagatedPosition;
     GnssDataNotification dataNotify = {};
     int msInWeek = -1;
+    int gpsTowMs = location_report_ptr->gpsTime_valid ?
+            (int)location_report_ptr->gpsTime.gpsTimeOfWeekMs : -1;
 
     GpsLocationExtended locationExtended;
     memset(&locationExtended, 0, sizeof (GpsLocationExtended));
@@ -2641,7 +2820,7 @@ void LocApiV02 :: reportPosition (
                 }
             }
         } else {
-            LocApiBase::reportData(dataNotify, msInWeek);
+            reportEpochData(dataNotify, msInWeek, gpsTowMs);
         }
 
         // Time stamp (UTC)
@@ -3253,20 +3432,20 @@ void LocApiV02 :: reportPosition (
                  locationExtended.dgnssCorrectionSourceID,
                  locationExtended.dgnssDataAgeMsec,
                  locationExtended.dgnssRefStationId);
-        LocApiBase::reportPosition(location,
-                                   locationExtended,
-                                   (location_report_ptr->sessionStatus ==
-                                    eQMI_LOC_SESS_STATUS_IN_PROGRESS_V02 ?
-                                    LOC_SESS_INTERMEDIATE : LOC_SESS_SUCCESS),
-                                   tech_Mask, &dataNotify, msInWeek);
+        reportEpochPosition(location,
+                            locationExtended,
+                            (location_report_ptr->sessionStatus ==
+                             eQMI_LOC_SESS_STATUS_IN_PROGRESS_V02 ?
+                             LOC_SESS_INTERMEDIATE : LOC_SESS_SUCCESS),
+                            tech_Mask, &dataNotify, msInWeek, gpsTowMs);
     }
     else
     {
-        LocApiBase::reportPosition(location,
-                                   locationExtended,
-                                   LOC_SESS_FAILURE,
-                                   LOC_POS_TECH_MASK_DEFAULT,
-                                   &dataNotify, msInWeek);
+        reportEpochPosition(location,
+                            locationExtended,
+                            LOC_SESS_FAILURE,
+                            LOC_POS_TECH_MASK_DEFAULT,
+                            &dataNotify, msInWeek, gpsTowMs);
 
         LOC_LOGD("%s:%d]: Ignoring position report with sess status = %d, "
                       "fix id = %u\n", __func__, __LINE__,
@@ -3652,7 +3831,7 @@ void  LocApiV02 :: reportSv (
         }
     }
 
-    LocApiBase::reportSv(SvNotify);
+    reportEpochSv(SvNotify);
 }
 
 static Gnss_LocSvSystemEnumType getLocApiSvSystemType (qmiLocSvSystemEnumT_v02 qmiSvSystemType) {
@@ -3896,6 +4075,15 @@ void  LocApiV02 :: reportSvPolynomial (
         svPolynomial.navicTgdL5 = gnss_sv_poly_ptr->navicTgdL5;
     }
 
+    // the engine repeats a polynomial until it is recomputed
+    auto it = mSvPolynomials.find(svPolynomial.gnssSvId);
+    if (it != mSvPolynomials.end() &&
+        0 == memcmp(&it->second, &svPolynomial, sizeof(svPolynomial))) {
+        LOC_LOGv("[SV_POLY_QMI] SV-Id:%d unchanged", svPolynomial.gnssSvId);
+        return;
+    }
+    mSvPolynomials[svPolynomial.gnssSvId] = svPolynomial;
+
     LocApiBase::reportSvPolynomial(svPolynomial);
 
     LOC_LOGV("[SV_POLY_QMI] SV-Id:%d\n", svPolynomial.gnssSvId);
@@ -4119,6 +4307,82 @@ void LocApiV02::populateFeatureStatusReport
 
 }
 
+/* SV id and action of each ephemeris type */
+static inline uint16_t svEphemerisSvId(const GpsEphemeris& eph) {
+    return eph.commonEphemerisData.gnssSvId;
+}
+static inline uint16_t svEphemerisSvId(const BdsEphemeris& eph) {
+    return eph.commonEphemerisData.gnssSvId;
+}
+static inline uint16_t svEphemerisSvId(const GalileoEphemeris& eph) {
+    return eph.commonEphemerisData.gnssSvId;
+}
+static inline uint16_t svEphemerisSvId(const GlonassEphemeris& eph) {
+    return eph.gnssSvId;
+}
+static inline GnssEphAction svEphemerisAction(const GpsEphemeris& eph) {
+    return eph.commonEphemerisData.updateAction;
+}
+static inline GnssEphAction svEphemerisAction(const BdsEphemeris& eph) {
+    return eph.commonEphemerisData.updateAction;
+}
+static inline GnssEphAction svEphemerisAction(const GalileoEphemeris& eph) {
+    return eph.commonEphemerisData.updateAction;
+}
+static inline GnssEphAction svEphemerisAction(const GlonassEphemeris& eph) {
+    return eph.updateAction;
+}
+
+static inline uint32_t svEphemerisKey(Gnss_LocSvSystemEnumType constellation, uint16_t svId) {
+    return ((uint32_t)constellation << 16) | svId;
+}
+
+template <typename EphemerisT>
+uint16_t LocApiV02::dedupSvEphemeris(Gnss_LocSvSystemEnumType constellation,
+        EphemerisT* ephemerisList, uint16_t& numOfEphemeris)
+{
+    static_assert(sizeof(EphemerisT) <= sizeof(SvEphemerisData), "SvEphemerisData too small");
+    uint16_t kept = 0;
+
+    std::lock_guard<std::mutex> guard(mSvEphemerisLock);
+    for (uint16_t i = 0; i < numOfEphemeris && i < GNSS_EPHEMERIS_LIST_MAX_SIZE_V02; i++) {
+        const EphemerisT& eph = ephemerisList[i];
+        uint32_t key = svEphemerisKey(constellation, svEphemerisSvId(eph));
+        if (svEphemerisAction(eph) >= GNSS_EPH_ACTION_DELETE_SRC_UNKNOWN_V02) {
+            mSvEphemeris.erase(key);
+        } else {
+            // the entries are memset before they are populated, so a
+            // repeated issue of data compares equal byte for byte
+            auto it = mSvEphemeris.find(key);
+            if (it != mSvEphemeris.end() && 0 == memcmp(&it->second, &eph, sizeof(eph))) {
+                continue;
+            }
+            memcpy(&mSvEphemeris[key], &eph, sizeof(eph));
+        }
+        if (kept != i) {
+            ephemerisList[kept] = eph;
+        }
+        kept++;
+    }
+
+    uint16_t dropped = numOfEphemeris - kept;
+    numOfEphemeris = kept;
+    return dropped;
+}
+
+template <typename EphemerisT>
+void LocApiV02::copySvEphemeris(Gnss_LocSvSystemEnumType constellation,
+        EphemerisT* ephemerisList, uint16_t& numOfEphemeris)
+{
+    numOfEphemeris = 0;
+    for (auto it = mSvEphemeris.lower_bound(svEphemerisKey(constellation, 0));
+         it != mSvEphemeris.end() && numOfEphemeris < GNSS_EPHEMERIS_LIST_MAX_SIZE_V02 &&
+         it->first < svEphemerisKey((Gnss_LocSvSystemEnumType)(constellation + 1), 0);
+         ++it) {
+        memcpy(&ephemerisList[numOfEphemeris++], &it->second, sizeof(EphemerisT));
+    }
+}
+
 void LocApiV02::reportSvEphemeris (
         uint32_t eventId, const locClientEventIndUnionType &eventPayload) {
 
@@ -4148,9 +4412,85 @@ void LocApiV02::reportSvEphemeris (
             populateQzssEphemeris(eventPayload.pQzssEphemerisReportEvent, svEphemeris);
     }
 
+    // only forward the ephemerides that changed
+    uint16_t dropped = 0;
+    uint16_t* numOfEphemeris = nullptr;
+    switch (svEphemeris.gnssConstellation)
+    {
+        case GNSS_LOC_SV_SYSTEM_GPS:
+            numOfEphemeris = &svEphemeris.ephInfo.gpsEphemeris.numOfEphemeris;
+            dropped = dedupSvEphemeris(svEphemeris.gnssConstellation,
+                    svEphemeris.ephInfo.gpsEphemeris.gpsEphemerisData, *numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_GLONASS:
+            numOfEphemeris = &svEphemeris.ephInfo.glonassEphemeris.numOfEphemeris;
+            dropped = dedupSvEphemeris(svEphemeris.gnssConstellation,
+                    svEphemeris.ephInfo.glonassEphemeris.gloEphemerisData, *numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_BDS:
+            numOfEphemeris = &svEphemeris.ephInfo.bdsEphemeris.numOfEphemeris;
+            dropped = dedupSvEphemeris(svEphemeris.gnssConstellation,
+                    svEphemeris.ephInfo.bdsEphemeris.bdsEphemerisData, *numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_GALILEO:
+            numOfEphemeris = &svEphemeris.ephInfo.galileoEphemeris.numOfEphemeris;
+            dropped = dedupSvEphemeris(svEphemeris.gnssConstellation,
+                    svEphemeris.ephInfo.galileoEphemeris.galEphemerisData, *numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_QZSS:
+            numOfEphemeris = &svEphemeris.ephInfo.qzssEphemeris.numOfEphemeris;
+            dropped = dedupSvEphemeris(svEphemeris.gnssConstellation,
+                    svEphemeris.ephInfo.qzssEphemeris.qzssEphemerisData, *numOfEphemeris);
+            break;
+        default:
+            break;
+    }
+
+    if (nullptr != numOfEphemeris && 0 == *numOfEphemeris && dropped > 0) {
+        LOC_LOGv("constellation %d: all %u ephemerides unchanged",
+                 svEphemeris.gnssConstellation, dropped);
+        return;
+    }
+
     LocApiBase::reportSvEphemeris(svEphemeris);
 }
 
+bool LocApiV02::getSvEphemeris(Gnss_LocSvSystemEnumType constellation,
+                               GnssSvEphemerisReport& svEphemeris)
+{
+    memset(&svEphemeris, 0, sizeof(svEphemeris));
+    svEphemeris.gnssConstellation = constellation;
+
+    std::lock_guard<std::mutex> guard(mSvEphemerisLock);
+    switch (constellation)
+    {
+        case GNSS_LOC_SV_SYSTEM_GPS:
+            copySvEphemeris(constellation, svEphemeris.ephInfo.gpsEphemeris.gpsEphemerisData,
+                    svEphemeris.ephInfo.gpsEphemeris.numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_GLONASS:
+            copySvEphemeris(constellation, svEphemeris.ephInfo.glonassEphemeris.gloEphemerisData,
+                    svEphemeris.ephInfo.glonassEphemeris.numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_BDS:
+            copySvEphemeris(constellation, svEphemeris.ephInfo.bdsEphemeris.bdsEphemerisData,
+                    svEphemeris.ephInfo.bdsEphemeris.numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_GALILEO:
+            copySvEphemeris(constellation, svEphemeris.ephInfo.galileoEphemeris.galEphemerisData,
+                    svEphemeris.ephInfo.galileoEphemeris.numOfEphemeris);
+            break;
+        case GNSS_LOC_SV_SYSTEM_QZSS:
+            copySvEphemeris(constellation, svEphemeris.ephInfo.qzssEphemeris.qzssEphemerisData,
+                    svEphemeris.ephInfo.qzssEphemeris.numOfEphemeris);
+            break;
+        default:
+            LOC_LOGe("no ephemeris kept for constellation %d", constellation);
+            return false;
+    }
+    return true;
+}
+
 void LocApiV02::populateGpsTimeOfReport(const qmiLocGnssTimeStructT_v02 &inGpsSystemTime,
         GnssSystemTimeStructType& outGpsSystemTime) {
 
@@ -4705,7 +5045,7 @@ void LocApiV02 :: reportNmea (
     }
 
     if ((NULL != p_nmea) && (q_nmea_len > 0)) {
-        LocApiBase::reportNmea(p_nmea, q_nmea_len);
+        reportEpochNmea(p_nmea, q_nmea_len);
     }
 }
 
@@ -5032,12 +5372,11 @@ void LocApiV02::reportGnssMeasurementData(
              gnss_measurement_report_ptr.svMeasurement_len);
 
     if (!mGnssMeasurements) {
-        mGnssMeasurements = (GnssMeasurements*)malloc(sizeof(GnssMeasurements));
+        resetSvMeasurementReport();
         if (!mGnssMeasurements) {
-            LOC_LOGe("Malloc failed to allocate heap memory for mGnssMeasurements");
+            LOC_LOGe("Failed to allocate heap memory for mGnssMeasurements");
             return;
         }
-        resetSvMeasurementReport();
         newMeasProcessed = false;
     }
 
@@ -5059,9 +5398,13 @@ void LocApiV02::reportGnssMeasurementData(
             reportSvMeasurementInternal();
             resetSvMeasurementReport();
             newMeasProcessed = false;
+            if (!mGnssMeasurements) {
+                LOC_LOGe("Failed to allocate heap memory for mGnssMeasurements");
+                return;
+            }
         }
 
-        mHlosQtimer1 = getQTimerTickCount();
+        mHlosQtimer1 = mIndQtimer;
         mRefFCount = gnss_measurement_report_ptr.systemTimeExt.refFCount;
         LOC_LOGv("mHlosQtimer1=%" PRIi64 " mRefFCount=%d", mHlosQtimer1, mRefFCount);
         prevRefFCount = gnss_measurement_report_ptr.systemTimeExt.refFCount;
@@ -5380,24 +5723,19 @@ void LocApiV02::setGnssBiases() {
 void LocApiV02 ::reportSvMeasurementInternal() {
 
     if (mGnssMeasurements) {
+        // the GPS time of the epoch, before it is cleared for the AGC
+        int gpsTowMs = mMsInWeek;
         // calling the base
         if (mAgcIsPresent) {
             /* If we can get AGC from QMI LOC there is no need to get it from NMEA */
             mMsInWeek = -1;
         }
         // now remove all the elements in the vector which are not for current epoch
-        if (mADRdata.size() > 0) {
-            auto front = mADRdata.begin();
-            for (auto back = mADRdata.end(); front != back;) {
-                if (mCounter != front->counter) {
-                    --back;
-                    swap(*front, *back);
-                } else {
-                    front++;
-                }
-            }
-            if (front != mADRdata.end()) {
-                mADRdata.erase(front, mADRdata.end());
+        for (auto it = mADRdata.begin(); it != mADRdata.end();) {
+            if (mCounter != it->second.counter) {
+                it = mADRdata.erase(it);
+            } else {
+                ++it;
             }
         }
 
@@ -5441,7 +5779,7 @@ void LocApiV02 ::reportSvMeasurementInternal() {
                     i, mGnssMeasurements->gnssMeasNotification.
                             measurements[i].fullInterSignalBiasUncertaintyNs);
         }
-        LocApiBase::reportGnssMeasurements(*mGnssMeasurements, mMsInWeek);
+        reportEpochMeasurements(mGnssMeasurementsBuf, mMsInWeek, gpsTowMs);
     }
 }
 
@@ -5946,26 +6284,35 @@ void LocApiV02::wifiStatusInformSync()
                                         (svId >= FIRST_BDS_D2_SV_PRN)) ? true : false )
 
 /*convert GnssMeasurement type from QMI LOC to loc eng format*/
+/* key of the carrier phase data of one signal of one SV in mADRdata; a
+   measurement indication carries a single signal type, 0 if not valid */
+static inline uint64_t adrDataKey(qmiLocSvSystemEnumT_v02 system,
+                                  qmiLocGnssSignalTypeMaskT_v02 gnssSignalType,
+                                  uint16_t gnssSvId)
+{
+    uint64_t signalIndex = (0 == gnssSignalType) ? 0 : (__builtin_ctzll(gnssSignalType) + 1);
+    return ((uint64_t)(uint32_t)system << 32) | (signalIndex << 16) | gnssSvId;
+}
+
 bool LocApiV02 :: convertGnssMeasurements(
     const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr,
     int index, bool isExt, bool validDgnssSvMeas)
 {
     bool bAgcIsPresent = false;
-    qmiLocSVMeasurementStructT_v02 gnss_measurement_info;
     uint32_t count = mGnssMeasurements->gnssMeasNotification.count;
 
     LOC_LOGv("entering extMeas %d, qmi sv index %d, current sv count %d", isExt, index, count);
-    if (isExt) {
-        gnss_measurement_info = gnss_measurement_report_ptr.extSvMeasurement[index];
-    } else {
-        gnss_measurement_info = gnss_measurement_report_ptr.svMeasurement[index];
-    }
+    const qmiLocSVMeasurementStructT_v02& gnss_measurement_info = isExt ?
+            gnss_measurement_report_ptr.extSvMeasurement[index] :
+            gnss_measurement_report_ptr.svMeasurement[index];
 
     GnssMeasurementsData& measurementData =
         mGnssMeasurements->gnssMeasNotification.measurements[count];
+    memset(&measurementData, 0, sizeof(measurementData));
 
     Gnss_SVMeasurementStructType& svMeas =
         mGnssMeasurements->gnssSvMeasurementSet.svMeas[count];
+    memset(&svMeas, 0, sizeof(svMeas));
 
     svMeas.size = sizeof(Gnss_SVMeasurementStructType);
     svMeas.gnssSystem = getLocApiSvSystemType(gnss_measurement_report_ptr.system);
@@ -6324,6 +6671,7 @@ bool LocApiV02 :: convertGnssMeasurements(
 
         LOC_LOGv("gnss_measurement_report_ptr.gnssSignalType_valid = 0");
     }
+    double wavelengthM = SPEED_OF_LIGHT / measurementData.carrierFrequencyHz;
 
     // accumulatedDeltaRangeM
     if (gnss_measurement_info.validMask & QMI_LOC_SV_CARRIER_PHASE_VALID_V02) {
@@ -6334,7 +6682,7 @@ bool LocApiV02 :: convertGnssMeasurements(
             measurementData.carrierPhase += 0.5;
         }
         measurementData.adrMeters =
-            (SPEED_OF_LIGHT / measurementData.carrierFrequencyHz) * measurementData.carrierPhase;
+            wavelengthM * measurementData.carrierPhase;
         LOC_LOGv("carrierPhase = %.2f adrMeters = %.2f",
                  measurementData.carrierPhase,
                  measurementData.adrMeters);
@@ -6352,7 +6700,7 @@ bool LocApiV02 :: convertGnssMeasurements(
     if (!isExt) {
         if (gnss_measurement_report_ptr.svCarrierPhaseUncertainty_valid) {
             measurementData.adrUncertaintyMeters =
-                (SPEED_OF_LIGHT / measurementData.carrierFrequencyHz) *
+                wavelengthM *
                 gnss_measurement_report_ptr.svCarrierPhaseUncertainty[index];
             LOC_LOGv("carrierPhaseUnc = %.6f adrMetersUnc = %.6f",
                      gnss_measurement_report_ptr.svCarrierPhaseUncertainty[index],
@@ -6363,7 +6711,7 @@ bool LocApiV02 :: convertGnssMeasurements(
     } else {
         if (gnss_measurement_report_ptr.extSvCarrierPhaseUncertainty_valid) {
             measurementData.adrUncertaintyMeters =
-                (SPEED_OF_LIGHT / measurementData.carrierFrequencyHz) *
+                wavelengthM *
                 gnss_measurement_report_ptr.extSvCarrierPhaseUncertainty[index];
             LOC_LOGv("extCarrierPhaseUnc = %.6f adrMetersUnc = %.6f",
                      gnss_measurement_report_ptr.extSvCarrierPhaseUncertainty[index],
@@ -6379,25 +6727,16 @@ bool LocApiV02 :: convertGnssMeasurements(
         (gnss_measurement_info.carrierPhase != 0.0)) {
         measurementData.adrStateMask = GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT;
 
-        bool bFound = false;
-        adrData tempAdrData;
-        vector<adrData>::iterator it;
         // check the prior epoch
-        // first see if info for this satellite exists in the vector (from prior epoch)
-        for (it = mADRdata.begin(); it != mADRdata.end(); ++it) {
-            tempAdrData = *it;
-            if (gnss_measurement_report_ptr.system == tempAdrData.system &&
-                ((gnss_measurement_report_ptr.gnssSignalType_valid &&
-                (gnss_measurement_report_ptr.gnssSignalType == tempAdrData.gnssSignalType)) ||
-                 (!gnss_measurement_report_ptr.gnssSignalType_valid &&
-                    (0 == tempAdrData.gnssSignalType))) &&
-                gnss_measurement_info.gnssSvId == tempAdrData.gnssSvId) {
-                bFound = true;
-                break;
-            }
-        }
+        // first see if info for this satellite exists in the map (from prior epoch)
+        uint64_t adrKey = adrDataKey(gnss_measurement_report_ptr.system,
+                gnss_measurement_report_ptr.gnssSignalType_valid ?
+                gnss_measurement_report_ptr.gnssSignalType : 0,
+                gnss_measurement_info.gnssSvId);
+        auto it = mADRdata.find(adrKey);
         measurementData.adrStateMask |= GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT;
-        if (bFound) {
+        if (it != mADRdata.end()) {
+            adrData& tempAdrData = it->second;
             LOC_LOGv("Found the carrier phase for this satellite from last epoch");
             if (tempAdrData.validMask & QMI_LOC_SV_CARRIER_PHASE_VALID_V02) {
                 LOC_LOGv("and it has valid carrier phase");
@@ -6421,13 +6760,13 @@ bool LocApiV02 :: convertGnssMeasurements(
                     }
                 }
             }
-            // now update the current satellite info to the vector
+            // now update the current satellite info in the map
             tempAdrData.counter = mCounter;
             tempAdrData.validMask = gnss_measurement_info.validMask;
             tempAdrData.cycleSlipCount = gnss_measurement_info.cycleSlipCount;
-            *it = tempAdrData;
         } else {
-            // now add the current satellite info to the vector
+            // now add the current satellite info to the map
+            adrData& tempAdrData = mADRdata[adrKey];
             tempAdrData.counter = mCounter;
             tempAdrData.system = gnss_measurement_report_ptr.system;
             if (gnss_measurement_report_ptr.gnssSignalType_valid) {
@@ -6438,7 +6777,6 @@ bool LocApiV02 :: convertGnssMeasurements(
             tempAdrData.gnssSvId = gnss_measurement_info.gnssSvId;
             tempAdrData.validMask = gnss_measurement_info.validMask;
             tempAdrData.cycleSlipCount = gnss_measurement_info.cycleSlipCount;
-            mADRdata.push_back(tempAdrData);
         }
 
         if (validMeasStatus & QMI_LOC_MASK_MEAS_STATUS_LP_VALID_V02) {
@@ -6732,19 +7070,66 @@ int LocApiV02 :: convertGnssClock (GnssMeasurementsClock& clock,
 }
 
 /* event callback registered with the loc_api v02 interface */
+void LocApiV02 :: queueEventInd(locClientHandleType clientHandle,
+  uint32_t eventId, const locClientEventIndUnionType& eventPayload)
+{
+  uint64_t indQtimer = getQTimerTickCount();
+  size_t indSize = 0;
+  std::shared_ptr<std::vector<uint8_t>> indBuf;
+
+  // the decoded indication is freed as soon as we return
+  if (!locClientGetSizeByEventIndId(eventId, &indSize) ||
+      nullptr == (indBuf = mIndBufferPool.acquire())) {
+    LOC_LOGe("failed to queue event id = 0x%X, size = %zu", eventId, indSize);
+    return;
+  }
+  indBuf->resize(indSize);
+  memcpy(indBuf->data(), eventPayload.pPositionReportEvent, indSize);
+
+  mIndMsgTask.sendMsg([this, clientHandle, eventId, indBuf, indQtimer] () {
+    locClientEventIndUnionType payload;
+    // dummy, any of the union members points to the same buffer
+    payload.pPositionReportEvent =
+        (qmiLocEventPositionReportIndMsgT_v02 *)indBuf->data();
+    mIndQtimer = indQtimer;
+    eventCb(clientHandle, eventId, payload);
+  });
+}
+
 void LocApiV02 :: eventCb(locClientHandleType /*clientHandle*/,
   uint32_t eventId, locClientEventIndUnionType eventPayload)
 {
   LOC_LOGd("event id = 0x%X", eventId);
 
+  // the reports of other indications go up after those held for the epoch
   switch(eventId)
   {
-    //Position Report
     case QMI_LOC_EVENT_POSITION_REPORT_IND_V02:
-      reportPosition(eventPayload.pPositionReportEvent);
-      break;
-
-    // Satellite report
+    case QMI_LOC_EVENT_UNPROPAGATED_POSITION_REPORT_IND_V02:
+    case QMI_LOC_EVENT_GNSS_SV_INFO_IND_V02:
+    case QMI_LOC_EVENT_NMEA_IND_V02:
+    case QMI_LOC_EVENT_GNSS_MEASUREMENT_REPORT_IND_V02:
+    case QMI_LOC_LATENCY_INFORMATION_IND_V02:
+    case QMI_LOC_EVENT_SV_POLYNOMIAL_REPORT_IND_V02:
+    case QMI_LOC_EVENT_GPS_EPHEMERIS_REPORT_IND_V02:
+    case QMI_LOC_EVENT_GLONASS_EPHEMERIS_REPORT_IND_V02:
+    case QMI_LOC_EVENT_BDS_EPHEMERIS_REPORT_IND_V02:
+    case QMI_LOC_EVENT_GALILEO_EPHEMERIS_REPORT_IND_V02:
+    case QMI_LOC_EVENT_QZSS_EPHEMERIS_REPORT_IND_V02:
+      break;
+    default:
+      flushEpochBundle();
+      break;
+  }
+
+  switch(eventId)
+  {
+    //Position Report
+    case QMI_LOC_EVENT_POSITION_REPORT_IND_V02:
+      reportPosition(eventPayload.pPositionReportEvent);
+      break;
+
+    // Satellite report
     case QMI_LOC_EVENT_GNSS_SV_INFO_IND_V02:
       reportSv(eventPayload.pGnssSvInfoReportEvent);
       break;
@@ -6899,6 +7284,12 @@ void LocApiV02 :: errorCb(locClientHandleType /*handle*/,
     LOC_LOGE("%s:%d]: Service unavailable error\n",
                   __func__, __LINE__);
 
+    // the engine reports everything again once it is back
+    mIndMsgTask.sendMsg([this] () {
+        mSvPolynomials.clear();
+        std::lock_guard<std::mutex> guard(mSvEphemerisLock);
+        mSvEphemeris.clear();
+    });
     handleEngineDownEvent();
   }
 }
@@ -7371,7 +7762,7 @@ void LocApiV02::reportLatencyInfo(const qmiLocLatencyInformationIndMsgT_v02* pLo
              gnssLatencyInfo.smQtimer3, gnssLatencyInfo.locMwQtimer,
              gnssLatencyInfo.hlosQtimer1, gnssLatencyInfo.hlosQtimer2);
 
-    LocApiBase::reportLatencyInfo(gnssLatencyInfo);
+    reportEpochLatencyInfo(gnssLatencyInfo);
 }
 
 void LocApiV02::configRobustLocation
@@ -7379,15 +7770,11 @@ void LocApiV02::configRobustLocation
 
     sendMsg(new LocApiMsg([this, enable, enableForE911, adapterResponse] () {
 
-    LocationError err = LOCATION_ERROR_SUCCESS;
     qmiLocSetRobustLocationReqMsgT_v02 req;
-    qmiLocGenReqStatusIndMsgT_v02 ind;
-    locClientStatusEnumType status;
     locClientReqUnionType req_union;
 
     LOC_LOGd("Enter. enabled %d, enableForE911 %d", enable, enableForE911);
     memset(&req, 0, sizeof(req));
-    memset(&ind, 0, sizeof(ind));
     req.enable = enable;
     req.enableForE911_valid = true;
     req.enableForE911 = enableForE911;
@@ -7398,25 +7785,31 @@ void LocApiV02::configRobustLocation
     }
 
     req_union.pSetRobustLocationReq = &req;
-    status = locSyncSendReq(QMI_LOC_SET_ROBUST_LOCATION_CONFIG_REQ_V02,
-                            req_union, LOC_ENGINE_SYNC_REQUEST_LONG_TIMEOUT,
-                            QMI_LOC_SET_ROBUST_LOCATION_CONFIG_IND_V02,
-                            &ind);
-    if (status != eLOC_CLIENT_SUCCESS || ind.status != eQMI_LOC_SUCCESS_V02) {
-        LOC_LOGe("failed. status: %s, ind status:%s\n",
-                 loc_get_v02_client_status_name(status),
-                 loc_get_v02_qmi_status_name(ind.status));
-        if (status == eLOC_CLIENT_FAILURE_UNSUPPORTED ||
-                status == eLOC_CLIENT_FAILURE_INVALID_MESSAGE_ID) {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        } else {
-            err = LOCATION_ERROR_GENERAL_FAILURE;
+    // the LocApi MsgTask is not held up waiting for the indication
+    sendReqAsync(QMI_LOC_SET_ROBUST_LOCATION_CONFIG_REQ_V02,
+                 req_union, LOC_ENGINE_SYNC_REQUEST_LONG_TIMEOUT,
+                 QMI_LOC_SET_ROBUST_LOCATION_CONFIG_IND_V02,
+                 [adapterResponse] (locClientStatusEnumType status, const void* indPayload) {
+        LocationError err = LOCATION_ERROR_SUCCESS;
+        qmiLocStatusEnumT_v02 indStatus = (nullptr != indPayload) ?
+                ((const qmiLocGenReqStatusIndMsgT_v02*)indPayload)->status :
+                eQMI_LOC_GENERAL_FAILURE_V02;
+        if (status != eLOC_CLIENT_SUCCESS || indStatus != eQMI_LOC_SUCCESS_V02) {
+            LOC_LOGe("failed. status: %s, ind status:%s\n",
+                     loc_get_v02_client_status_name(status),
+                     loc_get_v02_qmi_status_name(indStatus));
+            if (status == eLOC_CLIENT_FAILURE_UNSUPPORTED ||
+                    status == eLOC_CLIENT_FAILURE_INVALID_MESSAGE_ID) {
+                err = LOCATION_ERROR_NOT_SUPPORTED;
+            } else {
+                err = LOCATION_ERROR_GENERAL_FAILURE;
+            }
         }
-    }
-    if (adapterResponse) {
-        adapterResponse->returnToSender(err);
-    }
-    LOC_LOGv("Exit. err: %u", err);
+        if (adapterResponse) {
+            adapterResponse->returnToSender(err);
+        }
+        LOC_LOGv("Exit. err: %u", err);
+    });
     }));
 }
 
@@ -7742,6 +8135,242 @@ locClientStatusEnumType LocApiV02::locSyncSendReq(uint32_t req_id,
     return status;
 }
 
+void LocApiV02::sendReqAsync(uint32_t reqId, locClientReqUnionType reqPayload,
+        uint32_t timeoutMsec, uint32_t indId, AsyncReqContinuation continuation) {
+    uint32_t txnId = ++mAsyncReqTxnId;
+    uint64_t deadlineMs = getBootTimeMilliSec() + timeoutMsec;
+
+    // the completion of the indication runs in this MsgTask, so it always
+    // finds the request, even if the indication comes before the ack
+    mAsyncReqs[txnId] = {deadlineMs, continuation};
+    locClientStatusEnumType status = loc_async_send_req(clientHandle, reqId, reqPayload,
+            indId, asyncReqIndCb, this, txnId);
+    if (eLOC_CLIENT_SUCCESS != status) {
+        LOC_LOGe("failed. req: %s status: %s", loc_get_v02_event_name(reqId),
+                 loc_get_v02_client_status_name(status));
+        completeAsyncReq(txnId, status, nullptr);
+        return;
+    }
+
+    if (0 == mAsyncReqTimer.getDueMs() || deadlineMs < mAsyncReqTimer.getDueMs()) {
+        mAsyncReqTimer.start(deadlineMs);
+    }
+}
+
+void LocApiV02::asyncReqIndCb(void* userData, uint32_t txnId,
+                              void* indPayload, uint32_t indPayloadSize) {
+    LocApiV02* api = (LocApiV02*)userData;
+    std::vector<uint8_t> ind;
+    if (nullptr != indPayload) {
+        ind.assign((uint8_t*)indPayload, (uint8_t*)indPayload + indPayloadSize);
+    }
+    api->sendMsg(new LocApiMsg([api, txnId, ind] () {
+        api->completeAsyncReq(txnId, eLOC_CLIENT_SUCCESS, ind.data());
+    }));
+}
+
+void LocApiV02::completeAsyncReq(uint32_t txnId, locClientStatusEnumType status,
+                                 const void* indPayload) {
+    auto it = mAsyncReqs.find(txnId);
+    // already timed out or cancelled
+    if (it == mAsyncReqs.end()) {
+        return;
+    }
+    AsyncReqContinuation continuation = std::move(it->second.continuation);
+    mAsyncReqs.erase(it);
+    if (nullptr != continuation) {
+        continuation(status, indPayload);
+    }
+}
+
+void LocApiV02::expireAsyncReqs() {
+    uint64_t nowMs = getBootTimeMilliSec();
+    uint64_t soonestMs = UINT64_MAX;
+    std::vector<uint32_t> expired;
+
+    for (auto& req : mAsyncReqs) {
+        if (req.second.deadlineMs <= nowMs) {
+            if (loc_async_cancel_req(this, req.first)) {
+                expired.push_back(req.first);
+            } else {
+                // its indication is on the way to this MsgTask
+                req.second.deadlineMs = UINT64_MAX;
+            }
+        } else if (req.second.deadlineMs < soonestMs) {
+            soonestMs = req.second.deadlineMs;
+        }
+    }
+
+    if (UINT64_MAX != soonestMs) {
+        mAsyncReqTimer.start(soonestMs);
+    }
+    // last, as the continuations may send new requests
+    for (auto txnId : expired) {
+        LOC_LOGe("txn %u timed out", txnId);
+        completeAsyncReq(txnId, eLOC_CLIENT_FAILURE_TIMEOUT, nullptr);
+    }
+}
+
+void LocApiV02::cancelAsyncReqs() {
+    mAsyncReqTimer.stop();
+    std::vector<uint32_t> cancelled;
+    for (auto& req : mAsyncReqs) {
+        if (loc_async_cancel_req(this, req.first)) {
+            cancelled.push_back(req.first);
+        }
+    }
+    for (auto txnId : cancelled) {
+        completeAsyncReq(txnId, eLOC_CLIENT_FAILURE_PHONE_OFFLINE, nullptr);
+    }
+}
+
+void AsyncReqTimer::start(uint64_t dueMs) {
+    uint64_t nowMs = getBootTimeMilliSec();
+    LocTimer::stop();
+    mDueMs = dueMs;
+    LocTimer::start((dueMs > nowMs) ? (uint32_t)(dueMs - nowMs) : 1, false);
+}
+
+void AsyncReqTimer::stop() {
+    mDueMs = 0;
+    LocTimer::stop();
+}
+
+// Called in the context of LocTimer thread
+void AsyncReqTimer::timeOutCallback() {
+    mApi.sendMsg(new LocApiMsg([this] () {
+        mDueMs = 0;
+        mApi.expireAsyncReqs();
+    }));
+}
+
+LocApiEpochBundle* LocApiV02::joinEpochBundle(int gpsTowMs) {
+    if (nullptr != mEpochBundle && gpsTowMs >= 0 && mEpochBundle->gpsTowMs >= 0) {
+        // the measurement and fix times of an epoch need not be the same
+        int diffMs = abs(gpsTowMs - mEpochBundle->gpsTowMs);
+        diffMs = std::min(diffMs, GPS_WEEK_MS - diffMs);
+        if (diffMs > 0 && (uint32_t)diffMs * 2 >= mMinInterval) {
+            flushEpochBundle();
+        }
+    }
+    if (nullptr == mEpochBundle) {
+        mEpochBundle.reset(new LocApiEpochBundle());
+        mEpochBundleDueMs = getBootTimeMilliSec() + epoch_bundle_timeout_ms;
+        mEpochBundleTimer.start(epoch_bundle_timeout_ms, false);
+    }
+    if (mEpochBundle->gpsTowMs < 0) {
+        mEpochBundle->gpsTowMs = gpsTowMs;
+    }
+    return mEpochBundle.get();
+}
+
+void LocApiV02::flushEpochBundle() {
+    if (nullptr != mEpochBundle) {
+        std::unique_ptr<LocApiEpochBundle> bundle(std::move(mEpochBundle));
+        mEpochBundleDueMs = 0;
+        mEpochBundleTimer.stop();
+        LocApiBase::reportEpochBundle(*bundle);
+    }
+}
+
+void LocApiV02::expireEpochBundle() {
+    // the timer may have fired for a bundle that has already gone up
+    if (nullptr != mEpochBundle && getBootTimeMilliSec() >= mEpochBundleDueMs) {
+        LOC_LOGv("epoch bundle of gpsTowMs %d timed out", mEpochBundle->gpsTowMs);
+        flushEpochBundle();
+    }
+}
+
+void LocApiV02::reportEpochPosition(UlpLocation& location,
+        GpsLocationExtended& locationExtended, enum loc_sess_status status,
+        LocPosTechMask techMask, GnssDataNotification* pDataNotify, int msInWeek,
+        int gpsTowMs) {
+    if (0 == epoch_bundle_timeout_ms) {
+        LocApiBase::reportPosition(location, locationExtended, status, techMask,
+                                   pDataNotify, msInWeek);
+        return;
+    }
+    LocApiEpochBundle* bundle = joinEpochBundle(gpsTowMs);
+    bundle->positions.emplace_back();
+    LocApiEpochBundle::Position& position = bundle->positions.back();
+    position.location = location;
+    loc_copy_location_extended(&position.locationExtended, &locationExtended);
+    position.status = status;
+    position.techMask = techMask;
+    position.hasDataNotify = (nullptr != pDataNotify);
+    if (nullptr != pDataNotify) {
+        position.dataNotify = *pDataNotify;
+    }
+    position.msInWeek = msInWeek;
+}
+
+void LocApiV02::reportEpochSv(GnssSvNotification& svNotify) {
+    if (0 == epoch_bundle_timeout_ms) {
+        LocApiBase::reportSv(svNotify);
+        return;
+    }
+    LocApiEpochBundle* bundle = joinEpochBundle(-1);
+    if (bundle->hasSv) {
+        flushEpochBundle();
+        bundle = joinEpochBundle(-1);
+    }
+    bundle->hasSv = true;
+    bundle->svNotify = svNotify;
+}
+
+void LocApiV02::reportEpochNmea(const char* nmea, int length) {
+    if (0 == epoch_bundle_timeout_ms) {
+        LocApiBase::reportNmea(nmea, length);
+        return;
+    }
+    joinEpochBundle(-1)->nmea.emplace_back(nmea, length);
+}
+
+void LocApiV02::reportEpochData(GnssDataNotification& dataNotify, int msInWeek,
+                                int gpsTowMs) {
+    if (0 == epoch_bundle_timeout_ms) {
+        LocApiBase::reportData(dataNotify, msInWeek);
+        return;
+    }
+    joinEpochBundle(gpsTowMs)->data.push_back({dataNotify, msInWeek});
+}
+
+void LocApiV02::reportEpochMeasurements(const GnssMeasurementsPtr& measurements,
+                                        int msInWeek, int gpsTowMs) {
+    if (0 == epoch_bundle_timeout_ms) {
+        LocApiBase::reportGnssMeasurements(measurements, msInWeek);
+        return;
+    }
+    LocApiEpochBundle* bundle = joinEpochBundle(gpsTowMs);
+    if (nullptr != bundle->measurements) {
+        flushEpochBundle();
+        bundle = joinEpochBundle(gpsTowMs);
+    }
+    bundle->measurements = measurements;
+    bundle->measurementsMsInWeek = msInWeek;
+}
+
+void LocApiV02::reportEpochLatencyInfo(GnssLatencyInfo& latencyInfo) {
+    if (0 == epoch_bundle_timeout_ms) {
+        LocApiBase::reportLatencyInfo(latencyInfo);
+        return;
+    }
+    LocApiEpochBundle* bundle = joinEpochBundle(-1);
+    if (bundle->hasLatencyInfo) {
+        flushEpochBundle();
+        bundle = joinEpochBundle(-1);
+    }
+    bundle->hasLatencyInfo = true;
+    bundle->latencyInfo = latencyInfo;
+}
+
+// Called in the context of LocTimer thread
+void EpochBundleTimer::timeOutCallback() {
+    mApi.mIndMsgTask.sendMsg([this] () {
+        mApi.expireEpochBundle();
+    });
+}
+
 void LocApiV02 ::
 handleWwanZppFixIndication(const qmiLocGetAvailWwanPositionIndMsgT_v02& zpp_ind)
 {
@@ -7909,141 +8538,76 @@ void LocApiV02::
 }
 
 
+static const LocMaskBitMap<qmiLocPosTechMaskT_v02, LocPosTechMask> sPosTechMaskMap[] = {
+   { QMI_LOC_POS_TECH_MASK_SATELLITE_V02, LOC_POS_TECH_MASK_SATELLITE },
+   { QMI_LOC_POS_TECH_MASK_CELLID_V02, LOC_POS_TECH_MASK_CELLID },
+   { QMI_LOC_POS_TECH_MASK_WIFI_V02, LOC_POS_TECH_MASK_WIFI },
+   { QMI_LOC_POS_TECH_MASK_SENSORS_V02, LOC_POS_TECH_MASK_SENSORS },
+   { QMI_LOC_POS_TECH_MASK_REFERENCE_LOCATION_V02, LOC_POS_TECH_MASK_REFERENCE_LOCATION },
+   { QMI_LOC_POS_TECH_MASK_INJECTED_COARSE_POSITION_V02,
+     LOC_POS_TECH_MASK_INJECTED_COARSE_POSITION },
+   { QMI_LOC_POS_TECH_MASK_AFLT_V02, LOC_POS_TECH_MASK_AFLT },
+   { QMI_LOC_POS_TECH_MASK_HYBRID_V02, LOC_POS_TECH_MASK_HYBRID },
+};
+
 LocPosTechMask LocApiV02 :: convertPosTechMask(
   qmiLocPosTechMaskT_v02 mask)
 {
-   LocPosTechMask locTechMask = LOC_POS_TECH_MASK_DEFAULT;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_SATELLITE_V02)
-      locTechMask |= LOC_POS_TECH_MASK_SATELLITE;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_CELLID_V02)
-      locTechMask |= LOC_POS_TECH_MASK_CELLID;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_WIFI_V02)
-      locTechMask |= LOC_POS_TECH_MASK_WIFI;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_SENSORS_V02)
-      locTechMask |= LOC_POS_TECH_MASK_SENSORS;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_REFERENCE_LOCATION_V02)
-      locTechMask |= LOC_POS_TECH_MASK_REFERENCE_LOCATION;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_INJECTED_COARSE_POSITION_V02)
-      locTechMask |= LOC_POS_TECH_MASK_INJECTED_COARSE_POSITION;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_AFLT_V02)
-      locTechMask |= LOC_POS_TECH_MASK_AFLT;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_HYBRID_V02)
-      locTechMask |= LOC_POS_TECH_MASK_HYBRID;
-
-   return locTechMask;
+   return convertMaskBits(mask, sPosTechMaskMap, (LocPosTechMask)LOC_POS_TECH_MASK_DEFAULT);
 }
 
+static const LocMaskBitMap<qmiLocNavSolutionMaskT_v02, LocNavSolutionMask>
+        sNavSolutionMaskMap[] = {
+   { QMI_LOC_NAV_MASK_SBAS_CORRECTION_IONO_V02, LOC_NAV_MASK_SBAS_CORRECTION_IONO },
+   { QMI_LOC_NAV_MASK_SBAS_CORRECTION_FAST_V02, LOC_NAV_MASK_SBAS_CORRECTION_FAST },
+   { QMI_LOC_POS_TECH_MASK_WIFI_V02, LOC_POS_TECH_MASK_WIFI },
+   { QMI_LOC_NAV_MASK_SBAS_CORRECTION_LONG_V02, LOC_NAV_MASK_SBAS_CORRECTION_LONG },
+   { QMI_LOC_NAV_MASK_SBAS_INTEGRITY_V02, LOC_NAV_MASK_SBAS_INTEGRITY },
+   { QMI_LOC_NAV_MASK_CORRECTION_DGNSS_V02, LOC_NAV_MASK_DGNSS_CORRECTION },
+   { QMI_LOC_NAV_MASK_ONLY_SBAS_CORRECTED_SV_USED_V02,
+     LOC_NAV_MASK_ONLY_SBAS_CORRECTED_SV_USED },
+};
+
 LocNavSolutionMask LocApiV02 :: convertNavSolutionMask(
   qmiLocNavSolutionMaskT_v02 mask)
 {
-   LocNavSolutionMask locNavMask = 0;
-
-   if (mask & QMI_LOC_NAV_MASK_SBAS_CORRECTION_IONO_V02)
-      locNavMask |= LOC_NAV_MASK_SBAS_CORRECTION_IONO;
-
-   if (mask & QMI_LOC_NAV_MASK_SBAS_CORRECTION_FAST_V02)
-      locNavMask |= LOC_NAV_MASK_SBAS_CORRECTION_FAST;
-
-   if (mask & QMI_LOC_POS_TECH_MASK_WIFI_V02)
-      locNavMask |= LOC_POS_TECH_MASK_WIFI;
-
-   if (mask & QMI_LOC_NAV_MASK_SBAS_CORRECTION_LONG_V02)
-      locNavMask |= LOC_NAV_MASK_SBAS_CORRECTION_LONG;
-
-   if (mask & QMI_LOC_NAV_MASK_SBAS_INTEGRITY_V02)
-      locNavMask |= LOC_NAV_MASK_SBAS_INTEGRITY;
-
-   if (mask & QMI_LOC_NAV_MASK_CORRECTION_DGNSS_V02)
-      locNavMask |= LOC_NAV_MASK_DGNSS_CORRECTION;
-
-   if (mask & QMI_LOC_NAV_MASK_ONLY_SBAS_CORRECTED_SV_USED_V02)
-      locNavMask |= LOC_NAV_MASK_ONLY_SBAS_CORRECTED_SV_USED;
-
-   return locNavMask;
+   return convertMaskBits(mask, sNavSolutionMaskMap);
 }
 
+static const LocMaskBitMap<LocApnTypeMask, qmiLocApnTypeMaskT_v02> sApnTypeMaskMap[] = {
+    { LOC_APN_TYPE_MASK_DEFAULT, QMI_LOC_APN_TYPE_MASK_DEFAULT_V02 },
+    { LOC_APN_TYPE_MASK_IMS, QMI_LOC_APN_TYPE_MASK_IMS_V02 },
+    { LOC_APN_TYPE_MASK_MMS, QMI_LOC_APN_TYPE_MASK_MMS_V02 },
+    { LOC_APN_TYPE_MASK_DUN, QMI_LOC_APN_TYPE_MASK_DUN_V02 },
+    { LOC_APN_TYPE_MASK_SUPL, QMI_LOC_APN_TYPE_MASK_SUPL_V02 },
+    { LOC_APN_TYPE_MASK_HIPRI, QMI_LOC_APN_TYPE_MASK_HIPRI_V02 },
+    { LOC_APN_TYPE_MASK_FOTA, QMI_LOC_APN_TYPE_MASK_FOTA_V02 },
+    { LOC_APN_TYPE_MASK_CBS, QMI_LOC_APN_TYPE_MASK_CBS_V02 },
+    { LOC_APN_TYPE_MASK_IA, QMI_LOC_APN_TYPE_MASK_IA_V02 },
+    { LOC_APN_TYPE_MASK_EMERGENCY, QMI_LOC_APN_TYPE_MASK_EMERGENCY_V02 },
+};
+
 qmiLocApnTypeMaskT_v02 LocApiV02::convertLocApnTypeMask(LocApnTypeMask mask)
 {
-    qmiLocApnTypeMaskT_v02 qmiMask = 0;
-
-    if (mask & LOC_APN_TYPE_MASK_DEFAULT) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_DEFAULT_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_IMS) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_IMS_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_MMS) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_MMS_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_DUN) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_DUN_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_SUPL) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_SUPL_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_HIPRI) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_HIPRI_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_FOTA) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_FOTA_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_CBS) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_CBS_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_IA) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_IA_V02;
-    }
-    if (mask & LOC_APN_TYPE_MASK_EMERGENCY) {
-        qmiMask |= QMI_LOC_APN_TYPE_MASK_EMERGENCY_V02;
-    }
-
-    return qmiMask;
+    return convertMaskBits(mask, sApnTypeMaskMap);
 }
 
+static const LocMaskBitMap<qmiLocApnTypeMaskT_v02, LocApnTypeMask> sQmiApnTypeMaskMap[] = {
+    { QMI_LOC_APN_TYPE_MASK_DEFAULT_V02, LOC_APN_TYPE_MASK_DEFAULT },
+    { QMI_LOC_APN_TYPE_MASK_IMS_V02, LOC_APN_TYPE_MASK_IMS },
+    { QMI_LOC_APN_TYPE_MASK_MMS_V02, LOC_APN_TYPE_MASK_MMS },
+    { QMI_LOC_APN_TYPE_MASK_DUN_V02, LOC_APN_TYPE_MASK_DUN },
+    { QMI_LOC_APN_TYPE_MASK_SUPL_V02, LOC_APN_TYPE_MASK_SUPL },
+    { QMI_LOC_APN_TYPE_MASK_HIPRI_V02, LOC_APN_TYPE_MASK_HIPRI },
+    { QMI_LOC_APN_TYPE_MASK_FOTA_V02, LOC_APN_TYPE_MASK_FOTA },
+    { QMI_LOC_APN_TYPE_MASK_CBS_V02, LOC_APN_TYPE_MASK_CBS },
+    { QMI_LOC_APN_TYPE_MASK_IA_V02, LOC_APN_TYPE_MASK_IA },
+    { QMI_LOC_APN_TYPE_MASK_EMERGENCY_V02, LOC_APN_TYPE_MASK_EMERGENCY },
+};
+
 LocApnTypeMask LocApiV02::convertQmiLocApnTypeMask(qmiLocApnTypeMaskT_v02 qmiMask)
 {
-    LocApnTypeMask mask = 0;
-
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_DEFAULT_V02) {
-        mask |= LOC_APN_TYPE_MASK_DEFAULT;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_IMS_V02) {
-        mask |= LOC_APN_TYPE_MASK_IMS;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_MMS_V02) {
-        mask |= LOC_APN_TYPE_MASK_MMS;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_DUN_V02) {
-        mask |= LOC_APN_TYPE_MASK_DUN;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_SUPL_V02) {
-        mask |= LOC_APN_TYPE_MASK_SUPL;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_HIPRI_V02) {
-        mask |= LOC_APN_TYPE_MASK_HIPRI;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_FOTA_V02) {
-        mask |= LOC_APN_TYPE_MASK_FOTA;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_CBS_V02) {
-        mask |= LOC_APN_TYPE_MASK_CBS;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_IA_V02) {
-        mask |= LOC_APN_TYPE_MASK_IA;
-    }
-    if (qmiMask & QMI_LOC_APN_TYPE_MASK_EMERGENCY_V02) {
-        mask |= LOC_APN_TYPE_MASK_EMERGENCY;
-    }
-
-    return mask;
+    return convertMaskBits(qmiMask, sQmiApnTypeMaskMap);
 }
 
 GnssConfigSuplVersion
@@ -9207,6 +9771,83 @@ LocApiV02::geofenceDwellEvent(const qmiLocEventGeofenceBatchedDwellIndMsgT_v02 *
     delete[] hwIds;
 }
 
+void LocApiV02::queueGeofenceReq(std::function<void(uint32_t txnId)> send)
+{
+    mQueuedGeofenceReqs.push_back(std::move(send));
+    sendQueuedGeofenceReqs();
+}
+
+void LocApiV02::sendQueuedGeofenceReqs()
+{
+    // a request that fails to go out completes right away, the outer call
+    // carries on with the queue
+    if (mSendingGeofenceReqs) {
+        return;
+    }
+    mSendingGeofenceReqs = true;
+    while (!mQueuedGeofenceReqs.empty() &&
+           mGeofenceReqs.size() < (size_t)geofence_req_window) {
+        std::function<void(uint32_t txnId)> send = std::move(mQueuedGeofenceReqs.front());
+        mQueuedGeofenceReqs.pop_front();
+        uint32_t txnId = ++mGeofenceReqTxnId;
+        while (mGeofenceReqs.find(txnId) != mGeofenceReqs.end()) {
+            txnId = ++mGeofenceReqTxnId;
+        }
+        send(txnId);
+    }
+    mSendingGeofenceReqs = false;
+}
+
+template <typename IndT>
+void LocApiV02::sendGeofenceReq(uint32_t txnId, uint32_t reqId,
+        locClientReqUnionType reqPayload, uint32_t indId, AsyncReqContinuation continuation)
+{
+    mGeofenceReqs[txnId] = continuation;
+    // the sync req slots do not tell the indications of a type apart, the
+    // request an indication completes is the one of its transaction id
+    sendReqAsync(reqId, reqPayload, LOC_ENGINE_SYNC_REQUEST_TIMEOUT, indId,
+                 [this, txnId] (locClientStatusEnumType status, const void* indPayload) {
+        const IndT* ind = (const IndT*)indPayload;
+        completeGeofenceReq((nullptr != ind && ind->transactionId_valid) ?
+                            ind->transactionId : txnId, status, indPayload);
+    });
+}
+
+void LocApiV02::completeGeofenceReq(uint32_t txnId, locClientStatusEnumType status,
+                                    const void* indPayload)
+{
+    auto it = mGeofenceReqs.find(txnId);
+    if (it == mGeofenceReqs.end()) {
+        // its indication completed another slot, so the oldest request
+        // still in flight is the one this slot was left with
+        it = mGeofenceReqs.begin();
+        if (it == mGeofenceReqs.end()) {
+            return;
+        }
+    }
+    AsyncReqContinuation continuation = std::move(it->second);
+    mGeofenceReqs.erase(it);
+    if (nullptr != continuation) {
+        continuation(status, indPayload);
+    }
+    sendQueuedGeofenceReqs();
+}
+
+static LocationError geofenceReqError(locClientStatusEnumType status,
+                                      qmiLocStatusEnumT_v02 indStatus)
+{
+    if (eLOC_CLIENT_SUCCESS == status && eQMI_LOC_SUCCESS_V02 == indStatus) {
+        return LOCATION_ERROR_SUCCESS;
+    }
+    LOC_LOGe("failed. status: %s, ind status: %s",
+             loc_get_v02_client_status_name(status),
+             loc_get_v02_qmi_status_name(indStatus));
+    if (eQMI_LOC_MAX_GEOFENCE_PROGRAMMED_V02 == indStatus) {
+        return LOCATION_ERROR_GEOFENCES_AT_MAX;
+    }
+    return LOCATION_ERROR_GENERAL_FAILURE;
+}
+
 void
 LocApiV02::addGeofence(uint32_t clientId,
                         const GeofenceOption& options,
@@ -9215,10 +9856,11 @@ LocApiV02::addGeofence(uint32_t clientId,
 {
     sendMsg(new LocApiMsg([this, clientId, options, info, adapterResponseData] () {
 
+    queueGeofenceReq([this, clientId, options, info, adapterResponseData] (uint32_t txnId) {
+
     LOC_LOGD("%s]: lat=%8.2f long=%8.2f radius %8.2f breach=%u respon=%u dwell=%u",
              __func__, info.latitude, info.longitude, info.radius,
              options.breachTypeMask, options.responsiveness, options.dwellTime);
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
 
     qmiLocAddCircularGeofenceReqMsgT_v02 addReq;
     memset(&addReq, 0, sizeof(addReq));
@@ -9255,113 +9897,125 @@ LocApiV02::addGeofence(uint32_t clientId,
     addReq.circularGeofenceArgs.longitude = info.longitude;
     addReq.circularGeofenceArgs.radius = info.radius;
     addReq.includePosition = true;
-    addReq.transactionId = clientId;
-
-    LOC_SEND_SYNC_REQ(AddCircularGeofence, ADD_CIRCULAR_GEOFENCE, addReq);
-
-    LocApiGeofenceData data;
-    if (rv && ind.geofenceId_valid != 0) {
-        data.hwId = ind.geofenceId;
-        err = LOCATION_ERROR_SUCCESS;
-    } else {
-        if (eQMI_LOC_MAX_GEOFENCE_PROGRAMMED_V02 == ind.status) {
-            err = LOCATION_ERROR_GEOFENCES_AT_MAX;
+    addReq.transactionId = txnId;
+
+    locClientReqUnionType reqUnion;
+    reqUnion.pAddCircularGeofenceReq = &addReq;
+    sendGeofenceReq<qmiLocAddCircularGeofenceIndMsgT_v02>(txnId,
+            QMI_LOC_ADD_CIRCULAR_GEOFENCE_REQ_V02, reqUnion,
+            QMI_LOC_ADD_CIRCULAR_GEOFENCE_IND_V02,
+            [clientId, adapterResponseData] (locClientStatusEnumType status,
+                                              const void* indPayload) {
+        const qmiLocAddCircularGeofenceIndMsgT_v02* ind =
+                (const qmiLocAddCircularGeofenceIndMsgT_v02*)indPayload;
+        LocationError err = geofenceReqError(status,
+                (nullptr != ind) ? ind->status : eQMI_LOC_GENERAL_FAILURE_V02);
+
+        LocApiGeofenceData data;
+        if (LOCATION_ERROR_SUCCESS == err) {
+            if (ind->geofenceId_valid != 0) {
+                data.hwId = ind->geofenceId;
+            } else {
+                LOC_LOGe("no geofence id, clientId %u", clientId);
+                err = LOCATION_ERROR_GENERAL_FAILURE;
+            }
         }
-        LOC_LOGE("%s]: failed! rv is %d, ind.geofenceId_valid is %d",
-                 __func__, rv, ind.geofenceId_valid);
-    }
 
-    if (adapterResponseData != NULL) {
-        adapterResponseData->returnToSender(err, data);
-    }
+        if (adapterResponseData != NULL) {
+            adapterResponseData->returnToSender(err, data);
+        }
+    });
+    });
     }));
 }
 
 void
 LocApiV02::removeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse)
 {
-    sendMsg(new LocApiMsg([this, hwId, clientId, adapterResponse] () {
+    sendMsg(new LocApiMsg([this, hwId, adapterResponse] () {
+
+    queueGeofenceReq([this, hwId, adapterResponse] (uint32_t txnId) {
 
     LOC_LOGD("%s]: hwId %u", __func__, hwId);
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
 
     qmiLocDeleteGeofenceReqMsgT_v02 deleteReq;
     memset(&deleteReq, 0, sizeof(deleteReq));
 
     deleteReq.geofenceId = hwId;
-    deleteReq.transactionId = clientId;
-
-    LOC_SEND_SYNC_REQ(DeleteGeofence, DELETE_GEOFENCE, deleteReq);
-
-    if (rv) {
-        err = LOCATION_ERROR_SUCCESS;
-    } else {
-        LOC_LOGE("%s]: failed! rv is %d", __func__, rv);
-    }
-
-    if (adapterResponse != NULL) {
-        adapterResponse->returnToSender(err);
-    }
+    deleteReq.transactionId = txnId;
+
+    locClientReqUnionType reqUnion;
+    reqUnion.pDeleteGeofenceReq = &deleteReq;
+    sendGeofenceReq<qmiLocDeleteGeofenceIndMsgT_v02>(txnId,
+            QMI_LOC_DELETE_GEOFENCE_REQ_V02, reqUnion, QMI_LOC_DELETE_GEOFENCE_IND_V02,
+            [adapterResponse] (locClientStatusEnumType status, const void* indPayload) {
+        LocationError err = geofenceReqError(status, (nullptr != indPayload) ?
+                ((const qmiLocDeleteGeofenceIndMsgT_v02*)indPayload)->status :
+                eQMI_LOC_GENERAL_FAILURE_V02);
+        if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(err);
+        }
+    });
+    });
     }));
 }
 
+void
+LocApiV02::sendEditGeofenceReq(const qmiLocEditGeofenceReqMsgT_v02& editReq,
+                               LocApiResponse* adapterResponse)
+{
+    queueGeofenceReq([this, editReq, adapterResponse] (uint32_t txnId) {
+        qmiLocEditGeofenceReqMsgT_v02 req = editReq;
+        req.transactionId = txnId;
+
+        locClientReqUnionType reqUnion;
+        reqUnion.pEditGeofenceReq = &req;
+        sendGeofenceReq<qmiLocEditGeofenceIndMsgT_v02>(txnId,
+                QMI_LOC_EDIT_GEOFENCE_REQ_V02, reqUnion, QMI_LOC_EDIT_GEOFENCE_IND_V02,
+                [adapterResponse] (locClientStatusEnumType status, const void* indPayload) {
+            LocationError err = geofenceReqError(status, (nullptr != indPayload) ?
+                    ((const qmiLocEditGeofenceIndMsgT_v02*)indPayload)->status :
+                    eQMI_LOC_GENERAL_FAILURE_V02);
+            if (adapterResponse != NULL) {
+                adapterResponse->returnToSender(err);
+            }
+        });
+    });
+}
+
 void
 LocApiV02::pauseGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse)
 {
-    sendMsg(new LocApiMsg([this, hwId, clientId, adapterResponse] () {
+    sendMsg(new LocApiMsg([this, hwId, adapterResponse] () {
 
     LOC_LOGD("%s]: hwId %u", __func__, hwId);
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
 
     qmiLocEditGeofenceReqMsgT_v02 editReq;
     memset(&editReq, 0, sizeof(editReq));
 
     editReq.geofenceId = hwId;
-    editReq.transactionId = clientId;
     editReq.geofenceState_valid = 1;
     editReq.geofenceState = eQMI_LOC_GEOFENCE_STATE_SUSPEND_V02;
 
-    LOC_SEND_SYNC_REQ(EditGeofence, EDIT_GEOFENCE, editReq);
-
-    if (rv) {
-        err = LOCATION_ERROR_SUCCESS;
-    } else {
-        LOC_LOGE("%s]: failed! rv is %d", __func__, rv);
-    }
-
-    if (adapterResponse != NULL) {
-        adapterResponse->returnToSender(err);
-    }
+    sendEditGeofenceReq(editReq, adapterResponse);
     }));
 }
 
 void
 LocApiV02::resumeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse)
 {
-    sendMsg(new LocApiMsg([this, hwId, clientId, adapterResponse] () {
+    sendMsg(new LocApiMsg([this, hwId, adapterResponse] () {
 
     LOC_LOGD("%s]: hwId %u", __func__, hwId);
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
 
     qmiLocEditGeofenceReqMsgT_v02 editReq;
     memset(&editReq, 0, sizeof(editReq));
 
     editReq.geofenceId = hwId;
-    editReq.transactionId = clientId;
     editReq.geofenceState_valid = 1;
     editReq.geofenceState = eQMI_LOC_GEOFENCE_STATE_ACTIVE_V02;
 
-    LOC_SEND_SYNC_REQ(EditGeofence, EDIT_GEOFENCE, editReq);
-
-    if (rv) {
-        err = LOCATION_ERROR_SUCCESS;
-    } else {
-        LOC_LOGE("%s]: failed! rv is %d", __func__, rv);
-    }
-
-    if (adapterResponse != NULL) {
-        adapterResponse->returnToSender(err);
-    }
+    sendEditGeofenceReq(editReq, adapterResponse);
     }));
 }
 
@@ -9370,17 +10024,15 @@ LocApiV02::modifyGeofence(uint32_t hwId,
                            uint32_t clientId,
                            const GeofenceOption& options, LocApiResponse* adapterResponse)
 {
-    sendMsg(new LocApiMsg([this, hwId, clientId, options, adapterResponse] () {
+    sendMsg(new LocApiMsg([this, hwId, options, adapterResponse] () {
 
     LOC_LOGD("%s]: breach=%u respon=%u dwell=%u",
              __func__, options.breachTypeMask, options.responsiveness, options.dwellTime);
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
 
     qmiLocEditGeofenceReqMsgT_v02 editReq;
     memset(&editReq, 0, sizeof(editReq));
 
     editReq.geofenceId = hwId;
-    editReq.transactionId = clientId;
 
     editReq.breachMask_valid = 1;
     if (options.breachTypeMask & GEOFENCE_BREACH_ENTER_BIT) {
@@ -9399,16 +10051,7 @@ LocApiV02::modifyGeofence(uint32_t hwId,
         editReq.responsiveness = eQMI_LOC_GEOFENCE_RESPONSIVENESS_LOW_V02;
     }
 
-    LOC_SEND_SYNC_REQ(EditGeofence, EDIT_GEOFENCE, editReq);
-
-    if (rv) {
-        err = LOCATION_ERROR_SUCCESS;
-    } else {
-        LOC_LOGE("%s]: failed! rv is %d", __func__, rv);
-    }
-    if (adapterResponse != NULL) {
-        adapterResponse->returnToSender(err);
-    }
+    sendEditGeofenceReq(editReq, adapterResponse);
     }));
 
 }
@@ -10261,77 +10904,63 @@ LocApiV02::getBatchedLocationsSync(size_t count)
         LOC_LOGD("%s] No batching memory allocated in modem or nothing to read", __func__);
         // calling the base class
         reportLocations(NULL, 0, BATCHING_MODE_ROUTINE);
+    } else if (batch_flush_chunk_size > 0) {
+        streamModemLocations(entriesToReadInTotal, BATCHING_MODE_ROUTINE);
     } else {
+        BatchedLocationsPtr batchedLocations(mBatchedLocationsPool.acquire());
+        if (nullptr == batchedLocations) {
+            LOC_LOGE("new allocation failed, fatal error.");
+            return LOCATION_ERROR_GENERAL_FAILURE;
+        }
+        // the pieces are read in place, newest first; room is kept for one more
+        // location added during the read, and for a whole last piece
+        std::vector<Location>& locations = *batchedLocations;
+        locations.resize(entriesToReadInTotal + QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
         size_t entriesToRead =
             std::min(entriesToReadInTotal, (size_t)QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
         size_t entriesGotInTotal = 0;
         size_t entriesGotInEachTime = 0;
-        //allocate +1 just in case we get one more location added during read
-        Location* pLocationsFromModem = new Location[entriesToReadInTotal+1]();
-        if (pLocationsFromModem == nullptr) {
-            LOC_LOGE("new allocation failed, fatal error.");
-            return LOCATION_ERROR_GENERAL_FAILURE;
-        }
-        memset(pLocationsFromModem, 0, sizeof(Location)*(entriesToReadInTotal+1));
-        Location* tempLocationP = new Location[QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02]();
-        if (tempLocationP == nullptr) {
-            LOC_LOGE("new allocation failed, fatal error.");
-            return LOCATION_ERROR_GENERAL_FAILURE;
-        }
         do {
-            memset(tempLocationP, 0, QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02*sizeof(Location));
-            readModemLocations(tempLocationP,
+            readModemLocations(locations.data() + entriesGotInTotal,
                                entriesToRead,
                                BATCHING_MODE_ROUTINE,
                                entriesGotInEachTime);
-            for (size_t i = 0; i<entriesGotInEachTime; i++) {
-                size_t index = entriesToReadInTotal-entriesGotInTotal-i;
-
-                // make sure index is not too large or small to fit in the array
-                if (index <= entriesToReadInTotal && (int)index >= 0) {
-                    pLocationsFromModem[index] = tempLocationP[i];
-                } else {
-                    LOC_LOGW("%s] dropped an unexpected location.", __func__);
-                }
-            }
             entriesGotInTotal += entriesGotInEachTime;
+            if (entriesGotInTotal >= entriesToReadInTotal) {
+                break;
+            }
             entriesToRead = std::min(entriesToReadInTotal - entriesGotInTotal,
                                      (size_t)QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
-        } while (entriesGotInEachTime > 0 && entriesToRead > 0);
-        delete[] tempLocationP;
+        } while (entriesGotInEachTime > 0);
 
         LOC_LOGD("%s] Read out %zu batched locations from modem in total.",
                  __func__, entriesGotInTotal);
 
-        // offset is by default 1 because we allocated one extra location during read
-        uint32_t offset = 1;
-        if (entriesToReadInTotal > entriesGotInTotal) {
-            offset = 1 + entriesToReadInTotal - entriesGotInTotal;
-            LOC_LOGD("%s] offset %u", __func__, offset);
-        } else if (entriesGotInTotal > entriesToReadInTotal) {
-            // offset is zero because we need one extra slot for the extra location
-            offset = 0;
+        if (entriesGotInTotal > entriesToReadInTotal + 1) {
+            LOC_LOGW("%s] dropped %zu unexpected location(s).",
+                     __func__, entriesGotInTotal - entriesToReadInTotal - 1);
+            entriesGotInTotal = entriesToReadInTotal + 1;
+        }
+        locations.resize(entriesGotInTotal);
+        std::reverse(locations.begin(), locations.end());
+
+        if (entriesGotInTotal > entriesToReadInTotal) {
             LOC_LOGD("%s] Read %zu extra location(s) than expected.",
                      __func__, entriesGotInTotal - entriesToReadInTotal);
             // we got one extra location added during modem read, so one location will
             // be out of order and needs to be found and put in order
-            int64_t currentTimeStamp = pLocationsFromModem[entriesToReadInTotal].timestamp;
+            int64_t currentTimeStamp = locations[entriesToReadInTotal].timestamp;
             for (int i=entriesToReadInTotal-1; i >= 0; i--) {
                 // find the out of order location
-                if (currentTimeStamp < pLocationsFromModem[i].timestamp) {
+                if (currentTimeStamp < locations[i].timestamp) {
                     LOC_LOGD("%s] Out of order location is index %d timestamp %" PRIu64,
-                             __func__, i, pLocationsFromModem[i].timestamp);
-                    // save the out of order location to be put at end of array
-                    Location tempLocation(pLocationsFromModem[i]);
-                    // shift the remaining locations down one
-                    for (size_t j=i; j<entriesToReadInTotal; j++) {
-                        pLocationsFromModem[j] = pLocationsFromModem[j+1];
-                    }
-                    // put the out of order location at end of array now
-                    pLocationsFromModem[entriesToReadInTotal] = tempLocation;
+                             __func__, i, locations[i].timestamp);
+                    // move the out of order location to the end of array
+                    std::rotate(locations.begin() + i, locations.begin() + i + 1,
+                                locations.end());
                     break;
                 } else {
-                    currentTimeStamp = pLocationsFromModem[i].timestamp;
+                    currentTimeStamp = locations[i].timestamp;
                 }
             }
         }
@@ -10340,8 +10969,7 @@ LocApiV02::getBatchedLocationsSync(size_t count)
                   __func__, count, entriesGotInTotal);
 
         // calling the base class
-        reportLocations(pLocationsFromModem+offset, entriesGotInTotal, BATCHING_MODE_ROUTINE);
-        delete[] pLocationsFromModem;
+        reportLocations(batchedLocations, BATCHING_MODE_ROUTINE);
     }
     return err;
 
@@ -10360,65 +10988,65 @@ LocApiV02::getBatchedLocations(size_t count, LocApiResponse* adapterResponse)
 LocationError LocApiV02::getBatchedTripLocationsSync(size_t count, uint32_t accumulatedDistance)
 {
     LocationError err = LOCATION_ERROR_SUCCESS;
-    size_t idxLocationFromModem = 0;
 
     size_t entriesToReadInTotal = std::min(mTripBatchSize, count);
     if (entriesToReadInTotal == 0) {
         LOC_LOGD("%s] No trip batching memory allocated in modem or nothing to read", __func__);
         // calling the base class
         reportLocations(NULL, 0, BATCHING_MODE_TRIP);
-    } else {
-        size_t entriesToRead =
-                std::min(entriesToReadInTotal, (size_t)QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
-        size_t entriesGotInTotal = 0;
-        size_t entriesGotInEachTime = 0;
+    } else if (batch_flush_chunk_size > 0) {
+        streamModemLocations(entriesToReadInTotal, BATCHING_MODE_TRIP);
 
-        Location* pLocationsFromModem = new Location[entriesToReadInTotal]();
-        if (pLocationsFromModem == nullptr) {
-            LOC_LOGE("new allocation failed, fatal error.");
-            return LOCATION_ERROR_GENERAL_FAILURE;
+        if (accumulatedDistance != 0) {
+            LOC_LOGD("%s] Calling reportCompletedTrips with distance %u:",
+                    __func__, accumulatedDistance);
+            reportCompletedTrips(accumulatedDistance);
         }
-        memset(pLocationsFromModem, 0, sizeof(Location)*(entriesToReadInTotal));
-        Location* tempLocationP = new Location[QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02]();
-        if (tempLocationP == nullptr) {
+    } else {
+        BatchedLocationsPtr batchedLocations(mBatchedLocationsPool.acquire());
+        if (nullptr == batchedLocations) {
             LOC_LOGE("new allocation failed, fatal error.");
             return LOCATION_ERROR_GENERAL_FAILURE;
         }
+        // the pieces are read in place, oldest first, with room for a whole last piece
+        std::vector<Location>& locations = *batchedLocations;
+        locations.resize(entriesToReadInTotal + QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
+        size_t entriesToRead =
+                std::min(entriesToReadInTotal, (size_t)QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
+        size_t entriesGotInTotal = 0;
+        size_t entriesGotInEachTime = 0;
 
         do {
-            memset(tempLocationP, 0, QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02*sizeof(Location));
-            readModemLocations(tempLocationP,
+            readModemLocations(locations.data() + entriesGotInTotal,
                                entriesToRead,
                                BATCHING_MODE_TRIP,
                                entriesGotInEachTime);
-            for (size_t iEntryIndex = 0; iEntryIndex<entriesGotInEachTime;
-                    iEntryIndex++, idxLocationFromModem++) {
-                // make sure index is not too large fit in the array
-                if (idxLocationFromModem < entriesToReadInTotal) {
-                    pLocationsFromModem[idxLocationFromModem] = tempLocationP[iEntryIndex];
-                } else {
-                    LOC_LOGW("%s] dropped an unexpected location.", __func__);
-                }
-            }
             entriesGotInTotal += entriesGotInEachTime;
+            if (entriesGotInTotal >= entriesToReadInTotal) {
+                break;
+            }
             entriesToRead = std::min(entriesToReadInTotal - entriesGotInTotal,
                                      (size_t)QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
-        } while (entriesGotInEachTime > 0 && entriesToRead > 0);
-        delete[] tempLocationP;
+        } while (entriesGotInEachTime > 0);
+
+        if (entriesGotInTotal > entriesToReadInTotal) {
+            LOC_LOGW("%s] dropped %zu unexpected location(s).",
+                     __func__, entriesGotInTotal - entriesToReadInTotal);
+            entriesGotInTotal = entriesToReadInTotal;
+        }
+        locations.resize(entriesGotInTotal);
 
         LOC_LOGD("%s] Calling reportLocations with count:%zu and entriesGotInTotal:%zu",
                   __func__, count, entriesGotInTotal);
 
         // calling the base class
-        reportLocations(pLocationsFromModem, entriesGotInTotal, BATCHING_MODE_TRIP);
+        reportLocations(batchedLocations, BATCHING_MODE_TRIP);
 
         if (accumulatedDistance != 0) {
             LOC_LOGD("%s] Calling reportCompletedTrips with distance %u:",
                     __func__, accumulatedDistance);
             reportCompletedTrips(accumulatedDistance);
         }
-
-        delete[] pLocationsFromModem;
     }
 
     return err;
@@ -10538,6 +11166,80 @@ LocApiV02::readModemLocations(Location* pLocationPiece,
     }
 }
 
+// Reads the batch in chunks of batch_flush_chunk_size locations and reports each
+// chunk as soon as it is read, so neither the memory nor a single report grows
+// with the batch. Two chunks at most are held by the adapters: before reading a
+// chunk, the one before the last must be released, so a slow client slows the
+// read down. The routine batch is read newest first, so its chunks are reported
+// newest chunk first, each in time order.
+void
+LocApiV02::streamModemLocations(size_t entriesToReadInTotal, BatchingMode batchingMode)
+{
+    size_t chunkSize = batch_flush_chunk_size;
+    // a location added during the read of the routine batch is read too
+    size_t entriesMax = entriesToReadInTotal + ((BATCHING_MODE_ROUTINE == batchingMode) ? 1 : 0);
+    size_t entriesGotInTotal = 0;
+    size_t entriesGotInEachTime = 0;
+    uint32_t chunks = 0;
+    BatchedLocationsPtr chunksInFlight[2];
+
+    do {
+        // the slot still holds the chunk before the last one
+        BatchedLocationsPtr& chunk = chunksInFlight[chunks % 2];
+        uint32_t waitedMs = 0;
+        while (nullptr != chunk && chunk.use_count() > 1 &&
+                waitedMs < BATCH_FLUSH_RELEASE_TIMEOUT_MSEC) {
+            usleep(BATCH_FLUSH_RELEASE_POLL_MSEC * 1000);
+            waitedMs += BATCH_FLUSH_RELEASE_POLL_MSEC;
+        }
+        if (waitedMs >= BATCH_FLUSH_RELEASE_TIMEOUT_MSEC) {
+            LOC_LOGW("%s] chunk %u still held after %u ms, reading on",
+                     __func__, chunks - 2, waitedMs);
+        }
+        chunk = mBatchedLocationsPool.acquire();
+        if (nullptr == chunk) {
+            LOC_LOGE("new allocation failed, fatal error.");
+            break;
+        }
+
+        std::vector<Location>& locations = *chunk;
+        locations.resize(chunkSize + QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
+        size_t entriesGotInChunk = 0;
+        size_t entriesToReadInChunk = std::min(chunkSize, entriesToReadInTotal - entriesGotInTotal);
+        do {
+            size_t entriesToRead = std::min(entriesToReadInChunk - entriesGotInChunk,
+                                            (size_t)QMI_LOC_READ_FROM_BATCH_MAX_SIZE_V02);
+            readModemLocations(locations.data() + entriesGotInChunk,
+                               entriesToRead,
+                               batchingMode,
+                               entriesGotInEachTime);
+            entriesGotInChunk += entriesGotInEachTime;
+        } while (entriesGotInEachTime > 0 && entriesGotInChunk < entriesToReadInChunk);
+
+        if (entriesGotInTotal + entriesGotInChunk > entriesMax) {
+            LOC_LOGW("%s] dropped %zu unexpected location(s).",
+                     __func__, entriesGotInTotal + entriesGotInChunk - entriesMax);
+            entriesGotInChunk = entriesMax - entriesGotInTotal;
+        }
+        entriesGotInTotal += entriesGotInChunk;
+        locations.resize(entriesGotInChunk);
+        if (BATCHING_MODE_ROUTINE == batchingMode) {
+            std::reverse(locations.begin(), locations.end());
+        }
+
+        if (entriesGotInChunk > 0 || 0 == chunks) {
+            LOC_LOGD("%s] Calling reportLocations with chunk %u of %zu locations",
+                     __func__, chunks, entriesGotInChunk);
+            // calling the base class
+            reportLocations(chunk, batchingMode);
+        }
+        chunks++;
+    } while (entriesGotInEachTime > 0 && entriesGotInTotal < entriesToReadInTotal);
+
+    LOC_LOGD("%s] Read out %zu batched locations from modem in %u chunk(s).",
+             __func__, entriesGotInTotal, chunks);
+}
+
 LocationError LocApiV02::queryAccumulatedTripDistanceSync(uint32_t &accumulatedTripDistance,
         uint32_t &numOfBatchedPositions)
 {
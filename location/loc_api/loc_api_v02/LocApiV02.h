@@ -36,6 +36,10 @@
 #include <vector>
 #include <functional>
 #include <unordered_map>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <LocTimer.h>
 
 #define LOC_SEND_SYNC_REQ(NAME, ID, REQ)  \
     int rv = true; \
@@ -60,7 +64,36 @@
     }
 
 using Resender = std::function<void()>;
+// continuation of an asynchronous request, indPayload is nullptr unless
+// status is eLOC_CLIENT_SUCCESS
+using AsyncReqContinuation =
+        std::function<void(locClientStatusEnumType status, const void* indPayload)>;
 using namespace loc_core;
+using loc_util::LocTimer;
+
+class LocApiV02;
+
+// fires at the time out of the soonest asynchronous request in flight
+class AsyncReqTimer : public LocTimer {
+public:
+    inline AsyncReqTimer(LocApiV02& api) : LocTimer(), mApi(api), mDueMs(0) {}
+    void start(uint64_t dueMs);
+    void stop();
+    inline uint64_t getDueMs() const { return mDueMs; }
+    virtual void timeOutCallback();
+private:
+    LocApiV02& mApi;
+    uint64_t mDueMs; // boot time it fires at, 0 when not running
+};
+
+// fires at the deadline of the epoch bundle being assembled
+class EpochBundleTimer : public LocTimer {
+public:
+    inline EpochBundleTimer(LocApiV02& api) : LocTimer(), mApi(api) {}
+    virtual void timeOutCallback();
+private:
+    LocApiV02& mApi;
+};
 
 typedef struct
 {
@@ -147,7 +180,11 @@ private:
   bool mMasterRegisterNotSupported;
   uint32_t mCounter;
   uint32_t mMinInterval;
-  std::vector<adrData>  mADRdata;
+  // carrier phase tracking data of the prior epoch, by adrDataKey()
+  std::unordered_map<uint64_t, adrData> mADRdata;
+  // report being assembled, from mGnssMeasurementsPool; mGnssMeasurements
+  // is a shortcut to the buffer
+  GnssMeasurementsPtr mGnssMeasurementsBuf;
   GnssMeasurements*  mGnssMeasurements;
   bool mGPSreceived;
   int  mMsInWeek;
@@ -165,6 +202,93 @@ private:
   ElapsedRealtimeEstimator mMeasElapsedRealTimeCal;
   ElapsedRealtimeEstimator mPositionElapsedRealTimeCal;
 
+  // asynchronous requests in flight, by transaction id; only accessed
+  // in the LocApi MsgTask
+  struct AsyncReq {
+      uint64_t deadlineMs;
+      AsyncReqContinuation continuation;
+  };
+  std::map<uint32_t, AsyncReq> mAsyncReqs;
+  uint32_t mAsyncReqTxnId;
+  AsyncReqTimer mAsyncReqTimer;
+  friend class AsyncReqTimer;
+
+  /* Called in the QMI indication thread on completion of an asynchronous request */
+  static void asyncReqIndCb(void* userData, uint32_t txnId,
+                            void* indPayload, uint32_t indPayloadSize);
+  void completeAsyncReq(uint32_t txnId, locClientStatusEnumType status,
+                        const void* indPayload);
+  void expireAsyncReqs();
+  void cancelAsyncReqs();
+
+  // geofence requests in flight, by the transaction id they are sent with,
+  // and those waiting for one of the window to complete; only accessed in
+  // the LocApi MsgTask
+  std::map<uint32_t, AsyncReqContinuation> mGeofenceReqs;
+  std::deque<std::function<void(uint32_t txnId)>> mQueuedGeofenceReqs;
+  uint32_t mGeofenceReqTxnId;
+  bool mSendingGeofenceReqs;
+
+  // send is called once fewer than GEOFENCE_REQ_WINDOW geofence requests are
+  // in flight, with the transaction id to set in its request
+  void queueGeofenceReq(std::function<void(uint32_t txnId)> send);
+  void sendQueuedGeofenceReqs();
+  void completeGeofenceReq(uint32_t txnId, locClientStatusEnumType status,
+                           const void* indPayload);
+  template <typename IndT>
+  void sendGeofenceReq(uint32_t txnId, uint32_t reqId, locClientReqUnionType reqPayload,
+          uint32_t indId, AsyncReqContinuation continuation);
+  // queues editReq, its transaction id is set when it is sent
+  void sendEditGeofenceReq(const qmiLocEditGeofenceReqMsgT_v02& editReq,
+                           LocApiResponse* adapterResponse);
+
+  // latest ephemeris of each SV, by constellation << 16 | SV id, used to
+  // drop the entries that repeat it from the ephemeris reports; written in
+  // mIndMsgTask, read by getSvEphemeris from any thread
+  union SvEphemerisData {
+      GpsEphemeris gps;
+      GlonassEphemeris glonass;
+      BdsEphemeris bds;
+      GalileoEphemeris galileo;
+  };
+  std::mutex mSvEphemerisLock;
+  std::map<uint32_t, SvEphemerisData> mSvEphemeris;
+  // last polynomial reported for each SV, by SV id; only accessed in mIndMsgTask
+  std::unordered_map<uint16_t, GnssSvPolynomial> mSvPolynomials;
+
+  // event indications are copied into a pooled buffer in the QMI callback
+  // thread and converted in mIndMsgTask, so the QMI callback thread never
+  // waits on the conversion; mIndQtimer is the QTimer tick count at which
+  // the indication being converted came in
+  loc_util::LocBufferPool<std::vector<uint8_t>> mIndBufferPool;
+  uint64_t mIndQtimer;
+  MsgTask mIndMsgTask;
+
+  // The position, SV, measurement, NMEA, data and latency reports of the
+  // epoch being assembled, sent up as one by LocApiBase::reportEpochBundle()
+  // once a report of another epoch comes in, or at the deadline, when
+  // EPOCH_BUNDLE_TIMEOUT_MS is set; only accessed in mIndMsgTask
+  std::unique_ptr<LocApiEpochBundle> mEpochBundle;
+  uint64_t mEpochBundleDueMs;
+  EpochBundleTimer mEpochBundleTimer;
+  friend class EpochBundleTimer;
+
+  // the open bundle, or a new one, for a report of gpsTowMs, -1 if it has
+  // none; the open bundle is sent up first if the report is of another epoch
+  LocApiEpochBundle* joinEpochBundle(int gpsTowMs);
+  void flushEpochBundle();
+  void expireEpochBundle();
+  // the epoch reports, gathered into mEpochBundle or passed straight on
+  void reportEpochPosition(UlpLocation& location, GpsLocationExtended& locationExtended,
+                           enum loc_sess_status status, LocPosTechMask techMask,
+                           GnssDataNotification* pDataNotify, int msInWeek, int gpsTowMs);
+  void reportEpochSv(GnssSvNotification& svNotify);
+  void reportEpochNmea(const char* nmea, int length);
+  void reportEpochData(GnssDataNotification& dataNotify, int msInWeek, int gpsTowMs);
+  void reportEpochMeasurements(const GnssMeasurementsPtr& measurements, int msInWeek,
+                               int gpsTowMs);
+  void reportEpochLatencyInfo(GnssLatencyInfo& latencyInfo);
+
   /* Convert event mask from loc eng to loc_api_v02 format */
   static locClientEventMaskType convertMask(LOC_API_ADAPTER_EVENT_MASK_T mask);
 
@@ -207,6 +331,18 @@ private:
   /* Convert GnssPowerMode to QMI Loc Power Mode Enum */
   static qmiLocPowerModeEnumT_v02 convertPowerMode(GnssPowerMode powerMode);
 
+  /* Set the protocol config parameters of GnssConfig in a QMI request */
+  static void fillSUPLVersion(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+      GnssConfigSuplVersion version);
+  static void fillLPPConfig(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+      GnssConfigLppProfileMask profileMask);
+  static void fillAGLONASSProtocol(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+      GnssConfigAGlonassPositionProtocolMask aGlonassProtocol);
+  static void fillLPPeProtocolCp(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+      GnssConfigLppeControlPlaneMask lppeCP);
+  static void fillLPPeProtocolUp(qmiLocSetProtocolConfigParametersReqMsgT_v02& req,
+      GnssConfigLppeUserPlaneMask lppeUP);
+
   void convertGnssMeasurementsHeader(const Gnss_LocSvSystemEnumType locSvSystemType,
       const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_info);
 
@@ -251,6 +387,14 @@ private:
           GnssSvEphemerisReport &);
   void populateQzssEphemeris(const qmiLocQzssEphemerisReportIndMsgT_v02 *,
           GnssSvEphemerisReport &);
+  /* drops the entries already in mSvEphemeris from the list and updates
+     mSvEphemeris with the rest, returns the number of entries dropped */
+  template <typename EphemerisT>
+  uint16_t dedupSvEphemeris(Gnss_LocSvSystemEnumType constellation,
+          EphemerisT* ephemerisList, uint16_t& numOfEphemeris);
+  template <typename EphemerisT>
+  void copySvEphemeris(Gnss_LocSvSystemEnumType constellation,
+          EphemerisT* ephemerisList, uint16_t& numOfEphemeris);
   void populateCommonEphemeris(const qmiLocEphGnssDataStructT_v02 &, GnssEphCommon &);
   void populateGpsTimeOfReport(const qmiLocGnssTimeStructT_v02 &, GnssSystemTimeStructType &);
 
@@ -296,13 +440,26 @@ private:
 
   void reportSvMeasurementInternal();
 
+  // the previous report may still be held by the adapters, so a new
+  // report is always assembled in a buffer freshly taken from the pool.
+  // Only the fixed part of it is cleared here, the measurement slots are
+  // cleared by convertGnssMeasurements as each part of the epoch fills them.
   inline void resetSvMeasurementReport(){
-      memset(mGnssMeasurements, 0, sizeof(GnssMeasurements));
-      mGnssMeasurements->size = sizeof(GnssMeasurements);
-      mGnssMeasurements->gnssSvMeasurementSet.size = sizeof(GnssSvMeasurementSet);
-      mGnssMeasurements->gnssSvMeasurementSet.isNhz = false;
-      mGnssMeasurements->gnssSvMeasurementSet.svMeasSetHeader.size =
-          sizeof(GnssSvMeasurementHeader);
+      mGnssMeasurementsBuf = mGnssMeasurementsPool.acquire();
+      mGnssMeasurements = mGnssMeasurementsBuf.get();
+      if (nullptr != mGnssMeasurements) {
+          GnssSvMeasurementSet& svMeasSet = mGnssMeasurements->gnssSvMeasurementSet;
+          GnssMeasurementsNotification& measNotif = mGnssMeasurements->gnssMeasNotification;
+          mGnssMeasurements->size = sizeof(GnssMeasurements);
+          svMeasSet.size = sizeof(GnssSvMeasurementSet);
+          svMeasSet.isNhz = false;
+          memset(&svMeasSet.svMeasSetHeader, 0, sizeof(GnssSvMeasurementHeader));
+          svMeasSet.svMeasSetHeader.size = sizeof(GnssSvMeasurementHeader);
+          svMeasSet.svMeasCount = 0;
+          measNotif.size = 0;
+          measNotif.count = 0;
+          memset(&measNotif.clock, 0, sizeof(GnssMeasurementsClock));
+      }
       memset(&mTimeBiases, 0, sizeof(mTimeBiases));
       mGPSreceived = false;
       mMsInWeek = -1;
@@ -341,6 +498,7 @@ private:
   LocationError releaseBatchBuffer(BatchingMode batchMode);
   void readModemLocations(Location* pLocationPiece, size_t count,
           BatchingMode batchingMode, size_t& numbOfEntries);
+  void streamModemLocations(size_t entriesToReadInTotal, BatchingMode batchingMode);
   void setOperationMode(GnssSuplMode mode);
   bool needsNewTripBatchRestart(uint32_t newTripDistance, uint32_t newTripTBFInterval,
           uint32_t &accumulatedDistance, uint32_t &numOfBatchedPositions);
@@ -366,7 +524,13 @@ protected:
 public:
   static LocApiBase* createLocApiV02(LOC_API_ADAPTER_EVENT_MASK_T exMask,
                                      ContextBase* context);
-  /* event callback registered with the loc_api v02 interface */
+  /* called in the QMI callback thread, queues the event for eventCb */
+  void queueEventInd(locClientHandleType client_handle,
+                     uint32_t loc_event_id,
+                     const locClientEventIndUnionType& loc_event_payload);
+
+  /* event callback registered with the loc_api v02 interface, called
+     in mIndMsgTask */
   virtual void eventCb(locClientHandleType client_handle,
                uint32_t loc_event_id,
                locClientEventIndUnionType loc_event_payload);
@@ -471,6 +635,8 @@ public:
       setAGLONASSProtocolSync(GnssConfigAGlonassPositionProtocolMask aGlonassProtocol);
   virtual LocationError setLPPeProtocolCpSync(GnssConfigLppeControlPlaneMask lppeCP);
   virtual LocationError setLPPeProtocolUpSync(GnssConfigLppeUserPlaneMask lppeUP);
+  virtual LocationError setProtocolConfigSync(const GnssConfig& gnssConfig,
+                                              GnssConfigFlagsMask& failedFlags);
   virtual void getWwanZppFix();
   virtual void
       handleWwanZppFixIndication(const qmiLocGetAvailWwanPositionIndMsgT_v02 &zpp_ind);
@@ -536,9 +702,21 @@ public:
   virtual void getConstellationMultiBandConfig(uint32_t sessionId,
                                       LocApiResponse* adapterResponse=nullptr);
 
+  virtual bool getSvEphemeris(Gnss_LocSvSystemEnumType constellation,
+                              GnssSvEphemerisReport& svEphemeris);
+
   locClientStatusEnumType locSyncSendReq(uint32_t req_id, locClientReqUnionType req_payload,
           uint32_t timeout_msec, uint32_t ind_id, void* ind_payload_ptr);
 
+  // Sends a request without waiting for its indication, so the LocApi
+  // MsgTask can keep more requests in flight. The continuation is called
+  // in the LocApi MsgTask with the indication, or with the failure status
+  // if the request is not acknowledged or times out. Unlike locSyncSendReq,
+  // a request the engine is too busy for is not resent. Only to be called
+  // in the LocApi MsgTask.
+  void sendReqAsync(uint32_t reqId, locClientReqUnionType reqPayload,
+          uint32_t timeoutMsec, uint32_t indId, AsyncReqContinuation continuation);
+
   inline locClientStatusEnumType locClientSendReq(uint32_t req_id,
           locClientReqUnionType req_payload) {
       return ::locClientSendReq(clientHandle, req_id, req_payload);
@@ -33,6 +33,8 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <atomic>
+#include <new>
 #include <loc_cfg.h>
 #include "loc_api_v02_client.h"
 #include "loc_api_sync_req.h"
@@ -48,7 +50,12 @@
 #define LOG_TAG "LocSvc_api_v02"
 #include "loc_util_log.h"
 
-#define LOC_SYNC_REQ_BUFFER_SIZE 8
+/* Slots are added a chunk at a time, up to LOC_SYNC_REQ_MAX_CHUNKS chunks,
+   as concurrent sync requests need them. A chunk is never freed, so the
+   indication path can walk the allocated slots without a lock. */
+#define LOC_SYNC_REQ_CHUNK_SIZE 8
+#define LOC_SYNC_REQ_MAX_CHUNKS 8
+#define LOC_SYNC_REQ_MAX_SLOTS (LOC_SYNC_REQ_CHUNK_SIZE * LOC_SYNC_REQ_MAX_CHUNKS)
 pthread_mutex_t  loc_sync_call_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static bool loc_sync_call_initialized = false;
@@ -62,7 +69,7 @@ typedef struct {
    /*  waiting conditional variable */
    pthread_cond_t          ind_arrived_cond;
 
-   /* Callback waiting data block, protected by loc_cb_data_mutex */
+   /* Callback waiting data block, protected by sync_req_lock */
    bool                    ind_is_selected;              /* is cb selected? */
    bool                    ind_is_waiting;               /* is waiting?     */
    bool                    ind_has_arrived;              /* callback has arrived */
@@ -70,12 +77,28 @@ typedef struct {
    void                    *recv_ind_payload_ptr; /* received  payload */
    uint32_t                recv_ind_id;      /* received  ind   */
 
+   /* Completion of an asynchronous request, NULL for a sync one or once
+      claimed by the indication or a cancel; protected by sync_req_lock */
+   loc_async_req_cb        async_cb;
+   void                    *async_user_data;
+   uint32_t                async_txn_id;
+
+   /* Allocation state, protected by loc_sync_call_mutex */
+   bool                    slot_in_use;
+
+   /* Lookup key of the indication path, read without lock. The handle is
+      LOC_CLIENT_INVALID_HANDLE_VALUE while no ind is selected. */
+   std::atomic<locClientHandleType> key_client_handle;
+   std::atomic<uint32_t>   key_ind_id;
+
 } loc_sync_req_data_s_type;
 
 typedef struct {
-   bool                        in_use;  /* at least one sync call is active */
-   bool                        slot_in_use[LOC_SYNC_REQ_BUFFER_SIZE];
-   loc_sync_req_data_s_type    slots[LOC_SYNC_REQ_BUFFER_SIZE];
+   /* allocated slots, published with release once initialized */
+   std::atomic<int>            num_slots;
+   /* slots with a selected ind, the indication path returns if none */
+   std::atomic<int>            num_selected;
+   loc_sync_req_data_s_type    *chunks[LOC_SYNC_REQ_MAX_CHUNKS];
 } loc_sync_req_array_s_type;
 
 /***************************************************************************
@@ -83,43 +106,56 @@ typedef struct {
  **************************************************************************/
 loc_sync_req_array_s_type loc_sync_array;
 
+static inline loc_sync_req_data_s_type* loc_get_slot(int select_id)
+{
+   return &loc_sync_array.chunks[select_id / LOC_SYNC_REQ_CHUNK_SIZE]
+                                [select_id % LOC_SYNC_REQ_CHUNK_SIZE];
+}
+
+static void loc_free_slot(int select_id);
+
 /*===========================================================================
 
-FUNCTION   loc_sync_req_init
+FUNCTION   loc_add_slot_chunk
 
 DESCRIPTION
-   Initialize this module
+   Allocates and initializes the next chunk of slots, with
+   loc_sync_call_mutex held
 
 DEPENDENCIES
    N/A
 
 RETURN VALUE
-   none
+   true                : a chunk was added
+   false               : no more chunks
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-void loc_sync_req_init()
+static bool loc_add_slot_chunk()
 {
-   LOC_LOGV(" %s:%d]:\n", __func__, __LINE__);
-   UTIL_READ_CONF_DEFAULT(LOC_PATH_GPS_CONF);
-   pthread_mutex_lock(&loc_sync_call_mutex);
-   if(true == loc_sync_call_initialized)
+   int num_slots = loc_sync_array.num_slots.load(std::memory_order_relaxed);
+   int chunk_id = num_slots / LOC_SYNC_REQ_CHUNK_SIZE;
+
+   if (chunk_id >= LOC_SYNC_REQ_MAX_CHUNKS)
    {
-      LOC_LOGD("%s:%d]:already initialized\n", __func__, __LINE__);
-      pthread_mutex_unlock(&loc_sync_call_mutex);
-      return;
+      return false;
    }
 
-   loc_sync_array.in_use = false;
-
-   memset(loc_sync_array.slot_in_use, 0, sizeof(loc_sync_array.slot_in_use));
+   loc_sync_req_data_s_type *chunk =
+         new (std::nothrow) loc_sync_req_data_s_type[LOC_SYNC_REQ_CHUNK_SIZE];
+   if (NULL == chunk)
+   {
+      LOC_LOGE("%s:%d]: failed to allocate a chunk of %d slots\n",
+               __func__, __LINE__, LOC_SYNC_REQ_CHUNK_SIZE);
+      return false;
+   }
 
    int i;
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE; i++)
+   for (i = 0; i < LOC_SYNC_REQ_CHUNK_SIZE; i++)
    {
-      loc_sync_req_data_s_type *slot = &loc_sync_array.slots[i];
+      loc_sync_req_data_s_type *slot = &chunk[i];
 
       pthread_mutex_init(&slot->sync_req_lock, NULL);
       pthread_condattr_t condAttr;
@@ -135,8 +171,58 @@ void loc_sync_req_init()
       slot->recv_ind_id = 0;       /* ind to wait for   */
       slot->recv_ind_payload_ptr = NULL;
       slot->req_id =  0;   /* req id   */
+      slot->async_cb = NULL;
+      slot->async_user_data = NULL;
+      slot->async_txn_id = 0;
+      slot->slot_in_use = false;
+      slot->key_client_handle.store(LOC_CLIENT_INVALID_HANDLE_VALUE,
+                                    std::memory_order_relaxed);
+      slot->key_ind_id.store(0, std::memory_order_relaxed);
+   }
+
+   loc_sync_array.chunks[chunk_id] = chunk;
+   loc_sync_array.num_slots.store(num_slots + LOC_SYNC_REQ_CHUNK_SIZE,
+                                  std::memory_order_release);
+   LOC_LOGD("%s:%d]: %d slots\n", __func__, __LINE__,
+            num_slots + LOC_SYNC_REQ_CHUNK_SIZE);
+   return true;
+}
+
+/*===========================================================================
+
+FUNCTION   loc_sync_req_init
+
+DESCRIPTION
+   Initialize this module
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   none
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_sync_req_init()
+{
+   LOC_LOGV(" %s:%d]:\n", __func__, __LINE__);
+   UTIL_READ_CONF_DEFAULT(LOC_PATH_GPS_CONF);
+   pthread_mutex_lock(&loc_sync_call_mutex);
+   if(true == loc_sync_call_initialized)
+   {
+      LOC_LOGD("%s:%d]:already initialized\n", __func__, __LINE__);
+      pthread_mutex_unlock(&loc_sync_call_mutex);
+      return;
    }
 
+   loc_sync_array.num_slots.store(0, std::memory_order_relaxed);
+   loc_sync_array.num_selected.store(0, std::memory_order_relaxed);
+   memset(loc_sync_array.chunks, 0, sizeof(loc_sync_array.chunks));
+
+   loc_add_slot_chunk();
+
    loc_sync_call_initialized = true;
    pthread_mutex_unlock(&loc_sync_call_mutex);
 }
@@ -147,7 +233,9 @@ void loc_sync_req_init()
 FUNCTION    loc_sync_process_ind
 
 DESCRIPTION
-   Wakes up blocked API calls to check if the needed callback has arrived
+   Wakes up blocked API calls to check if the needed callback has arrived.
+   Called for every indication, it takes no global lock, and only locks
+   the slot the indication is selected in, if any.
 
 DEPENDENCIES
    N/A
@@ -170,28 +258,49 @@ void loc_sync_process_ind(
    LOC_LOGV("%s:%d]: received indication, handle = %p ind_id = %u \n",
                  __func__,__LINE__, client_handle, ind_id);
 
-   pthread_mutex_lock(&loc_sync_call_mutex);
-
-   if (!loc_sync_array.in_use)
+   if (0 == loc_sync_array.num_selected.load(std::memory_order_acquire))
    {
-      LOC_LOGD("%s:%d]: loc_sync_array not in use \n",
+      LOC_LOGV("%s:%d]: loc_sync_array not in use \n",
                     __func__, __LINE__);
-      pthread_mutex_unlock(&loc_sync_call_mutex);
       return;
    }
 
-   bool in_use = false, consumed = false;
+   bool consumed = false;
+   int num_slots = loc_sync_array.num_slots.load(std::memory_order_acquire);
    int i;
+   int async_id = -1;
+   loc_async_req_cb async_cb = NULL;
+   void *async_user_data = NULL;
+   uint32_t async_txn_id = 0;
 
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE && !consumed; i++)
+   for (i = 0; i < num_slots && !consumed; i++)
    {
-      loc_sync_req_data_s_type *slot = &loc_sync_array.slots[i];
+      loc_sync_req_data_s_type *slot = loc_get_slot(i);
 
-      in_use |= loc_sync_array.slot_in_use[i];
+      if (slot->key_client_handle.load(std::memory_order_acquire) != client_handle ||
+          slot->key_ind_id.load(std::memory_order_relaxed) != ind_id)
+      {
+         continue;
+      }
 
       pthread_mutex_lock(&slot->sync_req_lock);
 
-      if ( (loc_sync_array.slot_in_use[i]) && (slot->client_handle == client_handle)
+      /* the key may have changed since it was read, check again */
+      if ( (slot->ind_is_selected) && (slot->client_handle == client_handle)
+            && (ind_id == slot->recv_ind_id) && (NULL != slot->async_cb))
+      {
+         LOC_LOGV("%s:%d]: found async slot %d selected for ind %u \n",
+                       __func__, __LINE__, i, ind_id);
+
+         /* claimed here, completed once the slot is unlocked */
+         async_id = i;
+         async_cb = slot->async_cb;
+         async_user_data = slot->async_user_data;
+         async_txn_id = slot->async_txn_id;
+         slot->async_cb = NULL;
+         consumed = true;
+      }
+      else if ( (slot->ind_is_selected) && (slot->client_handle == client_handle)
             && (ind_id == slot->recv_ind_id) && (!slot->ind_has_arrived))
       {
          LOC_LOGV("%s:%d]: found slot %d selected for ind %u \n",
@@ -226,11 +335,11 @@ void loc_sync_process_ind(
       pthread_mutex_unlock(&slot->sync_req_lock);
    }
 
-   if (!in_use) {
-      loc_sync_array.in_use = false;
+   if (async_id >= 0)
+   {
+      loc_free_slot(async_id);
+      async_cb(async_user_data, async_txn_id, ind_payload_ptr, ind_payload_size);
    }
-
-   pthread_mutex_unlock(&loc_sync_call_mutex);
 }
 
 /*===========================================================================
@@ -238,7 +347,8 @@ void loc_sync_process_ind(
 FUNCTION    loc_alloc_slot
 
 DESCRIPTION
-   Allocates a buffer slot for the synchronous API call
+   Allocates a buffer slot for the synchronous API call, adding a chunk
+   of slots if all of them are in use
 
 DEPENDENCIES
    N/A
@@ -257,16 +367,23 @@ static int loc_alloc_slot()
 
    pthread_mutex_lock(&loc_sync_call_mutex);
 
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE; i++)
+   int num_slots = loc_sync_array.num_slots.load(std::memory_order_relaxed);
+   for (i = 0; i < num_slots; i++)
    {
-      if (!loc_sync_array.slot_in_use[i])
+      if (!loc_get_slot(i)->slot_in_use)
       {
          select_id = i;
-         loc_sync_array.slot_in_use[i] = 1;
-         loc_sync_array.in_use = true;
          break;
       }
    }
+   if (select_id < 0 && loc_add_slot_chunk())
+   {
+      select_id = num_slots;
+   }
+   if (select_id >= 0)
+   {
+      loc_get_slot(select_id)->slot_in_use = true;
+   }
 
    pthread_mutex_unlock(&loc_sync_call_mutex);
    LOC_LOGV("%s:%d]: returning slot %d\n",
@@ -293,16 +410,19 @@ SIDE EFFECTS
 ===========================================================================*/
 static void loc_free_slot(int select_id)
 {
-   int i;
-   loc_sync_req_data_s_type *slot;
-
-   pthread_mutex_lock(&loc_sync_call_mutex);
+   loc_sync_req_data_s_type *slot = loc_get_slot(select_id);
 
    LOC_LOGD("%s:%d]: freeing slot %d\n", __func__, __LINE__, select_id);
 
-   loc_sync_array.slot_in_use[select_id] = 0;
+   pthread_mutex_lock(&slot->sync_req_lock);
 
-   slot = &loc_sync_array.slots[select_id];
+   if (slot->ind_is_selected)
+   {
+      loc_sync_array.num_selected.fetch_sub(1, std::memory_order_relaxed);
+   }
+   slot->key_client_handle.store(LOC_CLIENT_INVALID_HANDLE_VALUE,
+                                 std::memory_order_relaxed);
+   slot->key_ind_id.store(0, std::memory_order_relaxed);
 
    slot->client_handle = LOC_CLIENT_INVALID_HANDLE_VALUE;
    slot->ind_is_selected = false;       /* is ind selected? */
@@ -311,18 +431,14 @@ static void loc_free_slot(int select_id)
    slot->recv_ind_id = 0;       /* ind to wait for   */
    slot->recv_ind_payload_ptr = NULL;
    slot->req_id =  0;
+   slot->async_cb = NULL;
+   slot->async_user_data = NULL;
+   slot->async_txn_id = 0;
 
-   // check if all slots are now free
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE; i++)
-   {
-      if (loc_sync_array.slot_in_use[i]) break;
-   }
-
-   if (i >= LOC_SYNC_REQ_BUFFER_SIZE)
-   {
-      loc_sync_array.in_use = false;
-   }
+   pthread_mutex_unlock(&slot->sync_req_lock);
 
+   pthread_mutex_lock(&loc_sync_call_mutex);
+   slot->slot_in_use = false;
    pthread_mutex_unlock(&loc_sync_call_mutex);
 }
 
@@ -364,7 +480,7 @@ static int loc_sync_select_ind(
       return -ENOMEM;
    }
 
-   loc_sync_req_data_s_type *slot = &loc_sync_array.slots[select_id];
+   loc_sync_req_data_s_type *slot = loc_get_slot(select_id);
 
    pthread_mutex_lock(&slot->sync_req_lock);
 
@@ -377,6 +493,12 @@ static int loc_sync_select_ind(
    slot->req_id      = req_id;
    slot->recv_ind_payload_ptr = ind_payload_ptr; //store the payload ptr
 
+   /* the key is published before the request is sent, so that its
+      indication can not be missed */
+   slot->key_ind_id.store(ind_id, std::memory_order_relaxed);
+   slot->key_client_handle.store(client_handle, std::memory_order_release);
+   loc_sync_array.num_selected.fetch_add(1, std::memory_order_release);
+
    pthread_mutex_unlock(&slot->sync_req_lock);
 
    return select_id;
@@ -408,7 +530,9 @@ static int loc_sync_wait_for_ind(
       uint32_t ind_id
 )
 {
-   if (select_id < 0 || select_id >= LOC_SYNC_REQ_BUFFER_SIZE || !loc_sync_array.slot_in_use[select_id])
+   if (select_id < 0 ||
+       select_id >= loc_sync_array.num_slots.load(std::memory_order_acquire) ||
+       !loc_get_slot(select_id)->ind_is_selected)
    {
       LOC_LOGE("%s:%d]: invalid select_id: %d \n",
                     __func__, __LINE__, select_id);
@@ -416,7 +540,7 @@ static int loc_sync_wait_for_ind(
       return (-EINVAL);
    }
 
-   loc_sync_req_data_s_type *slot = &loc_sync_array.slots[select_id];
+   loc_sync_req_data_s_type *slot = loc_get_slot(select_id);
 
    int ret_val = 0;  /* the return value of this function: 0 = no error */
    int rc;          /* return code from pthread calls */
@@ -543,4 +667,119 @@ locClientStatusEnumType loc_sync_send_req
    return status;
 }
 
+/*===========================================================================
+
+FUNCTION    loc_async_send_req
+
+DESCRIPTION
+   Asynchronous req call (thread safe). It returns once the request is
+   acknowledged, cb is then called in the QMI indication thread with the
+   indication, unless loc_async_cancel_req() is called first.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Loc API 2.0 status of the request; cb is only called on success
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+locClientStatusEnumType loc_async_send_req
+(
+      locClientHandleType       client_handle,
+      uint32_t                  req_id,        /* req id */
+      locClientReqUnionType     req_payload,
+      uint32_t                  ind_id,  /* ind ID completing the request */
+      loc_async_req_cb          cb,
+      void                      *user_data,
+      uint32_t                  txn_id   /* passed to cb along with user_data */
+)
+{
+   locClientStatusEnumType status = eLOC_CLIENT_SUCCESS;
+
+   if (NULL == cb)
+   {
+      return eLOC_CLIENT_FAILURE_INVALID_PARAMETER;
+   }
+
+   int select_id = loc_sync_select_ind(client_handle, ind_id, req_id, NULL);
+   if (select_id < 0)
+   {
+      return eLOC_CLIENT_FAILURE_NOT_ENOUGH_MEMORY;
+   }
+
+   loc_sync_req_data_s_type *slot = loc_get_slot(select_id);
+
+   /* set before the request goes out, its indication completes it */
+   pthread_mutex_lock(&slot->sync_req_lock);
+   slot->async_cb = cb;
+   slot->async_user_data = user_data;
+   slot->async_txn_id = txn_id;
+   pthread_mutex_unlock(&slot->sync_req_lock);
+
+   status = locClientSendReq(client_handle, req_id, req_payload);
+   LOC_LOGV("%s:%d]: select_id = %d,locClientSendReq returned %d\n",
+                 __func__, __LINE__, select_id, status);
 
+   if (status != eLOC_CLIENT_SUCCESS && loc_async_cancel_req(user_data, txn_id))
+   {
+      LOC_LOGE("%s:%d]: failed, select id %d, status %s", __func__, __LINE__,
+               select_id, loc_get_v02_client_status_name(status));
+   }
+
+   return status;
+}
+
+/*===========================================================================
+
+FUNCTION    loc_async_cancel_req
+
+DESCRIPTION
+   Cancels a pending asynchronous request, e.g. on its time out
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true                : the request was pending, cb will not be called
+   false               : cb has been or is being called
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_async_cancel_req(void *user_data, uint32_t txn_id)
+{
+   int i, select_id = -1;
+
+   pthread_mutex_lock(&loc_sync_call_mutex);
+
+   int num_slots = loc_sync_array.num_slots.load(std::memory_order_relaxed);
+   for (i = 0; i < num_slots && select_id < 0; i++)
+   {
+      loc_sync_req_data_s_type *slot = loc_get_slot(i);
+
+      if (!slot->slot_in_use)
+      {
+         continue;
+      }
+      pthread_mutex_lock(&slot->sync_req_lock);
+      if (NULL != slot->async_cb && user_data == slot->async_user_data &&
+          txn_id == slot->async_txn_id)
+      {
+         slot->async_cb = NULL;
+         select_id = i;
+      }
+      pthread_mutex_unlock(&slot->sync_req_lock);
+   }
+
+   pthread_mutex_unlock(&loc_sync_call_mutex);
+
+   if (select_id >= 0)
+   {
+      loc_free_slot(select_id);
+   }
+   return (select_id >= 0);
+}
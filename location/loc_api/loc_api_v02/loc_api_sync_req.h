@@ -63,6 +63,32 @@ extern locClientStatusEnumType loc_sync_send_req
       void                      *ind_payload_ptr /* can be NULL*/
 );
 
+/* Completion of an asynchronous request, called in the QMI indication
+   thread. The indication payload is only valid during the call. */
+typedef void (*loc_async_req_cb)(
+      void                    *user_data,
+      uint32_t                txn_id,
+      void                    *ind_payload_ptr,
+      uint32_t                ind_payload_size
+);
+
+/* Asynchronous request, returns once the request is acknowledged; on
+   success cb is called with its indication, unless it is cancelled first */
+extern locClientStatusEnumType loc_async_send_req
+(
+      locClientHandleType       client_handle,
+      uint32_t                  req_id,        /* req id */
+      locClientReqUnionType     req_payload,
+      uint32_t                  ind_id,  /* ind ID completing the request */
+      loc_async_req_cb          cb,
+      void                      *user_data,
+      uint32_t                  txn_id   /* passed to cb along with user_data */
+);
+
+/* Cancels a pending asynchronous request. Returns false if its cb has been
+   or is being called. */
+extern bool loc_async_cancel_req(void *user_data, uint32_t txn_id);
+
 #ifdef __cplusplus
 }
 #endif
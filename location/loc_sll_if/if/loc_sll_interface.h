@@ -1810,6 +1810,77 @@ typedef struct {
 
 } SllInterfaceReq;
 
+/**
+    The completion of an SLL asynchronous request. This interface API should be call by SLL
+    once a request made through SllInterfaceAsyncReq is done, in any SLL context.
+    It must be called exactly once for every request that was accepted.
+
+    @datatypes
+    #loc_api_adapter_err
+
+    @param reqId[Input]      Request ID the request was made with.
+
+    @param status[Input]     LOC_API_ADAPTER_ERR_SUCCESS if the request succeeded,
+                             other status indicate as failure.
+
+    @param context[Input]    Context Pointer of Synergy Location API.
+
+    @return
+        None.
+
+    @dependencies
+        None.
+*/
+typedef void (*sllAsyncReqCompleteCb)(uint32_t reqId, enum loc_api_adapter_err status,
+                                      void *context);
+
+/** SLL module's asynchronous Interface commands.
+    These commands are optional, and should implement by SLL module if it can have
+    several requests in flight. Unlike the SllInterfaceReq commands, they return
+    as soon as the request is accepted, and the result comes later with the
+    sllAsyncReqCompleteCb, tagged with the request ID given here. So Synergy
+    Location API can send its next request without waiting for the previous one.
+    SLL module shall carry out the requests in the order they are made.
+    Any command may be NULL, then the SllInterfaceReq command is used instead.
+
+    All of them return LOC_API_ADAPTER_ERR_SUCCESS if the request is accepted, and
+    other status if it is not, in which case sllAsyncReqCompleteCb shall not be called.
+ */
+typedef struct {
+    /** Asynchronous version of sllStartFix. */
+    enum loc_api_adapter_err (*sllStartFixAsync)(uint32_t reqId, sllPosMode& fixCriteria,
+                                                 void *context);
+
+    /** Asynchronous version of sllStopFix. */
+    enum loc_api_adapter_err (*sllStopFixAsync)(uint32_t reqId, void *context);
+
+    /** Asynchronous version of sllDeleteAidingData. */
+    enum loc_api_adapter_err (*sllDeleteAidingDataAsync)(uint32_t reqId,
+                                                         const GnssAidingData& data,
+                                                         void *context);
+
+    /** Asynchronous version of sllInjectPosition. */
+    enum loc_api_adapter_err (*sllInjectPositionAsync)(uint32_t reqId,
+                                const GnssLocationInfoNotification &locationInfo,
+                                bool onDemandCpi, void *context);
+
+    /** Asynchronous version of sllSetConstrainedTuncMode. */
+    enum loc_api_adapter_err (*sllSetConstrainedTuncModeAsync)(uint32_t reqId, bool enabled,
+                                float tuncConstraint, uint32_t energyBudget, void *context);
+
+    /** Asynchronous version of sllSetPositionAssistedClockEstimatorMode. */
+    enum loc_api_adapter_err (*sllSetPositionAssistedClockEstimatorModeAsync)(uint32_t reqId,
+                                bool enabled, void *context);
+
+    /** Asynchronous version of sllSetConstellationControl. */
+    enum loc_api_adapter_err (*sllSetConstellationControlAsync)(uint32_t reqId,
+                                const GnssSvTypeConfig& config, void *context);
+
+    /** Asynchronous version of sllResetConstellationControl. */
+    enum loc_api_adapter_err (*sllResetConstellationControlAsync)(uint32_t reqId,
+                                                                  void *context);
+} SllInterfaceAsyncReq;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -1871,6 +1942,33 @@ extern "C" {
     typedef const SllInterfaceReq* (*get_sll_if_api_t)
                                        (const SllInterfaceEvent* eventCallback, void *context);
 
+    /**
+      The optional Synergy location layer(SLL) asynchronous interface function. It is
+      looked up by Synergy LOC API module after get_sll_if_api, and an SLL module that
+      does not implement it is only used through the SllInterfaceReq commands.
+      The execution context will identify using ‘void *context’ variable.
+
+      @datatypes
+      #SllInterfaceAsyncReq \n
+      #sllAsyncReqCompleteCb
+
+      @param completeCb[Input]      Completion of the asynchronous requests. SLL module
+                                    should store and call it once per accepted request.
+      @param context[Input]         Context Pointer of Synergy Location API.
+
+      @return
+           SllInterfaceAsyncReq[Output]  These are asynchronous Interface commands of SLL
+                                         module, or NULL if there is none.
+
+      @dependencies
+           None.
+    */
+    const SllInterfaceAsyncReq* get_sll_async_if_api(sllAsyncReqCompleteCb completeCb,
+                                                     void *context);
+
+    typedef const SllInterfaceAsyncReq* (*get_sll_async_if_api_t)
+                                       (sllAsyncReqCompleteCb completeCb, void *context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,9 +40,137 @@
 
 #include <LocationApiMsg.h>
 #include <LocationApiPbMsgConv.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <lz4frame.h>
 
 using namespace loc_util;
 
+// FLAT WIRE FORMAT
+// ****************
+bool LocAPIFlatMsgHeader::serialize(ELocMsgID msgId, const void* payload,
+                                    uint32_t payloadSize, string& flatStr) {
+    LocAPIFlatMsgHeader head = {
+        LOCATION_REMOTE_API_FLAT_MAGIC,
+        LOCATION_REMOTE_API_FLAT_VERSION,
+        (uint16_t)sizeof(LocAPIFlatMsgHeader),
+        (uint32_t)msgId,
+        payloadSize
+    };
+    flatStr.reserve(sizeof(head) + payloadSize);
+    flatStr.assign(reinterpret_cast<const char*>(&head), sizeof(head));
+    flatStr.append(reinterpret_cast<const char*>(payload), payloadSize);
+    return true;
+}
+
+const char* LocAPIFlatMsgHeader::getPayload(const char* data, uint32_t length,
+                                            ELocMsgID& msgId, uint32_t& payloadSize) {
+    LocAPIFlatMsgHeader head;
+    if (length < sizeof(head)) {
+        return nullptr;
+    }
+    memcpy(&head, data, sizeof(head));
+    if (LOCATION_REMOTE_API_FLAT_MAGIC != head.magic) {
+        return nullptr;
+    }
+    if (LOCATION_REMOTE_API_FLAT_VERSION != head.version ||
+            head.headerSize < sizeof(head) ||
+            (uint64_t)head.headerSize + head.payloadSize != length) {
+        LOC_LOGe("flat msg version %u, head %u, payload %u do not fit length %u",
+                 head.version, head.headerSize, head.payloadSize, length);
+        return nullptr;
+    }
+    msgId = (ELocMsgID)head.msgId;
+    payloadSize = head.payloadSize;
+    return data + head.headerSize;
+}
+
+
+// LZ4 WIRE FORMAT
+// ***************
+bool LocAPILz4MsgHeader::compress(const char* data, uint32_t length, string& lz4Str) {
+    if (length < LOCATION_REMOTE_API_LZ4_MIN_SIZE) {
+        return false;
+    }
+    LZ4F_preferences_t prefs = {};
+    prefs.frameInfo.contentSize = length;
+    size_t bound = LZ4F_compressFrameBound(length, &prefs);
+    LocAPILz4MsgHeader head = {
+        LOCATION_REMOTE_API_LZ4_MAGIC,
+        LOCATION_REMOTE_API_LZ4_VERSION,
+        (uint16_t)sizeof(LocAPILz4MsgHeader),
+        length
+    };
+    lz4Str.resize(sizeof(head) + bound);
+    memcpy(&lz4Str[0], &head, sizeof(head));
+    size_t frameSize = LZ4F_compressFrame(&lz4Str[sizeof(head)], bound, data, length, &prefs);
+    if (LZ4F_isError(frameSize)) {
+        LOC_LOGe("lz4 compress of %u bytes failed: %s", length, LZ4F_getErrorName(frameSize));
+        return false;
+    }
+    if (sizeof(head) + frameSize >= length) {
+        return false;
+    }
+    lz4Str.resize(sizeof(head) + frameSize);
+    return true;
+}
+
+bool LocAPILz4MsgHeader::isCompressed(const char* data, uint32_t length) {
+    uint32_t magic;
+    if (length < sizeof(LocAPILz4MsgHeader)) {
+        return false;
+    }
+    memcpy(&magic, data, sizeof(magic));
+    return LOCATION_REMOTE_API_LZ4_MAGIC == magic;
+}
+
+bool LocAPILz4MsgHeader::decompress(const char* data, uint32_t length, string& rawStr) {
+    LocAPILz4MsgHeader head;
+    if (!isCompressed(data, length)) {
+        return false;
+    }
+    memcpy(&head, data, sizeof(head));
+    if (LOCATION_REMOTE_API_LZ4_VERSION != head.version ||
+            head.headerSize < sizeof(head) || head.headerSize > length ||
+            head.rawSize > LOCATION_REMOTE_API_LZ4_MAX_SIZE) {
+        LOC_LOGe("lz4 msg version %u, head %u, raw size %u do not fit length %u",
+                 head.version, head.headerSize, head.rawSize, length);
+        return false;
+    }
+
+    LZ4F_dctx* dctx = nullptr;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) {
+        LOC_LOGe("lz4 decompression context failed");
+        return false;
+    }
+    rawStr.resize(head.rawSize);
+    const char* src = data + head.headerSize;
+    size_t srcLeft = length - head.headerSize;
+    size_t dstDone = 0;
+    size_t ret = 1;
+    // a frame ends with ret 0, which needs all of the raw msg to be in place
+    while (0 != ret && srcLeft > 0) {
+        size_t dstSize = head.rawSize - dstDone;
+        size_t srcSize = srcLeft;
+        ret = LZ4F_decompress(dctx, &rawStr[0] + dstDone, &dstSize, src, &srcSize, nullptr);
+        if (LZ4F_isError(ret)) {
+            break;
+        }
+        dstDone += dstSize;
+        src += srcSize;
+        srcLeft -= srcSize;
+        if (0 == srcSize && 0 == dstSize) {
+            break;
+        }
+    }
+    LZ4F_freeDecompressionContext(dctx);
+    if (0 != ret || dstDone != head.rawSize) {
+        LOC_LOGe("lz4 msg of length %u failed to decompress to %u bytes: %s", length,
+                 head.rawSize, LZ4F_isError(ret) ? LZ4F_getErrorName(ret) : "truncated");
+        rawStr.clear();
+        return false;
+    }
+    return true;
+}
 
 // SERIALIZE RIGID TO PROTOBUF FORMAT
 // **********************************
@@ -50,6 +178,105 @@ using namespace loc_util;
 // to protobuf structure and serialized to string passed in the function. This payload can be
 // be passed over IPC.
 
+// Emit the header followed by its payload msg straight into protoStr. Sizes are computed
+// up front, so protoStr is sized once and the payload is never staged in a string of its
+// own before being copied into the header's bytes field. Protobuf decoders take fields in
+// any order, so payload = 4 may follow payloadSize = 5 on the wire.
+static int serializeWithPayload(const PBLocAPIMsgHeader& pbHdr,
+                                const google::protobuf::MessageLite& pbPayload,
+                                string& protoStr) {
+    using google::protobuf::io::CodedOutputStream;
+    // bytes       payload = 4; length delimited
+    const uint32_t payloadTag = (PBLocAPIMsgHeader::kPayloadFieldNumber << 3) | 2;
+
+    if (!pbHdr.payload().empty()) {
+        LOC_LOGe("pbHdr payload already set!");
+        return 0;
+    }
+    const size_t hdrSize = pbHdr.ByteSizeLong();
+    const size_t payloadSize = pbPayload.ByteSizeLong();
+    if (payloadSize > INT32_MAX / 2) {
+        LOC_LOGe("payload size %zu too large!", payloadSize);
+        return 0;
+    }
+    const size_t totalSize = hdrSize + CodedOutputStream::VarintSize32(payloadTag) +
+            CodedOutputStream::VarintSize32((uint32_t)payloadSize) + payloadSize;
+
+    protoStr.resize(totalSize);
+    uint8_t* target = reinterpret_cast<uint8_t*>(&protoStr[0]);
+    // sizes were cached by the ByteSizeLong() calls above
+    target = pbHdr.SerializeWithCachedSizesToArray(target);
+    target = CodedOutputStream::WriteVarint32ToArray(payloadTag, target);
+    target = CodedOutputStream::WriteVarint32ToArray((uint32_t)payloadSize, target);
+    target = pbPayload.SerializeWithCachedSizesToArray(target);
+    if (reinterpret_cast<uint8_t*>(&protoStr[0]) + totalSize != target) {
+        LOC_LOGe("serialized %zu bytes, expected %zu!",
+                 (size_t)(target - reinterpret_cast<uint8_t*>(&protoStr[0])), totalSize);
+        protoStr.clear();
+        return 0;
+    }
+    return protoStr.size();
+}
+
+// The protobuf msgs of the indications are built on an arena of the thread that
+// serializes them, reset once the outermost serialization on the thread is done.
+// The arena starts on a block of its own, so that, for a msg that fits the block,
+// building it and its nested and repeated fields takes no malloc.
+#define LOC_API_SERIALIZE_ARENA_BLOCK_SIZE (64 * 1024)
+
+class SerializeArena {
+public:
+    inline SerializeArena() : mThreadArena(getThreadArena()) {
+        mThreadArena.depth++;
+    }
+    inline ~SerializeArena() {
+        if (0 == --mThreadArena.depth) {
+            mThreadArena.arena.Reset();
+        }
+    }
+    template <typename PbMsg>
+    inline PbMsg& create() {
+        return *google::protobuf::Arena::CreateMessage<PbMsg>(&mThreadArena.arena);
+    }
+
+private:
+    struct ThreadArena {
+        unique_ptr<char[]> block;
+        google::protobuf::Arena arena;
+        uint32_t depth;
+
+        inline ThreadArena() :
+                block(new char[LOC_API_SERIALIZE_ARENA_BLOCK_SIZE]),
+                arena(getOptions(block.get())),
+                depth(0) {}
+        static inline google::protobuf::ArenaOptions getOptions(char* block) {
+            google::protobuf::ArenaOptions options;
+            options.initial_block = block;
+            options.initial_block_size = LOC_API_SERIALIZE_ARENA_BLOCK_SIZE;
+            return options;
+        }
+    };
+    static inline ThreadArena& getThreadArena() {
+        static thread_local ThreadArena sThreadArena;
+        return sThreadArena;
+    }
+
+    ThreadArena& mThreadArena;
+};
+
+// A client holding a token from the hal daemon sends the token in place of its
+// socket name. Registration always goes by name, as that is what the token is
+// handed out for.
+static inline void setPbMsgSender(PBLocAPIMsgHeader& pbHdr, const char* socketName,
+                                  const LocationApiPbMsgConv* pbMsgConv) {
+    uint32_t clientToken = pbMsgConv->getClientToken();
+    if (0 != clientToken) {
+        pbHdr.set_mclienttoken(clientToken);
+    } else {
+        pbHdr.set_msocketname(socketName);
+    }
+}
+
 // Convert LocAPIClientRegisterReqMsg -> PBLocAPIClientRegisterReqMsg payload
 int LocAPIClientRegisterReqMsg::serializeToProtobuf(string& protoStr) {
     PBLocAPIMsgHeader pLocApiMsgHdr;
@@ -70,23 +297,14 @@ int LocAPIClientRegisterReqMsg::serializeToProtobuf(string& protoStr) {
     // >>>> PBLocAPIClientRegisterReqMsg conversion
     // PBClientType mClientType = 1;
     pbLocApiClientRegMsg.set_mclienttype(pLocApiPbMsgConv->getPBEnumForClientType(mClientType));
-
-    string pbStr;
-    if (!pbLocApiClientRegMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiClientRegMsg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
+    // uint32 mWireFormats = 2;
+    pbLocApiClientRegMsg.set_mwireformats(mWireFormats);
 
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIClientRegisterReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiClientRegMsg, protoStr);
 }
 
 // Convert LocAPIClientDeregisterReqMsg -> PBLocAPIClientDeregisterReqMsg
@@ -97,8 +315,8 @@ int LocAPIClientDeregisterReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -124,8 +342,8 @@ int LocAPICapabilitiesIndMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -136,23 +354,14 @@ int LocAPICapabilitiesIndMsg::serializeToProtobuf(string& protoStr) {
     // uint64 capabilitiesMask = 1;
     pbLocApiCapabInd.set_capabilitiesmask(
             pLocApiPbMsgConv->getPBMaskForLocationCapabilitiesMask(capabilitiesMask));
-
-    string pbStr;
-    if (!pbLocApiCapabInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiCapabInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
+    // uint32 clientToken = 2;
+    pbLocApiCapabInd.set_clienttoken(clientToken);
 
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPICapabilitiesIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiCapabInd, protoStr);
 }
 
 // Convert LocAPIHalReadyIndMsg -> PBLocAPIHalReadyIndMsg
@@ -164,8 +373,8 @@ int LocAPIHalReadyIndMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -191,8 +400,8 @@ int LocAPIGenericRespMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -202,22 +411,11 @@ int LocAPIGenericRespMsg::serializeToProtobuf(string& protoStr) {
     // PBLocationError err = 1;
     pbLocApiGenericMsg.set_err(pLocApiPbMsgConv->getPBEnumForLocationError(err));
 
-    string pbStr;
-    if (!pbLocApiGenericMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGenericMsg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGenericRespMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiGenericMsg, protoStr);
 }
 
 // Convert LocAPICollectiveRespMsg -> PBLocAPICollectiveRespMsg
@@ -229,8 +427,8 @@ int LocAPICollectiveRespMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -250,24 +448,14 @@ int LocAPICollectiveRespMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiCollctvRspMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiCollctvRspMsg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPICollectiveRespMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiCollctvRspMsg, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPICollectiveRespMsg(pbLocApiCollctvRspMsg);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIStartTrackingReqMsg -> PBLocAPIStartTrackingReqMsg
@@ -279,8 +467,8 @@ int LocAPIStartTrackingReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -300,24 +488,14 @@ int LocAPIStartTrackingReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiStartTrack.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStartTrack failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStartTrackingReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiStartTrack, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIStartTrackingReqMsg(pbLocApiStartTrack);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIStopTrackingReqMsg -> PBLocAPIStopTrackingReqMsg
@@ -328,8 +506,8 @@ int LocAPIStopTrackingReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -355,8 +533,8 @@ int LocAPIUpdateCallbacksReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -367,22 +545,11 @@ int LocAPIUpdateCallbacksReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiUpdateCbsReg.set_locationcallbacks(
             pLocApiPbMsgConv->getPBMaskForLocationCallbacksMask(locationCallbacks));
 
-    string pbStr;
-    if (!pbLocApiUpdateCbsReg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUpdateCbsReg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateCallbacksReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiUpdateCbsReg, protoStr);
 }
 
 // Convert LocAPIUpdateTrackingOptionsReqMsg -> PBLocAPIUpdateTrackingOptionsReqMsg
@@ -394,8 +561,8 @@ int LocAPIUpdateTrackingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -415,24 +582,14 @@ int LocAPIUpdateTrackingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiUpdtTrackOpt.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUpdtTrackOpt failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateTrackingOptionsReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiUpdtTrackOpt, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIUpdateTrackingOptionsReqMsg(pbLocApiUpdtTrackOpt);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIStartBatchingReqMsg -> PBLocAPIStartBatchingReqMsg
@@ -444,8 +601,8 @@ int LocAPIStartBatchingReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -459,22 +616,11 @@ int LocAPIStartBatchingReqMsg::serializeToProtobuf(string& protoStr) {
     // PBBatchingMode batchingMode = 3;
     pbLocApiStartBatch.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
 
-    string pbStr;
-    if (!pbLocApiStartBatch.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStartBatch failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStartBatchingReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiStartBatch, protoStr);
 }
 
 // Convert LocAPIStopBatchingReqMsg -> PBLocAPIStopBatchingReqMsg
@@ -485,8 +631,8 @@ int LocAPIStopBatchingReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -512,8 +658,8 @@ int LocAPIUpdateBatchingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -527,22 +673,11 @@ int LocAPIUpdateBatchingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
     // PBBatchingMode batchingMode = 3;
     pbLocApiUptBatchOpt.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
 
-    string pbStr;
-    if (!pbLocApiUptBatchOpt.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUptBatchOpt failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateBatchingOptionsReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiUptBatchOpt, protoStr);
 }
 
 // Convert LocAPIAddGeofencesReqMsg -> PBLocAPIAddGeofencesReqMsg
@@ -554,8 +689,8 @@ int LocAPIAddGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -575,24 +710,14 @@ int LocAPIAddGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiAddGfReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiAddGfReqMsg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIAddGeofencesReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiAddGfReqMsg, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIAddGeofencesReqMsg(pbLocApiAddGfReqMsg);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIRemoveGeofencesReqMsg -> PBLocAPIRemoveGeofencesReqMsg
@@ -604,8 +729,8 @@ int LocAPIRemoveGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -625,24 +750,14 @@ int LocAPIRemoveGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiRemGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiRemGf failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIRemoveGeofencesReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiRemGf, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIRemoveGeofencesReqMsg(pbLocApiRemGf);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIModifyGeofencesReqMsg -> PBLocAPIModifyGeofencesReqMsg
@@ -654,8 +769,8 @@ int LocAPIModifyGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -675,24 +790,14 @@ int LocAPIModifyGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiModGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiModGf failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIModifyGeofencesReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiModGf, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIModifyGeofencesReqMsg(pbLocApiModGf);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIPauseGeofencesReqMsg -> PBLocAPIPauseGeofencesReqMsg
@@ -704,8 +809,8 @@ int LocAPIPauseGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -725,24 +830,14 @@ int LocAPIPauseGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiPauseGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPauseGf failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPauseGeofencesReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiPauseGf, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIPauseGeofencesReqMsg(pbLocApiPauseGf);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIResumeGeofencesReqMsg -> PBLocAPIResumeGeofencesReqMsg
@@ -754,8 +849,8 @@ int LocAPIResumeGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -775,24 +870,14 @@ int LocAPIResumeGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiResumeGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiResumeGf failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIResumeGeofencesReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiResumeGf, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIResumeGeofencesReqMsg(pbLocApiResumeGf);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIUpdateNetworkAvailabilityReqMsg -> PBLocAPIUpdateNetworkAvailabilityReqMsg
@@ -804,8 +889,8 @@ int LocAPIUpdateNetworkAvailabilityReqMsg::serializeToProtobuf(string& protoStr)
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -815,22 +900,11 @@ int LocAPIUpdateNetworkAvailabilityReqMsg::serializeToProtobuf(string& protoStr)
     // bool mAvailability = 1;
     pbLocApiUptNetwAvail.set_mavailability(mAvailability);
 
-    string pbStr;
-    if (!pbLocApiUptNetwAvail.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUptNetwAvail failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateNetworkAvailabilityReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiUptNetwAvail, protoStr);
 }
 
 // Convert LocAPIGetGnssEnergyConsumedReqMsg -> PBLocAPIGetGnssEnergyConsumedReqMsg
@@ -841,8 +915,8 @@ int LocAPIGetGnssEnergyConsumedReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -869,8 +943,8 @@ int LocAPIGetSingleTerrestrialPosReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -885,23 +959,11 @@ int LocAPIGetSingleTerrestrialPosReqMsg::serializeToProtobuf(string& protoStr) {
     // float horQoS = 3;
     pbLocGetTerrestrialPosReq.set_horqos(mHorQoS);
 
-    string pbStr;
-    if (!pbLocGetTerrestrialPosReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetTerrestrialPosReq failed!");
-        return 0;
-    }
-
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSingleTerrestrialPosReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocGetTerrestrialPosReq, protoStr);
 }
 
 // Decode PBLocConfigEngineRunStateReqMsg -> LocConfigEngineRunStateReqMsg
@@ -926,8 +988,8 @@ int LocAPIGetSingleTerrestrialPosRespMsg::serializeToProtobuf(string& protoStr)
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -950,26 +1012,14 @@ int LocAPIGetSingleTerrestrialPosRespMsg::serializeToProtobuf(string& protoStr)
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocGetTerrestrialPosResp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetTerrestrialPosResp failed!");
-        return 0;
-    }
-
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSingleTerrestrialPosRespMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocGetTerrestrialPosResp, protoStr);
     // free the location
     pbLocGetTerrestrialPosResp.clear_location();
-    return protoStr.size();
+    return protoSize;
 }
 
 // Decode PBLocAPIGetSingleTerrestrialPosRespMsg -> LocAPIGetSingleTerrestrialPosRespMsg
@@ -993,15 +1043,16 @@ LocAPIGetSingleTerrestrialPosRespMsg::LocAPIGetSingleTerrestrialPosRespMsg(
 
 // Convert LocAPILocationIndMsg -> PBLocAPILocationIndMsg
 int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPILocationIndMsg pbLocApiLocInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPILocationIndMsg& pbLocApiLocInd = arena.create<PBLocAPILocationIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1013,7 +1064,6 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != location) {
         if (pLocApiPbMsgConv->convertLocationToPB(locationNotification, location)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(location);
             return 0;
         }
     } else {
@@ -1021,37 +1071,25 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPILocationIndMsg(pbLocApiLocInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiLocInd, protoStr);
 }
 
 // Convert LocAPIBatchingIndMsg -> PBLocAPIBatchingIndMsg
 int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIBatchingIndMsg pbLocApiBatchInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIBatchingIndMsg& pbLocApiBatchInd = arena.create<PBLocAPIBatchingIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1064,7 +1102,6 @@ int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLocAPIBatchingNotifMsgToPB(batchNotification,
                 locApiBatchIndMsg)) {
             LOC_LOGe("convertLocAPIBatchingNotifMsgToPB failed");
-            free(locApiBatchIndMsg);
             return 0;
         }
     } else {
@@ -1072,37 +1109,25 @@ int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiBatchInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiBatchInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIBatchingIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIBatchingIndMsg(pbLocApiBatchInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiBatchInd, protoStr);
 }
 
 // Convert LocAPIGeofenceBreachIndMsg -> PBLocAPIGeofenceBreachIndMsg
 int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIGeofenceBreachIndMsg pbLocApiGfBreach;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIGeofenceBreachIndMsg& pbLocApiGfBreach = arena.create<PBLocAPIGeofenceBreachIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1116,7 +1141,6 @@ int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLocAPIGfBreachNotifToPB(gfBreachNotification,
                 locApiGfBreachNotif)) {
             LOC_LOGe("convertLocAPIGfBreachNotifToPB failed");
-            free(locApiGfBreachNotif);
             return 0;
         }
     } else {
@@ -1124,37 +1148,25 @@ int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiGfBreach.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGfBreach failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGeofenceBreachIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIGeofenceBreachIndMsg(pbLocApiGfBreach);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiGfBreach, protoStr);
 }
 
 // Convert LocAPILocationInfoIndMsg -> PBLocAPILocationInfoIndMsg
 int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPILocationInfoIndMsg pbLocApiLocInfoInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPILocationInfoIndMsg& pbLocApiLocInfoInd = arena.create<PBLocAPILocationInfoIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1168,7 +1180,6 @@ int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertGnssLocInfoNotifToPB(gnssLocationInfoNotification,
                 gnssLocInfoNotif)) {
             LOC_LOGe("convertGnssLocInfoNotifToPB failed");
-            free(gnssLocInfoNotif);
             return 0;
         }
     } else {
@@ -1176,37 +1187,26 @@ int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocInfoInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocInfoInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationInfoIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPILocationInfoIndMsg(pbLocApiLocInfoInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiLocInfoInd, protoStr);
 }
 
 // Convert LocAPIEngineLocationsInfoIndMsg -> PBLocAPIEngineLocationsInfoIndMsg
 int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIEngineLocationsInfoIndMsg pbLocApiEngLocInfo;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIEngineLocationsInfoIndMsg& pbLocApiEngLocInfo =
+            arena.create<PBLocAPIEngineLocationsInfoIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1223,7 +1223,6 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
             if (pLocApiPbMsgConv->convertGnssLocInfoNotifToPB(engineLocationsInfo[i],
                     gnssLocInfoNotif)) {
                 LOC_LOGe("convertGnssLocInfoNotifToPB failed");
-                free(gnssLocInfoNotif);
                 return 0;
             }
         } else {
@@ -1232,37 +1231,26 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
         }
     }
 
-    string pbStr;
-    if (!pbLocApiEngLocInfo.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiEngLocInfo failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIEngineLocationsInfoIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIEngineLocationsInfoIndMsg(pbLocApiEngLocInfo);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiEngLocInfo, protoStr);
 }
 
 // Convert LocAPISatelliteVehicleIndMsg -> PBLocAPISatelliteVehicleIndMsg
 int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPISatelliteVehicleIndMsg pbLocApiSatVehInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPISatelliteVehicleIndMsg& pbLocApiSatVehInd =
+            arena.create<PBLocAPISatelliteVehicleIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1274,7 +1262,6 @@ int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gnssSvNotif) {
         if (pLocApiPbMsgConv->convertGnssSvNotifToPB(gnssSvNotification, gnssSvNotif)) {
             LOC_LOGe("convertGnssSvNotifToPB failed");
-            free(gnssSvNotif);
             return 0;
         }
     } else {
@@ -1282,37 +1269,25 @@ int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiSatVehInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiSatVehInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPISatelliteVehicleIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPISatelliteVehicleIndMsg(pbLocApiSatVehInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiSatVehInd, protoStr);
 }
 
 // Convert LocAPINmeaIndMsg -> PBLocAPINmeaIndMsg
 int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPINmeaIndMsg pbLocApiNmeaInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPINmeaIndMsg& pbLocApiNmeaInd = arena.create<PBLocAPINmeaIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1326,7 +1301,6 @@ int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLocAPINmeaSerializedPayloadToPB(gnssNmeaNotification,
                 locAPINmeaSerPload)) {
             LOC_LOGe("convertLocAPINmeaSerializedPayloadToPB failed");
-            free(locAPINmeaSerPload);
             return 0;
         }
     } else {
@@ -1334,37 +1308,25 @@ int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiNmeaInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiNmeaInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPINmeaIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPINmeaIndMsg(pbLocApiNmeaInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiNmeaInd, protoStr);
 }
 
 // Convert LocAPIDataIndMsg -> PBLocAPIDataIndMsg
 int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIDataIndMsg pbLocApiDataInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIDataIndMsg& pbLocApiDataInd = arena.create<PBLocAPIDataIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1376,7 +1338,6 @@ int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
     if (nullptr != gnssDataNotif) {
         if (pLocApiPbMsgConv->convertGnssDataNotifToPB(gnssDataNotification, gnssDataNotif)) {
             LOC_LOGe("convertGnssDataNotifToPB failed");
-            free(gnssDataNotif);
             return 0;
         }
     } else {
@@ -1384,37 +1345,25 @@ int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiDataInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiDataInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIDataIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIDataIndMsg(pbLocApiDataInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiDataInd, protoStr);
 }
 
 // Convert LocAPIMeasIndMsg -> PBLocAPIMeasIndMsg
 int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIMeasIndMsg pbLocApiMeasInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIMeasIndMsg& pbLocApiMeasInd = arena.create<PBLocAPIMeasIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1428,7 +1377,6 @@ int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertGnssMeasNotifToPB(gnssMeasurementsNotification,
                 gnssMeasNotif)) {
             LOC_LOGe("convertGnssMeasNotifToPB failed");
-            free(gnssMeasNotif);
             return 0;
         }
     } else {
@@ -1436,24 +1384,11 @@ int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiMeasInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiMeasInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIMeasIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIMeasIndMsg(pbLocApiMeasInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiMeasInd, protoStr);
 }
 
 // Convert LocAPIGnssEnergyConsumedIndMsg -> PBLocAPIGnssEnergyConsumedIndMsg
@@ -1465,8 +1400,8 @@ int LocAPIGnssEnergyConsumedIndMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1477,35 +1412,26 @@ int LocAPIGnssEnergyConsumedIndMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiGnssEnrgyConsmdInd.set_totalgnssenergyconsumedsincefirstboot(
             totalGnssEnergyConsumedSinceFirstBoot);
 
-    string pbStr;
-    if (!pbLocApiGnssEnrgyConsmdInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGnssEnrgyConsmdInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGnssEnergyConsumedIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiGnssEnrgyConsmdInd, protoStr);
 }
 
 // Convert LocAPILocationSystemInfoIndMsg -> PBLocAPILocationSystemInfoIndMsg
 int LocAPILocationSystemInfoIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPILocationSystemInfoIndMsg pbLocApiLocSysInfoInd;
+    SerializeArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = arena.create<PBLocAPIMsgHeader>();
+    PBLocAPILocationSystemInfoIndMsg& pbLocApiLocSysInfoInd =
+            arena.create<PBLocAPILocationSystemInfoIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1517,7 +1443,6 @@ int LocAPILocationSystemInfoIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != locSysInfo) {
         if (pLocApiPbMsgConv->convertLocSysInfoToPB(locationSystemInfo, locSysInfo)) {
             LOC_LOGe("convertLocSysInfoToPB failed");
-            free(locSysInfo);
             return 0;
         }
     } else {
@@ -1525,24 +1450,11 @@ int LocAPILocationSystemInfoIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocSysInfoInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocSysInfoInd failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationSystemInfoIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPILocationSystemInfoIndMsg(pbLocApiLocSysInfoInd);
-    return protoStr.size();
+    // bytes       payload = 4; the arena frees the msgs
+    return serializeWithPayload(pLocApiMsgHdr, pbLocApiLocSysInfoInd, protoStr);
 }
 
 // Convert LocConfigConstrainedTuncReqMsg -> PBLocConfigConstrainedTuncReqMsg
@@ -1554,8 +1466,8 @@ int LocConfigConstrainedTuncReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1569,22 +1481,11 @@ int LocConfigConstrainedTuncReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32   mEnergyBudget = 3;
     pbLocConfConstrTunc.set_menergybudget(mEnergyBudget);
 
-    string pbStr;
-    if (!pbLocConfConstrTunc.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfConstrTunc failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigConstrainedTuncReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfConstrTunc, protoStr);
 }
 
 // Convert LocConfigPositionAssistedClockEstimatorReqMsg ->
@@ -1597,8 +1498,8 @@ int LocConfigPositionAssistedClockEstimatorReqMsg::serializeToProtobuf(string& p
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1608,22 +1509,11 @@ int LocConfigPositionAssistedClockEstimatorReqMsg::serializeToProtobuf(string& p
     // bool     mEnable = 1;
     pbLocConfPosAsstdClockEst.set_menable(mEnable);
 
-    string pbStr;
-    if (!pbLocConfPosAsstdClockEst.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfPosAsstdClockEst failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigPositionAssistedClockEstimatorReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfPosAsstdClockEst, protoStr);
 }
 
 // Convert LocConfigSvConstellationReqMsg -> PBLocConfigSvConstellationReqMsg
@@ -1635,8 +1525,8 @@ int LocConfigSvConstellationReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1674,25 +1564,14 @@ int LocConfigSvConstellationReqMsg::serializeToProtobuf(string& protoStr) {
     bool resetToDefault = (0 == mConstellationEnablementConfig.size);
     pbLocConfSvConst.set_mresettodefault(resetToDefault);
 
-    string pbStr;
-    if (!pbLocConfSvConst.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfSvConst failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigSvConstellationReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocConfSvConst, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocConfigSvConstellationReqMsg(pbLocConfSvConst);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocConfigConstellationSecondaryBandReqMsg -> PBLocConfigConstellationSecondaryBandReqMsg
@@ -1704,8 +1583,8 @@ int LocConfigConstellationSecondaryBandReqMsg::serializeToProtobuf(string& proto
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1727,24 +1606,14 @@ int LocConfigConstellationSecondaryBandReqMsg::serializeToProtobuf(string& proto
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgConstlSecBandReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocCfgConstlSecBandReqMsg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigConstellationSecondaryBandReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocCfgConstlSecBandReqMsg, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocConConstllSecBandReqMsg(pbLocCfgConstlSecBandReqMsg);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocConfigAidingDataDeletionReqMsg -> PBLocConfigAidingDataDeletionReqMsg
@@ -1756,8 +1625,8 @@ int LocConfigAidingDataDeletionReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1777,24 +1646,14 @@ int LocConfigAidingDataDeletionReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfAidDataDel.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfAidDataDel failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigAidingDataDeletionReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocConfAidDataDel, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocConAidingDataDeletionReqMsg(pbLocConfAidDataDel);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocConfigLeverArmReqMsg -> PBLocConfigLeverArmReqMsg
@@ -1806,8 +1665,8 @@ int LocConfigLeverArmReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1828,24 +1687,14 @@ int LocConfigLeverArmReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfLeverArm.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfLeverArm failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigLeverArmReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocConfLeverArm, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocConfigLeverArmReqMsg(pbLocConfLeverArm);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocConfigRobustLocationReqMsg -> PBLocConfigRobustLocationReqMsg
@@ -1857,8 +1706,8 @@ int LocConfigRobustLocationReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1870,22 +1719,11 @@ int LocConfigRobustLocationReqMsg::serializeToProtobuf(string& protoStr) {
     // bool mEnableForE911 = 2;
     pbLocConfRobustLoc.set_menablefore911(mEnableForE911);
 
-    string pbStr;
-    if (!pbLocConfRobustLoc.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfRobustLoc failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigRobustLocationReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfRobustLoc, protoStr);
 }
 
 // Convert LocConfigMinGpsWeekReqMsg -> PBLocConfigMinGpsWeekReqMsg
@@ -1897,8 +1735,8 @@ int LocConfigMinGpsWeekReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1908,22 +1746,11 @@ int LocConfigMinGpsWeekReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinGpsWeek = 1;
     pbLocConfMinGpsWeek.set_mmingpsweek(mMinGpsWeek);
 
-    string pbStr;
-    if (!pbLocConfMinGpsWeek.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfMinGpsWeek failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigMinGpsWeekReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfMinGpsWeek, protoStr);
 }
 
 // Convert LocConfigDrEngineParamsReqMsg -> PBLocConfigDrEngineParamsReqMsg
@@ -1935,8 +1762,8 @@ int LocConfigDrEngineParamsReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1957,24 +1784,14 @@ int LocConfigDrEngineParamsReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgDrEngParamReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfB2sMntParam failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigDrEngineParamsReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocCfgDrEngParamReq, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocConfDrEngineParamsReqMsg(pbLocCfgDrEngParamReq);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocConfigMinSvElevationReqMsg -> PBLocConfigMinSvElevationReqMsg
@@ -1986,8 +1803,8 @@ int LocConfigMinSvElevationReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -1997,22 +1814,11 @@ int LocConfigMinSvElevationReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinSvElevation = 1;
     pbLocConfMinSvElev.set_mminsvelevation(mMinSvElevation);
 
-    string pbStr;
-    if (!pbLocConfMinSvElev.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfMinSvElev failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigMinSvElevationReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfMinSvElev, protoStr);
 }
 
 // Convert LocConfigEngineRunStateReqMsg -> PBLocConfigEngineRunStateReqMsg
@@ -2024,8 +1830,8 @@ int LocConfigEngineRunStateReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2039,22 +1845,11 @@ int LocConfigEngineRunStateReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocConfEngineRunState.set_mengstate((::PBLocEngineRunState)
             pLocApiPbMsgConv->getPBEnumForLocEngineRunState(mEngState));
 
-    string pbStr;
-    if (!pbLocConfEngineRunState.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfEngineRunState failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigEngineRunStateReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfEngineRunState, protoStr);
 }
 
 // Convert LocConfigEngineRunStateReqMsg -> PBLocConfigEngineRunStateReqMsg
@@ -2068,8 +1863,8 @@ int LocConfigUserConsentTerrestrialPositioningReqMsg::serializeToProtobuf(
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2079,23 +1874,12 @@ int LocConfigUserConsentTerrestrialPositioningReqMsg::serializeToProtobuf(
     // bool userConsent
     pbMsg.set_userconsent(mUserConsent);
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(
             sizeof(LocConfigUserConsentTerrestrialPositioningReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbMsg, protoStr);
 }
 
 // Decode PBLocConfigEngineRunStateReqMsg -> LocConfigEngineRunStateReqMsg
@@ -2110,6 +1894,46 @@ LocConfigUserConsentTerrestrialPositioningReqMsg::
     mUserConsent = pbMsg.userconsent();
 }
 
+// Convert LocConfigBatchReqMsg -> PBLocConfigBatchReqMsg
+int LocConfigBatchReqMsg::serializeToProtobuf(string& protoStr) {
+
+    PBLocAPIMsgHeader pLocApiMsgHdr;
+    PBLocConfigBatchReqMsg pbMsg;
+
+    if (nullptr == pLocApiPbMsgConv) {
+        LOC_LOGe("pLocApiPbMsgConv is null!");
+        return 0;
+    }
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
+    // PBELocMsgID  msgId = 2;
+    pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
+    // uint32   msgVersion = 3;
+    pLocApiMsgHdr.set_msgversion(msgVersion);
+
+    // >>>> PBLocConfigBatchReqMsg conversion
+    // repeated bytes mConfigMsgs = 1;
+    for (const string& configMsg : mConfigMsgs) {
+        pbMsg.add_mconfigmsgs(configMsg);
+    }
+
+    // uint32   payloadSize = 5;
+    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigBatchReqMsg));
+
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbMsg, protoStr);
+}
+
+// Decode PBLocConfigBatchReqMsg -> LocConfigBatchReqMsg
+LocConfigBatchReqMsg::LocConfigBatchReqMsg(const char* name,
+        const PBLocConfigBatchReqMsg &pbMsg, const LocationApiPbMsgConv *pbMsgConv):
+        LocAPIMsgHeader(name, E_INTAPI_CONFIG_BATCH_MSG_ID, pbMsgConv) {
+    mConfigMsgs.reserve(pbMsg.mconfigmsgs_size());
+    for (int i = 0; i < pbMsg.mconfigmsgs_size(); i++) {
+        mConfigMsgs.push_back(pbMsg.mconfigmsgs(i));
+    }
+}
+
 // Convert LocConfigGetRobustLocationConfigReqMsg -> PBLocConfigGetRobustLocationConfigReqMsg
 int LocConfigGetRobustLocationConfigReqMsg::serializeToProtobuf(string& protoStr) {
     PBLocAPIMsgHeader pLocApiMsgHdr;
@@ -2118,8 +1942,8 @@ int LocConfigGetRobustLocationConfigReqMsg::serializeToProtobuf(string& protoStr
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2145,8 +1969,8 @@ int LocConfigGetRobustLocationConfigRespMsg::serializeToProtobuf(string& protoSt
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2168,24 +1992,14 @@ int LocConfigGetRobustLocationConfigRespMsg::serializeToProtobuf(string& protoSt
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfGetRobustLocConfg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetRobustLocConfg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetRobustLocationConfigRespMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocConfGetRobustLocConfg, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocConGetRbstLocCfgRespMsg(pbLocConfGetRobustLocConfg);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocConfigGetMinGpsWeekReqMsg -> PBLocConfigGetMinGpsWeekReqMsg
@@ -2196,8 +2010,8 @@ int LocConfigGetMinGpsWeekReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2223,8 +2037,8 @@ int LocConfigGetMinGpsWeekRespMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2234,22 +2048,11 @@ int LocConfigGetMinGpsWeekRespMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinGpsWeek = 1;
     pbLocConfGetMinGpsWeekRsp.set_mmingpsweek(mMinGpsWeek);
 
-    string pbStr;
-    if (!pbLocConfGetMinGpsWeekRsp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetMinGpsWeekRsp failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinGpsWeekRespMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfGetMinGpsWeekRsp, protoStr);
 }
 
 // Convert LocConfigGetMinSvElevationReqMsg -> PBLocConfigGetMinSvElevationReqMsg
@@ -2260,8 +2063,8 @@ int LocConfigGetMinSvElevationReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2287,8 +2090,8 @@ int LocConfigGetMinSvElevationRespMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2298,22 +2101,11 @@ int LocConfigGetMinSvElevationRespMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinSvElevation = 1;
     pbLocConfGetMinSvElev.set_mminsvelevation(mMinSvElevation);
 
-    string pbStr;
-    if (!pbLocConfGetMinSvElev.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetMinSvElev failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinSvElevationRespMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
-    return protoStr.size();
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbLocConfGetMinSvElev, protoStr);
 }
 
 // Convert LocConfigGetConstellationSecondaryBandConfigReqMsg to
@@ -2325,8 +2117,8 @@ int LocConfigGetConstellationSecondaryBandConfigReqMsg::serializeToProtobuf(stri
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2353,8 +2145,8 @@ int LocConfigGetConstellationSecondaryBandConfigRespMsg::serializeToProtobuf(str
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2376,26 +2168,85 @@ int LocConfigGetConstellationSecondaryBandConfigRespMsg::serializeToProtobuf(str
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgGetConstlSecBandRespMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocCfgGetConstlSecBandRespMsg failed!");
+    // uint32   payloadSize = 5;
+    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetConstellationSecondaryBandConfigRespMsg));
+
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocCfgGetConstlSecBandRespMsg, protoStr);
+    // free memory
+    pLocApiPbMsgConv->freeUpPBLocConfGetConstllSecBandCfgRespMsg(pbLocCfgGetConstlSecBandRespMsg);
+    return protoSize;
+}
+
+// Convert LocAPIGetClientStatsReqMsg -> PBLocAPIGetClientStatsReqMsg
+int LocAPIGetClientStatsReqMsg::serializeToProtobuf(string& protoStr) {
+    PBLocAPIMsgHeader pLocApiMsgHdr;
+
+    if (nullptr == pLocApiPbMsgConv) {
+        LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
+    // PBELocMsgID  msgId = 2;
+    pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
+    // uint32   msgVersion = 3;
+    pLocApiMsgHdr.set_msgversion(msgVersion);
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
+    // LocAPIGetClientStatsReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetConstellationSecondaryBandConfigRespMsg));
+    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetClientStatsReqMsg));
 
     if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
         LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocConfGetConstllSecBandCfgRespMsg(pbLocCfgGetConstlSecBandRespMsg);
     return protoStr.size();
 }
 
+// Convert LocAPIGetClientStatsRespMsg -> PBLocAPIGetClientStatsRespMsg
+int LocAPIGetClientStatsRespMsg::serializeToProtobuf(string& protoStr) {
+    PBLocAPIMsgHeader pLocApiMsgHdr;
+    PBLocAPIGetClientStatsRespMsg pbMsg;
+
+    if (nullptr == pLocApiPbMsgConv) {
+        LOC_LOGe("pLocApiPbMsgConv is null!");
+        return 0;
+    }
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
+    // PBELocMsgID  msgId = 2;
+    pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
+    // uint32   msgVersion = 3;
+    pLocApiMsgHdr.set_msgversion(msgVersion);
+
+    // >>>> PBLocAPIGetClientStatsRespMsg conversion
+    // repeated PBLocAPIClientStats mClientStats = 1;
+    for (const LocAPIClientStats& stats : mClientStats) {
+        PBLocAPIClientStats* pbStats = pbMsg.add_mclientstats();
+        pbStats->set_clientname(stats.clientName);
+        pbStats->set_msgsreceived(stats.msgsReceived);
+        pbStats->set_bytesreceived(stats.bytesReceived);
+        pbStats->set_msgssent(stats.msgsSent);
+        pbStats->set_bytessent(stats.bytesSent);
+        pbStats->set_serializecount(stats.serializeCount);
+        pbStats->set_serializens(stats.serializeNs);
+        pbStats->set_queuedropped(stats.queueDropped);
+        pbStats->set_queuecoalesced(stats.queueCoalesced);
+        pbStats->set_queuehighwater(stats.queueHighWater);
+        pbStats->set_trackingintervalms(stats.trackingIntervalMs);
+        pbStats->set_batchingintervalms(stats.batchingIntervalMs);
+        pbStats->set_geofencecount(stats.geofenceCount);
+        pbStats->set_batchedlocations(stats.batchedLocations);
+    }
+
+    // uint32   payloadSize = 5;
+    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetClientStatsRespMsg));
+
+    // bytes       payload = 4;
+    return serializeWithPayload(pLocApiMsgHdr, pbMsg, protoStr);
+}
+
 // Convert LocAPIPingTestReqMsg -> PBLocAPIPingTestReqMsg
 int LocAPIPingTestReqMsg::serializeToProtobuf(string& protoStr) {
     PBLocAPIMsgHeader pLocApiMsgHdr;
@@ -2405,8 +2256,8 @@ int LocAPIPingTestReqMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2421,24 +2272,14 @@ int LocAPIPingTestReqMsg::serializeToProtobuf(string& protoStr) {
         pbLocApiPingTest.add_data(data[i]);
     }
 
-    string pbStr;
-    if (!pbLocApiPingTest.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPingTest failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPingTestReqMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiPingTest, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIPingTestReqMsg(pbLocApiPingTest);
-    return protoStr.size();
+    return protoSize;
 }
 
 // Convert LocAPIPingTestIndMsg -> PBLocAPIPingTestIndMsg
@@ -2450,8 +2291,8 @@ int LocAPIPingTestIndMsg::serializeToProtobuf(string& protoStr) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return 0;
     }
-    // string      mSocketName = 1;
-    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // string      mSocketName = 1; or uint32   mClientToken = 6;
+    setPbMsgSender(pLocApiMsgHdr, mSocketName, pLocApiPbMsgConv);
     // PBELocMsgID  msgId = 2;
     pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
     // uint32   msgVersion = 3;
@@ -2466,24 +2307,14 @@ int LocAPIPingTestIndMsg::serializeToProtobuf(string& protoStr) {
         pbLocApiPingTestIndMsg.add_data(data[i]);
     }
 
-    string pbStr;
-    if (!pbLocApiPingTestIndMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPingTestIndMsg failed!");
-        return 0;
-    }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
     pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPingTestIndMsg));
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
-        return 0;
-    }
+    // bytes       payload = 4;
+    int protoSize = serializeWithPayload(pLocApiMsgHdr, pbLocApiPingTestIndMsg, protoStr);
     // free memory
     pLocApiPbMsgConv->freeUpPBLocAPIPingTestIndMsg(pbLocApiPingTestIndMsg);
-    return protoStr.size();
+    return protoSize;
 }
 
 
@@ -2496,7 +2327,8 @@ int LocAPIPingTestIndMsg::serializeToProtobuf(string& protoStr) {
 LocAPIClientRegisterReqMsg::LocAPIClientRegisterReqMsg(const char* name,
             const PBLocAPIClientRegisterReqMsg &pbLocApiClientRegReqMsg,
             const LocationApiPbMsgConv *pbMsgConv):
-        LocAPIMsgHeader(name, E_LOCAPI_CLIENT_REGISTER_MSG_ID, pbMsgConv) {
+        LocAPIMsgHeader(name, E_LOCAPI_CLIENT_REGISTER_MSG_ID, pbMsgConv),
+        mWireFormats(0) {
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return;
@@ -2504,13 +2336,16 @@ LocAPIClientRegisterReqMsg::LocAPIClientRegisterReqMsg(const char* name,
     // >>>> PBLocAPIClientRegisterReqMsg conversion
     // PBClientType mClientType = 1;
     mClientType = pLocApiPbMsgConv->getEnumForPBClientType(pbLocApiClientRegReqMsg.mclienttype());
+    // uint32 mWireFormats = 2;
+    mWireFormats = pbLocApiClientRegReqMsg.mwireformats();
 }
 
 // Decode PBLocAPICapabilitiesIndMsg -> LocAPICapabilitiesIndMsg
 LocAPICapabilitiesIndMsg::LocAPICapabilitiesIndMsg(const char* name,
             const PBLocAPICapabilitiesIndMsg &pbLocApiCapInd,
             const LocationApiPbMsgConv *pbMsgConv):
-        LocAPIMsgHeader(name, E_LOCAPI_CAPABILILTIES_MSG_ID, pbMsgConv) {
+        LocAPIMsgHeader(name, E_LOCAPI_CAPABILILTIES_MSG_ID, pbMsgConv),
+        clientToken(0) {
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return;
@@ -2519,6 +2354,8 @@ LocAPICapabilitiesIndMsg::LocAPICapabilitiesIndMsg(const char* name,
     // uint64 capabilitiesMask = 1;
     capabilitiesMask = pLocApiPbMsgConv->getLocationCapabilitiesMaskFromPB(
             pbLocApiCapInd.capabilitiesmask());
+    // uint32 clientToken = 2;
+    clientToken = pbLocApiCapInd.clienttoken();
 }
 
 // Decode PBLocAPIGenericRespMsg -> LocAPIGenericRespMsg
@@ -3108,6 +2945,34 @@ LocConfigGetConstellationSecondaryBandConfigRespMsg::
             pbCfgGetConstSecBandCfgResp.msecondarybandconfig(), mSecondaryBandConfig);
 }
 
+// Decode PBLocAPIGetClientStatsRespMsg -> LocAPIGetClientStatsRespMsg
+LocAPIGetClientStatsRespMsg::LocAPIGetClientStatsRespMsg(const char* name,
+        const PBLocAPIGetClientStatsRespMsg &pbClientStatsResp,
+        const LocationApiPbMsgConv *pbMsgConv):
+        LocAPIMsgHeader(name, E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID, pbMsgConv) {
+    // >>>> PBLocAPIGetClientStatsRespMsg conversion
+    // repeated PBLocAPIClientStats mClientStats = 1;
+    mClientStats.resize(pbClientStatsResp.mclientstats_size());
+    for (int i = 0; i < pbClientStatsResp.mclientstats_size(); i++) {
+        const PBLocAPIClientStats& pbStats = pbClientStatsResp.mclientstats(i);
+        LocAPIClientStats& stats = mClientStats[i];
+        strlcpy(stats.clientName, pbStats.clientname().c_str(), sizeof(stats.clientName));
+        stats.msgsReceived = pbStats.msgsreceived();
+        stats.bytesReceived = pbStats.bytesreceived();
+        stats.msgsSent = pbStats.msgssent();
+        stats.bytesSent = pbStats.bytessent();
+        stats.serializeCount = pbStats.serializecount();
+        stats.serializeNs = pbStats.serializens();
+        stats.queueDropped = pbStats.queuedropped();
+        stats.queueCoalesced = pbStats.queuecoalesced();
+        stats.queueHighWater = pbStats.queuehighwater();
+        stats.trackingIntervalMs = pbStats.trackingintervalms();
+        stats.batchingIntervalMs = pbStats.batchingintervalms();
+        stats.geofenceCount = pbStats.geofencecount();
+        stats.batchedLocations = pbStats.batchedlocations();
+    }
+}
+
 // Decode PBLocAPIPingTestReqMsg -> LocAPIPingTestReqMsg
 LocAPIPingTestReqMsg::LocAPIPingTestReqMsg(const char* name,
             const PBLocAPIPingTestReqMsg &pbPingTestReqMsg,
@@ -30,6 +30,7 @@
 #define LOCATIONAPIMSG_H
 
 #include <string>
+#include <vector>
 #include <memory>
 #include <algorithm>
 #include <loc_pla.h> // for strlcpy
@@ -48,6 +49,10 @@ Constants
 ******************************************************************************/
 #define LOCATION_REMOTE_API_MSG_VERSION (1)
 
+// Wire formats a client can take indications in, besides protobuf
+#define LOCATION_REMOTE_API_WIRE_FORMAT_FLAT (1 << 0)
+#define LOCATION_REMOTE_API_WIRE_FORMAT_LZ4  (1 << 1)
+
 // Maximum fully qualified path(including the file name)
 // for the location remote API service and client socket name
 #define MAX_SOCKET_PATHNAME_LENGTH (128)
@@ -245,6 +250,10 @@ enum ELocMsgID {
     E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_REQ_MSG_ID = 31,
     E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID = 32,
 
+    // resource use of the hal daemon clients request/response msg
+    E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID = 33,
+    E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID = 34,
+
     // ping
     E_LOCAPI_PINGTEST_MSG_ID = 99,
 
@@ -261,6 +270,7 @@ enum ELocMsgID {
     E_INTAPI_CONFIG_CONSTELLATION_SECONDARY_BAND_MSG_ID  = 209,
     E_INTAPI_CONFIG_ENGINE_RUN_STATE_MSG_ID = 210,
     E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID = 211,
+    E_INTAPI_CONFIG_BATCH_MSG_ID = 212,
 
     // integration API config retrieval request/response
     E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID  = 300,
@@ -290,6 +300,9 @@ enum ELocationCallbacksOption {
     E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT  = (1<<9), /**< Register for multiple engine reports */
     E_LOC_CB_SIMPLE_LOCATION_INFO_BIT   = (1<<10), /**< Register for simple location */
     E_LOC_CB_GNSS_MEAS_BIT              = (1<<11), /**< Register for GNSS Measurements */
+    /**< Along with E_LOC_CB_GNSS_NMEA_BIT: the sentences of an epoch may come
+         in one E_LOCAPI_NMEA_MSG_ID, separated by '\n' */
+    E_LOC_CB_GNSS_NMEA_BUNDLE_BIT       = (1<<12),
 };
 
 // Mask related to all info that are tied with a position session and need to be unsubscribed
@@ -297,6 +310,7 @@ enum ELocationCallbacksOption {
 #define LOCATION_SESSON_ALL_INFO_MASK (E_LOC_CB_DISTANCE_BASED_TRACKING_BIT|\
                                        E_LOC_CB_GNSS_LOCATION_INFO_BIT|\
                                        E_LOC_CB_GNSS_SV_BIT|E_LOC_CB_GNSS_NMEA_BIT|\
+                                       E_LOC_CB_GNSS_NMEA_BUNDLE_BIT|\
                                        E_LOC_CB_GNSS_DATA_BIT|E_LOC_CB_GNSS_MEAS_BIT|\
                                        E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT|\
                                        E_LOC_CB_SIMPLE_LOCATION_INFO_BIT)
@@ -363,6 +377,29 @@ struct CollectiveResPayload {
     uint32_t count;
     GeofenceResponse resp[1];
 };
+
+// resource use of one client of the hal daemon, since it registered
+struct LocAPIClientStats {
+    char clientName[MAX_SOCKET_PATHNAME_LENGTH];
+    uint64_t msgsReceived;
+    uint64_t bytesReceived;
+    uint64_t msgsSent;
+    uint64_t bytesSent;
+    // indications serialized, compressed and queued for this client, and
+    // the time in ns that took; one serialized for another client already
+    // is only queued
+    uint64_t serializeCount;
+    uint64_t serializeNs;
+    // msgs its outbound queue dropped, or replaced by newer ones
+    uint64_t queueDropped;
+    uint64_t queueCoalesced;
+    uint32_t queueHighWater;
+    // 0 if not tracking / batching
+    uint32_t trackingIntervalMs;
+    uint32_t batchingIntervalMs;
+    uint32_t geofenceCount;
+    uint64_t batchedLocations;
+};
 /******************************************************************************
 IPC message header structure
 ******************************************************************************/
@@ -373,11 +410,13 @@ struct LocAPIMsgHeader
     ELocMsgID  msgId;               /**< LocationMsgID */
     uint32_t   msgVersion;          /**< Location remote API message version */
     const LocationApiPbMsgConv *pLocApiPbMsgConv; /**< Protobuf converter */
+    uint32_t   mClientToken;        /**< Client token as received, 0 if none */
 
     inline LocAPIMsgHeader(const char* name, ELocMsgID msgId):
         msgId(msgId),
         pLocApiPbMsgConv(nullptr),
-        msgVersion(LOCATION_REMOTE_API_MSG_VERSION) {
+        msgVersion(LOCATION_REMOTE_API_MSG_VERSION),
+        mClientToken(0) {
             memset(mSocketName, 0, MAX_SOCKET_PATHNAME_LENGTH);
             strlcpy(mSocketName, name, MAX_SOCKET_PATHNAME_LENGTH);
         }
@@ -386,7 +425,8 @@ struct LocAPIMsgHeader
             const LocationApiPbMsgConv* locApiPbConv):
         msgId(msgId),
         pLocApiPbMsgConv(locApiPbConv),
-        msgVersion(LOCATION_REMOTE_API_MSG_VERSION) {
+        msgVersion(LOCATION_REMOTE_API_MSG_VERSION),
+        mClientToken(0) {
             memset(mSocketName, 0, MAX_SOCKET_PATHNAME_LENGTH);
             strlcpy(mSocketName, name, MAX_SOCKET_PATHNAME_LENGTH);
         }
@@ -430,6 +470,65 @@ struct LocAPIMsgHeader
     }
 };
 
+/******************************************************************************
+IPC message structure - flat wire format
+******************************************************************************/
+// Head of an indication in the flat wire format, which clients on the same
+// device as the hal daemon can ask for at registration. The local struct of
+// the indication follows the head as is, in the byte order of the device,
+// and is taken over without a parse step. Protobuf stays the format of all
+// other clients and messages.
+#define LOCATION_REMOTE_API_FLAT_MAGIC   (0x5446504c) // "LPFT"
+#define LOCATION_REMOTE_API_FLAT_VERSION (1)
+
+struct LocAPIFlatMsgHeader
+{
+    uint32_t magic;         /**< LOCATION_REMOTE_API_FLAT_MAGIC */
+    uint16_t version;       /**< LOCATION_REMOTE_API_FLAT_VERSION */
+    uint16_t headerSize;    /**< size of this head, the payload follows it */
+    uint32_t msgId;         /**< LocationMsgID */
+    uint32_t payloadSize;   /**< size of the local struct that follows */
+
+    /** Serialize the local struct of an indication to the flat format. */
+    static bool serialize(ELocMsgID msgId, const void* payload, uint32_t payloadSize,
+                          string& flatStr);
+    /** Payload of a flat msg of msgId, if data is one and carries payloadSize bytes,
+        else nullptr. Protobuf msgs never start with the magic. */
+    static const char* getPayload(const char* data, uint32_t length,
+                                  ELocMsgID& msgId, uint32_t& payloadSize);
+};
+
+/******************************************************************************
+IPC message structure - LZ4 wire format
+******************************************************************************/
+// Head of a msg compressed to an LZ4 frame, which clients on a remote node
+// can ask for at registration. Only msgs of LOCATION_REMOTE_API_LZ4_MIN_SIZE
+// bytes and up are compressed, and only if that makes them smaller, so a
+// client has to take both forms. The frame holds the msg as it would have
+// been sent otherwise, protobuf or flat.
+#define LOCATION_REMOTE_API_LZ4_MAGIC    (0x5a4c504c) // "LPLZ"
+#define LOCATION_REMOTE_API_LZ4_VERSION  (1)
+#define LOCATION_REMOTE_API_LZ4_MIN_SIZE (512)
+// a msg claiming more than this is taken as corrupt rather than allocated for
+#define LOCATION_REMOTE_API_LZ4_MAX_SIZE (4 * 1024 * 1024)
+
+struct LocAPILz4MsgHeader
+{
+    uint32_t magic;         /**< LOCATION_REMOTE_API_LZ4_MAGIC */
+    uint16_t version;       /**< LOCATION_REMOTE_API_LZ4_VERSION */
+    uint16_t headerSize;    /**< size of this head, the LZ4 frame follows it */
+    uint32_t rawSize;       /**< size of the msg once decompressed */
+
+    /** Compress msg to lz4Str, false if it is below the minimum size or
+        does not get any smaller. */
+    static bool compress(const char* data, uint32_t length, string& lz4Str);
+    /** True if data starts with the head of a compressed msg. Protobuf and
+        flat msgs never start with the magic. */
+    static bool isCompressed(const char* data, uint32_t length);
+    /** Decompress a compressed msg to rawStr, false if it is corrupt. */
+    static bool decompress(const char* data, uint32_t length, string& rawStr);
+};
+
 /******************************************************************************
 IPC message structure - client registration
 ******************************************************************************/
@@ -437,11 +536,13 @@ IPC message structure - client registration
 struct LocAPIClientRegisterReqMsg: LocAPIMsgHeader
 {
     ClientType mClientType;
+    // LOCATION_REMOTE_API_WIRE_FORMAT_* the client takes indications in
+    uint32_t mWireFormats;
 
     inline LocAPIClientRegisterReqMsg(const char* name, ClientType clientType,
-            const LocationApiPbMsgConv *pbMsgConv) :
+            const LocationApiPbMsgConv *pbMsgConv, uint32_t wireFormats = 0) :
         LocAPIMsgHeader(name, E_LOCAPI_CLIENT_REGISTER_MSG_ID, pbMsgConv),
-        mClientType(clientType) { }
+        mClientType(clientType), mWireFormats(wireFormats) { }
     LocAPIClientRegisterReqMsg(const char* name,
             const PBLocAPIClientRegisterReqMsg &pbLocApiClientRegReqMsg,
             const LocationApiPbMsgConv *pbMsgConv);
@@ -462,11 +563,15 @@ struct LocAPIClientDeregisterReqMsg: LocAPIMsgHeader
 struct LocAPICapabilitiesIndMsg: LocAPIMsgHeader
 {
     LocationCapabilitiesMask capabilitiesMask;
+    // token the client is to send in place of its socket name, 0 if none
+    uint32_t clientToken;
 
     inline LocAPICapabilitiesIndMsg(const char* name,
-        LocationCapabilitiesMask capabilitiesMask, const LocationApiPbMsgConv *pbMsgConv) :
+        LocationCapabilitiesMask capabilitiesMask, const LocationApiPbMsgConv *pbMsgConv,
+        uint32_t clientToken = 0) :
         LocAPIMsgHeader(name, E_LOCAPI_CAPABILILTIES_MSG_ID, pbMsgConv),
-        capabilitiesMask(capabilitiesMask) { }
+        capabilitiesMask(capabilitiesMask),
+        clientToken(clientToken) { }
     LocAPICapabilitiesIndMsg(const char* name,
             const PBLocAPICapabilitiesIndMsg &pbLocApiCapInd,
             const LocationApiPbMsgConv *pbMsgConv);
@@ -1187,6 +1292,22 @@ struct LocConfigUserConsentTerrestrialPositioningReqMsg: LocAPIMsgHeader
     int serializeToProtobuf(string& protoStr) override;
 };
 
+struct LocConfigBatchReqMsg: LocAPIMsgHeader
+{
+    // serialized config requests, in the order they are to be applied
+    vector<string> mConfigMsgs;
+
+    inline LocConfigBatchReqMsg(const char* name, vector<string>&& configMsgs,
+                                const LocationApiPbMsgConv *pbMsgConv) :
+        LocAPIMsgHeader(name, E_INTAPI_CONFIG_BATCH_MSG_ID, pbMsgConv),
+        mConfigMsgs(std::move(configMsgs)) { }
+
+    LocConfigBatchReqMsg(const char* name, const PBLocConfigBatchReqMsg &pbMsg,
+                         const LocationApiPbMsgConv *pbMsgConv);
+
+    int serializeToProtobuf(string& protoStr) override;
+};
+
 /******************************************************************************
 IPC message structure - Location Integration API Get request/response message
 ******************************************************************************/
@@ -1290,6 +1411,36 @@ struct LocConfigGetConstellationSecondaryBandConfigRespMsg: LocAPIMsgHeader
     int serializeToProtobuf(string& protoStr) override;
 };
 
+/******************************************************************************
+IPC message structure - client resource use
+******************************************************************************/
+// defintion for message with msg id of E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID
+struct LocAPIGetClientStatsReqMsg: LocAPIMsgHeader
+{
+    inline LocAPIGetClientStatsReqMsg(const char* name, const LocationApiPbMsgConv *pbMsgConv) :
+        LocAPIMsgHeader(name, E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID, pbMsgConv) { }
+
+    int serializeToProtobuf(string& protoStr) override;
+};
+
+// defintion for message with msg id of E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID
+struct LocAPIGetClientStatsRespMsg: LocAPIMsgHeader
+{
+    // one per client registered with the hal daemon
+    vector<LocAPIClientStats> mClientStats;
+
+    inline LocAPIGetClientStatsRespMsg(const char* name,
+                                       vector<LocAPIClientStats>&& clientStats,
+                                       const LocationApiPbMsgConv *pbMsgConv) :
+        LocAPIMsgHeader(name, E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID, pbMsgConv),
+        mClientStats(std::move(clientStats)) { }
+    LocAPIGetClientStatsRespMsg(const char* name,
+            const PBLocAPIGetClientStatsRespMsg &pbClientStatsResp,
+            const LocationApiPbMsgConv *pbMsgConv);
+
+    int serializeToProtobuf(string& protoStr) override;
+};
+
 /******************************************************************************
 IPC message structure - ping
 ******************************************************************************/
@@ -43,10 +43,416 @@
 using namespace loc_util;
 using std::min;
 
+// ********************
+// Mask conversion tables
+// ********************
+// a bit of a local mask and the protobuf bit it is sent as
+struct LocApiPbMaskBit {
+    uint64_t loc;
+    uint64_t pb;
+};
+
+// Converts a mask to protobuf and back after one table of bit pairs, so the
+// two directions cannot drift apart. Where each bit is sent as is, as for
+// most masks, a conversion comes down to a single and.
+class LocApiPbMaskMap {
+    const LocApiPbMaskBit* const mBits;
+    const size_t mCount;
+    const uint64_t mLocBits;
+    const uint64_t mPbBits;
+    const bool mIdentity;
+
+    static constexpr uint64_t locBitsOf(const LocApiPbMaskBit* bits, size_t count) {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < count; i++) {
+            mask |= bits[i].loc;
+        }
+        return mask;
+    }
+    static constexpr uint64_t pbBitsOf(const LocApiPbMaskBit* bits, size_t count) {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < count; i++) {
+            mask |= bits[i].pb;
+        }
+        return mask;
+    }
+    static constexpr bool isIdentity(const LocApiPbMaskBit* bits, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (bits[i].loc != bits[i].pb || 0 != (bits[i].loc & (bits[i].loc - 1))) {
+                return false;
+            }
+        }
+        return true;
+    }
+public:
+    template <size_t N>
+    constexpr LocApiPbMaskMap(const LocApiPbMaskBit (&bits)[N]) :
+            mBits(bits), mCount(N), mLocBits(locBitsOf(bits, N)), mPbBits(pbBitsOf(bits, N)),
+            mIdentity(isIdentity(bits, N)) {}
+
+    // no two local bits, nor two protobuf bits, overlap
+    constexpr bool isOneToOne() const {
+        for (size_t i = 0; i < mCount; i++) {
+            for (size_t j = i + 1; j < mCount; j++) {
+                if (0 != (mBits[i].loc & mBits[j].loc) || 0 != (mBits[i].pb & mBits[j].pb)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    inline uint64_t toPb(uint64_t locMask) const {
+        if (mIdentity) {
+            return locMask & mLocBits;
+        }
+        uint64_t pbMask = 0;
+        for (size_t i = 0; i < mCount; i++) {
+            if (locMask & mBits[i].loc) {
+                pbMask |= mBits[i].pb;
+            }
+        }
+        return pbMask;
+    }
+    inline uint64_t fromPb(uint64_t pbMask) const {
+        if (mIdentity) {
+            return pbMask & mPbBits;
+        }
+        uint64_t locMask = 0;
+        for (size_t i = 0; i < mCount; i++) {
+            if (pbMask & mBits[i].pb) {
+                locMask |= mBits[i].loc;
+            }
+        }
+        return locMask;
+    }
+};
+
+static constexpr LocApiPbMaskBit sLocationCallbacksMaskBits[] = {
+    {E_LOC_CB_DISTANCE_BASED_TRACKING_BIT, PB_E_LOC_CB_DISTANCE_BASED_TRACKING_BIT},
+    {E_LOC_CB_GNSS_LOCATION_INFO_BIT, PB_E_LOC_CB_GNSS_LOCATION_INFO_BIT},
+    {E_LOC_CB_GNSS_SV_BIT, PB_E_LOC_CB_GNSS_SV_BIT},
+    {E_LOC_CB_GNSS_NMEA_BIT, PB_E_LOC_CB_GNSS_NMEA_BIT},
+    {E_LOC_CB_GNSS_DATA_BIT, PB_E_LOC_CB_GNSS_DATA_BIT},
+    {E_LOC_CB_SYSTEM_INFO_BIT, PB_E_LOC_CB_SYSTEM_INFO_BIT},
+    {E_LOC_CB_BATCHING_BIT, PB_E_LOC_CB_BATCHING_BIT},
+    {E_LOC_CB_BATCHING_STATUS_BIT, PB_E_LOC_CB_BATCHING_STATUS_BIT},
+    {E_LOC_CB_GEOFENCE_BREACH_BIT, PB_E_LOC_CB_GEOFENCE_BREACH_BIT},
+    {E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT, PB_E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT},
+    {E_LOC_CB_SIMPLE_LOCATION_INFO_BIT, PB_E_LOC_CB_SIMPLE_LOCATION_INFO_BIT},
+    {E_LOC_CB_GNSS_MEAS_BIT, PB_E_LOC_CB_GNSS_MEAS_BIT},
+    {E_LOC_CB_GNSS_NMEA_BUNDLE_BIT, PB_E_LOC_CB_GNSS_NMEA_BUNDLE_BIT},
+};
+static constexpr LocApiPbMaskMap sLocationCallbacksMaskMap(sLocationCallbacksMaskBits);
+static_assert(sLocationCallbacksMaskMap.isOneToOne(), "location callbacks mask bits overlap");
+
+static constexpr LocApiPbMaskBit sLocationCapabilitiesMaskBits[] = {
+    {LOCATION_CAPABILITIES_TIME_BASED_TRACKING_BIT, PB_LOCATION_CAPS_TIME_BASED_TRACKING_BIT},
+    {LOCATION_CAPABILITIES_TIME_BASED_BATCHING_BIT, PB_LOCATION_CAPS_TIME_BASED_BATCHING_BIT},
+    {LOCATION_CAPABILITIES_DISTANCE_BASED_TRACKING_BIT,
+            PB_LOCATION_CAPS_DISTANCE_BASED_TRACKING_BIT},
+    {LOCATION_CAPABILITIES_DISTANCE_BASED_BATCHING_BIT,
+            PB_LOCATION_CAPS_DISTANCE_BASED_BATCHING_BIT},
+    {LOCATION_CAPABILITIES_GEOFENCE_BIT, PB_LOCATION_CAPS_GEOFENCE_BIT},
+    {LOCATION_CAPABILITIES_OUTDOOR_TRIP_BATCHING_BIT,
+            PB_LOCATION_CAPS_OUTDOOR_TRIP_BATCHING_BIT},
+    {LOCATION_CAPABILITIES_GNSS_MEASUREMENTS_BIT, PB_LOCATION_CAPS_GNSS_MEASUREMENTS_BIT},
+    {LOCATION_CAPABILITIES_CONSTELLATION_ENABLEMENT_BIT,
+            PB_LOCATION_CAPS_CONSTELLATION_ENABLEMENT_BIT},
+    {LOCATION_CAPABILITIES_QWES_CARRIER_PHASE_BIT, PB_LOCATION_CAPS_QWES_CARRIER_PHASE_BIT},
+    {LOCATION_CAPABILITIES_QWES_SV_POLYNOMIAL_BIT, PB_LOCATION_CAPS_QWES_SV_POLYNOMIAL_BIT},
+    {LOCATION_CAPABILITIES_QWES_GNSS_SINGLE_FREQUENCY,
+            PB_LOCATION_CAPS_QWES_GNSS_SINGLE_FREQUENCY},
+    {LOCATION_CAPABILITIES_QWES_GNSS_MULTI_FREQUENCY,
+            PB_LOCATION_CAPS_QWES_GNSS_MULTI_FREQUENCY},
+    {LOCATION_CAPABILITIES_QWES_VPE, PB_LOCATION_CAPS_QWES_VPE},
+    {LOCATION_CAPABILITIES_QWES_CV2X_LOCATION_BASIC, PB_LOCATION_CAPS_QWES_CV2X_LOCATION_BASIC},
+    {LOCATION_CAPABILITIES_QWES_CV2X_LOCATION_PREMIUM,
+            PB_LOCATION_CAPS_QWES_CV2X_LOCATION_PREMIUM},
+    {LOCATION_CAPABILITIES_QWES_PPE, PB_LOCATION_CAPS_QWES_PPE},
+    {LOCATION_CAPABILITIES_QWES_QDR2, PB_LOCATION_CAPS_QWES_QDR2},
+    {LOCATION_CAPABILITIES_QWES_QDR3, PB_LOCATION_CAPS_QWES_QDR3},
+};
+static constexpr LocApiPbMaskMap sLocationCapabilitiesMaskMap(sLocationCapabilitiesMaskBits);
+static_assert(sLocationCapabilitiesMaskMap.isOneToOne(), "location capabilities mask bits overlap");
+
+static constexpr LocApiPbMaskBit sPositioningEngineMaskBits[] = {
+    {STANDARD_POSITIONING_ENGINE, PB_STANDARD_POSITIONING_ENGINE},
+    {DEAD_RECKONING_ENGINE, PB_DEAD_RECKONING_ENGINE},
+    {PRECISE_POSITIONING_ENGINE, PB_PRECISE_POSITIONING_ENGINE},
+};
+static constexpr LocApiPbMaskMap sPositioningEngineMaskMap(sPositioningEngineMaskBits);
+static_assert(sPositioningEngineMaskMap.isOneToOne(), "positioning engine mask bits overlap");
+
+static constexpr LocApiPbMaskBit sLeverArmTypeMaskBits[] = {
+    {LEVER_ARM_TYPE_GNSS_TO_VRP_BIT, PB_LEVER_ARM_TYPE_GNSS_TO_VRP_BIT},
+    {LEVER_ARM_TYPE_DR_IMU_TO_GNSS_BIT, PB_LEVER_ARM_TYPE_DR_IMU_TO_GNSS_BIT},
+    {LEVER_ARM_TYPE_VEPP_IMU_TO_GNSS_BIT, PB_LEVER_ARM_TYPE_VEPP_IMU_TO_GNSS_BIT},
+};
+static constexpr LocApiPbMaskMap sLeverArmTypeMaskMap(sLeverArmTypeMaskBits);
+static_assert(sLeverArmTypeMaskMap.isOneToOne(), "lever arm type mask bits overlap");
+
+static constexpr LocApiPbMaskBit sLocReqEngineTypeMaskBits[] = {
+    {LOC_REQ_ENGINE_FUSED_BIT, PB_LOC_REQ_ENGINE_FUSED_BIT},
+    {LOC_REQ_ENGINE_SPE_BIT, PB_LOC_REQ_ENGINE_SPE_BIT},
+    {LOC_REQ_ENGINE_PPE_BIT, PB_LOC_REQ_ENGINE_PPE_BIT},
+};
+static constexpr LocApiPbMaskMap sLocReqEngineTypeMaskMap(sLocReqEngineTypeMaskBits);
+static_assert(sLocReqEngineTypeMaskMap.isOneToOne(), "loc req engine type mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssCfgRobustLocValidMaskBits[] = {
+    {GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT,
+            PB_GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT},
+    {GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT,
+            PB_GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT},
+    {GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT,
+            PB_GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssCfgRobustLocValidMaskMap(sGnssCfgRobustLocValidMaskBits);
+static_assert(sGnssCfgRobustLocValidMaskMap.isOneToOne(),
+        "gnss cfg robust loc valid mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssDataMaskBits[] = {
+    {GNSS_LOC_DATA_JAMMER_IND_BIT, PB_GNSS_LOC_DATA_JAMMER_IND_BIT},
+    {GNSS_LOC_DATA_AGC_BIT, PB_GNSS_LOC_DATA_AGC_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssDataMaskMap(sGnssDataMaskBits);
+static_assert(sGnssDataMaskMap.isOneToOne(), "gnss data mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssAidingDataSvMaskBits[] = {
+    {GNSS_AIDING_DATA_SV_EPHEMERIS_BIT, PB_AIDING_DATA_SV_EPHEMERIS_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssAidingDataSvMaskMap(sGnssAidingDataSvMaskBits);
+static_assert(sGnssAidingDataSvMaskMap.isOneToOne(), "gnss aiding data sv mask bits overlap");
+
+static constexpr LocApiPbMaskBit sLeapSecondSysInfoMaskBits[] = {
+    {LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT,
+            PB_LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT},
+    {LEAP_SECOND_SYS_INFO_LEAP_SECOND_CHANGE_BIT,
+            PB_LEAP_SECOND_SYS_INFO_LEAP_SECOND_CHANGE_BIT},
+};
+static constexpr LocApiPbMaskMap sLeapSecondSysInfoMaskMap(sLeapSecondSysInfoMaskBits);
+static_assert(sLeapSecondSysInfoMaskMap.isOneToOne(), "leap second sys info mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssSystemTimeStructTypeFlagsMaskBits[] = {
+    {GNSS_SYSTEM_TIME_WEEK_VALID, PB_GNSS_SYSTEM_TIME_WEEK_VALID},
+    {GNSS_SYSTEM_TIME_WEEK_MS_VALID, PB_GNSS_SYSTEM_TIME_WEEK_MS_VALID},
+    {GNSS_SYSTEM_CLK_TIME_BIAS_VALID, PB_GNSS_SYSTEM_CLK_TIME_BIAS_VALID},
+    {GNSS_SYSTEM_CLK_TIME_BIAS_UNC_VALID, PB_GNSS_SYSTEM_CLK_TIME_BIAS_UNC_VALID},
+    {GNSS_SYSTEM_REF_FCOUNT_VALID, PB_GNSS_SYSTEM_REF_FCOUNT_VALID},
+    {GNSS_SYSTEM_NUM_CLOCK_RESETS_VALID, PB_GNSS_SYSTEM_NUM_CLOCK_RESETS_VALID},
+};
+static constexpr LocApiPbMaskMap sGnssSystemTimeStructTypeFlagsMaskMap(
+        sGnssSystemTimeStructTypeFlagsMaskBits);
+static_assert(sGnssSystemTimeStructTypeFlagsMaskMap.isOneToOne(),
+        "gnss system time struct type flags mask bits overlap");
+
+static constexpr LocApiPbMaskBit sLocationFlagsMaskBits[] = {
+    {LOCATION_HAS_LAT_LONG_BIT, PB_LOCATION_HAS_LAT_LONG_BIT},
+    {LOCATION_HAS_ALTITUDE_BIT, PB_LOCATION_HAS_ALTITUDE_BIT},
+    {LOCATION_HAS_SPEED_BIT, PB_LOCATION_HAS_SPEED_BIT},
+    {LOCATION_HAS_BEARING_BIT, PB_LOCATION_HAS_BEARING_BIT},
+    {LOCATION_HAS_ACCURACY_BIT, PB_LOCATION_HAS_ACCURACY_BIT},
+    {LOCATION_HAS_VERTICAL_ACCURACY_BIT, PB_LOCATION_HAS_VERTICAL_ACCURACY_BIT},
+    {LOCATION_HAS_SPEED_ACCURACY_BIT, PB_LOCATION_HAS_SPEED_ACCURACY_BIT},
+    {LOCATION_HAS_BEARING_ACCURACY_BIT, PB_LOCATION_HAS_BEARING_ACCURACY_BIT},
+};
+static constexpr LocApiPbMaskMap sLocationFlagsMaskMap(sLocationFlagsMaskBits);
+static_assert(sLocationFlagsMaskMap.isOneToOne(), "location flags mask bits overlap");
+
+static constexpr LocApiPbMaskBit sLocationTechnologyMaskBits[] = {
+    {LOCATION_TECHNOLOGY_GNSS_BIT, PB_LOCATION_TECHNOLOGY_GNSS_BIT},
+    {LOCATION_TECHNOLOGY_CELL_BIT, PB_LOCATION_TECHNOLOGY_CELL_BIT},
+    {LOCATION_TECHNOLOGY_WIFI_BIT, PB_LOCATION_TECHNOLOGY_WIFI_BIT},
+    {LOCATION_TECHNOLOGY_SENSORS_BIT, PB_LOCATION_TECHNOLOGY_SENSORS_BIT},
+    {LOCATION_TECHNOLOGY_REFERENCE_LOCATION_BIT, PB_LOCATION_TECHNOLOGY_REFERENCE_LOCATION_BIT},
+    {LOCATION_TECHNOLOGY_INJECTED_COARSE_POSITION_BIT,
+            PB_LOCATION_TECHNOLOGY_INJECTED_COARSE_POSITION_BIT},
+    {LOCATION_TECHNOLOGY_AFLT_BIT, PB_LOCATION_TECHNOLOGY_AFLT_BIT},
+    {LOCATION_TECHNOLOGY_HYBRID_BIT, PB_LOCATION_TECHNOLOGY_HYBRID_BIT},
+    {LOCATION_TECHNOLOGY_PPE_BIT, PB_LOCATION_TECHNOLOGY_PPE_BIT},
+    {LOCATION_TECHNOLOGY_VEH_BIT, PB_LOCATION_TECHNOLOGY_VEH_BIT},
+    {LOCATION_TECHNOLOGY_VIS_BIT, PB_LOCATION_TECHNOLOGY_VIS_BIT},
+};
+static constexpr LocApiPbMaskMap sLocationTechnologyMaskMap(sLocationTechnologyMaskBits);
+static_assert(sLocationTechnologyMaskMap.isOneToOne(), "location technology mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssLocationNavSolutionMaskBits[] = {
+    {LOCATION_SBAS_CORRECTION_IONO_BIT, PB_LOCATION_SBAS_CORRECTION_IONO_BIT},
+    {LOCATION_SBAS_CORRECTION_FAST_BIT, PB_LOCATION_SBAS_CORRECTION_FAST_BIT},
+    {LOCATION_SBAS_CORRECTION_LONG_BIT, PB_LOCATION_SBAS_CORRECTION_LONG_BIT},
+    {LOCATION_SBAS_INTEGRITY_BIT, PB_LOCATION_SBAS_INTEGRITY_BIT},
+    {LOCATION_NAV_CORRECTION_DGNSS_BIT, PB_LOCATION_NAV_CORRECTION_DGNSS_BIT},
+    {LOCATION_NAV_CORRECTION_RTK_BIT, PB_LOCATION_NAV_CORRECTION_RTK_BIT},
+    {LOCATION_NAV_CORRECTION_PPP_BIT, PB_LOCATION_NAV_CORRECTION_PPP_BIT},
+    {LOCATION_NAV_CORRECTION_RTK_FIXED_BIT, PB_LOCATION_NAV_CORRECTION_RTK_FIXED_BIT},
+    {LOCATION_NAV_CORRECTION_ONLY_SBAS_CORRECTED_SV_USED_BIT,
+            PB_LOCATION_NAV_CORRECTION_ONLY_SBAS_CORRECTED_SV_USED_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssLocationNavSolutionMaskMap(sGnssLocationNavSolutionMaskBits);
+static_assert(sGnssLocationNavSolutionMaskMap.isOneToOne(),
+        "gnss location nav solution mask bits overlap");
+
+static constexpr LocApiPbMaskBit sDrCalibrationStatusMaskBits[] = {
+    {DR_ROLL_CALIBRATION_NEEDED, PB_DR_ROLL_CALIBRATION_NEEDED},
+    {DR_PITCH_CALIBRATION_NEEDED, PB_DR_PITCH_CALIBRATION_NEEDED},
+    {DR_YAW_CALIBRATION_NEEDED, PB_DR_YAW_CALIBRATION_NEEDED},
+    {DR_ODO_CALIBRATION_NEEDED, PB_DR_ODO_CALIBRATION_NEEDED},
+    {DR_GYRO_CALIBRATION_NEEDED, PB_DR_GYRO_CALIBRATION_NEEDED},
+};
+static constexpr LocApiPbMaskMap sDrCalibrationStatusMaskMap(sDrCalibrationStatusMaskBits);
+static_assert(sDrCalibrationStatusMaskMap.isOneToOne(), "dr calibration status mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssMeasurementsDataFlagsMaskBits[] = {
+    {GNSS_MEASUREMENTS_DATA_SV_ID_BIT, PB_GNSS_MEASUREMENTS_DATA_SV_ID_BIT},
+    {GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT, PB_GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT},
+    {GNSS_MEASUREMENTS_DATA_STATE_BIT, PB_GNSS_MEASUREMENTS_DATA_STATE_BIT},
+    {GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT},
+    {GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT},
+    {GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT},
+    {GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT, PB_GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT},
+    {GNSS_MEASUREMENTS_DATA_ADR_BIT, PB_GNSS_MEASUREMENTS_DATA_ADR_BIT},
+    {GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT, PB_GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT},
+    {GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT, PB_GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT},
+    {GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT, PB_GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT},
+    {GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT},
+    {GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT},
+    {GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT},
+    {GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT, PB_GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT},
+    {GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT,
+            PB_GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssMeasurementsDataFlagsMaskMap(
+        sGnssMeasurementsDataFlagsMaskBits);
+static_assert(sGnssMeasurementsDataFlagsMaskMap.isOneToOne(),
+        "gnss measurements data flags mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssMeasurementsClockFlagsMaskBits[] = {
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT,
+            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_BIT, PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT,
+            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT, PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT, PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT,
+            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT},
+    {GNSS_MEASUREMENTS_CLOCK_FLAGS_HW_CLOCK_DISCONTINUITY_COUNT_BIT,
+            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_HW_CLOCK_DISCONTINUITY_COUNT_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssMeasurementsClockFlagsMaskMap(
+        sGnssMeasurementsClockFlagsMaskBits);
+static_assert(sGnssMeasurementsClockFlagsMaskMap.isOneToOne(),
+        "gnss measurements clock flags mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssGloTimeStructTypeFlagsMaskBits[] = {
+    {GNSS_CLO_DAYS_VALID, PB_GNSS_CLO_DAYS_VALID},
+    {GNSS_GLO_MSEC_VALID, PB_GNSS_GLO_MSEC_VALID},
+    {GNSS_GLO_CLK_TIME_BIAS_VALID, PB_GNSS_GLO_CLK_TIME_BIAS_VALID},
+    {GNSS_GLO_CLK_TIME_BIAS_UNC_VALID, PB_GNSS_GLO_CLK_TIME_BIAS_UNC_VALID},
+    {GNSS_GLO_REF_FCOUNT_VALID, PB_GNSS_GLO_REF_FCOUNT_VALID},
+    {GNSS_GLO_NUM_CLOCK_RESETS_VALID, PB_GNSS_GLO_NUM_CLOCK_RESETS_VALID},
+    {GNSS_GLO_FOUR_YEAR_VALID, PB_GNSS_GLO_FOUR_YEAR_VALID},
+};
+static constexpr LocApiPbMaskMap sGnssGloTimeStructTypeFlagsMaskMap(
+        sGnssGloTimeStructTypeFlagsMaskBits);
+static_assert(sGnssGloTimeStructTypeFlagsMaskMap.isOneToOne(),
+        "gnss glo time struct type flags mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssSvOptionsMaskBits[] = {
+    {GNSS_SV_OPTIONS_HAS_EPHEMER_BIT, PB_GNSS_SV_OPTIONS_HAS_EPHEMER_BIT},
+    {GNSS_SV_OPTIONS_HAS_ALMANAC_BIT, PB_GNSS_SV_OPTIONS_HAS_ALMANAC_BIT},
+    {GNSS_SV_OPTIONS_USED_IN_FIX_BIT, PB_GNSS_SV_OPTIONS_USED_IN_FIX_BIT},
+    {GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT, PB_GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT},
+    {GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT, PB_GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssSvOptionsMaskMap(sGnssSvOptionsMaskBits);
+static_assert(sGnssSvOptionsMaskMap.isOneToOne(), "gnss sv options mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGnssSignalTypeMaskBits[] = {
+    {GNSS_SIGNAL_GPS_L1CA, PB_GNSS_SIGNAL_GPS_L1CA_BIT},
+    {GNSS_SIGNAL_GPS_L1C, PB_GNSS_SIGNAL_GPS_L1C_BIT},
+    {GNSS_SIGNAL_GPS_L2, PB_GNSS_SIGNAL_GPS_L2_BIT},
+    {GNSS_SIGNAL_GPS_L5, PB_GNSS_SIGNAL_GPS_L5_BIT},
+    {GNSS_SIGNAL_GLONASS_G1, PB_GNSS_SIGNAL_GLONASS_G1_BIT},
+    {GNSS_SIGNAL_GLONASS_G2, PB_GNSS_SIGNAL_GLONASS_G2_BIT},
+    {GNSS_SIGNAL_GALILEO_E1, PB_GNSS_SIGNAL_GALILEO_E1_BIT},
+    {GNSS_SIGNAL_GALILEO_E5A, PB_GNSS_SIGNAL_GALILEO_E5A_BIT},
+    {GNSS_SIGNAL_GALILEO_E5B, PB_GNSS_SIGNAL_GALILEO_E5B_BIT},
+    {GNSS_SIGNAL_BEIDOU_B1, PB_GNSS_SIGNAL_BEIDOU_B1_BIT},
+    {GNSS_SIGNAL_BEIDOU_B2, PB_GNSS_SIGNAL_BEIDOU_B2_BIT},
+    {GNSS_SIGNAL_QZSS_L1CA, PB_GNSS_SIGNAL_QZSS_L1CA_BIT},
+    {GNSS_SIGNAL_QZSS_L1S, PB_GNSS_SIGNAL_QZSS_L1S_BIT},
+    {GNSS_SIGNAL_QZSS_L2, PB_GNSS_SIGNAL_QZSS_L2_BIT},
+    {GNSS_SIGNAL_QZSS_L5, PB_GNSS_SIGNAL_QZSS_L5_BIT},
+    {GNSS_SIGNAL_SBAS_L1, PB_GNSS_SIGNAL_SBAS_L1_BIT},
+    {GNSS_SIGNAL_BEIDOU_B1I, PB_GNSS_SIGNAL_BEIDOU_B1I_BIT},
+    {GNSS_SIGNAL_BEIDOU_B1C, PB_GNSS_SIGNAL_BEIDOU_B1C_BIT},
+    {GNSS_SIGNAL_BEIDOU_B2I, PB_GNSS_SIGNAL_BEIDOU_B2I_BIT},
+    {GNSS_SIGNAL_BEIDOU_B2AI, PB_GNSS_SIGNAL_BEIDOU_B2AI_BIT},
+    {GNSS_SIGNAL_NAVIC_L5, PB_GNSS_SIGNAL_NAVIC_L5_BIT},
+    {GNSS_SIGNAL_BEIDOU_B2AQ, PB_GNSS_SIGNAL_BEIDOU_B2AQ_BIT},
+};
+static constexpr LocApiPbMaskMap sGnssSignalTypeMaskMap(sGnssSignalTypeMaskBits);
+static_assert(sGnssSignalTypeMaskMap.isOneToOne(), "gnss signal type mask bits overlap");
+
+static constexpr LocApiPbMaskBit sGeofenceBreachTypeMaskBits[] = {
+    {GEOFENCE_BREACH_ENTER_BIT, PB_GEOFENCE_BREACH_ENTER_BIT},
+    {GEOFENCE_BREACH_EXIT_BIT, PB_GEOFENCE_BREACH_EXIT_BIT},
+    {GEOFENCE_BREACH_DWELL_IN_BIT, PB_GEOFENCE_BREACH_DWELL_IN_BIT},
+    {GEOFENCE_BREACH_DWELL_OUT_BIT, PB_GEOFENCE_BREACH_DWELL_OUT_BIT},
+};
+static constexpr LocApiPbMaskMap sGeofenceBreachTypeMaskMap(sGeofenceBreachTypeMaskBits);
+static_assert(sGeofenceBreachTypeMaskMap.isOneToOne(), "geofence breach type mask bits overlap");
+
+static constexpr LocApiPbMaskBit sDeadReckoningEngineConfigValidMaskBits[] = {
+    {BODY_TO_SENSOR_MOUNT_PARAMS_BIT, PB_BODY_TO_SENSOR_MOUNT_PARAMS_BIT},
+    {VEHICLE_SPEED_SCALE_FACTOR_BIT, PB_VEHICLE_SPEED_SCALE_FACTOR_BIT},
+    {VEHICLE_SPEED_SCALE_FACTOR_UNC_BIT, PB_VEHICLE_SPEED_SCALE_FACTOR_UNC_BIT},
+    {GYRO_SCALE_FACTOR_BIT, PB_GYRO_SCALE_FACTOR_BIT},
+    {GYRO_SCALE_FACTOR_UNC_BIT, PB_GYRO_SCALE_FACTOR_UNC_BIT},
+};
+static constexpr LocApiPbMaskMap sDeadReckoningEngineConfigValidMaskMap(
+        sDeadReckoningEngineConfigValidMaskBits);
+static_assert(sDeadReckoningEngineConfigValidMaskMap.isOneToOne(),
+        "dead reckoning engine config valid mask bits overlap");
+
+static constexpr LocApiPbMaskBit sDrEngineAidingDataMaskBits[] = {
+    {DR_ENGINE_AIDING_DATA_CALIBRATION_BIT, PB_DR_ENGINE_AIDING_DATA_CALIBRATION_BIT},
+};
+static constexpr LocApiPbMaskMap sDrEngineAidingDataMaskMap(sDrEngineAidingDataMaskBits);
+static_assert(sDrEngineAidingDataMaskMap.isOneToOne(), "dr engine aiding data mask bits overlap");
+
+static constexpr LocApiPbMaskBit sDrSolutionStatusMaskBits[] = {
+    {VEHICLE_SENSOR_SPEED_INPUT_DETECTED, PB_VEHICLE_SENSOR_SPEED_INPUT_DETECTED},
+    {VEHICLE_SENSOR_SPEED_INPUT_USED, PB_VEHICLE_SENSOR_SPEED_INPUT_USED},
+};
+static constexpr LocApiPbMaskMap sDrSolutionStatusMaskMap(sDrSolutionStatusMaskBits);
+static_assert(sDrSolutionStatusMaskMap.isOneToOne(), "dr solution status mask bits overlap");
+
 // ********************
 // LocationApiPbMsgConv
 // ********************
-LocationApiPbMsgConv::LocationApiPbMsgConv() {
+LocationApiPbMsgConv::LocationApiPbMsgConv() : mClientToken(0) {
     mPbDebugLogEnabled = false;
     mPbVerboseLogEnabled = false;
     // Logtag mechanism for Protobuf conv util log
@@ -171,6 +577,12 @@ ELocMsgID LocationApiPbMsgConv::getEnumForPBELocMsgID(const PBELocMsgID &pbLocMs
         case PB_E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID:
             eLocMsgId = E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID;
             break;
+        case PB_E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID:
+            eLocMsgId = E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID;
+            break;
+        case PB_E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID:
+            eLocMsgId = E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID;
+            break;
         case PB_E_LOCAPI_PINGTEST_MSG_ID:
             eLocMsgId = E_LOCAPI_PINGTEST_MSG_ID;
             break;
@@ -210,6 +622,9 @@ ELocMsgID LocationApiPbMsgConv::getEnumForPBELocMsgID(const PBELocMsgID &pbLocMs
         case PB_E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID:
             eLocMsgId = E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID;
             break;
+        case PB_E_INTAPI_CONFIG_BATCH_MSG_ID:
+            eLocMsgId = E_INTAPI_CONFIG_BATCH_MSG_ID;
+            break;
         case PB_E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID:
             eLocMsgId = E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID;
             break;
@@ -616,6 +1031,12 @@ PBELocMsgID LocationApiPbMsgConv::getPBEnumForELocMsgID(const ELocMsgID &eLocMsg
         case E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID:
             pbLocMsgId = PB_E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID;
             break;
+        case E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID:
+            pbLocMsgId = PB_E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID;
+            break;
+        case E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID:
+            pbLocMsgId = PB_E_LOCAPI_GET_CLIENT_STATS_RESP_MSG_ID;
+            break;
         case E_LOCAPI_PINGTEST_MSG_ID:
             pbLocMsgId = PB_E_LOCAPI_PINGTEST_MSG_ID;
             break;
@@ -655,6 +1076,9 @@ PBELocMsgID LocationApiPbMsgConv::getPBEnumForELocMsgID(const ELocMsgID &eLocMsg
         case E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID:
             pbLocMsgId = PB_E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID;
             break;
+        case E_INTAPI_CONFIG_BATCH_MSG_ID:
+            pbLocMsgId = PB_E_INTAPI_CONFIG_BATCH_MSG_ID;
+            break;
         case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID:
             pbLocMsgId = PB_E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID;
             break;
@@ -919,104 +1343,14 @@ PBLocApiGnss_LocSvSystemEnumType LocationApiPbMsgConv::getPBGnssLocSvSysEnumFrom
 
 // **** helper function for mask conversion to protobuf masks
 uint32_t LocationApiPbMsgConv::getPBMaskForLocationCallbacksMask(const uint32_t &locCbMask) const {
-    uint32_t pbLocCbMask = 0;
-    if (locCbMask & E_LOC_CB_DISTANCE_BASED_TRACKING_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_DISTANCE_BASED_TRACKING_BIT;
-    }
-    if (locCbMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_GNSS_LOCATION_INFO_BIT;
-    }
-    if (locCbMask & E_LOC_CB_GNSS_SV_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_GNSS_SV_BIT;
-    }
-    if (locCbMask & E_LOC_CB_GNSS_NMEA_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_GNSS_NMEA_BIT;
-    }
-    if (locCbMask & E_LOC_CB_GNSS_DATA_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_GNSS_DATA_BIT;
-    }
-    if (locCbMask & E_LOC_CB_SYSTEM_INFO_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_SYSTEM_INFO_BIT;
-    }
-    if (locCbMask & E_LOC_CB_BATCHING_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_BATCHING_BIT;
-    }
-    if (locCbMask & E_LOC_CB_BATCHING_STATUS_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_BATCHING_STATUS_BIT;
-    }
-    if (locCbMask & E_LOC_CB_GEOFENCE_BREACH_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_GEOFENCE_BREACH_BIT;
-    }
-    if (locCbMask & E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT;
-    }
-    if (locCbMask & E_LOC_CB_SIMPLE_LOCATION_INFO_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_SIMPLE_LOCATION_INFO_BIT;
-    }
-    if (locCbMask & E_LOC_CB_GNSS_MEAS_BIT) {
-        pbLocCbMask |= PB_E_LOC_CB_GNSS_MEAS_BIT;
-    }
+    uint32_t pbLocCbMask = sLocationCallbacksMaskMap.toPb(locCbMask);
     LocApiPb_LOGv("LocApiPB: locCbMask:%x, pbLocCbMask:%x", locCbMask, pbLocCbMask);
     return pbLocCbMask;
 }
 
 uint64_t LocationApiPbMsgConv::getPBMaskForLocationCapabilitiesMask(
         const uint64_t &locCapabMask) const {
-    uint64_t pbLocCapabMask = 0;
-    if (locCapabMask & LOCATION_CAPABILITIES_TIME_BASED_TRACKING_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_TIME_BASED_TRACKING_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_TIME_BASED_BATCHING_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_TIME_BASED_BATCHING_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_DISTANCE_BASED_TRACKING_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_DISTANCE_BASED_TRACKING_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_DISTANCE_BASED_BATCHING_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_DISTANCE_BASED_BATCHING_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_GEOFENCE_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_GEOFENCE_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_OUTDOOR_TRIP_BATCHING_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_OUTDOOR_TRIP_BATCHING_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_GNSS_MEASUREMENTS_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_GNSS_MEASUREMENTS_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_CONSTELLATION_ENABLEMENT_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_CONSTELLATION_ENABLEMENT_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_CARRIER_PHASE_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_CARRIER_PHASE_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_SV_POLYNOMIAL_BIT) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_SV_POLYNOMIAL_BIT;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_GNSS_SINGLE_FREQUENCY) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_GNSS_SINGLE_FREQUENCY;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_GNSS_MULTI_FREQUENCY) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_GNSS_MULTI_FREQUENCY;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_VPE) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_VPE;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_CV2X_LOCATION_BASIC) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_CV2X_LOCATION_BASIC;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_CV2X_LOCATION_PREMIUM) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_CV2X_LOCATION_PREMIUM;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_PPE) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_PPE;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_QDR2) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_QDR2;
-    }
-    if (locCapabMask & LOCATION_CAPABILITIES_QWES_QDR3) {
-        pbLocCapabMask |= PB_LOCATION_CAPS_QWES_QDR3;
-    }
+    uint64_t pbLocCapabMask = sLocationCapabilitiesMaskMap.toPb(locCapabMask);
     LOC_LOGi("LocApiPB: locCapabMask:0x%" PRIx64", pbLocCapabMask:0x%" PRIx64,
             locCapabMask, pbLocCapabMask);
     return pbLocCapabMask;
@@ -1024,32 +1358,14 @@ uint64_t LocationApiPbMsgConv::getPBMaskForLocationCapabilitiesMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForPositioningEngineMask(
         const uint32_t &posEngMask) const {
-    uint32_t pbPosEngMask = 0;
-    if (posEngMask & STANDARD_POSITIONING_ENGINE) {
-        pbPosEngMask |= PB_STANDARD_POSITIONING_ENGINE;
-    }
-    if (posEngMask & DEAD_RECKONING_ENGINE) {
-        pbPosEngMask |= PB_DEAD_RECKONING_ENGINE;
-    }
-    if (posEngMask & PRECISE_POSITIONING_ENGINE) {
-        pbPosEngMask |= PB_PRECISE_POSITIONING_ENGINE;
-    }
+    uint32_t pbPosEngMask = sPositioningEngineMaskMap.toPb(posEngMask);
     LocApiPb_LOGv("LocApiPB: posEngMask:%x, pbPosEngMask:%x", posEngMask, pbPosEngMask);
     return pbPosEngMask;
 }
 
 uint32_t LocationApiPbMsgConv::getPBMaskForLeverArmTypeMask(
         const uint32_t &leverArmTypeMask) const {
-    uint32_t pbLeverArmTypeMask = 0;
-    if (leverArmTypeMask & LEVER_ARM_TYPE_GNSS_TO_VRP_BIT) {
-        pbLeverArmTypeMask |= PB_LEVER_ARM_TYPE_GNSS_TO_VRP_BIT;
-    }
-    if (leverArmTypeMask & LEVER_ARM_TYPE_DR_IMU_TO_GNSS_BIT) {
-        pbLeverArmTypeMask |= PB_LEVER_ARM_TYPE_DR_IMU_TO_GNSS_BIT;
-    }
-    if (leverArmTypeMask & LEVER_ARM_TYPE_VEPP_IMU_TO_GNSS_BIT) {
-        pbLeverArmTypeMask |= PB_LEVER_ARM_TYPE_VEPP_IMU_TO_GNSS_BIT;
-    }
+    uint32_t pbLeverArmTypeMask = sLeverArmTypeMaskMap.toPb(leverArmTypeMask);
     LocApiPb_LOGv("LocApiPB: leverArmTypeMask:%x, pbLeverArmTypeMask:%x",
             leverArmTypeMask, pbLeverArmTypeMask);
     return pbLeverArmTypeMask;
@@ -1057,16 +1373,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForLeverArmTypeMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForLocReqEngineTypeMask(
         const uint32_t &locReqEngTypeMask) const {
-    uint32_t pbLocReqEngTypeMask = 0;
-    if (locReqEngTypeMask & LOC_REQ_ENGINE_FUSED_BIT) {
-        pbLocReqEngTypeMask |= PB_LOC_REQ_ENGINE_FUSED_BIT;
-    }
-    if (locReqEngTypeMask & LOC_REQ_ENGINE_SPE_BIT) {
-        pbLocReqEngTypeMask |= PB_LOC_REQ_ENGINE_SPE_BIT;
-    }
-    if (locReqEngTypeMask & LOC_REQ_ENGINE_PPE_BIT) {
-        pbLocReqEngTypeMask |= PB_LOC_REQ_ENGINE_PPE_BIT;
-    }
+    uint32_t pbLocReqEngTypeMask = sLocReqEngineTypeMaskMap.toPb(locReqEngTypeMask);
     LocApiPb_LOGv("LocApiPB: locReqEngTypeMask:%x, pbLocReqEngTypeMask:%x",
             locReqEngTypeMask, pbLocReqEngTypeMask);
     return pbLocReqEngTypeMask;
@@ -1074,16 +1381,8 @@ uint32_t LocationApiPbMsgConv::getPBMaskForLocReqEngineTypeMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssCfgRobustLocValidMask(
         const uint32_t &gnssCfgRobustLocValidMask) const {
-    uint32_t pbGnssCfgRobustLocValidMask = 0;
-    if (gnssCfgRobustLocValidMask & GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT) {
-        pbGnssCfgRobustLocValidMask |= PB_GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT;
-    }
-    if (gnssCfgRobustLocValidMask & GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT) {
-        pbGnssCfgRobustLocValidMask |= PB_GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT;
-    }
-    if (gnssCfgRobustLocValidMask & GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT) {
-        pbGnssCfgRobustLocValidMask |= PB_GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT;
-    }
+    uint32_t pbGnssCfgRobustLocValidMask =
+            sGnssCfgRobustLocValidMaskMap.toPb(gnssCfgRobustLocValidMask);
     LocApiPb_LOGv("LocApiPB: gnssCfgRobustLocValidMask:%x, pbGnssCfgRobustLocValidMask:%x",
             gnssCfgRobustLocValidMask, pbGnssCfgRobustLocValidMask);
     return pbGnssCfgRobustLocValidMask;
@@ -1100,13 +1399,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForLocSysInfoMask(const uint32_t &locSys
 }
 
 uint64_t LocationApiPbMsgConv::getPBMaskForGnssDataMask(const uint64_t &gnssDataMask) const {
-    uint64_t pbGnssDataMask = 0;
-    if (gnssDataMask & GNSS_LOC_DATA_JAMMER_IND_BIT) {
-        pbGnssDataMask |= PB_GNSS_LOC_DATA_JAMMER_IND_BIT;
-    }
-    if (gnssDataMask & GNSS_LOC_DATA_AGC_BIT) {
-        pbGnssDataMask |= PB_GNSS_LOC_DATA_AGC_BIT;
-    }
+    uint64_t pbGnssDataMask = sGnssDataMaskMap.toPb(gnssDataMask);
     LocApiPb_LOGv("LocApiPB: locSysInfoMask:%" PRIu64", pbGnssDataMask:%" PRIu64,
             gnssDataMask, pbGnssDataMask);
     return pbGnssDataMask;
@@ -1114,10 +1407,7 @@ uint64_t LocationApiPbMsgConv::getPBMaskForGnssDataMask(const uint64_t &gnssData
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssAidingDataSvMask(
         const uint32_t &gnssAidDataSvMask) const {
-    uint32_t pbGnssAidDataSvMask = 0;
-    if (gnssAidDataSvMask & GNSS_AIDING_DATA_SV_EPHEMERIS_BIT) {
-        pbGnssAidDataSvMask |= PB_AIDING_DATA_SV_EPHEMERIS_BIT;
-    }
+    uint32_t pbGnssAidDataSvMask = sGnssAidingDataSvMaskMap.toPb(gnssAidDataSvMask);
     LocApiPb_LOGv("LocApiPB: gnssAidDataSvMask:%x, pbGnssAidDataSvMask:%x",
             gnssAidDataSvMask, pbGnssAidDataSvMask);
     return pbGnssAidDataSvMask;
@@ -1125,14 +1415,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssAidingDataSvMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForLeapSecondSysInfoMask(
         const uint32_t &leapSecSysInfoMask) const {
-    uint32_t pbLeapSecSysInfoMask = 0;
-    if (leapSecSysInfoMask & LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT) {
-        pbLeapSecSysInfoMask |= PB_LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT;
-    }
-    if (leapSecSysInfoMask & LEAP_SECOND_SYS_INFO_LEAP_SECOND_CHANGE_BIT) {
-        pbLeapSecSysInfoMask |= PB_LEAP_SECOND_SYS_INFO_LEAP_SECOND_CHANGE_BIT;
-    }
-
+    uint32_t pbLeapSecSysInfoMask = sLeapSecondSysInfoMaskMap.toPb(leapSecSysInfoMask);
     LocApiPb_LOGv("LocApiPB: leapSecSysInfoMask:%x, pbLeapSecSysInfoMask:%x",
             leapSecSysInfoMask, pbLeapSecSysInfoMask);
     return pbLeapSecSysInfoMask;
@@ -1140,96 +1423,22 @@ uint32_t LocationApiPbMsgConv::getPBMaskForLeapSecondSysInfoMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssSystemTimeStructTypeFlags(
         const uint32_t &gnssSysTimeStructTypeFlg) const {
-    uint32_t pbGnssSysTimeStructTypeFlg = 0;
-    if (gnssSysTimeStructTypeFlg & GNSS_SYSTEM_TIME_WEEK_VALID) {
-        pbGnssSysTimeStructTypeFlg |= PB_GNSS_SYSTEM_TIME_WEEK_VALID;
-    }
-    if (gnssSysTimeStructTypeFlg & GNSS_SYSTEM_TIME_WEEK_MS_VALID) {
-        pbGnssSysTimeStructTypeFlg |= PB_GNSS_SYSTEM_TIME_WEEK_MS_VALID;
-    }
-    if (gnssSysTimeStructTypeFlg & GNSS_SYSTEM_CLK_TIME_BIAS_VALID) {
-        pbGnssSysTimeStructTypeFlg |= PB_GNSS_SYSTEM_CLK_TIME_BIAS_VALID;
-    }
-    if (gnssSysTimeStructTypeFlg & GNSS_SYSTEM_CLK_TIME_BIAS_UNC_VALID) {
-        pbGnssSysTimeStructTypeFlg |= PB_GNSS_SYSTEM_CLK_TIME_BIAS_UNC_VALID;
-    }
-    if (gnssSysTimeStructTypeFlg & GNSS_SYSTEM_REF_FCOUNT_VALID) {
-        pbGnssSysTimeStructTypeFlg |= PB_GNSS_SYSTEM_REF_FCOUNT_VALID;
-    }
-    if (gnssSysTimeStructTypeFlg & GNSS_SYSTEM_NUM_CLOCK_RESETS_VALID) {
-        pbGnssSysTimeStructTypeFlg |= PB_GNSS_SYSTEM_NUM_CLOCK_RESETS_VALID;
-    }
+    uint32_t pbGnssSysTimeStructTypeFlg =
+            sGnssSystemTimeStructTypeFlagsMaskMap.toPb(gnssSysTimeStructTypeFlg);
     LocApiPb_LOGv("LocApiPB: gnssSysTimeStructTypeFlg:%x, pbGnssSysTimeStructTypeFlg:%x",
             gnssSysTimeStructTypeFlg, pbGnssSysTimeStructTypeFlg);
     return pbGnssSysTimeStructTypeFlg;
 }
 
 uint32_t LocationApiPbMsgConv::getPBMaskForLocationFlagsMask(const uint32_t &locFlagsMask) const {
-    uint32_t pbLocFlagsMask = 0;
-    if (locFlagsMask & LOCATION_HAS_LAT_LONG_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_LAT_LONG_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_ALTITUDE_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_ALTITUDE_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_SPEED_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_SPEED_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_BEARING_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_BEARING_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_ACCURACY_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_ACCURACY_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_VERTICAL_ACCURACY_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_VERTICAL_ACCURACY_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_SPEED_ACCURACY_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_SPEED_ACCURACY_BIT;
-    }
-    if (locFlagsMask & LOCATION_HAS_BEARING_ACCURACY_BIT) {
-        pbLocFlagsMask |= PB_LOCATION_HAS_BEARING_ACCURACY_BIT;
-    }
+    uint32_t pbLocFlagsMask = sLocationFlagsMaskMap.toPb(locFlagsMask);
     LocApiPb_LOGv("LocApiPB: locFlagsMask:%x, pbLocFlagsMask:%x", locFlagsMask, pbLocFlagsMask);
     return pbLocFlagsMask;
 }
 
 uint32_t LocationApiPbMsgConv::getPBMaskForLocationTechnologyMask(
         const uint32_t &locTechMask) const {
-    uint32_t pbLocTechMask = 0;
-    if (locTechMask & LOCATION_TECHNOLOGY_GNSS_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_GNSS_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_CELL_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_CELL_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_WIFI_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_WIFI_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_SENSORS_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_SENSORS_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_REFERENCE_LOCATION_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_REFERENCE_LOCATION_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_INJECTED_COARSE_POSITION_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_INJECTED_COARSE_POSITION_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_AFLT_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_AFLT_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_HYBRID_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_HYBRID_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_PPE_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_PPE_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_VEH_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_VEH_BIT;
-    }
-    if (locTechMask & LOCATION_TECHNOLOGY_VIS_BIT) {
-        pbLocTechMask |= PB_LOCATION_TECHNOLOGY_VIS_BIT;
-    }
+    uint32_t pbLocTechMask = sLocationTechnologyMaskMap.toPb(locTechMask);
     LocApiPb_LOGv("LocApiPB: locTechMask:%x, pbLocTechMask:%x", locTechMask, pbLocTechMask);
     return pbLocTechMask;
 }
@@ -1353,34 +1562,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssLocationInfoExtFlagMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssLocationNavSolutionMask(
         const uint32_t &gnssLocNavSolnMask) const {
-    uint32_t pbGnssLocNavSolnMask = 0;
-    if (gnssLocNavSolnMask & LOCATION_SBAS_CORRECTION_IONO_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_SBAS_CORRECTION_IONO_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_SBAS_CORRECTION_FAST_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_SBAS_CORRECTION_FAST_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_SBAS_CORRECTION_LONG_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_SBAS_CORRECTION_LONG_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_SBAS_INTEGRITY_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_SBAS_INTEGRITY_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_NAV_CORRECTION_DGNSS_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_NAV_CORRECTION_DGNSS_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_NAV_CORRECTION_RTK_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_NAV_CORRECTION_RTK_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_NAV_CORRECTION_PPP_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_NAV_CORRECTION_PPP_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_NAV_CORRECTION_RTK_FIXED_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_NAV_CORRECTION_RTK_FIXED_BIT;
-    }
-    if (gnssLocNavSolnMask & LOCATION_NAV_CORRECTION_ONLY_SBAS_CORRECTED_SV_USED_BIT) {
-        pbGnssLocNavSolnMask |= PB_LOCATION_NAV_CORRECTION_ONLY_SBAS_CORRECTED_SV_USED_BIT;
-    }
+    uint32_t pbGnssLocNavSolnMask = sGnssLocationNavSolutionMaskMap.toPb(gnssLocNavSolnMask);
     LocApiPb_LOGv("LocApiPB: gnssLocNavSolnMask:%x, pbGnssLocNavSolnMask:%x",
             gnssLocNavSolnMask, pbGnssLocNavSolnMask);
     return pbGnssLocNavSolnMask;
@@ -1388,22 +1570,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssLocationNavSolutionMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForDrCalibrationStatusMask(
         const uint32_t &drCalibStatusMask) const {
-    uint32_t pbDrCalibStatusMask = 0;
-    if (drCalibStatusMask & DR_ROLL_CALIBRATION_NEEDED) {
-        pbDrCalibStatusMask |= PB_DR_ROLL_CALIBRATION_NEEDED;
-    }
-    if (drCalibStatusMask & DR_PITCH_CALIBRATION_NEEDED) {
-        pbDrCalibStatusMask |= PB_DR_PITCH_CALIBRATION_NEEDED;
-    }
-    if (drCalibStatusMask & DR_YAW_CALIBRATION_NEEDED) {
-        pbDrCalibStatusMask |= PB_DR_YAW_CALIBRATION_NEEDED;
-    }
-    if (drCalibStatusMask & DR_ODO_CALIBRATION_NEEDED) {
-        pbDrCalibStatusMask |= PB_DR_ODO_CALIBRATION_NEEDED;
-    }
-    if (drCalibStatusMask & DR_GYRO_CALIBRATION_NEEDED) {
-        pbDrCalibStatusMask |= PB_DR_GYRO_CALIBRATION_NEEDED;
-    }
+    uint32_t pbDrCalibStatusMask = sDrCalibrationStatusMaskMap.toPb(drCalibStatusMask);
     LocApiPb_LOGv("LocApiPB: drCalibStatusMask:%x, pbDrCalibStatusMask:%x",
             drCalibStatusMask, pbDrCalibStatusMask);
     return pbDrCalibStatusMask;
@@ -1411,70 +1578,8 @@ uint32_t LocationApiPbMsgConv::getPBMaskForDrCalibrationStatusMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssMeasurementsDataFlagsMask(
         const uint32_t &gnssMeasDataFlagsMask) const {
-    uint32_t pbGnssMeasDataFlagsMask = 0;
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_SV_ID_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_SV_ID_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_STATE_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_STATE_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_ADR_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_ADR_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasDataFlagsMask & GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT) {
-        pbGnssMeasDataFlagsMask |= PB_GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT;
-    }
+    uint32_t pbGnssMeasDataFlagsMask =
+            sGnssMeasurementsDataFlagsMaskMap.toPb(gnssMeasDataFlagsMask);
     LocApiPb_LOGv("LocApiPB: gnssMeasDataFlagsMask:%x, pbGnssMeasDataFlagsMask:%x",
             gnssMeasDataFlagsMask, pbGnssMeasDataFlagsMask);
     return pbGnssMeasDataFlagsMask;
@@ -1618,35 +1723,8 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssLocationPosDataMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssMeasurementsClockFlagsMask(
         const uint32_t &gnssMeasClockFlagsMask) const {
-    uint32_t pbGnssMeasClockFlagsMask = 0;
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT) {
-        pbGnssMeasClockFlagsMask |= PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT;
-    }
-    if (gnssMeasClockFlagsMask & GNSS_MEASUREMENTS_CLOCK_FLAGS_HW_CLOCK_DISCONTINUITY_COUNT_BIT) {
-        pbGnssMeasClockFlagsMask |=
-                PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_HW_CLOCK_DISCONTINUITY_COUNT_BIT;
-    }
+    uint32_t pbGnssMeasClockFlagsMask =
+            sGnssMeasurementsClockFlagsMaskMap.toPb(gnssMeasClockFlagsMask);
     LocApiPb_LOGv("LocApiPB: gnssMeasClockFlagsMask:%x, pbGnssMeasClockFlagsMask:%x",
             gnssMeasClockFlagsMask, pbGnssMeasClockFlagsMask);
     return pbGnssMeasClockFlagsMask;
@@ -1654,50 +1732,15 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssMeasurementsClockFlagsMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssGloTimeStructTypeFlags(
         const uint32_t &gnssGloTimeStructTypeFlags) const {
-    uint32_t pbGnssGloTimeStructTypeFlags = 0;
-    if (gnssGloTimeStructTypeFlags & GNSS_CLO_DAYS_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_CLO_DAYS_VALID;
-    }
-    if (gnssGloTimeStructTypeFlags & GNSS_GLO_MSEC_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_GLO_MSEC_VALID;
-    }
-    if (gnssGloTimeStructTypeFlags & GNSS_GLO_CLK_TIME_BIAS_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_GLO_CLK_TIME_BIAS_VALID;
-    }
-    if (gnssGloTimeStructTypeFlags & GNSS_GLO_CLK_TIME_BIAS_UNC_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_GLO_CLK_TIME_BIAS_UNC_VALID;
-    }
-    if (gnssGloTimeStructTypeFlags & GNSS_GLO_REF_FCOUNT_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_GLO_REF_FCOUNT_VALID;
-    }
-    if (gnssGloTimeStructTypeFlags & GNSS_GLO_NUM_CLOCK_RESETS_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_GLO_NUM_CLOCK_RESETS_VALID;
-    }
-    if (gnssGloTimeStructTypeFlags & GNSS_GLO_FOUR_YEAR_VALID) {
-        pbGnssGloTimeStructTypeFlags |= PB_GNSS_GLO_FOUR_YEAR_VALID;
-    }
+    uint32_t pbGnssGloTimeStructTypeFlags =
+            sGnssGloTimeStructTypeFlagsMaskMap.toPb(gnssGloTimeStructTypeFlags);
     LocApiPb_LOGv("LocApiPB: gnssGloTimeStructTypeFlags:%x, pbGnssGloTimeStructTypeFlags:%x",
             gnssGloTimeStructTypeFlags, pbGnssGloTimeStructTypeFlags);
     return pbGnssGloTimeStructTypeFlags;
 }
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssSvOptionsMask(const uint32_t &gnssSvOptMask) const {
-    uint32_t pbGnssSvOptMask = 0;
-    if (gnssSvOptMask & GNSS_SV_OPTIONS_HAS_EPHEMER_BIT) {
-        pbGnssSvOptMask |= PB_GNSS_SV_OPTIONS_HAS_EPHEMER_BIT;
-    }
-    if (gnssSvOptMask & GNSS_SV_OPTIONS_HAS_ALMANAC_BIT) {
-        pbGnssSvOptMask |= PB_GNSS_SV_OPTIONS_HAS_ALMANAC_BIT;
-    }
-    if (gnssSvOptMask & GNSS_SV_OPTIONS_USED_IN_FIX_BIT) {
-        pbGnssSvOptMask |= PB_GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
-    }
-    if (gnssSvOptMask & GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT) {
-        pbGnssSvOptMask |= PB_GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT;
-    }
-    if (gnssSvOptMask & GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT) {
-        pbGnssSvOptMask |= PB_GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT;
-    }
+    uint32_t pbGnssSvOptMask = sGnssSvOptionsMaskMap.toPb(gnssSvOptMask);
     LocApiPb_LOGv("LocApiPB: gnssSvOptMask:%x, pbGnssSvOptMask:%x", gnssSvOptMask,
             pbGnssSvOptMask);
     return pbGnssSvOptMask;
@@ -1705,73 +1748,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssSvOptionsMask(const uint32_t &gns
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGnssSignalTypeMask(
         const uint32_t &gnssSignalTypeMask) const {
-    uint32_t pbGnssSignalTypeMask = 0;
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GPS_L1CA) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GPS_L1CA_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GPS_L1C) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GPS_L1C_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GPS_L2) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GPS_L2_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GPS_L5) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GPS_L5_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GLONASS_G1) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GLONASS_G1_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GLONASS_G2) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GLONASS_G2_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GALILEO_E1) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GALILEO_E1_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GALILEO_E5A) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GALILEO_E5A_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_GALILEO_E5B) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_GALILEO_E5B_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B1) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B1_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B2) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B2_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_QZSS_L1CA) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_QZSS_L1CA_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_QZSS_L1S) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_QZSS_L1S_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_QZSS_L2) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_QZSS_L2_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_QZSS_L5) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_QZSS_L5_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_SBAS_L1) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_SBAS_L1_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B1I) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B1I_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B1C) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B1C_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B2I) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B2I_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B2AI) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B2AI_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_NAVIC_L5) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_NAVIC_L5_BIT;
-    }
-    if (gnssSignalTypeMask & GNSS_SIGNAL_BEIDOU_B2AQ) {
-        pbGnssSignalTypeMask |= PB_GNSS_SIGNAL_BEIDOU_B2AQ_BIT;
-    }
+    uint32_t pbGnssSignalTypeMask = sGnssSignalTypeMaskMap.toPb(gnssSignalTypeMask);
     LocApiPb_LOGv("LocApiPB: gnssSignalTypeMask:%x, pbGnssSignalTypeMask:%x",
             gnssSignalTypeMask, pbGnssSignalTypeMask);
     return pbGnssSignalTypeMask;
@@ -1779,19 +1756,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGnssSignalTypeMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForGeofenceBreachTypeMask(
         const uint32_t &gfBreachTypeMask) const {
-    uint32_t pbGfBreachTypeMask = 0;
-    if (gfBreachTypeMask & GEOFENCE_BREACH_ENTER_BIT) {
-        pbGfBreachTypeMask |= PB_GEOFENCE_BREACH_ENTER_BIT;
-    }
-    if (gfBreachTypeMask & GEOFENCE_BREACH_EXIT_BIT) {
-        pbGfBreachTypeMask |= PB_GEOFENCE_BREACH_EXIT_BIT;
-    }
-    if (gfBreachTypeMask & GEOFENCE_BREACH_DWELL_IN_BIT) {
-        pbGfBreachTypeMask |= PB_GEOFENCE_BREACH_DWELL_IN_BIT;
-    }
-    if (gfBreachTypeMask & GEOFENCE_BREACH_DWELL_OUT_BIT) {
-        pbGfBreachTypeMask |= PB_GEOFENCE_BREACH_DWELL_OUT_BIT;
-    }
+    uint32_t pbGfBreachTypeMask = sGeofenceBreachTypeMaskMap.toPb(gfBreachTypeMask);
     LocApiPb_LOGv("LocApiPB: gfBreachTypeMask:%x, pbGfBreachTypeMask:%x",
             gfBreachTypeMask, pbGfBreachTypeMask);
     return pbGfBreachTypeMask;
@@ -1800,22 +1765,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForGeofenceBreachTypeMask(
 // DeadReckoningEngineConfigValidMask to PBDeadReckoningEngineConfigValidMask
 uint64_t LocationApiPbMsgConv::getPBMaskForDeadReckoningEngineConfigValidMask(
             const uint64_t &drEngCfgValidMask) const {
-    uint64_t pbDrEngCfgVldMask = 0;
-    if (drEngCfgValidMask & BODY_TO_SENSOR_MOUNT_PARAMS_BIT) {
-        pbDrEngCfgVldMask |= PB_BODY_TO_SENSOR_MOUNT_PARAMS_BIT;
-    }
-    if (drEngCfgValidMask & VEHICLE_SPEED_SCALE_FACTOR_BIT) {
-        pbDrEngCfgVldMask |= PB_VEHICLE_SPEED_SCALE_FACTOR_BIT;
-    }
-    if (drEngCfgValidMask & VEHICLE_SPEED_SCALE_FACTOR_UNC_BIT) {
-        pbDrEngCfgVldMask |= PB_VEHICLE_SPEED_SCALE_FACTOR_UNC_BIT;
-    }
-    if (drEngCfgValidMask & GYRO_SCALE_FACTOR_BIT) {
-        pbDrEngCfgVldMask |= PB_GYRO_SCALE_FACTOR_BIT;
-    }
-    if (drEngCfgValidMask & GYRO_SCALE_FACTOR_UNC_BIT) {
-        pbDrEngCfgVldMask |= PB_GYRO_SCALE_FACTOR_UNC_BIT;
-    }
+    uint64_t pbDrEngCfgVldMask = sDeadReckoningEngineConfigValidMaskMap.toPb(drEngCfgValidMask);
     LocApiPb_LOGv("LocApiPB: drEngCfgValidMask:%" PRIu64", pbDrEngCfgVldMask:%" PRIu64,
             drEngCfgValidMask, pbDrEngCfgVldMask);
     return pbDrEngCfgVldMask;
@@ -1824,10 +1774,7 @@ uint64_t LocationApiPbMsgConv::getPBMaskForDeadReckoningEngineConfigValidMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForDrEngineAidingDataMask(
         const uint32_t &drEngAidDataMask) const {
-    uint32_t pbDrEngAidDataMask = 0;
-    if (drEngAidDataMask & DR_ENGINE_AIDING_DATA_CALIBRATION_BIT) {
-        pbDrEngAidDataMask |= PB_DR_ENGINE_AIDING_DATA_CALIBRATION_BIT;
-    }
+    uint32_t pbDrEngAidDataMask = sDrEngineAidingDataMaskMap.toPb(drEngAidDataMask);
     LocApiPb_LOGv("LocApiPB: drEngAidDataMask:%x, pbDrEngAidDataMask:%x",
             drEngAidDataMask, pbDrEngAidDataMask);
     return pbDrEngAidDataMask;
@@ -1835,13 +1782,7 @@ uint32_t LocationApiPbMsgConv::getPBMaskForDrEngineAidingDataMask(
 
 uint32_t LocationApiPbMsgConv::getPBMaskForDrSolutionStatusMask(
         const uint32_t &drSolnStatusMask) const {
-    uint32_t pbDrSolnStatusMask = 0;
-    if (drSolnStatusMask & VEHICLE_SENSOR_SPEED_INPUT_DETECTED) {
-        pbDrSolnStatusMask |= PB_VEHICLE_SENSOR_SPEED_INPUT_DETECTED;
-    }
-    if (drSolnStatusMask & VEHICLE_SENSOR_SPEED_INPUT_USED) {
-        pbDrSolnStatusMask |= PB_VEHICLE_SENSOR_SPEED_INPUT_USED;
-    }
+    uint32_t pbDrSolnStatusMask = sDrSolutionStatusMaskMap.toPb(drSolnStatusMask);
     LocApiPb_LOGv("LocApiPB: drSolnStatusMask:%x, pbDrSolnStatusMask:%x",
             drSolnStatusMask, pbDrSolnStatusMask);
     return pbDrSolnStatusMask;
@@ -1850,119 +1791,20 @@ uint32_t LocationApiPbMsgConv::getPBMaskForDrSolutionStatusMask(
 // **** helper function for mask conversion from protobuf masks to normal rigid values
 uint64_t LocationApiPbMsgConv::getLocationCapabilitiesMaskFromPB(
         const uint64_t &pbLocCapabMask) const {
-    uint64_t locCapabMask = 0;
-    if (pbLocCapabMask & PB_LOCATION_CAPS_TIME_BASED_TRACKING_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_TIME_BASED_TRACKING_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_TIME_BASED_BATCHING_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_TIME_BASED_BATCHING_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_DISTANCE_BASED_TRACKING_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_DISTANCE_BASED_TRACKING_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_DISTANCE_BASED_BATCHING_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_DISTANCE_BASED_BATCHING_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_GEOFENCE_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_GEOFENCE_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_OUTDOOR_TRIP_BATCHING_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_OUTDOOR_TRIP_BATCHING_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_GNSS_MEASUREMENTS_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_GNSS_MEASUREMENTS_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_CONSTELLATION_ENABLEMENT_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_CONSTELLATION_ENABLEMENT_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_CARRIER_PHASE_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_CARRIER_PHASE_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_SV_POLYNOMIAL_BIT) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_SV_POLYNOMIAL_BIT;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_GNSS_SINGLE_FREQUENCY) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_GNSS_SINGLE_FREQUENCY;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_GNSS_MULTI_FREQUENCY) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_GNSS_MULTI_FREQUENCY;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_VPE) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_VPE;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_CV2X_LOCATION_BASIC) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_CV2X_LOCATION_BASIC;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_CV2X_LOCATION_PREMIUM) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_CV2X_LOCATION_PREMIUM;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_PPE) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_PPE;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_QDR2) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_QDR2;
-    }
-    if (pbLocCapabMask & PB_LOCATION_CAPS_QWES_QDR3) {
-        locCapabMask |= LOCATION_CAPABILITIES_QWES_QDR3;
-    }
+    uint64_t locCapabMask = sLocationCapabilitiesMaskMap.fromPb(pbLocCapabMask);
     LOC_LOGi("LocApiPB: pbLocCapabMask:0x%" PRIx64", locCapabMask:0x%" PRIx64,
             pbLocCapabMask, locCapabMask);
     return locCapabMask;
 }
 
 uint32_t LocationApiPbMsgConv::getLocationCallbacksMaskFromPB(const uint32_t &pbLocCbMask) const {
-    uint32_t locCbMask = 0;
-    if (pbLocCbMask & PB_E_LOC_CB_DISTANCE_BASED_TRACKING_BIT) {
-        locCbMask |= E_LOC_CB_DISTANCE_BASED_TRACKING_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_GNSS_LOCATION_INFO_BIT) {
-        locCbMask |= E_LOC_CB_GNSS_LOCATION_INFO_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_GNSS_SV_BIT) {
-        locCbMask |= E_LOC_CB_GNSS_SV_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_GNSS_NMEA_BIT) {
-        locCbMask |= E_LOC_CB_GNSS_NMEA_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_GNSS_DATA_BIT) {
-        locCbMask |= E_LOC_CB_GNSS_DATA_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_SYSTEM_INFO_BIT) {
-        locCbMask |= E_LOC_CB_SYSTEM_INFO_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_BATCHING_BIT) {
-        locCbMask |= E_LOC_CB_BATCHING_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_BATCHING_STATUS_BIT) {
-        locCbMask |= E_LOC_CB_BATCHING_STATUS_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_GEOFENCE_BREACH_BIT) {
-        locCbMask |= E_LOC_CB_GEOFENCE_BREACH_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT) {
-        locCbMask |= E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_SIMPLE_LOCATION_INFO_BIT) {
-        locCbMask |= E_LOC_CB_SIMPLE_LOCATION_INFO_BIT;
-    }
-    if (pbLocCbMask & PB_E_LOC_CB_GNSS_MEAS_BIT) {
-        locCbMask |= E_LOC_CB_GNSS_MEAS_BIT;
-    }
+    uint32_t locCbMask = sLocationCallbacksMaskMap.fromPb(pbLocCbMask);
     LocApiPb_LOGv("LocApiPB: pbLocCbMask:%x, locCbMask:%x", pbLocCbMask, locCbMask);
     return locCbMask;
 }
 
 uint32_t LocationApiPbMsgConv::getLeverArmTypeMaskFromPB(const uint32_t &pbLeverTypeMask) const {
-    uint32_t leverYypeMask = 0;
-    if (pbLeverTypeMask & PB_LEVER_ARM_TYPE_GNSS_TO_VRP_BIT) {
-        leverYypeMask |= LEVER_ARM_TYPE_GNSS_TO_VRP_BIT;
-    }
-    if (pbLeverTypeMask & PB_LEVER_ARM_TYPE_DR_IMU_TO_GNSS_BIT) {
-        leverYypeMask |= LEVER_ARM_TYPE_DR_IMU_TO_GNSS_BIT;
-    }
-    if (pbLeverTypeMask & PB_LEVER_ARM_TYPE_VEPP_IMU_TO_GNSS_BIT) {
-        leverYypeMask |= LEVER_ARM_TYPE_VEPP_IMU_TO_GNSS_BIT;
-    }
+    uint32_t leverYypeMask = sLeverArmTypeMaskMap.fromPb(pbLeverTypeMask);
     LocApiPb_LOGv("LocApiPB: pbLeverTypeMask:%x, leverYypeMask:%x", pbLeverTypeMask,
             leverYypeMask);
     return leverYypeMask;
@@ -1970,16 +1812,7 @@ uint32_t LocationApiPbMsgConv::getLeverArmTypeMaskFromPB(const uint32_t &pbLever
 
 uint32_t LocationApiPbMsgConv::getEnumForPBPositioningEngineMask(
         const uint32_t &pbPosEngMask) const {
-    uint32_t posEngMask = 0;
-    if (pbPosEngMask & PB_STANDARD_POSITIONING_ENGINE) {
-        posEngMask |= STANDARD_POSITIONING_ENGINE;
-    }
-    if (pbPosEngMask & PB_PRECISE_POSITIONING_ENGINE) {
-        posEngMask |= PRECISE_POSITIONING_ENGINE;
-    }
-    if (pbPosEngMask & PB_DEAD_RECKONING_ENGINE) {
-        posEngMask |= DEAD_RECKONING_ENGINE;
-    }
+    uint32_t posEngMask = sPositioningEngineMaskMap.fromPb(pbPosEngMask);
     LocApiPb_LOGv("LocApiPB: pbPosEngMask:%x, posEngMask:%x", pbPosEngMask, posEngMask);
     return posEngMask;
 }
@@ -2011,10 +1844,7 @@ uint64_t LocationApiPbMsgConv::getGnssSvTypesMaskFromPB(const uint64_t &pbGnssSv
 
 uint32_t LocationApiPbMsgConv::getGnssAidingDataSvMaskFromPB(
         const uint32_t &pbGnssAidDataSvMask) const {
-    uint32_t gnssAidDataSvMask = 0;
-    if (pbGnssAidDataSvMask & PB_AIDING_DATA_SV_EPHEMERIS_BIT) {
-        gnssAidDataSvMask |= GNSS_AIDING_DATA_SV_EPHEMERIS_BIT;
-    }
+    uint32_t gnssAidDataSvMask = sGnssAidingDataSvMaskMap.fromPb(pbGnssAidDataSvMask);
     LocApiPb_LOGv("LocApiPB: pbGnssAidDataSvMask:%x, gnssAidDataSvMask:%x",
             pbGnssAidDataSvMask, gnssAidDataSvMask);
     return gnssAidDataSvMask;
@@ -2022,16 +1852,7 @@ uint32_t LocationApiPbMsgConv::getGnssAidingDataSvMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getLocReqEngineTypeMaskFromPB(
         const uint32_t &pbLocReqEngTypeMask) const {
-    uint32_t locReqEngTypeMask = 0;
-    if (pbLocReqEngTypeMask & PB_LOC_REQ_ENGINE_FUSED_BIT) {
-        locReqEngTypeMask |= LOC_REQ_ENGINE_FUSED_BIT;
-    }
-    if (pbLocReqEngTypeMask & PB_LOC_REQ_ENGINE_SPE_BIT) {
-        locReqEngTypeMask |= LOC_REQ_ENGINE_SPE_BIT;
-    }
-    if (pbLocReqEngTypeMask & PB_LOC_REQ_ENGINE_PPE_BIT) {
-        locReqEngTypeMask |= LOC_REQ_ENGINE_PPE_BIT;
-    }
+    uint32_t locReqEngTypeMask = sLocReqEngineTypeMaskMap.fromPb(pbLocReqEngTypeMask);
     LocApiPb_LOGv("LocApiPB: pbLocReqEngTypeMask:%x, locReqEngTypeMask:%x",
             pbLocReqEngTypeMask, locReqEngTypeMask);
     return locReqEngTypeMask;
@@ -2049,13 +1870,7 @@ uint32_t LocationApiPbMsgConv::getLocationSystemInfoMaskFromPB(
 }
 
 uint64_t LocationApiPbMsgConv::getGnssDataMaskFromPB(const uint64_t &pbGnssDataMask) const {
-    uint64_t gnssDataMask = 0;
-    if (pbGnssDataMask & PB_GNSS_LOC_DATA_JAMMER_IND_BIT) {
-        gnssDataMask |= GNSS_LOC_DATA_JAMMER_IND_BIT;
-    }
-    if (pbGnssDataMask & PB_GNSS_LOC_DATA_AGC_BIT) {
-        gnssDataMask |= GNSS_LOC_DATA_AGC_BIT;
-    }
+    uint64_t gnssDataMask = sGnssDataMaskMap.fromPb(pbGnssDataMask);
     LocApiPb_LOGv("LocApiPB: pbGnssDataMask:%" PRIu64", gnssDataMask:%" PRIu64,
             pbGnssDataMask, gnssDataMask);
     return gnssDataMask;
@@ -2063,13 +1878,7 @@ uint64_t LocationApiPbMsgConv::getGnssDataMaskFromPB(const uint64_t &pbGnssDataM
 
 uint32_t LocationApiPbMsgConv::getLeapSecSysInfoMaskFromPB(
         const uint32_t &pbLeapSecSysInfoMask) const {
-    uint32_t leapSecSysInfoMask = 0;
-    if (pbLeapSecSysInfoMask & PB_LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT) {
-        leapSecSysInfoMask |= LEAP_SECOND_SYS_INFO_CURRENT_LEAP_SECONDS_BIT;
-    }
-    if (pbLeapSecSysInfoMask & PB_LEAP_SECOND_SYS_INFO_LEAP_SECOND_CHANGE_BIT) {
-        leapSecSysInfoMask |= LEAP_SECOND_SYS_INFO_LEAP_SECOND_CHANGE_BIT;
-    }
+    uint32_t leapSecSysInfoMask = sLeapSecondSysInfoMaskMap.fromPb(pbLeapSecSysInfoMask);
     LocApiPb_LOGv("LocApiPB: pbLeapSecSysInfoMask:%x, leapSecSysInfoMask:%x",
             pbLeapSecSysInfoMask, leapSecSysInfoMask);
     return leapSecSysInfoMask;
@@ -2077,25 +1886,8 @@ uint32_t LocationApiPbMsgConv::getLeapSecSysInfoMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssSystemTimeStructTypeFlagsFromPB(
         const uint32_t &pbGnssSysTimeStrctType) const {
-    uint32_t gnssSysTimeStrctTypeMsk = 0;
-    if (pbGnssSysTimeStrctType & PB_GNSS_SYSTEM_TIME_WEEK_VALID) {
-        gnssSysTimeStrctTypeMsk |= GNSS_SYSTEM_TIME_WEEK_VALID;
-    }
-    if (pbGnssSysTimeStrctType & PB_GNSS_SYSTEM_TIME_WEEK_MS_VALID) {
-        gnssSysTimeStrctTypeMsk |= GNSS_SYSTEM_TIME_WEEK_MS_VALID;
-    }
-    if (pbGnssSysTimeStrctType & PB_GNSS_SYSTEM_CLK_TIME_BIAS_VALID) {
-        gnssSysTimeStrctTypeMsk |= GNSS_SYSTEM_CLK_TIME_BIAS_VALID;
-    }
-    if (pbGnssSysTimeStrctType & PB_GNSS_SYSTEM_CLK_TIME_BIAS_UNC_VALID) {
-        gnssSysTimeStrctTypeMsk |= GNSS_SYSTEM_CLK_TIME_BIAS_UNC_VALID;
-    }
-    if (pbGnssSysTimeStrctType & PB_GNSS_SYSTEM_REF_FCOUNT_VALID) {
-        gnssSysTimeStrctTypeMsk |= GNSS_SYSTEM_REF_FCOUNT_VALID;
-    }
-    if (pbGnssSysTimeStrctType & PB_GNSS_SYSTEM_NUM_CLOCK_RESETS_VALID) {
-        gnssSysTimeStrctTypeMsk |= GNSS_SYSTEM_NUM_CLOCK_RESETS_VALID;
-    }
+    uint32_t gnssSysTimeStrctTypeMsk =
+            sGnssSystemTimeStructTypeFlagsMaskMap.fromPb(pbGnssSysTimeStrctType);
     LocApiPb_LOGv("LocApiPB: pbGnssSysTimeStrctType:%x, gnssSysTimeStrctTypeMsk:%x",
             pbGnssSysTimeStrctType, gnssSysTimeStrctTypeMsk);
     return gnssSysTimeStrctTypeMsk;
@@ -2103,73 +1895,7 @@ uint32_t LocationApiPbMsgConv::getGnssSystemTimeStructTypeFlagsFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssSignalTypeMaskFromPB(
         const uint32_t &pbGnssSignalTypeMask) const {
-    uint32_t gnssSignalTypeMask = 0;
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GPS_L1CA_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GPS_L1CA;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GPS_L1C_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GPS_L1C;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GPS_L2_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GPS_L2;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GPS_L5_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GPS_L5;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GLONASS_G1_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GLONASS_G1;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GLONASS_G2_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GLONASS_G2;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GALILEO_E1_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GALILEO_E1;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GALILEO_E5A_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GALILEO_E5A;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_GALILEO_E5B_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_GALILEO_E5B;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B1_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B1;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B2_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B2;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_QZSS_L1CA_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_QZSS_L1CA;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_QZSS_L1S_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_QZSS_L1S;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_QZSS_L2_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_QZSS_L2;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_QZSS_L5_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_QZSS_L5;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_SBAS_L1_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_SBAS_L1;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B1I_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B1I;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B1C_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B1C;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B2I_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B2I;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B2AI_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B2AI;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_NAVIC_L5_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_NAVIC_L5;
-    }
-    if (pbGnssSignalTypeMask & PB_GNSS_SIGNAL_BEIDOU_B2AQ_BIT) {
-        gnssSignalTypeMask |= GNSS_SIGNAL_BEIDOU_B2AQ;
-    }
+    uint32_t gnssSignalTypeMask = sGnssSignalTypeMaskMap.fromPb(pbGnssSignalTypeMask);
     LocApiPb_LOGv("LocApiPB: pbGnssSignalTypeMask:%x, gnssSignalTypeMask:%x",
             pbGnssSignalTypeMask, gnssSignalTypeMask);
     return gnssSignalTypeMask;
@@ -2177,147 +1903,36 @@ uint32_t LocationApiPbMsgConv::getGnssSignalTypeMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssSvOptionsMaskFromPB(
         const uint32_t &pbGnssSvOptMask) const {
-    uint32_t gnssSvOptMask = 0;
-    if (pbGnssSvOptMask & PB_GNSS_SV_OPTIONS_HAS_EPHEMER_BIT) {
-        gnssSvOptMask |= GNSS_SV_OPTIONS_HAS_EPHEMER_BIT;
-    }
-    if (pbGnssSvOptMask & PB_GNSS_SV_OPTIONS_HAS_ALMANAC_BIT) {
-        gnssSvOptMask |= GNSS_SV_OPTIONS_HAS_ALMANAC_BIT;
-    }
-    if (pbGnssSvOptMask & PB_GNSS_SV_OPTIONS_USED_IN_FIX_BIT) {
-        gnssSvOptMask |= GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
-    }
-    if (pbGnssSvOptMask & PB_GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT) {
-        gnssSvOptMask |= GNSS_SV_OPTIONS_HAS_CARRIER_FREQUENCY_BIT;
-    }
-    if (pbGnssSvOptMask & PB_GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT) {
-        gnssSvOptMask |= GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT;
-    }
+    uint32_t gnssSvOptMask = sGnssSvOptionsMaskMap.fromPb(pbGnssSvOptMask);
     LocApiPb_LOGv("LocApiPB: pbGnssSvOptMask:%x, gnssSvOptMask:%x", pbGnssSvOptMask,
             gnssSvOptMask);
     return gnssSvOptMask;
 }
 
 uint32_t LocationApiPbMsgConv::getGfBreachTypeMaskFromPB(const uint32_t &pbGfBreackTypMask) const {
-    uint32_t gfBreachTypMask = 0;
-    if (pbGfBreackTypMask & PB_GEOFENCE_BREACH_ENTER_BIT) {
-        gfBreachTypMask |= GEOFENCE_BREACH_ENTER_BIT;
-    }
-    if (pbGfBreackTypMask & PB_GEOFENCE_BREACH_EXIT_BIT) {
-        gfBreachTypMask |= GEOFENCE_BREACH_EXIT_BIT;
-    }
-    if (pbGfBreackTypMask & PB_GEOFENCE_BREACH_DWELL_IN_BIT) {
-        gfBreachTypMask |= GEOFENCE_BREACH_DWELL_IN_BIT;
-    }
-    if (pbGfBreackTypMask & PB_GEOFENCE_BREACH_DWELL_OUT_BIT) {
-        gfBreachTypMask |= GEOFENCE_BREACH_DWELL_OUT_BIT;
-    }
+    uint32_t gfBreachTypMask = sGeofenceBreachTypeMaskMap.fromPb(pbGfBreackTypMask);
     LocApiPb_LOGv("LocApiPB: pbGfBreackTypMask:%x, gfBreachTypMask:%x", pbGfBreackTypMask,
             gfBreachTypMask);
     return gfBreachTypMask;
 }
 
 uint32_t LocationApiPbMsgConv::getLocationFlagsMaskFromPB(const uint32_t &pbLocFlagsMask) const {
-    uint32_t locFlagsMask = 0;
-    if (pbLocFlagsMask & PB_LOCATION_HAS_LAT_LONG_BIT) {
-        locFlagsMask |= LOCATION_HAS_LAT_LONG_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_ALTITUDE_BIT) {
-        locFlagsMask |= LOCATION_HAS_ALTITUDE_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_SPEED_BIT) {
-        locFlagsMask |= LOCATION_HAS_SPEED_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_BEARING_BIT) {
-        locFlagsMask |= LOCATION_HAS_BEARING_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_ACCURACY_BIT) {
-        locFlagsMask |= LOCATION_HAS_ACCURACY_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_VERTICAL_ACCURACY_BIT) {
-        locFlagsMask |= LOCATION_HAS_VERTICAL_ACCURACY_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_SPEED_ACCURACY_BIT) {
-        locFlagsMask |= LOCATION_HAS_SPEED_ACCURACY_BIT;
-    }
-    if (pbLocFlagsMask & PB_LOCATION_HAS_BEARING_ACCURACY_BIT) {
-        locFlagsMask |= LOCATION_HAS_BEARING_ACCURACY_BIT;
-    }
+    uint32_t locFlagsMask = sLocationFlagsMaskMap.fromPb(pbLocFlagsMask);
     LocApiPb_LOGv("LocApiPB: pbLocFlagsMask:%x, locFlagsMask:%x", pbLocFlagsMask, locFlagsMask);
     return locFlagsMask;
 }
 
 uint32_t LocationApiPbMsgConv::getLocationTechnologyMaskFromPB(
         const uint32_t &pbLocTechMask) const {
-    uint32_t locTechMask = 0;
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_GNSS_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_GNSS_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_CELL_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_CELL_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_WIFI_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_WIFI_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_SENSORS_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_SENSORS_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_REFERENCE_LOCATION_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_REFERENCE_LOCATION_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_INJECTED_COARSE_POSITION_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_INJECTED_COARSE_POSITION_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_AFLT_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_AFLT_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_HYBRID_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_HYBRID_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_PPE_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_PPE_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_VEH_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_VEH_BIT;
-    }
-    if (pbLocTechMask & PB_LOCATION_TECHNOLOGY_VIS_BIT) {
-        locTechMask |= LOCATION_TECHNOLOGY_VIS_BIT;
-    }
+    uint32_t locTechMask = sLocationTechnologyMaskMap.fromPb(pbLocTechMask);
     LocApiPb_LOGv("LocApiPB: pbLocTechMask:%x, locTechMask:%x", pbLocTechMask, locTechMask);
     return locTechMask;
 }
 
 uint32_t LocationApiPbMsgConv::getGnssMeasurementsClockFlagsMaskFromPB(
         const uint32_t &pbGnssMeasClockFlgMask) const {
-    uint32_t gnssMeasClockFlgMask = 0;
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT;
-    }
-    if (pbGnssMeasClockFlgMask & PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasClockFlgMask &
-            PB_GNSS_MEASUREMENTS_CLOCK_FLAGS_HW_CLOCK_DISCONTINUITY_COUNT_BIT) {
-        gnssMeasClockFlgMask |= GNSS_MEASUREMENTS_CLOCK_FLAGS_HW_CLOCK_DISCONTINUITY_COUNT_BIT;
-    }
+    uint32_t gnssMeasClockFlgMask =
+            sGnssMeasurementsClockFlagsMaskMap.fromPb(pbGnssMeasClockFlgMask);
     LocApiPb_LOGv("LocApiPB: pbGnssMeasClockFlgMask:%x, gnssMeasClockFlgMask:%x",
             pbGnssMeasClockFlgMask, gnssMeasClockFlgMask);
     return gnssMeasClockFlgMask;
@@ -2325,70 +1940,7 @@ uint32_t LocationApiPbMsgConv::getGnssMeasurementsClockFlagsMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssMeasurementsDataFlagsMaskFromPB(
         const uint32_t &pbGnssMeasDataFlgMask) const {
-    uint32_t gnssMeasDataFlgMask = 0;
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_SV_ID_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_SV_ID_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_STATE_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_STATE_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_ADR_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_ADR_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT;
-    }
-    if (pbGnssMeasDataFlgMask & PB_GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT) {
-        gnssMeasDataFlgMask |= GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT;
-    }
+    uint32_t gnssMeasDataFlgMask = sGnssMeasurementsDataFlagsMaskMap.fromPb(pbGnssMeasDataFlgMask);
     LocApiPb_LOGv("LocApiPB: pbGnssMeasDataFlgMask:%x, gnssMeasDataFlgMask:%x",
             pbGnssMeasDataFlgMask, gnssMeasDataFlgMask);
     return gnssMeasDataFlgMask;
@@ -2527,34 +2079,7 @@ uint64_t LocationApiPbMsgConv::getGnssLocationInfoFlagMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssLocationNavSolutionMaskFromPB(
         const uint32_t &pbGnssLocNavSoln) const {
-    uint32_t gnssLocNavSoln = 0;
-    if (pbGnssLocNavSoln & PB_LOCATION_SBAS_CORRECTION_IONO_BIT) {
-        gnssLocNavSoln |= LOCATION_SBAS_CORRECTION_IONO_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_SBAS_CORRECTION_FAST_BIT) {
-        gnssLocNavSoln |= LOCATION_SBAS_CORRECTION_FAST_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_SBAS_CORRECTION_LONG_BIT) {
-        gnssLocNavSoln |= LOCATION_SBAS_CORRECTION_LONG_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_SBAS_INTEGRITY_BIT) {
-        gnssLocNavSoln |= LOCATION_SBAS_INTEGRITY_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_NAV_CORRECTION_DGNSS_BIT) {
-        gnssLocNavSoln |= LOCATION_NAV_CORRECTION_DGNSS_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_NAV_CORRECTION_RTK_BIT) {
-        gnssLocNavSoln |= LOCATION_NAV_CORRECTION_RTK_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_NAV_CORRECTION_PPP_BIT) {
-        gnssLocNavSoln |= LOCATION_NAV_CORRECTION_PPP_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_NAV_CORRECTION_RTK_FIXED_BIT) {
-        gnssLocNavSoln |= LOCATION_NAV_CORRECTION_RTK_FIXED_BIT;
-    }
-    if (pbGnssLocNavSoln & PB_LOCATION_NAV_CORRECTION_ONLY_SBAS_CORRECTED_SV_USED_BIT) {
-        gnssLocNavSoln |= LOCATION_NAV_CORRECTION_ONLY_SBAS_CORRECTED_SV_USED_BIT;
-    }
+    uint32_t gnssLocNavSoln = sGnssLocationNavSolutionMaskMap.fromPb(pbGnssLocNavSoln);
     LocApiPb_LOGv("LocApiPB: pbGnssLocNavSoln:%x, gnssLocNavSoln:%x", pbGnssLocNavSoln,
             gnssLocNavSoln);
     return gnssLocNavSoln;
@@ -2562,22 +2087,7 @@ uint32_t LocationApiPbMsgConv::getGnssLocationNavSolutionMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getDrCalibrationStatusMaskFromPB(
         const uint32_t &pbDrCalibStatus) const {
-    uint32_t drCalibStatus = 0;
-    if (pbDrCalibStatus & PB_DR_ROLL_CALIBRATION_NEEDED) {
-        drCalibStatus |= DR_ROLL_CALIBRATION_NEEDED;
-    }
-    if (pbDrCalibStatus & PB_DR_PITCH_CALIBRATION_NEEDED) {
-        drCalibStatus |= DR_PITCH_CALIBRATION_NEEDED;
-    }
-    if (pbDrCalibStatus & PB_DR_YAW_CALIBRATION_NEEDED) {
-        drCalibStatus |= DR_YAW_CALIBRATION_NEEDED;
-    }
-    if (pbDrCalibStatus & PB_DR_ODO_CALIBRATION_NEEDED) {
-        drCalibStatus |= DR_ODO_CALIBRATION_NEEDED;
-    }
-    if (pbDrCalibStatus & PB_DR_GYRO_CALIBRATION_NEEDED) {
-        drCalibStatus |= DR_GYRO_CALIBRATION_NEEDED;
-    }
+    uint32_t drCalibStatus = sDrCalibrationStatusMaskMap.fromPb(pbDrCalibStatus);
     LocApiPb_LOGv("LocApiPB: pbDrCalibStatus:%x, drCalibStatus:%x", pbDrCalibStatus,
             drCalibStatus);
     return drCalibStatus;
@@ -2655,28 +2165,7 @@ uint32_t LocationApiPbMsgConv::getGnssLocationPosDataMaskExtFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssGloTimeStructTypeFlagsFromPB(
         const uint32_t &pbGnssGloTimeStruct) const {
-    uint32_t gnssGloTimeStruct = 0;
-    if (pbGnssGloTimeStruct & PB_GNSS_CLO_DAYS_VALID) {
-        gnssGloTimeStruct |= GNSS_CLO_DAYS_VALID;
-    }
-    if (pbGnssGloTimeStruct & PB_GNSS_GLO_MSEC_VALID) {
-        gnssGloTimeStruct |= GNSS_GLO_MSEC_VALID;
-    }
-    if (pbGnssGloTimeStruct & PB_GNSS_GLO_CLK_TIME_BIAS_VALID) {
-        gnssGloTimeStruct |= GNSS_GLO_CLK_TIME_BIAS_VALID;
-    }
-    if (pbGnssGloTimeStruct & PB_GNSS_GLO_CLK_TIME_BIAS_UNC_VALID) {
-        gnssGloTimeStruct |= GNSS_GLO_CLK_TIME_BIAS_UNC_VALID;
-    }
-    if (pbGnssGloTimeStruct & PB_GNSS_GLO_REF_FCOUNT_VALID) {
-        gnssGloTimeStruct |= GNSS_GLO_REF_FCOUNT_VALID;
-    }
-    if (pbGnssGloTimeStruct & PB_GNSS_GLO_NUM_CLOCK_RESETS_VALID) {
-        gnssGloTimeStruct |= GNSS_GLO_NUM_CLOCK_RESETS_VALID;
-    }
-    if (pbGnssGloTimeStruct & PB_GNSS_GLO_FOUR_YEAR_VALID) {
-        gnssGloTimeStruct |= GNSS_GLO_FOUR_YEAR_VALID;
-    }
+    uint32_t gnssGloTimeStruct = sGnssGloTimeStructTypeFlagsMaskMap.fromPb(pbGnssGloTimeStruct);
     LocApiPb_LOGv("LocApiPB: pbGnssGloTimeStruct:%x, gnssGloTimeStruct:%x",
             pbGnssGloTimeStruct, gnssGloTimeStruct);
     return gnssGloTimeStruct;
@@ -2684,17 +2173,8 @@ uint32_t LocationApiPbMsgConv::getGnssGloTimeStructTypeFlagsFromPB(
 
 uint32_t LocationApiPbMsgConv::getGnssConfigRobustLocationValidMaskFromPB(
         const uint32_t &pbGnssCfgRobstLocValidMask) const {
-    uint32_t gnssCfgRobstLocValidMask = 0;
-    if (pbGnssCfgRobstLocValidMask & PB_GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT) {
-        gnssCfgRobstLocValidMask |= GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT;
-    }
-    if (pbGnssCfgRobstLocValidMask & PB_GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT) {
-        gnssCfgRobstLocValidMask |=  GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT;
-    }
-    if (pbGnssCfgRobstLocValidMask & PB_GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT) {
-        gnssCfgRobstLocValidMask |= GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT;
-    }
-
+    uint32_t gnssCfgRobstLocValidMask =
+            sGnssCfgRobustLocValidMaskMap.fromPb(pbGnssCfgRobstLocValidMask);
     LocApiPb_LOGv("LocApiPB: pbGnssCfgRobstLocValidMask:%x, gnssCfgRobstLocValidMask:%x",
             pbGnssCfgRobstLocValidMask, gnssCfgRobstLocValidMask);
     return gnssCfgRobstLocValidMask;
@@ -2702,22 +2182,7 @@ uint32_t LocationApiPbMsgConv::getGnssConfigRobustLocationValidMaskFromPB(
 
 uint64_t LocationApiPbMsgConv::getDeadReckoningEngineConfigValidMaskFromPB(
         const uint64_t &pbDrEngCfgVldMask) const {
-    uint64_t drEngCfgValidMask = 0;
-    if (pbDrEngCfgVldMask & PB_BODY_TO_SENSOR_MOUNT_PARAMS_BIT) {
-        drEngCfgValidMask |= BODY_TO_SENSOR_MOUNT_PARAMS_BIT;
-    }
-    if (pbDrEngCfgVldMask & PB_VEHICLE_SPEED_SCALE_FACTOR_BIT) {
-        drEngCfgValidMask |= VEHICLE_SPEED_SCALE_FACTOR_BIT;
-    }
-    if (pbDrEngCfgVldMask & PB_VEHICLE_SPEED_SCALE_FACTOR_UNC_BIT) {
-        drEngCfgValidMask |= VEHICLE_SPEED_SCALE_FACTOR_UNC_BIT;
-    }
-    if (pbDrEngCfgVldMask & PB_GYRO_SCALE_FACTOR_BIT) {
-        drEngCfgValidMask |= GYRO_SCALE_FACTOR_BIT;
-    }
-    if (pbDrEngCfgVldMask & PB_GYRO_SCALE_FACTOR_UNC_BIT) {
-        drEngCfgValidMask |= GYRO_SCALE_FACTOR_UNC_BIT;
-    }
+    uint64_t drEngCfgValidMask = sDeadReckoningEngineConfigValidMaskMap.fromPb(pbDrEngCfgVldMask);
     LocApiPb_LOGv("LocApiPB: pbDrEngCfgVldMask:%" PRIu64", drEngCfgValidMask:%" PRIu64,
             pbDrEngCfgVldMask, drEngCfgValidMask);
     return drEngCfgValidMask;
@@ -2725,10 +2190,7 @@ uint64_t LocationApiPbMsgConv::getDeadReckoningEngineConfigValidMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getDrEngineAidingDataMaskFromPB(
         const uint32_t &pbDrEngAidDataMask) const {
-    uint32_t drEngAidDataMask = 0;
-    if (pbDrEngAidDataMask & PB_DR_ENGINE_AIDING_DATA_CALIBRATION_BIT) {
-        drEngAidDataMask |= DR_ENGINE_AIDING_DATA_CALIBRATION_BIT;
-    }
+    uint32_t drEngAidDataMask = sDrEngineAidingDataMaskMap.fromPb(pbDrEngAidDataMask);
     LocApiPb_LOGv("LocApiPB: pbDrEngAidDataMask:%x, drEngAidDataMask:%x",
             pbDrEngAidDataMask, drEngAidDataMask);
     return drEngAidDataMask;
@@ -2736,13 +2198,7 @@ uint32_t LocationApiPbMsgConv::getDrEngineAidingDataMaskFromPB(
 
 uint32_t LocationApiPbMsgConv::getDrSolutionStatusMaskFromPB(
         const uint32_t &pbDrSolnStatusMask) const {
-    uint32_t drSolnStatusMask = 0;
-    if (pbDrSolnStatusMask & PB_VEHICLE_SENSOR_SPEED_INPUT_DETECTED) {
-        drSolnStatusMask |= VEHICLE_SENSOR_SPEED_INPUT_DETECTED;
-    }
-    if (pbDrSolnStatusMask & PB_VEHICLE_SENSOR_SPEED_INPUT_USED) {
-        drSolnStatusMask |= VEHICLE_SENSOR_SPEED_INPUT_USED;
-    }
+    uint32_t drSolnStatusMask = sDrSolutionStatusMaskMap.fromPb(pbDrSolnStatusMask);
     LocApiPb_LOGv("LocApiPB: pbDrSolnStatusMask:%x, drSolnStatusMask:%x",
             pbDrSolnStatusMask, drSolnStatusMask);
     return drSolnStatusMask;
@@ -3765,6 +3221,8 @@ int LocationApiPbMsgConv::convertGnssMeasDataToPB(const GnssMeasurementsData &gn
         LOC_LOGe("pbGnssMeasData is NULL!, return");
         return 1;
     }
+    // Fields whose validity bit is clear are left at their proto3 default, so they take
+    // no bytes on the wire and decode to 0, same as the peer would have to ignore anyway.
     // uint32 flags = 1; - bitwise OR of PBGnssMeasurementsDataFlagsMask
     pbGnssMeasData->set_flags(getPBMaskForGnssMeasurementsDataFlagsMask(gnssMeasData.flags));
 
@@ -3779,54 +3237,88 @@ int LocationApiPbMsgConv::convertGnssMeasDataToPB(const GnssMeasurementsData &gn
     pbGnssMeasData->set_timeoffsetns(gnssMeasData.timeOffsetNs);
 
     // uint32 stateMask = 5; - bitwise OR of PBGnssMeasurementsStateMask
-    pbGnssMeasData->set_statemask(getPBMaskForGnssMeasurementsStateMask(gnssMeasData.stateMask));
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_STATE_BIT) {
+        pbGnssMeasData->set_statemask(
+                getPBMaskForGnssMeasurementsStateMask(gnssMeasData.stateMask));
+    }
 
     // int64 receivedSvTimeNs = 6;
-    pbGnssMeasData->set_receivedsvtimens(gnssMeasData.receivedSvTimeNs);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT) {
+        pbGnssMeasData->set_receivedsvtimens(gnssMeasData.receivedSvTimeNs);
+    }
 
     // int64 receivedSvTimeUncertaintyNs = 7;
-    pbGnssMeasData->set_receivedsvtimeuncertaintyns(gnssMeasData.receivedSvTimeUncertaintyNs);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT) {
+        pbGnssMeasData->set_receivedsvtimeuncertaintyns(gnssMeasData.receivedSvTimeUncertaintyNs);
+    }
 
     // double carrierToNoiseDbHz = 8;
-    pbGnssMeasData->set_carriertonoisedbhz(gnssMeasData.carrierToNoiseDbHz);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT) {
+        pbGnssMeasData->set_carriertonoisedbhz(gnssMeasData.carrierToNoiseDbHz);
+    }
 
     // double pseudorangeRateMps = 9;
-    pbGnssMeasData->set_pseudorangeratemps(gnssMeasData.pseudorangeRateMps);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT) {
+        pbGnssMeasData->set_pseudorangeratemps(gnssMeasData.pseudorangeRateMps);
+    }
 
     // double pseudorangeRateUncertaintyMps = 10;
-    pbGnssMeasData->set_pseudorangerateuncertaintymps(gnssMeasData.pseudorangeRateUncertaintyMps);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT) {
+        pbGnssMeasData->set_pseudorangerateuncertaintymps(
+                gnssMeasData.pseudorangeRateUncertaintyMps);
+    }
 
     // uint32 adrStateMask = 11; - bitwise OR of PBGnssMeasurementsAdrStateMask
-    pbGnssMeasData->set_adrstatemask(
-            getPBMaskForGnssMeasurementsAdrStateMask(gnssMeasData.adrStateMask));
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT) {
+        pbGnssMeasData->set_adrstatemask(
+                getPBMaskForGnssMeasurementsAdrStateMask(gnssMeasData.adrStateMask));
+    }
 
     // double adrMeters = 12;
-    pbGnssMeasData->set_adrmeters(gnssMeasData.adrMeters);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_ADR_BIT) {
+        pbGnssMeasData->set_adrmeters(gnssMeasData.adrMeters);
+    }
 
     // double adrUncertaintyMeters = 13;
-    pbGnssMeasData->set_adruncertaintymeters(gnssMeasData.adrUncertaintyMeters);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_ADR_UNCERTAINTY_BIT) {
+        pbGnssMeasData->set_adruncertaintymeters(gnssMeasData.adrUncertaintyMeters);
+    }
 
     // float carrierFrequencyHz = 14;
-    pbGnssMeasData->set_carrierfrequencyhz(gnssMeasData.carrierFrequencyHz);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT) {
+        pbGnssMeasData->set_carrierfrequencyhz(gnssMeasData.carrierFrequencyHz);
+    }
 
     // int64 carrierCycles = 15;
-    pbGnssMeasData->set_carriercycles(gnssMeasData.carrierCycles);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT) {
+        pbGnssMeasData->set_carriercycles(gnssMeasData.carrierCycles);
+    }
 
     // double carrierPhase = 16;
-    pbGnssMeasData->set_carrierphase(gnssMeasData.carrierPhase);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT) {
+        pbGnssMeasData->set_carrierphase(gnssMeasData.carrierPhase);
+    }
 
     // double carrierPhaseUncertainty = 17;
-    pbGnssMeasData->set_carrierphaseuncertainty(gnssMeasData.carrierPhaseUncertainty);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT) {
+        pbGnssMeasData->set_carrierphaseuncertainty(gnssMeasData.carrierPhaseUncertainty);
+    }
 
     // PBGnssMeasurementsMultipathIndicator multipathIndicator = 18;
-    pbGnssMeasData->set_multipathindicator(
-            getPBEnumForGnssMeasMultiPathIndic(gnssMeasData.multipathIndicator));
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_MULTIPATH_INDICATOR_BIT) {
+        pbGnssMeasData->set_multipathindicator(
+                getPBEnumForGnssMeasMultiPathIndic(gnssMeasData.multipathIndicator));
+    }
 
     // double signalToNoiseRatioDb = 19;
-    pbGnssMeasData->set_signaltonoiseratiodb(gnssMeasData.signalToNoiseRatioDb);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT) {
+        pbGnssMeasData->set_signaltonoiseratiodb(gnssMeasData.signalToNoiseRatioDb);
+    }
 
     // double agcLevelDb = 20;
-    pbGnssMeasData->set_agcleveldb(gnssMeasData.agcLevelDb);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT) {
+        pbGnssMeasData->set_agcleveldb(gnssMeasData.agcLevelDb);
+    }
 
     // double basebandCarrierToNoiseDbHz = 21;
     pbGnssMeasData->set_basebandcarriertonoisedbhz(gnssMeasData.basebandCarrierToNoiseDbHz);
@@ -3836,14 +3328,20 @@ int LocationApiPbMsgConv::convertGnssMeasDataToPB(const GnssMeasurementsData &gn
             getPBMaskForGnssSignalTypeMask(gnssMeasData.gnssSignalType));
 
     // double fullInterSignalBiasNs = 23;
-    pbGnssMeasData->set_fullintersignalbiasns(gnssMeasData.fullInterSignalBiasNs);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) {
+        pbGnssMeasData->set_fullintersignalbiasns(gnssMeasData.fullInterSignalBiasNs);
+    }
 
     // double fullInterSignalBiasUncertaintyNs = 24;
-    pbGnssMeasData->set_fullintersignalbiasuncertaintyns(
-            gnssMeasData.fullInterSignalBiasUncertaintyNs);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) {
+        pbGnssMeasData->set_fullintersignalbiasuncertaintyns(
+                gnssMeasData.fullInterSignalBiasUncertaintyNs);
+    }
 
     // uint32 cycleSlipCount = 25;
-    pbGnssMeasData->set_cycleslipcount(gnssMeasData.cycleSlipCount);
+    if (gnssMeasData.flags & GNSS_MEASUREMENTS_DATA_CYCLE_SLIP_COUNT_BIT) {
+        pbGnssMeasData->set_cycleslipcount(gnssMeasData.cycleSlipCount);
+    }
 
     LOC_LOGd("LocApiPB: gnssMeasData - GnssMeasDataFlags:%x, Svid:%d, SvType:%d, StateMsk:%x, "\
             "RcvSvTime:%"  PRIu64", RcvSvTimeUnc:%" PRIu64", CNoDb:%lf", gnssMeasData.flags,
@@ -28,6 +28,7 @@
 #ifndef LOCATION_API_PBMSGCONV_H
 #define LOCATION_API_PBMSGCONV_H
 
+#include <atomic>
 #include <LocationApiMsg.h>
 
 using namespace std;
@@ -42,6 +43,11 @@ using namespace loc_util;
 class LocationApiPbMsgConv {
 public:
     LocationApiPbMsgConv();
+    // a copy converts alike, but holds no client token
+    inline LocationApiPbMsgConv(const LocationApiPbMsgConv& other) :
+            mPbDebugLogEnabled(other.mPbDebugLogEnabled),
+            mPbVerboseLogEnabled(other.mPbVerboseLogEnabled),
+            mClientToken(0) {}
     virtual ~LocationApiPbMsgConv() {}
 
     // STRUCTURE CONVERSION
@@ -514,9 +520,21 @@ public:
     PBELocMsgID getPBEnumForELocMsgID(const ELocMsgID &eLocMsgId) const;
     PBClientType getPBEnumForClientType(const ClientType &clientTyp) const;
 
+    // CLIENT TOKEN
+    // ************
+    // Token the hal daemon handed out to the client owning this converter. Msgs
+    // serialized with it carry the token in place of the socket name. 0 if none.
+    inline uint32_t getClientToken() const {
+        return mClientToken.load(std::memory_order_relaxed);
+    }
+    inline void setClientToken(uint32_t clientToken) {
+        mClientToken.store(clientToken, std::memory_order_relaxed);
+    }
+
 private:
     bool mPbDebugLogEnabled;
     bool mPbVerboseLogEnabled;
+    std::atomic<uint32_t> mClientToken;
 
     // RIGID TO PROTOBUF FORMAT
     // ************************
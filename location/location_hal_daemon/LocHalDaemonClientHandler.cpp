@@ -27,16 +27,215 @@
  */
 
 #include <cinttypes>
+#include <algorithm>
 #include <gps_extended_c.h>
 #include <LocationApiMsg.h>
 #include <LocHalDaemonClientHandler.h>
 #include <LocationApiService.h>
 
+// messages queued to a client before its indications start giving way
+#define LOC_HAL_OUTBOUND_QUEUE_DEPTH_DEFAULT (32)
+// messages handed to a client's sender at a time
+#define LOC_HAL_OUTBOUND_SEND_BATCH (16)
+// an NMEA bundle still without GGA goes out once this big
+#define LOC_HAL_NMEA_BUNDLE_MAX_SIZE (8 * 1024)
+
 shared_ptr<LocIpcSender> LocHalDaemonClientHandler::createSender(const string socket) {
     SockNode sockNode(SockNode::create(socket));
     return sockNode.createSender();
 }
 
+shared_ptr<LocIpcSender> LocHalDaemonClientHandler::createShmSender(const string socket,
+        const shared_ptr<LocIpcSender>& sockSender) {
+    // local clients may take measurement, SV and NMEA indications over a
+    // shm ring; those that do not map it keep getting them over the socket
+    if (nullptr != sockSender && SockNode::Local == SockNode::create(socket).getNodeType()) {
+        return LocIpc::getLocIpcShmSender(sockSender);
+    }
+    return sockSender;
+}
+
+/******************************************************************************
+LocHalOutboundQueue
+******************************************************************************/
+LocHalOutboundConfig LocHalOutboundQueue::sConfig = {
+    LOC_HAL_OUTBOUND_QUEUE_DEPTH_DEFAULT,
+    LOC_HAL_OUTBOUND_COALESCE_LATEST,
+    LOC_HAL_OUTBOUND_COALESCE_LATEST,
+    LOC_HAL_OUTBOUND_DROP_OLDEST
+};
+
+LocHalOutboundQueue::LocHalOutboundQueue(LocationApiService* service,
+        const std::string& clientName, const shared_ptr<LocIpcSender>& ipcSender) :
+        mService(service),
+        mName(clientName),
+        mIpcSender(ipcSender),
+        mDraining(false),
+        mClosed(nullptr == ipcSender),
+        mStats{},
+        mMsgTask("LocHalOutbound") {
+}
+
+void LocHalOutboundQueue::setConfig(const LocHalOutboundConfig& config) {
+    sConfig = config;
+    if (0 == sConfig.depth) {
+        sConfig.depth = LOC_HAL_OUTBOUND_QUEUE_DEPTH_DEFAULT;
+    }
+    LOC_LOGd("depth %u, position policy %d, sv policy %d, stream policy %d",
+             sConfig.depth, sConfig.positionPolicy, sConfig.svPolicy, sConfig.streamPolicy);
+}
+
+LocHalOutboundPolicy LocHalOutboundQueue::getPolicy(ELocMsgID msgId) {
+    switch (msgId) {
+        case E_LOCAPI_LOCATION_MSG_ID:
+        case E_LOCAPI_LOCATION_INFO_MSG_ID:
+        case E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID:
+            return sConfig.positionPolicy;
+        case E_LOCAPI_SATELLITE_VEHICLE_MSG_ID:
+        case E_LOCAPI_DATA_MSG_ID:
+            return sConfig.svPolicy;
+        case E_LOCAPI_NMEA_MSG_ID:
+        case E_LOCAPI_MEAS_MSG_ID:
+            return sConfig.streamPolicy;
+        default:
+            // responses, batches, breaches and the like are never dropped
+            return LOC_HAL_OUTBOUND_KEEP;
+    }
+}
+
+bool LocHalOutboundQueue::push(ELocMsgID msgId, const char* msg, size_t msglen) {
+    return push(msgId, std::make_shared<const std::string>(msg, msglen));
+}
+
+bool LocHalOutboundQueue::push(ELocMsgID msgId, const shared_ptr<const std::string>& payload) {
+    LocHalOutboundPolicy policy = getPolicy(msgId);
+    bool startDrain = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mClosed) {
+            return false;
+        }
+
+        bool queued = false;
+        if (LOC_HAL_OUTBOUND_COALESCE_LATEST == policy) {
+            for (auto& queuedMsg : mMsgs) {
+                if (queuedMsg.msgId == msgId) {
+                    queuedMsg.payload = payload;
+                    mStats.coalesced++;
+                    queued = true;
+                    break;
+                }
+            }
+        }
+
+        if (!queued) {
+            if (LOC_HAL_OUTBOUND_KEEP != policy && mMsgs.size() >= sConfig.depth) {
+                auto oldest = std::find_if(mMsgs.begin(), mMsgs.end(),
+                        [] (const OutboundMsg& queuedMsg) {
+                    return LOC_HAL_OUTBOUND_KEEP != queuedMsg.policy;
+                });
+                mStats.dropped++;
+                if (mMsgs.end() == oldest) {
+                    // only responses are queued, the new message gives way
+                    LOC_LOGv("client %s full, msg id %d dropped", mName.c_str(), msgId);
+                    return true;
+                }
+                LOC_LOGv("client %s full, msg id %d dropped", mName.c_str(), oldest->msgId);
+                mMsgs.erase(oldest);
+            }
+            mMsgs.push_back({msgId, policy, payload});
+            if (mMsgs.size() > mStats.highWater) {
+                mStats.highWater = mMsgs.size();
+            }
+        }
+
+        if (!mDraining) {
+            mDraining = true;
+            startDrain = true;
+        }
+    }
+
+    if (startDrain) {
+        shared_ptr<LocHalOutboundQueue> self = shared_from_this();
+        mMsgTask.sendMsg([self] {
+            self->drain();
+        });
+    }
+    return true;
+}
+
+void LocHalOutboundQueue::drain() {
+    // messages are taken out of the queue, and handed to the sender, up to
+    // LOC_HAL_OUTBOUND_SEND_BATCH at a time
+    std::vector<OutboundMsg> msgs;
+    std::vector<struct iovec> iovs;
+    msgs.reserve(LOC_HAL_OUTBOUND_SEND_BATCH);
+    iovs.reserve(LOC_HAL_OUTBOUND_SEND_BATCH);
+    while (true) {
+        msgs.clear();
+        iovs.clear();
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (mClosed || mMsgs.empty()) {
+                mDraining = false;
+                return;
+            }
+            while (!mMsgs.empty() && msgs.size() < LOC_HAL_OUTBOUND_SEND_BATCH) {
+                msgs.push_back(std::move(mMsgs.front()));
+                mMsgs.pop_front();
+            }
+        }
+
+        for (auto& msg : msgs) {
+            iovs.push_back({ .iov_base = (void*)msg.payload->data(),
+                             .iov_len = msg.payload->size() });
+        }
+        int sent = LocIpc::sendBatch(*mIpcSender, iovs.data(), iovs.size());
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStats.sent += sent;
+            for (int i = 0; i < sent; i++) {
+                mStats.bytesSent += iovs[i].iov_len;
+            }
+        }
+
+        if (sent < (int)msgs.size()) {
+            const OutboundMsg& msg = msgs[sent];
+            struct timespec ts;
+            clock_gettime(CLOCK_BOOTTIME, &ts);
+            LOC_LOGe("failed: client %s, msg id: %d, msg size %zu, err %s, "
+                     "boot timestamp %" PRIu64" msec",
+                     mName.c_str(), msg.msgId, msg.payload->size(), strerror(errno),
+                     (ts.tv_sec * 1000ULL + ts.tv_nsec/1000000));
+
+            // purge this client, unless it is already on its way out
+            std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+            bool closed;
+            {
+                std::lock_guard<std::mutex> queueLock(mLock);
+                closed = mClosed;
+            }
+            if (!closed) {
+                LOC_LOGe("failed sent=%d purging client=%s", sent, mName.c_str());
+                mService->deleteClientbyName(mName);
+            }
+            return;
+        }
+    }
+}
+
+void LocHalOutboundQueue::close() {
+    std::lock_guard<std::mutex> lock(mLock);
+    mClosed = true;
+    mMsgs.clear();
+}
+
+void LocHalOutboundQueue::getStats(LocHalOutboundStats& stats) {
+    std::lock_guard<std::mutex> lock(mLock);
+    stats = mStats;
+    stats.depth = mMsgs.size();
+}
+
 static GeofenceBreachTypeMask parseClientGeofenceBreachType(GeofenceBreachType type);
 
 /******************************************************************************
@@ -46,6 +245,10 @@ void LocHalDaemonClientHandler::updateSubscription(uint32_t mask) {
 
     // update my subscription mask
     mSubscriptionMask = mask;
+    if (!(mask & E_LOC_CB_GNSS_NMEA_BUNDLE_BIT)) {
+        // a partial epoch is of no use once the session is over
+        mNmeaBundle.clear();
+    }
 
     // set callback functions for Location API
     mCallbacks.size = sizeof(mCallbacks);
@@ -364,7 +567,7 @@ void LocHalDaemonClientHandler::pingTest() {
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIPingTestIndMsg serializeToProtobuf failed");
@@ -373,12 +576,18 @@ void LocHalDaemonClientHandler::pingTest() {
 }
 
 void LocHalDaemonClientHandler::cleanup() {
-    // please do not attempt to hold the lock, as the caller of this function
-    // already holds the lock
-
-    // set the ptr to null to prevent further sending out message to the
-    // remote client that is no longer reachable
-    mIpcSender = nullptr;
+    // please do not attempt to hold the registry lock, as the caller of this
+    // function already holds it. The caller must not hold the client lock.
+
+    {
+        // set the ptr to null to prevent further sending out message to the
+        // remote client that is no longer reachable; a callback in progress
+        // finishes first
+        std::lock_guard<std::mutex> lock(mLock);
+        mOutbound->close();
+        mIpcSender = nullptr;
+        mSockSender = nullptr;
+    }
 
     if (0 != remove(mName.c_str())) {
         LOC_LOGw("<-- failed to remove file %s error %s", mName.c_str(), strerror(errno));
@@ -395,12 +604,78 @@ void LocHalDaemonClientHandler::cleanup() {
     }
 }
 
+shared_ptr<const string> LocHalDaemonClientHandler::serializeFlat(ELocMsgID msgId,
+        const void* payload, uint32_t payloadSize) {
+    shared_ptr<string> flatStr = std::make_shared<string>();
+    if (!LocAPIFlatMsgHeader::serialize(msgId, payload, payloadSize, *flatStr)) {
+        return nullptr;
+    }
+    return flatStr;
+}
+
+LocHalDaemonClientHandler::SerializeTimer::SerializeTimer(LocHalDaemonClientHandler& client) :
+        mClient(client) {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    mStartNs = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+LocHalDaemonClientHandler::SerializeTimer::~SerializeTimer() {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    mClient.mSerializeCount++;
+    mClient.mSerializeNs += ts.tv_sec * 1000000000ULL + ts.tv_nsec - mStartNs;
+}
+
+/******************************************************************************
+LocHalDaemonClientHandler - resource use
+******************************************************************************/
+void LocHalDaemonClientHandler::getStats(LocAPIClientStats& stats) {
+    LocHalOutboundStats outboundStats;
+    mOutbound->getStats(outboundStats);
+
+    memset(&stats, 0, sizeof(stats));
+    strlcpy(stats.clientName, mName.c_str(), sizeof(stats.clientName));
+    stats.msgsReceived = mMsgsReceived;
+    stats.bytesReceived = mBytesReceived;
+    stats.msgsSent = outboundStats.sent;
+    stats.bytesSent = outboundStats.bytesSent;
+    stats.serializeCount = mSerializeCount;
+    stats.serializeNs = mSerializeNs;
+    stats.queueDropped = outboundStats.dropped;
+    stats.queueCoalesced = outboundStats.coalesced;
+    stats.queueHighWater = outboundStats.highWater;
+    stats.trackingIntervalMs = (0 != mSessionId) ? mOptions.minInterval : 0;
+    stats.batchingIntervalMs = (0 != mBatchingId) ? mBatchOptions.minInterval : 0;
+    stats.geofenceCount = mGfIdsMap.size();
+    stats.batchedLocations = mBatchedLocations;
+}
+
+void LocHalDaemonClientHandler::sendClientStats(vector<LocAPIClientStats>&& clientStats) {
+    if (nullptr == mIpcSender) {
+        return;
+    }
+    string pbStr;
+    LocAPIGetClientStatsRespMsg msg(SERVICE_NAME, std::move(clientStats),
+                                    &mService->mPbufMsgConv);
+    if (msg.serializeToProtobuf(pbStr)) {
+        bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        // purge this client if failed
+        if (!rc) {
+            LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
+            mService->purgeClient(mName);
+        }
+    } else {
+        LOC_LOGe("LocAPIGetClientStatsRespMsg serializeToProtobuf failed");
+    }
+}
+
 /******************************************************************************
 LocHalDaemonClientHandler - Location API response callback functions
 ******************************************************************************/
 void LocHalDaemonClientHandler::onResponseCb(LocationError err, uint32_t id) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
 
     if (nullptr != mIpcSender) {
         LOC_LOGd("--< onResponseCb err=%u id=%u", err, id);
@@ -454,7 +729,7 @@ void LocHalDaemonClientHandler::onResponseCb(LocationError err, uint32_t id) {
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIGenericRespMsg serializeToProtobuf failed");
@@ -464,7 +739,7 @@ void LocHalDaemonClientHandler::onResponseCb(LocationError err, uint32_t id) {
 
 void LocHalDaemonClientHandler::onCollectiveResponseCallback(
         size_t count, LocationError *errs, uint32_t *ids) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onCollectiveResponseCallback");
 
     if (nullptr == mIpcSender) {
@@ -548,7 +823,7 @@ void LocHalDaemonClientHandler::onCollectiveResponseCallback(
         // purge this client if failed
         if (!rc) {
             LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-            mService->deleteClientbyName(mName);
+            mService->purgeClient(mName);
         }
     } else {
         LOC_LOGe("LocAPICollectiveRespMsg serializeToProtobuf failed");
@@ -573,7 +848,7 @@ void LocHalDaemonClientHandler::onControlResponseCb(LocationError err, ELocMsgID
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIGenericRespMsg serializeToProtobuf failed");
@@ -644,7 +919,7 @@ void LocHalDaemonClientHandler::onGnssConfigCb(ELocMsgID configMsgId,
         // purge this client if failed
         if (!rc) {
             LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-            mService->deleteClientbyName(mName);
+            mService->purgeClient(mName);
         }
     } else {
         LOC_LOGe("mIpcSender or msgStream is null!!");
@@ -656,13 +931,14 @@ LocHalDaemonClientHandler - Location API callback functions
 ******************************************************************************/
 void LocHalDaemonClientHandler::onCapabilitiesCallback(LocationCapabilitiesMask mask) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onCapabilitiesCallback=0x%" PRIx64, mask);
 
     if ((nullptr != mIpcSender) && (mask != mCapabilityMask)) {
         // broadcast
         string pbStr;
-        LocAPICapabilitiesIndMsg msg(SERVICE_NAME, mask, &mService->mPbufMsgConv);
+        LocAPICapabilitiesIndMsg msg(SERVICE_NAME, mask, &mService->mPbufMsgConv,
+                                     mClientToken);
         LOC_LOGd("mask old=0x%" PRIx64" new=0x%" PRIx64, mCapabilityMask, mask);
         mCapabilityMask = mask;
         if (msg.serializeToProtobuf(pbStr)) {
@@ -670,7 +946,7 @@ void LocHalDaemonClientHandler::onCapabilitiesCallback(LocationCapabilitiesMask
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPICapabilitiesIndMsg serializeToProtobuf failed");
@@ -683,20 +959,29 @@ void LocHalDaemonClientHandler::onCapabilitiesCallback(LocationCapabilitiesMask
 
 void LocHalDaemonClientHandler::onTrackingCb(Location location) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onTrackingCb");
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_DISTANCE_BASED_TRACKING_BIT)) {
+        SerializeTimer timer(*this);
         // broadcast
-        string pbStr;
-        LocAPILocationIndMsg msg(SERVICE_NAME, location, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        shared_ptr<const string> pbStr;
+        if (mFlatIndications) {
+            pbStr = serializeFlat(E_LOCAPI_LOCATION_MSG_ID, &location, sizeof(location));
+        } else {
+            pbStr = mService->serializeIndication(E_LOCAPI_LOCATION_MSG_ID,
+                    &location, sizeof(location), [this, &location] (string& payload) {
+                LocAPILocationIndMsg msg(SERVICE_NAME, location, &mService->mPbufMsgConv);
+                return msg.serializeToProtobuf(payload);
+            });
+        }
+        if (nullptr != pbStr) {
+            bool rc = sendMessage(pbStr, E_LOCAPI_LOCATION_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPILocationIndMsg serializeToProtobuf failed");
@@ -706,13 +991,15 @@ void LocHalDaemonClientHandler::onTrackingCb(Location location) {
 
 void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
         BatchingOptions batchOptions) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onBatchingCb");
 
     if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_BATCHING_BIT)) {
         if (0 == count) {
             return;
         }
+        SerializeTimer timer(*this);
+        mBatchedLocations += count;
 
         // serialize locations in batch into ipc message payload
         size_t msglen = sizeof(LocAPIBatchingIndMsg) + sizeof(Location) * (count - 1);
@@ -736,7 +1023,7 @@ void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIBatchingIndMsg serializeToProtobuf failed");
@@ -748,7 +1035,7 @@ void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
 
 void LocHalDaemonClientHandler::onBatchingStatusCb(BatchingStatusInfo batchingStatus,
                 std::list<uint32_t>& listOfCompletedTrips) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onBatchingStatusCb");
     if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_BATCHING_STATUS_BIT) &&
                 (BATCHING_MODE_TRIP == mBatchingMode) &&
@@ -763,7 +1050,7 @@ void LocHalDaemonClientHandler::onBatchingStatusCb(BatchingStatusInfo batchingSt
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIBatchingIndMsg serializeToProtobuf failed");
@@ -774,10 +1061,11 @@ void LocHalDaemonClientHandler::onBatchingStatusCb(BatchingStatusInfo batchingSt
 
 void LocHalDaemonClientHandler::onGeofenceBreachCb(GeofenceBreachNotification gfBreachNotif) {
     LOC_LOGd("--< onGeofenceBreachCallback");
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_GEOFENCE_BREACH_BIT)) {
+        SerializeTimer timer(*this);
 
         uint32_t* clientIds = getClientIds(gfBreachNotif.count, gfBreachNotif.ids);
         if (nullptr == clientIds) {
@@ -811,7 +1099,7 @@ void LocHalDaemonClientHandler::onGeofenceBreachCb(GeofenceBreachNotification gf
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIGeofenceBreachIndMsg serializeToProtobuf failed");
@@ -824,33 +1112,57 @@ void LocHalDaemonClientHandler::onGeofenceBreachCb(GeofenceBreachNotification gf
 
 void LocHalDaemonClientHandler::onGnssLocationInfoCb(GnssLocationInfoNotification notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onGnssLocationInfoCb");
 
     if ((nullptr != mIpcSender) && (mSubscriptionMask &
             (E_LOC_CB_GNSS_LOCATION_INFO_BIT | E_LOC_CB_SIMPLE_LOCATION_INFO_BIT))) {
+        SerializeTimer timer(*this);
         bool rc = false;
-        string pbStr;
         if (mSubscriptionMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT) {
-            LocAPILocationInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-            if (msg.serializeToProtobuf(pbStr)) {
-                rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            shared_ptr<const string> pbStr;
+            if (mFlatIndications) {
+                pbStr = serializeFlat(E_LOCAPI_LOCATION_INFO_MSG_ID,
+                                      &notification, sizeof(notification));
+            } else {
+                pbStr = mService->serializeIndication(E_LOCAPI_LOCATION_INFO_MSG_ID,
+                        &notification, sizeof(notification),
+                        [this, &notification] (string& payload) {
+                    LocAPILocationInfoIndMsg msg(SERVICE_NAME, notification,
+                                                 &mService->mPbufMsgConv);
+                    return msg.serializeToProtobuf(payload);
+                });
+            }
+            if (nullptr != pbStr) {
+                rc = sendMessage(pbStr, E_LOCAPI_LOCATION_INFO_MSG_ID);
                 // purge this client if failed
                 if (!rc) {
                     LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                    mService->deleteClientbyName(mName);
+                    mService->purgeClient(mName);
                 }
             } else {
                 LOC_LOGe("LocAPILocationInfoIndMsg serializeToProtobuf failed");
             }
         } else {
-            LocAPILocationIndMsg msg(SERVICE_NAME, notification.location, &mService->mPbufMsgConv);
-            if (msg.serializeToProtobuf(pbStr)) {
-                rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            shared_ptr<const string> pbStr;
+            if (mFlatIndications) {
+                pbStr = serializeFlat(E_LOCAPI_LOCATION_MSG_ID,
+                                      &notification.location, sizeof(notification.location));
+            } else {
+                pbStr = mService->serializeIndication(E_LOCAPI_LOCATION_MSG_ID,
+                        &notification.location, sizeof(notification.location),
+                        [this, &notification] (string& payload) {
+                    LocAPILocationIndMsg msg(SERVICE_NAME, notification.location,
+                                             &mService->mPbufMsgConv);
+                    return msg.serializeToProtobuf(payload);
+                });
+            }
+            if (nullptr != pbStr) {
+                rc = sendMessage(pbStr, E_LOCAPI_LOCATION_MSG_ID);
                 // purge this client if failed
                 if (!rc) {
                     LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                    mService->deleteClientbyName(mName);
+                    mService->purgeClient(mName);
                 }
             } else {
                 LOC_LOGe("LocAPILocationIndMsg serializeToProtobuf failed");
@@ -864,7 +1176,7 @@ void LocHalDaemonClientHandler::onEngLocationsInfoCb(
         GnssLocationInfoNotification* engLocationsInfoNotification
 ) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onEngLocationInfoCb count: %d, locReqEngTypeMask 0x%x",
              count, mOptions.locReqEngTypeMask);
 
@@ -890,16 +1202,23 @@ void LocHalDaemonClientHandler::onEngLocationsInfoCb(
         }
 
         if (reportCount > 0 ) {
-            string pbStr;
-            LocAPIEngineLocationsInfoIndMsg msg(SERVICE_NAME, reportCount,
-                                                engineLocationInfoNotification,
-                                                &mService->mPbufMsgConv);
-            if (msg.serializeToProtobuf(pbStr)) {
-                bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            SerializeTimer timer(*this);
+            // keyed by the engines this client asked for
+            auto pbStr = mService->serializeIndication(E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID,
+                    engineLocationInfoNotification,
+                    reportCount * sizeof(engineLocationInfoNotification[0]),
+                    [this, reportCount, &engineLocationInfoNotification] (string& payload) {
+                LocAPIEngineLocationsInfoIndMsg msg(SERVICE_NAME, reportCount,
+                                                    engineLocationInfoNotification,
+                                                    &mService->mPbufMsgConv);
+                return msg.serializeToProtobuf(payload);
+            });
+            if (nullptr != pbStr) {
+                bool rc = sendMessage(pbStr, E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID);
                 // purge this client if failed
                 if (!rc) {
                     LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                    mService->deleteClientbyName(mName);
+                    mService->purgeClient(mName);
                 }
             } else {
                 LOC_LOGe("LocAPIEngineLocationsInfoIndMsg serializeToProtobuf failed");
@@ -910,24 +1229,29 @@ void LocHalDaemonClientHandler::onEngLocationsInfoCb(
 
 void LocHalDaemonClientHandler::onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onGnssNiCb");
 }
 
 void LocHalDaemonClientHandler::onGnssSvCb(GnssSvNotification notification) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onGnssSvCb");
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_GNSS_SV_BIT)) {
+        SerializeTimer timer(*this);
         // broadcast
-        string pbStr;
-        LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+        auto pbStr = mService->serializeIndication(E_LOCAPI_SATELLITE_VEHICLE_MSG_ID,
+                &notification, sizeof(notification), [this, &notification] (string& payload) {
+            LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, notification,
+                                             &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(payload);
+        });
+        if (nullptr != pbStr) {
+            bool rc = sendMessage(pbStr, E_LOCAPI_SATELLITE_VEHICLE_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPISatelliteVehicleIndMsg serializeToProtobuf failed");
@@ -937,36 +1261,63 @@ void LocHalDaemonClientHandler::onGnssSvCb(GnssSvNotification notification) {
 
 void LocHalDaemonClientHandler::onGnssNmeaCb(GnssNmeaNotification notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_GNSS_NMEA_BIT)) {
         LOC_LOGd("--< onGnssNmeaCb[%s] t=%" PRIu64" l=%zu nmea=%s",
                 mName.c_str(),
                 notification.timestamp,
                 notification.length,
                 notification.nmea);
-        // serialize nmea string into ipc message payload
-        string nmeaStr(notification.nmea, notification.length);
-        LocAPINmeaIndMsg msg(SERVICE_NAME, &mService->mPbufMsgConv);
-        msg.gnssNmeaNotification.timestamp = notification.timestamp;
-        msg.gnssNmeaNotification.nmea = nmeaStr;
+        if (!(mSubscriptionMask & E_LOC_CB_GNSS_NMEA_BUNDLE_BIT)) {
+            sendNmea(notification.timestamp, string(notification.nmea, notification.length));
+            return;
+        }
 
-        string pbStr;
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), E_LOCAPI_NMEA_MSG_ID);
-            // purge this client if failed
-            if (!rc) {
-                LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
-            }
-        } else {
-            LOC_LOGe("LocAPINmeaIndMsg serializeToProtobuf failed");
+        // the GGA sentence loc_nmea_generate_pos() puts out last ends the
+        // epoch; the size bound covers a stream that has no GGA
+        if (mNmeaBundle.empty()) {
+            mNmeaBundleTimestamp = notification.timestamp;
+        }
+        mNmeaBundle.append(notification.nmea, notification.length);
+        if (!mNmeaBundle.empty() && mNmeaBundle.back() != '\n') {
+            mNmeaBundle += '\n';
+        }
+        if (nullptr != strstr(notification.nmea, "GGA,") ||
+                mNmeaBundle.size() >= LOC_HAL_NMEA_BUNDLE_MAX_SIZE) {
+            string bundle;
+            bundle.swap(mNmeaBundle);
+            sendNmea(mNmeaBundleTimestamp, bundle);
+        }
+    }
+}
+
+void LocHalDaemonClientHandler::sendNmea(uint64_t timestamp, const string& nmea) {
+    SerializeTimer timer(*this);
+    // serialize nmea string into ipc message payload
+    string key(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+    key += nmea;
+    auto pbStr = mService->serializeIndication(E_LOCAPI_NMEA_MSG_ID,
+            key.data(), key.size(), [this, timestamp, &nmea] (string& payload) {
+        LocAPINmeaIndMsg msg(SERVICE_NAME, &mService->mPbufMsgConv);
+        msg.gnssNmeaNotification.timestamp = timestamp;
+        msg.gnssNmeaNotification.nmea = nmea;
+        return msg.serializeToProtobuf(payload);
+    });
+    if (nullptr != pbStr) {
+        bool rc = sendMessage(pbStr, E_LOCAPI_NMEA_MSG_ID);
+        // purge this client if failed
+        if (!rc) {
+            LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
+            mService->purgeClient(mName);
         }
+    } else {
+        LOC_LOGe("LocAPINmeaIndMsg serializeToProtobuf failed");
     }
 }
 
 void LocHalDaemonClientHandler::onGnssDataCb(GnssDataNotification notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onGnssDataCb");
 
     if ((nullptr != mIpcSender) &&
@@ -982,15 +1333,19 @@ void LocHalDaemonClientHandler::onGnssDataCb(GnssDataNotification notification)
             }
         }
 
-        string pbStr;
-        LocAPIDataIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
+        SerializeTimer timer(*this);
+        auto pbStr = mService->serializeIndication(E_LOCAPI_DATA_MSG_ID,
+                &notification, sizeof(notification), [this, &notification] (string& payload) {
+            LocAPIDataIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(payload);
+        });
+        if (nullptr != pbStr) {
             LOC_LOGv("Sending data message");
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            bool rc = sendMessage(pbStr, E_LOCAPI_DATA_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIDataIndMsg serializeToProtobuf failed");
@@ -999,18 +1354,22 @@ void LocHalDaemonClientHandler::onGnssDataCb(GnssDataNotification notification)
 }
 
 void LocHalDaemonClientHandler::onGnssMeasurementsCb(GnssMeasurementsNotification notification) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onGnssMeasurementsCb");
     if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_GNSS_MEAS_BIT)) {
-        string pbStr;
-        LocAPIMeasIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
+        SerializeTimer timer(*this);
+        auto pbStr = mService->serializeIndication(E_LOCAPI_MEAS_MSG_ID,
+                &notification, sizeof(notification), [this, &notification] (string& payload) {
+            LocAPIMeasIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+            return msg.serializeToProtobuf(payload);
+        });
+        if (nullptr != pbStr) {
             LOC_LOGv("Sending meas message");
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
+            bool rc = sendMessage(pbStr, E_LOCAPI_MEAS_MSG_ID);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIMeasIndMsg serializeToProtobuf failed");
@@ -1020,11 +1379,12 @@ void LocHalDaemonClientHandler::onGnssMeasurementsCb(GnssMeasurementsNotificatio
 
 void LocHalDaemonClientHandler::onLocationSystemInfoCb(LocationSystemInfo notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onLocationSystemInfoCb");
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_SYSTEM_INFO_BIT)) {
+        SerializeTimer timer(*this);
         string pbStr;
         LocAPILocationSystemInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
         LOC_LOGv("Sending location system info message");
@@ -1033,7 +1393,7 @@ void LocHalDaemonClientHandler::onLocationSystemInfoCb(LocationSystemInfo notifi
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPILocationSystemInfoIndMsg serializeToProtobuf failed");
@@ -1043,6 +1403,10 @@ void LocHalDaemonClientHandler::onLocationSystemInfoCb(LocationSystemInfo notifi
 
 void LocHalDaemonClientHandler::onLocationApiDestroyCompleteCb() {
     std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    {
+        // let the callback in progress, if any, finish
+        std::lock_guard<std::mutex> clientLock(mLock);
+    }
 
     LOC_LOGe("delete LocHalDaemonClientHandler");
     delete this;
@@ -1067,7 +1431,7 @@ void LocHalDaemonClientHandler::onGnssEnergyConsumedInfoAvailable(
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                mService->purgeClient(mName);
             }
         } else {
             LOC_LOGe("LocAPIGnssEnergyConsumedIndMsg serializeToProtobuf failed");
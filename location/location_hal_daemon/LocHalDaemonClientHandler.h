@@ -30,6 +30,7 @@
 #define LOCHAL_CLIENT_HANDLER_H
 
 #include <queue>
+#include <deque>
 #include <mutex>
 #include <log_util.h>
 #include <loc_pla.h>
@@ -42,6 +43,7 @@
 
 #include <LocationAPI.h>
 #include <LocIpc.h>
+#include <MsgTask.h>
 #include <LocationApiPbMsgConv.h>
 
 using namespace loc_util;
@@ -49,6 +51,85 @@ using namespace loc_util;
 // forward declaration
 class LocationApiService;
 
+// What the outbound queue of a client does with an indication once the
+// client falls behind and the queue is full
+typedef enum {
+    // never dropped, e.g. responses; may take the queue over its depth
+    LOC_HAL_OUTBOUND_KEEP = 0,
+    // the oldest droppable message queued makes room for it
+    LOC_HAL_OUTBOUND_DROP_OLDEST = 1,
+    // replaces the message of the same id still queued, if any
+    LOC_HAL_OUTBOUND_COALESCE_LATEST = 2,
+} LocHalOutboundPolicy;
+
+typedef struct {
+    // default queue depth, in messages
+    uint32_t depth;
+    // position reports: location, location info and engine locations info
+    LocHalOutboundPolicy positionPolicy;
+    // SV and GNSS data reports
+    LocHalOutboundPolicy svPolicy;
+    // NMEA and measurements
+    LocHalOutboundPolicy streamPolicy;
+} LocHalOutboundConfig;
+
+typedef struct {
+    uint32_t depth;
+    uint32_t highWater;
+    uint64_t sent;
+    uint64_t bytesSent;
+    uint64_t dropped;
+    uint64_t coalesced;
+} LocHalOutboundStats;
+
+/******************************************************************************
+LocHalOutboundQueue
+******************************************************************************/
+// Bounded queue of the serialized messages to one client. Callbacks only
+// queue; a task of the client's own sends them, so that a client which
+// stalls its socket holds up no one but itself.
+class LocHalOutboundQueue : public std::enable_shared_from_this<LocHalOutboundQueue>
+{
+public:
+    LocHalOutboundQueue(LocationApiService* service, const std::string& clientName,
+                        const shared_ptr<LocIpcSender>& ipcSender);
+
+    static void setConfig(const LocHalOutboundConfig& config);
+
+    // false if the client is gone; a message dropped by its policy
+    // still counts as queued
+    bool push(ELocMsgID msgId, const char* msg, size_t msglen);
+    // same, for a payload that other clients may be given too
+    bool push(ELocMsgID msgId, const shared_ptr<const std::string>& payload);
+    // no more sends, the client is being deleted.
+    // Caller holds LocationApiService::mMutex.
+    void close();
+    void getStats(LocHalOutboundStats& stats);
+
+private:
+    struct OutboundMsg {
+        ELocMsgID msgId;
+        LocHalOutboundPolicy policy;
+        shared_ptr<const std::string> payload;
+    };
+
+    static LocHalOutboundPolicy getPolicy(ELocMsgID msgId);
+    void drain();
+
+    static LocHalOutboundConfig sConfig;
+
+    LocationApiService* mService;
+    const std::string mName;
+    shared_ptr<LocIpcSender> mIpcSender;
+
+    std::mutex mLock;
+    std::deque<OutboundMsg> mMsgs;
+    bool mDraining;
+    bool mClosed;
+    LocHalOutboundStats mStats;
+    MsgTask mMsgTask;
+};
+
 /******************************************************************************
 LocHalDaemonClientHandler
 ******************************************************************************/
@@ -56,24 +137,43 @@ class LocHalDaemonClientHandler
 {
 public:
     inline LocHalDaemonClientHandler(LocationApiService* service, const std::string& clientname,
-                                     ClientType clientType) :
+                                     ClientType clientType, uint32_t wireFormats = 0,
+                                     uint32_t clientToken = 0) :
                 mService(service),
                 mName(clientname),
                 mClientType(clientType),
+                mClientToken(clientToken),
+                mFlatIndications((wireFormats & LOCATION_REMOTE_API_WIRE_FORMAT_FLAT) &&
+                        SockNode::Local == SockNode::create(clientname).getNodeType()),
+                mLz4Msgs((wireFormats & LOCATION_REMOTE_API_WIRE_FORMAT_LZ4) &&
+                        SockNode::Local != SockNode::create(clientname).getNodeType()),
                 mCapabilityMask(0),
                 mTracking(false),
                 mBatching(false),
                 mSessionId(0),
                 mBatchingId(0),
                 mBatchingMode(BATCHING_MODE_NO_AUTO_REPORT),
+                mLivenessWatched(false),
                 mLocationApi(nullptr),
                 mCallbacks{},
                 mPendingMessages(),
                 mGfPendingMessages(),
+                mTrackingOptionsPending(false),
+                mPendingTrackingOptions{},
                 mSubscriptionMask(0),
                 mEngineInfoRequestMask(0),
+                mNmeaBundle(),
+                mNmeaBundleTimestamp(0),
+                mMsgsReceived(0),
+                mBytesReceived(0),
+                mSerializeCount(0),
+                mSerializeNs(0),
+                mBatchedLocations(0),
                 mGeofenceIds(nullptr),
-                mIpcSender(createSender(clientname.c_str())) {
+                mSockSender(createSender(clientname.c_str())),
+                mIpcSender(createShmSender(clientname, mSockSender)),
+                mOutbound(std::make_shared<LocHalOutboundQueue>(service, clientname,
+                                                                mIpcSender)) {
 
 
         if (mClientType == LOCATION_CLIENT_API) {
@@ -85,6 +185,8 @@ public:
     }
 
     static shared_ptr<LocIpcSender> createSender(const string socket);
+    static shared_ptr<LocIpcSender> createShmSender(const string socket,
+                                                    const shared_ptr<LocIpcSender>& sockSender);
     void cleanup();
 
     // public APIs
@@ -120,15 +222,42 @@ public:
     // send terrestrial fix to the requesting LCA client
     void sendTerrestrialFix(LocationError error, const Location& location);
 
-    inline shared_ptr<LocIpcSender> getIpcSender () {return mIpcSender;};
+    // the socket sender, so that a ping fails once the client is gone,
+    // even if indications take the shm ring
+    inline shared_ptr<LocIpcSender> getIpcSender () {return mSockSender;};
 
     void pingTest();
 
+    // Guards the state of this client. Location API callbacks take it on
+    // their own; the service takes it, after LocationApiService::mMutex,
+    // around everything else it does with this client.
+    inline std::mutex& getLock() {return mLock;};
+    inline void getOutboundStats(LocHalOutboundStats& stats) {mOutbound->getStats(stats);};
+    // resource use of this client. Caller holds LocationApiService::mMutex
+    // and the lock of this client.
+    void getStats(LocAPIClientStats& stats);
+    // a msg of this client came in. Caller holds LocationApiService::mMutex.
+    inline void onMsgReceived(uint32_t length) {
+        mMsgsReceived++;
+        mBytesReceived += length;
+    }
+    void sendClientStats(vector<LocAPIClientStats>&& clientStats);
+    inline const std::string& getName() const {return mName;};
+
+    // token the client sends in place of its socket name, 0 if none
+    const uint32_t mClientToken;
     bool mTracking;
     bool mBatching;
     BatchingMode mBatchingMode;
+    // the service learns of this client going away from the kernel, so
+    // the maintenance timer need not ping it
+    bool mLivenessWatched;
     std::queue<ELocMsgID> mPendingMessages;
     std::queue<ELocMsgID> mGfPendingMessages;
+    // tracking options update held back by the service, to be coalesced
+    // with the ones that follow it closely
+    bool mTrackingOptionsPending;
+    LocationOptions mPendingTrackingOptions;
 
 private:
     inline ~LocHalDaemonClientHandler() {}
@@ -149,21 +278,54 @@ private:
     void onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotification);
     void onGnssSvCb(GnssSvNotification gnssSvNotification);
     void onGnssNmeaCb(GnssNmeaNotification);
+    void sendNmea(uint64_t timestamp, const string& nmea);
     void onGnssDataCb(GnssDataNotification gnssDataNotification);
     void onGnssMeasurementsCb(GnssMeasurementsNotification gnssMeasurementsNotification);
     void onLocationSystemInfoCb(LocationSystemInfo);
     void onLocationApiDestroyCompleteCb();
 
-    // send ipc message to this client for serialized payload
+    // books the time an indication takes to serialize, compress and queue
+    // to this client, for the scope it is in. Caller holds mLock.
+    class SerializeTimer {
+    public:
+        SerializeTimer(LocHalDaemonClientHandler& client);
+        ~SerializeTimer();
+    private:
+        LocHalDaemonClientHandler& mClient;
+        uint64_t mStartNs;
+    };
+
+    // location indication in the flat wire format
+    shared_ptr<const string> serializeFlat(ELocMsgID msgId, const void* payload,
+                                           uint32_t payloadSize);
+
+    // queue ipc message to this client for serialized payload; the
+    // outbound queue sends it, and purges the client if that fails. Large
+    // msgs to a remote client that takes LZ4 are queued compressed
     bool sendMessage(const char* msg, size_t msglen, ELocMsgID msg_id) {
-        bool retVal= LocIpc::send(*mIpcSender, reinterpret_cast<const uint8_t*>(msg), msglen);
+        string lz4Str;
+        if (mLz4Msgs && LocAPILz4MsgHeader::compress(msg, msglen, lz4Str)) {
+            return pushMessage(make_shared<const string>(move(lz4Str)), msg_id);
+        }
+        bool retVal = mOutbound->push(msg_id, msg, msglen);
         if (retVal == false) {
-            struct timespec ts;
-            clock_gettime(CLOCK_BOOTTIME, &ts);
-            LOC_LOGe("failed: client %s, msg id: %d, msg size %d, err %s, "
-                     "boot timestamp %" PRIu64" msec",
-                     mName.c_str(), msg_id, msglen, strerror(errno),
-                     (ts.tv_sec * 1000ULL + ts.tv_nsec/1000000));
+            LOC_LOGe("failed: client %s, msg id: %d, msg size %zu, client is gone",
+                     mName.c_str(), msg_id, msglen);
+        }
+        return retVal;
+    }
+    bool sendMessage(const shared_ptr<const string>& msg, ELocMsgID msg_id) {
+        string lz4Str;
+        if (mLz4Msgs && LocAPILz4MsgHeader::compress(msg->data(), msg->size(), lz4Str)) {
+            return pushMessage(make_shared<const string>(move(lz4Str)), msg_id);
+        }
+        return pushMessage(msg, msg_id);
+    }
+    bool pushMessage(const shared_ptr<const string>& msg, ELocMsgID msg_id) {
+        bool retVal = mOutbound->push(msg_id, msg);
+        if (retVal == false) {
+            LOC_LOGe("failed: client %s, msg id: %d, msg size %zu, client is gone",
+                     mName.c_str(), msg_id, msg->size());
         }
         return retVal;
     }
@@ -173,9 +335,17 @@ private:
     // pointer to parent service
     LocationApiService* mService;
 
+    std::mutex mLock;
+
     // name of this client
     const std::string mName;
     ClientType mClientType;
+    // location indications go in the flat wire format, only ever to clients
+    // on this device
+    const bool mFlatIndications;
+    // msgs from LOCATION_REMOTE_API_LZ4_MIN_SIZE up go LZ4 compressed, only
+    // ever to clients on a remote node, where they cost more packets
+    const bool mLz4Msgs;
 
     // LocationAPI interface
     LocationCapabilitiesMask mCapabilityMask;
@@ -191,8 +361,22 @@ private:
     // bitmask to hold this client's request to engine info related subscription
     uint32_t mEngineInfoRequestMask;
 
+    // sentences of the current epoch, for a client that takes bundles
+    string mNmeaBundle;
+    uint64_t mNmeaBundleTimestamp;
+
+    // resource use of this client, see getStats(); the msgs received
+    // are counted under LocationApiService::mMutex, the rest under mLock
+    uint64_t mMsgsReceived;
+    uint64_t mBytesReceived;
+    uint64_t mSerializeCount;
+    uint64_t mSerializeNs;
+    uint64_t mBatchedLocations;
+
     uint32_t* mGeofenceIds;
+    shared_ptr<LocIpcSender> mSockSender;
     shared_ptr<LocIpcSender> mIpcSender;
+    shared_ptr<LocHalOutboundQueue> mOutbound;
     std::unordered_map<uint32_t, uint32_t> mGfIdsMap; //geofence ID map, clientId-->session
 };
 
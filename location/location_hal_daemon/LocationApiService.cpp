@@ -28,8 +28,12 @@
 
 #include <stdint.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <unistd.h>
 #include <dlfcn.h>
 #include <memory>
+#include <atomic>
 #include <SystemStatus.h>
 #include <LocationApiMsg.h>
 #include <gps_extended_c.h>
@@ -46,7 +50,11 @@ using namespace std;
 
 #define MAX_GEOFENCE_COUNT (20)
 #define MAINT_TIMER_INTERVAL_MSEC (60000)
+// client liveness check is not time critical, let it share a wakeup
+#define MAINT_TIMER_SLACK_MSEC (5000)
 #define AUTO_START_CLIENT_NAME "default"
+// the maintenance msg task only sees timer expiries and client cleanups
+#define LOC_HAL_DAEMON_MSG_TASK_RING_SIZE (64)
 
 typedef void* (getLocationInterface)();
 
@@ -120,19 +128,103 @@ public:
     }
 };
 
+/******************************************************************************
+LocHaldPidRecver
+******************************************************************************/
+// Watches the process of a local client through a pidfd, which becomes
+// readable once the process exits. Served by the ipc reactor, it then has
+// the service reap the client, and is dropped from the reactor.
+class LocHaldPidRecver : public LocIpcSender, public LocIpcRecver {
+    LocationApiService& mService;
+    const std::string mClientName;
+    const int mPidFd;
+protected:
+    inline virtual bool isOperable() const override { return mPidFd >= 0; }
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
+                                int32_t msgId) const override {
+        return -1;
+    }
+    inline virtual ssize_t recv() const override {
+        mService.onClientGone(mClientName);
+        return 0;
+    }
+public:
+    inline LocHaldPidRecver(LocationApiService& service, const std::string& clientName,
+                            int pidFd) :
+            LocIpcSender(), LocIpcRecver(make_shared<LocHaldIpcListener>(service), *this),
+            mService(service), mClientName(clientName), mPidFd(pidFd) {}
+    inline virtual ~LocHaldPidRecver() {
+        if (mPidFd >= 0) {
+            ::close(mPidFd);
+        }
+    }
+    inline virtual const char* getName() const override { return mClientName.c_str(); }
+    inline virtual int getRecvFd() const override { return mPidFd; }
+    inline virtual void abort() const override {}
+    inline virtual ssize_t peekRecv() const override {
+        struct pollfd pfd = { mPidFd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 0) > 0) {
+            return 0;
+        }
+        errno = EAGAIN;
+        return -1;
+    }
+
+    // -1 if the kernel has no pidfd, the caller then pings the client
+    static int openPidFd(pid_t pid) {
+#ifdef __NR_pidfd_open
+        return syscall(__NR_pidfd_open, pid, 0);
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+};
+
+/******************************************************************************
+LocHaldQrtrWatcher
+******************************************************************************/
+// Remote clients each bring up an instance of the client qrtr service; the
+// qrtr name service tells when one of them goes down.
+class LocHaldQrtrWatcher : public LocIpcQrtrWatcher {
+    LocationApiService& mService;
+public:
+    inline LocHaldQrtrWatcher(LocationApiService& service) :
+            LocIpcQrtrWatcher({LOCATION_CLIENT_API_QSOCKET_CLIENT_SERVICE_ID}),
+            mService(service) {}
+    inline virtual void onServiceStatusChange(int serviceId, int instanceId,
+            LocIpcQrtrWatcher::ServiceStatus status, const LocIpcSender& refSender) override {
+        mService.onQrtrClientStatusChange(instanceId,
+                LocIpcQrtrWatcher::ServiceStatus::UP == status);
+    }
+};
+
+static google::protobuf::ArenaOptions getDecodeArenaOptions(char* block, size_t size) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = size;
+    return options;
+}
+
 /******************************************************************************
 LocationApiService - constructors
 ******************************************************************************/
 LocationApiService::LocationApiService(const configParamToRead & configParamRead) :
 
+    mClientTokenGen(0),
+    mConfigBatchId(0),
+    mLastConfigBatchId(0),
     mLocationControlId(0),
     mAutoStartGnss(configParamRead.autoStartGnss),
     mPowerState(POWER_STATE_UNKNOWN),
     mPositionMode((GnssSuplMode)configParamRead.positionMode),
-    mMsgTask("LocHalDaemonMaintenanceMsgTask"),
+    mTrackingOptionsCoalesceMs(configParamRead.clientTrackingOptionsCoalesceMs),
+    mMsgTask("LocHalDaemonMaintenanceMsgTask", LOC_HAL_DAEMON_MSG_TASK_RING_SIZE,
+             MSG_TASK_OVERFLOW_SPILL, MSG_TASK_WAKEUP_EVENTFD),
     mMaintTimer(this),
     mGtpWwanSsLocationApi(nullptr),
-    mOptInTerrestrialService(-1)
+    mOptInTerrestrialService(-1),
+    mDecodeArena(getDecodeArenaOptions(mDecodeBlock, sizeof(mDecodeBlock)))
 #ifdef POWERMANAGER_ENABLED
     ,mPowerEventObserver(nullptr)
 #endif
@@ -143,6 +235,15 @@ LocationApiService::LocationApiService(const configParamToRead & configParamRead
     LOC_LOGd("DeleteAllBeforeAutoStart=%u", configParamRead.deleteAllBeforeAutoStart);
     LOC_LOGd("DeleteAllOnEnginesMask=%u", configParamRead.posEngineMask);
     LOC_LOGd("PositionMode=%u", configParamRead.positionMode);
+    LOC_LOGd("TrackingOptionsCoalesceMs=%u", mTrackingOptionsCoalesceMs);
+
+    LocHalOutboundConfig outboundConfig = {
+        configParamRead.clientOutboundQueueDepth,
+        (LocHalOutboundPolicy)configParamRead.clientOutboundPositionPolicy,
+        (LocHalOutboundPolicy)configParamRead.clientOutboundSvPolicy,
+        (LocHalOutboundPolicy)configParamRead.clientOutboundStreamPolicy
+    };
+    LocHalOutboundQueue::setConfig(outboundConfig);
 
     // create Location control API
     mControlCallabcks.size = sizeof(mControlCallabcks);
@@ -178,7 +279,7 @@ LocationApiService::LocationApiService(const configParamToRead & configParamRead
     }
 #endif
 
-    mMaintTimer.start(MAINT_TIMER_INTERVAL_MSEC, false);
+    mMaintTimer.start(MAINT_TIMER_INTERVAL_MSEC, false, MAINT_TIMER_SLACK_MSEC);
 
     // create a default client if enabled by config
     if (mAutoStartGnss) {
@@ -194,6 +295,7 @@ LocationApiService::LocationApiService(const configParamToRead & configParamRead
         LocHalDaemonClientHandler* pClient =
                 new LocHalDaemonClientHandler(this, AUTO_START_CLIENT_NAME, LOCATION_CLIENT_API);
         mClients.emplace(AUTO_START_CLIENT_NAME, pClient);
+        std::lock_guard<std::mutex> clientLock(pClient->getLock());
 
         pClient->updateSubscription(
                 E_LOC_CB_GNSS_LOCATION_INFO_BIT | E_LOC_CB_GNSS_SV_BIT);
@@ -214,18 +316,21 @@ LocationApiService::LocationApiService(const configParamToRead & configParamRead
     LOC_LOGd("Ready, start Ipc Receivers");
     auto recver = LocIpc::getLocIpcLocalRecver(make_shared<LocHaldLocalIpcListener>(*this),
             SOCKET_TO_LOCATION_HAL_DAEMON);
-    // blocking: set to false
-    mIpc.startNonBlockingListening(recver);
+    mIpcReactor.add(recver);
 
-    mBlockingRecver = LocIpc::getLocIpcQrtrRecver(make_shared<LocHaldIpcListener>(*this),
+    auto qrtrRecver = LocIpc::getLocIpcQrtrRecver(make_shared<LocHaldIpcListener>(*this),
             LOCATION_CLIENT_API_QSOCKET_HALDAEMON_SERVICE_ID,
-            LOCATION_CLIENT_API_QSOCKET_HALDAEMON_INSTANCE_ID);
-    mIpc.startBlockingListening(*mBlockingRecver);
+            LOCATION_CLIENT_API_QSOCKET_HALDAEMON_INSTANCE_ID,
+            make_shared<LocHaldQrtrWatcher>(*this));
+    mIpcReactor.add(qrtrRecver);
+    // timer and cleanup msgs run on this thread too, between client requests
+    mIpcReactor.addFd(mMsgTask.getEventFd(), [this] { mMsgTask.processPending(); }, &mMsgTask);
+    // blocking: serve both recvers and the msg task from this thread
+    mIpcReactor.startBlocking();
 }
 
 LocationApiService::~LocationApiService() {
-    mIpc.stopNonBlockingListening();
-    mIpc.stopBlockingListening(*mBlockingRecver);
+    mIpcReactor.stop();
 
     // free resource associated with the client
     for (auto each : mClients) {
@@ -241,382 +346,256 @@ LocationApiService::~LocationApiService() {
 /******************************************************************************
 LocationApiService - implementation - registration
 ******************************************************************************/
-void LocationApiService::processClientMsg(const char* data, uint32_t length) {
-
-    string mMsgData(data, length);
-
-    // parse received message
-    // Protobuff Encoding enabled, so we need to convert the message from proto
-    // encoded format to local structure
-    PBLocAPIMsgHeader pbLocApiMsg;
-    if (0 == pbLocApiMsg.ParseFromString(mMsgData)) {
-        LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u",
-                mMsgData.length());
-        return;
-    }
-
-    ELocMsgID eLocMsgid = mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
-    string sockName = pbLocApiMsg.msocketname();
-    uint32_t msgVer = pbLocApiMsg.msgversion();
-    uint32_t payloadSize = pbLocApiMsg.payloadsize();
-    // pbLocApiMsg.payload() contains the payload data.
-
-    LOC_LOGi(">-- onReceive Rcvd msg id: %d, remote client: %s, payload size: %d", eLocMsgid,
-            sockName.c_str(), payloadSize);
-    LocAPIMsgHeader locApiMsg(sockName.c_str(), eLocMsgid);
-
-    // throw away msg that does not come from location hal daemon client, e.g. LCA/LIA
-    if (false == locApiMsg.isValidClientMsg(payloadSize)) {
+// parses the payload of a client request into PbMsg on the decode arena,
+// converts it and hands it to the request function
+template <typename PbMsg, typename Msg, void (LocationApiService::*Fn)(Msg*)>
+void LocationApiService::decodeClientMsg(LocationApiService& service,
+        const LocAPIMsgHeader& header, const PBLocAPIMsgHeader& pbHeader) {
+    PbMsg* pbMsg = google::protobuf::Arena::CreateMessage<PbMsg>(&service.mDecodeArena);
+    if (0 == pbMsg->ParseFromString(pbHeader.payload())) {
+        LOC_LOGe("Failed to parse msg id %d from payload!!", header.msgId);
         return;
     }
+    typename std::remove_const<Msg>::type msg(header.mSocketName, *pbMsg,
+                                              &service.mPbufMsgConv);
+    msg.mClientToken = header.mClientToken;
+    (service.*Fn)(&msg);
+}
 
-    switch (eLocMsgid) {
-        case E_LOCAPI_CLIENT_REGISTER_MSG_ID: {
-            // new client
-            PBLocAPIClientRegisterReqMsg pbLocApiClientRegReqMsg;
-            if (0 == pbLocApiClientRegReqMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiClientRegReqMsg from payload!!");
-                return;
-            }
-            LocAPIClientRegisterReqMsg msg(pbLocApiMsg.msocketname().c_str(),
-                    pbLocApiClientRegReqMsg, &mPbufMsgConv);
-            newClient(reinterpret_cast<LocAPIClientRegisterReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_CLIENT_DEREGISTER_MSG_ID: {
-            // delete client
-            LocAPIClientDeregisterReqMsg msg(sockName.c_str(), &mPbufMsgConv);
-            deleteClient(reinterpret_cast<LocAPIClientDeregisterReqMsg*>(&msg));
-            break;
-        }
-
-        case E_LOCAPI_START_TRACKING_MSG_ID: {
-            // start
-            PBLocAPIStartTrackingReqMsg pbLocApiStartTrackMsg;
-            if (0 == pbLocApiStartTrackMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiStartTrackMsg from payload!!");
-                return;
-            }
-            LocAPIStartTrackingReqMsg msg(sockName.c_str(), pbLocApiStartTrackMsg, &mPbufMsgConv);
-            startTracking(reinterpret_cast<LocAPIStartTrackingReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_STOP_TRACKING_MSG_ID: {
-            // stop
-            LocAPIStopTrackingReqMsg msg(sockName.c_str(), &mPbufMsgConv);
-            stopTracking(reinterpret_cast<LocAPIStopTrackingReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_UPDATE_CALLBACKS_MSG_ID: {
-            // update subscription
-            PBLocAPIUpdateCallbacksReqMsg pbLocApiUpdateCbsReqMsg;
-            if (0 == pbLocApiUpdateCbsReqMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiUpdateCbsReqMsg from payload!!");
-                return;
-            }
-            LocAPIUpdateCallbacksReqMsg msg(sockName.c_str(), pbLocApiUpdateCbsReqMsg,
-                    &mPbufMsgConv);
-            updateSubscription(reinterpret_cast<LocAPIUpdateCallbacksReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID: {
-            PBLocAPIUpdateTrackingOptionsReqMsg pbLocApiUpdateTrackOptMsg;
-            if (0 == pbLocApiUpdateTrackOptMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiUpdateTrackOptMsg from payload!!");
-                return;
-            }
-            LocAPIUpdateTrackingOptionsReqMsg msg(sockName.c_str(), pbLocApiUpdateTrackOptMsg,
-                    &mPbufMsgConv);
-            updateTrackingOptions(reinterpret_cast <LocAPIUpdateTrackingOptionsReqMsg*>(&msg));
-            break;
-        }
-
-        case E_LOCAPI_START_BATCHING_MSG_ID: {
-            // start
-            PBLocAPIStartBatchingReqMsg pbLocApiStartBatchReq;
-            if (0 == pbLocApiStartBatchReq.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiStartBatchReq from payload!!");
-                return;
-            }
-            LocAPIStartBatchingReqMsg msg(sockName.c_str(), pbLocApiStartBatchReq, &mPbufMsgConv);
-            startBatching(reinterpret_cast<LocAPIStartBatchingReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_STOP_BATCHING_MSG_ID: {
-            // stop
-            LocAPIStopBatchingReqMsg msg(sockName.c_str(), &mPbufMsgConv);
-            stopBatching(reinterpret_cast<LocAPIStopBatchingReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID: {
-            PBLocAPIUpdateBatchingOptionsReqMsg pbLocApiUpdateBatch;
-            if (0 == pbLocApiUpdateBatch.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiUpdateBatch from payload!!");
-                return;
-            }
-            LocAPIUpdateBatchingOptionsReqMsg msg(sockName.c_str(), pbLocApiUpdateBatch,
-                    &mPbufMsgConv);
-            updateBatchingOptions(reinterpret_cast <LocAPIUpdateBatchingOptionsReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_ADD_GEOFENCES_MSG_ID: {
-            PBLocAPIAddGeofencesReqMsg pbLocApiAddGf;
-            if (0 == pbLocApiAddGf.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiAddGf from payload!!");
-                return;
-            }
-            LocAPIAddGeofencesReqMsg msg(sockName.c_str(), pbLocApiAddGf, &mPbufMsgConv);
-            addGeofences(reinterpret_cast<LocAPIAddGeofencesReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_REMOVE_GEOFENCES_MSG_ID: {
-            PBLocAPIRemoveGeofencesReqMsg pbLocApiRnGfReq;
-            if (0 == pbLocApiRnGfReq.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiRnGfReq from payload!!");
-                return;
-            }
-            LocAPIRemoveGeofencesReqMsg msg(sockName.c_str(), pbLocApiRnGfReq, &mPbufMsgConv);
-            removeGeofences(reinterpret_cast<LocAPIRemoveGeofencesReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_MODIFY_GEOFENCES_MSG_ID: {
-            PBLocAPIModifyGeofencesReqMsg pbLocApiModGf;
-            if (0 == pbLocApiModGf.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiModGf from payload!!");
-                return;
-            }
-            LocAPIModifyGeofencesReqMsg msg(sockName.c_str(), pbLocApiModGf, &mPbufMsgConv);
-            modifyGeofences(reinterpret_cast<LocAPIModifyGeofencesReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_PAUSE_GEOFENCES_MSG_ID: {
-            PBLocAPIPauseGeofencesReqMsg pbLocApiPauseGf;
-            if (0 == pbLocApiPauseGf.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiPauseGf from payload!!");
-                return;
-            }
-            LocAPIPauseGeofencesReqMsg msg(sockName.c_str(), pbLocApiPauseGf, &mPbufMsgConv);
-            pauseGeofences(reinterpret_cast<LocAPIPauseGeofencesReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_RESUME_GEOFENCES_MSG_ID: {
-            PBLocAPIResumeGeofencesReqMsg pbLocApiResumeGf;
-            if (0 == pbLocApiResumeGf.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiResumeGf from payload!!");
-                return;
-            }
-            LocAPIResumeGeofencesReqMsg msg(sockName.c_str(), pbLocApiResumeGf, &mPbufMsgConv);
-            resumeGeofences(reinterpret_cast<LocAPIResumeGeofencesReqMsg*>(&msg));
-            break;
-        }
-        case E_LOCAPI_CONTROL_UPDATE_NETWORK_AVAILABILITY_MSG_ID: {
-            PBLocAPIUpdateNetworkAvailabilityReqMsg pbLocApiUpdateNetwAvail;
-            if (0 == pbLocApiUpdateNetwAvail.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiUpdateNetwAvail from payload!!");
-                return;
-            }
-            LocAPIUpdateNetworkAvailabilityReqMsg msg(sockName.c_str(), pbLocApiUpdateNetwAvail,
-                    &mPbufMsgConv);
-            updateNetworkAvailability(msg.mAvailability);
-            break;
-        }
-        case E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID: {
-            getGnssEnergyConsumed(sockName.c_str());
-            break;
-        }
-        case E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_REQ_MSG_ID: {
-            PBLocAPIGetSingleTerrestrialPosReqMsg pbMsg;
-            if (0 == pbMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse PBLocAPIGetSingleTerrestrialPosReqMsg from payload!!");
-                return;
-            }
-            LocAPIGetSingleTerrestrialPosReqMsg msg(sockName.c_str(), pbMsg, &mPbufMsgConv);
-            getSingleTerrestrialPos(&msg);
-            break;
-        }
-        case E_LOCAPI_PINGTEST_MSG_ID: {
-            PBLocAPIPingTestReqMsg pbLocApiPingTestMsg;
-            if (0 == pbLocApiPingTestMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiPingTestMsg from payload!!");
-                return;
-            }
-            LocAPIPingTestReqMsg msg(sockName.c_str(), pbLocApiPingTestMsg, &mPbufMsgConv);
-            pingTest(reinterpret_cast<LocAPIPingTestReqMsg*>(&msg));
-            break;
-        }
-
-        // location configuration API
-        case E_INTAPI_CONFIG_CONSTRAINTED_TUNC_MSG_ID: {
-            PBLocConfigConstrainedTuncReqMsg pbLocApiConfConstrTunc;
-            if (0 == pbLocApiConfConstrTunc.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiConfConstrTunc from payload!!");
-                return;
-            }
-            LocConfigConstrainedTuncReqMsg msg(sockName.c_str(), pbLocApiConfConstrTunc,
-                    &mPbufMsgConv);
-            configConstrainedTunc(reinterpret_cast<LocConfigConstrainedTuncReqMsg*>(&msg));
-            break;
-        }
-
-        case E_INTAPI_CONFIG_POSITION_ASSISTED_CLOCK_ESTIMATOR_MSG_ID: {
-            PBLocConfigPositionAssistedClockEstimatorReqMsg pbLocApiConfPosAsstdClockEst;
-            if (0 == pbLocApiConfPosAsstdClockEst.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiConfPosAsstdClockEst from payload!!");
-                return;
-            }
-            LocConfigPositionAssistedClockEstimatorReqMsg msg(sockName.c_str(),
-                    pbLocApiConfPosAsstdClockEst, &mPbufMsgConv);
-            configPositionAssistedClockEstimator(reinterpret_cast
-                        <LocConfigPositionAssistedClockEstimatorReqMsg*>(&msg));
-            break;
-        }
-
-        case E_INTAPI_CONFIG_SV_CONSTELLATION_MSG_ID: {
-            PBLocConfigSvConstellationReqMsg pbLocApiConfSvConstReqMsg;
-            if (0 == pbLocApiConfSvConstReqMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocApiConfSvConstReqMsg from payload!!");
-                return;
-            }
-            LocConfigSvConstellationReqMsg msg(sockName.c_str(), pbLocApiConfSvConstReqMsg,
-                    &mPbufMsgConv);
-            configConstellations(reinterpret_cast<LocConfigSvConstellationReqMsg*>(&msg));
-            break;
-        }
-
-        case E_INTAPI_CONFIG_CONSTELLATION_SECONDARY_BAND_MSG_ID: {
-            PBLocConfigConstellationSecondaryBandReqMsg pbLocCfgConstlSecBandReqMsg;
-            if (0 == pbLocCfgConstlSecBandReqMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocCfgConstlSecBandReqMsg from payload!!");
-                return;
-            }
-            LocConfigConstellationSecondaryBandReqMsg msg(sockName.c_str(),
-                    pbLocCfgConstlSecBandReqMsg, &mPbufMsgConv);
-            configConstellationSecondaryBand(reinterpret_cast
-                    <LocConfigConstellationSecondaryBandReqMsg*>(&msg));
-            break;
-        }
+// same, for a client request without payload
+template <typename Msg, void (LocationApiService::*Fn)(Msg*)>
+void LocationApiService::dispatchClientMsg(LocationApiService& service,
+        const LocAPIMsgHeader& header, const PBLocAPIMsgHeader& pbHeader) {
+    Msg msg(header.mSocketName, &service.mPbufMsgConv);
+    msg.mClientToken = header.mClientToken;
+    (service.*Fn)(&msg);
+}
 
-        case E_INTAPI_CONFIG_AIDING_DATA_DELETION_MSG_ID: {
-            PBLocConfigAidingDataDeletionReqMsg pbLocConfAidDataDelMsg;
-            if (0 == pbLocConfAidDataDelMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocConfAidDataDelMsg from payload!!");
-                return;
-            }
-            LocConfigAidingDataDeletionReqMsg msg(sockName.c_str(), pbLocConfAidDataDelMsg,
-                    &mPbufMsgConv);
-            configAidingDataDeletion(reinterpret_cast<LocConfigAidingDataDeletionReqMsg*>(&msg));
-            break;
-        }
+const LocationApiService::ClientMsgDispatch LocationApiService::sClientMsgDispatch[] = {
+    {E_LOCAPI_CLIENT_REGISTER_MSG_ID,
+            &decodeClientMsg<PBLocAPIClientRegisterReqMsg, LocAPIClientRegisterReqMsg,
+                             &LocationApiService::newClient>},
+    {E_LOCAPI_CLIENT_DEREGISTER_MSG_ID,
+            &dispatchClientMsg<LocAPIClientDeregisterReqMsg, &LocationApiService::deleteClient>},
+
+    {E_LOCAPI_START_TRACKING_MSG_ID,
+            &decodeClientMsg<PBLocAPIStartTrackingReqMsg, LocAPIStartTrackingReqMsg,
+                             &LocationApiService::startTracking>},
+    {E_LOCAPI_STOP_TRACKING_MSG_ID,
+            &dispatchClientMsg<LocAPIStopTrackingReqMsg, &LocationApiService::stopTracking>},
+    {E_LOCAPI_UPDATE_CALLBACKS_MSG_ID,
+            &decodeClientMsg<PBLocAPIUpdateCallbacksReqMsg, LocAPIUpdateCallbacksReqMsg,
+                             &LocationApiService::updateSubscription>},
+    {E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID,
+            &decodeClientMsg<PBLocAPIUpdateTrackingOptionsReqMsg,
+                             LocAPIUpdateTrackingOptionsReqMsg,
+                             &LocationApiService::updateTrackingOptions>},
+
+    {E_LOCAPI_START_BATCHING_MSG_ID,
+            &decodeClientMsg<PBLocAPIStartBatchingReqMsg, LocAPIStartBatchingReqMsg,
+                             &LocationApiService::startBatching>},
+    {E_LOCAPI_STOP_BATCHING_MSG_ID,
+            &dispatchClientMsg<LocAPIStopBatchingReqMsg, &LocationApiService::stopBatching>},
+    {E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID,
+            &decodeClientMsg<PBLocAPIUpdateBatchingOptionsReqMsg,
+                             LocAPIUpdateBatchingOptionsReqMsg,
+                             &LocationApiService::updateBatchingOptions>},
+
+    {E_LOCAPI_ADD_GEOFENCES_MSG_ID,
+            &decodeClientMsg<PBLocAPIAddGeofencesReqMsg, LocAPIAddGeofencesReqMsg,
+                             &LocationApiService::addGeofences>},
+    {E_LOCAPI_REMOVE_GEOFENCES_MSG_ID,
+            &decodeClientMsg<PBLocAPIRemoveGeofencesReqMsg, LocAPIRemoveGeofencesReqMsg,
+                             &LocationApiService::removeGeofences>},
+    {E_LOCAPI_MODIFY_GEOFENCES_MSG_ID,
+            &decodeClientMsg<PBLocAPIModifyGeofencesReqMsg, LocAPIModifyGeofencesReqMsg,
+                             &LocationApiService::modifyGeofences>},
+    {E_LOCAPI_PAUSE_GEOFENCES_MSG_ID,
+            &decodeClientMsg<PBLocAPIPauseGeofencesReqMsg, LocAPIPauseGeofencesReqMsg,
+                             &LocationApiService::pauseGeofences>},
+    {E_LOCAPI_RESUME_GEOFENCES_MSG_ID,
+            &decodeClientMsg<PBLocAPIResumeGeofencesReqMsg, LocAPIResumeGeofencesReqMsg,
+                             &LocationApiService::resumeGeofences>},
+
+    {E_LOCAPI_CONTROL_UPDATE_NETWORK_AVAILABILITY_MSG_ID,
+            &decodeClientMsg<PBLocAPIUpdateNetworkAvailabilityReqMsg,
+                             LocAPIUpdateNetworkAvailabilityReqMsg,
+                             &LocationApiService::updateNetworkAvailability>},
+    {E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID,
+            [] (LocationApiService& service, const LocAPIMsgHeader& header,
+                const PBLocAPIMsgHeader& pbHeader) {
+        service.getGnssEnergyConsumed(header.mSocketName);
+    }},
+    {E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_REQ_MSG_ID,
+            &decodeClientMsg<PBLocAPIGetSingleTerrestrialPosReqMsg,
+                             LocAPIGetSingleTerrestrialPosReqMsg,
+                             &LocationApiService::getSingleTerrestrialPos>},
+    {E_LOCAPI_GET_CLIENT_STATS_REQ_MSG_ID,
+            [] (LocationApiService& service, const LocAPIMsgHeader& header,
+                const PBLocAPIMsgHeader& pbHeader) {
+        service.getClientStats(&header);
+    }},
+    {E_LOCAPI_PINGTEST_MSG_ID,
+            &decodeClientMsg<PBLocAPIPingTestReqMsg, LocAPIPingTestReqMsg,
+                             &LocationApiService::pingTest>},
+
+    // location configuration API
+    {E_INTAPI_CONFIG_CONSTRAINTED_TUNC_MSG_ID,
+            &decodeClientMsg<PBLocConfigConstrainedTuncReqMsg,
+                             const LocConfigConstrainedTuncReqMsg,
+                             &LocationApiService::configConstrainedTunc>},
+    {E_INTAPI_CONFIG_POSITION_ASSISTED_CLOCK_ESTIMATOR_MSG_ID,
+            &decodeClientMsg<PBLocConfigPositionAssistedClockEstimatorReqMsg,
+                             const LocConfigPositionAssistedClockEstimatorReqMsg,
+                             &LocationApiService::configPositionAssistedClockEstimator>},
+    {E_INTAPI_CONFIG_SV_CONSTELLATION_MSG_ID,
+            &decodeClientMsg<PBLocConfigSvConstellationReqMsg,
+                             const LocConfigSvConstellationReqMsg,
+                             &LocationApiService::configConstellations>},
+    {E_INTAPI_CONFIG_CONSTELLATION_SECONDARY_BAND_MSG_ID,
+            &decodeClientMsg<PBLocConfigConstellationSecondaryBandReqMsg,
+                             const LocConfigConstellationSecondaryBandReqMsg,
+                             &LocationApiService::configConstellationSecondaryBand>},
+    {E_INTAPI_CONFIG_AIDING_DATA_DELETION_MSG_ID,
+            &decodeClientMsg<PBLocConfigAidingDataDeletionReqMsg,
+                             LocConfigAidingDataDeletionReqMsg,
+                             &LocationApiService::configAidingDataDeletion>},
+    {E_INTAPI_CONFIG_LEVER_ARM_MSG_ID,
+            &decodeClientMsg<PBLocConfigLeverArmReqMsg, const LocConfigLeverArmReqMsg,
+                             &LocationApiService::configLeverArm>},
+    {E_INTAPI_CONFIG_ROBUST_LOCATION_MSG_ID,
+            &decodeClientMsg<PBLocConfigRobustLocationReqMsg,
+                             const LocConfigRobustLocationReqMsg,
+                             &LocationApiService::configRobustLocation>},
+    {E_INTAPI_CONFIG_MIN_GPS_WEEK_MSG_ID,
+            &decodeClientMsg<PBLocConfigMinGpsWeekReqMsg, const LocConfigMinGpsWeekReqMsg,
+                             &LocationApiService::configMinGpsWeek>},
+    {E_INTAPI_CONFIG_DEAD_RECKONING_ENGINE_MSG_ID,
+            &decodeClientMsg<PBLocConfigDrEngineParamsReqMsg,
+                             const LocConfigDrEngineParamsReqMsg,
+                             &LocationApiService::configDeadReckoningEngineParams>},
+    {E_INTAPI_CONFIG_MIN_SV_ELEVATION_MSG_ID,
+            &decodeClientMsg<PBLocConfigMinSvElevationReqMsg,
+                             const LocConfigMinSvElevationReqMsg,
+                             &LocationApiService::configMinSvElevation>},
+    {E_INTAPI_CONFIG_ENGINE_RUN_STATE_MSG_ID,
+            &decodeClientMsg<PBLocConfigEngineRunStateReqMsg,
+                             const LocConfigEngineRunStateReqMsg,
+                             &LocationApiService::configEngineRunState>},
+    {E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID,
+            &decodeClientMsg<PBLocConfigUserConsentTerrestrialPositioningReqMsg,
+                             LocConfigUserConsentTerrestrialPositioningReqMsg,
+                             &LocationApiService::configUserConsentTerrestrialPositioning>},
+    {E_INTAPI_CONFIG_BATCH_MSG_ID,
+            &decodeClientMsg<PBLocConfigBatchReqMsg, const LocConfigBatchReqMsg,
+                             &LocationApiService::configBatch>},
+
+    {E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID,
+            [] (LocationApiService& service, const LocAPIMsgHeader& header,
+                const PBLocAPIMsgHeader& pbHeader) {
+        service.getGnssConfig(&header, GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT);
+    }},
+    {E_INTAPI_GET_MIN_GPS_WEEK_REQ_MSG_ID,
+            [] (LocationApiService& service, const LocAPIMsgHeader& header,
+                const PBLocAPIMsgHeader& pbHeader) {
+        service.getGnssConfig(&header, GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT);
+    }},
+    {E_INTAPI_GET_MIN_SV_ELEVATION_REQ_MSG_ID,
+            [] (LocationApiService& service, const LocAPIMsgHeader& header,
+                const PBLocAPIMsgHeader& pbHeader) {
+        service.getGnssConfig(&header, GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT);
+    }},
+    {E_INTAPI_GET_CONSTELLATION_SECONDARY_BAND_CONFIG_REQ_MSG_ID,
+            [] (LocationApiService& service, const LocAPIMsgHeader& header,
+                const PBLocAPIMsgHeader& pbHeader) {
+        service.getConstellationSecondaryBandConfig(
+                (const LocConfigGetConstellationSecondaryBandConfigReqMsg*) &header);
+    }},
+};
 
-        case E_INTAPI_CONFIG_LEVER_ARM_MSG_ID: {
-            PBLocConfigLeverArmReqMsg pbLocConfLeverArmMsg;
-            if (0 == pbLocConfLeverArmMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocConfLeverArmMsg from payload!!");
-                return;
-            }
-            LocConfigLeverArmReqMsg msg(sockName.c_str(), pbLocConfLeverArmMsg, &mPbufMsgConv);
-            configLeverArm(reinterpret_cast<LocConfigLeverArmReqMsg*>(&msg));
-            break;
-        }
+static inline uint64_t getBootTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
-        case E_INTAPI_CONFIG_ROBUST_LOCATION_MSG_ID: {
-            PBLocConfigRobustLocationReqMsg pbLocConfRobustLocMsg;
-            if (0 == pbLocConfRobustLocMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocConfRobustLocMsg from payload!!");
-                return;
-            }
-            LocConfigRobustLocationReqMsg msg(sockName.c_str(), pbLocConfRobustLocMsg,
-                    &mPbufMsgConv);
-            configRobustLocation(reinterpret_cast<LocConfigRobustLocationReqMsg*>(&msg));
-            break;
-        }
+void LocationApiService::processClientMsg(const char* data, uint32_t length) {
 
-        case E_INTAPI_CONFIG_MIN_GPS_WEEK_MSG_ID: {
-            PBLocConfigMinGpsWeekReqMsg pbLocConfMinGpsWeek;
-            if (0 == pbLocConfMinGpsWeek.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocConfMinGpsWeek from payload!!");
-                return;
-            }
-            LocConfigMinGpsWeekReqMsg msg(sockName.c_str(), pbLocConfMinGpsWeek, &mPbufMsgConv);
-            configMinGpsWeek(reinterpret_cast<LocConfigMinGpsWeekReqMsg*>(&msg));
-            break;
-        }
+    uint64_t startNs = getBootTimeNs();
 
-        case E_INTAPI_CONFIG_DEAD_RECKONING_ENGINE_MSG_ID: {
-            PBLocConfigDrEngineParamsReqMsg pbLocCfgDrEngParamReq;
-            if (0 == pbLocCfgDrEngParamReq.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocCfgDrEngParamReq from payload!!");
-                return;
-            }
-            LocConfigDrEngineParamsReqMsg msg(sockName.c_str(), pbLocCfgDrEngParamReq,
-                    &mPbufMsgConv);
-            configDeadReckoningEngineParams(
-                    reinterpret_cast<LocConfigDrEngineParamsReqMsg*>(&msg));
-            break;
-        }
+    // parse received message
+    // Protobuff Encoding enabled, so we need to convert the message from proto
+    // encoded format to local structure. The msgs are decoded on mDecodeArena,
+    // all on the reactor thread, and the arena is reset once a msg is done.
+    PBLocAPIMsgHeader* pbLocApiMsg =
+            google::protobuf::Arena::CreateMessage<PBLocAPIMsgHeader>(&mDecodeArena);
+    if (0 == pbLocApiMsg->ParseFromArray(data, length)) {
+        LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u", length);
+        mDecodeArena.Reset();
+        return;
+    }
 
-        case E_INTAPI_CONFIG_MIN_SV_ELEVATION_MSG_ID: {
-            PBLocConfigMinSvElevationReqMsg pbLocConfMinSvElev;
-            if (0 == pbLocConfMinSvElev.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocConfMinSvElev from payload!!");
-                return;
-            }
-            LocConfigMinSvElevationReqMsg msg(sockName.c_str(), pbLocConfMinSvElev, &mPbufMsgConv);
-            configMinSvElevation(reinterpret_cast<LocConfigMinSvElevationReqMsg*>(&msg));
-            break;
-        }
+    ELocMsgID eLocMsgid = mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg->msgid());
+    uint32_t clientToken = pbLocApiMsg->mclienttoken();
+    uint32_t payloadSize = pbLocApiMsg->payloadsize();
+    // pbLocApiMsg->payload() contains the payload data.
 
-        case E_INTAPI_CONFIG_ENGINE_RUN_STATE_MSG_ID: {
-            PBLocConfigEngineRunStateReqMsg pbLocConfEngineRunState;
-            if (0 == pbLocConfEngineRunState.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse pbLocConfEngineRunState from payload!!");
-                return;
-            }
-            LocConfigEngineRunStateReqMsg msg(sockName.c_str(),
-                                              pbLocConfEngineRunState,
-                                              &mPbufMsgConv);
-            configEngineRunState(reinterpret_cast<LocConfigEngineRunStateReqMsg*>(&msg));
-            break;
+    LocAPIMsgHeader locApiMsg(pbLocApiMsg->msocketname().c_str(), eLocMsgid);
+    if (0 != clientToken) {
+        // a registered client sends its token only, the requests that keep
+        // the client name are given it from here
+        std::lock_guard<std::mutex> lock(mMutex);
+        LocHalDaemonClientHandler* pClient = getClientByToken(clientToken);
+        if (nullptr == pClient) {
+            mDecodeArena.Reset();
+            return;
         }
-
-        case E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID: {
-            PBLocConfigUserConsentTerrestrialPositioningReqMsg pbMsg;
-            if (0 == pbMsg.ParseFromString(pbLocApiMsg.payload())) {
-                LOC_LOGe("Failed to parse PBLocConfigUserConsentTerrestrialPositioningReqMsg!!");
-                return;
-            }
-            LocConfigUserConsentTerrestrialPositioningReqMsg msg(
-                    sockName.c_str(), pbMsg, &mPbufMsgConv);
-            configUserConsentTerrestrialPositioning(reinterpret_cast
-                    <LocConfigUserConsentTerrestrialPositioningReqMsg*>(&msg));
-            break;
+        strlcpy(locApiMsg.mSocketName, pClient->getName().c_str(),
+                MAX_SOCKET_PATHNAME_LENGTH);
+        locApiMsg.mClientToken = clientToken;
+        pClient->onMsgReceived(length);
+    } else {
+        // the msgs of a client not yet registered are not counted
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto client = mClients.find(locApiMsg.mSocketName);
+        if (client != mClients.end()) {
+            client->second->onMsgReceived(length);
         }
+    }
 
-        case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID: {
-            getGnssConfig(&locApiMsg, GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT);
-            break;
-        }
+    LOC_LOGi(">-- onReceive Rcvd msg id: %d, remote client: %s, token: 0x%x, payload size: %d",
+            eLocMsgid, locApiMsg.mSocketName, clientToken, payloadSize);
 
-        case E_INTAPI_GET_MIN_GPS_WEEK_REQ_MSG_ID: {
-            getGnssConfig(&locApiMsg, GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT);
-            break;
-        }
+    // throw away msg that does not come from location hal daemon client, e.g. LCA/LIA
+    if (false == locApiMsg.isValidClientMsg(payloadSize)) {
+        mDecodeArena.Reset();
+        return;
+    }
 
-        case E_INTAPI_GET_MIN_SV_ELEVATION_REQ_MSG_ID: {
-            getGnssConfig(&locApiMsg, GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT);
+    const ClientMsgDispatch* dispatch = nullptr;
+    for (const ClientMsgDispatch& entry : sClientMsgDispatch) {
+        if (entry.msgId == eLocMsgid) {
+            dispatch = &entry;
             break;
         }
+    }
+    if (nullptr == dispatch) {
+        LOC_LOGe("Unknown message with id: %d ", eLocMsgid);
+        mDecodeArena.Reset();
+        return;
+    }
 
-        case E_INTAPI_GET_CONSTELLATION_SECONDARY_BAND_CONFIG_REQ_MSG_ID: {
-            getConstellationSecondaryBandConfig(
-                    (const LocConfigGetConstellationSecondaryBandConfigReqMsg*) &locApiMsg);
-            break;
-        }
+    dispatch->handler(*this, locApiMsg, *pbLocApiMsg);
+    mDecodeArena.Reset();
 
-        default: {
-            LOC_LOGe("Unknown message with id: %d ", eLocMsgid);
-            break;
-        }
+    uint64_t procNs = getBootTimeNs() - startNs;
+    LOC_LOGv("msg id %d processed in %" PRIu64 " ns", eLocMsgid, procNs);
+    std::lock_guard<std::mutex> lock(mClientMsgStatsLock);
+    ClientMsgStats& stats = mClientMsgStats[eLocMsgid];
+    stats.count++;
+    stats.totalNs += procNs;
+    if (procNs > stats.maxNs) {
+        stats.maxNs = procNs;
     }
 }
 
@@ -635,15 +614,118 @@ void LocationApiService::newClient(LocAPIClientRegisterReqMsg *pMsg) {
     }
 
     // store it in client property database
+    uint32_t clientToken = allocClientToken();
     LocHalDaemonClientHandler *pClient =
-            new LocHalDaemonClientHandler(this, clientname, pMsg->mClientType);
+            new LocHalDaemonClientHandler(this, clientname, pMsg->mClientType,
+                                          pMsg->mWireFormats, clientToken);
     if (!pClient) {
         LOC_LOGe("failed to register client=%s", clientname.c_str());
+        releaseClientToken(clientToken);
         return;
     }
 
     mClients.emplace(clientname, pClient);
-    LOC_LOGi(">-- registered new client=%s", clientname.c_str());
+    if (0 != clientToken) {
+        mClientSlots[(clientToken & CLIENT_TOKEN_SLOT_MASK) - 1].client = pClient;
+    }
+    watchClient(pClient, clientname);
+    LOC_LOGi(">-- registered new client=%s, token 0x%x", clientname.c_str(), clientToken);
+}
+
+// no need to hold the lock as lock has been held on calling functions
+uint32_t LocationApiService::allocClientToken() {
+    uint32_t slot;
+    if (!mFreeClientSlots.empty()) {
+        slot = mFreeClientSlots.back();
+        mFreeClientSlots.pop_back();
+    } else if (mClientSlots.size() < CLIENT_TOKEN_SLOT_MASK) {
+        slot = mClientSlots.size();
+        mClientSlots.push_back({0, nullptr});
+    } else {
+        // the client goes by its socket name then
+        LOC_LOGw("out of client tokens");
+        return 0;
+    }
+    mClientTokenGen++;
+    uint32_t clientToken = (mClientTokenGen << 16) | (slot + 1);
+    mClientSlots[slot] = {clientToken, nullptr};
+    return clientToken;
+}
+
+// no need to hold the lock as lock has been held on calling functions
+void LocationApiService::releaseClientToken(uint32_t clientToken) {
+    uint32_t slot = (clientToken & CLIENT_TOKEN_SLOT_MASK) - 1;
+    if (slot < mClientSlots.size() && mClientSlots[slot].token == clientToken) {
+        mClientSlots[slot] = {0, nullptr};
+        mFreeClientSlots.push_back(slot);
+    }
+}
+
+// no need to hold the lock as lock has been held on calling functions
+void LocationApiService::watchClient(LocHalDaemonClientHandler* pClient,
+                                     const std::string& clientname) {
+    SockNode sockNode(SockNode::create(clientname));
+    switch (sockNode.getNodeType()) {
+    case SockNode::Local: {
+        // the local socket name carries the pid of the client
+        int pidFd = LocHaldPidRecver::openPidFd(sockNode.getId1());
+        if (pidFd < 0) {
+            LOC_LOGw("no pidfd for client=%s, reason: %s", clientname.c_str(),
+                     strerror(errno));
+            break;
+        }
+        unique_ptr<LocIpcRecver> recver(new LocHaldPidRecver(*this, clientname, pidFd));
+        pClient->mLivenessWatched = mIpcReactor.add(recver);
+        break;
+    }
+    case SockNode::Eap:
+        // watched only once the name service has told its instance is up
+        pClient->mLivenessWatched = (sockNode.getId1() ==
+                LOCATION_CLIENT_API_QSOCKET_CLIENT_SERVICE_ID &&
+                mQrtrClientsUp.find(sockNode.getId2()) != mQrtrClientsUp.end());
+        break;
+    default:
+        break;
+    }
+}
+
+void LocationApiService::onClientGone(const std::string& clientName) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // the client may have deregistered already
+    if (mClients.find(clientName) != mClients.end()) {
+        LOC_LOGi("--< process of client %s exited", clientName.c_str());
+        deleteClientbyName(clientName);
+    }
+}
+
+void LocationApiService::onQrtrClientStatusChange(int instanceId, bool up) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    LOC_LOGd("client qrtr instance %d %s", instanceId, up ? "up" : "down");
+
+    if (up) {
+        mQrtrClientsUp.insert(instanceId);
+    } else {
+        mQrtrClientsUp.erase(instanceId);
+    }
+
+    std::vector<std::string> clientsGone;
+    for (auto client : mClients) {
+        SockNode sockNode(SockNode::create(client.first));
+        if (SockNode::Eap == sockNode.getNodeType() &&
+                LOCATION_CLIENT_API_QSOCKET_CLIENT_SERVICE_ID == sockNode.getId1() &&
+                instanceId == sockNode.getId2()) {
+            if (up) {
+                std::lock_guard<std::mutex> clientLock(client.second->getLock());
+                client.second->mLivenessWatched = true;
+            } else {
+                clientsGone.push_back(client.first);
+            }
+        }
+    }
+    for (auto& clientName : clientsGone) {
+        LOC_LOGi("--< qrtr service of client %s went down", clientName.c_str());
+        deleteClientbyName(clientName);
+    }
 }
 
 void LocationApiService::deleteClient(LocAPIClientDeregisterReqMsg *pMsg) {
@@ -664,20 +746,32 @@ void LocationApiService::deleteClientbyName(const std::string clientname) {
         return;
     }
     mClients.erase(clientname);
+    releaseClientToken(pClient->mClientToken);
     mTerrestrialFixReqs.erase(clientname);
+    mTrackingOptionsReqs.erase(clientname);
     pClient->cleanup();
 }
+void LocationApiService::purgeClient(const std::string& clientname) {
+    // the caller may hold the client lock, which must not be held
+    // while taking mMutex
+    mMsgTask.sendMsg([this, clientname] {
+        std::lock_guard<std::mutex> lock(mMutex);
+        deleteClientbyName(clientname);
+    });
+}
+
 /******************************************************************************
 LocationApiService - implementation - tracking
 ******************************************************************************/
 void LocationApiService::startTracking(LocAPIStartTrackingReqMsg *pMsg) {
 
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- start invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
 
     LocationOptions locationOption = pMsg->locOptions;
     // set the mode according to the master position mode
@@ -698,11 +792,20 @@ void LocationApiService::startTracking(LocAPIStartTrackingReqMsg *pMsg) {
 void LocationApiService::stopTracking(LocAPIStopTrackingReqMsg *pMsg) {
 
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- stop invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
+
+    // a held back tracking options update is superseded by the stop
+    mTrackingOptionsReqs.erase(std::string(pMsg->mSocketName));
+    if (pClient->mTrackingOptionsPending) {
+        pClient->mTrackingOptionsPending = false;
+        pClient->onControlResponseCb(LOCATION_ERROR_SUCCESS,
+                E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID);
+    }
 
     pClient->mTracking = false;
     pClient->unsubscribeLocationSessionCb();
@@ -713,9 +816,21 @@ void LocationApiService::stopTracking(LocAPIStopTrackingReqMsg *pMsg) {
 
 // no need to hold the lock as lock has been held on calling functions
 void LocationApiService::suspendAllTrackingSessions() {
+    // one engine stop for all sessions, which the adapter keeps meanwhile,
+    // instead of a stop per client
+    GnssInterface* gnssInterface = getGnssInterface();
+    if (nullptr != gnssInterface && nullptr != gnssInterface->suspendTracking) {
+        LOC_LOGi("--> suspend all tracking sessions");
+        gnssInterface->suspendTracking(true);
+        return;
+    }
     for (auto client : mClients) {
+        if (nullptr == client.second) {
+            continue;
+        }
+        std::lock_guard<std::mutex> clientLock(client.second->getLock());
         // stop session if running
-        if (client.second && client.second->mTracking) {
+        if (client.second->mTracking) {
             client.second->stopTracking();
             client.second->mPendingMessages.push(E_LOCAPI_STOP_TRACKING_MSG_ID);
             LOC_LOGi("--> suspended");
@@ -725,9 +840,19 @@ void LocationApiService::suspendAllTrackingSessions() {
 
 // no need to hold the lock as lock has been held on calling functions
 void LocationApiService::resumeAllTrackingSessions() {
+    GnssInterface* gnssInterface = getGnssInterface();
+    if (nullptr != gnssInterface && nullptr != gnssInterface->suspendTracking) {
+        LOC_LOGi("--> resume all tracking sessions");
+        gnssInterface->suspendTracking(false);
+        return;
+    }
     for (auto client : mClients) {
+        if (nullptr == client.second) {
+            continue;
+        }
+        std::lock_guard<std::mutex> clientLock(client.second->getLock());
         // start session if not running
-        if (client.second && client.second->mTracking) {
+        if (client.second->mTracking) {
 
             // resume session with preserved options
             if (!client.second->startTracking()) {
@@ -744,11 +869,12 @@ void LocationApiService::resumeAllTrackingSessions() {
 void LocationApiService::updateSubscription(LocAPIUpdateCallbacksReqMsg *pMsg) {
 
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- updateSubscription invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
 
     pClient->updateSubscription(pMsg->locationCallbacks);
 
@@ -760,18 +886,62 @@ void LocationApiService::updateTrackingOptions(LocAPIUpdateTrackingOptionsReqMsg
 
     std::lock_guard<std::mutex> lock(mMutex);
 
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (pClient) {
+        std::lock_guard<std::mutex> clientLock(pClient->getLock());
         LocationOptions locationOption = pMsg->locOptions;
         // set the mode according to the master position mode
         locationOption.mode = mPositionMode;
-        pClient->updateTrackingOptions(locationOption);
-        pClient->mPendingMessages.push(E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID);
+
+        if (0 == mTrackingOptionsCoalesceMs) {
+            pClient->updateTrackingOptions(locationOption);
+            pClient->mPendingMessages.push(E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID);
+        } else {
+            // hold the update back for the coalescing window; an update
+            // already held back is superseded and answered right away
+            if (pClient->mTrackingOptionsPending) {
+                LOC_LOGd(">-- update tracking options superseded, client=%s",
+                         pMsg->mSocketName);
+                pClient->onControlResponseCb(LOCATION_ERROR_SUCCESS,
+                        E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID);
+            }
+            pClient->mTrackingOptionsPending = true;
+            pClient->mPendingTrackingOptions = locationOption;
+
+            // the window opens with the first update held back and is
+            // not extended by the later ones
+            std::string clientName(pMsg->mSocketName);
+            if (mTrackingOptionsReqs.find(clientName) == mTrackingOptionsReqs.end()) {
+                mTrackingOptionsReqs.emplace(std::piecewise_construct,
+                                             std::forward_as_tuple(clientName),
+                                             std::forward_as_tuple(this, clientName));
+                auto it = mTrackingOptionsReqs.find(clientName);
+                if (it != mTrackingOptionsReqs.end()) {
+                    it->second.start(mTrackingOptionsCoalesceMs, false);
+                }
+            }
+        }
     }
 
     LOC_LOGi(">-- update tracking options");
 }
 
+void LocationApiService::applyTrackingOptions(const std::string& clientName) {
+    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+
+    mTrackingOptionsReqs.erase(clientName);
+    LocHalDaemonClientHandler* pClient = getClient(clientName);
+    if (pClient) {
+        std::lock_guard<std::mutex> clientLock(pClient->getLock());
+        if (pClient->mTrackingOptionsPending) {
+            LOC_LOGd("apply tracking options for client %s", clientName.c_str());
+            pClient->mTrackingOptionsPending = false;
+            pClient->updateTrackingOptions(pClient->mPendingTrackingOptions);
+            pClient->mPendingMessages.push(E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID);
+        }
+    }
+}
+
 void LocationApiService::updateNetworkAvailability(bool availability) {
 
     LOC_LOGi(">-- updateNetworkAvailability=%u", availability);
@@ -798,7 +968,7 @@ void LocationApiService::getGnssEnergyConsumed(const char* clientSocketName) {
 
     std::lock_guard<std::mutex> lock(mMutex);
     bool requestAlreadyPending = false;
-    for (auto each : mClients) {
+    for (auto& each : mClients) {
         if ((each.second != nullptr) &&
             (each.second->hasPendingEngineInfoRequest(E_ENGINE_INFO_CB_GNSS_ENERGY_CONSUMED_BIT))) {
             requestAlreadyPending = true;
@@ -809,6 +979,7 @@ void LocationApiService::getGnssEnergyConsumed(const char* clientSocketName) {
     std::string clientname(clientSocketName);
     LocHalDaemonClientHandler* pClient = getClient(clientname);
     if (pClient) {
+        std::lock_guard<std::mutex> clientLock(pClient->getLock());
         pClient->addEngineInfoRequst(E_ENGINE_INFO_CB_GNSS_ENERGY_CONSUMED_BIT);
 
         // this is first client coming to request GNSS energy consumed
@@ -826,6 +997,53 @@ void LocationApiService::getGnssEnergyConsumed(const char* clientSocketName) {
     }
 }
 
+/******************************************************************************
+LocationApiService - resource use of the clients
+******************************************************************************/
+void LocationApiService::getClientStats(const LocAPIMsgHeader* pReqMsg) {
+
+    LOC_LOGi(">-- getClientStats by=%s", pReqMsg->mSocketName);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientHandler* pClient = getClient(pReqMsg);
+    if (nullptr == pClient) {
+        return;
+    }
+
+    vector<LocAPIClientStats> clientStats(mClients.size());
+    size_t i = 0;
+    for (auto& each : mClients) {
+        std::lock_guard<std::mutex> clientLock(each.second->getLock());
+        each.second->getStats(clientStats[i++]);
+    }
+
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
+    pClient->sendClientStats(std::move(clientStats));
+}
+
+void LocationApiService::dumpClientStats(string& out) {
+    char line[512];
+    for (auto& each : mClients) {
+        LocAPIClientStats stats;
+        {
+            std::lock_guard<std::mutex> clientLock(each.second->getLock());
+            each.second->getStats(stats);
+        }
+        snprintf(line, sizeof(line),
+                 "client %s: rx %" PRIu64 " msgs %" PRIu64 " bytes, tx %" PRIu64 " msgs %"
+                 PRIu64 " bytes, serialize %" PRIu64 " x %" PRIu64 " ns avg, queue dropped %"
+                 PRIu64 " coalesced %" PRIu64 " high water %u, tracking %u ms, "
+                 "batching %u ms %" PRIu64 " locations, geofences %u\n",
+                 stats.clientName, stats.msgsReceived, stats.bytesReceived,
+                 stats.msgsSent, stats.bytesSent, stats.serializeCount,
+                 (0 != stats.serializeCount) ? stats.serializeNs / stats.serializeCount : 0,
+                 stats.queueDropped, stats.queueCoalesced, stats.queueHighWater,
+                 stats.trackingIntervalMs, stats.batchingIntervalMs,
+                 stats.batchedLocations, stats.geofenceCount);
+        out += line;
+    }
+}
+
 void LocationApiService::getConstellationSecondaryBandConfig(
         const LocConfigGetConstellationSecondaryBandConfigReqMsg* pReqMsg) {
 
@@ -852,11 +1070,12 @@ LocationApiService - implementation - batching
 void LocationApiService::startBatching(LocAPIStartBatchingReqMsg *pMsg) {
 
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- start invalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
 
     if (!pClient->startBatching(pMsg->intervalInMs, pMsg->distanceInMeters,
                 pMsg->batchingMode)) {
@@ -874,11 +1093,12 @@ void LocationApiService::startBatching(LocAPIStartBatchingReqMsg *pMsg) {
 
 void LocationApiService::stopBatching(LocAPIStopBatchingReqMsg *pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- stop invalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
 
     pClient->mBatching = false;
     pClient->mBatchingMode = BATCHING_MODE_NO_AUTO_REPORT;
@@ -890,8 +1110,9 @@ void LocationApiService::stopBatching(LocAPIStopBatchingReqMsg *pMsg) {
 
 void LocationApiService::updateBatchingOptions(LocAPIUpdateBatchingOptionsReqMsg *pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (pClient) {
+        std::lock_guard<std::mutex> clientLock(pClient->getLock());
         pClient->updateBatchingOptions(pMsg->intervalInMs, pMsg->distanceInMeters,
                 pMsg->batchingMode);
         pClient->mPendingMessages.push(E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID);
@@ -905,11 +1126,12 @@ LocationApiService - implementation - geofence
 ******************************************************************************/
 void LocationApiService::addGeofences(LocAPIAddGeofencesReqMsg* pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- start invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
     if (pMsg->geofences.count > MAX_GEOFENCE_COUNT) {
         LOC_LOGe(">-- geofence count greater than MAX =%d", pMsg->geofences.count);
         return;
@@ -958,11 +1180,12 @@ void LocationApiService::addGeofences(LocAPIAddGeofencesReqMsg* pMsg) {
 
 void LocationApiService::removeGeofences(LocAPIRemoveGeofencesReqMsg* pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (nullptr == pClient) {
         LOC_LOGe("removeGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
     uint32_t* sessions = pClient->getSessionIds(pMsg->gfClientIds.count, pMsg->gfClientIds.gfIds);
     if (pClient && sessions) {
         pClient->removeGeofences(pMsg->gfClientIds.count, sessions);
@@ -974,11 +1197,12 @@ void LocationApiService::removeGeofences(LocAPIRemoveGeofencesReqMsg* pMsg) {
 }
 void LocationApiService::modifyGeofences(LocAPIModifyGeofencesReqMsg* pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (nullptr == pClient) {
         LOC_LOGe("modifyGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
     if (pMsg->geofences.count > MAX_GEOFENCE_COUNT) {
         LOC_LOGe("modifyGeofences - geofence count greater than MAX =%d", pMsg->geofences.count);
         return;
@@ -1014,11 +1238,12 @@ void LocationApiService::modifyGeofences(LocAPIModifyGeofencesReqMsg* pMsg) {
 }
 void LocationApiService::pauseGeofences(LocAPIPauseGeofencesReqMsg* pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (nullptr == pClient) {
         LOC_LOGe("pauseGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
     uint32_t* sessions = pClient->getSessionIds(pMsg->gfClientIds.count, pMsg->gfClientIds.gfIds);
     if (pClient && sessions) {
         pClient->pauseGeofences(pMsg->gfClientIds.count, sessions);
@@ -1030,11 +1255,12 @@ void LocationApiService::pauseGeofences(LocAPIPauseGeofencesReqMsg* pMsg) {
 }
 void LocationApiService::resumeGeofences(LocAPIResumeGeofencesReqMsg* pMsg) {
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (nullptr == pClient) {
         LOC_LOGe("resumeGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
     uint32_t* sessions = pClient->getSessionIds(pMsg->gfClientIds.count, pMsg->gfClientIds.gfIds);
     if (pClient && sessions) {
         pClient->resumeGeofences(pMsg->gfClientIds.count, sessions);
@@ -1049,11 +1275,12 @@ void LocationApiService::pingTest(LocAPIPingTestReqMsg* pMsg) {
 
     // test only - ignore this request when config is not enabled
     std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(pMsg);
     if (!pClient) {
         LOC_LOGe(">-- pingTest invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> clientLock(pClient->getLock());
     pClient->pingTest();
     LOC_LOGd(">-- pingTest");
 }
@@ -1297,26 +1524,129 @@ void LocationApiService::configDeadReckoningEngineParams(const LocConfigDrEngine
     addConfigRequestToMap(sessionId, pMsg);
 }
 
+void LocationApiService::configBatch(const LocConfigBatchReqMsg* pMsg) {
+    if (!pMsg) {
+        return;
+    }
+
+    uint32_t batchId = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        LOC_LOGi(">-- client %s, config batch of %zu", pMsg->mSocketName,
+                 pMsg->mConfigMsgs.size());
+        if (0 == ++mLastConfigBatchId) {
+            ++mLastConfigBatchId;
+        }
+        batchId = mLastConfigBatchId;
+        ConfigBatchData batchData;
+        batchData.clientName = pMsg->mSocketName;
+        // held until all requests are dispatched, so that a batch is not
+        // answered while its later requests are still to be sent
+        batchData.pendingCnt = 1;
+        batchData.err = LOCATION_ERROR_SUCCESS;
+        mConfigBatches.emplace(batchId, batchData);
+    }
+
+    // the requests are dispatched one after the other on this thread, with
+    // addConfigRequestToMap() adding their sessions to the batch; the location
+    // control API queues them all to the engine without waiting on any of
+    // their responses
+    mConfigBatchId = batchId;
+    for (const string& configMsg : pMsg->mConfigMsgs) {
+        PBLocAPIMsgHeader* pbConfigMsg =
+                google::protobuf::Arena::CreateMessage<PBLocAPIMsgHeader>(&mDecodeArena);
+        ELocMsgID configMsgId = E_LOCAPI_UNDEFINED_MSG_ID;
+        if (0 != pbConfigMsg->ParseFromString(configMsg)) {
+            configMsgId = mPbufMsgConv.getEnumForPBELocMsgID(pbConfigMsg->msgid());
+        }
+
+        const ClientMsgDispatch* dispatch = nullptr;
+        // only the config requests can be part of a batch
+        if (configMsgId >= E_INTAPI_CONFIG_CONSTRAINTED_TUNC_MSG_ID &&
+                configMsgId < E_INTAPI_CONFIG_BATCH_MSG_ID) {
+            for (const ClientMsgDispatch& entry : sClientMsgDispatch) {
+                if (entry.msgId == configMsgId) {
+                    dispatch = &entry;
+                    break;
+                }
+            }
+        }
+        if (nullptr == dispatch) {
+            LOC_LOGe("invalid msg id %d in config batch", configMsgId);
+            std::lock_guard<std::mutex> lock(mMutex);
+            ConfigBatchData& batchData = mConfigBatches[batchId];
+            if (LOCATION_ERROR_SUCCESS == batchData.err) {
+                batchData.err = LOCATION_ERROR_INVALID_PARAMETER;
+            }
+            continue;
+        }
+        // the requests are taken as coming from the client that sent the batch
+        LocAPIMsgHeader configHeader(pMsg->mSocketName, configMsgId);
+        dispatch->handler(*this, configHeader, *pbConfigMsg);
+    }
+    mConfigBatchId = 0;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    onConfigBatchResponse(batchId, LOCATION_ERROR_SUCCESS);
+}
+
 void LocationApiService::addConfigRequestToMap(
         uint32_t sessionId, const LocAPIMsgHeader* pMsg){
     // for config request that is invoked from location integration API
     // if session id is valid, we need to add it to the map so when response
     // comes back, we can deliver the response to the integration api client
-    if (sessionId != 0) {
+    if (0 != mConfigBatchId) {
+        // request of a config batch, answered together with the batch
+        if (sessionId != 0) {
+            ConfigReqClientData configClientData;
+            configClientData.configMsgId = pMsg->msgId;
+            configClientData.clientName  = pMsg->mSocketName;
+            configClientData.batchId     = mConfigBatchId;
+            mConfigReqs.emplace(sessionId, configClientData);
+            mConfigBatches[mConfigBatchId].pendingCnt++;
+        } else {
+            ConfigBatchData& batchData = mConfigBatches[mConfigBatchId];
+            if (LOCATION_ERROR_SUCCESS == batchData.err) {
+                batchData.err = LOCATION_ERROR_GENERAL_FAILURE;
+            }
+        }
+    } else if (sessionId != 0) {
         ConfigReqClientData configClientData;
         configClientData.configMsgId = pMsg->msgId;
         configClientData.clientName  = pMsg->mSocketName;
+        configClientData.batchId     = 0;
         mConfigReqs.emplace(sessionId, configClientData);
     } else {
         // if session id is 0, we need to deliver failed response back to the
         // client
-        LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+        LocHalDaemonClientHandler* pClient = getClient(pMsg);
         if (pClient) {
+            std::lock_guard<std::mutex> clientLock(pClient->getLock());
             pClient->onControlResponseCb(LOCATION_ERROR_GENERAL_FAILURE, pMsg->msgId);
         }
     }
 }
 
+// no need to hold the lock as lock has been held on calling functions
+void LocationApiService::onConfigBatchResponse(uint32_t batchId, LocationError err) {
+    auto batchData = mConfigBatches.find(batchId);
+    if (batchData == std::end(mConfigBatches)) {
+        LOC_LOGe("--< config batch %u not found", batchId);
+        return;
+    }
+    if (LOCATION_ERROR_SUCCESS != err && LOCATION_ERROR_SUCCESS == batchData->second.err) {
+        batchData->second.err = err;
+    }
+    if (0 == --batchData->second.pendingCnt) {
+        LocHalDaemonClientHandler* pClient = getClient(batchData->second.clientName);
+        if (pClient) {
+            std::lock_guard<std::mutex> clientLock(pClient->getLock());
+            pClient->onControlResponseCb(batchData->second.err, E_INTAPI_CONFIG_BATCH_MSG_ID);
+        }
+        mConfigBatches.erase(batchData);
+    }
+}
+
 /******************************************************************************
 LocationApiService - Location Control API callback functions
 ******************************************************************************/
@@ -1326,9 +1656,14 @@ void LocationApiService::onControlResponseCallback(LocationError err, uint32_t s
 
     auto configReqData = mConfigReqs.find(sessionId);
     if (configReqData != std::end(mConfigReqs)) {
-        LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName);
-        if (pClient) {
-            pClient->onControlResponseCb(err, configReqData->second.configMsgId);
+        if (0 != configReqData->second.batchId) {
+            onConfigBatchResponse(configReqData->second.batchId, err);
+        } else {
+            LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName);
+            if (pClient) {
+                std::lock_guard<std::mutex> clientLock(pClient->getLock());
+                pClient->onControlResponseCb(err, configReqData->second.configMsgId);
+            }
         }
         mConfigReqs.erase(configReqData);
         LOC_LOGd("--< map size %d", mConfigReqs.size());
@@ -1353,9 +1688,15 @@ void LocationApiService::onControlCollectiveResponseCallback(
     // the first id
     auto configReqData = mConfigReqs.find(sessionId);
     if (configReqData != std::end(mConfigReqs)) {
-        LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName.c_str());
-        if (pClient) {
-            pClient->onControlResponseCb(err, configReqData->second.configMsgId);
+        if (0 != configReqData->second.batchId) {
+            onConfigBatchResponse(configReqData->second.batchId, err);
+        } else {
+            LocHalDaemonClientHandler* pClient =
+                    getClient(configReqData->second.clientName.c_str());
+            if (pClient) {
+                std::lock_guard<std::mutex> clientLock(pClient->getLock());
+                pClient->onControlResponseCb(err, configReqData->second.configMsgId);
+            }
         }
         mConfigReqs.erase(configReqData);
         LOC_LOGd("--< map size %d", mConfigReqs.size());
@@ -1373,6 +1714,7 @@ void LocationApiService::onGnssConfigCallback(uint32_t sessionId,
     if (configReqData != std::end(mConfigReqs)) {
         LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName);
         if (pClient) {
+            std::lock_guard<std::mutex> clientLock(pClient->getLock());
             // invoke the respCb to deliver success status
             pClient->onControlResponseCb(LOCATION_ERROR_SUCCESS, configReqData->second.configMsgId);
             // invoke the configCb to deliver the config
@@ -1407,7 +1749,10 @@ void LocationApiService::onGtpWwanTrackingCallback(Location location) {
 
         for (auto it = mTerrestrialFixReqs.begin(); it != mTerrestrialFixReqs.end();) {
             LocHalDaemonClientHandler* pClient = getClient(it->first);
-            pClient->sendTerrestrialFix(LOCATION_ERROR_SUCCESS, location);
+            if (pClient) {
+                std::lock_guard<std::mutex> clientLock(pClient->getLock());
+                pClient->sendTerrestrialFix(LOCATION_ERROR_SUCCESS, location);
+            }
             ++it;
         }
         mTerrestrialFixReqs.clear();
@@ -1451,6 +1796,7 @@ void LocationApiService::onGnssEnergyConsumedCb(uint64_t totalGnssEnergyConsumed
             &mPbufMsgConv);
     for (auto each : mClients) {
         // deliver the engergy info to registered client
+        std::lock_guard<std::mutex> clientLock(each.second->getLock());
         each.second->onGnssEnergyConsumedInfoAvailable(msg);
     }
 }
@@ -1477,6 +1823,37 @@ GnssInterface* LocationApiService::getGnssInterface() {
     return gnssInterface;
 }
 
+shared_ptr<const string> LocationApiService::serializeIndication(ELocMsgID msgId,
+        const void* key, size_t keyLen, const std::function<bool(string&)>& serialize) {
+    std::lock_guard<std::mutex> lock(mSerializedIndicationsLock);
+    SerializedIndication& cached = mSerializedIndications[msgId];
+    if (nullptr != cached.payload && cached.key.size() == keyLen &&
+            0 == memcmp(cached.key.data(), key, keyLen)) {
+        return cached.payload;
+    }
+
+    // once every client has been sent the last one, no one else holds it,
+    // and nothing can get it but from here: its buffer takes the new one
+    shared_ptr<string> pbStr;
+    if (nullptr != cached.payload && 1 == cached.payload.use_count()) {
+        // pairs with the release of the last other reference, so that
+        // its reads of the buffer are done
+        std::atomic_thread_fence(std::memory_order_acquire);
+        pbStr = std::move(cached.payload);
+        pbStr->clear();
+    } else {
+        pbStr = std::make_shared<string>();
+    }
+    if (!serialize(*pbStr)) {
+        LOC_LOGe("msg id %d serializeToProtobuf failed", msgId);
+        cached.payload = nullptr;
+        return nullptr;
+    }
+    cached.key.assign(reinterpret_cast<const char*>(key), keyLen);
+    cached.payload = pbStr;
+    return pbStr;
+}
+
 void LocationApiService::performMaintenance() {
     ClientNameIpcSenderMap   clientsToCheck;
 
@@ -1487,9 +1864,20 @@ void LocationApiService::performMaintenance() {
     // deleted by the thread of LocationApiService.
     {
         std::lock_guard<std::mutex> lock(mMutex);
+        string clientStats;
+        dumpClientStats(clientStats);
+        // a line per log entry, so that none gets cut short
+        for (size_t pos = 0, end; pos < clientStats.size(); pos = end + 1) {
+            end = clientStats.find('\n', pos);
+            LOC_LOGi("%.*s", (int)(end - pos), clientStats.c_str() + pos);
+        }
         for (auto client : mClients) {
+            // clients the kernel tells about going away need no ping
             if (client.first.compare(AUTO_START_CLIENT_NAME) != 0) {
-                clientsToCheck.emplace(client.first, client.second->getIpcSender());
+                std::lock_guard<std::mutex> clientLock(client.second->getLock());
+                if (!client.second->mLivenessWatched) {
+                    clientsToCheck.emplace(client.first, client.second->getIpcSender());
+                }
             }
         }
     }
@@ -1507,12 +1895,22 @@ void LocationApiService::performMaintenance() {
         LOC_LOGd("send ping message returned %d for client %s", messageSent, client.first.c_str());
         if (messageSent == false) {
             LOC_LOGe("--< ping failed for client %s", client.first.c_str());
+            std::lock_guard<std::mutex> lock(mMutex);
             deleteClientbyName(client.first);
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mClientMsgStatsLock);
+        for (auto each : mClientMsgStats) {
+            LOC_LOGd("client msg id %u: count %" PRIu64 ", avg %" PRIu64 " ns, max %" PRIu64
+                     " ns", each.first, each.second.count,
+                     each.second.totalNs / each.second.count, each.second.maxNs);
+        }
+    }
+
     // after maintenace, start next timer
-    mMaintTimer.start(MAINT_TIMER_INTERVAL_MSEC, false);
+    mMaintTimer.start(MAINT_TIMER_INTERVAL_MSEC, false, MAINT_TIMER_SLACK_MSEC);
 }
 
 
@@ -1549,22 +1947,26 @@ void LocationApiService::getSingleTerrestrialPos(
     if (mOptInTerrestrialService != 1) {
         LocHalDaemonClientHandler* pClient = getClient(clientName);
         if (pClient) {
+            std::lock_guard<std::mutex> clientLock(pClient->getLock());
             // inform client that GTP service is not supported
             Location location = {};
             pClient->sendTerrestrialFix(LOCATION_ERROR_NOT_SUPPORTED, location);
         }
     } else {
-        mTerrestrialFixReqs.emplace(std::piecewise_construct,
-                                    std::forward_as_tuple(clientName),
-                                    std::forward_as_tuple(this, clientName));
-
-        auto it = mTerrestrialFixReqs.find(clientName);
-        if (it != mTerrestrialFixReqs.end()) {
-            it->second.start(pReqMsg->mTimeoutMsec, false);
-        }
-
-        if (mTerrestrialFixReqs.size() == 1) {
+        // all clients waiting share the one network location session, so
+        // it is only started for the first of them; a client asking again
+        // just restarts its own timeout
+        bool firstReq = mTerrestrialFixReqs.empty();
+        auto it = mTerrestrialFixReqs.emplace(std::piecewise_construct,
+                                              std::forward_as_tuple(clientName),
+                                              std::forward_as_tuple(this, clientName)).first;
+        it->second.start(pReqMsg->mTimeoutMsec, false);
+
+        if (firstReq) {
             mGtpWwanSsLocationApi->startNetworkLocation(&mGtpWwanPosCallback);
+        } else {
+            LOC_LOGd("terrestrial fix in flight, %zu clients waiting",
+                     mTerrestrialFixReqs.size());
         }
     }
 }
@@ -1577,13 +1979,14 @@ void LocationApiService::gtpFixRequestTimeout(const std::string& clientName) {
     if (it != mTerrestrialFixReqs.end()) {
         LocHalDaemonClientHandler* pClient = getClient(clientName);
         if (pClient) {
+            std::lock_guard<std::mutex> clientLock(pClient->getLock());
             // inform client of timeout
             Location location = {};
             pClient->sendTerrestrialFix(LOCATION_ERROR_TIMEOUT, location);
         }
         mTerrestrialFixReqs.erase(clientName);
         // stop tracking if there is no more request
-        if (mTerrestrialFixReqs.size() == 1) {
+        if (mTerrestrialFixReqs.empty()) {
             mGtpWwanSsLocationApi->stopNetworkLocation(&mGtpWwanPosCallback);
         }
     }
@@ -1608,3 +2011,23 @@ void SingleTerrestrialFixTimer::timeOutCallback() {
     mLocationApiService->getMsgTask().sendMsg(new SingleTerrestrialFixTimeoutReq(
                 mLocationApiService, mClientName));
 }
+
+void TrackingOptionsTimer::timeOutCallback() {
+    LOC_LOGd("TrackingOptions coalescing timer fired");
+
+    struct TrackingOptionsTimeoutReq : public LocMsg {
+        TrackingOptionsTimeoutReq(LocationApiService* locationApiService,
+                                  const std::string &clientName) :
+                mLocationApiService(locationApiService),
+                mClientName(clientName) {}
+        virtual ~TrackingOptionsTimeoutReq() {}
+        void proc() const {
+            mLocationApiService->applyTrackingOptions(mClientName);
+        }
+        LocationApiService* mLocationApiService;
+        std::string         mClientName;
+    };
+
+    mLocationApiService->getMsgTask().sendMsg(new TrackingOptionsTimeoutReq(
+                mLocationApiService, mClientName));
+}
@@ -30,7 +30,11 @@
 #define LOCATIONAPISERVICE_H
 
 #include <string>
+#include <vector>
 #include <mutex>
+#include <functional>
+#include <type_traits>
+#include <google/protobuf/arena.h>
 
 #include <MsgTask.h>
 #include <loc_cfg.h>
@@ -50,16 +54,25 @@
 #else
     #include <unordered_map>
 #endif
+#include <unordered_set>
 
 #undef LOG_TAG
 #define LOG_TAG "LocSvc_HalDaemon"
 
+// first block of the arena client requests are decoded on
+#define CLIENT_MSG_DECODE_BLOCK_SIZE (16 * 1024)
+
 typedef struct {
     uint32_t autoStartGnss;
     uint32_t gnssSessionTbfMs;
     uint32_t deleteAllBeforeAutoStart;
     uint32_t posEngineMask;
     uint32_t positionMode;
+    uint32_t clientOutboundQueueDepth;
+    uint32_t clientOutboundPositionPolicy;
+    uint32_t clientOutboundSvPolicy;
+    uint32_t clientOutboundStreamPolicy;
+    uint32_t clientTrackingOptionsCoalesceMs;
 } configParamToRead;
 
 
@@ -72,8 +85,18 @@ typedef struct {
     // the info will be used to send back command response
     std::string clientName;
     ELocMsgID   configMsgId;
+    // id of the config batch the request is part of, 0 if sent on its own
+    uint32_t    batchId;
 } ConfigReqClientData;
 
+typedef struct {
+    // client the batch is answered to, once all of its requests are answered
+    std::string   clientName;
+    uint32_t      pendingCnt;
+    // first error any request of the batch was answered with
+    LocationError err;
+} ConfigBatchData;
+
 // periodic timer to perform maintenance work, e.g.: resource cleanup
 // for location hal daemon
 typedef std::unordered_map<std::string, shared_ptr<LocIpcSender>> ClientNameIpcSenderMap;
@@ -117,6 +140,31 @@ private:
 typedef std::unordered_map<std::string, SingleTerrestrialFixTimer>
         SingleTerrestrialFixClientMap;
 
+class TrackingOptionsTimer : public LocTimer {
+public:
+
+    TrackingOptionsTimer(LocationApiService* locationApiService,
+                         const std::string& clientName) :
+            mLocationApiService(locationApiService),
+            mClientName(clientName) {
+    }
+
+    ~TrackingOptionsTimer() {
+    }
+
+public:
+    void timeOutCallback() override;
+
+private:
+    LocationApiService* mLocationApiService;
+    const std::string mClientName;
+};
+
+// This keeps track of the clients with a tracking options update held
+// back, and the timer that applies it once the coalescing window is over
+typedef std::unordered_map<std::string, TrackingOptionsTimer>
+        TrackingOptionsClientMap;
+
 class LocationApiService
 {
 public:
@@ -151,24 +199,51 @@ public:
 #endif
 
     // other APIs
+    // caller holds mMutex
     void deleteClientbyName(const std::string name);
+    // deletes the client later, from the maintenance msg task. For the
+    // client handler, which must not take mMutex under its own lock.
+    void purgeClient(const std::string& name);
 
     // protobuf conversion util class
     LocationApiPbMsgConv mPbufMsgConv;
 
+    // Guards the client registry and the service state. Taken by client
+    // requests and service callbacks; indications to clients only take the
+    // lock of the client they go to.
     static std::mutex mMutex;
 
     // Utility routine used by maintenance timer
     void performMaintenance();
 
+    // dumpsys-style text of the resource use of each client, one line each.
+    // Caller holds mMutex.
+    void dumpClientStats(string& out);
+
     // Utility routine used by gtp fix timeout timer
     void gtpFixRequestTimeout(const std::string& clientName);
 
+    // Utility routine used by tracking options coalescing timer
+    void applyTrackingOptions(const std::string& clientName);
+
+    // Liveness events: the process of a local client exited, or the qrtr
+    // service of a remote client came up or went down
+    void onClientGone(const std::string& clientName);
+    void onQrtrClientStatusChange(int instanceId, bool up);
+
     inline const MsgTask& getMsgTask() const {return mMsgTask;};
 
+    // Indications carry the service name only, so every client is sent the
+    // same bytes. The last one of each msg id is kept serialized, keyed by the
+    // notification it came from, for the next client to reuse.
+    shared_ptr<const string> serializeIndication(ELocMsgID msgId,
+            const void* key, size_t keyLen,
+            const std::function<bool(string&)>& serialize);
+
 private:
     // APIs can be invoked to process client's IPC messgage
     void newClient(LocAPIClientRegisterReqMsg*);
+    void watchClient(LocHalDaemonClientHandler* pClient, const std::string& clientname);
     void deleteClient(LocAPIClientDeregisterReqMsg*);
 
     void startTracking(LocAPIStartTrackingReqMsg*);
@@ -180,7 +255,11 @@ private:
     void updateSubscription(LocAPIUpdateCallbacksReqMsg*);
     void updateTrackingOptions(LocAPIUpdateTrackingOptionsReqMsg*);
     void updateNetworkAvailability(bool availability);
+    inline void updateNetworkAvailability(LocAPIUpdateNetworkAvailabilityReqMsg* pMsg) {
+        updateNetworkAvailability(pMsg->mAvailability);
+    }
     void getGnssEnergyConsumed(const char* clientSocketName);
+    void getClientStats(const LocAPIMsgHeader* pReqMsg);
     void getSingleTerrestrialPos(LocAPIGetSingleTerrestrialPosReqMsg*);
 
     void startBatching(LocAPIStartBatchingReqMsg*);
@@ -195,6 +274,23 @@ private:
 
     void pingTest(LocAPIPingTestReqMsg*);
 
+    // Client requests are dispatched through a table keyed by msg id. The
+    // handler of a msg id decodes its payload on mDecodeArena and calls the
+    // request function above.
+    typedef void (*ClientMsgHandler)(LocationApiService& service,
+            const LocAPIMsgHeader& header, const PBLocAPIMsgHeader& pbHeader);
+    struct ClientMsgDispatch {
+        ELocMsgID msgId;
+        ClientMsgHandler handler;
+    };
+    static const ClientMsgDispatch sClientMsgDispatch[];
+    template <typename PbMsg, typename Msg, void (LocationApiService::*Fn)(Msg*)>
+    static void decodeClientMsg(LocationApiService& service,
+            const LocAPIMsgHeader& header, const PBLocAPIMsgHeader& pbHeader);
+    template <typename Msg, void (LocationApiService::*Fn)(Msg*)>
+    static void dispatchClientMsg(LocationApiService& service,
+            const LocAPIMsgHeader& header, const PBLocAPIMsgHeader& pbHeader);
+
     inline uint32_t gnssUpdateConfig(const GnssConfig& config) {
         uint32_t* sessionIds =  mLocationControlApi->gnssUpdateConfig(config);
         // in our usage, we only configure one setting at a time,
@@ -238,6 +334,7 @@ private:
     void configEngineRunState(const LocConfigEngineRunStateReqMsg* pMsg);
     void configUserConsentTerrestrialPositioning(
             LocConfigUserConsentTerrestrialPositioningReqMsg* pMsg);
+    void configBatch(const LocConfigBatchReqMsg* pMsg);
 
     // Location configuration API get/read requests
     void getGnssConfig(const LocAPIMsgHeader* pReqMsg,
@@ -248,6 +345,7 @@ private:
     // Location configuration API util routines
     void addConfigRequestToMap(uint32_t sessionId,
                                const LocAPIMsgHeader* pMsg);
+    void onConfigBatchResponse(uint32_t batchId, LocationError err);
 
     LocationApiService(const configParamToRead & configParamRead);
     virtual ~LocationApiService();
@@ -268,6 +366,29 @@ private:
         return getClient(clientname);
     }
 
+    // a client request goes by the token of its client, by the socket name
+    // if it carries none
+    inline LocHalDaemonClientHandler* getClient(const LocAPIMsgHeader* pMsg) {
+        if (0 != pMsg->mClientToken) {
+            return getClientByToken(pMsg->mClientToken);
+        }
+        return getClient(pMsg->mSocketName);
+    }
+
+    inline LocHalDaemonClientHandler* getClientByToken(uint32_t clientToken) {
+        uint32_t slot = (clientToken & CLIENT_TOKEN_SLOT_MASK) - 1;
+        if (slot >= mClientSlots.size() || mClientSlots[slot].token != clientToken) {
+            LOC_LOGe("Failed to find client of token 0x%x", clientToken);
+            return nullptr;
+        }
+        return mClientSlots[slot].client;
+    }
+
+    // the slot of a token is taken until released, its client is filled in
+    // once registered
+    uint32_t allocClientToken();
+    void releaseClientToken(uint32_t clientToken);
+
     GnssInterface* getGnssInterface();
 
 #ifdef POWERMANAGER_ENABLED
@@ -278,13 +399,27 @@ private:
     // singleton instance
     static LocationApiService *mInstance;
 
-    // IPC interface
-    LocIpc mIpc;
-    unique_ptr<LocIpcRecver> mBlockingRecver;
+    // IPC interface, serving both the local and the qrtr recver
+    LocIpcReactor mIpcReactor;
 
     // Client propery database
     std::unordered_map<std::string, LocHalDaemonClientHandler*> mClients;
+    // Registered clients by the token handed out to them. The low bits of a
+    // token are its slot + 1, the high bits tell apart the clients that held
+    // the slot one after the other. Guarded by mMutex.
+    static const uint32_t CLIENT_TOKEN_SLOT_MASK = 0xFFFF;
+    struct ClientSlot {
+        uint32_t token;
+        LocHalDaemonClientHandler* client;
+    };
+    std::vector<ClientSlot> mClientSlots;
+    std::vector<uint32_t> mFreeClientSlots;
+    uint32_t mClientTokenGen;
     std::unordered_map<uint32_t, ConfigReqClientData> mConfigReqs;
+    std::unordered_map<uint32_t, ConfigBatchData> mConfigBatches;
+    // batch whose requests are being dispatched, 0 if none
+    uint32_t mConfigBatchId;
+    uint32_t mLastConfigBatchId;
 
     // Location Control API interface
     uint32_t mLocationControlId;
@@ -294,13 +429,14 @@ private:
     // Configration
     const uint32_t mAutoStartGnss;
     GnssSuplMode   mPositionMode;
+    const uint32_t mTrackingOptionsCoalesceMs;
 
     PowerStateType  mPowerState;
 
     // maintenance timer
     MaintTimer mMaintTimer;
 
-   // msg task used by timers
+   // msg task used by timers, served by mIpcReactor rather than a thread
     const MsgTask   mMsgTask;
 
     // Terrestrial service related APIs
@@ -311,6 +447,34 @@ private:
     // -1: not set, 0: user not opt-in, 1: user opt in
     int mOptInTerrestrialService;
     SingleTerrestrialFixClientMap mTerrestrialFixReqs;
+
+    // instances of LOCATION_CLIENT_API_QSOCKET_CLIENT_SERVICE_ID that are up
+    std::unordered_set<int> mQrtrClientsUp;
+
+    // tracking options updates held back to be coalesced
+    TrackingOptionsClientMap mTrackingOptionsReqs;
+
+    // last serialized indication per msg id, see serializeIndication()
+    struct SerializedIndication {
+        string key;
+        shared_ptr<string> payload;
+    };
+    std::unordered_map<uint32_t, SerializedIndication> mSerializedIndications;
+    std::mutex mSerializedIndicationsLock;
+
+    // client requests are decoded on this arena, reset once a msg is done;
+    // its first block is mDecodeBlock, so most msgs need no malloc to decode
+    char mDecodeBlock[CLIENT_MSG_DECODE_BLOCK_SIZE];
+    google::protobuf::Arena mDecodeArena;
+
+    // processing cost of the client requests, per msg id
+    struct ClientMsgStats {
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t maxNs;
+    };
+    std::unordered_map<uint32_t, ClientMsgStats> mClientMsgStats;
+    std::mutex mClientMsgStatsLock;
 };
 
 #endif //LOCATIONAPISERVICE_H
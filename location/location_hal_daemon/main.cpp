@@ -62,6 +62,10 @@ static inline void waitForDir(const char* dirName) {
 int main(int argc, char *argv[])
 {
     configParamToRead configParamRead = {};
+    configParamRead.clientOutboundPositionPolicy = LOC_HAL_OUTBOUND_COALESCE_LATEST;
+    configParamRead.clientOutboundSvPolicy = LOC_HAL_OUTBOUND_COALESCE_LATEST;
+    configParamRead.clientOutboundStreamPolicy = LOC_HAL_OUTBOUND_DROP_OLDEST;
+    configParamRead.clientTrackingOptionsCoalesceMs = 100;
 #if FEATURE_AUTOMOTIVE
     // enable auto start by default with 100 ms TBF
     configParamRead.autoStartGnss = 1;
@@ -75,6 +79,14 @@ int main(int argc, char *argv[])
         {"DELETE_ALL_BEFORE_AUTO_START", &configParamRead.deleteAllBeforeAutoStart, NULL, 'n'},
         {"DELETE_ALL_ON_ENGINE_MASK", &configParamRead.posEngineMask, NULL, 'n'},
         {"POSITION_MODE", &configParamRead.positionMode, NULL, 'n'},
+        {"CLIENT_OUTBOUND_QUEUE_DEPTH", &configParamRead.clientOutboundQueueDepth, NULL, 'n'},
+        {"CLIENT_OUTBOUND_POSITION_POLICY",
+                &configParamRead.clientOutboundPositionPolicy, NULL, 'n'},
+        {"CLIENT_OUTBOUND_SV_POLICY", &configParamRead.clientOutboundSvPolicy, NULL, 'n'},
+        {"CLIENT_OUTBOUND_STREAM_POLICY",
+                &configParamRead.clientOutboundStreamPolicy, NULL, 'n'},
+        {"CLIENT_TRACKING_OPTIONS_COALESCE_MS",
+                &configParamRead.clientTrackingOptionsCoalesceMs, NULL, 'n'},
     };
 
     // read configuration file
@@ -265,9 +265,12 @@ extern "C" {
     This is an optional function and can be NULL.
     It is called when delivering a location in a batching session.
 
+    When a user buffer is set with qapi_Loc_Set_User_Buffer() and the batch
+    fits in it, the array points into the user buffer.
+
     @param[in] count     Number of locations in an array.
     @param[in] location  Array of location structures containing information
-    related to the batched locations.
+    related to the batched locations. Only valid until the callback returns.
 
     @return None.
     */
@@ -325,6 +328,22 @@ extern "C" {
         qapi_Gnss_Data_t gnssData
         );
 
+    /**
+    * @brief Tracking index callback, the zero copy form of the tracking
+    callback for a client that has set a user buffer with
+    qapi_Loc_Set_User_Buffer(). This is an optional function and can be NULL.
+    When set along with a user buffer, it is called instead of the tracking
+    callback, with the location already written into the user buffer.
+
+    @param[in] index  Index of the qapi_Location_t in the user buffer that
+    holds the tracked location.
+
+    @return None.
+    */
+    typedef void(*qapi_Tracking_Index_Callback)(
+        uint32_t index
+        );
+
     /** Location callbacks requirements. */
     typedef struct {
         size_t size;
@@ -345,6 +364,9 @@ extern "C" {
         /**< Single shot callback is optional. */
         qapi_Gnss_Data_Callback         gnssDataCb;
         /**< GNSS data callback is optional. @newpagetable */
+        qapi_Tracking_Index_Callback    trackingIndexCb;
+        /**< Tracking index callback is optional. It is only taken when size
+             covers it. */
     } qapi_Location_Callbacks_t;
 
     /** Location client identifier. */
@@ -387,18 +409,27 @@ extern "C" {
     /**
     * @brief Sets the user buffer to be used for sending back callback data.
 
+    The buffer is used as a ring of qapi_Location_t. The locations of the
+    tracking and single shot sessions are converted directly into the next
+    entry of the ring, which wraps around once the end of the buffer is
+    reached. A client that registered the tracking index callback is then
+    passed only the index of that entry, instead of a copy of the location.
+
     @param[in] clientId   Client ID for which user buffer is to be set
     @param[in] pUserBuffer User memory buffer to hold information passed
     in callbacks. Note that since buffer is shared by all
     the callbacks this has to be consumed at the user side
     before it can be used by another callback to avoid any
-    potential race condition.
+    potential race condition. NULL stops the use of a user buffer.
     @param[in] bufferSize  Size of user memory buffer to hold information passed
     in callbacks. This size should be large enough to
-    accomodate the largest data size passed in a callback.
+    accomodate the largest data size passed in a callback,
+    at least one qapi_Location_t.
 
     @return
     QAPI_LOCATION_ERROR_SUCCESS -- The operation was successful. \n
+    QAPI_LOCATION_ERROR_INVALID_PARAMETER -- The buffer can not hold a
+    qapi_Location_t. \n
     QAPI_LOCATION_ERROR_GENERAL_FAILURE -- There is an internal error. \n
     */
     qapi_Location_Error_t qapi_Loc_Set_User_Buffer(
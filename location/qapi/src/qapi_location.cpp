@@ -36,6 +36,7 @@
 #include <pthread.h>
 #include <vector>
 #include <string.h>
+#include <stddef.h>
 #include <LocTimer.h>
 
 using namespace std;
@@ -103,54 +104,84 @@ static qapi_Location_Error_t get_qapi_error(LocationResponse err)
     }
 }
 
-static int32_t copy_to_user_space_buffer(
-    uint8_t* user_space_buffer,
-    uint32_t user_space_buffer_size,
-    uint8_t* data_ptr,
-    uint32_t data_size,
-    uint32_t offset) {
-
-    if (offset >= user_space_buffer_size) {
-        LOC_LOGe("Invalid offset %d, buffer size %d",
-            offset, user_space_buffer_size);
-        return -1;
-    }
+/* User buffer set with qapi_Loc_Set_User_Buffer(), a ring of qapi_Location_t
+   that the tracked locations are converted into in place */
+static pthread_mutex_t qUserBufferMutex = PTHREAD_MUTEX_INITIALIZER;
+static qapi_Location_t* qUserLocations = nullptr;
+static uint32_t qUserLocationsCount = 0;
+static uint32_t qUserLocationsNext = 0;
+
+/* Returns the entry of the user buffer to convert the next location into, and
+   its index, or pFallback when no user buffer is set. */
+static qapi_Location_t* get_user_location(
+    qapi_Location_t* pFallback,
+    int32_t* pIndex) {
+
+    qapi_Location_t* pLocation = pFallback;
+    *pIndex = -1;
+    pthread_mutex_lock(&qUserBufferMutex);
+    if (nullptr != qUserLocations) {
+        *pIndex = qUserLocationsNext;
+        pLocation = &qUserLocations[qUserLocationsNext];
+        qUserLocationsNext = (qUserLocationsNext + 1) % qUserLocationsCount;
+    }
+    pthread_mutex_unlock(&qUserBufferMutex);
+    memset(pLocation, 0, sizeof(*pLocation));
+    return pLocation;
+}
 
-    memcpy((user_space_buffer + offset), data_ptr, data_size);
+/* Reserves count contiguous entries of the user buffer for a batch of
+   locations, or returns nullptr when no user buffer is set or the batch does
+   not fit before the end of it. */
+static qapi_Location_t* get_user_locations(size_t count) {
 
-    return 0;
+    qapi_Location_t* pLocations = nullptr;
+    pthread_mutex_lock(&qUserBufferMutex);
+    if (nullptr != qUserLocations && count <= qUserLocationsCount) {
+        if (count > qUserLocationsCount - qUserLocationsNext) {
+            qUserLocationsNext = 0;
+        }
+        pLocations = &qUserLocations[qUserLocationsNext];
+        qUserLocationsNext = (qUserLocationsNext + count) % qUserLocationsCount;
+    }
+    pthread_mutex_unlock(&qUserBufferMutex);
+    return pLocations;
 }
 
+/* Per fix output is only produced at verbose log level, so that the loop
+   over a full batch is skipped entirely otherwise */
 static void print_qLocation_array(qapi_Location_t* qLocationArray, uint32_t length) {
 
-    for (uint32_t i = 0; i < length; i++) {
-        LOC_LOGv("LAT: %d.%d LON: %d.%d ALT: %d.%d ALT_MSL: %d.%d",
-            (int)qLocationArray[i].latitude,
-            (abs((int)(qLocationArray[i].latitude * 100000))) % 100000,
-            (int)qLocationArray[i].longitude,
-            (abs((int)(qLocationArray[i].longitude * 100000))) % 100000,
-            (int)qLocationArray[i].altitude,
-            (abs((int)(qLocationArray[i].altitude * 100))) % 100,
-            (int)qLocationArray[i].altitudeMeanSeaLevel,
-            (abs((int)(qLocationArray[i].altitudeMeanSeaLevel * 100))) % 100);
-
-        LOC_LOGv("SPEED: %d.%d BEAR: %d.%d TIME: 0x%x%x FLAGS: %u",
-            (int)qLocationArray[i].speed,
-            (abs((int)(qLocationArray[i].speed * 100))) % 100,
-            (int)qLocationArray[i].bearing,
-            (abs((int)(qLocationArray[i].bearing * 100))) % 100,
-            (int)(qLocationArray[i].timestamp >> 32),
-            (int)qLocationArray[i].timestamp, qLocationArray[i].flags);
-
-        LOC_LOGv("ACC: %d.%d VERT_ACC: %d.%d SPEED_ACC: %d.%d BEAR_ACC: %d.%d",
-            (int)qLocationArray[i].accuracy,
-            (abs((int)(qLocationArray[i].accuracy * 100))) % 100,
-            (int)qLocationArray[i].verticalAccuracy,
-            (abs((int)(qLocationArray[i].verticalAccuracy * 100))) % 100,
-            (int)qLocationArray[i].speedAccuracy,
-            (abs((int)(qLocationArray[i].speedAccuracy * 100))) % 100,
-            (int)qLocationArray[i].bearingAccuracy,
-            (abs((int)(qLocationArray[i].bearingAccuracy * 100))) % 100);
+    IF_LOC_LOGV {
+        for (uint32_t i = 0; i < length; i++) {
+            LOC_LOGv("LAT: %d.%d LON: %d.%d ALT: %d.%d ALT_MSL: %d.%d",
+                (int)qLocationArray[i].latitude,
+                (abs((int)(qLocationArray[i].latitude * 100000))) % 100000,
+                (int)qLocationArray[i].longitude,
+                (abs((int)(qLocationArray[i].longitude * 100000))) % 100000,
+                (int)qLocationArray[i].altitude,
+                (abs((int)(qLocationArray[i].altitude * 100))) % 100,
+                (int)qLocationArray[i].altitudeMeanSeaLevel,
+                (abs((int)(qLocationArray[i].altitudeMeanSeaLevel * 100))) % 100);
+
+            LOC_LOGv("SPEED: %d.%d BEAR: %d.%d TIME: 0x%x%x FLAGS: %u",
+                (int)qLocationArray[i].speed,
+                (abs((int)(qLocationArray[i].speed * 100))) % 100,
+                (int)qLocationArray[i].bearing,
+                (abs((int)(qLocationArray[i].bearing * 100))) % 100,
+                (int)(qLocationArray[i].timestamp >> 32),
+                (int)qLocationArray[i].timestamp, qLocationArray[i].flags);
+
+            LOC_LOGv("ACC: %d.%d VERT_ACC: %d.%d SPEED_ACC: %d.%d BEAR_ACC: %d.%d",
+                (int)qLocationArray[i].accuracy,
+                (abs((int)(qLocationArray[i].accuracy * 100))) % 100,
+                (int)qLocationArray[i].verticalAccuracy,
+                (abs((int)(qLocationArray[i].verticalAccuracy * 100))) % 100,
+                (int)qLocationArray[i].speedAccuracy,
+                (abs((int)(qLocationArray[i].speedAccuracy * 100))) % 100,
+                (int)qLocationArray[i].bearingAccuracy,
+                (abs((int)(qLocationArray[i].bearingAccuracy * 100))) % 100);
+        }
     }
 }
 
@@ -208,18 +239,10 @@ static void location_collective_response_callback(
     delete[] ids;
 }
 
-static void location_tracking_callback(
-    Location location)
-{
-    qapi_Location_t qLocation = {};
-    bool bIsSingleShot = false;
-
-    // first check if location is valid
-    if (0 == location.flags) {
-        LOC_LOGd("Ignore invalid location");
-        return;
-    }
+/* Stops the single shot session, if the location is for one */
+static bool is_singleshot_location() {
 
+    bool bIsSingleShot = false;
     if (mTimer.isStarted()) {
         LOC_LOGd("Timer was started, meaning this is singleshot");
         if (nullptr != pLocClientApi) {
@@ -230,34 +253,29 @@ static void location_tracking_callback(
         mTimer.stop();
         bIsSingleShot = true;
     }
-    qLocation.size = sizeof(qapi_Location_t);
-    qLocation.timestamp = location.timestamp;
-    qLocation.latitude = location.latitude;
-    qLocation.longitude = location.longitude;
-    qLocation.altitude = location.altitude;
-// TODO
-//    qLocation.altitudeMeanSeaLevel = location.altitudeMeanSeaLevel;
-    qLocation.speed = location.speed;
-    qLocation.bearing = location.bearing;
-    qLocation.accuracy = location.horizontalAccuracy;
-    qLocation.flags = location.flags;
-    qLocation.flags &= ~QAPI_LOCATION_HAS_ALTITUDE_MSL_BIT;
-    qLocation.verticalAccuracy = location.verticalAccuracy;
-    qLocation.speedAccuracy = location.speedAccuracy;
-    qLocation.bearingAccuracy = location.bearingAccuracy;
-
-    print_qLocation_array(&qLocation, 1);
+    return bIsSingleShot;
+}
+
+static void deliver_tracked_location(
+    const qapi_Location_t* pLocation,
+    int32_t index,
+    bool bIsSingleShot)
+{
+    print_qLocation_array((qapi_Location_t*)pLocation, 1);
     if (bIsSingleShot) {
         LOC_LOGd("Invoking Singleshot Callback");
         if (qLocationCallbacks.singleShotCb) {
-            qLocationCallbacks.singleShotCb(qLocation, QAPI_LOCATION_ERROR_SUCCESS);
+            qLocationCallbacks.singleShotCb(*pLocation, QAPI_LOCATION_ERROR_SUCCESS);
         } else {
             LOC_LOGe("No singleshot cb registered");
         }
+    } else if (index >= 0 && qLocationCallbacks.trackingIndexCb) {
+        LOC_LOGd("Invoking Tracking Index Callback, index %d", index);
+        qLocationCallbacks.trackingIndexCb((uint32_t)index);
     } else {
         LOC_LOGd("Invoking Tracking Callback");
         if (qLocationCallbacks.trackingCb) {
-            qLocationCallbacks.trackingCb(qLocation);
+            qLocationCallbacks.trackingCb(*pLocation);
         }
         else {
             LOC_LOGe("No tracking cb registered");
@@ -265,11 +283,99 @@ static void location_tracking_callback(
     }
 }
 
+static void location_tracking_callback(
+    const Location& location)
+{
+    qapi_Location_t qLocation;
+    int32_t index;
+
+    // first check if location is valid
+    if (0 == location.flags) {
+        LOC_LOGd("Ignore invalid location");
+        return;
+    }
+
+    bool bIsSingleShot = is_singleshot_location();
+    qapi_Location_t* pLocation = get_user_location(&qLocation, &index);
+    pLocation->size = sizeof(qapi_Location_t);
+    pLocation->timestamp = location.timestamp;
+    pLocation->latitude = location.latitude;
+    pLocation->longitude = location.longitude;
+    pLocation->altitude = location.altitude;
+// TODO
+//    pLocation->altitudeMeanSeaLevel = location.altitudeMeanSeaLevel;
+    pLocation->speed = location.speed;
+    pLocation->bearing = location.bearing;
+    pLocation->accuracy = location.horizontalAccuracy;
+    pLocation->flags = location.flags;
+    pLocation->flags &= ~QAPI_LOCATION_HAS_ALTITUDE_MSL_BIT;
+    pLocation->verticalAccuracy = location.verticalAccuracy;
+    pLocation->speedAccuracy = location.speedAccuracy;
+    pLocation->bearingAccuracy = location.bearingAccuracy;
+
+    deliver_tracked_location(pLocation, index, bIsSingleShot);
+}
+
+/* Converts a batch of locations in one pass, without any per fix logging */
+static void convert_locations(
+    const vector<Location>& locations,
+    qapi_Location_t* pLocations)
+{
+    const size_t count = locations.size();
+    for (size_t i = 0; i < count; i++) {
+        const Location& location = locations[i];
+        qapi_Location_t& qLocation = pLocations[i];
+        qLocation.size = sizeof(qapi_Location_t);
+        qLocation.flags = location.flags & ~QAPI_LOCATION_HAS_ALTITUDE_MSL_BIT;
+        qLocation.timestamp = location.timestamp;
+        qLocation.latitude = location.latitude;
+        qLocation.longitude = location.longitude;
+        qLocation.altitude = location.altitude;
+        qLocation.altitudeMeanSeaLevel = 0;
+        qLocation.speed = location.speed;
+        qLocation.bearing = location.bearing;
+        qLocation.accuracy = location.horizontalAccuracy;
+        qLocation.verticalAccuracy = location.verticalAccuracy;
+        qLocation.speedAccuracy = location.speedAccuracy;
+        qLocation.bearingAccuracy = location.bearingAccuracy;
+    }
+}
+
+/* Converted batch, kept across callbacks so its storage is reused */
+static vector<qapi_Location_t> qBatchedLocations;
+
+static void location_batching_callback(
+    const std::vector<Location>& locations,
+    BatchingStatus batchStatus)
+{
+    size_t count = locations.size();
+
+    LOC_LOGd("Batch of %zu locations, status %d", count, batchStatus);
+    if (0 == count) {
+        return;
+    }
+    if (NULL == qLocationCallbacks.batchingCb) {
+        LOC_LOGe("No batching cb registered");
+        return;
+    }
+
+    qapi_Location_t* pLocations = get_user_locations(count);
+    if (nullptr == pLocations) {
+        qBatchedLocations.resize(count);
+        pLocations = qBatchedLocations.data();
+    }
+    convert_locations(locations, pLocations);
+    print_qLocation_array(pLocations, count);
+
+    LOC_LOGd("Invoking Batching Callback");
+    qLocationCallbacks.batchingCb(count, pLocations);
+}
+
 static void gnss_location_tracking_callback(
-    GnssLocation gnsslocation)
+    const GnssLocation& gnsslocation)
 {
-    qapi_Location_t qLocation = {};
-    bool bIsSingleShot = false;
+    qapi_Location_t qLocation;
+    int32_t index;
 
     // first check if location is valid
     if (0 == gnsslocation.flags) {
@@ -277,50 +383,26 @@ static void gnss_location_tracking_callback(
         return;
     }
 
-    if (mTimer.isStarted()) {
-        LOC_LOGd("Timer was started, meaning this is singleshot");
-        if (nullptr != pLocClientApi) {
-            LOC_LOGd("Stop singleshot session");
-            pLocClientApi->stopPositionSession();
-        }
-        LOC_LOGd("Stop singleshot timer");
-        mTimer.stop();
-        bIsSingleShot = true;
-    }
-    qLocation.size = sizeof(qapi_Location_t);
-    qLocation.timestamp = gnsslocation.timestamp;
-    qLocation.latitude = gnsslocation.latitude;
-    qLocation.longitude = gnsslocation.longitude;
-    qLocation.altitude = gnsslocation.altitude;
-    qLocation.altitudeMeanSeaLevel = gnsslocation.altitudeMeanSeaLevel;
-    qLocation.speed = gnsslocation.speed;
-    qLocation.bearing = gnsslocation.bearing;
-    qLocation.accuracy = gnsslocation.horizontalAccuracy;
-    qLocation.flags = gnsslocation.flags;
+    bool bIsSingleShot = is_singleshot_location();
+    qapi_Location_t* pLocation = get_user_location(&qLocation, &index);
+    pLocation->size = sizeof(qapi_Location_t);
+    pLocation->timestamp = gnsslocation.timestamp;
+    pLocation->latitude = gnsslocation.latitude;
+    pLocation->longitude = gnsslocation.longitude;
+    pLocation->altitude = gnsslocation.altitude;
+    pLocation->altitudeMeanSeaLevel = gnsslocation.altitudeMeanSeaLevel;
+    pLocation->speed = gnsslocation.speed;
+    pLocation->bearing = gnsslocation.bearing;
+    pLocation->accuracy = gnsslocation.horizontalAccuracy;
+    pLocation->flags = gnsslocation.flags;
     if (gnsslocation.gnssInfoFlags & GNSS_LOCATION_INFO_ALTITUDE_MEAN_SEA_LEVEL_BIT) {
-        qLocation.flags |= QAPI_LOCATION_HAS_ALTITUDE_MSL_BIT;
+        pLocation->flags |= QAPI_LOCATION_HAS_ALTITUDE_MSL_BIT;
     }
-    qLocation.verticalAccuracy = gnsslocation.verticalAccuracy;
-    qLocation.speedAccuracy = gnsslocation.speedAccuracy;
-    qLocation.bearingAccuracy = gnsslocation.bearingAccuracy;
+    pLocation->verticalAccuracy = gnsslocation.verticalAccuracy;
+    pLocation->speedAccuracy = gnsslocation.speedAccuracy;
+    pLocation->bearingAccuracy = gnsslocation.bearingAccuracy;
 
-    print_qLocation_array(&qLocation, 1);
-    if (bIsSingleShot) {
-        LOC_LOGd("Invoking Singleshot Callback");
-        if (qLocationCallbacks.singleShotCb) {
-            qLocationCallbacks.singleShotCb(qLocation, QAPI_LOCATION_ERROR_SUCCESS);
-        } else {
-            LOC_LOGe("No singleshot cb registered");
-        }
-    } else {
-        LOC_LOGd("Invoking Tracking Callback");
-        if (qLocationCallbacks.trackingCb) {
-            qLocationCallbacks.trackingCb(qLocation);
-        }
-        else {
-            LOC_LOGe("No tracking cb registered");
-        }
-    }
+    deliver_tracked_location(pLocation, index, bIsSingleShot);
 }
 
 static void loc_passive_capabilities_callback(
@@ -447,7 +529,14 @@ extern "C" {
 
         do
         {
-            qLocationCallbacks = *pCallbacks;
+            // a client built against an older qapi_Location_Callbacks_t
+            // has no tracking index callback
+            size_t callbacksSize = sizeof(qapi_Location_Callbacks_t);
+            if (pCallbacks->size < callbacksSize) {
+                callbacksSize = offsetof(qapi_Location_Callbacks_t, trackingIndexCb);
+            }
+            memset(&qLocationCallbacks, 0, sizeof(qLocationCallbacks));
+            memcpy(&qLocationCallbacks, pCallbacks, callbacksSize);
             if (nullptr == pLocClientApi) {
                 pLocClientApi = new LocationClientApi(
                     location_capabilities_callback);
@@ -511,7 +600,27 @@ extern "C" {
         uint8_t* pUserBuffer,
         size_t bufferSize)
     {
-        return QAPI_LOCATION_ERROR_NOT_SUPPORTED;
+        qapi_Location_Error_t retVal = QAPI_LOCATION_ERROR_SUCCESS;
+
+        LOC_LOGd("qapi_Loc_Set_User_Buffer! clientId %d, pUserBuffer %p, bufferSize %zu",
+            clientId, pUserBuffer, bufferSize);
+
+        pthread_mutex_lock(&qUserBufferMutex);
+        if (NULL == pUserBuffer) {
+            qUserLocations = nullptr;
+            qUserLocationsCount = 0;
+            qUserLocationsNext = 0;
+        } else if (bufferSize < sizeof(qapi_Location_t) ||
+                   0 != ((uintptr_t)pUserBuffer % alignof(qapi_Location_t))) {
+            LOC_LOGe("user buffer can not hold an aligned qapi_Location_t");
+            retVal = QAPI_LOCATION_ERROR_INVALID_PARAMETER;
+        } else {
+            qUserLocations = (qapi_Location_t*)pUserBuffer;
+            qUserLocationsCount = bufferSize / sizeof(qapi_Location_t);
+            qUserLocationsNext = 0;
+        }
+        pthread_mutex_unlock(&qUserBufferMutex);
+        return retVal;
     }
 
     qapi_Location_Error_t qapi_Loc_Start_Tracking(
@@ -591,14 +700,71 @@ extern "C" {
         const qapi_Location_Options_t* pOptions,
         uint32_t* pSessionId)
     {
-        return QAPI_LOCATION_ERROR_NOT_SUPPORTED;
+        qapi_Location_Error_t retVal =
+            QAPI_LOCATION_ERROR_SUCCESS;
+
+        LOC_LOGd("qapi_Loc_Start_Batching! pOptions=%p pSessionId=%p clientId=%d",
+            pOptions, pSessionId, clientId);
+
+        pthread_mutex_lock(&qMutex);
+        do {
+            if (NULL == pOptions)
+            {
+                LOC_LOGe("pOptions NULL");
+                retVal = QAPI_LOCATION_ERROR_INVALID_PARAMETER;
+                break;
+            }
+            if (NULL == qLocationCallbacks.batchingCb)
+            {
+                LOC_LOGe("No batching cb registered");
+                retVal = QAPI_LOCATION_ERROR_CALLBACK_MISSING;
+                break;
+            }
+
+            LOC_LOGd("qapi_Loc_Start_Batching! minInterval=%d minDistance=%d",
+                pOptions->minInterval,
+                pOptions->minDistance);
+
+            if (nullptr != pLocClientApi) {
+                bool ret;
+                ret = pLocClientApi->startRoutineBatchingSession(
+                        pOptions->minInterval,
+                        pOptions->minDistance,
+                        location_batching_callback,
+                        location_response_callback);
+                if (!ret) {
+                    retVal = QAPI_LOCATION_ERROR_GENERAL_FAILURE;
+                }
+            } else {
+                retVal = QAPI_LOCATION_ERROR_GENERAL_FAILURE;
+            }
+        } while (0);
+        if (NULL != pSessionId) {
+            *pSessionId = 1;
+        }
+        pthread_mutex_unlock(&qMutex);
+        return retVal;
     }
 
     qapi_Location_Error_t qapi_Loc_Stop_Batching(
         qapi_loc_client_id clientId,
         uint32_t sessionId)
     {
-        return QAPI_LOCATION_ERROR_NOT_SUPPORTED;
+        qapi_Location_Error_t retVal =
+            QAPI_LOCATION_ERROR_SUCCESS;
+
+        LOC_LOGv("qapi_Loc_Stop_Batching! clientId %d, sessionId %d",
+            clientId, sessionId);
+
+        pthread_mutex_lock(&qMutex);
+
+        if (nullptr != pLocClientApi) {
+            pLocClientApi->stopBatchingSession();
+        } else {
+            retVal = QAPI_LOCATION_ERROR_GENERAL_FAILURE;
+        }
+        pthread_mutex_unlock(&qMutex);
+        return retVal;
     }
 
     qapi_Location_Error_t qapi_Loc_Update_Batching_Options(
@@ -606,7 +772,8 @@ extern "C" {
         uint32_t sessionId,
         const qapi_Location_Options_t* pOptions)
     {
-        return QAPI_LOCATION_ERROR_NOT_SUPPORTED;
+        // a running routine batching session takes the new options in place
+        return qapi_Loc_Start_Batching(clientId, pOptions, NULL);
     }
 
     qapi_Location_Error_t qapi_Loc_Get_Batched_Locations(
@@ -43,6 +43,8 @@
 #include <gps_extended.h>
 #include "loc_pla.h"
 #include <loc_cfg.h>
+#include <loc_misc_utils.h>
+#include <LocConvUtils.h>
 #include <LocContext.h>
 #include <SynergyLocApi.h>
 
@@ -61,9 +63,24 @@ using namespace loc_core;
     return LOC_API_ADAPTER_ERR_UNSUPPORTED;                   \
 }
 
+/* Time an asynchronous SLL request is given to complete */
+#define SLL_ASYNC_REQ_TIMEOUT_MS (5000)
+
+/* True if the SLL provides the asynchronous version of a command */
+#define SLL_ASYNC_SUPPORTED(cmd) \
+    ((nullptr != sllAsyncReqIf) && (nullptr != sllAsyncReqIf->cmd))
+
 typedef const SllInterfaceReq* (*get_sll_if_api_t)
             (const SllInterfaceEvent* eventCallback, void *context);
 
+/* Returns the result of an SLL request to the adapter */
+static void respondToAdapter(LocApiResponse *adapterResponse, enum loc_api_adapter_err rtv) {
+    if (adapterResponse != NULL) {
+        adapterResponse->returnToSender((LOC_API_ADAPTER_ERR_SUCCESS == rtv) ?
+                LOCATION_ERROR_SUCCESS : LOCATION_ERROR_GENERAL_FAILURE);
+    }
+}
+
 /**
    Engine Up Event, this is receive from SLL Hardware.
    This event indicates Engine is ready to accept command
@@ -1231,7 +1248,8 @@ SynergyLocApi::SynergyLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask,
     mSlMask(0), mInSession(false), mPowerMode(GNSS_POWER_MODE_INVALID),
     mEngineOn(false), mMeasurementsStarted(false),
     mIsMasterRegistered(false), mMasterRegisterNotSupported(false),
-    mSvMeasurementSet(nullptr)
+    mSvMeasurementSet(nullptr), sllAsyncReqIf(nullptr),
+    mSllAsyncReqId(0), mSllAsyncReqTimer(*this)
 {
     const char * libName = nullptr;
     void *handle = nullptr;
@@ -1263,6 +1281,14 @@ SynergyLocApi::SynergyLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask,
         if (getter != nullptr) {
             sllReqIf = (getter)(&sllEventCb, ((void *)this));
             if (sllReqIf != nullptr) {
+                // optional, SLL libs without it are only used with blocking requests
+                get_sll_async_if_api_t asyncGetter =
+                        (get_sll_async_if_api_t)dlsym(handle, "get_sll_async_if_api");
+                if (asyncGetter != nullptr) {
+                    sllAsyncReqIf = (asyncGetter)(sllAsyncReqComplete, ((void *)this));
+                }
+                LOC_LOGd("%s async requests %ssupported", libName,
+                         (sllAsyncReqIf != nullptr) ? "" : "not ");
                 return;
             } else {
                 LOC_LOGe("%s SLL lib provided Command Interface as NULL", libName);
@@ -1415,9 +1441,135 @@ enum loc_api_adapter_err SynergyLocApi::close() {
     } else {
         rtv = LOC_API_ADAPTER_ERR_UNKNOWN;
     }
+    // their completions will not come any more
+    cancelSllAsyncReqs();
     return rtv;
 }
 
+/**
+   Make an SLL request, asynchronously if the SLL supports it.
+
+   @param async[Input]         Make the request with the asynchronous command.
+   @param req[Input]           Makes the request with the request ID it is given,
+                               or with the blocking command if it is 0.
+   @param continuation[Input]  Called with the result of the request.
+
+   @return
+        None.
+
+   @dependencies
+       Only to be called in the LocApi MsgTask.
+*/
+void SynergyLocApi::sendSllReq(bool async, const SllReq& req, SllReqContinuation continuation) {
+
+    if (!async) {
+        enum loc_api_adapter_err rtv = req(0);
+        if (nullptr != continuation) {
+            continuation(rtv);
+        }
+        return;
+    }
+
+    // 0 means a blocking request
+    if (0 == ++mSllAsyncReqId) {
+        ++mSllAsyncReqId;
+    }
+    uint32_t reqId = mSllAsyncReqId;
+    uint64_t deadlineMs = getBootTimeMilliSec() + SLL_ASYNC_REQ_TIMEOUT_MS;
+
+    // the completion runs in this MsgTask, so it always finds the request,
+    // even if the SLL completes it before returning
+    mSllAsyncReqs[reqId] = {deadlineMs, continuation};
+    enum loc_api_adapter_err rtv = req(reqId);
+    if (LOC_API_ADAPTER_ERR_SUCCESS != rtv) {
+        LOC_LOGe("req %u not accepted, error: %d", reqId, rtv);
+        completeSllAsyncReq(reqId, rtv);
+        return;
+    }
+
+    if (0 == mSllAsyncReqTimer.getDueMs() || deadlineMs < mSllAsyncReqTimer.getDueMs()) {
+        mSllAsyncReqTimer.start(deadlineMs);
+    }
+}
+
+/* Called in any SLL context */
+void SynergyLocApi::sllAsyncReqComplete(uint32_t reqId, enum loc_api_adapter_err status,
+                                        void *context) {
+    SynergyLocApi *api = (SynergyLocApi *)context;
+    if (nullptr != api) {
+        api->sendMsg(new LocApiMsg([api, reqId, status] () {
+            api->completeSllAsyncReq(reqId, status);
+        }));
+    }
+}
+
+void SynergyLocApi::completeSllAsyncReq(uint32_t reqId, enum loc_api_adapter_err status) {
+    auto it = mSllAsyncReqs.find(reqId);
+    // already timed out or cancelled
+    if (it == mSllAsyncReqs.end()) {
+        return;
+    }
+    SllReqContinuation continuation = std::move(it->second.continuation);
+    mSllAsyncReqs.erase(it);
+    if (nullptr != continuation) {
+        continuation(status);
+    }
+}
+
+void SynergyLocApi::expireSllAsyncReqs() {
+    uint64_t nowMs = getBootTimeMilliSec();
+    uint64_t soonestMs = UINT64_MAX;
+    std::vector<uint32_t> expired;
+
+    for (auto& req : mSllAsyncReqs) {
+        if (req.second.deadlineMs <= nowMs) {
+            expired.push_back(req.first);
+        } else if (req.second.deadlineMs < soonestMs) {
+            soonestMs = req.second.deadlineMs;
+        }
+    }
+
+    if (UINT64_MAX != soonestMs) {
+        mSllAsyncReqTimer.start(soonestMs);
+    }
+    // last, as the continuations may send new requests
+    for (auto reqId : expired) {
+        LOC_LOGe("req %u timed out", reqId);
+        completeSllAsyncReq(reqId, LOC_API_ADAPTER_ERR_TIMEOUT);
+    }
+}
+
+void SynergyLocApi::cancelSllAsyncReqs() {
+    mSllAsyncReqTimer.stop();
+    std::vector<uint32_t> cancelled;
+    for (auto& req : mSllAsyncReqs) {
+        cancelled.push_back(req.first);
+    }
+    for (auto reqId : cancelled) {
+        completeSllAsyncReq(reqId, LOC_API_ADAPTER_ERR_ENGINE_DOWN);
+    }
+}
+
+void SllAsyncReqTimer::start(uint64_t dueMs) {
+    uint64_t nowMs = getBootTimeMilliSec();
+    LocTimer::stop();
+    mDueMs = dueMs;
+    LocTimer::start((dueMs > nowMs) ? (uint32_t)(dueMs - nowMs) : 1, false);
+}
+
+void SllAsyncReqTimer::stop() {
+    mDueMs = 0;
+    LocTimer::stop();
+}
+
+// Called in the context of LocTimer thread
+void SllAsyncReqTimer::timeOutCallback() {
+    mApi.sendMsg(new LocApiMsg([this] () {
+        mDueMs = 0;
+        mApi.expireSllAsyncReqs();
+    }));
+}
+
 
 /**
    start positioning session
@@ -1434,8 +1586,6 @@ enum loc_api_adapter_err SynergyLocApi::close() {
 void SynergyLocApi::startFix(const LocPosMode& fixCriteria, LocApiResponse *adapterResponse) {
 
     sendMsg(new LocApiMsg([this, fixCriteria, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
         sllPosMode posMode;
 
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllStartFix)) {
@@ -1448,15 +1598,9 @@ void SynergyLocApi::startFix(const LocPosMode& fixCriteria, LocApiResponse *adap
             posMode.powerMode = fixCriteria.powerMode;
             posMode.timeBetweenMeasurements = fixCriteria.timeBetweenMeasurements;
 
-            rtv = sllReqIf->sllStartFix(posMode, ((void *)this));
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllStartFix(posMode, adapterResponse);
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 
@@ -1476,26 +1620,63 @@ void SynergyLocApi::startFix(const LocPosMode& fixCriteria, LocApiResponse *adap
 void SynergyLocApi::stopFix(LocApiResponse *adapterResponse) {
 
     sendMsg(new LocApiMsg([this, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllStopFix)) {
-
-            rtv = sllReqIf->sllStopFix((void *)this);
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllStopFix(adapterResponse);
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 }
 
 
+/**
+   Start a session of SLL, asynchronously if the SLL supports it.
+
+   @param sllPosMode[Input]      Session parameters.
+   @param LocApiResponse[Input]  LOC API Response API.
+
+   @return
+        None.
+
+   @dependencies
+       Only to be called in the LocApi MsgTask.
+*/
+void SynergyLocApi::sendSllStartFix(const sllPosMode& posMode,
+                                    LocApiResponse *adapterResponse) {
+
+    sendSllReq(SLL_ASYNC_SUPPORTED(sllStartFixAsync),
+            [this, posMode] (uint32_t reqId) mutable {
+        return (0 != reqId) ?
+                sllAsyncReqIf->sllStartFixAsync(reqId, posMode, ((void *)this)) :
+                sllReqIf->sllStartFix(posMode, ((void *)this));
+    }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+        respondToAdapter(adapterResponse, rtv);
+    });
+}
+
+/**
+   Stop the session of SLL, asynchronously if the SLL supports it.
+
+   @param LocApiResponse[Input]  LOC API Response API.
+
+   @return
+        None.
+
+   @dependencies
+       Only to be called in the LocApi MsgTask.
+*/
+void SynergyLocApi::sendSllStopFix(LocApiResponse *adapterResponse) {
+
+    sendSllReq(SLL_ASYNC_SUPPORTED(sllStopFixAsync), [this] (uint32_t reqId) {
+        return (0 != reqId) ?
+                sllAsyncReqIf->sllStopFixAsync(reqId, ((void *)this)) :
+                sllReqIf->sllStopFix((void *)this);
+    }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+        respondToAdapter(adapterResponse, rtv);
+    });
+}
+
+
 /**
    set the positioning fix criteria
 
@@ -1582,13 +1763,9 @@ void SynergyLocApi::injectPosition(const Location& location, bool onDemandCpi) {
     sendMsg(new LocApiMsg([this, location, onDemandCpi] () {
 
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllInjectPosition)) {
-            enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
             GnssLocationInfoNotification locInfo;
             locInfo.location = location;
-            rtv = sllReqIf->sllInjectPosition(locInfo, onDemandCpi, ((void *)this));
-            if (LOC_API_ADAPTER_ERR_SUCCESS != rtv) {
-                LOC_LOGe ("Error: %d", rtv);
-            }
+            sendSllInjectPosition(locInfo, onDemandCpi);
         }
 
     }));
@@ -1617,16 +1794,7 @@ int SynergyLocApi::getNumSvUsed (uint64_t svUsedIdsMask, int totalSvCntInOneCons
         return 0;
     }
 
-    int numSvUsed = 0;
-    uint64_t mask = 0x1;
-    for (int i = 0; i < totalSvCntInOneConstellation; i++) {
-        if (svUsedIdsMask & mask) {
-            numSvUsed++;
-        }
-        mask <<= 1;
-    }
-
-    return numSvUsed;
+    return loc_util::countSvUsedInMask(svUsedIdsMask, totalSvCntInOneConstellation);
 }
 
 
@@ -1647,16 +1815,40 @@ void SynergyLocApi::injectPosition(const GnssLocationInfoNotification &locationI
 
     sendMsg(new LocApiMsg([this, locationInfo, onDemandCpi] () {
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllInjectPosition)){
-            enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-            rtv = sllReqIf->sllInjectPosition(locationInfo, onDemandCpi, ((void *)this));
-            if (LOC_API_ADAPTER_ERR_SUCCESS != rtv) {
-                LOC_LOGe ("Error: %d", rtv);
-            }
+            sendSllInjectPosition(locationInfo, onDemandCpi);
         }
 
     }));
 }
 
+/**
+    Inject a position to SLL, asynchronously if the SLL supports it.
+
+   @param GnssLocationInfoNotification[Input]  Position to inject.
+   @param onDemandCpi[Input]  Indicate CPI demanded or not.
+
+   @return
+        None.
+
+   @dependencies
+       Only to be called in the LocApi MsgTask.
+*/
+void SynergyLocApi::sendSllInjectPosition(const GnssLocationInfoNotification &locationInfo,
+    bool onDemandCpi) {
+
+    sendSllReq(SLL_ASYNC_SUPPORTED(sllInjectPositionAsync),
+            [this, locationInfo, onDemandCpi] (uint32_t reqId) {
+        return (0 != reqId) ?
+                sllAsyncReqIf->sllInjectPositionAsync(reqId, locationInfo, onDemandCpi,
+                        ((void *)this)) :
+                sllReqIf->sllInjectPosition(locationInfo, onDemandCpi, ((void *)this));
+    }, [] (enum loc_api_adapter_err rtv) {
+        if (LOC_API_ADAPTER_ERR_SUCCESS != rtv) {
+            LOC_LOGe ("Error: %d", rtv);
+        }
+    });
+}
+
 
 
 /**
@@ -1675,20 +1867,17 @@ void
 SynergyLocApi::deleteAidingData(const GnssAidingData& data, LocApiResponse *adapterResponse) {
 
     sendMsg(new LocApiMsg([this, data, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllDeleteAidingData)) {
-            enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-            rtv = sllReqIf->sllDeleteAidingData(data, ((void *)this));
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllReq(SLL_ASYNC_SUPPORTED(sllDeleteAidingDataAsync),
+                    [this, data] (uint32_t reqId) {
+                return (0 != reqId) ?
+                        sllAsyncReqIf->sllDeleteAidingDataAsync(reqId, data, ((void *)this)) :
+                        sllReqIf->sllDeleteAidingData(data, ((void *)this));
+            }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+                respondToAdapter(adapterResponse, rtv);
+            });
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 }
@@ -2301,21 +2490,20 @@ void SynergyLocApi::setConstrainedTuncMode(bool enabled,
                                            LocApiResponse* adapterResponse) {
 
     sendMsg(new LocApiMsg([this, enabled, tuncConstraint, energyBudget, adapterResponse] () {
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-    enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
 
     if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllSetConstrainedTuncMode)) {
-
-        rtv = sllReqIf->sllSetConstrainedTuncMode(enabled, tuncConstraint,
-                    energyBudget, ((void *)this));
-        if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-            err = LOCATION_ERROR_SUCCESS;
-        }
-    } else {
-        err = LOCATION_ERROR_NOT_SUPPORTED;
-    }
-    if (adapterResponse != NULL) {
-        adapterResponse->returnToSender(err);
+        sendSllReq(SLL_ASYNC_SUPPORTED(sllSetConstrainedTuncModeAsync),
+                [this, enabled, tuncConstraint, energyBudget] (uint32_t reqId) {
+            return (0 != reqId) ?
+                    sllAsyncReqIf->sllSetConstrainedTuncModeAsync(reqId, enabled,
+                            tuncConstraint, energyBudget, ((void *)this)) :
+                    sllReqIf->sllSetConstrainedTuncMode(enabled, tuncConstraint,
+                            energyBudget, ((void *)this));
+        }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+            respondToAdapter(adapterResponse, rtv);
+        });
+    } else if (adapterResponse != NULL) {
+        adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
     }
     }));
 }
@@ -2336,23 +2524,21 @@ void SynergyLocApi::setPositionAssistedClockEstimatorMode(bool enabled,
                                                           LocApiResponse* adapterResponse) {
     sendMsg(new LocApiMsg([this, enabled, adapterResponse] () {
 
-    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-    enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-
     if ((nullptr != sllReqIf) &&
             (nullptr != sllReqIf->sllSetPositionAssistedClockEstimatorMode)) {
-        rtv = sllReqIf->sllSetPositionAssistedClockEstimatorMode(enabled, ((void *)this));
-        if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-            err = LOCATION_ERROR_SUCCESS;
-        }
-    } else {
-        err = LOCATION_ERROR_NOT_SUPPORTED;
+        sendSllReq(SLL_ASYNC_SUPPORTED(sllSetPositionAssistedClockEstimatorModeAsync),
+                [this, enabled] (uint32_t reqId) {
+            return (0 != reqId) ?
+                    sllAsyncReqIf->sllSetPositionAssistedClockEstimatorModeAsync(reqId,
+                            enabled, ((void *)this)) :
+                    sllReqIf->sllSetPositionAssistedClockEstimatorMode(enabled, ((void *)this));
+        }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+            respondToAdapter(adapterResponse, rtv);
+        });
+    } else if (adapterResponse != NULL) {
+        adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
     }
 
-    if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
-        }
-
     }));
 }
 
@@ -2572,19 +2758,22 @@ SynergyLocApi::setConstellationControl(const GnssSvTypeConfig& config,
                                        LocApiResponse *adapterResponse) {
 
     sendMsg(new LocApiMsg([this, config, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
 
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllSetConstellationControl)) {
-            rtv = sllReqIf->sllSetConstellationControl(config, (void *)this);
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            } else {
-               LOC_LOGe ("Error: %d", rtv);
-            }
-        }
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllReq(SLL_ASYNC_SUPPORTED(sllSetConstellationControlAsync),
+                    [this, config] (uint32_t reqId) {
+                return (0 != reqId) ?
+                        sllAsyncReqIf->sllSetConstellationControlAsync(reqId, config,
+                                (void *)this) :
+                        sllReqIf->sllSetConstellationControl(config, (void *)this);
+            }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+                if (LOC_API_ADAPTER_ERR_SUCCESS != rtv) {
+                   LOC_LOGe ("Error: %d", rtv);
+                }
+                respondToAdapter(adapterResponse, rtv);
+            });
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_GENERAL_FAILURE);
         }
     }));
 }
@@ -2632,19 +2821,21 @@ SynergyLocApi::getConstellationControl() {
 void
 SynergyLocApi::resetConstellationControl(LocApiResponse *adapterResponse) {
     sendMsg(new LocApiMsg([this, adapterResponse] () {
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
 
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllResetConstellationControl)) {
-            rtv = sllReqIf->sllResetConstellationControl((void *)this);
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            } else {
-               LOC_LOGe ("Error: %d", rtv);
-            }
-        }
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllReq(SLL_ASYNC_SUPPORTED(sllResetConstellationControlAsync),
+                    [this] (uint32_t reqId) {
+                return (0 != reqId) ?
+                        sllAsyncReqIf->sllResetConstellationControlAsync(reqId, (void *)this) :
+                        sllReqIf->sllResetConstellationControl((void *)this);
+            }, [adapterResponse] (enum loc_api_adapter_err rtv) {
+                if (LOC_API_ADAPTER_ERR_SUCCESS != rtv) {
+                   LOC_LOGe ("Error: %d", rtv);
+                }
+                respondToAdapter(adapterResponse, rtv);
+            });
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_GENERAL_FAILURE);
         }
     }));
 }
@@ -2654,8 +2845,6 @@ SynergyLocApi::startTimeBasedTracking(const TrackingOptions& options,
          LocApiResponse* adapterResponse) {
 
     sendMsg(new LocApiMsg([this, options, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
         sllPosMode posMode;
 
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllStartFix)) {
@@ -2669,15 +2858,9 @@ SynergyLocApi::startTimeBasedTracking(const TrackingOptions& options,
             posMode.powerMode = GNSS_POWER_MODE_M2;
             posMode.timeBetweenMeasurements = 1000;
 
-            rtv = sllReqIf->sllStartFix(posMode, ((void *)this));
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllStartFix(posMode, adapterResponse);
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 
@@ -2687,21 +2870,10 @@ void
 SynergyLocApi::stopTimeBasedTracking(LocApiResponse* adapterResponse){
 
     sendMsg(new LocApiMsg([this, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllStopFix)) {
-
-            rtv = sllReqIf->sllStopFix((void *)this);
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllStopFix(adapterResponse);
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 }
@@ -2711,8 +2883,6 @@ SynergyLocApi::startDistanceBasedTracking(uint32_t sessionId,
         const LocationOptions& options, LocApiResponse* adapterResponse) {
 
     sendMsg(new LocApiMsg([this, options, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
         sllPosMode posMode;
 
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllStartFix)) {
@@ -2726,15 +2896,9 @@ SynergyLocApi::startDistanceBasedTracking(uint32_t sessionId,
             posMode.powerMode = GNSS_POWER_MODE_M2;
             posMode.timeBetweenMeasurements = 1000;
 
-            rtv = sllReqIf->sllStartFix(posMode, ((void *)this));
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllStartFix(posMode, adapterResponse);
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 }
@@ -2744,21 +2908,10 @@ SynergyLocApi::stopDistanceBasedTracking(uint32_t sessionId,
          LocApiResponse* adapterResponse) {
 
     sendMsg(new LocApiMsg([this, adapterResponse] () {
-        LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
-        enum loc_api_adapter_err rtv = LOC_API_ADAPTER_ERR_SUCCESS;
-
         if ((nullptr != sllReqIf) && (nullptr != sllReqIf->sllStopFix)) {
-
-            rtv = sllReqIf->sllStopFix((void *)this);
-            if (LOC_API_ADAPTER_ERR_SUCCESS == rtv) {
-                err = LOCATION_ERROR_SUCCESS;
-            }
-        } else {
-            err = LOCATION_ERROR_NOT_SUPPORTED;
-        }
-
-        if (adapterResponse != NULL) {
-            adapterResponse->returnToSender(err);
+            sendSllStopFix(adapterResponse);
+        } else if (adapterResponse != NULL) {
+            adapterResponse->returnToSender(LOCATION_ERROR_NOT_SUPPORTED);
         }
     }));
 }
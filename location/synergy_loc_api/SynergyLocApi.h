@@ -34,14 +34,37 @@
 #include <loc_sll_interface.h>
 #include <vector>
 #include <functional>
+#include <map>
+#include <LocTimer.h>
 
 
 #define LOC_CLIENT_INVALID_HANDLE_VALUE (NULL)
 
 using Resender = std::function<void()>;
+// makes an SLL request; reqId is 0 for the blocking SllInterfaceReq command,
+// or the request ID to give to the SllInterfaceAsyncReq command
+using SllReq = std::function<enum loc_api_adapter_err(uint32_t reqId)>;
+// continuation of an SLL request, with its result
+using SllReqContinuation = std::function<void(enum loc_api_adapter_err status)>;
 
 using namespace std;
 using namespace loc_core;
+using loc_util::LocTimer;
+
+class SynergyLocApi;
+
+// fires at the time out of the soonest asynchronous SLL request in flight
+class SllAsyncReqTimer : public LocTimer {
+public:
+    inline SllAsyncReqTimer(SynergyLocApi& api) : LocTimer(), mApi(api), mDueMs(0) {}
+    void start(uint64_t dueMs);
+    void stop();
+    inline uint64_t getDueMs() const { return mDueMs; }
+    virtual void timeOutCallback();
+private:
+    SynergyLocApi& mApi;
+    uint64_t mDueMs; // boot time it fires at, 0 when not running
+};
 
 
 /* This class derives from the LocApiBase class.
@@ -65,9 +88,37 @@ private:
     LOC_API_ADAPTER_EVENT_MASK_T mSlMask;
 
     const SllInterfaceReq *sllReqIf;
+    const SllInterfaceAsyncReq *sllAsyncReqIf;
+
+    // asynchronous SLL requests in flight, by request ID; only accessed
+    // in the LocApi MsgTask
+    struct SllAsyncReq {
+        uint64_t deadlineMs;
+        SllReqContinuation continuation;
+    };
+    std::map<uint32_t, SllAsyncReq> mSllAsyncReqs;
+    uint32_t mSllAsyncReqId;
+    SllAsyncReqTimer mSllAsyncReqTimer;
+    friend class SllAsyncReqTimer;
 
     void registerEventMask(LOC_API_ADAPTER_EVENT_MASK_T adapterMask);
 
+    // Makes an SLL request, through the asynchronous command if async is true,
+    // or else the blocking one. The continuation is called in the LocApi MsgTask
+    // with the result, for an asynchronous request once the SLL completes it or
+    // it times out. Only to be called in the LocApi MsgTask.
+    void sendSllReq(bool async, const SllReq& req, SllReqContinuation continuation);
+    /* Called in any SLL context on completion of an asynchronous request */
+    static void sllAsyncReqComplete(uint32_t reqId, enum loc_api_adapter_err status,
+                                    void *context);
+    void completeSllAsyncReq(uint32_t reqId, enum loc_api_adapter_err status);
+    void expireSllAsyncReqs();
+    void cancelSllAsyncReqs();
+    void sendSllStartFix(const sllPosMode& posMode, LocApiResponse *adapterResponse);
+    void sendSllStopFix(LocApiResponse *adapterResponse);
+    void sendSllInjectPosition(const GnssLocationInfoNotification &locationInfo,
+                               bool onDemandCpi);
+
 
 protected:
     virtual enum loc_api_adapter_err
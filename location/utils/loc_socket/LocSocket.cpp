@@ -28,6 +28,8 @@
  */
 #include <unistd.h>
 #include <memory>
+#include <map>
+#include <atomic>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <errno.h>
@@ -43,6 +45,7 @@
 #endif
 
 #include <log_util.h>
+#include <loc_cfg.h>
 #include <LocIpc.h>
 
 namespace loc_util {
@@ -98,6 +101,16 @@ protected:
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr,
                            sizeof(mAddr));
     }
+    inline virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                                 int32_t /* msgId */) const override {
+        serviceLookup();
+        return mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr,
+                            sizeof(mAddr));
+    }
+    inline virtual int sendBatch(const struct iovec msgs[], int count) const override {
+        serviceLookup();
+        return mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
 public:
     inline LocIpcQsockSender(const qsockaddr_ipcr& destAddr) :
             LocIpcSender(),
@@ -150,6 +163,9 @@ public:
     inline virtual const char* getName() const override {
         return mServiceInfo.getName();
     }
+    inline virtual int getRecvFd() const override {
+        return mSock->mSid;
+    }
     inline virtual void abort() const override {
         if (isSendable()) {
             serviceLookup();
@@ -170,10 +186,105 @@ unique_ptr<LocIpcRecver> createLocIpcQrtrRecver(const shared_ptr<ILocIpcListener
 #else
 
 #define SOCKET_TIMEOUT_SEC 2
+#define QRTR_RECV_BATCH_SIZE_DEFAULT 16
+#define QRTR_RECV_BATCH_SIZE_MAX 64
+
+struct QrtrRecvConfig {
+    uint32_t batchSize;
+    uint32_t busyPollUs;
+};
+
+static const QrtrRecvConfig& getQrtrRecvConfig() {
+    static const QrtrRecvConfig sConfig = [] {
+        QrtrRecvConfig config = { QRTR_RECV_BATCH_SIZE_DEFAULT, 0 };
+        loc_param_s_type qrtrConfParamTable[] = {
+            {"QRTR_RECV_BATCH_SIZE", &config.batchSize,  nullptr, 'n'},
+            {"QRTR_BUSY_POLL_USEC",  &config.busyPollUs, nullptr, 'n'}
+        };
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, qrtrConfParamTable);
+        if (0 == config.batchSize || config.batchSize > QRTR_RECV_BATCH_SIZE_MAX) {
+            config.batchSize = QRTR_RECV_BATCH_SIZE_DEFAULT;
+        }
+        LOC_LOGd("recv batch size %u, busy poll %u usec", config.batchSize, config.busyPollUs);
+        return config;
+    }();
+    return sConfig;
+}
 
 static inline __le32 cpu_to_le32(uint32_t x) { return htole32(x); }
 static inline uint32_t le32_to_cpu(__le32 x) { return le32toh(x); }
 
+// Process wide directory of the QRTR servers the name service has announced
+// to any socket of this process. A sender looks its server up here before
+// asking the name service, and follows the server to its new port when it
+// comes back on its node after a restart of the remote subsystem.
+class QrtrServiceDirectory {
+    mutex mLock;
+    map<pair<uint32_t, uint32_t>, sockaddr_qrtr> mServers;
+    atomic<uint32_t> mGeneration;
+    inline QrtrServiceDirectory() : mGeneration(0) {}
+public:
+    static inline QrtrServiceDirectory& get() {
+        static QrtrServiceDirectory sDirectory;
+        return sDirectory;
+    }
+    // changes whenever a server comes or goes
+    inline uint32_t getGeneration() const { return mGeneration.load(); }
+    // instance 0 takes any instance of service
+    bool find(uint32_t service, uint32_t instance, sockaddr_qrtr& addr) {
+        lock_guard<mutex> lock(mLock);
+        auto it = mServers.lower_bound(make_pair(service, instance));
+        if (mServers.end() != it && it->first.first == service &&
+            (0 == instance || it->first.second == instance)) {
+            addr = it->second;
+            return true;
+        }
+        return false;
+    }
+    void update(const struct qrtr_ctrl_pkt& pkt) {
+        const uint32_t cmd = le32_to_cpu(pkt.cmd);
+        const pair<uint32_t, uint32_t> key(le32_to_cpu(pkt.server.service),
+                                           le32_to_cpu(pkt.server.instance));
+        bool changed = false;
+        lock_guard<mutex> lock(mLock);
+        if (QRTR_TYPE_NEW_SERVER == cmd && 0 != key.first) {
+            // a service of 0 ends the answer to a lookup
+            sockaddr_qrtr addr = {AF_QIPCRTR, le32_to_cpu(pkt.server.node),
+                                  le32_to_cpu(pkt.server.port)};
+            auto it = mServers.find(key);
+            if (mServers.end() == it || it->second.sq_node != addr.sq_node ||
+                it->second.sq_port != addr.sq_port) {
+                mServers[key] = addr;
+                changed = true;
+            }
+        } else if (QRTR_TYPE_DEL_SERVER == cmd) {
+            auto it = mServers.find(key);
+            if (mServers.end() != it &&
+                it->second.sq_node == le32_to_cpu(pkt.server.node) &&
+                it->second.sq_port == le32_to_cpu(pkt.server.port)) {
+                mServers.erase(it);
+                changed = true;
+            }
+        } else if (QRTR_TYPE_BYE == cmd || QRTR_TYPE_DEL_CLIENT == cmd) {
+            // BYE takes the whole node down, DEL_CLIENT one port of it
+            const uint32_t node = le32_to_cpu(pkt.client.node);
+            const uint32_t port = le32_to_cpu(pkt.client.port);
+            for (auto it = mServers.begin(); mServers.end() != it; ) {
+                if (it->second.sq_node == node &&
+                    (QRTR_TYPE_BYE == cmd || it->second.sq_port == port)) {
+                    it = mServers.erase(it);
+                    changed = true;
+                } else {
+                    ++it;
+                }
+            }
+        }
+        if (changed) {
+            mGeneration++;
+        }
+    }
+};
+
 class LocIpcQrtrSender : public LocIpcSender {
 protected:
     const ServiceInfo mServiceInfo;
@@ -181,6 +292,10 @@ protected:
     mutable sockaddr_qrtr mAddr;
     mutable struct qrtr_ctrl_pkt mCtrlPkt;
     mutable bool mLookupPending;
+    // directory generation mAddr was last taken from
+    mutable uint32_t mDirGeneration;
+    // set for senders to a service, which follow the server across restarts
+    bool mFollowsServer;
     bool ctrlCmdAndResponse(enum qrtr_pkt_type cmd) const {
         if (mSock->isValid()) {
             int rc = 0;
@@ -196,6 +311,7 @@ protected:
                 while ((len = ::recv(mSock->mSid, &pkt, sizeof(pkt), 0)) > 0) {
                     if (len >= (decltype(len))sizeof(pkt) && 0 != pkt.server.service &&
                             cpu_to_le32(QRTR_TYPE_NEW_SERVER) == pkt.cmd) {
+                        QrtrServiceDirectory::get().update(pkt);
                         mAddr.sq_node = le32_to_cpu(pkt.server.node);
                         mAddr.sq_port = le32_to_cpu(pkt.server.port);
                         LOC_LOGv("server found pkt.cmd %d, service %d, node, %d, port %d",
@@ -214,26 +330,100 @@ protected:
             (mAddr.sq_node != 0 || mAddr.sq_port != 0);
     }
 
-    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
-                                int32_t /* msgId */) const override {
+    inline bool resolveFromDirectory() const {
+        QrtrServiceDirectory& directory = QrtrServiceDirectory::get();
+        mDirGeneration = directory.getGeneration();
+        sockaddr_qrtr addr;
+        bool found = directory.find(mServiceInfo.getServiceId(),
+                                    mServiceInfo.getInstanceId(), addr);
+        if (found) {
+            mAddr.sq_node = addr.sq_node;
+            mAddr.sq_port = addr.sq_port;
+        }
+        return found;
+    }
+    inline void lookupOnce() const {
         if (mLookupPending) {
             mLookupPending = false;
-            ctrlCmdAndResponse(QRTR_TYPE_NEW_LOOKUP);
+            if (!resolveFromDirectory()) {
+                ctrlCmdAndResponse(QRTR_TYPE_NEW_LOOKUP);
+            }
+        } else if (mFollowsServer &&
+                   QrtrServiceDirectory::get().getGeneration() != mDirGeneration) {
+            resolveFromDirectory();
+        }
+    }
+    // The lookup of this socket keeps the name service announcing the comings
+    // and goings of the server to it. Takes in those that are pending, and
+    // nothing else, without blocking.
+    inline void takeInCtrlMsgs() const {
+        struct qrtr_ctrl_pkt pkt;
+        sockaddr_qrtr from;
+        socklen_t size = sizeof(from);
+        ssize_t len;
+        while ((len = ::recvfrom(mSock->mSid, &pkt, sizeof(pkt), MSG_PEEK | MSG_DONTWAIT,
+                                 (struct sockaddr*)&from, &size)) >= 0 &&
+               QRTR_PORT_CTRL == from.sq_port) {
+            ::recv(mSock->mSid, &pkt, sizeof(pkt), MSG_DONTWAIT);
+            if (sizeof(pkt) == (size_t)len) {
+                QrtrServiceDirectory::get().update(pkt);
+            }
+            size = sizeof(from);
+        }
+    }
+    // after a failed send; true if the server has moved on to a new address
+    // since, in which case the send is worth another try
+    inline bool followServer() const {
+        if (!mFollowsServer) {
+            return false;
         }
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        takeInCtrlMsgs();
+        const sockaddr_qrtr lastAddr = mAddr;
+        return resolveFromDirectory() &&
+                (lastAddr.sq_node != mAddr.sq_node || lastAddr.sq_port != mAddr.sq_port);
+    }
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
+                                int32_t /* msgId */) const override {
+        lookupOnce();
+        ssize_t rtv = mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        if (rtv < 0 && followServer()) {
+            rtv = mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        }
+        return rtv;
+    }
+    inline virtual ssize_t sendv(const struct iovec iov[], int iovcnt,
+                                 int32_t /* msgId */) const override {
+        lookupOnce();
+        ssize_t rtv = mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        if (rtv < 0 && followServer()) {
+            rtv = mSock->sendv(iov, iovcnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        }
+        return rtv;
+    }
+    inline virtual int sendBatch(const struct iovec msgs[], int count) const override {
+        lookupOnce();
+        int sent = mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        if (sent < count && followServer()) {
+            sent += mSock->sendBatch(msgs + sent, count - sent, 0,
+                                     (struct sockaddr*)&mAddr, sizeof(mAddr));
+        }
+        return sent;
     }
 public:
     inline LocIpcQrtrSender(const sockaddr_qrtr& destAddr) :
             LocIpcSender(), mServiceInfo(0, 0),
             mSock(make_shared<Sock>(::socket(AF_QIPCRTR, SOCK_DGRAM, 0))),
-            mAddr(destAddr), mCtrlPkt({}), mLookupPending(false) {
+            mAddr(destAddr), mCtrlPkt({}), mLookupPending(false),
+            mDirGeneration(0), mFollowsServer(false) {
     }
     inline LocIpcQrtrSender(int service, int instance) : LocIpcSender(),
             mServiceInfo(service, instance),
             mSock(make_shared<Sock>(::socket(AF_QIPCRTR, SOCK_DGRAM, 0))),
             mAddr({AF_QIPCRTR, 0, 0}),
             mCtrlPkt({}),
-            mLookupPending(true) {
+            mLookupPending(true),
+            mDirGeneration(0),
+            mFollowsServer(true) {
         // set timeout so if failed to send, call will return after 2 seconds timeout
         // otherwise, call may never return
         timeval timeout;
@@ -269,11 +459,16 @@ public:
 class LocIpcQrtrListener : public ILocIpcListener {
     const shared_ptr<ILocIpcListener> mRealListener;
     const shared_ptr<LocIpcQrtrWatcher> mQrtrWatcher;
+    // sender of the message being delivered, kept up to date by the recver
+    const sockaddr_qrtr& mSrcAddr;
     inline bool handleQrtrCtrlMsg(const char* data, uint32_t len) {
         const struct qrtr_ctrl_pkt* pkt = reinterpret_cast<const struct qrtr_ctrl_pkt*>(data);
         bool handledAsQrtrCtrlMsg = false;
 
-        if (sizeof(*pkt) == len) {
+        // only the name service sends from the control port, so a client
+        // message that happens to be as long as a control packet is not
+        // taken for one
+        if (QRTR_PORT_CTRL == mSrcAddr.sq_port && sizeof(*pkt) == len) {
             const uint32_t cmd = le32_to_cpu(pkt->cmd);
             if (cmd >= QRTR_TYPE_DATA && cmd <= QRTR_TYPE_DEL_LOOKUP) {
                 handledAsQrtrCtrlMsg = true;
@@ -288,6 +483,10 @@ class LocIpcQrtrListener : public ILocIpcListener {
                          " client node:port %d:%d", cmd, serviceId, instanceId, serverNodeId,
                          serverPort, clientNodeId, clientPort);
 
+                // before the watcher hears of it, so its senders already
+                // see the server's new address
+                QrtrServiceDirectory::get().update(*pkt);
+
                 if (nullptr != mQrtrWatcher) {
                     if ((QRTR_TYPE_NEW_SERVER == cmd || QRTR_TYPE_DEL_SERVER == cmd) &&
                         mQrtrWatcher->isServiceInWatch(serviceId)) {
@@ -308,8 +507,9 @@ class LocIpcQrtrListener : public ILocIpcListener {
     }
 public:
     inline LocIpcQrtrListener(const shared_ptr<ILocIpcListener>& listener,
-                              const shared_ptr<LocIpcQrtrWatcher>& qrtrWatcher) :
-            mRealListener(listener), mQrtrWatcher(qrtrWatcher) {}
+                              const shared_ptr<LocIpcQrtrWatcher>& qrtrWatcher,
+                              const sockaddr_qrtr& srcAddr) :
+            mRealListener(listener), mQrtrWatcher(qrtrWatcher), mSrcAddr(srcAddr) {}
     inline virtual void onListenerReady() override {
         if (nullptr != mRealListener) mRealListener->onListenerReady();
     }
@@ -322,17 +522,24 @@ public:
 };
 
 class LocIpcQrtrRecver : public LocIpcQrtrSender, public LocIpcRecver {
+    const QrtrRecvConfig mConfig;
 protected:
+    // a burst of measurements or NMEA from a remote processor is taken off
+    // the socket in one recvmmsg(); mAddr follows the sender of each message
     inline virtual ssize_t recv() const override {
         socklen_t size = sizeof(mAddr);
-        return mSock->recv(*this, mDataCb, 0, (struct sockaddr*)&mAddr, &size);
+        return mSock->recvBatch(*this, mDataCb, mConfig.batchSize, mConfig.busyPollUs,
+                                (struct sockaddr*)&mAddr, &size);
     }
 public:
     inline LocIpcQrtrRecver(const shared_ptr<ILocIpcListener>& listener,
                             int service, int instance,
                             const shared_ptr<LocIpcQrtrWatcher>& qrtrWatcher) :
             LocIpcQrtrSender(service, instance),
-            LocIpcRecver(make_shared<LocIpcQrtrListener>(listener, qrtrWatcher), *this) {
+            LocIpcRecver(make_shared<LocIpcQrtrListener>(listener, qrtrWatcher, mAddr), *this),
+            mConfig(getQrtrRecvConfig()) {
+        // mAddr is the last sender here, not a server to follow
+        mFollowsServer = false;
         ctrlCmdAndResponse(QRTR_TYPE_NEW_SERVER);
         if (nullptr != qrtrWatcher) {
             sockaddr_qrtr addr = mAddr;
@@ -356,6 +563,9 @@ public:
     inline virtual const char* getName() const override {
         return mServiceInfo.getName();
     }
+    inline virtual int getRecvFd() const override {
+        return mSock->mSid;
+    }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));